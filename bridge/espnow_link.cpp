@@ -2,8 +2,34 @@
  * @file espnow_link.cpp
  * ESP-NOW wireless link for bridge (receiver side)
  *
- * Receives hotkey commands from display; sends ACKs back.
- * Accepts from any peer (no pairing required).
+ * Receives hotkey commands from displays; sends ACKs back.
+ * Accepts from any peer. Paired displays (MSG_PAIR_REQ) are kept in a peer
+ * table in NVS ("espnow"/"peers", 6 bytes per display id); replies go
+ * unicast to the frame's sender, relayed messages to one display or all of
+ * them. With no display paired, the last sender stands in.
+ *
+ * Frames of both formats are decoded (frame_decode). Each paired display's
+ * MSG_HELLO says whether it speaks v2 and what it supports; frames to it
+ * are built to match, legacy for a display that never sent one.
+ *
+ * Messages a display should still get after sleeping, rebooting or a
+ * spell out of range wait in a per-display outbox until its radio ACKs
+ * them (store-and-forward, below).
+ *
+ * Small messages for the same display, from one radio task pass, go out
+ * together as one MSG_BATCH frame to displays that take it (batching,
+ * below).
+ *
+ * The radio channel is the bridge's call (see MSG_CHANNEL in protocol.h):
+ * a survey is an async WiFi scan, so the loop and HID scheduler keep
+ * running while it hops; display frames sent meanwhile are missed and
+ * retried, which is why it waits for a quiet moment first.
+ *
+ * TX power and the unicast PHY rate follow the weakest display
+ * (shared/link_adapt.h): each one's PINGs report how loud it hears us, and
+ * each PING ACK tells it the same about its own frames. One radio, so one
+ * setting for all of them; full power while any present display hasn't
+ * reported, or none is around.
  */
 
 #include "espnow_link.h"
@@ -12,112 +38,1075 @@
 #include <esp_now.h>
 #include <esp_wifi.h>
 #include <esp_idf_version.h>
+#include <Preferences.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include <string.h>
+#include <algorithm>
+#include "link_adapt.h"
+#include "log.h"
 
-// Ring buffer for received messages (callback -> poll)
+// Ring buffer for received messages (callback -> espnow_dispatch)
 #define RX_QUEUE_SIZE 8
 
 struct RxMsg {
     uint8_t type;
+    uint8_t seq;
+    uint8_t version;
     uint8_t payload[PROTO_MAX_PAYLOAD];
     uint8_t len;
+    uint8_t mac[6];
+    uint8_t display;   // Peer table slot, DISPLAY_UNKNOWN if not paired
+    uint32_t rx_us;
 };
 
 static volatile RxMsg rx_queue[RX_QUEUE_SIZE];
 static volatile int rx_head = 0;
 static volatile int rx_tail = 0;
+static TaskHandle_t rx_task = nullptr;   // Woken per queued frame (espnow_set_rx_task)
+
+// Link counters (MSG_BRIDGE_STATS). RX side is written by on_recv only.
+static volatile uint32_t rx_frames = 0, rx_bytes = 0, rx_drops = 0, rx_bad = 0;
+static volatile uint8_t rx_high = 0;   // Deepest the RX queue got since the last espnow_link_stats()
+static volatile int8_t rx_rssi = 0;
+static volatile int8_t peer_rssi[BRIDGE_MAX_DISPLAYS] = {};   // Last frame from each display
+static uint32_t tx_frames = 0, tx_bytes = 0, tx_failed = 0;
 
 // Broadcast address for sending commands to any display
 static const uint8_t broadcast_addr[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
 
-// Store last sender MAC for ACK replies
+// Fallback destination while no display is paired
 static uint8_t last_sender_mac[6] = {};
 
+// Paired displays; the index is the display id. Fan-out skips a display
+// silent for PEER_IDLE_MS (switched off, or replaced and never unpaired) so
+// it doesn't cost a full MAC retry cycle per relayed frame.
+#define PEER_IDLE_MS 60000
+static uint8_t peers[BRIDGE_MAX_DISPLAYS][6] = {};
+static volatile uint32_t peer_rx_ms[BRIDGE_MAX_DISPLAYS] = {};
+static volatile uint8_t peer_count = 0;
+
+// Per display id, from its MSG_HELLO (radio task); reset when the id is
+// (re)assigned. Legacy frames and PROTO_CAPS_LEGACY until it says otherwise.
+#define BRIDGE_CAPS (PROTO_CAP_MACRO | PROTO_CAP_TYPE_TEXT)
+static bool peer_v2[BRIDGE_MAX_DISPLAYS] = {};
+static uint16_t peer_caps[BRIDGE_MAX_DISPLAYS] = {};
+static uint8_t frag_msg_id = 0;
+
+// Link adaptation (radio task): how loud each display hears us, from its
+// PINGs, and the send results of every unicast to a paired display
+#define ADAPT_WINDOW_MS 5000                 // One step per display heartbeat
+static LinkAdapt adapt;
+static RssiAvg far_rssi[BRIDGE_MAX_DISPLAYS] = {};
+static uint32_t far_ms[BRIDGE_MAX_DISPLAYS] = {};   // Latest report, 0 = none
+static uint32_t adapt_ms = 0;
+static int8_t worst_far_rssi = 0;            // Latest step's input, 0 = none
+#ifdef ESPNOW_PHY_RATE
+static const wifi_phy_rate_t adapt_rates[] = { ESPNOW_PHY_RATE, WIFI_PHY_RATE_1M_L };
+#define ADAPT_RATE_STEPS 2
+#else
+#define ADAPT_RATE_STEPS 1                   // Already at the basic rate: power only
+#endif
+
+// Store-and-forward outbox, per display id (radio task; see espnow_outbox_poll)
+#ifndef OUTBOX_FIFO_DEPTH
+#define OUTBOX_FIFO_DEPTH  8                   // Notifications and control messages held per display
+#endif
+#ifndef OUTBOX_MAX_AGE_MS
+#define OUTBOX_MAX_AGE_MS  (10 * 60 * 1000)    // Held longer than this: dropped
+#endif
+#define OUTBOX_FLUSH_BURST 4                   // Held frames sent per pass once a display is back
+#define OUTBOX_TAGS        32                  // Unicasts per display awaiting on_sent()
+#define OUTBOX_RESULTS     32                  // on_sent() results not yet matched
+#define OUTBOX_RESULT_MS   20                  // Poll interval while a result is due
+#define OUTBOX_LATEST      4                   // Latest-wins slots, see outbox_latest_slot()
+
+enum OutboxState : uint8_t { OB_EMPTY, OB_HELD, OB_SENT };
+
+struct OutboxEntry {
+    uint8_t type;
+    uint8_t len;
+    OutboxState state;
+    uint8_t gen;              // Bumped on every store, so a result for an older send doesn't clear it
+    uint32_t held_ms;         // Stored at
+    uint8_t payload[PROTO_MAX_PAYLOAD];
+};
+
+struct Outbox {
+    OutboxEntry slot[OUTBOX_LATEST + OUTBOX_FIFO_DEPTH];   // Latest-wins slots, then the FIFO ring
+    uint8_t fifo_head, fifo_count;
+    uint16_t tags[OUTBOX_TAGS];   // One per message in a unicast frame in flight, in send order
+    uint32_t joined;              // Bit per ring position: shares the next tag's frame (MSG_BATCH)
+    uint8_t tag_head, tag_count;
+    uint8_t skip;                 // Results to ignore: their tags fell off a full ring
+    bool away;                    // A unicast to it failed, nothing heard since
+};
+
+// Tag: slot | gen << 8, TAG_FINAL on the last frame of the message
+#define TAG_NONE  0x00FF
+#define TAG_FINAL 0x8000
+static_assert(OUTBOX_TAGS <= 32, "Outbox::joined has a bit per tag");
+
+struct TxResult {
+    uint8_t display;
+    bool ok;
+};
+
+static Outbox outbox[BRIDGE_MAX_DISPLAYS];
+static uint16_t tx_tag = TAG_NONE;                         // Of the message send_frame() is sending
+static volatile TxResult tx_results[OUTBOX_RESULTS];       // on_sent() -> espnow_outbox_poll()
+static volatile uint8_t txr_head = 0, txr_tail = 0;
+static volatile bool txr_lost = false;
+static uint32_t outbox_dropped = 0;
+
+// Batching (radio task; see batch_add)
+#ifndef ESPNOW_BATCH_HOLD_MS
+#define ESPNOW_BATCH_HOLD_MS 0   // Extra wait for more messages; 0 = sent at the end of the pass
+#endif
+#define BATCH_DESTS    (BRIDGE_MAX_DISPLAYS + 1)   // Per display id, then the broadcast one
+#define BATCH_MAX_MSGS 16
+
+struct Batch {
+    uint8_t buf[FRAME_MAX_PAYLOAD];   // MSG_BATCH records
+    uint8_t len;
+    uint8_t count;
+    uint16_t tags[BATCH_MAX_MSGS];    // Outbox tag per record
+    uint32_t opened_ms;
+};
+
+static Batch batches[BATCH_DESTS];
+static uint32_t tx_batched = 0;       // Messages that went out in a MSG_BATCH frame
+
+// Radio channel and survey / switch state machine (radio task)
+#define SURVEY_QUIET_MS        300      // No display frame for this long before hopping off-channel
+#define SURVEY_MAX_WAIT_MS     30000    // ... or survey anyway after waiting this long
+#define SURVEY_DWELL_MS        80       // Active scan time per channel
+#define SURVEY_PAIR_HOLDOFF_MS 60000    // Pairing-triggered surveys at most this often
+#define CHANNEL_GAIN_PCT       30       // Move only to a channel this much quieter
+#define CHANNEL_SWITCH_DELAY_MS 600     // Order -> move
+#define CHANNEL_SWITCH_REPEATS 3        // Orders sent, spread over the delay
+
+enum SurveyState : uint8_t { SURVEY_IDLE, SURVEY_WANTED, SURVEY_SCANNING, SURVEY_SWITCHING };
+
+static uint8_t channel = ESPNOW_CHANNEL;
+static SurveyState survey_state = SURVEY_IDLE;
+static uint32_t survey_wanted_ms = 0;
+static uint32_t survey_done_ms = 0;      // 0 = none since boot
+static uint8_t switch_target = 0;
+static uint32_t switch_at_ms = 0;
+static uint8_t switch_orders_sent = 0;
+static volatile uint32_t last_rx_ms = 0;
+
+static uint8_t peer_lookup(const uint8_t *mac) {
+    for (uint8_t i = 0; i < peer_count; i++) {
+        if (memcmp(peers[i], mac, 6) == 0) return i;
+    }
+    return DISPLAY_UNKNOWN;
+}
+
+static bool peer_active(uint8_t i) {
+    uint32_t heard = peer_rx_ms[i];
+    return heard ? millis() - heard < PEER_IDLE_MS : millis() < PEER_IDLE_MS;   // Unheard since boot: grace period
+}
+
+static uint8_t active_count() {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < peer_count; i++) n += peer_active(i);
+    return n;
+}
+
+static void add_peer(const uint8_t *mac) {
+    if (esp_now_is_peer_exist(mac)) return;
+    esp_now_peer_info_t peer = {};
+    memcpy(peer.peer_addr, mac, 6);
+    peer.channel = 0;   // Whatever channel the radio is on: follows channel switches
+    peer.encrypt = false;
+    esp_now_add_peer(&peer);
+}
+
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
 static void on_recv(const esp_now_recv_info_t *info, const uint8_t *data, int len) {
     const uint8_t *mac = info->src_addr;
+    int8_t rssi = info->rx_ctrl ? (int8_t)info->rx_ctrl->rssi : 0;
+    if (rssi) rx_rssi = rssi;
 #else
 static void on_recv(const uint8_t *mac, const uint8_t *data, int len) {
+    int8_t rssi = 0;
 #endif
-    if (len < 1) return;
+    uint32_t rx_us = micros();
+    FrameView f;
+    if (!frame_decode(data, len, f) || (f.flags & FRAME_F_FRAG)) {   // Displays never fragment
+        rx_bad++;
+        return;
+    }
 
-    // Save sender MAC for ACK
     memcpy(last_sender_mac, mac, 6);
+    last_rx_ms = millis();
+    uint8_t display = peer_lookup(mac);
+    if (display != DISPLAY_UNKNOWN) {
+        peer_rx_ms[display] = millis() | 1;
+        if (rssi) peer_rssi[display] = rssi;
+    }
 
+    rx_frames++;
+    rx_bytes += len;
     int next = (rx_head + 1) % RX_QUEUE_SIZE;
-    if (next == rx_tail) return;  // queue full, drop
+    if (next == rx_tail) {
+        rx_drops++;
+        return;  // queue full, drop
+    }
+    uint8_t depth = (uint8_t)((next - rx_tail + RX_QUEUE_SIZE) % RX_QUEUE_SIZE);
+    if (depth > rx_high) rx_high = depth;
 
-    rx_queue[rx_head].type = data[0];
-    uint8_t payload_len = (len > 1) ? len - 1 : 0;
-    if (payload_len > PROTO_MAX_PAYLOAD) payload_len = PROTO_MAX_PAYLOAD;
+    rx_queue[rx_head].type = f.type;
+    rx_queue[rx_head].seq = f.seq;
+    rx_queue[rx_head].version = f.version;
+    uint8_t payload_len = f.len > PROTO_MAX_PAYLOAD ? PROTO_MAX_PAYLOAD : f.len;
     if (payload_len > 0) {
-        memcpy((void *)rx_queue[rx_head].payload, &data[1], payload_len);
+        memcpy((void *)rx_queue[rx_head].payload, f.payload, payload_len);
     }
     rx_queue[rx_head].len = payload_len;
+    memcpy((void *)rx_queue[rx_head].mac, mac, 6);
+    rx_queue[rx_head].display = display;
+    rx_queue[rx_head].rx_us = rx_us;
     rx_head = next;
+    if (rx_task) xTaskNotifyGive(rx_task);
+}
+
+// Send result (WiFi task). Unicast success means the display's radio ACKed
+// the frame; broadcasts and unpaired receivers aren't tracked.
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 5, 0)
+static void on_sent(const esp_now_send_info_t *info, esp_now_send_status_t status) {
+    const uint8_t *mac = info->des_addr;
+#else
+static void on_sent(const uint8_t *mac, esp_now_send_status_t status) {
+#endif
+    uint8_t display = peer_lookup(mac);
+    if (display == DISPLAY_UNKNOWN) return;
+    uint8_t next = (txr_head + 1) % OUTBOX_RESULTS;
+    if (next == txr_tail) {
+        txr_lost = true;
+        return;
+    }
+    tx_results[txr_head].display = display;
+    tx_results[txr_head].ok = status == ESP_NOW_SEND_SUCCESS;
+    txr_head = next;
+    if (status != ESP_NOW_SEND_SUCCESS && rx_task) xTaskNotifyGive(rx_task);
 }
 
 void espnow_link_init() {
     WiFi.mode(WIFI_STA);
     WiFi.disconnect();
 
-    // Pin to WiFi channel 1 for deterministic coexistence with SoftAP
-    esp_wifi_set_channel(1, WIFI_SECOND_CHAN_NONE);
+    Preferences prefs;
+#if ESPNOW_AUTO_CHANNEL
+    if (prefs.begin("espnow", true)) {
+        uint8_t ch = prefs.getUChar("chan", ESPNOW_CHANNEL);
+        if (ch >= 1 && ch <= ESPNOW_CHANNEL_MAX) channel = ch;
+        prefs.end();
+    }
+#endif
+    // One fixed channel for ESP-NOW (and the display's SoftAP)
+    esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
 
     if (esp_now_init() != ESP_OK) {
         Serial.println("ESP-NOW init failed!");
         return;
     }
 
-    // Register broadcast peer for sending commands
-    esp_now_peer_info_t bcast_peer = {};
-    memcpy(bcast_peer.peer_addr, broadcast_addr, 6);
-    bcast_peer.channel = 1;
-    bcast_peer.encrypt = false;
-    esp_now_add_peer(&bcast_peer);
+    // Broadcast peer for CONFIG_MODE/CONFIG_DONE and shared stats
+    add_peer(broadcast_addr);
+
+#ifdef ESPNOW_PHY_RATE
+    esp_wifi_config_espnow_rate(WIFI_IF_STA, ESPNOW_PHY_RATE);
+#endif
+    link_adapt_init(adapt, ADAPT_RATE_STEPS);
+#if ESPNOW_ADAPT
+    esp_wifi_set_max_tx_power(adapt.power_qdbm);
+#else
+    esp_wifi_get_max_tx_power(&adapt.power_qdbm);   // Reported as it is
+#endif
+
+    if (prefs.begin("espnow", true)) {
+        size_t n = prefs.getBytes("peers", peers, sizeof(peers)) / 6;
+        if (n == 0 && prefs.getBytes("peer", peers[0], 6) == 6) n = 1;   // Single-display firmware
+        peer_count = (uint8_t)n;
+        prefs.end();
+    }
+    for (uint8_t i = 0; i < peer_count; i++) {
+        peer_caps[i] = PROTO_CAPS_LEGACY;
+        add_peer(peers[i]);
+        Serial.printf("ESP-NOW: display %u = %02X:%02X:%02X:%02X:%02X:%02X\n", i,
+                      peers[i][0], peers[i][1], peers[i][2], peers[i][3], peers[i][4], peers[i][5]);
+    }
 
     esp_now_register_recv_cb(on_recv);
+    esp_now_register_send_cb(on_sent);
+
+    Serial.printf("ESP-NOW ready (MAC: %s, channel %u)\n", WiFi.macAddress().c_str(), channel);
+}
+
+static EspnowHandler rx_handlers[MSG_FLAG_SEQ] = {};   // Indexed by type (frame_decode strips the SEQ flag)
+static EspnowRxFilter rx_filter = nullptr;
+
+void espnow_register_handler(MsgType type, EspnowHandler fn) {
+    if (type < MSG_FLAG_SEQ) rx_handlers[type] = fn;
+}
+
+void espnow_set_rx_filter(EspnowRxFilter fn) {
+    rx_filter = fn;
+}
+
+void espnow_set_rx_task(TaskHandle_t task) {
+    rx_task = task;
+}
+
+static bool send_frame(const uint8_t *mac, MsgType type, const uint8_t *payload, uint8_t len,
+                       bool legacy = false);
+
+// A display that spoke v2 sending legacy frames again was reflashed
+static void check_downgrade(const EspnowMsg &msg) {
+    if (msg.display >= BRIDGE_MAX_DISPLAYS || !peer_v2[msg.display] || msg.version >= PROTO_VERSION) return;
+    if (msg.type == MSG_PAIR_REQ || msg.type == MSG_HELLO) return;   // Always legacy
+    peer_v2[msg.display] = false;
+    peer_caps[msg.display] = PROTO_CAPS_LEGACY;
+    Serial.printf("ESP-NOW: display %u back to legacy frames\n", msg.display);
+}
 
-    Serial.printf("ESP-NOW ready (MAC: %s)\n", WiFi.macAddress().c_str());
+// MSG_HELLO: note what the display speaks and answer with ours. A display
+// that isn't paired gets no answer and stays on legacy frames.
+static void handle_hello(const EspnowMsg &msg) {
+    HelloMsg hello;
+    if (msg.len < sizeof(hello) || msg.display >= BRIDGE_MAX_DISPLAYS) return;
+    memcpy(&hello, msg.payload, sizeof(hello));
+    peer_v2[msg.display] = hello.version >= PROTO_VERSION;
+    peer_caps[msg.display] = hello.caps;
+    Serial.printf("ESP-NOW: display %u speaks v%u, caps 0x%04X\n", msg.display,
+                  hello.version, (unsigned)hello.caps);
+    if (hello.flags & HELLO_F_REPLY) return;
+    HelloMsg reply = { PROTO_VERSION, BRIDGE_CAPS, HELLO_F_REPLY };
+    send_frame(msg.mac, MSG_HELLO, (const uint8_t *)&reply, sizeof(reply), true);
 }
 
-bool espnow_poll(uint8_t &type, uint8_t *payload, uint8_t &payload_len) {
-    if (rx_tail == rx_head) return false;  // empty
+int espnow_dispatch() {
+    int count = 0;
+    while (rx_tail != rx_head) {
+        // Handed out in place: rx_tail only moves past the slot once the
+        // handler has returned, so on_recv can't reuse it underneath
+        volatile RxMsg &slot = rx_queue[rx_tail];
+        EspnowMsg msg = { slot.type, slot.seq, (const uint8_t *)slot.payload, slot.len,
+                          slot.display, (const uint8_t *)slot.mac, slot.version, slot.rx_us };
+        check_downgrade(msg);
+        if (msg.display < BRIDGE_MAX_DISPLAYS) outbox_heard(msg.display);
 
-    type = rx_queue[rx_tail].type;
-    payload_len = rx_queue[rx_tail].len;
-    memcpy(payload, (const void *)rx_queue[rx_tail].payload, payload_len);
-    rx_tail = (rx_tail + 1) % RX_QUEUE_SIZE;
+        if (!rx_filter || rx_filter(msg)) {
+            EspnowHandler fn = rx_handlers[msg.type];
+            if (msg.type == MSG_HELLO) {
+                handle_hello(msg);
+            } else if (fn) {
+                fn(msg);
+            } else {
+                LOG_W("WARN: unknown msg type 0x%02X\n", msg.type);
+            }
+        }
+        rx_tail = (rx_tail + 1) % RX_QUEUE_SIZE;
+        count++;
+    }
+    return count;
+}
+
+static void count_tx(esp_err_t result, int len) {
+    if (result != ESP_OK) {
+        tx_failed++;
+        return;
+    }
+    tx_frames++;
+    tx_bytes += len;
+}
+
+static void outbox_settle_entry(Outbox &ob, uint16_t tag, bool ok);
+
+// Every unicast to a paired display gets a tag per message, so on_sent()
+// results can be matched in order; `joined` tags ride in the same frame as
+// the next one and settle with its result. A full ring drops its oldest
+// tag (taken as delivered) and skips that frame's result when it comes.
+static void tag_push(uint8_t display, uint16_t tag, bool joined = false) {
+    Outbox &ob = outbox[display];
+    if (ob.tag_count == OUTBOX_TAGS) {
+        uint16_t oldest = ob.tags[ob.tag_head];
+        if (!(ob.joined & (1u << ob.tag_head))) ob.skip++;   // Its frame's last tag
+        ob.joined &= ~(1u << ob.tag_head);
+        ob.tag_head = (ob.tag_head + 1) % OUTBOX_TAGS;
+        ob.tag_count--;
+        outbox_settle_entry(ob, oldest, true);
+    }
+    uint8_t at = (ob.tag_head + ob.tag_count) % OUTBOX_TAGS;
+    ob.tags[at] = tag;
+    if (joined) ob.joined |= 1u << at;
+    else ob.joined &= ~(1u << at);
+    ob.tag_count++;
+}
+
+// ============================================================
+// Batching
+//
+// A display with PROTO_CAP_BATCH gets its small v2 messages gathered per
+// destination (display id, or the broadcast address) and sent as one
+// MSG_BATCH frame: when the next one doesn't fit, before anything sent to
+// it another way (so order holds), and by espnow_batch_flush() at the end
+// of the radio task pass -- a PING's ACK, a relayed stats update and a
+// time sync from the same pass share one frame. A batch holding a single
+// message goes out as that message's plain frame. MSG_CLOCK_SYNC is never
+// held: its timestamps are taken for the moment it is sent.
+// ============================================================
+
+static int batch_dest(const uint8_t *mac) {
+    if (memcmp(mac, broadcast_addr, 6) == 0) return BRIDGE_MAX_DISPLAYS;
+    uint8_t id = peer_lookup(mac);
+    return id == DISPLAY_UNKNOWN ? -1 : id;
+}
+
+// Send what batch `dest` holds. A frame the driver refuses puts the
+// outbox messages in it back to held.
+static bool batch_send(int dest) {
+    Batch &b = batches[dest];
+    if (b.count == 0) return true;
+    const uint8_t *mac = dest < BRIDGE_MAX_DISPLAYS ? peers[dest] : broadcast_addr;
+    uint8_t frame[ESPNOW_MAX_FRAME];
+    uint8_t n;
+    if (b.count == 1) {
+        FrameView r;
+        uint8_t pos = 0;
+        batch_next(b.buf, b.len, pos, r);
+        n = frame_encode(frame, true, r.type, r.payload, r.len, r.seq, r.flags);
+    } else {
+        n = frame_encode(frame, true, MSG_BATCH, b.buf, b.len);
+    }
+    esp_err_t result = esp_now_send(mac, frame, n);
+    count_tx(result, n);
+    if (result == ESP_OK && b.count > 1) tx_batched += b.count;
+    if (dest < BRIDGE_MAX_DISPLAYS) {
+        for (uint8_t i = 0; i < b.count; i++) {
+            if (result == ESP_OK) tag_push((uint8_t)dest, b.tags[i], i + 1 < b.count);
+            else outbox_settle_entry(outbox[dest], b.tags[i], false);
+        }
+    }
+    b.len = 0;
+    b.count = 0;
+    return result == ESP_OK;
+}
+
+// Add a message to the batch for `dest`, sending the batch first if it
+// doesn't fit. Tagged with tx_tag like a frame of its own.
+static bool batch_add(int dest, uint8_t flags, uint8_t seq, uint8_t type, const uint8_t *payload, uint8_t len) {
+    Batch &b = batches[dest];
+    bool ok = true;
+    if (b.count == BATCH_MAX_MSGS || b.len + BATCH_REC_HDR + len > FRAME_MAX_PAYLOAD) ok = batch_send(dest);
+    if (b.count == 0) b.opened_ms = millis();
+    b.len = batch_append(b.buf, b.len, flags, seq, type, payload, len);
+    b.tags[b.count++] = tx_tag == TAG_NONE ? TAG_NONE : (uint16_t)(tx_tag | TAG_FINAL);
+    return ok;
+}
+
+static bool batch_takes(uint8_t type, uint8_t len) {
+    return type != MSG_CLOCK_SYNC && BATCH_REC_HDR + len <= FRAME_MAX_PAYLOAD;
+}
+
+uint32_t espnow_batch_flush() {
+    uint32_t wait = UINT32_MAX;
+    for (int d = 0; d < BATCH_DESTS; d++) {
+        Batch &b = batches[d];
+        if (b.count == 0) continue;
+        uint32_t held = millis() - b.opened_ms;
+        if (held < ESPNOW_BATCH_HOLD_MS) {
+            wait = std::min(wait, (uint32_t)(ESPNOW_BATCH_HOLD_MS - held));
+            continue;
+        }
+        batch_send(d);
+    }
+    return wait;
+}
+
+static bool transmit(const uint8_t *mac, const uint8_t *frame, uint8_t n, bool last = true) {
+    if (n == 0) {
+        tx_failed++;   // Payload too long for any frame
+        return false;
+    }
+    int dest = batch_dest(mac);
+    if (dest >= 0) batch_send(dest);   // Batched messages to it go first
+    esp_err_t result = esp_now_send(mac, frame, n);
+    count_tx(result, n);
+    if (result != ESP_OK) return false;
+    uint8_t display = peer_lookup(mac);
+    if (display != DISPLAY_UNKNOWN) tag_push(display, tx_tag == TAG_NONE || !last ? tx_tag : tx_tag | TAG_FINAL);
     return true;
 }
 
+// v2 frames, batched when the receiver has PROTO_CAP_BATCH, fragmented
+// when the payload doesn't fit one (receiver has PROTO_CAP_FRAGMENT), else
+// legacy
+static bool send_encoded(const uint8_t *mac, bool v2, bool can_frag, bool can_batch, MsgType type,
+                         const uint8_t *payload, uint8_t len) {
+    int dest = can_batch && v2 ? batch_dest(mac) : -1;
+    if (dest >= 0 && batch_takes(type, len)) return batch_add(dest, 0, 0, type, payload, len);
+    uint8_t frame[ESPNOW_MAX_FRAME];
+    if (v2 && len > FRAME_MAX_PAYLOAD && can_frag) {
+        if (++frag_msg_id == 0) frag_msg_id = 1;
+        bool ok = true;
+        uint8_t index = 0;
+        for (int off = 0; off < len; off += FRAME_FRAG_DATA, index++) {
+            uint8_t n = (uint8_t)(len - off < FRAME_FRAG_DATA ? len - off : FRAME_FRAG_DATA);
+            uint8_t frag = index | (off + n >= len ? FRAG_LAST : 0);
+            ok &= transmit(mac, frame, frame_encode(frame, true, type, payload + off, n,
+                                                    frag_msg_id, FRAME_F_FRAG, frag), frag & FRAG_LAST);
+        }
+        return ok;
+    }
+    if (v2 && len > FRAME_MAX_PAYLOAD) v2 = false;
+    return transmit(mac, frame, frame_encode(frame, v2, type, payload, len));
+}
+
+static bool send_frame(const uint8_t *mac, MsgType type, const uint8_t *payload, uint8_t len,
+                       bool legacy) {
+    add_peer(mac);
+    uint8_t id = peer_lookup(mac);
+    bool v2 = !legacy && id != DISPLAY_UNKNOWN && peer_v2[id];
+    return send_encoded(mac, v2, v2 && (peer_caps[id] & PROTO_CAP_FRAGMENT),
+                        v2 && (peer_caps[id] & PROTO_CAP_BATCH), type, payload, len);
+}
+
+bool espnow_reply(const EspnowMsg &msg, MsgType type, const uint8_t *payload, uint8_t len) {
+    return send_frame(msg.mac, type, payload, len);
+}
+
+bool espnow_ack(const EspnowMsg &msg, uint8_t status) {
+    uint8_t id = peer_lookup(msg.mac);
+    if (id != DISPLAY_UNKNOWN && peer_v2[id]) {
+        // A PING's ACK also says how loud the display's frames arrive (LinkReportMsg)
+        uint8_t body[1 + sizeof(LinkReportMsg)] = { status };
+        uint8_t len = 1;
+        if (msg.type == MSG_PING) {
+            LinkReportMsg report = { peer_rssi[id], adapt.power_qdbm };
+            memcpy(body + 1, &report, sizeof(report));
+            len += sizeof(report);
+        }
+        if (peer_caps[id] & PROTO_CAP_BATCH) return batch_add(id, FRAME_F_ACK, msg.seq, MSG_HOTKEY_ACK, body, len);
+        uint8_t frame[ESPNOW_MAX_FRAME];
+        return transmit(msg.mac, frame, frame_encode(frame, true, MSG_HOTKEY_ACK, body, len,
+                                                     msg.seq, FRAME_F_ACK));
+    }
+    HotkeyAckMsg ack = { status, msg.seq };
+    return send_frame(msg.mac, MSG_HOTKEY_ACK, (const uint8_t *)&ack, sizeof(ack), true);
+}
+
+// ============================================================
+// Store-and-forward outbox
+//
+// esp_now_send() only says a frame was queued; whether a display got it
+// comes later, from on_sent(). Messages still worth delivering late are
+// kept per display until then:
+//
+//   latest-wins  MSG_POWER_STATE, MSG_TIME_SYNC, MSG_PROFILE_SWITCH and
+//                MSG_STATS (merged with tlv_merge_stats), one slot each
+//   FIFO         MSG_NOTIFICATION, MSG_DDC_STATE, MSG_CONFIG_MODE/DONE,
+//                OUTBOX_FIFO_DEPTH deep, the oldest dropped when full
+//
+// A failed unicast, or PEER_IDLE_MS without a frame, makes the display
+// away: these messages are then only stored, everything else is dropped as
+// before. The next frame from it (its PING or HELLO, a pair request after
+// a reboot) brings it back, and espnow_outbox_poll() sends what was held,
+// latest-wins slots first. A held MSG_TIME_SYNC is advanced by the time it
+// waited; anything older than OUTBOX_MAX_AGE_MS is dropped. The unpaired
+// last-sender fallback has no id to keep an outbox under.
+// ============================================================
+
+static int outbox_latest_slot(uint8_t type) {
+    switch (type) {
+        case MSG_POWER_STATE:    return 0;
+        case MSG_TIME_SYNC:      return 1;
+        case MSG_PROFILE_SWITCH: return 2;
+        case MSG_STATS:          return 3;
+        default:                 return -1;
+    }
+}
+
+static bool outbox_fifo_type(uint8_t type) {
+    return type == MSG_NOTIFICATION || type == MSG_DDC_STATE || type == MSG_CONFIG_MODE ||
+           type == MSG_CONFIG_DONE;
+}
+
+static bool outbox_present(uint8_t display) {
+    return !outbox[display].away && peer_active(display);
+}
+
+static void outbox_remove(Outbox &ob, uint8_t i) {
+    ob.slot[i].state = OB_EMPTY;
+    while (ob.fifo_count && ob.slot[OUTBOX_LATEST + ob.fifo_head].state == OB_EMPTY) {
+        ob.fifo_head = (ob.fifo_head + 1) % OUTBOX_FIFO_DEPTH;
+        ob.fifo_count--;
+    }
+}
+
+// Keep a copy for `display`. Returns its slot, -1 for types not held.
+static int outbox_store(uint8_t display, uint8_t type, const uint8_t *payload, uint8_t len) {
+    Outbox &ob = outbox[display];
+    int i = outbox_latest_slot(type);
+    if (i < 0) {
+        if (!outbox_fifo_type(type)) return -1;
+        if (ob.fifo_count == OUTBOX_FIFO_DEPTH) {
+            outbox_dropped++;
+            LOG_W("OUTBOX: display %u full, oldest 0x%02X dropped\n", display, ob.slot[OUTBOX_LATEST + ob.fifo_head].type);
+            outbox_remove(ob, OUTBOX_LATEST + ob.fifo_head);
+        }
+        i = OUTBOX_LATEST + (ob.fifo_head + ob.fifo_count) % OUTBOX_FIFO_DEPTH;
+        ob.fifo_count++;
+        ob.slot[i].state = OB_EMPTY;
+    }
+    OutboxEntry &e = ob.slot[i];
+    bool merged = e.state != OB_EMPTY && type == MSG_STATS &&
+                  tlv_merge_stats(e.payload, e.len, sizeof(e.payload), payload, len);
+    if (!merged) {
+        e.len = len > sizeof(e.payload) ? sizeof(e.payload) : len;
+        memcpy(e.payload, payload, e.len);
+    }
+    e.type = type;
+    e.state = OB_HELD;
+    e.gen = (e.gen + 1) & 0x7F;
+    e.held_ms = millis();
+    return i;
+}
+
+// A result for the message tagged `tag`: failed goes back to held, the
+// last frame delivered removes it
+static void outbox_settle_entry(Outbox &ob, uint16_t tag, bool ok) {
+    uint8_t i = tag & 0xFF;
+    if (i >= OUTBOX_LATEST + OUTBOX_FIFO_DEPTH) return;
+    OutboxEntry &e = ob.slot[i];
+    if (e.state != OB_SENT || e.gen != ((tag >> 8) & 0x7F)) return;   // Stored again since
+    if (!ok) {
+        e.state = OB_HELD;
+    } else if (tag & TAG_FINAL) {
+        outbox_remove(ob, i);
+    }
+}
+
+// A result from on_sent(): any failed unicast makes the display away
+static void outbox_settle(uint8_t display, uint16_t tag, bool ok) {
+    Outbox &ob = outbox[display];
+    if (ok == ob.away) {
+        ob.away = !ok;
+        if (!ok) Serial.printf("OUTBOX: display %u not answering, holding its messages\n", display);
+    }
+    outbox_settle_entry(ob, tag, ok);
+}
+
+// Send slot i, as `payload` (the entry's own copy when flushing)
+static bool outbox_send(uint8_t display, uint8_t i, const uint8_t *payload, uint8_t len) {
+    OutboxEntry &e = outbox[display].slot[i];
+    tx_tag = (uint16_t)(i | e.gen << 8);
+    bool ok = send_frame(peers[display], (MsgType)e.type, payload, len);
+    tx_tag = TAG_NONE;
+    if (ok) e.state = OB_SENT;
+    return ok;
+}
+
+static bool send_to_display(uint8_t display, MsgType type, const uint8_t *payload, uint8_t len) {
+    int i = outbox_store(display, type, payload, len);
+    if (i < 0) return send_frame(peers[display], type, payload, len);
+    if (!outbox_present(display)) return true;   // Held for when it is back
+    const OutboxEntry &e = outbox[display].slot[i];
+    return outbox_send(display, (uint8_t)i, e.payload, e.len);   // Stats as merged with any unACKed ones
+}
+
+// Any frame from a paired display: it is back
+static void outbox_heard(uint8_t display) {
+    Outbox &ob = outbox[display];
+    if (!ob.away) return;
+    ob.away = false;
+    uint8_t held = 0;
+    for (const auto &e : ob.slot) held += e.state != OB_EMPTY;
+    Serial.printf("OUTBOX: display %u back, %u message(s) held\n", display, held);
+}
+
+uint32_t espnow_outbox_poll() {
+    if (txr_lost) {
+        // Results went missing: nothing left to match them by. Resend what was in flight.
+        txr_lost = false;
+        for (auto &ob : outbox) {
+            ob.tag_count = 0;
+            ob.joined = 0;
+            ob.skip = 0;
+            for (auto &e : ob.slot) {
+                if (e.state == OB_SENT) e.state = OB_HELD;
+            }
+        }
+        LOG_W("OUTBOX: send results lost, resending\n");
+    }
+    while (txr_tail != txr_head) {
+        uint8_t display = tx_results[txr_tail].display;
+        bool ok = tx_results[txr_tail].ok;
+        txr_tail = (txr_tail + 1) % OUTBOX_RESULTS;
+        link_adapt_count(adapt, ok, !ok);
+        Outbox &ob = outbox[display];
+        if (ob.skip) {
+            ob.skip--;
+            continue;
+        }
+        // The frame's tags: any joined ones, then its last
+        uint16_t tag = TAG_NONE;
+        while (ob.tag_count) {
+            tag = ob.tags[ob.tag_head];
+            bool joined = ob.joined & (1u << ob.tag_head);
+            ob.joined &= ~(1u << ob.tag_head);
+            ob.tag_head = (ob.tag_head + 1) % OUTBOX_TAGS;
+            ob.tag_count--;
+            if (!joined) break;
+            outbox_settle_entry(ob, tag, ok);
+            tag = TAG_NONE;
+        }
+        outbox_settle(display, tag, ok);
+    }
+
+    uint32_t now = millis();
+    uint32_t wait = UINT32_MAX;
+    for (uint8_t d = 0; d < peer_count; d++) {
+        Outbox &ob = outbox[d];
+        bool present = outbox_present(d);
+        uint8_t sent = 0;
+        uint8_t head = ob.fifo_head, n = OUTBOX_LATEST + ob.fifo_count;   // Expiry below moves them
+        for (uint8_t k = 0; k < n; k++) {
+            uint8_t i = k < OUTBOX_LATEST ? k : OUTBOX_LATEST + (head + k - OUTBOX_LATEST) % OUTBOX_FIFO_DEPTH;
+            OutboxEntry &e = ob.slot[i];
+            if (e.state == OB_EMPTY) continue;
+            if (now - e.held_ms >= OUTBOX_MAX_AGE_MS) {
+                outbox_dropped++;
+                LOG_D("OUTBOX: display %u: 0x%02X expired\n", d, e.type);
+                outbox_remove(ob, i);
+                continue;
+            }
+            if (e.state == OB_SENT) {
+                wait = std::min(wait, (uint32_t)OUTBOX_RESULT_MS);   // Result due
+                continue;
+            }
+            if (!present) continue;
+            if (sent == OUTBOX_FLUSH_BURST) {
+                wait = 0;
+                break;
+            }
+            uint8_t copy[PROTO_MAX_PAYLOAD];
+            memcpy(copy, e.payload, e.len);
+            if (e.type == MSG_TIME_SYNC && e.len >= sizeof(TimeSyncMsg)) {
+                TimeSyncMsg t;
+                memcpy(&t, copy, sizeof(t));
+                t.epoch_seconds += (now - e.held_ms) / 1000;
+                memcpy(copy, &t, sizeof(t));
+            }
+            if (!outbox_send(d, i, copy, e.len)) {
+                wait = std::min(wait, (uint32_t)OUTBOX_RESULT_MS);   // Driver queue full: next pass
+                break;
+            }
+            sent++;
+        }
+    }
+    return wait;
+}
+
+bool espnow_send_to(uint8_t display, MsgType type, const uint8_t *payload, uint8_t len) {
+    if (display != DISPLAY_ALL) {
+        return display < peer_count && send_to_display(display, type, payload, len);
+    }
+    if (peer_count == 0) return send_frame(last_sender_mac, type, payload, len);
+    bool held = outbox_latest_slot(type) >= 0 || outbox_fifo_type(type);
+    bool ok = true;
+    for (uint8_t i = 0; i < peer_count; i++) {
+        if (peer_active(i) || held) ok &= send_to_display(i, type, payload, len);
+    }
+    return ok;
+}
+
 bool espnow_send(MsgType type, const uint8_t *payload, uint8_t len) {
-    // Ensure last sender is registered as peer
-    if (!esp_now_is_peer_exist(last_sender_mac)) {
-        esp_now_peer_info_t peer = {};
-        memcpy(peer.peer_addr, last_sender_mac, 6);
-        peer.channel = 1;
-        peer.encrypt = false;
-        esp_now_add_peer(&peer);
+    return espnow_send_to(DISPLAY_ALL, type, payload, len);
+}
+
+bool espnow_send_shared(MsgType type, const uint8_t *payload, uint8_t len) {
+    if (active_count() > 1) {
+        // Not ACKed per display: only the ones known to be away get a copy kept
+        for (uint8_t i = 0; i < peer_count; i++) {
+            if (!outbox_present(i)) outbox_store(i, type, payload, len);
+        }
+        return espnow_send_broadcast(type, payload, len);
     }
+    return espnow_send_to(DISPLAY_ALL, type, payload, len);
+}
 
-    uint8_t buf[1 + PROTO_MAX_PAYLOAD];
-    buf[0] = (uint8_t)type;
-    if (len > 0 && payload) {
-        memcpy(&buf[1], payload, len);
+uint8_t espnow_display_count() {
+    return peer_count;
+}
+
+bool espnow_displays_support(uint16_t cap) {
+    for (uint8_t i = 0; i < peer_count; i++) {
+        if (peer_active(i) && (peer_caps[i] & cap) != cap) return false;
     }
+    return peer_count > 0 || (PROTO_CAPS_LEGACY & cap) == cap;
+}
 
-    esp_err_t result = esp_now_send(last_sender_mac, buf, 1 + len);
-    return result == ESP_OK;
+uint8_t espnow_accept_pairing(const EspnowMsg &msg) {
+    PairMsg req;
+    if (msg.len < sizeof(req)) return DISPLAY_UNKNOWN;
+    memcpy(&req, msg.payload, sizeof(req));
+    if (req.magic != PAIR_MAGIC) return DISPLAY_UNKNOWN;
+
+    uint8_t id = peer_lookup(msg.mac);
+    if (id == DISPLAY_UNKNOWN) {
+        if (peer_count < BRIDGE_MAX_DISPLAYS) {
+            id = peer_count;
+        } else {
+            // Table full: the display heard from least recently gives up its id
+            id = 0;
+            for (uint8_t i = 1; i < BRIDGE_MAX_DISPLAYS; i++) {
+                if ((int32_t)(peer_rx_ms[i] - peer_rx_ms[id]) < 0) id = i;
+            }
+            esp_now_del_peer(peers[id]);
+        }
+        memcpy(peers[id], msg.mac, 6);
+        peer_rx_ms[id] = millis() | 1;
+        peer_v2[id] = false;                  // Until its HELLO
+        peer_caps[id] = PROTO_CAPS_LEGACY;
+        memset(&outbox[id], 0, sizeof(outbox[id]));   // Nothing held for whoever had the id
+        far_rssi[id] = {};
+        far_ms[id] = 0;
+        peer_rssi[id] = 0;
+        if (id == peer_count) peer_count++;
+        Preferences prefs;
+        if (prefs.begin("espnow", false)) {
+            prefs.putBytes("peers", peers, peer_count * 6);
+            prefs.end();
+        }
+        Serial.printf("ESP-NOW: paired display %u = %02X:%02X:%02X:%02X:%02X:%02X\n", id,
+                      msg.mac[0], msg.mac[1], msg.mac[2], msg.mac[3], msg.mac[4], msg.mac[5]);
+        // New display on the air: a good moment to check the channel
+        espnow_request_survey(SURVEY_PAIR_HOLDOFF_MS);
+    }
+
+    PairMsg ack = { PAIR_MAGIC };
+    espnow_reply(msg, MSG_PAIR_ACK, (const uint8_t *)&ack, sizeof(ack));
+    return id;
 }
 
 bool espnow_send_broadcast(MsgType type, const uint8_t *payload, uint8_t len) {
-    uint8_t buf[1 + PROTO_MAX_PAYLOAD];
-    buf[0] = (uint8_t)type;
-    if (len > 0 && payload) {
-        memcpy(&buf[1], payload, len);
+    // One frame for everyone: v2 only if every display listening takes it
+    bool v2 = active_count() > 0, can_frag = true, can_batch = true;
+    for (uint8_t i = 0; i < peer_count; i++) {
+        if (!peer_active(i)) continue;
+        v2 &= peer_v2[i];
+        can_frag &= (peer_caps[i] & PROTO_CAP_FRAGMENT) != 0;
+        can_batch &= (peer_caps[i] & PROTO_CAP_BATCH) != 0;
     }
+    return send_encoded(broadcast_addr, v2, can_frag, can_batch, type, payload, len);
+}
 
-    esp_err_t result = esp_now_send(broadcast_addr, buf, 1 + len);
-    return result == ESP_OK;
+void espnow_link_stats(EspnowLinkStats &out) {
+    out.rx_frames = rx_frames;
+    out.rx_bytes = rx_bytes;
+    out.rx_drops = rx_drops;
+    out.rx_bad = rx_bad;
+    out.tx_frames = tx_frames;
+    out.tx_bytes = tx_bytes;
+    out.tx_failed = tx_failed;
+    out.tx_batched = tx_batched;
+    out.outbox_dropped = outbox_dropped;
+    out.rx_queue_high = rx_high;
+    out.rx_queue_size = RX_QUEUE_SIZE - 1;   // One slot stays empty
+    out.rssi = rx_rssi;
+    out.tx_power_qdbm = adapt.power_qdbm;
+    out.phy_rate_step = adapt.rate;
+    out.far_rssi = worst_far_rssi;
+    out.adapt_changes = adapt.changes;
+    LinkAdaptChange last;
+    out.adapt_reason = link_adapt_history(adapt, &last, 1) ? last.reason : 0xFF;
+    rx_high = 0;
+}
+
+// ============================================================
+// Channel survey and coordinated switch
+// ============================================================
+
+uint8_t espnow_channel() {
+    return channel;
+}
+
+void espnow_request_survey(uint32_t holdoff_ms) {
+#if ESPNOW_AUTO_CHANNEL
+    if (survey_state != SURVEY_IDLE) return;
+    if (survey_done_ms != 0 && millis() - survey_done_ms < holdoff_ms) return;
+    survey_state = SURVEY_WANTED;
+    survey_wanted_ms = millis();
+#else
+    (void)holdoff_ms;
+#endif
+}
+
+// Congestion per channel from the scan: each AP counts by strength, on its
+// own channel and (less) on the overlapping ones up to 4 channels away
+static uint8_t pick_channel(int ap_count, uint32_t &best_score, uint32_t &current_score) {
+    uint32_t score[ESPNOW_CHANNEL_MAX + 1] = {};
+    for (int i = 0; i < ap_count; i++) {
+        int ap_ch = WiFi.channel(i);
+        int weight = WiFi.RSSI(i) + 100;   // -30 dBm -> 70, -95 dBm -> 5
+        if (weight < 1) weight = 1;
+        if (weight > 70) weight = 70;
+        for (int c = 1; c <= ESPNOW_CHANNEL_MAX; c++) {
+            int d = abs(c - ap_ch);
+            if (d < 5) score[c] += weight * (5 - d);
+        }
+    }
+    uint8_t best = channel;
+    for (int c = 1; c <= ESPNOW_CHANNEL_MAX; c++) {
+        if (score[c] < score[best]) best = (uint8_t)c;
+    }
+    best_score = score[best];
+    current_score = score[channel];
+    return best;
+}
+
+static void send_switch_order() {
+    uint32_t now = millis();
+    ChannelMsg order = {};
+    order.op = CHANNEL_SWITCH;
+    order.channel = switch_target;
+    order.delay_ms = (int32_t)(switch_at_ms - now) > 0 ? (uint16_t)(switch_at_ms - now) : 0;
+    espnow_send(MSG_CHANNEL, (const uint8_t *)&order, sizeof(order));
+    switch_orders_sent++;
+}
+
+static void set_channel(uint8_t ch) {
+    channel = ch;
+    esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
+    Preferences prefs;
+    if (prefs.begin("espnow", false)) {
+        prefs.putUChar("chan", channel);
+        prefs.end();
+    }
+}
+
+uint32_t espnow_channel_update(bool allowed) {
+    uint32_t now = millis();
+    switch (survey_state) {
+        case SURVEY_IDLE:
+            return UINT32_MAX;
+
+        case SURVEY_WANTED: {
+            if (!allowed) return 100;
+            bool quiet = now - last_rx_ms >= SURVEY_QUIET_MS;
+            if (!quiet && now - survey_wanted_ms < SURVEY_MAX_WAIT_MS) return 50;
+            if (WiFi.scanNetworks(true, true, false, SURVEY_DWELL_MS) == WIFI_SCAN_FAILED) {
+                survey_state = SURVEY_IDLE;
+                survey_done_ms = now;
+                return UINT32_MAX;
+            }
+            survey_state = SURVEY_SCANNING;
+            Serial.printf("CHANNEL: surveying (on %u)\n", channel);
+            return 50;
+        }
+
+        case SURVEY_SCANNING: {
+            int16_t n = WiFi.scanComplete();
+            if (n == WIFI_SCAN_RUNNING) return 50;
+            // The scan leaves the radio on whichever channel it hopped to last
+            esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
+            survey_done_ms = now;
+            survey_state = SURVEY_IDLE;
+            if (n < 0) return UINT32_MAX;
+
+            uint32_t best_score, current_score;
+            uint8_t best = pick_channel(n, best_score, current_score);
+            WiFi.scanDelete();
+            Serial.printf("CHANNEL: %d APs, channel %u score %lu, best %u score %lu\n", n, channel,
+                          (unsigned long)current_score, best, (unsigned long)best_score);
+            if (best == channel || best_score * 100 > current_score * (100 - CHANNEL_GAIN_PCT)) {
+                return UINT32_MAX;
+            }
+            switch_target = best;
+            switch_at_ms = now + CHANNEL_SWITCH_DELAY_MS;
+            switch_orders_sent = 0;
+            survey_state = SURVEY_SWITCHING;
+            send_switch_order();
+            return CHANNEL_SWITCH_DELAY_MS / CHANNEL_SWITCH_REPEATS;
+        }
+
+        case SURVEY_SWITCHING: {
+            if ((int32_t)(now - switch_at_ms) >= 0) {
+                Serial.printf("CHANNEL: %u -> %u\n", channel, switch_target);
+                for (int d = 0; d < BATCH_DESTS; d++) batch_send(d);   // Still on the old channel
+                set_channel(switch_target);
+                survey_state = SURVEY_IDLE;
+                return UINT32_MAX;
+            }
+            const uint32_t spacing = CHANNEL_SWITCH_DELAY_MS / CHANNEL_SWITCH_REPEATS;
+            uint32_t next_order_ms = switch_at_ms - CHANNEL_SWITCH_DELAY_MS + switch_orders_sent * spacing;
+            if (switch_orders_sent < CHANNEL_SWITCH_REPEATS && (int32_t)(now - next_order_ms) >= 0) {
+                send_switch_order();
+            }
+            return 10;
+        }
+    }
+    return UINT32_MAX;
+}
+
+// ============================================================
+// Link adaptation
+// ============================================================
+
+void espnow_adapt_report(const EspnowMsg &msg) {
+    if (msg.display >= BRIDGE_MAX_DISPLAYS || msg.len < sizeof(LinkReportMsg)) return;
+    LinkReportMsg report;
+    memcpy(&report, msg.payload, sizeof(report));
+    if (report.rssi_dbm == 0) return;
+    rssi_avg_add(far_rssi[msg.display], report.rssi_dbm);
+    far_ms[msg.display] = millis() | 1;
+}
+
+static void adapt_apply() {
+    esp_wifi_set_max_tx_power(adapt.power_qdbm);
+#ifdef ESPNOW_PHY_RATE
+    esp_wifi_config_espnow_rate(WIFI_IF_STA, adapt_rates[adapt.rate]);
+#endif
+    for (auto &a : far_rssi) rssi_avg_shift(a, adapt.last_delta);
+    LinkAdaptChange c;
+    if (link_adapt_history(adapt, &c, 1) == 1) {
+        Serial.printf("ADAPT (%s): %.2f dBm, rate step %u (weakest display hears %d dBm, %u%% lost)\n",
+                      link_adapt_reason_name(c.reason), c.power_qdbm / 4.0f, c.rate, c.rssi_dbm,
+                      c.loss_pct);
+    }
+}
+
+uint32_t espnow_adapt_update() {
+#if ESPNOW_ADAPT
+    uint32_t now = millis();
+    if (adapt_ms == 0) adapt_ms = now;
+    if (now - adapt_ms < ADAPT_WINDOW_MS) return ADAPT_WINDOW_MS - (now - adapt_ms);
+    adapt_ms = now;
+
+    // The weakest present display decides; one that doesn't report (older
+    // firmware, or gone quiet) keeps us from lowering anything
+    RssiAvg worst = {};
+    uint8_t present = 0;
+    bool unreported = false;
+    for (uint8_t d = 0; d < peer_count; d++) {
+        if (!outbox_present(d)) continue;
+        present++;
+        if (far_ms[d] == 0 || now - far_ms[d] >= PEER_IDLE_MS || !far_rssi[d].valid) {
+            unreported = true;
+        } else if (!worst.valid || far_rssi[d].x16 < worst.x16) {
+            worst = far_rssi[d];
+        }
+    }
+    if (unreported) worst.valid = false;
+    worst_far_rssi = rssi_avg_dbm(worst);
+    bool changed = present ? link_adapt_step(adapt, worst, now) : link_adapt_reset(adapt, now);
+    if (changed) adapt_apply();
+    return ADAPT_WINDOW_MS;
+#else
+    return UINT32_MAX;
+#endif
 }
@@ -1,16 +1,126 @@
 #pragma once
 #include <cstdint>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include "protocol.h"
 
+// Everything here except the link counters belongs to the radio task
+// (pipeline.h): dispatch, sends, pairing and the channel state machine.
+
 // Initialize ESP-NOW receiver on bridge
 void espnow_link_init();
 
-// Poll for incoming hotkey commands (non-blocking)
-// Returns true if a command was received
-bool espnow_poll(uint8_t &type, uint8_t *payload, uint8_t &payload_len);
+// Received command handed to a handler, legacy or v2 frame alike (see
+// frame_decode): `seq` is the command's SEQ (0 = unsequenced), `type` has
+// no MSG_FLAG_SEQ. `payload` and `mac` point into the RX queue slot
+// itself and are only valid until the handler returns.
+struct EspnowMsg {
+    uint8_t type;
+    uint8_t seq;
+    const uint8_t *payload;
+    uint8_t len;
+    uint8_t display;        // Sender's display id, DISPLAY_UNKNOWN if not paired
+    const uint8_t *mac;     // Sender
+    uint8_t version;        // Frame format: 1 = legacy, else PROTO_VERSION
+    uint32_t rx_us;         // micros() in the receive callback
+};
+
+typedef void (*EspnowHandler)(const EspnowMsg &msg);
+typedef bool (*EspnowRxFilter)(const EspnowMsg &msg);
+
+// Route a message type to `fn` (nullptr unregisters)
+void espnow_register_handler(MsgType type, EspnowHandler fn);
+
+// Called for every frame before its handler (duplicate suppression).
+// Returning false drops the frame. MSG_HELLO is then handled here, not
+// by a registered handler.
+void espnow_set_rx_filter(EspnowRxFilter fn);
+
+// Run the handlers for all queued frames, releasing each slot afterwards.
+// Returns the number of frames dispatched.
+int espnow_dispatch();
 
-// Send a message back to display (ACK responses, uses last sender MAC)
+// Task notified (xTaskNotifyGive) for every frame queued, so it can sleep
+// in ulTaskNotifyTake() between them
+void espnow_set_rx_task(TaskHandle_t task);
+
+// Unicast to the display that sent `msg`
+bool espnow_reply(const EspnowMsg &msg, MsgType type, const uint8_t *payload, uint8_t len);
+
+// ACK a command (MSG_HOTKEY_ACK echoing msg.seq) in the display's format
+bool espnow_ack(const EspnowMsg &msg, uint8_t status);
+
+// Unicast to one display id, or to each paired display for DISPLAY_ALL
+// (the last sender while none is paired). False if any send was refused.
+// State a display should catch up on (power, time, profile, stats,
+// notifications, DDC and config mode) is also kept in its outbox until its
+// radio ACKs it, and only kept while it is away (see espnow_outbox_poll).
+bool espnow_send_to(uint8_t display, MsgType type, const uint8_t *payload, uint8_t len);
+
+// Same as espnow_send_to(DISPLAY_ALL, ...)
 bool espnow_send(MsgType type, const uint8_t *payload, uint8_t len);
 
+// Identical content for every display (stats): one broadcast frame once
+// more than one display is paired, unicast otherwise
+bool espnow_send_shared(MsgType type, const uint8_t *payload, uint8_t len);
+
+uint8_t espnow_display_count();
+
+// True if every active display advertised all of `cap` (ProtoCaps; a
+// display that never sent MSG_HELLO has PROTO_CAPS_LEGACY)
+bool espnow_displays_support(uint16_t cap);
+
+// Handle MSG_PAIR_REQ: add the sender to the peer table (NVS) and reply
+// MSG_PAIR_ACK to it. Returns its display id, DISPLAY_UNKNOWN if the
+// request is malformed.
+uint8_t espnow_accept_pairing(const EspnowMsg &msg);
+
+// Store-and-forward: match send results to what the outboxes hold, drop
+// what waited OUTBOX_MAX_AGE_MS, and send what is held to displays that
+// are back (heard from since their last failed unicast), a few frames per
+// call. Call every radio task pass; returns ms until it wants to run again.
+uint32_t espnow_outbox_poll();
+
+// Send the small messages gathered for each display since the last call
+// (MSG_BATCH, for displays with PROTO_CAP_BATCH). Call at the end of every
+// radio task pass; returns ms until a held batch is due (ESPNOW_BATCH_HOLD_MS).
+uint32_t espnow_batch_flush();
+
 // Send a message via broadcast (for commands like CONFIG_MODE/CONFIG_DONE)
 bool espnow_send_broadcast(MsgType type, const uint8_t *payload, uint8_t len);
+
+// Link counters: running totals since boot, except rx_queue_high, the
+// deepest the RX queue got since the previous call (reset by each call)
+struct EspnowLinkStats {
+    uint32_t rx_frames, rx_bytes, rx_drops;   // Drops: RX queue full
+    uint32_t rx_bad;                          // Dropped by frame_decode (CRC8, version, length)
+    uint32_t tx_frames, tx_bytes, tx_failed;  // Failed: esp_now_send refused (driver queue full)
+    uint32_t tx_batched;                      // Messages sent inside MSG_BATCH frames
+    uint32_t outbox_dropped;                  // Held messages dropped: FIFO full or expired
+    uint8_t rx_queue_high;
+    uint8_t rx_queue_size;
+    int8_t rssi;                              // Last frame received, dBm (0 = none yet)
+    int8_t tx_power_qdbm;                     // Link adaptation: current TX power, 0.25 dBm
+    uint8_t phy_rate_step;                    // ... rate step, 0 = ESPNOW_PHY_RATE / basic rate
+    int8_t far_rssi;                          // ... weakest display's report, 0 = none
+    uint8_t adapt_reason;                     // ... LinkAdaptReason of the latest change, 0xFF = none
+    uint32_t adapt_changes;                   // ... changes since boot
+};
+
+void espnow_link_stats(EspnowLinkStats &out);
+
+// Radio channel (MSG_CHANNEL). espnow_request_survey() marks a survey due
+// unless one ran within `holdoff_ms`; espnow_channel_update() runs it once
+// `allowed` (not in config mode, HID idle) and the air is quiet, then
+// orders the displays over if a clearly quieter channel turned up. Call
+// every radio task pass; returns ms until it wants to run again.
+uint8_t espnow_channel();
+void espnow_request_survey(uint32_t holdoff_ms);
+uint32_t espnow_channel_update(bool allowed);
+
+// Link adaptation (shared/link_adapt.h). espnow_adapt_report() takes the
+// LinkReportMsg a display's MSG_PING carries; espnow_adapt_update() steps
+// TX power / PHY rate once per window on the weakest present display and
+// the unicast send results. Radio task; returns ms until it runs again.
+void espnow_adapt_report(const EspnowMsg &msg);
+uint32_t espnow_adapt_update();
@@ -0,0 +1,162 @@
+/**
+ * @file fw_update.cpp
+ * Bridge firmware update over vendor HID, with rollback
+ *
+ * Same go-back-N rules as the display's bulk transfer: DATA is only taken
+ * at exactly next_offset, anything else is answered with the offset
+ * expected, and a BEGIN matching the transfer in progress resumes it.
+ * Update erases the slot a 4 KB sector at a time as it fills, so a sector
+ * erase is the longest the loop (and a pending keystroke) ever waits.
+ */
+
+#include "fw_update.h"
+#include "protocol.h"
+#include "usb_hid.h"
+#include <Arduino.h>
+#include <Update.h>
+#include <esp_ota_ops.h>
+#include <string.h>
+
+#define FW_REBOOT_DELAY_MS 200   // Let the final ACK reach the host first
+
+static bool active = false;
+static uint8_t xfer_id = 0;
+static uint32_t total_size = 0;
+static uint32_t expected_crc = 0;
+static uint32_t next_offset = 0;
+static uint32_t crc = 0;
+static bool reboot_pending = false;
+static uint32_t done_ms = 0;
+
+static void ack(uint8_t id, uint8_t status) {
+    BulkAckMsg msg = { id, status, next_offset };
+    send_vendor_report(MSG_FW_ACK, (const uint8_t *)&msg, sizeof(msg));
+}
+
+static void fail(uint8_t status, const char *why) {
+    Serial.printf("FW: %s\n", why);
+    if (Update.isRunning()) Update.abort();
+    active = false;
+    next_offset = 0;
+    ack(xfer_id, status);
+}
+
+void fw_update_begin(const uint8_t *payload, size_t len) {
+    if (len < sizeof(FwBeginMsg) || reboot_pending) return;
+    FwBeginMsg begin;
+    memcpy(&begin, payload, sizeof(begin));
+
+    bool same = active && begin.total_size == total_size && begin.crc32 == expected_crc;
+    if (same && !(begin.flags & BULK_FLAG_RESTART)) {
+        xfer_id = begin.xfer_id;
+        Serial.printf("FW: resuming at %lu/%lu\n", (unsigned long)next_offset, (unsigned long)total_size);
+        ack(xfer_id, BULK_OK);
+        return;
+    }
+
+    if (Update.isRunning()) Update.abort();
+    xfer_id = begin.xfer_id;
+    total_size = begin.total_size;
+    expected_crc = begin.crc32;
+    next_offset = 0;
+    crc = 0;
+    active = false;
+    if (total_size == 0 || !Update.begin(total_size)) {
+        Update.printError(Serial);
+        fail(BULK_ERR_BAD, "image rejected (size, or no OTA slot)");
+        return;
+    }
+    active = true;
+    Serial.printf("FW: receiving %lu bytes\n", (unsigned long)total_size);
+    ack(xfer_id, BULK_OK);
+}
+
+void fw_update_data(const uint8_t *payload, size_t len) {
+    if (len < sizeof(BulkDataHdr)) return;
+    BulkDataHdr hdr;
+    memcpy(&hdr, payload, sizeof(hdr));
+    if (!active || hdr.xfer_id != xfer_id) {
+        ack(hdr.xfer_id, BULK_ERR_BAD);
+        return;
+    }
+    const uint8_t *data = payload + sizeof(hdr);
+    size_t n = len - sizeof(hdr);
+    if (hdr.offset != next_offset || n == 0) {
+        ack(xfer_id, BULK_OK);   // Gap or duplicate: go back to next_offset
+        return;
+    }
+    if (next_offset + n > total_size) {
+        fail(BULK_ERR_BAD, "data past the announced size");
+        return;
+    }
+    if (Update.write(const_cast<uint8_t *>(data), n) != n) {
+        Update.printError(Serial);
+        fail(BULK_ERR_IO, "flash write failed");
+        return;
+    }
+    crc = crc32_update(crc, data, n);
+    next_offset += n;
+    ack(xfer_id, BULK_OK);
+}
+
+void fw_update_end(const uint8_t *payload, size_t len) {
+    if (len < sizeof(BulkEndMsg)) return;
+    if (reboot_pending && payload[0] == xfer_id) {
+        ack(xfer_id, BULK_DONE);   // Our DONE was lost: say it again
+        return;
+    }
+    if (!active || payload[0] != xfer_id) {
+        ack(payload[0], BULK_ERR_BAD);
+        return;
+    }
+    if (next_offset != total_size) {
+        ack(xfer_id, BULK_OK);   // Still missing data: tell the sender where
+        return;
+    }
+    if (crc != expected_crc) {
+        fail(BULK_ERR_CRC, "CRC mismatch");
+        return;
+    }
+    // Checks the image header, checksum and SHA-256, then switches the boot slot
+    if (!Update.end(true)) {
+        Update.printError(Serial);
+        fail(BULK_ERR_IO, "image verification failed");
+        return;
+    }
+    active = false;
+    reboot_pending = true;
+    done_ms = millis();
+    Serial.printf("FW: %lu bytes verified, rebooting when idle\n", (unsigned long)total_size);
+    ack(xfer_id, BULK_DONE);
+}
+
+void fw_update_poll(bool hid_idle) {
+    if (!reboot_pending || !hid_idle || millis() - done_ms < FW_REBOOT_DELAY_MS) return;
+    Serial.println("FW: rebooting into the new image");
+    Serial.flush();
+    ESP.restart();
+}
+
+// ============================================================
+// Rollback guard
+// ============================================================
+
+// The core would mark every image valid as soon as it boots; an image that
+// can't bring up USB would then be stuck on the desk. Wait for the companion.
+extern "C" bool verifyRollbackLater() {
+    return true;
+}
+
+void fw_update_confirm() {
+    static bool checked = false;
+    if (checked) return;
+    checked = true;
+
+    esp_ota_img_states_t img_state;
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    if (esp_ota_get_state_partition(running, &img_state) != ESP_OK) return;
+    if (img_state != ESP_OTA_IMG_PENDING_VERIFY) return;
+    if (esp_ota_mark_app_valid_cancel_rollback() == ESP_OK) {
+        Serial.printf("FW: image in %s confirmed\n", running->label);
+    }
+}
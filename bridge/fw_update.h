@@ -0,0 +1,21 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// ============================================================
+// Bridge firmware update over vendor HID (MSG_FW_*, protocol.h)
+//
+// Chunks go straight into the idle OTA slot (Update), CRC-32 accumulated on
+// the way; END checks it, lets Update verify the image and switches the
+// boot slot. Each message is answered with a MSG_FW_ACK. Loop context only.
+// ============================================================
+
+void fw_update_begin(const uint8_t *payload, size_t len);
+void fw_update_data(const uint8_t *payload, size_t len);
+void fw_update_end(const uint8_t *payload, size_t len);
+
+// Call every loop(): reboots into a finished update once `hid_idle`
+void fw_update_poll(bool hid_idle);
+
+// The companion reached this image over vendor HID: keep it (no rollback)
+void fw_update_confirm();
@@ -1,161 +1,955 @@
 #include <Arduino.h>
 #include "protocol.h"
+#include "key_layouts.h"
 #include "usb_hid.h"
 #include "espnow_link.h"
 #include "status_led.h"
+#include "fw_update.h"
+#include "log.h"
+#include "trace.h"
+#include "loop_watch.h"
+#include "clock_sync.h"
+#include "pipeline.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <algorithm>
 
-static uint32_t last_espnow_rx_ms = 0;
-static bool in_config_mode = false;
-static bool pc_asleep = false;
+#define VENDOR_MAX_PER_PASS 16   // Vendor messages read per loop() pass
+#define RADIO_TASK_STACK    6144
+
+#ifndef BRIDGE_STATS_INTERVAL_MS
+#define BRIDGE_STATS_INTERVAL_MS 1000   // MSG_BRIDGE_STATS period, 0 = off
+#endif
+#define COMPANION_IDLE_MS 5000          // No vendor traffic for this long: companion gone
+
+// A loop() pass longer than this is logged as a stall (loop_watch.h): a
+// keystroke waiting behind it reaches the PC that much later
+#ifndef LOOP_STALL_BUDGET_US
+#define LOOP_STALL_BUDGET_US 5000
+#endif
+
+// loop() sections, in pass order (BRIDGE_LOOP_SECTIONS in the companion)
+enum LoopSection : uint8_t {
+    LS_VENDOR_RX,    // Companion messages into to_radio
+    LS_USB_JOBS,     // Commands and reports from the radio task
+    LS_HID,          // usb_hid_update(): key press/release timing
+    LS_FW_UPDATE,
+    LS_CONSOLE,      // Serial console (trace dump)
+    LS_LED,
+    LS_STATS,        // MSG_BRIDGE_STATS
+    LS_CLOCK,        // Clock sync poll
+    LS_COUNT
+};
+static const char *const LOOP_SECTION_NAMES[LS_COUNT] = {
+    "vendor_rx", "usb_jobs", "hid", "fw_update", "console", "led", "stats", "clock",
+};
+
+// Written by one task, read by the other (pipeline.h)
+static volatile uint32_t last_espnow_rx_ms = 0;   // Radio
+static volatile uint32_t last_vendor_rx_ms = 0;   // USB
+static volatile bool in_config_mode = false;      // Radio
+static volatile bool pc_asleep = false;           // Radio
+static volatile bool hid_busy = false;            // USB: keys held, queued or still in to_usb
+static volatile uint8_t wake_signal = 0xFF;       // USB: WakeStatus of the latest remote wakeup, 0xFF = none new
+
+static SpscRing<RadioJob, BRIDGE_PIPE_LEN> to_radio;
+static SpscRing<UsbJob, BRIDGE_PIPE_LEN> to_usb;
+static TaskHandle_t usb_task = nullptr;     // loopTask
+static TaskHandle_t radio_task = nullptr;
+static bool stats_flush_due = false;        // USB: stats forwarded since the last RADIO_FLUSH
+
+// clock_sync is sampled on the USB task and answered on the radio task
+static portMUX_TYPE clock_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Duplicate suppression for sequenced commands (MSG_FLAG_SEQ): when a retry
+// arrives for a SEQ already executed, re-send the cached ACK instead of
+// running it again. Each display numbers its own SEQs, so one table per
+// display id (the last row for displays that never paired).
+#define SEEN_ROWS (BRIDGE_MAX_DISPLAYS + 1)
+static uint32_t seen_ms[SEEN_ROWS][256] = {};
+static uint8_t seen_status[SEEN_ROWS][256] = {};
+static uint32_t dup_count = 0;
+
+static uint8_t seen_row(const EspnowMsg &msg) {
+    return msg.display < BRIDGE_MAX_DISPLAYS ? msg.display : BRIDGE_MAX_DISPLAYS;
+}
+
+static void ack_command(const EspnowMsg &msg, uint8_t status) {
+    espnow_ack(msg, status);
+    if (msg.seq != 0) {
+        seen_ms[seen_row(msg)][msg.seq] = millis() | 1;  // never 0, which means "unseen"
+        seen_status[seen_row(msg)][msg.seq] = status;
+    }
+}
+
+static bool is_duplicate(const EspnowMsg &msg) {
+    uint32_t seen = seen_ms[seen_row(msg)][msg.seq];
+    return seen != 0 && millis() - seen < SEQ_DUP_WINDOW_MS;
+}
+
+// Stats coalescing: MSG_STATS reports are held here and sent once the vendor
+// HID buffer is drained, so a burst (live-rate stats, or USB delivering
+// several reports at once) goes out as one ESP-NOW frame instead of queuing
+// a frame per report behind the radio. stats_full folds in every report, for
+// displays that don't keep values a delta packet omits.
+static uint8_t stats_pending[PROTO_MAX_PAYLOAD];
+static uint8_t stats_pending_len = 0;
+static uint8_t stats_full[PROTO_MAX_PAYLOAD] = { 0 };   // Empty TLV
+static uint8_t stats_full_len = 1;
+static uint32_t stats_frames = 0, stats_merged = 0, stats_log_ms = 0;
+
+static void flush_stats() {
+    if (stats_pending_len == 0) return;
+    const uint8_t *pkt = stats_pending;
+    uint8_t len = stats_pending_len;
+    if (!espnow_displays_support(PROTO_CAP_DELTA_STATS)) {
+        pkt = stats_full;
+        len = stats_full_len;
+    }
+    // Older displays reject a packet holding any 32-bit/varint/tenths value
+    uint8_t narrow[PROTO_MAX_PAYLOAD];
+    if (!espnow_displays_support(PROTO_CAP_WIDE_STATS)) {
+        uint8_t n = tlv_narrow_stats(pkt, len, narrow);
+        if (n) {
+            pkt = narrow;
+            len = n;
+        }
+    }
+    espnow_send_shared(MSG_STATS, pkt, len);
+    stats_pending_len = 0;
+    stats_frames++;
+    trace(TR_STATS_RELAY, stats_pending_len, stats_merged);
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+    if (millis() - stats_log_ms >= 1000) {
+        stats_log_ms = millis();
+        LOG_D("STATS: relayed %lu frames (%lu reports merged)\n",
+              (unsigned long)stats_frames, (unsigned long)stats_merged);
+    }
+#endif
+}
+
+// A legacy StatsPayload from an old companion becomes TLV, so every frame
+// the displays get is TLV (v2 frames must be)
+static size_t stats_to_tlv(const uint8_t *&payload, size_t len, uint8_t *tlv) {
+    if (len < sizeof(StatsPayload) || payload[0] <= STAT_TYPE_MAX) return len;
+    StatsPayload sp;
+    memcpy(&sp, payload, sizeof(sp));
+    payload = tlv;
+    return stats_legacy_to_tlv(sp, tlv);
+}
+
+static void queue_stats(const uint8_t *payload, size_t len) {
+    if (len > sizeof(stats_pending)) len = sizeof(stats_pending);
+    tlv_merge_stats(stats_full, stats_full_len, sizeof(stats_full), payload, (uint8_t)len);   // Malformed: left as is
+    if (stats_pending_len > 0 &&
+        tlv_merge_stats(stats_pending, stats_pending_len, sizeof(stats_pending), payload, (uint8_t)len)) {
+        stats_merged++;
+        return;
+    }
+    flush_stats();
+    memcpy(stats_pending, payload, len);
+    stats_pending_len = (uint8_t)len;
+}
+
+// Bridge health (MSG_BRIDGE_STATS): work time per pass of both tasks and
+// the rings between them, reported with the link and HID counters while a
+// companion is reading. Not sent to an absent companion, whose unread
+// reports would only stall the writes. USB task.
+static uint32_t loop_sum_us = 0, loop_max_us = 0, loop_passes = 0;
+static uint32_t radio_sum_us = 0, radio_max_us = 0, radio_passes = 0;   // Under pass_mux
+static portMUX_TYPE pass_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t bridge_stats_ms = 0;
+
+static uint16_t avg_us(uint32_t sum, uint32_t passes) {
+    uint32_t avg = passes ? sum / passes : 0;
+    return avg > 0xFFFF ? 0xFFFF : (uint16_t)avg;
+}
+
+static void send_bridge_stats() {
+    uint32_t now = millis();
+    if (BRIDGE_STATS_INTERVAL_MS == 0 || now - bridge_stats_ms < BRIDGE_STATS_INTERVAL_MS) return;
+    bridge_stats_ms = now;
+
+    EspnowLinkStats link;
+    espnow_link_stats(link);
+    BridgeStatsMsg msg = {};
+    msg.uptime_ms = now;
+    msg.espnow_rx_frames = link.rx_frames;
+    msg.espnow_rx_bytes = link.rx_bytes;
+    msg.espnow_tx_frames = link.tx_frames;
+    msg.espnow_tx_bytes = link.tx_bytes;
+    msg.espnow_tx_failed = link.tx_failed;
+    msg.rx_queue_drops = link.rx_drops;
+    msg.rx_queue_high = link.rx_queue_high;
+    msg.rx_queue_size = link.rx_queue_size;
+    msg.hid_reports = usb_hid_reports_sent();
+    uint32_t vendor_rx, vendor_tx;
+    vendor_throughput(vendor_rx, vendor_tx);
+    msg.vendor_rx_bps = vendor_rx;
+    msg.vendor_tx_bps = vendor_tx;
+    msg.loop_avg_us = avg_us(loop_sum_us, loop_passes);
+    msg.loop_max_us = loop_max_us;
+    msg.rssi_dbm = link.rssi;
+    msg.free_heap = ESP.getFreeHeap();
+    msg.channel = espnow_channel();
+    loop_sum_us = loop_max_us = loop_passes = 0;
+    portENTER_CRITICAL(&pass_mux);
+    msg.radio_avg_us = avg_us(radio_sum_us, radio_passes);
+    msg.radio_max_us = radio_max_us;
+    radio_sum_us = radio_max_us = radio_passes = 0;
+    portEXIT_CRITICAL(&pass_mux);
+    msg.to_radio_high = to_radio.take_high();
+    msg.to_usb_high = to_usb.take_high();
+    msg.pipe_size = to_radio.capacity();
+    msg.to_radio_full = to_radio.full.load(std::memory_order_relaxed);
+    msg.to_usb_full = to_usb.full.load(std::memory_order_relaxed);
+    LoopWatchStats lw;
+    loop_watch_get(lw);
+    msg.loop_stalls = lw.stalls;
+    LoopStall last;
+    if (loop_watch_stalls(&last, 1) && last.boot == loop_watch_boot()) {
+        msg.stall_section = last.section;
+        msg.stall_us = last.total_us;
+    } else {
+        msg.stall_section = 0xFF;
+    }
+    msg.espnow_tx_batched = link.tx_batched;
+    msg.tx_power_qdbm = link.tx_power_qdbm;
+    msg.phy_rate_step = link.phy_rate_step;
+    msg.far_rssi_dbm = link.far_rssi;
+    msg.adapt_reason = link.adapt_reason;
+    msg.adapt_changes = link.adapt_changes;
+
+    if (last_vendor_rx_ms == 0 || now - last_vendor_rx_ms >= COMPANION_IDLE_MS) return;
+    send_vendor_report(MSG_BRIDGE_STATS, (const uint8_t *)&msg, sizeof(msg));
+}
+
+// Radio -> USB task. False when to_usb is full: the caller ACKs busy.
+static bool usb_push(uint8_t kind, uint8_t display, const void *data, uint8_t len, uint8_t type = 0) {
+    UsbJob *job = to_usb.claim();
+    if (!job) return false;
+    job->kind = kind;
+    job->display = display;
+    job->type = type;
+    job->len = len > sizeof(job->data) ? sizeof(job->data) : len;
+    if (job->len) memcpy(job->data, data, job->len);
+    to_usb.publish();
+    xTaskNotifyGive(usb_task);
+    return true;
+}
+
+// A display's message on to the companion (vendor HID, USB task)
+static bool relay_to_companion(uint8_t display, uint8_t type, const uint8_t *payload, uint8_t len) {
+    if (usb_push(USB_VENDOR, display, payload, len, type)) return true;
+    LOG_W("RELAY: USB queue full, 0x%02X from display %u dropped\n", type, display);
+    return false;
+}
+
+// ESP-NOW message handlers (espnow_dispatch() on the radio task).
+// Payloads are views into the RX queue, valid until the handler returns.
+
+// Every frame: link activity, then duplicate suppression for retries
+static bool on_display_msg(const EspnowMsg &msg) {
+    last_espnow_rx_ms = millis();
+    if (msg.seq != 0 && is_duplicate(msg)) {
+        dup_count++;
+        espnow_ack(msg, seen_status[seen_row(msg)][msg.seq]);
+        trace(TR_DUP_SEQ, msg.seq, msg.type);
+        LOG_D("SEQ: duplicate %u (type 0x%02X), re-ACKed (%lu total)\n",
+              msg.seq, msg.type, (unsigned long)dup_count);
+        return false;
+    }
+    trace(TR_CMD_RX, msg.type, msg.seq);
+    return true;
+}
+
+static void on_hotkey(const EspnowMsg &msg) {
+    if (msg.len >= sizeof(HotkeyMsg)) {
+        const HotkeyMsg *cmd = (const HotkeyMsg *)msg.payload;
+        LOG_D("CMD: hotkey mod=0x%02X key=0x%02X\n", cmd->modifiers, cmd->keycode);
+        bool queued = usb_push(USB_KEYSTROKE, msg.display, cmd, sizeof(HotkeyMsg));
+
+        // Send ACK (status = 0 queued, 2 = USB queue full)
+        ack_command(msg, queued ? 0 : 2);
+    } else {
+        LOG_E("ERR: hotkey payload too short (%d)\n", msg.len);
+        ack_command(msg, 1);  // status = 1 (error)
+    }
+}
+
+static void on_media_key(const EspnowMsg &msg) {
+    if (msg.len >= sizeof(MediaKeyMsg)) {
+        const MediaKeyMsg *cmd = (const MediaKeyMsg *)msg.payload;
+        LOG_D("CMD: media key 0x%04X\n", cmd->consumer_code);
+        bool queued = usb_push(USB_MEDIA_KEY, msg.display, cmd, sizeof(MediaKeyMsg));
+        ack_command(msg, queued ? 0 : 2);
+    } else {
+        LOG_E("ERR: media key payload too short (%d)\n", msg.len);
+        ack_command(msg, 1);
+    }
+}
+
+static void on_macro(const EspnowMsg &msg) {
+    uint8_t count = (msg.len >= 1) ? msg.payload[0] : 0;
+    uint8_t status = 1;
+    if (count > 0 && count <= MACRO_MAX_STEPS &&
+        msg.len >= 1 + count * sizeof(MacroStep)) {
+        bool queued = usb_push(USB_MACRO, msg.display, &msg.payload[1], count * sizeof(MacroStep));
+        status = queued ? 0 : 2;
+        LOG_D("CMD: macro %d steps%s\n", count, queued ? "" : " (busy)");
+    } else {
+        LOG_E("ERR: macro payload invalid (count=%d len=%d)\n", count, msg.len);
+    }
+    ack_command(msg, status);
+}
+
+static void on_type_text(const EspnowMsg &msg) {
+    uint8_t status = 1;
+    if (msg.len >= 2 && msg.payload[0] < KEY_LAYOUT_COUNT && msg.len - 1 <= TYPE_TEXT_MAX_BYTES) {
+        bool queued = usb_push(USB_TYPE_TEXT, msg.display, &msg.payload[1], msg.len - 1, msg.payload[0]);
+        status = queued ? 0 : 2;
+        LOG_D("CMD: type %d bytes (%s)%s\n", msg.len - 1, key_layout_name(msg.payload[0]), queued ? "" : " (busy)");
+    } else {
+        LOG_E("ERR: type text payload invalid (len=%d)\n", msg.len);
+    }
+    ack_command(msg, status);
+}
+
+static void on_button_press(const EspnowMsg &msg) {
+    if (msg.len >= 2) {
+        // Immediately ACK display (fast visual feedback)
+        ack_command(msg, 0);
+
+        // Relay to companion via vendor HID INPUT report. Untraced
+        // (2-byte) presses from older displays pass through as-is.
+        const uint8_t *p = msg.payload;
+        uint8_t n = msg.len < sizeof(ButtonPressMsg) ? msg.len : sizeof(ButtonPressMsg);
+        relay_to_companion(msg.display, MSG_BUTTON_PRESS, p, n);
+        trace(TR_PRESS_RELAY, p[0] << 8 | p[1], n >= 4 ? (uint32_t)(p[2] | p[3] << 8) : 0);
+        LOG_D("BTN: display %u page=%d widget=%d -> companion\n", msg.display, p[0], p[1]);
+    } else {
+        ack_command(msg, 1);
+    }
+}
+
+static void on_ddc_cmd(const EspnowMsg &msg) {
+    if (msg.len >= sizeof(DdcCmdMsg)) {
+        // DDC/CI runs on the host: relay to companion via vendor HID
+        ack_command(msg, 0);
+        relay_to_companion(msg.display, MSG_DDC_CMD, msg.payload, sizeof(DdcCmdMsg));
+        LOG_D("DDC: vcp=0x%02X -> companion\n", msg.payload[0]);
+    } else {
+        ack_command(msg, 1);
+    }
+}
+
+static void on_bench_probe(const EspnowMsg &msg) {
+    if (msg.len >= sizeof(BenchProbeMsg)) {
+        BenchProbeMsg probe;
+        memcpy(&probe, msg.payload, sizeof(probe));
+        probe.bridge_rx_us = micros();
+        ack_command(msg, usb_push(USB_BENCH_PROBE, msg.display, &probe, sizeof(probe)) ? 0 : 2);
+    } else {
+        ack_command(msg, 1);
+    }
+}
+
+static void on_bench_report(const EspnowMsg &msg) {
+    if (msg.len >= sizeof(BenchReportMsg)) {
+        ack_command(msg, 0);
+        relay_to_companion(msg.display, MSG_BENCH_REPORT, msg.payload, sizeof(BenchReportMsg));
+        Serial.println("BENCH: report -> companion");
+    } else {
+        ack_command(msg, 1);
+    }
+}
+
+static void on_replay_report(const EspnowMsg &msg) {
+    if (msg.len >= sizeof(ReplayReportMsg)) {
+        ack_command(msg, 0);
+        relay_to_companion(msg.display, MSG_REPLAY_REPORT, msg.payload, sizeof(ReplayReportMsg));
+        Serial.println("REPLAY: report -> companion");
+    } else {
+        ack_command(msg, 1);
+    }
+}
+
+static void on_stats_rate(const EspnowMsg &msg) {
+    if (msg.len >= sizeof(StatsRateMsg)) {
+        ack_command(msg, 0);
+        relay_to_companion(msg.display, MSG_STATS_RATE, msg.payload, sizeof(StatsRateMsg));
+        Serial.println("STATS: rate request -> companion");
+    } else {
+        ack_command(msg, 1);
+    }
+}
+
+static void on_stats_subscribe(const EspnowMsg &msg) {
+    if (msg.len >= sizeof(StatsSubscribeMsg)) {
+        ack_command(msg, 0);
+        relay_to_companion(msg.display, MSG_STATS_SUBSCRIBE, msg.payload, sizeof(StatsSubscribeMsg));
+        LOG_D("STATS: subscription -> companion\n");
+    } else {
+        ack_command(msg, 1);
+    }
+}
+
+static void on_pointer(const EspnowMsg &msg) {
+    if (msg.len < sizeof(PointerMsg)) {
+        if (msg.seq) ack_command(msg, 1);
+        return;
+    }
+    bool queued = usb_push(USB_POINTER, msg.display, msg.payload, sizeof(PointerMsg));
+    // Only button changes are sequenced; motion frames get no ACK airtime
+    if (msg.seq) ack_command(msg, queued ? 0 : 2);
+}
+
+static void on_bulk_ack(const EspnowMsg &msg) {
+    // Older displays leave out the trailing flags
+    if (msg.len >= offsetof(BulkAckMsg, flags)) {
+        relay_to_companion(msg.display, MSG_BULK_ACK, msg.payload,
+                           msg.len < sizeof(BulkAckMsg) ? msg.len : sizeof(BulkAckMsg));
+    }
+}
+
+// Host wake (MSG_WAKE_HOST): measured from the request to the companion's
+// first power state, for the display that asked. Radio task.
+static bool wake_pending = false;
+static uint8_t wake_display = 0;
+static uint32_t wake_started_ms = 0;
+
+static void send_wake_result(uint8_t status, uint16_t resume_ms, uint32_t latency_ms) {
+    WakeHostMsg res = {};
+    res.op = WAKE_RESULT;
+    res.status = status;
+    res.resume_ms = resume_ms;
+    res.latency_ms = latency_ms;
+    espnow_send_to(wake_display, MSG_WAKE_HOST, (const uint8_t *)&res, sizeof(res));
+}
+
+static void on_wake_host(const EspnowMsg &msg) {
+    if (msg.len < sizeof(WakeHostMsg) || msg.payload[0] != WAKE_REQ) {
+        ack_command(msg, 1);
+        return;
+    }
+    wake_signal = 0xFF;   // Whatever an earlier attempt left
+    bool queued = usb_push(USB_WAKE_HOST, msg.display, nullptr, 0);
+    ack_command(msg, queued ? 0 : 2);
+    if (!queued || msg.display >= BRIDGE_MAX_DISPLAYS) return;
+    // Another touch while waking keeps the clock running from the first
+    if (!wake_pending || wake_display != msg.display) wake_started_ms = millis();
+    wake_pending = true;
+    wake_display = msg.display;
+    Serial.printf("WAKE: display %u asks to wake the PC\n", msg.display);
+}
+
+// The companion is back (POWER_WAKE, or POWER_LOCKED at the lock screen)
+static void wake_host_done() {
+    if (!wake_pending) return;
+    wake_pending = false;
+    uint32_t now = millis();
+    uint32_t resumed = usb_last_resume_ms();
+    uint16_t resume_ms = 0xFFFF;
+    if (resumed && (int32_t)(resumed - wake_started_ms) >= 0) {
+        resume_ms = (uint16_t)std::min<uint32_t>(resumed - wake_started_ms, 0xFFFE);
+    }
+    send_wake_result(WAKE_DONE, resume_ms, now - wake_started_ms);
+    if (resume_ms != 0xFFFF) {
+        Serial.printf("WAKE: PC up after %lu ms (USB resumed after %u ms)\n",
+                      (unsigned long)(now - wake_started_ms), resume_ms);
+    } else {
+        Serial.printf("WAKE: PC up after %lu ms\n", (unsigned long)(now - wake_started_ms));
+    }
+}
+
+// Relays the USB task's remote-wakeup outcome and times out a PC that
+// never comes back. Returns ms until it wants to run again.
+static uint32_t wake_update() {
+    if (!wake_pending) return UINT32_MAX;
+    uint8_t signal = wake_signal;
+    if (signal != 0xFF) {
+        wake_signal = 0xFF;
+        send_wake_result(signal, 0xFFFF, 0);
+        Serial.printf("WAKE: %s\n", signal == WAKE_SIGNALLED ? "remote wakeup signalled"
+                                   : signal == WAKE_NOT_ARMED ? "host has remote wakeup disabled"
+                                   : "bus not suspended");
+    }
+    uint32_t elapsed = millis() - wake_started_ms;
+    if (elapsed < WAKE_TIMEOUT_MS) return WAKE_TIMEOUT_MS - elapsed;
+    wake_pending = false;
+    send_wake_result(WAKE_TIMEOUT, 0xFFFF, elapsed);
+    LOG_W("WAKE: no companion %lu ms after the request\n", (unsigned long)elapsed);
+    return UINT32_MAX;
+}
+
+static void on_pair_req(const EspnowMsg &msg) {
+    // Doubles as a heartbeat: ACK it like a PING once paired
+    if (espnow_accept_pairing(msg) != DISPLAY_UNKNOWN) ack_command(msg, 0);
+}
+
+static void on_ping(const EspnowMsg &msg) {
+    espnow_adapt_report(msg);   // How loud the display hears us; the ACK returns the favour
+    ack_command(msg, 0);
+}
+
+// A display seeing a poor link asks for a channel survey (espnow_channel_update)
+static void on_channel(const EspnowMsg &msg) {
+    if (msg.len < sizeof(ChannelMsg)) {
+        if (msg.seq) ack_command(msg, 1);
+        return;
+    }
+    ChannelMsg req;
+    memcpy(&req, msg.payload, sizeof(req));
+    if (msg.seq) ack_command(msg, 0);
+    if (req.op != CHANNEL_SURVEY_REQ) return;
+    Serial.printf("CHANNEL: display %u asks for a survey (%u%% failed, %d dBm)\n",
+                  msg.display, req.fail_pct, req.rssi_dbm);
+    espnow_request_survey(CHANNEL_RESURVEY_MS);
+}
+
+// A display asks for the shared timebase; answered once we have it ourselves.
+// t2 is the radio callback's stamp, so dispatch latency doesn't count.
+static void on_clock_sync(const EspnowMsg &msg) {
+    ClockSyncMsg req, reply;
+    if (msg.len < sizeof(req) || msg.display == DISPLAY_UNKNOWN) return;
+    memcpy(&req, msg.payload, sizeof(req));
+    portENTER_CRITICAL(&clock_mux);
+    bool answered = clock_sync_answer(req, clock_local_from_micros(msg.rx_us), reply);
+    portEXIT_CRITICAL(&clock_mux);
+    if (answered) {
+        espnow_send_to(msg.display, MSG_CLOCK_SYNC, (const uint8_t *)&reply, sizeof(reply));
+    }
+}
+
+// The companion's answer to our request (clock_sync_poll in loop()), USB task
+static void on_companion_clock(const uint8_t *payload, size_t len, int64_t rx_us) {
+    ClockSyncMsg reply;
+    if (len < sizeof(reply)) return;
+    memcpy(&reply, payload, sizeof(reply));
+    bool stepped;
+    portENTER_CRITICAL(&clock_mux);
+    bool used = clock_sync_sample(reply, rx_us, &stepped);
+    portEXIT_CRITICAL(&clock_mux);
+    if (!used) return;
+    if (stepped) {
+        Serial.printf("CLOCK: locked to companion (round trip %lu us)\n", (unsigned long)clock_sync.delay_us);
+    } else {
+        LOG_D("CLOCK: error %ld us, drift %.2f ppm, round trip %lu us\n", (long)clock_sync.last_error_us,
+              clock_sync.drift_ppm, (unsigned long)clock_sync.delay_us);
+    }
+}
+
+static void register_msg_handlers() {
+    espnow_set_rx_filter(on_display_msg);
+    espnow_register_handler(MSG_HOTKEY, on_hotkey);
+    espnow_register_handler(MSG_MEDIA_KEY, on_media_key);
+    espnow_register_handler(MSG_MACRO, on_macro);
+    espnow_register_handler(MSG_TYPE_TEXT, on_type_text);
+    espnow_register_handler(MSG_BUTTON_PRESS, on_button_press);
+    espnow_register_handler(MSG_DDC_CMD, on_ddc_cmd);
+    espnow_register_handler(MSG_BENCH_PROBE, on_bench_probe);
+    espnow_register_handler(MSG_BENCH_REPORT, on_bench_report);
+    espnow_register_handler(MSG_STATS_RATE, on_stats_rate);
+    espnow_register_handler(MSG_STATS_SUBSCRIBE, on_stats_subscribe);
+    espnow_register_handler(MSG_REPLAY_REPORT, on_replay_report);
+    espnow_register_handler(MSG_POINTER, on_pointer);
+    espnow_register_handler(MSG_BULK_ACK, on_bulk_ack);
+    espnow_register_handler(MSG_PAIR_REQ, on_pair_req);
+    espnow_register_handler(MSG_PING, on_ping);
+    espnow_register_handler(MSG_WAKE_HOST, on_wake_host);
+    espnow_register_handler(MSG_CHANNEL, on_channel);
+    espnow_register_handler(MSG_CLOCK_SYNC, on_clock_sync);
+}
+
+// A compact notification goes out as it came to displays that take it
+// (PROTO_CAP_COMPRESS), as a fixed NotificationMsg to the others. Radio task.
+static void relay_notification(uint8_t display, const uint8_t *payload, size_t len) {
+    static NotifText text;
+    if (!notif_parse(payload, len, text)) return;
+    if (payload[0] == NOTIF_COMPACT_MARK && espnow_displays_support(PROTO_CAP_COMPRESS)) {
+        uint8_t n = sizeof(NotifCompactHdr) + payload[offsetof(NotifCompactHdr, text_len)];
+        espnow_send_to(display, MSG_NOTIFICATION, payload, n);
+        Serial.printf("NOTIF: relayed (%u bytes, compact)\n", n);
+        return;
+    }
+    NotificationMsg fixed = {};
+    notif_copy_(fixed.app_name, sizeof(fixed.app_name), text.app_name, strlen(text.app_name));
+    notif_copy_(fixed.summary, sizeof(fixed.summary), text.summary, strlen(text.summary));
+    notif_copy_(fixed.body, sizeof(fixed.body), text.body, strlen(text.body));
+    fixed.urgency = text.urgency;
+    espnow_send_to(display, MSG_NOTIFICATION, (const uint8_t *)&fixed, sizeof(fixed));
+    Serial.printf("NOTIF: relayed (%d bytes)\n", (int)sizeof(fixed));
+}
+
+// One [TYPE][PAYLOAD...] message from the companion (vendor HID), for
+// `display` or, by default, all of them. Radio task; the bridge's own
+// messages never get here (handle_vendor_local).
+static void handle_vendor_message(const uint8_t *buf, size_t len, uint8_t display = DISPLAY_ALL) {
+    if (len < 1) return;
+    uint8_t msg_type = buf[0];
+    const uint8_t *payload = buf + 1;
+    size_t payload_len = len - 1;
+
+    switch (msg_type) {
+        case MSG_DISPLAY:
+            // [MSG_DISPLAY][id][TYPE][PAYLOAD...]: the inner message for one display
+            if (payload_len >= 2 && payload[1] != MSG_DISPLAY) {
+                handle_vendor_message(payload + 1, payload_len - 1, payload[0]);
+            }
+            break;
+        case MSG_STATS: {
+            if (payload_len < 1) break;
+            uint8_t tlv[1 + 8 * 4];
+            payload_len = stats_to_tlv(payload, payload_len, tlv);
+            if (display == DISPLAY_ALL) {
+                queue_stats(payload, payload_len);
+            } else {
+                espnow_send_to(display, MSG_STATS, payload, (uint8_t)min(payload_len, (size_t)PROTO_MAX_PAYLOAD));
+            }
+            break;
+        }
+        case MSG_HOST_STATS:
+            // Remote collector's stats: only firmware that takes them knows the
+            // type, and that firmware decodes every TLV width, so no narrowing
+            if (payload_len >= 2 && payload_len <= PROTO_MAX_PAYLOAD) {
+                if (display == DISPLAY_ALL) {
+                    espnow_send_shared(MSG_HOST_STATS, payload, payload_len);
+                } else {
+                    espnow_send_to(display, MSG_HOST_STATS, payload, payload_len);
+                }
+            }
+            break;
+        case MSG_POWER_STATE:
+            if (payload_len >= sizeof(PowerStateMsg)) {
+                espnow_send_to(display, MSG_POWER_STATE, payload, sizeof(PowerStateMsg));
+                pc_asleep = (payload[0] != POWER_WAKE);   // LED follows on the USB task
+                if (payload[0] != POWER_SHUTDOWN) wake_host_done();
+                Serial.printf("POWER: relayed state=%d\n", payload[0]);
+            }
+            break;
+        case MSG_TIME_SYNC:
+            if (payload_len >= sizeof(TimeSyncMsg)) {
+                espnow_send_to(display, MSG_TIME_SYNC, payload, sizeof(TimeSyncMsg));
+                Serial.println("TIME: relayed to display");
+            }
+            break;
+        case MSG_NOTIFICATION:
+            relay_notification(display, payload, payload_len);
+            break;
+        case MSG_PROFILE_SWITCH:
+            if (payload_len >= 1) {
+                uint8_t n = payload_len < sizeof(ProfileSwitchMsg) ? payload_len : sizeof(ProfileSwitchMsg);
+                espnow_send_to(display, MSG_PROFILE_SWITCH, payload, n);
+                Serial.printf("PROFILE: relayed switch (%d bytes)\n", n);
+            }
+            break;
+        case MSG_ACTION_RESULT:
+            if (payload_len >= sizeof(ActionResultMsg)) {
+                espnow_send_to(display, MSG_ACTION_RESULT, payload, sizeof(ActionResultMsg));
+            }
+            break;
+        case MSG_DDC_STATE:
+            if (payload_len >= sizeof(DdcStateMsg)) {
+                espnow_send_to(display, MSG_DDC_STATE, payload, sizeof(DdcStateMsg));
+            }
+            break;
+        case MSG_BENCH_START:
+            if (payload_len >= sizeof(BenchStartMsg)) {
+                espnow_send_to(display, MSG_BENCH_START, payload, sizeof(BenchStartMsg));
+                Serial.println("BENCH: start relayed to display");
+            }
+            break;
+        case MSG_REPLAY:
+            if (payload_len >= sizeof(ReplayCmdMsg)) {
+                espnow_send_to(display, MSG_REPLAY, payload, sizeof(ReplayCmdMsg));
+                Serial.println("REPLAY: command relayed to display");
+            }
+            break;
+        case MSG_BENCH_ECHO:
+            if (payload_len >= sizeof(BenchEchoMsg)) {
+                BenchEchoMsg echo;
+                memcpy(&echo, payload, sizeof(echo));
+                echo.bridge_echo_us = micros();
+                espnow_send_to(display, MSG_BENCH_ECHO, (uint8_t *)&echo, sizeof(echo));
+            }
+            break;
+        case MSG_BULK_BEGIN:
+        case MSG_BULK_DATA:
+        case MSG_BULK_END:
+            // Bulk file transfer: relay as-is, the display does flow control
+            if (payload_len >= 1 && payload_len <= PROTO_MAX_PAYLOAD) {
+                espnow_send_to(display, (MsgType)msg_type, payload, payload_len);
+            }
+            break;
+        case MSG_CONFIG_MODE:
+            espnow_send_to(display, MSG_CONFIG_MODE, nullptr, 0);
+            in_config_mode = true;
+            Serial.println("CONFIG_MODE: relayed to display");
+            break;
+        case MSG_CONFIG_DONE:
+            espnow_send_to(display, MSG_CONFIG_DONE, nullptr, 0);
+            in_config_mode = false;
+            Serial.println("CONFIG_DONE: relayed to display");
+            break;
+        default:
+            Serial.printf("VENDOR: unknown type 0x%02X len=%zu\n", msg_type, len);
+            break;
+    }
+}
+
+// Messages for the bridge itself, handled on the USB task: firmware
+// update (flash writes stay off the radio core) and the companion's clock
+// answer, stamped `rx_us` when read. False for everything to relay.
+static bool handle_vendor_local(const uint8_t *buf, size_t len, int64_t rx_us) {
+    const uint8_t *payload = buf + 1;
+    size_t payload_len = len - 1;
+    switch (buf[0]) {
+        case MSG_CLOCK_SYNC:
+            on_companion_clock(payload, payload_len, rx_us);
+            return true;
+        case MSG_FW_BEGIN:
+            fw_update_begin(payload, payload_len);
+            return true;
+        case MSG_FW_DATA:
+            fw_update_data(payload, payload_len);
+            return true;
+        case MSG_FW_END:
+            fw_update_end(payload, payload_len);
+            return true;
+        default:
+            return false;
+    }
+}
+
+// ============================================================
+// USB task: to_usb jobs
+// ============================================================
+
+// False if the HID scheduler can't take it yet
+static bool run_usb_job(const UsbJob &job) {
+    switch (job.kind) {
+        case USB_KEYSTROKE: {
+            HotkeyMsg cmd;
+            memcpy(&cmd, job.data, sizeof(cmd));
+            if (!fire_keystroke(cmd.modifiers, cmd.keycode)) return false;
+            status_led_flash();
+            return true;
+        }
+        case USB_MEDIA_KEY: {
+            MediaKeyMsg cmd;
+            memcpy(&cmd, job.data, sizeof(cmd));
+            if (!fire_media_key(cmd.consumer_code)) return false;
+            status_led_flash();
+            return true;
+        }
+        case USB_MACRO:
+            if (!fire_macro((const MacroStep *)job.data, job.len / sizeof(MacroStep))) return false;
+            status_led_flash();
+            return true;
+        case USB_BENCH_PROBE: {
+            BenchProbeMsg probe;
+            memcpy(&probe, job.data, sizeof(probe));
+            return fire_bench_probe(probe, job.display);
+        }
+        case USB_POINTER: {
+            PointerMsg ptr;
+            memcpy(&ptr, job.data, sizeof(ptr));
+            pointer_apply(ptr);
+            return true;
+        }
+        case USB_VENDOR:
+            send_vendor_report_from(job.display, job.type, job.data, job.len);
+            return true;
+        case USB_TYPE_TEXT:
+            if (!fire_text(job.type, job.data, job.len)) return false;
+            status_led_flash();
+            return true;
+        case USB_WAKE_HOST:
+            wake_signal = usb_remote_wakeup();
+            xTaskNotifyGive(radio_task);   // Result goes back to the display from there
+            return true;
+    }
+    return true;
+}
+
+// In order; a command the HID queue can't take yet stays at the front (and
+// everything behind it waits) until playback makes room, so once to_usb
+// fills up the radio side ACKs the next command busy
+static void drain_usb_jobs() {
+    while (UsbJob *job = to_usb.front()) {
+        if (!run_usb_job(*job)) {
+            if (usb_hid_busy()) break;
+            LOG_W("HID: job %u refused by an idle scheduler, dropped\n", job->kind);
+        }
+        to_usb.pop();
+    }
+}
+
+// ============================================================
+// Radio task
+// ============================================================
+static void radio_task_fn(void *) {
+    for (;;) {
+        uint32_t start_us = micros();
+
+        // Companion messages, in place; the slot is freed once handled
+        while (RadioJob *job = to_radio.front()) {
+            if (job->kind == RADIO_FLUSH) {
+                flush_stats();   // Vendor FIFO drained: send what the burst left
+            } else {
+                handle_vendor_message(job->buf, job->len);
+            }
+            to_radio.pop();
+        }
+
+        // Display frames: ACKs, relays, HID commands into to_usb
+        espnow_dispatch();
+
+        // Channel survey / switch: never mid-keystroke or while a display serves its SoftAP
+        uint32_t wait_ms = espnow_channel_update(!in_config_mode && !hid_busy);
+
+        // Held messages for displays that came back, send results for the rest
+        wait_ms = std::min(wait_ms, espnow_outbox_poll());
+
+        // TX power / PHY rate for the weakest display
+        wait_ms = std::min(wait_ms, espnow_adapt_update());
+
+        // Host wake in progress: remote-wakeup outcome, timeout
+        wait_ms = std::min(wait_ms, wake_update());
+
+        // Whatever this pass queued for each display, one frame per display
+        wait_ms = std::min(wait_ms, espnow_batch_flush());
+
+        uint32_t pass_us = micros() - start_us;
+        portENTER_CRITICAL(&pass_mux);
+        radio_sum_us += pass_us;
+        radio_passes++;
+        if (pass_us > radio_max_us) radio_max_us = pass_us;
+        portEXIT_CRITICAL(&pass_mux);
+
+        // Woken by each received frame and each to_radio publish
+        if (wait_ms > BRIDGE_RADIO_IDLE_MS) wait_ms = BRIDGE_RADIO_IDLE_MS;
+        TickType_t ticks = pdMS_TO_TICKS(wait_ms);
+        ulTaskNotifyTake(pdTRUE, ticks ? ticks : 1);
+    }
+}
 
 void setup() {
     status_led_init();  // Yellow during init
 
     Serial.begin(115200);  // Debug output on UART0 (GPIO 43/44)
     Serial.println("=== Bridge Unit Starting ===");
+    loop_watch_init(LOOP_SECTION_NAMES, LS_COUNT, LOOP_STALL_BUDGET_US);
 
     usb_hid_init();
     Serial.println("USB HID keyboard initialized");
 
     espnow_link_init();
+    register_msg_handlers();
     Serial.println("ESP-NOW link initialized");
 
+    usb_task = xTaskGetCurrentTaskHandle();
+    xTaskCreatePinnedToCore(radio_task_fn, "radio", RADIO_TASK_STACK, nullptr,
+                            BRIDGE_RADIO_PRIORITY, &radio_task, BRIDGE_RADIO_CORE);
+    espnow_set_rx_task(radio_task);
+    Serial.printf("Radio task on core %d, USB on core %d\n", BRIDGE_RADIO_CORE, xPortGetCoreID());
+
     Serial.println("Bridge ready - waiting for commands");
     status_led_set_state(LED_DISCONNECTED);  // Red until ESP-NOW traffic arrives
 }
 
+// USB task (Arduino loopTask)
 void loop() {
-    // --- Poll USB Vendor HID for incoming messages from companion app ---
-    // Protocol: [msg_type byte] [payload...]
-    // Requires companion to send type-prefixed HID reports (MSG_STATS byte before payload)
-    uint8_t vendor_buf[63];
-    size_t vendor_len = 0;
-    if (poll_vendor_hid(vendor_buf, vendor_len)) {
-        if (vendor_len >= 1) {
-            uint8_t msg_type = vendor_buf[0];
-            uint8_t *payload = vendor_buf + 1;
-            size_t payload_len = vendor_len - 1;
-
-            switch (msg_type) {
-                case MSG_STATS:
-                    if (payload_len >= 1) {
-                        espnow_send(MSG_STATS, payload, payload_len);
-                        Serial.printf("STATS: relayed %zu bytes to display\n", payload_len);
-                    }
-                    break;
-                case MSG_POWER_STATE:
-                    if (payload_len >= sizeof(PowerStateMsg)) {
-                        espnow_send(MSG_POWER_STATE, payload, sizeof(PowerStateMsg));
-                        pc_asleep = (payload[0] != POWER_WAKE);
-                        if (pc_asleep) {
-                            status_led_set_state(LED_SLEEP);
-                        }
-                        Serial.printf("POWER: relayed state=%d\n", payload[0]);
-                    }
-                    break;
-                case MSG_TIME_SYNC:
-                    if (payload_len >= sizeof(TimeSyncMsg)) {
-                        espnow_send(MSG_TIME_SYNC, payload, sizeof(TimeSyncMsg));
-                        Serial.println("TIME: relayed to display");
-                    }
-                    break;
-                case MSG_NOTIFICATION:
-                    if (payload_len >= sizeof(NotificationMsg)) {
-                        espnow_send(MSG_NOTIFICATION, payload, sizeof(NotificationMsg));
-                        Serial.printf("NOTIF: relayed (%d bytes)\n", (int)sizeof(NotificationMsg));
-                    }
-                    break;
-                case MSG_CONFIG_MODE:
-                    espnow_send(MSG_CONFIG_MODE, nullptr, 0);
-                    in_config_mode = true;
-                    status_led_set_state(LED_CONFIG_MODE);
-                    Serial.println("CONFIG_MODE: relayed to display");
-                    break;
-                case MSG_CONFIG_DONE:
-                    espnow_send(MSG_CONFIG_DONE, nullptr, 0);
-                    in_config_mode = false;
-                    Serial.println("CONFIG_DONE: relayed to display");
-                    break;
-                default:
-                    Serial.printf("VENDOR: unknown type 0x%02X len=%zu\n", msg_type, vendor_len);
-                    break;
-            }
+    uint32_t pass_start_us = micros();
+    loop_watch_begin();
+
+    // --- Vendor HID messages from the companion app ---
+    // Protocol: [msg_type byte] [payload...], longer messages reassembled
+    // from MSG_FRAGMENT pieces, read straight into to_radio slots. While
+    // the ring is full the rest stays in the FIFO: USB flow control holds
+    // the companion off until the radio task catches up.
+    bool drained = false, published = false;
+    for (int i = 0; i < VENDOR_MAX_PER_PASS; i++) {
+        if (!vendor_rx_pending()) {
+            drained = true;
+            break;
+        }
+        RadioJob *job = to_radio.claim();
+        if (!job) break;
+        size_t len = 0;
+        if (!poll_vendor_hid(job->buf, len)) {
+            drained = true;   // Only part of a fragmented message so far
+            break;
         }
+        int64_t rx_us = esp_timer_get_time();
+        last_vendor_rx_ms = millis();
+        fw_update_confirm();   // The companion reaches this image: no rollback
+        if (len < 1 || handle_vendor_local(job->buf, len, rx_us)) continue;
+        job->kind = RADIO_VENDOR;
+        job->len = (uint8_t)len;
+        to_radio.publish();
+        published = stats_flush_due = true;
     }
+    if (drained && stats_flush_due) {
+        if (RadioJob *job = to_radio.claim()) {
+            job->kind = RADIO_FLUSH;
+            job->len = 0;
+            to_radio.publish();
+            published = true;
+            stats_flush_due = false;
+        }
+    }
+    if (published) xTaskNotifyGive(radio_task);
+    loop_watch_mark(LS_VENDOR_RX);
 
-    // --- Poll ESP-NOW for incoming messages from display ---
-    uint8_t msg_type;
-    uint8_t payload[PROTO_MAX_PAYLOAD];
-    uint8_t payload_len;
+    // --- Commands and reports from the radio task ---
+    drain_usb_jobs();
+    loop_watch_mark(LS_USB_JOBS);
 
-    if (espnow_poll(msg_type, payload, payload_len)) {
-        last_espnow_rx_ms = millis();
+    // Press/release queued keystrokes without blocking the loop
+    usb_hid_update();
+    bool hid_idle = !usb_hid_busy() && to_usb.depth() == 0;
+    hid_busy = !hid_idle;
+    loop_watch_mark(LS_HID);
 
-        switch (msg_type) {
-            case MSG_HOTKEY: {
-                if (payload_len >= sizeof(HotkeyMsg)) {
-                    HotkeyMsg *cmd = (HotkeyMsg *)payload;
-                    Serial.printf("CMD: hotkey mod=0x%02X key=0x%02X\n",
-                                  cmd->modifiers, cmd->keycode);
-                    fire_keystroke(cmd->modifiers, cmd->keycode);
-                    status_led_flash();
+    // Finished firmware update: restart into it between keystrokes
+    fw_update_poll(hid_idle);
+    loop_watch_mark(LS_FW_UPDATE);
 
-                    // Send ACK
-                    HotkeyAckMsg ack = { 0 };  // status = 0 (success)
-                    espnow_send(MSG_HOTKEY_ACK, (uint8_t *)&ack, sizeof(ack));
-                } else {
-                    Serial.printf("ERR: hotkey payload too short (%d)\n", payload_len);
-                    HotkeyAckMsg ack = { 1 };  // status = 1 (error)
-                    espnow_send(MSG_HOTKEY_ACK, (uint8_t *)&ack, sizeof(ack));
-                }
-                break;
-            }
-            case MSG_MEDIA_KEY: {
-                if (payload_len >= sizeof(MediaKeyMsg)) {
-                    MediaKeyMsg *cmd = (MediaKeyMsg *)payload;
-                    Serial.printf("CMD: media key 0x%04X\n", cmd->consumer_code);
-                    fire_media_key(cmd->consumer_code);
-                    status_led_flash();
-                } else {
-                    Serial.printf("ERR: media key payload too short (%d)\n", payload_len);
-                }
-                break;
-            }
-            case MSG_BUTTON_PRESS: {
-                if (payload_len >= sizeof(ButtonPressMsg)) {
-                    // Immediately ACK display (fast visual feedback)
-                    HotkeyAckMsg ack = { 0 };
-                    espnow_send(MSG_HOTKEY_ACK, (uint8_t *)&ack, sizeof(ack));
-
-                    // Relay to companion via vendor HID INPUT report
-                    send_vendor_report(MSG_BUTTON_PRESS, payload, sizeof(ButtonPressMsg));
-                    Serial.printf("BTN: page=%d widget=%d -> companion\n",
-                                  payload[0], payload[1]);
-                }
-                break;
-            }
-            case MSG_PING: {
-                HotkeyAckMsg ack = { 0 };
-                espnow_send(MSG_HOTKEY_ACK, (uint8_t *)&ack, sizeof(ack));
-                break;
-            }
-            default:
-                Serial.printf("WARN: unknown msg type 0x%02X\n", msg_type);
-                break;
-        }
-    }
+    trace_serial_poll();  // 't' on the console dumps the trace ring
+    loop_watch_mark(LS_CONSOLE);
 
     // Update LED state: sleep overrides everything, then config mode, then connection
     if (pc_asleep) {
         status_led_set_state(LED_SLEEP);
-    } else if (!in_config_mode) {
-        if (last_espnow_rx_ms > 0 && millis() - last_espnow_rx_ms < 5000) {
-            status_led_set_state(LED_CONNECTED);
-        } else {
-            status_led_set_state(LED_DISCONNECTED);
-        }
+    } else if (in_config_mode) {
+        status_led_set_state(LED_CONFIG_MODE);
+    } else if (last_espnow_rx_ms > 0 && millis() - last_espnow_rx_ms < 5000) {
+        status_led_set_state(LED_CONNECTED);
+    } else {
+        status_led_set_state(LED_DISCONNECTED);
     }
 
     status_led_update();
-    delay(1);  // Yield to other tasks; keep responsive
+    loop_watch_mark(LS_LED);
+    send_bridge_stats();
+    loop_watch_mark(LS_STATS);
+
+    // Shared timebase from the companion, handed on to the displays (clock_sync.h)
+    ClockSyncMsg clock_req;
+    bool companion = last_vendor_rx_ms != 0 && millis() - last_vendor_rx_ms < COMPANION_IDLE_MS;
+    portENTER_CRITICAL(&clock_mux);
+    bool clock_due = clock_sync_poll(clock_req, companion);
+    portEXIT_CRITICAL(&clock_mux);
+    if (clock_due) send_vendor_report(MSG_CLOCK_SYNC, (const uint8_t *)&clock_req, sizeof(clock_req));
+    loop_watch_mark(LS_CLOCK);
+    loop_watch_end();
+
+    uint32_t pass_us = micros() - pass_start_us;
+    loop_sum_us += pass_us;
+    loop_passes++;
+    if (pass_us > loop_max_us) loop_max_us = pass_us;
+
+    // Sleep a tick (woken early by a to_usb publish), unless the companion is mid-burst
+    if (!vendor_rx_pending()) ulTaskNotifyTake(pdTRUE, 1);
 }
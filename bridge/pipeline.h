@@ -0,0 +1,109 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "protocol.h"
+
+// ============================================================
+// Bridge task layout
+//
+//   core 1  loopTask  USB: vendor HID RX/TX, HID report scheduler, status
+//                     LED, firmware update, clock sync with the companion
+//   core 0  radio     ESP-NOW dispatch and ACKs, relays to the displays,
+//                     stats coalescing, channel survey
+//
+// Each side owns its peripheral's state outright; they only talk through
+// two single-producer/single-consumer rings. The USB task reads vendor
+// messages straight into free to_radio slots and stops reading while the
+// ring is full, so a flooding companion is held off by USB flow control
+// instead of pushing display traffic aside. Keystrokes, media keys, macros
+// and reports for the companion travel in to_usb; a command arriving while
+// it is full is ACKed "busy" (status 2) and retried by the display, the same
+// as a full HID queue used to be. A stats burst then costs the radio side
+// a few frames and never holds up a keystroke on the USB side, and HID
+// playback never delays an ACK.
+// ============================================================
+
+#ifndef BRIDGE_RADIO_CORE
+#define BRIDGE_RADIO_CORE 0       // With the WiFi driver, away from USB on loopTask's core 1
+#endif
+#ifndef BRIDGE_RADIO_PRIORITY
+#define BRIDGE_RADIO_PRIORITY 2   // Above loopTask (1): ACKs go out while HID plays back
+#endif
+#ifndef BRIDGE_PIPE_LEN
+#define BRIDGE_PIPE_LEN 16        // Slots per ring (one stays empty)
+#endif
+#define BRIDGE_RADIO_IDLE_MS 10   // Radio task wake-up with nothing queued
+
+// Lock-free ring between exactly one producer and one consumer task.
+// claim() a slot, fill it in place, publish() it; the consumer reads
+// front() in place and pop()s it once done, so no slot is copied twice.
+template <typename T, uint8_t N>
+struct SpscRing {
+    T slots[N];
+    std::atomic<uint8_t> head{0};       // Next slot to fill (producer)
+    std::atomic<uint8_t> tail{0};       // Next slot to read (consumer)
+    std::atomic<uint8_t> high{0};       // Deepest since the last take_high()
+    std::atomic<uint32_t> full{0};      // claim() found no free slot
+
+    static uint8_t next(uint8_t i) { return (uint8_t)((i + 1) % N); }
+
+    T *claim() {
+        uint8_t h = head.load(std::memory_order_relaxed);
+        if (next(h) == tail.load(std::memory_order_acquire)) {
+            full.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        return &slots[h];
+    }
+    void publish() {
+        uint8_t h = next(head.load(std::memory_order_relaxed));
+        head.store(h, std::memory_order_release);
+        uint8_t d = (uint8_t)((h - tail.load(std::memory_order_relaxed) + N) % N);
+        if (d > high.load(std::memory_order_relaxed)) high.store(d, std::memory_order_relaxed);
+    }
+    T *front() {
+        uint8_t t = tail.load(std::memory_order_relaxed);
+        return t == head.load(std::memory_order_acquire) ? nullptr : &slots[t];
+    }
+    void pop() {
+        tail.store(next(tail.load(std::memory_order_relaxed)), std::memory_order_release);
+    }
+    uint8_t depth() const {
+        return (uint8_t)((head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire) + N) % N);
+    }
+    uint8_t take_high() { return high.exchange(0, std::memory_order_relaxed); }
+    static constexpr uint8_t capacity() { return N - 1; }
+};
+
+// USB -> radio
+enum RadioJobKind : uint8_t {
+    RADIO_VENDOR,       // A companion message for the displays, [TYPE][PAYLOAD...]
+    RADIO_FLUSH,        // Vendor FIFO drained: send the coalesced stats
+};
+
+struct RadioJob {
+    uint8_t kind;
+    uint8_t len;
+    uint8_t buf[VENDOR_MAX_MESSAGE];
+};
+
+// Radio -> USB
+enum UsbJobKind : uint8_t {
+    USB_KEYSTROKE,      // data: HotkeyMsg
+    USB_MEDIA_KEY,      // data: MediaKeyMsg
+    USB_MACRO,          // data: MacroStep[len / sizeof(MacroStep)]
+    USB_BENCH_PROBE,    // data: BenchProbeMsg
+    USB_POINTER,        // data: PointerMsg
+    USB_VENDOR,         // data: payload of a `type` report to the companion
+    USB_TYPE_TEXT,      // data: UTF-8, type = KeyLayout
+    USB_WAKE_HOST,      // No data: USB remote wakeup (MSG_WAKE_HOST)
+};
+
+struct UsbJob {
+    uint8_t kind;
+    uint8_t display;    // Sender
+    uint8_t type;       // USB_VENDOR: MsgType, USB_TYPE_TEXT: KeyLayout
+    uint8_t len;
+    uint8_t data[PROTO_MAX_PAYLOAD];
+};
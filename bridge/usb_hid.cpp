@@ -2,26 +2,302 @@
  * @file usb_hid.cpp
  * Composite USB HID implementation for bridge ESP32-S3
  *
- * Three HID interfaces:
- *   - Keyboard: fires hotkey keystrokes
+ * HID devices on the composite interface:
+ *   - Keyboard: fires hotkey keystrokes (boot 6KRO report, or an NKRO
+ *     bitmap report with -DHID_NKRO=1)
  *   - ConsumerControl: fires media keys (play/pause, volume, etc.)
- *   - Vendor (63-byte reports): receives stats data from companion app
+ *   - Pointer: relative mouse + absolute pointer for trackpad widgets
+ *   - Vendor (63-byte reports): receives stats data from companion app;
+ *     messages longer than one report travel as MSG_FRAGMENT pieces
+ *
+ * Keystrokes and macros are queued and played back by usb_hid_update()
+ * without blocking loop(). The bridge keeps the host-visible key state
+ * itself and sends it as one complete report per step, so a chord and its
+ * modifiers reach the host in a single interrupt-IN frame instead of one
+ * report per key.
+ *
+ * A display touched while the PC sleeps asks for a USB remote wakeup
+ * (usb_remote_wakeup, MSG_WAKE_HOST) rather than the bus resuming as a
+ * side effect of whichever HID report goes out next.
  *
  * Requires build flags: ARDUINO_USB_MODE=0, ARDUINO_USB_CDC_ON_BOOT=0
  */
 
 #include "usb_hid.h"
 #include "protocol.h"
+#include "hid_keys.h"
+#include "key_layouts.h"
+#include "log.h"
+#include "trace.h"
 
 #include <Arduino.h>
 #include <USB.h>
 #include <USBHIDKeyboard.h>
 #include <USBHIDConsumerControl.h>
 #include <USBHIDVendor.h>
+#include "tusb.h"
+
+#ifndef HID_NKRO
+#define HID_NKRO 0            // 1: bitmap keyboard report, no 6-key limit
+#endif
 
 static USBHIDKeyboard Keyboard;
 static USBHIDConsumerControl ConsumerControl;
-static USBHIDVendor Vendor(63, false);  // 63-byte reports, no size prepend
+static USBHIDVendor Vendor(VENDOR_REPORT_SIZE, false);  // 63-byte reports, no size prepend
+
+// Vendor RX queue: a whole BULK_WINDOW of fragmented chunks plus stats and
+// control traffic, so the host can keep writing while the loop relays
+#define VENDOR_RX_BUFFER (32 * VENDOR_REPORT_SIZE)
+
+// Vendor traffic per direction, report payload bytes (1 s windows in usb_hid_update)
+static uint32_t vendor_rx_bytes = 0, vendor_tx_bytes = 0;
+static uint32_t vendor_rx_bps = 0, vendor_tx_bps = 0;
+
+static uint32_t hid_reports = 0;   // Keyboard, consumer and pointer reports since boot
+static volatile uint32_t usb_resumed_ms = 0;   // Latest bus resume (TinyUSB task), 0 = none
+
+// ============================================================
+// Keyboard reports
+//
+// Key state lives here as a modifier byte plus a bitmap of pressed usages.
+// key_press()/key_release() only edit it; key_send() puts the whole state
+// on the wire as one report. Scheduler steps call key_send() once, so a
+// chord with modifiers is a single report and a macro step is exactly one
+// interrupt-IN frame.
+//
+// Keycodes are the Arduino ones from protocol.h, mapped to usages by
+// hid_key_lookup() (hid_keys.h).
+// ============================================================
+#define KEY_ERR_ROLLOVER 0x01      // 6KRO: more than six keys down
+
+static uint8_t key_mods = 0;
+static uint8_t key_bits[16];       // Pressed usages 0x00-0x7F (raw keycodes reach 0x77)
+
+#if HID_NKRO
+#define NKRO_REPORT_ID  0x10       // Clear of the composite's stock report IDs
+#define NKRO_USAGE_MAX  0x7F       // Bitmap covers every usage an Arduino keycode can name
+
+static const uint8_t nkro_descriptor[] = {
+    0x05, 0x01,                    // Usage Page (Generic Desktop)
+    0x09, 0x06,                    // Usage (Keyboard)
+    0xA1, 0x01,                    // Collection (Application)
+    0x85, NKRO_REPORT_ID,          //   Report ID
+    0x05, 0x07,                    //   Usage Page (Keyboard/Keypad)
+    0x19, 0xE0, 0x29, 0xE7,        //   Usage Min/Max: left ctrl .. right GUI
+    0x15, 0x00, 0x25, 0x01,        //   Logical 0..1
+    0x75, 0x01, 0x95, 0x08,        //   8 x 1 bit
+    0x81, 0x02,                    //   Input (Data, Var, Abs): modifier byte
+    0x19, 0x00, 0x29, NKRO_USAGE_MAX,
+    0x95, NKRO_USAGE_MAX + 1,      //   One bit per usage
+    0x81, 0x02,                    //   Input (Data, Var, Abs): key bitmap
+    0xC0                           // End Collection
+};
+
+class NkroKeyboard : public USBHIDDevice {
+public:
+    NkroKeyboard() {
+        static bool added = false;
+        if (!added) {
+            added = true;
+            hid.addDevice(this, sizeof(nkro_descriptor));
+        }
+    }
+    void begin() { hid.begin(); }
+    uint16_t _onGetDescriptor(uint8_t *buffer) override {
+        memcpy(buffer, nkro_descriptor, sizeof(nkro_descriptor));
+        return sizeof(nkro_descriptor);
+    }
+    bool send(const uint8_t *report, size_t len) { return hid.SendReport(NKRO_REPORT_ID, report, len); }
+
+private:
+    USBHID hid;
+};
+
+static NkroKeyboard Nkro;
+
+static void nkro_begin() {
+    Nkro.begin();
+}
+#endif
+
+static void key_press(uint8_t modifiers, uint8_t keycode) {
+    key_mods |= modifiers;
+    if (!keycode) return;
+    uint8_t usage, mods;
+    if (!hid_key_lookup(keycode, usage, mods)) {
+        LOG_W("HID: no usage for keycode 0x%02X\n", keycode);
+        return;
+    }
+    key_mods |= mods;
+    if (usage) key_bits[usage >> 3] |= 1 << (usage & 7);
+}
+
+static void key_release(uint8_t modifiers, uint8_t keycode) {
+    uint8_t usage = 0, mods = 0;
+    if (keycode && hid_key_lookup(keycode, usage, mods) && usage) {
+        key_bits[usage >> 3] &= ~(1 << (usage & 7));
+    }
+    key_mods &= ~(modifiers | mods);
+}
+
+static void key_release_all() {
+    key_mods = 0;
+    memset(key_bits, 0, sizeof(key_bits));
+}
+
+static void key_send() {
+#if HID_NKRO
+    uint8_t report[1 + sizeof(key_bits)];
+    report[0] = key_mods;
+    memcpy(&report[1], key_bits, sizeof(key_bits));
+    Nkro.send(report, sizeof(report));
+    hid_reports++;
+#else
+    KeyReport report = {};
+    report.modifiers = key_mods;
+    uint8_t n = 0;
+    for (int usage = 1; usage <= 0x7F; usage++) {
+        if (!(key_bits[usage >> 3] & (1 << (usage & 7)))) continue;
+        if (n == sizeof(report.keys)) {
+            memset(report.keys, KEY_ERR_ROLLOVER, sizeof(report.keys));
+            break;
+        }
+        report.keys[n++] = (uint8_t)usage;
+    }
+    Keyboard.sendReport(&report);
+    hid_reports++;
+#endif
+}
+
+// ============================================================
+// Pointer (trackpad widgets, MSG_POINTER)
+//
+// One device, two report IDs: a relative mouse with 16-bit deltas (no
+// splitting of fast swipes into +-127 steps) plus wheel/pan, and an
+// absolute pointer over 0..POINTER_ABS_MAX that hosts map onto the whole
+// desktop. Frames from the display only update ptr_*; usb_hid_update()
+// sends at most one report per pass, so bursts that arrive together are
+// merged into one report per USB frame.
+// ============================================================
+#define POINTER_REPORT_REL 0x11
+#define POINTER_REPORT_ABS 0x12
+
+static const uint8_t pointer_descriptor[] = {
+    0x05, 0x01, 0x09, 0x02,        // Generic Desktop / Mouse
+    0xA1, 0x01,                    // Collection (Application)
+    0x85, POINTER_REPORT_REL,      //   Report ID
+    0x09, 0x01, 0xA1, 0x00,        //   Pointer, Collection (Physical)
+    0x05, 0x09, 0x19, 0x01, 0x29, 0x03,   // Buttons 1-3
+    0x15, 0x00, 0x25, 0x01, 0x95, 0x03, 0x75, 0x01, 0x81, 0x02,
+    0x95, 0x01, 0x75, 0x05, 0x81, 0x03,   // Padding
+    0x05, 0x01, 0x09, 0x30, 0x09, 0x31,   // X, Y: 16-bit relative
+    0x16, 0x01, 0x80, 0x26, 0xFF, 0x7F, 0x75, 0x10, 0x95, 0x02, 0x81, 0x06,
+    0x09, 0x38,                           // Wheel
+    0x15, 0x81, 0x25, 0x7F, 0x75, 0x08, 0x95, 0x01, 0x81, 0x06,
+    0x05, 0x0C, 0x0A, 0x38, 0x02,         // Consumer / AC Pan
+    0x15, 0x81, 0x25, 0x7F, 0x75, 0x08, 0x95, 0x01, 0x81, 0x06,
+    0xC0, 0xC0,
+    0x05, 0x01, 0x09, 0x02,        // Generic Desktop / Mouse
+    0xA1, 0x01,                    // Collection (Application)
+    0x85, POINTER_REPORT_ABS,      //   Report ID
+    0x09, 0x01, 0xA1, 0x00,        //   Pointer, Collection (Physical)
+    0x05, 0x09, 0x19, 0x01, 0x29, 0x03,   // Buttons 1-3
+    0x15, 0x00, 0x25, 0x01, 0x95, 0x03, 0x75, 0x01, 0x81, 0x02,
+    0x95, 0x01, 0x75, 0x05, 0x81, 0x03,   // Padding
+    0x05, 0x01, 0x09, 0x30, 0x09, 0x31,   // X, Y: 0..POINTER_ABS_MAX absolute
+    0x15, 0x00, 0x26, POINTER_ABS_MAX & 0xFF, POINTER_ABS_MAX >> 8,
+    0x75, 0x10, 0x95, 0x02, 0x81, 0x02,
+    0xC0, 0xC0
+};
+
+class PointerDevice : public USBHIDDevice {
+public:
+    PointerDevice() {
+        static bool added = false;
+        if (!added) {
+            added = true;
+            hid.addDevice(this, sizeof(pointer_descriptor));
+        }
+    }
+    void begin() { hid.begin(); }
+    uint16_t _onGetDescriptor(uint8_t *buffer) override {
+        memcpy(buffer, pointer_descriptor, sizeof(pointer_descriptor));
+        return sizeof(pointer_descriptor);
+    }
+    bool send(uint8_t report_id, const uint8_t *report, size_t len) { return hid.SendReport(report_id, report, len); }
+
+private:
+    USBHID hid;
+};
+
+static PointerDevice Pointer;
+
+static bool ptr_absolute = false;       // Mode of the pending report
+static uint8_t ptr_buttons = 0;
+static uint8_t ptr_button_seq = 0;
+static bool ptr_seq_valid = false;
+static int32_t ptr_dx = 0, ptr_dy = 0;  // Relative motion not yet reported
+static int16_t ptr_wheel = 0, ptr_pan = 0;
+static uint16_t ptr_x = 0, ptr_y = 0;   // Absolute position
+static bool ptr_dirty = false;
+static uint32_t ptr_reports = 0, ptr_frames = 0;
+
+static int16_t take_clamped(int32_t &v, int32_t limit) {
+    int32_t out = v > limit ? limit : v < -limit ? -limit : v;
+    v -= out;
+    return (int16_t)out;
+}
+
+static void pointer_flush() {
+    if (!ptr_dirty) return;
+    if (ptr_absolute) {
+        uint8_t r[5] = { ptr_buttons, (uint8_t)ptr_x, (uint8_t)(ptr_x >> 8), (uint8_t)ptr_y, (uint8_t)(ptr_y >> 8) };
+        Pointer.send(POINTER_REPORT_ABS, r, sizeof(r));
+        ptr_dirty = false;
+    } else {
+        int16_t dx = take_clamped(ptr_dx, 32767);
+        int16_t dy = take_clamped(ptr_dy, 32767);
+        int32_t wheel = ptr_wheel, pan = ptr_pan;
+        int8_t w = (int8_t)take_clamped(wheel, 127);
+        int8_t p = (int8_t)take_clamped(pan, 127);
+        ptr_wheel = (int16_t)wheel;
+        ptr_pan = (int16_t)pan;
+        uint8_t r[7] = { ptr_buttons, (uint8_t)dx, (uint8_t)(dx >> 8), (uint8_t)dy, (uint8_t)(dy >> 8),
+                         (uint8_t)w, (uint8_t)p };
+        Pointer.send(POINTER_REPORT_REL, r, sizeof(r));
+        ptr_dirty = ptr_dx || ptr_dy || ptr_wheel || ptr_pan;   // Remainder goes next pass
+    }
+    ptr_reports++;
+    hid_reports++;
+}
+
+void pointer_apply(const PointerMsg &msg) {
+    bool absolute = msg.flags & POINTER_ABSOLUTE;
+    // Buttons only from the newest state: a retried press must not undo a later release
+    bool newer = !ptr_seq_valid || (int8_t)(msg.button_seq - ptr_button_seq) > 0;
+    bool buttons_change = newer && msg.buttons != ptr_buttons;
+
+    // Keep each button edge and mode switch in a report of its own
+    if ((buttons_change || absolute != ptr_absolute) && ptr_dirty) pointer_flush();
+    ptr_absolute = absolute;
+    if (newer) {
+        ptr_buttons = msg.buttons;
+        ptr_button_seq = msg.button_seq;
+        ptr_seq_valid = true;
+    }
+    if (absolute) {
+        ptr_x = msg.x < 0 ? 0 : msg.x;
+        ptr_y = msg.y < 0 ? 0 : msg.y;
+        ptr_dirty = true;
+    } else {
+        ptr_dx += msg.x;
+        ptr_dy += msg.y;
+        ptr_wheel += msg.wheel;
+        ptr_pan += msg.pan;
+        ptr_dirty |= msg.x || msg.y || msg.wheel || msg.pan || buttons_change;
+    }
+    ptr_frames++;
+}
 
 void usb_hid_init() {
     // Force USB D+/D- low to trigger host disconnect before switching
@@ -34,53 +310,492 @@ void usb_hid_init() {
 
     // Register all HID devices before USB.begin()
     Keyboard.begin();
+#if HID_NKRO
+    nkro_begin();
+#endif
     ConsumerControl.begin();
+    Pointer.begin();
+    Vendor.setRxBufferSize(VENDOR_RX_BUFFER);
     Vendor.begin();
 
+    USB.onEvent(ARDUINO_USB_RESUME_EVENT, [](void *, esp_event_base_t, int32_t, void *) {
+        usb_resumed_ms = millis() | 1;
+    });
     USB.productName("HotkeyBridge");
     USB.manufacturerName("CrowPanel");
     USB.begin();
     delay(1000);  // Allow USB enumeration after PHY switch
-    Serial.println("USB HID composite initialized (Keyboard + ConsumerControl + Vendor)");
+    Serial.printf("USB HID composite initialized (Keyboard %s + ConsumerControl + Pointer + Vendor)\n",
+                  HID_NKRO ? "NKRO" : "6KRO");
 }
 
-void fire_keystroke(uint8_t modifiers, uint8_t keycode) {
-    // Press modifier keys based on protocol.h modifier masks
-    if (modifiers & MOD_CTRL)  Keyboard.press(KEY_LEFT_CTRL);
-    if (modifiers & MOD_SHIFT) Keyboard.press(KEY_LEFT_SHIFT);
-    if (modifiers & MOD_ALT)   Keyboard.press(KEY_LEFT_ALT);
-    if (modifiers & MOD_GUI)   Keyboard.press(KEY_LEFT_GUI);
+// ============================================================
+// Keystroke scheduler
+//
+// fire_keystroke()/fire_media_key() only enqueue. usb_hid_update() walks
+// each command through press -> hold -> release -> gap using micros(), so
+// loop() never blocks while a key is held down.
+//
+// Single hotkeys keep a human-length hold. Macro taps are held and gapped
+// for HID_MACRO_FRAME_MS only: with the 1 ms interrupt-IN interval every
+// macro step is one report in consecutive frames, so typed text runs at
+// the poll rate instead of 40 chars/s.
+//
+// Typed text (MSG_TYPE_TEXT) waits in text_pool as UTF-8 and takes one
+// queue slot. When it reaches the front, each character is looked up in
+// the host layout as it is about to play and its strokes (dead key, then
+// the key) go out as macro taps, so a 240-byte string needs neither 240
+// queue slots nor a translation pass up front.
+// ============================================================
+#define HID_QUEUE_SIZE  (MACRO_MAX_STEPS + 16)  // One full macro plus headroom
+#define HID_TEXT_POOL   (2 * TYPE_TEXT_MAX_BYTES)   // One string playing, one waiting
+#define HID_HOLD_MS     20   // Minimum hold time for host to register
+#define HID_GAP_MS      5    // Released state visible before the next press
+#ifndef HID_MACRO_FRAME_MS
+#define HID_MACRO_FRAME_MS 1 // Macro tap hold and gap (one bInterval)
+#endif
+
+enum HidCmdKind : uint8_t {
+    HID_CMD_KEY,          // Tap: modifiers + keycode
+    HID_CMD_MEDIA,        // Tap: consumer code
+    HID_CMD_PRESS,        // Press and keep held (macro)
+    HID_CMD_RELEASE,      // Release (macro)
+    HID_CMD_RELEASE_ALL,  // Release everything (macro)
+    HID_CMD_DELAY,        // Wait value ms (macro)
+    HID_CMD_BENCH,        // Latency probe: held like a tap, reported over vendor HID (value = slot)
+    HID_CMD_TEXT,         // Type value bytes of text_pool (modifiers = KeyLayout)
+};
+
+struct HidCmd {
+    HidCmdKind kind;
+    uint8_t modifiers;
+    uint8_t keycode;
+    uint16_t value;       // Consumer code (MEDIA), delay ms (DELAY), probe slot (BENCH) or bytes (TEXT)
+    bool macro;           // Macro step: frame-length hold and gap
+};
 
-    // Press the key itself
-    Keyboard.press(keycode);
-    delay(20);  // Minimum hold time for host to register
-    Keyboard.releaseAll();
+enum HidPhase : uint8_t { HID_IDLE, HID_HELD, HID_GAP };
+
+static HidCmd hid_queue[HID_QUEUE_SIZE];
+static uint8_t hid_head = 0;
+static uint8_t hid_tail = 0;
+static HidPhase hid_phase = HID_IDLE;
+static HidCmd hid_current;
+static uint32_t hid_phase_start = 0;   // micros()
+static uint32_t hid_hold_us = 0;
+static uint32_t hid_gap_us = 0;
+static uint32_t hid_dropped = 0;
+
+// Keystrokes-per-second over the last completed 1 s window
+static uint32_t kps_window_start = 0;
+static uint16_t kps_window_count = 0;
+static uint16_t kps_last = 0;
+
+// Probes waiting in the HID queue (HID_CMD_BENCH refers to a slot here)
+#define BENCH_SLOTS (BENCH_WINDOW * 2)
+static BenchProbeMsg bench_slots[BENCH_SLOTS];
+static uint8_t bench_display[BENCH_SLOTS];   // Sender, so the echo finds its way back
+static uint8_t bench_next_slot = 0;
+static uint8_t bench_queued = 0;
+
+// Text of the HID_CMD_TEXT commands, in queue order
+static uint8_t text_pool[HID_TEXT_POOL];
+static uint16_t text_pool_tail = 0;     // Next byte to type
+static uint16_t text_pool_used = 0;     // Queued and not yet typed
+static uint16_t text_left = 0;          // Bytes left of the string playing
+static uint8_t text_layout = KEY_LAYOUT_US;
+static KeyStroke text_strokes[KEY_STROKES_MAX];   // Of the character playing
+static uint8_t text_stroke_n = 0, text_stroke_i = 0;
+
+static uint8_t hid_free_slots() {
+    return HID_QUEUE_SIZE - 1 - usb_hid_queue_depth();
+}
+
+static bool hid_enqueue(const HidCmd &cmd) {
+    if (hid_free_slots() == 0) {
+        hid_dropped++;
+        trace(TR_HID_DROP, 0, hid_dropped);
+        LOG_W("HID: queue full, dropped (total %lu)\n", (unsigned long)hid_dropped);
+        return false;
+    }
+    hid_queue[hid_head] = cmd;
+    hid_head = (hid_head + 1) % HID_QUEUE_SIZE;
+    return true;
+}
+
+// Start a command. Returns how long it occupies the scheduler before its
+// release step (the tap hold, the wait for DELAY, 0 otherwise), in us.
+static uint32_t hid_begin(const HidCmd &cmd) {
+    uint32_t hold_us = (cmd.macro ? HID_MACRO_FRAME_MS : HID_HOLD_MS) * 1000u;
+    switch (cmd.kind) {
+        case HID_CMD_KEY:
+            key_press(cmd.modifiers, cmd.keycode);
+            key_send();
+            trace(TR_HID_KEY, cmd.modifiers << 8 | cmd.keycode);
+            LOG_D("HID: mod=0x%02X key=0x%02X\n", cmd.modifiers, cmd.keycode);
+            return hold_us;
+        case HID_CMD_MEDIA:
+            ConsumerControl.press(cmd.value);
+            hid_reports++;
+            trace(TR_HID_MEDIA, cmd.value);
+            LOG_D("HID: media key 0x%04X\n", cmd.value);
+            return hold_us;
+        case HID_CMD_PRESS:
+            key_press(cmd.modifiers, cmd.keycode);
+            key_send();
+            return 0;
+        case HID_CMD_RELEASE:
+            key_release(cmd.modifiers, cmd.keycode);
+            key_send();
+            return 0;
+        case HID_CMD_RELEASE_ALL:
+            key_release_all();
+            key_send();
+            return 0;
+        case HID_CMD_BENCH: {
+            // Where a keyboard report would go out: stamp and hand to the companion
+            BenchProbeMsg &probe = bench_slots[cmd.value];
+            probe.bridge_hid_us = micros();
+            send_vendor_report_from(bench_display[cmd.value], MSG_BENCH_PROBE, (const uint8_t *)&probe, sizeof(probe));
+            bench_queued--;
+            return HID_HOLD_MS * 1000u;
+        }
+        case HID_CMD_DELAY:
+            return cmd.value * 1000u;
+        case HID_CMD_TEXT:   // Expanded by hid_next(), never started
+            return 0;
+    }
+    return 0;
+}
+
+// End of the hold phase: release taps (macro press/release steps are explicit).
+// Only the tap's own keys are released so keys held by a macro PRESS survive.
+static void hid_end(const HidCmd &cmd) {
+    if (cmd.kind == HID_CMD_KEY) {
+        key_release(cmd.modifiers, cmd.keycode);
+        key_send();
+    } else if (cmd.kind == HID_CMD_MEDIA) {
+        ConsumerControl.release();
+        hid_reports++;
+    }
+}
 
-    Serial.printf("HID: mod=0x%02X key=0x%02X\n", modifiers, keycode);
+bool fire_keystroke(uint8_t modifiers, uint8_t keycode) {
+    HidCmd cmd = { HID_CMD_KEY, modifiers, keycode, 0, false };
+    return hid_enqueue(cmd);
 }
 
-void fire_media_key(uint16_t consumer_code) {
-    ConsumerControl.press(consumer_code);
-    delay(20);
-    ConsumerControl.release();
-    Serial.printf("HID: media key 0x%04X\n", consumer_code);
+bool fire_media_key(uint16_t consumer_code) {
+    HidCmd cmd = { HID_CMD_MEDIA, 0, 0, consumer_code, false };
+    return hid_enqueue(cmd);
+}
+
+bool fire_bench_probe(const BenchProbeMsg &probe, uint8_t display) {
+    if (bench_queued >= BENCH_SLOTS) return false;
+    HidCmd cmd = { HID_CMD_BENCH, 0, 0, bench_next_slot, false };
+    if (!hid_enqueue(cmd)) return false;
+    bench_slots[bench_next_slot] = probe;
+    bench_display[bench_next_slot] = display;
+    bench_next_slot = (bench_next_slot + 1) % BENCH_SLOTS;
+    bench_queued++;
+    return true;
+}
+
+bool fire_macro(const MacroStep *steps, uint8_t count) {
+    // All-or-nothing: never start a macro that can't be queued completely
+    if (count + 1 > hid_free_slots()) {
+        hid_dropped++;
+        Serial.printf("HID: macro of %u steps does not fit (free %u)\n", count, hid_free_slots());
+        return false;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        const MacroStep &s = steps[i];
+        HidCmd cmd = { HID_CMD_KEY, s.a, s.b, 0, true };
+        switch (s.op) {
+            case MACRO_OP_TAP:         cmd.kind = HID_CMD_KEY; break;
+            case MACRO_OP_PRESS:       cmd.kind = HID_CMD_PRESS; break;
+            case MACRO_OP_RELEASE:     cmd.kind = HID_CMD_RELEASE; break;
+            case MACRO_OP_RELEASE_ALL: cmd.kind = HID_CMD_RELEASE_ALL; break;
+            case MACRO_OP_DELAY:
+                cmd = { HID_CMD_DELAY, 0, 0, (uint16_t)(s.a | (s.b << 8)), true };
+                break;
+            case MACRO_OP_MEDIA:
+                cmd = { HID_CMD_MEDIA, 0, 0, (uint16_t)(s.a | (s.b << 8)), true };
+                break;
+            default:
+                Serial.printf("HID: macro step %u has unknown op %u, skipped\n", i, s.op);
+                continue;
+        }
+        hid_enqueue(cmd);
+    }
+    // A macro must never leave keys stuck down on the host
+    HidCmd release = { HID_CMD_RELEASE_ALL, 0, 0, 0, true };
+    if (count > 0 && steps[count - 1].op != MACRO_OP_RELEASE_ALL) hid_enqueue(release);
+    return true;
+}
+
+bool fire_text(uint8_t layout, const uint8_t *utf8, uint16_t len) {
+    if (!len) return true;
+    if (len > HID_TEXT_POOL - text_pool_used || hid_free_slots() == 0) {
+        hid_dropped++;
+        Serial.printf("HID: text of %u bytes does not fit (pool free %u)\n", len, HID_TEXT_POOL - text_pool_used);
+        return false;
+    }
+    uint16_t head = (text_pool_tail + text_pool_used) % HID_TEXT_POOL;
+    for (uint16_t i = 0; i < len; i++) text_pool[(head + i) % HID_TEXT_POOL] = utf8[i];
+    text_pool_used += len;
+    HidCmd cmd = { HID_CMD_TEXT, layout, 0, len, true };
+    return hid_enqueue(cmd);
+}
+
+// Next stroke of the text playing as a macro tap. False once it is all typed.
+static bool text_next(HidCmd &cmd) {
+    while (text_stroke_i >= text_stroke_n) {
+        if (!text_left) return false;
+        uint8_t buf[4];
+        uint8_t n = text_left < sizeof(buf) ? (uint8_t)text_left : sizeof(buf);
+        for (uint8_t i = 0; i < n; i++) buf[i] = text_pool[(text_pool_tail + i) % HID_TEXT_POOL];
+        const uint8_t *p = buf;
+        uint32_t cp = 0;
+        utf8_next(p, buf + n, cp);
+        uint16_t used = (uint16_t)(p - buf);
+        text_pool_tail = (text_pool_tail + used) % HID_TEXT_POOL;
+        text_pool_used -= used;
+        text_left -= used;
+        text_stroke_n = key_layout_strokes(text_layout, cp, text_strokes);
+        text_stroke_i = 0;
+        if (!text_stroke_n && cp != '\r') {
+            LOG_D("HID: U+%04lX has no key on layout %s, skipped\n", (unsigned long)cp, key_layout_name(text_layout));
+        }
+    }
+    const KeyStroke &k = text_strokes[text_stroke_i++];
+    cmd = { HID_CMD_KEY, k.mods, (uint8_t)(KEY_RAW_BASE + k.usage), 0, true };
+    return true;
+}
+
+// Command to start next: the text playing comes before the queue
+static bool hid_next(HidCmd &cmd) {
+    for (;;) {
+        if (text_next(cmd)) return true;
+        if (hid_tail == hid_head) return false;
+        cmd = hid_queue[hid_tail];
+        hid_tail = (hid_tail + 1) % HID_QUEUE_SIZE;
+        if (cmd.kind != HID_CMD_TEXT) return true;
+        text_left = cmd.value;
+        text_layout = cmd.modifiers;
+    }
+}
+
+void usb_hid_update() {
+    uint32_t now = micros();
+    pointer_flush();
+
+    switch (hid_phase) {
+        case HID_IDLE:
+            if (hid_next(hid_current)) {
+                hid_hold_us = hid_begin(hid_current);
+                hid_gap_us = (hid_current.macro ? HID_MACRO_FRAME_MS : HID_GAP_MS) * 1000u;
+                hid_phase = HID_HELD;
+                hid_phase_start = now;
+            }
+            break;
+        case HID_HELD:
+            if (now - hid_phase_start >= hid_hold_us) {
+                hid_end(hid_current);
+                hid_phase = HID_GAP;
+                hid_phase_start = now;
+                if (hid_current.kind == HID_CMD_KEY || hid_current.kind == HID_CMD_MEDIA ||
+                    hid_current.kind == HID_CMD_PRESS) {
+                    kps_window_count++;
+                }
+            }
+            break;
+        case HID_GAP:
+            if (now - hid_phase_start >= hid_gap_us) {
+                hid_phase = HID_IDLE;
+            }
+            break;
+    }
+
+    if (now - kps_window_start >= 1000000) {
+        kps_last = kps_window_count;
+        if (kps_last > 0) {
+            LOG_D("HID: %u keystrokes/s (queued %u)\n", kps_last, usb_hid_queue_depth());
+        }
+        if (ptr_frames > 0) {
+            LOG_D("HID: pointer %lu frames -> %lu reports\n", (unsigned long)ptr_frames, (unsigned long)ptr_reports);
+            ptr_frames = ptr_reports = 0;
+        }
+        vendor_rx_bps = vendor_rx_bytes;
+        vendor_tx_bps = vendor_tx_bytes;
+        vendor_rx_bytes = vendor_tx_bytes = 0;
+        if (vendor_rx_bps || vendor_tx_bps) {
+            LOG_D("VENDOR: rx %lu.%lu KB/s, tx %lu.%lu KB/s\n",
+                  (unsigned long)(vendor_rx_bps / 1024), (unsigned long)(vendor_rx_bps % 1024 * 10 / 1024),
+                  (unsigned long)(vendor_tx_bps / 1024), (unsigned long)(vendor_tx_bps % 1024 * 10 / 1024));
+        }
+        kps_window_count = 0;
+        kps_window_start = now;
+    }
+}
+
+bool usb_hid_busy() {
+    return hid_phase != HID_IDLE || hid_tail != hid_head || text_left || text_stroke_i < text_stroke_n;
+}
+
+uint8_t usb_hid_queue_depth() {
+    return (uint8_t)((hid_head - hid_tail + HID_QUEUE_SIZE) % HID_QUEUE_SIZE);
+}
+
+uint16_t usb_hid_keystrokes_per_sec() {
+    return kps_last;
+}
+
+uint32_t usb_hid_reports_sent() {
+    return hid_reports;
+}
+
+uint8_t usb_remote_wakeup() {
+    if (!tud_suspended()) return WAKE_BUS_AWAKE;
+    // Refused unless the host armed remote wakeup (SET_FEATURE) before suspending
+    return tud_remote_wakeup() ? WAKE_SIGNALLED : WAKE_NOT_ARMED;
+}
+
+uint32_t usb_last_resume_ms() {
+    return usb_resumed_ms;
+}
+
+
+// ============================================================
+// Vendor HID transport
+//
+// Single-report messages pass straight through. MSG_FRAGMENT reports are
+// reassembled in order (see protocol.h) and returned as one message once
+// the FRAG_LAST piece arrives.
+// ============================================================
+static uint8_t frag_buf[VENDOR_MAX_MESSAGE];
+static size_t frag_len = 0;
+static uint8_t frag_seq = 0;
+static uint8_t frag_next = 0;      // Next expected fragment index
+static bool frag_active = false;
+static uint32_t frag_dropped = 0;   // Partial messages abandoned
+static uint8_t tx_frag_seq = 0;
+
+static void frag_drop() {
+    if (frag_active) {
+        frag_dropped++;
+        Serial.printf("VENDOR: fragmented message seq=%d dropped (%lu total)\n",
+                      frag_seq, (unsigned long)frag_dropped);
+    }
+    frag_active = false;
 }
 
 bool poll_vendor_hid(uint8_t *buf, size_t &len) {
-    if (Vendor.available()) {
-        int n = Vendor.read(buf, 63);
-        if (n > 0) {
+    uint8_t report[VENDOR_REPORT_SIZE];
+    while (Vendor.available()) {
+        int n = Vendor.read(report, VENDOR_REPORT_SIZE);
+        if (n <= 0) return false;
+        vendor_rx_bytes += n;
+
+        if (report[0] != MSG_FRAGMENT) {
+            memcpy(buf, report, n);
             len = (size_t)n;
             return true;
         }
+        if (n < FRAG_HEADER_SIZE) continue;
+
+        uint8_t seq = report[1];
+        uint8_t index = report[2] & FRAG_INDEX_MASK;
+        bool last = report[2] & FRAG_LAST;
+        size_t chunk = report[3];
+        if (chunk > (size_t)(n - FRAG_HEADER_SIZE)) chunk = n - FRAG_HEADER_SIZE;
+
+        if (index == 0) {
+            frag_drop();  // A new message interrupts any unfinished one
+            frag_active = true;
+            frag_seq = seq;
+            frag_len = 0;
+        } else if (!frag_active || seq != frag_seq || index != frag_next) {
+            frag_drop();
+            continue;
+        }
+
+        if (frag_len + chunk > VENDOR_MAX_MESSAGE) {
+            frag_drop();
+            continue;
+        }
+        memcpy(&frag_buf[frag_len], &report[FRAG_HEADER_SIZE], chunk);
+        frag_len += chunk;
+        frag_next = index + 1;
+
+        if (last) {
+            frag_active = false;
+            memcpy(buf, frag_buf, frag_len);
+            len = frag_len;
+            return true;
+        }
     }
     return false;
 }
 
+uint32_t vendor_fragments_dropped() {
+    return frag_dropped;
+}
+
+bool vendor_rx_pending() {
+    return Vendor.available() > 0;
+}
+
+void vendor_throughput(uint32_t &rx_bytes_per_sec, uint32_t &tx_bytes_per_sec) {
+    rx_bytes_per_sec = vendor_rx_bps;
+    tx_bytes_per_sec = vendor_tx_bps;
+}
+
 void send_vendor_report(uint8_t msg_type, const uint8_t *payload, uint8_t len) {
-    uint8_t buf[63];
-    memset(buf, 0, sizeof(buf));
-    buf[0] = msg_type;
-    if (len > 0 && payload) memcpy(&buf[1], payload, min((int)len, 62));
-    Vendor.write(buf, 1 + len);
+    uint8_t buf[VENDOR_REPORT_SIZE];
+    if (1 + (size_t)len > VENDOR_MAX_MESSAGE) return;
+
+    if (1 + (size_t)len <= VENDOR_REPORT_SIZE) {
+        memset(buf, 0, sizeof(buf));
+        buf[0] = msg_type;
+        if (len > 0 && payload) memcpy(&buf[1], payload, len);
+        Vendor.write(buf, 1 + len);
+        vendor_tx_bytes += 1 + len;
+        return;
+    }
+
+    // Too big for one report: [TYPE][PAYLOAD] split into MSG_FRAGMENT reports
+    uint8_t msg[VENDOR_MAX_MESSAGE];
+    msg[0] = msg_type;
+    memcpy(&msg[1], payload, len);
+    size_t total = 1 + (size_t)len;
+
+    uint8_t seq = ++tx_frag_seq;
+    uint8_t index = 0;
+    for (size_t off = 0; off < total; index++) {
+        size_t chunk = min(total - off, (size_t)FRAG_DATA_SIZE);
+        memset(buf, 0, sizeof(buf));
+        buf[0] = MSG_FRAGMENT;
+        buf[1] = seq;
+        buf[2] = index | ((off + chunk >= total) ? FRAG_LAST : 0);
+        buf[3] = (uint8_t)chunk;
+        memcpy(&buf[FRAG_HEADER_SIZE], &msg[off], chunk);
+        Vendor.write(buf, sizeof(buf));
+        vendor_tx_bytes += sizeof(buf);
+        off += chunk;
+    }
+}
+
+void send_vendor_report_from(uint8_t display, uint8_t msg_type, const uint8_t *payload, uint8_t len) {
+    if (display == 0 || display == DISPLAY_UNKNOWN) {
+        send_vendor_report(msg_type, payload, len);
+        return;
+    }
+    // [MSG_DISPLAY][id][TYPE][PAYLOAD...]
+    uint8_t msg[VENDOR_MAX_MESSAGE - 1];
+    if (2 + (size_t)len > sizeof(msg)) return;
+    msg[0] = display;
+    msg[1] = msg_type;
+    if (len > 0 && payload) memcpy(&msg[2], payload, len);
+    send_vendor_report(MSG_DISPLAY, msg, (uint8_t)(2 + len));
 }
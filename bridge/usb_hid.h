@@ -1,9 +1,54 @@
 #pragma once
 #include <cstdint>
 #include <cstddef>
+#include "protocol.h"
 
 void usb_hid_init();
-void fire_keystroke(uint8_t modifiers, uint8_t keycode);
-void fire_media_key(uint16_t consumer_code);
+
+// Queue a keystroke / media key (non-blocking). Returns false if the queue is full.
+bool fire_keystroke(uint8_t modifiers, uint8_t keycode);
+bool fire_media_key(uint16_t consumer_code);
+
+// Queue a whole macro (MSG_MACRO steps). All-or-nothing: returns false without
+// queuing anything if the steps don't fit. A trailing release-all is added.
+bool fire_macro(const MacroStep *steps, uint8_t count);
+
+// Queue UTF-8 text (MSG_TYPE_TEXT) to type in host layout `layout`
+// (KeyLayout). It plays at macro speed, one character translated at a
+// time; characters with no key on the layout are skipped. False without
+// queuing anything if the text pool or the queue is full.
+bool fire_text(uint8_t layout, const uint8_t *utf8, uint16_t len);
+
+// Queue a latency probe (MSG_BENCH_PROBE) from `display`. It occupies the
+// scheduler like a tap, then goes to the companion as a vendor report with
+// bridge_hid_us set.
+bool fire_bench_probe(const BenchProbeMsg &probe, uint8_t display);
+
+// Trackpad pointer frame (MSG_POINTER). Motion accumulates and goes out as
+// at most one report per usb_hid_update(); a button edge flushes what was
+// pending first, so clicks are never merged away.
+void pointer_apply(const PointerMsg &msg);
+
+// Advance the press/hold/release scheduler. Call every loop() iteration.
+void usb_hid_update();
+bool usb_hid_busy();                    // Key held, commands or text pending
+uint8_t usb_hid_queue_depth();          // Commands waiting to be pressed
+uint16_t usb_hid_keystrokes_per_sec();  // Completed keystrokes in the last 1 s window
+uint32_t usb_hid_reports_sent();        // Keyboard/consumer/pointer reports since boot
+
+// USB remote wakeup for a display touched while the PC sleeps
+// (MSG_WAKE_HOST). Returns the WakeStatus of the attempt: WAKE_SIGNALLED,
+// WAKE_BUS_AWAKE or WAKE_NOT_ARMED. USB task.
+uint8_t usb_remote_wakeup();
+uint32_t usb_last_resume_ms();          // millis() of the latest bus resume, 0 = none since boot
+
+// Vendor HID messages, [TYPE][PAYLOAD...]. Fragmented messages (MSG_FRAGMENT)
+// are reassembled / split transparently; buf must hold VENDOR_MAX_MESSAGE bytes.
 bool poll_vendor_hid(uint8_t *buf, size_t &len);
 void send_vendor_report(uint8_t msg_type, const uint8_t *payload, uint8_t len);
+// Message from a display: MSG_DISPLAY envelope unless it is display 0 (protocol.h)
+void send_vendor_report_from(uint8_t display, uint8_t msg_type, const uint8_t *payload, uint8_t len);
+uint32_t vendor_fragments_dropped();    // Incomplete/out-of-order fragmented messages
+bool vendor_rx_pending();               // Reports waiting in the RX FIFO
+// Vendor report bytes per direction over the last completed 1 s window
+void vendor_throughput(uint32_t &rx_bytes_per_sec, uint32_t &tx_bytes_per_sec);
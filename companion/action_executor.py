@@ -7,15 +7,24 @@ Handles 5 action types:
 - ACTION_LAUNCH_APP: Launch or focus an application
 - ACTION_SHELL_CMD: Run a shell command (sudo blocked)
 - ACTION_OPEN_URL: Open URL in default browser
+
+Presses from the display go through ActionDispatcher, which keeps the
+actions pre-resolved and runs them on a persistent worker pool.
 """
 
+import collections
+import json
 import logging
 import re
 import shutil
 import subprocess
+import threading
+import time
 import webbrowser
+from concurrent.futures import ThreadPoolExecutor
 from subprocess import DEVNULL
 
+from companion.window_tracker import get_window_tracker
 from companion.config_manager import (
     ACTION_HOTKEY,
     ACTION_MEDIA_KEY,
@@ -134,119 +143,251 @@ _MOD_NAMES = {
 # Action dispatch
 # ---------------------------------------------------------------------------
 
+# Worker threads kept alive for button presses (a press mostly waits on fork/exec)
+ACTION_WORKERS = 4
+
+# Result codes reported back to the display (ActionResultStatus in shared/protocol.h)
+ACTION_RESULT_OK = 0
+ACTION_RESULT_NO_ACTION = 1
+ACTION_RESULT_FAILED = 2
+
+# Page index the display uses for hardware buttons (hw_input.cpp)
+HW_BUTTON_PAGE = 0xFF
+
+_which_cache = {}
+
+
+def _which(tool):
+    """shutil.which() remembered per tool: one PATH scan instead of one per press."""
+    try:
+        return _which_cache[tool]
+    except KeyError:
+        path = _which_cache[tool] = shutil.which(tool)
+        return path
+
+
+def resolve_action(widget):
+    """Turn a widget (or hardware button) dict into a zero-argument callable.
+
+    Everything that only depends on the config -- command cleanup, key combo
+    strings, sudo screening -- is done here, once. The callable returns False
+    when the action could not be started. Returns None when nothing runs on
+    the PC (display-local action, empty command, unknown key).
+    """
+    action_type = widget.get("action_type", ACTION_HOTKEY)
+
+    # Skip display-local actions (handled on device, not on PC)
+    if action_type in DISPLAY_LOCAL_ACTIONS:
+        return None
+
+    if action_type == ACTION_LAUNCH_APP:
+        launch_command = widget.get("launch_command", "")
+        if not launch_command:
+            return None
+        # Strip .desktop Exec format codes (%u, %U, %f, %F, etc.)
+        clean_cmd = re.sub(r'%[uUfFdDnNickvm]', '', launch_command).strip()
+        wm_class = widget.get("launch_wm_class", "")
+        focus_or_launch = widget.get("launch_focus_or_launch", True)
+        return lambda: _launch_app(clean_cmd, wm_class if focus_or_launch else "")
+    if action_type == ACTION_SHELL_CMD:
+        cmd = widget.get("shell_command", "")
+        if not cmd:
+            return None
+        # Block sudo commands
+        if "sudo" in cmd.split():
+            logging.warning("Shell command blocked (contains sudo): %s", cmd)
+            return None
+        return lambda: _run_shell_cmd(cmd)
+    if action_type == ACTION_OPEN_URL:
+        url = widget.get("url", "")
+        return (lambda: _open_url(url)) if url else None
+    if action_type == ACTION_HOTKEY:
+        key_combo = _key_combo(widget.get("modifiers", 0), widget.get("keycode", 0))
+        return (lambda: _send_key_combo(key_combo)) if key_combo else None
+    if action_type == ACTION_MEDIA_KEY:
+        key_name = _CONSUMER_KEY_NAMES.get(widget.get("consumer_code", 0))
+        return (lambda: _send_media_key(key_name)) if key_name else None
+    if action_type == ACTION_DDC:
+        args = (widget.get("ddc_vcp_code", 0x10), widget.get("ddc_value", 0),
+                widget.get("ddc_adjustment", 0), widget.get("ddc_display", 0))
+        return lambda: execute_ddc_direct(*args)
+    if action_type in (ACTION_DISPLAY_SETTINGS, ACTION_DISPLAY_CLOCK, ACTION_DISPLAY_PICTURE):
+        return None
+    logging.warning("Unknown action_type %d", action_type)
+    return None
+
+
 def execute_action(config_manager, page_idx: int, widget_idx: int):
     """Look up widget by page+widget index and execute its configured action."""
     widget = config_manager.get_widget(page_idx, widget_idx)
     if widget is None:
         logging.warning("No widget at page=%d widget=%d", page_idx, widget_idx)
         return
-
-    action_type = widget.get("action_type", ACTION_HOTKEY)
-
-    # Skip display-local actions (handled on device, not on PC)
-    if action_type in DISPLAY_LOCAL_ACTIONS:
-        logging.debug("Skipping display-local action type %d", action_type)
+    action = resolve_action(widget)
+    if action is None:
+        logging.debug("Nothing to run on the PC for page=%d widget=%d (action_type %d)",
+                      page_idx, widget_idx, widget.get("action_type", ACTION_HOTKEY))
         return
+    action()
+
+
+class ActionDispatcher:
+    """Runs button-press actions on a persistent worker pool.
+
+    Every widget of every profile is resolved (resolve_action) into a table
+    keyed by (profile_idx, page_idx, widget_idx), scroll grid entries by
+    (profile_idx, page_idx, widget_idx, entry_idx). refresh() brings it up
+    to date with the ConfigManager: only entries whose widget changed are
+    resolved again, the rest are carried over, and the new table goes in
+    with one assignment. The config watcher calls it after each reload,
+    submit() only when it finds the generation moved on without one, so a
+    press costs a dict lookup and a queue hand-off instead of a config
+    walk, PATH scans and a new thread. submit() is meant to be called from
+    the HID read thread only.
+    """
 
-    if action_type == ACTION_LAUNCH_APP:
-        _exec_launch_app(widget)
-    elif action_type == ACTION_SHELL_CMD:
-        _exec_shell_cmd(widget)
-    elif action_type == ACTION_OPEN_URL:
-        _exec_open_url(widget)
-    elif action_type == ACTION_HOTKEY:
-        _exec_keyboard_shortcut(widget)
-    elif action_type == ACTION_MEDIA_KEY:
-        _exec_media_key(widget)
-    elif action_type == ACTION_DDC:
-        execute_ddc_direct(
-            widget.get("ddc_vcp_code", 0x10),
-            widget.get("ddc_value", 0),
-            widget.get("ddc_adjustment", 0),
-            widget.get("ddc_display", 0),
-        )
-    elif action_type in (ACTION_DISPLAY_SETTINGS, ACTION_DISPLAY_CLOCK, ACTION_DISPLAY_PICTURE):
-        logging.debug("Display-local action_type %d handled on device, ignoring on PC", action_type)
-    else:
-        logging.warning("Unknown action_type %d for page=%d widget=%d",
-                        action_type, page_idx, widget_idx)
+    def __init__(self, config_manager, workers=ACTION_WORKERS):
+        self._config_mgr = config_manager
+        self._pool = ThreadPoolExecutor(max_workers=workers, thread_name_prefix="action")
+        # (table, profile_count, active_profile, generation), replaced whole
+        self._state = ({}, 0, 0, None)
+        self._sources = {}   # Key -> the widget's JSON the table entry was resolved from
+        self._refresh_lock = threading.Lock()
+
+    def refresh(self):
+        """Re-resolve what changed since the last call; safe from any thread."""
+        with self._refresh_lock:
+            config = self._config_mgr.config
+            generation = (id(config), self._config_mgr.generation)
+            old_table = self._state[0]
+            if generation == self._state[3]:
+                return
+            _which_cache.clear()  # Tools may have been installed since the last load
+            table = {}
+            sources = {}
+            resolved = 0
+
+            def put(key, item, default_type):
+                nonlocal resolved
+                source = json.dumps(item, sort_keys=True)
+                sources[key] = source
+                if self._sources.get(key) == source and key in old_table:
+                    table[key] = old_table[key]
+                else:
+                    table[key] = (item.get("action_type", default_type), resolve_action(item))
+                    resolved += 1
+
+            active_name = config.get("active_profile_name", "")
+            active = 0
+            for pi, profile in enumerate(config.get("profiles", [])):
+                if profile.get("name") == active_name:
+                    active = pi
+                for gi, page in enumerate(profile.get("pages", [])):
+                    for wi, widget in enumerate(page.get("widgets", [])):
+                        put((pi, gi, wi), widget, ACTION_HOTKEY)
+                        for ei, entry in enumerate(widget.get("entries", [])):
+                            put((pi, gi, wi, ei), entry, ACTION_LAUNCH_APP)
+                # Hardware buttons are global; the display still tags them with a profile
+                for bi, button in enumerate(config.get("hardware_buttons", [])):
+                    put((pi, HW_BUTTON_PAGE, bi), button, ACTION_HOTKEY)
+            self._sources = sources
+            self._state = (table, len(config.get("profiles", [])), active, generation)
+            logging.debug("Action table updated: %d entries, %d re-resolved", len(table), resolved)
+
+    def submit(self, page_idx, widget_idx, profile_idx=None, received=None, on_done=None,
+               entry_idx=None):
+        """Queue the action bound to a widget and return immediately.
+
+        profile_idx None (or out of range) means the active profile. entry_idx
+        picks an entry of a scroll grid widget (None = the widget itself). received
+        is the time.perf_counter() at which the press was read. on_done is
+        called from the worker as on_done(status, queue_s, exec_s).
+        """
+        if received is None:
+            received = time.perf_counter()
+        state = self._state
+        if state[3] != (id(self._config_mgr.config), self._config_mgr.generation):
+            self.refresh()   # Changed without a reload callback (IPC edit)
+            state = self._state
+        table, profile_count, active_profile, _ = state
+        if profile_idx is None or not 0 <= profile_idx < profile_count:
+            profile_idx = active_profile
+        key = (profile_idx, page_idx, widget_idx)
+        entry = table.get(key if entry_idx is None else key + (entry_idx,))
+        if entry is None:
+            logging.warning("No widget at page=%d widget=%d entry=%s", page_idx, widget_idx, entry_idx)
+        elif entry[1] is None:
+            logging.debug("Nothing to run on the PC for page=%d widget=%d (action_type %d)",
+                          page_idx, widget_idx, entry[0])
+        self._pool.submit(self._run, entry[1] if entry else None, received, on_done)
+
+    @staticmethod
+    def _run(action, received, on_done):
+        started = time.perf_counter()
+        status = ACTION_RESULT_NO_ACTION
+        if action is not None:
+            try:
+                status = ACTION_RESULT_FAILED if action() is False else ACTION_RESULT_OK
+            except Exception as exc:
+                logging.error("Button action failed: %s", exc)
+                status = ACTION_RESULT_FAILED
+        finished = time.perf_counter()
+        if on_done:
+            on_done(status, started - received, finished - started)
+
+    def shutdown(self):
+        self._pool.shutdown(wait=False)
 
 
 # ---------------------------------------------------------------------------
 # Action handlers
 # ---------------------------------------------------------------------------
 
-def _exec_launch_app(widget):
-    """Launch or focus an application."""
-    launch_command = widget.get("launch_command", "")
-    if not launch_command:
-        logging.warning("Launch app: empty launch_command")
-        return
-
-    wm_class = widget.get("launch_wm_class", "")
-    focus_or_launch = widget.get("launch_focus_or_launch", True)
-
+def _launch_app(clean_cmd, wm_class):
+    """Launch an application, or focus its window when wm_class is given and found."""
     # Try to focus existing window first
-    if focus_or_launch and wm_class:
-        if _try_focus_window(wm_class):
-            logging.info("Focused existing window: %s", wm_class)
-            return
-
-    # Strip .desktop Exec format codes (%u, %U, %f, %F, etc.)
-    clean_cmd = re.sub(r'%[uUfFdDnNickvm]', '', launch_command).strip()
+    if wm_class and _try_focus_window(wm_class):
+        logging.info("Focused existing window: %s", wm_class)
+        return True
 
     try:
         subprocess.Popen(clean_cmd, shell=True, stdout=DEVNULL, stderr=DEVNULL)
         logging.info("Launched app: %s", clean_cmd)
+        return True
     except Exception as exc:
         logging.error("Failed to launch app: %s", exc)
+        return False
 
 
-def _exec_shell_cmd(widget):
-    """Run a shell command (blocks sudo)."""
-    cmd = widget.get("shell_command", "")
-    if not cmd:
-        return
-
-    # Block sudo commands
-    if "sudo" in cmd.split():
-        logging.warning("Shell command blocked (contains sudo): %s", cmd)
-        return
-
+def _run_shell_cmd(cmd):
+    """Run a shell command (already screened for sudo)."""
     try:
         subprocess.Popen(cmd, shell=True, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
         logging.info("Shell command: %s", cmd)
+        return True
     except Exception as exc:
         logging.error("Failed to run shell command: %s", exc)
+        return False
 
 
-def _exec_open_url(widget):
+def _open_url(url):
     """Open a URL in the default browser."""
-    url = widget.get("url", "")
-    if not url:
-        return
-
     try:
         webbrowser.open(url)
         logging.info("Opened URL: %s", url)
+        return True
     except Exception as exc:
         logging.error("Failed to open URL: %s", exc)
+        return False
 
 
-def _exec_keyboard_shortcut(widget):
-    """Simulate a keyboard shortcut via ydotool (with xdotool fallback)."""
-    modifiers = widget.get("modifiers", 0)
-    keycode = widget.get("keycode", 0)
-
-    if keycode == 0:
-        logging.warning("Keyboard shortcut: no keycode set")
-        return
-
-    # Build key name from keycode (supports Arduino ASCII + HID scan codes)
-    key_name = _KEY_NAMES.get(keycode)
+def _key_combo(modifiers, keycode):
+    """Build a ydotool/xdotool "mod+mod+key" string, or None if keycode is unset/unknown."""
+    # Build key name from keycode (supports Arduino ASCII + HID scan codes).
+    # Quiet on purpose: every non-button widget defaults to ACTION_HOTKEY.
+    key_name = _KEY_NAMES.get(keycode) if keycode else None
     if key_name is None:
-        logging.warning("Unknown keycode: 0x%02X", keycode)
-        return
+        return None
 
     # Build modifier+key combo string
     parts = []
@@ -254,91 +395,307 @@ def _exec_keyboard_shortcut(widget):
         if modifiers & mod_bit:
             parts.append(mod_name)
     parts.append(key_name)
-    key_combo = "+".join(parts)
+    return "+".join(parts)
 
+
+def _send_key_combo(key_combo):
+    """Simulate a keyboard shortcut via ydotool (with xdotool fallback)."""
     # Try ydotool first
-    if shutil.which("ydotool"):
+    if _which("ydotool"):
         try:
             subprocess.Popen(["ydotool", "key", key_combo],
                              stdout=DEVNULL, stderr=DEVNULL)
             logging.info("Keyboard shortcut (ydotool): %s", key_combo)
-            return
+            return True
         except Exception as exc:
             logging.debug("ydotool failed: %s", exc)
 
     # Fallback to xdotool
-    if shutil.which("xdotool"):
+    if _which("xdotool"):
         try:
             subprocess.Popen(["xdotool", "key", key_combo],
                              stdout=DEVNULL, stderr=DEVNULL)
             logging.info("Keyboard shortcut (xdotool): %s", key_combo)
-            return
+            return True
         except Exception as exc:
             logging.debug("xdotool failed: %s", exc)
 
     logging.error("Neither ydotool nor xdotool available for keyboard shortcuts")
+    return False
 
 
-def _exec_media_key(widget):
+def _send_media_key(key_name):
     """Simulate a media key via ydotool."""
-    consumer_code = widget.get("consumer_code", 0)
-    if consumer_code == 0:
-        logging.warning("Media key: no consumer_code set")
-        return
-
-    key_name = _CONSUMER_KEY_NAMES.get(consumer_code)
-    if key_name is None:
-        logging.warning("Unknown consumer code: 0x%04X", consumer_code)
-        return
-
-    if shutil.which("ydotool"):
+    if _which("ydotool"):
         try:
             subprocess.Popen(["ydotool", "key", key_name],
                              stdout=DEVNULL, stderr=DEVNULL)
             logging.info("Media key (ydotool): %s", key_name)
-            return
+            return True
         except Exception as exc:
             logging.debug("ydotool media key failed: %s", exc)
 
     logging.warning("ydotool not available for media keys")
+    return False
 
 
-def execute_ddc_direct(vcp_code, value, adjustment, display_num):
-    """Execute a DDC/CI command via ddcutil.
+# ---------------------------------------------------------------------------
+# DDC/CI
+# ---------------------------------------------------------------------------
+#
+# A ddcutil call takes a few hundred ms, the encoder sends a command every
+# 40 ms while it spins. Commands are merged per (display, VCP) until the
+# worker gets to them -- relative steps add up, an absolute value replaces
+# whatever was pending -- and one worker runs them in arrival order, so a
+# fast spin costs one write per control instead of seconds of backlog.
+# Writes are absolute against a cache of the monitor's values (filled by
+# the first getvcp), which also gives the display something to show.
+
+DDC_TIMEOUT = 5.0
 
-    If adjustment != 0, uses relative adjustment: ddcutil setvcp 0xNN + N or - N
-    If adjustment == 0, uses absolute value: ddcutil setvcp 0xNN <value>
-    """
-    if not shutil.which("ddcutil"):
-        logging.error("ddcutil not found -- DDC/CI commands require ddcutil. "
-                      "Install with: sudo apt install ddcutil")
-        return
 
+def _ddc_base(display_num):
     cmd = ["ddcutil"]
     if display_num > 0:
         cmd.extend(["--display", str(display_num)])
+    return cmd
 
-    vcp_hex = f"0x{vcp_code:02X}"
-
-    if adjustment != 0:
-        op = "+" if adjustment > 0 else "-"
-        cmd.extend(["setvcp", vcp_hex, op, str(abs(adjustment))])
-    else:
-        cmd.extend(["setvcp", vcp_hex, str(value)])
 
+def _ddc_getvcp(display_num, vcp_code):
+    """(current, max) of a continuous VCP feature, or None."""
+    cmd = _ddc_base(display_num) + ["getvcp", f"0x{vcp_code:02X}", "--brief"]
     try:
-        subprocess.Popen(cmd, stdout=DEVNULL, stderr=DEVNULL)
-        logging.info("DDC command: %s", " ".join(cmd))
-    except Exception as exc:
-        logging.error("DDC command failed: %s", exc)
+        out = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=DEVNULL,
+                             timeout=DDC_TIMEOUT, text=True).stdout
+    except (OSError, subprocess.TimeoutExpired) as exc:
+        logging.debug("ddcutil getvcp failed: %s", exc)
+        return None
+    # "VCP 10 C 50 100" (continuous); non-continuous features aren't cached
+    parts = out.split()
+    if len(parts) >= 5 and parts[0] == "VCP" and parts[2] == "C":
+        try:
+            return int(parts[3]), int(parts[4])
+        except ValueError:
+            pass
+    return None
+
+
+class DdcQueue:
+    """Latest-wins DDC/CI command queue with cached monitor values.
+
+    submit() never blocks. on_state(vcp_code, value, max_value, display_num)
+    is called from the worker after each write whose result is known.
+    """
+
+    def __init__(self):
+        self._cond = threading.Condition()
+        self._pending = {}    # (display, vcp) -> [absolute or None, relative, on_state]
+        self._values = {}     # (display, vcp) -> (value, max); worker only
+        self._thread = None
+
+    def submit(self, vcp_code, value, adjustment, display_num, on_state=None):
+        key = (display_num, vcp_code)
+        with self._cond:
+            entry = self._pending.get(key)
+            if adjustment == 0 or entry is None:
+                self._pending[key] = [value if adjustment == 0 else None, adjustment, on_state]
+            else:
+                entry[1] += adjustment
+                entry[2] = on_state or entry[2]
+            if self._thread is None:
+                self._thread = threading.Thread(target=self._run, name="ddc", daemon=True)
+                self._thread.start()
+            self._cond.notify()
+
+    def _run(self):
+        while True:
+            with self._cond:
+                while not self._pending:
+                    self._cond.wait()
+                key = next(iter(self._pending))
+                absolute, relative, on_state = self._pending.pop(key)
+            try:
+                self._apply(key, absolute, relative, on_state)
+            except Exception as exc:
+                logging.error("DDC command failed: %s", exc)
+
+    def _apply(self, key, absolute, relative, on_state):
+        display_num, vcp_code = key
+        state = self._values.get(key)
+        if absolute is None and state is None:
+            state = _ddc_getvcp(display_num, vcp_code)
+        vcp_hex = f"0x{vcp_code:02X}"
+        cmd = _ddc_base(display_num) + ["setvcp", vcp_hex]
+        if absolute is not None:
+            target = absolute
+            cmd.append(str(target))
+        elif state is not None:
+            target = max(0, min(state[0] + relative, state[1]))
+            if target == state[0]:
+                self._report(on_state, key, state)   # Already at the end of the range
+                return
+            cmd.append(str(target))
+        elif relative:
+            # Value unknown (non-continuous or getvcp failed): let ddcutil step it
+            target = None
+            cmd.extend(["+" if relative > 0 else "-", str(abs(relative))])
+        else:
+            return
+
+        started = time.perf_counter()
+        try:
+            ok = subprocess.run(cmd, stdout=DEVNULL, stderr=DEVNULL,
+                                timeout=DDC_TIMEOUT).returncode == 0
+        except (OSError, subprocess.TimeoutExpired) as exc:
+            logging.error("DDC command failed: %s", exc)
+            ok = False
+        logging.info("DDC command: %s (%s, %.0f ms)", " ".join(cmd), "ok" if ok else "FAILED",
+                     (time.perf_counter() - started) * 1e3)
+        if not ok or target is None:
+            self._values.pop(key, None)   # Read it again next time
+            return
+        state = (target, state[1] if state else 0)
+        self._values[key] = state
+        self._report(on_state, key, state)
+
+    @staticmethod
+    def _report(on_state, key, state):
+        if on_state is not None:
+            on_state(key[1], state[0], state[1], key[0])
+
+
+ddc_queue = DdcQueue()
+
+
+def execute_ddc_direct(vcp_code, value, adjustment, display_num, on_state=None):
+    """Queue a DDC/CI command for ddcutil; returns at once.
+
+    If adjustment != 0, the value moves by adjustment (clamped to the
+    monitor's range); if adjustment == 0, it is set to value. Pending
+    commands for the same display and VCP code are merged. on_state: see
+    DdcQueue.
+    """
+    if not _which("ddcutil"):
+        logging.error("ddcutil not found -- DDC/CI commands require ddcutil. "
+                      "Install with: sudo apt install ddcutil")
+        return False
+    ddc_queue.submit(vcp_code, value, adjustment, display_num, on_state)
+    return True
+
+
+# ---------------------------------------------------------------------------
+# Keys from a wired display
+# ---------------------------------------------------------------------------
+#
+# A display on its own USB port (companion/wired_link.py) has no bridge to
+# type for it: MSG_HOTKEY, MSG_MEDIA_KEY, MSG_MACRO and MSG_TYPE_TEXT come
+# here instead.
+# One worker plays them in arrival order, each tool call finished before
+# the next, so a macro's keys land in sequence. Holds (press/release) need
+# xdotool's keydown/keyup; with ydotool alone a press is played as a tap.
+# Text goes to the tool's own "type", which already follows the session's
+# keyboard layout, so the display's key_layout isn't needed here.
+
+# MacroOp (shared/protocol.h)
+MACRO_OP_TAP, MACRO_OP_PRESS, MACRO_OP_RELEASE, MACRO_OP_RELEASE_ALL, MACRO_OP_DELAY, MACRO_OP_MEDIA = range(6)
+_OP_TEXT = -1   # Player-only step: a = the string
+
+KEY_TOOL_TIMEOUT = 2.0   # Seconds a single ydotool/xdotool call may take
+
+
+class KeyPlayer:
+    """Plays HID commands from a wired display, one at a time."""
+
+    def __init__(self):
+        self._queue = collections.deque()
+        self._cond = threading.Condition()
+        self._held = []   # xdotool key names pressed by MACRO_OP_PRESS
+        threading.Thread(target=self._run, name="key-player", daemon=True).start()
+
+    def hotkey(self, modifiers, keycode):
+        self._submit([(MACRO_OP_TAP, modifiers, keycode)])
+
+    def media(self, consumer_code):
+        self._submit([(MACRO_OP_MEDIA, consumer_code & 0xFF, consumer_code >> 8)])
+
+    def macro(self, steps):
+        """steps: (op, a, b) tuples as in MacroStep."""
+        self._submit(list(steps))
+
+    def text(self, text):
+        if text:
+            self._submit([(_OP_TEXT, text, 0)])
+
+    def _submit(self, steps):
+        with self._cond:
+            self._queue.append(steps)
+            self._cond.notify()
+
+    def _run(self):
+        while True:
+            with self._cond:
+                while not self._queue:
+                    self._cond.wait()
+                steps = self._queue.popleft()
+            for op, a, b in steps:
+                try:
+                    self._step(op, a, b)
+                except Exception as exc:
+                    logging.debug("Wired key step %d failed: %s", op, exc)
+
+    @staticmethod
+    def _tool(*argv):
+        subprocess.run(argv, stdout=DEVNULL, stderr=DEVNULL, timeout=KEY_TOOL_TIMEOUT)
+
+    def _step(self, op, a, b):
+        if op == _OP_TEXT:
+            if _which("ydotool"):
+                self._tool("ydotool", "type", "--", a)
+            elif _which("xdotool"):
+                self._tool("xdotool", "type", "--", a)
+        elif op == MACRO_OP_DELAY:
+            time.sleep((a | b << 8) / 1000.0)
+        elif op == MACRO_OP_MEDIA:
+            key_name = _CONSUMER_KEY_NAMES.get(a | b << 8)
+            if key_name and _which("ydotool"):
+                self._tool("ydotool", "key", key_name)
+        elif op == MACRO_OP_TAP or (op == MACRO_OP_PRESS and not _which("xdotool")):
+            combo = _key_combo(a, b) if b else None
+            if combo is None:
+                return
+            if _which("ydotool"):
+                self._tool("ydotool", "key", combo)
+            elif _which("xdotool"):
+                self._tool("xdotool", "key", combo)
+        elif op == MACRO_OP_PRESS:
+            combo = _key_combo(a, b) if b else "+".join(n for bit, n in _MOD_NAMES.items() if a & bit)
+            if combo:
+                self._tool("xdotool", "keydown", combo)
+                self._held.append(combo)
+        elif op in (MACRO_OP_RELEASE, MACRO_OP_RELEASE_ALL) and _which("xdotool"):
+            if op == MACRO_OP_RELEASE:
+                combo = _key_combo(a, b) if b else "+".join(n for bit, n in _MOD_NAMES.items() if a & bit)
+                release = [combo] if combo else []
+            else:
+                release = list(reversed(self._held))
+            for combo in release:
+                self._tool("xdotool", "keyup", combo)
+                if combo in self._held:
+                    self._held.remove(combo)
 
 
 def _try_focus_window(wm_class: str) -> bool:
-    """Try to focus an existing window by WM_CLASS using wmctrl.
+    """Try to focus an existing window by WM_CLASS.
 
-    Returns True if a window was focused, False otherwise.
+    Resolved from the compositor's window list (window_tracker) when its IPC
+    is connected, with wmctrl as the fallback. Returns True if a window was
+    focused, False otherwise.
     """
-    if not shutil.which("wmctrl"):
+    focused = get_window_tracker().focus(wm_class)
+    if focused is not None:
+        return focused
+
+    if not _which("wmctrl"):
         return False
 
     try:
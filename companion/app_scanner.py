@@ -4,14 +4,48 @@ App Scanner: Discover installed Linux applications from .desktop files.
 Scans /usr/share/applications and ~/.local/share/applications for .desktop
 entries, extracts name/icon/exec, and resolves icon paths from the active
 icon theme for use as button icons on the device.
+
+The result is kept in a persistent index (INDEX_PATH) keyed by each
+.desktop file's mtime, so a rescan only parses files that changed and only
+resolves icons it hasn't resolved for the current theme. With
+start_background_index() an inotify watch on the application directories
+refreshes the index as packages come and go, and the app icons are
+pre-rendered into ICON_CACHE_DIR at APP_ICON_SIZES, so app lists come up
+without touching the disk or rasterizing an SVG.
 """
 
 import configparser
+import ctypes
+import ctypes.util
+import functools
 import glob
+import hashlib
+import json
+import logging
 import os
+import select
 import subprocess
-from dataclasses import dataclass, field
-from typing import List, Optional
+import threading
+import time
+from dataclasses import asdict, dataclass, field
+from typing import Dict, List, Optional, Tuple
+
+logger = logging.getLogger(__name__)
+
+_CACHE_ROOT = os.path.join(os.environ.get("XDG_CACHE_HOME") or os.path.expanduser("~/.cache"),
+                           "crowdisplay")
+INDEX_PATH = os.path.join(_CACHE_ROOT, "apps.json")
+ICON_CACHE_DIR = os.path.join(_CACHE_ROOT, "app_icons")
+_INDEX_VERSION = 1  # Bump when AppEntry or the parsing rules change
+
+# Pre-rendered icon boxes: the picker list, editor previews, and a default
+# hotkey button (WIDGET_DEFAULT_SIZES in config_manager)
+APP_ICON_SIZES = ((32, 32), (64, 64), (180, 100))
+
+DESKTOP_DIRS = [
+    "/usr/share/applications",
+    os.path.expanduser("~/.local/share/applications"),
+]
 
 
 @dataclass
@@ -27,8 +61,9 @@ class AppEntry:
     wm_class: str = ""   # StartupWMClass from .desktop file
 
 
+@functools.lru_cache(maxsize=1)
 def _get_icon_theme() -> str:
-    """Get the active GTK icon theme name."""
+    """Get the active GTK icon theme name (asked once per process)."""
     try:
         result = subprocess.run(
             ["gtk-query-settings", "gtk-icon-theme-name"],
@@ -101,70 +136,365 @@ def _resolve_icon_path(icon_name: str, theme: str) -> str:
     return ""
 
 
-def scan_applications() -> List[AppEntry]:
+def _parse_desktop_file(desktop_file: str) -> Optional[AppEntry]:
+    """AppEntry for a .desktop file (icon not resolved), or None if it isn't a visible app."""
+    try:
+        cp = configparser.ConfigParser(interpolation=None)
+        cp.read(desktop_file)
+
+        if not cp.has_section("Desktop Entry"):
+            return None
+
+        entry = cp["Desktop Entry"]
+
+        # Skip non-applications and hidden entries
+        if entry.get("Type", "") != "Application":
+            return None
+        if entry.get("NoDisplay", "false").lower() == "true":
+            return None
+        if entry.get("Hidden", "false").lower() == "true":
+            return None
+
+        name = entry.get("Name", "")
+        if not name:
+            return None
+
+        return AppEntry(
+            name=name,
+            icon_name=entry.get("Icon", ""),
+            exec_cmd=entry.get("Exec", ""),
+            comment=entry.get("Comment", ""),
+            categories=[c.strip() for c in entry.get("Categories", "").split(";") if c.strip()],
+            desktop_file=desktop_file,
+            wm_class=entry.get("StartupWMClass", ""),
+        )
+    except Exception:
+        return None
+
+
+# ============================================================
+# Persistent index
+# ============================================================
+
+class AppIndex:
     """
-    Scan system for installed applications.
+    Installed apps, kept in sync with the .desktop files incrementally.
 
-    Returns a sorted list of AppEntry objects with resolved icon paths.
+    The index file maps each .desktop path to its mtime and parsed entry
+    (None for files that aren't visible apps), plus the icon theme the
+    icon paths were resolved for. refresh() stats the directories and
+    re-parses only what changed; apps() skips even that while an inotify
+    watch vouches that nothing did.
     """
-    desktop_dirs = [
-        "/usr/share/applications",
-        os.path.expanduser("~/.local/share/applications"),
-    ]
 
-    theme = _get_icon_theme()
-    apps = []
-    seen_names = set()
+    def __init__(self, path: str = INDEX_PATH, dirs: Optional[List[str]] = None):
+        self.path = path
+        self.dirs = dirs if dirs is not None else DESKTOP_DIRS
+        self._lock = threading.Lock()
+        self._files: Dict[str, dict] = {}   # desktop path -> {"mtime": ns, "entry": dict | None}
+        self._theme = ""
+        self._apps: Optional[List[AppEntry]] = None
+        self._watching = False
+        self._dirty = True
+        self._load()
 
-    for app_dir in desktop_dirs:
-        if not os.path.isdir(app_dir):
-            continue
+    def _load(self):
+        try:
+            with open(self.path, "r", encoding="utf-8") as f:
+                data = json.load(f)
+            if data.get("version") == _INDEX_VERSION:
+                self._files = data.get("files", {})
+                self._theme = data.get("theme", "")
+        except (OSError, ValueError):
+            pass
 
-        for desktop_file in glob.glob(os.path.join(app_dir, "*.desktop")):
-            try:
-                cp = configparser.ConfigParser(interpolation=None)
-                cp.read(desktop_file)
+    def _save(self):
+        try:
+            os.makedirs(os.path.dirname(self.path), exist_ok=True)
+            tmp = f"{self.path}.{os.getpid()}.tmp"
+            with open(tmp, "w", encoding="utf-8") as f:
+                json.dump({"version": _INDEX_VERSION, "theme": self._theme, "files": self._files}, f)
+            os.replace(tmp, self.path)
+        except OSError as e:
+            logger.debug("App index: cannot write %s: %s", self.path, e)
 
-                if not cp.has_section("Desktop Entry"):
+    def refresh(self) -> bool:
+        """Bring the index up to date with the disk. True if anything changed."""
+        with self._lock:
+            theme = _get_icon_theme()
+            retheme = theme != self._theme
+            seen = set()
+            changed = retheme
+            parsed = 0
+            resolved: Dict[str, str] = {}   # icon name -> path, this refresh
+
+            for app_dir in self.dirs:
+                try:
+                    listing = list(os.scandir(app_dir))
+                except OSError:
                     continue
+                for de in listing:
+                    if not de.name.endswith(".desktop"):
+                        continue
+                    try:
+                        mtime = de.stat().st_mtime_ns
+                    except OSError:
+                        continue
+                    seen.add(de.path)
+                    cached = self._files.get(de.path)
+                    entry = cached["entry"] if cached else None
+                    if not cached or cached["mtime"] != mtime:
+                        app = _parse_desktop_file(de.path)
+                        entry = asdict(app) if app else None
+                        parsed += 1
+                    elif not (entry and (retheme or (entry["icon_path"] and
+                                                     not os.path.exists(entry["icon_path"])))):
+                        continue   # Unchanged, icon still where it was
+                    if entry:
+                        name = entry["icon_name"]
+                        if name not in resolved:
+                            resolved[name] = _resolve_icon_path(name, theme)
+                        entry["icon_path"] = resolved[name]
+                    self._files[de.path] = {"mtime": mtime, "entry": entry}
+                    changed = True
 
-                entry = cp["Desktop Entry"]
+            for gone in set(self._files) - seen:
+                del self._files[gone]
+                changed = True
 
-                # Skip non-applications and hidden entries
-                if entry.get("Type", "") != "Application":
-                    continue
-                if entry.get("NoDisplay", "false").lower() == "true":
-                    continue
-                if entry.get("Hidden", "false").lower() == "true":
-                    continue
+            self._theme = theme
+            self._dirty = False
+            if changed or self._apps is None:
+                self._apps = self._build()
+            if changed:
+                self._save()
+                logger.info("App index: %d apps, %d files parsed, %d icons resolved",
+                            len(self._apps), parsed, len(resolved))
+            return changed
 
-                name = entry.get("Name", "")
-                if not name or name in seen_names:
-                    continue
-                seen_names.add(name)
-
-                icon_name = entry.get("Icon", "")
-                exec_cmd = entry.get("Exec", "")
-                comment = entry.get("Comment", "")
-                categories = [c.strip() for c in entry.get("Categories", "").split(";") if c.strip()]
-                wm_class = entry.get("StartupWMClass", "")
-
-                # Resolve icon to filesystem path
-                icon_path = _resolve_icon_path(icon_name, theme)
-
-                apps.append(AppEntry(
-                    name=name,
-                    icon_name=icon_name,
-                    exec_cmd=exec_cmd,
-                    comment=comment,
-                    categories=categories,
-                    desktop_file=desktop_file,
-                    icon_path=icon_path,
-                    wm_class=wm_class,
-                ))
-
-            except Exception:
+    def _build(self) -> List[AppEntry]:
+        """Sorted app list: the first entry of each name wins, system directory first."""
+        apps = []
+        seen_names = set()
+        rank = {d: i for i, d in enumerate(self.dirs)}
+        for path in sorted(self._files, key=lambda p: (rank.get(os.path.dirname(p), len(rank)), p)):
+            entry = self._files[path]["entry"]
+            if not entry or entry["name"] in seen_names:
                 continue
+            seen_names.add(entry["name"])
+            apps.append(AppEntry(**entry))
+        apps.sort(key=lambda a: a.name.lower())
+        return apps
+
+    def apps(self) -> List[AppEntry]:
+        """Current app list; stats the directories first unless the watch is up."""
+        if not self._watching or self._dirty or self._apps is None:
+            self.refresh()
+        with self._lock:
+            return list(self._apps)
+
+    # -- inotify ---------------------------------------------------------
+
+    _IN_MODIFY, _IN_ATTRIB, _IN_CLOSE_WRITE = 0x002, 0x004, 0x008
+    _IN_MOVED_FROM, _IN_MOVED_TO, _IN_CREATE, _IN_DELETE = 0x040, 0x080, 0x100, 0x200
+    _SETTLE_S = 1.0   # Package installs touch many files: wait for quiet before rescanning
+
+    def watch(self, on_change=None) -> bool:
+        """
+        Watch the application directories on a daemon thread, refreshing
+        the index (and then calling on_change()) after changes. False when
+        inotify isn't available; apps() then keeps stat-checking.
+        """
+        if self._watching:
+            return True
+        try:
+            libc = ctypes.CDLL(ctypes.util.find_library("c") or "libc.so.6", use_errno=True)
+            fd = libc.inotify_init1(os.O_CLOEXEC)
+        except (OSError, AttributeError):
+            return False
+        if fd < 0:
+            return False
+        mask = (self._IN_MODIFY | self._IN_ATTRIB | self._IN_CLOSE_WRITE | self._IN_MOVED_FROM
+                | self._IN_MOVED_TO | self._IN_CREATE | self._IN_DELETE)
+        # A directory that doesn't exist yet isn't watched: its apps show up
+        # with the next change elsewhere, or the next start
+        watched = sum(1 for d in self.dirs
+                      if os.path.isdir(d) and libc.inotify_add_watch(fd, os.fsencode(d), mask) >= 0)
+        if not watched:
+            os.close(fd)
+            return False
+
+        def run():
+            while True:
+                os.read(fd, 4096)
+                self._dirty = True
+                # Drain until the directories have been quiet for _SETTLE_S
+                while select.select([fd], [], [], self._SETTLE_S)[0]:
+                    os.read(fd, 4096)
+                try:
+                    if self.refresh() and on_change:
+                        on_change()
+                except Exception as e:
+                    logger.warning("App index: refresh failed: %s", e)
+
+        self._watching = True
+        threading.Thread(target=run, name="app-index-watch", daemon=True).start()
+        return True
+
+
+_index: Optional[AppIndex] = None
+_index_lock = threading.Lock()
+
+
+def get_app_index() -> AppIndex:
+    """The process-wide AppIndex."""
+    global _index
+    with _index_lock:
+        if _index is None:
+            _index = AppIndex()
+        return _index
+
+
+def scan_applications() -> List[AppEntry]:
+    """
+    Installed applications, sorted by name, with resolved icon paths.
+
+    Served from the persistent index: only .desktop files changed since the
+    last call are parsed.
+    """
+    return get_app_index().apps()
+
+
+# ============================================================
+# Pre-rendered app icons
+# ============================================================
+
+_icon_failed = set()   # (icon path, w, h) that didn't render, this process
+
+
+def _icon_cache_path(icon_path: str, width: int, height: int) -> Optional[str]:
+    try:
+        mtime = os.stat(icon_path).st_mtime_ns
+    except OSError:
+        return None
+    key = hashlib.sha1(repr((icon_path, mtime, width, height)).encode()).hexdigest()
+    return os.path.join(ICON_CACHE_DIR, key[:2], f"{key}.png")
+
+
+def app_icon_png(app: AppEntry, width: int = 32, height: int = 32) -> Optional[bytes]:
+    """
+    The app's icon as PNG bytes fitted to width x height (optimize_for_widget),
+    from ICON_CACHE_DIR when it was rendered before. None without a usable icon.
+    """
+    if not app.icon_path or (app.icon_path, width, height) in _icon_failed:
+        return None
+    cache_path = _icon_cache_path(app.icon_path, width, height)
+    if cache_path is None:
+        return None
+    try:
+        with open(cache_path, "rb") as f:
+            return f.read()
+    except OSError:
+        pass
+    try:
+        from companion.image_optimizer import optimize_for_widget
+        data = optimize_for_widget(app.icon_path, width, height)
+    except Exception as e:
+        logger.debug("App icon: cannot render %s: %s", app.icon_path, e)
+        _icon_failed.add((app.icon_path, width, height))
+        return None
+    try:
+        os.makedirs(os.path.dirname(cache_path), exist_ok=True)
+        tmp = f"{cache_path}.{os.getpid()}.tmp"
+        with open(tmp, "wb") as f:
+            f.write(data)
+        os.replace(tmp, cache_path)
+    except OSError as e:
+        logger.debug("App icon: cannot write %s: %s", cache_path, e)
+    return data
+
+
+def prewarm_app_icons(apps: Optional[List[AppEntry]] = None,
+                      sizes: Tuple[Tuple[int, int], ...] = APP_ICON_SIZES) -> int:
+    """Render every app icon missing from the cache at `sizes`. Returns how many were rendered."""
+    rendered = 0
+    for app in apps if apps is not None else scan_applications():
+        for w, h in sizes:
+            cache_path = _icon_cache_path(app.icon_path, w, h) if app.icon_path else None
+            if cache_path and not os.path.exists(cache_path) and app_icon_png(app, w, h):
+                rendered += 1
+    if rendered:
+        logger.info("App icons: %d rendered into %s", rendered, ICON_CACHE_DIR)
+    return rendered
+
+
+def start_background_index(on_change=None) -> None:
+    """
+    Off the caller's thread: bring the index up to date, pre-render the
+    icons, and keep both current with an inotify watch. For the editor at
+    startup, so the first app list it shows is already warm.
+    """
+    index = get_app_index()
+
+    def run():
+        try:
+            index.refresh()
+            prewarm_app_icons(index.apps())
+        except Exception as e:
+            logger.warning("App index: background scan failed: %s", e)
+
+    def changed():
+        prewarm_app_icons(index.apps())
+        if on_change:
+            on_change()
+
+    if not index.watch(changed):
+        logger.info("App index: inotify unavailable, app lists stat-check on use")
+    threading.Thread(target=run, name="app-index", daemon=True).start()
+
+
+def get_active_wm_class() -> Optional[str]:
+    """
+    Return the WM_CLASS of the focused window, or None if it can't be read.
+
+    Tries, in order:
+    1. hyprctl activewindow -j (Hyprland)
+    2. swaymsg -t get_tree (Sway: app_id, or window_properties.class for XWayland)
+    3. xdotool getactivewindow getwindowclassname (X11)
+    """
+    import json
+    import shutil
+
+    if os.environ.get("HYPRLAND_INSTANCE_SIGNATURE") and shutil.which("hyprctl"):
+        try:
+            result = subprocess.run(["hyprctl", "activewindow", "-j"],
+                                    capture_output=True, text=True, timeout=1)
+            if result.returncode == 0 and result.stdout.strip():
+                return json.loads(result.stdout).get("class") or None
+        except Exception:
+            pass
+
+    if os.environ.get("SWAYSOCK") and shutil.which("swaymsg"):
+        try:
+            result = subprocess.run(["swaymsg", "-t", "get_tree"],
+                                    capture_output=True, text=True, timeout=1)
+            stack = [json.loads(result.stdout)] if result.returncode == 0 else []
+            while stack:
+                node = stack.pop()
+                if node.get("focused"):
+                    return (node.get("app_id")
+                            or node.get("window_properties", {}).get("class") or None)
+                stack.extend(node.get("nodes", []) + node.get("floating_nodes", []))
+        except Exception:
+            pass
+
+    if os.environ.get("DISPLAY") and shutil.which("xdotool"):
+        try:
+            result = subprocess.run(["xdotool", "getactivewindow", "getwindowclassname"],
+                                    capture_output=True, text=True, timeout=1)
+            if result.returncode == 0:
+                return result.stdout.strip() or None
+        except Exception:
+            pass
 
-    apps.sort(key=lambda a: a.name.lower())
-    return apps
+    return None
@@ -3,9 +3,19 @@ Bridge Device: USB HID interface for sending commands to the ESP32-S3 bridge.
 
 Reuses discovery logic from hotkey_companion.py. Provides a context manager
 for safe open/close and methods to send CONFIG_MODE and CONFIG_DONE messages.
+While the companion service runs, BridgeDevice talks to the bridge through
+the service's socket (service_ipc.py) instead of opening the device.
 """
 
+import collections
+import gzip
 import logging
+import struct
+import threading
+import time
+import zlib
+
+from companion import lz_stream
 
 logger = logging.getLogger(__name__)
 
@@ -16,6 +26,413 @@ PRODUCT_STRING = "HotkeyBridge"
 # Message types (must match shared/protocol.h)
 MSG_CONFIG_MODE = 0x09
 MSG_CONFIG_DONE = 0x0A
+MSG_FRAGMENT    = 0x0E
+MSG_BULK_BEGIN  = 0x0F
+MSG_BULK_DATA   = 0x10
+MSG_BULK_END    = 0x11
+MSG_BULK_ACK    = 0x12
+MSG_DISPLAY     = 0x1E        # Envelope: [MSG_DISPLAY][display id][TYPE][PAYLOAD...]
+MSG_FW_BEGIN    = 0x20        # Bridge firmware update (vendor HID only, never relayed)
+MSG_FW_DATA     = 0x21
+MSG_FW_END      = 0x22
+MSG_FW_ACK      = 0x23
+
+# Vendor HID report layout (must match shared/protocol.h)
+VENDOR_REPORT_ID   = 0x06
+VENDOR_REPORT_SIZE = 63
+FRAG_HEADER_SIZE   = 4        # [MSG_FRAGMENT] [seq] [index | FRAG_LAST] [data_len]
+FRAG_DATA_SIZE     = VENDOR_REPORT_SIZE - FRAG_HEADER_SIZE
+FRAG_LAST          = 0x80
+FRAG_INDEX_MASK    = 0x7F
+VENDOR_MAX_MESSAGE = 253      # MSG_DISPLAY envelope + [TYPE] + 250-byte payload (one ESP-NOW frame)
+
+# Bulk file transfer (must match shared/protocol.h)
+BULK_PATH_MAX     = 64
+BULK_CHUNK_SIZE   = 240
+BULK_WINDOW       = 4
+BULK_FLAG_RESTART = 0x01
+BULK_FLAG_APPLY   = 0x02
+BULK_FLAG_FIRMWARE = 0x04    # Display firmware into its idle OTA slot (path is a label)
+BULK_FLAG_IMAGE   = 0x08     # Remote image patch (companion/remote_image.py), path = source name
+BULK_FLAG_LZ      = 0x10     # DATA is companion/lz_stream.py output (SD files only)
+BULK_LZ_MIN_GAIN  = 0.9      # Compress only when the stream is below this share of the file
+BULK_OK, BULK_DONE, BULK_ERR_CRC, BULK_ERR_IO, BULK_ERR_BAD = range(5)
+_BULK_ERRORS = {BULK_ERR_CRC: "checksum mismatch", BULK_ERR_IO: "SD card write failed",
+                BULK_ERR_BAD: "rejected (bad path/size, or config invalid)"}
+_FW_ERRORS = {BULK_ERR_CRC: "checksum mismatch", BULK_ERR_IO: "flash write or image check failed",
+              BULK_ERR_BAD: "rejected (image too large for the OTA slot?)"}
+_DISPLAY_FW_ERRORS = {BULK_ERR_CRC: "checksum mismatch", BULK_ERR_IO: "flash write or image check failed",
+                      BULK_ERR_BAD: "rejected (no OTA slot: flash the OTA partition table once over USB)"}
+_IMAGE_ERRORS = {BULK_ERR_CRC: "checksum mismatch", BULK_ERR_IO: "display out of memory",
+                 BULK_ERR_BAD: "refused (not on the frame it holds, or busy with another transfer)"}
+BULK_ACK = struct.Struct("<BBI")  # xfer_id, status, next_offset (+ flags from newer displays)
+
+_frag_seq = 0
+
+
+def encode_vendor_reports(msg_type: int, payload: bytes = b"", display=None) -> list:
+    """Build the HID output reports for one message.
+
+    Messages that fit in a single report are sent as-is; longer ones are
+    split into MSG_FRAGMENT reports that the bridge reassembles. Every
+    report is zero-padded to the full report size (USBHIDVendor reads
+    fixed 63-byte chunks) and prefixed with the report ID. display=None
+    sends to every display on the bridge, a display id to that one only.
+    """
+    global _frag_seq
+    message = bytes([msg_type]) + bytes(payload)
+    if display is not None:
+        message = bytes([MSG_DISPLAY, display]) + message
+    if len(message) > VENDOR_MAX_MESSAGE:
+        raise ValueError(f"message too long ({len(message)} > {VENDOR_MAX_MESSAGE})")
+
+    if len(message) <= VENDOR_REPORT_SIZE:
+        return [bytes([VENDOR_REPORT_ID]) + message.ljust(VENDOR_REPORT_SIZE, b"\x00")]
+
+    _frag_seq = (_frag_seq + 1) & 0xFF
+    reports = []
+    for index, offset in enumerate(range(0, len(message), FRAG_DATA_SIZE)):
+        chunk = message[offset:offset + FRAG_DATA_SIZE]
+        flags = index | (FRAG_LAST if offset + len(chunk) >= len(message) else 0)
+        body = bytes([MSG_FRAGMENT, _frag_seq, flags, len(chunk)]) + chunk
+        reports.append(bytes([VENDOR_REPORT_ID]) + body.ljust(VENDOR_REPORT_SIZE, b"\x00"))
+    return reports
+
+
+def write_vendor_message(device, msg_type: int, payload: bytes = b"", display=None) -> None:
+    """Write one (possibly fragmented) message to an open hid device.
+
+    Fragments go out back-to-back; callers sharing the device between
+    threads must hold their HID lock around the whole call (or go through
+    a HidWriter). A display on its own USB port (wired_link.WiredDisplay)
+    takes the message whole.
+    """
+    write_message = getattr(device, "write_message", None)
+    if write_message is not None:
+        write_message(msg_type, payload, display)
+        return
+    for report in encode_vendor_reports(msg_type, payload, display):
+        device.write(report)
+
+
+# HidWriter message classes, most urgent first
+WRITE_CONTROL, WRITE_NOTIFY, WRITE_STATS, WRITE_BULK = range(4)
+WRITE_CLASS_NAMES = ("control", "notify", "stats", "bulk")
+WRITE_LATENCY_SAMPLES = 256   # Per class, for the percentiles in HidWriter.stats()
+
+
+class HidWriter:
+    """One thread owns every write to the bridge, most urgent class first.
+
+    Control messages (power state, clock and time sync, profile switches,
+    action results, DDC state, benchmark traffic) go before notifications,
+    notifications before stats, stats before bulk transfer chunks, which are
+    flow-controlled by their ACK window anyway. Within a class writes keep
+    their order. A message submitted with coalesce=fn is folded into one of
+    the same type and display still waiting (fn(queued, new) -> payload, or
+    None to queue it after all), so stats never pile up: the newest values
+    win. A payload may be a callable evaluated right before the write, for
+    timestamps that must not include the wait (clock sync t3, bench echo).
+
+    get_device() gives the handle to write to; `lock` is held around each
+    message. on_error(exc) runs on the writer thread when a write fails.
+    """
+
+    class _Entry:
+        __slots__ = ("msg_type", "payload", "display", "submitted", "done", "ok")
+
+    def __init__(self, get_device, lock=None, on_error=None):
+        self._get_device = get_device
+        self._lock = lock or threading.Lock()
+        self._on_error = on_error
+        self._cond = threading.Condition()
+        self._queues = [collections.deque() for _ in WRITE_CLASS_NAMES]
+        self._latency = [collections.deque(maxlen=WRITE_LATENCY_SAMPLES) for _ in WRITE_CLASS_NAMES]
+        self._sent = [0] * len(WRITE_CLASS_NAMES)
+        self._merged = [0] * len(WRITE_CLASS_NAMES)
+        self._failed = [0] * len(WRITE_CLASS_NAMES)
+        self._thread = None
+        self._running = False
+
+    def start(self):
+        if self._thread is not None:
+            return
+        self._running = True
+        self._thread = threading.Thread(target=self._run, name="hid-writer", daemon=True)
+        self._thread.start()
+
+    def stop(self):
+        """Stop the thread; anything still queued is dropped (waiters get False)."""
+        with self._cond:
+            self._running = False
+            pending = [e for q in self._queues for e in q]
+            for q in self._queues:
+                q.clear()
+            self._cond.notify_all()
+        for entry in pending:
+            self._finish(entry, False)
+        self._thread = None
+
+    def submit(self, cls, msg_type, payload=b"", display=None, coalesce=None, wait=None) -> bool:
+        """Queue a message. With wait=<seconds>, block until it was written and
+        return whether that worked; else return True once queued."""
+        with self._cond:
+            if not self._running:
+                return False
+            if coalesce is not None and wait is None:
+                for entry in self._queues[cls]:
+                    if entry.msg_type == msg_type and entry.display == display:
+                        merged = coalesce(entry.payload, payload)
+                        if merged is not None:
+                            entry.payload = merged   # Keeps its place and submit time
+                            self._merged[cls] += 1
+                            return True
+            entry = self._Entry()
+            entry.msg_type = msg_type
+            entry.payload = payload
+            entry.display = display
+            entry.submitted = time.perf_counter()
+            entry.done = threading.Event() if wait is not None else None
+            entry.ok = False
+            self._queues[cls].append(entry)
+            self._cond.notify()
+        if entry.done is None:
+            return True
+        entry.done.wait(wait)
+        return entry.ok
+
+    def stats(self) -> dict:
+        """Per class: messages sent / coalesced / failed, still queued, and
+        submit-to-written latency (ms) over the last WRITE_LATENCY_SAMPLES."""
+        out = {}
+        with self._cond:
+            for cls, name in enumerate(WRITE_CLASS_NAMES):
+                samples = sorted(self._latency[cls])
+                pick = (lambda f: round(samples[min(int(len(samples) * f), len(samples) - 1)] * 1e3, 2)
+                        if samples else None)
+                out[name] = {"sent": self._sent[cls], "merged": self._merged[cls],
+                             "failed": self._failed[cls], "queued": len(self._queues[cls]),
+                             "p50_ms": pick(0.5), "p99_ms": pick(0.99),
+                             "max_ms": round(samples[-1] * 1e3, 2) if samples else None}
+        return out
+
+    @staticmethod
+    def _finish(entry, ok):
+        entry.ok = ok
+        if entry.done is not None:
+            entry.done.set()
+
+    def _run(self):
+        while True:
+            with self._cond:
+                while self._running and not any(self._queues):
+                    self._cond.wait()
+                if not self._running:
+                    return
+                cls = next(c for c, q in enumerate(self._queues) if q)
+                entry = self._queues[cls].popleft()
+            ok = self._write(entry)
+            with self._cond:
+                if ok:
+                    self._sent[cls] += 1
+                    self._latency[cls].append(time.perf_counter() - entry.submitted)
+                else:
+                    self._failed[cls] += 1
+            self._finish(entry, ok)
+
+    def _write(self, entry) -> bool:
+        try:
+            with self._lock:
+                device = self._get_device()
+                if device is None:
+                    return False
+                payload = entry.payload() if callable(entry.payload) else entry.payload
+                write_vendor_message(device, entry.msg_type, payload, entry.display)
+            return True
+        except (IOError, OSError, ValueError) as exc:
+            logger.debug("HID write of 0x%02X failed: %s", entry.msg_type, exc)
+            if self._on_error is not None and not isinstance(exc, ValueError):
+                self._on_error(exc)
+            return False
+
+
+def split_display(message: bytes):
+    """(display id, [TYPE][PAYLOAD...]) of a message from the bridge.
+
+    Display 0 (and a display that never paired) sends without envelope.
+    """
+    if len(message) >= 3 and message[0] == MSG_DISPLAY:
+        return message[1], message[2:]
+    return 0, message
+
+
+class FragmentReassembler:
+    """Rebuilds messages from vendor HID input reports.
+
+    feed() takes the report bytes without the report ID and returns the
+    complete [TYPE][PAYLOAD...] message, or None while a fragmented message
+    is still incomplete. Out-of-order fragments drop the partial message.
+    """
+
+    def __init__(self):
+        self._buf = bytearray()
+        self._seq = None
+        self._next = 0
+        self.dropped = 0
+
+    def feed(self, report: bytes):
+        report = bytes(report)
+        if not report:
+            return None
+        if report[0] != MSG_FRAGMENT:
+            return report
+        if len(report) < FRAG_HEADER_SIZE:
+            return None
+
+        seq, flags, data_len = report[1], report[2], report[3]
+        index = flags & FRAG_INDEX_MASK
+        data = report[FRAG_HEADER_SIZE:FRAG_HEADER_SIZE + data_len]
+
+        if index == 0:
+            if self._seq is not None:
+                self.dropped += 1
+            self._buf = bytearray()
+            self._seq = seq
+        elif seq != self._seq or index != self._next:
+            if self._seq is not None:
+                self.dropped += 1
+            self._seq = None
+            return None
+
+        self._buf += data
+        self._next = index + 1
+        if flags & FRAG_LAST:
+            self._seq = None
+            return bytes(self._buf[:VENDOR_MAX_MESSAGE])
+        return None
+
+
+def push_chunks(write, wait_ack, data_type, end_type, xfer_id, data, acked, name, errors,
+                progress=None, ack_timeout=0.3, max_retries=10):
+    """Windowed go-back-N from `acked` to the end of `data`, then END.
+
+    write(msg_type, payload) sends one message; wait_ack(timeout) returns the
+    newest (status, next_offset) for xfer_id or None. Up to BULK_WINDOW
+    chunks are in flight and a missing ACK rewinds to the last acknowledged
+    offset. Shared by the display file transfer (MSG_BULK_*) and the bridge
+    firmware update (MSG_FW_*). Raises BulkTransferError on failure.
+    """
+    total = len(data)
+    sent = acked
+    retries = 0
+    start_offset, start = acked, time.monotonic()
+    while True:
+        # Fill the window
+        while sent < total and sent < acked + BULK_WINDOW * BULK_CHUNK_SIZE:
+            chunk = data[sent:sent + BULK_CHUNK_SIZE]
+            write(data_type, struct.pack("<BI", xfer_id, sent) + chunk)
+            sent += len(chunk)
+        if acked >= total:
+            write(end_type, bytes([xfer_id]))
+
+        ack = wait_ack(ack_timeout)
+        if ack is None:
+            retries += 1
+            if retries > max_retries:
+                raise BulkTransferError(f"{name}: timed out at {acked}/{total} bytes", timed_out=True)
+            sent = acked  # Go back to the last confirmed offset
+            continue
+
+        status, next_offset = ack
+        if status == BULK_DONE:
+            if progress:
+                progress(total, total)
+            elapsed = time.monotonic() - start
+            rate = (total - start_offset) / elapsed / 1024 if elapsed > 0 else 0.0
+            logger.info("Bulk: sent %s (%d bytes, %.1f KB/s)", name, total, rate)
+            return
+        if status != BULK_OK:
+            raise BulkTransferError(f"{name}: {errors.get(status, status)}", status=status)
+        if next_offset > acked:
+            retries = 0
+        acked = next_offset
+        if next_offset < sent:
+            sent = next_offset  # Receiver reported a gap/duplicate
+        if progress:
+            progress(acked, total)
+
+
+def begin_transfer(write, wait_ack, begin_type, begin, name, errors, peer, ack_timeout=0.3) -> int:
+    """Send BEGIN (three tries) and return the offset to resume from.
+
+    Raises BulkTransferError; no_response=True when `peer` never answered.
+    """
+    for _ in range(3):
+        write(begin_type, begin)
+        ack = wait_ack(ack_timeout * 3)
+        if ack:
+            status, acked = ack
+            if status != BULK_OK:
+                raise BulkTransferError(f"{name}: {errors.get(status, status)}", status=status)
+            return acked
+    raise BulkTransferError(f"{name}: {peer} did not answer", no_response=True)
+
+
+def send_firmware(write, wait_ack, xfer_id, image: bytes, progress=None,
+                  ack_timeout: float = 0.3, max_retries: int = 10) -> None:
+    """Flash a bridge firmware.bin (or its .gz) over MSG_FW_*.
+
+    The bridge writes it to its idle OTA slot, verifies it and reboots into
+    it once no key is held. write/wait_ack as for push_chunks(); a transfer
+    interrupted before END resumes when called again with the same image.
+    Raises BulkTransferError (no_response=True: the bridge firmware has no
+    update channel and needs one USB flash).
+    """
+    if image[:2] == b"\x1f\x8b":
+        image = gzip.decompress(image)  # The bridge takes plain images only
+    begin = struct.pack("<BBII", xfer_id, 0, len(image), zlib.crc32(image) & 0xFFFFFFFF)
+    acked = begin_transfer(write, wait_ack, MSG_FW_BEGIN, begin, "bridge firmware",
+                           _FW_ERRORS, "bridge", ack_timeout)
+    push_chunks(write, wait_ack, MSG_FW_DATA, MSG_FW_END, xfer_id, image, acked,
+                "bridge firmware", _FW_ERRORS, progress, ack_timeout, max_retries)
+
+
+def send_display_firmware(write, wait_ack, xfer_id, image: bytes, progress=None,
+                          ack_timeout: float = 0.3, max_retries: int = 10) -> None:
+    """Push a display firmware.bin (or, smaller over the air, its .gz) over ESP-NOW.
+
+    MSG_BULK_* with BULK_FLAG_FIRMWARE: the display inflates it into its
+    idle OTA slot while the UI keeps running, verifies it and boots it the
+    next time it dims or shows the clock. A dropped transfer resumes when
+    called again with the same image, as long as the display has not
+    rebooted in between. Raises BulkTransferError.
+    """
+    begin = struct.pack("<BBII", xfer_id, BULK_FLAG_FIRMWARE, len(image), zlib.crc32(image) & 0xFFFFFFFF)
+    begin += b"/firmware.bin".ljust(BULK_PATH_MAX, b"\x00")
+    acked = begin_transfer(write, wait_ack, MSG_BULK_BEGIN, begin, "display firmware",
+                           _DISPLAY_FW_ERRORS, "display", ack_timeout)
+    push_chunks(write, wait_ack, MSG_BULK_DATA, MSG_BULK_END, xfer_id, image, acked,
+                "display firmware", _DISPLAY_FW_ERRORS, progress, ack_timeout, max_retries)
+
+
+def send_remote_image(write, wait_ack, xfer_id, source: str, patch: bytes,
+                      ack_timeout: float = 0.3, max_retries: int = 3) -> None:
+    """Push one remote image patch (RemoteImageStream.patches()) for `source`.
+
+    MSG_BULK_* with BULK_FLAG_IMAGE: staged in the display's PSRAM and
+    applied at END. Always starts over (no resume: the next frame
+    supersedes this one anyway). Raises BulkTransferError; status
+    BULK_ERR_BAD means the display needs a key frame.
+    """
+    name = source.encode("utf-8")[:BULK_PATH_MAX - 1]
+    begin = struct.pack("<BBII", xfer_id, BULK_FLAG_IMAGE | BULK_FLAG_RESTART, len(patch),
+                        zlib.crc32(patch) & 0xFFFFFFFF)
+    begin += name.ljust(BULK_PATH_MAX, b"\x00")
+    label = f"remote image {source}"
+    acked = begin_transfer(write, wait_ack, MSG_BULK_BEGIN, begin, label, _IMAGE_ERRORS,
+                           "display", ack_timeout)
+    push_chunks(write, wait_ack, MSG_BULK_DATA, MSG_BULK_END, xfer_id, patch, acked,
+                label, _IMAGE_ERRORS, None, ack_timeout, max_retries)
 
 
 class BridgeDeviceError(Exception):
@@ -23,17 +440,68 @@ class BridgeDeviceError(Exception):
     pass
 
 
+class BulkTransferError(BridgeDeviceError):
+    """Raised when a bulk file transfer fails.
+
+    no_response is True when the display never answered BEGIN, i.e. its
+    firmware predates the bulk channel and the caller should fall back to
+    the SoftAP upload. timed_out is True when ACKs stopped mid-transfer:
+    calling again resumes.
+    """
+
+    def __init__(self, message: str, no_response: bool = False, timed_out: bool = False,
+                 status=None):
+        super().__init__(message)
+        self.no_response = no_response
+        self.timed_out = timed_out
+        self.status = status  # BulkStatus the receiver answered with, if it did
+
+
+class _NoLzSupport(Exception):
+    """The display accepted a BULK_FLAG_LZ BEGIN without decoding it."""
+
+
 class BridgeDevice:
-    """USB HID interface to the HotkeyBridge ESP32-S3."""
+    """USB HID interface to the HotkeyBridge ESP32-S3.
 
-    def __init__(self):
+    With the companion service running, open() connects to its socket and
+    every message goes through the service's HID writer; the bridge is only
+    opened directly when no service is listening.
+    """
+
+    def __init__(self, display=None):
         self._device = None
+        self._service = None      # ServiceClient while the service owns the bridge
+        self.display = display  # None: every display on the bridge
+        self._reassembler = FragmentReassembler()
+        self._xfer_id = 0
+        self._ack_display = None  # Display whose ACKs pace the current transfer
+        self._ack_flags = 0       # BulkAckMsg.flags of the newest ACK
 
     def open(self) -> None:
-        """Find and open the HotkeyBridge USB HID device.
+        """Connect to the companion service, or find and open the HotkeyBridge
+        USB HID device when none runs.
 
         Raises BridgeDeviceError if bridge is not found or cannot be opened.
         """
+        from companion.service_ipc import ServiceClient, ServiceError
+        client = ServiceClient()
+        if client.connect():
+            try:
+                if not client.status().get("connected"):
+                    raise BridgeDeviceError("Companion service runs, but the bridge is not connected")
+                client.subscribe(["message"], [MSG_BULK_ACK, MSG_FW_ACK])
+            except ServiceError as e:
+                client.close()
+                raise BridgeDeviceError(f"Companion service: {e}")
+            except BridgeDeviceError:
+                client.close()
+                raise
+            self._service = client
+            self._device = client
+            logger.info("Bridge reached through the companion service")
+            return
+
         try:
             import hid
         except ImportError:
@@ -73,7 +541,8 @@ class BridgeDevice:
             raise BridgeDeviceError(f"Failed to open bridge: {e}")
 
     def close(self) -> None:
-        """Close the HID device."""
+        """Close the HID device (or the service connection)."""
+        self._service = None
         if self._device:
             try:
                 self._device.close()
@@ -91,22 +560,142 @@ class BridgeDevice:
         self._send(MSG_CONFIG_DONE)
         logger.info("Sent CONFIG_DONE to bridge")
 
-    def _send(self, msg_type: int) -> None:
-        """Send a zero-payload message to the bridge.
+    def send_file(self, remote_path: str, data: bytes, apply: bool = False,
+                  progress=None, ack_timeout: float = 0.3, max_retries: int = 10) -> None:
+        """Push a file to the display's SD card over USB + ESP-NOW.
 
-        Packet format: [0x00 report ID] [msg_type] [0-pad to 64 bytes]
-        Must be padded to full 64-byte report for USBHIDVendor to receive it.
+        Windowed go-back-N: up to BULK_WINDOW chunks are in flight, the
+        display ACKs the offset it has stored, and a missing ACK rewinds to
+        the last acknowledged offset. Calling again for the same file after a
+        failure resumes where the display stopped. /config.json is applied
+        on commit; apply=True also rebuilds the UI for other files (icons).
+        Without a target display (self.display) the file goes to every
+        display, paced by the first one to answer.
+        For a target display the file travels LZ-compressed when that saves
+        enough; a display that doesn't answer BEGIN with BULK_FLAG_LZ gets
+        it again from the start, uncompressed. Displays that may not decode
+        it never see a compressed stream, so a broadcast always goes plain.
+        progress(sent_bytes, total_bytes) is called as ACKs arrive, in
+        bytes of what travels.
+        Raises BulkTransferError on failure.
         """
         if not self._device:
             raise BridgeDeviceError("Bridge not open")
+        path = remote_path.encode("utf-8")
+        if not path.startswith(b"/") or len(path) >= BULK_PATH_MAX:
+            raise BulkTransferError(f"invalid remote path: {remote_path}")
+
+        flags = BULK_FLAG_APPLY if apply else 0
+        if self.display is not None:
+            packed = lz_stream.compress(data)
+            if len(packed) < len(data) * BULK_LZ_MIN_GAIN:
+                try:
+                    self._send_stream(remote_path, path, packed, flags | BULK_FLAG_LZ,
+                                      progress, ack_timeout, max_retries)
+                    return
+                except _NoLzSupport:
+                    logger.info("Bulk: display doesn't decode LZ, sending %s uncompressed", remote_path)
+                    flags |= BULK_FLAG_RESTART
+        self._send_stream(remote_path, path, data, flags, progress, ack_timeout, max_retries)
+
+    def _send_stream(self, remote_path, path, data, flags, progress, ack_timeout, max_retries):
+        """One BEGIN/DATA/END exchange for send_file(); raises _NoLzSupport
+        if BULK_FLAG_LZ was asked for and the BEGIN ACK doesn't carry it."""
+        self._xfer_id = (self._xfer_id + 1) & 0xFF
+        xfer_id = self._xfer_id
+        # Sent to every display, the first to answer BEGIN paces the window
+        self._ack_display = self.display
+        total = len(data)
+        begin = struct.pack("<BBII", xfer_id, flags, total, zlib.crc32(data) & 0xFFFFFFFF)
+        begin += path.ljust(BULK_PATH_MAX, b"\x00")
+
+        wait_ack = lambda t: self._wait_bulk_ack(xfer_id, t)
+        acked = begin_transfer(self._write, wait_ack, MSG_BULK_BEGIN, begin, remote_path,
+                               _BULK_ERRORS, "display", ack_timeout)
+        if (flags & BULK_FLAG_LZ) and not (self._ack_flags & BULK_FLAG_LZ):
+            raise _NoLzSupport()
+        push_chunks(self._write, wait_ack, MSG_BULK_DATA, MSG_BULK_END,
+                    xfer_id, data, acked, remote_path, _BULK_ERRORS, progress, ack_timeout, max_retries)
+
+    def _wait_bulk_ack(self, xfer_id: int, timeout: float, ack_type: int = MSG_BULK_ACK):
+        """Wait for MSG_BULK_ACKs for xfer_id.
+
+        Returns (status, next_offset) or None on timeout. ACKs already
+        queued behind the first one are drained too, so the sender acts on
+        the newest state instead of working through a stale backlog. Other
+        inbound messages (button presses etc.) are discarded while deploying.
+        """
+        best = None
+        deadline = time.monotonic() + timeout
+        while True:
+            remaining = deadline - time.monotonic()
+            if best is not None:
+                remaining = 0  # Only take what is already queued
+            elif remaining <= 0:
+                return None
+            received = self._read_message(remaining)
+            if received is None:
+                if best is not None:
+                    return best
+                continue
+            display, message = received
+            if not message:
+                continue
+            if self._ack_display is not None and display != self._ack_display:
+                continue
+            if message[0] != ack_type or len(message) < 1 + BULK_ACK.size:
+                continue
+            ack_id, status, next_offset = BULK_ACK.unpack_from(message, 1)
+            if ack_id != xfer_id:
+                continue
+            self._ack_display = display
+            # Zero when absent: short reports arrive zero-padded
+            self._ack_flags = message[1 + BULK_ACK.size] if len(message) > 1 + BULK_ACK.size else 0
+            if status != BULK_OK:
+                return status, next_offset  # Final result or error wins
+            if best is None or next_offset > best[1]:
+                best = (status, next_offset)
+
+    def _read_message(self, timeout: float):
+        """(display, [TYPE][PAYLOAD...]) of the next inbound message, or
+        (0, None) for a report that didn't complete one; None on timeout."""
+        if self._service is not None:
+            try:
+                event = self._service.next_event(timeout)
+            except IOError as e:
+                raise BridgeDeviceError(f"Companion service: {e}")
+            if event is None:
+                return None
+            return event["display"], bytes([event["type"]]) + bytes.fromhex(event["payload"])
         try:
-            buf = bytearray(64)
-            buf[0] = 0x06   # HID report ID for vendor interface
-            buf[1] = msg_type
-            self._device.write(bytes(buf))
+            report = self._device.read(1 + VENDOR_REPORT_SIZE, int(timeout * 1000))
+        except (IOError, OSError) as e:
+            raise BridgeDeviceError(f"HID read failed: {e}")
+        if not report:
+            return None
+        message = self._reassembler.feed(report[1:])
+        return split_display(message) if message else (0, None)
+
+    def _write(self, msg_type: int, payload: bytes = b"", cls: int = WRITE_BULK) -> None:
+        if self._service is not None:
+            try:
+                ok = self._service.send(msg_type, payload, self.display, WRITE_CLASS_NAMES[cls])
+            except IOError as e:
+                raise BridgeDeviceError(f"Companion service: {e}")
+            if not ok:
+                raise BridgeDeviceError("Companion service: bridge not connected")
+            return
+        try:
+            write_vendor_message(self._device, msg_type, payload, self.display)
         except (IOError, OSError) as e:
             raise BridgeDeviceError(f"HID write failed: {e}")
 
+    def _send(self, msg_type: int) -> None:
+        """Send a zero-payload message to the bridge."""
+        if not self._device:
+            raise BridgeDeviceError("Bridge not open")
+        self._write(msg_type, cls=WRITE_CONTROL)
+
     def __enter__(self):
         self.open()
         return self
@@ -13,7 +13,7 @@ import json
 import os
 import uuid
 from pathlib import Path
-from typing import Dict, List, Any, Optional
+from typing import Dict, List, Any, Optional, Tuple
 
 
 # Action type constants (must match device/protocol.h)
@@ -35,6 +35,13 @@ ACTION_DDC = 14              # DDC/CI monitor control
 ACTION_FOCUS_NEXT = 15       # Focus next button on page (display-local)
 ACTION_FOCUS_PREV = 16       # Focus previous button on page (display-local)
 ACTION_FOCUS_ACTIVATE = 17   # Activate focused button (display-local)
+ACTION_MACRO = 18            # Key sequence played back by the bridge
+ACTION_PERF_HUD = 19         # Toggle render performance overlay (display-local)
+ACTION_PROFILE_GOTO = 20     # Switch to profile N (display-local)
+ACTION_PROFILE_NEXT = 21     # Switch to the next profile (display-local)
+ACTION_HOST_NEXT = 22        # Switch to the next paired PC (display-local)
+ACTION_HOST_PAIR = 23        # Pair one more PC's bridge (display-local)
+ACTION_TYPE_TEXT = 24        # Type a UTF-8 string in the host's keyboard layout (bridge plays it)
 
 VALID_ACTION_TYPES = (
     ACTION_HOTKEY, ACTION_MEDIA_KEY, ACTION_LAUNCH_APP, ACTION_SHELL_CMD, ACTION_OPEN_URL,
@@ -42,6 +49,8 @@ VALID_ACTION_TYPES = (
     ACTION_PAGE_NEXT, ACTION_PAGE_PREV, ACTION_PAGE_GOTO,
     ACTION_MODE_CYCLE, ACTION_BRIGHTNESS, ACTION_CONFIG_MODE,
     ACTION_DDC, ACTION_FOCUS_NEXT, ACTION_FOCUS_PREV, ACTION_FOCUS_ACTIVATE,
+    ACTION_MACRO, ACTION_PERF_HUD, ACTION_PROFILE_GOTO, ACTION_PROFILE_NEXT,
+    ACTION_HOST_NEXT, ACTION_HOST_PAIR, ACTION_TYPE_TEXT,
 )
 
 # Display-local actions that the companion should NOT try to execute
@@ -50,6 +59,8 @@ DISPLAY_LOCAL_ACTIONS = {
     ACTION_PAGE_NEXT, ACTION_PAGE_PREV, ACTION_PAGE_GOTO,
     ACTION_MODE_CYCLE, ACTION_BRIGHTNESS, ACTION_CONFIG_MODE,
     ACTION_FOCUS_NEXT, ACTION_FOCUS_PREV, ACTION_FOCUS_ACTIVATE,
+    ACTION_PERF_HUD, ACTION_PROFILE_GOTO, ACTION_PROFILE_NEXT,
+    ACTION_HOST_NEXT, ACTION_HOST_PAIR,
 }
 
 # Human-readable names for action type dropdowns
@@ -72,8 +83,89 @@ ACTION_TYPE_NAMES = {
     ACTION_FOCUS_NEXT: "Focus Next",
     ACTION_FOCUS_PREV: "Focus Previous",
     ACTION_FOCUS_ACTIVATE: "Activate Focus",
+    ACTION_MACRO: "Macro / Key Sequence",
+    ACTION_PERF_HUD: "Performance Overlay",
+    ACTION_PROFILE_GOTO: "Go to Profile",
+    ACTION_PROFILE_NEXT: "Next Profile",
+    ACTION_HOST_NEXT: "Next Host",
+    ACTION_HOST_PAIR: "Pair New Host",
+    ACTION_TYPE_TEXT: "Type Text",
 }
 
+# Macro steps (must match MacroOp / MACRO_MAX_STEPS in shared/protocol.h).
+# JSON: widget["macro"] = [{"op": "tap", "mod": 1, "key": 99}, {"op": "delay", "ms": 50}, ...]
+# "text" is expanded by the display into one tap per character.
+MACRO_MAX_STEPS = 64
+MACRO_OPS = ("tap", "press", "release", "release_all", "delay", "media", "text")
+
+# Typed text (must match TYPE_TEXT_MAX_BYTES / KeyLayout in shared/protocol.h
+# and shared/key_layouts.h). JSON: widget["text"], widget["key_layout"].
+TYPE_TEXT_MAX_BYTES = 240
+KEY_LAYOUTS = ("us", "uk", "de", "fr")
+
+
+def macro_step_count(steps) -> int:
+    """Number of device-side steps a macro expands to ("text" = one per char)."""
+    count = 0
+    for step in steps:
+        if step.get("op") == "text":
+            count += len(step.get("text", ""))
+        else:
+            count += 1
+    return count
+
+
+# Stat alert rules (must match StatRule / STAT_RULES_MAX in display/config.h).
+# JSON: widget["rules"] = [{"above": 85, "hysteresis": 3, "color": 0xFF0000, "blink": true, "toast": true}]
+# Thresholds are in the stat's displayed units (load average x100, like graph_max).
+STAT_RULES_MAX = 4
+
+
+def text_to_rules(text: str) -> list:
+    """Parse the editor's rules text ("above 85 #FF0000 hyst 3 blink toast",
+    one rule per line) into widget["rules"]. Raises ValueError."""
+    rules = []
+    for lineno, raw in enumerate(text.splitlines(), 1):
+        words = raw.split()
+        if not words or words[0].startswith("#"):
+            continue
+        try:
+            if words[0].lower() not in ("above", "below") or len(words) < 2:
+                raise ValueError("expected 'above N' or 'below N'")
+            rule = {words[0].lower(): int(words[1], 0)}
+            rest = iter(words[2:])
+            for word in rest:
+                lw = word.lower()
+                if lw.startswith("#"):
+                    rule["color"] = int(word[1:], 16) & 0xFFFFFF
+                elif lw in ("hyst", "hysteresis"):
+                    rule["hysteresis"] = max(0, min(int(next(rest, "0"), 0), 0xFFFF))
+                elif lw in ("blink", "toast"):
+                    rule[lw] = True
+                else:
+                    raise ValueError(f"unknown word '{word}'")
+        except ValueError as exc:
+            raise ValueError(f"line {lineno}: {exc}") from None
+        rules.append(rule)
+    if len(rules) > STAT_RULES_MAX:
+        raise ValueError(f"at most {STAT_RULES_MAX} rules")
+    return rules
+
+
+def rules_to_text(rules: list) -> str:
+    """Format widget["rules"] for the editor's rules text box."""
+    lines = []
+    for rule in rules:
+        key = "below" if "below" in rule else "above"
+        parts = [key, str(rule.get(key, 0))]
+        if rule.get("color"):
+            parts.append(f"#{rule['color']:06X}")
+        if rule.get("hysteresis"):
+            parts.append(f"hyst {rule['hysteresis']}")
+        parts.extend(flag for flag in ("blink", "toast") if rule.get(flag))
+        lines.append(" ".join(parts))
+    return "\n".join(lines)
+
 # Encoder rotation mode names
 ENCODER_MODE_NAMES = {
     0: "Page Navigation",
@@ -118,8 +210,38 @@ WIDGET_CLOCK = 3
 WIDGET_TEXT_LABEL = 4
 WIDGET_SEPARATOR = 5
 WIDGET_PAGE_NAV = 6
-
-WIDGET_TYPE_MAX = 6
+WIDGET_STAT_GRAPH = 7
+WIDGET_TRACKPAD = 8
+WIDGET_REMOTE_IMAGE = 9
+WIDGET_SCROLL_GRID = 10
+
+WIDGET_TYPE_MAX = 10
+
+# Stat graph history length (must match GRAPH_POINTS_* in display/config.h)
+GRAPH_POINTS_MIN = 8
+GRAPH_POINTS_MAX = 240
+GRAPH_POINTS_DEFAULT = 60
+
+# Remote stats collectors, "remote_host" of a stat monitor (must match REMOTE_HOST_MAX in shared/protocol.h)
+REMOTE_HOST_MAX = 8
+
+# Trackpad pointer speed in tenths (must match TRACKPAD_SPEED_* in display/config.h)
+TRACKPAD_SPEED_MIN = 1
+TRACKPAD_SPEED_MAX = 50
+TRACKPAD_SPEED_DEFAULT = 15
+
+# Remote image sources (see companion/remote_image.py); names ride in a
+# BULK_PATH_MAX field on the wire
+REMOTE_IMAGE_SOURCE_MAX = 63
+REMOTE_IMAGE_DEFAULT_SOURCE = "now_playing"
+
+# Scroll grid (launcher) limits (must match GRID_* in display/config.h)
+GRID_ENTRIES_MAX = 512
+GRID_COLUMNS_MAX = 8
+GRID_ROW_HEIGHT_MIN = 40
+GRID_ROW_HEIGHT_MAX = 240
+GRID_ROW_HEIGHT_DEFAULT = 96
+GRID_CELL_GAP = 6   # UI_GRID_CELL_GAP in display/ui.cpp
 
 WIDGET_TYPE_NAMES = {
     WIDGET_HOTKEY_BUTTON: "Hotkey Button",
@@ -129,6 +251,10 @@ WIDGET_TYPE_NAMES = {
     WIDGET_TEXT_LABEL: "Text Label",
     WIDGET_SEPARATOR: "Separator",
     WIDGET_PAGE_NAV: "Page Nav",
+    WIDGET_STAT_GRAPH: "Stat Graph",
+    WIDGET_TRACKPAD: "Trackpad",
+    WIDGET_REMOTE_IMAGE: "Remote Image",
+    WIDGET_SCROLL_GRID: "Scroll Grid",
 }
 
 # Default widget sizes
@@ -140,6 +266,10 @@ WIDGET_DEFAULT_SIZES = {
     WIDGET_TEXT_LABEL: (160, 40),
     WIDGET_SEPARATOR: (200, 4),
     WIDGET_PAGE_NAV: (200, 30),
+    WIDGET_STAT_GRAPH: (240, 100),
+    WIDGET_TRACKPAD: (320, 200),
+    WIDGET_REMOTE_IMAGE: (160, 160),
+    WIDGET_SCROLL_GRID: (400, 400),
 }
 
 # Modifier constants (must match shared/protocol.h)
@@ -151,9 +281,35 @@ MOD_GUI = 0x08
 
 # Config constraints
 CONFIG_VERSION = 2
-CONFIG_MAX_PAGES = 16
-CONFIG_MAX_WIDGETS = 32
+CONFIG_MAX_PAGES = 64     # Ceilings only: pages are admitted by cost (below)
+CONFIG_MAX_WIDGETS = 127
 CONFIG_MAX_STATS = 8
+CONFIG_MAX_TEMPLATES = 32  # Per profile "templates" (display/config.h)
+TEMPLATE_MIN_WIDGETS = 3   # Widgets of one type before compact_templates() factors them
+BRIDGE_MAX_DISPLAYS = 4  # Per bridge (shared/protocol.h); profile "display" targets one
+
+# Layout cost model (display/config_cost.h): per widget type, LVGL heap
+# bytes and objects of one instance, and render time per 1000 px of its
+# area; the device serves its own table and budgets at GET /api/budget,
+# which validate() takes over these defaults
+WIDGET_COSTS = {
+    WIDGET_HOTKEY_BUTTON: (1100, 4, 60),
+    WIDGET_STAT_MONITOR: (700, 3, 30),
+    WIDGET_STATUS_BAR: (1800, 9, 20),
+    WIDGET_CLOCK: (900, 2, 25),
+    WIDGET_TEXT_LABEL: (400, 1, 25),
+    WIDGET_SEPARATOR: (250, 1, 10),
+    WIDGET_PAGE_NAV: (1200, 6, 15),
+    WIDGET_STAT_GRAPH: (1400, 2, 80),
+    WIDGET_TRACKPAD: (500, 2, 15),
+    WIDGET_REMOTE_IMAGE: (500, 1, 40),
+    WIDGET_SCROLL_GRID: (800, 1, 50),
+}
+PAGE_BUDGET = {"heap": 512 * 1024, "image_bytes": 1536 * 1024, "render_us": 200000}
+COST_GRID_CELL_GAP = 6
+COST_GRID_OVERSCAN = 1
+COST_GRID_CELL_HEAP = 900
+COST_GRID_CELL_OBJECTS = 3
 
 # Display dimensions
 DISPLAY_WIDTH = 800
@@ -215,6 +371,17 @@ def get_default_encoder():
     }
 
 
+def get_default_gestures():
+    """Default touch gesture bindings (swipe = page nav, two-finger tap = first page)."""
+    return {
+        "swipe_pages": True,
+        "two_finger_tap": {"enabled": True, "action_type": ACTION_PAGE_GOTO,
+                           "keycode": 0, "consumer_code": 0, "modifiers": 0},
+        "long_press": {"enabled": False, "action_type": ACTION_MODE_CYCLE,
+                       "keycode": 0, "consumer_code": 0, "modifiers": 0},
+    }
+
+
 def get_default_mode_cycle():
     """Default mode cycle order (all modes enabled)."""
     return [0, 1, 2, 3]
@@ -226,7 +393,8 @@ def get_default_display_settings():
         "dim_timeout_sec": 60, "sleep_timeout_sec": 300,
         "wake_on_touch": True, "clock_24h": True,
         "clock_color_theme": 0xFFFFFF, "slideshow_interval_sec": 30,
-        "slideshow_transition": "fade",
+        "slideshow_transition": "fade", "slideshow_shuffle": False,
+        "battery_saver_pct": 30, "battery_critical_pct": 15,
     }
 
 
@@ -258,6 +426,7 @@ def make_default_widget(widget_type: int, x: int = 0, y: int = 0) -> Dict[str, A
             "keycode": 0,
             "consumer_code": 0,
             "pressed_color": 0,
+            "fire_on_press": False,
             "launch_command": "",
             "launch_wm_class": "",
             "launch_focus_or_launch": True,
@@ -309,10 +478,49 @@ def make_default_widget(widget_type: int, x: int = 0, y: int = 0) -> Dict[str, A
         widget.update({
             "color": DEFAULT_COLORS["BLUE"],
         })
+    elif widget_type == WIDGET_STAT_GRAPH:
+        widget.update({
+            "label": "CPU",
+            "stat_type": 0x01,
+            "color": DEFAULT_COLORS["BLUE"],
+            "graph_points": GRAPH_POINTS_DEFAULT,
+            "graph_max": 0,
+        })
+    elif widget_type == WIDGET_TRACKPAD:
+        widget.update({
+            "label": "Trackpad",
+            "color": DEFAULT_COLORS["BLUE"],
+            "trackpad_absolute": False,
+            "trackpad_speed": TRACKPAD_SPEED_DEFAULT,
+        })
+    elif widget_type == WIDGET_REMOTE_IMAGE:
+        widget.update({
+            "label": "Now Playing",
+            "show_label": False,
+            "image_source": REMOTE_IMAGE_DEFAULT_SOURCE,
+        })
+    elif widget_type == WIDGET_SCROLL_GRID:
+        widget.update({
+            "label": "Apps",
+            "show_label": False,
+            "grid_columns": 4,
+            "grid_row_height": GRID_ROW_HEIGHT_DEFAULT,
+            "entries": [],
+        })
 
     return widget
 
 
+def grid_icon_size(widget: Dict[str, Any]) -> Tuple[int, int]:
+    """Icon box of a scroll grid cell, as render_scroll_grid() lays it out on the display."""
+    cols = max(1, widget.get("grid_columns", 1))
+    cell_w = (widget.get("width", 400) - GRID_CELL_GAP * (cols + 1)) // cols
+    cell_h = widget.get("grid_row_height", GRID_ROW_HEIGHT_DEFAULT) - GRID_CELL_GAP
+    if cols == 1:
+        return max(1, cell_h - 8), max(1, cell_h - 8)
+    return max(1, cell_w * 6 // 10), max(1, cell_h - 32)
+
+
 def _migrate_v1_page(v1_page: Dict[str, Any]) -> Dict[str, Any]:
     """Migrate a v1 grid-based page to v2 absolute-positioned widgets."""
     v2_page = {"name": v1_page.get("name", "Page"), "widgets": []}
@@ -402,12 +610,159 @@ def ensure_widget_ids(config: Dict[str, Any]) -> None:
                     widget["widget_id"] = str(uuid.uuid4())
 
 
+def resolve_templates(config: Dict[str, Any]) -> None:
+    """Expand widget "template" references in place and drop the profiles'
+    "templates": the editor only works on complete widgets. A widget's own
+    keys win over its template's, as on the display."""
+    for profile in config.get("profiles", []):
+        templates = profile.pop("templates", None) or {}
+        for page in profile.get("pages", []):
+            widgets = page.get("widgets", [])
+            for i, widget in enumerate(widgets):
+                base = templates.get(widget.pop("template", None))
+                if isinstance(base, dict):
+                    resolved = {k: v for k, v in base.items() if k != "template"}
+                    resolved.update(widget)
+                    widgets[i] = resolved
+
+
+def compact_templates(config: Dict[str, Any]) -> Dict[str, Any]:
+    """A copy of `config` with each profile's repeated widget fields factored
+    out into "templates" (display/config.h), for deploying.
+
+    One template per widget type with at least TEMPLATE_MIN_WIDGETS widgets:
+    every key all of them have, at its most common value when two or more
+    share it. Widgets then keep only the keys that differ. A key some widget
+    lacks never goes into the template -- the display would hand that widget
+    the template's value instead of its own default.
+    """
+    config = json.loads(json.dumps(config))
+    resolve_templates(config)
+    for profile in config.get("profiles", []):
+        by_type: Dict[int, List[Dict[str, Any]]] = {}
+        for page in profile.get("pages", []):
+            for widget in page.get("widgets", []):
+                by_type.setdefault(widget.get("widget_type", WIDGET_HOTKEY_BUTTON), []).append(widget)
+
+        templates = {}
+        for widget_type, widgets in sorted(by_type.items()):
+            if len(widgets) < TEMPLATE_MIN_WIDGETS or len(templates) >= CONFIG_MAX_TEMPLATES:
+                continue
+            shared = set(widgets[0]).intersection(*widgets[1:]) - {"widget_id"}
+            base = {}
+            for key in sorted(shared):
+                counts: Dict[str, int] = {}
+                for widget in widgets:
+                    enc = json.dumps(widget[key], sort_keys=True)
+                    counts[enc] = counts.get(enc, 0) + 1
+                enc, n = max(counts.items(), key=lambda kv: kv[1])
+                if n >= 2:
+                    base[key] = json.loads(enc)
+            if not base:
+                continue
+            name = WIDGET_TYPE_NAMES.get(widget_type, "widget").lower().replace(" ", "_")
+            templates[name] = base
+            for widget in widgets:
+                for key, value in base.items():
+                    if widget[key] == value:
+                        del widget[key]
+                widget["template"] = name
+        if templates:
+            profile["templates"] = templates
+    return config
+
+
+def budget_from_device(reply: Optional[Dict[str, Any]]) -> Optional[Dict[str, Any]]:
+    """Budget dict for page_cost()/validate() from a GET /api/budget reply,
+    or None if there is none (older firmware)."""
+    if not reply or "page" not in reply:
+        return None
+    costs = dict(WIDGET_COSTS)
+    for t, row in enumerate(reply.get("widgets", [])):
+        costs[t] = (row.get("heap", 0), row.get("objects", 0), row.get("render_us_kpx", 0))
+    return {
+        "max_pages": reply.get("max_pages", CONFIG_MAX_PAGES),
+        "max_widgets": reply.get("max_widgets", CONFIG_MAX_WIDGETS),
+        "page": {**PAGE_BUDGET, **reply["page"]},
+        "costs": costs,
+    }
+
+
+def page_cost(page: Dict[str, Any], budget: Optional[Dict[str, Any]] = None) -> Dict[str, int]:
+    """What a page costs the display once realized: the firmware's model
+    (display/config_cost.cpp), with the device's table when given one."""
+    costs = (budget or {}).get("costs", WIDGET_COSTS)
+    cost = {"heap": 0, "image_bytes": 0, "render_us": 0, "objects": 0}
+
+    def icon_bytes(w, h):
+        return max(w, 1) * max(h, 1) * 3   # RGB565 + alpha
+
+    for widget in page.get("widgets", []):
+        wtype = widget.get("widget_type", WIDGET_HOTKEY_BUTTON)
+        heap, objects, render_kpx = costs.get(wtype, costs[WIDGET_HOTKEY_BUTTON])
+        w = max(widget.get("width", 0), 0)
+        h = max(widget.get("height", 0), 0)
+        cost["heap"] += heap
+        cost["objects"] += objects
+        cost["render_us"] += render_kpx * w * h // 1000
+        if wtype == WIDGET_HOTKEY_BUTTON:
+            if widget.get("icon_path") or widget.get("icon_source"):
+                has_label = widget.get("show_label", True) and widget.get("label")
+                has_desc = widget.get("show_description", True) and widget.get("description")
+                if has_label or has_desc:
+                    cost["image_bytes"] += icon_bytes(w * 6 // 10, h * 4 // 10)
+                else:
+                    cost["image_bytes"] += icon_bytes(w * 8 // 10, h * 8 // 10)
+        elif wtype == WIDGET_TEXT_LABEL:
+            cost["heap"] += len(str(widget.get("label", "")).encode("utf-8"))
+        elif wtype == WIDGET_CLOCK:
+            if widget.get("clock_analog"):
+                cost["heap"] += 1500
+                cost["objects"] += 4
+                cost["image_bytes"] += w * h * 2
+        elif wtype == WIDGET_STAT_GRAPH:
+            cost["heap"] += widget.get("graph_points", GRAPH_POINTS_DEFAULT) * 2
+        elif wtype == WIDGET_REMOTE_IMAGE:
+            cost["image_bytes"] += w * h * 2
+        elif wtype == WIDGET_SCROLL_GRID:
+            cols = widget.get("grid_columns", 1) or 1
+            row_h = widget.get("grid_row_height", GRID_ROW_HEIGHT_DEFAULT) or GRID_ROW_HEIGHT_DEFAULT
+            rows = (len(widget.get("entries", [])) + cols - 1) // cols
+            pool = min((h + row_h - 1) // row_h + 1 + 2 * COST_GRID_OVERSCAN, rows)
+            cells = pool * cols
+            cell_w = (w - COST_GRID_CELL_GAP * (cols + 1)) // cols
+            cell_h = row_h - COST_GRID_CELL_GAP
+            cost["heap"] += cells * COST_GRID_CELL_HEAP
+            cost["objects"] += cells * COST_GRID_CELL_OBJECTS
+            if cols == 1:
+                cost["image_bytes"] += cells * icon_bytes(cell_h - 8, cell_h - 8)
+            else:
+                cost["image_bytes"] += cells * icon_bytes(cell_w * 6 // 10, cell_h - 32)
+    return cost
+
+
+def page_over_budget(cost: Dict[str, int], budget: Optional[Dict[str, Any]] = None) -> str:
+    """Which page budget `cost` is over ("" if none), as the firmware checks them."""
+    limits = (budget or {}).get("page", PAGE_BUDGET)
+    if cost["heap"] > limits["heap"]:
+        return f"needs {cost['heap'] // 1024} KB of LVGL heap (budget {limits['heap'] // 1024} KB)"
+    if cost["image_bytes"] > limits["image_bytes"]:
+        return (f"needs {cost['image_bytes'] // 1024} KB of decoded images "
+                f"(budget {limits['image_bytes'] // 1024} KB)")
+    if cost["render_us"] > limits["render_us"]:
+        return (f"takes ~{cost['render_us'] // 1000} ms to draw "
+                f"(budget {limits['render_us'] // 1000} ms)")
+    return ""
+
+
 class ConfigManager:
     """Manages in-memory AppConfig with JSON I/O and validation"""
 
     def __init__(self):
         self.config = {}
         self.config_changed_callback = None
+        self.generation = 0  # Bumped on every change; lets caches notice edits
+        self.device_budget = None  # budget_from_device() of the last display seen
         self.new_config()
 
     def new_config(self) -> None:
@@ -445,6 +800,7 @@ class ConfigManager:
             "default_mode": 0,
             "slideshow_interval_sec": 30,
             "clock_analog": False,
+            "clock_seconds": False,
             "profiles": [
                 {
                     "name": "Default",
@@ -457,6 +813,7 @@ class ConfigManager:
             ],
             "hardware_buttons": get_default_hardware_buttons(),
             "encoder": get_default_encoder(),
+            "gestures": get_default_gestures(),
             "mode_cycle": get_default_mode_cycle(),
             "display_settings": get_default_display_settings(),
         }
@@ -476,17 +833,21 @@ class ConfigManager:
             if version < 2:
                 data = _migrate_v1_config(data)
 
-            self.config = data
             # Ensure hardware config sections exist with defaults
-            if "hardware_buttons" not in self.config:
-                self.config["hardware_buttons"] = get_default_hardware_buttons()
-            if "encoder" not in self.config:
-                self.config["encoder"] = get_default_encoder()
-            if "mode_cycle" not in self.config:
-                self.config["mode_cycle"] = get_default_mode_cycle()
-            if "display_settings" not in self.config:
-                self.config["display_settings"] = get_default_display_settings()
-            ensure_widget_ids(self.config)
+            if "hardware_buttons" not in data:
+                data["hardware_buttons"] = get_default_hardware_buttons()
+            if "encoder" not in data:
+                data["encoder"] = get_default_encoder()
+            if "gestures" not in data:
+                data["gestures"] = get_default_gestures()
+            if "mode_cycle" not in data:
+                data["mode_cycle"] = get_default_mode_cycle()
+            if "display_settings" not in data:
+                data["display_settings"] = get_default_display_settings()
+            resolve_templates(data)
+            ensure_widget_ids(data)
+            # Only a finished config is ever visible (press lookups on other threads)
+            self.config = data
             self._emit_changed()
             return True
         except (json.JSONDecodeError, FileNotFoundError, IOError):
@@ -656,8 +1017,14 @@ class ConfigManager:
         """Serialize config dict to JSON string"""
         return json.dumps(self.config, indent=2)
 
-    def validate(self) -> tuple[bool, str]:
-        """Validate config structure. Returns (is_valid, error_message)."""
+    def validate(self, budget: Optional[Dict[str, Any]] = None) -> tuple[bool, str]:
+        """Validate config structure, and each active page against the
+        display's layout budgets (`budget` from budget_from_device(), else
+        the last device seen, else the firmware defaults). Returns
+        (is_valid, error_message)."""
+        budget = budget or self.device_budget
+        max_pages = (budget or {}).get("max_pages", CONFIG_MAX_PAGES)
+        max_widgets = (budget or {}).get("max_widgets", CONFIG_MAX_WIDGETS)
         # Check version
         if self.config.get("version") != CONFIG_VERSION:
             return False, f"Config version mismatch (got {self.config.get('version')}, expected {CONFIG_VERSION})"
@@ -675,6 +1042,10 @@ class ConfigManager:
         if not isinstance(clock_analog, bool):
             return False, "clock_analog must be a boolean"
 
+        clock_seconds = self.config.get("clock_seconds", False)
+        if not isinstance(clock_seconds, bool):
+            return False, "clock_seconds must be a boolean"
+
         # Check notification settings (optional)
         notifications_enabled = self.config.get("notifications_enabled", False)
         if not isinstance(notifications_enabled, bool):
@@ -692,6 +1063,13 @@ class ConfigManager:
         if not profiles:
             return False, "No profiles defined"
 
+        for profile in profiles:
+            display = profile.get("display")
+            if display is not None and (not isinstance(display, int) or
+                                        not 0 <= display < BRIDGE_MAX_DISPLAYS):
+                return False, (f"Profile '{profile.get('name', '')}': display must be "
+                               f"0-{BRIDGE_MAX_DISPLAYS - 1}")
+
         active_name = self.config.get("active_profile_name")
         active_profile = None
         for profile in profiles:
@@ -707,14 +1085,14 @@ class ConfigManager:
         if not pages:
             return False, "No pages in active profile"
 
-        if len(pages) > CONFIG_MAX_PAGES:
-            return False, f"Too many pages (max {CONFIG_MAX_PAGES})"
+        if len(pages) > max_pages:
+            return False, f"Too many pages (max {max_pages})"
 
         # Check widgets
         for pi, page in enumerate(pages):
             widgets = page.get("widgets", [])
-            if len(widgets) > CONFIG_MAX_WIDGETS:
-                return False, f"Page {pi} has too many widgets (max {CONFIG_MAX_WIDGETS})"
+            if len(widgets) > max_widgets:
+                return False, f"Page {pi} has too many widgets (max {max_widgets})"
 
             for wi, widget in enumerate(widgets):
                 # Validate widget type
@@ -747,6 +1125,26 @@ class ConfigManager:
                     at = widget.get("action_type", ACTION_HOTKEY)
                     if at not in VALID_ACTION_TYPES:
                         return False, f"Page {pi} widget {wi}: invalid action_type"
+                    if at == ACTION_MACRO:
+                        steps = widget.get("macro", [])
+                        if not isinstance(steps, list) or not steps:
+                            return False, f"Page {pi} widget {wi}: macro has no steps"
+                        for si, step in enumerate(steps):
+                            if not isinstance(step, dict) or step.get("op", "tap") not in MACRO_OPS:
+                                return False, f"Page {pi} widget {wi}: macro step {si} is invalid"
+                        if macro_step_count(steps) > MACRO_MAX_STEPS:
+                            return False, (f"Page {pi} widget {wi}: macro expands to "
+                                           f"{macro_step_count(steps)} steps (max {MACRO_MAX_STEPS})")
+                    if at == ACTION_TYPE_TEXT:
+                        text = widget.get("text", "")
+                        if not isinstance(text, str) or not text:
+                            return False, f"Page {pi} widget {wi}: type text has no text"
+                        if len(text.encode("utf-8")) > TYPE_TEXT_MAX_BYTES:
+                            return False, (f"Page {pi} widget {wi}: text is {len(text.encode('utf-8'))} "
+                                           f"bytes (max {TYPE_TEXT_MAX_BYTES} as UTF-8)")
+                        if str(widget.get("key_layout", "us")).lower() not in KEY_LAYOUTS:
+                            return False, (f"Page {pi} widget {wi}: key_layout must be one of "
+                                           f"{', '.join(KEY_LAYOUTS)}")
                     icon_source = widget.get("icon_source", "")
                     if icon_source and not isinstance(icon_source, str):
                         return False, f"Page {pi} widget {wi}: icon_source must be a string"
@@ -754,10 +1152,64 @@ class ConfigManager:
                     if icon_source_type and icon_source_type not in ("freedesktop", "file"):
                         return False, f"Page {pi} widget {wi}: icon_source_type must be 'freedesktop' or 'file'"
 
-                elif wtype == WIDGET_STAT_MONITOR:
+                elif wtype in (WIDGET_STAT_MONITOR, WIDGET_STAT_GRAPH):
                     st = widget.get("stat_type", 0)
                     if not isinstance(st, int) or st < STAT_TYPE_MIN or st > STAT_TYPE_MAX:
                         return False, f"Page {pi} widget {wi}: stat_type {st} out of range"
+                    rules = widget.get("rules", [])
+                    if not isinstance(rules, list) or len(rules) > STAT_RULES_MAX:
+                        return False, f"Page {pi} widget {wi}: rules must be a list of at most {STAT_RULES_MAX}"
+                    for rule in rules:
+                        if not isinstance(rule, dict) or not any(
+                                isinstance(rule.get(k), int) for k in ("above", "below")):
+                            return False, f"Page {pi} widget {wi}: each rule needs an integer 'above' or 'below'"
+                    remote = widget.get("remote_host", 0)
+                    if not isinstance(remote, int) or not 0 <= remote <= REMOTE_HOST_MAX:
+                        return False, f"Page {pi} widget {wi}: remote_host {remote} out of range (0-{REMOTE_HOST_MAX})"
+                    if wtype == WIDGET_STAT_GRAPH:
+                        points = widget.get("graph_points", GRAPH_POINTS_DEFAULT)
+                        if not isinstance(points, int) or not GRAPH_POINTS_MIN <= points <= GRAPH_POINTS_MAX:
+                            return False, (f"Page {pi} widget {wi}: graph_points {points} out of range "
+                                           f"({GRAPH_POINTS_MIN}-{GRAPH_POINTS_MAX})")
+                        gmax = widget.get("graph_max", 0)
+                        if not isinstance(gmax, int) or not 0 <= gmax <= 0xFFFF:
+                            return False, f"Page {pi} widget {wi}: graph_max {gmax} out of range"
+
+                elif wtype == WIDGET_TRACKPAD:
+                    speed = widget.get("trackpad_speed", TRACKPAD_SPEED_DEFAULT)
+                    if not isinstance(speed, int) or not TRACKPAD_SPEED_MIN <= speed <= TRACKPAD_SPEED_MAX:
+                        return False, (f"Page {pi} widget {wi}: trackpad_speed {speed} out of range "
+                                       f"({TRACKPAD_SPEED_MIN}-{TRACKPAD_SPEED_MAX})")
+
+                elif wtype == WIDGET_REMOTE_IMAGE:
+                    source = widget.get("image_source", "")
+                    if (not isinstance(source, str) or not source
+                            or len(source.encode("utf-8")) > REMOTE_IMAGE_SOURCE_MAX):
+                        return False, (f"Page {pi} widget {wi}: image_source must be 1-"
+                                       f"{REMOTE_IMAGE_SOURCE_MAX} bytes")
+
+                elif wtype == WIDGET_SCROLL_GRID:
+                    cols = widget.get("grid_columns", 1)
+                    if not isinstance(cols, int) or not 1 <= cols <= GRID_COLUMNS_MAX:
+                        return False, f"Page {pi} widget {wi}: grid_columns {cols} out of range (1-{GRID_COLUMNS_MAX})"
+                    row_h = widget.get("grid_row_height", GRID_ROW_HEIGHT_DEFAULT)
+                    if not isinstance(row_h, int) or not GRID_ROW_HEIGHT_MIN <= row_h <= GRID_ROW_HEIGHT_MAX:
+                        return False, (f"Page {pi} widget {wi}: grid_row_height {row_h} out of range "
+                                       f"({GRID_ROW_HEIGHT_MIN}-{GRID_ROW_HEIGHT_MAX})")
+                    entries = widget.get("entries", [])
+                    if not isinstance(entries, list) or len(entries) > GRID_ENTRIES_MAX:
+                        return False, f"Page {pi} widget {wi}: entries must be a list of at most {GRID_ENTRIES_MAX}"
+                    for ei, entry in enumerate(entries):
+                        if not isinstance(entry, dict) or not isinstance(entry.get("label", ""), str):
+                            return False, f"Page {pi} widget {wi}: entry {ei} is invalid"
+                        if entry.get("action_type", ACTION_LAUNCH_APP) not in VALID_ACTION_TYPES:
+                            return False, f"Page {pi} widget {wi}: entry {ei} has an invalid action_type"
+
+        # What each page costs the display (display/config_cost.h)
+        for pi, page in enumerate(pages):
+            over = page_over_budget(page_cost(page, budget), budget)
+            if over:
+                return False, f"Page {pi} ('{page.get('name', '')}') {over}"
 
         # Validate stats_header
         stats_header = self.config.get("stats_header", [])
@@ -802,6 +1254,7 @@ class ConfigManager:
 
     def _emit_changed(self) -> None:
         """Emit callback if registered"""
+        self.generation += 1
         if self.config_changed_callback:
             self.config_changed_callback()
 
@@ -13,6 +13,14 @@ epoch time sync with each stats update for the display clock.
 
 Usage:
     python3 hotkey_companion.py          # Run directly
+    python3 hotkey_companion.py --bench [--bench-rate HZ] [--bench-count N]
+                                         # End-to-end latency benchmark
+    python3 hotkey_companion.py --hw-bench [--hw-bench-label TEXT]
+                                         # Display hardware benchmark (config mode), stored
+    python3 hotkey_companion.py --hw-bench-list  # Stored hardware benchmark runs
+    python3 hotkey_companion.py --record NAME    # Record panel input to the display's SD card
+    python3 hotkey_companion.py --replay NAME [--replay-loops N]
+                                         # Replay it and print frame / flush / heap figures
     systemctl --user start hotkey-companion  # Run as service
 
 Dependencies:
@@ -20,6 +28,7 @@ Dependencies:
     pip install dbus-next  # Optional: for shutdown detection
 """
 
+import hashlib
 import hid
 import json
 import psutil
@@ -31,9 +40,22 @@ import logging
 import os
 import threading
 import asyncio
+import collections
+import argparse
+import queue
 
-from companion.action_executor import execute_action, execute_ddc_direct
+from companion.action_executor import ActionDispatcher, KeyPlayer, execute_action, execute_ddc_direct
 from companion.config_manager import get_config_manager, DEFAULT_CONFIG_DIR, DEFAULT_CONFIG_PATH
+from companion.bridge_device import (FragmentReassembler, write_vendor_message,
+                                     split_display, send_firmware, send_display_firmware,
+                                     send_remote_image,
+                                     BulkTransferError, BULK_ACK, BULK_OK, MSG_BULK_ACK,
+                                     MSG_FW_ACK, VENDOR_REPORT_SIZE, VENDOR_MAX_MESSAGE, HidWriter,
+                                     WRITE_CONTROL, WRITE_NOTIFY, WRITE_STATS, WRITE_BULK)
+from companion.wired_link import WiredDisplay, open_wired_display, WIRED_BAUD
+from companion.remote_stats import RemoteStatsPoller, load_remote_hosts
+from companion import lz_stream
+from companion.service_ipc import IpcServer, ServiceRunningError
 
 # ---------------------------------------------------------------------------
 # Constants
@@ -43,6 +65,11 @@ VENDOR_ID = 0x303A          # Espressif
 PRODUCT_ID = 0x1001         # CrowPanel HotkeyBridge
 PRODUCT_STRING = "HotkeyBridge"
 UPDATE_INTERVAL = 1.0       # Seconds between stat reports (1 Hz)
+STATS_PROFILE_INTERVAL = 60  # Seconds between --profile-stats cost reports
+LIVE_RATE_MIN = 10          # "stats_live" rate bounds (Hz)
+LIVE_RATE_MAX = 30
+KEYFRAME_INTERVAL = 4.0     # Full stats packet at least this often (display times out at 5 s)
+CONFIG_RELOAD_DEBOUNCE_S = 0.5  # Quiet time after the last config file event before reloading
 
 # Legacy StatsPayload format (v0.9.0 backwards compatibility)
 STATS_FORMAT = "<BBBBBBhh"  # 6 x uint8 + 2 x int16 = 10 bytes
@@ -75,12 +102,94 @@ DEFAULT_STATS_CONFIG = [
 ]
 
 # HID vendor message type prefixes (first byte after report ID)
+MSG_HOTKEY       = 0x01
 MSG_STATS        = 0x03
+MSG_MEDIA_KEY    = 0x04
 MSG_POWER_STATE  = 0x05
 MSG_TIME_SYNC    = 0x06
 MSG_NOTIFICATION = 0x08
 MSG_BUTTON_PRESS = 0x0B
 MSG_DDC_CMD      = 0x0C
+MSG_MACRO        = 0x0D
+MSG_PROFILE_SWITCH = 0x15
+MSG_ACTION_RESULT  = 0x16
+MSG_BENCH_START    = 0x17
+MSG_BENCH_PROBE    = 0x18
+MSG_BENCH_ECHO     = 0x19
+MSG_BENCH_REPORT   = 0x1A
+MSG_STATS_RATE     = 0x1B
+MSG_BRIDGE_STATS   = 0x1D
+MSG_DDC_STATE      = 0x25
+MSG_CLOCK_SYNC     = 0x26
+MSG_REPLAY         = 0x27
+MSG_REPLAY_REPORT  = 0x28
+MSG_TYPE_TEXT      = 0x29
+MSG_HOST_STATS     = 0x2A
+MSG_STATS_SUBSCRIBE = 0x2B
+
+# ButtonPressMsg trace fields after page/widget: press_id, display_ms, profile_index
+BUTTON_PRESS_TRACE = struct.Struct('<HIB')
+BUTTON_PRESS_ENTRY = struct.Struct('<H')   # Scroll grid entry, after the trace fields
+BUTTON_PRESS_NO_ENTRY = 0xFFFF
+# ActionResultMsg: press_id, status, display_ms, host_queue_us, host_exec_ms
+ACTION_RESULT = struct.Struct('<HBIHH')
+# DdcCmdMsg / DdcStateMsg: vcp_code, value, adjustment | max_value, display_num
+DDC_CMD = struct.Struct('<BHhB')
+DDC_STATE = struct.Struct('<BHHB')
+# flags, id, t1, t2, t3 (shared/clock_sync.h); the bridge asks, we answer in Unix us
+CLOCK_SYNC = struct.Struct('<BBqqq')
+CLOCK_F_REPLY = 0x01
+# Latency benchmark (shared/protocol.h MSG_BENCH_*)
+BENCH_START = struct.Struct('<HH')             # rate_hz, count
+BENCH_PROBE = struct.Struct('<HIII')           # id, display_us, bridge_rx_us, bridge_hid_us
+BENCH_ECHO_TAIL = struct.Struct('<II')         # host_us, bridge_echo_us (bridge fills)
+BENCH_REPORT = struct.Struct('<HHHIH5I5I')     # rate, sent, received, elapsed_ms, tput_x10, p50[5], p99[5]
+BENCH_STAGES = ("radio", "hid_queue", "usb", "host", "total")
+BENCH_MAX_PROBES = 2000
+# Input record / replay (shared/protocol.h MSG_REPLAY*)
+REPLAY_OP_RECORD, REPLAY_OP_STOP, REPLAY_OP_RUN = 0, 1, 2
+REPLAY_NAME_MAX = 24
+REPLAY_CMD = struct.Struct('<BB24s')           # op, loops, name
+# op, status, events, duration_ms, frames, frame p50/p99/max ms, frame_avg_us,
+# flushes, flush_px, flush_avg_us, heap_min_free, heap_delta, psram_min_free, name
+REPLAY_REPORT = struct.Struct('<BBHII3HIIIIIiI24s')
+REPLAY_STATUS = {0: "ok", 1: "SD card / file error", 2: "busy", 3: "bad name or recording", 4: "stopped"}
+# StatsRateMsg: interval_ms (0 = default), live (0 = pause live stats)
+STATS_RATE = struct.Struct('<HB')
+STATS_RATE_MAX_INTERVAL = 30.0  # Longest full-pass period a display may ask for (s)
+# StatsSubscribeMsg: bit N = StatType N is on the display's screen
+STATS_SUBSCRIBE = struct.Struct('<I')
+# BridgeStatsMsg: uptime_ms, ESP-NOW rx frames/bytes, tx frames/bytes/failed,
+# RX queue drops/high-water/size, hid_reports, vendor rx/tx B/s, loop avg/max us,
+# rssi_dbm, free_heap, radio channel
+BRIDGE_STATS = struct.Struct('<7IBB3IHIbIB')
+# ... then, from bridges with the USB/radio task split: radio task avg/max us,
+# USB->radio and radio->USB ring high-water, ring size, ring-full counts
+BRIDGE_STATS_PIPE = struct.Struct('<HIBBBII')
+# ... then loop() stalls since boot, the latest stall's longest section
+# (index into BRIDGE_LOOP_SECTIONS, 0xFF = none) and its pass us
+BRIDGE_STATS_STALL = struct.Struct('<IBI')
+# ... then messages sent batched (several per MSG_BATCH frame) since boot
+BRIDGE_STATS_BATCH = struct.Struct('<I')
+# ... then link adaptation: TX power (0.25 dBm), PHY rate step, the weakest
+# display's RSSI of the bridge (0 = none), latest change's reason (0xFF =
+# none) and changes since boot
+BRIDGE_STATS_ADAPT = struct.Struct('<bBbBI')
+ADAPT_REASONS = ("strong", "weak", "lossy", "reset")   # shared/link_adapt.h LinkAdaptReason
+BRIDGE_LOOP_SECTIONS = ("vendor_rx", "usb_jobs", "hid", "fw_update", "console", "led",
+                        "stats", "clock")   # bridge/main.cpp LoopSection order
+BRIDGE_STATS_HISTORY = 300      # Samples kept for the tray graphs (5 min at 1 Hz)
+
+# Profile name field of ProfileSwitchMsg (shared/protocol.h)
+PROFILE_NAME_MAX = 32
+
+# Seconds between focused-window checks (profile_follow_focus)
+FOCUS_POLL_INTERVAL = 0.5
+
+# Seconds between remote image source polls (WIDGET_REMOTE_IMAGE)
+REMOTE_IMAGE_INTERVAL = 1.0
+REMOTE_IMAGE_BACKOFF = 30.0   # After a display that never answers (no image support)
+WIDGET_REMOTE_IMAGE = 9       # config_manager / display/config.h
 
 # Power state values
 POWER_SHUTDOWN = 0
@@ -90,12 +199,18 @@ POWER_LOCKED   = 2
 # Retry interval when bridge is not found
 RETRY_INTERVAL = 5.0
 
+BULK_WRITE_TIMEOUT = 5.0      # Bulk chunk waiting for the HID writer (s)
+WRITER_LOG_INTERVAL = 60.0    # Period of the HID writer latency summary (debug log)
+
 # ---------------------------------------------------------------------------
 # Globals
 # ---------------------------------------------------------------------------
 
 running = True
 shutdown_event = threading.Event()
+sleep_event = threading.Event()         # PrepareForSleep(True): tell the display before suspending
+sleep_sent_event = threading.Event()    # ... done, the sleep inhibitor can go
+resume_event = threading.Event()        # PrepareForSleep(False)
 lock_event = threading.Event()
 unlock_event = threading.Event()
 
@@ -134,6 +249,11 @@ async def start_dbus_shutdown_listener():
     thread can send MSG_POWER_STATE to the bridge, then releases the
     inhibitor lock to allow shutdown to proceed.
 
+    PrepareForSleep works the same way with a sleep inhibitor (taken again
+    after every resume): sleep_event before suspending, resume_event after,
+    so the display shows its clock while the PC sleeps and the bridge can
+    time a wake the display asked for (MSG_WAKE_HOST).
+
     Gracefully degrades if dbus-next is not installed or the system bus
     is unavailable.
     """
@@ -189,6 +309,42 @@ async def start_dbus_shutdown_listener():
                     pass
 
         manager.on_prepare_for_shutdown(on_prepare_for_shutdown)
+
+        sleep_fd = None
+
+        async def take_sleep_lock():
+            nonlocal sleep_fd
+            try:
+                fd = await manager.call_inhibit(
+                    "sleep", "HotkeyCompanion", "Telling the display the PC sleeps", "delay")
+                sleep_fd = fd.fileno() if hasattr(fd, 'fileno') else fd
+            except Exception as exc:
+                logging.warning("Sleep inhibitor lock not taken: %s", exc)
+
+        async def release_sleep_lock():
+            nonlocal sleep_fd
+            # Give the main loop a moment to get POWER_SHUTDOWN out
+            await asyncio.get_running_loop().run_in_executor(None, sleep_sent_event.wait, 2.0)
+            if sleep_fd is not None:
+                try:
+                    os.close(sleep_fd)
+                except OSError:
+                    pass
+                sleep_fd = None
+
+        def on_prepare_for_sleep(start):
+            if start:
+                logging.info("PrepareForSleep(True) received")
+                sleep_sent_event.clear()
+                sleep_event.set()
+                asyncio.ensure_future(release_sleep_lock())
+            else:
+                logging.info("PrepareForSleep(False) received")
+                resume_event.set()
+                asyncio.ensure_future(take_sleep_lock())
+
+        await take_sleep_lock()
+        manager.on_prepare_for_sleep(on_prepare_for_sleep)
         logging.info("D-Bus shutdown listener active")
 
         await bus.wait_for_disconnect()
@@ -376,10 +532,15 @@ class NotificationListener:
                         app_name = str(args[0])
                         summary = str(args[3])
                         body = str(args[4])
+                        urgency = 1
+                        if len(args) >= 7 and isinstance(args[6], dict):
+                            hint = args[6].get('urgency')
+                            if hint is not None:
+                                urgency = int(getattr(hint, 'value', hint))
                         if not self.app_filter or app_name in self.app_filter:
                             logging.info("Forwarding notification: %s - %s", app_name, summary)
                             try:
-                                self.callback(app_name, summary, body)
+                                self.callback(app_name, summary, body, urgency)
                             except Exception as exc:
                                 logging.debug("Notification callback error: %s", exc)
 
@@ -404,26 +565,67 @@ def _run_notification_listener(app_filter, callback):
         loop.close()
 
 
-def send_notification_to_display(device, app_name, summary, body, hid_lock=None):
-    """Encode and send a MSG_NOTIFICATION payload to the bridge.
+# freedesktop urgency hint (0 low, 1 normal, 2 critical) -> NotifUrgency
+NOTIF_URGENCY = {0: 1, 1: 0, 2: 2}
+
+# Compact notifications (must match shared/protocol.h)
+NOTIF_COMPACT = struct.Struct('<BBBBBB')   # mark, flags, urgency, app_len, summary_len, text_len
+NOTIF_COMPACT_MARK = 0x01
+NOTIF_F_LZ = 0x01
+NOTIF_APP_MAX = 32            # Field sizes on the display, terminator included
+NOTIF_SUMMARY_MAX = 100
+NOTIF_BODY_MAX = 400
+NOTIF_PAYLOAD_MAX = 250       # PROTO_MAX_PAYLOAD
+
+
+def _send(device, writer, cls, msg_type, payload=b"", display=None):
+    """Queue on `writer` (a HidWriter, by message class) when given, else write
+    to `device` right away. `payload` may be a callable (HidWriter.submit)."""
+    if writer is not None:
+        return writer.submit(cls, msg_type, payload, display)
+    write_vendor_message(device, msg_type, payload() if callable(payload) else payload, display)
+    return True
+
+
+def _utf8_cut(text, limit):
+    """`text` as UTF-8, cut to at most `limit` bytes on a character boundary."""
+    return text.encode('utf-8')[:limit].decode('utf-8', 'ignore').encode('utf-8')
 
-    NotificationMsg: app_name[32] + summary[100] + body[116] = 248 bytes.
-    Packet: [0x00 report ID] [0x08 MSG_NOTIFICATION] [248-byte payload]
+
+def encode_notification(app_name, summary, body, urgency=1):
+    """The compact MSG_NOTIFICATION payload (protocol.h, NotifCompactHdr).
+
+    app_name, summary and body go back to back, LZ-compressed when that is
+    shorter; a body too long for one payload even then is cut to fit.
     """
-    app_bytes = app_name.encode('utf-8')[:31] + b'\x00'
-    sum_bytes = summary.encode('utf-8')[:99] + b'\x00'
-    body_bytes = body.encode('utf-8')[:115] + b'\x00'
+    app = _utf8_cut(app_name, NOTIF_APP_MAX - 1)
+    title = _utf8_cut(summary, NOTIF_SUMMARY_MAX - 1)
+    body_limit = NOTIF_BODY_MAX - 1
+    room = NOTIF_PAYLOAD_MAX - NOTIF_COMPACT.size
+    while True:
+        text = app + title + _utf8_cut(body, body_limit)
+        packed = lz_stream.compress(text)
+        flags = NOTIF_F_LZ if len(packed) < len(text) else 0
+        if not flags:
+            packed = text
+        if len(packed) <= room or body_limit == 0:   # App and summary alone always fit
+            break
+        body_limit = max(body_limit - (len(packed) - room) - 4, 0)
+    return NOTIF_COMPACT.pack(NOTIF_COMPACT_MARK, flags, NOTIF_URGENCY.get(urgency, 0),
+                              len(app), len(title), len(packed)) + packed
 
-    payload = (app_bytes.ljust(32, b'\x00') +
-               sum_bytes.ljust(100, b'\x00') +
-               body_bytes.ljust(116, b'\x00'))
 
+def send_notification_to_display(device, app_name, summary, body, urgency=1, writer=None):
+    """Encode and send a MSG_NOTIFICATION payload to the bridge.
+
+    Compact form (encode_notification): a short notification fits one
+    vendor report, a long one is sent as MSG_FRAGMENT reports and
+    reassembled by the bridge, which expands it into the fixed 248-byte
+    NotificationMsg for displays without PROTO_CAP_COMPRESS.
+    """
+    payload = encode_notification(app_name, summary, body, urgency)
     try:
-        if hid_lock:
-            with hid_lock:
-                device.write(b"\x06" + bytes([MSG_NOTIFICATION]) + payload)
-        else:
-            device.write(b"\x06" + bytes([MSG_NOTIFICATION]) + payload)
+        _send(device, writer, WRITE_NOTIFY, MSG_NOTIFICATION, payload)
     except (IOError, OSError) as exc:
         logging.debug("Failed to send notification: %s", exc)
 
@@ -462,6 +664,88 @@ def load_follow_lock_config(config_path=None):
     return True
 
 
+def load_focus_profile_config(config_path=None):
+    """Load the focus-following profile map from config.json.
+
+    Enabled by "profile_follow_focus": true. Each profile may list
+    "match_apps": WM_CLASS names (case-insensitive) that select it; windows
+    matching none select the config's active_profile_name. A profile with
+    "display": <id> is only switched on that display of a multi-display
+    bridge; the others keep what they show.
+
+    Returns (enabled: bool, default_profile: str, {wm_class_lower: profile_name},
+    {profile_name: display id}).
+    """
+    if config_path and os.path.isfile(config_path):
+        try:
+            with open(config_path, "r") as f:
+                data = json.load(f)
+            app_map = {}
+            displays = {}
+            for profile in data.get("profiles", []):
+                for wm_class in profile.get("match_apps", []) or []:
+                    app_map.setdefault(str(wm_class).lower(), profile.get("name", ""))
+                if isinstance(profile.get("display"), int):
+                    displays[profile.get("name", "")] = profile["display"]
+            enabled = bool(data.get("profile_follow_focus", False)) and bool(app_map)
+            return enabled, data.get("active_profile_name", ""), app_map, displays
+        except (json.JSONDecodeError, IOError) as exc:
+            logging.warning("Failed to load focus profile config: %s", exc)
+    return False, "", {}, {}
+
+
+def send_profile_switch(device, profile_name, writer=None, display=None):
+    """Send a MSG_PROFILE_SWITCH message asking the display to activate a profile.
+
+    Packet: [0x00 report ID] [0x15 MSG_PROFILE_SWITCH] [name, NUL-padded to 32 bytes]
+    display=None switches every display on the bridge.
+    """
+    name = profile_name.encode("utf-8")[:PROFILE_NAME_MAX - 1]
+    payload = name.ljust(PROFILE_NAME_MAX, b"\x00")
+    try:
+        if not _send(device, writer, WRITE_CONTROL, MSG_PROFILE_SWITCH, payload, display):
+            return False
+        logging.info("Sent profile switch: %s%s", profile_name,
+                     "" if display is None else f" (display {display})")
+        return True
+    except (IOError, OSError) as exc:
+        logging.debug("Failed to send profile switch: %s", exc)
+        return False
+
+
+def send_action_result(device, press_id, status, display_ms, queue_s, exec_s, writer=None,
+                       display=None):
+    """Tell the display a traced button press has been executed.
+
+    Packet: [0x00 report ID] [0x16 MSG_ACTION_RESULT] [ActionResultMsg]
+    Host timings saturate at the u16 field limits. display: the display
+    the press came from (None = all).
+    """
+    payload = ACTION_RESULT.pack(press_id, status, display_ms,
+                                 min(int(queue_s * 1e6), 0xFFFF),
+                                 min(int(exec_s * 1e3), 0xFFFF))
+    try:
+        return _send(device, writer, WRITE_CONTROL, MSG_ACTION_RESULT, payload, display)
+    except (IOError, OSError) as exc:
+        logging.debug("Failed to send action result: %s", exc)
+        return False
+
+
+def send_ddc_state(device, vcp_code, value, max_value, display_num, writer=None,
+                   display=None):
+    """Tell the display where a DDC/CI control landed after a MSG_DDC_CMD.
+
+    Packet: [0x00 report ID] [0x25 MSG_DDC_STATE] [DdcStateMsg]
+    display: the display the command came from (None = all).
+    """
+    payload = DDC_STATE.pack(vcp_code, min(value, 0xFFFF), min(max_value, 0xFFFF), display_num)
+    try:
+        return _send(device, writer, WRITE_CONTROL, MSG_DDC_STATE, payload, display)
+    except (IOError, OSError) as exc:
+        logging.debug("Failed to send DDC state: %s", exc)
+        return False
+
+
 # ---------------------------------------------------------------------------
 # Vendor HID read thread
 # ---------------------------------------------------------------------------
@@ -469,12 +753,19 @@ def load_follow_lock_config(config_path=None):
 def _vendor_read_thread(device, hid_lock, config_mgr):
     """Background thread: reads vendor HID input reports from bridge."""
     global running
+    reassembler = FragmentReassembler()
     while running:
         try:
             with hid_lock:
-                data = device.read(63, timeout=100)
+                report = device.read(1 + VENDOR_REPORT_SIZE, timeout=100)
+            received_us = time.time_ns() // 1000
+            # report[0] is the HID report ID (0x06); data keeps the same
+            # layout for reassembled messages: [id][type][payload...]
+            message = reassembler.feed(report[1:]) if report else None
+            if message:
+                _, message = split_display(message)
+            data = [report[0]] + list(message) if message else None
             if data and len(data) >= 4:
-                # data[0] is the HID report ID (0x06), actual payload starts at data[1]
                 msg_type = data[1]
                 if msg_type == MSG_BUTTON_PRESS:
                     page_idx = data[2]
@@ -486,18 +777,15 @@ def _vendor_read_thread(device, hid_lock, config_mgr):
                         args=(config_mgr, page_idx, widget_idx),
                         daemon=True
                     ).start()
-                elif msg_type == MSG_DDC_CMD and len(data) >= 8:
-                    vcp_code = data[2]
-                    value = struct.unpack_from('<H', bytes(data), 3)[0]
-                    adjustment = struct.unpack_from('<h', bytes(data), 5)[0]
-                    display_num = data[7]
+                elif msg_type == MSG_DDC_CMD and len(data) >= 2 + DDC_CMD.size:
+                    vcp_code, value, adjustment, display_num = DDC_CMD.unpack_from(bytes(data), 2)
                     logging.info("DDC cmd: vcp=0x%02X val=%d adj=%d disp=%d",
                                  vcp_code, value, adjustment, display_num)
-                    threading.Thread(
-                        target=execute_ddc_direct,
-                        args=(vcp_code, value, adjustment, display_num),
-                        daemon=True
-                    ).start()
+                    # Queued and merged; the result goes back to the display
+                    execute_ddc_direct(vcp_code, value, adjustment, display_num,
+                                       lambda *st: send_ddc_state(device, *st))
+                elif msg_type == MSG_CLOCK_SYNC and len(data) >= 2 + CLOCK_SYNC.size:
+                    answer_clock_sync(device, bytes(data[2:2 + CLOCK_SYNC.size]), received_us)
         except (IOError, OSError):
             logging.warning("Vendor HID read error, device may have disconnected")
             break
@@ -509,8 +797,14 @@ def _vendor_read_thread(device, hid_lock, config_mgr):
 # Config file watcher
 # ---------------------------------------------------------------------------
 
-def _start_config_watcher(config_path, config_mgr):
-    """Start watching config file for changes, reload on modification."""
+def _start_config_watcher(config_path, config_mgr, on_reload=None):
+    """Start watching config file for changes, reload on modification.
+
+    Bursts of events (an editor's write + rename, quick saves) collapse into
+    one reload CONFIG_RELOAD_DEBOUNCE_S after the last, and a file whose
+    bytes are unchanged is not reloaded at all. on_reload() runs on the
+    timer thread after each reload that took.
+    """
     try:
         from watchdog.observers import Observer
         from watchdog.events import FileSystemEventHandler
@@ -519,21 +813,49 @@ def _start_config_watcher(config_path, config_mgr):
                        "Install with: pip install watchdog")
         return None
 
+    target = os.path.abspath(config_path)
+
+    def file_digest():
+        try:
+            with open(target, "rb") as f:
+                return hashlib.sha1(f.read()).digest()
+        except OSError:
+            return None
+
     class ConfigReloadHandler(FileSystemEventHandler):
         def __init__(self):
             self._timer = None
-            self._debounce_sec = 0.5
+            self._lock = threading.Lock()
+            self._digest = file_digest()   # What the companion loaded at start
 
-        def on_modified(self, event):
-            if os.path.abspath(event.src_path) == os.path.abspath(config_path):
+        def _schedule(self, path):
+            if os.path.abspath(path) != target:
+                return
+            with self._lock:
                 if self._timer:
                     self._timer.cancel()
-                self._timer = threading.Timer(self._debounce_sec, self._reload)
+                self._timer = threading.Timer(CONFIG_RELOAD_DEBOUNCE_S, self._reload)
+                self._timer.daemon = True
                 self._timer.start()
 
+        def on_modified(self, event):
+            self._schedule(event.src_path)
+
+        def on_created(self, event):
+            self._schedule(event.src_path)
+
+        def on_moved(self, event):
+            self._schedule(event.dest_path)   # Saved as a temp file, renamed over
+
         def _reload(self):
+            digest = file_digest()
+            if digest is None or digest == self._digest:
+                return
             if config_mgr.load_json_file(config_path):
+                self._digest = digest
                 logging.info("Config reloaded from %s", config_path)
+                if on_reload:
+                    on_reload()
             else:
                 logging.warning("Config reload failed from %s", config_path)
 
@@ -550,15 +872,17 @@ def _start_config_watcher(config_path, config_mgr):
 # Power state and time sync helpers
 # ---------------------------------------------------------------------------
 
-def send_power_state(device, state, hid_lock=None):
+def send_power_state(device, state, writer=None, wait=None):
     """Send a MSG_POWER_STATE message to the bridge.
 
     Packet: [0x00 report ID] [0x05 MSG_POWER_STATE] [state byte]
+    wait: seconds to wait for the writer to get it out (shutdown).
     """
     try:
-        if hid_lock:
-            with hid_lock:
-                device.write(b"\x06" + bytes([MSG_POWER_STATE, state]))
+        if writer is not None:
+            if not writer.submit(WRITE_CONTROL, MSG_POWER_STATE, bytes([state]), wait=wait):
+                logging.warning("Failed to send power state 0x%02X", state)
+                return
         else:
             device.write(b"\x06" + bytes([MSG_POWER_STATE, state]))
         state_names = {POWER_SHUTDOWN: "SHUTDOWN", POWER_WAKE: "WAKE", POWER_LOCKED: "LOCKED"}
@@ -567,7 +891,24 @@ def send_power_state(device, state, hid_lock=None):
         logging.warning("Failed to send power state: %s", exc)
 
 
-def send_time_sync(device, hid_lock=None):
+def answer_clock_sync(device, payload, t2_us, writer=None):
+    """Answer the bridge's MSG_CLOCK_SYNC request: the host wall clock is the
+    shared timebase every unit's trace timestamps are mapped onto.
+
+    t2_us is taken right after the read returned; t3 right before the write
+    (the writer builds the reply), so neither side counts our own queueing.
+    """
+    flags, xid, t1, _, _ = CLOCK_SYNC.unpack_from(payload)
+    if flags & CLOCK_F_REPLY:
+        return
+    try:
+        _send(device, writer, WRITE_CONTROL, MSG_CLOCK_SYNC,
+              lambda: CLOCK_SYNC.pack(CLOCK_F_REPLY, xid, t1, t2_us, time.time_ns() // 1000))
+    except (IOError, OSError) as exc:
+        logging.debug("Failed to answer clock sync: %s", exc)
+
+
+def send_time_sync(device, writer=None):
     """Send a MSG_TIME_SYNC message with current epoch seconds and timezone offset.
 
     Packet: [0x00 report ID] [0x06 MSG_TIME_SYNC] [uint32 LE epoch] [int16 LE tz_offset_min]
@@ -579,11 +920,7 @@ def send_time_sync(device, hid_lock=None):
     tz_offset_min = int(local_dt.utcoffset().total_seconds() // 60)
     payload = struct.pack("<Ih", epoch, tz_offset_min)
     try:
-        if hid_lock:
-            with hid_lock:
-                device.write(b"\x06" + bytes([MSG_TIME_SYNC]) + payload)
-        else:
-            device.write(b"\x06" + bytes([MSG_TIME_SYNC]) + payload)
+        _send(device, writer, WRITE_CONTROL, MSG_TIME_SYNC, payload)
     except (IOError, OSError) as exc:
         logging.debug("Failed to send time sync: %s", exc)
 
@@ -597,13 +934,32 @@ class GPUCollector:
 
     Tries NVIDIA (pynvml) first, then AMD (sysfs). If neither is
     available, returns 0xFF for both metrics.
+
+    Every source stays open between samples so a read costs microseconds
+    and the live rate (10-30 Hz) is affordable: NVML keeps its device
+    handle, the nvidia-smi fallback is one long-running
+    ``nvidia-smi --loop-ms`` stream parsed by a reader thread (collect()
+    returns its latest line), and the AMD sysfs files are held open and
+    re-read with pread().
     """
 
-    def __init__(self):
+    # One CSV line per sample: collect() and collect_extended() fields
+    _SMI_QUERY = "utilization.gpu,temperature.gpu,memory.used,memory.total,power.draw,clocks.gr"
+    _SMI_RESTART_S = 5.0      # Back-off before restarting a stream that exited
+    _SMI_STALE_SAMPLES = 3    # Samples missed before the values read as unavailable
+
+    def __init__(self, sample_hz=1):
         self.gpu_type = None  # 'nvidia', 'amd', or None
+        self._nvml = None
         self._nvml_handle = None
-        self._amd_gpu_busy_path = None
-        self._amd_temp_path = None
+        self._amd_busy_fd = None
+        self._amd_temp_fd = None
+        self._sample_hz = max(1, int(sample_hz))
+        self._smi_lock = threading.Lock()
+        self._smi_proc = None
+        self._smi_sample = None      # (monotonic time, (pct, temp, mem_pct, power_w, freq))
+        self._smi_restart_at = 0.0
+        self._closed = False
         self._init_nvidia()
         if self.gpu_type is None:
             self._init_amd()
@@ -619,6 +975,7 @@ class GPUCollector:
             if isinstance(name, bytes):
                 name = name.decode()
             logging.info("NVIDIA GPU detected (pynvml): %s", name)
+            self._nvml = pynvml
             self.gpu_type = "nvidia"
         except ImportError:
             logging.debug("pynvml not installed, trying nvidia-smi fallback")
@@ -628,7 +985,7 @@ class GPUCollector:
             self._init_nvidia_smi()
 
     def _init_nvidia_smi(self):
-        """Fallback: detect NVIDIA GPU via nvidia-smi subprocess."""
+        """Fallback: detect NVIDIA GPU via nvidia-smi, then start its sample stream."""
         import subprocess
         try:
             result = subprocess.run(
@@ -639,6 +996,7 @@ class GPUCollector:
                 name = result.stdout.strip().split('\n')[0]
                 logging.info("NVIDIA GPU detected (nvidia-smi): %s", name)
                 self.gpu_type = "nvidia-smi"
+                self._start_smi_stream()
             else:
                 logging.debug("nvidia-smi returned no GPU")
         except FileNotFoundError:
@@ -649,72 +1007,172 @@ class GPUCollector:
     def _init_amd(self):
         gpu_busy = "/sys/class/drm/card0/device/gpu_busy_percent"
         if os.path.isfile(gpu_busy):
-            self._amd_gpu_busy_path = gpu_busy
+            self._amd_busy_fd = self._open_sysfs(gpu_busy)
             # Find hwmon temperature file
             hwmon_base = "/sys/class/drm/card0/device/hwmon"
             if os.path.isdir(hwmon_base):
                 for entry in os.listdir(hwmon_base):
                     temp_path = os.path.join(hwmon_base, entry, "temp1_input")
                     if os.path.isfile(temp_path):
-                        self._amd_temp_path = temp_path
+                        self._amd_temp_fd = self._open_sysfs(temp_path)
                         break
             logging.info("AMD GPU detected (sysfs)")
             self.gpu_type = "amd"
 
+    @staticmethod
+    def _open_sysfs(path):
+        try:
+            return os.open(path, os.O_RDONLY)
+        except OSError as exc:
+            logging.debug("Can't open %s: %s", path, exc)
+            return None
+
+    @staticmethod
+    def _read_sysfs_int(fd):
+        # sysfs regenerates the value on every read from offset 0
+        return int(os.pread(fd, 32, 0))
+
+    def set_sample_rate(self, hz):
+        """Rate collect() is called at; restarts the nvidia-smi stream to match."""
+        hz = max(1, int(hz))
+        if hz == self._sample_hz:
+            return
+        self._sample_hz = hz
+        if self.gpu_type == "nvidia-smi":
+            self._stop_smi_stream()
+            self._start_smi_stream()
+
+    def close(self):
+        """Stop the nvidia-smi stream and close the sysfs files."""
+        self._closed = True
+        self._stop_smi_stream()
+        for fd in (self._amd_busy_fd, self._amd_temp_fd):
+            if fd is not None:
+                try:
+                    os.close(fd)
+                except OSError:
+                    pass
+        self._amd_busy_fd = self._amd_temp_fd = None
+
+    # -- nvidia-smi stream ------------------------------------------------
+
+    def _start_smi_stream(self):
+        import subprocess
+        interval_ms = max(1, 1000 // self._sample_hz)
+        try:
+            proc = subprocess.Popen(
+                ["nvidia-smi", f"--query-gpu={self._SMI_QUERY}", "--format=csv,noheader,nounits",
+                 "--id=0", f"--loop-ms={interval_ms}"],
+                stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, text=True, bufsize=1
+            )
+        except Exception as exc:
+            logging.warning("nvidia-smi stream failed to start: %s", exc)
+            self._smi_restart_at = time.monotonic() + self._SMI_RESTART_S
+            return
+        with self._smi_lock:
+            self._smi_proc = proc
+        threading.Thread(target=self._smi_reader, args=(proc,), name="nvidia-smi",
+                         daemon=True).start()
+        logging.debug("nvidia-smi stream started (%d ms)", interval_ms)
+
+    def _stop_smi_stream(self):
+        with self._smi_lock:
+            proc, self._smi_proc = self._smi_proc, None
+            self._smi_sample = None
+        if proc is not None:
+            try:
+                proc.terminate()
+                proc.wait(timeout=2)
+            except Exception:
+                proc.kill()
+
+    def _smi_reader(self, proc):
+        for line in proc.stdout:
+            sample = self._parse_smi_line(line)
+            if sample is not None:
+                with self._smi_lock:
+                    if proc is self._smi_proc:
+                        self._smi_sample = (time.monotonic(), sample)
+        # EOF: nvidia-smi exited (driver reload, crash) unless we stopped it
+        with self._smi_lock:
+            if proc is not self._smi_proc:
+                return
+            self._smi_proc = None
+            self._smi_restart_at = time.monotonic() + self._SMI_RESTART_S
+        if not self._closed:
+            logging.warning("nvidia-smi stream exited (%s), restarting in %.0f s",
+                            proc.poll(), self._SMI_RESTART_S)
+
+    @staticmethod
+    def _parse_smi_line(line):
+        """(pct, temp, mem_pct, power_w, freq) from one CSV line, None if unparsable."""
+        parts = [p.strip() for p in line.split(',')]
+        if len(parts) < 6:
+            return None
+
+        def num(text):
+            try:
+                return float(text)
+            except ValueError:
+                return None  # "[N/A]" and friends
+
+        util, temp, mem_used, mem_total, power, clock = (num(p) for p in parts[:6])
+        if util is None or temp is None:
+            return None
+        gpu_mem_pct = (min(int(mem_used * 100 / mem_total), 100)
+                       if mem_used is not None and mem_total else 0xFF)
+        gpu_power_w = min(int(power), 0xFFFF) if power is not None else 0
+        gpu_freq_mhz = min(int(clock), 0xFFFF) if clock is not None else 0
+        return (min(int(util), 100), min(int(temp), 254), gpu_mem_pct, gpu_power_w, gpu_freq_mhz)
+
+    def _smi_latest(self):
+        """Latest stream sample, or None while it is stale / restarting."""
+        now = time.monotonic()
+        with self._smi_lock:
+            proc, sample = self._smi_proc, self._smi_sample
+        if proc is None and not self._closed and now >= self._smi_restart_at:
+            self._start_smi_stream()
+        if sample is None:
+            return None
+        max_age = max(self._SMI_STALE_SAMPLES / self._sample_hz, 3.0)
+        return sample[1] if now - sample[0] <= max_age else None
+
+    # -- collection -------------------------------------------------------
+
     def collect(self):
         """Return (gpu_percent, gpu_temp) as ints. 0xFF if unavailable."""
         if self.gpu_type == "nvidia":
             return self._collect_nvidia()
         elif self.gpu_type == "nvidia-smi":
-            return self._collect_nvidia_smi()
+            sample = self._smi_latest()
+            return sample[:2] if sample else (0xFF, 0xFF)
         elif self.gpu_type == "amd":
             return self._collect_amd()
         return (0xFF, 0xFF)
 
     def _collect_nvidia(self):
         try:
-            import pynvml
-            util = pynvml.nvmlDeviceGetUtilizationRates(self._nvml_handle)
-            temp = pynvml.nvmlDeviceGetTemperature(
-                self._nvml_handle, pynvml.NVML_TEMPERATURE_GPU
-            )
+            nvml = self._nvml
+            util = nvml.nvmlDeviceGetUtilizationRates(self._nvml_handle)
+            temp = nvml.nvmlDeviceGetTemperature(self._nvml_handle, nvml.NVML_TEMPERATURE_GPU)
             return (min(int(util.gpu), 100), min(int(temp), 254))
         except Exception as exc:
             logging.debug("NVIDIA read failed: %s", exc)
             return (0xFF, 0xFF)
 
-    def _collect_nvidia_smi(self):
-        """Collect GPU stats via nvidia-smi subprocess."""
-        import subprocess
-        try:
-            result = subprocess.run(
-                ["nvidia-smi", "--query-gpu=utilization.gpu,temperature.gpu",
-                 "--format=csv,noheader,nounits"],
-                capture_output=True, text=True, timeout=5
-            )
-            if result.returncode == 0 and result.stdout.strip():
-                parts = result.stdout.strip().split(',')
-                gpu_pct = min(int(parts[0].strip()), 100)
-                gpu_temp = min(int(parts[1].strip()), 254)
-                return (gpu_pct, gpu_temp)
-        except Exception as exc:
-            logging.debug("nvidia-smi collect failed: %s", exc)
-        return (0xFF, 0xFF)
-
     def _collect_amd(self):
         gpu_percent = 0xFF
         gpu_temp = 0xFF
-        try:
-            with open(self._amd_gpu_busy_path) as f:
-                gpu_percent = min(int(f.read().strip()), 100)
-        except Exception:
-            pass
-        if self._amd_temp_path:
+        if self._amd_busy_fd is not None:
             try:
-                with open(self._amd_temp_path) as f:
-                    # sysfs reports millidegrees
-                    gpu_temp = min(int(f.read().strip()) // 1000, 254)
-            except Exception:
+                gpu_percent = min(self._read_sysfs_int(self._amd_busy_fd), 100)
+            except (OSError, ValueError):
+                pass
+        if self._amd_temp_fd is not None:
+            try:
+                # sysfs reports millidegrees
+                gpu_temp = min(round(self._read_sysfs_int(self._amd_temp_fd) / 1000, 1), 254)
+            except (OSError, ValueError):
                 pass
         return (gpu_percent, gpu_temp)
 
@@ -724,23 +1182,24 @@ class GPUCollector:
         Returns (0xFF, 0, 0) if not NVIDIA or on error.
         """
         if self.gpu_type == "nvidia-smi":
-            return self._collect_extended_nvidia_smi()
+            sample = self._smi_latest()
+            return sample[2:] if sample else (0xFF, 0, 0)
         if self.gpu_type != "nvidia":
             return (0xFF, 0, 0)
         try:
-            import pynvml
+            nvml = self._nvml
             # GPU memory
-            mem = pynvml.nvmlDeviceGetMemoryInfo(self._nvml_handle)
+            mem = nvml.nvmlDeviceGetMemoryInfo(self._nvml_handle)
             gpu_mem_pct = min(int(mem.used * 100 / mem.total), 100) if mem.total > 0 else 0xFF
             # GPU power
             try:
-                power_mw = pynvml.nvmlDeviceGetPowerUsage(self._nvml_handle)
+                power_mw = nvml.nvmlDeviceGetPowerUsage(self._nvml_handle)
                 gpu_power_w = min(int(power_mw / 1000), 0xFFFF)
             except Exception:
                 gpu_power_w = 0
             # GPU clock
             try:
-                clock = pynvml.nvmlDeviceGetClockInfo(self._nvml_handle, pynvml.NVML_CLOCK_GRAPHICS)
+                clock = nvml.nvmlDeviceGetClockInfo(self._nvml_handle, nvml.NVML_CLOCK_GRAPHICS)
                 gpu_freq_mhz = min(int(clock), 0xFFFF)
             except Exception:
                 gpu_freq_mhz = 0
@@ -749,34 +1208,6 @@ class GPUCollector:
             logging.debug("NVIDIA extended stats failed: %s", exc)
             return (0xFF, 0, 0)
 
-    def _collect_extended_nvidia_smi(self):
-        """Collect extended GPU stats via nvidia-smi subprocess."""
-        import subprocess
-        try:
-            result = subprocess.run(
-                ["nvidia-smi",
-                 "--query-gpu=memory.used,memory.total,power.draw,clocks.gr",
-                 "--format=csv,noheader,nounits"],
-                capture_output=True, text=True, timeout=5
-            )
-            if result.returncode == 0 and result.stdout.strip():
-                parts = result.stdout.strip().split(',')
-                mem_used = float(parts[0].strip())
-                mem_total = float(parts[1].strip())
-                gpu_mem_pct = min(int(mem_used * 100 / mem_total), 100) if mem_total > 0 else 0xFF
-                try:
-                    gpu_power_w = min(int(float(parts[2].strip())), 0xFFFF)
-                except (ValueError, IndexError):
-                    gpu_power_w = 0
-                try:
-                    gpu_freq_mhz = min(int(float(parts[3].strip())), 0xFFFF)
-                except (ValueError, IndexError):
-                    gpu_freq_mhz = 0
-                return (gpu_mem_pct, gpu_power_w, gpu_freq_mhz)
-        except Exception as exc:
-            logging.debug("nvidia-smi extended stats failed: %s", exc)
-        return (0xFF, 0, 0)
-
 
 # ---------------------------------------------------------------------------
 # Bridge discovery
@@ -828,7 +1259,7 @@ def find_bridge():
 # ---------------------------------------------------------------------------
 
 def get_cpu_temp():
-    """Read CPU temperature from psutil. Returns int Celsius or 0xFF."""
+    """Read CPU temperature from psutil. Returns Celsius (to 0.1) or 0xFF."""
     try:
         temps = psutil.sensors_temperatures()
         if not temps:
@@ -837,11 +1268,11 @@ def get_cpu_temp():
             if name in temps:
                 entries = temps[name]
                 if entries:
-                    return min(int(entries[0].current), 254)
+                    return min(round(entries[0].current, 1), 254)
         # Fall back to first available sensor
         for sensor_list in temps.values():
             if sensor_list:
-                return min(int(sensor_list[0].current), 254)
+                return min(round(sensor_list[0].current, 1), 254)
     except Exception:
         pass
     return 0xFF
@@ -851,24 +1282,158 @@ def get_cpu_temp():
 # TLV encoding
 # ---------------------------------------------------------------------------
 
+TLV_ENC_VARINT = 0x80   # Zig-zag LEB128, signed
+TLV_ENC_TENTHS = 0xC0   # Zig-zag LEB128 of value x 10
+
+
+def _zigzag_varint(value):
+    z = (value << 1) ^ (value >> 63)
+    out = bytearray()
+    while True:
+        b = z & 0x7F
+        z >>= 7
+        if z:
+            out.append(b | 0x80)
+        else:
+            out.append(b)
+            return bytes(out)
+
+
+def encode_stat_value(value):
+    """(desc, value bytes) for one stat, in the smallest encoding that holds it.
+
+    Whole numbers 0-65535 keep the original 1/2-byte unsigned encoding, so
+    packets of everyday values read the same to older firmware; bigger
+    ones become a signed varint or a 4-byte unsigned, whichever is shorter.
+    A value with a fractional part (temperatures) is sent in tenths.
+    """
+    if isinstance(value, float) and not value.is_integer():
+        data = _zigzag_varint(max(-0x7FFFFFFF, min(round(value * 10), 0x7FFFFFFF)))
+        return TLV_ENC_TENTHS | len(data), data
+    value = max(-0x80000000, min(int(value), 0xFFFFFFFF))
+    if 0 <= value < 256:
+        return 1, bytes([value])
+    if 0 <= value <= 0xFFFF:
+        return 2, struct.pack('<H', value)
+    if value <= 0x7FFFFFFF:
+        data = _zigzag_varint(value)
+        if value < 0 or len(data) < 4:
+            return TLV_ENC_VARINT | len(data), data
+    return 4, struct.pack('<I', min(value, 0x7FFFFFFF))
+
+
 def encode_stats_tlv(stats_list):
     """Encode a list of (stat_type_id, value) pairs into TLV packet bytes.
 
-    Format: [count] [type1][len1][val1...] [type2][len2][val2...] ...
-    Values < 256 use 1 byte, values >= 256 use 2 bytes (little-endian).
+    Format: [count] [type1][desc1][val1...] [type2][desc2][val2...] ...
+    desc is the value's encoding | its size, see encode_stat_value() and
+    tlv_decode_stats() in shared/protocol.h.
     """
     packet = bytearray([len(stats_list)])
     for stat_type, value in stats_list:
+        desc, data = encode_stat_value(value)
         packet.append(stat_type)
-        if value < 256:
-            packet.append(1)
-            packet.append(value & 0xFF)
-        else:
-            packet.append(2)
-            packet.extend(struct.pack('<H', value & 0xFFFF))
+        packet.append(desc)
+        packet.extend(data)
     return bytes(packet)
 
 
+TLV_LEN_MASK = 0x0F
+
+
+def merge_stats_tlv(older, newer):
+    """Fold TLV packet `newer` into `older` (its values win), in type order,
+    like tlv_merge_stats() on the bridge: a stats packet still waiting for
+    the HID writer is superseded without losing a delta only it carried.
+    None if either packet is malformed or the result is too long."""
+    entries = {}
+    for packet in (older, newer):
+        if not packet:
+            return None
+        pos = 1
+        for _ in range(packet[0]):
+            if pos + 2 > len(packet):
+                return None
+            end = pos + 2 + (packet[pos + 1] & TLV_LEN_MASK)
+            if end > len(packet):
+                return None
+            entries[packet[pos]] = packet[pos:end]
+            pos = end
+    merged = bytearray([len(entries)])
+    for stat_type in sorted(entries):
+        merged.extend(entries[stat_type])
+    return bytes(merged) if len(merged) < VENDOR_MAX_MESSAGE else None
+
+
+def merge_host_stats(older, newer):
+    """merge_stats_tlv() for MSG_HOST_STATS ([host id][TLV]): only packets of
+    the same host fold, and a "host down" packet (no entries) replaces."""
+    if older[:1] != newer[:1]:
+        return None
+    if len(newer) < 2 or newer[1] == 0 or len(older) < 2 or older[1] == 0:
+        return newer
+    merged = merge_stats_tlv(older[1:], newer[1:])
+    return older[:1] + merged if merged is not None else None
+
+
+# Per-type hysteresis for delta mode: (absolute, percent of last sent value).
+# A stat is resent once it moves by more than max(absolute, percent) from the
+# value the display last received. Types not listed resend on any change.
+STAT_HYSTERESIS = {
+    STAT_TYPES['cpu_temp']:       (0.4, 0),  # Celsius, sensors report tenths
+    STAT_TYPES['gpu_temp']:       (0.4, 0),
+    STAT_TYPES['cpu_freq']:       (50, 0),   # MHz
+    STAT_TYPES['gpu_freq']:       (50, 0),
+    STAT_TYPES['fan_rpm']:        (50, 0),
+    STAT_TYPES['load_avg']:       (5, 0),    # x100
+    STAT_TYPES['net_up']:         (2, 5),    # KB/s
+    STAT_TYPES['net_down']:       (2, 5),
+    STAT_TYPES['disk_read_kbs']:  (2, 5),
+    STAT_TYPES['disk_write_kbs']: (2, 5),
+}
+
+
+class StatsDeltaEncoder:
+    """Turn successive stats samples into delta TLV packets.
+
+    Only stats that moved beyond their STAT_HYSTERESIS since they were last
+    sent go into a packet; every KEYFRAME_INTERVAL (or after reset()) all of
+    them are sent. The display keeps the last value of anything omitted.
+    encode() returns None when there is nothing to send.
+    """
+
+    def __init__(self, keyframe_interval=KEYFRAME_INTERVAL):
+        self._keyframe_interval = keyframe_interval
+        self._sent = {}
+        self._last_keyframe = 0.0
+
+    def reset(self):
+        """Force the next packet to be a keyframe (reconnect, config reload)."""
+        self._sent = {}
+        self._last_keyframe = 0.0
+
+    def _changed(self, stat_type, value):
+        last = self._sent.get(stat_type)
+        if last is None:
+            return True
+        absolute, percent = STAT_HYSTERESIS.get(stat_type, (0, 0))
+        threshold = max(absolute, last * percent // 100)
+        return abs(value - last) > threshold
+
+    def encode(self, stats_list, now=None):
+        now = time.time() if now is None else now
+        if now - self._last_keyframe >= self._keyframe_interval:
+            self._last_keyframe = now
+            changed = list(stats_list)
+        else:
+            changed = [(t, v) for t, v in stats_list if self._changed(t, v)]
+        if not changed:
+            return None
+        for stat_type, value in changed:
+            self._sent[stat_type] = value
+        return encode_stats_tlv(changed)
+
+
 # ---------------------------------------------------------------------------
 # Stats config loading
 # ---------------------------------------------------------------------------
@@ -878,11 +1443,11 @@ def load_stats_config(config_path=None):
 
     Merges stat types from two sources:
     1. stats_header (legacy stats bar configuration)
-    2. stat_monitor widgets placed on any page (widget_type == 1)
+    2. stat_monitor / stat_graph widgets placed on any page (widget_type 1 / 7)
 
     This ensures the companion collects and sends ALL stat types that
     the display needs, whether configured via stats_header or via
-    stat_monitor widgets on pages.
+    stat widgets on pages.
 
     Returns (stat_type_ids, net_interface, disk_device, disk_mount, proc_update_interval).
     - net_interface: NIC name (e.g. "enp6s0") or None for aggregate
@@ -914,9 +1479,10 @@ def load_stats_config(config_path=None):
                         if 1 <= t <= 0x17:
                             type_set.add(t)
 
-            # Also scan all widget pages for stat_monitor widgets (widget_type == 1)
+            # Also scan all widget pages for stat_monitor / stat_graph widgets
             # to ensure the companion sends data for any stat type used on the display
             WIDGET_STAT_MONITOR = 1
+            WIDGET_STAT_GRAPH = 7
             STAT_DISPLAY_UPTIME = 0x15  # Display-local, no companion data needed
             active_name = data.get("active_profile_name", "")
             for profile in data.get("profiles", []):
@@ -924,7 +1490,9 @@ def load_stats_config(config_path=None):
                     continue
                 for page in profile.get("pages", []):
                     for widget in page.get("widgets", []):
-                        if widget.get("widget_type") == WIDGET_STAT_MONITOR:
+                        if widget.get("widget_type") in (WIDGET_STAT_MONITOR, WIDGET_STAT_GRAPH):
+                            if widget.get("remote_host"):
+                                continue  # Another machine's value (remote_stats.py)
                             st = widget.get("stat_type", 0)
                             if 1 <= st <= 0x17 and st != STAT_DISPLAY_UPTIME:
                                 type_set.add(st)
@@ -942,6 +1510,68 @@ def load_stats_config(config_path=None):
     return ([s["type"] for s in DEFAULT_STATS_CONFIG], net_interface, disk_device, disk_mount, proc_update_interval)
 
 
+# Gauges that can be sampled at the live rate: no counters (net/disk rates
+# share one baseline with the 1 Hz pass) and nothing that forks a process
+LIVE_CAPABLE_STATS = {
+    STAT_TYPES['cpu_percent'], STAT_TYPES['ram_percent'], STAT_TYPES['gpu_percent'],
+    STAT_TYPES['cpu_temp'], STAT_TYPES['gpu_temp'], STAT_TYPES['cpu_freq'],
+    STAT_TYPES['gpu_freq'], STAT_TYPES['fan_rpm'], STAT_TYPES['gpu_mem_pct'],
+    STAT_TYPES['gpu_power_w'],
+}
+
+GPU_STATS = {
+    STAT_TYPES['gpu_percent'], STAT_TYPES['gpu_temp'], STAT_TYPES['gpu_freq'],
+    STAT_TYPES['gpu_mem_pct'], STAT_TYPES['gpu_power_w'],
+}
+
+# Rates from byte counters: a pass that skipped them leaves a stale baseline
+COUNTER_STATS = {
+    STAT_TYPES['net_up'], STAT_TYPES['net_down'],
+    STAT_TYPES['disk_read_kbs'], STAT_TYPES['disk_write_kbs'],
+}
+
+
+def load_live_stats_config(config_path, enabled_types):
+    """Load the high-rate stats subset from config.json.
+
+    "stats_live": {"enabled": true, "rate_hz": 20, "stats": ["gpu_percent", ...]}
+    streams the listed stats (names or type IDs; default: every enabled
+    live-capable stat) at rate_hz, clamped to LIVE_RATE_MIN..LIVE_RATE_MAX.
+    Everything else stays at 1 Hz.
+
+    Returns (live_type_ids, rate_hz); live_type_ids is empty when disabled.
+    """
+    if not (config_path and os.path.isfile(config_path)):
+        return [], 0
+    try:
+        with open(config_path, "r") as f:
+            live = json.load(f).get("stats_live") or {}
+    except (json.JSONDecodeError, IOError) as exc:
+        logging.warning("Failed to load live stats config: %s", exc)
+        return [], 0
+    if not isinstance(live, dict) or not live.get("enabled", False):
+        return [], 0
+
+    try:
+        rate = int(live.get("rate_hz", 20))
+    except (TypeError, ValueError):
+        rate = 20
+    rate = max(LIVE_RATE_MIN, min(LIVE_RATE_MAX, rate))
+
+    wanted = set()
+    for entry in live.get("stats") or []:
+        t = STAT_TYPES.get(entry) if isinstance(entry, str) else entry
+        if isinstance(t, int):
+            wanted.add(t)
+    enabled = set(enabled_types)
+    candidates = (wanted or LIVE_CAPABLE_STATS) & enabled
+    skipped = (wanted - LIVE_CAPABLE_STATS) if wanted else set()
+    if skipped:
+        logging.warning("Live stats: %s can't be sampled at the live rate, kept at 1 Hz",
+                        [STAT_ID_TO_NAME.get(t, f"0x{t:02X}") for t in sorted(skipped)])
+    return sorted(candidates & LIVE_CAPABLE_STATS), rate
+
+
 # ---------------------------------------------------------------------------
 # Expanded stat collectors
 # ---------------------------------------------------------------------------
@@ -1008,33 +1638,103 @@ def get_load_avg_x100():
         return 0
 
 
-def get_proc_count():
-    """Return number of running processes."""
-    try:
-        return min(len(psutil.pids()), 0xFFFF)
-    except Exception:
-        return 0
+class ProcessOwners:
+    """proc_count / proc_user / proc_system from one walk of the PID list.
 
+    The owner of each PID is looked up once, when it first shows up, and
+    forgotten when it exits, so a pass costs one psutil.pids() plus a
+    lookup per new process instead of a username for every process, twice.
+    Owners are UIDs from a stat of /proc/<pid> where that exists, else
+    psutil usernames ($USER / $USERNAME, and root).
+    """
 
-def get_proc_user_count():
-    """Return number of processes owned by the current user."""
-    try:
-        username = os.getenv('USER') or os.getenv('USERNAME', '')
-        count = sum(1 for p in psutil.process_iter(['username'])
-                    if p.info.get('username') == username)
-        return min(count, 0xFFFF)
-    except Exception:
-        return 0
+    def __init__(self):
+        self._owners = {}   # pid -> uid or username, None if it couldn't be read
+        self._proc = os.path.isdir("/proc/self")
+        if self._proc:
+            self._user, self._system = os.getuid(), 0
+        else:
+            self._user, self._system = os.getenv('USER') or os.getenv('USERNAME', ''), 'root'
 
+    def _owner(self, pid):
+        try:
+            if self._proc:
+                return os.stat(f"/proc/{pid}").st_uid
+            return psutil.Process(pid).username()
+        except (OSError, psutil.Error):
+            return None
+
+    def counts(self):
+        """(processes, owned by the current user, owned by root)."""
+        try:
+            pids = set(psutil.pids())
+        except Exception:
+            return (0, 0, 0)
+        owners = self._owners
+        for pid in owners.keys() - pids:
+            del owners[pid]
+        for pid in pids - owners.keys():
+            owners[pid] = self._owner(pid)
+        values = list(owners.values())
+        return (min(len(pids), 0xFFFF), min(values.count(self._user), 0xFFFF),
+                min(values.count(self._system), 0xFFFF))
 
-def get_proc_system_count():
-    """Return number of processes owned by root/SYSTEM."""
-    try:
-        count = sum(1 for p in psutil.process_iter(['username'])
-                    if p.info.get('username') == 'root')
-        return min(count, 0xFFFF)
-    except Exception:
-        return 0
+
+_process_owners = ProcessOwners()
+
+
+class StatsProfiler:
+    """Per-stat collection cost for collect_stats_tlv() (--profile-stats).
+
+    lap(name) charges the time since the previous lap to `name`; every
+    STATS_PROFILE_INTERVAL seconds the averages are logged, dearest first.
+    """
+
+    def __init__(self, interval=None):
+        self._interval = interval or STATS_PROFILE_INTERVAL
+        self._totals = collections.defaultdict(float)
+        self._counts = collections.Counter()
+        self._passes = 0
+        self._since = time.monotonic()
+        self._mark = 0.0
+
+    def start(self):
+        self._passes += 1
+        self._mark = time.perf_counter()
+
+    def lap(self, name):
+        now = time.perf_counter()
+        self._totals[name] += now - self._mark
+        self._counts[name] += 1
+        self._mark = now
+
+    def maybe_report(self):
+        if time.monotonic() - self._since < self._interval or not self._totals:
+            return
+        total = sum(self._totals.values())
+        rows = sorted(self._totals.items(), key=lambda kv: kv[1], reverse=True)
+        logging.info("Stats cost over %d passes: %.2f ms/pass", self._passes, total * 1e3 / self._passes)
+        for name, spent in rows:
+            logging.info("  %-14s %8.3f ms avg  %5.1f%%", name, spent * 1e3 / self._counts[name],
+                         spent * 100 / total if total else 0)
+        self._totals.clear()
+        self._counts.clear()
+        self._passes = 0
+        self._since = time.monotonic()
+
+
+class _NoProfile:
+    def start(self):
+        pass
+
+    def lap(self, name):
+        pass
+
+    def maybe_report(self):
+        pass
+
+
+_NO_PROFILE = _NoProfile()
 
 
 def get_disk_io(prev_disk_io, dt, disk_device=None):
@@ -1057,21 +1757,54 @@ def get_disk_io(prev_disk_io, dt, disk_device=None):
             return (0, 0, curr)
         read_kbs = int((curr.read_bytes - prev_disk_io.read_bytes) / dt / 1024)
         write_kbs = int((curr.write_bytes - prev_disk_io.write_bytes) / dt / 1024)
-        return (max(0, min(read_kbs, 0xFFFF)), max(0, min(write_kbs, 0xFFFF)), curr)
+        return (max(0, read_kbs), max(0, write_kbs), curr)
     except Exception:
         return (0, 0, prev_disk_io)
 
 
+def read_counter_baselines(net_interface=None, disk_device=None):
+    """Current (net, disk I/O) counters for collect_stats_tlv's rates.
+
+    Per NIC / disk when configured and present, else aggregate; disk I/O
+    may be None where psutil can't read it.
+    """
+    try:
+        if net_interface:
+            net = psutil.net_io_counters(pernic=True).get(net_interface)
+            if net is None:
+                logging.warning("NIC '%s' not found, falling back to aggregate", net_interface)
+                net = psutil.net_io_counters()
+        else:
+            net = psutil.net_io_counters()
+    except Exception:
+        net = psutil.net_io_counters()
+    disk_io = None
+    try:
+        if disk_device:
+            disk_io = psutil.disk_io_counters(perdisk=True).get(disk_device)
+            if disk_io is None:
+                logging.warning("Disk '%s' not found, falling back to aggregate", disk_device)
+                disk_io = psutil.disk_io_counters()
+        else:
+            disk_io = psutil.disk_io_counters()
+    except Exception:
+        pass
+    return net, disk_io
+
+
 # ---------------------------------------------------------------------------
 # Stats collection (TLV + legacy)
 # ---------------------------------------------------------------------------
 
 def collect_stats_tlv(gpu_collector, enabled_types, prev_net, prev_time, prev_disk_io,
                       net_interface=None, disk_device=None, disk_mount="/",
-                      proc_update_interval=30, proc_state=None):
+                      proc_update_interval=30, proc_state=None, delta_encoder=None,
+                      profiler=None):
     """Collect system metrics based on enabled types and return TLV-encoded bytes.
 
     Returns (tlv_bytes, current_net_counters, current_time, current_disk_io).
+    With a StatsDeltaEncoder, tlv_bytes holds only changed stats (or a
+    keyframe) and is None when nothing needs sending.
     Only collects stats that are in enabled_types (saves CPU on unused psutil calls).
 
     net_interface: NIC name for per-interface network stats, or None for aggregate.
@@ -1079,7 +1812,10 @@ def collect_stats_tlv(gpu_collector, enabled_types, prev_net, prev_time, prev_di
     disk_mount:    mount path for disk usage %, defaults to "/".
     proc_update_interval: seconds between proc stat collection (default 30).
     proc_state: dict with 'last_time', 'count', 'user', 'system' for throttling.
+    profiler: StatsProfiler charged with each stat's collection time.
     """
+    prof = profiler or _NO_PROFILE
+    prof.start()
     now = time.time()
     dt = now - prev_time
     if dt <= 0:
@@ -1097,6 +1833,7 @@ def collect_stats_tlv(gpu_collector, enabled_types, prev_net, prev_time, prev_di
         except Exception:
             val = 0
         stats_list.append((STAT_TYPES['cpu_percent'], val))
+        prof.lap('cpu_percent')
 
     # RAM percent
     if STAT_TYPES['ram_percent'] in enabled_set:
@@ -1105,6 +1842,7 @@ def collect_stats_tlv(gpu_collector, enabled_types, prev_net, prev_time, prev_di
         except Exception:
             val = 0
         stats_list.append((STAT_TYPES['ram_percent'], val))
+        prof.lap('ram_percent')
 
     # GPU percent & temp
     need_gpu = (STAT_TYPES['gpu_percent'] in enabled_set or
@@ -1134,10 +1872,12 @@ def collect_stats_tlv(gpu_collector, enabled_types, prev_net, prev_time, prev_di
                 stats_list.append((STAT_TYPES['gpu_power_w'], 0))
             if STAT_TYPES['gpu_freq'] in enabled_set:
                 stats_list.append((STAT_TYPES['gpu_freq'], 0))
+        prof.lap('gpu')
 
     # CPU temp
     if STAT_TYPES['cpu_temp'] in enabled_set:
         stats_list.append((STAT_TYPES['cpu_temp'], get_cpu_temp()))
+        prof.lap('cpu_temp')
 
     # Disk percent (configurable mount point)
     if STAT_TYPES['disk_percent'] in enabled_set:
@@ -1146,6 +1886,7 @@ def collect_stats_tlv(gpu_collector, enabled_types, prev_net, prev_time, prev_di
         except Exception:
             val = 0
         stats_list.append((STAT_TYPES['disk_percent'], val))
+        prof.lap('disk_percent')
 
     # Network (per-interface or aggregate)
     if STAT_TYPES['net_up'] in enabled_set or STAT_TYPES['net_down'] in enabled_set:
@@ -1161,8 +1902,8 @@ def collect_stats_tlv(gpu_collector, enabled_types, prev_net, prev_time, prev_di
                 curr_net = psutil.net_io_counters()
             net_up = int((curr_net.bytes_sent - prev_net.bytes_sent) / dt / 1024)
             net_down = int((curr_net.bytes_recv - prev_net.bytes_recv) / dt / 1024)
-            net_up = max(0, min(net_up, 0xFFFF))
-            net_down = max(0, min(net_down, 0xFFFF))
+            net_up = max(0, net_up)
+            net_down = max(0, net_down)
         except Exception:
             curr_net = prev_net
             net_up = 0
@@ -1171,30 +1912,37 @@ def collect_stats_tlv(gpu_collector, enabled_types, prev_net, prev_time, prev_di
             stats_list.append((STAT_TYPES['net_up'], net_up))
         if STAT_TYPES['net_down'] in enabled_set:
             stats_list.append((STAT_TYPES['net_down'], net_down))
+        prof.lap('net')
 
     # CPU freq
     if STAT_TYPES['cpu_freq'] in enabled_set:
         stats_list.append((STAT_TYPES['cpu_freq'], get_cpu_freq_mhz()))
+        prof.lap('cpu_freq')
 
     # Swap
     if STAT_TYPES['swap_percent'] in enabled_set:
         stats_list.append((STAT_TYPES['swap_percent'], get_swap_percent()))
+        prof.lap('swap_percent')
 
     # Uptime
     if STAT_TYPES['uptime_hours'] in enabled_set:
         stats_list.append((STAT_TYPES['uptime_hours'], get_uptime_hours()))
+        prof.lap('uptime_hours')
 
     # Battery
     if STAT_TYPES['battery_pct'] in enabled_set:
         stats_list.append((STAT_TYPES['battery_pct'], get_battery_percent()))
+        prof.lap('battery_pct')
 
     # Fan RPM
     if STAT_TYPES['fan_rpm'] in enabled_set:
         stats_list.append((STAT_TYPES['fan_rpm'], get_fan_rpm()))
+        prof.lap('fan_rpm')
 
     # Load average
     if STAT_TYPES['load_avg'] in enabled_set:
         stats_list.append((STAT_TYPES['load_avg'], get_load_avg_x100()))
+        prof.lap('load_avg')
 
     # Process stats (throttled by proc_update_interval)
     proc_types = {STAT_TYPES['proc_count'], STAT_TYPES['proc_user'], STAT_TYPES['proc_system']}
@@ -1204,18 +1952,14 @@ def collect_stats_tlv(gpu_collector, enabled_types, prev_net, prev_time, prev_di
             proc_state = {'last_time': 0, 'count': 0, 'user': 0, 'system': 0}
         if now - proc_state['last_time'] >= proc_update_interval:
             proc_state['last_time'] = now
-            if STAT_TYPES['proc_count'] in enabled_set:
-                proc_state['count'] = get_proc_count()
-            if STAT_TYPES['proc_user'] in enabled_set:
-                proc_state['user'] = get_proc_user_count()
-            if STAT_TYPES['proc_system'] in enabled_set:
-                proc_state['system'] = get_proc_system_count()
+            proc_state['count'], proc_state['user'], proc_state['system'] = _process_owners.counts()
         if STAT_TYPES['proc_count'] in enabled_set:
             stats_list.append((STAT_TYPES['proc_count'], proc_state['count']))
         if STAT_TYPES['proc_user'] in enabled_set:
             stats_list.append((STAT_TYPES['proc_user'], proc_state['user']))
         if STAT_TYPES['proc_system'] in enabled_set:
             stats_list.append((STAT_TYPES['proc_system'], proc_state['system']))
+        prof.lap('processes')
 
     # Disk I/O (per-device or aggregate)
     if STAT_TYPES['disk_read_kbs'] in enabled_set or STAT_TYPES['disk_write_kbs'] in enabled_set:
@@ -1224,8 +1968,14 @@ def collect_stats_tlv(gpu_collector, enabled_types, prev_net, prev_time, prev_di
             stats_list.append((STAT_TYPES['disk_read_kbs'], read_kbs))
         if STAT_TYPES['disk_write_kbs'] in enabled_set:
             stats_list.append((STAT_TYPES['disk_write_kbs'], write_kbs))
+        prof.lap('disk_io')
 
-    tlv_bytes = encode_stats_tlv(stats_list)
+    if delta_encoder is not None:
+        tlv_bytes = delta_encoder.encode(stats_list, now)
+    else:
+        tlv_bytes = encode_stats_tlv(stats_list)
+    prof.lap('encode')
+    prof.maybe_report()
     return (tlv_bytes, curr_net, now, curr_disk_io)
 
 
@@ -1233,19 +1983,116 @@ def collect_stats_tlv(gpu_collector, enabled_types, prev_net, prev_time, prev_di
 # Main
 # ---------------------------------------------------------------------------
 
+def decode_bridge_stats(payload, prev=None):
+    """MSG_BRIDGE_STATS -> dict. Totals become per-second rates against `prev`
+    (the previous decoded report); the first report after a bridge reboot has
+    no rates."""
+    (uptime_ms, rx_frames, rx_bytes, tx_frames, tx_bytes, tx_failed, rx_drops,
+     rx_high, rx_size, hid_reports, vendor_rx_bps, vendor_tx_bps,
+     loop_avg_us, loop_max_us, rssi, free_heap, channel) = BRIDGE_STATS.unpack_from(payload)
+    pipe = stall = batched = adapt = None
+    if len(payload) >= BRIDGE_STATS.size + BRIDGE_STATS_PIPE.size:
+        pipe = BRIDGE_STATS_PIPE.unpack_from(payload, BRIDGE_STATS.size)
+    stall_offset = BRIDGE_STATS.size + BRIDGE_STATS_PIPE.size
+    if len(payload) >= stall_offset + BRIDGE_STATS_STALL.size:
+        stall = BRIDGE_STATS_STALL.unpack_from(payload, stall_offset)
+    batch_offset = stall_offset + BRIDGE_STATS_STALL.size
+    if len(payload) >= batch_offset + BRIDGE_STATS_BATCH.size:
+        (batched,) = BRIDGE_STATS_BATCH.unpack_from(payload, batch_offset)
+    adapt_offset = batch_offset + BRIDGE_STATS_BATCH.size
+    if len(payload) >= adapt_offset + BRIDGE_STATS_ADAPT.size:
+        adapt = BRIDGE_STATS_ADAPT.unpack_from(payload, adapt_offset)
+    sample = {
+        "time": time.time(),
+        "uptime_ms": uptime_ms,
+        "totals": {
+            "espnow_rx_frames": rx_frames, "espnow_rx_bytes": rx_bytes,
+            "espnow_tx_frames": tx_frames, "espnow_tx_bytes": tx_bytes,
+            "espnow_tx_failed": tx_failed, "rx_queue_drops": rx_drops,
+            "hid_reports": hid_reports,
+        },
+        "radio_avg_us": None, "radio_max_us": None,
+        "to_radio_high": None, "to_usb_high": None, "pipe_size": None,
+        "last_stall_section": None, "last_stall_us": None,
+        "tx_power_dbm": None, "phy_rate_step": None, "far_rssi_dbm": None,
+        "adapt_reason": None, "adapt_changes": None,
+        "rx_queue_high": rx_high,
+        "rx_queue_size": rx_size,
+        "vendor_rx_kbps": vendor_rx_bps / 1024.0,
+        "vendor_tx_kbps": vendor_tx_bps / 1024.0,
+        "loop_avg_us": loop_avg_us,
+        "loop_max_us": loop_max_us,
+        "rssi_dbm": rssi if rssi else None,
+        "free_heap": free_heap,
+        "channel": channel,
+        "rates": {},
+    }
+    if pipe is not None:
+        (sample["radio_avg_us"], sample["radio_max_us"], sample["to_radio_high"],
+         sample["to_usb_high"], sample["pipe_size"], to_radio_full, to_usb_full) = pipe
+        sample["totals"]["to_radio_full"] = to_radio_full
+        sample["totals"]["to_usb_full"] = to_usb_full
+    if stall is not None:
+        loop_stalls, section, stall_us = stall
+        sample["totals"]["loop_stalls"] = loop_stalls
+        if section != 0xFF:
+            sample["last_stall_section"] = (BRIDGE_LOOP_SECTIONS[section]
+                                            if section < len(BRIDGE_LOOP_SECTIONS)
+                                            else str(section))
+            sample["last_stall_us"] = stall_us
+    if batched is not None:
+        sample["totals"]["espnow_tx_batched"] = batched
+    if adapt is not None:
+        power_qdbm, rate_step, far_rssi, reason, changes = adapt
+        sample["tx_power_dbm"] = power_qdbm / 4.0
+        sample["phy_rate_step"] = rate_step
+        sample["far_rssi_dbm"] = far_rssi if far_rssi else None
+        if reason != 0xFF:
+            sample["adapt_reason"] = ADAPT_REASONS[reason] if reason < len(ADAPT_REASONS) else str(reason)
+        sample["adapt_changes"] = changes
+    if prev is not None and uptime_ms > prev["uptime_ms"]:
+        dt = (uptime_ms - prev["uptime_ms"]) / 1000.0
+        for key, value in sample["totals"].items():
+            if key not in prev["totals"]:
+                continue
+            delta = (value - prev["totals"][key]) & 0xFFFFFFFF
+            sample["rates"][key] = delta / dt
+    return sample
+
+
 class CompanionService:
     """Background service: bridge communication, stats streaming, action dispatch.
 
     Runs all work in daemon threads. Call start() to begin, stop() to shut down.
+    The service is the only process that opens the bridge: everything else
+    reaches it through the IPC socket (service_ipc.py), which start() opens
+    first and which makes it raise ServiceRunningError when another service
+    already owns the bridge.
     Status callbacks (on_bridge_connected, on_bridge_disconnected, on_stats_sent,
-    on_button_press) are called from background threads — use Qt signals or
+    on_button_press, on_bridge_stats) are called from background threads — use Qt signals or
     thread-safe mechanisms if updating UI.
     """
 
-    def __init__(self, config_manager=None):
+    def __init__(self, config_manager=None, wired=True, wired_baud=WIRED_BAUD):
         self._running = False
         self._device = None
+        # A display on its own USB port (wired_link.py) is preferred over the
+        # bridge and stands in for it; the service then types its keys itself
+        self._wired = wired
+        self._wired_baud = wired_baud
+        self._key_player = None
+        # Every write goes through _writer (one thread, by message class),
+        # which holds _hid_lock per message; the vendor reader only takes
+        # _read_lock, so a 100 ms read() never stalls a write. hidraw
+        # handles a concurrent read and write on one handle fine.
         self._hid_lock = threading.Lock()
+        self._read_lock = threading.Lock()
+        self._write_error = threading.Event()   # Set by the writer, handled by the stats loop
+        self._writer = HidWriter(lambda: self._device, self._hid_lock,
+                                 lambda exc: self._write_error.set())
+        self._writer_log_time = 0.0
+        self._ipc = IpcServer(self)
+        self._dispatcher = None
         self._config_mgr = config_manager or get_config_manager()
         self._config_path = str(DEFAULT_CONFIG_PATH)
         self._config_watcher = None
@@ -1253,61 +2100,121 @@ class CompanionService:
         self._stats_thread = None
         self._vendor_thread = None
         self._enabled_stat_types = []
+        self._live_stat_types = []
+        self._live_rate = 0
+        # Display battery policy (MSG_STATS_RATE): full-pass period and live pause
+        self._stats_interval = UPDATE_INTERVAL
+        self._live_paused = False
+        self._stats_rates = {}  # display id -> (interval, live paused); stats are shared
+        self._stats_subs = {}   # display id -> StatTypes on its screen (MSG_STATS_SUBSCRIBE)
+        self._stats_wanted = None  # Union of _stats_subs, None = no display subscribed
         self._net_interface = None
         self._disk_device = None
         self._disk_mount = "/"
         self._proc_update_interval = 30
         self._proc_state = {'last_time': 0, 'count': 0, 'user': 0, 'system': 0}
+        self._stats_profiler = None  # StatsProfiler (profile_stats())
+        self._focus_config = (False, "", {}, {})
+        self._focus_profile = None  # Last (profile, display) sent for the focused window
 
         # Status callbacks
         self.on_bridge_connected = None
         self.on_bridge_disconnected = None
         self.on_stats_sent = None
         self.on_button_press = None
+        self.on_bridge_stats = None
+
+        # Bridge health reports (MSG_BRIDGE_STATS), oldest first
+        self._bridge_stats = collections.deque(maxlen=BRIDGE_STATS_HISTORY)
+
+        # Latency benchmark (run_bench)
+        self._bench_done = threading.Event()
+        self._bench_report = None
+
+        # Input record / replay (replay_command)
+        self._replay_done = threading.Event()
+        self._replay_report = None
+
+        # Firmware updates: MSG_FW_ACKs (bridge) and MSG_BULK_ACKs from the
+        # display being flashed (update_display_firmware), from the reader
+        self._fw_acks = queue.Queue()
+        self._bulk_acks = queue.Queue()
+        self._bulk_display = None
+        self._fw_xfer_id = 0
+        # One bulk transfer at a time per display: remote image patches skip
+        # a pass while a firmware update holds this
+        self._bulk_lock = threading.Lock()
+        self._image_xfer_id = 0x80   # Own range, so a stale firmware ACK never matches
+        self._image_streams = {}     # source -> ((width, height) asked for, RemoteImageStream)
 
         # Readable state
         self._bridge_connected = False
         self._stats_count = 0
+        self._stats_delta = StatsDeltaEncoder()
+        # Remote collectors (remote_stats.py): scraped on their own threads,
+        # delta-encoded per host id like the local stats
+        self._remote_poller = None
+        self._remote_delta = {}
+
+    def profile_stats(self, enabled: bool = True):
+        """Log per-stat collection cost every STATS_PROFILE_INTERVAL seconds."""
+        self._stats_profiler = StatsProfiler() if enabled else None
 
     @property
     def is_bridge_connected(self) -> bool:
         return self._bridge_connected
 
-    def release_bridge(self):
-        """Temporarily close the HID device so another process can use it.
-
-        Call reclaim_bridge() when done.  The stats/vendor loops keep running
-        but will skip I/O until the device is reclaimed.
-        """
-        with self._hid_lock:
-            if self._device is not None:
-                try:
-                    self._device.close()
-                except Exception:
-                    pass
-                self._device = None
-                logging.info("Bridge released for deploy")
-
-    def reclaim_bridge(self):
-        """Re-open the bridge HID device after release_bridge()."""
+    @property
+    def is_wired(self) -> bool:
+        """Connected to a display's own USB port rather than a bridge."""
+        return isinstance(self._device, WiredDisplay)
+
+    def _open_device(self):
+        """A wired display if one answers, else the bridge; None if neither."""
+        if self._wired:
+            device = open_wired_display(self._wired_baud)
+            if device is not None:
+                return device
         path = find_bridge()
         if path is None:
-            logging.warning("Cannot reclaim bridge: device not found")
-            return
-        try:
-            if hasattr(hid, 'Device'):
-                self._device = hid.Device(path=path)
-            else:
-                self._device = hid.device()
-                self._device.open_path(path)
-            logging.info("Bridge reclaimed after deploy")
-        except Exception as exc:
-            logging.error("Failed to reclaim bridge: %s", exc)
-            self._device = None
+            return None
+        if hasattr(hid, 'Device'):
+            return hid.Device(path=path)
+        device = hid.device()
+        device.open_path(path)
+        return device
+
+    def send_message(self, msg_type, payload=b"", display=None, cls=WRITE_CONTROL, wait=True) -> bool:
+        """Write one message through the HID writer (IPC "send"). With wait,
+        True once written, else once queued; False without a device."""
+        if self._device is None:
+            return False
+        return self._writer.submit(cls, msg_type, payload, display,
+                                   wait=BULK_WRITE_TIMEOUT if wait else None)
+
+    def ipc_status(self) -> dict:
+        """State for IPC "status" requests."""
+        return {"connected": self._bridge_connected, "wired": self.is_wired,
+                "status": self.status_text, "clients": self._ipc.client_count}
+
+    @property
+    def hid_write_stats(self) -> dict:
+        """Per message class (control, notify, stats, bulk): HidWriter.stats()."""
+        return self._writer.stats()
+
+    @property
+    def bridge_stats_history(self) -> list:
+        """Decoded MSG_BRIDGE_STATS reports (decode_bridge_stats), oldest first."""
+        return list(self._bridge_stats)
 
     @property
     def status_text(self) -> str:
+        if self._bridge_connected and self.is_wired:
+            return f"Display: Connected over USB, Stats: {len(self._enabled_stat_types)} types @ 1Hz"
         if self._bridge_connected:
+            if self._live_stat_types:
+                return (f"Bridge: Connected, Stats: {len(self._enabled_stat_types)} types @ 1Hz, "
+                        f"{len(self._live_stat_types)} @ {self._live_rate}Hz")
             return f"Bridge: Connected, Stats: {len(self._enabled_stat_types)} types @ 1Hz"
         return "Bridge: Disconnected"
 
@@ -1316,21 +2223,27 @@ class CompanionService:
         if self._running:
             return
 
-        self._running = True
         DEFAULT_CONFIG_DIR.mkdir(parents=True, exist_ok=True)
+        self._ipc.start()   # Raises ServiceRunningError before anything else starts
+        self._running = True
 
         # Load config
         self._config_mgr.load_json_file(self._config_path)
+
+        # Initialize GPU collector (before the device config: live stats depend on it)
+        self._gpu = GPUCollector()
+        psutil.cpu_percent()  # Prime — first call always returns 0
+
         self._load_device_config()
         logging.info("Enabled stat types: %s",
                      [STAT_ID_TO_NAME.get(t, f"0x{t:02X}") for t in self._enabled_stat_types])
 
-        # Initialize GPU collector
-        self._gpu = GPUCollector()
-        psutil.cpu_percent()  # Prime — first call always returns 0
+        # Button presses run on a persistent pool against pre-resolved actions
+        self._dispatcher = ActionDispatcher(self._config_mgr)
 
-        # Start config file watcher
-        self._config_watcher = _start_config_watcher(self._config_path, self._config_mgr)
+        # Start config file watcher; the action table is brought up to date off the press path
+        self._config_watcher = _start_config_watcher(self._config_path, self._config_mgr,
+                                                     self._dispatcher.refresh)
 
         # D-Bus shutdown listener
         threading.Thread(target=_run_dbus_listener, daemon=True).start()
@@ -1351,7 +2264,15 @@ class CompanionService:
         else:
             logging.info("Notification forwarding disabled")
 
-        # Main stats + bridge thread
+        # Per-application profiles following window focus
+        self._focus_config = load_focus_profile_config(self._config_path)
+        if self._focus_config[0]:
+            logging.info("Profile focus following enabled (%d apps)", len(self._focus_config[2]))
+        threading.Thread(target=self._focus_loop, daemon=True).start()
+        threading.Thread(target=self._remote_image_loop, daemon=True).start()
+
+        # Main stats + bridge thread, and the writer everything sends through
+        self._writer.start()
         self._stats_thread = threading.Thread(
             target=self._stats_loop, args=(notif_enabled, notif_filter), daemon=True
         )
@@ -1360,6 +2281,19 @@ class CompanionService:
     def stop(self):
         """Clean shutdown of all threads."""
         self._running = False
+        self._ipc.stop()
+        if self._dispatcher is not None:
+            self._dispatcher.shutdown()
+            self._dispatcher = None
+        self._writer.stop()
+        if self._remote_poller is not None:
+            self._remote_poller.stop()
+            self._remote_poller = None
+        from companion.window_tracker import get_window_tracker
+        get_window_tracker().stop()
+        if self._gpu is not None:
+            self._gpu.close()
+            self._gpu = None
         if self._device is not None:
             try:
                 self._device.close()
@@ -1374,22 +2308,62 @@ class CompanionService:
         (self._enabled_stat_types, self._net_interface,
          self._disk_device, self._disk_mount,
          self._proc_update_interval) = load_stats_config(self._config_path)
+        self._live_stat_types, self._live_rate = load_live_stats_config(
+            self._config_path, self._enabled_stat_types)
+        if self._gpu is not None:
+            # The nvidia-smi stream samples as fast as the GPU stats are sent
+            gpu_live = any(t in GPU_STATS for t in self._live_stat_types)
+            self._gpu.set_sample_rate(self._live_rate if gpu_live else 1)
+        if self._live_stat_types:
+            logging.info("Live stats at %d Hz: %s", self._live_rate,
+                         [STAT_ID_TO_NAME.get(t, f"0x{t:02X}") for t in self._live_stat_types])
         if self._net_interface:
             logging.info("Network interface: %s", self._net_interface)
         if self._disk_device:
             logging.info("Disk device: %s", self._disk_device)
         if self._disk_mount != "/":
             logging.info("Disk mount: %s", self._disk_mount)
+        if self._remote_poller is not None:
+            self._remote_poller.stop()
+        self._remote_poller = RemoteStatsPoller(load_remote_hosts(self._config_path))
+        self._remote_poller.start()
+        self._remote_delta = {}
 
     def reload_config(self):
         """Reload config from disk."""
         if self._config_mgr.load_json_file(self._config_path):
             self._load_device_config()
+            self._stats_delta.reset()  # New widgets need every value, not just changes
+            self._remote_delta = {}
+            self._focus_config = load_focus_profile_config(self._config_path)
+            self._focus_profile = None  # Re-send: profiles may have been renamed
             logging.info("Config reloaded, %d stat types", len(self._enabled_stat_types))
 
+    def _send_remote_stats(self):
+        """MSG_HOST_STATS for every remote host with a fresh scrape (or one
+        that just went down). Never blocks on a host: take() only returns
+        what their threads have finished."""
+        if self._remote_poller is None:
+            return
+        for host_id, stats in self._remote_poller.take():
+            if stats is None:
+                self._remote_delta.pop(host_id, None)
+                packed = bytes([0])   # Down: the display drops its values
+            else:
+                pairs = [(STAT_TYPES[name], value) for name, value in sorted(stats.items())
+                         if name in STAT_TYPES and name != 'display_uptime']
+                encoder = self._remote_delta.setdefault(host_id, StatsDeltaEncoder())
+                packed = encoder.encode(pairs)
+                if packed is None:
+                    continue
+            self._writer.submit(WRITE_STATS, MSG_HOST_STATS, bytes([host_id]) + packed,
+                                coalesce=merge_host_stats)
+
     def _set_bridge_connected(self, connected):
         prev = self._bridge_connected
         self._bridge_connected = connected
+        if connected != prev:
+            self._ipc.publish("connection", {"connected": connected})
         if connected and not prev:
             if self.on_bridge_connected:
                 self.on_bridge_connected()
@@ -1400,14 +2374,11 @@ class CompanionService:
     def _connect_bridge(self):
         """Discover and connect to bridge. Blocks until connected or stopped."""
         while self._running:
-            path = find_bridge()
-            if path is not None:
-                try:
-                    if hasattr(hid, 'Device'):
-                        self._device = hid.Device(path=path)
-                    else:
-                        self._device = hid.device()
-                        self._device.open_path(path)
+            try:
+                self._device = self._open_device()
+                if self._device is not None:
+                    if self.is_wired and self._key_player is None:
+                        self._key_player = KeyPlayer()
                     product = getattr(self._device, 'product', '') or ''
                     manufacturer = getattr(self._device, 'manufacturer', '') or ''
                     serial = getattr(self._device, 'serial', '') or ''
@@ -1415,51 +2386,470 @@ class CompanionService:
                                  product, manufacturer, serial)
                     self._set_bridge_connected(True)
                     return True
-                except Exception as exc:
-                    logging.error("Failed to open bridge: %s", exc)
-                    self._device = None
+            except Exception as exc:
+                logging.error("Failed to open bridge: %s", exc)
+                self._device = None
             logging.info("Bridge not found, retrying in %.0fs...", RETRY_INTERVAL)
             time.sleep(RETRY_INTERVAL)
         return False
 
     def _vendor_read_loop(self):
         """Background: reads vendor HID input reports from bridge."""
+        reassembler = FragmentReassembler()
         while self._running and self._device is not None:
             try:
-                with self._hid_lock:
-                    data = self._device.read(63, timeout=100)
+                with self._read_lock:
+                    device = self._device
+                    if device is None:
+                        break
+                    report = device.read(1 + VENDOR_REPORT_SIZE, timeout=100)
+                received = time.perf_counter()
+                received_us = time.time_ns() // 1000
+                # report[0] is the HID report ID (0x06); data keeps the same
+                # layout for reassembled messages: [id][type][payload...],
+                # with a multi-display envelope (MSG_DISPLAY) split off
+                message = reassembler.feed(report[1:]) if report else None
+                display = 0
+                if message:
+                    display, message = split_display(message)
+                    self._ipc.publish_message(display, message)
+                data = [report[0]] + list(message) if message else None
                 if data and len(data) >= 4:
-                    # data[0] is the HID report ID (0x06), actual payload starts at data[1]
                     msg_type = data[1]
-                    if msg_type == MSG_BUTTON_PRESS:
-                        page_idx = data[2]
-                        widget_idx = data[3]
-                        logging.info("Button press: page=%d widget=%d", page_idx, widget_idx)
-                        if self.on_button_press:
-                            self.on_button_press(page_idx, widget_idx)
-                        threading.Thread(
-                            target=execute_action,
-                            args=(self._config_mgr, page_idx, widget_idx),
-                            daemon=True
-                        ).start()
-                    elif msg_type == MSG_DDC_CMD and len(data) >= 8:
-                        vcp_code = data[2]
-                        value = struct.unpack_from('<H', bytes(data), 3)[0]
-                        adjustment = struct.unpack_from('<h', bytes(data), 5)[0]
-                        display_num = data[7]
-                        logging.info("DDC cmd: vcp=0x%02X val=%d adj=%d disp=%d",
-                                     vcp_code, value, adjustment, display_num)
-                        threading.Thread(
-                            target=execute_ddc_direct,
-                            args=(vcp_code, value, adjustment, display_num),
-                            daemon=True
-                        ).start()
+                    if msg_type == MSG_BENCH_PROBE:
+                        self._echo_bench_probe(bytes(data[2:2 + BENCH_PROBE.size]), received, display)
+                    elif msg_type == MSG_BUTTON_PRESS:
+                        self._dispatch_button_press(bytes(data[2:]), received, display)
+                    elif msg_type == MSG_BENCH_REPORT:
+                        self._on_bench_report(bytes(data[2:2 + BENCH_REPORT.size]))
+                    elif msg_type == MSG_REPLAY_REPORT:
+                        self._on_replay_report(bytes(data[2:2 + REPLAY_REPORT.size]))
+                    elif msg_type == MSG_STATS_RATE:
+                        self._on_stats_rate(bytes(data[2:2 + STATS_RATE.size]), display)
+                    elif msg_type == MSG_STATS_SUBSCRIBE:
+                        self._on_stats_subscribe(bytes(data[2:2 + STATS_SUBSCRIBE.size]), display)
+                    elif msg_type == MSG_BRIDGE_STATS:
+                        self._on_bridge_stats(bytes(data[2:2 + BRIDGE_STATS.size + BRIDGE_STATS_PIPE.size
+                                                          + BRIDGE_STATS_STALL.size
+                                                          + BRIDGE_STATS_BATCH.size
+                                                          + BRIDGE_STATS_ADAPT.size]))
+                    elif msg_type == MSG_FW_ACK:
+                        self._fw_acks.put(bytes(data[2:2 + BULK_ACK.size]))
+                    elif msg_type == MSG_BULK_ACK:
+                        if self._bulk_display is None or display in (None, self._bulk_display):
+                            self._bulk_acks.put(bytes(data[2:2 + BULK_ACK.size]))
+                    elif msg_type == MSG_DDC_CMD and len(data) >= 2 + DDC_CMD.size:
+                        self._dispatch_ddc_cmd(bytes(data[2:2 + DDC_CMD.size]), display)
+                    elif msg_type in (MSG_HOTKEY, MSG_MEDIA_KEY, MSG_MACRO, MSG_TYPE_TEXT) and self.is_wired:
+                        self._play_wired_keys(msg_type, bytes(data[2:]))
+                    elif msg_type == MSG_CLOCK_SYNC and len(data) >= 2 + CLOCK_SYNC.size:
+                        answer_clock_sync(device, bytes(data[2:2 + CLOCK_SYNC.size]), received_us,
+                                          self._writer)
             except (IOError, OSError):
                 logging.warning("Vendor HID read error, device may have disconnected")
                 break
             except Exception as exc:
                 logging.debug("Vendor read thread error: %s", exc)
 
+    def _play_wired_keys(self, msg_type, payload):
+        """MSG_HOTKEY / MSG_MEDIA_KEY / MSG_MACRO / MSG_TYPE_TEXT from a wired display: no bridge
+        to type them."""
+        player = self._key_player
+        if msg_type == MSG_TYPE_TEXT:
+            player.text(payload[1:].rstrip(b"\0").decode("utf-8", "replace"))   # [layout][UTF-8]
+        elif msg_type == MSG_HOTKEY:
+            player.hotkey(payload[0], payload[1])
+        elif msg_type == MSG_MEDIA_KEY:
+            player.media(payload[0] | payload[1] << 8)
+        else:
+            count = min(payload[0], (len(payload) - 1) // 3)
+            player.macro(tuple(payload[1 + 3 * i:4 + 3 * i]) for i in range(count))
+
+    def _dispatch_button_press(self, payload, received, display=0):
+        """Hand a MSG_BUTTON_PRESS to the dispatcher; traced presses get a result back
+        (addressed to the display that was pressed)."""
+        page_idx, widget_idx = payload[0], payload[1]
+        on_done = None
+        profile_idx = None
+        entry_idx = None
+        entry_off = 2 + BUTTON_PRESS_TRACE.size
+        if len(payload) >= entry_off + BUTTON_PRESS_ENTRY.size:
+            entry, = BUTTON_PRESS_ENTRY.unpack_from(payload, entry_off)
+            entry_idx = None if entry == BUTTON_PRESS_NO_ENTRY else entry
+        if len(payload) >= 2 + BUTTON_PRESS_TRACE.size:
+            press_id, display_ms, profile = BUTTON_PRESS_TRACE.unpack_from(payload, 2)
+            profile_idx = None if profile == 0xFF else profile
+            device = self._device
+
+            def on_done(status, queue_s, exec_s):
+                logging.debug("Button press #%d: status=%d queue=%.0fus exec=%.1fms",
+                              press_id, status, queue_s * 1e6, exec_s * 1e3)
+                if device is self._device:  # Not after a reconnect/release
+                    send_action_result(device, press_id, status, display_ms,
+                                       queue_s, exec_s, self._writer, display)
+            logging.info("Button press #%d: display=%d page=%d widget=%d entry=%s profile=%s",
+                         press_id, display, page_idx, widget_idx, entry_idx, profile_idx)
+        else:
+            logging.info("Button press: display=%d page=%d widget=%d", display, page_idx, widget_idx)
+        if self._dispatcher is not None:
+            self._dispatcher.submit(page_idx, widget_idx, profile_idx, received, on_done, entry_idx)
+        if self.on_button_press:
+            self.on_button_press(page_idx, widget_idx)
+
+    def _dispatch_ddc_cmd(self, payload, display=0):
+        """Queue a MSG_DDC_CMD (merged with any still pending for that control);
+        where it lands is sent back to the display it came from."""
+        vcp_code, value, adjustment, display_num = DDC_CMD.unpack(payload)
+        logging.info("DDC cmd: display=%d vcp=0x%02X val=%d adj=%d disp=%d",
+                     display, vcp_code, value, adjustment, display_num)
+        device = self._device
+
+        def on_state(vcp, current, max_value, ddc_display):
+            if device is self._device:  # Not after a reconnect/release
+                send_ddc_state(device, vcp, current, max_value, ddc_display,
+                               self._writer, display)
+        execute_ddc_direct(vcp_code, value, adjustment, display_num, on_state)
+
+    def _echo_bench_probe(self, probe, received, display=0):
+        """Return a latency probe to its display at once, with the host turnaround."""
+        if self._device is None or len(probe) < BENCH_PROBE.size:
+            return
+
+        def echo():   # Built by the writer: host_us includes the queueing
+            host_us = int((time.perf_counter() - received) * 1e6)
+            return probe + BENCH_ECHO_TAIL.pack(min(host_us, 0xFFFFFFFF), 0)
+        self._writer.submit(WRITE_CONTROL, MSG_BENCH_ECHO, echo, display)
+
+    def _on_stats_rate(self, payload, display=0):
+        """A display on battery asked for a slower stats cadence (or back to normal).
+
+        Stats go to every display at once, so the fastest request wins and
+        live stats only pause once every display that asked has paused them.
+        """
+        if len(payload) < STATS_RATE.size:
+            return
+        interval_ms, live = STATS_RATE.unpack(payload)
+        interval = interval_ms / 1000.0 if interval_ms else UPDATE_INTERVAL
+        interval = max(UPDATE_INTERVAL, min(interval, STATS_RATE_MAX_INTERVAL))
+        self._stats_rates[display] = (interval, not live)
+        interval = min(i for i, _ in self._stats_rates.values())
+        paused = all(p for _, p in self._stats_rates.values())
+        if interval != self._stats_interval or paused != self._live_paused:
+            logging.info("Stats rate (display %d asked): every %.1fs, live stats %s",
+                         display, interval, "paused" if paused else "on")
+        self._stats_interval = interval
+        self._live_paused = paused
+
+    def _on_stats_subscribe(self, payload, display=0):
+        """A display reported the stats it currently shows.
+
+        Collection follows the union over every display that subscribed;
+        until one does (older firmware), every configured stat is sent.
+        """
+        if len(payload) < STATS_SUBSCRIBE.size:
+            return
+        (bits,) = STATS_SUBSCRIBE.unpack(payload)
+        types = frozenset(t for t in range(1, 32) if bits & (1 << t))
+        if self._stats_subs.get(display) == types:
+            return
+        self._stats_subs[display] = types
+        logging.info("Stats subscription (display %d): %s", display,
+                     ", ".join(STAT_ID_TO_NAME.get(t, f"0x{t:02X}") for t in sorted(types)) or "none")
+        self._stats_wanted = frozenset().union(*self._stats_subs.values())  # Read by the stats loop
+
+    def _subscribed(self, types):
+        """`types` narrowed to what some display shows (all of them before any subscribed)."""
+        wanted = self._stats_wanted
+        if wanted is None:
+            return list(types)
+        return [t for t in types if t in wanted]
+
+    def _on_bridge_stats(self, payload):
+        if len(payload) < BRIDGE_STATS.size:
+            return
+        prev = self._bridge_stats[-1] if self._bridge_stats else None
+        sample = decode_bridge_stats(payload, prev)
+        rates = sample["rates"]
+        if rates.get("rx_queue_drops") or rates.get("espnow_tx_failed"):
+            logging.warning("Bridge: %.1f RX drops/s, %.1f TX failures/s",
+                            rates["rx_queue_drops"], rates["espnow_tx_failed"])
+        if (sample["adapt_changes"] is not None and prev is not None
+                and sample["adapt_changes"] != prev.get("adapt_changes")):
+            logging.info("Bridge radio (%s): %.2f dBm, rate step %d, weakest display hears %s dBm",
+                         sample["adapt_reason"], sample["tx_power_dbm"], sample["phy_rate_step"],
+                         sample["far_rssi_dbm"])
+        self._bridge_stats.append(sample)
+        self._ipc.publish("bridge_stats", {"sample": sample})
+        if self.on_bridge_stats:
+            self.on_bridge_stats(sample)
+
+    def _on_bench_report(self, payload):
+        if len(payload) < BENCH_REPORT.size:
+            return
+        fields = BENCH_REPORT.unpack(payload)
+        rate, sent, received, elapsed_ms, tput_x10 = fields[:5]
+        self._bench_report = {
+            "rate_hz": rate,
+            "sent": sent,
+            "received": received,
+            "elapsed_ms": elapsed_ms,
+            "throughput": tput_x10 / 10.0,
+            "p50_us": dict(zip(BENCH_STAGES, fields[5:10])),
+            "p99_us": dict(zip(BENCH_STAGES, fields[10:15])),
+        }
+        self._bench_done.set()
+
+    def run_bench(self, rate_hz=50, count=500, timeout=None, display=None):
+        """Run the display's end-to-end latency benchmark and wait for its report.
+
+        rate_hz=0 floods with a fixed number of probes in flight, which gives
+        the throughput ceiling. With several displays on the bridge, pass the
+        display id to bench (otherwise all of them run at once). Returns the
+        report dict, or None on timeout.
+        """
+        count = max(1, min(count, BENCH_MAX_PROBES))
+        if timeout is None:
+            # Send phase (flood mode: assume >= 10 probes/s) plus the drain/report margin
+            timeout = count / (rate_hz or 10) + 10
+        device = self._device
+        if device is None:
+            return None
+        self._bench_done.clear()
+        self._bench_report = None
+        self._writer.submit(WRITE_CONTROL, MSG_BENCH_START, BENCH_START.pack(rate_hz, count), display)
+        logging.info("Benchmark started: %d probes at %s", count,
+                     f"{rate_hz} Hz" if rate_hz else "flood")
+        if not self._bench_done.wait(timeout):
+            return None
+        return self._bench_report
+
+    def _on_replay_report(self, payload):
+        if len(payload) < REPLAY_REPORT.size:
+            return
+        (op, status, events, duration_ms, frames, p50, p99, fmax, favg_us, flushes, flush_px,
+         flush_avg_us, heap_min, heap_delta, psram_min, name) = REPLAY_REPORT.unpack(payload)
+        self._replay_report = {
+            "op": op,
+            "status": status,
+            "name": name.split(b"\0", 1)[0].decode("ascii", "replace"),
+            "events": events,
+            "duration_ms": duration_ms,
+            "frames": frames,
+            "frame_p50_ms": p50,
+            "frame_p99_ms": p99,
+            "frame_max_ms": fmax,
+            "frame_avg_us": favg_us,
+            "flushes": flushes,
+            "flush_px": flush_px,
+            "flush_avg_us": flush_avg_us,
+            "heap_min_free": heap_min,
+            "heap_delta": heap_delta,
+            "psram_min_free": psram_min,
+        }
+        self._replay_done.set()
+
+    def replay_command(self, op, name="", loops=1, timeout=10.0, display=None):
+        """Send a MSG_REPLAY and wait up to timeout s for the display's report.
+
+        REPLAY_OP_RECORD only answers on failure (the report comes with the
+        REPLAY_OP_STOP that saves it), and a replay answers when it is done,
+        which wait_replay_report() keeps waiting for. Returns the report
+        dict, or None on timeout.
+        """
+        if self._device is None:
+            return None
+        self._replay_done.clear()
+        self._replay_report = None
+        raw = name.encode("ascii", "replace")[:REPLAY_NAME_MAX - 1]
+        self._writer.submit(WRITE_CONTROL, MSG_REPLAY, REPLAY_CMD.pack(op, loops, raw), display)
+        return self.wait_replay_report(timeout)
+
+    def wait_replay_report(self, timeout):
+        """The report of the last replay_command(), waiting up to timeout s."""
+        self._replay_done.wait(timeout)
+        return self._replay_report
+
+    def update_bridge_firmware(self, image: bytes, progress=None):
+        """Flash the bridge with a firmware.bin (or .bin.gz) over vendor HID.
+
+        Runs on the caller's thread while stats, notifications and button
+        presses carry on; the keyboard works until the bridge reboots into
+        the new image at the end (and the reader reconnects). Call again
+        after a failure to resume. progress(sent_bytes, total_bytes).
+        Raises BulkTransferError.
+        """
+        if self._device is None or self.is_wired:
+            raise BulkTransferError("bridge firmware: bridge not connected")
+        self._fw_xfer_id = (self._fw_xfer_id + 1) & 0xFF
+        xfer_id = self._fw_xfer_id
+        write, wait_ack = self._transfer_io(self._fw_acks, xfer_id, None, "bridge firmware")
+        logging.info("Bridge firmware: sending %d bytes", len(image))
+        send_firmware(write, wait_ack, xfer_id, image, progress)
+        logging.info("Bridge firmware: verified, bridge reboots when no key is held")
+
+    def update_display_firmware(self, image: bytes, display=None, progress=None, attempts: int = 3):
+        """Flash a display over ESP-NOW through the bridge, no WiFi needed.
+
+        The display keeps working while its idle OTA slot fills and swaps to
+        the new image the next time it dims or shows the clock. A dropout
+        (ACKs stop) is resumed from the display's last stored offset up to
+        `attempts` times. display=None flashes the only (or first answering)
+        display. progress(sent_bytes, total_bytes). Raises BulkTransferError.
+        """
+        if self._device is None:
+            raise BulkTransferError("display firmware: bridge not connected")
+        self._fw_xfer_id = (self._fw_xfer_id + 1) & 0x7F
+        xfer_id = self._fw_xfer_id    # Kept across resumes: the display matches on it too
+        with self._bulk_lock:
+            self._bulk_display = display
+            write, wait_ack = self._transfer_io(self._bulk_acks, xfer_id, display, "display firmware")
+            logging.info("Display firmware: sending %d bytes over ESP-NOW", len(image))
+            for attempt in range(attempts):
+                try:
+                    send_display_firmware(write, wait_ack, xfer_id, image, progress)
+                    break
+                except BulkTransferError as exc:
+                    if not exc.timed_out or attempt == attempts - 1:
+                        raise
+                    logging.warning("Display firmware: %s, resuming", exc)
+                    time.sleep(2)   # Let a link hunt or channel move settle
+        logging.info("Display firmware: verified, display restarts the next time it is idle")
+
+    def _transfer_io(self, acks, xfer_id, display, name):
+        """write/wait_ack pair for push_chunks() over the shared device, fed by the reader."""
+        while not acks.empty():
+            acks.get_nowait()
+
+        def write(msg_type, payload):
+            if self._device is None or not self._writer.submit(WRITE_BULK, msg_type, payload, display,
+                                                               wait=BULK_WRITE_TIMEOUT):
+                raise BulkTransferError(f"{name}: bridge disconnected")
+
+        def wait_ack(timeout):
+            # Newest state wins, as in BridgeDevice._wait_bulk_ack
+            best = None
+            deadline = time.monotonic() + timeout
+            while True:
+                try:
+                    wait = 0 if best is not None else max(deadline - time.monotonic(), 0)
+                    ack = acks.get(timeout=wait) if wait else acks.get_nowait()
+                except queue.Empty:
+                    return best
+                ack_id, status, next_offset = BULK_ACK.unpack(ack)
+                if ack_id != xfer_id:
+                    continue
+                if status != BULK_OK:
+                    return status, next_offset
+                if best is None or next_offset > best[1]:
+                    best = (status, next_offset)
+
+        return write, wait_ack
+
+    def _focus_loop(self):
+        """Follow window focus: switch the display to the profile mapped to the focused app.
+
+        With a compositor IPC connection (window_tracker) this wakes on its
+        focus events; otherwise the focused window is polled with the
+        command-line tools every FOCUS_POLL_INTERVAL.
+        """
+        from companion.app_scanner import get_active_wm_class
+        from companion.window_tracker import get_window_tracker
+
+        tracker = get_window_tracker()
+        focus_changed = threading.Event()
+        tracker.add_focus_listener(lambda _wm_class: focus_changed.set())
+
+        while self._running:
+            focus_changed.wait(FOCUS_POLL_INTERVAL)
+            focus_changed.clear()
+            enabled, default_profile, app_map, profile_displays = self._focus_config
+            if not enabled or self._device is None:
+                self._focus_profile = None  # Re-send once the bridge is back
+                continue
+            wm_class = tracker.active_class() if tracker.connected else get_active_wm_class()
+            if not wm_class:
+                continue  # Unknown (no WM tool, desktop focused): keep the current profile
+            target = app_map.get(wm_class.lower(), default_profile)
+            display = profile_displays.get(target)
+            if not target or (target, display) == self._focus_profile:
+                continue
+            if send_profile_switch(self._device, target, self._writer, display):
+                self._focus_profile = (target, display)
+
+    def _remote_image_sources(self):
+        """{source: (width, height)} the active profile's remote image widgets ask for."""
+        wanted = {}
+        profile = self._config_mgr.get_active_profile() or {}
+        for page in profile.get("pages", []):
+            for widget in page.get("widgets", []):
+                if widget.get("widget_type") != WIDGET_REMOTE_IMAGE:
+                    continue
+                source = widget.get("image_source", "")
+                if not source:
+                    continue
+                w, h = wanted.get(source, (0, 0))
+                wanted[source] = (max(w, widget.get("width", 0)), max(h, widget.get("height", 0)))
+        return wanted
+
+    def _push_remote_image(self, source, stream, frame):
+        """Send the patches taking the display to `frame`; False if the display never answered."""
+        for seq, patch in stream.patches(frame):
+            self._image_xfer_id = 0x80 | ((self._image_xfer_id + 1) & 0x7F)
+            xfer_id = self._image_xfer_id
+            write, wait_ack = self._transfer_io(self._bulk_acks, xfer_id, None, "remote image")
+            try:
+                send_remote_image(write, wait_ack, xfer_id, source, patch)
+            except BulkTransferError as exc:
+                logging.debug("Remote image %s: %s", source, exc)
+                stream.reset()   # Key frame next pass
+                return not exc.no_response
+            stream.commit(seq)
+        return True
+
+    def _remote_image_loop(self):
+        """Stream the sources of WIDGET_REMOTE_IMAGE widgets to the display as tile patches."""
+        from companion.remote_image import RemoteImageStream, fetch_source, rgb565_frame
+
+        while self._running:
+            time.sleep(REMOTE_IMAGE_INTERVAL)
+            if self._device is None:
+                self._image_streams.clear()   # The display may have rebooted meanwhile
+                continue
+            wanted = self._remote_image_sources()
+            for source in list(self._image_streams):
+                if source not in wanted:
+                    del self._image_streams[source]
+            for source, (w, h) in wanted.items():
+                size, stream = self._image_streams.get(source, (None, None))
+                if size != (w, h):   # New, or a widget was resized
+                    stream = RemoteImageStream(w, h)
+                    self._image_streams[source] = ((w, h), stream)
+                img = fetch_source(source)
+                if img is None:
+                    continue
+                frame = rgb565_frame(img, stream.width, stream.height)
+                if not self._bulk_lock.acquire(blocking=False):
+                    break   # Firmware update running
+                try:
+                    answered = self._push_remote_image(source, stream, frame)
+                finally:
+                    self._bulk_lock.release()
+                if not answered:
+                    time.sleep(REMOTE_IMAGE_BACKOFF)
+                    break
+
+    def _log_writer_stats(self):
+        """Every WRITER_LOG_INTERVAL: submit-to-written latency per message class."""
+        now = time.monotonic()
+        if now - self._writer_log_time < WRITER_LOG_INTERVAL:
+            return
+        self._writer_log_time = now
+        for name, st in self._writer.stats().items():
+            if st["sent"] or st["failed"]:
+                logging.debug("HID writer %s: %d sent, %d merged, %d failed, p50 %s ms, p99 %s ms, max %s ms",
+                              name, st["sent"], st["merged"], st["failed"],
+                              st["p50_ms"], st["p99_ms"], st["max_ms"])
+
     def _stats_loop(self, notif_enabled, notif_filter):
         """Main loop: bridge discovery, stats streaming, reconnection."""
         global running
@@ -1476,63 +2866,74 @@ class CompanionService:
             threading.Thread(
                 target=_run_notification_listener,
                 args=(notif_filter,
-                      lambda app, s, b: send_notification_to_display(
-                          self._device, app, s, b, self._hid_lock)),
+                      lambda app, s, b, u: send_notification_to_display(
+                          self._device, app, s, b, u, self._writer)),
                 daemon=True
             ).start()
 
         # Initialize baselines (per-interface/device if configured)
-        try:
-            if self._net_interface:
-                prev_net = psutil.net_io_counters(pernic=True).get(self._net_interface)
-                if prev_net is None:
-                    logging.warning("NIC '%s' not found, falling back to aggregate", self._net_interface)
-                    prev_net = psutil.net_io_counters()
-            else:
-                prev_net = psutil.net_io_counters()
-        except Exception:
-            prev_net = psutil.net_io_counters()
+        prev_net, prev_disk_io = read_counter_baselines(self._net_interface, self._disk_device)
         prev_time = time.time()
-        prev_disk_io = None
-        try:
-            if self._disk_device:
-                per_disk = psutil.disk_io_counters(perdisk=True)
-                prev_disk_io = per_disk.get(self._disk_device)
-                if prev_disk_io is None:
-                    logging.warning("Disk '%s' not found, falling back to aggregate", self._disk_device)
-                    prev_disk_io = psutil.disk_io_counters()
-            else:
-                prev_disk_io = psutil.disk_io_counters()
-        except Exception:
-            pass
+        stat_types = self._subscribed(self._enabled_stat_types)
 
-        logging.info("Streaming TLV stats at %.1f Hz (%d stat types)",
-                     1.0 / UPDATE_INTERVAL, len(self._enabled_stat_types))
+        logging.info("Streaming TLV stats at %.1f Hz (%d stat types, %d live at %d Hz)",
+                     1.0 / UPDATE_INTERVAL, len(self._enabled_stat_types),
+                     len(self._live_stat_types), self._live_rate)
 
         pc_locked = False
         TIME_SYNC_INTERVAL = 12 * 3600  # Sync time every 12 hours
         last_time_sync = 0  # Force immediate sync on first loop
+        next_full = time.time() + UPDATE_INTERVAL  # Next 1 Hz pass over every enabled stat
 
         while self._running:
             if shutdown_event.is_set():
                 logging.info("System shutdown detected, notifying bridge...")
-                send_power_state(self._device, POWER_SHUTDOWN, self._hid_lock)
+                send_power_state(self._device, POWER_SHUTDOWN, self._writer, wait=1.0)
                 self._running = False
                 running = False
                 break
 
+            # Suspend / resume: clock on the display while asleep; the first
+            # power state after resume ends the bridge's wake measurement
+            if sleep_event.is_set():
+                sleep_event.clear()
+                logging.info("System going to sleep, notifying bridge...")
+                send_power_state(self._device, POWER_SHUTDOWN, self._writer, wait=1.0)
+                sleep_sent_event.set()
+            if resume_event.is_set():
+                resume_event.clear()
+                send_power_state(self._device, POWER_LOCKED if pc_locked else POWER_WAKE, self._writer)
+                self._stats_delta.reset()
+
             # Session lock/unlock detection
             if self._follow_lock:
                 if lock_event.is_set() and not pc_locked:
                     pc_locked = True
                     logging.info("Sending POWER_LOCKED to display")
-                    send_power_state(self._device, POWER_LOCKED, self._hid_lock)
+                    send_power_state(self._device, POWER_LOCKED, self._writer)
                 elif unlock_event.is_set() and pc_locked:
                     pc_locked = False
                     logging.info("Sending POWER_WAKE to display (unlocked)")
-                    send_power_state(self._device, POWER_WAKE, self._hid_lock)
-
-            time.sleep(UPDATE_INTERVAL)
+                    send_power_state(self._device, POWER_WAKE, self._writer)
+                    self._stats_delta.reset()
+
+            # Live stats: wake at the live rate, folding the 1 Hz pass into
+            # whichever tick reaches its deadline
+            # What the displays show (MSG_STATS_SUBSCRIBE): a type coming
+            # back needs a fresh counter baseline, and every change a keyframe
+            types = self._subscribed(self._enabled_stat_types)
+            if types != stat_types:
+                if COUNTER_STATS & (set(types) - set(stat_types)):
+                    prev_net, prev_disk_io = read_counter_baselines(self._net_interface, self._disk_device)
+                    prev_time = time.time()
+                stat_types = types
+                self._stats_delta.reset()
+            live_types = [] if self._live_paused else self._subscribed(self._live_stat_types)
+            next_full = min(next_full, time.time() + self._stats_interval)  # Rate raised meanwhile
+            wait = next_full - time.time()
+            if live_types:
+                wait = min(wait, 1.0 / self._live_rate)
+            time.sleep(max(0.0, wait))
             if not self._running:
                 break
 
@@ -1540,25 +2941,48 @@ class CompanionService:
             if pc_locked:
                 continue
 
-            packed, prev_net, prev_time, prev_disk_io = collect_stats_tlv(
-                self._gpu, self._enabled_stat_types, prev_net, prev_time, prev_disk_io,
-                self._net_interface, self._disk_device, self._disk_mount,
-                self._proc_update_interval, self._proc_state
-            )
+            # Remote collectors: whatever their threads brought in since last tick
+            self._send_remote_stats()
+
+            if time.time() >= next_full:
+                next_full += self._stats_interval
+                if next_full < time.time():
+                    next_full = time.time() + self._stats_interval  # Fell behind: don't catch up in a burst
+                packed, prev_net, prev_time, prev_disk_io = collect_stats_tlv(
+                    self._gpu, stat_types, prev_net, prev_time, prev_disk_io,
+                    self._net_interface, self._disk_device, self._disk_mount,
+                    self._proc_update_interval, self._proc_state, self._stats_delta,
+                    self._stats_profiler
+                )
+                if packed is None:
+                    continue  # Nothing moved past its hysteresis; keyframe will follow
+            else:
+                # Live tick: every live gauge, no hysteresis, so the display
+                # sees a steady stream; counter baselines are left to the 1 Hz pass
+                packed, _, _, _ = collect_stats_tlv(
+                    self._gpu, live_types, prev_net, prev_time, prev_disk_io,
+                    self._net_interface, self._disk_device, self._disk_mount,
+                    self._proc_update_interval, self._proc_state, None,
+                    self._stats_profiler
+                )
 
-            try:
-                with self._hid_lock:
-                    self._device.write(b"\x06" + bytes([MSG_STATS]) + packed)
+            # Latest wins: a packet still queued behind control messages or
+            # notifications takes this one's values instead of queueing twice
+            if self._writer.submit(WRITE_STATS, MSG_STATS, packed, coalesce=merge_stats_tlv):
                 self._stats_count += 1
                 if self.on_stats_sent:
                     self.on_stats_sent()
-            except (IOError, OSError) as exc:
-                logging.warning("HID write failed (device disconnected?): %s", exc)
-                try:
-                    self._device.close()
-                except Exception:
-                    pass
-                self._device = None
+            self._log_writer_stats()
+
+            if self._write_error.is_set():
+                logging.warning("HID write failed (device disconnected?)")
+                with self._hid_lock:
+                    try:
+                        self._device.close()
+                    except Exception:
+                        pass
+                    self._device = None
+                self._write_error.clear()
                 self._set_bridge_connected(False)
 
                 # Reconnect
@@ -1569,6 +2993,8 @@ class CompanionService:
                     target=self._vendor_read_loop, daemon=True
                 )
                 self._vendor_thread.start()
+                self._stats_delta.reset()
+                self._remote_delta = {}
                 prev_net = psutil.net_io_counters()
                 prev_time = time.time()
                 continue
@@ -1576,7 +3002,7 @@ class CompanionService:
             if self._device is not None:
                 now = time.time()
                 if now - last_time_sync >= TIME_SYNC_INTERVAL:
-                    send_time_sync(self._device, self._hid_lock)
+                    send_time_sync(self._device, self._writer)
                     last_time_sync = now
 
         # Clean up
@@ -1593,9 +3019,73 @@ class CompanionService:
 # Headless CLI entry point
 # ---------------------------------------------------------------------------
 
+def print_bench_report(report):
+    """Print a run_bench() report as a per-stage table."""
+    rate = f"{report['rate_hz']} Hz" if report['rate_hz'] else "flood"
+    print(f"Latency benchmark ({rate}): {report['received']}/{report['sent']} probes "
+          f"in {report['elapsed_ms']} ms, {report['throughput']:.1f} presses/s")
+    print(f"  {'stage':<10} {'p50 (ms)':>9} {'p99 (ms)':>9}")
+    for stage in BENCH_STAGES:
+        print(f"  {stage:<10} {report['p50_us'][stage] / 1000:9.2f} {report['p99_us'][stage] / 1000:9.2f}")
+
+
+def print_replay_report(report):
+    """Print a replay_command() report."""
+    status = REPLAY_STATUS.get(report["status"], report["status"])
+    if report["op"] != REPLAY_OP_RUN:
+        print(f"Recording '{report['name']}': {status}, {report['events']} events "
+              f"over {report['duration_ms'] / 1000:.1f} s")
+        return
+    print(f"Replay '{report['name']}': {status}, {report['events']} events "
+          f"in {report['duration_ms'] / 1000:.1f} s")
+    print(f"  frames  {report['frames']}, p50 {report['frame_p50_ms']} ms, p99 {report['frame_p99_ms']} ms, "
+          f"max {report['frame_max_ms']} ms, avg {report['frame_avg_us'] / 1000:.2f} ms")
+    print(f"  flushes {report['flushes']}, {report['flush_px']} px, avg {report['flush_avg_us']} us each")
+    print(f"  heap    min free {report['heap_min_free']}, delta {report['heap_delta']:+d}; "
+          f"PSRAM min free {report['psram_min_free']}")
+
+
 def main():
     global running
 
+    parser = argparse.ArgumentParser(description="Hotkey Bridge Companion")
+    parser.add_argument("--bench", action="store_true",
+                        help="run the end-to-end latency benchmark, print it and exit")
+    parser.add_argument("--bench-rate", type=int, default=50,
+                        help="benchmark probes per second (0 = flood, for the throughput ceiling)")
+    parser.add_argument("--bench-count", type=int, default=500,
+                        help="benchmark probes to send (max %d)" % BENCH_MAX_PROBES)
+    parser.add_argument("--bench-display", type=int, default=None,
+                        help="display id to benchmark when the bridge serves several")
+    parser.add_argument("--hw-bench", action="store_true",
+                        help="run the display's hardware benchmark over its config SoftAP, "
+                             "store and print it, and exit")
+    parser.add_argument("--hw-bench-ip", default="192.168.4.1",
+                        help="display address for --hw-bench (default %(default)s)")
+    parser.add_argument("--hw-bench-label", default="",
+                        help="note stored with the run (unit, SD card, ...)")
+    parser.add_argument("--hw-bench-list", action="store_true",
+                        help="print every stored hardware benchmark run and exit")
+    parser.add_argument("--record", metavar="NAME",
+                        help="record panel input to /replay/NAME.rec on the display until Enter")
+    parser.add_argument("--replay", metavar="NAME",
+                        help="replay /replay/NAME.rec on the display, print its measurements and exit")
+    parser.add_argument("--replay-loops", type=int, default=1,
+                        help="passes over the recording in one replay (1-255)")
+    parser.add_argument("--flash-bridge", metavar="FIRMWARE",
+                        help="update the bridge over USB HID with a firmware.bin (.gz) and exit")
+    parser.add_argument("--flash-display", metavar="FIRMWARE",
+                        help="update a display over ESP-NOW with a firmware.bin (.gz) and exit")
+    parser.add_argument("--flash-display-id", type=int, default=None,
+                        help="display id to flash when the bridge serves several")
+    parser.add_argument("--profile-stats", action="store_true",
+                        help="log what each enabled stat costs to collect, every %d s" % STATS_PROFILE_INTERVAL)
+    parser.add_argument("--no-wired", action="store_true",
+                        help="don't look for a display on its own USB port, only for the bridge")
+    parser.add_argument("--wired-baud", type=int, default=WIRED_BAUD,
+                        help="baud rate of a wired display (its WIRED_LINK_BAUD, default %(default)s)")
+    args = parser.parse_args()
+
     logging.basicConfig(
         level=logging.INFO,
         format="%(asctime)s [%(levelname)s] %(message)s",
@@ -1605,10 +3095,107 @@ def main():
     signal.signal(signal.SIGINT, _signal_handler)
     signal.signal(signal.SIGTERM, _signal_handler)
 
+    if args.hw_bench or args.hw_bench_list:
+        # Plain HTTP to the display in config mode: no bridge needed
+        from companion import hw_bench
+        from companion.http_client import HTTPClient, HTTPClientError
+        if args.hw_bench:
+            try:
+                record = hw_bench.run_hw_bench(HTTPClient(args.hw_bench_ip), args.hw_bench_label)
+            except HTTPClientError as exc:
+                logging.error("Hardware benchmark failed: %s", exc)
+                sys.exit(1)
+            if record is None:
+                logging.error("Hardware benchmark failed: display firmware has no /api/bench")
+                sys.exit(1)
+            records = [record]
+        else:
+            records = hw_bench.load_results()
+        print(hw_bench.format_results(records))
+        return
+
     logging.info("Hotkey Bridge Companion starting (headless)...")
 
-    service = CompanionService()
-    service.start()
+    service = CompanionService(wired=not args.no_wired, wired_baud=args.wired_baud)
+    if args.profile_stats:
+        service.profile_stats()
+    try:
+        service.start()
+    except ServiceRunningError as exc:
+        logging.error("Not starting: %s", exc)
+        sys.exit(1)
+
+    if args.bench:
+        # Wait for the bridge (and the vendor reader) before starting the run
+        deadline = time.monotonic() + 30
+        while running and not service.is_bridge_connected and time.monotonic() < deadline:
+            time.sleep(0.2)
+        time.sleep(0.5)
+        report = service.run_bench(args.bench_rate, args.bench_count,
+                                   display=args.bench_display) if service.is_bridge_connected else None
+        service.stop()
+        if report is None:
+            logging.error("Benchmark failed: no report from the display")
+            sys.exit(1)
+        print_bench_report(report)
+        return
+
+    if args.record or args.replay:
+        deadline = time.monotonic() + 30
+        while running and not service.is_bridge_connected and time.monotonic() < deadline:
+            time.sleep(0.2)
+        time.sleep(0.5)
+        report = None
+        if service.is_bridge_connected and args.record:
+            report = service.replay_command(REPLAY_OP_RECORD, args.record, timeout=1.0)
+            if report is None:
+                # No answer means it's recording: wait for Enter (or Ctrl-C)
+                enter = threading.Event()
+                threading.Thread(target=lambda: (sys.stdin.readline(), enter.set()), daemon=True).start()
+                print(f"Recording '{args.record}' -- use the panel, then press Enter")
+                while running and not enter.is_set():
+                    time.sleep(0.1)
+                report = service.replay_command(REPLAY_OP_STOP, timeout=10.0)
+        elif service.is_bridge_connected:
+            loops = max(1, min(args.replay_loops, 255))
+            report = service.replay_command(REPLAY_OP_RUN, args.replay, loops, timeout=1.0)
+            while report is None and running:
+                report = service.wait_replay_report(0.5)
+            if report is None:
+                # Ctrl-C: cut the replay short, it still reports what it measured
+                report = service.replay_command(REPLAY_OP_STOP, timeout=10.0)
+        service.stop()
+        if report is None:
+            logging.error("No report from the display")
+            sys.exit(1)
+        print_replay_report(report)
+        sys.exit(0 if report["status"] == 0 else 1)
+
+    if args.flash_bridge or args.flash_display:
+        with open(args.flash_bridge or args.flash_display, "rb") as f:
+            image = f.read()
+        deadline = time.monotonic() + 30
+        while running and not service.is_bridge_connected and time.monotonic() < deadline:
+            time.sleep(0.2)
+        target = "Bridge" if args.flash_bridge else "Display"
+        last_pct = [-1]
+
+        def progress(sent, total):
+            pct = sent * 100 // max(total, 1)
+            if pct // 10 != last_pct[0] // 10:
+                logging.info("%s firmware: %d%%", target, pct)
+            last_pct[0] = pct
+        try:
+            if args.flash_bridge:
+                service.update_bridge_firmware(image, progress)
+            else:
+                service.update_display_firmware(image, args.flash_display_id, progress)
+        except BulkTransferError as exc:
+            service.stop()
+            logging.error("%s update failed: %s", target, exc)
+            sys.exit(1)
+        service.stop()
+        return
 
     try:
         while running:
@@ -7,7 +7,9 @@ Parses device responses and provides error feedback.
 
 import requests
 import time
-from typing import Dict, Any
+import zlib
+from concurrent.futures import ThreadPoolExecutor
+from typing import Dict, Any, List, Optional
 
 
 class HTTPClientError(Exception):
@@ -24,18 +26,28 @@ class HTTPClient:
         self.port = port
         self.timeout = timeout
         self.base_url = f"http://{device_ip}:{port}"
+        # Uploads the device takes at once ("workers" in /api/health; older
+        # firmware serves one request at a time and doesn't say)
+        self.upload_slots = 1
 
     def health_check(self) -> bool:
         """
         Check if device is reachable via /api/health endpoint.
         Returns True if device responds with 200, False otherwise.
+        Also picks up how many uploads it takes in parallel.
         """
         try:
             response = requests.get(
                 f"{self.base_url}/api/health",
                 timeout=3,
             )
-            return response.status_code == 200
+            if response.status_code != 200:
+                return False
+            try:
+                self.upload_slots = max(1, int(response.json().get("workers", 1)))
+            except (ValueError, TypeError, AttributeError):
+                self.upload_slots = 1
+            return True
         except (requests.ConnectionError, requests.Timeout):
             return False
         except Exception:
@@ -82,6 +94,10 @@ class HTTPClient:
         files = {
             "config": (filename, json_str, "application/json"),
         }
+        # Device checks the CRC-32 of what it stored before replacing config.json
+        form_data = {
+            "crc32": f"{zlib.crc32(json_str.encode('utf-8')):08x}",
+        }
 
         # Retry logic: up to 3 attempts with 5-second interval
         for attempt in range(3):
@@ -89,6 +105,7 @@ class HTTPClient:
                 response = requests.post(
                     url,
                     files=files,
+                    data=form_data,
                     timeout=self.timeout,
                 )
 
@@ -168,9 +185,12 @@ class HTTPClient:
         files = {
             "image": (filename, data, "image/png"),
         }
+        form_data = {
+            "crc32": f"{zlib.crc32(data):08x}",
+        }
 
         try:
-            response = requests.post(url, files=files, timeout=self.timeout)
+            response = requests.post(url, files=files, data=form_data, timeout=self.timeout)
 
             if response.status_code == 200:
                 try:
@@ -213,6 +233,8 @@ class HTTPClient:
             mime = "image/jpeg"
         elif lower.endswith(".bmp"):
             mime = "image/bmp"
+        elif lower.endswith(".gif"):
+            mime = "image/gif"
         else:
             mime = "image/png"
 
@@ -221,6 +243,7 @@ class HTTPClient:
         }
         form_data = {
             "folder": folder,
+            "crc32": f"{zlib.crc32(data):08x}",
         }
 
         try:
@@ -291,6 +314,129 @@ class HTTPClient:
         except Exception as e:
             raise HTTPClientError(f"SD list failed: {str(e)}")
 
+    def sd_manifest(self, path: str) -> Optional[Dict[str, Dict[str, Any]]]:
+        """
+        Size and CRC-32 of every file in an SD card directory.
+
+        Args:
+            path: Directory path on SD card (e.g. "/icons")
+
+        Returns:
+            Dict of filename -> {"size": int, "crc32": int}, or None if the
+            firmware predates /api/sd/manifest
+
+        Raises:
+            HTTPClientError: On connection failure
+        """
+        url = f"{self.base_url}/api/sd/manifest"
+        try:
+            # Device hashes every file before answering
+            response = requests.get(url, params={"path": path}, timeout=30)
+            if response.status_code == 404:
+                body = response.text
+                if "Not a directory" in body:
+                    return {}
+                return None
+            response.raise_for_status()
+            return {
+                f["name"]: {"size": f["size"], "crc32": int(f["crc32"], 16)}
+                for f in response.json().get("files", [])
+            }
+        except requests.Timeout:
+            raise HTTPClientError("SD manifest request timeout")
+        except requests.ConnectionError:
+            raise HTTPClientError("Cannot reach device")
+        except Exception as e:
+            raise HTTPClientError(f"SD manifest failed: {str(e)}")
+
+    def sd_batch_upload(self, folder: str, files: Dict[str, bytes]) -> Dict[str, Any]:
+        """
+        Upload several files into one SD card folder in a single request.
+
+        Returns:
+            Device response: "success", "stored", "failed" and a "files" list
+            of {"path", "size", "crc32"} or {"path", "error"}
+
+        Raises:
+            HTTPClientError: On connection failure
+        """
+        url = f"{self.base_url}/api/sd/batch"
+        # Part field name is the destination folder
+        parts = [(folder, (name, data, "application/octet-stream")) for name, data in files.items()]
+        total = sum(len(d) for d in files.values())
+        try:
+            # SoftAP throughput is ~200 KB/s at worst; allow for it plus SD writes
+            response = requests.post(url, files=parts, timeout=self.timeout + total / 100_000)
+            try:
+                return response.json()
+            except Exception:
+                return {"success": False, "error": f"HTTP {response.status_code}", "files": []}
+        except requests.Timeout:
+            raise HTTPClientError("Batch upload timeout")
+        except requests.ConnectionError:
+            raise HTTPClientError("Cannot reach device for batch upload")
+        except Exception as e:
+            raise HTTPClientError(f"Batch upload failed: {str(e)}")
+
+    def sync_folder(self, folder: str, files: Dict[str, bytes],
+                    batch_bytes: int = 512 * 1024) -> List[str]:
+        """
+        Make /<folder> on the SD card contain `files`, sending only files whose
+        size or CRC-32 differ from the device's manifest. Nothing is deleted.
+
+        Falls back to one upload per file on firmware without the manifest.
+        Batches go up side by side, as many as the device has upload slots
+        (see health_check()).
+
+        Returns:
+            List of "name: error" warnings (empty when everything is in sync)
+
+        Raises:
+            HTTPClientError: On connection failure
+        """
+        if not files:
+            return []
+        manifest = self.sd_manifest(f"/{folder}")
+        warnings = []
+        if manifest is None:
+            for name, data in files.items():
+                result = self.sd_upload_image(name, data, folder=folder)
+                if not result.get("success"):
+                    warnings.append(f"{name}: {result.get('error', 'unknown')}")
+            return warnings
+
+        changed = {
+            name: data for name, data in files.items()
+            if manifest.get(name) != {"size": len(data), "crc32": zlib.crc32(data)}
+        }
+        expected = {f"/{folder}/{name}": zlib.crc32(data) for name, data in changed.items()}
+
+        batch, batch_size = {}, 0
+        batches = []
+        for name, data in changed.items():
+            if batch and batch_size + len(data) > batch_bytes:
+                batches.append(batch)
+                batch, batch_size = {}, 0
+            batch[name] = data
+            batch_size += len(data)
+        if batch:
+            batches.append(batch)
+
+        with ThreadPoolExecutor(max_workers=max(1, min(self.upload_slots, len(batches)))) as pool:
+            results = list(pool.map(lambda b: self.sd_batch_upload(folder, b), batches))
+        for batch, result in zip(batches, results):
+            reported = {f.get("path"): f for f in result.get("files", [])}
+            for name in batch:
+                path = f"/{folder}/{name}"
+                entry = reported.get(path)
+                if entry is None:
+                    warnings.append(f"{name}: {result.get('error', 'not stored')}")
+                elif "error" in entry:
+                    warnings.append(f"{name}: {entry['error']}")
+                elif int(entry.get("crc32", "0"), 16) != expected[path]:
+                    warnings.append(f"{name}: CRC mismatch after upload")
+        return warnings
+
     def sd_delete(self, path: str) -> Dict[str, Any]:
         """
         Delete a file from SD card.
@@ -319,3 +465,134 @@ class HTTPClient:
             raise HTTPClientError(f"SD delete failed: {str(e)}")
         except Exception as e:
             raise HTTPClientError(f"SD delete failed: {str(e)}")
+
+    def screenshot(self, fmt: str = "png") -> Optional[bytes]:
+        """
+        The panel as it is rendered now, for comparing against the editor's
+        preview.
+
+        Args:
+            fmt: "png" (compressed, the default) or "bmp" (uncompressed)
+
+        Returns:
+            The image file's bytes, or None if the firmware predates
+            /api/screenshot
+
+        Raises:
+            HTTPClientError: On connection failure or if the device is out of memory
+        """
+        url = f"{self.base_url}/api/screenshot"
+        try:
+            response = requests.get(url, params={"format": fmt}, timeout=30)
+            if response.status_code == 404:
+                return None
+            response.raise_for_status()
+            return response.content
+        except requests.Timeout:
+            raise HTTPClientError("Screenshot request timeout")
+        except requests.ConnectionError:
+            raise HTTPClientError("Cannot reach device")
+        except Exception as e:
+            raise HTTPClientError(f"Screenshot failed: {str(e)}")
+
+    def hw_bench(self, png_path: Optional[str] = None,
+                 jpeg_path: Optional[str] = None) -> Optional[Dict[str, Any]]:
+        """
+        Run the display's hardware microbenchmarks (display/hw_bench.h).
+
+        Args:
+            png_path: Reference PNG on the SD card (firmware default /bench/ref.png)
+            jpeg_path: Reference SJPG/JPEG (firmware default /bench/ref.sjpg)
+
+        Returns:
+            The results ("draw", "flush", "sd", "decode", "config_load",
+            "espnow_ping", "i2c"; stages that couldn't run are missing), or
+            None if the firmware predates /api/bench
+
+        Raises:
+            HTTPClientError: On connection failure or if a run is already going
+        """
+        url = f"{self.base_url}/api/bench"
+        params = {}
+        if png_path:
+            params["png"] = png_path
+        if jpeg_path:
+            params["jpeg"] = jpeg_path
+        try:
+            response = requests.post(url, params=params, timeout=60)
+            if response.status_code == 404:
+                return None
+            if response.status_code == 409:
+                raise HTTPClientError("A benchmark is already running on the device")
+            response.raise_for_status()
+            return response.json()
+        except HTTPClientError:
+            raise
+        except requests.Timeout:
+            raise HTTPClientError("Benchmark request timeout")
+        except requests.ConnectionError:
+            raise HTTPClientError("Cannot reach device")
+        except Exception as e:
+            raise HTTPClientError(f"Benchmark failed: {str(e)}")
+
+    def layout_budget(self) -> Optional[Dict[str, Any]]:
+        """
+        The display's layout cost table and page budgets (display/config_cost.h).
+
+        Returns:
+            The /api/budget reply ("max_pages", "max_widgets", "page",
+            "widgets"), or None if the firmware predates it
+
+        Raises:
+            HTTPClientError: On connection failure
+        """
+        url = f"{self.base_url}/api/budget"
+        try:
+            response = requests.get(url, timeout=self.timeout)
+            if response.status_code == 404:
+                return None
+            response.raise_for_status()
+            return response.json()
+        except requests.Timeout:
+            raise HTTPClientError("Budget request timeout")
+        except requests.ConnectionError:
+            raise HTTPClientError("Cannot reach device")
+        except Exception as e:
+            raise HTTPClientError(f"Budget request failed: {str(e)}")
+
+    def stats_history(self, stat_type: int, hours: int = 24, points: int = 288,
+                      host: Optional[int] = None) -> Optional[Dict[str, Any]]:
+        """
+        One stat's trend from the display's SD log, as evenly spaced averages.
+
+        Args:
+            stat_type: StatType value (tenths for the tenths types)
+            hours: How far back, ending now
+            points: Number of averages (at most 1440)
+            host: Host slot; the active one if not given
+
+        Returns:
+            {"type", "host", "from" (Unix seconds), "step_s", "values"} with
+            None where nothing was logged, or None if the firmware predates
+            /api/stats/history
+
+        Raises:
+            HTTPClientError: On connection failure, or when the display's clock
+                isn't set or it has no log
+        """
+        url = f"{self.base_url}/api/stats/history"
+        params = {"type": stat_type, "hours": hours, "points": points}
+        if host is not None:
+            params["host"] = host
+        try:
+            response = requests.get(url, params=params, timeout=15)
+            if response.status_code == 404:
+                return None
+            response.raise_for_status()
+            return response.json()
+        except requests.Timeout:
+            raise HTTPClientError("Stats history request timeout")
+        except requests.ConnectionError:
+            raise HTTPClientError("Cannot reach device")
+        except Exception as e:
+            raise HTTPClientError(f"Stats history failed: {str(e)}")
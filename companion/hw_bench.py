@@ -0,0 +1,171 @@
+"""
+Hardware benchmark: run the display's /api/bench and keep the results.
+
+The display measures its own fill/blend and flush rates, SD throughput,
+image decode, config parse, ESP-NOW round trips and I2C latency
+(display/hw_bench.h). This side puts the reference images on its card
+first, so every unit decodes the same files, and appends each run to
+~/.config/crowpanel/hw_bench.jsonl for comparing units and SD cards.
+"""
+
+import hashlib
+import json
+import logging
+import os
+import tempfile
+import time
+from io import BytesIO
+from typing import Any, Dict, List, Optional
+
+from PIL import Image
+
+from companion.config_manager import DEFAULT_CONFIG_DIR
+from companion.http_client import HTTPClient, HTTPClientError
+from companion.image_optimizer import optimize_for_sjpg
+
+logger = logging.getLogger(__name__)
+
+RESULTS_PATH = DEFAULT_CONFIG_DIR / "hw_bench.jsonl"
+REF_FOLDER = "bench"
+REF_PNG = "ref.png"      # Names the firmware looks for by default
+REF_SJPG = "ref.sjpg"
+REF_PNG_SIZE = 256       # A large icon: what the icon cache decodes most
+
+
+def _reference_image(width: int, height: int) -> Image.Image:
+    """Gradients with hard edges and an alpha ramp: nothing compresses away."""
+    img = Image.new("RGBA", (width, height))
+    px = img.load()
+    for y in range(height):
+        for x in range(width):
+            checker = 255 if (x // 16 + y // 16) % 2 else 0
+            px[x, y] = ((x * 255) // width, (y * 255) // height, ((x ^ y) & 0xFF) ^ checker,
+                        64 + (x * 191) // width)
+    return img
+
+
+def reference_images() -> Dict[str, bytes]:
+    """The reference PNG (RGBA) and SJPG (800x480), as file name -> bytes."""
+    buf = BytesIO()
+    _reference_image(REF_PNG_SIZE, REF_PNG_SIZE).save(buf, format="PNG")
+    files = {REF_PNG: buf.getvalue()}
+
+    # optimize_for_sjpg works from a file
+    fd, tmp = tempfile.mkstemp(suffix=".png")
+    try:
+        with os.fdopen(fd, "wb") as f:
+            _reference_image(800, 480).convert("RGB").save(f, format="PNG")
+        files[REF_SJPG] = optimize_for_sjpg(tmp)
+    finally:
+        os.unlink(tmp)
+    return files
+
+
+def run_hw_bench(client: HTTPClient, label: str = "", upload_refs: bool = True,
+                 results_path=RESULTS_PATH) -> Optional[Dict[str, Any]]:
+    """
+    Run the benchmark on the display behind `client` and store the result.
+
+    Args:
+        client: HTTPClient for the display's SoftAP (config mode)
+        label: Free text saved with the run (unit name, SD card model, ...)
+        upload_refs: Sync the reference images to /bench first
+        results_path: JSONL file the run is appended to (None: don't store)
+
+    Returns:
+        The stored record: {"time", "label", "device", "refs", "results"},
+        or None if the firmware has no /api/bench
+
+    Raises:
+        HTTPClientError: Device unreachable, busy or the run failed
+    """
+    if not client.health_check():
+        raise HTTPClientError(f"No display at {client.device_ip}")
+
+    refs = {}
+    if upload_refs:
+        files = reference_images()
+        warnings = client.sync_folder(REF_FOLDER, files)
+        for w in warnings:
+            logger.warning("Reference image: %s", w)
+        # Units are only comparable on the same bytes: keep their hashes
+        refs = {name: hashlib.sha1(data).hexdigest() for name, data in files.items()}
+
+    results = client.hw_bench(f"/{REF_FOLDER}/{REF_PNG}", f"/{REF_FOLDER}/{REF_SJPG}")
+    if results is None:
+        return None
+
+    record = {
+        "time": int(time.time()),
+        "label": label,
+        "device": results.get("mac", client.device_ip),
+        "refs": refs,
+        "results": results,
+    }
+    if results_path:
+        os.makedirs(os.path.dirname(results_path), exist_ok=True)
+        with open(results_path, "a") as f:
+            f.write(json.dumps(record, separators=(",", ":")) + "\n")
+        logger.info("Benchmark of %s stored in %s", record["device"], results_path)
+    return record
+
+
+def load_results(results_path=RESULTS_PATH) -> List[Dict[str, Any]]:
+    """Every stored run, oldest first (unreadable lines skipped)."""
+    runs = []
+    try:
+        with open(results_path) as f:
+            for line in f:
+                try:
+                    runs.append(json.loads(line))
+                except ValueError:
+                    continue
+    except FileNotFoundError:
+        pass
+    return runs
+
+
+# Figures compared across units: (column, path into "results", format)
+SUMMARY_COLUMNS = [
+    ("fill fps", ("draw", "fill_fps"), "{:.0f}"),
+    ("blend fps", ("draw", "blend_fps"), "{:.0f}"),
+    ("redraw fps", ("flush", "fps"), "{:.1f}"),
+    ("flush Mpx/s", ("flush", "mpx_per_s"), "{:.1f}"),
+    ("max pclk MHz", ("scanout", "max_stable_pclk_hz"), "{:.0f}", 1000000),
+    ("underruns", ("scanout", "underruns"), "{}"),
+    ("SD rd MB/s", ("sd", "seq_read_mbs"), "{:.2f}"),
+    ("SD wr MB/s", ("sd", "seq_write_mbs"), "{:.2f}"),
+    ("4K rd ms", ("sd", "rnd_read_ms"), "{:.2f}"),
+    ("4K wr ms", ("sd", "rnd_write_ms"), "{:.2f}"),
+    ("png ms", ("decode", "png_us"), "{:.1f}", 1000),
+    ("sjpg ms", ("decode", "jpeg_us"), "{:.1f}", 1000),
+    ("config ms", ("config_load", "us"), "{:.1f}", 1000),
+    ("ping p50 ms", ("espnow_ping", "p50_us"), "{:.1f}", 1000),
+    ("ping p99 ms", ("espnow_ping", "p99_us"), "{:.1f}", 1000),
+]
+
+
+def _cell(results: Dict[str, Any], column) -> str:
+    section, key = column[1]
+    value = results.get(section, {}).get(key)
+    if value is None:
+        return "-"
+    if len(column) > 3:
+        value = value / column[3]
+    return column[2].format(value)
+
+
+def format_results(records: List[Dict[str, Any]]) -> str:
+    """One row per run (device, label, then SUMMARY_COLUMNS), plus I2C per device."""
+    header = ["device", "label"] + [c[0] for c in SUMMARY_COLUMNS]
+    rows = [[r.get("device", "?"), r.get("label", "")] +
+            [_cell(r.get("results", {}), c) for c in SUMMARY_COLUMNS] for r in records]
+    widths = [max(len(str(row[i])) for row in [header] + rows) for i in range(len(header))]
+    lines = ["  ".join(str(v).rjust(w) for v, w in zip(row, widths)) for row in [header] + rows]
+    for r in records:
+        for dev in r.get("results", {}).get("i2c", []):
+            lines.append(f"  {r.get('device', '?')} i2c {dev['device']:<9} "
+                         f"busy p50 {dev['busy_p50_us']} us p99 {dev['busy_p99_us']} us, "
+                         f"round trip p50 {dev['total_p50_us']} us p99 {dev['total_p99_us']} us"
+                         + (f", {dev['errors']} errors" if dev.get("errors") else ""))
+    return "\n".join(lines)
@@ -3,11 +3,26 @@ Image Optimizer: Resize and convert images for device button icons.
 
 Uses Pillow to resize images to fit within widget bounds and convert to PNG
 format for LVGL's lodepng decoder on the device. Handles SVG via cairosvg.
+
+For deploys and picture syncs, optimize_batch() picks the output format from
+a DeviceProfile (what the firmware decodes cheapest), keeps every result in
+an on-disk cache keyed by the source's content hash, and farms cache misses
+out to a process pool, so re-syncing a folder of photos only encodes the
+ones that changed.
 """
 
+import hashlib
+import logging
+import multiprocessing
+import os
 import struct
+from concurrent.futures import ProcessPoolExecutor
+from dataclasses import dataclass
 from io import BytesIO
-from PIL import Image
+from typing import Callable, FrozenSet, List, Optional, Union
+from PIL import Image, ImageChops
+
+logger = logging.getLogger(__name__)
 
 
 def _open_image(input_path: str, target_width: int = 256, target_height: int = 256) -> Image.Image:
@@ -48,6 +63,45 @@ def optimize_icon(input_path: str, max_width: int, max_height: int) -> bytes:
     return buf.getvalue()
 
 
+def is_animated(input_path: str) -> bool:
+    """True for a GIF with more than one frame."""
+    if not input_path.lower().endswith(".gif"):
+        return False
+    try:
+        with Image.open(input_path) as img:
+            return getattr(img, "n_frames", 1) > 1
+    except OSError:
+        return False
+
+
+def optimize_animated_icon(input_path: str, max_width: int, max_height: int) -> bytes:
+    """
+    Resize every frame of an animated GIF to fit within max dimensions.
+
+    The display decodes GIF icons itself (display/anim_icon.h), at a cost per
+    source pixel and frame, so the frames are shrunk here. Frame timing and
+    the loop count are kept.
+
+    Returns:
+        GIF-encoded bytes ready for upload to device SD card
+    """
+    from PIL import ImageSequence
+
+    frames, durations = [], []
+    with Image.open(input_path) as img:
+        loop = img.info.get("loop", 0)
+        for frame in ImageSequence.Iterator(img):
+            durations.append(frame.info.get("duration", 100))
+            frame = frame.convert("RGBA")
+            frame.thumbnail((max_width, max_height), Image.LANCZOS)
+            frames.append(frame)
+
+    buf = BytesIO()
+    frames[0].save(buf, format="GIF", save_all=True, append_images=frames[1:],
+                   duration=durations, loop=loop, disposal=2)
+    return buf.getvalue()
+
+
 def _fit_with_matte(img: Image.Image, width: int, height: int) -> Image.Image:
     """Fit image to canvas with a blurred zoom-to-fill matte background.
 
@@ -85,7 +139,7 @@ def _fit_with_matte(img: Image.Image, width: int, height: int) -> Image.Image:
     return matte
 
 
-def optimize_for_sjpg(input_path: str, width: int = 800, height: int = 480) -> bytes:
+def optimize_for_sjpg(input_path: str, width: int = 800, height: int = 480, quality: int = 90) -> bytes:
     """
     Convert an image to SJPG (LVGL split-JPEG) format.
 
@@ -99,6 +153,7 @@ def optimize_for_sjpg(input_path: str, width: int = 800, height: int = 480) -> b
         input_path: Path to source image
         width: Target width in pixels
         height: Target height in pixels
+        quality: JPEG quality of each strip
 
     Returns:
         SJPG-encoded bytes
@@ -107,7 +162,6 @@ def optimize_for_sjpg(input_path: str, width: int = 800, height: int = 480) -> b
         ValueError: If the file is not a valid image
     """
     SPLIT_HEIGHT = 16
-    JPEG_QUALITY = 90
 
     try:
         img = _open_image(input_path, width, height)
@@ -126,7 +180,7 @@ def optimize_for_sjpg(input_path: str, width: int = 800, height: int = 480) -> b
         strip_h = min(SPLIT_HEIGHT, h - y)
         strip = img.crop((0, y, w, y + strip_h))
         buf = BytesIO()
-        strip.save(buf, format="JPEG", quality=JPEG_QUALITY)
+        strip.save(buf, format="JPEG", quality=quality)
         strips.append(buf.getvalue())
 
     total_frames = len(strips)
@@ -183,3 +237,224 @@ def optimize_for_widget(input_path: str, widget_width: int, widget_height: int)
     icon_w = max(16, widget_width)
     icon_h = max(16, widget_height)
     return optimize_icon(input_path, icon_w, icon_h)
+
+
+def encode_lvgl_bin(img: Image.Image) -> bytes:
+    """
+    Encode an image as an LVGL 8 raw image file (LV_IMG_CF_TRUE_COLOR_ALPHA).
+
+    A 4-byte lv_img_header_t, then per pixel RGB565 little endian
+    (LV_COLOR_16_SWAP 0) and an alpha byte: exactly what the display's icon
+    cache keeps in PSRAM, so it renders without running a decoder.
+    """
+    LV_IMG_CF_TRUE_COLOR_ALPHA = 5
+
+    if img.mode != "RGBA":
+        img = img.convert("RGBA")
+    r, g, b, a = img.split()
+    # Byte-wise RGB565: lo = g[4:2] b[7:3], hi = r[7:3] g[7:5]
+    lo = ImageChops.add(g.point(lambda v: ((v >> 2) & 0x07) << 5), b.point(lambda v: v >> 3))
+    hi = ImageChops.add(r.point(lambda v: v & 0xF8), g.point(lambda v: v >> 5))
+    header = struct.pack("<I", LV_IMG_CF_TRUE_COLOR_ALPHA | (img.width << 10) | (img.height << 21))
+    return header + Image.merge("RGB", (lo, hi, a)).tobytes()
+
+
+# ============================================================
+# Device profiles
+# ============================================================
+
+@dataclass(frozen=True)
+class DeviceProfile:
+    """What a display can show and how cheaply.
+
+    decoders: file formats its firmware renders. The output format for each
+    job kind is the first entry of FORMAT_PREFERENCE the device decodes.
+    """
+    name: str
+    width: int
+    height: int
+    decoders: FrozenSet[str]
+    jpeg_quality: int = 90
+
+
+# Cheapest for the device first. Icons: raw .bin needs no decode at all
+# (about 3x the bytes of a PNG over the link, once). Pictures: SJPG decodes
+# in 16-px strips instead of holding a full 800x480 JPEG frame. Animated
+# icons stay GIF; a device without "gif" gets their first frame as an icon.
+FORMAT_PREFERENCE = {
+    "icon": ("bin", "png"),
+    "anim_icon": ("gif",),
+    "picture": ("sjpg", "jpg"),
+}
+
+DEVICE_PROFILES = {
+    "crowpanel-7": DeviceProfile("crowpanel-7", 800, 480,
+                                 frozenset({"bin", "png", "gif", "sjpg", "jpg", "bmp"})),
+    # Firmware before raw icon sources: icons must go through lodepng
+    "crowpanel-7-png": DeviceProfile("crowpanel-7-png", 800, 480,
+                                     frozenset({"png", "sjpg", "jpg", "bmp"})),
+}
+DEFAULT_PROFILE = "crowpanel-7"
+
+
+def get_profile(profile: Union[str, DeviceProfile, None] = None) -> DeviceProfile:
+    if isinstance(profile, DeviceProfile):
+        return profile
+    return DEVICE_PROFILES[profile or DEFAULT_PROFILE]
+
+
+def output_format(kind: str, profile: Union[str, DeviceProfile, None] = None) -> str:
+    """File extension (no dot) a job of `kind` is encoded to for `profile`."""
+    decoders = get_profile(profile).decoders
+    for fmt in FORMAT_PREFERENCE[kind]:
+        if fmt in decoders:
+            return fmt
+    raise ValueError(f"Device decodes none of {FORMAT_PREFERENCE[kind]} for {kind}s")
+
+
+@dataclass(frozen=True)
+class ImageJob:
+    """One source image to encode. width/height: widget box for icons
+    (ignored for pictures, which fill the panel)."""
+    kind: str
+    path: str
+    width: int = 0
+    height: int = 0
+
+
+def _encode(job: ImageJob, profile: DeviceProfile) -> bytes:
+    fmt = output_format(job.kind, profile)
+    if job.kind == "picture":
+        if fmt == "sjpg":
+            return optimize_for_sjpg(job.path, profile.width, profile.height, profile.jpeg_quality)
+        img = _fit_with_matte(_open_image(job.path, profile.width, profile.height).convert("RGB"),
+                              profile.width, profile.height)
+        buf = BytesIO()
+        img.save(buf, format="JPEG", quality=profile.jpeg_quality)
+        return buf.getvalue()
+
+    w, h = max(16, job.width), max(16, job.height)
+    if job.kind == "anim_icon":
+        return optimize_animated_icon(job.path, w, h)
+    if fmt == "png":
+        return optimize_icon(job.path, w, h)
+    img = _open_image(job.path, w, h)
+    if img.mode != "RGBA":
+        img = img.convert("RGBA")
+    img.thumbnail((w, h), Image.LANCZOS)
+    return encode_lvgl_bin(img)
+
+
+# ============================================================
+# Output cache
+# ============================================================
+
+CACHE_DIR = os.path.join(os.environ.get("XDG_CACHE_HOME") or os.path.expanduser("~/.cache"),
+                         "crowdisplay", "images")
+_CACHE_VERSION = 1  # Bump when an encoder's output changes
+
+
+def _cache_path(job: ImageJob, profile: DeviceProfile) -> str:
+    """Cache file for `job`: source bytes + every parameter that shapes the output."""
+    h = hashlib.sha256()
+    with open(job.path, "rb") as f:
+        for chunk in iter(lambda: f.read(1 << 20), b""):
+            h.update(chunk)
+    fmt = output_format(job.kind, profile)
+    size = (profile.width, profile.height) if job.kind == "picture" else (job.width, job.height)
+    h.update(repr((_CACHE_VERSION, job.kind, fmt, size, profile.jpeg_quality)).encode())
+    key = h.hexdigest()
+    return os.path.join(CACHE_DIR, key[:2], f"{key}.{fmt}")
+
+
+def _cache_load(path: str) -> Optional[bytes]:
+    try:
+        with open(path, "rb") as f:
+            return f.read()
+    except OSError:
+        return None
+
+
+def _cache_store(path: str, data: bytes) -> None:
+    try:
+        os.makedirs(os.path.dirname(path), exist_ok=True)
+        tmp = f"{path}.{os.getpid()}.tmp"
+        with open(tmp, "wb") as f:
+            f.write(data)
+        os.replace(tmp, path)
+    except OSError as e:
+        logger.debug("Image cache: cannot write %s: %s", path, e)
+
+
+def _encode_worker(args):
+    job, profile = args
+    try:
+        return _encode(job, profile)
+    except Exception as e:
+        return ValueError(f"{os.path.basename(job.path)}: {e}")
+
+
+def optimize_batch(jobs: List[ImageJob], profile: Union[str, DeviceProfile, None] = None,
+                   workers: Optional[int] = None, use_cache: bool = True,
+                   progress: Optional[Callable[[int, int], None]] = None) -> List[Union[bytes, Exception]]:
+    """
+    Encode many images for a device, in the format it decodes cheapest.
+
+    Cached results are returned without opening the image; the rest are
+    encoded by a process pool (Pillow's resize and JPEG encoder hold the
+    GIL) and then cached.
+
+    Args:
+        jobs: Images to encode
+        profile: DeviceProfile or a DEVICE_PROFILES name (default DEFAULT_PROFILE)
+        workers: Pool size (default: CPU count); 1 encodes in this process
+        use_cache: Read and fill the on-disk cache under CACHE_DIR
+        progress: Called with (done, total) as results come in
+
+    Returns:
+        One entry per job, in order: encoded bytes, or the exception that
+        job failed with (ValueError for unreadable images)
+    """
+    profile = get_profile(profile)
+    results: List[Union[bytes, Exception, None]] = [None] * len(jobs)
+    cache_paths: List[Optional[str]] = [None] * len(jobs)
+    done = 0
+    misses = []
+    for i, job in enumerate(jobs):
+        try:
+            output_format(job.kind, profile)
+            if use_cache:
+                cache_paths[i] = _cache_path(job, profile)
+                results[i] = _cache_load(cache_paths[i])
+        except (OSError, ValueError) as e:
+            results[i] = ValueError(f"{os.path.basename(job.path)}: {e}")
+        if results[i] is None:
+            misses.append(i)
+        else:
+            done += 1
+            if progress:
+                progress(done, len(jobs))
+
+    workers = min(workers or os.cpu_count() or 1, len(misses))
+    if workers > 1:
+        # spawn, not fork: the caller is usually a Qt app with live threads
+        pool = ProcessPoolExecutor(max_workers=workers, mp_context=multiprocessing.get_context("spawn"))
+        encoded = pool.map(_encode_worker, [(jobs[i], profile) for i in misses])
+    else:
+        pool = None
+        encoded = (_encode_worker((jobs[i], profile)) for i in misses)
+    try:
+        for i, data in zip(misses, encoded):
+            results[i] = data
+            if cache_paths[i] and isinstance(data, bytes):
+                _cache_store(cache_paths[i], data)
+            done += 1
+            if progress:
+                progress(done, len(jobs))
+    finally:
+        if pool:
+            pool.shutdown()
+
+    logger.info("Image batch: %d images, %d from cache, %d encoded (%d workers)",
+                len(jobs), len(jobs) - len(misses), len(misses), max(workers, 1))
+    return results
@@ -134,3 +134,109 @@ def arduino_keycode_to_display_name(keycode: int) -> str:
     if keycode == 0:
         return "(none)"
     return f"0x{keycode:02X}"
+
+
+# ---------------------------------------------------------------------------
+# Macro text format (editor <-> widget["macro"] steps)
+# ---------------------------------------------------------------------------
+#
+# One step per line:
+#   ctrl+shift+t      tap a chord          press shift       hold keys down
+#   delay 50          wait 50 ms           release shift     release held keys
+#   text Hello        type a snippet       release_all       release everything
+#   media 0xCD        tap a consumer code
+
+_MACRO_MOD_NAMES = {
+    "ctrl": 0x01, "control": 0x01,
+    "shift": 0x02,
+    "alt": 0x04,
+    "gui": 0x08, "super": 0x08, "meta": 0x08, "win": 0x08,
+    "rctrl": 0x10, "rshift": 0x20, "ralt": 0x40, "altgr": 0x40,
+    "rgui": 0x80, "rsuper": 0x80,
+}
+_MACRO_MOD_ORDER = (("ctrl", 0x01), ("shift", 0x02), ("alt", 0x04), ("super", 0x08),
+                    ("rctrl", 0x10), ("rshift", 0x20), ("altgr", 0x40), ("rsuper", 0x80))
+_ARDUINO_NAME_TO_KEY = {name.lower(): code for code, name in ARDUINO_KEY_NAMES.items()}
+_ARDUINO_NAME_TO_KEY.update({"enter": 0xB0, "esc": 0xB1, "del": 0xD4})
+
+
+def _parse_chord(chord: str):
+    """Parse 'ctrl+shift+t' into (modifiers, keycode). Raises ValueError."""
+    mods = 0
+    key = 0
+    for part in chord.split("+"):
+        name = part.strip().lower()
+        if not name:
+            continue
+        if name in _MACRO_MOD_NAMES:
+            mods |= _MACRO_MOD_NAMES[name]
+        elif name in _ARDUINO_NAME_TO_KEY:
+            key = _ARDUINO_NAME_TO_KEY[name]
+        elif len(name) == 1:
+            key = ord(name)
+        elif name.startswith("0x"):
+            key = int(name, 16) & 0xFF
+        else:
+            raise ValueError(f"unknown key '{part.strip()}'")
+    return mods, key
+
+
+def _format_chord(mods: int, key: int) -> str:
+    parts = [name for name, bit in _MACRO_MOD_ORDER if mods & bit]
+    if key:
+        name = ARDUINO_KEY_NAMES.get(key)
+        if name:
+            parts.append(name.lower())
+        elif 0x21 <= key <= 0x7E and chr(key) != "+":
+            parts.append(chr(key))
+        else:
+            parts.append(f"0x{key:02X}")
+    return "+".join(parts)
+
+
+def text_to_macro(text: str) -> list:
+    """Parse the editor's macro text into widget["macro"] steps. Raises ValueError."""
+    steps = []
+    for lineno, raw in enumerate(text.splitlines(), 1):
+        line = raw.strip()
+        if not line or line.startswith("#"):
+            continue
+        word, _, rest = line.partition(" ")
+        word = word.lower()
+        try:
+            if word == "delay":
+                steps.append({"op": "delay", "ms": max(0, min(int(rest.strip()), 0xFFFF))})
+            elif word == "text":
+                steps.append({"op": "text", "text": raw.strip()[5:]})
+            elif word == "media":
+                steps.append({"op": "media", "code": int(rest.strip(), 0) & 0xFFFF})
+            elif word == "release_all":
+                steps.append({"op": "release_all"})
+            elif word in ("press", "release"):
+                mods, key = _parse_chord(rest)
+                steps.append({"op": word, "mod": mods, "key": key})
+            else:
+                mods, key = _parse_chord(line)
+                steps.append({"op": "tap", "mod": mods, "key": key})
+        except ValueError as exc:
+            raise ValueError(f"line {lineno}: {exc}") from None
+    return steps
+
+
+def macro_to_text(steps: list) -> str:
+    """Format widget["macro"] steps for the editor's macro text box."""
+    lines = []
+    for step in steps:
+        op = step.get("op", "tap")
+        if op == "delay":
+            lines.append(f"delay {step.get('ms', 0)}")
+        elif op == "text":
+            lines.append(f"text {step.get('text', '')}")
+        elif op == "media":
+            lines.append(f"media 0x{step.get('code', 0):02X}")
+        elif op == "release_all":
+            lines.append("release_all")
+        else:
+            chord = _format_chord(step.get("mod", 0), step.get("key", 0))
+            lines.append(chord if op == "tap" else f"{op} {chord}")
+    return "\n".join(lines)
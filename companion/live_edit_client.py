@@ -0,0 +1,213 @@
+"""
+Live edit client: stream layout edits to the CrowPanel over a WebSocket
+
+Talks to ws://<device>:81/api/live (display/live_edit.cpp) while the panel's
+config SoftAP is up and this machine is on it. Each edit is one JSON-patch
+style text frame for the panel's active profile; the panel applies it to the
+running layout at once and saves /config.json a moment after the last one,
+so a drag on the editor canvas moves the widget on the panel as it happens.
+
+Sends are short and synchronous (the frames are a few hundred bytes). A
+dead link is dropped; the next edit reconnects, at most every
+RECONNECT_INTERVAL seconds so a missing panel doesn't stall the editor.
+"""
+
+import base64
+import hashlib
+import json
+import logging
+import os
+import socket
+import struct
+import time
+from typing import Any, Dict, List, Optional
+
+logger = logging.getLogger(__name__)
+
+LIVE_EDIT_PORT = 81
+LIVE_EDIT_PATH = "/api/live"
+RECONNECT_INTERVAL = 3.0
+
+_WS_GUID = b"258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+_OP_TEXT = 0x1
+_OP_CLOSE = 0x8
+_OP_PING = 0x9
+_OP_PONG = 0xA
+
+
+def widget_path(page: int, index) -> str:
+    """Patch path of a widget ("-" appends)."""
+    return f"/pages/{page}/widgets/{index}"
+
+
+class LiveEditClient:
+    """One WebSocket connection to the panel's live-edit endpoint."""
+
+    def __init__(self, device_ip: str = "192.168.4.1", port: int = LIVE_EDIT_PORT,
+                 timeout: float = 1.0):
+        self.device_ip = device_ip
+        self.port = port
+        self.timeout = timeout
+        self.last_error = ""   # Last patch the panel rejected
+        self.rev = 0           # Panel's edit counter from the last accepted patch
+        self._sock = None
+        self._rx = b""
+        self._last_attempt = 0.0
+
+    @property
+    def connected(self) -> bool:
+        return self._sock is not None
+
+    def connect(self) -> bool:
+        """Open the WebSocket. Returns False if the panel isn't reachable."""
+        self.close()
+        self._last_attempt = time.monotonic()
+        key = base64.b64encode(os.urandom(16))
+        request = (f"GET {LIVE_EDIT_PATH} HTTP/1.1\r\n"
+                   f"Host: {self.device_ip}:{self.port}\r\n"
+                   "Upgrade: websocket\r\n"
+                   "Connection: Upgrade\r\n"
+                   f"Sec-WebSocket-Key: {key.decode()}\r\n"
+                   "Sec-WebSocket-Version: 13\r\n\r\n").encode()
+        try:
+            sock = socket.create_connection((self.device_ip, self.port), timeout=self.timeout)
+            sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            sock.sendall(request)
+            response = b""
+            while b"\r\n\r\n" not in response:
+                chunk = sock.recv(1024)
+                if not chunk:
+                    raise OSError("connection closed during handshake")
+                response += chunk
+        except OSError as e:
+            logger.info("Live edit: cannot reach %s:%d (%s)", self.device_ip, self.port, e)
+            return False
+
+        head, _, rest = response.partition(b"\r\n\r\n")
+        expected = base64.b64encode(hashlib.sha1(key + _WS_GUID).digest())
+        if not head.startswith(b"HTTP/1.1 101") or expected not in head:
+            logger.warning("Live edit: upgrade refused: %s", head.split(b"\r\n", 1)[0].decode(errors="replace"))
+            sock.close()
+            return False
+        self._sock = sock
+        self._rx = rest
+        logger.info("Live edit: connected to %s", self.device_ip)
+        return True
+
+    def close(self) -> None:
+        if self._sock is None:
+            return
+        try:
+            self._send_frame(_OP_CLOSE, struct.pack(">H", 1000))
+        except OSError:
+            pass
+        self._sock.close()
+        self._sock = None
+        self._rx = b""
+
+    def send_patch(self, ops: List[Dict[str, Any]], profile: Optional[str] = None) -> bool:
+        """Send one patch (a list of ops, see config_apply_patch() on the panel).
+
+        profile: the editor's active profile name; the panel refuses the
+        patch if it is showing another one. Returns False if it could not be
+        sent. The panel's answer is picked up by poll().
+        """
+        if self._sock is None:
+            if time.monotonic() - self._last_attempt < RECONNECT_INTERVAL or not self.connect():
+                return False
+        message = {"patch": ops}
+        if profile:
+            message["profile"] = profile
+        try:
+            self._send_frame(_OP_TEXT, json.dumps(message, separators=(",", ":")).encode("utf-8"))
+        except OSError as e:
+            logger.info("Live edit: link lost (%s)", e)
+            self._drop()
+            return False
+        self.poll()
+        return True
+
+    def poll(self) -> List[Dict[str, Any]]:
+        """Read whatever replies have arrived, without waiting. Returns them."""
+        replies = []
+        if self._sock is None:
+            return replies
+        try:
+            self._sock.setblocking(False)
+            while True:
+                chunk = self._sock.recv(4096)
+                if not chunk:
+                    self._drop()
+                    return replies
+                self._rx += chunk
+        except BlockingIOError:
+            pass
+        except OSError:
+            self._drop()
+            return replies
+        finally:
+            if self._sock is not None:
+                self._sock.settimeout(self.timeout)
+
+        while True:
+            frame = self._take_frame()
+            if frame is None:
+                break
+            opcode, payload = frame
+            if opcode == _OP_TEXT:
+                try:
+                    reply = json.loads(payload)
+                except ValueError:
+                    continue
+                if reply.get("ok"):
+                    self.rev = reply.get("rev", self.rev)
+                else:
+                    self.last_error = reply.get("error", "rejected")
+                    logger.warning("Live edit: panel rejected patch: %s", self.last_error)
+                replies.append(reply)
+            elif opcode == _OP_PING:
+                self._send_frame(_OP_PONG, payload)
+            elif opcode == _OP_CLOSE:
+                self._drop()
+                break
+        return replies
+
+    def _drop(self) -> None:
+        if self._sock is not None:
+            self._sock.close()
+        self._sock = None
+        self._rx = b""
+
+    def _send_frame(self, opcode: int, payload: bytes) -> None:
+        # Client frames are always masked (RFC 6455 5.3)
+        header = bytes([0x80 | opcode])
+        n = len(payload)
+        if n < 126:
+            header += bytes([0x80 | n])
+        else:
+            header += bytes([0x80 | 126]) + struct.pack(">H", n)
+        mask = os.urandom(4)
+        masked = bytes(b ^ mask[i & 3] for i, b in enumerate(payload))
+        self._sock.sendall(header + mask + masked)
+
+    def _take_frame(self):
+        """(opcode, payload) for the next complete server frame, or None."""
+        rx = self._rx
+        if len(rx) < 2:
+            return None
+        n = rx[1] & 0x7F
+        pos = 2
+        if n == 126:
+            if len(rx) < 4:
+                return None
+            n = struct.unpack_from(">H", rx, 2)[0]
+            pos = 4
+        elif n == 127:
+            if len(rx) < 10:
+                return None
+            n = struct.unpack_from(">Q", rx, 2)[0]
+            pos = 10
+        if len(rx) < pos + n:
+            return None
+        self._rx = rx[pos + n:]
+        return rx[0] & 0x0F, rx[pos:pos + n]
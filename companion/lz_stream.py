@@ -0,0 +1,95 @@
+"""
+LZ payload compression for the display link (shared/lz_stream.h).
+
+The display decodes with a fixed 1 KB window and nothing else, so the
+format stays minimal: literal runs of up to 128 bytes and back references
+of 3..34 bytes up to 1024 bytes back, two bytes each. compress() is a
+greedy match finder over short hash chains -- plenty for notification
+text and config/icon files, where the radio, not this, is the bottleneck.
+"""
+
+LZ_WINDOW = 1024
+LZ_MIN_MATCH = 3
+LZ_MAX_MATCH = 0x1F + LZ_MIN_MATCH
+LZ_MAX_LITERALS = 0x80
+LZ_CHAIN = 16                   # Candidates tried per position
+
+
+def compress(data: bytes) -> bytes:
+    """The LZ stream for `data` (b"" for b"")."""
+    data = bytes(data)
+    n = len(data)
+    out = bytearray()
+    chains = {}
+    lit_start = 0
+    i = 0
+
+    def add(pos):
+        if pos + LZ_MIN_MATCH <= n:
+            chain = chains.setdefault(data[pos:pos + LZ_MIN_MATCH], [])
+            chain.append(pos)
+            if len(chain) > 2 * LZ_CHAIN:
+                del chain[:LZ_CHAIN]
+
+    def literals(end):
+        nonlocal lit_start
+        while lit_start < end:
+            run = min(LZ_MAX_LITERALS, end - lit_start)
+            out.append(run - 1)
+            out.extend(data[lit_start:lit_start + run])
+            lit_start += run
+
+    while i < n:
+        best_len = best_dist = 0
+        limit = min(LZ_MAX_MATCH, n - i)
+        if limit >= LZ_MIN_MATCH:
+            for pos in reversed(chains.get(data[i:i + LZ_MIN_MATCH], ())[-LZ_CHAIN:]):
+                dist = i - pos
+                if dist > LZ_WINDOW:
+                    break
+                length = LZ_MIN_MATCH
+                while length < limit and data[pos + length] == data[i + length]:
+                    length += 1
+                if length > best_len:
+                    best_len, best_dist = length, dist
+                    if length == limit:
+                        break
+        if best_len < LZ_MIN_MATCH:
+            add(i)
+            i += 1
+            continue
+        literals(i)
+        out.append(0x80 | (best_len - LZ_MIN_MATCH) << 2 | (best_dist - 1) >> 8)
+        out.append((best_dist - 1) & 0xFF)
+        for pos in range(i, i + best_len):
+            add(pos)
+        i += best_len
+        lit_start = i
+    literals(n)
+    return bytes(out)
+
+
+def decompress(stream: bytes) -> bytes:
+    """Inverse of compress(). Raises ValueError on a malformed stream."""
+    out = bytearray()
+    i = 0
+    while i < len(stream):
+        t = stream[i]
+        i += 1
+        if t < 0x80:
+            run = stream[i:i + t + 1]
+            if len(run) != t + 1:
+                raise ValueError("LZ literal run past the end")
+            out.extend(run)
+            i += t + 1
+            continue
+        if i >= len(stream):
+            raise ValueError("LZ match without its distance")
+        length = ((t >> 2) & 0x1F) + LZ_MIN_MATCH
+        dist = ((t & 0x03) << 8 | stream[i]) + 1
+        i += 1
+        if dist > len(out):
+            raise ValueError("LZ match before the start")
+        for _ in range(length):
+            out.append(out[-dist])
+    return bytes(out)
@@ -0,0 +1,210 @@
+"""
+Remote image: stream host-side pictures into WIDGET_REMOTE_IMAGE on the display.
+
+Each source name a widget asks for ("now_playing", "file:/path/to.png")
+is rendered to an RGB565 frame the size of its widget. RemoteImageStream
+keeps the last frame it sent, cuts the new one into REMOTE_TILE x
+REMOTE_TILE tiles and turns the ones that changed into patches (shared/
+protocol.h, BULK_FLAG_IMAGE): a tile of one colour costs 2 bytes, flat
+artwork goes as runs, photos as raw pixels. The patches travel over the
+bulk channel; the display writes them into its PSRAM frame and redraws
+only those tiles, so a track change sends the art once, a clock-like
+graph a few tiles a second.
+
+Sources:
+    now_playing     MPRIS album art of the active player (playerctl)
+    file:<path>     an image file, re-read when its mtime changes (write a
+                    PNG from any script for host-rendered graphs)
+"""
+
+import logging
+import os
+import shutil
+import struct
+import subprocess
+from io import BytesIO
+from typing import Dict, List, Optional, Tuple
+from urllib.parse import unquote, urlparse
+
+from PIL import Image, ImageChops
+
+logger = logging.getLogger(__name__)
+
+# Must match shared/protocol.h / display/remote_image.h
+REMOTE_TILE = 32
+REMOTE_IMAGE_MAX_DIM = 480
+REMOTE_IMAGE_PATCH_MAX = 160 * 1024
+TILE_RAW, TILE_FILL, TILE_RLE = range(3)
+IMAGE_HDR = struct.Struct("<HHHHH")   # width, height, seq, base_seq, tile_count
+TILE_HDR = struct.Struct("<BBBH")     # tx, ty, encoding, len
+
+
+def rgb565_frame(img: Image.Image, width: int, height: int) -> bytes:
+    """`img` fitted into width x height (aspect kept, centred on black) as
+    RGB565 little endian, the display's LV_COLOR_16_SWAP 0 layout."""
+    img = img.convert("RGB")
+    img.thumbnail((width, height), Image.LANCZOS)
+    canvas = Image.new("RGB", (width, height))
+    canvas.paste(img, ((width - img.width) // 2, (height - img.height) // 2))
+    r, g, b = canvas.split()
+    # Byte-wise RGB565 as in image_optimizer.encode_lvgl_bin
+    lo = ImageChops.add(g.point(lambda v: ((v >> 2) & 0x07) << 5), b.point(lambda v: v >> 3))
+    hi = ImageChops.add(r.point(lambda v: v & 0xF8), g.point(lambda v: v >> 5))
+    return Image.merge("LA", (lo, hi)).tobytes()
+
+
+def _rle(tile: bytes) -> Optional[bytes]:
+    """[count-1][pixel] runs, or None once they stop being smaller than raw."""
+    out = bytearray()
+    n = len(tile)
+    i = 0
+    while i < n:
+        px = tile[i:i + 2]
+        j = i + 2
+        while j < n and j - i < 512 and tile[j:j + 2] == px:
+            j += 2
+        out.append((j - i) // 2 - 1)
+        out += px
+        if len(out) >= n:
+            return None
+        i = j
+    return bytes(out)
+
+
+def encode_tile(tile: bytes) -> Tuple[int, bytes]:
+    """Cheapest (encoding, data) for one tile's pixels."""
+    first = tile[:2]
+    if tile == first * (len(tile) // 2):
+        return TILE_FILL, first
+    rle = _rle(tile)
+    if rle is not None:
+        return TILE_RLE, rle
+    return TILE_RAW, tile
+
+
+class RemoteImageStream:
+    """Frames of one source at a fixed size -> patches for the display."""
+
+    def __init__(self, width: int, height: int):
+        self.width = min(max(width, 1), REMOTE_IMAGE_MAX_DIM)
+        self.height = min(max(height, 1), REMOTE_IMAGE_MAX_DIM)
+        self._frame = None    # Last frame the display confirmed
+        self._pending = None  # Frame the patches from patches() lead to
+        self._seq = 0
+
+    def reset(self) -> None:
+        """The display lost track (reboot, refused patch): next frame is a key frame."""
+        self._frame = None
+
+    def _tile(self, frame: bytes, tx: int, ty: int) -> bytes:
+        x0, y0 = tx * REMOTE_TILE, ty * REMOTE_TILE
+        tw = min(REMOTE_TILE, self.width - x0)
+        rows = range(y0, min(y0 + REMOTE_TILE, self.height))
+        return b"".join(frame[(y * self.width + x0) * 2:(y * self.width + x0 + tw) * 2] for y in rows)
+
+    def patches(self, frame: bytes) -> List[Tuple[int, bytes]]:
+        """(seq, patch) list taking the display from the last frame to `frame`.
+
+        Empty when nothing changed. Call commit(seq) for each one the
+        display accepted, reset() when one failed.
+        """
+        key = self._frame is None
+        tiles = []
+        for ty in range((self.height + REMOTE_TILE - 1) // REMOTE_TILE):
+            for tx in range((self.width + REMOTE_TILE - 1) // REMOTE_TILE):
+                tile = self._tile(frame, tx, ty)
+                if not key and tile == self._tile(self._frame, tx, ty):
+                    continue
+                enc, data = encode_tile(tile)
+                if key and enc == TILE_FILL and data == b"\x00\x00":
+                    continue   # A key frame starts out black
+                tiles.append(TILE_HDR.pack(tx, ty, enc, len(data)) + data)
+        if not tiles and not key:
+            return []
+
+        out = []
+        base = 0 if key else self._seq
+        seq = self._seq
+        body, count = [], 0
+        size = IMAGE_HDR.size
+        for t in tiles + [None]:
+            if t is not None and size + len(t) <= REMOTE_IMAGE_PATCH_MAX:
+                body.append(t)
+                count += 1
+                size += len(t)
+                continue
+            seq = seq % 0xFFFF + 1   # Never 0
+            out.append((seq, IMAGE_HDR.pack(self.width, self.height, seq, base, count) + b"".join(body)))
+            base = seq
+            body, count, size = ([t], 1, IMAGE_HDR.size + len(t)) if t is not None else ([], 0, 0)
+        self._pending = frame
+        return out
+
+    def commit(self, seq: int) -> None:
+        self._seq = seq
+        self._frame = self._pending
+
+
+# ---------------------------------------------------------------------------
+# Sources
+# ---------------------------------------------------------------------------
+
+_file_cache: Dict[str, Tuple[float, Image.Image]] = {}
+_art_cache: Dict[str, Image.Image] = {}
+
+
+def _load_file(path: str) -> Optional[Image.Image]:
+    try:
+        mtime = os.path.getmtime(path)
+    except OSError:
+        return None
+    cached = _file_cache.get(path)
+    if cached and cached[0] == mtime:
+        return cached[1]
+    try:
+        with Image.open(path) as f:
+            img = f.convert("RGB")
+    except OSError as exc:
+        logger.debug("Remote image %s: %s", path, exc)
+        return None
+    _file_cache[path] = (mtime, img)
+    return img
+
+
+def _now_playing_art() -> Optional[Image.Image]:
+    if not shutil.which("playerctl"):
+        return None
+    try:
+        url = subprocess.run(["playerctl", "metadata", "mpris:artUrl"], stdout=subprocess.PIPE,
+                             stderr=subprocess.DEVNULL, timeout=2, text=True).stdout.strip()
+    except (OSError, subprocess.TimeoutExpired):
+        return None
+    if not url:
+        return None
+    parsed = urlparse(url)
+    if parsed.scheme == "file":
+        return _load_file(unquote(parsed.path))
+    if parsed.scheme not in ("http", "https"):
+        return None
+    if url not in _art_cache:
+        try:
+            import requests
+            resp = requests.get(url, timeout=5)
+            resp.raise_for_status()
+            with Image.open(BytesIO(resp.content)) as f:
+                img = f.convert("RGB")
+        except Exception as exc:
+            logger.debug("Album art %s: %s", url, exc)
+            return None
+        _art_cache.clear()   # One track at a time
+        _art_cache[url] = img
+    return _art_cache[url]
+
+
+def fetch_source(name: str) -> Optional[Image.Image]:
+    """Current picture of a source, None when it has nothing (yet)."""
+    if name == "now_playing":
+        return _now_playing_art()
+    if name.startswith("file:"):
+        return _load_file(os.path.expanduser(name[5:]))
+    return None
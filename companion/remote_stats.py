@@ -0,0 +1,353 @@
+"""
+Remote stats: put other machines' metrics (build servers, a NAS) on the panel.
+
+config.json "remote_hosts" lists the collectors the companion pulls:
+
+    "remote_hosts": [
+        {"id": 1, "name": "nas", "kind": "prometheus",
+         "url": "http://nas.lan:9100/metrics", "interval": 5, "timeout": 2},
+        {"id": 2, "name": "build", "kind": "agent", "url": "http://build:9105/"}
+    ]
+
+    prometheus  a node_exporter /metrics page; rates (CPU, network, disk)
+                come from two scrapes, so they appear from the second one
+    agent       JSON from `python -m companion.remote_stats --serve` on that
+                machine: {"stats": {"cpu_percent": 12, ...}}
+
+Each host is scraped on its own thread with its own timeout; the stats loop
+only picks up what has arrived (RemoteStatsPoller.take()) and never waits
+for a host, so one slow or dead collector can't hold up the local stats.
+A stat monitor shows host N's value with "remote_host": N; the values go
+out as MSG_HOST_STATS, one packet per host tagged with its id.
+
+Values are keyed by the companion's stat names (STAT_TYPES): the caller
+maps them to type ids and encodes them like its own.
+"""
+
+import argparse
+import json
+import logging
+import re
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from typing import Dict, List, Optional, Tuple
+
+import requests
+
+logger = logging.getLogger(__name__)
+
+# Must match shared/protocol.h
+REMOTE_HOST_MAX = 8
+
+REMOTE_KINDS = ("prometheus", "agent")
+REMOTE_INTERVAL_DEFAULT = 5.0    # Seconds between scrapes
+REMOTE_INTERVAL_MIN = 1.0
+REMOTE_TIMEOUT_DEFAULT = 2.0     # Per request; capped at the interval
+REMOTE_DOWN_AFTER = 3            # Failed scrapes in a row before the host is reported down
+AGENT_PORT = 9105
+
+# Network interfaces and filesystems node_exporter reports that aren't "the machine's"
+_VIRTUAL_NET = re.compile(r"^(lo|docker\d*|veth.*|br-.*|virbr\d*)$")
+_VIRTUAL_FS = {"tmpfs", "devtmpfs", "overlay", "squashfs", "ramfs", "autofs"}
+
+
+def load_remote_hosts(config_path) -> List[dict]:
+    """Validated "remote_hosts" entries from config.json (ids 1..REMOTE_HOST_MAX,
+    each id once); malformed entries are logged and skipped."""
+    try:
+        with open(config_path, "r") as f:
+            entries = json.load(f).get("remote_hosts") or []
+    except (OSError, json.JSONDecodeError) as exc:
+        logger.warning("Failed to load remote hosts: %s", exc)
+        return []
+    hosts, seen = [], set()
+    for entry in entries if isinstance(entries, list) else []:
+        if not isinstance(entry, dict):
+            continue
+        host_id, url, kind = entry.get("id"), entry.get("url"), entry.get("kind", "prometheus")
+        if not isinstance(host_id, int) or not 1 <= host_id <= REMOTE_HOST_MAX or host_id in seen:
+            logger.warning("remote_hosts: id %r invalid or repeated (1-%d)", host_id, REMOTE_HOST_MAX)
+            continue
+        if not isinstance(url, str) or not url.startswith(("http://", "https://")) or kind not in REMOTE_KINDS:
+            logger.warning("remote_hosts %d: needs an http(s) url and a kind of %s", host_id, REMOTE_KINDS)
+            continue
+        try:
+            interval = max(REMOTE_INTERVAL_MIN, float(entry.get("interval", REMOTE_INTERVAL_DEFAULT)))
+            timeout = min(interval, max(0.1, float(entry.get("timeout", REMOTE_TIMEOUT_DEFAULT))))
+        except (TypeError, ValueError):
+            interval, timeout = REMOTE_INTERVAL_DEFAULT, REMOTE_TIMEOUT_DEFAULT
+        seen.add(host_id)
+        hosts.append({"id": host_id, "name": str(entry.get("name") or f"host{host_id}"),
+                      "kind": kind, "url": url, "interval": interval, "timeout": timeout})
+    return hosts
+
+
+# ---------------------------------------------------------------------------
+# Prometheus text format (node_exporter)
+# ---------------------------------------------------------------------------
+
+_SAMPLE = re.compile(r'^([a-zA-Z_:][a-zA-Z0-9_:]*)(?:\{(.*)\})?\s+(\S+)')
+_LABEL = re.compile(r'([a-zA-Z_][a-zA-Z0-9_]*)="((?:[^"\\]|\\.)*)"')
+
+
+def parse_prometheus(text: str) -> Dict[str, List[Tuple[dict, float]]]:
+    """Metric name -> [(labels, value)] for every sample in a /metrics page."""
+    metrics: Dict[str, List[Tuple[dict, float]]] = {}
+    for line in text.splitlines():
+        if not line or line[0] == "#":
+            continue
+        m = _SAMPLE.match(line)
+        if not m:
+            continue
+        try:
+            value = float(m.group(3))
+        except ValueError:
+            continue
+        labels = dict(_LABEL.findall(m.group(2))) if m.group(2) else {}
+        metrics.setdefault(m.group(1), []).append((labels, value))
+    return metrics
+
+
+def _total(metrics, name, skip=None) -> Optional[float]:
+    samples = metrics.get(name)
+    if not samples:
+        return None
+    return sum(v for labels, v in samples if not (skip and skip(labels)))
+
+
+def _one(metrics, name, match=None) -> Optional[float]:
+    for labels, v in metrics.get(name, ()):
+        if match is None or match(labels):
+            return v
+    return None
+
+
+class NodeExporterStats:
+    """Stats from successive node_exporter scrapes. Counters (CPU time,
+    bytes) become rates against the previous scrape."""
+
+    def __init__(self):
+        self._prev: Optional[dict] = None
+
+    def update(self, metrics, now) -> Dict[str, float]:
+        stats: Dict[str, float] = {}
+        counters = {"t": now}
+
+        cpu = metrics.get("node_cpu_seconds_total", ())
+        counters["cpu_all"] = sum(v for _, v in cpu)
+        counters["cpu_idle"] = sum(v for labels, v in cpu if labels.get("mode") in ("idle", "iowait"))
+        virtual = lambda labels: bool(_VIRTUAL_NET.match(labels.get("device", "")))
+        counters["net_tx"] = _total(metrics, "node_network_transmit_bytes_total", virtual)
+        counters["net_rx"] = _total(metrics, "node_network_receive_bytes_total", virtual)
+        counters["disk_rd"] = _total(metrics, "node_disk_read_bytes_total")
+        counters["disk_wr"] = _total(metrics, "node_disk_written_bytes_total")
+
+        prev, self._prev = self._prev, counters
+        if prev:
+            dt = now - prev["t"]
+            busy = counters["cpu_all"] - prev["cpu_all"]
+            if busy > 0:
+                stats["cpu_percent"] = round(100 * (1 - (counters["cpu_idle"] - prev["cpu_idle"]) / busy))
+            for key, name in (("net_tx", "net_up"), ("net_rx", "net_down"),
+                              ("disk_rd", "disk_read_kbs"), ("disk_wr", "disk_write_kbs")):
+                if dt > 0 and counters[key] is not None and prev[key] is not None:
+                    stats[name] = max(0, round((counters[key] - prev[key]) / dt / 1024))
+
+        total = _one(metrics, "node_memory_MemTotal_bytes")
+        avail = _one(metrics, "node_memory_MemAvailable_bytes")
+        if total and avail is not None:
+            stats["ram_percent"] = round(100 * (1 - avail / total))
+        swap_total = _one(metrics, "node_memory_SwapTotal_bytes")
+        swap_free = _one(metrics, "node_memory_SwapFree_bytes")
+        if swap_total and swap_free is not None:
+            stats["swap_percent"] = round(100 * (1 - swap_free / swap_total))
+
+        root = lambda labels: labels.get("mountpoint") == "/" and labels.get("fstype") not in _VIRTUAL_FS
+        size = _one(metrics, "node_filesystem_size_bytes", root)
+        free = _one(metrics, "node_filesystem_avail_bytes", root)
+        if size and free is not None:
+            stats["disk_percent"] = round(100 * (1 - free / size))
+
+        load1 = _one(metrics, "node_load1")
+        if load1 is not None:
+            stats["load_avg"] = round(load1 * 100)
+        boot = _one(metrics, "node_boot_time_seconds")
+        clock = _one(metrics, "node_time_seconds")
+        if boot and clock:
+            stats["uptime_hours"] = int((clock - boot) // 3600)
+        procs = _one(metrics, "node_processes_threads") or _one(metrics, "node_procs_running")
+        if procs is not None:
+            stats["proc_count"] = int(procs)
+
+        temps = [v for labels, v in metrics.get("node_hwmon_temp_celsius", ()) if 0 < v < 150]
+        if not temps:
+            temps = [v for _, v in metrics.get("node_thermal_zone_temp", ()) if 0 < v < 150]
+        if temps:
+            stats["cpu_temp"] = round(max(temps), 1)
+        freqs = [v for _, v in metrics.get("node_cpu_scaling_frequency_hertz", ())]
+        if freqs:
+            stats["cpu_freq"] = round(sum(freqs) / len(freqs) / 1e6)
+        return stats
+
+
+# ---------------------------------------------------------------------------
+# Poller
+# ---------------------------------------------------------------------------
+
+class RemoteStatsPoller:
+    """Scrapes every configured host on its own daemon thread.
+
+    take() hands the stats loop whatever arrived since its last call without
+    blocking: (host id, {stat name: value}) per host with a fresh scrape, and
+    (host id, None) once, when a host has failed REMOTE_DOWN_AFTER scrapes in
+    a row.
+    """
+
+    def __init__(self, hosts: List[dict]):
+        self._hosts = hosts
+        self._lock = threading.Lock()
+        self._fresh: Dict[int, Optional[Dict[str, float]]] = {}
+        self._stop = threading.Event()
+        self._threads: List[threading.Thread] = []
+
+    def start(self):
+        for host in self._hosts:
+            t = threading.Thread(target=self._run, args=(host,), daemon=True,
+                                 name=f"remote-stats-{host['name']}")
+            t.start()
+            self._threads.append(t)
+        if self._hosts:
+            logger.info("Remote stats: %s", ", ".join(f"{h['id']}={h['name']} ({h['kind']})"
+                                                      for h in self._hosts))
+
+    def stop(self):
+        self._stop.set()
+
+    def take(self) -> List[Tuple[int, Optional[Dict[str, float]]]]:
+        with self._lock:
+            fresh, self._fresh = self._fresh, {}
+        return sorted(fresh.items())
+
+    def _run(self, host):
+        session = requests.Session()
+        node = NodeExporterStats() if host["kind"] == "prometheus" else None
+        failures = 0
+        while not self._stop.is_set():
+            start = time.monotonic()
+            try:
+                stats = self._scrape(session, host, node)
+            except (requests.RequestException, ValueError) as exc:
+                failures += 1
+                if failures == REMOTE_DOWN_AFTER:
+                    logger.warning("Remote stats %s: down (%s)", host["name"], exc)
+                    with self._lock:
+                        self._fresh[host["id"]] = None
+            else:
+                if failures >= REMOTE_DOWN_AFTER:
+                    logger.info("Remote stats %s: back", host["name"])
+                failures = 0
+                if stats:
+                    with self._lock:
+                        self._fresh[host["id"]] = stats
+            self._stop.wait(max(0.0, host["interval"] - (time.monotonic() - start)))
+
+    @staticmethod
+    def _scrape(session, host, node) -> Dict[str, float]:
+        resp = session.get(host["url"], timeout=host["timeout"])
+        resp.raise_for_status()
+        if node is not None:
+            return node.update(parse_prometheus(resp.text), time.monotonic())
+        data = resp.json()
+        stats = data.get("stats", data) if isinstance(data, dict) else {}
+        return {k: v for k, v in stats.items()
+                if isinstance(k, str) and isinstance(v, (int, float)) and not isinstance(v, bool)}
+
+
+# ---------------------------------------------------------------------------
+# Agent: `python -m companion.remote_stats --serve` on the remote machine
+# ---------------------------------------------------------------------------
+
+class _AgentSampler:
+    """psutil stats sampled once a second, so rates span a steady window
+    whatever the scrape interval."""
+
+    def __init__(self):
+        import psutil
+        self._psutil = psutil
+        self._lock = threading.Lock()
+        self._stats: Dict[str, float] = {}
+        threading.Thread(target=self._run, daemon=True).start()
+
+    def snapshot(self) -> Dict[str, float]:
+        with self._lock:
+            return dict(self._stats)
+
+    def _run(self):
+        ps = self._psutil
+        ps.cpu_percent()
+        prev_net, prev_disk, prev_t = ps.net_io_counters(), ps.disk_io_counters(), time.monotonic()
+        while True:
+            time.sleep(1.0)
+            now = time.monotonic()
+            dt = max(1e-3, now - prev_t)
+            net, disk = ps.net_io_counters(), ps.disk_io_counters()
+            stats = {
+                "cpu_percent": round(ps.cpu_percent()),
+                "ram_percent": round(ps.virtual_memory().percent),
+                "swap_percent": round(ps.swap_memory().percent),
+                "disk_percent": round(ps.disk_usage("/").percent),
+                "net_up": round((net.bytes_sent - prev_net.bytes_sent) / dt / 1024),
+                "net_down": round((net.bytes_recv - prev_net.bytes_recv) / dt / 1024),
+                "load_avg": round(ps.getloadavg()[0] * 100),
+                "uptime_hours": int((time.time() - ps.boot_time()) // 3600),
+                "proc_count": len(ps.pids()),
+            }
+            if disk and prev_disk:
+                stats["disk_read_kbs"] = round((disk.read_bytes - prev_disk.read_bytes) / dt / 1024)
+                stats["disk_write_kbs"] = round((disk.write_bytes - prev_disk.write_bytes) / dt / 1024)
+            freq = ps.cpu_freq()
+            if freq:
+                stats["cpu_freq"] = round(freq.current)
+            try:
+                temps = [t.current for sensors in ps.sensors_temperatures().values() for t in sensors
+                         if 0 < t.current < 150]
+                if temps:
+                    stats["cpu_temp"] = round(max(temps), 1)
+            except (AttributeError, OSError):
+                pass
+            prev_net, prev_disk, prev_t = net, disk, now
+            with self._lock:
+                self._stats = stats
+
+
+def serve_agent(port=AGENT_PORT, bind="0.0.0.0"):
+    sampler = _AgentSampler()
+
+    class Handler(BaseHTTPRequestHandler):
+        def do_GET(self):
+            body = json.dumps({"stats": sampler.snapshot()}).encode()
+            self.send_response(200)
+            self.send_header("Content-Type", "application/json")
+            self.send_header("Content-Length", str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+
+        def log_message(self, fmt, *args):
+            logger.debug(fmt, *args)
+
+    logger.info("Stats agent on %s:%d", bind, port)
+    ThreadingHTTPServer((bind, port), Handler).serve_forever()
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="CrowPanel remote stats agent")
+    parser.add_argument("--serve", action="store_true", help="serve this machine's stats as JSON")
+    parser.add_argument("--port", type=int, default=AGENT_PORT)
+    parser.add_argument("--bind", default="0.0.0.0")
+    args = parser.parse_args()
+    logging.basicConfig(level=logging.INFO, format="%(asctime)s %(levelname)s %(message)s")
+    if args.serve:
+        serve_agent(args.port, args.bind)
+    else:
+        parser.print_help()
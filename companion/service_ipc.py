@@ -0,0 +1,460 @@
+"""
+Service IPC: the companion service as the one owner of the bridge's HID device.
+
+CompanionService opens the bridge (or a wired display), reconnects when it
+goes away and serves everyone else over a UNIX socket, so the tray, the
+editor's deploy and upload dialogs and command-line tools never open the
+device themselves and never contend for it. BridgeDevice uses the socket
+whenever a service is listening and only opens the device directly when
+none is.
+
+The socket ($XDG_RUNTIME_DIR/crowpanel-companion.sock, or the config
+directory without one; $CROWPANEL_SOCKET overrides) carries one JSON object
+per line. Requests carry an "id" that their reply repeats:
+
+    {"op": "status"}                 -> connected, wired, status text
+    {"op": "send", "type": 0x09, "payload": "<hex>", "display": null,
+     "class": "control", "wait": true}
+                                     -> ok: written (or queued, wait false)
+    {"op": "subscribe", "topics": ["message"], "types": [0x12]}
+
+Events have no id and are pushed to subscribers as they happen:
+
+    {"event": "message", "display": 0, "type": 0x12, "payload": "<hex>"}
+    {"event": "bridge_stats", "sample": {...decode_bridge_stats()...}}
+    {"event": "connection", "connected": true}
+
+"message" is every inbound vendor message ([TYPE] split off, display
+envelope removed), optionally only the given types. A subscriber that
+falls SUBSCRIBER_QUEUE events behind loses the newest ones rather than
+stalling the reader.
+
+    python -m companion.service_ipc status
+    python -m companion.service_ipc watch [TYPE...]
+    python -m companion.service_ipc send TYPE [HEX] [--display N]
+"""
+
+import argparse
+import itertools
+import json
+import logging
+import os
+import queue
+import socket
+import sys
+import threading
+from pathlib import Path
+
+from companion.bridge_device import WRITE_CLASS_NAMES
+
+logger = logging.getLogger(__name__)
+
+SOCKET_NAME = "crowpanel-companion.sock"
+SUBSCRIBER_QUEUE = 1024       # Events buffered per client
+REQUEST_TIMEOUT = 5.0         # Seconds a client waits for a reply (sends can wait on the writer)
+LINE_MAX = 64 * 1024          # Longest request line the service reads
+
+_CLOSED = object()            # Queued behind the last event once the connection is gone
+
+
+class ServiceRunningError(RuntimeError):
+    """Another companion service already owns the bridge (its socket answers)."""
+
+
+class ServiceError(IOError):
+    """The service went away, or a request timed out or was refused."""
+
+
+def socket_path() -> Path:
+    override = os.environ.get("CROWPANEL_SOCKET")
+    if override:
+        return Path(override)
+    runtime = os.environ.get("XDG_RUNTIME_DIR")
+    if runtime and os.path.isdir(runtime):
+        return Path(runtime) / SOCKET_NAME
+    from companion.config_manager import DEFAULT_CONFIG_DIR
+    return DEFAULT_CONFIG_DIR / SOCKET_NAME
+
+
+def _encode(obj) -> bytes:
+    return (json.dumps(obj, separators=(",", ":")) + "\n").encode()
+
+
+def service_running(path=None) -> bool:
+    """True if a service answers on the socket."""
+    sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    try:
+        sock.settimeout(0.5)
+        sock.connect(str(path or socket_path()))
+        return True
+    except OSError:
+        return False
+    finally:
+        sock.close()
+
+
+# ---------------------------------------------------------------------------
+# Service side
+# ---------------------------------------------------------------------------
+
+class _Subscriber:
+    """One connected client: its reader runs the requests, a sender thread
+    writes replies and events so a slow client never blocks the service."""
+
+    def __init__(self, server, sock):
+        self.server = server
+        self.sock = sock
+        self.topics = set()
+        self.types = None         # Message types for "message", None = all
+        self.dropped = 0
+        self._out = queue.Queue(SUBSCRIBER_QUEUE)
+        self._alive = True
+
+    def start(self):
+        threading.Thread(target=self._send_loop, name="ipc-send", daemon=True).start()
+        threading.Thread(target=self._read_loop, name="ipc-read", daemon=True).start()
+
+    def push(self, data: bytes, reply=False):
+        try:
+            if reply:
+                self._out.put(data, timeout=REQUEST_TIMEOUT)   # Replies are never dropped
+            else:
+                self._out.put_nowait(data)
+        except queue.Full:
+            self.dropped += 1
+
+    def wants(self, topic, msg_type=None) -> bool:
+        if topic not in self.topics:
+            return False
+        return msg_type is None or self.types is None or msg_type in self.types
+
+    def close(self):
+        if not self._alive:
+            return
+        self._alive = False
+        self.server._remove(self)
+        try:
+            self.sock.shutdown(socket.SHUT_RDWR)
+        except OSError:
+            pass
+        self._out.put(None)
+
+    def _send_loop(self):
+        while True:
+            data = self._out.get()
+            if data is None:
+                break
+            try:
+                self.sock.sendall(data)
+            except OSError:
+                self.close()
+                break
+        self.sock.close()
+
+    def _read_loop(self):
+        buf = b""
+        try:
+            while self._alive:
+                chunk = self.sock.recv(65536)
+                if not chunk:
+                    break
+                buf += chunk
+                while b"\n" in buf:
+                    line, buf = buf.split(b"\n", 1)
+                    if line.strip():
+                        self._handle(line)
+                if len(buf) > LINE_MAX:
+                    logger.warning("IPC: request line too long, closing client")
+                    break
+        except OSError:
+            pass
+        self.close()
+
+    def _handle(self, line):
+        req_id = None
+        try:
+            req = json.loads(line)
+            req_id = req.get("id")
+            reply = self.server._dispatch(self, req)
+        except (ValueError, TypeError, KeyError, AttributeError) as exc:
+            reply = {"ok": False, "error": f"bad request: {exc}"}
+        reply["id"] = req_id
+        self.push(_encode(reply), reply=True)
+
+
+class IpcServer:
+    """The service's socket: requests go to `service` (CompanionService),
+    publish() fans events out to the subscribers that asked for them."""
+
+    def __init__(self, service, path=None):
+        self._service = service
+        self._path = Path(path) if path else socket_path()
+        self._sock = None
+        self._clients = []
+        self._lock = threading.Lock()
+
+    def start(self):
+        """Listen. Raises ServiceRunningError if another service answers on
+        the socket; a stale socket file is replaced."""
+        if service_running(self._path):
+            raise ServiceRunningError(f"companion service already running ({self._path})")
+        self._path.parent.mkdir(parents=True, exist_ok=True)
+        try:
+            self._path.unlink()
+        except FileNotFoundError:
+            pass
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        old_umask = os.umask(0o177)   # Owner only: the socket can type keys
+        try:
+            sock.bind(str(self._path))
+        finally:
+            os.umask(old_umask)
+        sock.listen(8)
+        self._sock = sock
+        threading.Thread(target=self._accept_loop, name="ipc-accept", daemon=True).start()
+        logger.info("IPC: listening on %s", self._path)
+
+    def stop(self):
+        sock, self._sock = self._sock, None
+        if sock is None:
+            return
+        sock.close()
+        try:
+            self._path.unlink()
+        except OSError:
+            pass
+        with self._lock:
+            clients = list(self._clients)
+        for client in clients:
+            client.close()
+
+    @property
+    def client_count(self) -> int:
+        return len(self._clients)
+
+    def publish(self, topic, event: dict, msg_type=None):
+        """Send `event` to every client subscribed to `topic` (and msg_type)."""
+        if not self._clients:
+            return
+        with self._lock:
+            targets = [c for c in self._clients if c.wants(topic, msg_type)]
+        if not targets:
+            return
+        event["event"] = topic
+        data = _encode(event)
+        for client in targets:
+            client.push(data)
+
+    def publish_message(self, display, message: bytes):
+        """An inbound [TYPE][PAYLOAD...] message, for "message" subscribers."""
+        if self._clients and message:
+            self.publish("message", {"display": display, "type": message[0],
+                                     "payload": bytes(message[1:]).hex()}, message[0])
+
+    def _accept_loop(self):
+        while self._sock is not None:
+            try:
+                conn, _ = self._sock.accept()
+            except OSError:
+                break
+            client = _Subscriber(self, conn)
+            with self._lock:
+                self._clients.append(client)
+            client.start()
+
+    def _remove(self, client):
+        with self._lock:
+            if client in self._clients:
+                self._clients.remove(client)
+        if client.dropped:
+            logger.warning("IPC: client dropped %d events (not reading fast enough)", client.dropped)
+
+    def _dispatch(self, client, req):
+        op = req["op"]
+        if op == "status":
+            return dict(ok=True, **self._service.ipc_status())
+        if op == "send":
+            cls = WRITE_CLASS_NAMES.index(req.get("class", "control"))
+            payload = bytes.fromhex(req.get("payload", ""))
+            ok = self._service.send_message(int(req["type"]), payload, req.get("display"), cls,
+                                            wait=req.get("wait", True))
+            return {"ok": ok} if ok else {"ok": False, "error": "bridge not connected"}
+        if op == "subscribe":
+            client.topics = set(req.get("topics", []))
+            types = req.get("types")
+            client.types = set(types) if types else None
+            return {"ok": True}
+        return {"ok": False, "error": f"unknown op {op!r}"}
+
+
+# ---------------------------------------------------------------------------
+# Client side
+# ---------------------------------------------------------------------------
+
+class ServiceClient:
+    """A connection to the service. Replies are matched to requests by id;
+    events go to `on_event(event)` when given, else into a queue read with
+    next_event(). Thread-safe."""
+
+    def __init__(self, path=None, on_event=None):
+        self._path = Path(path) if path else socket_path()
+        self._on_event = on_event
+        self._sock = None
+        self._ids = itertools.count(1)
+        self._pending = {}
+        self._lock = threading.Lock()
+        self._send_lock = threading.Lock()
+        self._events = queue.Queue()
+        self._closed = threading.Event()
+
+    def connect(self) -> bool:
+        """False when no service is listening."""
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        try:
+            sock.connect(str(self._path))
+        except OSError:
+            sock.close()
+            return False
+        self._sock = sock
+        self._closed.clear()
+        threading.Thread(target=self._read_loop, name="ipc-client", daemon=True).start()
+        return True
+
+    def close(self):
+        sock, self._sock = self._sock, None
+        if sock is not None:
+            try:
+                sock.shutdown(socket.SHUT_RDWR)
+            except OSError:
+                pass
+            sock.close()
+
+    @property
+    def connected(self) -> bool:
+        return self._sock is not None and not self._closed.is_set()
+
+    def request(self, op, timeout=REQUEST_TIMEOUT, **fields) -> dict:
+        """The reply to one request. Raises ServiceError if the service is
+        gone or doesn't answer in time."""
+        if not self.connected:
+            raise ServiceError("companion service not connected")
+        req_id = next(self._ids)
+        slot = [threading.Event(), None]
+        with self._lock:
+            self._pending[req_id] = slot
+        try:
+            with self._send_lock:
+                self._sock.sendall(_encode(dict(fields, op=op, id=req_id)))
+            if not slot[0].wait(timeout) or slot[1] is None:
+                raise ServiceError(f"companion service: no answer to {op}")
+            return slot[1]
+        except OSError as exc:
+            raise ServiceError(f"companion service: {exc}")
+        finally:
+            with self._lock:
+                self._pending.pop(req_id, None)
+
+    def status(self) -> dict:
+        return self.request("status")
+
+    def send(self, msg_type, payload=b"", display=None, cls="control", wait=True) -> bool:
+        """Write one message through the service's HID writer (class by
+        name, WRITE_CLASS_NAMES). True once written, or queued with wait=False."""
+        reply = self.request("send", type=msg_type, payload=bytes(payload).hex(), display=display,
+                             **{"class": cls, "wait": wait})
+        return reply.get("ok", False)
+
+    def subscribe(self, topics, types=None):
+        """Replace this connection's subscriptions."""
+        self.request("subscribe", topics=list(topics), types=list(types) if types else None)
+
+    def next_event(self, timeout=None):
+        """The next queued event, None on timeout. Raises ServiceError once
+        the connection is gone and nothing is left."""
+        try:
+            event = self._events.get(timeout=timeout) if timeout != 0 else self._events.get_nowait()
+        except queue.Empty:
+            return None
+        if event is _CLOSED:
+            self._events.put(_CLOSED)   # For the next call too
+            raise ServiceError("companion service closed the connection")
+        return event
+
+    def _read_loop(self):
+        buf = b""
+        sock = self._sock
+        try:
+            while True:
+                chunk = sock.recv(65536)
+                if not chunk:
+                    break
+                buf += chunk
+                while b"\n" in buf:
+                    line, buf = buf.split(b"\n", 1)
+                    self._dispatch(json.loads(line))
+        except (OSError, ValueError):
+            pass
+        self._closed.set()
+        self._events.put(_CLOSED)
+        with self._lock:
+            for slot in self._pending.values():
+                slot[0].set()
+
+    def _dispatch(self, msg):
+        if "event" in msg:
+            if self._on_event is not None:
+                self._on_event(msg)
+            else:
+                self._events.put(msg)
+            return
+        with self._lock:
+            slot = self._pending.get(msg.get("id"))
+        if slot is not None:
+            slot[1] = msg
+            slot[0].set()
+
+    def __enter__(self):
+        if not self.connect():
+            raise ServiceError(f"no companion service on {self._path}")
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        self.close()
+        return False
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description="Talk to the running companion service")
+    sub = parser.add_subparsers(dest="cmd", required=True)
+    sub.add_parser("status", help="bridge connection state")
+    watch = sub.add_parser("watch", help="print inbound messages and bridge stats as they come")
+    watch.add_argument("types", nargs="*", type=lambda v: int(v, 0), help="only these message types")
+    send = sub.add_parser("send", help="send one message")
+    send.add_argument("type", type=lambda v: int(v, 0))
+    send.add_argument("payload", nargs="?", default="", help="payload as hex")
+    send.add_argument("--display", type=int, default=None)
+    send.add_argument("--class", dest="cls", default="control", choices=WRITE_CLASS_NAMES)
+    args = parser.parse_args(argv)
+
+    try:
+        with ServiceClient() as client:
+            if args.cmd == "status":
+                print(json.dumps(client.status(), indent=2))
+            elif args.cmd == "send":
+                if not client.send(args.type, bytes.fromhex(args.payload), args.display, args.cls):
+                    print("not sent: bridge not connected", file=sys.stderr)
+                    return 1
+            else:
+                client.subscribe(["message", "bridge_stats", "connection"], args.types)
+                while True:
+                    print(json.dumps(client.next_event()), flush=True)
+    except ServiceError as exc:
+        print(exc, file=sys.stderr)
+        return 1
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -11,14 +11,16 @@ import os
 import shutil
 import subprocess
 import sys
+import threading
 from pathlib import Path
 
 from PySide6.QtCore import Qt, QTimer, Signal, QObject
 from PySide6.QtGui import QAction, QIcon, QImage, QPixmap, QPainter, QColor
-from PySide6.QtWidgets import QApplication, QMenu, QSystemTrayIcon
+from PySide6.QtWidgets import QApplication, QFileDialog, QMenu, QSystemTrayIcon
 
 from companion.config_manager import get_config_manager, DEFAULT_CONFIG_DIR, DEFAULT_CONFIG_PATH
 from companion.hotkey_companion import CompanionService
+from companion.service_ipc import ServiceRunningError
 
 # XDG autostart paths
 AUTOSTART_DIR = Path.home() / ".config" / "autostart"
@@ -40,6 +42,9 @@ class _ServiceSignals(QObject):
     bridge_disconnected = Signal()
     stats_sent = Signal()
     button_pressed = Signal(int, int)
+    bridge_stats = Signal()
+    firmware_progress = Signal(int)  # Percent
+    firmware_done = Signal(str)      # "" on success, else the error
 
 
 def _tint_icon(path: Path, tint: QColor) -> QIcon:
@@ -95,12 +100,16 @@ class CrowPanelTray(QApplication):
         self._signals.bridge_disconnected.connect(self._on_bridge_disconnected)
         self._signals.stats_sent.connect(self._on_stats_sent)
         self._signals.button_pressed.connect(self._on_button_pressed)
+        self._signals.bridge_stats.connect(self._on_bridge_stats)
+        self._signals.firmware_progress.connect(self._on_firmware_progress)
+        self._signals.firmware_done.connect(self._on_firmware_done)
 
         # Wire service callbacks to emit Qt signals
         self._service.on_bridge_connected = lambda: self._signals.bridge_connected.emit()
         self._service.on_bridge_disconnected = lambda: self._signals.bridge_disconnected.emit()
         self._service.on_stats_sent = lambda: self._signals.stats_sent.emit()
         self._service.on_button_press = lambda p, w: self._signals.button_pressed.emit(p, w)
+        self._service.on_bridge_stats = lambda sample: self._signals.bridge_stats.emit()
 
         # System tray icon — tinted grayscale crow
         self._tray = QSystemTrayIcon(self)
@@ -119,6 +128,12 @@ class CrowPanelTray(QApplication):
         refresh_action = self._menu.addAction("Refresh Config")
         refresh_action.triggered.connect(self._on_refresh)
 
+        health_action = self._menu.addAction("Bridge Health...")
+        health_action.triggered.connect(self._on_health)
+
+        self._firmware_action = self._menu.addAction("Update Bridge Firmware...")
+        self._firmware_action.triggered.connect(self._on_update_firmware)
+
         self._menu.addSeparator()
 
         self._autostart_action = self._menu.addAction("Autostart")
@@ -141,9 +156,20 @@ class CrowPanelTray(QApplication):
         # Editor window (in-process) or subprocess handle
         self._editor = None
         self._editor_proc = None
+        self._health = None
 
         # Start companion service
-        self._service.start()
+        self._start_service()
+
+    def _start_service(self):
+        """Start the service; another one owning the bridge (e.g. the systemd
+        unit) is shown in the menu rather than fought over."""
+        try:
+            self._service.start()
+        except ServiceRunningError as exc:
+            logging.warning("%s", exc)
+            self._status_action.setText("Bridge: owned by the running companion service")
+            self._tray.setToolTip("CrowPanel — companion service already running")
 
     def _on_bridge_connected(self):
         self._tray.setIcon(_tint_icon(TRAY_ICON_PATH, COLOR_CONNECTED))
@@ -159,6 +185,55 @@ class CrowPanelTray(QApplication):
     def _on_button_pressed(self, page_idx, widget_idx):
         logging.debug("Tray: button press page=%d widget=%d", page_idx, widget_idx)
 
+    def _on_bridge_stats(self):
+        if self._health is not None and self._health.isVisible():
+            self._health.refresh()
+
+    def _on_health(self):
+        """Open or bring to front the bridge health graphs."""
+        if self._health is None:
+            from companion.ui.bridge_health import BridgeHealthWindow
+            self._health = BridgeHealthWindow(self._service)
+            if APP_ICON_PATH.is_file():
+                self._health.setWindowIcon(QIcon(str(APP_ICON_PATH)))
+        self._health.refresh()
+        self._health.show()
+        self._health.raise_()
+        self._health.activateWindow()
+
+    def _on_update_firmware(self):
+        """Pick a bridge firmware.bin and flash it in the background over USB HID."""
+        path, _ = QFileDialog.getOpenFileName(None, "Bridge firmware", str(Path.home()),
+                                              "Firmware (*.bin *.bin.gz)")
+        if not path:
+            return
+        image = Path(path).read_bytes()
+        self._firmware_action.setEnabled(False)
+        self._firmware_action.setText("Updating Bridge Firmware (0%)")
+
+        def progress(sent, total):
+            self._signals.firmware_progress.emit(sent * 100 // max(total, 1))
+
+        def run():
+            try:
+                self._service.update_bridge_firmware(image, progress)
+                self._signals.firmware_done.emit("")
+            except Exception as exc:
+                self._signals.firmware_done.emit(str(exc))
+        threading.Thread(target=run, daemon=True).start()
+
+    def _on_firmware_progress(self, pct):
+        self._firmware_action.setText(f"Updating Bridge Firmware ({pct}%)")
+
+    def _on_firmware_done(self, error):
+        self._firmware_action.setEnabled(True)
+        self._firmware_action.setText("Update Bridge Firmware...")
+        if error:
+            self._tray.showMessage("Bridge update failed", error, QSystemTrayIcon.Warning)
+        else:
+            self._tray.showMessage("Bridge updated",
+                                   "The bridge restarts into the new firmware when no key is held.")
+
     def _update_status(self):
         text = self._service.status_text
         self._status_action.setText(text)
@@ -253,7 +328,7 @@ class CrowPanelTray(QApplication):
         self._service.stop()
         self._tray.setIcon(_tint_icon(TRAY_ICON_PATH, COLOR_DISCONNECTED))
         self._status_action.setText("Restarting...")
-        self._service.start()
+        self._start_service()
         logging.info("Companion service restarted")
 
     def _on_quit(self):
@@ -264,5 +339,7 @@ class CrowPanelTray(QApplication):
             self._editor.close()
         if self._editor_proc is not None and self._editor_proc.poll() is None:
             self._editor_proc.terminate()
+        if self._health is not None:
+            self._health.close()
         self._tray.hide()
         self.quit()
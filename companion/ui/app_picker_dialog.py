@@ -19,7 +19,7 @@ from PySide6.QtWidgets import (
 from PySide6.QtCore import Qt, QSize
 from PySide6.QtGui import QIcon, QPixmap
 
-from companion.app_scanner import AppEntry, scan_applications
+from companion.app_scanner import AppEntry, app_icon_png, scan_applications
 
 
 class AppPickerDialog(QDialog):
@@ -33,6 +33,7 @@ class AppPickerDialog(QDialog):
 
         self._apps = []
         self._selected_app = None
+        self._icons = {}  # desktop_file -> QIcon, so searches don't reload them
 
         layout = QVBoxLayout(self)
 
@@ -97,17 +98,30 @@ class AppPickerDialog(QDialog):
             item.setText(app.name)
             item.setData(Qt.UserRole, app)
 
-            # Load icon
-            if app.icon_path:
-                icon = QIcon(app.icon_path)
-                if not icon.isNull():
-                    item.setIcon(icon)
+            icon = self._icon_for(app)
+            if icon is not None:
+                item.setIcon(icon)
 
             if app.comment:
                 item.setToolTip(app.comment)
 
             self.app_list.addItem(item)
 
+    def _icon_for(self, app):
+        """Pre-rendered PNG from the app icon cache, else the source file; None without one."""
+        if app.desktop_file not in self._icons:
+            icon = None
+            png = app_icon_png(app, 32, 32)
+            pixmap = QPixmap()
+            if png and pixmap.loadFromData(png, "PNG"):
+                icon = QIcon(pixmap)
+            elif app.icon_path:
+                icon = QIcon(app.icon_path)
+                if icon.isNull():
+                    icon = None
+            self._icons[app.desktop_file] = icon
+        return self._icons[app.desktop_file]
+
     def _on_search(self, text):
         """Filter app list by search text."""
         query = text.lower().strip()
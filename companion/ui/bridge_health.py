@@ -0,0 +1,169 @@
+"""
+Bridge Health: live graphs of the bridge's MSG_BRIDGE_STATS reports.
+
+Opened from the tray menu. Shows the ESP-NOW traffic per direction, vendor
+HID throughput, USB and radio task times and loop stalls, the rings between the two tasks,
+RSSI both ways and the adapted TX power / PHY rate, free heap and the loss counters (RX queue drops, refused sends) over
+the history the companion keeps, so a bottleneck shows up without a serial
+console on the bridge.
+"""
+
+from PySide6.QtCore import Qt, QPointF
+from PySide6.QtGui import QColor, QPainter, QPen, QPolygonF
+from PySide6.QtWidgets import QGridLayout, QLabel, QVBoxLayout, QWidget
+
+# (title, unit, [(series label, color, value getter)])
+GRAPHS = [
+    ("ESP-NOW frames", "/s", [
+        ("rx", "#3498DB", lambda s: s["rates"].get("espnow_rx_frames")),
+        ("tx", "#E67E22", lambda s: s["rates"].get("espnow_tx_frames")),
+        ("tx batched msgs", "#9B59B6", lambda s: s["rates"].get("espnow_tx_batched")),
+    ]),
+    ("ESP-NOW throughput", " KB/s", [
+        ("rx", "#3498DB", lambda s: _kb(s["rates"].get("espnow_rx_bytes"))),
+        ("tx", "#E67E22", lambda s: _kb(s["rates"].get("espnow_tx_bytes"))),
+    ]),
+    ("Vendor HID", " KB/s", [
+        ("rx", "#3498DB", lambda s: s["vendor_rx_kbps"]),
+        ("tx", "#E67E22", lambda s: s["vendor_tx_kbps"]),
+    ]),
+    ("HID reports", "/s", [
+        ("reports", "#2ECC71", lambda s: s["rates"].get("hid_reports")),
+    ]),
+    ("Task time", " us", [
+        ("usb avg", "#2ECC71", lambda s: s["loop_avg_us"]),
+        ("usb max", "#E74C3C", lambda s: s["loop_max_us"]),
+        ("radio avg", "#3498DB", lambda s: s.get("radio_avg_us")),
+        ("radio max", "#E67E22", lambda s: s.get("radio_max_us")),
+    ]),
+    ("Loop stalls", "/s", [
+        ("over budget", "#E74C3C", lambda s: s["rates"].get("loop_stalls")),
+    ]),
+    ("Task rings", "", [
+        ("usb->radio high", "#3498DB", lambda s: s.get("to_radio_high")),
+        ("radio->usb high", "#E67E22", lambda s: s.get("to_usb_high")),
+        ("held/s", "#9B59B6", lambda s: s["rates"].get("to_radio_full")),
+        ("refused/s", "#E74C3C", lambda s: s["rates"].get("to_usb_full")),
+    ]),
+    ("RX queue", "", [
+        ("high-water", "#9B59B6", lambda s: s["rx_queue_high"]),
+        ("drops/s", "#E74C3C", lambda s: s["rates"].get("rx_queue_drops")),
+        ("tx refused/s", "#E67E22", lambda s: s["rates"].get("espnow_tx_failed")),
+    ]),
+    ("RSSI", " dBm", [
+        ("display", "#1ABC9C", lambda s: s["rssi_dbm"]),
+        ("at weakest display", "#E67E22", lambda s: s.get("far_rssi_dbm")),
+    ]),
+    ("Radio setting", "", [
+        ("tx power dBm", "#3498DB", lambda s: s.get("tx_power_dbm")),
+        ("rate step", "#E74C3C", lambda s: s.get("phy_rate_step")),
+    ]),
+    ("Free heap", " KB", [
+        ("heap", "#7F8C8D", lambda s: s["free_heap"] / 1024.0),
+    ]),
+]
+
+
+def _kb(value):
+    return None if value is None else value / 1024.0
+
+
+class Sparkline(QWidget):
+    """One graph: a line per series over the sample history, auto-scaled."""
+
+    def __init__(self, title, unit, series, parent=None):
+        super().__init__(parent)
+        self._title = title
+        self._unit = unit
+        self._series = series
+        self._samples = []
+        self.setMinimumSize(260, 90)
+
+    def set_samples(self, samples):
+        self._samples = samples
+        self.update()
+
+    def paintEvent(self, event):
+        p = QPainter(self)
+        p.setRenderHint(QPainter.Antialiasing)
+        rect = self.rect().adjusted(4, 18, -4, -4)
+        p.fillRect(rect, QColor("#1E1E1E"))
+        p.setPen(QColor("#CCCCCC"))
+        p.drawText(4, 13, self._title)
+
+        lines = []
+        for label, color, getter in self._series:
+            values = [getter(s) for s in self._samples]
+            lines.append((label, color, values))
+        known = [v for _, _, values in lines for v in values if v is not None]
+        if not known:
+            p.drawText(rect, Qt.AlignCenter, "No data")
+            return
+        lo, hi = min(known), max(known)
+        if lo > 0:
+            lo = 0
+        if hi - lo < 1e-9:
+            hi = lo + 1
+
+        n = max(len(self._samples) - 1, 1)
+        legend_x = rect.right()
+        for label, color, values in reversed(lines):
+            points = [QPointF(rect.left() + rect.width() * i / n,
+                              rect.bottom() - (v - lo) / (hi - lo) * rect.height())
+                      for i, v in enumerate(values) if v is not None]
+            p.setPen(QPen(QColor(color), 1.5))
+            if len(points) > 1:
+                p.drawPolyline(QPolygonF(points))
+            last = next((v for v in reversed(values) if v is not None), None)
+            text = f"{label} {_fmt(last)}{self._unit}"
+            legend_x -= p.fontMetrics().horizontalAdvance(text) + 10
+            p.drawText(legend_x, 13, text)
+
+        p.setPen(QColor("#777777"))
+        p.drawText(rect.adjusted(2, 0, 0, 0), Qt.AlignTop | Qt.AlignLeft, _fmt(hi))
+
+
+def _fmt(value):
+    if value is None:
+        return "-"
+    if abs(value) >= 100 or float(value).is_integer():
+        return f"{value:.0f}"
+    return f"{value:.1f}"
+
+
+class BridgeHealthWindow(QWidget):
+    """Grid of sparklines fed from CompanionService.bridge_stats_history."""
+
+    def __init__(self, service, parent=None):
+        super().__init__(parent)
+        self._service = service
+        self.setWindowTitle("CrowPanel — Bridge Health")
+
+        layout = QVBoxLayout(self)
+        self._summary = QLabel("Waiting for the bridge...")
+        layout.addWidget(self._summary)
+        grid = QGridLayout()
+        layout.addLayout(grid)
+        self._graphs = []
+        for i, (title, unit, series) in enumerate(GRAPHS):
+            graph = Sparkline(title, unit, series)
+            grid.addWidget(graph, i // 2, i % 2)
+            self._graphs.append(graph)
+        self.resize(600, 480)
+        self.refresh()
+
+    def refresh(self):
+        samples = self._service.bridge_stats_history
+        for graph in self._graphs:
+            graph.set_samples(samples)
+        if samples:
+            last = samples[-1]
+            totals = last["totals"]
+            self._summary.setText(
+                f"Uptime {last['uptime_ms'] // 60000} min, channel {last['channel']}, "
+                f"RX queue {last['rx_queue_high']}/{last['rx_queue_size']} peak, "
+                f"{totals['rx_queue_drops']} dropped, "
+                f"{totals['espnow_tx_failed']} sends refused"
+                + (f", last loop stall {last['last_stall_us'] / 1000:.1f} ms "
+                   f"in {last['last_stall_section']}" if last.get("last_stall_section") else "")
+            )
@@ -3,6 +3,9 @@ Deploy Dialog: One-click deploy via USB bridge + WiFi auto-connect.
 
 Orchestrates the full deploy sequence:
 1. Open bridge USB HID
+   Fast path: push images + config as bulk transfers through the bridge
+   (USB -> ESP-NOW -> SD) and stop there. Displays without the bulk channel
+   don't answer, and the SoftAP sequence below is used instead.
 2. Send CONFIG_MODE (display starts SoftAP)
 3. Connect PC WiFi to CrowPanel-Config
 4. Wait for device HTTP health check
@@ -24,8 +27,10 @@ from PySide6.QtWidgets import (
 from PySide6.QtCore import QThread, Signal
 
 from companion.http_client import HTTPClient, HTTPClientError
-from companion.bridge_device import BridgeDevice, BridgeDeviceError
+from companion.bridge_device import BridgeDevice, BridgeDeviceError, BulkTransferError
 from companion.wifi_manager import WiFiManager, WiFiManagerError
+from companion.config_manager import (WIDGET_SCROLL_GRID, budget_from_device, compact_templates,
+                                      grid_icon_size)
 
 import json
 import os
@@ -35,55 +40,68 @@ import logging
 logger = logging.getLogger(__name__)
 
 
-def _resolve_deploy_images(config):
-    """Walk all widgets, resolve icon_source → system path, optimize to PNG bytes.
+def _resolve_deploy_images(config, profile=None):
+    """Walk all widgets, resolve icon_source → system path, encode for the device.
 
-    Returns dict of {filename: png_bytes} and a modified config dict with icon_path set.
+    Icons get the format `profile` renders cheapest (image_optimizer), all
+    images go through one cached, parallel optimize_batch().
+
+    Returns dict of {filename: bytes} and a modified config dict with icon_path set.
     The original config dict is not modified.
     """
     import copy
-    from companion.image_optimizer import optimize_for_widget
+    from companion.image_optimizer import ImageJob, is_animated, optimize_batch, output_format
 
     deploy_config = copy.deepcopy(config)
     images = {}
+    icon_ext = output_format("icon", profile)
+    try:
+        anim_ext = output_format("anim_icon", profile)
+    except ValueError:
+        anim_ext = None   # Firmware without GIF icons: the first frame as a still
+    jobs = []      # (ImageJob, owner dict, key, folder, filename)
+
+    def add_icon_job(owner, width, height, animate=True):
+        icon_source = owner.get("icon_source", "")
+        icon_source_type = owner.get("icon_source_type", "")
+        if not icon_source or not icon_source_type:
+            owner.pop("icon_path", None)
+            return
+
+        # Resolve to filesystem path
+        source_path = None
+        if icon_source_type == "file":
+            source_path = icon_source if os.path.exists(icon_source) else None
+        elif icon_source_type == "freedesktop":
+            from companion.app_scanner import _resolve_icon_path, _get_icon_theme
+            source_path = _resolve_icon_path(icon_source, _get_icon_theme()) or None
+
+        if not source_path:
+            logger.warning("Icon source not found: %s (%s)", icon_source, icon_source_type)
+            owner.pop("icon_path", None)
+            return
+
+        # Generate safe filename
+        base = os.path.splitext(os.path.basename(icon_source))[0] or icon_source
+        safe_name = "".join(c if c.isalnum() or c in "-_" else "_" for c in base)
+        kind, ext = "icon", icon_ext
+        if animate and anim_ext and is_animated(source_path):
+            kind, ext = "anim_icon", anim_ext
+        filename = f"{safe_name}.{ext}"
+        jobs.append((ImageJob(kind, source_path, width, height), owner, "icon_path", "icons", filename))
 
     for profile in deploy_config.get("profiles", []):
         for page in profile.get("pages", []):
             for widget in page.get("widgets", []):
-                icon_source = widget.get("icon_source", "")
-                icon_source_type = widget.get("icon_source_type", "")
-                if not icon_source or not icon_source_type:
-                    widget.pop("icon_path", None)
-                    continue
-
-                # Resolve to filesystem path
-                source_path = None
-                if icon_source_type == "file":
-                    source_path = icon_source if os.path.exists(icon_source) else None
-                elif icon_source_type == "freedesktop":
-                    from companion.app_scanner import _resolve_icon_path, _get_icon_theme
-                    source_path = _resolve_icon_path(icon_source, _get_icon_theme()) or None
-
-                if not source_path:
-                    logger.warning("Icon source not found: %s (%s)", icon_source, icon_source_type)
-                    widget.pop("icon_path", None)
+                if widget.get("widget_type") == WIDGET_SCROLL_GRID:
+                    # Rendered at the cell's icon box, the size the display shows them at;
+                    # grid cells only show stills
+                    icon_w, icon_h = grid_icon_size(widget)
+                    for entry in widget.get("entries", []):
+                        add_icon_job(entry, icon_w, icon_h, animate=False)
                     continue
-
-                # Generate safe filename
-                base = os.path.splitext(os.path.basename(icon_source))[0] or icon_source
-                safe_name = "".join(c if c.isalnum() or c in "-_" else "_" for c in base)
-                filename = f"{safe_name}.png"
-
-                # Optimize at full widget size
-                try:
-                    w = widget.get("width", 180)
-                    h = widget.get("height", 100)
-                    png_data = optimize_for_widget(source_path, w, h)
-                    images[filename] = png_data
-                    widget["icon_path"] = f"/icons/{filename}"
-                except Exception as e:
-                    logger.warning("Failed to optimize icon %s: %s", source_path, e)
-                    widget.pop("icon_path", None)
+                # Rendered at full widget size
+                add_icon_job(widget, widget.get("width", 180), widget.get("height", 100))
 
     # Resolve page background images (separate dict — uploaded to /bkgnds/)
     bg_images = {}
@@ -95,21 +113,24 @@ def _resolve_deploy_images(config):
                 continue
             base = os.path.splitext(os.path.basename(bg_src))[0]
             safe_name = "".join(c if c.isalnum() or c in "-_" else "_" for c in base)
-            filename = f"bg_{safe_name}.sjpg"
-            try:
-                from companion.image_optimizer import optimize_for_sjpg
-                sjpg_data = optimize_for_sjpg(bg_src)
-                bg_images[filename] = sjpg_data
-                page["bg_image"] = f"/bkgnds/{filename}"
-            except Exception as e:
-                logger.warning("Failed to optimize bg image %s: %s", bg_src, e)
-                page.pop("bg_image", None)
+            filename = f"bg_{safe_name}.{output_format('picture', profile)}"
+            jobs.append((ImageJob("picture", bg_src), page, "bg_image", "bkgnds", filename))
+
+    results = optimize_batch([job for job, *_ in jobs], profile)
+    for (job, owner, key, folder, filename), data in zip(jobs, results):
+        if isinstance(data, Exception):
+            logger.warning("Failed to optimize %s: %s", job.path, data)
+            owner.pop(key, None)
+            continue
+        (images if folder == "icons" else bg_images)[filename] = data
+        owner[key] = f"/{folder}/{filename}"
 
     return images, bg_images, deploy_config
 
 # Deploy step definitions: (key, label)
 DEPLOY_STEPS = [
     ("bridge", "Open bridge USB connection"),
+    ("usb_push", "Push files over USB"),
     ("config_mode", "Signal display to enter config mode"),
     ("ap_wait", "Wait for AP startup"),
     ("wifi_connect", "Connect WiFi to CrowPanel-Config"),
@@ -134,9 +155,11 @@ class DeployWorker(QThread):
         super().__init__()
         # Resolve icons and bg images at deploy time from system sources
         images, bg_images, deploy_config = _resolve_deploy_images(config_manager.config)
-        self.json_str = json.dumps(deploy_config, indent=2)
-        self.pending_images = images      # {filename: png_bytes} → /icons/
-        self.pending_bg_images = bg_images  # {filename: png_bytes} → /bkgnds/
+        # Repeated widget fields go out once per profile as "templates"
+        self.json_str = json.dumps(compact_templates(deploy_config), separators=(",", ":"))
+        self.pending_images = images      # {filename: bytes} → /icons/
+        self.pending_bg_images = bg_images  # {filename: bytes} → /bkgnds/
+        self._config_manager = config_manager
         self._bridge = None
         self._wifi = None
 
@@ -151,6 +174,22 @@ class DeployWorker(QThread):
             self._bridge.open()
             self.step_done.emit("bridge")
 
+            # Fast path: bulk transfer over the bridge, no SoftAP round trip
+            self.step_started.emit("usb_push")
+            try:
+                image_warnings = self._deploy_usb()
+            except BulkTransferError as e:
+                if not e.no_response:
+                    raise
+                logger.info("Display has no bulk channel, falling back to WiFi deploy")
+            else:
+                self.step_done.emit("usb_push")
+                self._bridge.close()
+                self.deploy_success.emit()
+                if image_warnings:
+                    self.deploy_warning.emit("Some icons failed to upload:\n" + "\n".join(image_warnings))
+                return
+
             # 2. Send CONFIG_MODE
             self.step_started.emit("config_mode")
             self._bridge.send_config_mode()
@@ -171,27 +210,26 @@ class DeployWorker(QThread):
             client = HTTPClient()
             if not client.wait_for_device(timeout=10, interval=1):
                 raise HTTPClientError("Device not responding after WiFi connect")
+            # This display's own layout budgets: a page that can't fit is refused here,
+            # not truncated on the device
+            budget = budget_from_device(client.layout_budget())
+            if budget:
+                self._config_manager.device_budget = budget
+                valid, error = self._config_manager.validate(budget)
+                if not valid:
+                    raise HTTPClientError(f"Config does not fit this display: {error}")
             self.step_done.emit("health")
 
             # 6. Upload images (non-fatal: warn but continue if upload fails)
             self.step_started.emit("images")
             image_warnings = []
-            if self.pending_images:
-                for filename, data in self.pending_images.items():
-                    try:
-                        result = client.upload_image(filename, data)
-                        if not result.get("success"):
-                            image_warnings.append(f"{filename}: {result.get('error', 'unknown')}")
-                    except Exception as e:
-                        image_warnings.append(f"{filename}: {e}")
-            if self.pending_bg_images:
-                for filename, data in self.pending_bg_images.items():
-                    try:
-                        result = client.sd_upload_image(filename, data, folder="bkgnds")
-                        if not result.get("success"):
-                            image_warnings.append(f"bg/{filename}: {result.get('error', 'unknown')}")
-                    except Exception as e:
-                        image_warnings.append(f"bg/{filename}: {e}")
+            # Only assets whose size/CRC differ from the SD card are sent
+            for folder, images, prefix in (("icons", self.pending_images, ""),
+                                           ("bkgnds", self.pending_bg_images, "bg/")):
+                try:
+                    image_warnings += [prefix + w for w in client.sync_folder(folder, images)]
+                except Exception as e:
+                    image_warnings.append(f"{prefix or 'icons/'}*: {e}")
             self.step_done.emit("images")
 
             # 7. Upload config
@@ -225,6 +263,26 @@ class DeployWorker(QThread):
             self._cleanup()
             self.deploy_failed.emit(f"Unexpected error: {e}")
 
+    def _deploy_usb(self):
+        """Push images and config as bulk transfers. Returns image warnings.
+
+        Raises BulkTransferError(no_response=True) if the display doesn't
+        speak the bulk protocol; the config is sent last so the display
+        rebuilds once with every image already in place.
+        """
+        image_warnings = []
+        uploads = [(f"/icons/{name}", data) for name, data in self.pending_images.items()]
+        uploads += [(f"/bkgnds/{name}", data) for name, data in self.pending_bg_images.items()]
+        for remote_path, data in uploads:
+            try:
+                self._bridge.send_file(remote_path, data)
+            except BulkTransferError as e:
+                if e.no_response:
+                    raise
+                image_warnings.append(str(e))
+        self._bridge.send_file("/config.json", self.json_str.encode("utf-8"))
+        return image_warnings
+
     def _cleanup(self):
         """Best-effort cleanup: send CONFIG_DONE and restore WiFi."""
         try:
@@ -299,7 +357,8 @@ class DeployDialog(QDialog):
         header.setStyleSheet("font-size: 16px; font-weight: bold; color: #3498DB;")
         layout.addWidget(header)
 
-        desc = QLabel("Deploys config via USB bridge + WiFi auto-connect.")
+        desc = QLabel("Deploys config over the USB bridge "
+                      "(WiFi auto-connect for older display firmware).")
         desc.setStyleSheet("color: #999999; margin-bottom: 8px;")
         desc.setWordWrap(True)
         layout.addWidget(desc)
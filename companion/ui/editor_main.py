@@ -21,6 +21,7 @@ from PySide6.QtWidgets import (
     QGroupBox,
     QComboBox,
     QSpinBox,
+    QDoubleSpinBox,
     QCheckBox,
     QTableWidget,
     QTableWidgetItem,
@@ -31,6 +32,7 @@ from PySide6.QtWidgets import (
     QListWidget,
     QListWidgetItem,
     QLineEdit,
+    QPlainTextEdit,
     QGraphicsScene,
     QGraphicsView,
     QGraphicsRectItem,
@@ -60,6 +62,27 @@ from companion.config_manager import (
     WIDGET_TEXT_LABEL,
     WIDGET_SEPARATOR,
     WIDGET_PAGE_NAV,
+    WIDGET_STAT_GRAPH,
+    WIDGET_TRACKPAD,
+    WIDGET_REMOTE_IMAGE,
+    WIDGET_SCROLL_GRID,
+    GRID_ENTRIES_MAX,
+    GRID_COLUMNS_MAX,
+    GRID_ROW_HEIGHT_MIN,
+    GRID_ROW_HEIGHT_MAX,
+    GRID_ROW_HEIGHT_DEFAULT,
+    ACTION_LAUNCH_APP,
+    REMOTE_IMAGE_SOURCE_MAX,
+    REMOTE_HOST_MAX,
+    REMOTE_IMAGE_DEFAULT_SOURCE,
+    TRACKPAD_SPEED_MIN,
+    rules_to_text,
+    text_to_rules,
+    TRACKPAD_SPEED_MAX,
+    TRACKPAD_SPEED_DEFAULT,
+    GRAPH_POINTS_MIN,
+    GRAPH_POINTS_MAX,
+    GRAPH_POINTS_DEFAULT,
     WIDGET_TYPE_NAMES,
     WIDGET_DEFAULT_SIZES,
     WIDGET_TYPE_MAX,
@@ -81,6 +104,11 @@ from companion.config_manager import (
     ACTION_FOCUS_NEXT,
     ACTION_FOCUS_PREV,
     ACTION_FOCUS_ACTIVATE,
+    ACTION_MACRO,
+    ACTION_PROFILE_GOTO,
+    ACTION_TYPE_TEXT,
+    TYPE_TEXT_MAX_BYTES,
+    KEY_LAYOUTS,
     ACTION_TYPE_NAMES,
     ENCODER_MODE_NAMES,
     DDC_VCP_NAMES,
@@ -105,8 +133,10 @@ from companion.config_manager import (
 )
 from companion.ui.icon_picker import IconPicker
 from companion.ui.keyboard_recorder import KeyboardRecorder
+from companion.keycode_map import macro_to_text, text_to_macro
 from companion.ui.deploy_dialog import DeployDialog
 from companion.ui.slideshow_upload_dialog import SlideshowUploadDialog
+from companion.live_edit_client import LiveEditClient, widget_path
 from companion.ui.no_scroll_combo import NoScrollComboBox
 from companion.lvgl_symbols import SYMBOL_BY_UTF8
 import os
@@ -279,6 +309,10 @@ WIDGET_PALETTE_ICONS = {
     WIDGET_TEXT_LABEL: "\u0054",     # T
     WIDGET_SEPARATOR: "\u2500",      # line
     WIDGET_PAGE_NAV: "\u2022\u2022\u2022",  # dots
+    WIDGET_STAT_GRAPH: "\u223F",     # wave
+    WIDGET_TRACKPAD: "\u25AD",       # rectangle
+    WIDGET_REMOTE_IMAGE: "\u25A3",   # framed square
+    WIDGET_SCROLL_GRID: "\u229E",    # squared plus (grid)
 }
 
 
@@ -344,20 +378,14 @@ def _get_kde_favorites():
         return []
 
 
-_APP_CACHE = None  # Cache scanned apps for reuse
-
-
 def _get_all_apps():
-    """Get all installed apps, using cache if available."""
-    global _APP_CACHE
-    if _APP_CACHE is None:
-        try:
-            from companion.app_scanner import scan_applications
-            _APP_CACHE = scan_applications()
-        except Exception as e:
-            logger.warning("Failed to scan applications: %s", e)
-            _APP_CACHE = []
-    return _APP_CACHE
+    """Get all installed apps (from the incremental app index, cheap to call)."""
+    try:
+        from companion.app_scanner import scan_applications
+        return scan_applications()
+    except Exception as e:
+        logger.warning("Failed to scan applications: %s", e)
+        return []
 
 
 def _resolve_app_from_desktop(desktop_file):
@@ -1187,7 +1215,7 @@ class CanvasWidgetItem(QGraphicsRectItem):
             bg = _int_to_qcolor(bg_color) if bg_color else QColor("#16213e")
             self.setBrush(QBrush(bg))
             self.setPen(QPen(bg.lighter(130), 1))
-        elif wtype == WIDGET_STAT_MONITOR:
+        elif wtype in (WIDGET_STAT_MONITOR, WIDGET_STAT_GRAPH):
             self.setBrush(QBrush(QColor("#1a1f2e")))
             self.setPen(QPen(qcolor, 2))
         elif wtype == WIDGET_CLOCK:
@@ -1202,6 +1230,18 @@ class CanvasWidgetItem(QGraphicsRectItem):
         elif wtype == WIDGET_PAGE_NAV:
             self.setBrush(QBrush(QColor(0, 0, 0, 40)))
             self.setPen(QPen(QColor("#555"), 1, Qt.DashLine))
+        elif wtype == WIDGET_TRACKPAD:
+            bg = _int_to_qcolor(bg_color) if bg_color else QColor("#0d1b2a")
+            self.setBrush(QBrush(bg))
+            self.setPen(QPen(qcolor.darker(200), 1))
+        elif wtype == WIDGET_REMOTE_IMAGE:
+            bg = _int_to_qcolor(bg_color) if bg_color else QColor("#111")
+            self.setBrush(QBrush(bg))
+            self.setPen(QPen(QColor("#555"), 1, Qt.DashLine))
+        elif wtype == WIDGET_SCROLL_GRID:
+            bg = _int_to_qcolor(bg_color) if bg_color else QColor(0, 0, 0, 40)
+            self.setBrush(QBrush(bg))
+            self.setPen(QPen(QColor("#555"), 1, Qt.DashLine))
         else:
             self.setBrush(QBrush(QColor("#333")))
             self.setPen(QPen(QColor("#666"), 1))
@@ -1229,6 +1269,14 @@ class CanvasWidgetItem(QGraphicsRectItem):
             self._paint_separator(painter, rect, qcolor)
         elif wtype == WIDGET_PAGE_NAV:
             self._paint_page_nav(painter, rect, qcolor)
+        elif wtype == WIDGET_STAT_GRAPH:
+            self._paint_stat_graph(painter, rect, qcolor)
+        elif wtype == WIDGET_TRACKPAD:
+            self._paint_trackpad(painter, rect, qcolor)
+        elif wtype == WIDGET_REMOTE_IMAGE:
+            self._paint_remote_image(painter, rect, qcolor)
+        elif wtype == WIDGET_SCROLL_GRID:
+            self._paint_scroll_grid(painter, rect, qcolor)
 
         # Selection highlight
         if self.isSelected():
@@ -1355,6 +1403,24 @@ class CanvasWidgetItem(QGraphicsRectItem):
                 painter.setFont(QFont("Arial", 11, QFont.Bold))
                 painter.drawText(rect.adjusted(4, half, -4, -2), Qt.AlignCenter, value)
 
+    def _paint_stat_graph(self, painter, rect, qcolor):
+        stat_type = self.widget_dict.get("stat_type", 0x01)
+        chart = rect.adjusted(4, 4, -4, -4)
+        if self.widget_dict.get("show_label", True):
+            painter.setPen(qcolor)
+            painter.setFont(QFont("Arial", 8))
+            painter.drawText(chart, Qt.AlignLeft | Qt.AlignTop,
+                             STAT_PLACEHOLDERS.get(stat_type, "--"))
+            chart = chart.adjusted(0, 16, 0, 0)
+        # Placeholder sparkline
+        painter.setPen(QPen(qcolor, 2))
+        shape = (0.55, 0.6, 0.45, 0.5, 0.3, 0.4, 0.25, 0.35, 0.2, 0.45, 0.4, 0.3)
+        step = chart.width() / (len(shape) - 1)
+        for i in range(len(shape) - 1):
+            painter.drawLine(QPointF(chart.left() + i * step, chart.top() + shape[i] * chart.height()),
+                             QPointF(chart.left() + (i + 1) * step,
+                                     chart.top() + shape[i + 1] * chart.height()))
+
     def _paint_status_bar(self, painter, rect, qcolor):
         from datetime import datetime
         painter.setPen(qcolor)
@@ -1421,6 +1487,43 @@ class CanvasWidgetItem(QGraphicsRectItem):
             cy = rect.center().y()
             painter.drawLine(int(rect.left() + 2), int(cy), int(rect.right() - 2), int(cy))
 
+    def _paint_trackpad(self, painter, rect, qcolor):
+        painter.setPen(qcolor.darker(150))
+        painter.setFont(QFont("Arial", 9))
+        label = self.widget_dict.get("label", "") if self.widget_dict.get("show_label", True) else ""
+        mode = "Absolute" if self.widget_dict.get("trackpad_absolute", False) else "Mouse"
+        painter.drawText(rect, Qt.AlignCenter, f"{label}\n({mode})" if label else f"({mode})")
+
+    def _paint_remote_image(self, painter, rect, qcolor):
+        painter.setPen(QColor("#888"))
+        painter.setFont(QFont("Arial", 9))
+        source = self.widget_dict.get("image_source", "")
+        painter.drawText(rect, Qt.AlignCenter | Qt.TextWordWrap, f"\u25A3\n{source}")
+
+    def _paint_scroll_grid(self, painter, rect, qcolor):
+        # The cells of the first screenful, labelled like the display shows them
+        cols = max(1, self.widget_dict.get("grid_columns", 1))
+        row_h = self.widget_dict.get("grid_row_height", GRID_ROW_HEIGHT_DEFAULT)
+        entries = self.widget_dict.get("entries", [])
+        gap = 6
+        cell_w = (rect.width() - gap * (cols + 1)) / cols
+        painter.setFont(QFont("Arial", 9))
+        for i, entry in enumerate(entries):
+            row, col = divmod(i, cols)
+            y = rect.top() + row * row_h + gap / 2
+            if y + row_h - gap > rect.bottom():
+                break
+            cell = QRectF(rect.left() + gap + col * (cell_w + gap), y, cell_w, row_h - gap)
+            painter.setPen(QPen(QColor("#444"), 1))
+            painter.setBrush(Qt.NoBrush)
+            painter.drawRoundedRect(cell, 6, 6)
+            painter.setPen(qcolor)
+            align = Qt.AlignVCenter | Qt.AlignLeft if cols == 1 else Qt.AlignBottom | Qt.AlignHCenter
+            painter.drawText(cell.adjusted(6, 4, -6, -4), align, entry.get("label", ""))
+        painter.setPen(QColor("#888"))
+        painter.drawText(rect.adjusted(4, 4, -4, -4), Qt.AlignRight | Qt.AlignBottom,
+                         f"{len(entries)} entries")
+
     def _paint_page_nav(self, painter, rect, qcolor):
         painter.setPen(Qt.NoPen)
         dot_r = 4
@@ -2067,6 +2170,49 @@ class PropertiesPanel(QScrollArea):
         self.media_key_combo.setVisible(False)
         hotkey_layout.addWidget(self.media_key_combo)
 
+        # Macro section (ACTION_MACRO): one step per line, played back by the bridge
+        self.macro_label = QLabel("Macro Steps:")
+        self.macro_label.setVisible(False)
+        hotkey_layout.addWidget(self.macro_label)
+        self.macro_input = QPlainTextEdit()
+        self.macro_input.setPlaceholderText(
+            "ctrl+shift+t\ndelay 50\ntext Hello\nmedia 0xCD\npress shift / release shift"
+        )
+        self.macro_input.setFixedHeight(110)
+        self.macro_input.setVisible(False)
+        self.macro_input.textChanged.connect(self._on_property_changed)
+        hotkey_layout.addWidget(self.macro_input)
+        self.macro_error_label = QLabel("")
+        self.macro_error_label.setStyleSheet("color: #E74C3C; font-size: 11px;")
+        self.macro_error_label.setWordWrap(True)
+        self.macro_error_label.setVisible(False)
+        hotkey_layout.addWidget(self.macro_error_label)
+
+        # Type text section (ACTION_TYPE_TEXT): typed by the bridge in the host's layout
+        self.type_text_label = QLabel("Text:")
+        self.type_text_label.setVisible(False)
+        hotkey_layout.addWidget(self.type_text_label)
+        self.type_text_input = QPlainTextEdit()
+        self.type_text_input.setPlaceholderText("Mit freundlichen Grüßen\nJane")
+        self.type_text_input.setFixedHeight(80)
+        self.type_text_input.setVisible(False)
+        self.type_text_input.textChanged.connect(self._on_property_changed)
+        hotkey_layout.addWidget(self.type_text_input)
+        self.key_layout_label = QLabel("Host Keyboard Layout:")
+        self.key_layout_label.setVisible(False)
+        hotkey_layout.addWidget(self.key_layout_label)
+        self.key_layout_combo = NoScrollComboBox()
+        for name, code in (("US (QWERTY)", "us"), ("UK (QWERTY)", "uk"),
+                           ("German (QWERTZ)", "de"), ("French (AZERTY)", "fr")):
+            self.key_layout_combo.addItem(name, code)
+        self.key_layout_combo.currentIndexChanged.connect(self._on_property_changed)
+        self.key_layout_combo.setVisible(False)
+        hotkey_layout.addWidget(self.key_layout_combo)
+        self.type_text_error_label = QLabel("")
+        self.type_text_error_label.setStyleSheet("color: #E74C3C; font-size: 11px;")
+        self.type_text_error_label.setVisible(False)
+        hotkey_layout.addWidget(self.type_text_error_label)
+
         # Launch App section
         self.launch_app_label = QLabel("Application:")
         self.launch_app_label.setVisible(False)
@@ -2201,6 +2347,14 @@ class PropertiesPanel(QScrollArea):
         pressed_row.addStretch()
         hotkey_layout.addLayout(pressed_row)
 
+        self.fire_on_press_check = QCheckBox("Fire on press")
+        self.fire_on_press_check.setToolTip(
+            "Send the action as soon as the button is touched instead of on release.\n"
+            "Lowest latency; a swipe that starts on the button still fires it."
+        )
+        self.fire_on_press_check.stateChanged.connect(self._on_property_changed)
+        hotkey_layout.addWidget(self.fire_on_press_check)
+
         self.hotkey_group.setLayout(hotkey_layout)
         self.main_layout.addWidget(self.hotkey_group)
 
@@ -2213,7 +2367,9 @@ class PropertiesPanel(QScrollArea):
             self.stat_type_combo.addItem(name, tid)
         self.stat_type_combo.currentIndexChanged.connect(self._on_stat_type_changed)
         stat_layout.addWidget(self.stat_type_combo)
-        vpos_row = QHBoxLayout()
+        self.vpos_row_widget = QWidget()
+        vpos_row = QHBoxLayout(self.vpos_row_widget)
+        vpos_row.setContentsMargins(0, 0, 0, 0)
         vpos_row.addWidget(QLabel("Value Position:"))
         self.value_position_combo = NoScrollComboBox()
         self.value_position_combo.addItem("Inline", 0)
@@ -2221,7 +2377,55 @@ class PropertiesPanel(QScrollArea):
         self.value_position_combo.addItem("Value Bottom", 2)
         self.value_position_combo.currentIndexChanged.connect(self._on_property_changed)
         vpos_row.addWidget(self.value_position_combo)
-        stat_layout.addLayout(vpos_row)
+        stat_layout.addWidget(self.vpos_row_widget)
+        # Remote collector (config.json "remote_hosts" id), monitors only
+        self.remote_host_row_widget = QWidget()
+        remote_row = QHBoxLayout(self.remote_host_row_widget)
+        remote_row.setContentsMargins(0, 0, 0, 0)
+        remote_row.addWidget(QLabel("Host:"))
+        self.remote_host_spin = QSpinBox()
+        self.remote_host_spin.setRange(0, REMOTE_HOST_MAX)
+        self.remote_host_spin.setSpecialValueText("This PC")
+        self.remote_host_spin.setPrefix("remote ")
+        self.remote_host_spin.setToolTip("Id of a remote_hosts entry in config.json")
+        self.remote_host_spin.setFocusPolicy(Qt.StrongFocus)
+        self.remote_host_spin.valueChanged.connect(self._on_property_changed)
+        remote_row.addWidget(self.remote_host_spin)
+        stat_layout.addWidget(self.remote_host_row_widget)
+        # Stat Graph options (history length + Y axis)
+        self.graph_options_widget = QWidget()
+        graph_layout = QVBoxLayout(self.graph_options_widget)
+        graph_layout.setContentsMargins(0, 0, 0, 0)
+        points_row = QHBoxLayout()
+        points_row.addWidget(QLabel("History (samples, 1/s):"))
+        self.graph_points_spin = QSpinBox()
+        self.graph_points_spin.setRange(GRAPH_POINTS_MIN, GRAPH_POINTS_MAX)
+        self.graph_points_spin.setValue(GRAPH_POINTS_DEFAULT)
+        self.graph_points_spin.setFocusPolicy(Qt.StrongFocus)
+        self.graph_points_spin.valueChanged.connect(self._on_property_changed)
+        points_row.addWidget(self.graph_points_spin)
+        graph_layout.addLayout(points_row)
+        max_row = QHBoxLayout()
+        max_row.addWidget(QLabel("Y Max (0 = auto):"))
+        self.graph_max_spin = QSpinBox()
+        self.graph_max_spin.setRange(0, 0xFFFF)
+        self.graph_max_spin.setFocusPolicy(Qt.StrongFocus)
+        self.graph_max_spin.valueChanged.connect(self._on_property_changed)
+        max_row.addWidget(self.graph_max_spin)
+        graph_layout.addLayout(max_row)
+        stat_layout.addWidget(self.graph_options_widget)
+        # Alert rules, checked on the display as values arrive
+        stat_layout.addWidget(QLabel("Alert Rules:"))
+        self.rules_input = QPlainTextEdit()
+        self.rules_input.setPlaceholderText("above 70 #F1C40F\nabove 85 #E74C3C hyst 3 blink toast\nbelow 20 #E74C3C")
+        self.rules_input.setFixedHeight(70)
+        self.rules_input.textChanged.connect(self._on_property_changed)
+        stat_layout.addWidget(self.rules_input)
+        self.rules_error_label = QLabel("")
+        self.rules_error_label.setStyleSheet("color: #E74C3C; font-size: 11px;")
+        self.rules_error_label.setWordWrap(True)
+        self.rules_error_label.setVisible(False)
+        stat_layout.addWidget(self.rules_error_label)
         self.stat_group.setLayout(stat_layout)
         self.main_layout.addWidget(self.stat_group)
 
@@ -2271,6 +2475,10 @@ class PropertiesPanel(QScrollArea):
         self.font_size_combo = NoScrollComboBox()
         for size in [12, 14, 16, 20, 22, 28, 40]:
             self.font_size_combo.addItem(str(size), size)
+        # Loaded from /fonts/<size>.bin on the SD card (tools/font_subset.py --bin),
+        # else shown at the nearest smaller built-in size
+        for size in [48, 64, 96]:
+            self.font_size_combo.addItem("%d (SD font)" % size, size)
         self.font_size_combo.currentIndexChanged.connect(self._on_property_changed)
         text_layout.addWidget(self.font_size_combo)
         text_layout.addWidget(QLabel("Alignment:"))
@@ -2299,6 +2507,75 @@ class PropertiesPanel(QScrollArea):
         self.separator_group.setLayout(sep_layout)
         self.main_layout.addWidget(self.separator_group)
 
+        # Trackpad group
+        self.trackpad_group = QGroupBox("Trackpad")
+        pad_layout = QVBoxLayout()
+        pad_layout.addWidget(QLabel("Mode:"))
+        self.trackpad_mode_combo = NoScrollComboBox()
+        self.trackpad_mode_combo.addItem("Mouse (relative, tap to click)", False)
+        self.trackpad_mode_combo.addItem("Absolute (maps to the whole screen)", True)
+        self.trackpad_mode_combo.currentIndexChanged.connect(self._on_property_changed)
+        pad_layout.addWidget(self.trackpad_mode_combo)
+        pad_layout.addWidget(QLabel("Pointer speed:"))
+        self.trackpad_speed_spin = QDoubleSpinBox()
+        self.trackpad_speed_spin.setRange(TRACKPAD_SPEED_MIN / 10, TRACKPAD_SPEED_MAX / 10)
+        self.trackpad_speed_spin.setSingleStep(0.1)
+        self.trackpad_speed_spin.setDecimals(1)
+        self.trackpad_speed_spin.setSuffix("x")
+        self.trackpad_speed_spin.setValue(TRACKPAD_SPEED_DEFAULT / 10)
+        self.trackpad_speed_spin.setFocusPolicy(Qt.StrongFocus)
+        self.trackpad_speed_spin.valueChanged.connect(self._on_property_changed)
+        pad_layout.addWidget(self.trackpad_speed_spin)
+        self.trackpad_group.setLayout(pad_layout)
+        self.main_layout.addWidget(self.trackpad_group)
+
+        # Remote image group
+        self.remote_image_group = QGroupBox("Remote Image")
+        img_layout = QVBoxLayout()
+        img_layout.addWidget(QLabel("Source:"))
+        self.image_source_combo = NoScrollComboBox()
+        self.image_source_combo.setEditable(True)
+        self.image_source_combo.addItem("now_playing")
+        self.image_source_combo.addItem("file:~/.cache/crowdisplay/graph.png")
+        self.image_source_combo.lineEdit().setMaxLength(REMOTE_IMAGE_SOURCE_MAX)
+        self.image_source_combo.currentTextChanged.connect(self._on_property_changed)
+        img_layout.addWidget(self.image_source_combo)
+        hint = QLabel("now_playing: album art of the active media player.\n"
+                      "file:<path>: an image file, re-sent when it changes.")
+        hint.setStyleSheet("color: #888; font-size: 11px;")
+        img_layout.addWidget(hint)
+        self.remote_image_group.setLayout(img_layout)
+        self.main_layout.addWidget(self.remote_image_group)
+
+        # Scroll grid group
+        self.scroll_grid_group = QGroupBox("Scroll Grid")
+        grid_layout = QVBoxLayout()
+        grid_layout.addWidget(QLabel("Columns (1 = list):"))
+        self.grid_columns_spin = QSpinBox()
+        self.grid_columns_spin.setRange(1, GRID_COLUMNS_MAX)
+        self.grid_columns_spin.setFocusPolicy(Qt.StrongFocus)
+        self.grid_columns_spin.valueChanged.connect(self._on_property_changed)
+        grid_layout.addWidget(self.grid_columns_spin)
+        grid_layout.addWidget(QLabel("Row height:"))
+        self.grid_row_height_spin = QSpinBox()
+        self.grid_row_height_spin.setRange(GRID_ROW_HEIGHT_MIN, GRID_ROW_HEIGHT_MAX)
+        self.grid_row_height_spin.setSuffix(" px")
+        self.grid_row_height_spin.setFocusPolicy(Qt.StrongFocus)
+        self.grid_row_height_spin.valueChanged.connect(self._on_property_changed)
+        grid_layout.addWidget(self.grid_row_height_spin)
+        self.grid_entries_label = QLabel()
+        grid_layout.addWidget(self.grid_entries_label)
+        grid_btn_row = QHBoxLayout()
+        self.grid_fill_btn = QPushButton("Fill from Installed Apps")
+        self.grid_fill_btn.clicked.connect(self._on_grid_fill_apps)
+        grid_btn_row.addWidget(self.grid_fill_btn)
+        self.grid_clear_btn = QPushButton("Clear")
+        self.grid_clear_btn.clicked.connect(self._on_grid_clear)
+        grid_btn_row.addWidget(self.grid_clear_btn)
+        grid_layout.addLayout(grid_btn_row)
+        self.scroll_grid_group.setLayout(grid_layout)
+        self.main_layout.addWidget(self.scroll_grid_group)
+
         # Hardware Input group (for encoder rotation mode)
         self.hw_encoder_group = QGroupBox("Encoder Rotation")
         enc_layout = QVBoxLayout()
@@ -2355,6 +2632,8 @@ class PropertiesPanel(QScrollArea):
         hw_action_layout.addWidget(QLabel("Action Type:"))
         self.hw_action_type_combo = NoScrollComboBox()
         for action_id, action_name in ACTION_TYPE_NAMES.items():
+            if action_id in (ACTION_MACRO, ACTION_TYPE_TEXT):
+                continue  # Hardware buttons don't carry macro steps or text
             self.hw_action_type_combo.addItem(action_name, action_id)
         self.hw_action_type_combo.currentIndexChanged.connect(self._on_hw_action_type_changed)
         hw_action_layout.addWidget(self.hw_action_type_combo)
@@ -2443,6 +2722,9 @@ class PropertiesPanel(QScrollArea):
         self.clock_group.setVisible(False)
         self.text_group.setVisible(False)
         self.separator_group.setVisible(False)
+        self.trackpad_group.setVisible(False)
+        self.remote_image_group.setVisible(False)
+        self.scroll_grid_group.setVisible(False)
         self.hw_encoder_group.setVisible(False)
         self.hw_action_group.setVisible(False)
 
@@ -2530,6 +2812,12 @@ class PropertiesPanel(QScrollArea):
                 widget_dict.get("modifiers", 0), widget_dict.get("keycode", 0)
             )
             self._set_media_key_combo(widget_dict.get("consumer_code", 0))
+            if action_type in (ACTION_PAGE_GOTO, ACTION_PROFILE_GOTO):
+                self.page_goto_spin.setValue(widget_dict.get("keycode", 0) + 1)
+            self.macro_input.setPlainText(macro_to_text(widget_dict.get("macro", [])))
+            self.type_text_input.setPlainText(widget_dict.get("text", ""))
+            layout_idx = self.key_layout_combo.findData(str(widget_dict.get("key_layout", "us")).lower())
+            self.key_layout_combo.setCurrentIndex(max(layout_idx, 0))
 
             # Load launch app fields
             launch_cmd = widget_dict.get("launch_command", "")
@@ -2565,9 +2853,15 @@ class PropertiesPanel(QScrollArea):
             self.pressed_color_btn.setVisible(pressed != 0)
             if pressed != 0:
                 self._set_color_btn(self.pressed_color_btn, pressed)
+            self.fire_on_press_check.setChecked(widget_dict.get("fire_on_press", False))
 
-        elif wtype == WIDGET_STAT_MONITOR:
+        elif wtype in (WIDGET_STAT_MONITOR, WIDGET_STAT_GRAPH):
+            is_graph = (wtype == WIDGET_STAT_GRAPH)
+            self.stat_group.setTitle("Stat Graph" if is_graph else "Stat Monitor")
             self.stat_group.setVisible(True)
+            self.vpos_row_widget.setVisible(not is_graph)
+            self.remote_host_row_widget.setVisible(not is_graph)
+            self.graph_options_widget.setVisible(is_graph)
             st = widget_dict.get("stat_type", 0x01)
             for i in range(self.stat_type_combo.count()):
                 if self.stat_type_combo.itemData(i) == st:
@@ -2575,6 +2869,11 @@ class PropertiesPanel(QScrollArea):
                     break
             vp = widget_dict.get("value_position", 0)
             self.value_position_combo.setCurrentIndex(min(vp, 2))
+            self.remote_host_spin.setValue(widget_dict.get("remote_host", 0))
+            self.graph_points_spin.setValue(widget_dict.get("graph_points", GRAPH_POINTS_DEFAULT))
+            self.graph_max_spin.setValue(widget_dict.get("graph_max", 0))
+            self.rules_input.setPlainText(rules_to_text(widget_dict.get("rules", [])))
+            self.rules_error_label.setVisible(False)
 
         elif wtype == WIDGET_STATUS_BAR:
             self.status_bar_group.setVisible(True)
@@ -2604,6 +2903,22 @@ class PropertiesPanel(QScrollArea):
             self.sep_vertical_check.setChecked(widget_dict.get("separator_vertical", False))
             self.thickness_spin.setValue(widget_dict.get("thickness", 2))
 
+        elif wtype == WIDGET_TRACKPAD:
+            self.trackpad_group.setVisible(True)
+            self.trackpad_mode_combo.setCurrentIndex(1 if widget_dict.get("trackpad_absolute", False) else 0)
+            self.trackpad_speed_spin.setValue(widget_dict.get("trackpad_speed", TRACKPAD_SPEED_DEFAULT) / 10)
+            self.trackpad_speed_spin.setEnabled(not widget_dict.get("trackpad_absolute", False))
+
+        elif wtype == WIDGET_REMOTE_IMAGE:
+            self.remote_image_group.setVisible(True)
+            self.image_source_combo.setCurrentText(widget_dict.get("image_source", REMOTE_IMAGE_DEFAULT_SOURCE))
+
+        elif wtype == WIDGET_SCROLL_GRID:
+            self.scroll_grid_group.setVisible(True)
+            self.grid_columns_spin.setValue(widget_dict.get("grid_columns", 1))
+            self.grid_row_height_spin.setValue(widget_dict.get("grid_row_height", GRID_ROW_HEIGHT_DEFAULT))
+            self.grid_entries_label.setText(f"{len(widget_dict.get('entries', []))} entries")
+
         self._hw_mode = False
         self._updating = False
 
@@ -2699,7 +3014,9 @@ class PropertiesPanel(QScrollArea):
 
     def _update_hw_action_visibility(self, action_type):
         """Show/hide hardware action fields based on action type."""
-        is_goto = (action_type == ACTION_PAGE_GOTO)
+        is_goto = action_type in (ACTION_PAGE_GOTO, ACTION_PROFILE_GOTO)
+        self.hw_page_goto_label.setText(
+            "Target Profile:" if action_type == ACTION_PROFILE_GOTO else "Target Page:")
         self.hw_page_goto_label.setVisible(is_goto)
         self.hw_page_goto_spin.setVisible(is_goto)
 
@@ -2760,7 +3077,7 @@ class PropertiesPanel(QScrollArea):
                 btn = buttons[self._hw_index]
                 btn["action_type"] = self.hw_action_type_combo.currentData() or ACTION_PAGE_NEXT
                 btn["label"] = self.hw_label_input.text()
-                if btn["action_type"] == ACTION_PAGE_GOTO:
+                if btn["action_type"] in (ACTION_PAGE_GOTO, ACTION_PROFILE_GOTO):
                     btn["keycode"] = self.hw_page_goto_spin.value() - 1
                 if btn["action_type"] == ACTION_DDC:
                     btn["ddc_vcp_code"] = self.hw_ddc_vcp_combo.currentData() or 0x10
@@ -2774,7 +3091,7 @@ class PropertiesPanel(QScrollArea):
             encoder["push_action"] = self.hw_action_type_combo.currentData() or ACTION_BRIGHTNESS
             encoder["push_label"] = self.hw_label_input.text()
             encoder["encoder_mode"] = self.encoder_mode_combo.currentData() or 0
-            if encoder["push_action"] == ACTION_PAGE_GOTO:
+            if encoder["push_action"] in (ACTION_PAGE_GOTO, ACTION_PROFILE_GOTO):
                 encoder["push_keycode"] = self.hw_page_goto_spin.value() - 1
             if encoder["encoder_mode"] == 5:
                 encoder["ddc_vcp_code"] = self.enc_ddc_vcp_combo.currentData() or 0x10
@@ -2835,6 +3152,32 @@ class PropertiesPanel(QScrollArea):
                 d["ddc_value"] = self.ddc_value_spin.value()
                 d["ddc_adjustment"] = self.ddc_adjustment_spin.value()
                 d["ddc_display"] = self.ddc_display_spin.value()
+            elif action_type == ACTION_MACRO:
+                d["consumer_code"] = 0
+                d["modifiers"] = 0
+                d["keycode"] = 0
+                try:
+                    d["macro"] = text_to_macro(self.macro_input.toPlainText())
+                    self.macro_error_label.setVisible(False)
+                except ValueError as exc:
+                    self.macro_error_label.setText(str(exc))
+                    self.macro_error_label.setVisible(True)
+            elif action_type == ACTION_TYPE_TEXT:
+                d["consumer_code"] = 0
+                d["modifiers"] = 0
+                d["keycode"] = 0
+                text = self.type_text_input.toPlainText()
+                size = len(text.encode("utf-8"))
+                if size > TYPE_TEXT_MAX_BYTES:
+                    self.type_text_error_label.setText(
+                        f"{size} bytes as UTF-8, the display keeps the first {TYPE_TEXT_MAX_BYTES}")
+                self.type_text_error_label.setVisible(size > TYPE_TEXT_MAX_BYTES)
+                d["text"] = text
+                d["key_layout"] = self.key_layout_combo.currentData() or KEY_LAYOUTS[0]
+            elif action_type in (ACTION_PAGE_GOTO, ACTION_PROFILE_GOTO):
+                d["consumer_code"] = 0
+                d["modifiers"] = 0
+                d["keycode"] = self.page_goto_spin.value() - 1
             else:
                 d["consumer_code"] = 0
                 d["modifiers"] = 0
@@ -2850,10 +3193,20 @@ class PropertiesPanel(QScrollArea):
             d["pressed_color"] = 0 if self.auto_darken_check.isChecked() else (
                 self.pressed_color_btn.property("color_value") or 0xFF0000
             )
+            d["fire_on_press"] = self.fire_on_press_check.isChecked()
 
         elif wtype == WIDGET_STAT_MONITOR:
             d["stat_type"] = self.stat_type_combo.currentData() or 0x01
             d["value_position"] = self.value_position_combo.currentData() or 0
+            if self.remote_host_spin.value():
+                d["remote_host"] = self.remote_host_spin.value()
+            else:
+                d.pop("remote_host", None)
+
+        elif wtype == WIDGET_STAT_GRAPH:
+            d["stat_type"] = self.stat_type_combo.currentData() or 0x01
+            d["graph_points"] = self.graph_points_spin.value()
+            d["graph_max"] = self.graph_max_spin.value()
 
         elif wtype == WIDGET_STATUS_BAR:
             d["show_wifi"] = self.show_wifi_check.isChecked()
@@ -2874,12 +3227,63 @@ class PropertiesPanel(QScrollArea):
             d["separator_vertical"] = self.sep_vertical_check.isChecked()
             d["thickness"] = self.thickness_spin.value()
 
+        elif wtype == WIDGET_TRACKPAD:
+            d["trackpad_absolute"] = bool(self.trackpad_mode_combo.currentData())
+            d["trackpad_speed"] = int(round(self.trackpad_speed_spin.value() * 10))
+            self.trackpad_speed_spin.setEnabled(not d["trackpad_absolute"])
+
+        elif wtype == WIDGET_REMOTE_IMAGE:
+            d["image_source"] = self.image_source_combo.currentText().strip()
+
+        elif wtype == WIDGET_SCROLL_GRID:
+            d["grid_columns"] = self.grid_columns_spin.value()
+            d["grid_row_height"] = self.grid_row_height_spin.value()
+
+        if wtype in (WIDGET_STAT_MONITOR, WIDGET_STAT_GRAPH):
+            try:
+                rules = text_to_rules(self.rules_input.toPlainText())
+                if rules:
+                    d["rules"] = rules
+                else:
+                    d.pop("rules", None)
+                self.rules_error_label.setVisible(False)
+            except ValueError as exc:
+                self.rules_error_label.setText(str(exc))
+                self.rules_error_label.setVisible(True)
+
         return d
 
     def _on_position_changed(self):
         if not self._updating:
             self._emit_update()
 
+    def _set_grid_entries(self, entries):
+        if self._widget_dict is None:
+            return
+        self._widget_dict["entries"] = entries
+        self.grid_entries_label.setText(f"{len(entries)} entries")
+        self._emit_update()
+
+    def _on_grid_fill_apps(self):
+        """Replace the grid's entries with every installed application, by name."""
+        entries = []
+        for app in sorted(_get_all_apps(), key=lambda a: a.name.lower())[:GRID_ENTRIES_MAX]:
+            entry = {
+                "label": app.name[:32],
+                "action_type": ACTION_LAUNCH_APP,
+                "launch_command": app.exec_cmd,
+                "launch_wm_class": app.wm_class or app.name,
+                "launch_focus_or_launch": True,
+            }
+            if app.icon_name:
+                entry["icon_source"] = app.icon_name
+                entry["icon_source_type"] = "freedesktop"
+            entries.append(entry)
+        self._set_grid_entries(entries)
+
+    def _on_grid_clear(self):
+        self._set_grid_entries([])
+
     def _on_property_changed(self, *args):
         if not self._updating:
             self._emit_update()
@@ -2916,6 +3320,22 @@ class PropertiesPanel(QScrollArea):
         self.media_key_combo.setVisible(is_media)
         self.media_key_label.setVisible(is_media)
 
+        # Macro section
+        is_macro = (action_type == ACTION_MACRO)
+        self.macro_label.setVisible(is_macro)
+        self.macro_input.setVisible(is_macro)
+        if not is_macro:
+            self.macro_error_label.setVisible(False)
+
+        # Type text section
+        is_text = (action_type == ACTION_TYPE_TEXT)
+        self.type_text_label.setVisible(is_text)
+        self.type_text_input.setVisible(is_text)
+        self.key_layout_label.setVisible(is_text)
+        self.key_layout_combo.setVisible(is_text)
+        if not is_text:
+            self.type_text_error_label.setVisible(False)
+
         # Launch app section
         is_launch = (action_type == ACTION_LAUNCH_APP)
         self.launch_app_label.setVisible(is_launch)
@@ -2942,8 +3362,10 @@ class PropertiesPanel(QScrollArea):
         self.url_label.setVisible(is_url)
         self.url_input.setVisible(is_url)
 
-        # Page goto section
-        is_goto = (action_type == ACTION_PAGE_GOTO)
+        # Page / profile goto section (same spinner, keycode is the index)
+        is_goto = action_type in (ACTION_PAGE_GOTO, ACTION_PROFILE_GOTO)
+        self.page_goto_label.setText(
+            "Target Profile:" if action_type == ACTION_PROFILE_GOTO else "Target Page:")
         self.page_goto_label.setVisible(is_goto)
         self.page_goto_spin.setVisible(is_goto)
 
@@ -3281,6 +3703,10 @@ class SettingsTab(QScrollArea):
         trans_row.addStretch()
         ss_layout.addLayout(trans_row)
 
+        self.slideshow_shuffle_check = QCheckBox("Shuffle")
+        self.slideshow_shuffle_check.toggled.connect(self._on_setting_changed)
+        ss_layout.addWidget(self.slideshow_shuffle_check)
+
         # Pictures list
         pics_label = QLabel("Pictures to upload:")
         pics_label.setStyleSheet("color: #aaa; font-size: 11px; margin-top: 6px;")
@@ -3366,6 +3792,31 @@ class SettingsTab(QScrollArea):
         self.wake_on_touch_check.stateChanged.connect(self._on_setting_changed)
         power_layout.addWidget(self.wake_on_touch_check)
 
+        # On battery: slower heartbeat/stats, no animations, lower frame rate
+        saver_row = QHBoxLayout()
+        saver_row.addWidget(QLabel("Battery Saver at (%):"))
+        self.battery_saver_spin = QSpinBox()
+        self.battery_saver_spin.setRange(0, 100)
+        self.battery_saver_spin.setValue(30)
+        self.battery_saver_spin.setFocusPolicy(Qt.StrongFocus)
+        self.battery_saver_spin.setSpecialValueText("Off")
+        self.battery_saver_spin.valueChanged.connect(self._on_setting_changed)
+        saver_row.addWidget(self.battery_saver_spin)
+        saver_row.addStretch()
+        power_layout.addLayout(saver_row)
+
+        critical_row = QHBoxLayout()
+        critical_row.addWidget(QLabel("Battery Critical at (%):"))
+        self.battery_critical_spin = QSpinBox()
+        self.battery_critical_spin.setRange(0, 100)
+        self.battery_critical_spin.setValue(15)
+        self.battery_critical_spin.setFocusPolicy(Qt.StrongFocus)
+        self.battery_critical_spin.setSpecialValueText("Off")
+        self.battery_critical_spin.valueChanged.connect(self._on_setting_changed)
+        critical_row.addWidget(self.battery_critical_spin)
+        critical_row.addStretch()
+        power_layout.addLayout(critical_row)
+
         power_group.setLayout(power_layout)
         layout.addWidget(power_group)
 
@@ -3535,10 +3986,13 @@ class SettingsTab(QScrollArea):
             if self.transition_combo.itemData(i) == transition:
                 self.transition_combo.setCurrentIndex(i)
                 break
+        self.slideshow_shuffle_check.setChecked(ds.get("slideshow_shuffle", False))
 
         self.dim_timeout_spin.setValue(ds.get("dim_timeout_sec", 60))
         self.sleep_timeout_spin.setValue(ds.get("sleep_timeout_sec", 300))
         self.wake_on_touch_check.setChecked(ds.get("wake_on_touch", True))
+        self.battery_saver_spin.setValue(ds.get("battery_saver_pct", 30))
+        self.battery_critical_spin.setValue(ds.get("battery_critical_pct", 15))
 
         # System Monitor settings (stored at config root level)
         net_iface = self.config_manager.config.get("net_interface", "") or ""
@@ -3648,9 +4102,12 @@ class SettingsTab(QScrollArea):
         ds["clock_color_theme"] = self.clock_color_btn.property("color_value") or 0xFFFFFF
         ds["slideshow_interval_sec"] = self.slideshow_interval_spin.value()
         ds["slideshow_transition"] = self.transition_combo.currentData() or "fade"
+        ds["slideshow_shuffle"] = self.slideshow_shuffle_check.isChecked()
         ds["dim_timeout_sec"] = self.dim_timeout_spin.value()
         ds["sleep_timeout_sec"] = self.sleep_timeout_spin.value()
         ds["wake_on_touch"] = self.wake_on_touch_check.isChecked()
+        ds["battery_saver_pct"] = self.battery_saver_spin.value()
+        ds["battery_critical_pct"] = self.battery_critical_spin.value()
         self.config_manager.config["mode_cycle"] = self._get_mode_order()
         # System Monitor settings (config root level)
         self.config_manager.config["net_interface"] = self.net_interface_combo.currentData() or ""
@@ -3929,6 +4386,14 @@ class EditorMainWindow(QMainWindow):
         # Canvas items tracked by stable widget_id
         self._canvas_items = {}  # widget_id -> CanvasWidgetItem
 
+        # Live edit: changes mirrored to the panel over its SoftAP (None = off)
+        self._live = None
+
+        # App index and pre-rendered app icons, warmed off the UI thread so
+        # the app pickers open instantly
+        from companion.app_scanner import start_background_index
+        start_background_index()
+
         # Central widget with splitter layout
         central_widget = QWidget()
         main_layout = QHBoxLayout(central_widget)
@@ -4063,6 +4528,9 @@ class EditorMainWindow(QMainWindow):
         self.analog_checkbox = QCheckBox("Analog clock")
         self.analog_checkbox.stateChanged.connect(self._on_display_mode_changed)
         display_layout.addWidget(self.analog_checkbox, 2, 0, 1, 2)
+        self.seconds_checkbox = QCheckBox("Second hand (analog)")
+        self.seconds_checkbox.stateChanged.connect(self._on_display_mode_changed)
+        display_layout.addWidget(self.seconds_checkbox, 3, 0, 1, 2)
         display_group.setLayout(display_layout)
         settings_layout.addWidget(display_group)
         settings_layout.addStretch()
@@ -4173,6 +4641,7 @@ class EditorMainWindow(QMainWindow):
         self.config_manager.config = self._undo_stack.pop()
         self._rebuild_canvas()
         self._save_timer.start()
+        self._live_sync_page()
         self.statusBar().showMessage("Undo")
 
     def _redo(self):
@@ -4183,6 +4652,7 @@ class EditorMainWindow(QMainWindow):
         self.config_manager.config = self._redo_stack.pop()
         self._rebuild_canvas()
         self._save_timer.start()
+        self._live_sync_page()
         self.statusBar().showMessage("Redo")
 
     def _auto_save_config(self):
@@ -4191,6 +4661,45 @@ class EditorMainWindow(QMainWindow):
         DEFAULT_CONFIG_DIR.mkdir(parents=True, exist_ok=True)
         self.config_manager.save_json_file(path)
 
+    # -- Live edit (panel in config mode, this machine on its SoftAP) --
+
+    def _on_live_edit_toggled(self, checked):
+        if not checked:
+            if self._live:
+                self._live.close()
+            self._live = None
+            self.statusBar().showMessage("Live edit off")
+            return
+        client = LiveEditClient()
+        if not client.connect():
+            self._live_action.setChecked(False)
+            QMessageBox.warning(self, "Live Edit",
+                                "The panel is not reachable. Put it in config mode and join "
+                                "the CrowPanel-Config WiFi network first.")
+            return
+        self._live = client
+        self._live_sync_page()
+        self.statusBar().showMessage(f"Live edit: connected to {client.device_ip}")
+
+    def _live_send(self, ops):
+        """Mirror an edit of the current page to the panel, if live edit is on."""
+        if not self._live:
+            return
+        profile = self.config_manager.get_active_profile() or {}
+        if not self._live.send_patch(ops, profile.get("name")):
+            self.statusBar().showMessage("Live edit: panel not reachable, retrying on the next change")
+        elif self._live.last_error:
+            self.statusBar().showMessage(f"Live edit: {self._live.last_error}")
+            self._live.last_error = ""
+
+    def _live_sync_page(self):
+        """Send the whole current page (undo/redo, paste, templates, reconnect)."""
+        page = self.config_manager.get_page(self.current_page)
+        if page is not None:
+            # Insert the new copy, then drop the old one: never an empty profile
+            self._live_send([{"op": "add", "path": f"/pages/{self.current_page}", "value": page},
+                             {"op": "remove", "path": f"/pages/{self.current_page + 1}"}])
+
     def _resolve_widget_idx(self, widget_id: str) -> int:
         """Find positional index of widget by its stable widget_id. Returns -1 if not found."""
         page = self.config_manager.get_page(self.current_page)
@@ -4235,6 +4744,10 @@ class EditorMainWindow(QMainWindow):
         upload_pictures_action = file_menu.addAction("Upload Pictures...")
         upload_pictures_action.triggered.connect(self._on_upload_pictures)
 
+        self._live_action = file_menu.addAction("Live Edit on Panel")
+        self._live_action.setCheckable(True)
+        self._live_action.toggled.connect(self._on_live_edit_toggled)
+
         file_menu.addSeparator()
 
         factory_action = file_menu.addAction("Reset to Factory Defaults")
@@ -4277,6 +4790,7 @@ class EditorMainWindow(QMainWindow):
                 self._mark_dirty()
                 self.properties_panel.clear_selection()
                 self._rebuild_canvas()
+                self._live_sync_page()
                 self.statusBar().showMessage("Template applied to current page")
         elif clicked == new_btn:
             widgets = template_fn()
@@ -4293,6 +4807,8 @@ class EditorMainWindow(QMainWindow):
                 self.properties_panel.clear_selection()
                 self._rebuild_canvas()
                 self._update_page_display()
+                if new_page is not None:
+                    self._live_send([{"op": "add", "path": "/pages/-", "value": new_page}])
                 self.statusBar().showMessage(f"Template added as {new_name}")
 
     def _rebuild_canvas(self):
@@ -4367,14 +4883,17 @@ class EditorMainWindow(QMainWindow):
             widget_dict["height"] = h
             self.config_manager.set_widget(self.current_page, widget_idx, widget_dict)
             self._mark_dirty()
+            # Fires on every snapped step of a drag: the panel follows along
+            self._live_send([{"op": "merge", "path": widget_path(self.current_page, widget_idx),
+                              "value": {"x": x, "y": y, "width": w, "height": h}}])
             # Update position readout in properties panel
             self.properties_panel.update_position(x, y, w, h)
 
     def _on_canvas_widget_dropped(self, widget_type, x, y):
         """Widget dropped from palette onto canvas."""
         widget_dict = make_default_widget(widget_type, x, y)
-        # Stat monitors get their label from the stat type name
-        if widget_type == WIDGET_STAT_MONITOR:
+        # Stat monitors/graphs get their label from the stat type name
+        if widget_type in (WIDGET_STAT_MONITOR, WIDGET_STAT_GRAPH):
             st = widget_dict.get("stat_type", 0x01)
             widget_dict["label"] = STAT_TYPE_NAMES.get(st, "Stat")
         widget_idx = self.config_manager.add_widget(self.current_page, widget_dict)
@@ -4387,6 +4906,8 @@ class EditorMainWindow(QMainWindow):
             self.canvas_scene.clearSelection()
             item.setSelected(True)
             self._mark_dirty()
+            self._live_send([{"op": "add", "path": widget_path(self.current_page, widget_idx),
+                              "value": widget_dict}])
             type_name = WIDGET_TYPE_NAMES.get(widget_type, "Widget")
             self.statusBar().showMessage(f"Added: {type_name} at ({x}, {y})")
 
@@ -4403,6 +4924,9 @@ class EditorMainWindow(QMainWindow):
         # Remove from config_manager in reverse order to maintain indices
         for idx in sorted(indices_to_remove, reverse=True):
             self.config_manager.remove_widget(self.current_page, idx)
+        if indices_to_remove:
+            self._live_send([{"op": "remove", "path": widget_path(self.current_page, idx)}
+                             for idx in sorted(indices_to_remove, reverse=True)])
 
         # Rebuild canvas to fix indices
         self._mark_dirty()
@@ -4425,6 +4949,7 @@ class EditorMainWindow(QMainWindow):
                 self._canvas_items[wid] = item
                 item.setSelected(True)
         self._mark_dirty()
+        self._live_sync_page()
         self.statusBar().showMessage(f"Pasted {len(widget_dicts)} widget(s)")
 
     def _on_move_widgets_to_page(self, widget_ids, target_page):
@@ -4470,6 +4995,8 @@ class EditorMainWindow(QMainWindow):
             return
         self.config_manager.set_widget(self.current_page, widget_idx, widget_dict)
         self._mark_dirty()
+        self._live_send([{"op": "replace", "path": widget_path(self.current_page, widget_idx),
+                          "value": widget_dict}])
         # Update the canvas item appearance
         if widget_id in self._canvas_items:
             item = self._canvas_items[widget_id]
@@ -4656,15 +5183,23 @@ class EditorMainWindow(QMainWindow):
     # -- Settings handlers --
 
     def _load_display_mode_settings(self):
+        # Read everything first: each setter fires _on_display_mode_changed,
+        # which writes all the widgets (some not yet loaded) back to config
         config = self.config_manager.config
-        self.mode_dropdown.setCurrentIndex(config.get("default_mode", 0))
-        self.slideshow_spinbox.setValue(config.get("slideshow_interval_sec", 30))
-        self.analog_checkbox.setChecked(config.get("clock_analog", False))
+        mode = config.get("default_mode", 0)
+        interval = config.get("slideshow_interval_sec", 30)
+        analog = config.get("clock_analog", False)
+        seconds = config.get("clock_seconds", False)
+        self.mode_dropdown.setCurrentIndex(mode)
+        self.slideshow_spinbox.setValue(interval)
+        self.analog_checkbox.setChecked(analog)
+        self.seconds_checkbox.setChecked(seconds)
 
     def _on_display_mode_changed(self):
         self.config_manager.config["default_mode"] = self.mode_dropdown.currentIndex()
         self.config_manager.config["slideshow_interval_sec"] = self.slideshow_spinbox.value()
         self.config_manager.config["clock_analog"] = self.analog_checkbox.isChecked()
+        self.config_manager.config["clock_seconds"] = self.seconds_checkbox.isChecked()
 
     def _on_stats_header_changed(self):
         self.statusBar().showMessage("Stats header updated")
@@ -4792,18 +5327,12 @@ class EditorMainWindow(QMainWindow):
         if not is_valid:
             QMessageBox.critical(self, "Validation Error", error_msg)
             return
-        # Release the companion service's bridge so deploy can use it exclusively
-        if self._companion_service:
-            self._companion_service.release_bridge()
-        try:
-            deploy_dialog = DeployDialog(self.config_manager, self)
-            result = deploy_dialog.exec()
-            if result == QDialog.Accepted:
-                self._auto_save_config()
-                self.statusBar().showMessage("Config deployed and saved")
-        finally:
-            if self._companion_service:
-                self._companion_service.reclaim_bridge()
+        # The deploy goes through the companion service's socket when one runs
+        deploy_dialog = DeployDialog(self.config_manager, self)
+        result = deploy_dialog.exec()
+        if result == QDialog.Accepted:
+            self._auto_save_config()
+            self.statusBar().showMessage("Config deployed and saved")
 
     def _on_upload_pictures(self):
         """Upload pictures via bridge + WiFi. Uses queued list or opens file picker."""
@@ -4821,13 +5350,7 @@ class EditorMainWindow(QMainWindow):
         if not files:
             return
 
-        if self._companion_service:
-            self._companion_service.release_bridge()
-        try:
-            dialog = SlideshowUploadDialog(files, self)
-            if dialog.exec() == QDialog.Accepted:
-                pic_list.clear()
-                self.settings_tab.slideshow_upload_btn.setEnabled(False)
-        finally:
-            if self._companion_service:
-                self._companion_service.reclaim_bridge()
+        dialog = SlideshowUploadDialog(files, self)
+        if dialog.exec() == QDialog.Accepted:
+            pic_list.clear()
+            self.settings_tab.slideshow_upload_btn.setEnabled(False)
@@ -1,13 +1,15 @@
 """
 Slideshow Upload Dialog: One-click picture upload via USB bridge + WiFi auto-connect.
 
-Orchestrates the same sequence as deploy:
+Orchestrates the same sequence as deploy, after encoding the pictures
+(cached, in parallel) while the panel is still untouched:
+0. Encode pictures for the device (image_optimizer.optimize_batch)
 1. Open bridge USB HID
 2. Send CONFIG_MODE (display starts SoftAP)
 3. Wait for AP startup
 4. Connect PC WiFi to CrowPanel-Config
 5. Wait for device HTTP health check
-6. Upload optimized SJPG images to /pictures/
+6. Upload the pictures that changed to /pictures/
 7. Send CONFIG_DONE (display reloads, exits AP)
 8. Restore previous WiFi
 """
@@ -35,6 +37,7 @@ import logging
 logger = logging.getLogger(__name__)
 
 UPLOAD_STEPS = [
+    ("encode", "Prepare pictures"),
     ("bridge", "Open bridge USB connection"),
     ("config_mode", "Signal display to enter config mode"),
     ("ap_wait", "Wait for AP startup"),
@@ -63,12 +66,26 @@ class SlideshowUploadWorker(QThread):
 
     def run(self):
         """Execute full upload sequence with error recovery."""
-        from companion.image_optimizer import optimize_for_slideshow
+        from companion.image_optimizer import ImageJob, optimize_batch, output_format
 
         self._bridge = BridgeDevice()
         self._wifi = WiFiManager()
 
         try:
+            # 0. Encode everything before the panel enters config mode
+            self.step_started.emit("encode")
+            ext = output_format("picture")
+            results = optimize_batch([ImageJob("picture", path) for path in self._file_paths],
+                                     progress=self.upload_progress.emit)
+            files = {}
+            errors = []
+            for path, data in zip(self._file_paths, results):
+                if isinstance(data, Exception):
+                    errors.append(str(data))
+                else:
+                    files[os.path.splitext(os.path.basename(path))[0] + "." + ext] = data
+            self.step_done.emit("encode")
+
             # 1. Open bridge
             self.step_started.emit("bridge")
             self._bridge.open()
@@ -96,24 +113,10 @@ class SlideshowUploadWorker(QThread):
                 raise HTTPClientError("Device not responding after WiFi connect")
             self.step_done.emit("health")
 
-            # 6. Upload images
+            # 6. Upload images (only those the SD card doesn't already hold)
             self.step_started.emit("upload")
             total = len(self._file_paths)
-            errors = []
-            for i, path in enumerate(self._file_paths):
-                self.upload_progress.emit(i + 1, total)
-                basename = os.path.basename(path)
-                name_root = os.path.splitext(basename)[0]
-                dest_name = name_root + ".sjpg"
-
-                try:
-                    data = optimize_for_slideshow(path)
-                    result = client.sd_upload_image(dest_name, data, folder="pictures")
-                    if not result.get("success"):
-                        errors.append(f"{basename}: {result.get('error', 'unknown')}")
-                except Exception as e:
-                    errors.append(f"{basename}: {e}")
-
+            errors += client.sync_folder("pictures", files)
             self.step_done.emit("upload")
 
             # 7. Send CONFIG_DONE
@@ -0,0 +1,483 @@
+"""
+Window tracker: a live window list from the compositor.
+
+Focus-or-launch buttons and profile focus following used to fork wmctrl,
+hyprctl, swaymsg or xdotool per press / per poll. WindowTracker instead
+keeps one IPC connection to the compositor, loads the window list once and
+follows it through the compositor's event stream, so looking up a window
+by WM_CLASS is a dict walk and focusing it is one request on an open
+socket.
+
+Backends, picked from the session environment:
+    Hyprland    $HYPRLAND_INSTANCE_SIGNATURE: .socket2.sock events,
+                .socket.sock requests ("j/clients", "dispatch focuswindow")
+    Sway        $SWAYSOCK: i3 IPC, subscribed to "window" events
+    X11         $DISPLAY with python-xlib installed: EWMH _NET_CLIENT_LIST /
+                _NET_ACTIVE_WINDOW property changes on the root window
+
+focus() and active_class() return None while no backend is connected;
+callers then fall back to the command-line tools.
+"""
+
+import collections
+import json
+import logging
+import os
+import socket
+import struct
+import threading
+import time
+
+# Seconds before reconnecting to a compositor that closed its socket
+RECONNECT_INTERVAL = 5.0
+
+# Seconds an IPC request may take before the connection is considered dead
+REQUEST_TIMEOUT = 1.0
+
+
+def _matches(wm_class, names):
+    """wmctrl -x semantics: wm_class is a case-insensitive substring of instance.class."""
+    needle = wm_class.lower()
+    return any(needle in name for name in names)
+
+
+class _Backend:
+    """One compositor connection. run() feeds the tracker until the connection drops."""
+
+    name = ""
+
+    def __init__(self, tracker):
+        self._tracker = tracker
+
+    def run(self):
+        raise NotImplementedError
+
+    def focus(self, window_id):
+        raise NotImplementedError
+
+    def close(self):
+        pass
+
+
+class _HyprlandBackend(_Backend):
+    name = "hyprland"
+
+    def __init__(self, tracker, signature):
+        super().__init__(tracker)
+        runtime = os.environ.get("XDG_RUNTIME_DIR", "")
+        base = os.path.join(runtime, "hypr", signature)
+        if not os.path.exists(os.path.join(base, ".socket.sock")):
+            base = os.path.join("/tmp/hypr", signature)   # Hyprland < 0.40
+        self._request_path = os.path.join(base, ".socket.sock")
+        self._event_path = os.path.join(base, ".socket2.sock")
+        self._events = None
+
+    def _request(self, command):
+        # The request socket answers one command per connection
+        with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as sock:
+            sock.settimeout(REQUEST_TIMEOUT)
+            sock.connect(self._request_path)
+            sock.sendall(command.encode())
+            chunks = []
+            while True:
+                chunk = sock.recv(65536)
+                if not chunk:
+                    break
+                chunks.append(chunk)
+            return b"".join(chunks).decode(errors="replace")
+
+    @staticmethod
+    def _address(text):
+        # Events leave out the 0x; "activewindowv2>>," means nothing is focused
+        return text.strip().strip(",").lower().removeprefix("0x")
+
+    def run(self):
+        self._events = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self._events.connect(self._event_path)
+        # Subscribe first, then load the list: nothing opened in between is missed
+        clients = json.loads(self._request("j/clients") or "[]")
+        windows = {}
+        # focusHistoryID 0 is the focused window: load oldest first
+        for client in sorted(clients, key=lambda c: -c.get("focusHistoryID", 0)):
+            windows[self._address(client.get("address", ""))] = (
+                client.get("class", ""), client.get("initialClass", ""))
+        active = next((self._address(c.get("address", "")) for c in clients
+                       if c.get("focusHistoryID") == 0), None)
+        self._tracker._reset(windows, active)
+
+        buffer = b""
+        while True:
+            chunk = self._events.recv(4096)
+            if not chunk:
+                return
+            buffer += chunk
+            *lines, buffer = buffer.split(b"\n")
+            for line in lines:
+                event, _, data = line.decode(errors="replace").partition(">>")
+                if event == "openwindow":
+                    # ADDRESS,WORKSPACE,CLASS,TITLE (the title may contain commas)
+                    fields = data.split(",", 3)
+                    if len(fields) >= 3:
+                        self._tracker._window_opened(self._address(fields[0]), (fields[2],))
+                elif event == "closewindow":
+                    self._tracker._window_closed(self._address(data))
+                elif event == "activewindowv2":
+                    self._tracker._window_focused(self._address(data) or None)
+
+    def focus(self, window_id):
+        return self._request(f"dispatch focuswindow address:0x{window_id}").strip() == "ok"
+
+    def close(self):
+        if self._events is not None:
+            try:
+                self._events.shutdown(socket.SHUT_RDWR)
+            except OSError:
+                pass
+            self._events.close()
+
+
+class _SwayBackend(_Backend):
+    name = "sway"
+
+    _MAGIC = b"i3-ipc"
+    _HEADER = struct.Struct("=6sII")
+    _RUN_COMMAND = 0
+    _SUBSCRIBE = 2
+    _GET_TREE = 4
+    _EVENT_WINDOW = 0x80000003
+
+    def __init__(self, tracker, path):
+        super().__init__(tracker)
+        self._path = path
+        self._events = None
+        self._commands = None
+        self._command_lock = threading.Lock()
+
+    def _connect(self):
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        sock.connect(self._path)
+        return sock
+
+    def _send(self, sock, msg_type, payload=b""):
+        sock.sendall(self._HEADER.pack(self._MAGIC, len(payload), msg_type) + payload)
+
+    def _recv(self, sock):
+        def read(n):
+            data = b""
+            while len(data) < n:
+                chunk = sock.recv(n - len(data))
+                if not chunk:
+                    raise ConnectionError("sway closed the IPC socket")
+                data += chunk
+            return data
+        magic, length, msg_type = self._HEADER.unpack(read(self._HEADER.size))
+        if magic != self._MAGIC:
+            raise ConnectionError("not an i3 IPC reply")
+        return msg_type, json.loads(read(length) or b"null")
+
+    @staticmethod
+    def _names(con):
+        props = con.get("window_properties") or {}
+        return tuple(n for n in (con.get("app_id"), props.get("class"), props.get("instance")) if n)
+
+    def run(self):
+        self._events = self._connect()
+        self._send(self._events, self._SUBSCRIBE, b'["window"]')
+        self._recv(self._events)
+        self._send(self._events, self._GET_TREE)
+        msg_type, tree = self._recv(self._events)
+        while msg_type != self._GET_TREE:   # Events that beat the reply are in the tree
+            msg_type, tree = self._recv(self._events)
+        windows = {}
+        active = None
+        stack = [tree]
+        while stack:
+            node = stack.pop()
+            if node.get("pid") is not None or node.get("window") is not None:
+                windows[node["id"]] = self._names(node)
+                if node.get("focused"):
+                    active = node["id"]
+            stack.extend(node.get("nodes", []) + node.get("floating_nodes", []))
+        self._tracker._reset(windows, active)
+
+        while True:
+            msg_type, event = self._recv(self._events)
+            if msg_type != self._EVENT_WINDOW:
+                continue
+            change, con = event.get("change"), event.get("container") or {}
+            if change == "new":
+                self._tracker._window_opened(con.get("id"), self._names(con))
+            elif change == "close":
+                self._tracker._window_closed(con.get("id"))
+            elif change == "focus":
+                self._tracker._window_opened(con.get("id"), self._names(con))
+                self._tracker._window_focused(con.get("id"))
+
+    def focus(self, window_id):
+        with self._command_lock:
+            try:
+                if self._commands is None:
+                    self._commands = self._connect()
+                    self._commands.settimeout(REQUEST_TIMEOUT)
+                self._send(self._commands, self._RUN_COMMAND, f"[con_id={window_id}] focus".encode())
+                _, replies = self._recv(self._commands)
+            except (OSError, ConnectionError, ValueError):
+                if self._commands is not None:
+                    self._commands.close()
+                self._commands = None
+                raise
+        return bool(replies) and all(r.get("success") for r in replies)
+
+    def close(self):
+        for sock in (self._events, self._commands):
+            if sock is not None:
+                try:
+                    sock.shutdown(socket.SHUT_RDWR)
+                except OSError:
+                    pass
+                sock.close()
+
+
+class _X11Backend(_Backend):
+    name = "x11"
+
+    def __init__(self, tracker, xlib):
+        super().__init__(tracker)
+        self._xlib = xlib
+        self._display = None   # Event connection, owned by run()
+        self._request_display = None
+        self._request_lock = threading.Lock()
+
+    def run(self):
+        from Xlib import X
+        self._display = self._xlib.Display()
+        root = self._display.screen().root
+        client_list = self._display.intern_atom("_NET_CLIENT_LIST")
+        active_window = self._display.intern_atom("_NET_ACTIVE_WINDOW")
+        root.change_attributes(event_mask=X.PropertyChangeMask)
+
+        def names(window_id):
+            try:
+                wm_class = self._display.create_resource_object("window", window_id).get_wm_class()
+            except Exception:
+                return ()   # Already gone
+            return tuple(wm_class or ())
+
+        def property_ids(atom):
+            prop = root.get_full_property(atom, X.AnyPropertyType)
+            return list(prop.value) if prop else []
+
+        windows = {wid: names(wid) for wid in property_ids(client_list)}
+        active = (property_ids(active_window) or [None])[0]
+        self._tracker._reset(windows, active or None)
+        known = set(windows)
+
+        while True:
+            event = self._display.next_event()
+            if event.type != X.PropertyNotify:
+                continue
+            if event.atom == client_list:
+                current = set(property_ids(client_list))
+                for wid in current - known:
+                    self._tracker._window_opened(wid, names(wid))
+                for wid in known - current:
+                    self._tracker._window_closed(wid)
+                known = current
+            elif event.atom == active_window:
+                self._tracker._window_focused((property_ids(active_window) or [None])[0] or None)
+
+    def focus(self, window_id):
+        from Xlib import X
+        from Xlib.protocol import event
+        with self._request_lock:
+            if self._request_display is None:
+                self._request_display = self._xlib.Display()
+            display = self._request_display
+            root = display.screen().root
+            window = display.create_resource_object("window", window_id)
+            # Source indication 2 = pager: window managers honour it without focus-stealing checks
+            message = event.ClientMessage(window=window, client_type=display.intern_atom("_NET_ACTIVE_WINDOW"),
+                                          data=(32, [2, X.CurrentTime, 0, 0, 0]))
+            root.send_event(message, event_mask=X.SubstructureRedirectMask | X.SubstructureNotifyMask)
+            display.flush()
+        return True
+
+    def close(self):
+        for display in (self._display, self._request_display):
+            if display is not None:
+                try:
+                    display.close()
+                except Exception:
+                    pass
+
+
+class WindowTracker:
+    """Window list and focus of the running compositor, kept current by its events.
+
+    Listeners added with add_focus_listener() are called as listener(wm_class)
+    from the tracker thread whenever the focused window changes (wm_class
+    None when nothing is focused).
+    """
+
+    def __init__(self):
+        self._lock = threading.Lock()
+        self._windows = collections.OrderedDict()   # id -> lowercase names, last focused at the end
+        self._active = None
+        self._backend = None
+        self._connected = False
+        self._running = False
+        self._thread = None
+        self._listeners = []
+
+    def _make_backend(self):
+        signature = os.environ.get("HYPRLAND_INSTANCE_SIGNATURE")
+        if signature:
+            return _HyprlandBackend(self, signature)
+        if os.environ.get("SWAYSOCK"):
+            return _SwayBackend(self, os.environ["SWAYSOCK"])
+        if os.environ.get("DISPLAY") and not os.environ.get("WAYLAND_DISPLAY"):
+            try:
+                from Xlib import display as xlib
+            except ImportError:
+                logging.debug("python-xlib not installed: X11 windows via wmctrl/xdotool")
+                return None
+            return _X11Backend(self, xlib)
+        return None
+
+    def start(self):
+        """Connect in the background; a no-op without a supported compositor."""
+        if self._running:
+            return
+        self._backend = self._make_backend()
+        if self._backend is None:
+            return
+        self._running = True
+        self._thread = threading.Thread(target=self._run, name="window-tracker", daemon=True)
+        self._thread.start()
+
+    def stop(self):
+        self._running = False
+        if self._backend is not None:
+            self._backend.close()
+
+    def _run(self):
+        while self._running:
+            try:
+                self._backend.run()
+                logging.info("Window tracker: %s closed its IPC socket", self._backend.name)
+            except Exception as exc:
+                if self._running:
+                    logging.info("Window tracker: %s IPC unavailable (%s)", self._backend.name, exc)
+            with self._lock:
+                self._connected = False
+                self._windows.clear()
+            self._backend.close()
+            if self._running:
+                time.sleep(RECONNECT_INTERVAL)
+
+    # -- backend callbacks (tracker thread) -------------------------------
+
+    @staticmethod
+    def _lower(names):
+        return tuple(n.lower() for n in names if n)
+
+    def _reset(self, windows, active):
+        with self._lock:
+            self._windows = collections.OrderedDict(
+                (wid, self._lower(names)) for wid, names in windows.items())
+            if active in self._windows:
+                self._windows.move_to_end(active)
+            self._active = active
+            self._connected = True
+        logging.info("Window tracker: %s IPC connected, %d windows", self._backend.name, len(windows))
+        self._notify()
+
+    def _window_opened(self, window_id, names):
+        with self._lock:
+            if window_id not in self._windows or names:
+                self._windows[window_id] = self._lower(names)
+                self._windows.move_to_end(window_id, last=False)   # Never focused yet
+
+    def _window_closed(self, window_id):
+        with self._lock:
+            self._windows.pop(window_id, None)
+            if self._active == window_id:
+                self._active = None
+
+    def _window_focused(self, window_id):
+        with self._lock:
+            if window_id == self._active:
+                return
+            self._active = window_id
+            if window_id in self._windows:
+                self._windows.move_to_end(window_id)
+        self._notify()
+
+    def _notify(self):
+        wm_class = self.active_class()
+        for listener in list(self._listeners):
+            try:
+                listener(wm_class)
+            except Exception as exc:
+                logging.error("Focus listener failed: %s", exc)
+
+    # -- queries ----------------------------------------------------------
+
+    @property
+    def connected(self):
+        return self._connected
+
+    def add_focus_listener(self, listener):
+        self._listeners.append(listener)
+
+    def remove_focus_listener(self, listener):
+        if listener in self._listeners:
+            self._listeners.remove(listener)
+
+    def active_class(self):
+        """The focused window's class ('' when none is focused), None while disconnected."""
+        with self._lock:
+            if not self._connected:
+                return None
+            names = self._windows.get(self._active, ())
+        return names[0] if names else ""
+
+    def find(self, wm_class):
+        """Id of the most recently focused window matching wm_class, None if none."""
+        with self._lock:
+            for window_id in reversed(self._windows):
+                if _matches(wm_class, self._windows[window_id]):
+                    return window_id
+        return None
+
+    def focus(self, wm_class):
+        """Focus the most recent window of wm_class.
+
+        Returns True when one was focused, False when the compositor has no
+        such window, None when the tracker can't tell (not connected, request
+        failed) and the caller should use its fallback.
+        """
+        if not self._connected:
+            return None
+        window_id = self.find(wm_class)
+        if window_id is None:
+            return False
+        try:
+            return bool(self._backend.focus(window_id)) or None
+        except Exception as exc:
+            logging.debug("Window tracker: focus request failed: %s", exc)
+            return None
+
+
+_tracker = None
+_tracker_lock = threading.Lock()
+
+
+def get_window_tracker() -> WindowTracker:
+    """Get or create the singleton WindowTracker, started on first use."""
+    global _tracker
+    with _tracker_lock:
+        if _tracker is None:
+            _tracker = WindowTracker()
+            _tracker.start()
+    return _tracker
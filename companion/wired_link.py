@@ -0,0 +1,228 @@
+"""
+Wired link: the companion on the display's own USB port.
+
+The CrowPanel's USB socket is a USB-UART bridge (CH340) on the display's
+serial console. With the panel plugged in, the companion talks to it over
+that port directly instead of through the bridge, with the same message
+types (display/wired_link.h has the firmware side):
+
+    0x00  COBS( [TYPE] [PAYLOAD...] [CRC-32 LE] )  0x00
+
+Whatever between the zeros doesn't decode with a good CRC is the display's
+console log, passed to logging at debug level.
+
+WiredDisplay stands in for the bridge's hid device: write_vendor_message()
+hands it whole messages (write_message), the vendor reader gets each
+frame from read() shaped like a reassembled vendor report. MSG_HELLO
+keeps the link up both ways; a display that stops answering makes read()
+raise, so the service falls back to looking for a bridge.
+"""
+
+import collections
+import logging
+import struct
+import threading
+import time
+import zlib
+
+from companion.bridge_device import (FragmentReassembler, split_display,
+                                     VENDOR_REPORT_ID, VENDOR_MAX_MESSAGE)
+
+logger = logging.getLogger(__name__)
+
+# USB-UART chips the CrowPanel ships with (VID, PID)
+WIRED_USB_IDS = {(0x1A86, 0x7523), (0x1A86, 0x55D4)}   # CH340, CH9102
+WIRED_BAUD = 115200           # WIRED_LINK_BAUD in the display build
+WIRED_KEEPALIVE = 1.0         # Seconds between MSG_HELLOs (display times out at 3 s)
+WIRED_TIMEOUT = 5.0           # No valid frame for this long: the display is gone
+WIRED_PROBE_TIMEOUT = 1.5     # Wait for the display's HELLO reply when opening
+
+MSG_HELLO = 0x24
+HELLO = struct.Struct("<BHB")   # version, caps, flags (HelloMsg)
+HELLO_F_REPLY = 0x01
+PROTO_VERSION = 2
+
+
+def cobs_encode(data: bytes) -> bytes:
+    out = bytearray([0])
+    code_pos, code = 0, 1
+    for byte in data:
+        if byte == 0:
+            out[code_pos] = code
+            code_pos, code = len(out), 1
+            out.append(0)
+            continue
+        out.append(byte)
+        code += 1
+        if code == 0xFF:
+            out[code_pos] = code
+            code_pos, code = len(out), 1
+            out.append(0)
+    out[code_pos] = code
+    return bytes(out)
+
+
+def cobs_decode(data: bytes):
+    """Decoded bytes, or None for a malformed block."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        i += 1
+        if code == 0 or i + code - 1 > len(data):
+            return None
+        out += data[i:i + code - 1]
+        i += code - 1
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def encode_frame(msg_type: int, payload: bytes = b"") -> bytes:
+    body = bytes([msg_type]) + bytes(payload)
+    body += struct.pack("<I", zlib.crc32(body))
+    return b"\x00" + cobs_encode(body) + b"\x00"
+
+
+def decode_frame(chunk: bytes):
+    """[TYPE][PAYLOAD...] of one zero-delimited chunk, None if it is log text."""
+    body = cobs_decode(chunk)
+    if body is None or len(body) < 5:
+        return None
+    if zlib.crc32(body[:-4]) != struct.unpack_from("<I", body, len(body) - 4)[0]:
+        return None
+    return body[:-4]
+
+
+def find_wired_displays():
+    """Serial ports that may be a CrowPanel (pyserial missing: none)."""
+    try:
+        from serial.tools import list_ports
+    except ImportError:
+        return []
+    return [port.device for port in list_ports.comports()
+            if (port.vid, port.pid) in WIRED_USB_IDS]
+
+
+class WiredDisplay:
+    """A display on a serial port, with the hid device calls the service uses."""
+
+    product = "CrowPanel (USB)"
+    manufacturer = "Elecrow"
+
+    def __init__(self, port: str, baud: int = WIRED_BAUD):
+        import serial
+        self.serial = port
+        self._port = serial.Serial()
+        self._port.port = port
+        self._port.baudrate = baud
+        self._port.timeout = 0
+        # The USB-UART's DTR/RTS drive EN and IO0: keep both released, or
+        # opening the port resets the display (or drops it into the ROM loader)
+        self._port.dtr = False
+        self._port.rts = False
+        self._write_lock = threading.Lock()
+        self._rx = bytearray()
+        self._frames = collections.deque()
+        self._reports = FragmentReassembler()
+        self._last_rx = 0.0
+        self._last_hello = 0.0
+
+    def open(self, probe_timeout: float = WIRED_PROBE_TIMEOUT) -> bool:
+        """Open the port; True once the display has answered a HELLO."""
+        self._port.open()
+        self._port.reset_input_buffer()
+        deadline = time.monotonic() + probe_timeout
+        while time.monotonic() < deadline:
+            self._keepalive(force=time.monotonic() - self._last_hello > 0.5)
+            self._pump(0.05)
+            if self._last_rx:
+                return True
+        self.close()
+        return False
+
+    def close(self):
+        try:
+            self._port.close()
+        except Exception:
+            pass
+
+    # --- Writes ----------------------------------------------------------
+
+    def write_message(self, msg_type: int, payload: bytes = b"", display=None):
+        """One message to the display (display ids don't apply to a cable)."""
+        frame = encode_frame(msg_type, payload)
+        with self._write_lock:
+            self._port.write(frame)
+        return len(frame)
+
+    def write(self, report) -> int:
+        """A vendor HID output report, as written to the bridge."""
+        message = self._reports.feed(bytes(report)[1:])
+        if message:
+            _, message = split_display(message)
+            self.write_message(message[0], message[1:])
+        return len(report)
+
+    def _keepalive(self, force=False):
+        now = time.monotonic()
+        if force or now - self._last_hello >= WIRED_KEEPALIVE:
+            self._last_hello = now
+            self.write_message(MSG_HELLO, HELLO.pack(PROTO_VERSION, 0, 0))
+
+    # --- Reads -----------------------------------------------------------
+
+    def _pump(self, timeout: float):
+        """Read what is there (waiting up to timeout for the first byte)."""
+        self._port.timeout = timeout
+        data = self._port.read(1)
+        if data:
+            self._port.timeout = 0
+            data += self._port.read(self._port.in_waiting or 0)
+        self._rx += data
+        while True:
+            end = self._rx.find(0)
+            if end < 0:
+                break
+            chunk = bytes(self._rx[:end])
+            del self._rx[:end + 1]
+            if not chunk:
+                continue
+            message = decode_frame(chunk)
+            if message is None:
+                text = chunk.decode("utf-8", "replace").strip()
+                if text:
+                    logger.debug("display: %s", text)
+                continue
+            self._last_rx = time.monotonic()
+            if message[0] == MSG_HELLO:
+                continue   # Keepalive answer, nothing for the service
+            self._frames.append(message[:VENDOR_MAX_MESSAGE])
+        if len(self._rx) > 4096:   # Log line without a zero in sight
+            logger.debug("display: %s", self._rx.decode("utf-8", "replace").strip())
+            self._rx.clear()
+
+    def read(self, size: int, timeout: int = 0):
+        """Next frame as [report id][TYPE][PAYLOAD...]; b"" after timeout ms."""
+        self._keepalive()
+        if not self._frames:
+            self._pump(timeout / 1000.0)
+        if time.monotonic() - self._last_rx > WIRED_TIMEOUT:
+            raise OSError("wired display stopped answering")
+        if not self._frames:
+            return b""
+        return bytes([VENDOR_REPORT_ID]) + self._frames.popleft()
+
+
+def open_wired_display(baud: int = WIRED_BAUD):
+    """The first serial port with a display answering on it, or None."""
+    for port in find_wired_displays():
+        try:
+            device = WiredDisplay(port, baud)
+            if device.open():
+                logger.info("Display found on %s", port)
+                return device
+            logger.debug("No display answering on %s", port)
+        except Exception as exc:
+            logger.debug("Cannot probe %s: %s", port, exc)
+    return None
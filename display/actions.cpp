@@ -0,0 +1,297 @@
+/**
+ * @file actions.cpp
+ * Per-page action tables and the one dispatcher behind every button
+ *
+ * Display-local actions run here; HID actions (hotkey, media key, DDC,
+ * macro, typed text) go straight to the bridge, or the keyboard ones to the
+ * display's BLE keyboard when that is the host's link, and the PC-side
+ * ones (launch, shell, URL) send the button's identity for the companion
+ * to look up.
+ */
+
+#include "actions.h"
+#include "espnow_link.h"
+#include "ble_hid.h"
+#include "wired_link.h"
+#include "config_server.h"
+#include "hw_input.h"
+#include "power.h"
+#include "perf.h"
+#include "input_replay.h"
+#include "key_layouts.h"
+#include "ui.h"
+#include "log.h"
+#include "trace.h"
+#include <Arduino.h>
+
+// ============================================================
+// Tables
+// ============================================================
+
+void action_table_clear(ActionTable &t) {
+    t.action.clear();
+    t.keycode.clear();
+    t.modifiers.clear();
+    t.consumer_code.clear();
+    t.extra.clear();
+    t.extras.clear();
+}
+
+void action_table_build(ActionTable &t, const PageConfig &page, uint8_t page_idx) {
+    action_table_clear(t);
+    t.page = page_idx;
+    size_t n = page.widgets.size() < CONFIG_MAX_WIDGETS ? page.widgets.size() : CONFIG_MAX_WIDGETS;
+    t.action.reserve(n);
+    t.keycode.reserve(n);
+    t.modifiers.reserve(n);
+    t.consumer_code.reserve(n);
+    t.extra.reserve(n);
+    for (size_t wi = 0; wi < n; wi++) {
+        const WidgetConfig &w = page.widgets[wi];
+        bool button = w.widget_type == WIDGET_HOTKEY_BUTTON;
+        t.action.push_back(button ? (uint8_t)w.action_type : ACTION_TABLE_NONE);
+        t.keycode.push_back(w.keycode);
+        t.modifiers.push_back(w.modifiers);
+        t.consumer_code.push_back(w.consumer_code);
+        uint8_t extra = 0xFF;
+        if (button && (w.action_type == ACTION_DDC || w.action_type == ACTION_MACRO ||
+                       w.action_type == ACTION_TYPE_TEXT)) {
+            extra = (uint8_t)t.extras.size();
+            t.extras.push_back({ w.ddc_vcp_code, w.ddc_display, w.ddc_value, w.ddc_adjustment,
+                                 w.action_type == ACTION_MACRO ? &w.macro_steps : nullptr,
+                                 w.action_type == ACTION_TYPE_TEXT ? &w.type_text : nullptr, w.key_layout });
+        }
+        t.extra.push_back(extra);
+    }
+}
+
+bool action_table_get(const ActionTable &t, uint8_t widget, ActionDesc &out) {
+    if (widget >= t.action.size() || t.action[widget] == ACTION_TABLE_NONE) return false;
+    out = {};
+    out.action = t.action[widget];
+    out.keycode = t.keycode[widget];
+    out.modifiers = t.modifiers[widget];
+    out.consumer_code = t.consumer_code[widget];
+    if (t.extra[widget] != 0xFF) {
+        const ActionTable::Extra &x = t.extras[t.extra[widget]];
+        out.ddc_vcp_code = x.ddc_vcp_code;
+        out.ddc_value = x.ddc_value;
+        out.ddc_adjustment = x.ddc_adjustment;
+        out.ddc_display = x.ddc_display;
+        out.macro = x.macro;
+        out.text = x.text;
+        out.key_layout = x.key_layout;
+    }
+    out.page = t.page;
+    out.widget = widget;
+    out.entry = ACTION_ENTRY_NONE;
+    return true;
+}
+
+ActionDesc action_from_hw(const HwButtonConfig &b, uint8_t slot) {
+    ActionDesc a = action_simple(b.action_type, b.keycode, b.consumer_code, b.modifiers);
+    a.ddc_vcp_code = b.ddc_vcp_code;
+    a.ddc_value = b.ddc_value;
+    a.ddc_adjustment = b.ddc_adjustment;
+    a.ddc_display = b.ddc_display;
+    a.widget = slot;
+    return a;
+}
+
+ActionDesc action_simple(uint8_t action, uint8_t keycode, uint16_t consumer_code, uint8_t modifiers) {
+    ActionDesc a = {};
+    a.action = action;
+    a.keycode = keycode;
+    a.consumer_code = consumer_code;
+    a.modifiers = modifiers;
+    a.page = ACTION_SOURCE_HW;
+    a.widget = 0xFF;
+    a.entry = ACTION_ENTRY_NONE;
+    return a;
+}
+
+// ============================================================
+// HID transport
+// ============================================================
+
+static bool hid_via_ble() {
+    if (!ble_hid_connected() || wired_link_up()) return false;   // The cable beats both radios
+    return BLE_HID_PREFER || !espnow_host_linked(espnow_active_host());
+}
+
+void hid_send_hotkey(uint8_t modifiers, uint8_t keycode) {
+    if (replay_running()) return;   // A replay never types into the PC
+    if (hid_via_ble() && ble_hid_send_key(modifiers, keycode)) return;
+    send_hotkey_to_bridge(modifiers, keycode);
+}
+
+void hid_send_media(uint16_t consumer_code) {
+    if (replay_running()) return;
+    if (hid_via_ble() && ble_hid_send_media(consumer_code)) return;
+    send_media_key_to_bridge(consumer_code);
+}
+
+void hid_send_macro(const MacroStep *steps, uint8_t count) {
+    if (replay_running()) return;
+    if (hid_via_ble() && ble_hid_send_macro(steps, count)) return;
+    send_macro_to_bridge(steps, count);
+}
+
+void hid_send_text(const char *utf8, size_t len, uint8_t layout) {
+    if (replay_running()) return;
+    if (hid_via_ble()) {
+        // The BLE keyboard plays macros: the leading characters that fit one
+        MacroStep steps[MACRO_MAX_STEPS];
+        size_t typed = 0;
+        uint8_t count = key_layout_macro(layout, utf8, len, steps, MACRO_MAX_STEPS, &typed);
+        if (typed < len) LOG_W("Text: BLE types %u of %u bytes\n", (unsigned)typed, (unsigned)len);
+        if (!count || ble_hid_send_macro(steps, count)) return;
+    }
+    send_text_to_bridge(utf8, len, layout);
+}
+
+// ============================================================
+// Dispatch
+// ============================================================
+
+// What a replay may run: the panel's own UI. Anything reaching the PC,
+// the monitor, the bridge pairing or the SoftAP is dropped, so a replay
+// changes nothing but pixels and can run back to back.
+static bool replay_allows(uint8_t action) {
+    switch (action) {
+        case ACTION_DISPLAY_CLOCK:
+        case ACTION_DISPLAY_PICTURE:
+        case ACTION_PAGE_NEXT:
+        case ACTION_PAGE_PREV:
+        case ACTION_PAGE_GOTO:
+        case ACTION_MODE_CYCLE:
+        case ACTION_BRIGHTNESS:
+        case ACTION_PERF_HUD:
+        case ACTION_PROFILE_GOTO:
+        case ACTION_PROFILE_NEXT:
+        case ACTION_FOCUS_NEXT:
+        case ACTION_FOCUS_PREV:
+        case ACTION_FOCUS_ACTIVATE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void toggle_config_mode() {
+    if (!config_server_active()) {
+        if (config_server_start()) show_config_screen();
+    } else {
+        config_server_stop();
+        hide_config_screen();
+    }
+}
+
+void action_run(const ActionDesc &a) {
+    power_activity();
+    if (a.page != ACTION_SOURCE_HW) trace(TR_UI_ACTION, a.action, a.page << 8 | a.widget);
+    if (replay_running() && !replay_allows(a.action)) {
+        LOG_D("Action %d skipped during replay\n", a.action);
+        return;
+    }
+
+    switch (a.action) {
+        // Display-local
+        case ACTION_DISPLAY_SETTINGS:
+        case ACTION_CONFIG_MODE:
+            LOG_D("Action: toggle config mode\n");
+            toggle_config_mode();
+            return;
+        case ACTION_DISPLAY_CLOCK:
+            display_set_mode(MODE_CLOCK);
+            return;
+        case ACTION_DISPLAY_PICTURE:
+            display_set_mode(MODE_PICTURE_FRAME);
+            return;
+        case ACTION_PAGE_NEXT:
+            ui_next_page();
+            return;
+        case ACTION_PAGE_PREV:
+            ui_prev_page();
+            return;
+        case ACTION_PAGE_GOTO:
+            LOG_D("Action: goto page %d\n", a.keycode);
+            ui_goto_page(a.keycode);
+            return;
+        case ACTION_MODE_CYCLE:
+            mode_cycle_next(get_global_config().mode_cycle.enabled_modes);
+            return;
+        case ACTION_BRIGHTNESS:
+            power_cycle_brightness();
+            return;
+        case ACTION_PERF_HUD:
+            perf_hud_toggle();
+            return;
+        case ACTION_PROFILE_GOTO:
+            LOG_D("Action: goto profile %d\n", a.keycode);
+            ui_switch_profile_index(a.keycode);
+            return;
+        case ACTION_PROFILE_NEXT:
+            ui_next_profile();
+            return;
+        case ACTION_HOST_NEXT:
+            ui_next_host();
+            return;
+        case ACTION_HOST_PAIR:
+            ui_pair_host();
+            return;
+        case ACTION_FOCUS_NEXT:
+            hw_input_focus_next();
+            return;
+        case ACTION_FOCUS_PREV:
+            hw_input_focus_prev();
+            return;
+        case ACTION_FOCUS_ACTIVATE:
+            hw_input_activate_focus();
+            return;
+
+        // HID, straight through the bridge (or BLE)
+        case ACTION_HOTKEY:
+            hid_send_hotkey(a.modifiers, a.keycode);
+            LOG_D("Hotkey: mod=0x%02X key=0x%02X\n", a.modifiers, a.keycode);
+            return;
+        case ACTION_MEDIA_KEY:
+            hid_send_media(a.consumer_code);
+            LOG_D("Media key: 0x%04X\n", a.consumer_code);
+            return;
+        case ACTION_DDC: {
+            DdcCmdMsg ddc;
+            ddc.vcp_code = a.ddc_vcp_code;
+            ddc.value = a.ddc_value;
+            ddc.adjustment = a.ddc_adjustment;
+            ddc.display_num = a.ddc_display;
+            send_ddc_to_bridge(ddc);
+            LOG_D("DDC cmd: vcp=0x%02X val=%d adj=%d disp=%d\n",
+                  ddc.vcp_code, ddc.value, ddc.adjustment, ddc.display_num);
+            return;
+        }
+        case ACTION_MACRO:
+            if (a.macro && !a.macro->empty()) {
+                hid_send_macro(a.macro->data(), (uint8_t)a.macro->size());
+            } else {
+                LOG_W("Macro: no steps configured\n");
+            }
+            return;
+        case ACTION_TYPE_TEXT:
+            if (a.text && !a.text->empty()) {
+                hid_send_text(a.text->c_str(), a.text->size(), a.key_layout);
+            } else {
+                LOG_W("Type text: no text configured\n");
+            }
+            return;
+
+        default:
+            // Companion-handled (launch app, shell command, URL): send the
+            // button identity for lookup; hardware buttons as page 0xFF,
+            // scroll grid cells with their entry index
+            send_button_press_to_bridge(a.page, a.widget, ui_active_profile_index(), a.entry);
+            LOG_D("Button press: page=%d widget=%d entry=%d action=%d\n", a.page, a.widget,
+                  a.entry == ACTION_ENTRY_NONE ? -1 : a.entry, a.action);
+            return;
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include "config.h"
+
+// ============================================================
+// Action dispatch: touch widgets, hardware buttons, the encoder push and
+// touch gestures all end up in action_run(), one switch over ActionType.
+//
+// Each realized page carries an ActionTable generated with its LVGL
+// objects: a struct of arrays over the page's widgets, with the columns the
+// dispatcher reads for every press (action, key, modifiers, consumer code)
+// packed together and the rarely used DDC parameters, macro steps and
+// typed text in a side table. LVGL user data holds an action_ref() (page and widget index),
+// not a pointer, so a page's table can be regenerated on a partial rebuild
+// while its unchanged buttons live on, and there is no fixed pool to run
+// out of.
+// ============================================================
+
+#define ACTION_TABLE_NONE 0xFF   // ActionTable::action of a widget that isn't a button
+#define ACTION_SOURCE_HW  0xFF   // ActionDesc::page of a hardware button or the encoder push
+#define ACTION_ENTRY_NONE 0xFFFF // ActionDesc::entry of anything but a scroll grid cell
+
+// One action, unpacked for the dispatcher
+struct ActionDesc {
+    uint8_t action;            // ActionType
+    uint8_t keycode;           // HOTKEY keycode, or PAGE_GOTO / PROFILE_GOTO target
+    uint8_t modifiers;
+    uint16_t consumer_code;
+    uint8_t ddc_vcp_code;
+    uint16_t ddc_value;
+    int16_t ddc_adjustment;
+    uint8_t ddc_display;
+    const std::vector<MacroStep> *macro;   // Points into AppConfig, nullptr = none
+    const ConfigStr *text;     // TYPE_TEXT string, likewise
+    uint8_t key_layout;        // TYPE_TEXT host layout (KeyLayout)
+    uint8_t page;              // Source: page index, or ACTION_SOURCE_HW
+    uint8_t widget;            // Widget index, or hardware button slot (0xFF = encoder push)
+    uint16_t entry;            // Scroll grid entry index, or ACTION_ENTRY_NONE
+};
+
+struct ActionTable {
+    struct Extra {
+        uint8_t ddc_vcp_code;
+        uint8_t ddc_display;
+        uint16_t ddc_value;
+        int16_t ddc_adjustment;
+        const std::vector<MacroStep> *macro;
+        const ConfigStr *text;
+        uint8_t key_layout;
+    };
+    uint8_t page = 0;
+    std::vector<uint8_t> action;          // Per widget, ACTION_TABLE_NONE for non-buttons
+    std::vector<uint8_t> keycode;
+    std::vector<uint8_t> modifiers;
+    std::vector<uint16_t> consumer_code;
+    std::vector<uint8_t> extra;           // Index into extras, 0xFF = none
+    std::vector<Extra> extras;            // DDC, macro and type-text buttons only
+};
+
+// LVGL user data for a page widget, and back
+inline void *action_ref(uint8_t page, uint8_t widget) {
+    return (void *)(uintptr_t)(0x10000u | page << 8 | widget);   // Never nullptr
+}
+inline bool action_ref_decode(const void *ref, uint8_t &page, uint8_t &widget) {
+    uintptr_t v = (uintptr_t)ref;
+    if (!(v & 0x10000u)) return false;
+    page = (v >> 8) & 0xFF;
+    widget = v & 0xFF;
+    return true;
+}
+
+// (Re)generate `t` from a page's config. Macro and text pointers follow `page`, so
+// rebuild whenever the AppConfig behind it changes.
+void action_table_build(ActionTable &t, const PageConfig &page, uint8_t page_idx);
+void action_table_clear(ActionTable &t);
+
+// Widget `widget` of the table, false if it has no action
+bool action_table_get(const ActionTable &t, uint8_t widget, ActionDesc &out);
+
+// A hardware button (slot 0-3) or, with slot 0xFF, an action without one
+ActionDesc action_from_hw(const HwButtonConfig &b, uint8_t slot);
+ActionDesc action_simple(uint8_t action, uint8_t keycode, uint16_t consumer_code, uint8_t modifiers);
+
+// Run it. UI task only.
+void action_run(const ActionDesc &a);
+
+// HID output for actions and the encoder: the display's own BLE keyboard
+// (ble_hid.h) while a host is connected to it and the bridge is not (or
+// always, BLE_HID_PREFER), the bridge over ESP-NOW otherwise. UI task only.
+void hid_send_hotkey(uint8_t modifiers, uint8_t keycode);
+void hid_send_media(uint16_t consumer_code);
+void hid_send_macro(const MacroStep *steps, uint8_t count);
+void hid_send_text(const char *utf8, size_t len, uint8_t layout);
@@ -0,0 +1,283 @@
+/**
+ * @file anim_icon.cpp
+ * Animated GIF button icons on a shared decode budget (see anim_icon.h)
+ *
+ * gifdec renders each frame into its own canvas at the source size, in the
+ * same RGB565+alpha layout icon_cache.cpp produces, so a frame is
+ * gd_get_frame() + gd_render_frame() + icon_resample() into the fit size.
+ * The lv_img points at one lv_img_dsc_t per icon; a new frame only moves
+ * its data pointer (the stream buffer or a cached frame) and invalidates
+ * the image's area.
+ */
+
+#include "anim_icon.h"
+#include "icon_cache.h"
+#include "mem_budget.h"
+#include "power.h"
+#include "sdcard.h"
+#include <Arduino.h>
+#include <SD.h>
+#include <algorithm>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define ANIM_PX_BYTES LV_IMG_PX_SIZE_ALPHA_BYTE
+
+struct AnimFrame {
+    uint8_t *px;
+    uint16_t delay_ms;
+};
+
+struct AnimIcon {
+    std::string path;
+    lv_obj_t *img = nullptr;
+    gd_GIF *gif = nullptr;          // Open until the first loop is cached
+    lv_img_dsc_t dsc = {};          // What img shows
+    uint8_t *stream_px = nullptr;   // Scaled frame while decoding (freed once cached)
+    std::vector<AnimFrame> frames;  // First loop as decoded; complete once gif is closed
+    uint32_t clip_bytes = 0;
+    bool caching = false;           // Still keeping decoded frames
+    uint16_t cur = 0;               // Position in frames once cached
+    uint16_t delay_ms = 0;          // Of the frame on screen
+    uint32_t shown_at = 0;          // millis() it went up (kept current while paused)
+};
+
+static AnimIcon icons[ANIM_ICON_MAX];
+static uint8_t live = 0;
+static uint8_t next_start = 0;      // First slot looked at next pass (round robin under the budget)
+static uint32_t cache_bytes = 0;
+static uint8_t last_running = 0;
+static uint32_t decoded_total = 0, deferred_total = 0, decode_max_us = 0;
+
+bool anim_icon_matches(const char *path) {
+    size_t n = path ? strlen(path) : 0;
+    return n > 4 && strcasecmp(path + n - 4, ".gif") == 0;
+}
+
+// Logical screen size from the GIF header, before gifdec allocates for it
+static bool gif_size(const char *path, uint16_t *w, uint16_t *h) {
+    File f = SD.open(path, FILE_READ);
+    if (!f) return false;
+    uint8_t hdr[10];
+    bool ok = f.read(hdr, sizeof(hdr)) == sizeof(hdr) && memcmp(hdr, "GIF8", 4) == 0;
+    f.close();
+    if (!ok) return false;
+    *w = hdr[6] | (hdr[7] << 8);
+    *h = hdr[8] | (hdr[9] << 8);
+    return *w && *h;
+}
+
+// GCE delay (1/100 s) in ms: 0-1 means "as fast as possible", which
+// browsers play at 100 ms
+static uint16_t frame_delay_ms(uint16_t cs) {
+    if (cs < 2) return 100;
+    uint32_t ms = (uint32_t)cs * 10;
+    if (ms < ANIM_ICON_MIN_FRAME_MS) ms = ANIM_ICON_MIN_FRAME_MS;
+    return ms > 0xFFFF ? 0xFFFF : (uint16_t)ms;
+}
+
+static size_t frame_bytes(const AnimIcon &a) {
+    return (size_t)a.dsc.header.w * a.dsc.header.h * ANIM_PX_BYTES;
+}
+
+static void show(AnimIcon &a, uint8_t *px, uint16_t delay_ms) {
+    a.dsc.data = px;
+    lv_img_cache_invalidate_src(&a.dsc);   // Keyed by the descriptor, not the pixels
+    lv_obj_invalidate(a.img);
+    a.delay_ms = delay_ms;
+}
+
+static void drop_frames(AnimIcon &a) {
+    for (auto &f : a.frames) mem_free(MEM_POOL_IMAGES, f.px);
+    a.frames.clear();
+    cache_bytes -= a.clip_bytes;
+    a.clip_bytes = 0;
+}
+
+static void close_gif(AnimIcon &a) {
+    if (a.gif) gd_close_gif(a.gif);
+    a.gif = nullptr;
+}
+
+// The loop just decoded is all in frames: play from them from now on
+static void finish_caching(AnimIcon &a) {
+    close_gif(a);
+    a.caching = false;
+    a.cur = 0;
+    show(a, a.frames[0].px, a.frames[0].delay_ms);
+    mem_free(MEM_POOL_IMAGES, a.stream_px);
+    a.stream_px = nullptr;
+    Serial.printf("[anim] %s: %u frame(s) cached (%lu KB)\n", a.path.c_str(), (unsigned)a.frames.size(),
+                  (unsigned long)(a.clip_bytes / 1024));
+}
+
+// Next frame into the stream buffer or, on the first loop, a new cached
+// frame. False when the GIF turned out corrupt (the icon stops where it is).
+static bool decode_next(AnimIcon &a) {
+    int r = gd_get_frame(a.gif);
+    if (r == 0) {   // End of the loop
+        if (a.caching && !a.frames.empty()) {
+            finish_caching(a);
+            return true;
+        }
+        gd_rewind(a.gif);
+        r = gd_get_frame(a.gif);
+    }
+    if (r <= 0) {
+        close_gif(a);
+        return false;
+    }
+    gd_render_frame(a.gif, a.gif->canvas);
+    uint16_t delay = frame_delay_ms(a.gif->gce.delay);
+
+    uint8_t *dst = a.stream_px;
+    if (a.caching) {
+        size_t bytes = frame_bytes(a);
+        uint8_t *px = nullptr;
+        if (a.clip_bytes + bytes <= ANIM_ICON_CLIP_BYTES && cache_bytes + bytes <= ANIM_ICON_CACHE_BYTES) {
+            px = (uint8_t *)mem_alloc(MEM_POOL_IMAGES, bytes);
+        }
+        if (px) {
+            a.frames.push_back({px, delay});
+            a.clip_bytes += bytes;
+            cache_bytes += bytes;
+            dst = px;
+        } else {
+            // Too long (or no room) to keep: streamed from here on
+            a.caching = false;
+            drop_frames(a);
+        }
+    }
+    icon_resample(a.gif->canvas, a.gif->width, a.gif->height, true, dst, a.dsc.header.w, a.dsc.header.h);
+    show(a, dst, delay);
+    return true;
+}
+
+static void release(AnimIcon &a) {
+    lv_img_cache_invalidate_src(&a.dsc);
+    close_gif(a);
+    drop_frames(a);
+    mem_free(MEM_POOL_IMAGES, a.stream_px);
+    a = AnimIcon();
+    live--;
+}
+
+static void img_delete_cb(lv_event_t *e) {
+    release(*(AnimIcon *)lv_event_get_user_data(e));
+}
+
+lv_obj_t *anim_icon_create(lv_obj_t *parent, const char *path, uint16_t max_w, uint16_t max_h) {
+    if (!anim_icon_matches(path) || !max_w || !max_h || !sdcard_mounted()) return nullptr;
+    AnimIcon *slot = nullptr;
+    for (auto &a : icons) {
+        if (!a.img) {
+            slot = &a;
+            break;
+        }
+    }
+    if (!slot) {
+        Serial.printf("[anim] %s: all %d animated icon slots in use\n", path, ANIM_ICON_MAX);
+        return nullptr;
+    }
+    uint16_t sw, sh;
+    if (!gif_size(path, &sw, &sh)) return nullptr;
+    if ((uint32_t)sw * sh > ANIM_ICON_MAX_SRC_PX) {
+        Serial.printf("[anim] %s: %ux%u is too large for an icon\n", path, sw, sh);
+        return nullptr;
+    }
+
+    uint32_t t0 = millis();
+    std::string src = std::string("S:") + path;
+    AnimIcon &a = *slot;
+    a.path = path;
+    a.gif = gd_open_gif_file(src.c_str());
+    if (!a.gif) {
+        a = AnimIcon();
+        return nullptr;
+    }
+    uint16_t w, h;
+    icon_fit_size(a.gif->width, a.gif->height, max_w, max_h, &w, &h);
+    a.dsc.header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+    a.dsc.header.w = w;
+    a.dsc.header.h = h;
+    a.dsc.data_size = frame_bytes(a);
+    a.stream_px = (uint8_t *)mem_alloc(MEM_POOL_IMAGES, a.dsc.data_size);
+    a.caching = true;
+    a.img = lv_img_create(parent);   // Before the first show(): it invalidates the image
+    live++;
+    if (!a.stream_px || !decode_next(a)) {
+        lv_obj_del(a.img);   // No callback yet: release by hand
+        release(a);
+        return nullptr;
+    }
+    lv_img_set_src(a.img, &a.dsc);
+    lv_obj_add_event_cb(a.img, img_delete_cb, LV_EVENT_DELETE, &a);
+    a.shown_at = millis();
+    Serial.printf("[anim] %s %ux%u (source %ux%u) in %lums\n", path, w, h, sw, sh,
+                  (unsigned long)(millis() - t0));
+    return a.img;
+}
+
+uint32_t anim_icon_update() {
+    last_running = 0;
+    if (!live) return UINT32_MAX;
+
+    // DIMMED / CLOCK and the battery policy freeze every icon on its frame
+    bool allowed = power_get_state() == POWER_ACTIVE && power_animations_enabled();
+    uint32_t now = millis();
+    uint32_t wait = UINT32_MAX;
+    uint32_t spent_us = 0;
+    int first_deferred = -1;
+    for (int k = 0; k < ANIM_ICON_MAX; k++) {
+        int i = (next_start + k) % ANIM_ICON_MAX;
+        AnimIcon &a = icons[i];
+        if (!a.img || (!a.gif && a.frames.size() < 2)) continue;   // Free slot, still image or broken GIF
+        if (!allowed || !lv_obj_is_visible(a.img)) {
+            a.shown_at = now;   // Hidden page, other screen: resume with a full frame delay
+            continue;
+        }
+        last_running++;
+        uint32_t elapsed = now - a.shown_at;
+        if (elapsed < a.delay_ms) {
+            wait = std::min(wait, (uint32_t)(a.delay_ms - elapsed));
+            continue;
+        }
+        if (a.gif) {
+            if (spent_us >= ANIM_DECODE_BUDGET_US) {
+                deferred_total++;
+                if (first_deferred < 0) first_deferred = i;
+                wait = 0;
+                continue;
+            }
+            uint32_t t0 = micros();
+            decode_next(a);
+            uint32_t us = micros() - t0;
+            spent_us += us;
+            decoded_total++;
+            if (us > decode_max_us) decode_max_us = us;
+        } else {
+            a.cur = (a.cur + 1) % a.frames.size();
+            show(a, a.frames[a.cur].px, a.frames[a.cur].delay_ms);
+        }
+        a.shown_at = now;
+        wait = std::min(wait, (uint32_t)a.delay_ms);
+    }
+    // Whoever the budget cut off goes first next pass
+    next_start = first_deferred >= 0 ? first_deferred : (next_start + 1) % ANIM_ICON_MAX;
+    return wait;
+}
+
+void anim_icon_get_stats(AnimIconStats &out) {
+    out = AnimIconStats();
+    for (const auto &a : icons) {
+        if (!a.img) continue;
+        out.icons++;
+        if (!a.gif && !a.frames.empty()) out.cached++;
+    }
+    out.running = last_running;
+    out.cache_bytes = cache_bytes;
+    out.decoded = decoded_total;
+    out.deferred = deferred_total;
+    out.decode_max_us = decode_max_us;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <lvgl.h>
+#include <stdint.h>
+
+// ============================================================
+// Animated button icons (GIF)
+//
+// An icon_path ending in .gif gets an lv_img whose frames come from LVGL's
+// gifdec, scaled to the icon box like icon_cache.h does for stills. Frames
+// are advanced by anim_icon_update() from the main loop, not by an LVGL
+// timer per image, so every animated icon shares one decode budget:
+//
+//   - Decoding (gifdec + resample) stops for the pass once the icons have
+//     used ANIM_DECODE_BUDGET_US; the rest show their frame a pass late.
+//     A page full of GIFs plays slower instead of dropping UI frames.
+//   - The first loop of a small icon is kept: each scaled frame goes into
+//     the images pool as it is decoded, and once the loop completes the GIF
+//     is closed and later loops only swap the pointer. Icons whose frames
+//     exceed ANIM_ICON_CLIP_BYTES (or the ANIM_ICON_CACHE_BYTES total) stay
+//     streamed.
+//   - Nothing advances while the image isn't visible (hidden page, other
+//     screen), outside POWER_ACTIVE, or when the battery policy turns
+//     animations off; icons resume from where they stopped.
+//
+// Frame delays below 20 ms are played at 100 ms (as browsers do), and no
+// icon runs faster than ANIM_ICON_MIN_FRAME_MS.
+// ============================================================
+
+#ifndef ANIM_ICON_MAX
+#define ANIM_ICON_MAX 32                      // Animated icons realized at once
+#endif
+#ifndef ANIM_DECODE_BUDGET_US
+#define ANIM_DECODE_BUDGET_US 4000            // Decode time per loop pass, all icons together
+#endif
+#ifndef ANIM_ICON_CLIP_BYTES
+#define ANIM_ICON_CLIP_BYTES (192 * 1024)     // Largest pre-decoded loop of one icon
+#endif
+#ifndef ANIM_ICON_CACHE_BYTES
+#define ANIM_ICON_CACHE_BYTES (1024 * 1024)   // All pre-decoded loops together
+#endif
+#define ANIM_ICON_MIN_FRAME_MS 33
+#define ANIM_ICON_MAX_SRC_PX   (320 * 320)    // gifdec keeps 4 bytes per source pixel
+
+struct AnimIconStats {
+    uint8_t icons;          // Live animated icons
+    uint8_t cached;         // ... playing from pre-decoded frames
+    uint8_t running;        // ... advanced on the last pass (visible, not paused)
+    uint32_t cache_bytes;   // Pre-decoded frames, all icons
+    uint32_t decoded;       // Frames decoded since boot
+    uint32_t deferred;      // Due frames pushed to a later pass by the budget
+    uint32_t decode_max_us; // Slowest single frame decode
+};
+
+// GIF source: handled here rather than by icon_cache_acquire()
+bool anim_icon_matches(const char *path);
+
+// lv_img child of `parent` showing `path` scaled to fit max_w x max_h, first
+// frame decoded; freed with the image. nullptr when the file is missing,
+// too large, not a GIF, or all ANIM_ICON_MAX slots are taken.
+lv_obj_t *anim_icon_create(lv_obj_t *parent, const char *path, uint16_t max_w, uint16_t max_h);
+
+// Advance due frames within the decode budget. Returns ms until the next
+// frame is due (UINT32_MAX when nothing animates). Main loop, UI lock held.
+uint32_t anim_icon_update();
+
+void anim_icon_get_stats(AnimIconStats &out);
@@ -1,5 +1,6 @@
 #include "battery.h"
-#include "touch.h"   // i2c_take() / i2c_give()
+#include "i2c_bus.h"
+#include "tasks.h"
 
 #include <Arduino.h>
 #include <SparkFun_MAX1704x_Fuel_Gauge_Arduino_Library.h>
@@ -7,21 +8,62 @@
 static SFE_MAX1704X lipo(MAX1704X_MAX17048);
 static bool fuel_gauge_present = false;
 
+// Read in flight: filled by the bus job, handed over by the UI call
+static volatile bool read_busy = false;
+static BatteryDoneFn read_done = nullptr;
+static BatteryState read_state = {0xFF, 0.0f, 0.0f, false};
+
+// Low threshold to program with the next job (0 = nothing pending)
+static volatile uint8_t pending_threshold = 0;
+
+// battery_update() scheduling (UI task)
+static uint32_t last_read_ms = 0;
+static uint32_t last_poll_ms = 0;
+static bool first_read_done = false;
+
 // ============================================================
-// battery_init() -- probe MAX17048 on shared I2C bus
+// Alerts -- bus job context
 // ============================================================
-bool battery_init() {
-    if (!i2c_take(50)) {
-        Serial.println("[battery] Failed to acquire I2C mutex for init");
-        return false;
-    }
+static void apply_threshold() {
+    uint8_t pct = pending_threshold;
+    if (!pct) return;
+    pending_threshold = 0;
+    lipo.setThreshold(pct);
+}
+
+// Acknowledge SOC-change / low flags and release ALRT
+static void clear_alerts() {
+    lipo.isChange(true);
+    lipo.isLow(true);
+    lipo.clearAlert();
+}
 
+// ============================================================
+// battery_init() -- probe MAX17048 on shared I2C bus
+// ============================================================
+static bool probe_job(void *) {
     fuel_gauge_present = lipo.begin();
+    if (!fuel_gauge_present) return true;
+    lipo.enableSOCAlert();   // CONFIG.ALSC: alert on each 1% SOC change
+    apply_threshold();
+    clear_alerts();
+    return true;
+}
+
+// Benchmark probe: one register read, as every battery poll does
+static bool bench_job(void *) {
+    lipo.getVoltage();
+    return true;
+}
 
-    i2c_give();
+bool battery_init() {
+    if (!pending_threshold) pending_threshold = 15;
+    i2c_run(I2C_DEV_MAX17048, I2C_PRIO_BACKGROUND, probe_job);
+    if (fuel_gauge_present) i2c_register_probe(I2C_DEV_MAX17048, bench_job);
 
     if (fuel_gauge_present) {
-        Serial.println("[battery] MAX17048 fuel gauge detected");
+        Serial.printf("[battery] MAX17048 fuel gauge detected, SOC alerts %s\n",
+                      BATTERY_ALERT_GPIO >= 0 ? "on ALRT" : "polled");
     } else {
         Serial.println("[battery] No fuel gauge found -- battery unavailable");
     }
@@ -29,24 +71,111 @@ bool battery_init() {
     return fuel_gauge_present;
 }
 
+bool battery_present() {
+    return fuel_gauge_present;
+}
+
+void battery_set_low_threshold(uint8_t percent) {
+    if (percent == 0) return;
+    pending_threshold = percent < 1 ? 1 : percent > 32 ? 32 : percent;
+}
+
 // ============================================================
-// battery_read() -- read SOC + voltage (mutex-protected)
+// battery_request() -- SOC + voltage + rate as one bus job
 // ============================================================
-BatteryState battery_read() {
-    if (!fuel_gauge_present) {
-        return {0xFF, 0.0f, false};
+static bool read_job(void *) {
+    apply_threshold();
+    clear_alerts();   // Before reading: a step during the read raises a new alert
+    float voltage = lipo.getVoltage();
+    float soc     = lipo.getSOC();
+    float rate    = lipo.getChangeRate();
+    if (voltage <= 0.0f) {   // The library reads 0 on a failed transaction
+        read_state = {0xFF, 0.0f, 0.0f, false};
+        return false;
     }
+    read_state = {(uint8_t)constrain((int)soc, 0, 100), voltage, rate, true};
+    return true;
+}
+
+static void deliver(uint32_t) {
+    BatteryState state = read_state;
+    BatteryDoneFn done = read_done;
+    read_busy = false;
+    if (done) done(state);
+}
 
-    if (!i2c_take(50)) {
-        // Could not acquire bus -- return stale unavailable rather than block
-        return {0xFF, 0.0f, false};
+static void read_finished(void *, bool) {
+    if (!ui_post(deliver)) read_busy = false;
+}
+
+bool battery_request(BatteryDoneFn done) {
+    if (!fuel_gauge_present) {
+        if (done) done({0xFF, 0.0f, 0.0f, false});
+        return true;
     }
+    if (read_busy) return false;
+    read_busy = true;
+    read_done = done;
+    if (!i2c_submit(I2C_DEV_MAX17048, I2C_PRIO_BACKGROUND, read_job, nullptr, read_finished)) {
+        read_busy = false;
+        return false;
+    }
+    return true;
+}
 
-    float voltage = lipo.getVoltage();
-    float soc     = lipo.getSOC();
+// ============================================================
+// battery_update() -- read on alert / fallback
+// ============================================================
+// Polled alert flag: a full read in the same job only if it is set
+static volatile bool poll_alerted = false;
 
-    i2c_give();
+static bool poll_job(void *) {
+    apply_threshold();
+    poll_alerted = lipo.getAlert();
+    return !poll_alerted || read_job(nullptr);
+}
+
+static void poll_finished(void *, bool ok) {
+    if (poll_alerted) read_finished(nullptr, ok);
+    else read_busy = false;
+}
+
+static bool start_read(BatteryDoneFn done, uint32_t now) {
+    if (!battery_request(done)) return false;
+    last_read_ms = last_poll_ms = now;
+    first_read_done = true;
+    return true;
+}
+
+static uint32_t ms_left(uint32_t since, uint32_t period, uint32_t now) {
+    uint32_t elapsed = now - since;
+    return elapsed >= period ? 0 : period - elapsed;
+}
 
-    uint8_t percent = constrain((int)soc, 0, 100);
-    return {percent, voltage, true};
+uint32_t battery_update(bool alert, BatteryDoneFn done) {
+    uint32_t now = millis();
+    if (!fuel_gauge_present) {
+        // One "unavailable" result so the status bar shows no gauge
+        if (!first_read_done) start_read(done, now);
+        return UINT32_MAX;
+    }
+
+    if (!first_read_done || alert || now - last_read_ms >= BATTERY_FALLBACK_MS) {
+        if (!start_read(done, now)) return 100;   // Previous job still in flight
+    } else if (BATTERY_ALERT_GPIO < 0 && now - last_poll_ms >= BATTERY_POLL_MS) {
+        if (read_busy) return 100;
+        last_poll_ms = now;
+        read_busy = true;
+        read_done = done;
+        if (!i2c_submit(I2C_DEV_MAX17048, I2C_PRIO_BACKGROUND, poll_job, nullptr, poll_finished)) {
+            read_busy = false;
+        }
+    }
+
+    uint32_t due = ms_left(last_read_ms, BATTERY_FALLBACK_MS, now);
+    if (BATTERY_ALERT_GPIO < 0) {
+        uint32_t poll_due = ms_left(last_poll_ms, BATTERY_POLL_MS, now);
+        if (poll_due < due) due = poll_due;
+    }
+    return due;
 }
@@ -4,8 +4,39 @@
 struct BatteryState {
     uint8_t percent;    // 0-100, or 0xFF if unavailable
     float   voltage;    // Volts (e.g., 3.85), 0.0 if unavailable
+    float   rate_pct_h; // SOC change rate (CRATE), %/hour, negative while discharging
     bool    available;  // false if no fuel gauge detected
 };
 
-bool battery_init();            // Init MAX17048 on I2C bus (mutex-protected). Returns true if found.
-BatteryState battery_read();    // Read current state (mutex-protected). Call every 10-30s, not every loop.
+// The MAX17048 is set to raise ALRT on every 1% SOC step and when SOC
+// drops below the low threshold, so the gauge is only read when something
+// changed. With ALRT wired to a GPIO (open drain, active low) the alert is
+// an event; otherwise only the CONFIG register is polled, one 2-byte read.
+// A full read also happens every BATTERY_FALLBACK_MS for voltage and rate.
+#ifndef BATTERY_ALERT_GPIO
+#define BATTERY_ALERT_GPIO -1
+#endif
+#ifndef BATTERY_POLL_MS
+#define BATTERY_POLL_MS 30000       // Alert flag check when ALRT isn't wired
+#endif
+#ifndef BATTERY_FALLBACK_MS
+#define BATTERY_FALLBACK_MS 300000  // Full read at least this often
+#endif
+
+bool battery_init();            // Probe MAX17048 and arm its alerts (setup, inline bus job). Returns true if found.
+bool battery_present();         // Fuel gauge found by battery_init()
+
+// Low-SOC alert threshold (1-32%, the gauge's range; 0 = leave as is).
+// Applied with the next bus job.
+void battery_set_low_threshold(uint8_t percent);
+
+// Queue a gauge read on the I2C bus at background priority and return at
+// once; `done` gets the result on the UI task (ui_post). False while the
+// previous read is still in flight.
+typedef void (*BatteryDoneFn)(const BatteryState &state);
+bool battery_request(BatteryDoneFn done);
+
+// UI task, every loop pass: reads the gauge when the alert fired (`alert`
+// = EVT_BATTERY_ALERT seen), when the polled alert flag is set or when the
+// fallback interval is up. Returns the ms until it must run again.
+uint32_t battery_update(bool alert, BatteryDoneFn done);
@@ -0,0 +1,182 @@
+/**
+ * @file bench.cpp
+ * Latency benchmark: synthetic presses through radio, bridge HID scheduler and host
+ *
+ * Probes go out as reliable ESP-NOW frames like any keystroke. In rate mode
+ * they fire on a fixed micros() schedule; in flood mode (rate 0) a new one
+ * goes out whenever fewer than BENCH_WINDOW are in flight, so the achieved
+ * echoes/s is the throughput ceiling of the slowest stage. A probe with no
+ * echo for BENCH_STALL_MS is written off so a lost frame can't stall the
+ * window.
+ */
+
+#include "bench.h"
+#include "espnow_link.h"
+#include "protocol.h"
+#include <Arduino.h>
+#include <algorithm>
+#include <esp_heap_caps.h>
+#include <string.h>
+
+#define BENCH_DRAIN_MS  2000   // Wait for stragglers after the last probe
+#define BENCH_STALL_MS  500    // Flood mode: no echo for this long -> presumed lost
+#define BENCH_MAX_RATE  1000
+
+static const char *const STAGE_NAMES[BENCH_STAGES] = { "radio", "hid_queue", "usb", "host", "total" };
+
+static bool active = false;
+static uint16_t rate_hz = 0;
+static uint16_t count = 0;
+static uint16_t sent = 0;
+static uint16_t received = 0;
+static uint16_t written_off = 0;
+static uint16_t id_base = 0;               // First probe id of this run
+static uint32_t period_us = 0;
+static uint32_t next_fire_us = 0;
+static uint32_t start_us = 0;
+static uint32_t last_echo_us = 0;
+static uint32_t last_progress_ms = 0;      // Last send or echo
+static uint32_t *samples[BENCH_STAGES] = {};  // count entries per stage, PSRAM
+
+static uint16_t outstanding() {
+    int n = (int)sent - received - written_off;   // A written-off probe may still echo
+    return n > 0 ? (uint16_t)n : 0;
+}
+
+static void free_samples() {
+    for (int i = 0; i < BENCH_STAGES; i++) {
+        free(samples[i]);
+        samples[i] = nullptr;
+    }
+}
+
+bool bench_active() {
+    return active;
+}
+
+bool bench_start(uint16_t rate, uint16_t n) {
+    if (active || n == 0) return false;
+    if (n > BENCH_MAX_PROBES) n = BENCH_MAX_PROBES;
+    if (rate > BENCH_MAX_RATE) rate = BENCH_MAX_RATE;
+    for (int i = 0; i < BENCH_STAGES; i++) {
+        samples[i] = (uint32_t *)ps_malloc(n * sizeof(uint32_t));
+        if (!samples[i]) {
+            free_samples();
+            Serial.println("BENCH: out of memory");
+            return false;
+        }
+    }
+    id_base += count;   // Late echoes from the previous run fall outside this one
+    rate_hz = rate;
+    count = n;
+    sent = received = written_off = 0;
+    period_us = rate ? 1000000u / rate : 0;
+    start_us = next_fire_us = micros();
+    last_progress_ms = millis();
+    active = true;
+    Serial.printf("BENCH: %u probes at %s%u Hz\n", n, rate ? "" : "flood, window ", rate ? rate : BENCH_WINDOW);
+    return true;
+}
+
+static bool fire_probe() {
+    BenchProbeMsg probe = {};
+    probe.id = id_base + sent;
+    probe.display_us = micros();
+    if (!espnow_send_reliable(MSG_BENCH_PROBE, (const uint8_t *)&probe, sizeof(probe))) return false;
+    sent++;
+    last_progress_ms = millis();
+    return true;
+}
+
+void bench_on_echo(const uint8_t *payload, uint8_t len) {
+    if (!active || len < sizeof(BenchEchoMsg)) return;
+    uint32_t now = micros();
+    BenchEchoMsg echo;
+    memcpy(&echo, payload, sizeof(echo));
+    const BenchProbeMsg &p = echo.probe;
+    if ((uint16_t)(p.id - id_base) >= sent || received >= count) return;
+
+    // Each difference stays within one unit's clock
+    uint32_t total = now - p.display_us;
+    uint32_t bridge_span = echo.bridge_echo_us - p.bridge_rx_us;
+    uint32_t after_hid = echo.bridge_echo_us - p.bridge_hid_us;
+    uint16_t i = received++;
+    samples[BENCH_STAGE_RADIO][i] = total > bridge_span ? total - bridge_span : 0;
+    samples[BENCH_STAGE_HID_QUEUE][i] = p.bridge_hid_us - p.bridge_rx_us;
+    samples[BENCH_STAGE_USB][i] = after_hid > echo.host_us ? after_hid - echo.host_us : 0;
+    samples[BENCH_STAGE_HOST][i] = echo.host_us;
+    samples[BENCH_STAGE_TOTAL][i] = total;
+    last_echo_us = now;
+    last_progress_ms = millis();
+}
+
+static uint32_t percentile(uint32_t *v, uint16_t n, int pct) {
+    if (n == 0) return 0;
+    return v[(uint32_t)(n - 1) * pct / 100];
+}
+
+static void finish() {
+    active = false;
+
+    BenchReportMsg rep = {};
+    rep.rate_hz = rate_hz;
+    rep.sent = sent;
+    rep.received = received;
+    rep.elapsed_ms = received ? (last_echo_us - start_us) / 1000 : 0;
+    rep.throughput_x10 = rep.elapsed_ms ? (uint16_t)std::min<uint32_t>((uint32_t)received * 10000u / rep.elapsed_ms, 0xFFFF) : 0;
+    for (int s = 0; s < BENCH_STAGES; s++) {
+        std::sort(samples[s], samples[s] + received);
+        rep.p50_us[s] = percentile(samples[s], received, 50);
+        rep.p99_us[s] = percentile(samples[s], received, 99);
+    }
+    free_samples();
+
+    Serial.printf("BENCH: %u/%u echoed in %lu ms, %u.%u/s\n", received, sent,
+                  (unsigned long)rep.elapsed_ms, rep.throughput_x10 / 10, rep.throughput_x10 % 10);
+    for (int s = 0; s < BENCH_STAGES; s++) {
+        Serial.printf("BENCH: %-9s p50=%6luus p99=%6luus\n", STAGE_NAMES[s],
+                      (unsigned long)rep.p50_us[s], (unsigned long)rep.p99_us[s]);
+    }
+    espnow_send_reliable(MSG_BENCH_REPORT, (const uint8_t *)&rep, sizeof(rep));
+}
+
+uint32_t bench_update() {
+    if (!active) return UINT32_MAX;
+    uint32_t now_ms = millis();
+
+    if (sent < count) {
+        if (rate_hz == 0) {
+            if (outstanding() >= BENCH_WINDOW && now_ms - last_progress_ms >= BENCH_STALL_MS) {
+                written_off++;
+                last_progress_ms = now_ms;
+            }
+            while (sent < count && outstanding() < BENCH_WINDOW) {
+                if (!fire_probe()) return 1;   // TX queue full: try again shortly
+            }
+            if (sent < count) {
+                uint32_t idle = millis() - last_progress_ms;
+                return idle < BENCH_STALL_MS ? BENCH_STALL_MS - idle : 0;
+            }
+        } else {
+            uint32_t now_us = micros();
+            if ((int32_t)(now_us - next_fire_us) >= 0) {
+                if (!fire_probe()) return 1;
+                next_fire_us += period_us;
+                // Fell more than a few periods behind (e.g. long render): don't burst to catch up
+                if ((int32_t)(now_us - next_fire_us) > (int32_t)(4 * period_us)) next_fire_us = now_us + period_us;
+            }
+            if (sent < count) {
+                uint32_t remaining = next_fire_us - micros();
+                return (int32_t)remaining > 0 ? (remaining + 999) / 1000 : 0;
+            }
+        }
+    }
+
+    // All sent: wait for the echoes, then report
+    uint32_t idle = millis() - last_progress_ms;
+    if (received + written_off >= count || idle >= BENCH_DRAIN_MS) {
+        finish();
+        return UINT32_MAX;
+    }
+    return BENCH_DRAIN_MS - idle;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+
+// ============================================================
+// End-to-end latency benchmark (MSG_BENCH_*, see protocol.h)
+//
+// Started by the companion (hotkey_companion.py --bench). Fires synthetic
+// presses, collects the per-hop timestamps from their echoes and reports
+// p50/p99 per stage plus the achieved throughput, both on serial and back
+// to the companion as MSG_BENCH_REPORT.
+// ============================================================
+
+// Begin a run. Ignored (returns false) while one is already going.
+bool bench_start(uint16_t rate_hz, uint16_t count);
+
+// MSG_BENCH_ECHO from the main loop
+void bench_on_echo(const uint8_t *payload, uint8_t len);
+
+// Fire due probes, finish the run once drained. Returns ms until the next
+// probe/deadline (UINT32_MAX when idle). Call every loop() pass.
+uint32_t bench_update();
+
+bool bench_active();
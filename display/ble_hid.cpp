@@ -0,0 +1,388 @@
+/**
+ * @file ble_hid.cpp
+ * NimBLE HID keyboard + consumer control, the bridge-less HID transport
+ *
+ * Every key goes through one step queue in MacroOp terms: a hotkey is a
+ * single TAP, a media key a single MEDIA, a macro its own steps. Taps are
+ * pressed at once, from the UI task that ran the action, and released
+ * BLE_HID_HOLD_MS later by ble_hid_update(); the next step waits as long
+ * again so hosts see distinct presses. Key state is a modifier byte plus
+ * a bitmap of held usages, sent as one 6KRO report, like the bridge's
+ * USB keyboard.
+ *
+ * NimBLE callbacks run on its host task and only set flags and times;
+ * reports and parameter requests go out from the UI task.
+ */
+
+#include "ble_hid.h"
+
+#if BLE_HID_ENABLE
+
+#include <Arduino.h>
+#include <NimBLEDevice.h>
+#include <NimBLEHIDDevice.h>
+#include "hid_keys.h"
+#include "log.h"
+#include "trace.h"
+
+#define REPORT_ID_KEYBOARD 1
+#define REPORT_ID_CONSUMER 2
+#define QUEUE_LEN 64            // Power of two; holds a whole MACRO_MAX_STEPS macro
+#define KEY_ERR_ROLLOVER 0x01   // More than six keys down
+
+static_assert((QUEUE_LEN & (QUEUE_LEN - 1)) == 0, "QUEUE_LEN must be a power of two");
+
+static const uint8_t REPORT_MAP[] = {
+    0x05, 0x01,                    // Usage Page (Generic Desktop)
+    0x09, 0x06,                    // Usage (Keyboard)
+    0xA1, 0x01,                    // Collection (Application)
+    0x85, REPORT_ID_KEYBOARD,      //   Report ID
+    0x05, 0x07,                    //   Usage Page (Keyboard/Keypad)
+    0x19, 0xE0, 0x29, 0xE7,        //   Usage Min/Max: left ctrl .. right GUI
+    0x15, 0x00, 0x25, 0x01,        //   Logical 0..1
+    0x75, 0x01, 0x95, 0x08,        //   8 x 1 bit
+    0x81, 0x02,                    //   Input (Data, Var, Abs): modifier byte
+    0x75, 0x08, 0x95, 0x01,
+    0x81, 0x01,                    //   Input (Const): reserved byte
+    0x05, 0x08,                    //   Usage Page (LEDs)
+    0x19, 0x01, 0x29, 0x05,        //   Num lock .. Kana
+    0x75, 0x01, 0x95, 0x05,
+    0x91, 0x02,                    //   Output (Data, Var, Abs): LED bits
+    0x75, 0x03, 0x95, 0x01,
+    0x91, 0x01,                    //   Output (Const): padding
+    0x05, 0x07,                    //   Usage Page (Keyboard/Keypad)
+    0x19, 0x00, 0x29, 0x7F,        //   Every usage an Arduino keycode can name
+    0x15, 0x00, 0x25, 0x7F,
+    0x75, 0x08, 0x95, 0x06,        //   6 x 8 bit
+    0x81, 0x00,                    //   Input (Data, Array): keys
+    0xC0,                          // End Collection
+    0x05, 0x0C,                    // Usage Page (Consumer)
+    0x09, 0x01,                    // Usage (Consumer Control)
+    0xA1, 0x01,                    // Collection (Application)
+    0x85, REPORT_ID_CONSUMER,      //   Report ID
+    0x19, 0x00, 0x2A, 0xFF, 0x03,  //   Usage Min/Max 0..0x3FF
+    0x15, 0x00, 0x26, 0xFF, 0x03,  //   Logical 0..0x3FF
+    0x75, 0x10, 0x95, 0x01,        //   1 x 16 bit
+    0x81, 0x00,                    //   Input (Data, Array): usage
+    0xC0,                          // End Collection
+};
+
+struct __attribute__((packed)) KeyboardReport {
+    uint8_t modifiers;
+    uint8_t reserved;
+    uint8_t keys[6];
+};
+
+static NimBLEServer *server = nullptr;
+static NimBLEHIDDevice *hid = nullptr;
+static NimBLECharacteristic *kbd_input = nullptr;
+static NimBLECharacteristic *consumer_input = nullptr;
+
+// Host task -> UI task
+static volatile uint16_t conn_handle = BLE_HS_CONN_HANDLE_NONE;
+static volatile bool params_due = false;     // New connection: request parameters
+static volatile uint32_t notify_start_us = 0;
+
+static bool fast = false;                    // Parameters last requested
+
+// Key state
+static uint8_t key_mods = 0;
+static uint8_t key_bits[16];
+
+// Step queue (MacroOp) and the player's wait
+static MacroStep queue[QUEUE_LEN];
+static uint8_t q_head = 0, q_tail = 0;
+enum Release : uint8_t { RELEASE_NONE, RELEASE_KEY, RELEASE_MEDIA };
+static Release release_due = RELEASE_NONE;   // Tap in progress: release when the wait ends
+static uint8_t release_mods = 0, release_key = 0;
+static bool waiting = false;
+static uint32_t wait_until_ms = 0;
+
+static BleHidStats stats;
+static uint64_t tx_sum_us = 0;
+static uint32_t tx_count = 0;
+
+// ============================================================
+// NimBLE callbacks (host task)
+// ============================================================
+
+class ServerCallbacks : public NimBLEServerCallbacks {
+    void onConnect(NimBLEServer *, ble_gap_conn_desc *desc) override {
+        conn_handle = desc->conn_handle;
+        params_due = true;
+    }
+    void onDisconnect(NimBLEServer *) override {
+        conn_handle = BLE_HS_CONN_HANDLE_NONE;   // Advertising restarts by itself
+    }
+};
+
+class ReportCallbacks : public NimBLECharacteristicCallbacks {
+    void onStatus(NimBLECharacteristic *, Status s, int) override {
+        uint32_t start = notify_start_us;
+        if (!start) return;
+        notify_start_us = 0;
+        if (s != SUCCESS_NOTIFY) {
+            stats.failed++;
+            return;
+        }
+        uint32_t us = micros() - start;
+        stats.tx_last_us = us;
+        if (us > stats.tx_max_us) stats.tx_max_us = us;
+        tx_sum_us += us;
+        tx_count++;
+    }
+};
+
+static ServerCallbacks server_callbacks;
+static ReportCallbacks report_callbacks;
+
+// ============================================================
+// Reports
+// ============================================================
+
+static bool notify(NimBLECharacteristic *chr, const uint8_t *data, size_t len) {
+    chr->setValue(data, len);
+    notify_start_us = micros() | 1;
+    chr->notify();
+    stats.reports++;
+    return true;
+}
+
+static void send_keys() {
+    KeyboardReport report = {};
+    report.modifiers = key_mods;
+    uint8_t n = 0;
+    for (int usage = 1; usage <= 0x7F; usage++) {
+        if (!(key_bits[usage >> 3] & (1 << (usage & 7)))) continue;
+        if (n == sizeof(report.keys)) {
+            memset(report.keys, KEY_ERR_ROLLOVER, sizeof(report.keys));
+            break;
+        }
+        report.keys[n++] = (uint8_t)usage;
+    }
+    notify(kbd_input, (const uint8_t *)&report, sizeof(report));
+}
+
+static void send_consumer(uint16_t code) {
+    notify(consumer_input, (const uint8_t *)&code, sizeof(code));
+}
+
+static void key_press(uint8_t modifiers, uint8_t keycode) {
+    key_mods |= modifiers;
+    if (!keycode) return;
+    uint8_t usage, mods;
+    if (!hid_key_lookup(keycode, usage, mods)) {
+        LOG_W("BLE HID: no usage for keycode 0x%02X\n", keycode);
+        return;
+    }
+    key_mods |= mods;
+    if (usage) key_bits[usage >> 3] |= 1 << (usage & 7);
+}
+
+static void key_release(uint8_t modifiers, uint8_t keycode) {
+    uint8_t usage = 0, mods = 0;
+    if (keycode && hid_key_lookup(keycode, usage, mods) && usage) {
+        key_bits[usage >> 3] &= ~(1 << (usage & 7));
+    }
+    key_mods &= ~(modifiers | mods);
+}
+
+static void key_release_all() {
+    key_mods = 0;
+    memset(key_bits, 0, sizeof(key_bits));
+}
+
+// ============================================================
+// Step player
+// ============================================================
+
+static void wait_for(uint32_t now, uint32_t ms) {
+    waiting = true;
+    wait_until_ms = now + ms;
+}
+
+static void reset_player() {
+    q_head = q_tail = 0;
+    release_due = RELEASE_NONE;
+    waiting = false;
+    key_release_all();
+}
+
+// Run steps until one has to wait. Returns ms until the next is due.
+static uint32_t run_steps(uint32_t now) {
+    for (;;) {
+        if (waiting) {
+            int32_t left = (int32_t)(wait_until_ms - now);
+            if (left > 0) return (uint32_t)left;
+            waiting = false;
+        }
+        if (release_due != RELEASE_NONE) {
+            if (release_due == RELEASE_KEY) {
+                key_release(release_mods, release_key);
+                send_keys();
+            } else {
+                send_consumer(0);
+            }
+            release_due = RELEASE_NONE;
+            wait_for(now, BLE_HID_HOLD_MS);   // Gap before the next press
+            continue;
+        }
+        if (q_head == q_tail) return UINT32_MAX;
+
+        const MacroStep s = queue[q_tail++ & (QUEUE_LEN - 1)];
+        switch (s.op) {
+            case MACRO_OP_TAP:
+                key_press(s.a, s.b);
+                send_keys();
+                release_due = RELEASE_KEY;
+                release_mods = s.a;
+                release_key = s.b;
+                wait_for(now, BLE_HID_HOLD_MS);
+                break;
+            case MACRO_OP_PRESS:
+                key_press(s.a, s.b);
+                send_keys();
+                break;
+            case MACRO_OP_RELEASE:
+                key_release(s.a, s.b);
+                send_keys();
+                break;
+            case MACRO_OP_RELEASE_ALL:
+                key_release_all();
+                send_keys();
+                break;
+            case MACRO_OP_DELAY:
+                wait_for(now, s.a | s.b << 8);
+                break;
+            case MACRO_OP_MEDIA:
+                send_consumer(s.a | s.b << 8);
+                release_due = RELEASE_MEDIA;
+                wait_for(now, BLE_HID_HOLD_MS);
+                break;
+        }
+    }
+}
+
+static bool enqueue(const MacroStep *steps, uint8_t count) {
+    if (!ble_hid_connected()) return false;
+    if ((uint8_t)(q_head - q_tail) + count > QUEUE_LEN) {
+        LOG_W("BLE HID: queue full, %u steps dropped\n", count);
+        return true;   // Connected but busy: the bridge would not get it there sooner
+    }
+    for (uint8_t i = 0; i < count; i++) queue[q_head++ & (QUEUE_LEN - 1)] = steps[i];
+    run_steps(millis());   // Press now, from the caller's pass
+    return true;
+}
+
+// ============================================================
+// Connection parameters
+// ============================================================
+
+static void request_params(bool want_fast) {
+    uint16_t h = conn_handle;
+    if (h == BLE_HS_CONN_HANDLE_NONE) return;
+    if (want_fast) {
+        server->updateConnParams(h, BLE_HID_FAST_INTERVAL, BLE_HID_FAST_INTERVAL,
+                                 BLE_HID_FAST_LATENCY, BLE_HID_TIMEOUT);
+    } else {
+        server->updateConnParams(h, BLE_HID_IDLE_INTERVAL_MIN, BLE_HID_IDLE_INTERVAL_MAX,
+                                 BLE_HID_IDLE_LATENCY, BLE_HID_TIMEOUT);
+    }
+    fast = want_fast;
+    LOG_D("BLE HID: %s connection parameters requested\n", want_fast ? "fast" : "idle");
+}
+
+// ============================================================
+// Public
+// ============================================================
+
+bool ble_hid_init() {
+    NimBLEDevice::init(BLE_HID_NAME);
+    NimBLEDevice::setSecurityAuth(true, false, true);   // Bonding, no MITM, secure connections
+    NimBLEDevice::setSecurityIOCap(BLE_HS_IO_NO_INPUT_OUTPUT);
+
+    server = NimBLEDevice::createServer();
+    server->setCallbacks(&server_callbacks, false);
+    hid = new NimBLEHIDDevice(server);
+    kbd_input = hid->inputReport(REPORT_ID_KEYBOARD);
+    consumer_input = hid->inputReport(REPORT_ID_CONSUMER);
+    hid->outputReport(REPORT_ID_KEYBOARD);   // LEDs: accepted, not shown
+    kbd_input->setCallbacks(&report_callbacks);
+    consumer_input->setCallbacks(&report_callbacks);
+
+    hid->manufacturer()->setValue("Elecrow");
+    hid->pnp(0x02, 0x303A, 0x8002, 0x0100);   // USB-IF vendor source, Espressif VID
+    hid->hidInfo(0x00, 0x01);                 // Country 0, normally connectable
+    hid->reportMap((uint8_t *)REPORT_MAP, sizeof(REPORT_MAP));
+    hid->startServices();
+    hid->setBatteryLevel(100);
+
+    NimBLEAdvertising *adv = server->getAdvertising();
+    adv->setAppearance(HID_KEYBOARD);
+    adv->addServiceUUID(hid->hidService()->getUUID());
+    adv->setScanResponse(true);
+    bool ok = adv->start();
+    Serial.printf("BLE HID: advertising as '%s'%s\n", BLE_HID_NAME, ok ? "" : " FAILED");
+    return ok;
+}
+
+bool ble_hid_connected() {
+    return kbd_input && conn_handle != BLE_HS_CONN_HANDLE_NONE && kbd_input->getSubscribedCount() > 0;
+}
+
+bool ble_hid_send_key(uint8_t modifiers, uint8_t keycode) {
+    MacroStep s = { MACRO_OP_TAP, modifiers, keycode };
+    if (!enqueue(&s, 1)) return false;
+    trace(TR_BLE_HID_TX, modifiers << 8 | keycode);
+    return true;
+}
+
+bool ble_hid_send_media(uint16_t consumer_code) {
+    MacroStep s = { MACRO_OP_MEDIA, (uint8_t)(consumer_code & 0xFF), (uint8_t)(consumer_code >> 8) };
+    if (!enqueue(&s, 1)) return false;
+    trace(TR_BLE_HID_TX, consumer_code, 1);
+    return true;
+}
+
+bool ble_hid_send_macro(const MacroStep *steps, uint8_t count) {
+    if (count > MACRO_MAX_STEPS) count = MACRO_MAX_STEPS;
+    if (!enqueue(steps, count)) return false;
+    trace(TR_BLE_HID_TX, count, 2);
+    return true;
+}
+
+uint32_t ble_hid_update(bool active) {
+    if (!server) return UINT32_MAX;
+    if (conn_handle == BLE_HS_CONN_HANDLE_NONE) {
+        if (q_head != q_tail || key_mods || release_due != RELEASE_NONE) reset_player();
+        return UINT32_MAX;
+    }
+    if (params_due || active != fast) {
+        params_due = false;
+        request_params(active);
+    }
+    return run_steps(millis());
+}
+
+void ble_hid_get_stats(BleHidStats &out) {
+    out = stats;
+    out.connected = ble_hid_connected();
+    out.fast = fast;
+    out.interval_us = 0;
+    out.latency = 0;
+    ble_gap_conn_desc desc;
+    uint16_t h = conn_handle;
+    if (h != BLE_HS_CONN_HANDLE_NONE && ble_gap_conn_find(h, &desc) == 0) {
+        out.interval_us = desc.conn_itvl * 1250;
+        out.latency = desc.conn_latency;
+    }
+    out.tx_avg_us = tx_count ? (uint32_t)(tx_sum_us / tx_count) : 0;
+}
+
+void ble_hid_reset_stats() {
+    stats = {};
+    tx_sum_us = 0;
+    tx_count = 0;
+}
+
+#endif  // BLE_HID_ENABLE
@@ -0,0 +1,92 @@
+#pragma once
+#include <stdint.h>
+#include "protocol.h"
+
+// ============================================================
+// Direct BLE HID (bridge-less keyboard + consumer control)
+//
+// Optional NimBLE transport for the HID actions, for a laptop with no
+// bridge plugged in. The display advertises as a BLE keyboard; once a
+// host has bonded, hid_send_*() (actions.h) route hotkeys, media keys and
+// macros here instead of ESP-NOW while the bridge link is down (or
+// always, with BLE_HID_PREFER=1). DDC and the PC-side actions still need
+// the bridge and companion.
+//
+// Connection parameters follow the panel: 7.5 ms interval and no slave
+// latency while it is ACTIVE, a relaxed interval with slave latency once
+// it dims, so an idle BLE link costs little. Each report's time from
+// notify() to the stack reporting it sent is kept for GET /api/perf, next
+// to the ESP-NOW link's send latency.
+//
+// Off by default: needs h2zero/NimBLE-Arduino and ~60 KB of internal RAM
+// (see [env:display-ble] in platformio.ini). With BLE_HID_ENABLE=0 the
+// calls below are inline no-ops.
+// ============================================================
+
+#ifndef BLE_HID_ENABLE
+#define BLE_HID_ENABLE 0
+#endif
+#ifndef BLE_HID_NAME
+#define BLE_HID_NAME "CrowPanel"
+#endif
+#ifndef BLE_HID_PREFER
+#define BLE_HID_PREFER 0      // 1 = BLE whenever a host is connected, bridge or not
+#endif
+#ifndef BLE_HID_HOLD_MS
+#define BLE_HID_HOLD_MS 10    // Key press -> release of a tap
+#endif
+
+// Connection parameters (1.25 ms intervals, 10 ms supervision timeout units)
+#define BLE_HID_FAST_INTERVAL    6     // 7.5 ms, the minimum
+#define BLE_HID_FAST_LATENCY     0
+#define BLE_HID_IDLE_INTERVAL_MIN 24   // 30 ms
+#define BLE_HID_IDLE_INTERVAL_MAX 48   // 60 ms
+#define BLE_HID_IDLE_LATENCY     4     // Up to 300 ms between answered events
+#define BLE_HID_TIMEOUT          400   // 4 s
+
+struct BleHidStats {
+    bool connected;
+    bool fast;                 // Fast parameters requested
+    uint32_t interval_us;      // Negotiated connection interval, 0 = not connected
+    uint16_t latency;          // Negotiated slave latency
+    uint32_t reports;          // Input reports sent (since reset)
+    uint32_t failed;           // notify() refused or reported failed
+    uint32_t tx_last_us;       // notify() -> stack done, most recent
+    uint32_t tx_avg_us;
+    uint32_t tx_max_us;
+};
+
+#if BLE_HID_ENABLE
+
+// Start advertising. Call once from setup(), after espnow_link_init().
+bool ble_hid_init();
+
+// A bonded host is connected and subscribed to the keyboard report
+bool ble_hid_connected();
+
+// Taps; false without a host (the caller falls back to the bridge)
+bool ble_hid_send_key(uint8_t modifiers, uint8_t keycode);
+bool ble_hid_send_media(uint16_t consumer_code);
+// Played from ble_hid_update(), honouring holds and delays (MacroOp)
+bool ble_hid_send_macro(const MacroStep *steps, uint8_t count);
+
+// Releases and macro steps as they come due, connection parameters for
+// `active` (panel in POWER_ACTIVE). Returns ms until the next step
+// (UINT32_MAX when idle). Call every loop() pass.
+uint32_t ble_hid_update(bool active);
+
+void ble_hid_get_stats(BleHidStats &out);
+void ble_hid_reset_stats();
+
+#else
+
+inline bool ble_hid_init() { return false; }
+inline bool ble_hid_connected() { return false; }
+inline bool ble_hid_send_key(uint8_t, uint8_t) { return false; }
+inline bool ble_hid_send_media(uint16_t) { return false; }
+inline bool ble_hid_send_macro(const MacroStep *, uint8_t) { return false; }
+inline uint32_t ble_hid_update(bool) { return UINT32_MAX; }
+inline void ble_hid_get_stats(BleHidStats &out) { out = {}; }
+inline void ble_hid_reset_stats() {}
+
+#endif
@@ -0,0 +1,337 @@
+/**
+ * @file bulk_xfer.cpp
+ * Bulk file transfer over ESP-NOW (no SoftAP needed for icon/config pushes)
+ *
+ * Chunks are appended to "<path>.part" strictly in order while the CRC-32 is
+ * accumulated, so END only has to compare and rename. A repeated BEGIN for
+ * the same path/size/crc resumes where the stored data ends (until reboot).
+ *
+ * BULK_FLAG_FIRMWARE sends the chunks to ota_update.cpp instead (the idle
+ * OTA slot, gzip inflated on the way); the UI keeps running and the new
+ * image is booted once the display next goes idle (ota_swap_when_idle).
+ *
+ * BULK_FLAG_IMAGE patches go to remote_image.cpp, staged in PSRAM and
+ * applied at END; the path is the source name. They are frequent, so
+ * they are only logged when something goes wrong.
+ *
+ * A committed /config.json is parsed off the UI task (apply_task) and its
+ * DONE sent once the new config is staged, or BULK_ERR_BAD if it is refused.
+ *
+ * BULK_FLAG_LZ files arrive compressed: each chunk goes through one
+ * streaming LzDecoder into the .part file as it arrives, so the CRC and
+ * offsets stay those of the stream and resuming needs nothing extra.
+ */
+
+#include "bulk_xfer.h"
+#include "espnow_link.h"
+#include "protocol.h"
+#include "sdcard.h"
+#include "config.h"
+#include "ui.h"
+#include "icon_cache.h"
+#include "picture_index.h"
+#include "ota_update.h"
+#include "remote_image.h"
+#include "lz_stream.h"
+#include "tasks.h"
+#include <Arduino.h>
+#include <string.h>
+
+#define BULK_ACK_EVERY 2   // In-order chunks per progress ACK (window is BULK_WINDOW)
+#define BULK_IDLE_MS   10000  // A file/firmware transfer quiet this long may be displaced by an image
+
+static struct {
+    bool     active;
+    bool     committed;          // Last transfer finished: a repeated END gets BULK_DONE again
+    uint8_t  xfer_id;
+    uint8_t  flags;
+    uint32_t total_size;
+    uint32_t crc_expected;
+    uint32_t crc_running;
+    uint32_t received;
+    uint8_t  unacked;            // In-order chunks since the last ACK
+    bool     gap_acked;          // Already told the sender about the current gap
+    uint32_t start_ms;
+    uint32_t last_rx_ms;         // Last BEGIN/DATA
+    char     path[BULK_PATH_MAX];
+    char     part_path[BULK_PATH_MAX + 6];
+} xfer = {};
+
+static LzDecoder lz;   // BULK_FLAG_LZ: decodes into xfer.part_path
+
+static bool lz_sink(void *, const uint8_t *data, size_t len) {
+    return sdcard_append_file(xfer.part_path, data, len);
+}
+
+static void send_ack(uint8_t xfer_id, uint8_t status, uint32_t next_offset) {
+    BulkAckMsg ack;
+    ack.xfer_id = xfer_id;
+    ack.status = status;
+    ack.next_offset = next_offset;
+    ack.flags = xfer_id == xfer.xfer_id ? (xfer.flags & BULK_FLAG_LZ) : 0;
+    espnow_send(MSG_BULK_ACK, (const uint8_t *)&ack, sizeof(ack));
+}
+
+// Absolute, no "..", fits with the ".part" suffix
+static bool path_ok(const char *path) {
+    size_t n = strnlen(path, BULK_PATH_MAX);
+    if (n == 0 || n >= BULK_PATH_MAX || path[0] != '/') return false;
+    return strstr(path, "..") == nullptr;
+}
+
+// Create the parent directory of path (one level: /icons, /bkgnds, ...)
+static void ensure_parent_dir(const char *path) {
+    const char *slash = strrchr(path, '/');
+    if (!slash || slash == path) return;
+    char dir[BULK_PATH_MAX];
+    size_t n = slash - path;
+    memcpy(dir, path, n);
+    dir[n] = '\0';
+    sdcard_mkdir(dir);
+}
+
+// Committed /config.json: parsed on a task of its own so the radio and
+// the UI keep running, staged like a SoftAP upload, and answered from the
+// UI task once the verdict is in. ENDs that arrive meanwhile (the sender
+// repeats its END until it hears back) wait for that answer.
+#ifndef BULK_APPLY_STACK
+#define BULK_APPLY_STACK 8192   // config_load(), as on the boot I/O task
+#endif
+#define APPLIED_OK 0x100        // config_applied() arg: xfer_id | APPLIED_OK
+
+static volatile bool config_applying = false;
+
+static void config_applied(uint32_t arg) {
+    uint8_t xfer_id = arg & 0xFF;
+    bool ok = arg & APPLIED_OK;
+    config_applying = false;
+    bool current = xfer_id == xfer.xfer_id;
+    if (current) xfer.committed = ok;
+    send_ack(xfer_id, ok ? BULK_DONE : BULK_ERR_BAD, current ? xfer.received : 0);
+}
+
+static void apply_task(void *arg) {
+    uint32_t verdict = (uint32_t)(uintptr_t)arg;
+    const char *err = config_reload_staged();
+    if (err) Serial.printf("[bulk] uploaded config refused (%s), keeping current\n", err);
+    else verdict |= APPLIED_OK;
+    while (!ui_post(config_applied, verdict)) vTaskDelay(pdMS_TO_TICKS(10));
+    vTaskDelete(nullptr);
+}
+
+static void handle_begin(const BulkBeginMsg *msg) {
+    char path[BULK_PATH_MAX];
+    memcpy(path, msg->path, BULK_PATH_MAX);
+    path[BULK_PATH_MAX - 1] = '\0';
+    bool firmware = msg->flags & BULK_FLAG_FIRMWARE;
+    bool image = msg->flags & BULK_FLAG_IMAGE;
+    // LZ is for SD files: an ACK without it makes the sender start over plain
+    uint8_t flags = (firmware || image) ? msg->flags & ~BULK_FLAG_LZ : msg->flags;
+
+    if (!firmware && !image && (!sdcard_mounted() || !path_ok(path))) {
+        Serial.printf("[bulk] rejected begin for '%s'\n", path);
+        send_ack(msg->xfer_id, BULK_ERR_BAD, 0);
+        return;
+    }
+    // Live images wait for a deploy or firmware push, they don't abort it
+    if (image && xfer.active && !(xfer.flags & BULK_FLAG_IMAGE) && millis() - xfer.last_rx_ms < BULK_IDLE_MS) {
+        send_ack(msg->xfer_id, BULK_ERR_BAD, 0);
+        return;
+    }
+
+    const uint8_t kind = BULK_FLAG_FIRMWARE | BULK_FLAG_IMAGE | BULK_FLAG_LZ;
+    bool resume = xfer.active && !(flags & BULK_FLAG_RESTART) &&
+                  strcmp(xfer.path, path) == 0 && (xfer.flags & kind) == (flags & kind) &&
+                  xfer.total_size == msg->total_size && xfer.crc_expected == msg->crc32;
+    if (resume) {
+        xfer.xfer_id = msg->xfer_id;
+        xfer.flags = flags;
+        xfer.unacked = 0;
+        xfer.gap_acked = false;
+        xfer.last_rx_ms = millis();
+        Serial.printf("[bulk] resume %s at %lu/%lu\n", path,
+                      (unsigned long)xfer.received, (unsigned long)xfer.total_size);
+        send_ack(xfer.xfer_id, BULK_OK, xfer.received);
+        return;
+    }
+
+    if (xfer.active && (xfer.flags & BULK_FLAG_FIRMWARE)) ota_abort();
+    if (xfer.active && (xfer.flags & BULK_FLAG_IMAGE)) remote_image_abort();
+    xfer = {};
+    xfer.xfer_id = msg->xfer_id;
+    xfer.flags = flags;
+    xfer.total_size = msg->total_size;
+    xfer.crc_expected = msg->crc32;
+    xfer.start_ms = xfer.last_rx_ms = millis();
+    strcpy(xfer.path, path);
+    snprintf(xfer.part_path, sizeof(xfer.part_path), "%s.part", path);
+
+    if (firmware) {
+        if (!ota_begin(path)) {
+            send_ack(xfer.xfer_id, BULK_ERR_BAD, 0);
+            return;
+        }
+        xfer.active = true;
+        Serial.printf("[bulk] begin firmware (%lu bytes)\n", (unsigned long)xfer.total_size);
+        send_ack(xfer.xfer_id, BULK_OK, 0);
+        return;
+    }
+    if (image) {
+        if (!remote_image_begin(path, xfer.total_size)) {
+            Serial.printf("[bulk] image patch for '%s' refused (%lu bytes)\n", path, (unsigned long)xfer.total_size);
+            send_ack(xfer.xfer_id, BULK_ERR_BAD, 0);
+            return;
+        }
+        xfer.active = true;
+        send_ack(xfer.xfer_id, BULK_OK, 0);
+        return;
+    }
+
+    ensure_parent_dir(path);
+    // Start from an empty .part file so appends line up with offset 0
+    if (!sdcard_write_file(xfer.part_path, nullptr, 0)) {
+        send_ack(xfer.xfer_id, BULK_ERR_IO, 0);
+        return;
+    }
+    if (flags & BULK_FLAG_LZ) lz_init(lz, lz_sink, nullptr);
+    xfer.active = true;
+    Serial.printf("[bulk] begin %s (%lu bytes%s)\n", path, (unsigned long)xfer.total_size,
+                  (flags & BULK_FLAG_LZ) ? ", compressed" : "");
+    send_ack(xfer.xfer_id, BULK_OK, 0);
+}
+
+static void handle_data(const uint8_t *payload, uint8_t len) {
+    const BulkDataHdr *hdr = (const BulkDataHdr *)payload;
+    if (!xfer.active || hdr->xfer_id != xfer.xfer_id) {
+        send_ack(hdr->xfer_id, BULK_ERR_BAD, 0);
+        return;
+    }
+
+    const uint8_t *data = payload + sizeof(BulkDataHdr);
+    uint32_t n = len - sizeof(BulkDataHdr);
+    if (hdr->offset != xfer.received || xfer.received + n > xfer.total_size) {
+        // Duplicate or gap: tell the sender where to continue from (once per
+        // gap, the rest of its window would only repeat the same ACK)
+        if (!xfer.gap_acked) {
+            send_ack(xfer.xfer_id, BULK_OK, xfer.received);
+            xfer.gap_acked = true;
+        }
+        xfer.unacked = 0;
+        return;
+    }
+    xfer.gap_acked = false;
+    xfer.last_rx_ms = millis();
+
+    bool stored = (xfer.flags & BULK_FLAG_FIRMWARE) ? ota_write(data, n)
+                : (xfer.flags & BULK_FLAG_IMAGE)    ? remote_image_write(data, n)
+                : (xfer.flags & BULK_FLAG_LZ)       ? lz_decode(lz, data, n)
+                                                    : sdcard_append_file(xfer.part_path, data, n);
+    if (!stored) {
+        xfer.active = false;
+        send_ack(xfer.xfer_id, BULK_ERR_IO, xfer.received);
+        return;
+    }
+    xfer.crc_running = crc32_update(xfer.crc_running, data, n);
+    xfer.received += n;
+
+    if (++xfer.unacked >= BULK_ACK_EVERY || xfer.received == xfer.total_size) {
+        xfer.unacked = 0;
+        send_ack(xfer.xfer_id, BULK_OK, xfer.received);
+    }
+}
+
+static void handle_end(const BulkEndMsg *msg) {
+    if (config_applying) return;   // Answered by config_applied()
+    if (!xfer.active && xfer.committed && msg->xfer_id == xfer.xfer_id) {
+        send_ack(xfer.xfer_id, BULK_DONE, xfer.received);   // Our DONE was lost
+        return;
+    }
+    if (!xfer.active || msg->xfer_id != xfer.xfer_id) {
+        send_ack(msg->xfer_id, BULK_ERR_BAD, 0);
+        return;
+    }
+    if (xfer.received != xfer.total_size) {
+        // Not everything arrived yet: sender resumes from here
+        send_ack(xfer.xfer_id, BULK_OK, xfer.received);
+        return;
+    }
+
+    xfer.active = false;
+    bool firmware = xfer.flags & BULK_FLAG_FIRMWARE;
+    if (xfer.crc_running != xfer.crc_expected) {
+        Serial.printf("[bulk] %s CRC mismatch (0x%08lX != 0x%08lX)\n", xfer.path,
+                      (unsigned long)xfer.crc_running, (unsigned long)xfer.crc_expected);
+        if (firmware) ota_abort();
+        else if (xfer.flags & BULK_FLAG_IMAGE) remote_image_abort();
+        else sdcard_file_remove(xfer.part_path);
+        send_ack(xfer.xfer_id, BULK_ERR_CRC, 0);
+        return;
+    }
+    if (xfer.flags & BULK_FLAG_IMAGE) {
+        uint8_t status = remote_image_end();
+        xfer.committed = status == BULK_DONE;
+        send_ack(xfer.xfer_id, status, xfer.received);
+        return;
+    }
+    uint32_t elapsed_ms = millis() - xfer.start_ms;
+    uint32_t rate_bps = elapsed_ms ? (uint32_t)((uint64_t)xfer.total_size * 1000 / elapsed_ms) : 0;
+    if (firmware) {
+        if (!ota_end()) {
+            send_ack(xfer.xfer_id, BULK_ERR_IO, xfer.received);
+            return;
+        }
+        Serial.printf("[bulk] firmware staged (%lu bytes, %lu ms, %lu B/s), swap when idle\n",
+                      (unsigned long)xfer.total_size, (unsigned long)elapsed_ms, (unsigned long)rate_bps);
+        xfer.committed = true;
+        send_ack(xfer.xfer_id, BULK_DONE, xfer.received);
+        return;
+    }
+    if ((xfer.flags & BULK_FLAG_LZ) && !lz_done(lz)) {
+        Serial.printf("[bulk] %s: compressed stream cut short\n", xfer.path);
+        sdcard_file_remove(xfer.part_path);
+        send_ack(xfer.xfer_id, BULK_ERR_BAD, 0);
+        return;
+    }
+    if (!sdcard_file_rename(xfer.part_path, xfer.path)) {
+        send_ack(xfer.xfer_id, BULK_ERR_IO, xfer.received);
+        return;
+    }
+
+    Serial.printf("[bulk] committed %s (%lu bytes, %lu ms, %lu B/s)\n", xfer.path,
+                  (unsigned long)xfer.total_size, (unsigned long)elapsed_ms, (unsigned long)rate_bps);
+    icon_cache_invalidate(xfer.path);
+    picture_index_added(xfer.path);
+
+    if (strcmp(xfer.path, "/config.json") == 0) {
+        config_applying = true;
+        if (xTaskCreatePinnedToCore(apply_task, "cfg_apply", BULK_APPLY_STACK, (void *)(uintptr_t)xfer.xfer_id,
+                                    1, nullptr, 0) != pdPASS) {
+            config_applying = false;
+            send_ack(xfer.xfer_id, BULK_ERR_IO, xfer.received);   // Stays on the card for the next boot
+        }
+        return;
+    }
+    if (xfer.flags & BULK_FLAG_APPLY) request_ui_rebuild();
+    xfer.committed = true;
+    send_ack(xfer.xfer_id, BULK_DONE, xfer.received);
+}
+
+void bulk_handle_msg(uint8_t type, const uint8_t *payload, uint8_t len) {
+    switch (type) {
+        case MSG_BULK_BEGIN:
+            if (len >= sizeof(BulkBeginMsg)) handle_begin((const BulkBeginMsg *)payload);
+            break;
+        case MSG_BULK_DATA:
+            if (len > sizeof(BulkDataHdr)) handle_data(payload, len);
+            break;
+        case MSG_BULK_END:
+            if (len >= sizeof(BulkEndMsg)) handle_end((const BulkEndMsg *)payload);
+            break;
+        default:
+            break;
+    }
+}
+
+bool bulk_active() {
+    return xfer.active;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+
+// ============================================================
+// Bulk file transfer receiver (MSG_BULK_BEGIN / DATA / END)
+//
+// Files pushed by the companion through the bridge are streamed into
+// "<path>.part" on SD, CRC-checked, then renamed over the target, or with
+// BULK_FLAG_FIRMWARE into the idle OTA slot. See the protocol description
+// in protocol.h.
+// ============================================================
+
+// Handle one MSG_BULK_* frame from espnow_dispatch(); replies with MSG_BULK_ACK.
+void bulk_handle_msg(uint8_t type, const uint8_t *payload, uint8_t len);
+
+// True while a transfer has started but not yet been committed or aborted
+bool bulk_active();
@@ -0,0 +1,206 @@
+/**
+ * @file button_skin.cpp
+ * Nine-slice baked button backgrounds (rounded rect + shadow, PSRAM)
+ *
+ * The bake is a SKIN_SIZE square: the rect inset by SKIN_PAD (the shadow's
+ * reach outside the button), so the outer SKIN_CAP pixels hold the corner
+ * curves plus shadow falloff and the SKIN_MID strip between them is uniform
+ * along its edge. Coverage comes from the rounded-box distance, the shadow
+ * from the same distance of the offset box ramped over the blur width,
+ * which is what LVGL's own shadow approximates.
+ */
+
+#include "button_skin.h"
+#include "mem_budget.h"
+#include <Arduino.h>
+#include <math.h>
+#include <string.h>
+
+#define SKIN_PAD   (BUTTON_SHADOW_W / 2 + BUTTON_SHADOW_OFS_Y)   // Shadow reach outside the button
+#define SKIN_EDGE  (BUTTON_RADIUS + BUTTON_SHADOW_W)             // Non-uniform band inside the button
+#define SKIN_CAP   (SKIN_PAD + SKIN_EDGE)
+#define SKIN_MID   16                                            // Tile width: fewer blits than 1 px
+#define SKIN_SIZE  (2 * SKIN_CAP + SKIN_MID)
+#define SKIN_MAX   24                                            // Colour pairs (~31 KB PSRAM each)
+#define SKIN_PX_BYTES LV_IMG_PX_SIZE_ALPHA_BYTE
+
+struct Skin {
+    uint32_t bg_color;
+    uint32_t pressed_color;
+    lv_img_dsc_t released;
+    lv_img_dsc_t pressed;
+};
+
+static Skin skins[SKIN_MAX];
+static int skin_count = 0;
+
+// Signed distance from (px, py) to a rounded box, negative inside
+static float rounded_box_distance(float px, float py, float x1, float y1, float x2, float y2, float r) {
+    float qx = fabsf(px - (x1 + x2) * 0.5f) - ((x2 - x1) * 0.5f - r);
+    float qy = fabsf(py - (y1 + y2) * 0.5f) - ((y2 - y1) * 0.5f - r);
+    float ox = fmaxf(qx, 0.0f), oy = fmaxf(qy, 0.0f);
+    return sqrtf(ox * ox + oy * oy) + fminf(fmaxf(qx, qy), 0.0f) - r;
+}
+
+static bool bake(lv_img_dsc_t &img, uint32_t color, float inset) {
+    uint32_t size = (uint32_t)SKIN_SIZE * SKIN_SIZE * SKIN_PX_BYTES;
+    uint8_t *buf = (uint8_t *)mem_alloc(MEM_POOL_IMAGES, size);
+    if (!buf) return false;
+
+    float x1 = SKIN_PAD + inset, x2 = SKIN_SIZE - SKIN_PAD - inset;
+    float shadow_opa = BUTTON_SHADOW_OPA / 255.0f;
+    uint8_t *px = buf;
+    for (int y = 0; y < SKIN_SIZE; y++) {
+        for (int x = 0; x < SKIN_SIZE; x++, px += SKIN_PX_BYTES) {
+            float cx = x + 0.5f, cy = y + 0.5f;
+            float d = rounded_box_distance(cx, cy, x1, x1, x2, x2, BUTTON_RADIUS);
+            float d_shadow = rounded_box_distance(cx, cy - BUTTON_SHADOW_OFS_Y, x1, x1, x2, x2, BUTTON_RADIUS);
+            float a_fill = fminf(fmaxf(0.5f - d, 0.0f), 1.0f);
+            float a_shadow = shadow_opa * fminf(fmaxf(0.5f - d_shadow / BUTTON_SHADOW_W, 0.0f), 1.0f);
+            // Fill over a black shadow: the shadow only darkens, so colour is
+            // the fill scaled by its share of the combined alpha
+            float a = a_fill + a_shadow * (1.0f - a_fill);
+            float k = a > 0.0f ? a_fill / a : 0.0f;
+            lv_color_t c = lv_color_make((uint8_t)(((color >> 16) & 0xFF) * k),
+                                         (uint8_t)(((color >> 8) & 0xFF) * k),
+                                         (uint8_t)((color & 0xFF) * k));
+            memcpy(px, &c, sizeof(c));
+            px[SKIN_PX_BYTES - 1] = (uint8_t)(a * 255.0f + 0.5f);
+        }
+    }
+
+    memset(&img, 0, sizeof(img));
+    img.header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+    img.header.w = SKIN_SIZE;
+    img.header.h = SKIN_SIZE;
+    img.data_size = size;
+    img.data = buf;
+    return true;
+}
+
+static const Skin *skin_for(uint32_t bg_color, uint32_t pressed_color) {
+    for (int i = 0; i < skin_count; i++) {
+        if (skins[i].bg_color == bg_color && skins[i].pressed_color == pressed_color) return &skins[i];
+    }
+    if (skin_count >= SKIN_MAX) return nullptr;
+
+    Skin &s = skins[skin_count];
+    uint32_t t0 = micros();
+    if (!bake(s.released, bg_color, 0)) return nullptr;
+    if (!bake(s.pressed, pressed_color, BUTTON_PRESS_INSET)) {
+        mem_free(MEM_POOL_IMAGES, (void *)s.released.data);
+        return nullptr;
+    }
+    s.bg_color = bg_color;
+    s.pressed_color = pressed_color;
+    skin_count++;
+    Serial.printf("[skin] Baked #%06lX/#%06lX in %luus (%d/%d)\n", (unsigned long)bg_color,
+                  (unsigned long)pressed_color, (unsigned long)(micros() - t0), skin_count, SKIN_MAX);
+    return &s;
+}
+
+// One slice: the part of the bake placed at (img_x, img_y) that falls in `dest`
+static void draw_part(lv_draw_ctx_t *ctx, const lv_img_dsc_t *img, const lv_area_t &dest,
+                      lv_coord_t img_x, lv_coord_t img_y) {
+    lv_area_t clip;
+    if (!_lv_area_intersect(&clip, &dest, ctx->clip_area)) return;
+    const lv_area_t *saved = ctx->clip_area;
+    ctx->clip_area = &clip;
+    lv_area_t coords = { img_x, img_y, (lv_coord_t)(img_x + SKIN_SIZE - 1), (lv_coord_t)(img_y + SKIN_SIZE - 1) };
+    lv_draw_img_dsc_t dsc;
+    lv_draw_img_dsc_init(&dsc);
+    lv_draw_img(ctx, &dsc, &coords, img);
+    ctx->clip_area = saved;
+}
+
+// Destination span of slice `i` (0 = start cap, 1 = tiled middle, 2 = end cap)
+// along one axis of the outer area [lo, hi]
+static void slice_span(int i, lv_coord_t lo, lv_coord_t hi, lv_coord_t &from, lv_coord_t &to) {
+    if (i == 0)      { from = lo;                to = lo + SKIN_CAP - 1; }
+    else if (i == 1) { from = lo + SKIN_CAP;     to = hi - SKIN_CAP; }
+    else             { from = hi - SKIN_CAP + 1; to = hi; }
+}
+
+static void skin_draw(lv_obj_t *btn, const Skin *skin, lv_draw_ctx_t *ctx) {
+    bool pressed = lv_obj_has_state(btn, LV_STATE_PRESSED);
+    const lv_img_dsc_t *img = pressed ? &skin->pressed : &skin->released;
+
+    lv_area_t outer;
+    lv_obj_get_coords(btn, &outer);
+    lv_area_increase(&outer, SKIN_PAD, SKIN_PAD);
+
+    for (int row = 0; row < 3; row++) {
+        lv_coord_t y1, y2;
+        slice_span(row, outer.y1, outer.y2, y1, y2);
+        for (int col = 0; col < 3; col++) {
+            lv_coord_t x1, x2;
+            slice_span(col, outer.x1, outer.x2, x1, x2);
+            if (row == 1 && col == 1) {
+                // Centre is solid fill
+                lv_area_t centre = { x1, y1, x2, y2 };
+                lv_draw_rect_dsc_t fill;
+                lv_draw_rect_dsc_init(&fill);
+                fill.bg_color = lv_color_hex(pressed ? skin->pressed_color : skin->bg_color);
+                lv_draw_rect(ctx, &fill, &centre);
+                continue;
+            }
+            // Image origin for caps; middles step through the tile strip
+            lv_coord_t step_x = col == 1 ? SKIN_MID : x2 - x1 + 1;
+            lv_coord_t step_y = row == 1 ? SKIN_MID : y2 - y1 + 1;
+            for (lv_coord_t ty = y1; ty <= y2; ty += step_y) {
+                lv_coord_t img_y = row == 0 ? outer.y1 : row == 2 ? outer.y2 - SKIN_SIZE + 1 : ty - SKIN_CAP;
+                for (lv_coord_t tx = x1; tx <= x2; tx += step_x) {
+                    lv_coord_t img_x = col == 0 ? outer.x1 : col == 2 ? outer.x2 - SKIN_SIZE + 1 : tx - SKIN_CAP;
+                    lv_area_t dest = { tx, ty, (lv_coord_t)LV_MIN(tx + step_x - 1, x2),
+                                       (lv_coord_t)LV_MIN(ty + step_y - 1, y2) };
+                    draw_part(ctx, img, dest, img_x, img_y);
+                }
+            }
+        }
+    }
+}
+
+// Inside the rounded rect (less the pressed inset and the antialiased
+// edge) every slice is opaque fill, in either state. An invalidated area in
+// there -- a label update, an animated icon frame -- is drawn from the
+// button up; LVGL skips the page background and container under it.
+static void skin_cover_check(lv_obj_t *btn, lv_cover_check_info_t *info) {
+    if (info->res == LV_COVER_RES_MASKED || lv_obj_get_style_opa(btn, LV_PART_MAIN) < LV_OPA_MAX) return;
+    lv_area_t fill;
+    lv_obj_get_coords(btn, &fill);
+    lv_area_increase(&fill, -(BUTTON_PRESS_INSET + 1), -(BUTTON_PRESS_INSET + 1));
+    if (_lv_area_is_in(info->area, &fill, BUTTON_RADIUS)) info->res = LV_COVER_RES_COVER;
+}
+
+static void skin_event_cb(lv_event_t *e) {
+    lv_obj_t *btn = lv_event_get_target(e);
+    const Skin *skin = (const Skin *)lv_event_get_user_data(e);
+    switch (lv_event_get_code(e)) {
+        case LV_EVENT_DRAW_MAIN:
+            skin_draw(btn, skin, lv_event_get_draw_ctx(e));
+            break;
+        case LV_EVENT_COVER_CHECK:   // After lv_obj's own check, which sees a transparent bg
+            skin_cover_check(btn, (lv_cover_check_info_t *)lv_event_get_param(e));
+            break;
+        case LV_EVENT_REFR_EXT_DRAW_SIZE:
+            lv_event_set_ext_draw_size(e, SKIN_PAD);
+            break;
+        case LV_EVENT_PRESSED:
+        case LV_EVENT_RELEASED:
+        case LV_EVENT_PRESS_LOST:
+            lv_obj_invalidate(btn);   // No style differs between the states to do it for us
+            break;
+        default:
+            break;
+    }
+}
+
+bool button_skin_attach(lv_obj_t *btn, lv_coord_t width, lv_coord_t height,
+                        uint32_t bg_color, uint32_t pressed_color) {
+    if (width <= 2 * SKIN_EDGE || height <= 2 * SKIN_EDGE) return false;
+    const Skin *skin = skin_for(bg_color, pressed_color);
+    if (!skin) return false;
+    lv_obj_add_event_cb(btn, skin_event_cb, LV_EVENT_ALL, (void *)skin);
+    lv_obj_refresh_ext_draw_size(btn);
+    return true;
+}
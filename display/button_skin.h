@@ -0,0 +1,36 @@
+#pragma once
+#include <lvgl.h>
+#include <stdint.h>
+
+// ============================================================
+// Baked hotkey button backgrounds
+//
+// A filled button is a 12 px rounded rect with an 8 px shadow, squeezed by
+// 3 px while pressed. Drawn live, the shadow blur is the most expensive
+// thing on a page and every press redraws it (plus the transform) from
+// scratch. Instead, the rounded, shadowed rect is rendered once per colour
+// pair into a small RGB565+alpha nine-slice image in PSRAM (released and
+// pressed variants) and blitted: corners as-is, edges tiled, centre as a
+// plain fill. Size independent, so one bake serves every button of that
+// colour. Buttons too small for the corner slices stay on live styles.
+// The opaque interior answers LVGL's cover check, so a redraw inside the
+// button (label, icon frame) doesn't repaint the page background under it.
+// ============================================================
+
+#ifndef UI_BAKED_BUTTONS
+#define UI_BAKED_BUTTONS 1
+#endif
+
+// Geometry shared with the live styles in ui.cpp
+#define BUTTON_RADIUS        12
+#define BUTTON_SHADOW_W      8
+#define BUTTON_SHADOW_OFS_Y  4
+#define BUTTON_SHADOW_OPA    LV_OPA_30
+#define BUTTON_PRESS_INSET   3
+
+// Draw `btn` (width x height) from baked images of bg_color / pressed_color.
+// The caller leaves the button's own bg and shadow transparent. Returns
+// false (and attaches nothing) when the button is too small for the corner
+// slices, the colour pair cache is full or PSRAM ran out.
+bool button_skin_attach(lv_obj_t *btn, lv_coord_t width, lv_coord_t height,
+                        uint32_t bg_color, uint32_t pressed_color);
@@ -0,0 +1,219 @@
+/**
+ * @file clock_direct.cpp
+ * Minute clock drawn straight into the framebuffer with LVGL stopped
+ *
+ * Layout mirrors what lv_label does for a one-line, content-sized,
+ * LV_ALIGN_CENTER label: glyph advances with kerning plus letter spacing,
+ * minus the trailing one, placed at pw/2 - w/2 inside the parent.
+ */
+
+#include "clock_direct.h"
+#if CLOCK_DIRECT_ENABLE
+#include "display_hw.h"
+#include "mem_budget.h"
+#include "ui.h"
+#include <Arduino.h>
+#include <lvgl.h>
+#include <string.h>
+
+static const char GLYPHS[] = "0123456789:-";
+#define GLYPH_COUNT (sizeof(GLYPHS) - 1)
+
+// Rasterized glyph cells: line height rows, advance (no kerning) columns,
+// text colour over the screen background
+struct GlyphCell {
+    uint16_t *px;
+    uint16_t w;
+};
+static GlyphCell cells[GLYPH_COUNT] = {};
+static const lv_font_t *cells_font = nullptr;
+static lv_color_t cells_fg, cells_bg;
+static uint16_t cell_h = 0;
+
+static bool active = false;
+static uint32_t quiet_since = 0;
+static lv_coord_t parent_x1, parent_w, text_y;
+static lv_coord_t letter_space;
+static lv_coord_t span_x1, span_x2;   // Columns the digits cover now
+static uint16_t *strip = nullptr;     // SCREEN_WIDTH x cell_h compose buffer
+static uint32_t engaged_ms = 0;
+static uint16_t draws = 0;
+
+static int glyph_index(char c) {
+    const char *p = strchr(GLYPHS, c);
+    return p && c ? (int)(p - GLYPHS) : -1;
+}
+
+static void free_cells() {
+    for (GlyphCell &c : cells) {
+        mem_free(MEM_POOL_IMAGES, c.px);
+        c = {};
+    }
+    cells_font = nullptr;
+}
+
+// One throwaway screen (not shown: nothing on it invalidates the display)
+// holding a background box with a single-glyph label, snapshotted per glyph
+static bool rasterize(const lv_font_t *font, lv_color_t fg, lv_color_t bg) {
+    free_cells();
+    cell_h = lv_font_get_line_height(font);
+    lv_obj_t *scr = lv_obj_create(NULL);
+    lv_obj_t *box = lv_obj_create(scr);
+    lv_obj_remove_style_all(box);
+    lv_obj_set_style_bg_color(box, bg, LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(box, LV_OPA_COVER, LV_PART_MAIN);
+    lv_obj_t *lbl = lv_label_create(box);
+    lv_obj_set_style_text_font(lbl, font, LV_PART_MAIN);
+    lv_obj_set_style_text_color(lbl, fg, LV_PART_MAIN);
+    lv_obj_set_pos(lbl, 0, 0);
+
+    bool ok = true;
+    for (size_t i = 0; i < GLYPH_COUNT && ok; i++) {
+        char text[2] = { GLYPHS[i], 0 };
+        uint16_t w = lv_font_get_glyph_width(font, GLYPHS[i], 0);
+        lv_label_set_text(lbl, text);
+        lv_obj_set_size(box, w, cell_h);
+        lv_obj_update_layout(box);
+        uint32_t need = lv_snapshot_buf_size_needed(box, LV_IMG_CF_TRUE_COLOR);
+        void *buf = mem_alloc(MEM_POOL_IMAGES, need);
+        lv_img_dsc_t dsc;
+        ok = buf && lv_snapshot_take_to_buf(box, LV_IMG_CF_TRUE_COLOR, &dsc, buf, need) == LV_RES_OK &&
+             dsc.header.w == w && dsc.header.h == cell_h;
+        if (!ok) {
+            mem_free(MEM_POOL_IMAGES, buf);
+            break;
+        }
+        cells[i] = { (uint16_t *)buf, w };
+    }
+    lv_obj_del(scr);
+    if (!ok) {
+        Serial.println("[clock_direct] glyph rasterization failed, LVGL keeps the clock");
+        free_cells();
+        return false;
+    }
+    cells_font = font;
+    cells_fg = fg;
+    cells_bg = bg;
+    return true;
+}
+
+void clock_direct_draw(const char *text) {
+    if (!active) return;
+    const lv_font_t *font = cells_font;
+    size_t n = strlen(text);
+    int32_t w = 0;
+    for (size_t i = 0; i < n; i++) {
+        w += lv_font_get_glyph_width(font, text[i], text[i + 1]) + letter_space;
+    }
+    if (n) w -= letter_space;
+    lv_coord_t x0 = parent_x1 + parent_w / 2 - w / 2;
+
+    // Cover the old digits too when the new time is narrower
+    lv_coord_t x1 = LV_MAX(LV_MIN(x0, span_x1), 0);
+    lv_coord_t x2 = LV_MIN(LV_MAX(x0 + w - 1, span_x2), SCREEN_WIDTH - 1);
+    if (x2 < x1) return;
+    uint16_t sw = x2 - x1 + 1;
+    uint16_t bg = cells_bg.full;
+    for (uint32_t i = 0; i < (uint32_t)sw * cell_h; i++) strip[i] = bg;
+
+    lv_coord_t x = x0;
+    for (size_t i = 0; i < n; i++) {
+        int g = glyph_index(text[i]);
+        if (g >= 0) {
+            const GlyphCell &c = cells[g];
+            for (uint16_t col = 0; col < c.w; col++) {
+                lv_coord_t dx = x + col - x1;
+                if (dx < 0 || dx >= sw) continue;
+                for (uint16_t row = 0; row < cell_h; row++) strip[row * sw + dx] = c.px[row * c.w + col];
+            }
+        }
+        x += lv_font_get_glyph_width(font, text[i], text[i + 1]) + letter_space;
+    }
+    display_write_rect(x1, text_y, sw, cell_h, strip);
+    span_x1 = x0;
+    span_x2 = x0 + w - 1;
+    draws++;
+}
+
+static bool engage(lv_obj_t *lbl) {
+    const lv_font_t *font = lv_obj_get_style_text_font(lbl, LV_PART_MAIN);
+    lv_color_t fg = lv_obj_get_style_text_color(lbl, LV_PART_MAIN);
+    lv_color_t bg = lv_obj_get_style_bg_color(lv_obj_get_screen(lbl), LV_PART_MAIN);
+    if ((font != cells_font || fg.full != cells_fg.full || bg.full != cells_bg.full) && !rasterize(font, fg, bg)) {
+        return false;
+    }
+    if (!strip) strip = (uint16_t *)mem_alloc(MEM_POOL_IMAGES, SCREEN_WIDTH * cell_h * sizeof(uint16_t));
+    if (!strip) return false;
+
+    lv_area_t parent;
+    lv_obj_get_content_coords(lv_obj_get_parent(lbl), &parent);
+    parent_x1 = parent.x1;
+    parent_w = lv_area_get_width(&parent);
+    text_y = lbl->coords.y1;
+    letter_space = lv_obj_get_style_text_letter_space(lbl, LV_PART_MAIN);
+    span_x1 = lbl->coords.x1;
+    span_x2 = lbl->coords.x2;
+
+    lvgl_suspend(true);
+    active = true;
+    engaged_ms = millis();
+    draws = 0;
+    Serial.println("[clock_direct] LVGL stopped, drawing the clock directly");
+    return true;
+}
+
+static void hand_back() {
+    if (!active) return;
+    active = false;
+    lvgl_suspend(false);
+    update_clock_time();                  // Label catches up with the minutes drawn meanwhile
+    lv_obj_invalidate(lv_scr_act());
+    mem_free(MEM_POOL_IMAGES, strip);     // Cells stay: the next night needs the same ones
+    strip = nullptr;
+    Serial.printf("[clock_direct] LVGL back after %lu s, %u direct draws\n",
+                  (unsigned long)((millis() - engaged_ms) / 1000), draws);
+}
+
+// Top-layer objects (toast, HUD) need LVGL running to animate or go away
+static bool top_layer_clear() {
+    lv_obj_t *top = lv_layer_top();
+    for (uint32_t i = 0; i < lv_obj_get_child_cnt(top); i++) {
+        if (!lv_obj_has_flag(lv_obj_get_child(top, i), LV_OBJ_FLAG_HIDDEN)) return false;
+    }
+    return true;
+}
+
+void clock_direct_update(bool allowed) {
+    uint32_t now = millis();
+    lv_disp_t *disp = lv_disp_get_default();
+    bool pending = disp && disp->inv_p != 0;
+    if (active) {
+        if (!allowed || pending) {
+            hand_back();
+            quiet_since = now;
+        }
+        return;
+    }
+    if (!allowed || pending || lv_anim_count_running() || !top_layer_clear()) {
+        quiet_since = now;
+        return;
+    }
+    if (now - quiet_since < CLOCK_DIRECT_IDLE_MS) return;
+    lv_obj_t *lbl = ui_clock_direct_label();
+    if (!lbl || !engage(lbl)) quiet_since = now;   // Analog face, other screen: look again later
+}
+
+void clock_direct_wake() {
+    hand_back();
+    quiet_since = millis();
+}
+
+bool clock_direct_active() {
+    return active;
+}
+#else
+void clock_direct_update(bool) {}
+void clock_direct_wake() {}
+bool clock_direct_active() { return false; }
+void clock_direct_draw(const char *) {}
+#endif
@@ -0,0 +1,45 @@
+#pragma once
+#include <stdint.h>
+
+// ============================================================
+// Direct clock renderer (POWER_CLOCK, digital clock screen)
+//
+// Overnight the panel only shows the time, yet LVGL kept running its
+// refresh, input and style timers several times a second. Once the clock
+// screen has sat untouched for CLOCK_DIRECT_IDLE_MS, its digits are
+// rasterized once per font/colour with lv_snapshot (PSRAM, kept across
+// sessions), LVGL's timers are stopped and each minute the loop copies
+// the new time into the panel framebuffer glyph by glyph, at the exact
+// place the label has it. The loop then sleeps up to
+// CLOCK_DIRECT_MAX_SLEEP_MS between passes instead of MAX_SLEEP_MS.
+//
+// Hand-off: a touch, leaving POWER_CLOCK or anything LVGL invalidates
+// (screen change, toast) restarts LVGL, which redraws the whole screen
+// with the label brought up to date. The analog face isn't covered: it
+// keeps the normal path.
+//
+// The CPU does not light-sleep: the RGB panel needs PCLK and the PSRAM
+// framebuffer to keep scanning, and ESP-NOW has to hear the bridge's wake.
+// Between passes both cores idle in WAITI at POWER_CLOCK's 80 MHz.
+//
+// -DCLOCK_DIRECT_ENABLE=0 keeps LVGL running in clock mode.
+// ============================================================
+
+#ifndef CLOCK_DIRECT_ENABLE
+#define CLOCK_DIRECT_ENABLE 1
+#endif
+#ifndef CLOCK_DIRECT_IDLE_MS
+#define CLOCK_DIRECT_IDLE_MS 5000
+#endif
+#define CLOCK_DIRECT_MAX_SLEEP_MS 1000   // Housekeeping cadence while LVGL is stopped
+
+// Loop, every pass before lvgl_tick(): engages once the clock screen has been
+// quiet long enough while `allowed`, hands back as soon as it isn't
+void clock_direct_update(bool allowed);
+
+void clock_direct_wake();              // Touch: back to LVGL now, restart the idle wait
+bool clock_direct_active();
+
+// Draw `text` ("HH:MM") in place of the clock label. Direct mode only;
+// update_clock_time() calls it instead of changing the label.
+void clock_direct_draw(const char *text);
@@ -1,9 +1,15 @@
 #include "config.h"
 #include "sdcard.h"
+#include "config_cache.h"
+#include "config_cost.h"
 #include <ArduinoJson.h>
 #include <Arduino.h>
 #include <lvgl.h>
 #include "protocol.h"
+#include "espnow_link.h"
+#include "key_layouts.h"
+#include "log.h"
+#include <SD.h>
 
 // ============================================================
 // Default/Builtin Profiles (hardcoded fallback) — v2 format
@@ -243,6 +249,168 @@ AppConfig config_create_defaults() {
 // JSON Serialization/Deserialization (ArduinoJson v7 API) — v2
 // ============================================================
 
+// Macro step names used in JSON ("op" field), indexed by MacroOp
+static const char *const MACRO_OP_NAMES[] = {
+    "tap", "press", "release", "release_all", "delay", "media",
+};
+#define MACRO_OP_COUNT (sizeof(MACRO_OP_NAMES) / sizeof(MACRO_OP_NAMES[0]))
+
+// Helper: Serialize macro steps to a JSON array
+static void macro_to_json(JsonArray arr, const std::vector<MacroStep>& steps) {
+    for (const auto& s : steps) {
+        if (s.op >= MACRO_OP_COUNT) continue;
+        JsonObject o = arr.add<JsonObject>();
+        o["op"] = MACRO_OP_NAMES[s.op];
+        switch (s.op) {
+            case MACRO_OP_TAP:
+            case MACRO_OP_PRESS:
+            case MACRO_OP_RELEASE:
+                if (s.a) o["mod"] = s.a;
+                if (s.b) o["key"] = s.b;
+                break;
+            case MACRO_OP_DELAY:
+                o["ms"] = (uint16_t)(s.a | (s.b << 8));
+                break;
+            case MACRO_OP_MEDIA:
+                o["code"] = (uint16_t)(s.a | (s.b << 8));
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// Helper: Parse macro steps from a JSON array.
+// {"op":"text","text":"..."} is a convenience that expands to one tap per
+// character (USBHIDKeyboard maps ASCII, including shifted characters).
+static void json_to_macro(JsonArrayConst arr, std::vector<MacroStep>& steps) {
+    steps.clear();
+    bool truncated = false;
+    for (JsonObjectConst o : arr) {
+        const char *op = o["op"] | "tap";
+        if (strcmp(op, "text") == 0) {
+            const char *text = o["text"] | "";
+            for (const char *c = text; *c; c++) {
+                if (steps.size() >= MACRO_MAX_STEPS) { truncated = true; break; }
+                if ((uint8_t)*c < 0x20 && *c != '\n' && *c != '\t') continue;
+                uint8_t key = (*c == '\n') ? 0xB0 : (*c == '\t') ? 0xB3 : (uint8_t)*c;  // KEY_RETURN / KEY_TAB
+                steps.push_back({MACRO_OP_TAP, 0, key});
+            }
+            continue;
+        }
+
+        uint8_t op_id = 0xFF;
+        for (uint8_t i = 0; i < MACRO_OP_COUNT; i++) {
+            if (strcmp(op, MACRO_OP_NAMES[i]) == 0) { op_id = i; break; }
+        }
+        if (op_id == 0xFF) {
+            Serial.printf("CONFIG: WARNING - unknown macro op '%s' skipped\n", op);
+            continue;
+        }
+        if (steps.size() >= MACRO_MAX_STEPS) { truncated = true; break; }
+
+        MacroStep s = {op_id, 0, 0};
+        if (op_id == MACRO_OP_DELAY || op_id == MACRO_OP_MEDIA) {
+            uint16_t v = (op_id == MACRO_OP_DELAY) ? (o["ms"] | (uint16_t)0) : (o["code"] | (uint16_t)0);
+            s.a = v & 0xFF;
+            s.b = v >> 8;
+        } else {
+            s.a = o["mod"] | (uint8_t)0;
+            s.b = o["key"] | (uint8_t)0;
+        }
+        steps.push_back(s);
+    }
+    if (truncated) {
+        Serial.printf("CONFIG: WARNING - macro truncated to %d steps\n", MACRO_MAX_STEPS);
+    }
+}
+
+// Helper: Serialize stat alert rules to a JSON array
+static void rules_to_json(JsonArray arr, const std::vector<StatRule>& rules) {
+    for (const auto& r : rules) {
+        JsonObject o = arr.add<JsonObject>();
+        o[(r.flags & RULE_BELOW) ? "below" : "above"] = r.threshold;
+        if (r.hysteresis) o["hysteresis"] = r.hysteresis;
+        if (r.color) o["color"] = r.color;
+        if (r.flags & RULE_BLINK) o["blink"] = true;
+        if (r.flags & RULE_TOAST) o["toast"] = true;
+    }
+}
+
+// Helper: Parse stat alert rules; a rule needs "above" or "below"
+static void json_to_rules(JsonArrayConst arr, std::vector<StatRule>& rules) {
+    rules.clear();
+    for (JsonObjectConst o : arr) {
+        bool below = !o["below"].isNull();
+        if (!below && o["above"].isNull()) {
+            Serial.println("CONFIG: WARNING - stat rule without above/below skipped");
+            continue;
+        }
+        if (rules.size() >= STAT_RULES_MAX) {
+            Serial.printf("CONFIG: WARNING - stat rules truncated to %d\n", STAT_RULES_MAX);
+            break;
+        }
+        StatRule r = {};
+        r.threshold = below ? (o["below"] | (int32_t)0) : (o["above"] | (int32_t)0);
+        r.hysteresis = o["hysteresis"] | (uint16_t)0;
+        r.color = o["color"] | (uint32_t)0;
+        r.flags = (below ? RULE_BELOW : 0) | ((o["blink"] | false) ? RULE_BLINK : 0) |
+                  ((o["toast"] | false) ? RULE_TOAST : 0);
+        rules.push_back(r);
+    }
+}
+
+// Helper: Serialize scroll grid entries (PC-side commands stay in the companion's copy)
+static void entries_to_json(JsonArray arr, const std::vector<GridEntry>& entries) {
+    for (const GridEntry& e : entries) {
+        JsonObject o = arr.add<JsonObject>();
+        o["label"] = e.label.c_str();
+        if (!e.icon_path.empty()) o["icon_path"] = e.icon_path.c_str();
+        o["action_type"] = (int)e.action_type;
+        if (e.modifiers) o["modifiers"] = e.modifiers;
+        if (e.keycode) o["keycode"] = e.keycode;
+        if (e.consumer_code) o["consumer_code"] = e.consumer_code;
+    }
+}
+
+// Helper: Parse scroll grid entries
+static void json_to_entries(JsonArrayConst arr, std::vector<GridEntry>& entries) {
+    entries.clear();
+    for (JsonObjectConst o : arr) {
+        if (entries.size() >= GRID_ENTRIES_MAX) {
+            Serial.printf("CONFIG: WARNING - grid entries truncated to %d\n", GRID_ENTRIES_MAX);
+            break;
+        }
+        GridEntry e;
+        if (!o["label"].isNull()) e.label = o["label"].as<const char*>();
+        if (!o["icon_path"].isNull()) e.icon_path = o["icon_path"].as<const char*>();
+        e.action_type = (ActionType)(o["action_type"] | (int)ACTION_LAUNCH_APP);
+        e.modifiers = o["modifiers"] | (uint8_t)0;
+        e.keycode = o["keycode"] | (uint8_t)0;
+        e.consumer_code = o["consumer_code"] | (uint16_t)0;
+        entries.push_back(e);
+    }
+}
+
+// Helper: Serialize a touch gesture binding
+static void gesture_action_to_json(JsonObject obj, const GestureAction& g) {
+    obj["enabled"] = g.enabled;
+    obj["action_type"] = (uint8_t)g.action_type;
+    obj["keycode"] = g.keycode;
+    obj["consumer_code"] = g.consumer_code;
+    obj["modifiers"] = g.modifiers;
+}
+
+// Helper: Parse a touch gesture binding (missing fields keep their defaults)
+static void json_to_gesture_action(JsonObject obj, GestureAction& g) {
+    if (obj.isNull()) return;
+    g.enabled = obj["enabled"] | g.enabled;
+    g.action_type = (ActionType)(obj["action_type"] | (uint8_t)g.action_type);
+    g.keycode = obj["keycode"] | (uint8_t)0;
+    g.consumer_code = obj["consumer_code"] | (uint16_t)0;
+    g.modifiers = obj["modifiers"] | (uint8_t)0;
+}
+
 // Helper: Serialize widget to JSON object
 static void widget_to_json(JsonObject obj, const WidgetConfig& w) {
     obj["widget_type"] = (int)w.widget_type;
@@ -266,16 +434,33 @@ static void widget_to_json(JsonObject obj, const WidgetConfig& w) {
             obj["keycode"] = w.keycode;
             obj["consumer_code"] = w.consumer_code;
             obj["pressed_color"] = w.pressed_color;
+            if (w.fire_on_press) obj["fire_on_press"] = true;
             if (w.action_type == ACTION_DDC) {
                 obj["ddc_vcp_code"] = w.ddc_vcp_code;
                 obj["ddc_value"] = w.ddc_value;
                 obj["ddc_adjustment"] = w.ddc_adjustment;
                 obj["ddc_display"] = w.ddc_display;
             }
+            if (w.action_type == ACTION_MACRO) {
+                macro_to_json(obj["macro"].to<JsonArray>(), w.macro_steps);
+            }
+            if (w.action_type == ACTION_TYPE_TEXT) {
+                obj["text"] = w.type_text.c_str();
+                obj["key_layout"] = key_layout_name(w.key_layout);
+            }
             break;
         case WIDGET_STAT_MONITOR:
             obj["stat_type"] = w.stat_type;
             if (w.value_position != 0) obj["value_position"] = w.value_position;
+            if (w.stat_host != 0) obj["stat_host"] = w.stat_host;
+            if (w.stat_remote != 0) obj["remote_host"] = w.stat_remote;
+            if (!w.stat_rules.empty()) rules_to_json(obj["rules"].to<JsonArray>(), w.stat_rules);
+            break;
+        case WIDGET_STAT_GRAPH:
+            obj["stat_type"] = w.stat_type;
+            obj["graph_points"] = w.graph_points;
+            if (w.graph_max != 0) obj["graph_max"] = w.graph_max;
+            if (!w.stat_rules.empty()) rules_to_json(obj["rules"].to<JsonArray>(), w.stat_rules);
             break;
         case WIDGET_CLOCK:
             obj["clock_analog"] = w.clock_analog;
@@ -297,13 +482,38 @@ static void widget_to_json(JsonObject obj, const WidgetConfig& w) {
             obj["separator_vertical"] = w.separator_vertical;
             obj["thickness"] = w.thickness;
             break;
+        case WIDGET_TRACKPAD:
+            obj["trackpad_absolute"] = w.trackpad_absolute;
+            obj["trackpad_speed"] = w.trackpad_speed;
+            break;
+        case WIDGET_REMOTE_IMAGE:
+            obj["image_source"] = w.image_source.c_str();
+            break;
+        case WIDGET_SCROLL_GRID:
+            obj["grid_columns"] = w.grid_columns;
+            obj["grid_row_height"] = w.grid_row_height;
+            entries_to_json(obj["entries"].to<JsonArray>(), w.grid_entries);
+            break;
         case WIDGET_PAGE_NAV:
             break;
     }
 }
 
-// Helper: Deserialize widget from JSON object
-static void json_to_widget(JsonObject obj, WidgetConfig& w) {
+// A widget's JSON seen through its template: keys the widget sets win,
+// the rest come from the template (a null object when it names none)
+struct WidgetJson {
+    JsonObjectConst own;
+    JsonObjectConst base;
+
+    JsonVariantConst operator[](const char *key) const {
+        JsonVariantConst v = own[key];
+        return v.isNull() ? base[key] : v;
+    }
+};
+
+// Helper: Deserialize widget from JSON object, on top of template `base`
+static void json_to_widget(JsonObjectConst own, WidgetConfig& w, JsonObjectConst base = JsonObjectConst()) {
+    WidgetJson obj = { own, base };
     w.widget_type = (WidgetType)(obj["widget_type"] | (int)WIDGET_HOTKEY_BUTTON);
     w.x = obj["x"] | (int16_t)0;
     w.y = obj["y"] | (int16_t)0;
@@ -340,10 +550,28 @@ static void json_to_widget(JsonObject obj, WidgetConfig& w) {
             w.keycode = obj["keycode"] | (uint8_t)0;
             w.consumer_code = obj["consumer_code"] | (uint16_t)0;
             w.pressed_color = obj["pressed_color"] | (uint32_t)0;
+            w.fire_on_press = obj["fire_on_press"] | false;
             w.ddc_vcp_code = obj["ddc_vcp_code"] | (uint8_t)0;
             w.ddc_value = obj["ddc_value"] | (uint16_t)0;
             w.ddc_adjustment = obj["ddc_adjustment"] | (int16_t)0;
             w.ddc_display = obj["ddc_display"] | (uint8_t)0;
+            if (w.action_type == ACTION_MACRO && obj["macro"].is<JsonArrayConst>()) {
+                json_to_macro(obj["macro"].as<JsonArrayConst>(), w.macro_steps);
+            }
+            if (w.action_type == ACTION_TYPE_TEXT) {
+                const char *text = obj["text"] | "";
+                size_t len = strlen(text), keep = utf8_clip(text, len, TYPE_TEXT_MAX_BYTES);
+                if (keep < len) {
+                    Serial.printf("CONFIG: WARNING - text of %u bytes cut to %u\n", (unsigned)len, (unsigned)keep);
+                }
+                w.type_text = ConfigStr(text, keep);
+                const char *layout = obj["key_layout"] | "us";
+                w.key_layout = key_layout_from_name(layout);
+                if (w.key_layout >= KEY_LAYOUT_COUNT) {
+                    Serial.printf("CONFIG: WARNING - key_layout \"%s\" unknown, using us\n", layout);
+                    w.key_layout = KEY_LAYOUT_US;
+                }
+            }
             break;
         case WIDGET_STAT_MONITOR:
             w.stat_type = obj["stat_type"] | (uint8_t)0;
@@ -353,6 +581,23 @@ static void json_to_widget(JsonObject obj, WidgetConfig& w) {
             }
             w.value_position = obj["value_position"] | (uint8_t)0;
             if (w.value_position > 2) w.value_position = 0;
+            w.stat_host = obj["stat_host"] | (uint8_t)0;
+            if (w.stat_host > ESPNOW_MAX_HOSTS) w.stat_host = 0;
+            w.stat_remote = obj["remote_host"] | (uint8_t)0;
+            if (w.stat_remote > REMOTE_HOST_MAX) w.stat_remote = 0;
+            if (obj["rules"].is<JsonArrayConst>()) json_to_rules(obj["rules"].as<JsonArrayConst>(), w.stat_rules);
+            break;
+        case WIDGET_STAT_GRAPH:
+            w.stat_type = obj["stat_type"] | (uint8_t)0;
+            if (w.stat_type < 1 || w.stat_type > STAT_TYPE_MAX) {
+                Serial.printf("CONFIG: WARNING - stat_type %d invalid\n", w.stat_type);
+                w.stat_type = STAT_CPU_PERCENT;
+            }
+            w.graph_points = obj["graph_points"] | (uint16_t)GRAPH_POINTS_DEFAULT;
+            if (w.graph_points < GRAPH_POINTS_MIN) w.graph_points = GRAPH_POINTS_MIN;
+            if (w.graph_points > GRAPH_POINTS_MAX) w.graph_points = GRAPH_POINTS_MAX;
+            w.graph_max = obj["graph_max"] | (uint16_t)0;
+            if (obj["rules"].is<JsonArrayConst>()) json_to_rules(obj["rules"].as<JsonArrayConst>(), w.stat_rules);
             break;
         case WIDGET_CLOCK:
             w.clock_analog = obj["clock_analog"] | false;
@@ -378,24 +623,116 @@ static void json_to_widget(JsonObject obj, WidgetConfig& w) {
             if (w.thickness < 1) w.thickness = 1;
             if (w.thickness > 8) w.thickness = 8;
             break;
+        case WIDGET_TRACKPAD:
+            w.trackpad_absolute = obj["trackpad_absolute"] | false;
+            w.trackpad_speed = obj["trackpad_speed"] | (uint8_t)TRACKPAD_SPEED_DEFAULT;
+            if (w.trackpad_speed < TRACKPAD_SPEED_MIN) w.trackpad_speed = TRACKPAD_SPEED_MIN;
+            if (w.trackpad_speed > TRACKPAD_SPEED_MAX) w.trackpad_speed = TRACKPAD_SPEED_MAX;
+            break;
+        case WIDGET_REMOTE_IMAGE:
+            if (!obj["image_source"].isNull()) w.image_source = obj["image_source"].as<const char*>();
+            break;
+        case WIDGET_SCROLL_GRID:
+            w.grid_columns = obj["grid_columns"] | (uint8_t)1;
+            if (w.grid_columns < 1) w.grid_columns = 1;
+            if (w.grid_columns > GRID_COLUMNS_MAX) w.grid_columns = GRID_COLUMNS_MAX;
+            w.grid_row_height = obj["grid_row_height"] | (uint16_t)GRID_ROW_HEIGHT_DEFAULT;
+            if (w.grid_row_height < GRID_ROW_HEIGHT_MIN) w.grid_row_height = GRID_ROW_HEIGHT_MIN;
+            if (w.grid_row_height > GRID_ROW_HEIGHT_MAX) w.grid_row_height = GRID_ROW_HEIGHT_MAX;
+            if (obj["entries"].is<JsonArrayConst>()) json_to_entries(obj["entries"].as<JsonArrayConst>(), w.grid_entries);
+            break;
         case WIDGET_PAGE_NAV:
             break;
     }
 }
 
+bool widget_config_equal(const WidgetConfig& a, const WidgetConfig& b) {
+    return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height &&
+           a.widget_type == b.widget_type && a.label == b.label && a.show_label == b.show_label &&
+           a.color == b.color && a.bg_color == b.bg_color &&
+           a.description == b.description && a.show_description == b.show_description &&
+           a.icon == b.icon && a.icon_path == b.icon_path &&
+           a.action_type == b.action_type && a.modifiers == b.modifiers && a.keycode == b.keycode &&
+           a.consumer_code == b.consumer_code && a.pressed_color == b.pressed_color &&
+           a.fire_on_press == b.fire_on_press &&
+           a.ddc_vcp_code == b.ddc_vcp_code && a.ddc_value == b.ddc_value &&
+           a.ddc_adjustment == b.ddc_adjustment && a.ddc_display == b.ddc_display &&
+           a.macro_steps.size() == b.macro_steps.size() &&
+           (a.macro_steps.empty() ||
+            memcmp(a.macro_steps.data(), b.macro_steps.data(), a.macro_steps.size() * sizeof(MacroStep)) == 0) &&
+           a.type_text == b.type_text && a.key_layout == b.key_layout &&
+           a.stat_type == b.stat_type && a.value_position == b.value_position &&
+           a.stat_host == b.stat_host && a.stat_remote == b.stat_remote &&
+           a.stat_rules == b.stat_rules &&
+           a.graph_points == b.graph_points && a.graph_max == b.graph_max &&
+           a.clock_analog == b.clock_analog &&
+           a.show_wifi == b.show_wifi && a.show_pc == b.show_pc && a.show_settings == b.show_settings &&
+           a.show_brightness == b.show_brightness && a.show_battery == b.show_battery &&
+           a.show_time == b.show_time && a.icon_spacing == b.icon_spacing &&
+           a.font_size == b.font_size && a.text_align == b.text_align &&
+           a.separator_vertical == b.separator_vertical && a.thickness == b.thickness &&
+           a.trackpad_absolute == b.trackpad_absolute && a.trackpad_speed == b.trackpad_speed &&
+           a.image_source == b.image_source &&
+           a.grid_columns == b.grid_columns && a.grid_row_height == b.grid_row_height &&
+           a.grid_entries == b.grid_entries;
+}
+
+// Helper: Serialize a widget as the fields that differ from its template.
+// Fields the full form leaves out at their default (icon_path, ddc_*, ...)
+// would come back from the template instead, so the result is parsed once
+// more and a widget that doesn't come back field-for-field is written in
+// full, without the link.
+static void widget_to_json_compact(JsonObject obj, const WidgetConfig& w, const std::vector<WidgetTemplate>& templates) {
+    if (w.template_id == 0 || w.template_id > templates.size()) {
+        widget_to_json(obj, w);
+        return;
+    }
+    const WidgetTemplate& t = templates[w.template_id - 1];
+    JsonDocument full_doc, base_doc;
+    JsonObject full = full_doc.to<JsonObject>();
+    JsonObject base = base_doc.to<JsonObject>();
+    widget_to_json(full, w);
+    widget_to_json(base, t.widget);
+    obj["template"] = t.name.c_str();
+    for (JsonPair kv : full) {
+        if (kv.value() != base[kv.key()]) obj[kv.key()] = kv.value();
+    }
+    WidgetConfig check;
+    json_to_widget(obj, check, base);
+    if (widget_config_equal(check, w)) return;
+    obj.clear();
+    widget_to_json(obj, w);
+}
+
 // Helper: Serialize page to JSON object (v2)
-static void page_to_json(JsonObject obj, const PageConfig& page) {
+static void page_to_json(JsonObject obj, const PageConfig& page, const std::vector<WidgetTemplate>& templates) {
     obj["name"] = page.name.c_str();
     if (!page.bg_image.empty()) obj["bg_image"] = page.bg_image.c_str();
     JsonArray widgets_array = obj["widgets"].to<JsonArray>();
     for (const auto& w : page.widgets) {
         JsonObject w_obj = widgets_array.add<JsonObject>();
-        widget_to_json(w_obj, w);
+        widget_to_json_compact(w_obj, w, templates);
+    }
+}
+
+// The template a widget names, as its template_id (0 = none or unknown)
+// and its JSON in the profile's "templates"
+static uint8_t find_template(JsonObjectConst templates, const std::vector<WidgetTemplate>& list,
+                             const char *name, JsonObjectConst& base) {
+    for (size_t i = 0; i < list.size(); i++) {
+        if (list[i].name == name) {
+            base = templates[name].as<JsonObjectConst>();
+            return (uint8_t)(i + 1);
+        }
     }
+    Serial.printf("CONFIG: WARNING - unknown template '%s'\n", name);
+    return 0;
 }
 
-// Helper: Deserialize page from JSON object (v2)
-static void json_to_page_v2(JsonObject obj, PageConfig& page) {
+// Helper: Deserialize page from JSON object (v2). Widgets naming a
+// template resolve against `templates`, already parsed into `list`.
+static void json_to_page_v2(JsonObject obj, PageConfig& page, JsonObjectConst templates = JsonObjectConst(),
+                            const std::vector<WidgetTemplate>& list = {}) {
     if (!obj["name"].isNull()) page.name = obj["name"].as<const char*>();
     if (!obj["bg_image"].isNull()) page.bg_image = obj["bg_image"].as<const char*>();
     page.widgets.clear();
@@ -409,13 +746,28 @@ static void json_to_page_v2(JsonObject obj, PageConfig& page) {
                 break;
             }
             WidgetConfig w;
-            json_to_widget(w_obj, w);
+            JsonObjectConst base;
+            const char *name = w_obj["template"].as<const char*>();
+            if (name) w.template_id = find_template(templates, list, name, base);
+            json_to_widget(w_obj, w, base);
             page.widgets.push_back(w);
             count++;
         }
     }
-    Serial.printf("CONFIG: Page '%s': %d widgets loaded\n",
-                  page.name.c_str(), (int)page.widgets.size());
+    LayoutCost cost;
+    size_t fit = config_cost_fit(page, &cost);
+    if (fit < page.widgets.size()) {
+        LayoutCost all = config_cost_page(page);
+        Serial.printf("CONFIG: WARNING - page '%s': %s (%lu B heap, %lu B images, ~%lu us), "
+                      "keeping %u of %u widgets\n",
+                      page.name.c_str(), config_cost_check(all), (unsigned long)all.heap,
+                      (unsigned long)all.image_bytes, (unsigned long)all.render_us,
+                      (unsigned)fit, (unsigned)page.widgets.size());
+        page.widgets.resize(fit);
+    }
+    LOG_D("CONFIG: Page '%s': %d widgets loaded (%lu B heap, %lu B images, ~%lu us)\n",
+          page.name.c_str(), (int)page.widgets.size(), (unsigned long)cost.heap,
+          (unsigned long)cost.image_bytes, (unsigned long)cost.render_us);
 }
 
 // ============================================================
@@ -504,23 +856,43 @@ static void migrate_v1_page(JsonObject page_obj, PageConfig& page) {
     pn.color = 0x3498DB;
     page.widgets.push_back(pn);
 
-    Serial.printf("CONFIG: Migrated v1 page '%s': %d buttons -> %d widgets\n",
-                  page.name.c_str(), btn_count, (int)page.widgets.size());
+    LOG_D("CONFIG: Migrated v1 page '%s': %d buttons -> %d widgets\n",
+          page.name.c_str(), btn_count, (int)page.widgets.size());
 }
 
 // Helper: Serialize profile to JSON object
 static void profile_to_json(JsonObject obj, const ProfileConfig& profile) {
     obj["name"] = profile.name.c_str();
+    if (profile.host != 0) obj["host"] = profile.host;
+    if (!profile.templates.empty()) {
+        JsonObject templates = obj["templates"].to<JsonObject>();
+        for (const auto& t : profile.templates) widget_to_json(templates[t.name.c_str()].to<JsonObject>(), t.widget);
+    }
     JsonArray pages_array = obj["pages"].to<JsonArray>();
     for (const auto& page : profile.pages) {
         JsonObject page_obj = pages_array.add<JsonObject>();
-        page_to_json(page_obj, page);
+        page_to_json(page_obj, page, profile.templates);
     }
 }
 
 // Helper: Deserialize profile from JSON object
 static void json_to_profile(JsonObject obj, ProfileConfig& profile, uint8_t config_version) {
     if (!obj["name"].isNull()) profile.name = obj["name"].as<const char*>();
+    profile.host = obj["host"] | (uint8_t)0;
+    if (profile.host > ESPNOW_MAX_HOSTS) profile.host = 0;
+    JsonObjectConst templates = obj["templates"].as<JsonObjectConst>();
+    profile.templates.clear();
+    for (JsonPairConst kv : templates) {
+        if (profile.templates.size() >= CONFIG_MAX_TEMPLATES) {
+            Serial.printf("CONFIG: WARNING - profile '%s' has >%d templates, truncating\n",
+                          profile.name.c_str(), CONFIG_MAX_TEMPLATES);
+            break;
+        }
+        if (!kv.value().is<JsonObjectConst>()) continue;
+        profile.templates.emplace_back();
+        profile.templates.back().name = kv.key().c_str();
+        json_to_widget(kv.value().as<JsonObjectConst>(), profile.templates.back().widget);
+    }
     profile.pages.clear();
     if (!obj["pages"].isNull()) {
         JsonArray pages_array = obj["pages"].as<JsonArray>();
@@ -536,7 +908,7 @@ static void json_to_profile(JsonObject obj, ProfileConfig& profile, uint8_t conf
                 // V1 migration: convert grid buttons to absolute widgets
                 migrate_v1_page(page_obj, page);
             } else {
-                json_to_page_v2(page_obj, page);
+                json_to_page_v2(page_obj, page, templates, profile.templates);
             }
             if (page.widgets.empty()) {
                 Serial.printf("CONFIG: WARNING - skipping empty page '%s'\n", page.name.c_str());
@@ -552,35 +924,238 @@ static void json_to_profile(JsonObject obj, ProfileConfig& profile, uint8_t conf
 // Configuration I/O
 // ============================================================
 
-AppConfig config_load() {
+#define CONFIG_JSON_PATH  "/config.json"
+#define CONFIG_TMP_PATH   "/config.tmp"
+#define CONFIG_SCAN_CHUNK 2048
+
+// serializeJson() target: buffers into SD-sized writes and keeps the
+// size and CRC of everything written, so the save needs no String copy
+class CrcFileWriter : public Print {
+public:
+    explicit CrcFileWriter(File &f) : file_(f) {}
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buf, size_t len) override {
+        size_t done = 0;
+        while (done < len && ok_) {
+            size_t n = len - done < sizeof(buf_) - used_ ? len - done : sizeof(buf_) - used_;
+            memcpy(buf_ + used_, buf + done, n);
+            used_ += n;
+            done += n;
+            if (used_ == sizeof(buf_)) flush_buf();
+        }
+        size += done;
+        crc = crc32_update(crc, buf, done);
+        return done;
+    }
+
+    // Writes out the tail; false if any write came up short
+    bool finish() {
+        flush_buf();
+        return ok_;
+    }
+
+    uint32_t size = 0;
+    uint32_t crc = 0;
+
+private:
+    void flush_buf() {
+        if (used_ && ok_) ok_ = file_.write(buf_, used_) == used_;
+        used_ = 0;
+    }
+
+    File &file_;
+    uint8_t buf_[512];
+    size_t used_ = 0;
+    bool ok_ = true;
+};
+
+bool config_file_matches(const char *path, uint32_t size, uint32_t crc) {
+    File f = SD.open(path, FILE_READ);
+    if (!f) return false;
+    if (f.size() != size) {
+        f.close();
+        return false;
+    }
+    uint8_t *buf = (uint8_t *)malloc(CONFIG_SCAN_CHUNK);
+    if (!buf) {
+        f.close();
+        return false;
+    }
+    uint32_t got = 0, total = 0;
+    int n;
+    while ((n = f.read(buf, CONFIG_SCAN_CHUNK)) > 0) {
+        got = crc32_update(got, buf, n);
+        total += n;
+    }
+    free(buf);
+    f.close();
+    return total == size && got == crc;
+}
+
+// What one streaming pass over /config.json finds without parsing it
+struct JsonScan {
+    uint32_t size;
+    uint32_t crc;                          // Key for the binary snapshot
+    std::vector<uint32_t> profile_offsets; // Byte offset of each "profiles"[i] object
+};
+
+// Tracks nesting (outside strings) to find where the top-level "profiles"
+// array's elements start. False if the file doesn't start with an object.
+static bool scan_config_json(File &f, JsonScan &scan) {
+    uint8_t *buf = (uint8_t *)malloc(CONFIG_SCAN_CHUNK);
+    if (!buf) return false;
+
+    scan = JsonScan();
+    int depth = 0;
+    bool in_string = false, escape = false, in_profiles = false, saw_root = false;
+    char key[12];            // Last string closed at depth 1 (the key before a '[')
+    size_t key_len = 0;
+    bool key_overflow = false;
+    uint32_t pos = 0;
+    int n;
+    while ((n = f.read(buf, CONFIG_SCAN_CHUNK)) > 0) {
+        scan.crc = crc32_update(scan.crc, buf, n);
+        for (int i = 0; i < n; i++, pos++) {
+            char c = (char)buf[i];
+            if (in_string) {
+                if (escape) escape = false;
+                else if (c == '\\') escape = true;
+                else if (c == '"') in_string = false;
+                else if (depth == 1) {
+                    if (key_len < sizeof(key) - 1) key[key_len++] = c;
+                    else key_overflow = true;
+                }
+                continue;
+            }
+            switch (c) {
+                case '"':
+                    in_string = true;
+                    if (depth == 1) { key_len = 0; key_overflow = false; }
+                    break;
+                case '{':
+                    if (!saw_root && depth == 0) saw_root = true;
+                    if (in_profiles && depth == 2) scan.profile_offsets.push_back(pos);
+                    depth++;
+                    break;
+                case '[':
+                    if (depth == 1) {
+                        key[key_len] = '\0';
+                        in_profiles = !key_overflow && strcmp(key, "profiles") == 0;
+                    }
+                    depth++;
+                    break;
+                case '}':
+                case ']':
+                    depth--;
+                    if (depth == 1) in_profiles = false;
+                    break;
+                default:
+                    if (!saw_root && c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+                        free(buf);
+                        return false;   // Not an object (or a BOM we don't expect)
+                    }
+                    break;
+            }
+        }
+    }
+    free(buf);
+    scan.size = pos;
+    return saw_root;
+}
+
+// Parse the profile object at profile.json_offset (the stream parser stops
+// at the end of that value, so the rest of the file is never read)
+static bool load_profile_at(File &f, ProfileConfig &profile) {
+    if (!f.seek(profile.json_offset)) return false;
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, f);
+    if (error || !(doc["name"] == profile.name.c_str())) {
+        Serial.printf("CONFIG: profile '%s' not found at offset %lu (%s)\n", profile.name.c_str(),
+                      (unsigned long)profile.json_offset, error ? error.c_str() : "name differs");
+        return false;
+    }
+    json_to_profile(doc.as<JsonObject>(), profile, profile.json_version);
+    profile.loaded = true;
+    return true;
+}
+
+bool config_load_profile(ProfileConfig& profile) {
+    if (profile.loaded) return true;
+    if (!sdcard_mounted()) return false;
+    File f = SD.open(CONFIG_JSON_PATH, FILE_READ);
+    if (!f) return false;
+    uint32_t t0 = millis();
+    bool ok = load_profile_at(f, profile);
+    f.close();
+    if (ok) {
+        Serial.printf("CONFIG: loaded profile '%s' (%zu pages) in %lu ms\n", profile.name.c_str(),
+                      profile.pages.size(), (unsigned long)(millis() - t0));
+    }
+    return ok;
+}
+
+static void log_string_pool() {
+    uint32_t unique, bytes, chunks;
+    config_str_stats(&unique, &bytes, &chunks);
+    Serial.printf("CONFIG: string pool %lu unique, %lu KB in %lu chunks\n",
+                  (unsigned long)unique, (unsigned long)(bytes / 1024), (unsigned long)chunks);
+}
+
+AppConfig config_load(bool *from_sd) {
+    if (from_sd) *from_sd = false;
+
     // Try to load from SD card
     if (!sdcard_mounted()) {
         Serial.println("CONFIG: SD card not mounted, using defaults");
         return config_create_defaults();
     }
 
-    // PSRAM-allocated buffer for reading file (max 64KB for config)
-    uint8_t *buffer = (uint8_t *)ps_malloc(64 * 1024);
-    if (!buffer) {
-        Serial.println("CONFIG: PSRAM alloc failed for read buffer, using defaults");
+    File f = SD.open(CONFIG_JSON_PATH, FILE_READ);
+    if (!f) {
+        Serial.println("CONFIG: /config.json not found, using defaults");
         return config_create_defaults();
     }
 
-    int bytes_read = sdcard_read_file("/config.json", buffer, (64 * 1024) - 1);
-
-    if (bytes_read <= 0) {
-        Serial.println("CONFIG: /config.json not found, using defaults");
-        free(buffer);
+    // One streaming pass for the snapshot key and the profile offsets
+    uint32_t t0 = micros();
+    JsonScan scan;
+    if (!scan_config_json(f, scan)) {
+        f.close();
+        Serial.println("CONFIG: /config.json is empty or not a JSON object, using defaults");
         return config_create_defaults();
     }
 
-    buffer[bytes_read] = '\0';
+    // Snapshot built from this exact JSON? Then skip ArduinoJson altogether
+    AppConfig cached;
+    uint32_t json_parse_us = 0;
+    if (config_cache_load(scan.size, scan.crc, cached, &json_parse_us)) {
+        f.close();
+        uint32_t us = micros() - t0;
+        Serial.printf("CONFIG: Loaded '%s' from " CONFIG_CACHE_PATH " in %lu us (JSON path: %lu us)\n",
+                      cached.active_profile_name.c_str(), (unsigned long)us, (unsigned long)json_parse_us);
+        log_string_pool();
+        if (from_sd) *from_sd = true;
+        return cached;
+    }
 
+    // Everything except the profiles' contents (only their names are kept)
+    JsonDocument filter;
+    for (const char *key : { "version", "active_profile_name", "brightness_level", "default_mode",
+                             "slideshow_interval_sec", "clock_analog", "clock_seconds", "stats_header",
+                             "hardware_buttons", "encoder", "gestures", "mode_cycle",
+                             "display_settings" }) {
+        filter[key] = true;
+    }
+    filter["profiles"][0]["name"] = true;
+    filter["profiles"][0]["host"] = true;
+
+    f.seek(0);
     JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, (const char*)buffer);
-    free(buffer);
+    DeserializationError error = deserializeJson(doc, f, DeserializationOption::Filter(filter));
 
     if (error) {
+        f.close();
         Serial.printf("CONFIG: JSON parse failed: %s, using defaults\n", error.c_str());
         return config_create_defaults();
     }
@@ -607,6 +1182,7 @@ AppConfig config_load() {
     cfg.default_mode = doc["default_mode"] | (uint8_t)0;
     cfg.slideshow_interval_sec = doc["slideshow_interval_sec"] | (uint16_t)30;
     cfg.clock_analog = doc["clock_analog"] | false;
+    cfg.clock_seconds = doc["clock_seconds"] | false;
 
     if (cfg.default_mode > 3) {
         Serial.printf("CONFIG: WARNING - invalid default_mode=%d, using MODE_HOTKEYS\n", cfg.default_mode);
@@ -615,15 +1191,28 @@ AppConfig config_load() {
     if (cfg.slideshow_interval_sec < 5) cfg.slideshow_interval_sec = 5;
     if (cfg.slideshow_interval_sec > 300) cfg.slideshow_interval_sec = 300;
 
+    // Profiles: index all, parse only the active one
     cfg.profiles.clear();
-    if (!doc["profiles"].isNull()) {
-        JsonArray profiles_array = doc["profiles"].as<JsonArray>();
-        for (JsonObject profile_obj : profiles_array) {
+    JsonArray profile_names = doc["profiles"];
+    if (!profile_names.isNull() && profile_names.size() == scan.profile_offsets.size()) {
+        size_t i = 0;
+        for (JsonObject profile_obj : profile_names) {
             ProfileConfig profile;
-            json_to_profile(profile_obj, profile, file_version);
+            profile.name = profile_obj["name"] | "";
+            profile.host = profile_obj["host"] | (uint8_t)0;
+            if (profile.host > ESPNOW_MAX_HOSTS) profile.host = 0;
+            profile.json_offset = scan.profile_offsets[i++];
+            profile.json_version = file_version;
+            profile.loaded = false;
+            if (profile.name == cfg.active_profile_name) {
+                load_profile_at(f, profile);
+            }
             cfg.profiles.push_back(profile);
         }
+    } else if (!profile_names.isNull()) {
+        Serial.println("CONFIG: WARNING - profile index mismatch, ignoring profiles");
     }
+    f.close();
 
     // Parse stats_header
     if (!doc["stats_header"].isNull()) {
@@ -689,6 +1278,14 @@ AppConfig config_load() {
         cfg.encoder.ddc_display = enc["ddc_display"] | 0;
     }
 
+    // Touch gestures (optional)
+    JsonObject gest = doc["gestures"];
+    if (!gest.isNull()) {
+        cfg.gestures.swipe_pages = gest["swipe_pages"] | true;
+        json_to_gesture_action(gest["two_finger_tap"], cfg.gestures.two_finger_tap);
+        json_to_gesture_action(gest["long_press"], cfg.gestures.long_press);
+    }
+
     // Mode cycle (optional)
     JsonArray modes = doc["mode_cycle"];
     if (!modes.isNull()) {
@@ -708,6 +1305,9 @@ AppConfig config_load() {
         cfg.display_settings.clock_color_theme = ds["clock_color_theme"] | (uint32_t)0xFFFFFF;
         cfg.display_settings.slideshow_interval_sec = ds["slideshow_interval_sec"] | 30;
         cfg.display_settings.slideshow_transition = ds["slideshow_transition"] | "fade";
+        cfg.display_settings.slideshow_shuffle = ds["slideshow_shuffle"] | false;
+        cfg.display_settings.battery_saver_pct = ds["battery_saver_pct"] | 30;
+        cfg.display_settings.battery_critical_pct = ds["battery_critical_pct"] | 15;
     }
 
     // Validate
@@ -727,10 +1327,12 @@ AppConfig config_load() {
         active->pages.resize(CONFIG_MAX_PAGES);
     }
 
-    // If migrated from v1, save upgraded config
+    // If migrated from v1, save upgraded config (config_save() writes the snapshot)
     if (file_version < 2) {
         Serial.println("CONFIG: Saving migrated v2 config...");
         config_save(cfg);
+    } else {
+        config_cache_save(cfg, scan.size, scan.crc, micros() - t0);
     }
 
     int total_widgets = 0;
@@ -740,33 +1342,13 @@ AppConfig config_load() {
     Serial.printf("CONFIG: Loaded '%s' - %zu pages, %d total widgets, version %d\n",
                   cfg.active_profile_name.c_str(), active->pages.size(),
                   total_widgets, cfg.version);
+    log_string_pool();
+    if (from_sd) *from_sd = true;
     return cfg;
 }
 
-bool config_save(const AppConfig& config) {
-    if (!sdcard_mounted()) {
-        Serial.println("CONFIG: SD card not mounted, cannot save");
-        return false;
-    }
-
-    // Backup existing config.json
-    if (sdcard_file_exists("/config.json")) {
-        uint8_t *backup_buf = (uint8_t *)ps_malloc(64 * 1024);
-        if (backup_buf) {
-            int backup_bytes = sdcard_read_file("/config.json", backup_buf, (64 * 1024) - 1);
-            if (backup_bytes > 0) {
-                if (sdcard_write_file("/config.json.bak", backup_buf, backup_bytes)) {
-                    Serial.println("CONFIG: backed up /config.json to /config.json.bak");
-                } else {
-                    Serial.println("CONFIG: WARNING - backup to /config.json.bak failed, continuing save");
-                }
-            }
-            free(backup_buf);
-        }
-    }
-
-    // Build JSON document
-    JsonDocument doc;
+// Whole AppConfig -> JSON document (v2). Profiles must be loaded.
+static void config_to_json(const AppConfig& config, JsonDocument& doc) {
     doc["version"] = CONFIG_VERSION;
     doc["active_profile_name"] = config.active_profile_name.c_str();
     doc["brightness_level"] = config.brightness_level;
@@ -774,6 +1356,7 @@ bool config_save(const AppConfig& config) {
     doc["default_mode"] = config.default_mode;
     doc["slideshow_interval_sec"] = config.slideshow_interval_sec;
     doc["clock_analog"] = config.clock_analog;
+    doc["clock_seconds"] = config.clock_seconds;
 
     JsonArray profiles_array = doc["profiles"].to<JsonArray>();
     for (const auto& profile : config.profiles) {
@@ -820,6 +1403,12 @@ bool config_save(const AppConfig& config) {
     enc["ddc_step"] = config.encoder.ddc_step;
     enc["ddc_display"] = config.encoder.ddc_display;
 
+    // Touch gestures
+    JsonObject gest = doc["gestures"].to<JsonObject>();
+    gest["swipe_pages"] = config.gestures.swipe_pages;
+    gesture_action_to_json(gest["two_finger_tap"].to<JsonObject>(), config.gestures.two_finger_tap);
+    gesture_action_to_json(gest["long_press"].to<JsonObject>(), config.gestures.long_press);
+
     // Mode cycle
     JsonArray modes = doc["mode_cycle"].to<JsonArray>();
     for (uint8_t m : config.mode_cycle.enabled_modes) {
@@ -835,49 +1424,461 @@ bool config_save(const AppConfig& config) {
     ds["clock_color_theme"] = config.display_settings.clock_color_theme;
     ds["slideshow_interval_sec"] = config.display_settings.slideshow_interval_sec;
     ds["slideshow_transition"] = config.display_settings.slideshow_transition;
+    ds["slideshow_shuffle"] = config.display_settings.slideshow_shuffle;
+    ds["battery_saver_pct"] = config.display_settings.battery_saver_pct;
+    ds["battery_critical_pct"] = config.display_settings.battery_critical_pct;
+}
 
-    String json_str;
-    serializeJson(doc, json_str);
+bool config_save(const AppConfig& config_in) {
+    if (!sdcard_mounted()) {
+        Serial.println("CONFIG: SD card not mounted, cannot save");
+        return false;
+    }
 
-    // Atomic write
-    if (!sdcard_write_file("/config.tmp", (const uint8_t*)json_str.c_str(), json_str.length())) {
-        Serial.println("CONFIG: Failed to write /config.tmp");
+    // Profiles never opened this boot still live only in the old file: pull
+    // them in before it is overwritten
+    AppConfig loaded_copy;
+    bool all_loaded = true;
+    for (const auto& profile : config_in.profiles) all_loaded = all_loaded && profile.loaded;
+    if (!all_loaded) {
+        loaded_copy = config_in;
+        for (auto& profile : loaded_copy.profiles) {
+            if (!config_load_profile(profile)) {
+                Serial.printf("CONFIG: cannot load profile '%s', not saving\n", profile.name.c_str());
+                return false;
+            }
+        }
+    }
+    const AppConfig& config = all_loaded ? config_in : loaded_copy;
+
+    // Backup existing config.json
+    if (sdcard_file_exists("/config.json")) {
+        if (sdcard_copy_file("/config.json", "/config.json.bak")) {
+            Serial.println("CONFIG: backed up /config.json to /config.json.bak");
+        } else {
+            Serial.println("CONFIG: WARNING - backup to /config.json.bak failed, continuing save");
+        }
+    }
+
+    JsonDocument doc;
+    config_to_json(config, doc);
+
+    // Serialize straight to the card; size and CRC come out of the same pass
+    File out = SD.open(CONFIG_TMP_PATH, FILE_WRITE);
+    if (!out) {
+        Serial.println("CONFIG: Failed to create " CONFIG_TMP_PATH);
+        return false;
+    }
+    CrcFileWriter writer(out);
+    serializeJson(doc, writer);
+    bool write_ok = writer.finish();
+    out.close();
+    if (!write_ok) {
+        Serial.println("CONFIG: Failed to write " CONFIG_TMP_PATH);
+        sdcard_file_remove(CONFIG_TMP_PATH);
+        return false;
+    }
+
+    // Verify what landed on the card before /config.json is touched
+    if (!config_file_matches(CONFIG_TMP_PATH, writer.size, writer.crc)) {
+        Serial.println("CONFIG: " CONFIG_TMP_PATH " failed read-back verification, not saving");
+        sdcard_file_remove(CONFIG_TMP_PATH);
         return false;
     }
 
-    sdcard_file_remove("/config.json");
+    sdcard_file_remove(CONFIG_JSON_PATH);
 
-    if (!sdcard_file_rename("/config.tmp", "/config.json")) {
-        Serial.println("CONFIG: Failed to rename /config.tmp to /config.json");
+    if (!sdcard_file_rename(CONFIG_TMP_PATH, CONFIG_JSON_PATH)) {
+        Serial.println("CONFIG: Failed to rename " CONFIG_TMP_PATH " to " CONFIG_JSON_PATH);
         if (sdcard_file_exists("/config.json.bak")) {
-            sdcard_file_rename("/config.json.bak", "/config.json");
+            sdcard_file_rename("/config.json.bak", CONFIG_JSON_PATH);
             Serial.println("CONFIG: Restored /config.json from backup");
         }
         return false;
     }
 
-    // Verify
-    uint8_t *verify_buf = (uint8_t *)ps_malloc(64 * 1024);
-    if (verify_buf) {
-        int verify_bytes = sdcard_read_file("/config.json", verify_buf, (64 * 1024) - 1);
-        if (verify_bytes > 0) {
-            verify_buf[verify_bytes] = '\0';
-            JsonDocument verify_doc;
-            DeserializationError verify_err = deserializeJson(verify_doc, (const char*)verify_buf);
-            if (verify_err) {
-                Serial.printf("CONFIG: WARNING - saved file failed verification: %s\n", verify_err.c_str());
-                if (sdcard_file_exists("/config.json.bak")) {
-                    sdcard_file_remove("/config.json");
-                    sdcard_file_rename("/config.json.bak", "/config.json");
-                    Serial.println("CONFIG: Restored /config.json from backup after verification failure");
-                }
-                free(verify_buf);
-                return false;
-            }
-        }
-        free(verify_buf);
+    Serial.printf("CONFIG: Saved configuration (%lu bytes, crc 0x%08lX)\n", (unsigned long)writer.size,
+                  (unsigned long)writer.crc);
+    // Parse cost unknown here; the next JSON load that misses records it
+    config_cache_save(config, writer.size, writer.crc, 0);
+    return true;
+}
+
+// ============================================================
+// Live edit patches (live_edit.cpp)
+// ============================================================
+
+// "/pages/<p>[/widgets/<w>][/<field>]"; index -1 is "-" (append), widget
+// -2 when the path stops at the page
+struct PatchPath {
+    int page;
+    int widget;
+    const char *field;   // nullptr: the page or widget itself
+};
+
+static bool parse_patch_index(const char *&p, int &out) {
+    if (*p == '-') {
+        out = -1;
+        p++;
+        return true;
     }
+    if (*p < '0' || *p > '9') return false;
+    char *end;
+    out = (int)strtol(p, &end, 10);
+    p = end;
+    return true;
+}
 
-    Serial.printf("CONFIG: Saved configuration (%zu bytes)\n", json_str.length());
+static bool parse_patch_path(const char *path, PatchPath &out) {
+    out = {-2, -2, nullptr};
+    if (strncmp(path, "/pages/", 7) != 0) return false;
+    const char *p = path + 7;
+    if (!parse_patch_index(p, out.page)) return false;
+    if (*p == '\0') return true;
+    if (strncmp(p, "/widgets/", 9) == 0) {
+        p += 9;
+        if (!parse_patch_index(p, out.widget)) return false;
+        if (*p == '\0') return true;
+    }
+    if (*p != '/' || p[1] == '\0' || strchr(p + 1, '/')) return false;
+    out.field = p + 1;
     return true;
 }
+
+// Overlay any subset of widget keys: round trip through the JSON form so a
+// patch gets exactly config_load()'s defaults, clamping and validation
+static void patch_widget(WidgetConfig &w, JsonObjectConst patch) {
+    JsonDocument doc;
+    JsonObject obj = doc.to<JsonObject>();
+    widget_to_json(obj, w);
+    for (JsonPairConst kv : patch) obj[kv.key()] = kv.value();
+    json_to_widget(obj, w);
+}
+
+// Field replace, merge or whole-widget replace on one widget
+static const char *patch_widget_op(WidgetConfig &w, const PatchPath &path, JsonVariantConst value,
+                                   bool replace, bool merge) {
+    if (path.field) {
+        if (!replace) return "widget fields take replace";
+        JsonDocument one;
+        one[path.field] = value;
+        patch_widget(w, one.as<JsonObjectConst>());
+        return nullptr;
+    }
+    if (merge || replace) {
+        if (!value.is<JsonObjectConst>()) return "merge/replace needs an object";
+        if (replace) w = WidgetConfig();
+        patch_widget(w, value.as<JsonObjectConst>());
+        return nullptr;
+    }
+    return "unknown op";
+}
+
+// A failed op leaves the profile as it was: everything is validated before
+// it changes, except the page budgets, whose widget edits are undone
+static const char *apply_patch_op(ProfileConfig &profile, JsonObjectConst op, int &touched) {
+    const char *name = op["op"] | "";
+    JsonVariantConst value = op["value"];
+    PatchPath path;
+    if (!parse_patch_path(op["path"] | "", path)) return "bad path";
+    bool add = strcmp(name, "add") == 0;
+    bool remove = strcmp(name, "remove") == 0;
+    bool replace = strcmp(name, "replace") == 0;
+    bool merge = strcmp(name, "merge") == 0;
+    std::vector<PageConfig> &pages = profile.pages;
+
+    if (path.widget == -2 && !path.field) {
+        if (add) {
+            int at = path.page < 0 ? (int)pages.size() : path.page;
+            if (at > (int)pages.size()) return "page out of range";
+            if (pages.size() >= CONFIG_MAX_PAGES) return "too many pages";
+            if (!value.is<JsonObjectConst>()) return "add needs an object";
+            JsonDocument doc;
+            doc.set(value);
+            PageConfig page;
+            json_to_page_v2(doc.as<JsonObject>(), page);
+            pages.insert(pages.begin() + at, page);
+            touched = at;
+            return nullptr;
+        }
+        if (remove) {
+            if (path.page < 0 || path.page >= (int)pages.size()) return "page out of range";
+            if (pages.size() == 1) return "cannot remove the last page";
+            pages.erase(pages.begin() + path.page);
+            touched = path.page < (int)pages.size() ? path.page : (int)pages.size() - 1;
+            return nullptr;
+        }
+        return "pages take add or remove";
+    }
+
+    if (path.page < 0 || path.page >= (int)pages.size()) return "page out of range";
+    PageConfig &page = pages[path.page];
+    touched = path.page;
+
+    if (path.widget == -2) {
+        if (!replace || !value.is<const char *>()) return "page fields take replace with a string";
+        if (strcmp(path.field, "name") == 0) page.name = value.as<const char *>();
+        else if (strcmp(path.field, "bg_image") == 0) page.bg_image = value.as<const char *>();
+        else return "unknown page field";
+        return nullptr;
+    }
+
+    std::vector<WidgetConfig> &widgets = page.widgets;
+    if (add && !path.field) {
+        int at = path.widget < 0 ? (int)widgets.size() : path.widget;
+        if (at > (int)widgets.size()) return "widget out of range";
+        if (widgets.size() >= CONFIG_MAX_WIDGETS) return "too many widgets";
+        if (!value.is<JsonObjectConst>()) return "add needs an object";
+        WidgetConfig w;
+        patch_widget(w, value.as<JsonObjectConst>());
+        widgets.insert(widgets.begin() + at, w);
+        if (const char *over = config_cost_check(config_cost_page(page))) {
+            widgets.erase(widgets.begin() + at);
+            return over;
+        }
+        return nullptr;
+    }
+    if (path.widget < 0 || path.widget >= (int)widgets.size()) return "widget out of range";
+    WidgetConfig &w = widgets[path.widget];
+    if (remove && !path.field) {
+        widgets.erase(widgets.begin() + path.widget);
+        return nullptr;
+    }
+
+    // Edits may make the widget dearer (graph points, icons, size): undone if the page no longer fits
+    WidgetConfig before = w;
+    const char *err = patch_widget_op(w, path, value, replace, merge);
+    if (!err) err = config_cost_check(config_cost_page(page));
+    if (err) w = before;
+    return err;
+}
+
+const char *config_apply_patch(AppConfig &config, const char *json, size_t len, int *page) {
+    *page = -1;
+    JsonDocument doc;
+    if (deserializeJson(doc, json, len)) return "invalid JSON";
+    ProfileConfig *profile = config.get_active_profile();
+    if (!profile) return "no active profile";
+
+    JsonVariantConst ops = doc.as<JsonVariantConst>();
+    if (doc["patch"].is<JsonArrayConst>()) {
+        const char *name = doc["profile"] | "";
+        if (*name && profile->name != name) return "not the active profile";
+        ops = doc["patch"].as<JsonVariantConst>();
+    }
+    if (ops.is<JsonObjectConst>()) return apply_patch_op(*profile, ops.as<JsonObjectConst>(), *page);
+    if (!ops.is<JsonArrayConst>()) return "expected an op or an array of ops";
+
+    // Several ops: later ones may fail after earlier ones applied
+    JsonArrayConst list = ops.as<JsonArrayConst>();
+    std::vector<PageConfig> backup;
+    if (list.size() > 1) backup = profile->pages;
+    for (JsonObjectConst op : list) {
+        const char *err = apply_patch_op(*profile, op, *page);
+        if (err) {
+            if (list.size() > 1) profile->pages = std::move(backup);
+            *page = -1;
+            return err;
+        }
+    }
+    return nullptr;
+}
+
+// ============================================================
+// Codec microbenchmarks (CONFIG_BENCH_AT_BOOT)
+//
+// Runs on the target, so the numbers include PSRAM and the real allocator.
+// ============================================================
+
+#define BENCH_PROTO_ITERS  10000
+#define BENCH_FUZZ_ITERS   20000
+#define BENCH_CONFIG_ITERS 5
+
+static volatile uint32_t bench_sink;
+static uint32_t bench_rng = 0x9E3779B9u;
+
+static uint32_t bench_rand() {
+    bench_rng ^= bench_rng << 13;   // xorshift32: reproducible run to run
+    bench_rng ^= bench_rng >> 17;
+    bench_rng ^= bench_rng << 5;
+    return bench_rng;
+}
+
+static void bench_stat_cb(uint8_t type, int32_t value, bool) {
+    bench_sink = bench_sink + type + value;
+}
+
+static void bench_protocol() {
+    // Full keyframe: every stat type with a uint16 value
+    uint8_t tlv[1 + STAT_TYPE_MAX * 4];
+    uint8_t len = 1;
+    for (uint8_t t = 1; t <= STAT_TYPE_MAX; t++) {
+        tlv[len++] = t;
+        tlv[len++] = 2;
+        tlv[len++] = t * 7;
+        tlv[len++] = 0;
+    }
+    tlv[0] = STAT_TYPE_MAX;
+
+    uint32_t t0 = micros();
+    for (int i = 0; i < BENCH_PROTO_ITERS; i++) tlv_decode_stats(tlv, len, bench_stat_cb);
+    uint32_t decode_us = micros() - t0;
+
+    uint8_t dst[PROTO_MAX_PAYLOAD];
+    t0 = micros();
+    for (int i = 0; i < BENCH_PROTO_ITERS; i++) {
+        memcpy(dst, tlv, len);
+        uint8_t dst_len = len;
+        tlv_merge_stats(dst, dst_len, sizeof(dst), tlv, len);
+    }
+    uint32_t merge_us = micros() - t0;
+
+    uint8_t frame[PROTO_MAX_PAYLOAD];
+    for (size_t i = 0; i < sizeof(frame); i++) frame[i] = (uint8_t)bench_rand();
+    t0 = micros();
+    for (int i = 0; i < BENCH_PROTO_ITERS; i++) bench_sink = bench_sink + crc8_calc(frame, sizeof(frame));
+    uint32_t crc8_us = micros() - t0;
+
+    t0 = micros();
+    uint32_t crc = 0;
+    for (int i = 0; i < BENCH_PROTO_ITERS / 10; i++) crc = crc32_update(crc, frame, sizeof(frame));
+    uint32_t crc32_us = micros() - t0;
+    bench_sink = bench_sink + crc;
+
+    // Fuzz: random packets and bit-flipped keyframes through decode + merge
+    uint32_t decoded = 0, merged = 0;
+    uint8_t pkt[PROTO_MAX_PAYLOAD];
+    for (int i = 0; i < BENCH_FUZZ_ITERS; i++) {
+        uint8_t n;
+        if (i & 1) {
+            n = len;
+            memcpy(pkt, tlv, len);
+            for (int f = 0; f < 3; f++) pkt[bench_rand() % n] ^= 1 << (bench_rand() % 8);
+        } else {
+            n = (uint8_t)(bench_rand() % (sizeof(pkt) + 1));
+            for (uint8_t k = 0; k < n; k++) pkt[k] = (uint8_t)bench_rand();
+            if (n) pkt[0] %= STAT_TYPE_MAX + 1;   // Keep it on the TLV path
+        }
+        if (tlv_decode_stats(pkt, n, bench_stat_cb)) decoded++;
+        memcpy(dst, tlv, len);
+        uint8_t dst_len = len;
+        if (tlv_merge_stats(dst, dst_len, sizeof(dst), pkt, n)) merged++;
+    }
+
+    Serial.printf("PROTO: bench tlv_decode %.2f us (%u stats), tlv_merge %.2f us, crc8 %.2f us/%u B, crc32 %.2f MB/s\n",
+                  (float)decode_us / BENCH_PROTO_ITERS, STAT_TYPE_MAX,
+                  (float)merge_us / BENCH_PROTO_ITERS,
+                  (float)crc8_us / BENCH_PROTO_ITERS, (unsigned)sizeof(frame),
+                  crc32_us ? (float)(BENCH_PROTO_ITERS / 10) * sizeof(frame) / crc32_us : 0.0f);
+    Serial.printf("PROTO: fuzz %d packets: %lu decoded, %lu merged\n",
+                  BENCH_FUZZ_ITERS, (unsigned long)decoded, (unsigned long)merged);
+}
+
+// Large profile: pages full of hotkey buttons (the old fixed limits, so runs stay comparable)
+#define BENCH_PAGES   16
+#define BENCH_WIDGETS 32
+
+static ProfileConfig bench_large_profile() {
+    ProfileConfig profile;
+    profile.name = "bench";
+    char name[24], label[16];
+    for (int p = 0; p < BENCH_PAGES; p++) {
+        PageConfig page;
+        snprintf(name, sizeof(name), "Bench %d", p + 1);
+        page.name = name;
+        for (int i = 0; i < BENCH_WIDGETS; i++) {
+            snprintf(label, sizeof(label), "Key %d", i + 1);
+            page.widgets.push_back(make_hotkey((i % 8) * 100, 50 + (i / 8) * 105, 96, 100, label,
+                                               "Ctrl+key", 0x3498DB, LV_SYMBOL_OK, MOD_CTRL, 'a' + i % 26));
+        }
+        profile.pages.push_back(page);
+    }
+    return profile;
+}
+
+static void bench_config(const AppConfig& live) {
+    AppConfig cfg = live;
+    for (auto& profile : cfg.profiles) {
+        if (!config_load_profile(profile)) profile.pages.clear();
+    }
+    cfg.profiles.push_back(bench_large_profile());
+    int widgets = 0;
+    for (const auto& profile : cfg.profiles) {
+        for (const auto& page : profile.pages) widgets += page.widgets.size();
+    }
+
+    String json;
+    uint32_t t0 = micros();
+    for (int i = 0; i < BENCH_CONFIG_ITERS; i++) {
+        JsonDocument doc;
+        config_to_json(cfg, doc);
+        json = "";
+        serializeJson(doc, json);
+    }
+    uint32_t save_us = (micros() - t0) / BENCH_CONFIG_ITERS;
+
+    std::vector<ProfileConfig> parsed;
+    uint32_t parse_us = 0;
+    for (int i = 0; i < BENCH_CONFIG_ITERS; i++) {
+        parsed.clear();
+        t0 = micros();
+        JsonDocument doc;
+        if (deserializeJson(doc, json)) break;
+        for (JsonObject obj : doc["profiles"].as<JsonArray>()) {
+            parsed.emplace_back();
+            json_to_profile(obj, parsed.back(), CONFIG_VERSION);
+        }
+        parse_us += micros() - t0;
+    }
+    parse_us /= BENCH_CONFIG_ITERS;
+
+    // Round trip: every widget must come back field-for-field (empty pages are dropped on load)
+    bool same = parsed.size() == cfg.profiles.size();
+    for (size_t p = 0; same && p < parsed.size(); p++) {
+        std::vector<const PageConfig*> pages;
+        for (const auto& page : cfg.profiles[p].pages) {
+            if (!page.widgets.empty()) pages.push_back(&page);
+        }
+        same = parsed[p].pages.size() == pages.size();
+        for (size_t g = 0; same && g < pages.size(); g++) {
+            const auto& a = pages[g]->widgets;
+            const auto& b = parsed[p].pages[g].widgets;
+            same = a.size() == b.size();
+            for (size_t w = 0; same && w < a.size(); w++) same = widget_config_equal(a[w], b[w]);
+        }
+    }
+
+    // v1 migration: a full profile of 12-button grid pages
+    JsonDocument v1;
+    JsonArray pages = v1["pages"].to<JsonArray>();
+    for (int p = 0; p < BENCH_PAGES; p++) {
+        JsonObject page = pages.add<JsonObject>();
+        page["name"] = "v1";
+        JsonArray buttons = page["buttons"].to<JsonArray>();
+        for (int i = 0; i < 12; i++) {
+            JsonObject btn = buttons.add<JsonObject>();
+            btn["label"] = "Key";
+            btn["keycode"] = 'a' + i;
+            btn["modifiers"] = MOD_CTRL;
+            btn["grid_row"] = i / GRID_COLS;
+            btn["grid_col"] = i % GRID_COLS;
+        }
+    }
+    t0 = micros();
+    for (int i = 0; i < BENCH_CONFIG_ITERS; i++) {
+        ProfileConfig profile;
+        json_to_profile(v1.as<JsonObject>(), profile, 1);
+    }
+    uint32_t migrate_us = (micros() - t0) / BENCH_CONFIG_ITERS;
+
+    Serial.printf("CONFIG: bench %zu profiles, %d widgets, %u B JSON: serialize %lu us, parse %lu us, round trip %s\n",
+                  cfg.profiles.size(), widgets, (unsigned)json.length(),
+                  (unsigned long)save_us, (unsigned long)parse_us, same ? "ok" : "MISMATCH");
+    Serial.printf("CONFIG: bench v1 migration %d pages x 12 buttons: %lu us\n",
+                  BENCH_PAGES, (unsigned long)migrate_us);
+}
+
+void config_benchmark(const AppConfig& config) {
+    bench_protocol();
+    bench_config(config);
+}
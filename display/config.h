@@ -3,6 +3,8 @@
 #include <stdint.h>
 #include <vector>
 #include <string>
+#include "protocol.h"
+#include "config_str.h"
 
 // ============================================================
 // Configuration Schema for WYSIWYG Widget Layouts
@@ -13,11 +15,14 @@
 // v2: WYSIWYG absolute pixel positioning with widget types
 #define CONFIG_VERSION 2
 
-// Maximum pages per profile (validated on load)
-#define CONFIG_MAX_PAGES 16
+// Ceilings on pages per profile and widgets per page. Within them a page
+// holds what fits its memory and render budgets (config_cost.h); widget
+// indices are uint8_t in the renderers and hit grid, int8_t for focus.
+#define CONFIG_MAX_PAGES 64
+#define CONFIG_MAX_WIDGETS 127
 
-// Maximum widgets per page
-#define CONFIG_MAX_WIDGETS 32
+// Maximum widget templates per profile
+#define CONFIG_MAX_TEMPLATES 32
 
 // Display dimensions
 #define DISPLAY_WIDTH  800
@@ -40,6 +45,12 @@
 //
 // Format: profiles[] contains pages, each page contains widgets
 // JSON: { "profiles": [ { "name": "...", "pages": [ { "widgets": [...] } ] } ] }
+//
+// A profile may also hold named templates: "templates": { "key": {widget
+// fields} }. A widget with "template": "key" takes every field it doesn't
+// set itself from that template, so rows of near-identical buttons only
+// spell out their label and key. Resolved once while the profile is parsed;
+// the rest of the firmware only ever sees complete WidgetConfigs.
 
 // ============================================================
 // Widget Types
@@ -53,9 +64,27 @@ enum WidgetType : uint8_t {
     WIDGET_TEXT_LABEL    = 4,    // Static text with configurable font/color
     WIDGET_SEPARATOR     = 5,    // Horizontal or vertical divider line
     WIDGET_PAGE_NAV      = 6,    // Visual page indicator dots/arrows
+    WIDGET_STAT_GRAPH    = 7,    // Scrolling history (sparkline) of one system stat
+    WIDGET_TRACKPAD      = 8,    // Touch area driving the host pointer (mouse or absolute)
+    WIDGET_REMOTE_IMAGE  = 9,    // Image streamed by the companion (album art, thumbnails)
+    WIDGET_SCROLL_GRID   = 10,   // Scrolling list/grid of launcher entries (hundreds of apps)
 };
 
-#define WIDGET_TYPE_MAX 6
+#define WIDGET_TYPE_MAX 10
+
+#define TRACKPAD_SPEED_MIN     1    // Pointer speed in tenths (1 = 0.1x .. 50 = 5x)
+#define TRACKPAD_SPEED_MAX     50
+#define TRACKPAD_SPEED_DEFAULT 15
+
+#define GRAPH_POINTS_MIN     8
+#define GRAPH_POINTS_MAX     240
+#define GRAPH_POINTS_DEFAULT 60   // 1 sample/s -> one minute of history
+
+#define GRID_ENTRIES_MAX        512
+#define GRID_COLUMNS_MAX        8     // 1 = list
+#define GRID_ROW_HEIGHT_MIN     40
+#define GRID_ROW_HEIGHT_MAX     240
+#define GRID_ROW_HEIGHT_DEFAULT 96
 
 // ============================================================
 // Button Action Types (used by WIDGET_HOTKEY_BUTTON)
@@ -80,6 +109,72 @@ enum ActionType : uint8_t {
     ACTION_FOCUS_NEXT = 15,       // Focus next button on current page (display-local)
     ACTION_FOCUS_PREV = 16,       // Focus previous button on current page (display-local)
     ACTION_FOCUS_ACTIVATE = 17,   // Activate (press) the currently focused button (display-local)
+    ACTION_MACRO = 18,            // Key sequence played back by the bridge (macro_steps)
+    ACTION_PERF_HUD = 19,         // Toggle render performance overlay (display-local)
+    ACTION_PROFILE_GOTO = 20,     // Switch to profile by index (uses keycode as profile number)
+    ACTION_PROFILE_NEXT = 21,     // Switch to the next profile, wrapping around (display-local)
+    ACTION_HOST_NEXT = 22,        // Switch to the next paired bridge/PC (display-local)
+    ACTION_HOST_PAIR = 23,        // Accept one more bridge for the next 30 s (display-local)
+    ACTION_TYPE_TEXT = 24,        // Type type_text in the host's key_layout (bridge plays it)
+};
+
+// ============================================================
+// Stat Alert Rules (WIDGET_STAT_MONITOR / WIDGET_STAT_GRAPH)
+// ============================================================
+//
+// Checked on the display as each value arrives. A rule holds from the
+// moment the value reaches its threshold until it is back `hysteresis`
+// past it; of the rules holding, the last one listed sets the colour, so
+// bands go from mild to severe:
+//   "rules": [ {"above": 70, "color": 16776960},
+//              {"above": 85, "hysteresis": 3, "color": 16711680, "blink": true, "toast": true} ]
+
+#define STAT_RULES_MAX 4
+
+enum StatRuleFlags : uint8_t {
+    RULE_BELOW = 0x01,        // Holds at value <= threshold (else >=)
+    RULE_BLINK = 0x02,        // Blink the value while this rule sets the colour
+    RULE_TOAST = 0x04,        // Toast each time the rule starts holding
+};
+
+struct StatRule {
+    int32_t threshold;        // Stat units as displayed (load average x100, like graph_max)
+    uint32_t color;           // Value / graph colour while active, 0 = keep the widget's own
+    uint16_t hysteresis;      // Same units
+    uint8_t flags;            // StatRuleFlags
+    uint8_t reserved;         // Keeps the struct free of padding (cache, memcmp)
+
+    bool operator==(const StatRule &o) const {
+        return threshold == o.threshold && color == o.color && hysteresis == o.hysteresis &&
+               flags == o.flags;
+    }
+};
+
+// ============================================================
+// Scroll Grid Entries (WIDGET_SCROLL_GRID)
+// ============================================================
+//
+// One launcher cell. Display-local, hotkey and media actions run on the
+// display like a button's; the PC-side ones (launch, shell, URL) are sent
+// as a button press carrying the entry index, and the companion looks the
+// command up in its copy of the entry.
+
+struct GridEntry {
+    ConfigStr label;
+    ConfigStr icon_path;      // SD card image, loaded when the cell scrolls into view
+    ActionType action_type;
+    uint8_t modifiers;
+    uint8_t keycode;
+    uint16_t consumer_code;
+
+    GridEntry()
+        : label(""), icon_path(""), action_type(ACTION_LAUNCH_APP), modifiers(0), keycode(0),
+          consumer_code(0) {}
+
+    bool operator==(const GridEntry &o) const {
+        return label == o.label && icon_path == o.icon_path && action_type == o.action_type &&
+               modifiers == o.modifiers && keycode == o.keycode && consumer_code == o.consumer_code;
+    }
 };
 
 // ============================================================
@@ -95,21 +190,23 @@ struct WidgetConfig {
 
     // --- Common properties ---
     WidgetType widget_type;   // Which widget type this is
-    std::string label;        // Display label (used by most widget types)
+    ConfigStr label;          // Display label (used by most widget types)
     bool show_label;          // Whether to render label on device
     uint32_t color;           // Primary color (0xRRGGBB)
     uint32_t bg_color;        // Background color (0xRRGGBB, 0 = transparent/default)
+    uint8_t template_id;      // 0 = none, N = the profile's templates[N-1] (keeps saves compact)
 
     // --- Hotkey Button properties (widget_type == WIDGET_HOTKEY_BUTTON) ---
-    std::string description;  // Tooltip description (e.g., "Super+1")
+    ConfigStr description;    // Tooltip description (e.g., "Super+1")
     bool show_description;    // Whether to render description on device
-    std::string icon;         // LVGL symbol string (e.g., LV_SYMBOL_HOME)
-    std::string icon_path;    // SD card image path (e.g., "/icons/calc.png") — overrides icon symbol
+    ConfigStr icon;           // LVGL symbol string (e.g., LV_SYMBOL_HOME)
+    ConfigStr icon_path;      // SD card image path (e.g., "/icons/calc.png") — overrides icon symbol
     ActionType action_type;   // HOTKEY or MEDIA_KEY
     uint8_t modifiers;        // MOD_CTRL | MOD_SHIFT | MOD_ALT | MOD_GUI
     uint8_t keycode;          // ASCII key or special key code
     uint16_t consumer_code;   // USB HID consumer control code (for MEDIA_KEY)
     uint32_t pressed_color;   // 0x000000 = auto-darken, else explicit color
+    bool fire_on_press;       // Send on touch-down (hit grid fast path), not on release
 
     // --- DDC Monitor Control properties (action_type == ACTION_DDC) ---
     uint8_t ddc_vcp_code;     // DDC VCP code (0x10=brightness, 0x12=contrast, etc.)
@@ -117,9 +214,23 @@ struct WidgetConfig {
     int16_t ddc_adjustment;   // Signed step (+/-), 0 = use absolute value
     uint8_t ddc_display;      // ddcutil --display N (0 = auto-detect)
 
+    // --- Macro properties (action_type == ACTION_MACRO) ---
+    std::vector<MacroStep> macro_steps;  // Sent as one MSG_MACRO (max MACRO_MAX_STEPS)
+
+    // --- Type Text properties (action_type == ACTION_TYPE_TEXT) ---
+    ConfigStr type_text;      // UTF-8, max TYPE_TEXT_MAX_BYTES (sent as one MSG_TYPE_TEXT)
+    uint8_t key_layout;       // KeyLayout of the host (key_layouts.h)
+
     // --- Stat Monitor properties (widget_type == WIDGET_STAT_MONITOR) ---
     uint8_t stat_type;        // StatType enum value (1-23)
     uint8_t value_position;   // 0=inline (default), 1=value top/label bottom, 2=label top/value bottom
+    uint8_t stat_host;        // 0 = the active host, N = always host slot N-1 (espnow_link.h)
+    uint8_t stat_remote;      // 0 = the host's own stats, N = remote collector N (MSG_HOST_STATS)
+    std::vector<StatRule> stat_rules;  // Alert colours/blink/toast, also for graphs (max STAT_RULES_MAX)
+
+    // --- Stat Graph properties (widget_type == WIDGET_STAT_GRAPH, also uses stat_type) ---
+    uint16_t graph_points;    // History length in samples (GRAPH_POINTS_MIN..MAX)
+    uint16_t graph_max;       // Fixed Y-axis maximum, 0 = auto (100 for percentages)
 
     // --- Clock properties (widget_type == WIDGET_CLOCK) ---
     bool clock_analog;        // true = analog, false = digital
@@ -134,28 +245,51 @@ struct WidgetConfig {
     uint8_t icon_spacing;     // Spacing between status bar icons in pixels (2-20)
 
     // --- Text Label properties (widget_type == WIDGET_TEXT_LABEL) ---
-    uint8_t font_size;        // Font size (12, 14, 16, 20, 22, 28, 40)
+    uint8_t font_size;        // Font size px (12-40 in flash, others from /fonts/<size>.bin)
     uint8_t text_align;       // 0=left, 1=center, 2=right
 
     // --- Separator properties (widget_type == WIDGET_SEPARATOR) ---
     bool separator_vertical;  // true = vertical, false = horizontal
     uint8_t thickness;        // Line thickness in pixels (1-8)
 
+    // --- Trackpad properties (widget_type == WIDGET_TRACKPAD) ---
+    bool trackpad_absolute;   // true = widget maps onto the whole screen, false = relative mouse
+    uint8_t trackpad_speed;   // Relative pointer speed in tenths (TRACKPAD_SPEED_MIN..MAX)
+
+    // --- Remote Image properties (widget_type == WIDGET_REMOTE_IMAGE) ---
+    ConfigStr image_source;   // Companion source ("now_playing", "file:/path/to.png")
+
+    // --- Scroll Grid properties (widget_type == WIDGET_SCROLL_GRID) ---
+    uint8_t grid_columns;     // Cells per row (1 = list, max GRID_COLUMNS_MAX)
+    uint16_t grid_row_height; // Row height in pixels (GRID_ROW_HEIGHT_MIN..MAX)
+    std::vector<GridEntry> grid_entries;  // Max GRID_ENTRIES_MAX; only visible rows get LVGL objects
+
     // Constructor with defaults
     WidgetConfig()
         : x(0), y(0), width(180), height(100),
           widget_type(WIDGET_HOTKEY_BUTTON),
-          label(""), show_label(true), color(0xFFFFFF), bg_color(0),
+          label(""), show_label(true), color(0xFFFFFF), bg_color(0), template_id(0),
           description(""), show_description(true), icon(""), icon_path(""),
           action_type(ACTION_HOTKEY), modifiers(0), keycode(0),
-          consumer_code(0), pressed_color(0x000000),
+          consumer_code(0), pressed_color(0x000000), fire_on_press(false),
           ddc_vcp_code(0), ddc_value(0), ddc_adjustment(0), ddc_display(0),
-          stat_type(0), value_position(0),
+          macro_steps(), type_text(""), key_layout(0),
+          stat_type(0), value_position(0), stat_host(0), stat_remote(0), stat_rules(),
+          graph_points(GRAPH_POINTS_DEFAULT), graph_max(0),
           clock_analog(false),
           show_wifi(true), show_pc(true), show_settings(true), show_brightness(true),
           show_battery(true), show_time(true), icon_spacing(8),
           font_size(16), text_align(1),
-          separator_vertical(false), thickness(2) {}
+          separator_vertical(false), thickness(2),
+          trackpad_absolute(false), trackpad_speed(TRACKPAD_SPEED_DEFAULT),
+          image_source(""),
+          grid_columns(1), grid_row_height(GRID_ROW_HEIGHT_DEFAULT), grid_entries() {}
+};
+
+// A named template from a profile's "templates" (see the schema notes above)
+struct WidgetTemplate {
+    ConfigStr name;
+    WidgetConfig widget;      // The template parsed like a widget, for config_save()
 };
 
 // ============================================================
@@ -163,8 +297,8 @@ struct WidgetConfig {
 // ============================================================
 
 struct PageConfig {
-    std::string name;                       // Page name (e.g., "Window Manager")
-    std::string bg_image;                   // SD card path for background image (e.g., "/bkgnds/dark.png")
+    ConfigStr name;                         // Page name (e.g., "Window Manager")
+    ConfigStr bg_image;                     // SD card path for background image (e.g., "/bkgnds/dark.png")
     std::vector<WidgetConfig> widgets;      // Widgets on this page
 
     PageConfig() : name(""), bg_image(""), widgets() {}
@@ -192,8 +326,16 @@ struct StatConfig {
 struct ProfileConfig {
     std::string name;                     // Profile name (e.g., "Hyprland Default")
     std::vector<PageConfig> pages;        // Pages in this profile
+    uint8_t host;                         // 0 = any, N = shown when host slot N-1 becomes active
+    std::vector<WidgetTemplate> templates; // Already resolved into the widgets (max CONFIG_MAX_TEMPLATES)
+
+    // config_load() only parses the active profile; the others keep their
+    // position in /config.json and are parsed by config_load_profile()
+    bool loaded;                          // false = pages not parsed yet
+    uint32_t json_offset;                 // Byte offset of the profile object
+    uint8_t json_version;                 // Schema version of that file
 
-    ProfileConfig() : name(""), pages() {}
+    ProfileConfig() : name(""), pages(), host(0), templates(), loaded(true), json_offset(0), json_version(CONFIG_VERSION) {}
 };
 
 // ============================================================
@@ -230,6 +372,25 @@ struct EncoderConfig {
                       encoder_mode(0), ddc_vcp_code(0x10), ddc_step(10), ddc_display(0) {}
 };
 
+// Touch gesture bindings (swipes are fixed to page navigation)
+struct GestureAction {
+    bool enabled;
+    ActionType action_type;
+    uint8_t keycode;        // HOTKEY keycode or PAGE_GOTO page number
+    uint16_t consumer_code; // For MEDIA_KEY
+    uint8_t modifiers;      // For HOTKEY modifiers
+    GestureAction(bool en, ActionType type) : enabled(en), action_type(type), keycode(0),
+                                              consumer_code(0), modifiers(0) {}
+};
+
+struct GestureConfig {
+    bool swipe_pages;              // Horizontal swipe -> next/previous page
+    GestureAction two_finger_tap;
+    GestureAction long_press;      // Off by default: widgets use their own long-press
+    GestureConfig() : swipe_pages(true), two_finger_tap(true, ACTION_PAGE_GOTO),
+                      long_press(false, ACTION_MODE_CYCLE) {}
+};
+
 struct ModeCycleConfig {
     std::vector<uint8_t> enabled_modes; // DisplayMode values in rotation order
     ModeCycleConfig() : enabled_modes({0, 1, 2, 3}) {} // All modes by default
@@ -243,10 +404,14 @@ struct DisplaySettings {
     uint32_t clock_color_theme;
     uint16_t slideshow_interval_sec;
     std::string slideshow_transition;   // "fade", "slide", "none"
+    bool slideshow_shuffle;             // Random order (else upload order)
+    uint8_t battery_saver_pct;          // On battery at or below: saver policy (0 = off)
+    uint8_t battery_critical_pct;       // On battery at or below: critical policy (0 = off)
     DisplaySettings() : dim_timeout_sec(60), sleep_timeout_sec(300),
                         wake_on_touch(true), clock_24h(true),
                         clock_color_theme(0xFFFFFF), slideshow_interval_sec(30),
-                        slideshow_transition("fade") {}
+                        slideshow_transition("fade"), slideshow_shuffle(false),
+                        battery_saver_pct(30), battery_critical_pct(15) {}
 };
 
 // ============================================================
@@ -263,6 +428,7 @@ struct AppConfig {
     uint8_t default_mode;                 // DisplayMode enum value (0=HOTKEYS, 1=CLOCK, 2=PICTURE_FRAME, 3=STANDBY)
     uint16_t slideshow_interval_sec;      // Picture frame slideshow interval in seconds (default 30)
     bool clock_analog;                    // true = analog clock, false = digital clock (global fallback)
+    bool clock_seconds;                   // Analog clock: sweeping second hand
 
     // Stats header configuration (for stat monitor widgets without explicit config)
     std::vector<StatConfig> stats_header; // User-selected stats (default 8, max CONFIG_MAX_STATS)
@@ -270,12 +436,14 @@ struct AppConfig {
     // Hardware input configuration
     HwButtonConfig hw_buttons[4];
     EncoderConfig encoder;
+    GestureConfig gestures;
     ModeCycleConfig mode_cycle;
     DisplaySettings display_settings;
 
     AppConfig() : version(CONFIG_VERSION), active_profile_name(""), profiles(), brightness_level(100),
-                  default_mode(0), slideshow_interval_sec(30), clock_analog(false), stats_header(),
-                  hw_buttons(), encoder(), mode_cycle(), display_settings() {}
+                  default_mode(0), slideshow_interval_sec(30), clock_analog(false), clock_seconds(false),
+                  stats_header(),
+                  hw_buttons(), encoder(), gestures(), mode_cycle(), display_settings() {}
 
     // Helper: Get currently active profile
     ProfileConfig* get_active_profile() {
@@ -311,14 +479,54 @@ struct AppConfig {
 // Configuration I/O Helpers (declared in config.cpp)
 // ============================================================
 
-// Load configuration from SD card (/config.json)
+// Load configuration from SD card (/config.json), streamed from the file:
+// settings plus the active profile only (see ProfileConfig::loaded)
 // Returns AppConfig with defaults on failure
 // Handles v1→v2 migration automatically
-AppConfig config_load();
+// *from_sd (optional) tells the file's contents from that fallback
+AppConfig config_load(bool *from_sd = nullptr);
+
+// Parse a profile config_load() only indexed (no-op if already loaded).
+// Call before switching active_profile_name to it.
+bool config_load_profile(ProfileConfig& profile);
 
 // Save configuration to SD card (/config.json)
-// Writes JSON atomically: write to /config.tmp, rename to /config.json
+// Writes JSON atomically: stream to /config.tmp, check it reads back with
+// the CRC computed while writing, rename to /config.json
 bool config_save(const AppConfig& config);
 
+// True if the file at path is exactly `size` bytes with CRC32 `crc` (one
+// chunked read, no parse)
+bool config_file_matches(const char *path, uint32_t size, uint32_t crc);
+
 // Create default configuration (hardcoded builtin profiles)
 AppConfig config_create_defaults();
+
+// Field-by-field comparison (rebuild_ui() patches only widgets that differ).
+// template_id is left out: it records where the fields came from, not what they are.
+bool widget_config_equal(const WidgetConfig& a, const WidgetConfig& b);
+
+// Apply a JSON-patch style edit to the active profile in place (live_edit.cpp).
+// One op or an array of them, optionally wrapped as {"profile": name,
+// "patch": [...]} to refuse edits meant for another profile:
+//   {"op":"merge",   "path":"/pages/1/widgets/3", "value":{"x":120,"y":40}}
+//   {"op":"replace", "path":"/pages/1/widgets/3", "value":{...whole widget...}}
+//   {"op":"replace", "path":"/pages/1/widgets/3/label", "value":"Term"}
+//   {"op":"add",     "path":"/pages/1/widgets/-", "value":{...widget...}}
+//   {"op":"remove",  "path":"/pages/1/widgets/3"}
+//   {"op":"replace", "path":"/pages/1/name", "value":"Media"}   (or bg_image)
+//   {"op":"add",     "path":"/pages/-", "value":{"name":"New"}}, "remove" "/pages/2"
+// Widget values get the same defaults and validation as config_load(), and
+// a page edit must keep the page within its budgets (config_cost.h). All
+// or nothing: returns nullptr on success, else what was wrong (static
+// string). *page is the last page an op touched, -1 if none.
+const char* config_apply_patch(AppConfig& config, const char* json, size_t len, int* page);
+
+// Protocol (TLV decode/merge, CRC) and config (JSON save/parse round trip
+// on the current profiles plus a maximum-size one, v1 migration)
+// microbenchmarks, and a TLV fuzz pass; results to Serial. Runs once at
+// boot after config_load() when CONFIG_BENCH_AT_BOOT=1.
+#ifndef CONFIG_BENCH_AT_BOOT
+#define CONFIG_BENCH_AT_BOOT 0
+#endif
+void config_benchmark(const AppConfig& config);
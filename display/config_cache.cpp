@@ -0,0 +1,262 @@
+/**
+ * @file config_cache.cpp
+ * Binary AppConfig snapshot: header + field dump, written/read in one go
+ *
+ * One visit() per struct lists its fields in order; the same function drives
+ * both the writer and the reader, so the two can't drift apart. Trivially
+ * copyable fields are stored as raw little-endian bytes, strings and vectors
+ * as a u16 count followed by their contents.
+ *
+ * Bump CONFIG_CACHE_FORMAT whenever a visit() changes. The layout fingerprint
+ * (struct sizes) catches most forgotten bumps as well.
+ */
+
+#include "config_cache.h"
+#include "sdcard.h"
+#include "protocol.h"
+#include "mem_budget.h"
+#include <Arduino.h>
+#include <SD.h>
+#include <string.h>
+#include <type_traits>
+
+#define CONFIG_CACHE_MAGIC  0x47464343u   // "CCFG"
+#define CONFIG_CACHE_FORMAT 14
+#define CONFIG_CACHE_MAX    (256 * 1024)
+
+struct CacheHeader {
+    uint32_t magic;
+    uint16_t format;         // CONFIG_CACHE_FORMAT
+    uint16_t layout;         // layout_fingerprint() of the writing firmware
+    uint32_t json_size;      // Source /config.json
+    uint32_t json_crc;
+    uint32_t json_parse_us;  // Cost of the JSON path this snapshot replaces
+    uint32_t body_size;
+    uint32_t body_crc;
+};
+
+static uint16_t layout_fingerprint() {
+    const uint32_t sizes[] = {
+        CONFIG_VERSION, sizeof(WidgetConfig), sizeof(PageConfig), sizeof(ProfileConfig),
+        sizeof(StatConfig), sizeof(HwButtonConfig), sizeof(EncoderConfig), sizeof(GestureConfig),
+        sizeof(DisplaySettings), sizeof(AppConfig), sizeof(MacroStep), sizeof(StatRule),
+    };
+    uint32_t crc = crc32_update(0, (const uint8_t *)sizes, sizeof(sizes));
+    return (uint16_t)(crc ^ (crc >> 16));
+}
+
+// ============================================================
+// Field lists
+// ============================================================
+
+template <typename IO> static void visit(IO &io, WidgetConfig &w);
+template <typename IO> static void visit(IO &io, WidgetTemplate &t);
+template <typename IO> static void visit(IO &io, PageConfig &p);
+template <typename IO> static void visit(IO &io, ProfileConfig &p);
+template <typename IO> static void visit(IO &io, HwButtonConfig &b);
+template <typename IO> static void visit(IO &io, EncoderConfig &e);
+template <typename IO> static void visit(IO &io, DisplaySettings &d);
+template <typename IO> static void visit(IO &io, AppConfig &c);
+
+struct CacheWriter {
+    std::vector<uint8_t> out;
+
+    template <typename T> void operator()(T &v) {
+        if constexpr (std::is_trivially_copyable<T>::value) {
+            const uint8_t *p = (const uint8_t *)&v;
+            out.insert(out.end(), p, p + sizeof(T));
+        } else {
+            visit(*this, v);
+        }
+    }
+    void operator()(std::string &s) {
+        uint16_t n = (uint16_t)s.size();
+        (*this)(n);
+        out.insert(out.end(), s.begin(), s.begin() + n);
+    }
+    void operator()(ConfigStr &s) {
+        uint16_t n = (uint16_t)s.size();
+        (*this)(n);
+        out.insert(out.end(), s.c_str(), s.c_str() + n);
+    }
+    template <typename T> void operator()(std::vector<T> &v) {
+        uint16_t n = (uint16_t)v.size();
+        (*this)(n);
+        for (uint16_t i = 0; i < n; i++) (*this)(v[i]);
+    }
+};
+
+struct CacheReader {
+    const uint8_t *p;
+    const uint8_t *end;
+    bool ok;
+
+    bool take(void *dst, size_t n) {
+        if (!ok || (size_t)(end - p) < n) { ok = false; return false; }
+        memcpy(dst, p, n);
+        p += n;
+        return true;
+    }
+    template <typename T> void operator()(T &v) {
+        if constexpr (std::is_trivially_copyable<T>::value) {
+            take(&v, sizeof(T));
+        } else {
+            visit(*this, v);
+        }
+    }
+    void operator()(std::string &s) {
+        uint16_t n = 0;
+        if (!take(&n, sizeof(n)) || (size_t)(end - p) < n) { ok = false; return; }
+        s.assign((const char *)p, n);
+        p += n;
+    }
+    void operator()(ConfigStr &s) {
+        uint16_t n = 0;
+        if (!take(&n, sizeof(n)) || (size_t)(end - p) < n) { ok = false; return; }
+        s = ConfigStr((const char *)p, n);   // Interned: repeated icons share one entry
+        p += n;
+    }
+    template <typename T> void operator()(std::vector<T> &v) {
+        uint16_t n = 0;
+        // Every element takes at least one byte: rejects absurd counts before resize()
+        if (!take(&n, sizeof(n)) || (size_t)(end - p) < n) { ok = false; return; }
+        v.resize(n);
+        for (uint16_t i = 0; i < n && ok; i++) (*this)(v[i]);
+    }
+};
+
+template <typename IO> static void visit(IO &io, GridEntry &e) {
+    io(e.label); io(e.icon_path);
+    io(e.action_type); io(e.modifiers); io(e.keycode); io(e.consumer_code);
+}
+
+template <typename IO> static void visit(IO &io, WidgetConfig &w) {
+    io(w.x); io(w.y); io(w.width); io(w.height);
+    io(w.widget_type); io(w.label); io(w.show_label); io(w.color); io(w.bg_color); io(w.template_id);
+    io(w.description); io(w.show_description); io(w.icon); io(w.icon_path);
+    io(w.action_type); io(w.modifiers); io(w.keycode); io(w.consumer_code); io(w.pressed_color);
+    io(w.fire_on_press);
+    io(w.ddc_vcp_code); io(w.ddc_value); io(w.ddc_adjustment); io(w.ddc_display);
+    io(w.macro_steps); io(w.type_text); io(w.key_layout);
+    io(w.stat_type); io(w.value_position); io(w.stat_host); io(w.stat_remote); io(w.stat_rules);
+    io(w.graph_points); io(w.graph_max);
+    io(w.clock_analog);
+    io(w.show_wifi); io(w.show_pc); io(w.show_settings); io(w.show_brightness);
+    io(w.show_battery); io(w.show_time); io(w.icon_spacing);
+    io(w.font_size); io(w.text_align);
+    io(w.separator_vertical); io(w.thickness);
+    io(w.trackpad_absolute); io(w.trackpad_speed);
+    io(w.image_source);
+    io(w.grid_columns); io(w.grid_row_height); io(w.grid_entries);
+}
+
+template <typename IO> static void visit(IO &io, WidgetTemplate &t) {
+    io(t.name); io(t.widget);
+}
+
+template <typename IO> static void visit(IO &io, PageConfig &p) {
+    io(p.name); io(p.bg_image); io(p.widgets);
+}
+
+template <typename IO> static void visit(IO &io, ProfileConfig &p) {
+    io(p.name); io(p.pages); io(p.host); io(p.templates); io(p.loaded); io(p.json_offset); io(p.json_version);
+}
+
+template <typename IO> static void visit(IO &io, HwButtonConfig &b) {
+    io(b.action_type); io(b.label); io(b.keycode); io(b.consumer_code); io(b.modifiers);
+    io(b.ddc_vcp_code); io(b.ddc_value); io(b.ddc_adjustment); io(b.ddc_display);
+}
+
+template <typename IO> static void visit(IO &io, EncoderConfig &e) {
+    io(e.push_action); io(e.push_label); io(e.push_keycode); io(e.push_consumer_code);
+    io(e.push_modifiers); io(e.encoder_mode); io(e.ddc_vcp_code); io(e.ddc_step); io(e.ddc_display);
+}
+
+template <typename IO> static void visit(IO &io, DisplaySettings &d) {
+    io(d.dim_timeout_sec); io(d.sleep_timeout_sec); io(d.wake_on_touch); io(d.clock_24h);
+    io(d.clock_color_theme); io(d.slideshow_interval_sec); io(d.slideshow_transition);
+    io(d.slideshow_shuffle);
+    io(d.battery_saver_pct); io(d.battery_critical_pct);
+}
+
+template <typename IO> static void visit(IO &io, AppConfig &c) {
+    io(c.version); io(c.active_profile_name); io(c.profiles); io(c.brightness_level);
+    io(c.default_mode); io(c.slideshow_interval_sec); io(c.clock_analog); io(c.clock_seconds);
+    io(c.stats_header);
+    for (auto &b : c.hw_buttons) io(b);
+    io(c.encoder);
+    io(c.gestures.swipe_pages); io(c.gestures.two_finger_tap); io(c.gestures.long_press);
+    io(c.mode_cycle.enabled_modes);
+    io(c.display_settings);
+}
+
+// ============================================================
+// File I/O
+// ============================================================
+
+bool config_cache_load(uint32_t json_size, uint32_t json_crc, AppConfig &out, uint32_t *json_parse_us) {
+    if (!sdcard_mounted()) return false;
+
+    CacheHeader hdr;
+    File f = SD.open(CONFIG_CACHE_PATH, FILE_READ);
+    if (!f) return false;
+    size_t file_size = f.size();
+    bool hdr_ok = file_size > sizeof(hdr) && file_size <= CONFIG_CACHE_MAX &&
+                  f.read((uint8_t *)&hdr, sizeof(hdr)) == sizeof(hdr) &&
+                  hdr.magic == CONFIG_CACHE_MAGIC && hdr.format == CONFIG_CACHE_FORMAT &&
+                  hdr.layout == layout_fingerprint() && hdr.body_size == file_size - sizeof(hdr);
+    if (!hdr_ok || hdr.json_size != json_size || hdr.json_crc != json_crc) {
+        f.close();
+        if (hdr_ok) Serial.println("CONFIG: " CONFIG_CACHE_PATH " is stale");
+        return false;
+    }
+
+    uint8_t *body = (uint8_t *)mem_alloc(MEM_POOL_CONFIG, hdr.body_size);
+    if (!body) { f.close(); return false; }
+    bool ok = f.read(body, hdr.body_size) == hdr.body_size &&
+              crc32_update(0, body, hdr.body_size) == hdr.body_crc;
+    f.close();
+
+    if (ok) {
+        AppConfig cfg;
+        CacheReader rd = { body, body + hdr.body_size, true };
+        rd(cfg);
+        ok = rd.ok && rd.p == rd.end;
+        if (ok) out = std::move(cfg);
+    }
+    mem_free(MEM_POOL_CONFIG, body);
+    if (!ok) {
+        Serial.println("CONFIG: " CONFIG_CACHE_PATH " corrupt, ignoring");
+        return false;
+    }
+    if (json_parse_us) *json_parse_us = hdr.json_parse_us;
+    return true;
+}
+
+bool config_cache_save(const AppConfig &config, uint32_t json_size, uint32_t json_crc, uint32_t json_parse_us) {
+    if (!sdcard_mounted()) return false;
+
+    CacheWriter wr;
+    wr.out.reserve(8192);
+    wr.out.resize(sizeof(CacheHeader));
+    wr(const_cast<AppConfig &>(config));   // Writer only reads through the reference
+
+    CacheHeader hdr;
+    hdr.magic = CONFIG_CACHE_MAGIC;
+    hdr.format = CONFIG_CACHE_FORMAT;
+    hdr.layout = layout_fingerprint();
+    hdr.json_size = json_size;
+    hdr.json_crc = json_crc;
+    hdr.json_parse_us = json_parse_us;
+    hdr.body_size = wr.out.size() - sizeof(hdr);
+    hdr.body_crc = crc32_update(0, wr.out.data() + sizeof(hdr), hdr.body_size);
+    memcpy(wr.out.data(), &hdr, sizeof(hdr));
+
+    if (!sdcard_write_file(CONFIG_CACHE_PATH ".tmp", wr.out.data(), wr.out.size()) ||
+        !sdcard_file_rename(CONFIG_CACHE_PATH ".tmp", CONFIG_CACHE_PATH)) {
+        Serial.println("CONFIG: WARNING - could not write " CONFIG_CACHE_PATH);
+        return false;
+    }
+    Serial.printf("CONFIG: wrote " CONFIG_CACHE_PATH " (%u bytes)\n", (unsigned)wr.out.size());
+    return true;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <stdint.h>
+#include "config.h"
+
+// ============================================================
+// Binary config snapshot (/config.bin)
+//
+// The parsed AppConfig is stored next to /config.json as a flat field dump,
+// tagged with the size and CRC-32 of the JSON it was built from. When the
+// JSON on the card still matches, config_load() decodes the snapshot instead
+// of running ArduinoJson over the whole file. Any mismatch (JSON edited or
+// replaced, snapshot from another firmware layout, bad body CRC) falls back
+// to the JSON path, which then rewrites the snapshot.
+// ============================================================
+
+#define CONFIG_CACHE_PATH "/config.bin"
+
+// Decode the snapshot into `out` if it was built from JSON with this size/CRC.
+// `json_parse_us` receives how long the JSON path took when it was written
+// (0 if unknown), for the boot log.
+bool config_cache_load(uint32_t json_size, uint32_t json_crc, AppConfig &out, uint32_t *json_parse_us);
+
+// Write the snapshot for `config`, parsed from JSON with this size/CRC
+bool config_cache_save(const AppConfig &config, uint32_t json_size, uint32_t json_crc, uint32_t json_parse_us);
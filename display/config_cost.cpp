@@ -0,0 +1,118 @@
+/**
+ * @file config_cost.cpp
+ * Per-widget-type cost table and page budget admission (config_cost.h)
+ */
+
+#include "config_cost.h"
+#include <lvgl.h>
+
+// Only realized rows of a scroll grid get objects (ui.cpp)
+#define COST_GRID_CELL_GAP     6
+#define COST_GRID_OVERSCAN     1
+#define COST_GRID_CELL_HEAP    900   // Cell button, icon and label
+#define COST_GRID_CELL_OBJECTS 3
+
+// Per 200x120 instance, as sim --cost-table measures them
+static const WidgetCost COSTS[WIDGET_TYPE_MAX + 1] = {
+    /* HOTKEY_BUTTON */ { 1100, 4, 60 },
+    /* STAT_MONITOR  */ {  700, 3, 30 },
+    /* STATUS_BAR    */ { 1800, 9, 20 },
+    /* CLOCK         */ {  900, 2, 25 },   // Digital; analog adds its face below
+    /* TEXT_LABEL    */ {  400, 1, 25 },
+    /* SEPARATOR     */ {  250, 1, 10 },
+    /* PAGE_NAV      */ { 1200, 6, 15 },
+    /* STAT_GRAPH    */ { 1400, 2, 80 },
+    /* TRACKPAD      */ {  500, 2, 15 },
+    /* REMOTE_IMAGE  */ {  500, 1, 40 },
+    /* SCROLL_GRID   */ {  800, 1, 50 },
+};
+
+const WidgetCost &config_cost_of_type(uint8_t t) {
+    return COSTS[t <= WIDGET_TYPE_MAX ? t : WIDGET_HOTKEY_BUTTON];
+}
+
+// A decoded icon fit into a max_w x max_h box: RGB565 + alpha (icon_cache.h)
+static uint32_t icon_bytes(int max_w, int max_h) {
+    if (max_w < 1) max_w = 1;
+    if (max_h < 1) max_h = 1;
+    return (uint32_t)max_w * max_h * 3;
+}
+
+void config_cost_add(const WidgetConfig &w, LayoutCost &acc) {
+    const WidgetCost &c = config_cost_of_type(w.widget_type);
+    uint32_t area = (uint32_t)(w.width > 0 ? w.width : 0) * (uint32_t)(w.height > 0 ? w.height : 0);
+    acc.heap += c.heap;
+    acc.objects += c.objects;
+    acc.render_us += c.render_us_kpx * area / 1000;
+
+    switch (w.widget_type) {
+        case WIDGET_HOTKEY_BUTTON:
+            if (!w.icon_path.empty()) {
+                // Same fit boxes as the button renderer
+                bool icon_only = !(w.show_label && !w.label.empty()) &&
+                                 !(w.show_description && !w.description.empty());
+                acc.image_bytes += icon_only ? icon_bytes(w.width * 8 / 10, w.height * 8 / 10)
+                                             : icon_bytes(w.width * 6 / 10, w.height * 4 / 10);
+            }
+            break;
+        case WIDGET_TEXT_LABEL:
+            acc.heap += w.label.size();
+            break;
+        case WIDGET_CLOCK:
+            if (w.clock_analog) {
+                acc.heap += 1500;             // Hands and ticks
+                acc.objects += 4;
+                acc.image_bytes += area * 2;  // Pre-drawn face
+            }
+            break;
+        case WIDGET_STAT_GRAPH:
+            acc.heap += (uint32_t)w.graph_points * sizeof(lv_coord_t);
+            break;
+        case WIDGET_REMOTE_IMAGE:
+            acc.image_bytes += area * 2;      // RGB565 frame of the source
+            break;
+        case WIDGET_SCROLL_GRID: {
+            int cols = w.grid_columns ? w.grid_columns : 1;
+            int row_h = w.grid_row_height ? w.grid_row_height : GRID_ROW_HEIGHT_DEFAULT;
+            int rows = ((int)w.grid_entries.size() + cols - 1) / cols;
+            int pool = (w.height + row_h - 1) / row_h + 1 + 2 * COST_GRID_OVERSCAN;
+            if (pool > rows) pool = rows;
+            uint32_t cells = (uint32_t)pool * cols;
+            int cell_w = (w.width - COST_GRID_CELL_GAP * (cols + 1)) / cols;
+            int cell_h = row_h - COST_GRID_CELL_GAP;
+            acc.heap += cells * COST_GRID_CELL_HEAP;
+            acc.objects += cells * COST_GRID_CELL_OBJECTS;
+            acc.image_bytes += cells * (cols == 1 ? icon_bytes(cell_h - 8, cell_h - 8)
+                                                  : icon_bytes(cell_w * 6 / 10, cell_h - 32));
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+LayoutCost config_cost_page(const PageConfig &page) {
+    LayoutCost cost = {};
+    for (const auto &w : page.widgets) config_cost_add(w, cost);
+    return cost;
+}
+
+const char *config_cost_check(const LayoutCost &cost) {
+    if (cost.heap > CONFIG_PAGE_HEAP_BUDGET) return "page over its LVGL heap budget";
+    if (cost.image_bytes > CONFIG_PAGE_IMAGE_BUDGET) return "page over its image budget";
+    if (cost.render_us > CONFIG_PAGE_RENDER_BUDGET_US) return "page over its render time budget";
+    return nullptr;
+}
+
+size_t config_cost_fit(const PageConfig &page, LayoutCost *cost) {
+    LayoutCost acc = {};
+    size_t n = 0;
+    for (; n < page.widgets.size(); n++) {
+        LayoutCost next = acc;
+        config_cost_add(page.widgets[n], next);
+        if (config_cost_check(next)) break;
+        acc = next;
+    }
+    if (cost) *cost = acc;
+    return n;
+}
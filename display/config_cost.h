@@ -0,0 +1,63 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+#include "mem_budget.h"
+#include "icon_cache.h"
+
+// ============================================================
+// Layout cost model: what a page costs the display once realized
+//
+// Per widget type (WidgetCost): LVGL heap bytes and objects of one
+// instance, and the software render time per 1000 px of its area. Types
+// that scale add their own terms: graph history points, scroll grid cells
+// kept realized, label text, decoded icons. The table in config_cost.cpp
+// is refreshed from the simulator (.pio/build/sim/program --cost-table
+// <sd-dir>): its heap and object counts match the device, its host render
+// times want scaling by the ratio of a full-screen redraw there and in
+// /api/bench.
+//
+// config_load() and live-edit patches admit a page's widgets while they
+// fit its budgets, instead of a fixed count: a page of plain buttons can
+// hold far more than one of graphs and animated icons. CONFIG_MAX_PAGES
+// and CONFIG_MAX_WIDGETS are only the ceilings the index types allow.
+// GET /api/budget serves the table and budgets, and the companion's
+// ConfigManager.validate() checks layouts against them before uploading.
+// ============================================================
+
+#ifndef CONFIG_PAGE_HEAP_BUDGET
+#define CONFIG_PAGE_HEAP_BUDGET (MEM_BUDGET_LVGL / 4)   // The 3 cached pages + status bar, overlays
+#endif
+#ifndef CONFIG_PAGE_IMAGE_BUDGET
+#define CONFIG_PAGE_IMAGE_BUDGET ICON_CACHE_BYTES       // Icons a page shows stay pinned
+#endif
+#ifndef CONFIG_PAGE_RENDER_BUDGET_US
+#define CONFIG_PAGE_RENDER_BUDGET_US 200000             // Estimated full redraw of the page's widgets
+#endif
+
+struct WidgetCost {
+    uint16_t heap;           // LVGL bytes, one instance
+    uint8_t  objects;
+    uint8_t  render_us_kpx;  // Device render time per 1000 px of widget area
+};
+
+struct LayoutCost {
+    uint32_t heap;           // LVGL bytes
+    uint32_t image_bytes;    // Decoded icons, remote image and clock face buffers (images pool)
+    uint32_t render_us;
+    uint32_t objects;
+};
+
+// Table row for widget type t (entries past WIDGET_TYPE_MAX: a hotkey button's)
+const WidgetCost &config_cost_of_type(uint8_t t);
+
+// Add what widget w costs to acc
+void config_cost_add(const WidgetConfig &w, LayoutCost &acc);
+
+LayoutCost config_cost_page(const PageConfig &page);
+
+// nullptr if `cost` is within every page budget, else which one it is over
+const char *config_cost_check(const LayoutCost &cost);
+
+// How many of the page's leading widgets fit its budgets (*cost: theirs)
+size_t config_cost_fit(const PageConfig &page, LayoutCost *cost = nullptr);
@@ -1,484 +1,748 @@
 #include "config_server.h"
 #include <Arduino.h>
 #include <WiFi.h>
-#include <WebServer.h>
 #include <ArduinoOTA.h>
-#include <Update.h>
+#include <esp_http_server.h>
 #include <esp_wifi.h>
 #include <ArduinoJson.h>
 #include "sdcard.h"
 #include "config.h"
+#include "config_cost.h"
 #include "ui.h"
+#include "perf.h"
+#include "espnow_link.h"
+#include "ble_hid.h"
+#include "wired_link.h"
+#include "input_replay.h"
+#include "screenshot.h"
+#include "stats_log.h"
+#include "icon_cache.h"
+#include "anim_icon.h"
+#include "picture_index.h"
+#include "ota_update.h"
+#include "live_edit.h"
+#include "multipart.h"
+#include "protocol.h"
+#include "tasks.h"
+#include "trace.h"
+#include "loop_watch.h"
+#include "mem_budget.h"
+#include "i2c_bus.h"
+#include "hw_bench.h"
+#include "web_assets.h"
+#include <SD.h>
+#include <time.h>
+#include <ctype.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
 
 #define CONFIG_SSID     "CrowPanel-Config"
 #define CONFIG_PASS     "crowconfig"
 #define CONFIG_HOSTNAME "crowpanel"
-#define CONFIG_CHANNEL  1
 #define INACTIVITY_TIMEOUT_MS (5 * 60 * 1000)
-
-static bool active = false;
-static WebServer *web_server = nullptr;
+#define CONFIG_SERVER_POLL_MS 5   // ArduinoOTA and the live-edit socket need frequent service
+#define RESPONSE_BUF 1436         // One TCP segment at the SoftAP's MSS
+#define SERVER_TASK_STACK (8192 + RESPONSE_BUF)   // Handlers keep a response buffer on the stack
+#define SERVER_JOB_QUEUE (CONFIG_SERVER_WORKERS * 2)
+#define SERVER_RECV_RETRIES 3     // Socket read timeouts in a row before a body counts as dropped
+#define QUERY_MAX 256
+
+// The SoftAP, ArduinoOTA and the live-edit socket belong to the network
+// task (config_server_service); HTTP to esp_http_server's task and the
+// workers below. Start happens on the caller's task while nothing is
+// running yet; stop is a request the network task carries out. server_mutex
+// only covers start vs. the network task's stop, never a request handler or
+// a wait for one, so a UI-task caller can't deadlock against a handler
+// waiting on ui_lock().
+static volatile bool active = false;
+static volatile bool stop_requested = false;
+static volatile bool stopping = false;   // Handlers being wound down: no restart until done
+static SemaphoreHandle_t server_mutex = nullptr;
+static httpd_handle_t http_server = nullptr;
 static on_config_updated_callback_t g_callback = nullptr;
 
-// Inactivity tracking
-static uint32_t last_activity_time = 0;
+// Inactivity tracking (written by every handler task)
+static volatile uint32_t last_activity_time = 0;
 
 // Inactivity timeout latch (cleared on read)
-static bool g_timed_out = false;
-
-// Upload error propagation state
-static bool g_upload_success = false;
-static String g_upload_error = "";
-
-// Simple HTML upload form for configuration + OTA
-static const char config_html[] PROGMEM = R"rawliteral(
-<!DOCTYPE html><html><head><title>CrowPanel Config</title>
-<style>
-body {
-  font-family: sans-serif;
-  max-width: 600px;
-  margin: 40px auto;
-  padding: 20px;
-  text-align: center;
-  background: #1a1a2e;
-  color: #eee;
-}
-h2 { color: #3498db; }
-.container { background: #16213e; padding: 30px; border-radius: 8px; }
-input[type=file] { margin: 20px 0; display: block; }
-button {
-  padding: 12px 40px;
-  font-size: 16px;
-  background: #2ecc71;
-  border: none;
-  color: #fff;
-  border-radius: 8px;
-  cursor: pointer;
-  margin: 10px;
-}
-button:hover { background: #27ae60; }
-.info {
-  margin: 20px 0;
-  padding: 15px;
-  background: #0f3460;
-  border-left: 4px solid #3498db;
-  text-align: left;
-  border-radius: 4px;
-}
-.status { margin: 15px 0; font-size: 14px; color: #bdc3c7; }
-code { background: #0f3460; padding: 2px 6px; border-radius: 3px; font-family: monospace; }
-hr { opacity: 0.2; margin: 30px 0; }
-</style>
-<script>
-function uploadConfig() {
-  const fileInput = document.getElementById('configFile');
-  if (!fileInput.files.length) {
-    alert('Please select a config.json file');
-    return;
-  }
-
-  const formData = new FormData();
-  formData.append('config', fileInput.files[0]);
-
-  const statusDiv = document.getElementById('configStatus');
-  statusDiv.innerHTML = 'Uploading...';
-
-  fetch('/api/config/upload', {
-    method: 'POST',
-    body: formData
-  })
-  .then(response => response.json())
-  .then(data => {
-    if (data.success) {
-      statusDiv.innerHTML = '<span style="color: #2ecc71;">&#10003; Configuration updated! Rebuilding UI...</span>';
-      setTimeout(() => {
-        statusDiv.innerHTML = '<span style="color: #3498db;">UI rebuilt. Ready to use new configuration.</span>';
-      }, 2000);
-    } else {
-      statusDiv.innerHTML = '<span style="color: #e74c3c;">&#10007; Error: ' + (data.error || 'Unknown error') + '</span>';
-    }
-  })
-  .catch(error => {
-    statusDiv.innerHTML = '<span style="color: #e74c3c;">&#10007; Upload failed: ' + error + '</span>';
-  });
-}
-
-function uploadFirmware() {
-  const fileInput = document.getElementById('firmwareFile');
-  if (!fileInput.files.length) {
-    alert('Please select a .bin firmware file');
-    return;
-  }
-
-  const formData = new FormData();
-  formData.append('firmware', fileInput.files[0]);
-
-  const statusDiv = document.getElementById('otaStatus');
-  statusDiv.innerHTML = 'Uploading firmware...';
-
-  fetch('/update', {
-    method: 'POST',
-    body: formData
-  })
-  .then(response => response.text())
-  .then(data => {
-    if (data.indexOf('OK') >= 0) {
-      statusDiv.innerHTML = '<span style="color: #2ecc71;">&#10003; Firmware updated! Rebooting...</span>';
-    } else {
-      statusDiv.innerHTML = '<span style="color: #e74c3c;">&#10007; Firmware update failed</span>';
-    }
-  })
-  .catch(error => {
-    statusDiv.innerHTML = '<span style="color: #e74c3c;">&#10007; Upload failed: ' + error + '</span>';
-  });
-}
-</script>
-</head>
-<body>
-<div class="container">
-  <h2>CrowPanel Configuration</h2>
-
-  <div class="info">
-    <strong>Upload a configuration file</strong><br>
-    Select your <code>config.json</code> file to update the hotkey layout.
-    The device will validate and apply the configuration without rebooting.
-  </div>
-
-  <form>
-    <input type="file" id="configFile" name="config" accept=".json">
-    <button type="button" onclick="uploadConfig()">Upload Configuration</button>
-  </form>
-
-  <div id="configStatus" class="status"></div>
-
-  <hr>
-
-  <div class="info">
-    <strong>Firmware Update (OTA)</strong><br>
-    Select a <code>.bin</code> firmware file to update the device.
-    The device will reboot after a successful update.
-  </div>
-
-  <form>
-    <input type="file" id="firmwareFile" name="firmware" accept=".bin">
-    <button type="button" onclick="uploadFirmware()">Upload Firmware</button>
-  </form>
-
-  <div id="otaStatus" class="status"></div>
-
-  <hr>
-  <div class="info" style="text-align: left; font-size: 13px;">
-    <strong>PlatformIO OTA:</strong><br>
-    <code>pio run -t upload --upload-port &lt;IP&gt;</code>
-  </div>
-</div>
-</body>
-</html>)rawliteral";
-
-// Handle GET /api/health (lightweight probe)
-static void handle_health() {
-    last_activity_time = millis();
-    web_server->send(200, "application/json", "{\"status\":\"ok\"}");
+static volatile bool g_timed_out = false;
+
+// ============================================================
+// Responses
+//
+// Replies of known size go out in one httpd_resp_send() with a
+// Content-Length; JSON documents are serialized into an upload-pool buffer
+// of exactly their size for it. Streamed replies (listings, manifests,
+// traces, screenshots) use chunked encoding through ClientStream, one
+// packet-sized chunk at a time.
+// ============================================================
+static const char *status_line(int code) {
+    switch (code) {
+    case 200: return "200 OK";
+    case 304: return "304 Not Modified";
+    case 400: return "400 Bad Request";
+    case 403: return "403 Forbidden";
+    case 404: return "404 Not Found";
+    case 409: return "409 Conflict";
+    case 503: return "503 Service Unavailable";
+    default:  return "500 Internal Server Error";
+    }
 }
 
-// Handle GET / (serves HTML form)
-static void handle_config_page() {
-    last_activity_time = millis();
-    web_server->send_P(200, "text/html", config_html);
+static esp_err_t send_body(httpd_req_t *req, int code, const char *type, const char *body,
+                           ssize_t len = HTTPD_RESP_USE_STRLEN) {
+    httpd_resp_set_status(req, status_line(code));
+    httpd_resp_set_type(req, type);
+    return httpd_resp_send(req, body, len);
 }
 
-// Handle POST /api/config/upload (multipart form data)
-static void handle_config_upload() {
-    HTTPUpload &upload = web_server->upload();
-    static uint8_t *config_buffer = nullptr;
-    static size_t config_size = 0;
-    static const size_t MAX_CONFIG_SIZE = 65536;  // 64KB max config
+class ClientStream : public Print {
+public:
+    explicit ClientStream(httpd_req_t *req) : req(req) {}
+    ~ClientStream() { flush(); }
+    size_t write(uint8_t c) override {
+        if (len == sizeof(buf)) flush();
+        buf[len++] = c;
+        return 1;
+    }
+    size_t write(const uint8_t *data, size_t n) override {
+        for (size_t left = n; left;) {
+            if (len == sizeof(buf)) flush();
+            size_t take = left < sizeof(buf) - len ? left : sizeof(buf) - len;
+            memcpy(buf + len, data, take);
+            len += take;
+            data += take;
+            left -= take;
+        }
+        return n;
+    }
+    void flush() override {
+        if (len) httpd_resp_send_chunk(req, (const char *)buf, len);
+        len = 0;
+    }
+    httpd_req_t *request() const { return req; }
+private:
+    httpd_req_t *req;
+    uint8_t buf[RESPONSE_BUF];   // On the handler's stack: one per request in flight
+    size_t len = 0;
+};
+
+// Status and type for a chunked body; finish with end_chunked()
+static void begin_chunked(httpd_req_t *req, const char *type) {
+    httpd_resp_set_status(req, status_line(200));
+    httpd_resp_set_type(req, type);
+}
 
-    if (upload.status == UPLOAD_FILE_START) {
-        Serial.printf("Config: receiving %s\n", upload.filename.c_str());
-        last_activity_time = millis();
+static void end_chunked(ClientStream &out) {
+    out.flush();
+    httpd_resp_send_chunk(out.request(), nullptr, 0);   // Zero-length last chunk
+}
 
-        // Reset error state
-        g_upload_success = false;
-        g_upload_error = "";
+static esp_err_t send_json(httpd_req_t *req, int code, const JsonDocument &doc) {
+    size_t len = measureJson(doc);
+    char *body = (char *)mem_alloc(MEM_POOL_UPLOAD, len + 1);
+    if (body) {
+        serializeJson(doc, body, len + 1);
+        esp_err_t err = send_body(req, code, "application/json", body, len);
+        mem_free(MEM_POOL_UPLOAD, body);
+        return err;
+    }
+    // No buffer for it: the same bytes, chunked
+    httpd_resp_set_status(req, status_line(code));
+    httpd_resp_set_type(req, "application/json");
+    ClientStream out(req);
+    serializeJson(doc, out);
+    end_chunked(out);
+    return ESP_OK;
+}
 
-        config_buffer = (uint8_t *)ps_malloc(MAX_CONFIG_SIZE);
-        if (!config_buffer) {
-            Serial.println("Config: malloc failed");
-            g_upload_error = "Memory allocation failed";
-            return;
+// A JSON string literal, escaped
+static void print_json_string(Print &out, const char *s) {
+    JsonDocument doc;
+    doc.set(s);
+    serializeJson(doc, out);
+}
+
+// ============================================================
+// Requests
+// ============================================================
+
+// %XX and '+' decoded in place
+static void url_decode(char *s) {
+    char *out = s;
+    for (; *s; s++) {
+        if (*s == '+') {
+            *out++ = ' ';
+        } else if (s[0] == '%' && isxdigit((unsigned char)s[1]) && isxdigit((unsigned char)s[2])) {
+            char hex[3] = { s[1], s[2], '\0' };
+            *out++ = (char)strtol(hex, nullptr, 16);
+            s += 2;
+        } else {
+            *out++ = *s;
         }
-        config_size = 0;
     }
-    else if (upload.status == UPLOAD_FILE_WRITE) {
-        last_activity_time = millis();
-        if (config_buffer) {
-            if (config_size + upload.currentSize > MAX_CONFIG_SIZE) {
-                Serial.println("Config: buffer overflow");
-                g_upload_error = "Config file too large (max 64KB)";
-                free(config_buffer);
-                config_buffer = nullptr;
-                config_size = 0;
-                return;
-            }
-            memcpy(config_buffer + config_size, upload.buf, upload.currentSize);
-            config_size += upload.currentSize;
-            Serial.printf("Config: received %zu bytes so far\n", config_size);
-        }
+    *out = '\0';
+}
+
+// Decoded query parameter `key` into out; false when absent (or too long)
+static bool query_arg(httpd_req_t *req, const char *key, char *out, size_t out_len) {
+    char query[QUERY_MAX];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK) return false;
+    if (httpd_query_key_value(query, key, out, out_len) != ESP_OK) return false;
+    url_decode(out);
+    return true;
+}
+
+static bool has_arg(httpd_req_t *req, const char *key) {
+    char value[16];
+    return query_arg(req, key, value, sizeof(value));
+}
+
+static long query_long(httpd_req_t *req, const char *key, long fallback) {
+    char value[16];
+    return query_arg(req, key, value, sizeof(value)) ? strtol(value, nullptr, 10) : fallback;
+}
+
+// A short body (JSON commands) into buf, NUL-terminated. False if it is
+// larger than buf or the connection dropped.
+static bool read_body(httpd_req_t *req, char *buf, size_t buf_len) {
+    if (req->content_len >= buf_len) return false;
+    size_t got = 0;
+    int timeouts = 0;
+    while (got < req->content_len) {
+        int n = httpd_req_recv(req, buf + got, req->content_len - got);
+        if (n == HTTPD_SOCK_ERR_TIMEOUT && ++timeouts < SERVER_RECV_RETRIES) continue;
+        if (n <= 0) return false;
+        got += n;
+    }
+    buf[got] = '\0';
+    return true;
+}
+
+// Read a multipart body CONFIG_SERVER_RECV_BUF at a time into `cb`. Its
+// file_data() writes each piece to SD before the next read, so a slow card
+// holds the TCP window shut instead of piling data up in RAM. nullptr on
+// success, else why the body didn't arrive whole.
+static const char *receive_multipart(httpd_req_t *req, const MultipartCallbacks &cb, void *user) {
+    char type[160];
+    MultipartParser parser;
+    if (httpd_req_get_hdr_value_str(req, "Content-Type", type, sizeof(type)) != ESP_OK ||
+        !multipart_begin(parser, type, &cb, user)) {
+        return "Not a multipart upload";
     }
-    else if (upload.status == UPLOAD_FILE_END) {
+    uint8_t *buf = (uint8_t *)mem_alloc(MEM_POOL_UPLOAD, CONFIG_SERVER_RECV_BUF);
+    if (!buf) return "Out of memory";
+
+    size_t left = req->content_len;
+    int timeouts = 0;
+    while (left) {
+        int n = httpd_req_recv(req, (char *)buf, left < CONFIG_SERVER_RECV_BUF ? left : CONFIG_SERVER_RECV_BUF);
+        if (n == HTTPD_SOCK_ERR_TIMEOUT && ++timeouts < SERVER_RECV_RETRIES) continue;
+        if (n <= 0) break;
+        timeouts = 0;
         last_activity_time = millis();
-        if (!config_buffer) {
-            Serial.println("Config: buffer is null at EOF");
-            if (g_upload_error.isEmpty()) g_upload_error = "Upload buffer lost";
-            return;
-        }
+        multipart_feed(parser, buf, n);
+        left -= n;
+    }
+    mem_free(MEM_POOL_UPLOAD, buf);
+    return multipart_finish(parser) ? nullptr : "Upload aborted";
+}
 
-        Serial.printf("Config: upload complete, %zu bytes total\n", config_size);
+// ============================================================
+// Workers
+//
+// esp_http_server's task parses requests and runs the quick handlers
+// itself. Anything that reads a large body or streams a large reply is
+// detached with httpd_req_async_handler_begin() and run by one of
+// CONFIG_SERVER_WORKERS worker tasks, leaving the server task free for the
+// next socket: uploads go on side by side, and a status poll still gets
+// its answer in the middle of one.
+// ============================================================
+typedef esp_err_t (*RequestFn)(httpd_req_t *req);
+
+struct ServerJob {
+    httpd_req_t *req;   // nullptr: worker exits
+    RequestFn fn;
+};
+
+static QueueHandle_t job_queue = nullptr;
+static SemaphoreHandle_t workers_exited = nullptr;
+static int workers_running = 0;
+
+static void worker_fn(void *) {
+    ServerJob job;
+    while (xQueueReceive(job_queue, &job, portMAX_DELAY) == pdTRUE && job.req) {
+        job.fn(job.req);
+        httpd_req_async_handler_complete(job.req);
+    }
+    xSemaphoreGive(workers_exited);
+    vTaskDelete(nullptr);
+}
 
-        // Validate JSON by attempting to parse (ArduinoJson v7)
-        JsonDocument doc;
-        DeserializationError error = deserializeJson(doc, config_buffer, config_size);
+// Handler registered for worker routes; user_ctx is the RequestFn
+static esp_err_t hand_to_worker(httpd_req_t *req) {
+    last_activity_time = millis();
+    if (workers_running == 0) return ((RequestFn)req->user_ctx)(req);   // None came up: run it here
+    httpd_req_t *detached = nullptr;
+    if (stop_requested || httpd_req_async_handler_begin(req, &detached) != ESP_OK) {
+        return send_body(req, 503, "application/json", "{\"error\":\"Server busy\"}");
+    }
+    ServerJob job = { detached, (RequestFn)req->user_ctx };
+    if (xQueueSend(job_queue, &job, 0) != pdTRUE) {
+        send_body(detached, 503, "application/json", "{\"error\":\"Server busy\"}");
+        httpd_req_async_handler_complete(detached);
+    }
+    return ESP_OK;
+}
 
-        if (error) {
-            Serial.printf("Config: JSON parse error: %s\n", error.c_str());
-            g_upload_error = String("JSON parse error: ") + error.c_str();
-            free(config_buffer);
-            config_buffer = nullptr;
-            return;
+static void workers_start() {
+    if (!job_queue) job_queue = xQueueCreate(SERVER_JOB_QUEUE, sizeof(ServerJob));
+    if (!workers_exited) workers_exited = xSemaphoreCreateCounting(CONFIG_SERVER_WORKERS, 0);
+    workers_running = 0;
+    for (int i = 0; i < CONFIG_SERVER_WORKERS; i++) {
+        char name[12];
+        snprintf(name, sizeof(name), "http_w%d", i);
+        if (xTaskCreatePinnedToCore(worker_fn, name, SERVER_TASK_STACK, nullptr,
+                                    NET_TASK_PRIORITY, nullptr, NET_TASK_CORE) == pdPASS) {
+            workers_running++;
         }
+    }
+    if (workers_running < CONFIG_SERVER_WORKERS) {
+        Serial.printf("Config Server: %d of %d workers started\n", workers_running, CONFIG_SERVER_WORKERS);
+    }
+}
 
-        // Write to SD card atomically: tmp file -> validate -> rename
-        if (!sdcard_write_file("/config.tmp", config_buffer, config_size)) {
-            Serial.println("Config: write to /config.tmp failed");
-            g_upload_error = "SD card write failed";
-            free(config_buffer);
-            config_buffer = nullptr;
-            return;
-        }
+// Network task: the workers finish the jobs queued so far, then exit
+static void workers_stop() {
+    ServerJob quit = { nullptr, nullptr };
+    for (int i = 0; i < workers_running; i++) xQueueSend(job_queue, &quit, portMAX_DELAY);
+    for (int i = 0; i < workers_running; i++) xSemaphoreTake(workers_exited, portMAX_DELAY);
+    workers_running = 0;
+
+    // Queued behind the quit jobs: their sockets close with the server
+    ServerJob late;
+    while (xQueueReceive(job_queue, &late, 0) == pdTRUE) {
+        if (late.req) httpd_req_async_handler_complete(late.req);
+    }
+}
 
-        Serial.println("Config: wrote /config.tmp, validating...");
+// ============================================================
+// Static assets (display/web/, gzipped at build time by tools/web_assets.py)
+//
+// The bytes go out as stored with Content-Encoding: gzip. no-cache makes the
+// browser revalidate every load, which costs a 304 with no body while the
+// ETag matches, and still picks the new page up right after an OTA.
+// ============================================================
+static esp_err_t serve_asset(httpd_req_t *req) {
+    const WebAsset &asset = *(const WebAsset *)req->user_ctx;
+    last_activity_time = millis();
+    httpd_resp_set_hdr(req, "ETag", asset.etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    char etag[16];
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", etag, sizeof(etag)) == ESP_OK &&
+        strcmp(etag, asset.etag) == 0) {
+        httpd_resp_set_status(req, status_line(304));
+        return httpd_resp_send(req, nullptr, 0);
+    }
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    return send_body(req, 200, asset.mime, (const char *)asset.gz, asset.gz_len);
+}
 
-        // Re-parse from buffer already in memory to validate schema
-        JsonDocument validate_doc;
-        DeserializationError validate_error = deserializeJson(validate_doc, config_buffer, config_size);
-        if (validate_error) {
-            Serial.printf("Config: validation parse error: %s\n", validate_error.c_str());
-            g_upload_error = String("Validation error: ") + validate_error.c_str();
-            free(config_buffer);
-            config_buffer = nullptr;
-            return;
-        }
+// Handle GET /api/health (lightweight probe). "workers" tells the companion
+// how many uploads to send side by side.
+static esp_err_t handle_health(httpd_req_t *req) {
+    last_activity_time = millis();
+    char body[40];
+    snprintf(body, sizeof(body), "{\"status\":\"ok\",\"workers\":%d}", workers_running);
+    return send_body(req, 200, "application/json", body);
+}
 
-        // Atomic rename: move tmp to config.json
-        bool rename_ok = sdcard_file_rename("/config.tmp", "/config.json");
-        if (!rename_ok) {
-            Serial.println("Config: rename /config.tmp to /config.json failed");
-            g_upload_error = "SD card rename failed";
-            free(config_buffer);
-            config_buffer = nullptr;
-            return;
-        }
+// ============================================================
+// Streaming upload sink
+//
+// File parts are written straight to a temp file on SD, one socket read at
+// a time, while the CRC-32 is accumulated, then renamed over the
+// destination once the part ends. Peak RAM is one receive buffer regardless
+// of file size. A client may send a "crc32" form field (8 hex digits,
+// before the file part) to have the stored bytes checked before the rename.
+// ============================================================
+struct UploadSink {
+    File file;
+    const char *tmp_path = nullptr;
+    size_t size = 0;
+    uint32_t crc = 0;
+};
+
+static bool sink_open(UploadSink &sink, const char *tmp_path) {
+    sink.tmp_path = tmp_path;
+    sink.size = 0;
+    sink.crc = 0;
+    if (!sdcard_mounted()) return false;
+    sink.file = SD.open(tmp_path, FILE_WRITE);   // Truncates a leftover from an aborted upload
+    return (bool)sink.file;
+}
 
-        // Load new config into global (all LVGL widgets destroyed before rebuild in loop)
-        AppConfig new_cfg = config_load();
-        const ProfileConfig* profile = new_cfg.get_active_profile();
-        if (!profile || profile->pages.empty()) {
-            Serial.println("Config: uploaded config invalid, keeping current");
-            g_upload_error = "Config loaded but has no valid pages";
-            free(config_buffer);
-            config_buffer = nullptr;
-            return;
-        }
+static bool sink_write(UploadSink &sink, const uint8_t *data, size_t len) {
+    if (!sink.file) return false;
+    if (sink.file.write(data, len) != len) {
+        sink.file.close();
+        sdcard_file_remove(sink.tmp_path);
+        return false;
+    }
+    sink.crc = crc32_update(sink.crc, data, len);
+    sink.size += len;
+    return true;
+}
 
-        // Update global config (ButtonConfig* pointers invalidated on rebuild)
-        get_global_config() = new_cfg;
-        Serial.printf("Config: loaded updated config, profile: %s, %zu pages\n",
-                      new_cfg.active_profile_name.c_str(), profile->pages.size());
+static void sink_abort(UploadSink &sink) {
+    if (sink.file) sink.file.close();
+    if (sink.tmp_path) sdcard_file_remove(sink.tmp_path);
+}
 
-        // Request deferred rebuild (will execute from loop context)
-        request_ui_rebuild();
-        Serial.println("Config: rebuild requested");
+// Close the temp file and check the client's CRC (`expected`, "" if it
+// sent none). Empty on success.
+static String sink_finish(UploadSink &sink, const char *expected) {
+    if (!sink.file) return "SD card write failed";
+    sink.file.close();
+    if (expected[0]) {
+        uint32_t want = strtoul(expected, nullptr, 16);
+        if (want != sink.crc) {
+            Serial.printf("Upload: CRC mismatch (0x%08lX != 0x%08lX)\n",
+                          (unsigned long)sink.crc, (unsigned long)want);
+            sdcard_file_remove(sink.tmp_path);
+            return "CRC mismatch";
+        }
+    }
+    return "";
+}
 
-        // Mark upload as successful
-        g_upload_success = true;
+// "crc32" form field into a request's 9-byte slot
+static void take_crc_field(char *slot, const char *name, const char *value) {
+    if (strcmp(name, "crc32") == 0) strlcpy(slot, value, 9);
+}
 
-        // Call user callback if registered
-        if (g_callback) {
-            g_callback();
-        }
+// ============================================================
+// Config upload: POST /api/config/upload (multipart form data)
+//
+// Uploads take turns on config_upload_mutex: they all go through
+// /config.tmp and the one global config.
+// ============================================================
+static SemaphoreHandle_t config_upload_mutex = nullptr;
+static const size_t MAX_CONFIG_SIZE = 1024 * 1024;  // Sanity cap; config_load() streams the file
+
+struct ConfigUpload {
+    UploadSink sink;
+    char crc32[9] = "";
+    bool success = false;
+    String error;
+};
+
+static void config_field(void *user, const char *name, const char *value) {
+    take_crc_field(((ConfigUpload *)user)->crc32, name, value);
+}
 
-        free(config_buffer);
-        config_buffer = nullptr;
+static void config_file_begin(void *user, const char *, const char *filename) {
+    ConfigUpload &up = *(ConfigUpload *)user;
+    Serial.printf("Config: receiving %s\n", filename);
+    if (!sink_open(up.sink, "/config.tmp")) {
+        Serial.println("Config: cannot create /config.tmp");
+        up.error = "SD card write failed";
     }
 }
 
-// Handle POST /api/config/upload completion (returns JSON response)
-static void handle_config_done() {
-    if (g_upload_success) {
-        web_server->send(200, "application/json", "{\"success\": true}");
-    } else {
-        String response = "{\"success\": false, \"error\": \"" + g_upload_error + "\"}";
-        web_server->send(400, "application/json", response);
+static void config_file_data(void *user, const uint8_t *data, size_t len) {
+    ConfigUpload &up = *(ConfigUpload *)user;
+    if (!up.sink.file) return;
+    if (up.sink.size + len > MAX_CONFIG_SIZE) {
+        Serial.println("Config: too large");
+        up.error = "Config file too large (max 1MB)";
+        sink_abort(up.sink);
+        return;
+    }
+    if (!sink_write(up.sink, data, len)) {
+        Serial.println("Config: write to /config.tmp failed");
+        up.error = "SD card write failed";
     }
 }
 
-// Handle POST /update (OTA firmware upload)
-static void handle_ota_upload() {
-    HTTPUpload &upload = web_server->upload();
-    last_activity_time = millis();
+static void config_file_abort(void *user) {
+    ConfigUpload &up = *(ConfigUpload *)user;
+    Serial.println("Config: upload aborted");
+    sink_abort(up.sink);
+    up.error = "Upload aborted";
+}
 
-    if (upload.status == UPLOAD_FILE_START) {
-        Serial.printf("OTA: receiving %s\n", upload.filename.c_str());
-        if (!Update.begin(UPDATE_SIZE_UNKNOWN)) {
-            Update.printError(Serial);
-        }
-    } else if (upload.status == UPLOAD_FILE_WRITE) {
-        if (Update.write(upload.buf, upload.currentSize) != upload.currentSize) {
-            Update.printError(Serial);
-        }
-    } else if (upload.status == UPLOAD_FILE_END) {
-        if (Update.end(true)) {
-            Serial.printf("OTA: success, %u bytes\n", upload.totalSize);
-        } else {
-            Update.printError(Serial);
+static void config_file_end(void *user) {
+    ConfigUpload &up = *(ConfigUpload *)user;
+    UploadSink &sink = up.sink;
+    if (!up.error.isEmpty()) return;
+
+    up.error = sink_finish(sink, up.crc32);
+    if (!up.error.isEmpty()) return;
+    Serial.printf("Config: upload complete, %zu bytes total (crc 0x%08lX)\n", sink.size,
+                  (unsigned long)sink.crc);
+
+    // Read-back CRC instead of a validating parse: config_load() below is
+    // the one parse, and a file it can't use puts the old one back
+    if (!config_file_matches("/config.tmp", sink.size, sink.crc)) {
+        Serial.println("Config: /config.tmp failed read-back verification");
+        up.error = "SD card verify failed";
+        sdcard_file_remove("/config.tmp");
+        return;
+    }
+
+    bool had_config = sdcard_file_exists("/config.json");
+    if (had_config) {
+        sdcard_file_remove("/config.json.bak");
+        if (!sdcard_file_rename("/config.json", "/config.json.bak")) {
+            Serial.println("Config: backup of /config.json failed");
+            up.error = "SD card rename failed";
+            sdcard_file_remove("/config.tmp");
+            return;
         }
     }
+
+    // Atomic rename: move tmp to config.json
+    bool rename_ok = sdcard_file_rename("/config.tmp", "/config.json");
+    if (!rename_ok) {
+        Serial.println("Config: rename /config.tmp to /config.json failed");
+        if (had_config) sdcard_file_rename("/config.json.bak", "/config.json");
+        up.error = "SD card rename failed";
+        return;
+    }
+
+    // Parsed here on the upload worker; loop() swaps it in between frames.
+    // A file it refuses never touches the live config and the old file goes back.
+    const char *err = config_reload_staged();
+    if (err) {
+        Serial.println("Config: uploaded config invalid, keeping current");
+        sdcard_file_remove("/config.json");
+        if (had_config) sdcard_file_rename("/config.json.bak", "/config.json");
+        up.error = err;
+        return;
+    }
+
+    // Mark upload as successful
+    up.success = true;
+
+    // Call user callback if registered
+    if (g_callback) {
+        g_callback();
+    }
+}
+
+static const MultipartCallbacks CONFIG_UPLOAD_CB = {
+    config_field, config_file_begin, config_file_data, config_file_end, config_file_abort,
+};
+
+static esp_err_t handle_config_upload(httpd_req_t *req) {
+    ConfigUpload up;
+    xSemaphoreTake(config_upload_mutex, portMAX_DELAY);
+    const char *recv_error = receive_multipart(req, CONFIG_UPLOAD_CB, &up);
+    xSemaphoreGive(config_upload_mutex);
+
+    if (up.success) return send_body(req, 200, "application/json", "{\"success\": true}");
+    if (up.error.isEmpty()) up.error = recv_error ? recv_error : "No file in upload";
+    JsonDocument doc;
+    doc["success"] = false;
+    doc["error"] = up.error;
+    return send_json(req, 400, doc);
 }
 
-static void handle_ota_done() {
-    bool ok = !Update.hasError();
-    web_server->send(200, "text/html",
-        ok ? "<h2>Update OK! Rebooting...</h2>"
-           : "<h2>Update FAILED</h2>");
+// ============================================================
+// Firmware upload: POST /update, firmware.bin or firmware.bin.gz, streamed
+// into the inactive slot by ota_update.cpp. One at a time: there is one
+// inactive slot.
+// ============================================================
+static SemaphoreHandle_t ota_upload_mutex = nullptr;
+
+static void ota_file_begin(void *user, const char *, const char *filename) {
+    *(bool *)user = true;
+    ota_begin(filename);
+}
+
+static void ota_file_data(void *, const uint8_t *data, size_t len) {
+    ota_write(data, len);
+}
+
+static void ota_file_end(void *) {
+    ota_end();
+}
+
+static void ota_file_abort(void *) {
+    Serial.println("OTA: upload aborted");
+    ota_abort();
+}
+
+static void ota_field(void *, const char *, const char *) {}
+
+static const MultipartCallbacks OTA_UPLOAD_CB = {
+    ota_field, ota_file_begin, ota_file_data, ota_file_end, ota_file_abort,
+};
+
+static esp_err_t handle_ota_upload(httpd_req_t *req) {
+    if (xSemaphoreTake(ota_upload_mutex, 0) != pdTRUE) {
+        return send_body(req, 409, "text/html", "<h2>Update FAILED: another update is in progress</h2>");
+    }
+    bool started = false;
+    const char *recv_error = receive_multipart(req, OTA_UPLOAD_CB, &started);
+    if (!recv_error && !started) recv_error = "no firmware file in upload";
+    const char *err = ota_error();
+    bool ok = !recv_error && err[0] == '\0';
+    xSemaphoreGive(ota_upload_mutex);
+
+    String body = ok ? String("<h2>Update OK! Rebooting...</h2>")
+                     : String("<h2>Update FAILED: ") + (err[0] ? err : recv_error) + "</h2>";
+    send_body(req, ok ? 200 : 400, "text/html", body.c_str());
     if (ok) {
         delay(500);
         ESP.restart();
     }
+    return ESP_OK;
 }
 
 // ============================================================
 // Image Upload Endpoint: POST /api/image/upload
+//
+// The "folder" field may come before or after the file part, so the file
+// goes to a temp name of its own (per connection) and is moved into the
+// folder once the whole body is in.
 // ============================================================
-static uint8_t *g_image_buffer = nullptr;
-static size_t g_image_size = 0;
-static String g_image_filename = "";
-static String g_image_folder = "icons";  // default folder
-static bool g_image_upload_success = false;
-static String g_image_upload_error = "";
-static const size_t MAX_IMAGE_SIZE = 4 * 1024 * 1024;  // 4MB max (picture frame photos)
-
-static void handle_image_upload() {
-    HTTPUpload &upload = web_server->upload();
-
-    if (upload.status == UPLOAD_FILE_START) {
-        Serial.printf("Image: receiving %s\n", upload.filename.c_str());
-        last_activity_time = millis();
 
-        g_image_upload_success = false;
-        g_image_upload_error = "";
-        g_image_filename = upload.filename;
+// Upload targets on the SD card
+static bool image_folder_ok(const String &folder) {
+    return folder == "icons" || folder == "pictures" || folder == "bkgnds" || folder == "bench";
+}
 
-        g_image_buffer = (uint8_t *)ps_malloc(MAX_IMAGE_SIZE);
-        if (!g_image_buffer) {
-            g_image_upload_error = "Memory allocation failed";
-            return;
-        }
-        g_image_size = 0;
+// Empty if `name` is a safe image filename, else the error for the client
+static String image_name_error(const String &name) {
+    if (name.length() == 0 || name.indexOf("..") >= 0 || name.indexOf("/") >= 0) {
+        return "Invalid filename";
     }
-    else if (upload.status == UPLOAD_FILE_WRITE) {
-        last_activity_time = millis();
-        if (g_image_buffer) {
-            if (g_image_size + upload.currentSize > MAX_IMAGE_SIZE) {
-                g_image_upload_error = "Image too large (max 4MB)";
-                free(g_image_buffer);
-                g_image_buffer = nullptr;
-                g_image_size = 0;
-                return;
-            }
-            memcpy(g_image_buffer + g_image_size, upload.buf, upload.currentSize);
-            g_image_size += upload.currentSize;
-        }
+    String lower_name = name;
+    lower_name.toLowerCase();
+    if (!lower_name.endsWith(".jpg") && !lower_name.endsWith(".jpeg") &&
+        !lower_name.endsWith(".png") && !lower_name.endsWith(".bmp") &&
+        !lower_name.endsWith(".sjpg") && !lower_name.endsWith(".bin") &&
+        !lower_name.endsWith(".gif")) {
+        return "Invalid file type (allowed: jpg, jpeg, png, bmp, sjpg, bin, gif)";
     }
-    else if (upload.status == UPLOAD_FILE_END) {
-        last_activity_time = millis();
-        if (!g_image_buffer) {
-            if (g_image_upload_error.isEmpty()) g_image_upload_error = "Upload buffer lost";
-            return;
-        }
+    return "";
+}
 
-        // Read folder from form field (defaults to "icons")
-        g_image_folder = "icons";
-        if (web_server->hasArg("folder")) {
-            g_image_folder = web_server->arg("folder");
-        }
+struct ImageUpload {
+    UploadSink sink;
+    char tmp[24];
+    char crc32[9] = "";
+    String filename;
+    String folder = "icons";   // default folder
+    bool stored = false;       // Temp file complete and verified
+    String error;
+};
+
+static void image_field(void *user, const char *name, const char *value) {
+    ImageUpload &up = *(ImageUpload *)user;
+    take_crc_field(up.crc32, name, value);
+    if (strcmp(name, "folder") == 0) up.folder = value;
+}
 
-        // Sanitize folder: strip leading /
-        while (g_image_folder.startsWith("/")) {
-            g_image_folder = g_image_folder.substring(1);
-        }
+static void image_file_begin(void *user, const char *, const char *filename) {
+    ImageUpload &up = *(ImageUpload *)user;
+    Serial.printf("Image: receiving %s\n", filename);
+    up.filename = filename;
 
-        // Validate folder: allowlist only
-        if (g_image_folder != "icons" && g_image_folder != "pictures" && g_image_folder != "bkgnds") {
-            g_image_upload_error = "Invalid folder (allowed: icons, pictures, bkgnds)";
-            free(g_image_buffer);
-            g_image_buffer = nullptr;
-            return;
-        }
+    // Validate filename: reject path traversal, empty, unsafe chars and non-images
+    up.error = image_name_error(up.filename);
+    if (!up.error.isEmpty()) {
+        Serial.printf("Image: REJECTED filename '%s'\n", up.filename.c_str());
+        return;
+    }
 
-        // Validate filename: reject path traversal, empty, and unsafe chars
-        Serial.printf("Image: validating filename '%s' (len=%d)\n", g_image_filename.c_str(), g_image_filename.length());
-        if (g_image_filename.length() == 0 || g_image_filename.indexOf("..") >= 0 || g_image_filename.indexOf("/") >= 0) {
-            Serial.printf("Image: REJECTED filename '%s'\n", g_image_filename.c_str());
-            g_image_upload_error = "Invalid filename";
-            free(g_image_buffer);
-            g_image_buffer = nullptr;
-            return;
-        }
+    if (!sink_open(up.sink, up.tmp)) {
+        up.error = "SD card write failed";
+    }
+}
 
-        // Validate file extension
-        String lower_name = g_image_filename;
-        lower_name.toLowerCase();
-        if (!lower_name.endsWith(".jpg") && !lower_name.endsWith(".jpeg") &&
-            !lower_name.endsWith(".png") && !lower_name.endsWith(".bmp") &&
-            !lower_name.endsWith(".sjpg")) {
-            g_image_upload_error = "Invalid file type (allowed: jpg, jpeg, png, bmp, sjpg)";
-            free(g_image_buffer);
-            g_image_buffer = nullptr;
-            return;
-        }
+static void image_file_data(void *user, const uint8_t *data, size_t len) {
+    ImageUpload &up = *(ImageUpload *)user;
+    if (up.sink.file && !sink_write(up.sink, data, len)) {
+        up.error = "SD card write failed (card full?)";
+    }
+}
+
+static void image_file_abort(void *user) {
+    ImageUpload &up = *(ImageUpload *)user;
+    Serial.println("Image: upload aborted");
+    sink_abort(up.sink);
+    up.error = "Upload aborted";
+}
+
+static void image_file_end(void *user) {
+    ImageUpload &up = *(ImageUpload *)user;
+    if (!up.error.isEmpty()) {
+        sink_abort(up.sink);
+        return;
+    }
+    up.error = sink_finish(up.sink, up.crc32);
+    up.stored = up.error.isEmpty();
+}
 
-        // Ensure target directory exists
-        String dir_path = "/" + g_image_folder;
-        sdcard_mkdir(dir_path.c_str());
+static const MultipartCallbacks IMAGE_UPLOAD_CB = {
+    image_field, image_file_begin, image_file_data, image_file_end, image_file_abort,
+};
 
-        // Build destination path
-        String dest_path = "/" + g_image_folder + "/" + g_image_filename;
+// Move the finished temp file into its folder as dest_path. Empty on success.
+static String image_store(ImageUpload &up, String &dest_path) {
+    // Sanitize folder: strip leading /
+    while (up.folder.startsWith("/")) {
+        up.folder = up.folder.substring(1);
+    }
 
-        if (!sdcard_write_file(dest_path.c_str(), g_image_buffer, g_image_size)) {
-            g_image_upload_error = "SD card write failed";
-            free(g_image_buffer);
-            g_image_buffer = nullptr;
-            return;
-        }
+    // Validate folder: allowlist only
+    if (!image_folder_ok(up.folder)) {
+        return "Invalid folder (allowed: icons, pictures, bkgnds, bench)";
+    }
 
-        Serial.printf("Image: saved %s (%zu bytes)\n", dest_path.c_str(), g_image_size);
-        g_image_upload_success = true;
+    // Ensure target directory exists
+    String dir_path = "/" + up.folder;
+    sdcard_mkdir(dir_path.c_str());
 
-        free(g_image_buffer);
-        g_image_buffer = nullptr;
+    // Build destination path and move the finished temp file over it
+    dest_path = "/" + up.folder + "/" + up.filename;
+    if (!sdcard_file_rename(up.tmp, dest_path.c_str())) {
+        return "SD card rename failed";
     }
+
+    Serial.printf("Image: saved %s (%zu bytes, crc 0x%08lX)\n", dest_path.c_str(), up.sink.size,
+                  (unsigned long)up.sink.crc);
+    ui_lock();  // Icon cache and picture index are shared with LVGL
+    icon_cache_invalidate(dest_path.c_str());
+    picture_index_added(dest_path.c_str());
+    ui_unlock();
+    return "";
 }
 
-static void handle_image_done() {
-    if (g_image_upload_success) {
-        String path = "/" + g_image_folder + "/" + g_image_filename;
-        String response = "{\"success\":true,\"path\":\"" + path + "\"}";
-        web_server->send(200, "application/json", response);
-    } else {
-        String response = "{\"success\":false,\"error\":\"" + g_image_upload_error + "\"}";
-        web_server->send(400, "application/json", response);
+static esp_err_t handle_image_upload(httpd_req_t *req) {
+    ImageUpload up;
+    snprintf(up.tmp, sizeof(up.tmp), "/.upload%d.part", httpd_req_to_sockfd(req));
+    const char *recv_error = receive_multipart(req, IMAGE_UPLOAD_CB, &up);
+
+    String dest_path;
+    if (up.stored && !recv_error) {
+        up.error = image_store(up, dest_path);
+    } else if (up.error.isEmpty()) {
+        up.error = recv_error ? recv_error : "No file in upload";
     }
+    bool success = up.stored && up.error.isEmpty();
+    if (!success && up.stored) sdcard_file_remove(up.tmp);
+
+    JsonDocument doc;
+    doc["success"] = success;
+    if (success) doc["path"] = dest_path;
+    else doc["error"] = up.error;
+    return send_json(req, success ? 200 : 400, doc);
 }
 
 // ============================================================
@@ -486,100 +750,904 @@ static void handle_image_done() {
 // ============================================================
 
 // GET /api/sd/usage
-static void handle_sd_usage() {
+static esp_err_t handle_sd_usage(httpd_req_t *req) {
     last_activity_time = millis();
     uint64_t total, used;
     if (!sdcard_get_usage(&total, &used)) {
-        web_server->send(503, "application/json", "{\"error\":\"SD not mounted\"}");
-        return;
+        return send_body(req, 503, "application/json", "{\"error\":\"SD not mounted\"}");
     }
     uint32_t total_mb = (uint32_t)(total / (1024 * 1024));
     uint32_t used_mb = (uint32_t)(used / (1024 * 1024));
     uint32_t free_mb = total_mb > used_mb ? total_mb - used_mb : 0;
-    String json = "{\"total_mb\":" + String(total_mb) +
-                  ",\"used_mb\":" + String(used_mb) +
-                  ",\"free_mb\":" + String(free_mb) + "}";
-    web_server->send(200, "application/json", json);
+    JsonDocument doc;
+    doc["total_mb"] = total_mb;
+    doc["used_mb"] = used_mb;
+    doc["free_mb"] = free_mb;
+    return send_json(req, 200, doc);
+}
+
+// GET /api/perf[?reset=1] -- render performance counters (see perf.h)
+static esp_err_t handle_perf(httpd_req_t *req) {
+    last_activity_time = millis();
+    PerfStats s;
+    perf_get(s);
+
+    JsonDocument doc;
+    doc["fps"] = s.fps;
+    doc["frames_total"] = s.frames_total;
+    doc["last_frame_ms"] = s.last_frame_ms;
+    doc["max_frame_ms"] = s.max_frame_ms;
+    JsonArray hist = doc["frame_hist"].to<JsonArray>();
+    for (int i = 0; i < PERF_HIST_BUCKETS; i++) {
+        JsonObject b = hist.add<JsonObject>();
+        if (i < PERF_HIST_BUCKETS - 1) b["lt_ms"] = PERF_HIST_LIMITS_MS[i];
+        b["count"] = s.frame_hist[i];
+    }
+    JsonObject flush = doc["flush"].to<JsonObject>();
+    flush["areas_per_sec"] = s.flush_count;
+    flush["avg_us"] = s.flush_avg_us;
+    flush["max_us"] = s.flush_max_us;
+    flush["px_per_sec"] = s.px_per_sec;
+    flush["stat_updates"] = s.stat_updates;
+    flush["px_per_stat_update"] = s.px_per_stat_update;
+    JsonObject timer = doc["timer_handler"].to<JsonObject>();
+    timer["avg_us"] = s.timer_handler_avg_us;
+    timer["max_us"] = s.timer_handler_max_us;
+    JsonObject vsync = doc["vsync"].to<JsonObject>();
+    vsync["mode"] = DISPLAY_VSYNC;
+    vsync["running"] = s.vsync.running;
+    vsync["count"] = s.vsync.vsyncs;
+    vsync["period_us"] = s.vsync.period_us;
+    vsync["frames"] = s.vsync.frames;
+    vsync["missed"] = s.vsync.missed;
+    vsync["split_frames"] = s.vsync.split_frames;
+    vsync["phase_avg_us"] = s.vsync.phase_avg_us;
+    vsync["jitter_us"] = s.vsync.jitter_us;
+    vsync["jitter_max_us"] = s.vsync.jitter_max_us;
+    vsync["beam_hits"] = s.vsync.beam_hits;
+    vsync["beam_wait_us"] = s.vsync.beam_wait_us;
+    vsync["deferred"] = s.vsync.deferred;
+    JsonObject scanout = doc["scanout"].to<JsonObject>();
+    scanout["pclk_hz"] = s.scanout.pclk_hz;
+    scanout["bounce_lines"] = s.scanout.bounce_lines;
+    scanout["underruns"] = s.scanout.underruns;
+    scanout["max_stable_pclk_hz"] = s.scanout.max_stable_pclk_hz;
+    JsonObject press = doc["press"].to<JsonObject>();
+    press["total"] = s.presses_total;
+    press["failed"] = s.presses_failed;
+    press["last_ms"] = s.press_last_ms;
+    press["max_ms"] = s.press_max_ms;
+    press["host_queue_avg_us"] = s.host_queue_avg_us;
+    press["host_exec_avg_ms"] = s.host_exec_avg_ms;
+    JsonArray phist = press["hist"].to<JsonArray>();
+    for (int i = 0; i < PERF_PRESS_BUCKETS; i++) {
+        JsonObject b = phist.add<JsonObject>();
+        if (i < PERF_PRESS_BUCKETS - 1) b["lt_ms"] = PERF_PRESS_LIMITS_MS[i];
+        b["count"] = s.press_hist[i];
+    }
+    JsonObject heap = doc["heap"].to<JsonObject>();
+    heap["internal_free"] = s.heap_free;
+    heap["internal_min_free"] = s.heap_min_free;
+    heap["psram_free"] = s.psram_free;
+    heap["psram_min_free"] = s.psram_min_free;
+    JsonObject pools = heap["pools"].to<JsonObject>();
+    for (int i = 0; i < MEM_POOL_COUNT; i++) {
+        MemPoolStats m;
+        mem_get_stats((MemPool)i, &m);
+        JsonObject pool = pools[m.name].to<JsonObject>();
+        pool["budget"] = m.budget;
+        pool["used"] = m.used;
+        pool["peak"] = m.peak;
+        pool["blocks"] = m.blocks;
+        pool["internal"] = m.internal_used;
+        pool["over_budget"] = m.over_budget;
+        pool["failed"] = m.failed;
+        pool["evicted"] = m.evicted;
+    }
+    JsonObject i2c = doc["i2c"].to<JsonObject>();
+    i2c["hz"] = I2C_BUS_HZ;
+    for (int i = 0; i < I2C_DEV_COUNT; i++) {
+        I2cDevStats d;
+        i2c_get_stats((I2cDevice)i, &d);
+        JsonObject dev = i2c[d.name].to<JsonObject>();
+        dev["jobs"] = d.jobs;
+        dev["errors"] = d.errors;
+        dev["dropped"] = d.dropped;
+        dev["wait_avg_us"] = d.wait_avg_us;
+        dev["wait_max_us"] = d.wait_max_us;
+        dev["busy_avg_us"] = d.busy_avg_us;
+        dev["busy_max_us"] = d.busy_max_us;
+    }
+    doc["hud"] = perf_hud_visible();
+    BootPhase phases[PERF_BOOT_PHASES];
+    size_t nphases = perf_boot_get(phases, PERF_BOOT_PHASES);
+    JsonArray boot = doc["boot"].to<JsonArray>();
+    for (size_t i = 0; i < nphases; i++) {
+        JsonObject b = boot.add<JsonObject>();
+        b["phase"] = phases[i].name;
+        b["core"] = phases[i].core;
+        b["start_us"] = phases[i].start_us;
+        b["us"] = phases[i].us;
+    }
+
+    LinkStats ls;
+    espnow_get_link_stats(ls);
+    JsonObject link = doc["link"].to<JsonObject>();
+    link["sent"] = ls.sent;
+    link["acked"] = ls.acked;
+    link["retries"] = ls.retries;
+    link["lost"] = ls.lost;
+    link["late_acks"] = ls.late_acks;
+    link["window_full"] = ls.window_full;
+    link["in_flight"] = ls.in_flight;
+    link["rtt_last_us"] = ls.rtt_last_us;
+    link["rtt_avg_us"] = ls.rtt_avg_us;
+    link["rtt_max_us"] = ls.rtt_max_us;
+    link["rssi"] = espnow_get_rssi();
+    link["paired"] = espnow_is_paired();
+    link["proto"] = espnow_peer_version();
+    link["caps"] = espnow_peer_caps();
+    link["rx_bad"] = ls.rx_bad;
+    link["frag_lost"] = ls.rx_frag_lost;
+    JsonObject tx = link["tx"].to<JsonObject>();
+    tx["ok"] = ls.tx_ok;
+    tx["fail"] = ls.tx_fail;
+    tx["no_mem"] = ls.tx_no_mem;
+    tx["dropped"] = ls.tx_dropped;
+    tx["queued"] = ls.tx_queued;
+    tx["last_us"] = ls.tx_last_us;
+    tx["avg_us"] = ls.tx_avg_us;
+    tx["max_us"] = ls.tx_max_us;
+    JsonObject adapt = link["adapt"].to<JsonObject>();
+    adapt["enabled"] = ESPNOW_ADAPT != 0;
+    adapt["power_dbm"] = ls.tx_power_qdbm / 4.0f;
+    adapt["rate_step"] = ls.phy_rate_step;
+    adapt["far_rssi"] = ls.far_rssi;
+    adapt["changes"] = ls.adapt_changes;
+    LinkAdaptChange changes[LINK_ADAPT_HISTORY];
+    int n_changes = espnow_adapt_history(changes, LINK_ADAPT_HISTORY);
+    JsonArray history = adapt["history"].to<JsonArray>();
+    for (int i = 0; i < n_changes; i++) {
+        JsonObject c = history.add<JsonObject>();
+        c["age_ms"] = millis() - changes[i].at_ms;
+        c["reason"] = link_adapt_reason_name(changes[i].reason);
+        c["power_dbm"] = changes[i].power_qdbm / 4.0f;
+        c["rate_step"] = changes[i].rate;
+        c["far_rssi"] = changes[i].rssi_dbm;
+        c["loss_pct"] = changes[i].loss_pct;
+    }
+
+#if WIRED_LINK_ENABLE
+    // Companion on the display's USB port (wired_link.h)
+    WiredLinkStats ws;
+    wired_link_get_stats(ws);
+    JsonObject wired = doc["wired"].to<JsonObject>();
+    wired["up"] = ws.up;
+    wired["rx_frames"] = ws.rx_frames;
+    wired["rx_bad"] = ws.rx_bad;
+    wired["tx_frames"] = ws.tx_frames;
+    wired["tx_dropped"] = ws.tx_dropped;
+#endif
+
+#if BLE_HID_ENABLE
+    // Bridge-less BLE keyboard: tx_*_us is notify() -> sent, against link.tx above
+    BleHidStats bs;
+    ble_hid_get_stats(bs);
+    JsonObject ble = doc["ble"].to<JsonObject>();
+    ble["connected"] = bs.connected;
+    ble["fast"] = bs.fast;
+    ble["interval_us"] = bs.interval_us;
+    ble["latency"] = bs.latency;
+    ble["reports"] = bs.reports;
+    ble["failed"] = bs.failed;
+    ble["tx_last_us"] = bs.tx_last_us;
+    ble["tx_avg_us"] = bs.tx_avg_us;
+    ble["tx_max_us"] = bs.tx_max_us;
+#endif
+
+    // Last input record / replay (input_replay.h), until the next one
+    ReplayReportMsg rr;
+    replay_last_report(rr);
+    if (rr.status != 0xFF) {
+        JsonObject replay = doc["replay"].to<JsonObject>();
+        replay["name"] = rr.name;
+        replay["op"] = rr.op == REPLAY_OP_RUN ? "replay" : "record";
+        replay["status"] = rr.status;
+        replay["running"] = replay_running();
+        replay["events"] = rr.events;
+        replay["duration_ms"] = rr.duration_ms;
+        replay["frames"] = rr.frames;
+        replay["frame_p50_ms"] = rr.frame_p50_ms;
+        replay["frame_p99_ms"] = rr.frame_p99_ms;
+        replay["frame_max_ms"] = rr.frame_max_ms;
+        replay["frame_avg_us"] = rr.frame_avg_us;
+        replay["flushes"] = rr.flushes;
+        replay["flush_px"] = rr.flush_px;
+        replay["flush_avg_us"] = rr.flush_avg_us;
+        replay["heap_min_free"] = rr.heap_min_free;
+        replay["heap_delta"] = rr.heap_delta;
+        replay["psram_min_free"] = rr.psram_min_free;
+    }
+
+    // Animated icons (anim_icon.h): "deferred" counts frames the decode budget pushed back
+    AnimIconStats as;
+    ui_lock();
+    anim_icon_get_stats(as);
+    ui_unlock();
+    JsonObject anim = doc["anim_icons"].to<JsonObject>();
+    anim["icons"] = as.icons;
+    anim["cached"] = as.cached;
+    anim["running"] = as.running;
+    anim["cache_bytes"] = as.cache_bytes;
+    anim["decoded"] = as.decoded;
+    anim["deferred"] = as.deferred;
+    anim["decode_max_us"] = as.decode_max_us;
+    anim["budget_us"] = ANIM_DECODE_BUDGET_US;
+
+    // Stats history log on SD (stats_log.h)
+    StatsLogStats sl;
+    stats_log_get_stats(sl);
+    JsonObject slog_stats = doc["stats_log"].to<JsonObject>();
+    slog_stats["ready"] = sl.ready;
+    slog_stats["frames"] = sl.frames;
+    slog_stats["blocks_written"] = sl.blocks_written;
+    slog_stats["flushes"] = sl.flushes;
+    slog_stats["write_failed"] = sl.write_failed;
+    slog_stats["file_bytes"] = sl.file_bytes;
+    slog_stats["last_epoch"] = sl.last_epoch;
+
+    // loop() passes over budget, per section (loop_watch.h). "stalls_log" is
+    // the RTC log: it outlives resets, so entries may be from earlier boots.
+    LoopWatchStats lw;
+    loop_watch_get(lw);
+    JsonObject loop = doc["loop"].to<JsonObject>();
+    loop["budget_us"] = lw.budget_us;
+    loop["passes"] = lw.passes;
+    loop["stalls"] = lw.stalls;
+    loop["max_us"] = lw.max_us;
+    loop["max_section"] = loop_watch_section_name(lw.max_section);
+    loop["boot"] = loop_watch_boot();
+    JsonObject sections = loop["sections"].to<JsonObject>();
+    for (uint8_t i = 0; i < loop_watch_section_count(); i++) {
+        LoopSectionStats ss = loop_watch_section(i);
+        JsonObject sec = sections[loop_watch_section_name(i)].to<JsonObject>();
+        sec["max_us"] = ss.max_us;
+        sec["stalls"] = ss.stalls;
+    }
+    LoopStall stalls[LOOP_STALL_LOG_SIZE];
+    size_t nstalls = loop_watch_stalls(stalls, LOOP_STALL_LOG_SIZE);
+    JsonArray slog = loop["stalls_log"].to<JsonArray>();
+    for (size_t i = 0; i < nstalls; i++) {
+        JsonObject e = slog.add<JsonObject>();
+        e["boot"] = stalls[i].boot;
+        e["at_ms"] = stalls[i].at_ms;
+        e["us"] = stalls[i].total_us;
+        e["section"] = loop_watch_section_name(stalls[i].section);
+        e["section_us"] = stalls[i].section_us;
+    }
+
+    if (has_arg(req, "reset")) {
+        perf_reset();
+        loop_watch_reset();
+        ble_hid_reset_stats();
+        wired_link_reset_stats();
+        espnow_reset_link_stats();
+        mem_reset_peaks();
+    }
+    return send_json(req, 200, doc);
+}
+
+// GET /api/trace -- trace ring, oldest first (see trace.h). With the shared
+// timebase locked, each event also carries host_us (clock_sync.h).
+static esp_err_t handle_trace(httpd_req_t *req) {
+    last_activity_time = millis();
+    TraceEntry *snap = (TraceEntry *)mem_alloc(MEM_POOL_UPLOAD, TRACE_RING_SIZE * sizeof(TraceEntry));
+    if (!snap) {
+        return send_body(req, 503, "application/json", "{\"error\":\"Out of memory\"}");
+    }
+    size_t n = trace_snapshot(snap, TRACE_RING_SIZE);
+
+    // Up to TRACE_RING_SIZE events: streamed, one small document per event
+    begin_chunked(req, "application/json");
+    ClientStream out(req);
+    bool synced = clock_sync_valid();
+    out.printf("{\"now_us\":%lu,\"recorded\":%lu,", (unsigned long)micros(),
+               (unsigned long)trace_head.load(std::memory_order_relaxed));
+    if (synced) {
+        out.printf("\"clock\":{\"host_us\":%lld,\"drift_ppm\":%.2f,\"delay_us\":%lu,\"error_us\":%ld},",
+                   (long long)clock_sync_now_us(), clock_sync.drift_ppm,
+                   (unsigned long)clock_sync.delay_us, (long)clock_sync.last_error_us);
+    }
+    out.print("\"events\":[");
+    JsonDocument ev;
+    for (size_t i = 0; i < n; i++) {
+        ev.clear();
+        ev["t_us"] = snap[i].t_us;
+        if (synced) ev["host_us"] = clock_sync_host_us(clock_local_from_micros(snap[i].t_us));
+        ev["event"] = trace_event_name(snap[i].id);
+        ev["a"] = snap[i].a;
+        ev["b"] = snap[i].b;
+        if (i) out.write(',');
+        serializeJson(ev, out);
+    }
+    mem_free(MEM_POOL_UPLOAD, snap);
+    out.print("]}");
+    end_chunked(out);
+    return ESP_OK;
+}
+
+// GET /api/screenshot[?format=png|bmp] -- the panel as it is now (screenshot.h),
+// chunked either way: a PNG's size isn't known until the last row is deflated
+static esp_err_t handle_screenshot(httpd_req_t *req) {
+    last_activity_time = millis();
+    ShotBuffers *sb = screenshot_alloc();
+    if (!sb) {
+        return send_body(req, 503, "application/json", "{\"error\":\"Out of memory\"}");
+    }
+    char format[8] = "";
+    query_arg(req, "format", format, sizeof(format));
+    bool bmp = strcmp(format, "bmp") == 0;
+    uint32_t t0 = millis();
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    begin_chunked(req, bmp ? "image/bmp" : "image/png");
+    ClientStream out(req);
+    screenshot_write(sb, bmp ? SCREENSHOT_BMP : SCREENSHOT_PNG, out);
+    screenshot_free(sb);
+    end_chunked(out);
+    Serial.printf("Screenshot: %s in %lu ms\n", bmp ? "BMP" : "PNG", (unsigned long)(millis() - t0));
+    return ESP_OK;
+}
+
+// GET /api/stats/history?type=N[&hours=24][&points=288][&host=slot] -- one
+// stat from the SD log (stats_log.h) as `points` evenly spaced averages over
+// the last `hours`; null where nothing was logged. Needs the wall clock.
+#define STATS_HISTORY_MAX_POINTS 1440
+
+struct HistoryBuckets {
+    int64_t *sum;
+    uint16_t *count;
+    uint8_t type;
+    uint32_t from;
+    uint32_t span;   // Seconds per bucket
+    uint16_t points;
+};
+
+static void history_bucket_visit(uint32_t epoch, uint8_t type, int32_t value, void *user) {
+    HistoryBuckets *b = (HistoryBuckets *)user;
+    if (type != b->type || epoch < b->from) return;
+    uint32_t i = (epoch - b->from) / b->span;
+    if (i >= b->points) i = b->points - 1;
+    b->sum[i] += value;
+    if (b->count[i] < UINT16_MAX) b->count[i]++;
+}
+
+static esp_err_t handle_stats_history(httpd_req_t *req) {
+    last_activity_time = millis();
+    int type = query_long(req, "type", 0);
+    if (type < 1 || type > STAT_TYPE_MAX) {
+        return send_body(req, 400, "application/json", "{\"error\":\"Bad type\"}");
+    }
+    uint32_t now = (uint32_t)time(nullptr);
+    if (now < 1000000000UL) {
+        return send_body(req, 503, "application/json", "{\"error\":\"Clock not set\"}");
+    }
+    long hours = query_long(req, "hours", 24);
+    long points = query_long(req, "points", 288);
+    if (hours < 1) hours = 1;
+    if (hours > 24 * 31) hours = 24 * 31;
+    if (points < 1) points = 1;
+    if (points > STATS_HISTORY_MAX_POINTS) points = STATS_HISTORY_MAX_POINTS;
+    uint8_t host = espnow_active_host();
+    if (has_arg(req, "host")) host = query_long(req, "host", 0);
+    else if (host == ESPNOW_HOST_NONE) host = 0;
+
+    HistoryBuckets b;
+    b.type = type;
+    b.points = points;
+    b.span = (hours * 3600 + points - 1) / points;
+    b.from = now - b.span * points;
+    b.sum = (int64_t *)mem_alloc(MEM_POOL_UPLOAD, points * (sizeof(int64_t) + sizeof(uint16_t)));
+    if (!b.sum) {
+        return send_body(req, 503, "application/json", "{\"error\":\"Out of memory\"}");
+    }
+    b.count = (uint16_t *)(b.sum + points);
+    memset(b.sum, 0, points * (sizeof(int64_t) + sizeof(uint16_t)));
+    uint32_t t0 = millis();
+    if (!stats_log_read(host, b.from, now, history_bucket_visit, &b)) {
+        mem_free(MEM_POOL_UPLOAD, b.sum);
+        return send_body(req, 503, "application/json", "{\"error\":\"Stats log not available\"}");
+    }
+
+    begin_chunked(req, "application/json");
+    ClientStream out(req);
+    out.printf("{\"type\":%d,\"host\":%u,\"from\":%lu,\"step_s\":%lu,\"values\":[", type, host,
+               (unsigned long)b.from, (unsigned long)b.span);
+    for (long i = 0; i < points; i++) {
+        if (i) out.write(',');
+        if (b.count[i]) out.printf("%ld", (long)(b.sum[i] / b.count[i]));
+        else out.print("null");
+    }
+    out.print("]}");
+    mem_free(MEM_POOL_UPLOAD, b.sum);
+    end_chunked(out);
+    Serial.printf("Stats history: type %d, %ldh in %ld points, %lu ms\n", type, hours, points,
+                  (unsigned long)(millis() - t0));
+    return ESP_OK;
+}
+
+static void perf_hud_post_cb(uint32_t on) {
+    perf_hud_set(on != 0);
+}
+
+// POST /api/perf/hud?on=0|1 (no arg = toggle)
+static esp_err_t handle_perf_hud(httpd_req_t *req) {
+    last_activity_time = millis();
+    char arg[8];
+    bool on = query_arg(req, "on", arg, sizeof(arg)) ? strcmp(arg, "0") != 0 : !perf_hud_visible();
+    ui_post(perf_hud_post_cb, on);  // HUD is an LVGL object: applied by the UI task
+    return send_body(req, 200, "application/json", on ? "{\"hud\":true}" : "{\"hud\":false}");
+}
+
+// GET /api/budget -- layout cost model and page budgets (config_cost.h), so
+// the companion validates configs against this build before uploading
+static esp_err_t handle_budget(httpd_req_t *req) {
+    last_activity_time = millis();
+    JsonDocument doc;
+    doc["max_pages"] = CONFIG_MAX_PAGES;
+    doc["max_widgets"] = CONFIG_MAX_WIDGETS;
+    JsonObject page = doc["page"].to<JsonObject>();
+    page["heap"] = CONFIG_PAGE_HEAP_BUDGET;
+    page["image_bytes"] = CONFIG_PAGE_IMAGE_BUDGET;
+    page["render_us"] = CONFIG_PAGE_RENDER_BUDGET_US;
+    JsonArray widgets = doc["widgets"].to<JsonArray>();
+    for (int t = 0; t <= WIDGET_TYPE_MAX; t++) {
+        const WidgetCost &c = config_cost_of_type(t);
+        JsonObject w = widgets.add<JsonObject>();
+        w["heap"] = c.heap;
+        w["objects"] = c.objects;
+        w["render_us_kpx"] = c.render_us_kpx;
+    }
+    return send_json(req, 200, doc);
 }
 
 // GET /api/sd/list?path=/
-struct ListContext { String json; bool first; };
+// Entries are written to the client as the card is walked, so a folder of
+// thousands of files never sits in RAM as one String
+#define SD_PATH_MAX 128
+
+struct ListContext { ClientStream *out; JsonDocument entry; bool first; };
 
 static void list_entry_cb(const char* name, size_t size, bool is_dir, void* user_data) {
     ListContext* ctx = (ListContext*)user_data;
-    if (!ctx->first) ctx->json += ",";
+    ctx->entry.clear();
+    ctx->entry["name"] = name;
+    ctx->entry["size"] = (uint32_t)size;
+    ctx->entry["dir"] = is_dir;
+    if (!ctx->first) ctx->out->write(',');
     ctx->first = false;
-    ctx->json += "{\"name\":\"" + String(name) + "\"";
-    ctx->json += ",\"size\":" + String((uint32_t)size);
-    ctx->json += ",\"dir\":" + String(is_dir ? "true" : "false") + "}";
+    serializeJson(ctx->entry, *ctx->out);
 }
 
-static void handle_sd_list() {
+static esp_err_t handle_sd_list(httpd_req_t *req) {
     last_activity_time = millis();
     if (!sdcard_mounted()) {
-        web_server->send(503, "application/json", "{\"error\":\"SD not mounted\"}");
-        return;
+        return send_body(req, 503, "application/json", "{\"error\":\"SD not mounted\"}");
+    }
+    char path[SD_PATH_MAX] = "/";
+    query_arg(req, "path", path, sizeof(path));
+    if (!sdcard_is_dir(path)) {   // Checked first: the 200 goes out before the walk
+        return send_body(req, 404, "application/json", "{\"error\":\"Not a directory\"}");
     }
-    String path = web_server->hasArg("path") ? web_server->arg("path") : "/";
+    begin_chunked(req, "application/json");
+    ClientStream out(req);
+    out.print("{\"path\":");
+    print_json_string(out, path);
+    out.print(",\"files\":[");
     ListContext ctx;
-    ctx.json = "{\"path\":\"" + path + "\",\"files\":[";
+    ctx.out = &out;
     ctx.first = true;
-    int count = sdcard_list_dir(path.c_str(), list_entry_cb, &ctx);
-    if (count < 0) {
-        web_server->send(404, "application/json", "{\"error\":\"Not a directory\"}");
-        return;
-    }
-    ctx.json += "]}";
-    web_server->send(200, "application/json", ctx.json);
+    sdcard_list_dir(path, list_entry_cb, &ctx);
+    out.print("]}");
+    end_chunked(out);
+    return ESP_OK;
 }
 
 // POST /api/sd/delete (JSON body: {"path": "/slideshow/img.png"})
-static void handle_sd_delete() {
+static esp_err_t handle_sd_delete(httpd_req_t *req) {
     last_activity_time = millis();
     if (!sdcard_mounted()) {
-        web_server->send(503, "application/json", "{\"error\":\"SD not mounted\"}");
-        return;
+        return send_body(req, 503, "application/json", "{\"error\":\"SD not mounted\"}");
     }
-    String body = web_server->arg("plain");
+    char body[SD_PATH_MAX + 32];
     JsonDocument doc;
-    DeserializationError err = deserializeJson(doc, body);
-    if (err) {
-        web_server->send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
-        return;
+    if (!read_body(req, body, sizeof(body)) || deserializeJson(doc, body)) {
+        return send_body(req, 400, "application/json", "{\"error\":\"Invalid JSON\"}");
     }
     const char* path = doc["path"];
     if (!path || strlen(path) == 0) {
-        web_server->send(400, "application/json", "{\"error\":\"Empty path\"}");
-        return;
+        return send_body(req, 400, "application/json", "{\"error\":\"Empty path\"}");
     }
     // Safety: don't allow deleting config files
     if (strcmp(path, "/config.json") == 0 || strcmp(path, "/config.json.bak") == 0) {
-        web_server->send(403, "application/json", "{\"error\":\"Cannot delete config files\"}");
-        return;
+        return send_body(req, 403, "application/json", "{\"error\":\"Cannot delete config files\"}");
     }
-    if (sdcard_file_remove(path)) {
-        web_server->send(200, "application/json", "{\"success\":true}");
+    if (!sdcard_file_remove(path)) {
+        return send_body(req, 404, "application/json", "{\"error\":\"File not found or delete failed\"}");
+    }
+    ui_lock();  // Icon cache and picture index are shared with LVGL
+    icon_cache_invalidate(path);
+    picture_index_removed(path);
+    ui_unlock();
+    return send_body(req, 200, "application/json", "{\"success\":true}");
+}
+
+// ============================================================
+// Asset sync: GET /api/sd/manifest + POST /api/sd/batch
+//
+// The companion diffs its assets against the manifest (size + CRC-32 per
+// file) and sends only what changed, many files per request.
+// ============================================================
+#define MANIFEST_READ_CHUNK 4096
+
+struct ManifestContext { String dir; ClientStream *out; JsonDocument entry; bool first; uint8_t *buf; };
+
+static void manifest_entry_cb(const char* name, size_t size, bool is_dir, void* user_data) {
+    ManifestContext* ctx = (ManifestContext*)user_data;
+    if (is_dir) return;
+    String full = ctx->dir + "/" + name;
+    File f = SD.open(full.c_str(), FILE_READ);
+    if (!f) return;
+    uint32_t crc = 0;
+    int n;
+    while ((n = f.read(ctx->buf, MANIFEST_READ_CHUNK)) > 0) crc = crc32_update(crc, ctx->buf, n);
+    f.close();
+
+    char crc_hex[9];
+    snprintf(crc_hex, sizeof(crc_hex), "%08lx", (unsigned long)crc);
+    ctx->entry.clear();
+    ctx->entry["name"] = name;
+    ctx->entry["size"] = (uint32_t)size;
+    ctx->entry["crc32"] = crc_hex;
+    if (!ctx->first) ctx->out->write(',');
+    ctx->first = false;
+    serializeJson(ctx->entry, *ctx->out);
+}
+
+// GET /api/sd/manifest?path=/icons (files only, not recursive)
+static esp_err_t handle_sd_manifest(httpd_req_t *req) {
+    last_activity_time = millis();
+    if (!sdcard_mounted()) {
+        return send_body(req, 503, "application/json", "{\"error\":\"SD not mounted\"}");
+    }
+    char path[SD_PATH_MAX] = "/";
+    query_arg(req, "path", path, sizeof(path));
+    for (size_t len = strlen(path); len > 1 && path[len - 1] == '/'; len--) path[len - 1] = '\0';
+
+    if (!sdcard_is_dir(path)) {
+        return send_body(req, 404, "application/json", "{\"error\":\"Not a directory\"}");
+    }
+    ManifestContext ctx;
+    ctx.dir = strcmp(path, "/") == 0 ? "" : path;
+    ctx.first = true;
+    ctx.buf = (uint8_t *)malloc(MANIFEST_READ_CHUNK);
+    if (!ctx.buf) {
+        return send_body(req, 500, "application/json", "{\"error\":\"Out of memory\"}");
+    }
+    // Streamed like /api/sd/list: each file's entry goes out once it is hashed
+    begin_chunked(req, "application/json");
+    ClientStream out(req);
+    ctx.out = &out;
+    out.print("{\"path\":");
+    print_json_string(out, path);
+    out.print(",\"files\":[");
+    uint32_t t0 = millis();
+    int count = sdcard_list_dir(path, manifest_entry_cb, &ctx);
+    free(ctx.buf);
+    out.print("]}");
+    end_chunked(out);
+    Serial.printf("Manifest: %s, %d entries hashed in %lu ms\n", path, count,
+                  (unsigned long)(millis() - t0));
+    return ESP_OK;
+}
+
+// Batch state: one multipart request, one file part per asset. The part's
+// field name is the target folder (icons/pictures/bkgnds/bench), its filename the
+// name in that folder. Each part streams to "<dest>.part" and is renamed
+// when it ends, so a dropped connection never leaves a truncated asset.
+// Batches in parallel must not share a file; the companion splits them by
+// name.
+struct BatchUpload {
+    UploadSink sink;
+    String dest;
+    String error;          // Error for the part in progress
+    JsonDocument results;  // Reply body, "files" gets one object per part
+    uint16_t ok = 0;
+    uint16_t failed = 0;
+    char tmp[96];
+};
+
+static void batch_record(BatchUpload &up, const String &error) {
+    if (!up.results["files"].is<JsonArray>()) up.results["files"].to<JsonArray>();
+    JsonObject part = up.results["files"].add<JsonObject>();
+    part["path"] = up.dest;
+    if (error.isEmpty()) {
+        char crc_hex[9];
+        snprintf(crc_hex, sizeof(crc_hex), "%08lx", (unsigned long)up.sink.crc);
+        part["size"] = (uint32_t)up.sink.size;
+        part["crc32"] = crc_hex;
+        up.ok++;
     } else {
-        web_server->send(404, "application/json", "{\"error\":\"File not found or delete failed\"}");
+        part["error"] = error;
+        up.failed++;
     }
 }
 
+static void batch_field(void *, const char *, const char *) {}
+
+static void batch_file_begin(void *user, const char *name, const char *filename) {
+    BatchUpload &up = *(BatchUpload *)user;
+    String folder = name;
+    while (folder.startsWith("/")) folder = folder.substring(1);
+    up.dest = "/" + folder + "/" + filename;
+    up.error = image_folder_ok(folder) ? image_name_error(filename)
+                                       : "Invalid folder (allowed: icons, pictures, bkgnds, bench)";
+    if (!up.error.isEmpty()) return;
+
+    sdcard_mkdir(("/" + folder).c_str());
+    snprintf(up.tmp, sizeof(up.tmp), "%s.part", up.dest.c_str());
+    if (!sink_open(up.sink, up.tmp)) up.error = "SD card write failed";
+}
+
+static void batch_file_data(void *user, const uint8_t *data, size_t len) {
+    BatchUpload &up = *(BatchUpload *)user;
+    if (up.error.isEmpty() && !sink_write(up.sink, data, len)) {
+        up.error = "SD card write failed (card full?)";
+    }
+}
+
+static void batch_file_abort(void *user) {
+    BatchUpload &up = *(BatchUpload *)user;
+    Serial.printf("Batch: aborted during %s\n", up.dest.c_str());
+    sink_abort(up.sink);
+    batch_record(up, "Upload aborted");
+}
+
+static void batch_file_end(void *user) {
+    BatchUpload &up = *(BatchUpload *)user;
+    if (up.error.isEmpty()) {
+        up.sink.file.close();
+        if (!sdcard_file_rename(up.tmp, up.dest.c_str())) {
+            sdcard_file_remove(up.tmp);
+            up.error = "SD card rename failed";
+        } else {
+            ui_lock();  // Icon cache and picture index are shared with LVGL
+            icon_cache_invalidate(up.dest.c_str());
+            picture_index_added(up.dest.c_str());
+            ui_unlock();
+        }
+    } else {
+        sink_abort(up.sink);
+    }
+    batch_record(up, up.error);
+}
+
+static const MultipartCallbacks BATCH_UPLOAD_CB = {
+    batch_field, batch_file_begin, batch_file_data, batch_file_end, batch_file_abort,
+};
+
+static esp_err_t handle_sd_batch(httpd_req_t *req) {
+    BatchUpload up;
+    const char *recv_error = receive_multipart(req, BATCH_UPLOAD_CB, &up);
+    up.results["success"] = up.failed == 0 && !recv_error;
+    up.results["stored"] = up.ok;
+    up.results["failed"] = up.failed;
+    if (recv_error) up.results["error"] = recv_error;
+    if (!up.results["files"].is<JsonArray>()) up.results["files"].to<JsonArray>();
+    Serial.printf("Batch: %u stored, %u failed\n", up.ok, up.failed);
+    return send_json(req, (up.failed || recv_error) && !up.ok ? 400 : 200, up.results);
+}
+
+// ============================================================
+// Hardware benchmark (hw_bench.h)
+// ============================================================
+
+// POST /api/bench[?png=/bench/ref.png&jpeg=/bench/ref.sjpg]
+// Several seconds; stages that couldn't run are missing from the reply
+static esp_err_t handle_bench(httpd_req_t *req) {
+    last_activity_time = millis();
+    char png[SD_PATH_MAX] = HW_BENCH_REF_PNG;
+    char jpeg[SD_PATH_MAX] = HW_BENCH_REF_JPEG;
+    query_arg(req, "png", png, sizeof(png));
+    query_arg(req, "jpeg", jpeg, sizeof(jpeg));
+    HwBenchResult r;
+    if (!hw_bench_run(r, png, jpeg)) {
+        return send_body(req, 409, "application/json", "{\"error\":\"Benchmark already running\"}");
+    }
+    last_activity_time = millis();   // The run itself doesn't count as idle
+
+    JsonDocument doc;
+    doc["mac"] = WiFi.macAddress();   // Which unit, for fleet comparison
+    doc["cpu_mhz"] = getCpuFrequencyMhz();
+    doc["elapsed_ms"] = r.elapsed_ms;
+    if (r.draw_ok) {
+        JsonObject d = doc["draw"].to<JsonObject>();
+        d["accelerated"] = r.draw.accelerated;
+        d["fill_us"] = r.draw.fill_us;
+        d["fill_fps"] = r.draw.fill_us ? 1e6f / r.draw.fill_us : 0.0f;
+        d["blend_us"] = r.draw.fill_opa_us;
+        d["blend_fps"] = r.draw.fill_opa_us ? 1e6f / r.draw.fill_opa_us : 0.0f;
+        d["image_us"] = r.draw.copy_us;
+        d["image_blend_us"] = r.draw.copy_opa_us;
+    }
+    if (r.flush_ok) {
+        JsonObject f = doc["flush"].to<JsonObject>();
+        f["frame_us"] = r.flush.frame_us;
+        f["fps"] = 1e6f / r.flush.frame_us;
+        f["flush_us"] = r.flush.flush_us;
+        f["px"] = r.flush.px;
+        f["mpx_per_s"] = r.flush.flush_us ? (float)r.flush.px / r.flush.flush_us : 0.0f;
+    }
+    {
+        DisplayScanoutStats so;
+        display_get_scanout_stats(so);
+        JsonObject sc = doc["scanout"].to<JsonObject>();
+        sc["pclk_hz"] = so.pclk_hz;
+        sc["bounce_lines"] = so.bounce_lines;
+        sc["underruns"] = so.underruns;
+        if (r.pclk_ok) {
+            sc["probe_base_hz"] = r.pclk.base_hz;
+            sc["max_stable_pclk_hz"] = r.pclk.max_stable_hz;
+            sc["fail_pclk_hz"] = r.pclk.fail_hz;
+            sc["fail_underruns"] = r.pclk.fail_underruns;
+        }
+    }
+    if (r.sd_ok) {
+        JsonObject s = doc["sd"].to<JsonObject>();
+        s["bus_mhz"] = sdcard_bus_hz() / 1000000;
+        s["size_mb"] = sdcard_size_mb();
+        s["seq_read_mbs"] = r.sd.seq_read_mbs;
+        s["seq_write_mbs"] = r.sd.seq_write_mbs;
+        s["rnd_read_mbs"] = r.sd.rnd_read_mbs;
+        s["rnd_read_ms"] = r.sd.rnd_read_ms;
+        s["rnd_write_mbs"] = r.sd.rnd_write_mbs;
+        s["rnd_write_ms"] = r.sd.rnd_write_ms;
+    }
+    if (r.png_us || r.jpeg_us) {
+        JsonObject dec = doc["decode"].to<JsonObject>();
+        if (r.png_us) {
+            dec["png_path"] = png;
+            dec["png_us"] = r.png_us;
+            dec["png_px"] = (uint32_t)r.png_w * r.png_h;
+        }
+        if (r.jpeg_us) {
+            dec["jpeg_path"] = jpeg;
+            dec["jpeg_us"] = r.jpeg_us;
+        }
+    }
+    if (r.config_load_us) {
+        doc["config_load"]["us"] = r.config_load_us;
+        doc["config_load"]["from_sd"] = r.config_from_sd;
+    }
+    if (r.pings_sent) {
+        JsonObject p = doc["espnow_ping"].to<JsonObject>();
+        p["sent"] = r.pings_sent;
+        p["acked"] = r.pings_acked;
+        p["p50_us"] = r.ping_p50_us;
+        p["p99_us"] = r.ping_p99_us;
+    }
+    JsonArray i2c = doc["i2c"].to<JsonArray>();
+    for (const I2cBenchResult &d : r.i2c) {
+        if (!d.present) continue;
+        JsonObject o = i2c.add<JsonObject>();
+        o["device"] = d.name;
+        o["runs"] = d.runs;
+        o["errors"] = d.errors;
+        o["busy_p50_us"] = d.busy_p50_us;
+        o["busy_p99_us"] = d.busy_p99_us;
+        o["total_p50_us"] = d.total_p50_us;
+        o["total_p99_us"] = d.total_p99_us;
+    }
+    return send_json(req, 200, doc);
+}
+
+// ============================================================
+// Server
+// ============================================================
+struct Route {
+    const char *uri;
+    httpd_method_t method;
+    RequestFn fn;
+    bool worker;   // Long body or streamed reply: run on a worker task
+};
+
+static const Route ROUTES[] = {
+    { "/api/health",         HTTP_GET,  handle_health,        false },
+    { "/api/config/upload",  HTTP_POST, handle_config_upload, true },
+    { "/api/image/upload",   HTTP_POST, handle_image_upload,  true },
+    { "/api/sd/usage",       HTTP_GET,  handle_sd_usage,      false },
+    { "/api/sd/list",        HTTP_GET,  handle_sd_list,       true },
+    { "/api/sd/delete",      HTTP_POST, handle_sd_delete,     false },
+    { "/api/sd/manifest",    HTTP_GET,  handle_sd_manifest,   true },
+    { "/api/sd/batch",       HTTP_POST, handle_sd_batch,      true },
+    { "/api/perf",           HTTP_GET,  handle_perf,          false },
+    { "/api/perf/hud",       HTTP_POST, handle_perf_hud,      false },
+    { "/api/budget",         HTTP_GET,  handle_budget,        false },
+    { "/api/trace",          HTTP_GET,  handle_trace,         true },
+    { "/api/screenshot",     HTTP_GET,  handle_screenshot,    true },
+    { "/api/stats/history",  HTTP_GET,  handle_stats_history, true },
+    { "/api/bench",          HTTP_POST, handle_bench,         true },
+    { "/update",             HTTP_POST, handle_ota_upload,    true },
+};
+
+static bool http_start() {
+    httpd_config_t cfg = HTTPD_DEFAULT_CONFIG();
+    cfg.core_id = NET_TASK_CORE;
+    cfg.task_priority = NET_TASK_PRIORITY + 1;   // Above the workers: other sockets get served while they stream
+    cfg.stack_size = SERVER_TASK_STACK;
+    cfg.max_uri_handlers = sizeof(ROUTES) / sizeof(ROUTES[0]) + sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]);
+    cfg.lru_purge_enable = true;
+    cfg.recv_wait_timeout = 10;
+    cfg.send_wait_timeout = 10;
+    if (httpd_start(&http_server, &cfg) != ESP_OK) {
+        http_server = nullptr;
+        return false;
+    }
+
+    for (const WebAsset &asset : WEB_ASSETS) {
+        httpd_uri_t uri = { asset.path, HTTP_GET, serve_asset, (void *)&asset };
+        httpd_register_uri_handler(http_server, &uri);
+    }
+    for (const Route &route : ROUTES) {
+        httpd_uri_t uri = { route.uri, route.method, route.worker ? hand_to_worker : route.fn,
+                            route.worker ? (void *)route.fn : nullptr };
+        httpd_register_uri_handler(http_server, &uri);
+    }
+    workers_start();
+    return true;
+}
+
 bool config_server_start() {
-    if (active) return true;
+    if (!server_mutex) {
+        server_mutex = xSemaphoreCreateMutex();
+        config_upload_mutex = xSemaphoreCreateMutex();
+        ota_upload_mutex = xSemaphoreCreateMutex();
+    }
+    xSemaphoreTake(server_mutex, portMAX_DELAY);  // Waits out a stop in progress
+    if (active) {
+        bool cancelled = !stopping;
+        if (cancelled) stop_requested = false;    // Still running: cancel a pending stop
+        else Serial.println("Config Server: still stopping");
+        xSemaphoreGive(server_mutex);
+        return cancelled;
+    }
 
     // Switch from STA to AP+STA so ESP-NOW keeps working
     WiFi.mode(WIFI_AP_STA);
-    if (!WiFi.softAP(CONFIG_SSID, CONFIG_PASS, CONFIG_CHANNEL)) {
+    // On the ESP-NOW channel: one radio, so the AP can't live anywhere else
+    uint8_t channel = espnow_channel();
+    if (!WiFi.softAP(CONFIG_SSID, CONFIG_PASS, channel)) {
         Serial.println("Config Server: SoftAP failed");
         WiFi.mode(WIFI_STA);  // revert
+        xSemaphoreGive(server_mutex);
         return false;
     }
 
     // Re-pin channel after softAP start
-    esp_wifi_set_channel(CONFIG_CHANNEL, WIFI_SECOND_CHAN_NONE);
+    esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
 
     Serial.printf("Config Server: SoftAP started - SSID: %s  Password: %s  IP: %s  Channel: %d\n",
-                  CONFIG_SSID, CONFIG_PASS, WiFi.softAPIP().toString().c_str(), CONFIG_CHANNEL);
+                  CONFIG_SSID, CONFIG_PASS, WiFi.softAPIP().toString().c_str(), channel);
+
+    // HTTP on port 80
+    if (!http_start()) {
+        Serial.println("Config Server: HTTP server failed");
+        WiFi.softAPdisconnect(true);
+        WiFi.mode(WIFI_STA);
+        esp_wifi_set_channel(espnow_channel(), WIFI_SECOND_CHAN_NONE);
+        xSemaphoreGive(server_mutex);
+        return false;
+    }
+    Serial.printf("Config Server: HTTP on port 80, %d workers\n", workers_running);
 
     // ArduinoOTA (for PlatformIO upload)
     ArduinoOTA.setHostname(CONFIG_HOSTNAME);
@@ -592,51 +1660,68 @@ bool config_server_start() {
         Serial.printf("OTA: error %u\n", error);
     });
     ArduinoOTA.begin();
-
-    // Web server on port 80
-    web_server = new WebServer(80);
-    web_server->on("/", HTTP_GET, handle_config_page);
-    web_server->on("/api/health", HTTP_GET, handle_health);
-    web_server->on("/api/config/upload", HTTP_POST, handle_config_done, handle_config_upload);
-    web_server->on("/api/image/upload", HTTP_POST, handle_image_done, handle_image_upload);
-    web_server->on("/api/sd/usage", HTTP_GET, handle_sd_usage);
-    web_server->on("/api/sd/list", HTTP_GET, handle_sd_list);
-    web_server->on("/api/sd/delete", HTTP_POST, handle_sd_delete);
-    web_server->on("/update", HTTP_POST, handle_ota_done, handle_ota_upload);
-    web_server->begin();
-    Serial.println("Config Server: web server on port 80");
+    live_edit_start();
 
     last_activity_time = millis();
+    stop_requested = false;
+    g_timed_out = false;
     active = true;
+    xSemaphoreGive(server_mutex);
+    tasks_wake_net();
     return true;
 }
 
 void config_server_stop() {
     if (!active) return;
+    stop_requested = true;
+    tasks_wake_net();
+}
 
-    ArduinoOTA.end();
+// Network task, server_mutex NOT held: handlers may be waiting on ui_lock()
+// while the UI task waits on server_mutex in config_server_start()
+static void http_stop() {
+    workers_stop();
+    httpd_stop(http_server);
+    http_server = nullptr;
+}
 
-    if (web_server) {
-        web_server->stop();
-        delete web_server;
-        web_server = nullptr;
-    }
+// Network task, server_mutex held
+static void server_stop() {
+
+    ArduinoOTA.end();
+    live_edit_stop();
 
     WiFi.softAPdisconnect(true);
     WiFi.mode(WIFI_STA);  // back to STA-only for ESP-NOW
 
     // Re-pin ESP-NOW channel after WiFi mode transition
-    esp_wifi_set_channel(CONFIG_CHANNEL, WIFI_SECOND_CHAN_NONE);
+    esp_wifi_set_channel(espnow_channel(), WIFI_SECOND_CHAN_NONE);
 
     active = false;
     Serial.println("Config Server: stopped");
 }
 
-void config_server_poll() {
-    if (!active || !web_server) return;
+uint32_t config_server_service() {
+    if (!active) return UINT32_MAX;
+
+    if (stop_requested) {
+        xSemaphoreTake(server_mutex, portMAX_DELAY);
+        bool stop = stop_requested && active;   // Re-check: a start may have cancelled it
+        if (stop) stopping = true;
+        xSemaphoreGive(server_mutex);
+        if (stop) {
+            http_stop();
+            xSemaphoreTake(server_mutex, portMAX_DELAY);
+            server_stop();
+            stop_requested = false;
+            stopping = false;
+            xSemaphoreGive(server_mutex);
+        }
+        return active ? 0 : UINT32_MAX;
+    }
 
     ArduinoOTA.handle();
-    web_server->handleClient();
+    if (live_edit_service()) last_activity_time = millis();
 
     // Track client connections as activity
     if (WiFi.softAPgetStationNum() > 0) {
@@ -646,13 +1731,15 @@ void config_server_poll() {
     // Inactivity timeout: auto-stop after 5 minutes
     if (millis() - last_activity_time > INACTIVITY_TIMEOUT_MS) {
         Serial.println("Config Server: inactivity timeout, auto-stopping");
-        config_server_stop();
         g_timed_out = true;
+        stop_requested = true;
+        return 0;
     }
+    return CONFIG_SERVER_POLL_MS;
 }
 
 bool config_server_active() {
-    return active;
+    return active && !stop_requested;
 }
 
 bool config_server_timed_out() {
@@ -3,6 +3,13 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#ifndef CONFIG_SERVER_WORKERS
+#define CONFIG_SERVER_WORKERS 2       // Uploads / streamed replies served at once
+#endif
+#ifndef CONFIG_SERVER_RECV_BUF
+#define CONFIG_SERVER_RECV_BUF 4096   // Body bytes per socket read, and per SD write
+#endif
+
 // ============================================================
 // Configuration Server - Unified SoftAP HTTP Interface
 // ============================================================
@@ -10,38 +17,53 @@
 // Provides a WiFi SoftAP ("CrowPanel-Config") with HTTP endpoints:
 //   - Config upload: POST /api/config/upload (JSON config files)
 //   - OTA firmware:  POST /update (binary firmware files)
+//   - Perf counters: GET /api/perf, POST /api/perf/hud (render HUD toggle)
+//   - Benchmark:     POST /api/bench, hardware microbenchmarks (hw_bench.h)
+//   - Live edit:     ws://<ip>:81/api/live, layout patches (live_edit.h)
 //   - ArduinoOTA:    PlatformIO upload-port support
 //
 // Usage:
-//   config_server_start()  - Start SoftAP + web server + ArduinoOTA
-//   config_server_poll()   - Call from main loop (handles HTTP + OTA + timeout)
-//   config_server_stop()   - Stop SoftAP + web server + ArduinoOTA
+//   config_server_start()   - Start SoftAP + web server + ArduinoOTA
+//   config_server_service() - Network task (tasks.cpp): OTA + live edit + timeout
+//   config_server_stop()    - Stop SoftAP + web server + ArduinoOTA
 //
 // Architecture:
-//   - SoftAP operates on channel 1 (pinned for ESP-NOW coexistence)
+//   - SoftAP runs on the ESP-NOW channel (espnow_channel()); channel
+//     switches are held off while it is up
 //   - 5-minute inactivity timeout auto-stops SoftAP
 //   - Validates JSON before writing to SD card
 //   - Atomically writes: upload -> tmp file -> validate -> rename -> rebuild UI
 //   - Upload errors return HTTP 400 with descriptive JSON error
+//   - HTTP is esp_http_server on NET_TASK_CORE. Quick handlers run on its
+//     task; uploads and streamed replies are detached to CONFIG_SERVER_WORKERS
+//     worker tasks, so several go on at once and none holds up the rest.
+//     Upload bodies are read CONFIG_SERVER_RECV_BUF at a time and each piece
+//     is on SD before the next read (a slow card backs up TCP, not RAM).
+//   - Handlers take ui_lock() around the global config / icon cache and
+//     ui_post() anything that touches LVGL
 
 // Start configuration server: bring up SoftAP + HTTP endpoints + ArduinoOTA
 // Returns true if SoftAP started successfully
 bool config_server_start();
 
-// Stop configuration server: tear down SoftAP, web server, and ArduinoOTA
+// Stop configuration server: tear down SoftAP, web server, and ArduinoOTA.
+// Asynchronous: the network task stops it once the requests in progress are
+// done; config_server_active() reads false right away. A start while that
+// is still going on fails.
 void config_server_stop();
 
-// Must be called from loop() while config server is active
-// Handles HTTP clients, ArduinoOTA, and inactivity timeout
-void config_server_poll();
+// Network task only: handles ArduinoOTA, live edit, pending stop and the
+// inactivity timeout. Returns ms until the next call (UINT32_MAX = inactive,
+// sleep until tasks_wake_net()).
+uint32_t config_server_service();
 
-// Is config server currently active?
+// Is config server currently active? (any task)
 bool config_server_active();
 
 // Check if server timed out due to inactivity (returns true once, then clears)
 bool config_server_timed_out();
 
-// Callback: called when new config is successfully validated and applied
-// (fired AFTER rebuild_ui() completes)
+// Callback: called when an uploaded config has been validated and staged
+// (upload worker task; the UI swaps it in on its next loop pass)
 typedef void (*on_config_updated_callback_t)();
 void config_server_set_callback(on_config_updated_callback_t cb);
@@ -0,0 +1,230 @@
+/**
+ * @file config_str.cpp
+ * ConfigStr intern pool: chained hash table over bump-allocated PSRAM chunks
+ *
+ * Entries are carved sequentially out of CONFIG_STR_CHUNK byte chunks. A
+ * chunk counts its live entries; when that drops to zero it is freed (or
+ * rewound, if it is the one still being filled). A config reload releases
+ * the old strings and interns the new ones, so the pool settles on roughly
+ * one chunk set per distinct profile instead of thousands of small blocks.
+ *
+ * pool_mux guards the buckets, the refcounts and chunk fill levels. Nothing
+ * that can block runs under it: a lookup that needs a new chunk or a bigger
+ * table drops the lock, allocates, and retries (another task may have
+ * interned the same text meanwhile).
+ */
+
+#include "config_str.h"
+#include "mem_budget.h"
+#include <Arduino.h>
+#include <stdlib.h>
+#include <vector>
+
+#define CONFIG_STR_CHUNK   4096
+#define CONFIG_STR_MAX_LEN 0xFFFF
+
+struct StrChunk {
+    uint32_t cap;
+    uint32_t used;
+    uint32_t live;           // Entries with refs > 0
+    uint8_t data[];
+};
+
+struct StrEntry {
+    StrEntry *next;          // Hash chain
+    StrChunk *chunk;
+    uint32_t hash;
+    uint32_t refs;
+    uint16_t len;
+    char chars[];            // len bytes + NUL
+};
+
+static std::vector<StrEntry *> buckets;   // Power-of-two size
+static uint32_t entry_count = 0;
+static uint32_t chunk_count = 0;
+static uint32_t chunk_bytes = 0;
+static StrChunk *open_chunk = nullptr;       // Chunk new entries are appended to
+static portMUX_TYPE pool_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t str_hash(const char *s, size_t len) {
+    uint32_t h = 2166136261u;  // FNV-1a
+    for (size_t i = 0; i < len; i++) h = (h ^ (uint8_t)s[i]) * 16777619u;
+    return h;
+}
+
+static size_t entry_size(size_t len) {
+    return (sizeof(StrEntry) + len + 1 + alignof(StrEntry) - 1) & ~(alignof(StrEntry) - 1);
+}
+
+// Called unlocked (the heap may block); the lock only covers the counters
+static StrChunk *chunk_alloc(uint32_t cap) {
+    StrChunk *c = (StrChunk *)mem_alloc(MEM_POOL_CONFIG, sizeof(StrChunk) + cap);
+    if (!c) return nullptr;
+    c->cap = cap;
+    c->used = 0;
+    c->live = 0;
+    portENTER_CRITICAL(&pool_mux);
+    chunk_count++;
+    chunk_bytes += cap;
+    portEXIT_CRITICAL(&pool_mux);
+    return c;
+}
+
+static void chunk_free(StrChunk *c) {
+    if (!c) return;
+    portENTER_CRITICAL(&pool_mux);
+    chunk_count--;
+    chunk_bytes -= c->cap;
+    portEXIT_CRITICAL(&pool_mux);
+    mem_free(MEM_POOL_CONFIG, c);
+}
+
+// Called with pool_mux held, down to intern()
+
+static StrEntry *lookup(uint32_t h, const char *s, size_t len) {
+    if (buckets.empty()) return nullptr;
+    for (StrEntry *e = buckets[h & (buckets.size() - 1)]; e; e = e->next) {
+        if (e->hash == h && e->len == len && memcmp(e->chars, s, len) == 0) return e;
+    }
+    return nullptr;
+}
+
+static StrEntry *link_entry(StrEntry *e, uint32_t h, const char *s, size_t len) {
+    e->hash = h;
+    e->refs = 1;
+    e->len = (uint16_t)len;
+    memcpy(e->chars, s, len);
+    e->chars[len] = '\0';
+    StrEntry *&slot = buckets[h & (buckets.size() - 1)];
+    e->next = slot;
+    slot = e;
+    entry_count++;
+    return e;
+}
+
+// Carve `need` bytes out of the open chunk, if they fit
+static StrEntry *entry_carve(size_t need) {
+    if (!open_chunk || open_chunk->cap - open_chunk->used < need) return nullptr;
+    StrEntry *e = (StrEntry *)(open_chunk->data + open_chunk->used);
+    open_chunk->used += need;
+    open_chunk->live++;
+    e->chunk = open_chunk;
+    return e;
+}
+
+static void rehash_into(std::vector<StrEntry *> &fresh) {
+    size_t n = fresh.size();
+    for (StrEntry *head : buckets) {
+        while (head) {
+            StrEntry *next = head->next;
+            StrEntry *&slot = fresh[head->hash & (n - 1)];
+            head->next = slot;
+            slot = head;
+            head = next;
+        }
+    }
+    buckets.swap(fresh);
+}
+
+StrEntry *ConfigStr::intern(const char *s, size_t len) {
+    if (!s || len == 0) return nullptr;
+    if (len > CONFIG_STR_MAX_LEN) len = CONFIG_STR_MAX_LEN;
+    uint32_t h = str_hash(s, len);
+    size_t need = entry_size(len);
+
+    for (;;) {
+        portENTER_CRITICAL(&pool_mux);
+        StrEntry *e = lookup(h, s, len);
+        if (e) {
+            e->refs++;
+            portEXIT_CRITICAL(&pool_mux);
+            return e;
+        }
+        size_t want_buckets = entry_count >= buckets.size() ? (buckets.empty() ? 256 : buckets.size() * 2) : 0;
+        if (!want_buckets && need <= CONFIG_STR_CHUNK && (e = entry_carve(need))) {
+            link_entry(e, h, s, len);
+            portEXIT_CRITICAL(&pool_mux);
+            return e;
+        }
+        portEXIT_CRITICAL(&pool_mux);
+
+        if (want_buckets) {
+            std::vector<StrEntry *> fresh(want_buckets, nullptr);
+            portENTER_CRITICAL(&pool_mux);
+            if (buckets.size() < want_buckets) rehash_into(fresh);   // Else another task grew it first
+            portEXIT_CRITICAL(&pool_mux);
+            continue;   // `fresh` now holds the old table, freed out here
+        }
+
+        if (need > CONFIG_STR_CHUNK) {
+            // Oversized: a chunk of its own, freed with the entry
+            StrChunk *c = chunk_alloc(need);
+            if (!c) return nullptr;   // Out of memory: reads as ""
+            c->used = need;
+            c->live = 1;
+            e = (StrEntry *)c->data;
+            e->chunk = c;
+            portENTER_CRITICAL(&pool_mux);
+            StrEntry *dup = lookup(h, s, len);
+            if (dup) dup->refs++;
+            else link_entry(e, h, s, len);
+            portEXIT_CRITICAL(&pool_mux);
+            if (!dup) return e;
+            chunk_free(c);
+            return dup;
+        }
+
+        // Open chunk full: put a fresh one in its place and retry
+        StrChunk *fresh = chunk_alloc(CONFIG_STR_CHUNK);
+        if (!fresh) return nullptr;
+        StrChunk *spare = fresh;
+        portENTER_CRITICAL(&pool_mux);
+        if (!open_chunk || open_chunk->cap - open_chunk->used < need) {
+            spare = open_chunk && open_chunk->live == 0 ? open_chunk : nullptr;
+            open_chunk = fresh;
+        }
+        portEXIT_CRITICAL(&pool_mux);
+        chunk_free(spare);   // An emptied chunk nobody fills any more, or ours if we lost the race
+    }
+}
+
+void ConfigStr::retain(StrEntry *e) {
+    if (!e) return;
+    portENTER_CRITICAL(&pool_mux);
+    e->refs++;
+    portEXIT_CRITICAL(&pool_mux);
+}
+
+void ConfigStr::release(StrEntry *e) {
+    if (!e) return;
+    StrChunk *dead = nullptr;
+    portENTER_CRITICAL(&pool_mux);
+    if (--e->refs == 0) {
+        StrEntry **link = &buckets[e->hash & (buckets.size() - 1)];
+        while (*link != e) link = &(*link)->next;
+        *link = e->next;
+        entry_count--;
+
+        StrChunk *c = e->chunk;
+        if (--c->live == 0) {
+            if (c == open_chunk) c->used = 0;   // Nothing left in it: refill from the start
+            else dead = c;
+        }
+    }
+    portEXIT_CRITICAL(&pool_mux);
+    chunk_free(dead);
+}
+
+const char *ConfigStr::c_str() const {
+    return e ? e->chars : "";
+}
+
+size_t ConfigStr::size() const {
+    return e ? e->len : 0;
+}
+
+void config_str_stats(uint32_t *unique, uint32_t *bytes, uint32_t *chunks) {
+    if (unique) *unique = entry_count;
+    if (bytes) *bytes = chunk_bytes;
+    if (chunks) *chunks = chunk_count;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <string>
+
+// ============================================================
+// Interned config strings
+//
+// Widget/page strings (labels, icon symbols, icon paths, ...) repeat a lot
+// across a profile and across the copies of it the UI keeps (global config,
+// pending upload, realized-page snapshots). ConfigStr stores each distinct
+// text once, refcounted, packed into PSRAM chunks:
+//   - copying a config copies pointers, no allocation
+//   - equal strings share one entry, so == is a pointer compare
+//   - a chunk is returned to the heap once nothing in it is referenced
+//
+// Safe from any task: uploads parse a whole config on a worker while the
+// UI keeps copying and dropping strings of the live one. One spinlock
+// covers the table and the refcounts; allocation happens outside it.
+// ============================================================
+
+struct StrEntry;
+
+class ConfigStr {
+public:
+    ConfigStr() : e(nullptr) {}
+    ConfigStr(const char *s) : e(intern(s, s ? strlen(s) : 0)) {}
+    ConfigStr(const char *s, size_t len) : e(intern(s, len)) {}
+    ConfigStr(const std::string &s) : e(intern(s.data(), s.size())) {}
+    ConfigStr(const ConfigStr &o) : e(o.e) { retain(e); }
+    ConfigStr(ConfigStr &&o) noexcept : e(o.e) { o.e = nullptr; }
+    ~ConfigStr() { release(e); }
+
+    ConfigStr &operator=(const ConfigStr &o) {
+        retain(o.e);
+        release(e);
+        e = o.e;
+        return *this;
+    }
+    ConfigStr &operator=(ConfigStr &&o) noexcept {
+        if (this != &o) { release(e); e = o.e; o.e = nullptr; }
+        return *this;
+    }
+
+    const char *c_str() const;
+    size_t size() const;
+    size_t length() const { return size(); }
+    bool empty() const { return e == nullptr; }   // "" is never interned
+
+    bool operator==(const ConfigStr &o) const { return e == o.e; }
+    bool operator!=(const ConfigStr &o) const { return e != o.e; }
+    bool operator==(const char *s) const { return strcmp(c_str(), s ? s : "") == 0; }
+    bool operator!=(const char *s) const { return !(*this == s); }
+
+private:
+    StrEntry *e;
+    static StrEntry *intern(const char *s, size_t len);
+    static void retain(StrEntry *e);
+    static void release(StrEntry *e);
+};
+
+// Pool footprint, for the config load log
+void config_str_stats(uint32_t *unique, uint32_t *bytes, uint32_t *chunks);
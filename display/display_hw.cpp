@@ -1,5 +1,11 @@
 #include "display_hw.h"
 #include "touch.h"
+#include "i2c_bus.h"
+#include "perf.h"
+#include "draw_accel.h"
+#if DISPLAY_BOUNCE_LINES
+#include "rgb_bounce.h"
+#endif
 
 #include <Arduino.h>
 #include <Wire.h>
@@ -8,14 +14,53 @@
 #include <lgfx/v1/platforms/esp32s3/Bus_RGB.hpp>
 #include <lvgl.h>
 #include <PCA9557.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <driver/ledc.h>
+#if DISPLAY_VSYNC
+#include <driver/gpio.h>
+#include <soc/gpio_periph.h>
+#include <soc/io_mux_reg.h>
+#include <esp_timer.h>
+#endif
+#include <soc/gdma_struct.h>
+#include <soc/gdma_channel.h>
+#include <string.h>
+#if DISPLAY_LVGL_DIRECT_MODE
+#include <esp32s3/rom/cache.h>
+#endif
+
+#if DISPLAY_LVGL_DIRECT_MODE
+// Panel_RGB keeps its scanout framebuffer in protected members; expose the
+// base so LVGL can render into it directly.
+class Panel_RGB_FB : public lgfx::Panel_RGB {
+public:
+  uint8_t *frame_buffer() { return _lines_buffer ? _lines_buffer[0] : nullptr; }
+  bool frame_buffer_contiguous(uint32_t width, uint32_t height) {
+    if (!_lines_buffer) return false;
+    return _lines_buffer[height - 1] == _lines_buffer[0] + (height - 1) * width * sizeof(uint16_t);
+  }
+};
+#endif
 
 // ============================================================
 // LovyanGFX Display -- CrowPanel 7.0" (800x480 RGB565)
 // ============================================================
+#define PANEL_PIN_VSYNC GPIO_NUM_40
+#define PANEL_PCLK_HZ   DISPLAY_PCLK_HZ
+#define PANEL_H_TOTAL   (800 + 40 + 48 + 40)   // Active + porches + pulse, as configured below
+#define PANEL_V_TOTAL   (480 + 1 + 31 + 13)
+#define PANEL_V_LEAD    (31 + 13)              // Lines from the vsync pulse to row 0
+
 class LGFX : public lgfx::LGFX_Device {
 public:
   lgfx::Bus_RGB   _bus_instance;
+#if DISPLAY_LVGL_DIRECT_MODE
+  Panel_RGB_FB    _panel_instance;
+#else
   lgfx::Panel_RGB _panel_instance;
+#endif
   lgfx::Light_PWM _light_instance;
 
   LGFX(void) {
@@ -41,10 +86,10 @@ public:
       cfg.pin_d12 = GPIO_NUM_21; cfg.pin_d13 = GPIO_NUM_47;
       cfg.pin_d14 = GPIO_NUM_48; cfg.pin_d15 = GPIO_NUM_45;
       cfg.pin_henable = GPIO_NUM_41;
-      cfg.pin_vsync   = GPIO_NUM_40;
+      cfg.pin_vsync   = PANEL_PIN_VSYNC;
       cfg.pin_hsync   = GPIO_NUM_39;
       cfg.pin_pclk    = GPIO_NUM_0;
-      cfg.freq_write  = 12000000;
+      cfg.freq_write  = PANEL_PCLK_HZ;
       cfg.hsync_polarity    = 0; cfg.hsync_front_porch = 40;
       cfg.hsync_pulse_width = 48; cfg.hsync_back_porch = 40;
       cfg.vsync_polarity    = 0; cfg.vsync_front_porch = 1;
@@ -58,6 +103,7 @@ public:
     {
       auto cfg = _light_instance.config();
       cfg.pin_bl = GPIO_NUM_2;
+      cfg.pwm_channel = 7;   // BACKLIGHT_LEDC_CHANNEL: the fade engine takes it over
       _light_instance.config(cfg);
       _panel_instance.light(&_light_instance);
     }
@@ -67,6 +113,11 @@ public:
 
 static LGFX lcd;
 static PCA9557 ioExpander;
+#define PCA9557_ADDR 0x18   // The library's default: A0..A2 tied low
+
+#define BACKLIGHT_LEDC_MODE    LEDC_LOW_SPEED_MODE
+#define BACKLIGHT_LEDC_CHANNEL LEDC_CHANNEL_7
+static void backlight_fade_init();
 
 // ============================================================
 // LVGL Display Flush Callback
@@ -74,16 +125,296 @@ static PCA9557 ioExpander;
 static lv_disp_draw_buf_t draw_buf;
 static lv_color_t *buf1;
 static lv_color_t *buf2;
+static lv_indev_t *touch_indev = NULL;
 
-static void disp_flush_cb(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p) {
+// Frame rate accounting (one frame = last flush of a refresh cycle)
+static uint32_t fps_window_start = 0;
+static uint16_t fps_frames = 0;
+static uint16_t fps_last = 0;
+
+static void count_frame(lv_disp_drv_t *disp) {
+  if (lv_disp_flush_is_last(disp)) fps_frames++;
+}
+
+// Flush totals for display_flush_benchmark() (written by whichever task flushes)
+static volatile uint32_t bench_flush_us = 0;
+static volatile uint32_t bench_flush_px = 0;
+
+static void record_flush(uint32_t us, uint32_t px) {
+  perf_record_flush(us, px);
+  bench_flush_us += us;
+  bench_flush_px += px;
+}
+
+// ============================================================
+// Scan-out underruns
+//
+// Whichever driver scans out (Bus_RGB or esp_lcd) owns a GDMA TX channel
+// wired to LCD_CAM. Its out-FIFO underflow flags latch in the raw
+// interrupt register whether or not the interrupt is enabled: reading and
+// clearing them once per scan counts scans that ran dry.
+// ============================================================
+#define GDMA_OUT_UDF_MASK ((1u << 5) | (1u << 7))   // OUTFIFO_UDF_L1 | OUTFIFO_UDF_L3 (TRM, GDMA_OUT_INT_RAW_CHn)
+
+static bool bounce = false;           // rgb_bounce drives the panel
+static int8_t scan_dma_ch = -1;
+static volatile uint32_t scan_underruns = 0;
+static uint32_t max_stable_pclk_hz = 0;
+
+static void scanout_init() {
+  for (int ch = 0; ch < SOC_GDMA_PAIRS_PER_GROUP; ch++) {
+    if (GDMA.channel[ch].out.peri_sel.sel == SOC_GDMA_TRIG_PERIPH_LCD0) {
+      scan_dma_ch = ch;
+      GDMA.channel[ch].out.int_clr.val = GDMA_OUT_UDF_MASK;
+      return;
+    }
+  }
+  Serial.println("Scan-out: no LCD_CAM DMA channel found, underruns not counted");
+}
+
+static void IRAM_ATTR scanout_poll() {
+  if (scan_dma_ch < 0) return;
+  if (GDMA.channel[scan_dma_ch].out.int_raw.val & GDMA_OUT_UDF_MASK) {
+    GDMA.channel[scan_dma_ch].out.int_clr.val = GDMA_OUT_UDF_MASK;
+    scan_underruns++;
+  }
+}
+
+#if DISPLAY_VSYNC
+// ============================================================
+// Vsync tracking
+//
+// Panel_RGB scans the framebuffer out continuously, so a copy that lands
+// on the rows being scanned shows half old, half new. LovyanGFX has no
+// vsync callback: the panel's own VSYNC output is read back through its
+// pad (input enabled alongside the LCD_CAM output) and every pulse is
+// timestamped. From the last pulse and the measured scan period,
+// beam_line() tells which row the panel is reading right now.
+// ============================================================
+#define VSYNC_NOMINAL_US ((uint32_t)((uint64_t)PANEL_H_TOTAL * PANEL_V_TOTAL * 1000000 / PANEL_PCLK_HZ))
+#define VSYNC_SPIN_US    1500   // Closer than this to the next scan: spin instead of deferring
+
+static volatile uint32_t vsync_count = 0;
+static volatile uint32_t vsync_last_us = 0;
+static volatile uint32_t vsync_period_us = VSYNC_NOMINAL_US;   // Running mean of pulse spacing
+
+// Frame pacing counters (whichever task flushes; see DisplayVsyncStats)
+static uint32_t vs_frames = 0;
+static uint32_t vs_missed = 0;
+static uint32_t vs_split = 0;
+static int32_t vs_phase_avg_us = 0;
+static uint32_t vs_jitter_us = 0;
+static uint32_t vs_jitter_max_us = 0;
+static uint32_t vs_beam_hits = 0;
+static uint32_t vs_beam_wait_us = 0;
+static uint32_t vs_deferred = 0;
+
+static bool frame_open = false;        // First stripe of a frame flushed, last one not yet
+static uint32_t frame_first_vsync = 0;
+static uint32_t copy_row_us = 40;      // Running mean of the stripe copy cost per row
+
+static void IRAM_ATTR vsync_isr(void *) {
+  uint32_t now = (uint32_t)esp_timer_get_time();
+  uint32_t dt = now - vsync_last_us;
+  uint32_t period = vsync_period_us;
+  // Skip gaps (a stalled ISR, the first pulse): they are not a period
+  if (vsync_count && dt > period / 2 && dt < period + period / 2) {
+    vsync_period_us = period + ((int32_t)(dt - period) >> 3);
+  }
+  vsync_last_us = now;
+  vsync_count++;
+  scanout_poll();
+}
+
+static void vsync_init() {
+  gpio_num_t pin = PANEL_PIN_VSYNC;
+  // Keep the pad routed to LCD_CAM; only add the input path
+  PIN_INPUT_ENABLE(GPIO_PIN_MUX_REG[pin]);
+  esp_err_t err = gpio_install_isr_service(0);
+  if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+    Serial.printf("Vsync: ISR service failed (%d), presenting unpaced\n", err);
+    return;
+  }
+  gpio_set_intr_type(pin, GPIO_INTR_POSEDGE);   // vsync_polarity 0: the pulse is high
+  gpio_isr_handler_add(pin, vsync_isr, nullptr);
+  gpio_intr_enable(pin);
+  Serial.printf("Vsync: tracking GPIO %d, nominal %lu us per scan\n", pin, (unsigned long)VSYNC_NOMINAL_US);
+}
+
+static bool vsync_running() {
+  uint32_t now = (uint32_t)esp_timer_get_time();
+  return vsync_count > 1 && now - vsync_last_us < 2 * vsync_period_us;
+}
+
+static uint32_t vsync_line_us() {
+  return vsync_period_us / PANEL_V_TOTAL;
+}
+
+// Row being scanned: 0..SCREEN_HEIGHT-1 while active, negative during the
+// pulse and back porch, SCREEN_HEIGHT in the front porch
+static int32_t beam_line() {
+  uint32_t last = vsync_last_us;   // Before now: a pulse in between can't make dt negative
+  uint32_t period = vsync_period_us;
+  uint32_t dt = ((uint32_t)esp_timer_get_time() - last) % period;
+  return (int32_t)((uint64_t)dt * PANEL_V_TOTAL / period) - PANEL_V_LEAD;
+}
+
+// Hold a stripe back while the beam is on its rows, or would reach them
+// before the copy is done, so it lands behind the beam. Mode 1 only counts.
+static void beam_clear(int32_t y1, int32_t y2) {
+  if (!vsync_running()) return;
+  uint32_t line_us = vsync_line_us();
+  int32_t lead = (int32_t)((y2 - y1 + 1) * copy_row_us / line_us) + 1;
+  int32_t b = beam_line();
+  if (b < y1 - lead || b > y2) return;
+  vs_beam_hits++;
+#if DISPLAY_VSYNC >= 2
+  uint32_t t0 = micros();
+  uint32_t limit = vsync_period_us;
+  while (b >= y1 - lead && b <= y2 && micros() - t0 < limit) {
+    uint32_t us = (uint32_t)(y2 + 1 - b) * line_us;
+    if (us > VSYNC_SPIN_US) vTaskDelay(1);
+    else delayMicroseconds(us);
+    b = beam_line();
+  }
+  vs_beam_wait_us += micros() - t0;
+#endif
+}
+
+static void present_begin() {
+  if (frame_open) return;
+  frame_open = true;
+  frame_first_vsync = vsync_count;
+}
+
+// Last area of a frame is out: a vsync in between split it across two scans
+static void present_end() {
+  if (!frame_open) return;
+  frame_open = false;
+  if (!vsync_running()) return;
+  vs_frames++;
+  uint32_t crossed = vsync_count - frame_first_vsync;
+  if (crossed) {
+    vs_missed += crossed;
+    vs_split++;
+  }
+  // Scan phase at which frames finish; its spread is the present jitter
+  int32_t phase = (int32_t)(((uint32_t)esp_timer_get_time() - vsync_last_us) % vsync_period_us);
+  int32_t dev = phase - vs_phase_avg_us;
+  uint32_t adev = dev < 0 ? -dev : dev;
+  if (vs_frames == 1) {
+    vs_phase_avg_us = phase;
+    return;
+  }
+  vs_phase_avg_us += dev / 16;
+  vs_jitter_us += ((int32_t)adev - (int32_t)vs_jitter_us) / 16;
+  if (adev > vs_jitter_max_us) vs_jitter_max_us = adev;
+}
+#endif
+
+static void panel_write(const lv_area_t *area, const uint16_t *px) {
   uint32_t w = area->x2 - area->x1 + 1;
   uint32_t h = area->y2 - area->y1 + 1;
+#if DISPLAY_BOUNCE_LINES
+  if (bounce) {
+    rgb_bounce_draw(area->x1, area->y1, area->x2, area->y2, px);
+    return;
+  }
+#endif
   lcd.startWrite();
   lcd.setAddrWindow(area->x1, area->y1, w, h);
-  lcd.writePixels((lgfx::rgb565_t *)color_p, w * h);
+  lcd.writePixels((const lgfx::rgb565_t *)px, w * h);
   lcd.endWrite();
+}
+
+static void push_stripe(const lv_area_t *area, lv_color_t *color_p, bool last) {
+  uint32_t w = area->x2 - area->x1 + 1;
+  uint32_t h = area->y2 - area->y1 + 1;
+#if DISPLAY_VSYNC
+  present_begin();
+  beam_clear(area->y1, area->y2);
+#endif
+  uint32_t t0 = micros();
+  panel_write(area, (const uint16_t *)color_p);
+  uint32_t us = micros() - t0;
+  record_flush(us, w * h);
+#if DISPLAY_VSYNC
+  copy_row_us += ((int32_t)(us / h) - (int32_t)copy_row_us) / 8;
+  if (last) present_end();
+#endif
+}
+
+// LVGL calls this after every refresh with its render time and pixel count
+static void disp_monitor_cb(lv_disp_drv_t *disp, uint32_t time_ms, uint32_t px) {
+  perf_record_frame(time_ms, px);
+}
+
+#if DISPLAY_ASYNC_FLUSH
+// ============================================================
+// Async flush: disp_flush_cb hands the stripe to flush_task and returns, so
+// LVGL starts rendering into the other draw buffer while this one is copied.
+// ============================================================
+struct FlushJob {
+  lv_disp_drv_t *disp;
+  lv_area_t area;
+  lv_color_t *color_p;
+  bool last;                         // Last area of the refresh cycle
+};
+
+static QueueHandle_t flush_queue = NULL;
+static SemaphoreHandle_t flush_done = NULL;  // Wakes LVGL's wait_cb
+
+static void flush_task(void *arg) {
+  FlushJob job;
+  for (;;) {
+    if (xQueueReceive(flush_queue, &job, portMAX_DELAY) != pdTRUE) continue;
+    push_stripe(&job.area, job.color_p, job.last);
+    lv_disp_flush_ready(job.disp);
+    xSemaphoreGive(flush_done);
+  }
+}
+
+// Called by LVGL while both buffers are busy: block instead of spinning
+static void disp_wait_cb(lv_disp_drv_t *disp) {
+  xSemaphoreTake(flush_done, 1);
+}
+
+static void disp_flush_cb(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p) {
+  count_frame(disp);  // Must be sampled now; LVGL state moves on after return
+  FlushJob job = { disp, *area, color_p, lv_disp_flush_is_last(disp) };
+  xQueueSend(flush_queue, &job, portMAX_DELAY);
+}
+#else
+static void disp_flush_cb(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p) {
+  push_stripe(area, color_p, lv_disp_flush_is_last(disp));
+  count_frame(disp);
   lv_disp_flush_ready(disp);
 }
+#endif
+
+#if DISPLAY_LVGL_DIRECT_MODE
+// Direct mode: LVGL already drew into the scanout buffer. The RGB peripheral
+// reads PSRAM via EDMA, so push the dirty rows out of the CPU cache.
+static void disp_flush_direct_cb(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p) {
+  uint8_t *fb = (uint8_t *)disp->draw_buf->buf_act;
+  uint32_t row_bytes = SCREEN_WIDTH * sizeof(lv_color_t);
+#if DISPLAY_VSYNC
+  // Rendering already wrote the scanout rows: holding the write-back for
+  // the beam would not stop a tear, only frame pacing does
+  present_begin();
+#endif
+  uint32_t t0 = micros();
+  Cache_WriteBack_Addr((uint32_t)(fb + area->y1 * row_bytes),
+                       (area->y2 - area->y1 + 1) * row_bytes);
+  record_flush(micros() - t0,
+               (area->x2 - area->x1 + 1) * (area->y2 - area->y1 + 1));
+#if DISPLAY_VSYNC
+  if (lv_disp_flush_is_last(disp)) present_end();
+#endif
+  count_frame(disp);
+  lv_disp_flush_ready(disp);
+}
+#endif
 
 // ============================================================
 // display_init() -- PCA9557 touch reset + LCD init
@@ -93,68 +424,431 @@ void display_init() {
   pinMode(38, OUTPUT);
   digitalWrite(38, LOW);
 
-  // PCA9557 touch reset sequence:
-  // IO0 controls GT911 reset, IO1 is GT911 INT
-  ioExpander.reset();
-  ioExpander.setMode(IO_OUTPUT);
-  ioExpander.setState(IO0, IO_LOW);
-  ioExpander.setState(IO1, IO_LOW);
-  delay(20);
-  ioExpander.setState(IO0, IO_HIGH);
-  delay(100);
-  ioExpander.setMode(IO1, IO_INPUT);
+  // PCA9557 touch reset sequence (setup: the bus job runs inline):
+  // IO0 controls GT911 reset, IO1 is GT911 INT. Cached registers: every
+  // step is one write, and both pins go low-and-output in one batch.
+  i2c_run(I2C_DEV_PCA9557, I2C_PRIO_BACKGROUND, [](void *) {
+    ioExpander.setCached(true);
+    ioExpander.reset();
+    ioExpander.beginBatch();
+    ioExpander.setState(IO0, IO_LOW);
+    ioExpander.setState(IO1, IO_LOW);
+    ioExpander.setMode(IO_OUTPUT);
+    if (ioExpander.commit() != COM_SUCCESS) return false;
+    delay(20);
+    ioExpander.setState(IO0, IO_HIGH);
+    delay(10);   // INT held low past reset latches address 0x5D
+    ioExpander.setMode(IO1, IO_INPUT);
+    return true;
+  });
   Serial.println("PCA9557 touch reset done");
+  // Benchmark probe: an address ACK (the library answers reads from its cache)
+  i2c_register_probe(I2C_DEV_PCA9557, [](void *) {
+    Wire.beginTransmission(PCA9557_ADDR);
+    return Wire.endTransmission() == 0;
+  });
 
-  // Initialize LovyanGFX RGB panel
-  lcd.begin();
-  lcd.fillScreen(TFT_BLACK);
-  delay(200);
+  // Panel bring-up doubles as the GT911's ~50 ms post-reset settle time;
+  // gt911_discover() runs after LVGL is up and retries if it is still early
+#if DISPLAY_BOUNCE_LINES
+  // Backlight stays with Light_PWM; the panel goes to esp_lcd
+  bounce = rgb_bounce_init(lcd._bus_instance.config(), DISPLAY_BOUNCE_LINES);
+  if (bounce) {
+    lcd._light_instance.init(0);
+  } else {
+    Serial.println("Display: bounce buffers unavailable, Bus_RGB scan-out");
+  }
+#endif
+  if (!bounce) {
+    lcd.begin();
+    lcd.fillScreen(TFT_BLACK);
+  }
+  scanout_init();
+#if DISPLAY_VSYNC
+  vsync_init();   // After begin(): the VSYNC pad is routed by then
+#endif
+  backlight_fade_init();
   Serial.println("Display initialized");
 }
 
+// ============================================================
+// Invalidation merging
+//
+// LVGL joins two dirty areas only when their union is smaller than the
+// pair, i.e. when they overlap. Neighbouring stat values in a status bar
+// don't overlap, so each one cost its own render pass and flush. Just
+// before every refresh, areas whose bounding box wastes at most
+// DISPLAY_MERGE_SLACK_PCT are joined here first.
+// ============================================================
+#if DISPLAY_MERGE_SLACK_PCT
+static bool merge_one_pair(lv_disp_t *disp) {
+  for (uint16_t i = 0; i < disp->inv_p; i++) {
+    for (uint16_t j = i + 1; j < disp->inv_p; j++) {
+      const lv_area_t &a = disp->inv_areas[i];
+      const lv_area_t &b = disp->inv_areas[j];
+      lv_area_t u = { LV_MIN(a.x1, b.x1), LV_MIN(a.y1, b.y1), LV_MAX(a.x2, b.x2), LV_MAX(a.y2, b.y2) };
+      uint32_t pair = lv_area_get_size(&a) + lv_area_get_size(&b);
+      if ((uint64_t)lv_area_get_size(&u) * 100 > (uint64_t)pair * (100 + DISPLAY_MERGE_SLACK_PCT)) continue;
+      disp->inv_areas[i] = u;
+      disp->inv_areas[j] = disp->inv_areas[--disp->inv_p];
+      return true;
+    }
+  }
+  return false;
+}
+
+#endif
+
+#if DISPLAY_VSYNC >= 2
+// ============================================================
+// Frame pacing
+//
+// A frame spanning several stripes starts rendering on the vsync pulse:
+// the blanking lines give LVGL a head start on the beam, and it renders
+// top-down too, so the whole frame lands on one scan. Otherwise the
+// refresh timer is pushed to just before the next pulse (one scan at
+// most). Updates within one stripe's height go out at once; beam_clear()
+// suffices for them.
+// ============================================================
+#define PACE_MIN_ROWS 40   // Stripe height
+
+static bool present_due(lv_timer_t *timer, lv_disp_t *disp) {
+  if (!disp || disp->inv_p == 0 || !vsync_running()) return true;
+  int32_t y1 = SCREEN_HEIGHT, y2 = -1;
+  for (uint16_t i = 0; i < disp->inv_p; i++) {
+    if (disp->inv_area_joined[i]) continue;
+    y1 = LV_MIN(y1, disp->inv_areas[i].y1);
+    y2 = LV_MAX(y2, disp->inv_areas[i].y2);
+  }
+  if (y2 - y1 + 1 <= PACE_MIN_ROWS) return true;
+
+  // Early in the blanking lines: go now
+  int32_t b = beam_line();
+  if (b < -PANEL_V_LEAD / 2) return true;
+  uint32_t until_us = (uint32_t)(SCREEN_HEIGHT + 1 - b) * vsync_line_us();
+  if (until_us <= VSYNC_SPIN_US) {
+    uint32_t count = vsync_count;
+    uint32_t t0 = micros();
+    while (vsync_count == count && micros() - t0 < 2 * VSYNC_SPIN_US) {}
+    return true;
+  }
+  // lv_timer_exec stamped last_run just before calling us: re-arm
+  // so the timer comes back VSYNC_SPIN_US or less ahead of the pulse
+  uint32_t defer_ms = (until_us - VSYNC_SPIN_US) / 1000 + 1;
+  if (defer_ms < timer->period) timer->last_run = lv_tick_get() - timer->period + defer_ms;
+  vs_deferred++;
+  return false;
+}
+#endif
+
+#if DISPLAY_MERGE_SLACK_PCT || DISPLAY_VSYNC >= 2
+static lv_timer_cb_t lv_refr_timer_cb = nullptr;
+
+// Wraps LVGL's refresh timer: pacing first, then merging, then the refresh
+static void refr_timer_hook_cb(lv_timer_t *timer) {
+  lv_disp_t *disp = (lv_disp_t *)timer->user_data;
+#if DISPLAY_VSYNC >= 2
+  if (!present_due(timer, disp)) return;
+#endif
+#if DISPLAY_MERGE_SLACK_PCT
+  if (disp && !disp->driver->full_refresh) {
+    while (disp->inv_p > 1 && merge_one_pair(disp)) {}
+  }
+#endif
+  lv_refr_timer_cb(timer);
+}
+#endif
+
 // ============================================================
 // lvgl_init() -- LVGL buffers + display/touch driver registration
 // ============================================================
 void lvgl_init() {
   lv_init();
 
-  // Double-buffered PSRAM allocation (800 x 40 lines each)
-  buf1 = (lv_color_t *)ps_malloc(SCREEN_WIDTH * 40 * sizeof(lv_color_t));
-  buf2 = (lv_color_t *)ps_malloc(SCREEN_WIDTH * 40 * sizeof(lv_color_t));
-  lv_disp_draw_buf_init(&draw_buf, buf1, buf2, SCREEN_WIDTH * 40);
-
-  // Display driver
   static lv_disp_drv_t disp_drv;
   lv_disp_drv_init(&disp_drv);
   disp_drv.hor_res  = SCREEN_WIDTH;
   disp_drv.ver_res  = SCREEN_HEIGHT;
   disp_drv.flush_cb = disp_flush_cb;
   disp_drv.draw_buf = &draw_buf;
+  disp_drv.monitor_cb = disp_monitor_cb;
+  draw_accel_install(&disp_drv);   // Fill/copy/blend kernels under lv_draw_sw
+
+  bool direct = false;
+#if DISPLAY_LVGL_DIRECT_MODE
+  // Render straight into the panel's framebuffer (needs one contiguous block)
+#if DISPLAY_BOUNCE_LINES
+  if (bounce) {
+    buf1 = (lv_color_t *)rgb_bounce_frame_buffer();
+  } else
+#endif
+  if (lcd._panel_instance.frame_buffer_contiguous(SCREEN_WIDTH, SCREEN_HEIGHT)) {
+    buf1 = (lv_color_t *)lcd._panel_instance.frame_buffer();
+  }
+  if (buf1) {
+    lv_disp_draw_buf_init(&draw_buf, buf1, NULL, SCREEN_WIDTH * SCREEN_HEIGHT);
+    disp_drv.direct_mode = 1;
+    disp_drv.flush_cb = disp_flush_direct_cb;
+    direct = true;
+  } else {
+    Serial.println("LVGL: panel framebuffer not contiguous, using stripe buffers");
+  }
+#endif
+
+  if (!direct) {
+    // Double-buffered PSRAM allocation (800 x 40 lines each)
+    buf1 = (lv_color_t *)ps_malloc(SCREEN_WIDTH * 40 * sizeof(lv_color_t));
+    buf2 = (lv_color_t *)ps_malloc(SCREEN_WIDTH * 40 * sizeof(lv_color_t));
+    lv_disp_draw_buf_init(&draw_buf, buf1, buf2, SCREEN_WIDTH * 40);
+#if DISPLAY_ASYNC_FLUSH
+    // Depth 1: at most one stripe in flight while LVGL renders the other
+    flush_queue = xQueueCreate(1, sizeof(FlushJob));
+    flush_done = xSemaphoreCreateBinary();
+    xTaskCreatePinnedToCore(flush_task, "lv_flush", 4096, NULL,
+                            configMAX_PRIORITIES - 2, NULL, 0);
+    disp_drv.wait_cb = disp_wait_cb;
+#endif
+  }
+#if DISPLAY_MERGE_SLACK_PCT || DISPLAY_VSYNC >= 2
+  lv_disp_t *disp = lv_disp_drv_register(&disp_drv);
+  lv_refr_timer_cb = disp->refr_timer->timer_cb;
+  disp->refr_timer->timer_cb = refr_timer_hook_cb;
+#else
   lv_disp_drv_register(&disp_drv);
+#endif
+  Serial.printf("LVGL: %s render path%s%s\n",
+                direct ? "direct (panel framebuffer)" : "2x40-line stripe",
+                (!direct && DISPLAY_ASYNC_FLUSH) ? ", async flush on core 0" : "",
+                DISPLAY_VSYNC >= 2 ? ", vsync paced" : "");
 
   // Touch input driver
   static lv_indev_drv_t indev_drv;
   lv_indev_drv_init(&indev_drv);
   indev_drv.type    = LV_INDEV_TYPE_POINTER;
   indev_drv.read_cb = touch_read_cb;
-  lv_indev_drv_register(&indev_drv);
+  touch_indev = lv_indev_drv_register(&indev_drv);
 }
 
 // ============================================================
 // lvgl_tick() -- call from loop()
+// Returns the time until the next LVGL timer is due, so the caller
+// can sleep instead of spinning.
+// ============================================================
+static bool lv_suspended = false;
+
+void lvgl_suspend(bool suspend) {
+  lv_disp_t *disp = lv_disp_get_default();
+  // The last stripe may still be on its way (async flush)
+  if (suspend && disp) {
+    while (disp->driver->draw_buf->flushing) taskYIELD();
+  }
+  lv_timer_enable(!suspend);
+  lv_suspended = suspend;
+}
+
+bool lvgl_suspended() {
+  return lv_suspended;
+}
+
+void display_write_rect(int16_t x, int16_t y, uint16_t w, uint16_t h, const uint16_t *px) {
+  lv_area_t area = { x, y, (lv_coord_t)(x + w - 1), (lv_coord_t)(y + h - 1) };
+#if DISPLAY_VSYNC
+  beam_clear(area.y1, area.y2);
+#endif
+  panel_write(&area, px);
+}
+
+uint32_t lvgl_tick() {
+  if (lv_suspended) return UINT32_MAX;   // lv_timer_handler() would only say "1 ms"
+  uint32_t t0 = micros();
+  uint32_t sleep_ms = lv_timer_handler();
+  perf_record_timer_handler(micros() - t0);
+#if !DISPLAY_VSYNC
+  scanout_poll();   // Otherwise once per scan from the vsync ISR
+#endif
+
+  uint32_t now = millis();
+  if (now - fps_window_start >= 1000) {
+    fps_last = fps_frames;
+    // Only report while something is animating/redrawing
+    if (fps_frames > 1) Serial.printf("LVGL: %u fps\n", fps_frames);
+    fps_frames = 0;
+    fps_window_start = now;
+  }
+  return sleep_ms;
+}
+
+uint16_t display_get_fps() {
+  return fps_last;
+}
+
+void display_get_vsync_stats(DisplayVsyncStats &out) {
+  out = {};
+#if DISPLAY_VSYNC
+  out.running = vsync_running();
+  out.vsyncs = vsync_count;
+  out.period_us = vsync_period_us;
+  out.frames = vs_frames;
+  out.missed = vs_missed;
+  out.split_frames = vs_split;
+  out.phase_avg_us = vs_phase_avg_us > 0 ? vs_phase_avg_us : 0;
+  out.jitter_us = vs_jitter_us;
+  out.jitter_max_us = vs_jitter_max_us;
+  out.beam_hits = vs_beam_hits;
+  out.beam_wait_us = vs_beam_wait_us;
+  out.deferred = vs_deferred;
+#endif
+}
+
+void display_reset_vsync_stats() {
+#if DISPLAY_VSYNC
+  vs_frames = vs_missed = vs_split = 0;
+  vs_jitter_us = vs_jitter_max_us = 0;
+  vs_beam_hits = vs_beam_wait_us = vs_deferred = 0;
+#endif
+}
+
+void display_flush_benchmark(uint8_t rounds, DisplayFlushBench &out) {
+  out = {};
+  lv_disp_t *disp = lv_disp_get_default();
+  if (!disp || rounds == 0) return;
+  bench_flush_us = bench_flush_px = 0;
+  uint32_t t0 = micros();
+  for (uint8_t i = 0; i < rounds; i++) {
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(disp);
+    // The last stripe may still be on its way to the panel (async flush)
+    while (disp->driver->draw_buf->flushing) taskYIELD();
+  }
+  out.frame_us = (micros() - t0) / rounds;
+  out.flush_us = bench_flush_us / rounds;
+  out.px = bench_flush_px / rounds;
+}
+
+// Both render paths end up in the scan-out framebuffer (Panel_RGB's,
+// which readRect copies out of, or rgb_bounce's)
+void display_read_rows(uint16_t y, uint16_t rows, uint16_t *out) {
+#if DISPLAY_BOUNCE_LINES
+  if (bounce) {
+    memcpy(out, rgb_bounce_frame_buffer() + y * SCREEN_WIDTH, rows * SCREEN_WIDTH * sizeof(uint16_t));
+    return;
+  }
+#endif
+  lcd.readRect(0, y, SCREEN_WIDTH, rows, (lgfx::rgb565_t *)out);
+}
+
+void display_get_scanout_stats(DisplayScanoutStats &out) {
+  out = {};
+  out.pclk_hz = DISPLAY_PCLK_HZ;
+#if DISPLAY_BOUNCE_LINES
+  if (bounce) {
+    out.pclk_hz = rgb_bounce_pclk();
+    out.bounce_lines = DISPLAY_BOUNCE_LINES;
+  }
+#endif
+  out.underruns = scan_underruns;
+  out.max_stable_pclk_hz = max_stable_pclk_hz;
+}
+
+#define PCLK_PROBE_REDRAWS  10
+#define PCLK_PROBE_SETTLE_MS 100   // The new clock applies at a vsync; then a couple of scans
+
+void display_pclk_probe(DisplayPclkProbe &out) {
+  out = {};
+  out.base_hz = DISPLAY_PCLK_HZ;
+#if DISPLAY_BOUNCE_LINES
+  if (!bounce || scan_dma_ch < 0) return;
+  for (uint32_t hz = DISPLAY_PCLK_HZ; hz <= DISPLAY_PCLK_PROBE_MAX_HZ; hz += DISPLAY_PCLK_PROBE_STEP_HZ) {
+    if (!rgb_bounce_set_pclk(hz)) break;
+    vTaskDelay(pdMS_TO_TICKS(PCLK_PROBE_SETTLE_MS));
+#if !DISPLAY_VSYNC
+    scanout_poll();   // Drop a flag the clock switch itself raised
+#endif
+    uint32_t before = scan_underruns;
+    DisplayFlushBench redraw;
+    display_flush_benchmark(PCLK_PROBE_REDRAWS, redraw);
+    vTaskDelay(pdMS_TO_TICKS(PCLK_PROBE_SETTLE_MS));
+#if !DISPLAY_VSYNC
+    scanout_poll();
+#endif
+    out.steps++;
+    uint32_t underruns = scan_underruns - before;
+    Serial.printf("Scan-out: %lu Hz PCLK, %lu underruns\n", (unsigned long)hz, (unsigned long)underruns);
+    if (underruns) {
+      out.fail_hz = hz;
+      out.fail_underruns = underruns;
+      break;
+    }
+    out.max_stable_hz = hz;
+  }
+  rgb_bounce_set_pclk(DISPLAY_PCLK_HZ);
+  max_stable_pclk_hz = out.max_stable_hz;
+#endif
+}
+
+// ============================================================
+// lvgl_indev_kick() -- fresh touch data available, skip the wait for
+// the 30ms indev read period
+// ============================================================
+void lvgl_indev_kick() {
+  if (touch_indev && touch_indev->driver->read_timer) {
+    lv_timer_ready(touch_indev->driver->read_timer);
+  }
+}
+
+// ============================================================
+// lvgl_set_refresh_period() -- how often LVGL checks for invalidated
+// areas and renders them (power profiles slow this down)
 // ============================================================
-void lvgl_tick() {
-  lv_timer_handler();
+void lvgl_set_refresh_period(uint32_t ms) {
+  lv_disp_t *disp = lv_disp_get_default();
+  if (disp && disp->refr_timer) lv_timer_set_period(disp->refr_timer, ms);
 }
 
 // ============================================================
-// Brightness control wrappers
+// Brightness control: LEDC hardware fades
+//
+// Light_PWM sets the channel up (8-bit duty) and drives it until the fade
+// service is installed; from then on only the calls below touch it.
 // ============================================================
 static uint8_t current_brightness = 200;
+static bool fade_ready = false;
+static uint32_t fade_end_ms = 0;   // Hardware ramp running until then
 
-void set_backlight(uint8_t level) {
+static void backlight_fade_init() {
+#if BACKLIGHT_FADE_MS
+  esp_err_t err = ledc_fade_func_install(0);
+  fade_ready = err == ESP_OK || err == ESP_ERR_INVALID_STATE;  // Already installed by the core
+  if (!fade_ready) Serial.printf("Backlight: no LEDC fade service (%d), instant steps\n", err);
+#endif
+}
+
+// Same duty as Light_PWM: 255 maps to 256, fully on
+static inline uint32_t backlight_duty(uint8_t level) {
+  return level + (level >> 7);
+}
+
+void set_backlight(uint8_t level, uint32_t fade_ms) {
   current_brightness = level;
-  lcd.setBrightness(level);
+  if (!fade_ready) {
+    if (bounce) lcd._light_instance.setBrightness(level);   // No LGFX panel to go through
+    else lcd.setBrightness(level);
+    return;
+  }
+  // A running ramp is stopped where it is and the new one starts from there
+  if ((int32_t)(fade_end_ms - millis()) > 0) ledc_fade_stop(BACKLIGHT_LEDC_MODE, BACKLIGHT_LEDC_CHANNEL);
+  fade_end_ms = millis();
+
+  uint32_t duty = backlight_duty(level);
+  if (ledc_get_duty(BACKLIGHT_LEDC_MODE, BACKLIGHT_LEDC_CHANNEL) == duty) return;
+  if (fade_ms &&
+      ledc_set_fade_with_time(BACKLIGHT_LEDC_MODE, BACKLIGHT_LEDC_CHANNEL, duty, fade_ms) == ESP_OK &&
+      ledc_fade_start(BACKLIGHT_LEDC_MODE, BACKLIGHT_LEDC_CHANNEL, LEDC_FADE_NO_WAIT) == ESP_OK) {
+    fade_end_ms = millis() + fade_ms;
+    return;
+  }
+  ledc_set_duty(BACKLIGHT_LEDC_MODE, BACKLIGHT_LEDC_CHANNEL, duty);
+  ledc_update_duty(BACKLIGHT_LEDC_MODE, BACKLIGHT_LEDC_CHANNEL);
 }
 
 uint8_t get_backlight() {
@@ -4,9 +4,150 @@
 #define SCREEN_WIDTH  800
 #define SCREEN_HEIGHT 480
 
+// LVGL render target (build flag -DDISPLAY_LVGL_DIRECT_MODE=1):
+//   0 = two 800x40 PSRAM stripes copied into the panel with writePixels()
+//   1 = LVGL direct_mode straight into the Panel_RGB scanout framebuffer
+//       (no copy; flush only writes back the CPU cache for dirty rows)
+#ifndef DISPLAY_LVGL_DIRECT_MODE
+#define DISPLAY_LVGL_DIRECT_MODE 0
+#endif
+
+// Stripe path only: copy finished stripes from a flush task on core 0 so
+// LVGL renders the next stripe into the other buffer meanwhile (0 = copy
+// synchronously inside the flush callback).
+#ifndef DISPLAY_ASYNC_FLUSH
+#define DISPLAY_ASYNC_FLUSH 1
+#endif
+
+// Dirty areas whose bounding box costs at most this many percent more pixels
+// than the two areas alone are flushed as one (0 = LVGL's own joining only).
+#ifndef DISPLAY_MERGE_SLACK_PCT
+#define DISPLAY_MERGE_SLACK_PCT 25
+#endif
+
+// RGB pixel clock. 12 MHz is what the PSRAM-fed Bus_RGB scan-out holds
+// while LVGL renders; with bounce buffers the panel can be run faster.
+#ifndef DISPLAY_PCLK_HZ
+#define DISPLAY_PCLK_HZ 12000000
+#endif
+
+// Scan-out source (build flag -DDISPLAY_BOUNCE_LINES=N):
+//   0 = LovyanGFX Bus_RGB, the DMA reads the PSRAM framebuffer directly
+//   N = esp_lcd RGB panel fed from two N-line internal-RAM bounce buffers
+//       (2 x N x 1.6 KB) refilled from the PSRAM framebuffer; N divides 240
+#ifndef DISPLAY_BOUNCE_LINES
+#define DISPLAY_BOUNCE_LINES 0
+#endif
+#if DISPLAY_BOUNCE_LINES && (SCREEN_HEIGHT % (2 * DISPLAY_BOUNCE_LINES))
+#error "DISPLAY_BOUNCE_LINES must divide SCREEN_HEIGHT / 2"
+#endif
+
+// PCLK probe ceiling and step (bounce buffers only, see display_pclk_probe)
+#ifndef DISPLAY_PCLK_PROBE_MAX_HZ
+#define DISPLAY_PCLK_PROBE_MAX_HZ 24000000
+#endif
+#ifndef DISPLAY_PCLK_PROBE_STEP_HZ
+#define DISPLAY_PCLK_PROBE_STEP_HZ 2000000
+#endif
+
+// Vsync-aware presentation (build flag -DDISPLAY_VSYNC=N). The RGB panel
+// scans the framebuffer continuously; the VSYNC pin's pulses give the row
+// being scanned at any moment.
+//   0 = off: stripes and cache write-backs land whenever LVGL has them
+//   1 = track vsync and count stripes written under the beam, change nothing
+//   2 = paced: frames taller than a stripe start rendering on the vsync
+//       pulse, and a stripe the beam is on waits until it has passed
+#ifndef DISPLAY_VSYNC
+#define DISPLAY_VSYNC 2
+#endif
+
 void display_init();   // Init LovyanGFX RGB panel + PCA9557 touch reset + backlight
 void lvgl_init();      // Init LVGL buffers, register display/touch drivers
-void lvgl_tick();      // Call lv_timer_handler() -- call from loop()
+uint32_t lvgl_tick(); // Call lv_timer_handler() -- returns ms until LVGL needs to run again
+void lvgl_indev_kick(); // Make the touch indev read on the next lvgl_tick()
+void lvgl_set_refresh_period(uint32_t ms);  // Display refresh timer (LV_DISP_DEF_REFR_PERIOD at boot)
+
+// Stop / restart all LVGL timers (clock_direct.h). Stopping waits for a
+// flush in flight; while stopped lvgl_tick() returns UINT32_MAX and no
+// LVGL rendering happens, so display_write_rect() owns the panel.
+void lvgl_suspend(bool suspend);
+bool lvgl_suspended();
+
+// Backlight level changes ramp on the LEDC hardware fade engine: the call
+// returns at once and no CPU is spent while the duty moves. A new level
+// mid-fade retargets from wherever the ramp is. -DBACKLIGHT_FADE_MS=0
+// keeps instant steps through lcd.setBrightness().
+#ifndef BACKLIGHT_FADE_MS
+#define BACKLIGHT_FADE_MS 400        // Power state changes, preset cycling
+#endif
+#ifndef BACKLIGHT_STEP_FADE_MS
+#define BACKLIGHT_STEP_FADE_MS 80    // Encoder steps: consecutive detents chain into one ramp
+#endif
+
+void set_backlight(uint8_t level, uint32_t fade_ms = BACKLIGHT_FADE_MS);   // 0=off, 255=max
+uint8_t get_backlight();             // Level last asked for (the fade's target)
+
+uint16_t display_get_fps();          // Frames completed in the last 1 s window
+
+// Frame pacing (DISPLAY_VSYNC >= 1; all zero otherwise). Counters run
+// since display_reset_vsync_stats(), which perf_reset() calls.
+struct DisplayVsyncStats {
+  bool running;                      // Pulses arriving on the VSYNC pin
+  uint32_t vsyncs;                   // Since boot
+  uint32_t period_us;                // Measured scan period
+  uint32_t frames;                   // Frames presented
+  uint32_t missed;                   // Vsyncs passed between a frame's first and last flush
+  uint32_t split_frames;             // Frames that landed on more than one scan
+  uint32_t phase_avg_us;             // Vsync -> frame's last flush done, running mean
+  uint32_t jitter_us;                // Mean deviation from phase_avg_us (present jitter)
+  uint32_t jitter_max_us;
+  uint32_t beam_hits;                // Stripes due on rows the beam was about to scan
+  uint32_t beam_wait_us;             // Time those were held back (mode 2)
+  uint32_t deferred;                 // Refreshes moved up to the next vsync (mode 2)
+};
+void display_get_vsync_stats(DisplayVsyncStats &out);
+void display_reset_vsync_stats();
+
+// Scan-out health. An underrun is a scan in which the panel DMA's FIFO ran
+// dry (GDMA out-FIFO underflow flag): the panel showed stale or shifted
+// pixels. Checked once per vsync (DISPLAY_VSYNC) or per lvgl_tick().
+struct DisplayScanoutStats {
+  uint32_t pclk_hz;                  // Running pixel clock
+  uint16_t bounce_lines;             // 0: scan-out straight from PSRAM
+  uint32_t underruns;                // Since boot
+  uint32_t max_stable_pclk_hz;       // Last display_pclk_probe() result, 0 = not probed
+};
+void display_get_scanout_stats(DisplayScanoutStats &out);
+
+// Step the PCLK up from DISPLAY_PCLK_HZ by DISPLAY_PCLK_PROBE_STEP_HZ,
+// redrawing the full screen at each step, until a step underruns or
+// DISPLAY_PCLK_PROBE_MAX_HZ is reached; then back to DISPLAY_PCLK_HZ. A
+// second or so of flicker. Bounce-buffer builds only (steps = 0 otherwise).
+// UI task only.
+struct DisplayPclkProbe {
+  uint32_t base_hz;
+  uint32_t max_stable_hz;            // Highest step without an underrun
+  uint32_t fail_hz;                  // First step that underran, 0 = none up to the ceiling
+  uint32_t fail_underruns;
+  uint8_t steps;
+};
+void display_pclk_probe(DisplayPclkProbe &out);
+
+// Redraw the whole active screen `rounds` times with lv_refr_now(): mean
+// time per frame (render + flush) and the disp_flush_cb share of it, for
+// POST /api/bench. UI task only.
+struct DisplayFlushBench {
+  uint32_t frame_us;
+  uint32_t flush_us;                 // Flush callback time per frame
+  uint32_t px;                       // Pixels flushed per frame
+};
+void display_flush_benchmark(uint8_t rounds, DisplayFlushBench &out);
+
+// Write RGB565 pixels (LVGL's colour format) straight into the scan-out
+// framebuffer, behind the beam when DISPLAY_VSYNC paces. UI task, only
+// while LVGL is suspended.
+void display_write_rect(int16_t x, int16_t y, uint16_t w, uint16_t h, const uint16_t *px);
 
-void set_backlight(uint8_t level);   // 0=off, 255=max. Wraps lcd.setBrightness().
-uint8_t get_backlight();
+// Copy `rows` full-width rows of the panel's scanout framebuffer from row y,
+// RGB565 as LVGL renders it. Any task; hold ui_lock() for a whole frame.
+void display_read_rows(uint16_t y, uint16_t rows, uint16_t *out);
@@ -0,0 +1,320 @@
+/**
+ * @file draw_accel.cpp
+ * RGB565 fill / copy / blend kernels behind lv_draw_sw's blend hook
+ *
+ * Clipping and mask/source offsets follow lv_draw_sw_blend_basic() exactly,
+ * so the kernels only ever see one destination rectangle with a stride.
+ */
+
+#include "draw_accel.h"
+#include <Arduino.h>
+#include <string.h>
+#include <esp_heap_caps.h>
+
+#if defined(CONFIG_IDF_TARGET_ESP32S3)
+#define DRAW_ACCEL_PIE 1   // 128-bit q registers (EE.VLD/EE.VST)
+#else
+#define DRAW_ACCEL_PIE 0
+#endif
+
+// ============================================================
+// Kernels
+// ============================================================
+
+// RGB565 as 0000 0GGG GGG0 0000 RRRR R000 00BB BBBB: one multiply blends
+// all three channels with room for the carries
+static inline uint32_t spread565(uint16_t c) {
+    return (c | ((uint32_t)c << 16)) & 0x07E0F81Fu;
+}
+
+static inline uint16_t blend_spread(uint32_t fg, uint16_t bg, uint32_t a5) {
+    uint32_t b = spread565(bg);
+    uint32_t r = ((((fg - b) * a5) >> 5) + b) & 0x07E0F81Fu;
+    return (uint16_t)(r | (r >> 16));
+}
+
+// LVGL opacity (0-255) to the kernel's 0-32
+static inline uint32_t alpha5(uint32_t opa) {
+    return (opa * 32 + 128) >> 8;
+}
+
+static void fill_row(uint16_t *dst, int32_t n, uint16_t color, const uint16_t *pattern) {
+#if DRAW_ACCEL_PIE
+    while (n > 0 && ((uintptr_t)dst & 15)) { *dst++ = color; n--; }
+    int32_t blocks = n >> 3;
+    if (blocks > 0) {
+        const uint16_t *pat = pattern;
+        asm volatile(
+            "ee.vld.128.ip q0, %[pat], 0    \n"
+            "loopgtz %[n], 1f               \n"
+            "ee.vst.128.ip q0, %[dst], 16   \n"
+            "1:                             \n"
+            : [dst] "+r"(dst), [pat] "+r"(pat)
+            : [n] "r"(blocks)
+            : "memory");
+        n &= 7;
+    }
+#else
+    (void)pattern;
+    if (n > 0 && ((uintptr_t)dst & 2)) { *dst++ = color; n--; }
+    uint32_t pair = color | ((uint32_t)color << 16);
+    uint32_t *d32 = (uint32_t *)dst;
+    for (; n >= 2; n -= 2) *d32++ = pair;
+    dst = (uint16_t *)d32;
+#endif
+    while (n-- > 0) *dst++ = color;
+}
+
+static void copy_row(uint16_t *dst, const uint16_t *src, int32_t n) {
+#if DRAW_ACCEL_PIE
+    if ((((uintptr_t)dst ^ (uintptr_t)src) & 15) == 0) {
+        while (n > 0 && ((uintptr_t)dst & 15)) { *dst++ = *src++; n--; }
+        int32_t blocks = n >> 3;
+        if (blocks > 0) {
+            asm volatile(
+                "loopgtz %[n], 1f               \n"
+                "ee.vld.128.ip q0, %[src], 16   \n"
+                "ee.vst.128.ip q0, %[dst], 16   \n"
+                "1:                             \n"
+                : [dst] "+r"(dst), [src] "+r"(src)
+                : [n] "r"(blocks)
+                : "memory");
+            n &= 7;
+        }
+        while (n-- > 0) *dst++ = *src++;
+        return;
+    }
+#endif
+    memcpy(dst, src, n * sizeof(uint16_t));
+}
+
+// Solid colour at `opa`, optionally through a per-pixel mask
+static void fill_rect(uint16_t *dst, int32_t dst_stride, int32_t w, int32_t h, uint16_t color,
+                      lv_opa_t opa, const lv_opa_t *mask, int32_t mask_stride) {
+    if (!mask && opa >= LV_OPA_MAX) {
+        alignas(16) uint16_t pattern[8];
+        for (int i = 0; i < 8; i++) pattern[i] = color;
+        for (int32_t y = 0; y < h; y++, dst += dst_stride) fill_row(dst, w, color, pattern);
+        return;
+    }
+    uint32_t fg = spread565(color);
+    if (!mask) {
+        uint32_t a5 = alpha5(opa);
+        for (int32_t y = 0; y < h; y++, dst += dst_stride) {
+            for (int32_t x = 0; x < w; x++) dst[x] = blend_spread(fg, dst[x], a5);
+        }
+        return;
+    }
+    for (int32_t y = 0; y < h; y++, dst += dst_stride, mask += mask_stride) {
+        for (int32_t x = 0; x < w; x++) {
+            uint32_t m = opa >= LV_OPA_MAX ? mask[x] : (mask[x] * opa) >> 8;
+            if (m >= LV_OPA_MAX) dst[x] = color;
+            else if (m > LV_OPA_MIN) dst[x] = blend_spread(fg, dst[x], alpha5(m));
+        }
+    }
+}
+
+// Source image at `opa`, optionally through a per-pixel mask
+static void image_rect(uint16_t *dst, int32_t dst_stride, const uint16_t *src, int32_t src_stride,
+                       int32_t w, int32_t h, lv_opa_t opa, const lv_opa_t *mask, int32_t mask_stride) {
+    if (!mask && opa >= LV_OPA_MAX) {
+        for (int32_t y = 0; y < h; y++, dst += dst_stride, src += src_stride) copy_row(dst, src, w);
+        return;
+    }
+    uint32_t a5 = alpha5(opa);
+    for (int32_t y = 0; y < h; y++, dst += dst_stride, src += src_stride) {
+        if (!mask) {
+            for (int32_t x = 0; x < w; x++) dst[x] = blend_spread(spread565(src[x]), dst[x], a5);
+            continue;
+        }
+        for (int32_t x = 0; x < w; x++) {
+            uint32_t m = opa >= LV_OPA_MAX ? mask[x] : (mask[x] * opa) >> 8;
+            if (m >= LV_OPA_MAX) dst[x] = src[x];
+            else if (m > LV_OPA_MIN) dst[x] = blend_spread(spread565(src[x]), dst[x], alpha5(m));
+        }
+        mask += mask_stride;
+    }
+}
+
+// ============================================================
+// Blend hook
+// ============================================================
+static void accel_blend(lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *dsc) {
+    const lv_opa_t *mask = dsc->mask_buf;
+    if (mask && dsc->mask_res == LV_DRAW_MASK_RES_TRANSP) return;
+    if (dsc->mask_res == LV_DRAW_MASK_RES_FULL_COVER) mask = nullptr;
+
+    lv_disp_t *disp = _lv_refr_get_disp_refreshing();
+    if (dsc->blend_mode != LV_BLEND_MODE_NORMAL || disp->driver->set_px_cb || disp->driver->screen_transp) {
+        lv_draw_sw_blend_basic(draw_ctx, dsc);
+        return;
+    }
+
+    lv_area_t area;
+    if (!_lv_area_intersect(&area, dsc->blend_area, draw_ctx->clip_area)) return;
+    int32_t w = lv_area_get_width(&area);
+    int32_t h = lv_area_get_height(&area);
+
+    int32_t dst_stride = lv_area_get_width(draw_ctx->buf_area);
+    uint16_t *dst = (uint16_t *)draw_ctx->buf + dst_stride * (area.y1 - draw_ctx->buf_area->y1) +
+                    (area.x1 - draw_ctx->buf_area->x1);
+
+    int32_t mask_stride = 0;
+    if (mask) {
+        mask_stride = lv_area_get_width(dsc->mask_area);
+        mask += mask_stride * (area.y1 - dsc->mask_area->y1) + (area.x1 - dsc->mask_area->x1);
+    }
+
+    if (!dsc->src_buf) {
+        fill_rect(dst, dst_stride, w, h, dsc->color.full, dsc->opa, mask, mask_stride);
+        return;
+    }
+    int32_t src_stride = lv_area_get_width(dsc->blend_area);
+    const uint16_t *src = (const uint16_t *)dsc->src_buf + src_stride * (area.y1 - dsc->blend_area->y1) +
+                          (area.x1 - dsc->blend_area->x1);
+    image_rect(dst, dst_stride, src, src_stride, w, h, dsc->opa, mask, mask_stride);
+}
+
+static void accel_ctx_init(lv_disp_drv_t *drv, lv_draw_ctx_t *ctx) {
+    lv_draw_sw_init_ctx(drv, ctx);
+    ((lv_draw_sw_ctx_t *)ctx)->blend = accel_blend;
+}
+
+#define DRAW_ACCEL_ACTIVE (DRAW_ACCEL && LV_COLOR_DEPTH == 16 && !LV_COLOR_16_SWAP)
+
+void draw_accel_install(lv_disp_drv_t *drv) {
+#if DRAW_ACCEL_ACTIVE
+    drv->draw_ctx_init = accel_ctx_init;
+    drv->draw_ctx_deinit = lv_draw_sw_deinit_ctx;
+    drv->draw_ctx_size = sizeof(lv_draw_sw_ctx_t);
+    Serial.printf("[draw] accelerated blend (%s fill/copy)\n", DRAW_ACCEL_PIE ? "PIE" : "scalar");
+#else
+    (void)drv;
+#endif
+}
+
+// ============================================================
+// Benchmark
+// ============================================================
+#define BENCH_W      800
+#define BENCH_H      480
+#define BENCH_ROUNDS 5
+
+struct BenchBufs {
+    uint16_t *dst;
+    uint16_t *src;
+};
+
+typedef void (*BenchFn)(const BenchBufs &b);
+
+// Average us per full-screen pass
+static uint32_t bench_time(BenchFn fn, const BenchBufs &b) {
+    fn(b);   // Warm the cache lines and the code path
+    uint32_t t0 = micros();
+    for (int i = 0; i < BENCH_ROUNDS; i++) fn(b);
+    return (micros() - t0) / BENCH_ROUNDS;
+}
+
+static const lv_color_t BENCH_COLOR = lv_color_hex(0x3498DB);
+
+// LVGL's own scalar paths for the same operations (lv_draw_sw_blend.c)
+static void ref_fill(const BenchBufs &b) {
+    for (int y = 0; y < BENCH_H; y++) lv_color_fill((lv_color_t *)b.dst + y * BENCH_W, BENCH_COLOR, BENCH_W);
+}
+
+static void ref_blend(const BenchBufs &b) {
+    lv_color_t *d = (lv_color_t *)b.dst;
+    for (int i = 0; i < BENCH_W * BENCH_H; i++) d[i] = lv_color_mix(BENCH_COLOR, d[i], LV_OPA_90);
+}
+
+static void ref_copy(const BenchBufs &b) {
+    for (int y = 0; y < BENCH_H; y++) lv_memcpy(b.dst + y * BENCH_W, b.src + y * BENCH_W, BENCH_W * 2);
+}
+
+static void ref_image_blend(const BenchBufs &b) {
+    lv_color_t *d = (lv_color_t *)b.dst;
+    const lv_color_t *s = (const lv_color_t *)b.src;
+    for (int i = 0; i < BENCH_W * BENCH_H; i++) d[i] = lv_color_mix(s[i], d[i], LV_OPA_50);
+}
+
+static void acc_fill(const BenchBufs &b) {
+    fill_rect(b.dst, BENCH_W, BENCH_W, BENCH_H, BENCH_COLOR.full, LV_OPA_COVER, nullptr, 0);
+}
+
+static void acc_blend(const BenchBufs &b) {
+    fill_rect(b.dst, BENCH_W, BENCH_W, BENCH_H, BENCH_COLOR.full, LV_OPA_90, nullptr, 0);
+}
+
+static void acc_copy(const BenchBufs &b) {
+    image_rect(b.dst, BENCH_W, b.src, BENCH_W, BENCH_W, BENCH_H, LV_OPA_COVER, nullptr, 0);
+}
+
+static void acc_image_blend(const BenchBufs &b) {
+    image_rect(b.dst, BENCH_W, b.src, BENCH_W, BENCH_W, BENCH_H, LV_OPA_50, nullptr, 0);
+}
+
+static bool bench_alloc(BenchBufs &b) {
+    size_t bytes = BENCH_W * BENCH_H * sizeof(uint16_t);
+    // 16-byte aligned so the copy takes the vector path, as LVGL's buffers do
+    b.dst = (uint16_t *)heap_caps_aligned_alloc(16, bytes, MALLOC_CAP_SPIRAM);
+    b.src = (uint16_t *)heap_caps_aligned_alloc(16, bytes, MALLOC_CAP_SPIRAM);
+    if (!b.dst || !b.src) {
+        Serial.println("[draw] bench: no PSRAM for two 800x480 buffers");
+        heap_caps_free(b.dst);
+        heap_caps_free(b.src);
+        return false;
+    }
+    for (int i = 0; i < BENCH_W * BENCH_H; i++) {
+        b.src[i] = (uint16_t)(i * 2654435761u >> 16);
+        b.dst[i] = 0;
+    }
+    return true;
+}
+
+bool draw_accel_measure(DrawBenchResult &out) {
+    BenchBufs b;
+    if (!bench_alloc(b)) return false;
+    out.accelerated = DRAW_ACCEL_ACTIVE;
+    out.fill_us = bench_time(out.accelerated ? acc_fill : ref_fill, b);
+    out.fill_opa_us = bench_time(out.accelerated ? acc_blend : ref_blend, b);
+    out.copy_us = bench_time(out.accelerated ? acc_copy : ref_copy, b);
+    out.copy_opa_us = bench_time(out.accelerated ? acc_image_blend : ref_image_blend, b);
+    heap_caps_free(b.dst);
+    heap_caps_free(b.src);
+    return true;
+}
+
+void draw_accel_benchmark() {
+    BenchBufs b;
+    if (!bench_alloc(b)) return;
+
+    struct { const char *name; BenchFn ref, acc; } cases[] = {
+        { "fill",              ref_fill,        acc_fill },
+        { "fill opa 90%",      ref_blend,       acc_blend },
+        { "image copy",        ref_copy,        acc_copy },
+        { "image opa 50%",     ref_image_blend, acc_image_blend },
+    };
+    Serial.printf("[draw] bench: 800x480 RGB565 in PSRAM, %s kernels\n", DRAW_ACCEL_PIE ? "PIE" : "scalar");
+    for (const auto &c : cases) {
+        uint32_t ref_us = bench_time(c.ref, b);
+        uint32_t acc_us = bench_time(c.acc, b);
+        Serial.printf("[draw]   %-14s lvgl %6lu us  accel %6lu us  (%.2fx)\n", c.name,
+                      (unsigned long)ref_us, (unsigned long)acc_us, acc_us ? (float)ref_us / acc_us : 0.0f);
+    }
+
+    // Blend quality: 5-bit alpha against LVGL's 8-bit mix
+    int max_err = 0;
+    for (int i = 0; i < 4096; i++) {
+        lv_color_t bg; bg.full = b.src[i];
+        lv_color_t want = lv_color_mix(BENCH_COLOR, bg, LV_OPA_90);
+        uint16_t got = blend_spread(spread565(BENCH_COLOR.full), bg.full, alpha5(LV_OPA_90));
+        int dr = abs((int)(want.full >> 11) - (int)(got >> 11));
+        int dg = abs((int)((want.full >> 5) & 0x3F) - (int)((got >> 5) & 0x3F));
+        int db = abs((int)(want.full & 0x1F) - (int)(got & 0x1F));
+        max_err = max(max_err, max(dr, max(dg, db)));
+    }
+    Serial.printf("[draw]   blend differs from LVGL by at most %d LSB per channel\n", max_err);
+
+    heap_caps_free(b.dst);
+    heap_caps_free(b.src);
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <lvgl.h>
+
+// ============================================================
+// Accelerated LVGL software blend (RGB565)
+//
+// Installed as lv_draw_sw's blend hook, it takes the common cases that
+// every fill, box shadow and image ends in:
+//   - opaque fill             128-bit PIE stores (ESP32-S3), 8 px per op
+//   - opaque image copy       128-bit PIE load/store when source and
+//                             destination are 16-byte co-aligned
+//   - fill/image with opacity two-pixels-in-a-word blend (5-bit alpha),
+//     also per pixel through an anti-aliasing / shadow mask
+// Anything else (blend modes, set_px_cb, transparent screens) goes to
+// lv_draw_sw_blend_basic() unchanged. Off the S3 the fill and copy
+// kernels fall back to scalar loops.
+//
+// -DDRAW_ACCEL=0 keeps LVGL's own blend.
+// ============================================================
+
+#ifndef DRAW_ACCEL
+#define DRAW_ACCEL 1
+#endif
+
+// Fill / blend / copy microbenchmark, LVGL-style scalar loops against the
+// kernels above on full-screen buffers in PSRAM; results to Serial. Runs
+// once at boot when DRAW_ACCEL_BENCH_AT_BOOT=1.
+#ifndef DRAW_ACCEL_BENCH_AT_BOOT
+#define DRAW_ACCEL_BENCH_AT_BOOT 0
+#endif
+
+// Point the driver's draw context at the accelerated blend. Call on the
+// driver before lv_disp_drv_register().
+void draw_accel_install(lv_disp_drv_t *drv);
+
+void draw_accel_benchmark();
+
+// The same full-screen passes through the blend LVGL actually uses (these
+// kernels when installed, else its own), us per 800x480 frame. For POST
+// /api/bench (hw_bench.h); any task. False without PSRAM for the buffers.
+struct DrawBenchResult {
+    uint32_t fill_us;
+    uint32_t fill_opa_us;     // 90% opacity fill
+    uint32_t copy_us;         // Opaque image
+    uint32_t copy_opa_us;     // 50% opacity image
+    bool accelerated;
+};
+bool draw_accel_measure(DrawBenchResult &out);
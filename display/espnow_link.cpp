@@ -2,122 +2,1248 @@
  * @file espnow_link.cpp
  * ESP-NOW wireless link for display <-> bridge communication
  *
- * Broadcasts hotkey/media key commands; receives ACKs and stats from bridge.
- * No pairing required -- bridge accepts from any peer.
+ * Sends hotkey/media key commands; receives ACKs and stats from bridge.
+ * Incoming frames go through an SPSC ring (control messages) plus a
+ * latest-value slot for MSG_STATS, so bursts aren't lost between polls.
+ *
+ * Commands (hotkey, media, macro, button press, DDC) are sequenced: each
+ * carries a SEQ and stays in a small in-flight window until the bridge ACKs
+ * it, and is retransmitted on timeout. The bridge suppresses duplicates, so
+ * retries are safe.
+ *
+ * Once paired (MSG_PAIR_REQ/ACK, bridge MAC kept in NVS) frames go unicast,
+ * which adds MAC-layer ACK/retry and a faster PHY rate underneath. Until
+ * then everything is broadcast and the SEQ retries are all there is.
+ * Several bridges can be paired (hosts, see espnow_link.h); frames and
+ * retransmits carry the host slot they are for, stats are kept per host.
+ *
+ * Outgoing frames go through a TX queue: one frame is with the driver at a
+ * time, the send-complete callback reports its delivery status, and the loop
+ * hands over the next one. Bursts no longer hit ESP_ERR_ESPNOW_NO_MEM.
+ * Trackpad motion (MSG_POINTER) is merged into a pointer frame that is
+ * still queued, so the pointer stream never queues up behind the radio.
+ *
+ * Frames are built when they reach the driver: v2 (header + CRC8) once
+ * the bridge's MSG_HELLO reply says it speaks v2, legacy until then or if
+ * it never answers. Received frames of either format are decoded; a bridge
+ * that falls back to legacy frames is asked for a HELLO again.
+ *
+ * The bridge picks the radio channel (MSG_CHANNEL in protocol.h). A switch
+ * order is applied once its delay runs out; a display that lost the bridge
+ * anyway (missed order, bridge reflashed onto another channel) hunts:
+ * one broadcast PAIR_REQ per channel until a PAIR_ACK answers. No channel
+ * change while the SoftAP is up, whose clients are on the current one.
+ *
+ * With the companion on the display's own USB port (wired_link.h), the
+ * public sends go over the cable and its frames come in through
+ * espnow_deliver_wired(); pairing, pings, HELLO and channel traffic stay
+ * on the radio, so the bridge link is still up when the cable goes.
+ *
+ * TX power and the unicast PHY rate follow the link (shared/link_adapt.h):
+ * the heartbeat PING tells the bridge how loud it arrives, its ACK tells us
+ * the same about ours, and each heartbeat steps power down while the
+ * bridge hears us clearly or back up (then to a slower rate) when frames
+ * start getting lost. Full power while the SoftAP is up or the bridge is lost.
  */
 
 #include "espnow_link.h"
+#include "events.h"
+#include "key_layouts.h"
+#include "log.h"
+#include "trace.h"
+#include "wired_link.h"
 #include <Arduino.h>
 #include <WiFi.h>
 #include <esp_now.h>
 #include <esp_wifi.h>
 #include <esp_idf_version.h>
+#include <Preferences.h>
 #include <string.h>
 
 // Broadcast address (all 0xFF)
 static const uint8_t broadcast_addr[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
 
-// ACK receive buffer (callback -> poll)
-static volatile bool ack_ready = false;
-static volatile uint8_t ack_status_buf = 0;
+// Paired bridges (NVS "espnow"/"hosts", 6 bytes each, active slot in
+// "host"; "peer" keeps the active one for older firmware). Broadcast until
+// one is known. host_count and active_host only change in loop context.
+#define PAIR_LOST_PERIODS 3   // Fall back to broadcasting PAIR_REQ after this many silent heartbeats
+#define HEARTBEAT_MS      5000   // Default espnow_send_heartbeat() period (espnow_host_linked)
+
+static uint8_t host_mac[ESPNOW_MAX_HOSTS][6] = {};
+static volatile uint8_t host_count = 0;
+static volatile uint8_t active_host = 0;
+static volatile uint32_t host_rx_ms[ESPNOW_MAX_HOSTS] = {};
+static bool paired = false;                   // host_count > 0
+static uint32_t heartbeat_ms = HEARTBEAT_MS;
+static uint32_t pair_window_ms = 0;           // espnow_pair_new_host(), 0 = closed
+
+// PAIR_ACK source (callback -> espnow_link_update, NVS can't be written from the WiFi task)
+static volatile bool pair_pending = false;
+static uint8_t pair_pending_mac[6];
+static uint8_t pair_pending_channel = 0;
+
+static uint8_t host_lookup(const uint8_t *mac) {
+    for (uint8_t i = 0; i < host_count; i++) {
+        if (memcmp(host_mac[i], mac, 6) == 0) return i;
+    }
+    return ESPNOW_HOST_NONE;
+}
+
+// Bridge protocol (MSG_HELLO), per host. Written by on_recv.
+#define DISPLAY_CAPS    (PROTO_CAP_DELTA_STATS | PROTO_CAP_FRAGMENT | PROTO_CAP_COMPRESS | PROTO_CAP_WIDE_STATS | \
+                         PROTO_CAP_BATCH)
+#define HELLO_TRIES     3        // HELLOs per link-up; no reply = a legacy bridge
+#define HELLO_RETRY_MS  1000
+
+static volatile bool host_v2[ESPNOW_MAX_HOSTS] = {};
+static volatile uint16_t host_caps[ESPNOW_MAX_HOSTS];
+static volatile bool hello_request = false;   // Link-up / bridge fell back to legacy frames
+static volatile bool hello_answered = false;
+static uint8_t hello_left = 0;
+static uint32_t hello_due_ms = 0;
+
+// Fragment reassembly (on_recv only): one message from the bridge at a time
+static uint8_t frag_buf[PROTO_MAX_PAYLOAD];
+static uint8_t frag_len = 0;
+static uint8_t frag_seq = 0;
+static uint8_t frag_next = 0xFF;              // Expected index, 0xFF = none in progress
+
+static volatile uint32_t rx_bad = 0;          // CRC / version / length failures
+static volatile uint32_t rx_frag_lost = 0;    // Fragmented messages dropped (gap, overflow)
+
+// Radio channel (NVS "espnow"/"chan"). `channel` is the committed one;
+// radio_channel is where the radio is right now (differs while hunting).
+#define HUNT_DWELL_MS       150      // Per channel: PAIR_REQ out, time for the ACK to come back
+#define HUNT_INTERVAL_MS    10000    // A full sweep at most this often while the bridge is lost
+#define QUALITY_WINDOW_MS   30000    // Unicast delivery measured over this window
+#define QUALITY_MIN_FRAMES  10       // ... with at least this many frames
+#define QUALITY_FAIL_PCT    30       // Ask the bridge for a survey above this failure rate
+
+static uint8_t channel = ESPNOW_CHANNEL;
+static volatile uint8_t radio_channel = ESPNOW_CHANNEL;
+
+// CHANNEL_SWITCH from the bridge (callback -> espnow_link_update)
+static volatile bool switch_pending = false;
+static volatile uint8_t switch_pending_channel = 0;
+static volatile uint16_t switch_pending_delay = 0;
+static bool switch_scheduled = false;
+static uint8_t switch_channel = 0;
+static uint32_t switch_at_ms = 0;
+
+static bool hunting = false;
+static uint8_t hunt_next = 1;            // Next channel to try
+static uint32_t hunt_step_ms = 0;
+static uint32_t hunt_started_ms = 0;     // 0 = never
+
+static uint32_t quality_ok = 0, quality_fail = 0;   // Unicast send completions this window
+static uint32_t quality_window_ms = 0;
+static uint32_t survey_requested_ms = 0;            // 0 = never
+
+static void add_peer(const uint8_t *mac) {
+    if (esp_now_is_peer_exist(mac)) return;
+    esp_now_peer_info_t peer = {};
+    memcpy(peer.peer_addr, mac, 6);
+    peer.channel = 0;   // Whatever channel the radio is on: follows switches and hunting
+    peer.encrypt = false;
+    esp_now_add_peer(&peer);
+}
+
+// TX queue (loop context only). The send callback just records completion.
+#define TX_QUEUE_SIZE      8
+#define TX_NO_MEM_RETRY_MS 2     // Driver out of buffers: try again after this
+#define TX_DONE_TIMEOUT_MS 100   // No send callback by then: assume it failed
+#define TX_AVG_SHIFT       3     // EWMA weight 1/8
+
+struct TxFrame {
+    bool     broadcast;                  // Force broadcast (PAIR_REQ)
+    bool     legacy;                     // Legacy framing whatever the bridge speaks (PAIR_REQ, HELLO)
+    uint8_t  host;                       // Destination host slot
+    uint8_t  type;
+    uint8_t  seq;                        // 0 = unsequenced
+    uint8_t  len;
+    uint32_t queued_us;                  // Enqueue time (TX latency start)
+    uint8_t  payload[PROTO_MAX_PAYLOAD];
+};
+
+static TxFrame tx_queue[TX_QUEUE_SIZE];
+static int tx_q_head = 0;
+static int tx_q_tail = 0;
+static bool tx_busy = false;             // A frame is with the driver
+static uint32_t tx_busy_ms = 0;
+static uint32_t tx_busy_queued_us = 0;
+static bool tx_busy_unicast = false;
+static bool tx_backoff = false;
+static uint32_t tx_backoff_ms = 0;
+static uint32_t pointer_merged = 0;      // MSG_POINTER motion folded into a queued frame
+
+// Send-complete callback -> loop
+static volatile bool tx_done = false;
+static volatile bool tx_done_ok = false;
+static volatile uint32_t tx_done_us = 0;
+
+// ACK ring (callback -> espnow_link_update), same SPSC rules as rx_queue
+#define ACK_QUEUE_SIZE 8
+
+struct AckMsg {
+    uint8_t status;
+    uint8_t seq;
+    uint8_t host;
+    uint32_t rx_us;
+};
+
+static volatile AckMsg ack_queue[ACK_QUEUE_SIZE];
+static volatile int ack_head = 0;
+static volatile int ack_tail = 0;
+
+// Latest ACK status for espnow_poll_ack()
+static bool ack_ready = false;
+static uint8_t ack_status_buf = 0;
+
+// In-flight window for sequenced commands (loop context only)
+#define TX_WINDOW         4
+#define TX_RETRY_MS       30    // Retransmit if no ACK within this
+#define TX_MAX_RETRIES    3     // Then give up and count the frame as lost
+#define RTT_AVG_SHIFT     3     // EWMA weight 1/8
 
-// Generic message receive buffer (callback -> poll)
-// Stores one message at a time; newer messages overwrite older unread ones.
-static volatile bool msg_ready = false;
-static volatile uint8_t msg_type_buf = 0;
-static volatile uint8_t msg_payload_len_buf = 0;
-static uint8_t msg_payload_buf[PROTO_MAX_PAYLOAD];
+struct TxSlot {
+    bool     used;
+    uint8_t  seq;
+    uint8_t  retries;
+    uint8_t  host;                       // Retransmitted to the host it was first sent to
+    uint8_t  type;
+    uint8_t  len;
+    uint32_t first_us;                   // First transmission (RTT start)
+    uint32_t sent_ms;                    // Last transmission (retry timer)
+    uint8_t  payload[PROTO_MAX_PAYLOAD];
+};
+
+static TxSlot tx_window[TX_WINDOW];
+static uint8_t next_seq = 0;
+static LinkStats link_stats = {};
+static uint8_t probe_seq = 0;          // espnow_ping_probe() in flight (0 = none)
+static uint32_t probe_rtt_us = 0;
+
+// Ring buffer for received messages (WiFi task -> espnow_dispatch)
+// Single producer (on_recv) / single consumer (loop), so head is only written
+// by the callback and tail only by the poller. Xtensa GCC serializes volatile
+// accesses (memw), which is all the ordering an SPSC ring needs.
+#define RX_QUEUE_SIZE 8
+
+// Slots held back for control messages: bulk/periodic frames are refused once
+// fewer than this many slots are free, so a burst can't starve CONFIG_MODE etc.
+#define RX_CONTROL_RESERVE 2
+
+struct RxMsg {
+    uint8_t type;
+    uint8_t version;
+    uint8_t payload[PROTO_MAX_PAYLOAD];
+    uint8_t len;
+    uint32_t rx_us;
+};
+
+static volatile RxMsg rx_queue[RX_QUEUE_SIZE];
+static volatile int rx_head = 0;
+static volatile int rx_tail = 0;
+
+// Latest-value slot for MSG_STATS per host (newest frame wins, never queued).
+// Seqlock: writer makes seq odd while copying, even when done. The reader
+// skips the slot while odd and discards its copy if seq moved underneath it.
+struct StatsSlot {
+    volatile uint32_t seq;
+    uint32_t read_seq;
+    volatile uint8_t len;
+    volatile uint8_t version;
+    volatile uint8_t payload[PROTO_MAX_PAYLOAD];
+};
+static StatsSlot stats_slots[ESPNOW_MAX_HOSTS];
+
+// Per-type overflow counters (frames dropped or superseded before being read)
+static volatile uint32_t rx_overflow[256] = {};
+
+static bool is_control_msg(uint8_t type) {
+    return type == MSG_CONFIG_MODE || type == MSG_CONFIG_DONE ||
+           type == MSG_POWER_STATE || type == MSG_NOTIFICATION ||
+           type == MSG_PROFILE_SWITCH || type == MSG_ACTION_RESULT ||
+           type == MSG_BENCH_START;
+}
+
+// Add one FRAME_F_FRAG piece. Fragments come in order from a single
+// sender; a gap or a new message id drops the partial one. Returns true
+// with `f` pointing at the whole message once the last piece is in.
+static bool reassemble(FrameView &f) {
+    uint8_t index = f.frag & FRAG_INDEX_MASK;
+    if (index == 0) {
+        if (frag_next != 0xFF) rx_frag_lost++;
+        frag_seq = f.seq;
+        frag_len = 0;
+        frag_next = 0;
+    }
+    if (index != frag_next || f.seq != frag_seq || frag_len + f.len > sizeof(frag_buf)) {
+        if (frag_next != 0xFF) rx_frag_lost++;
+        frag_next = 0xFF;
+        return false;
+    }
+    memcpy(frag_buf + frag_len, f.payload, f.len);
+    frag_len += f.len;
+    frag_next++;
+    if (!(f.frag & FRAG_LAST)) return false;
+    frag_next = 0xFF;
+    f.payload = frag_buf;
+    f.len = frag_len;
+    f.flags &= ~FRAME_F_FRAG;
+    return true;
+}
 
 // RSSI from last received packet
 static volatile int last_rssi = 0;
 
+// Link adaptation: how loud the active host hears us (its PING ACKs,
+// callback -> heartbeat) and how many of our unicasts to it got lost
+static LinkAdapt adapt;
+static RssiAvg far_rssi = {};
+static volatile int8_t far_report = 0;   // Latest report, 0 = none since the last heartbeat
+#ifdef ESPNOW_PHY_RATE
+static const wifi_phy_rate_t adapt_rates[] = { ESPNOW_PHY_RATE, WIFI_PHY_RATE_1M_L };
+#define ADAPT_RATE_STEPS 2
+#else
+#define ADAPT_RATE_STEPS 1               // Already at the basic rate: power only
+#endif
+
+// ESP-NOW send-complete callback (runs in WiFi task context). For unicast,
+// success means the bridge's radio ACKed the frame; broadcast always succeeds.
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 5, 0)
+static void on_sent(const esp_now_send_info_t *info, esp_now_send_status_t status) {
+#else
+static void on_sent(const uint8_t *mac, esp_now_send_status_t status) {
+#endif
+    tx_done_us = micros();
+    tx_done_ok = (status == ESP_NOW_SEND_SUCCESS);
+    tx_done = true;
+    events_post(EVT_ESPNOW_TX);
+}
+
+// One decoded message (a whole frame, or a MSG_BATCH record): ACKs and
+// stats into their slots, pairing / HELLO / channel state for the loop,
+// the rest into the RX queue. True if the loop should be woken for it.
+static bool rx_message(const uint8_t *mac, uint8_t host, bool from_peer, const FrameView &f) {
+    uint8_t msg_type = f.type;
+    const uint8_t *payload = f.payload;
+    uint8_t plen = f.len > PROTO_MAX_PAYLOAD ? PROTO_MAX_PAYLOAD : f.len;
+
+    // Background hosts: their stats, pairing, HELLO and ACKs for commands
+    // sent before the switch. Their companion's profile switches, config
+    // sessions, notifications... are for when the display is theirs.
+    bool background = host != ESPNOW_HOST_NONE && host != active_host;
+    if (background && msg_type != MSG_STATS && msg_type != MSG_PAIR_ACK &&
+        msg_type != MSG_HELLO && msg_type != MSG_HOTKEY_ACK) {
+        return false;
+    }
+
+    if (msg_type == MSG_PAIR_ACK) {
+        PairMsg pm;
+        if (plen < sizeof(pm)) return false;
+        memcpy(&pm, payload, sizeof(pm));
+        if (pm.magic != PAIR_MAGIC || pair_pending) return false;
+        memcpy(pair_pending_mac, mac, 6);
+        pair_pending_channel = radio_channel;
+        pair_pending = true;
+        return false;  // Committed in espnow_link_update(); the ACK that follows wakes the loop
+    } else if (msg_type == MSG_HELLO) {
+        HelloMsg hello;
+        if (plen < sizeof(hello) || host == ESPNOW_HOST_NONE) return false;
+        memcpy(&hello, payload, sizeof(hello));
+        if (hello.flags & HELLO_F_REPLY) {
+            host_caps[host] = hello.caps;
+            host_v2[host] = hello.version >= PROTO_VERSION;
+            if (from_peer) hello_answered = true;
+        } else if (from_peer) {
+            hello_request = true;
+        }
+        events_post(EVT_ESPNOW_TX);
+        return false;
+    } else if (msg_type == MSG_CHANNEL) {
+        ChannelMsg cm;
+        if (plen < sizeof(cm) || !from_peer) return false;
+        memcpy(&cm, payload, sizeof(cm));
+        if (cm.op != CHANNEL_SWITCH || cm.channel < 1 || cm.channel > ESPNOW_CHANNEL_MAX) return false;
+        switch_pending_channel = cm.channel;
+        switch_pending_delay = cm.delay_ms;
+        switch_pending = true;
+        return false;  // Scheduled in espnow_link_update(); repeats just refresh the deadline
+    } else if (msg_type == MSG_HOTKEY_ACK && plen >= 1) {
+        int next = (ack_head + 1) % ACK_QUEUE_SIZE;
+        if (next == ack_tail) {
+            rx_overflow[MSG_HOTKEY_ACK]++;
+        } else {
+            volatile AckMsg &slot = ack_queue[ack_head];
+            slot.status = payload[0];
+            // v2: SEQ in the header; legacy: after the status (older bridges send status only)
+            slot.seq = (f.flags & FRAME_F_ACK) ? f.seq : (plen >= 2) ? payload[1] : 0;
+            slot.host = host == ESPNOW_HOST_NONE ? active_host : host;
+            slot.rx_us = micros();
+            ack_head = next;
+        }
+        // A PING's v2 ACK: the bridge's RSSI of our frames after the status
+        if ((f.flags & FRAME_F_ACK) && plen >= 1 + sizeof(LinkReportMsg) &&
+            (host == ESPNOW_HOST_NONE ? active_host : host) == active_host) {
+            LinkReportMsg report;
+            memcpy(&report, payload + 1, sizeof(report));
+            far_report = report.rssi_dbm;
+        }
+    } else if (msg_type == MSG_STATS) {
+        // An unpaired sender stands in for the active host, as before
+        StatsSlot &ss = stats_slots[host == ESPNOW_HOST_NONE ? active_host : host];
+        uint32_t seq = ss.seq;
+        if (seq != ss.read_seq) rx_overflow[MSG_STATS]++;  // unread frame superseded
+        ss.seq = seq + 1;
+        memcpy((void *)ss.payload, payload, plen);
+        ss.len = plen;
+        ss.version = f.version;
+        ss.seq = seq + 2;
+    } else {
+        // Queue as generic message for espnow_dispatch()
+        // Supports zero-payload messages (e.g. CONFIG_MODE, CONFIG_DONE)
+        int used = (rx_head - rx_tail + RX_QUEUE_SIZE) % RX_QUEUE_SIZE;
+        int free_slots = RX_QUEUE_SIZE - 1 - used;
+        int needed = is_control_msg(msg_type) ? 1 : 1 + RX_CONTROL_RESERVE;
+        if (free_slots < needed) {
+            rx_overflow[msg_type]++;
+            return false;
+        }
+
+        volatile RxMsg &slot = rx_queue[rx_head];
+        if (plen > 0) {
+            memcpy((void *)slot.payload, payload, plen);
+        }
+        slot.len = plen;
+        slot.type = msg_type;
+        slot.version = f.version;
+        slot.rx_us = micros();
+        rx_head = (rx_head + 1) % RX_QUEUE_SIZE;
+    }
+    return true;
+}
+
 // ESP-NOW receive callback (runs in WiFi task context)
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
 static void on_recv(const esp_now_recv_info_t *info, const uint8_t *data, int len) {
     const uint8_t *mac = info->src_addr;
     if (info->rx_ctrl) last_rssi = info->rx_ctrl->rssi;
+    bool unicast = memcmp(info->des_addr, broadcast_addr, 6) != 0;
 #else
 static void on_recv(const uint8_t *mac, const uint8_t *data, int len) {
+    bool unicast = true;
 #endif
-    if (len < 1) return;  // need at least type byte
+    FrameView f;
+    if (!frame_decode(data, len, f)) {
+        rx_bad++;
+        return;
+    }
 
-    uint8_t msg_type = data[0];
+    uint8_t host = host_lookup(mac);
+    bool from_peer = host != ESPNOW_HOST_NONE && host == active_host;
+    if (host != ESPNOW_HOST_NONE) host_rx_ms[host] = millis();
 
-    if (msg_type == MSG_HOTKEY_ACK && len >= 2) {
-        ack_status_buf = data[1];
-        ack_ready = true;
-    } else {
-        // Queue as generic message for espnow_poll_msg()
-        // Supports zero-payload messages (e.g. CONFIG_MODE, CONFIG_DONE)
-        uint8_t plen = (len > 1) ? (uint8_t)(len - 1) : 0;
-        if (plen > PROTO_MAX_PAYLOAD) plen = PROTO_MAX_PAYLOAD;
-        if (plen > 0) {
-            memcpy(msg_payload_buf, &data[1], plen);
+    // The bridge spoke v2 and now doesn't: rebooted (caps forgotten) or
+    // reflashed. Back to legacy frames until it answers a HELLO again.
+    // Broadcasts don't count, they go legacy while any display is.
+    if (host != ESPNOW_HOST_NONE && unicast && host_v2[host] && f.version < PROTO_VERSION &&
+        f.type != MSG_PAIR_ACK && f.type != MSG_HELLO) {
+        host_v2[host] = false;
+        host_caps[host] = PROTO_CAPS_LEGACY;
+        if (from_peer) hello_request = true;   // A background host is asked when it becomes active
+    }
+
+    if (f.flags & FRAME_F_FRAG) {
+        if (!from_peer || !reassemble(f)) return;
+    }
+
+    if (f.type == MSG_BATCH && f.version >= PROTO_VERSION) {
+        FrameView r;
+        uint8_t pos = 0;
+        bool wake = false;
+        while (batch_next(f.payload, f.len, pos, r)) {
+            r.version = f.version;
+            wake |= rx_message(mac, host, from_peer, r);
         }
-        msg_payload_len_buf = plen;
-        msg_type_buf = msg_type;
-        msg_ready = true;
+        if (wake) events_post(EVT_ESPNOW_RX);
+        return;
     }
+    if (rx_message(mac, host, from_peer, f)) events_post(EVT_ESPNOW_RX);
 }
 
 void espnow_link_init() {
     WiFi.mode(WIFI_STA);
     WiFi.disconnect();
 
-    // Pin to WiFi channel 1 for deterministic coexistence with SoftAP
-    esp_wifi_set_channel(1, WIFI_SECOND_CHAN_NONE);
+    Preferences prefs;
+#if ESPNOW_AUTO_CHANNEL
+    if (prefs.begin("espnow", true)) {
+        uint8_t ch = prefs.getUChar("chan", ESPNOW_CHANNEL);
+        if (ch >= 1 && ch <= ESPNOW_CHANNEL_MAX) channel = ch;
+        prefs.end();
+    }
+#endif
+    // One fixed channel for ESP-NOW and the SoftAP (config_server.cpp)
+    radio_channel = channel;
+    esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
 
     if (esp_now_init() != ESP_OK) {
         Serial.println("ESP-NOW init failed!");
         return;
     }
 
-    // Register broadcast peer
-    esp_now_peer_info_t peer = {};
-    memcpy(peer.peer_addr, broadcast_addr, 6);
-    peer.channel = 1;
-    peer.encrypt = false;
-    esp_now_add_peer(&peer);
+#ifdef ESPNOW_PHY_RATE
+    // Only applies to unicast; broadcasts stay at the basic rate
+    esp_wifi_config_espnow_rate(WIFI_IF_STA, ESPNOW_PHY_RATE);
+#endif
+    link_adapt_init(adapt, ADAPT_RATE_STEPS);
+#if ESPNOW_ADAPT
+    esp_wifi_set_max_tx_power(adapt.power_qdbm);
+#else
+    esp_wifi_get_max_tx_power(&adapt.power_qdbm);   // Reported as it is
+#endif
+
+    // Broadcast peer for pairing, plus the stored bridges if we have any
+    add_peer(broadcast_addr);
+    for (auto &caps : host_caps) caps = PROTO_CAPS_LEGACY;
+
+    if (prefs.begin("espnow", true)) {
+        size_t n = prefs.getBytes("hosts", host_mac, sizeof(host_mac)) / 6;
+        if (n == 0 && prefs.getBytes("peer", host_mac[0], 6) == 6) n = 1;   // Single-bridge NVS
+        host_count = (uint8_t)n;
+        uint8_t active = prefs.getUChar("host", 0);
+        active_host = active < host_count ? active : 0;
+        prefs.end();
+    }
+    paired = host_count > 0;
+    for (uint8_t i = 0; i < host_count; i++) {
+        add_peer(host_mac[i]);
+        const uint8_t *m = host_mac[i];
+        Serial.printf("ESP-NOW: paired bridge %u%s %02X:%02X:%02X:%02X:%02X:%02X\n", i,
+                      i == active_host ? " (active)" : "", m[0], m[1], m[2], m[3], m[4], m[5]);
+    }
 
     esp_now_register_recv_cb(on_recv);
+    esp_now_register_send_cb(on_sent);
+
+    // Random starting SEQ so a reboot isn't mistaken for retries by the bridge
+    next_seq = (uint8_t)esp_random();
+    if (paired) hello_request = true;   // Find out what the stored bridge speaks
 
     // Print our MAC for reference
-    Serial.printf("ESP-NOW ready (MAC: %s)\n", WiFi.macAddress().c_str());
+    Serial.printf("ESP-NOW ready (MAC: %s, channel %u)\n", WiFi.macAddress().c_str(), channel);
 }
 
+static void tx_complete() {
+    bool ok = tx_done_ok;
+    uint32_t latency = tx_done_us - tx_busy_queued_us;
+    tx_done = false;
+    tx_busy = false;
+
+    if (tx_busy_unicast) {
+        if (ok) quality_ok++;
+        else quality_fail++;
+        link_adapt_count(adapt, ok, !ok);
+    }
+    if (!ok) {
+        link_stats.tx_fail++;
+        return;
+    }
+    link_stats.tx_ok++;
+    link_stats.tx_last_us = latency;
+    if (latency > link_stats.tx_max_us) link_stats.tx_max_us = latency;
+    if (link_stats.tx_avg_us == 0) {
+        link_stats.tx_avg_us = latency;
+    } else {
+        link_stats.tx_avg_us += ((int32_t)latency - (int32_t)link_stats.tx_avg_us) >> TX_AVG_SHIFT;
+    }
+}
+
+// Hand the next queued frame to the driver if it is idle
+static void tx_pump() {
+    if (tx_done) tx_complete();
+    if (tx_busy) {
+        if (millis() - tx_busy_ms < TX_DONE_TIMEOUT_MS) return;
+        tx_busy = false;
+        link_stats.tx_fail++;
+    }
+    if (tx_backoff && millis() - tx_backoff_ms < TX_NO_MEM_RETRY_MS) return;
+    tx_backoff = false;
+
+    while (tx_q_tail != tx_q_head) {
+        TxFrame &f = tx_queue[tx_q_tail];
+        uint8_t frame[ESPNOW_MAX_FRAME];
+        bool v2 = paired && host_v2[f.host] && !f.broadcast && !f.legacy;
+        uint8_t n = frame_encode(frame, v2, f.type, f.payload, f.len, f.seq);
+        if (n == 0) {
+            link_stats.tx_fail++;   // Payload too long for a frame
+            tx_q_tail = (tx_q_tail + 1) % TX_QUEUE_SIZE;
+            continue;
+        }
+        // Mark busy first: the callback can fire before esp_now_send returns
+        tx_busy = true;
+        tx_busy_ms = millis();
+        tx_busy_queued_us = f.queued_us;
+        // Channel quality is the active host's: only its frames count
+        tx_busy_unicast = paired && !f.broadcast && f.host == active_host;
+        const uint8_t *dest = f.broadcast || !paired ? broadcast_addr : host_mac[f.host];
+        esp_err_t err = esp_now_send(dest, frame, n);
+        if (err == ESP_OK) {
+            tx_q_tail = (tx_q_tail + 1) % TX_QUEUE_SIZE;
+            return;
+        }
+        tx_busy = false;
+        if (err == ESP_ERR_ESPNOW_NO_MEM) {
+            link_stats.tx_no_mem++;
+            tx_backoff = true;
+            tx_backoff_ms = millis();
+            return;
+        }
+        // Rejected outright (bad peer/length): drop it and move on
+        link_stats.tx_fail++;
+        tx_q_tail = (tx_q_tail + 1) % TX_QUEUE_SIZE;
+    }
+}
+
+static bool tx_enqueue(bool broadcast, bool legacy, uint8_t host, uint8_t type, uint8_t seq,
+                       const uint8_t *payload, uint8_t len) {
+    int next = (tx_q_head + 1) % TX_QUEUE_SIZE;
+    if (next == tx_q_tail || len > PROTO_MAX_PAYLOAD) {
+        link_stats.tx_dropped++;
+        return false;
+    }
+    TxFrame &f = tx_queue[tx_q_head];
+    f.broadcast = broadcast;
+    f.legacy = legacy;
+    f.host = host < host_count ? host : active_host;
+    f.type = type;
+    f.seq = seq;
+    f.len = len;
+    f.queued_us = micros();
+    if (len > 0 && payload) memcpy(f.payload, payload, len);
+    tx_q_head = next;
+    tx_pump();
+    return true;
+}
+
+static bool radio_send(MsgType type, const uint8_t *payload, uint8_t len) {
+    return tx_enqueue(false, false, active_host, type, 0, payload, len);
+}
+
+static bool radio_send_reliable(MsgType type, const uint8_t *payload, uint8_t len);
+
+// The cable while the companion is on it (wired_link.h), else the radio.
+// A frame the UART can't take goes by radio rather than not at all.
 bool espnow_send(MsgType type, const uint8_t *payload, uint8_t len) {
-    // Frame: [TYPE] [PAYLOAD...]
-    uint8_t buf[1 + PROTO_MAX_PAYLOAD];
-    buf[0] = (uint8_t)type;
+    if (wired_link_up() && wired_link_send(type, payload, len)) return true;
+    return radio_send(type, payload, len);
+}
+
+static int16_t add_sat16(int16_t a, int16_t b) {
+    int32_t v = (int32_t)a + b;
+    return (int16_t)(v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : v);
+}
+
+static int8_t add_sat8(int8_t a, int8_t b) {
+    int v = a + b;
+    return (int8_t)(v > INT8_MAX ? INT8_MAX : v < INT8_MIN ? INT8_MIN : v);
+}
+
+// Radio only: pointer reports are the bridge's USB mouse, the companion
+// has nothing to play them with
+bool espnow_send_pointer(const PointerMsg &msg, bool reliable) {
+    if (reliable) return radio_send_reliable(MSG_POINTER, (const uint8_t *)&msg, sizeof(msg));
+
+    // Newest queued frame still waiting for the driver: fold the motion into it
+    if (tx_q_head != tx_q_tail) {
+        TxFrame &f = tx_queue[(tx_q_head + TX_QUEUE_SIZE - 1) % TX_QUEUE_SIZE];
+        PointerMsg prev;
+        if (f.type == MSG_POINTER && f.seq == 0 && f.len == sizeof(prev) && f.host == active_host) {
+            memcpy(&prev, f.payload, sizeof(prev));
+            if (prev.flags == msg.flags && prev.buttons == msg.buttons && prev.button_seq == msg.button_seq) {
+                if (msg.flags & POINTER_ABSOLUTE) {
+                    prev.x = msg.x;
+                    prev.y = msg.y;
+                } else {
+                    prev.x = add_sat16(prev.x, msg.x);
+                    prev.y = add_sat16(prev.y, msg.y);
+                    prev.wheel = add_sat8(prev.wheel, msg.wheel);
+                    prev.pan = add_sat8(prev.pan, msg.pan);
+                }
+                memcpy(f.payload, &prev, sizeof(prev));
+                pointer_merged++;
+                return true;
+            }
+        }
+    }
+    return radio_send(MSG_POINTER, (const uint8_t *)&msg, sizeof(msg));
+}
+
+uint32_t espnow_pointer_merged() {
+    return pointer_merged;
+}
+
+// ============================================================
+// Radio channel: switch orders, hunting, link-quality survey requests
+// ============================================================
+
+static bool softap_active() {
+    return (WiFi.getMode() & WIFI_MODE_AP) != 0;
+}
+
+static void tune(uint8_t ch) {
+    radio_channel = ch;
+    esp_wifi_set_channel(ch, WIFI_SECOND_CHAN_NONE);
+}
+
+static void save_channel(uint8_t ch) {
+    if (ch == channel) return;
+    Serial.printf("ESP-NOW: channel %u -> %u\n", channel, ch);
+    channel = ch;
+    Preferences prefs;
+    if (prefs.begin("espnow", false)) {
+        prefs.putUChar("chan", channel);
+        prefs.end();
+    }
+}
+
+uint8_t espnow_channel() {
+    return channel;
+}
+
+static void send_pair_req() {
+    PairMsg pm = { PAIR_MAGIC };
+    tx_enqueue(true, true, active_host, MSG_PAIR_REQ, 0, (const uint8_t *)&pm, sizeof(pm));
+}
+
+static void stop_hunt(bool found) {
+    if (!hunting) return;
+    hunting = false;
+    if (!found) tune(channel);   // Nobody answered: back to the last known channel
+}
+
+// One hunt step: next channel, broadcast PAIR_REQ there. Returns ms to the next step.
+static uint32_t hunt_update() {
+    if (!hunting) return UINT32_MAX;
+    if (softap_active()) {
+        stop_hunt(false);
+        return UINT32_MAX;
+    }
+    uint32_t elapsed = millis() - hunt_step_ms;
+    if (elapsed < HUNT_DWELL_MS) return HUNT_DWELL_MS - elapsed;
+    if (hunt_next > ESPNOW_CHANNEL_MAX) {
+        stop_hunt(false);
+        return UINT32_MAX;
+    }
+    if (hunt_next == channel) hunt_next++;   // Already tried by the heartbeat
+    if (hunt_next > ESPNOW_CHANNEL_MAX) {
+        stop_hunt(false);
+        return UINT32_MAX;
+    }
+    tune(hunt_next++);
+    send_pair_req();
+    hunt_step_ms = millis();
+    return HUNT_DWELL_MS;
+}
+
+static uint32_t channel_switch_update() {
+    if (switch_pending) {
+        switch_pending = false;
+        switch_channel = switch_pending_channel;
+        switch_at_ms = millis() + switch_pending_delay;
+        switch_scheduled = true;
+    }
+    if (!switch_scheduled) return UINT32_MAX;
+    int32_t remaining = (int32_t)(switch_at_ms - millis());
+    if (remaining > 0) return (uint32_t)remaining;
+    switch_scheduled = false;
+    // The SoftAP's clients stay where they are; if the bridge moved anyway
+    // the link comes back by hunting once the config session ends
+    if (softap_active() || switch_channel == channel) return UINT32_MAX;
+    stop_hunt(true);
+    tune(switch_channel);
+    save_channel(switch_channel);
+    return UINT32_MAX;
+}
+
+// Unicast delivery over the last window: a poor channel asks the bridge to look around
+static void check_link_quality(uint32_t now) {
+    if (quality_window_ms == 0) quality_window_ms = now;
+    if (now - quality_window_ms < QUALITY_WINDOW_MS) return;
+    uint32_t total = quality_ok + quality_fail;
+    uint8_t fail_pct = total ? (uint8_t)(quality_fail * 100 / total) : 0;
+    quality_ok = quality_fail = 0;
+    quality_window_ms = now;
+    if (!ESPNOW_AUTO_CHANNEL || total < QUALITY_MIN_FRAMES || fail_pct < QUALITY_FAIL_PCT) return;
+    if (survey_requested_ms != 0 && now - survey_requested_ms < CHANNEL_RESURVEY_MS) return;
+    survey_requested_ms = now;
+
+    ChannelMsg req = {};
+    req.op = CHANNEL_SURVEY_REQ;
+    req.channel = channel;
+    req.fail_pct = fail_pct;
+    req.rssi_dbm = (int8_t)last_rssi;
+    radio_send_reliable(MSG_CHANNEL, (const uint8_t *)&req, sizeof(req));
+    LOG_W("ESP-NOW: %u%% of %lu frames failed on channel %u, survey requested\n",
+          fail_pct, (unsigned long)total, channel);
+}
+
+static void adapt_apply() {
+    esp_wifi_set_max_tx_power(adapt.power_qdbm);
+#ifdef ESPNOW_PHY_RATE
+    esp_wifi_config_espnow_rate(WIFI_IF_STA, adapt_rates[adapt.rate]);
+#endif
+    rssi_avg_shift(far_rssi, adapt.last_delta);
+    LinkAdaptChange c;
+    if (link_adapt_history(adapt, &c, 1) == 1) {
+        Serial.printf("ESP-NOW adapt (%s): %.2f dBm, rate step %u (bridge hears %d dBm, %u%% lost)\n",
+                      link_adapt_reason_name(c.reason), c.power_qdbm / 4.0f, c.rate, c.rssi_dbm,
+                      c.loss_pct);
+    }
+}
+
+// Once per heartbeat while linked to the active host
+static void adapt_update(uint32_t now) {
+#if ESPNOW_ADAPT
+    int8_t report = far_report;
+    far_report = 0;
+    rssi_avg_add(far_rssi, report);
+    if (softap_active() ? link_adapt_reset(adapt, now) : link_adapt_step(adapt, far_rssi, now)) adapt_apply();
+#else
+    (void)now;
+#endif
+}
+
+// Bridge lost or another host: start over from full power
+static void adapt_reset() {
+    far_rssi = {};
+    far_report = 0;
+#if ESPNOW_ADAPT
+    if (link_adapt_reset(adapt, millis())) adapt_apply();
+#endif
+}
+
+void espnow_send_heartbeat(uint32_t period_ms) {
+    uint32_t now = millis();
+    heartbeat_ms = period_ms;
+    // Background hosts: a ping keeps this display in their bridge's fan-out
+    for (uint8_t i = 0; i < host_count; i++) {
+        if (i != active_host) tx_enqueue(false, false, i, MSG_PING, 0, nullptr, 0);
+    }
+    if (pair_window_ms && now - pair_window_ms >= ESPNOW_PAIR_WINDOW_MS) pair_window_ms = 0;
+    if (pair_window_ms) send_pair_req();   // Adding a host: ask whoever is around
+    if (paired && now - host_rx_ms[active_host] < PAIR_LOST_PERIODS * period_ms) {
+        LinkReportMsg report = { (int8_t)last_rssi, adapt.power_qdbm };
+        radio_send(MSG_PING, (const uint8_t *)&report, sizeof(report));
+        check_link_quality(now);
+        adapt_update(now);
+        return;
+    }
+    adapt_reset();
+    // Unpaired, or the stored bridge went quiet (replaced / reflashed /
+    // moved channel): ask around here, then now and then on every channel
+    if (hunting) return;
+    send_pair_req();
+#if ESPNOW_AUTO_CHANNEL
+    if (!softap_active() && (hunt_started_ms == 0 || now - hunt_started_ms >= HUNT_INTERVAL_MS)) {
+        hunting = true;
+        hunt_next = 1;
+        hunt_started_ms = now;
+        hunt_step_ms = now;   // First step after one dwell on the current channel
+        events_post(EVT_ESPNOW_TX);
+    }
+#endif
+}
+
+static void save_hosts() {
+    Preferences prefs;
+    if (prefs.begin("espnow", false)) {
+        prefs.putBytes("hosts", host_mac, host_count * 6);
+        prefs.putUChar("host", active_host);
+        prefs.putBytes("peer", host_mac[active_host], 6);
+        prefs.end();
+    }
+}
+
+// Slot for a bridge we don't know yet: the next free one while adding a
+// host (or the one heard from least recently when full), else the active
+// host's, which it replaces
+static uint8_t claim_host_slot() {
+    if (!paired) return 0;
+    if (!pair_window_ms) return active_host;
+    if (host_count < ESPNOW_MAX_HOSTS) return host_count;
+    uint8_t oldest = active_host == 0 ? 1 : 0;
+    for (uint8_t i = 0; i < host_count; i++) {
+        if (i != active_host && (int32_t)(host_rx_ms[i] - host_rx_ms[oldest]) < 0) oldest = i;
+    }
+    return oldest;
+}
+
+static void commit_pairing() {
+    uint8_t mac[6];
+    memcpy(mac, pair_pending_mac, 6);
+    uint8_t ch = pair_pending_channel;
+    pair_pending = false;
+
+    uint8_t host = host_lookup(mac);
+    if (host == ESPNOW_HOST_NONE) {
+        // Outside the pairing window a stranger only takes over from a host that went quiet
+        if (paired && !pair_window_ms &&
+            millis() - host_rx_ms[active_host] < PAIR_LOST_PERIODS * heartbeat_ms) {
+            return;
+        }
+        host = claim_host_slot();
+        if (host < host_count) esp_now_del_peer(host_mac[host]);
+        memcpy(host_mac[host], mac, 6);
+        add_peer(mac);
+        host_v2[host] = false;
+        host_caps[host] = PROTO_CAPS_LEGACY;
+        if (host == host_count) host_count++;
+        paired = true;
+        if (pair_window_ms && host != active_host) pair_window_ms = 0;   // One new host per window
+        save_hosts();
+        Serial.printf("ESP-NOW: paired with bridge %u %02X:%02X:%02X:%02X:%02X:%02X\n", host,
+                      mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    }
+    host_rx_ms[host] = millis();
+    if (host != active_host) return;   // Its pings resume with the next heartbeat
+
+    if (hunting || ch != channel) {
+        // The bridge answered here: this is the channel now
+        hunting = false;
+        if (radio_channel != ch) tune(ch);
+        save_channel(ch);
+    }
+    hello_request = true;   // Link (re)established: the bridge may have changed firmware
+}
+
+bool espnow_is_paired() {
+    return paired;
+}
+
+uint8_t espnow_host_count() {
+    return host_count;
+}
+
+uint8_t espnow_active_host() {
+    return active_host;
+}
+
+bool espnow_select_host(uint8_t host) {
+    if (host >= host_count) return false;
+    if (host == active_host) return true;
+    active_host = host;
+    hello_request = true;            // Caps may have changed while it was in the background
+    quality_ok = quality_fail = 0;   // Measured against the other bridge
+    quality_window_ms = 0;
+    adapt_reset();
+    save_hosts();
+    const uint8_t *m = host_mac[host];
+    Serial.printf("ESP-NOW: active host %u %02X:%02X:%02X:%02X:%02X:%02X\n", host,
+                  m[0], m[1], m[2], m[3], m[4], m[5]);
+    return true;
+}
+
+bool espnow_host_linked(uint8_t host) {
+    return host < host_count && host_rx_ms[host] &&
+           millis() - host_rx_ms[host] < PAIR_LOST_PERIODS * heartbeat_ms;
+}
+
+void espnow_pair_new_host() {
+    pair_window_ms = millis() | 1;
+    send_pair_req();
+    Serial.printf("ESP-NOW: pairing a new host for %u s\n", ESPNOW_PAIR_WINDOW_MS / 1000);
+}
+
+bool espnow_pairing_host() {
+    return pair_window_ms != 0;
+}
+
+static bool radio_send_reliable(MsgType type, const uint8_t *payload, uint8_t len) {
+    if (len > PROTO_MAX_PAYLOAD - 1) return false;  // SEQ takes one payload byte
+
+    TxSlot *slot = nullptr;
+    for (int i = 0; i < TX_WINDOW; i++) {
+        if (!tx_window[i].used) { slot = &tx_window[i]; break; }
+    }
+    if (!slot) {
+        // Window full: still deliver best-effort rather than drop the command
+        link_stats.window_full++;
+        return radio_send(type, payload, len);
+    }
+
+    if (++next_seq == 0) next_seq = 1;  // SEQ 0 is reserved for unsequenced ACKs
+    slot->seq = next_seq;
+    slot->retries = 0;
+    slot->host = active_host;
+    slot->type = (uint8_t)type;
     if (len > 0 && payload) {
-        memcpy(&buf[1], payload, len);
+        memcpy(slot->payload, payload, len);
     }
+    slot->len = len;
+    slot->first_us = micros();
+    slot->sent_ms = millis();
+    slot->used = true;
+    link_stats.sent++;
+
+    return tx_enqueue(false, false, slot->host, slot->type, slot->seq, slot->payload, slot->len);
+}
+
+bool espnow_ping_probe() {
+    if (!paired || probe_seq) return false;
+    uint32_t window_full = link_stats.window_full;
+    if (!radio_send_reliable(MSG_PING, nullptr, 0) || link_stats.window_full != window_full) return false;
+    probe_seq = next_seq;
+    probe_rtt_us = 0;
+    return true;
+}
+
+uint32_t espnow_ping_result() {
+    return probe_rtt_us;
+}
 
-    esp_err_t result = esp_now_send(broadcast_addr, buf, 1 + len);
-    return result == ESP_OK;
+// Over the cable a command goes once: no SEQ, no window, no ACK to wait for
+bool espnow_send_reliable(MsgType type, const uint8_t *payload, uint8_t len) {
+    if (wired_link_up() && wired_link_send(type, payload, len)) return true;
+    return radio_send_reliable(type, payload, len);
+}
+
+// ============================================================
+// Protocol handshake (MSG_HELLO)
+// ============================================================
+
+static void send_hello() {
+    HelloMsg hello = { PROTO_VERSION, DISPLAY_CAPS, 0 };
+    tx_enqueue(false, true, active_host, MSG_HELLO, 0, (const uint8_t *)&hello, sizeof(hello));
+}
+
+// HELLO_TRIES per link-up, then whatever the bridge answered (or legacy).
+// Returns ms until the next try.
+static uint32_t hello_update() {
+    uint32_t now = millis();
+    if (hello_request) {
+        hello_request = false;
+        hello_left = HELLO_TRIES;
+        hello_due_ms = now;
+    }
+    if (hello_answered) {
+        hello_answered = false;
+        hello_left = 0;
+        Serial.printf("ESP-NOW: bridge speaks v%u, caps 0x%04X\n",
+                      espnow_peer_version(), (unsigned)espnow_peer_caps());
+    }
+    if (hello_left == 0 || !paired || hunting) return UINT32_MAX;
+    int32_t wait = (int32_t)(hello_due_ms - now);
+    if (wait > 0) return (uint32_t)wait;
+    send_hello();
+    if (--hello_left == 0) return UINT32_MAX;   // Last try: no answer means a legacy bridge
+    hello_due_ms = now + HELLO_RETRY_MS;
+    return HELLO_RETRY_MS;
+}
+
+uint8_t espnow_peer_version() {
+    return host_v2[active_host] ? PROTO_VERSION : 1;
+}
+
+uint16_t espnow_peer_caps() {
+    return host_caps[active_host];
+}
+
+static void complete_slot(uint8_t seq, uint8_t host, uint32_t rx_us) {
+    for (int i = 0; i < TX_WINDOW; i++) {
+        TxSlot &slot = tx_window[i];
+        if (!slot.used || slot.seq != seq || slot.host != host) continue;
+        slot.used = false;
+        uint32_t rtt = rx_us - slot.first_us;
+        link_stats.acked++;
+        link_stats.rtt_last_us = rtt;
+        if (rtt > link_stats.rtt_max_us) link_stats.rtt_max_us = rtt;
+        if (seq == probe_seq) {
+            probe_seq = 0;
+            probe_rtt_us = rtt ? rtt : 1;
+        }
+        if (link_stats.rtt_avg_us == 0) {
+            link_stats.rtt_avg_us = rtt;
+        } else {
+            link_stats.rtt_avg_us += ((int32_t)rtt - (int32_t)link_stats.rtt_avg_us) >> RTT_AVG_SHIFT;
+        }
+        return;
+    }
+    link_stats.late_acks++;  // Already acked (duplicate) or given up on
+}
+
+uint32_t espnow_link_update() {
+    if (pair_pending) commit_pairing();
+    uint32_t channel_ms = channel_switch_update();
+    uint32_t hunt_ms = hunt_update();
+    uint32_t hello_ms = hello_update();
+
+    while (ack_tail != ack_head) {
+        volatile AckMsg &ack = ack_queue[ack_tail];
+        uint8_t status = ack.status;
+        uint8_t seq = ack.seq;
+        uint8_t host = ack.host;
+        uint32_t rx_us = ack.rx_us;
+        ack_tail = (ack_tail + 1) % ACK_QUEUE_SIZE;
+
+        if (seq != 0) complete_slot(seq, host, rx_us);
+        ack_status_buf = status;
+        ack_ready = true;
+    }
+
+    uint32_t now = millis();
+    uint32_t next_ms = UINT32_MAX;
+    link_stats.in_flight = 0;
+    for (int i = 0; i < TX_WINDOW; i++) {
+        TxSlot &slot = tx_window[i];
+        if (!slot.used) continue;
+
+        uint32_t elapsed = now - slot.sent_ms;
+        if (elapsed >= TX_RETRY_MS) {
+            if (slot.retries >= TX_MAX_RETRIES) {
+                slot.used = false;
+                link_stats.lost++;
+                if (slot.seq == probe_seq) {
+                    probe_seq = 0;
+                    probe_rtt_us = UINT32_MAX;
+                }
+                trace(TR_TX_LOST, slot.seq, slot.type);
+                LOG_W("ESPNOW TX: seq=%u type=0x%02X lost after %d retries\n",
+                      slot.seq, slot.type, TX_MAX_RETRIES);
+                continue;
+            }
+            slot.retries++;
+            slot.sent_ms = now;
+            link_stats.retries++;
+            if (slot.host == active_host) link_adapt_count(adapt, 0, 1);   // No SEQ ACK in time
+            tx_enqueue(false, false, slot.host, slot.type, slot.seq, slot.payload, slot.len);
+            elapsed = 0;
+        }
+        link_stats.in_flight++;
+        uint32_t remaining = TX_RETRY_MS - elapsed;
+        if (remaining < next_ms) next_ms = remaining;
+    }
+
+    // Completion / next frame; wake again for a NO_MEM retry or a lost callback
+    tx_pump();
+    link_stats.tx_queued = (uint8_t)((tx_q_head - tx_q_tail + TX_QUEUE_SIZE) % TX_QUEUE_SIZE);
+    if (tx_busy) {
+        uint32_t elapsed = millis() - tx_busy_ms;
+        uint32_t remaining = elapsed < TX_DONE_TIMEOUT_MS ? TX_DONE_TIMEOUT_MS - elapsed : 0;
+        if (remaining < next_ms) next_ms = remaining;
+    } else if (link_stats.tx_queued > 0 && next_ms > TX_NO_MEM_RETRY_MS) {
+        next_ms = TX_NO_MEM_RETRY_MS;
+    }
+    if (channel_ms < next_ms) next_ms = channel_ms;
+    if (hunt_ms < next_ms) next_ms = hunt_ms;
+    if (hello_ms < next_ms) next_ms = hello_ms;
+    return next_ms;
+}
+
+void espnow_get_link_stats(LinkStats &out) {
+    out = link_stats;
+    out.rx_bad = rx_bad;
+    out.rx_frag_lost = rx_frag_lost;
+    out.tx_power_qdbm = adapt.power_qdbm;
+    out.phy_rate_step = adapt.rate;
+    out.far_rssi = rssi_avg_dbm(far_rssi);
+    out.adapt_changes = adapt.changes;
+}
+
+int espnow_adapt_history(LinkAdaptChange *out, int max) {
+    return link_adapt_history(adapt, out, max);
+}
+
+void espnow_reset_link_stats() {
+    uint8_t in_flight = link_stats.in_flight;
+    uint8_t tx_queued = link_stats.tx_queued;
+    rx_bad = rx_frag_lost = 0;
+    link_stats = {};
+    link_stats.in_flight = in_flight;
+    link_stats.tx_queued = tx_queued;
 }
 
 void send_hotkey_to_bridge(uint8_t modifiers, uint8_t keycode) {
     HotkeyMsg msg;
     msg.modifiers = modifiers;
     msg.keycode = keycode;
-    espnow_send(MSG_HOTKEY, (uint8_t *)&msg, sizeof(msg));
-    Serial.printf("ESPNOW TX: hotkey mod=0x%02X key=0x%02X\n", modifiers, keycode);
+    espnow_send_reliable(MSG_HOTKEY, (uint8_t *)&msg, sizeof(msg));
+    trace(TR_HOTKEY_TX, modifiers << 8 | keycode);
+    LOG_D("ESPNOW TX: hotkey mod=0x%02X key=0x%02X\n", modifiers, keycode);
 }
 
 void send_media_key_to_bridge(uint16_t consumer_code) {
     MediaKeyMsg msg;
     msg.consumer_code = consumer_code;
-    espnow_send(MSG_MEDIA_KEY, (uint8_t *)&msg, sizeof(msg));
-    Serial.printf("ESPNOW TX: media key 0x%04X\n", consumer_code);
+    espnow_send_reliable(MSG_MEDIA_KEY, (uint8_t *)&msg, sizeof(msg));
+    trace(TR_MEDIA_TX, consumer_code);
+    LOG_D("ESPNOW TX: media key 0x%04X\n", consumer_code);
 }
 
-void send_button_press_to_bridge(uint8_t page_index, uint8_t widget_index) {
+void send_button_press_to_bridge(uint8_t page_index, uint8_t widget_index, int profile_index,
+                                 uint16_t entry_index) {
+    static uint16_t next_press_id = 0;
     ButtonPressMsg msg;
     msg.page_index = page_index;
     msg.widget_index = widget_index;
-    espnow_send(MSG_BUTTON_PRESS, (uint8_t *)&msg, sizeof(msg));
-    Serial.printf("ESPNOW TX: button press page=%d widget=%d\n", page_index, widget_index);
+    msg.press_id = ++next_press_id;
+    msg.display_ms = millis();
+    msg.profile_index = profile_index >= 0 && profile_index < 0xFF ? (uint8_t)profile_index : 0xFF;
+    msg.entry_index = entry_index;
+    espnow_send_reliable(MSG_BUTTON_PRESS, (uint8_t *)&msg, sizeof(msg));
+    trace(TR_PRESS_TX, msg.press_id, page_index << 8 | widget_index);
+    LOG_D("ESPNOW TX: button press #%u page=%d widget=%d profile=%d\n",
+          msg.press_id, page_index, widget_index, profile_index);
+}
+
+void send_macro_to_bridge(const MacroStep *steps, uint8_t count) {
+    if (count > MACRO_MAX_STEPS) count = MACRO_MAX_STEPS;
+    if (!wired_link_up() && !(espnow_peer_caps() & PROTO_CAP_MACRO)) {  // The companion plays them
+        // Bridge can't play macros: one command per tap; holds and delays are lost
+        for (uint8_t i = 0; i < count; i++) {
+            if (steps[i].op == MACRO_OP_TAP) send_hotkey_to_bridge(steps[i].a, steps[i].b);
+            else if (steps[i].op == MACRO_OP_MEDIA) send_media_key_to_bridge(steps[i].a | steps[i].b << 8);
+        }
+        LOG_W("ESPNOW TX: bridge has no macro support, %d steps sent as single keys\n", count);
+        return;
+    }
+    uint8_t buf[1 + MACRO_MAX_STEPS * sizeof(MacroStep)];
+    buf[0] = count;
+    memcpy(&buf[1], steps, count * sizeof(MacroStep));
+    espnow_send_reliable(MSG_MACRO, buf, 1 + count * sizeof(MacroStep));
+    trace(TR_MACRO_TX, count);
+    LOG_D("ESPNOW TX: macro %d steps\n", count);
+}
+
+void send_text_to_bridge(const char *utf8, size_t len, uint8_t layout) {
+    len = utf8_clip(utf8, len, TYPE_TEXT_MAX_BYTES);
+    if (!wired_link_up() && !(espnow_peer_caps() & PROTO_CAP_TYPE_TEXT)) {  // The companion types it
+        MacroStep steps[MACRO_MAX_STEPS];
+        size_t typed = 0;
+        uint8_t count = key_layout_macro(layout, utf8, len, steps, MACRO_MAX_STEPS, &typed);
+        if (typed < len) LOG_W("ESPNOW TX: bridge can't type text, %u of %u bytes sent as a macro\n",
+                               (unsigned)typed, (unsigned)len);
+        if (count) send_macro_to_bridge(steps, count);
+        return;
+    }
+    uint8_t buf[1 + TYPE_TEXT_MAX_BYTES];
+    buf[0] = layout;
+    memcpy(&buf[1], utf8, len);
+    espnow_send_reliable(MSG_TYPE_TEXT, buf, 1 + len);
+    LOG_D("ESPNOW TX: text %u bytes (%s)\n", (unsigned)len, key_layout_name(layout));
+}
+
+void send_ddc_to_bridge(const DdcCmdMsg &cmd) {
+    espnow_send_reliable(MSG_DDC_CMD, (const uint8_t *)&cmd, sizeof(cmd));
+    trace(TR_DDC_TX, cmd.vcp_code, cmd.value);
+}
+
+void send_wake_to_bridge() {
+    // By radio even while wired: the companion at the other end is asleep too
+    WakeHostMsg req = {};
+    req.op = WAKE_REQ;
+    radio_send_reliable(MSG_WAKE_HOST, (const uint8_t *)&req, sizeof(req));
 }
 
 bool espnow_poll_ack(uint8_t &status) {
@@ -129,17 +1255,80 @@ bool espnow_poll_ack(uint8_t &status) {
     return false;
 }
 
-bool espnow_poll_msg(uint8_t &type, uint8_t *payload, uint8_t &payload_len) {
-    if (msg_ready) {
-        msg_ready = false;
-        type = msg_type_buf;
-        payload_len = msg_payload_len_buf;
-        if (payload_len > 0) {
-            memcpy(payload, msg_payload_buf, payload_len);
-        }
-        return true;
+// ============================================================
+// Receive dispatch
+// ============================================================
+static EspnowHandler rx_handlers[MSG_FLAG_SEQ] = {};   // Indexed by type (frame_decode strips the SEQ flag)
+static EspnowRxFilter rx_filter = nullptr;
+
+void espnow_register_handler(MsgType type, EspnowHandler fn) {
+    if (type < MSG_FLAG_SEQ) rx_handlers[type] = fn;
+}
+
+void espnow_set_rx_filter(EspnowRxFilter fn) {
+    rx_filter = fn;
+}
+
+static void dispatch_one(const EspnowMsg &msg) {
+    if (rx_filter && !rx_filter(msg)) return;
+    EspnowHandler fn = msg.type < MSG_FLAG_SEQ ? rx_handlers[msg.type] : nullptr;
+    if (fn) fn(msg);
+}
+
+void espnow_deliver_wired(uint8_t type, const uint8_t *payload, uint8_t len, uint32_t rx_us) {
+    if (type == MSG_HELLO) {
+        // The companion's keepalive: answer with what this display speaks
+        if (len >= sizeof(HelloMsg) && (payload[sizeof(HelloMsg) - 1] & HELLO_F_REPLY)) return;
+        HelloMsg hello = { PROTO_VERSION, DISPLAY_CAPS, HELLO_F_REPLY };
+        wired_link_send(MSG_HELLO, (const uint8_t *)&hello, sizeof(hello));
+        return;
     }
-    return false;
+    EspnowMsg msg = { type, payload, len, PROTO_VERSION, rx_us, active_host };
+    dispatch_one(msg);
+}
+
+int espnow_dispatch() {
+    int count = 0;
+
+    // Queued messages first (control traffic). The handler reads the slot in
+    // place; rx_tail only moves past it once the handler has returned, so
+    // on_recv can't reuse it underneath.
+    while (rx_tail != rx_head) {
+        volatile RxMsg &slot = rx_queue[rx_tail];
+        EspnowMsg msg = { slot.type, (const uint8_t *)slot.payload, slot.len, slot.version, slot.rx_us,
+                          active_host };
+        dispatch_one(msg);
+        rx_tail = (rx_tail + 1) % RX_QUEUE_SIZE;
+        count++;
+    }
+
+    // Latest STATS frame of each host. The seqlock slot may be rewritten at
+    // any time, so it is copied out and checked before a handler sees it.
+    static uint8_t stats_copy[PROTO_MAX_PAYLOAD];
+    for (uint8_t host = 0; host < ESPNOW_MAX_HOSTS; host++) {
+        StatsSlot &ss = stats_slots[host];
+        uint32_t seq = ss.seq;
+        if (seq == ss.read_seq || (seq & 1)) continue;  // nothing new / mid-write
+        uint8_t len = ss.len;
+        uint8_t version = ss.version;
+        memcpy(stats_copy, (const void *)ss.payload, len);
+        if (ss.seq != seq) continue;  // overwritten while copying, retry next pass
+        ss.read_seq = seq;
+        EspnowMsg msg = { MSG_STATS, stats_copy, len, version, 0, host };
+        dispatch_one(msg);
+        count++;
+    }
+    return count;
+}
+
+uint32_t espnow_rx_overflow_count(uint8_t type) {
+    return rx_overflow[type];
+}
+
+uint32_t espnow_rx_overflow_total() {
+    uint32_t total = 0;
+    for (int i = 0; i < 256; i++) total += rx_overflow[i];
+    return total;
 }
 
 int espnow_get_rssi() {
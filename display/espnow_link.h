@@ -1,27 +1,209 @@
 #pragma once
 #include <cstdint>
 #include "protocol.h"
+#include "link_adapt.h"
 
 void espnow_link_init();
+
+// Send to the active host: over the cable while the companion is on the
+// display's USB port (wired_link.h), else by radio
 bool espnow_send(MsgType type, const uint8_t *payload, uint8_t len);
 
+// Send a sequenced command: held in the in-flight window and retransmitted
+// until the bridge ACKs it (see "Sequenced commands" in protocol.h).
+// Over the cable it goes once, unsequenced. Payload max PROTO_MAX_PAYLOAD-1.
+bool espnow_send_reliable(MsgType type, const uint8_t *payload, uint8_t len);
+
+// Periodic heartbeat: MSG_PING to the paired bridge, or a broadcast
+// MSG_PAIR_REQ while unpaired / after the bridge has been silent for three
+// heartbeat periods. Lost, it also sweeps the other channels (at most every
+// 10 s, driven by espnow_link_update); linked, it asks the bridge for a
+// channel survey when too many unicast frames went unacknowledged, and
+// steps TX power / PHY rate (ESPNOW_ADAPT) on how well the bridge hears us.
+void espnow_send_heartbeat(uint32_t period_ms = 5000);
+
+// Committed radio channel (MSG_CHANNEL), also used for the SoftAP
+uint8_t espnow_channel();
+
+// True once a bridge MAC is known (stored in NVS) and frames go unicast
+bool espnow_is_paired();
+
+// ============================================================
+// Hosts: one display, several bridges (one per PC)
+//
+// Every paired bridge is a host slot (NVS "espnow"/"hosts"). Commands,
+// pings, HELLO and channel orders go to the active host; the others get a
+// ping per heartbeat so their bridges keep the display in their fan-out, and
+// only their MSG_STATS (tagged EspnowMsg::host) and PAIR_ACK / HELLO are
+// taken. All bridges have to share one channel: a CHANNEL_SWITCH is
+// followed only when the active host sends it.
+//
+// A bridge that answers a PAIR_REQ is added as a new host while
+// espnow_pair_new_host()'s window is open (or when none is paired yet);
+// outside it, an unknown bridge replaces the active host once that one has
+// gone quiet, as a reflashed or swapped bridge did with a single slot.
+// ============================================================
+
+#ifndef ESPNOW_MAX_HOSTS
+#define ESPNOW_MAX_HOSTS 4
+#endif
+#define ESPNOW_HOST_NONE 0xFF
+#define ESPNOW_PAIR_WINDOW_MS 30000
+
+uint8_t espnow_host_count();
+uint8_t espnow_active_host();
+
+// Make `host` the destination of everything the display sends. Instant:
+// its peer entry, protocol version and caps are kept from before. Commands
+// still in flight finish with the host they were sent to. False if no such slot.
+bool espnow_select_host(uint8_t host);
+
+// Heard from within three heartbeat periods
+bool espnow_host_linked(uint8_t host);
+
+// Broadcast PAIR_REQ for ESPNOW_PAIR_WINDOW_MS; a new bridge answering gets
+// the next free slot (or the one heard from least recently)
+void espnow_pair_new_host();
+bool espnow_pairing_host();
+
+// What the bridge's MSG_HELLO reply advertised: frame version (1 = legacy
+// frames, also for a bridge that never answered) and ProtoCaps
+// (PROTO_CAPS_LEGACY until it answers)
+uint8_t espnow_peer_version();
+uint16_t espnow_peer_caps();
+
+// Process received ACKs, retransmit timed-out commands and feed the TX queue
+// from send completions. Call every loop (EVT_ESPNOW_TX marks a completion).
+// Returns ms until it next needs to run (UINT32_MAX if nothing is pending).
+// espnow_send()/espnow_send_reliable() return false only if the TX queue is full.
+uint32_t espnow_link_update();
+
+// Link quality counters. TX latency is enqueue -> send-complete callback;
+// RTT is first transmission of a sequenced command -> bridge ACK.
+struct LinkStats {
+    uint32_t tx_ok;         // Frames the driver reported delivered (MAC ACK for unicast)
+    uint32_t tx_fail;       // Delivery failed, rejected or no callback
+    uint32_t tx_no_mem;     // ESP_ERR_ESPNOW_NO_MEM (frame kept and retried)
+    uint32_t tx_dropped;    // TX queue full
+    uint32_t tx_last_us;
+    uint32_t tx_avg_us;     // EWMA
+    uint32_t tx_max_us;
+    uint8_t  tx_queued;     // Frames waiting for the driver
+
+    uint32_t sent;          // Commands sent (first transmission)
+    uint32_t acked;         // Commands acknowledged by the bridge
+    uint32_t retries;       // Retransmissions
+    uint32_t lost;          // Gave up after TX_MAX_RETRIES
+    uint32_t late_acks;     // ACKs for a command no longer in flight
+    uint32_t window_full;   // Sent unsequenced because the window was full
+    uint32_t rtt_last_us;   // First transmission -> ACK
+    uint32_t rtt_avg_us;    // EWMA
+    uint32_t rtt_max_us;
+    uint8_t  in_flight;
+
+    uint32_t rx_bad;        // Frames dropped by frame_decode (CRC8, version, length)
+    uint32_t rx_frag_lost;  // Fragmented messages dropped (gap, overflow)
+
+    // Link adaptation (shared/link_adapt.h): current settings, not reset
+    int8_t   tx_power_qdbm; // 0.25 dBm
+    uint8_t  phy_rate_step; // 0 = ESPNOW_PHY_RATE (or the basic rate), 1 = 1 Mbps fallback
+    int8_t   far_rssi;      // Smoothed RSSI the bridge reports for our frames, 0 = no report
+    uint32_t adapt_changes; // Power / rate changes since boot
+};
+
+void espnow_get_link_stats(LinkStats &out);
+void espnow_reset_link_stats();
+
+// Latest power / rate changes, newest first (up to LINK_ADAPT_HISTORY).
+// Returns the number copied.
+int espnow_adapt_history(LinkAdaptChange *out, int max);
+
+// Latency probe (POST /api/bench): a sequenced MSG_PING to the active
+// host's bridge, by radio even while wired. espnow_ping_result() is its
+// first transmission -> ACK time in us once espnow_link_update() has seen
+// the ACK, 0 before, UINT32_MAX when it was given up on. One at a time;
+// false if unpaired, one is in flight or the window is full. UI task.
+bool espnow_ping_probe();
+uint32_t espnow_ping_result();
+
 // Convenience: send hotkey command to bridge
 void send_hotkey_to_bridge(uint8_t modifiers, uint8_t keycode);
 
 // Convenience: send media/consumer control key to bridge
 void send_media_key_to_bridge(uint16_t consumer_code);
 
-// Convenience: send button press identity (page + widget index) to bridge
-void send_button_press_to_bridge(uint8_t page_index, uint8_t widget_index);
+// Convenience: send button press identity (page + widget index) to bridge.
+// Each press gets a press_id + timestamp; the companion's MSG_ACTION_RESULT
+// echoes them back and is fed to perf_record_press(). profile_index < 0 = unknown;
+// entry_index picks the entry of a scroll grid (0xFFFF = none).
+void send_button_press_to_bridge(uint8_t page_index, uint8_t widget_index, int profile_index = -1,
+                                 uint16_t entry_index = 0xFFFF);
+
+// Convenience: send a macro (key sequence) for the bridge to play back locally
+void send_macro_to_bridge(const MacroStep *steps, uint8_t count);
+
+// Convenience: UTF-8 text for the bridge to type in host layout `layout`
+// (KeyLayout), clipped to TYPE_TEXT_MAX_BYTES. A bridge without
+// PROTO_CAP_TYPE_TEXT gets it as one macro of the same keys instead.
+void send_text_to_bridge(const char *utf8, size_t len, uint8_t layout);
+
+// Convenience: send a DDC/CI monitor command (relayed to the companion)
+void send_ddc_to_bridge(const DdcCmdMsg &cmd);
+
+// Ask the bridge to wake the sleeping PC (MSG_WAKE_HOST, USB remote
+// wakeup). Always by radio; the WAKE_RESULTs come back as MSG_WAKE_HOST.
+void send_wake_to_bridge();
+
+// Trackpad pointer frame. Motion (reliable = false) goes unsequenced and is
+// merged into the newest queued MSG_POINTER frame when that one hasn't
+// reached the driver yet and has the same mode and buttons; button changes
+// go sequenced (reliable = true) and are never merged. Radio only, wired or
+// not: the bridge is the mouse.
+bool espnow_send_pointer(const PointerMsg &msg, bool reliable);
+uint32_t espnow_pointer_merged();   // Motion frames folded into a queued one
 
 // Poll for incoming ACK messages (non-blocking)
 // Returns true if ACK received, status in out param
 bool espnow_poll_ack(uint8_t &status);
 
-// Poll for any incoming message (non-blocking)
-// Returns true if a message was received; type, payload, and len are filled in.
-// payload buffer must be at least PROTO_MAX_PAYLOAD bytes.
-bool espnow_poll_msg(uint8_t &type, uint8_t *payload, uint8_t &payload_len);
+// Received message handed to a handler. `payload` points into the RX queue
+// slot itself (no copy) and is only valid until the handler returns; a
+// handler that needs the data later copies what it keeps. Payloads are
+// packed protocol structs, so cast to those or memcpy, never to aligned types.
+struct EspnowMsg {
+    uint8_t type;
+    const uint8_t *payload;
+    uint8_t len;
+    uint8_t version;        // Frame format it came in: 1 = legacy, else PROTO_VERSION
+    uint32_t rx_us;         // micros() in the receive callback (0 for MSG_STATS)
+    uint8_t host;           // Host slot it came from (MSG_STATS: any host, else the active one)
+};
+
+typedef void (*EspnowHandler)(const EspnowMsg &msg);
+typedef bool (*EspnowRxFilter)(const EspnowMsg &msg);
+
+// Route a message type to `fn` (nullptr unregisters). Types without a
+// handler are drained and ignored.
+void espnow_register_handler(MsgType type, EspnowHandler fn);
+
+// Called for every message before its handler (link activity, wake-up).
+// Returning false drops the message.
+void espnow_set_rx_filter(EspnowRxFilter fn);
+
+// Run the handlers for everything received, then release each slot.
+// Queued messages go first, then the most recent MSG_STATS frame of each host.
+// Call from loop(); returns the number of messages dispatched.
+int espnow_dispatch();
+
+// A frame from the companion over the cable (wired_link_poll()): runs the
+// rx filter and handler in place, as from the active host. Answers
+// MSG_HELLO itself.
+void espnow_deliver_wired(uint8_t type, const uint8_t *payload, uint8_t len, uint32_t rx_us);
+
+// RX overflow counters: frames of a given type dropped (queue full) or,
+// for MSG_STATS, superseded by a newer frame before being polled.
+uint32_t espnow_rx_overflow_count(uint8_t type);
+uint32_t espnow_rx_overflow_total();
 
 // Get RSSI of last received ESP-NOW packet (dBm, 0 = no packets yet)
 int espnow_get_rssi();
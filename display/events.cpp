@@ -0,0 +1,67 @@
+/**
+ * @file events.cpp
+ * Loop wake-up events via FreeRTOS direct-to-task notifications
+ *
+ * Two consumers at most (the Arduino loop task and one claiming task), any
+ * number of producers. Bits accumulate with eSetBits, so several events
+ * posted while a consumer is busy are all delivered by its next
+ * events_wait().
+ */
+
+#include "events.h"
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static TaskHandle_t loop_task = NULL;
+static TaskHandle_t claim_task = NULL;
+static volatile uint32_t claim_bits = 0;
+
+// Per-pin event bits for the shared GPIO ISR
+#define EVENTS_MAX_GPIO 49
+static uint32_t gpio_bits[EVENTS_MAX_GPIO] = {};
+
+void events_init() {
+    loop_task = xTaskGetCurrentTaskHandle();
+}
+
+void events_claim(uint32_t bits) {
+    claim_task = xTaskGetCurrentTaskHandle();
+    claim_bits = bits;
+}
+
+void events_post(uint32_t bits) {
+    uint32_t claimed = bits & claim_bits;
+    if (claimed) xTaskNotify(claim_task, claimed, eSetBits);
+    bits &= ~claimed;
+    if (bits && loop_task) xTaskNotify(loop_task, bits, eSetBits);
+}
+
+void IRAM_ATTR events_post_from_isr(uint32_t bits) {
+    BaseType_t woken = pdFALSE;
+    uint32_t claimed = bits & claim_bits;
+    if (claimed) xTaskNotifyFromISR(claim_task, claimed, eSetBits, &woken);
+    bits &= ~claimed;
+    if (bits && loop_task) xTaskNotifyFromISR(loop_task, bits, eSetBits, &woken);
+    if (woken) portYIELD_FROM_ISR();
+}
+
+static void IRAM_ATTR gpio_event_isr(void *arg) {
+    events_post_from_isr(gpio_bits[(int)(intptr_t)arg]);
+}
+
+bool events_attach_gpio(int pin, uint32_t bits) {
+    if (pin < 0 || pin >= EVENTS_MAX_GPIO) return false;
+    gpio_bits[pin] = bits;
+    pinMode(pin, INPUT_PULLUP);
+    attachInterruptArg(digitalPinToInterrupt(pin), gpio_event_isr,
+                       (void *)(intptr_t)pin, FALLING);
+    Serial.printf("[events] GPIO %d -> event 0x%02lX\n", pin, (unsigned long)bits);
+    return true;
+}
+
+uint32_t events_wait(uint32_t timeout_ms) {
+    uint32_t bits = 0;
+    xTaskNotifyWait(0, UINT32_MAX, &bits, pdMS_TO_TICKS(timeout_ms));
+    return bits;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+
+// ============================================================
+// Loop wake-up events
+//
+// Producers (WiFi task, GPIO ISRs, the input task) set bits on the Arduino
+// loop task's notification value; loop() sleeps in events_wait() until a
+// bit is set or its next deadline (LVGL timer / periodic housekeeping)
+// comes due. One other task may claim a set of bits with events_claim();
+// those are delivered to it instead (the input task takes the INT lines).
+// ============================================================
+
+enum LoopEvent : uint32_t {
+    EVT_ESPNOW_RX  = (1u << 0),  // Frame queued by espnow_link on_recv
+    EVT_TOUCH_INT  = (1u << 1),  // GT911 INT line asserted
+    EVT_HW_INPUT   = (1u << 2),  // PCF8575 INT line asserted
+    EVT_UI_REQUEST = (1u << 3),  // Deferred UI work requested (rebuild etc.)
+    EVT_ESPNOW_TX  = (1u << 4),  // ESP-NOW send-complete callback fired
+    EVT_TOUCH_DATA = (1u << 5),  // Input task: touch state changed / still pressed
+    EVT_HW_DATA    = (1u << 6),  // Input task: button/encoder sample queued
+    EVT_BATTERY_ALERT = (1u << 7),  // MAX17048 ALRT line asserted (SOC step / low)
+    EVT_WIRED_RX   = (1u << 8),  // Console UART received bytes (wired_link.h)
+};
+
+// Capture the calling task as the event consumer. Call once from setup().
+void events_init();
+
+// Deliver `bits` to the calling task from now on instead of the loop task.
+// That task then waits with events_wait() as well.
+void events_claim(uint32_t bits);
+
+// Post events from task context (e.g. WiFi callbacks). Safe before events_init().
+void events_post(uint32_t bits);
+
+// Post events from an ISR.
+void events_post_from_isr(uint32_t bits);
+
+// Attach a falling-edge GPIO interrupt that posts `bits`. Returns false for pin < 0.
+bool events_attach_gpio(int pin, uint32_t bits);
+
+// Block until any event is posted or timeout_ms elapses. Returns the bits
+// that were pending (0 on timeout) and clears them.
+uint32_t events_wait(uint32_t timeout_ms);
@@ -0,0 +1,84 @@
+/**
+ * @file font_store.cpp
+ * Flash fonts by size, plus SD card fonts loaded into PSRAM on first use
+ *
+ * Misses are remembered too, so a size without a file costs one SD lookup
+ * per boot rather than one per label. UI task only (LVGL calls).
+ */
+
+#include "font_store.h"
+#include "sdcard.h"
+#include <Arduino.h>
+#include <SD.h>
+
+struct FontSlot {
+    uint16_t size;
+    lv_font_t *font;   // nullptr: no file for this size
+};
+
+static FontSlot slots[FONT_STORE_SLOTS * 2];   // Loaded fonts + remembered misses
+static int slot_count = 0;
+static int loaded_count = 0;
+
+static const struct {
+    uint16_t size;
+    const lv_font_t *font;
+} BUILTIN[] = {
+    { 40, &lv_font_montserrat_40 },
+    { 28, &lv_font_montserrat_28 },
+    { 24, &lv_font_montserrat_24 },
+    { 22, &lv_font_montserrat_22 },
+    { 20, &lv_font_montserrat_20 },
+    { 18, &lv_font_montserrat_18 },
+    { 16, &lv_font_montserrat_16 },
+    { 14, &lv_font_montserrat_14 },
+    { 12, &lv_font_montserrat_12 },
+};
+
+const lv_font_t *font_store_builtin(uint16_t size_px) {
+    for (const auto &b : BUILTIN) {
+        if (size_px >= b.size) return b.font;
+    }
+    return &lv_font_montserrat_12;
+}
+
+static bool is_builtin_size(uint16_t size_px) {
+    for (const auto &b : BUILTIN) {
+        if (b.size == size_px) return true;
+    }
+    return false;
+}
+
+static lv_font_t *load_sd_font(uint16_t size_px) {
+    if (!sdcard_mounted() || loaded_count >= FONT_STORE_SLOTS) return nullptr;
+    char path[32];
+    snprintf(path, sizeof(path), FONT_STORE_DIR "/%u.bin", size_px);
+    File f = SD.open(path);
+    if (!f) return nullptr;
+    size_t bytes = f.size();
+    f.close();
+
+    char lv_path[36];
+    snprintf(lv_path, sizeof(lv_path), "S:%s", path);
+    uint32_t t0 = millis();
+    lv_font_t *font = lv_font_load(lv_path);
+    if (!font) {
+        Serial.printf("[fonts] %s: not a valid LVGL font\n", path);
+        return nullptr;
+    }
+    font->fallback = font_store_builtin(size_px);
+    loaded_count++;
+    Serial.printf("[fonts] Loaded %s (%u KB, line height %d) in %lums\n", path, (unsigned)(bytes / 1024),
+                  font->line_height, (unsigned long)(millis() - t0));
+    return font;
+}
+
+const lv_font_t *font_store_get(uint16_t size_px) {
+    if (is_builtin_size(size_px)) return font_store_builtin(size_px);
+    for (int i = 0; i < slot_count; i++) {
+        if (slots[i].size == size_px) return slots[i].font ? slots[i].font : font_store_builtin(size_px);
+    }
+    lv_font_t *font = load_sd_font(size_px);
+    if (slot_count < (int)(sizeof(slots) / sizeof(slots[0]))) slots[slot_count++] = { size_px, font };
+    return font ? font : font_store_builtin(size_px);
+}
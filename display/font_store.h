@@ -0,0 +1,27 @@
+#pragma once
+#include <lvgl.h>
+#include <stdint.h>
+
+// ============================================================
+// Text fonts by pixel size
+//
+// Sizes with a font in flash (LV_FONT_MONTSERRAT_* in lv_conf.h) use it.
+// Any other size is looked up once as FONT_STORE_DIR/<size>.bin on the SD
+// card (LVGL binary font, tools/font_subset.py --bin) and loaded whole into
+// PSRAM through lv_font_load(), which keeps every glyph resident: the
+// loaded font is its own glyph cache and renders at flash-font speed. Its
+// fallback is the nearest flash font, so symbols missing from it still
+// draw. Without an SD font the nearest flash size at or below is used.
+// ============================================================
+
+#define FONT_STORE_DIR "/fonts"
+
+// Loaded SD fonts kept at once (each stays until reboot: labels point at it)
+#ifndef FONT_STORE_SLOTS
+#define FONT_STORE_SLOTS 6
+#endif
+
+const lv_font_t *font_store_get(uint16_t size_px);
+
+// Largest flash font not above size_px (12 px minimum)
+const lv_font_t *font_store_builtin(uint16_t size_px);
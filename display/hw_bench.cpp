@@ -0,0 +1,177 @@
+/**
+ * @file hw_bench.cpp
+ * On-device hardware microbenchmarks (POST /api/bench)
+ *
+ * Each stage borrows the module's own measurement (draw_accel_measure,
+ * display_flush_benchmark, sdcard_benchmark, i2c_bench) or times the real
+ * entry point (png_stream_decode, img_loader_decode_into, config_load,
+ * espnow_ping_probe), with the same locking their normal callers use: LVGL
+ * and the config string pool under the UI lock, redraws on the UI task.
+ */
+
+#include "hw_bench.h"
+#include "config.h"
+#include "espnow_link.h"
+#include "img_loader.h"
+#include "mem_budget.h"
+#include "png_stream.h"
+#include "tasks.h"
+#include <Arduino.h>
+#include <algorithm>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#define HW_BENCH_UI_TIMEOUT_MS 10000   // Redraw stage, queued behind the loop pass
+
+static portMUX_TYPE run_mux = portMUX_INITIALIZER_UNLOCKED;
+static bool running = false;
+
+static SemaphoreHandle_t ui_done = nullptr;
+static DisplayFlushBench flush_result;
+static DisplayPclkProbe pclk_result;
+
+static uint32_t percentile(uint32_t *v, uint16_t n, int pct) {
+    if (n == 0) return 0;
+    return v[(uint32_t)(n - 1) * pct / 100];
+}
+
+static void flush_stage_cb(uint32_t) {
+    display_flush_benchmark(HW_BENCH_REDRAWS, flush_result);
+    xSemaphoreGive(ui_done);
+}
+
+static bool bench_flush(DisplayFlushBench &out) {
+    if (!ui_done) ui_done = xSemaphoreCreateBinary();
+    xSemaphoreTake(ui_done, 0);   // A late give from a run that timed out
+    if (!ui_post(flush_stage_cb)) return false;
+    if (xSemaphoreTake(ui_done, pdMS_TO_TICKS(HW_BENCH_UI_TIMEOUT_MS)) != pdTRUE) return false;
+    out = flush_result;
+    return out.frame_us != 0;
+}
+
+static void pclk_stage_cb(uint32_t) {
+    display_pclk_probe(pclk_result);
+    xSemaphoreGive(ui_done);
+}
+
+static bool bench_pclk(DisplayPclkProbe &out) {
+    xSemaphoreTake(ui_done, 0);
+    if (!ui_post(pclk_stage_cb)) return false;
+    if (xSemaphoreTake(ui_done, pdMS_TO_TICKS(HW_BENCH_UI_TIMEOUT_MS)) != pdTRUE) return false;
+    out = pclk_result;
+    return out.steps != 0;
+}
+
+static void bench_png(const char *path, HwBenchResult &r) {
+    if (!sdcard_file_exists(path)) return;
+    String src = String("S:") + path;
+    uint32_t w, h;
+    ui_lock();   // lv_fs, as for the icon cache build
+    bool info = png_stream_info(src.c_str(), &w, &h) && w && h && w * h <= SCREEN_WIDTH * SCREEN_HEIGHT;
+    ui_unlock();
+    if (!info) return;
+
+    uint8_t *dst = (uint8_t *)mem_alloc(MEM_POOL_IMAGES, w * h * LV_IMG_PX_SIZE_ALPHA_BYTE);
+    if (!dst) return;
+    ui_lock();
+    uint32_t t0 = micros();
+    bool ok = png_stream_decode(src.c_str(), dst, (uint16_t)w, (uint16_t)h);
+    uint32_t us = micros() - t0;
+    ui_unlock();
+    mem_free(MEM_POOL_IMAGES, dst);
+    if (!ok) return;
+    r.png_us = us ? us : 1;
+    r.png_w = (uint16_t)w;
+    r.png_h = (uint16_t)h;
+}
+
+static void bench_jpeg(const char *path, HwBenchResult &r) {
+    if (!sdcard_file_exists(path) || !img_loader_takes(path)) return;
+    uint16_t *frame = (uint16_t *)mem_alloc(MEM_POOL_IMAGES, SCREEN_WIDTH * SCREEN_HEIGHT * sizeof(uint16_t));
+    if (!frame) return;
+    volatile ImgLoadState state = IMG_LOAD_IDLE;
+    uint32_t t0 = micros();
+    if (img_loader_decode_into(path, frame, &state)) {
+        // Loader jobs can't be cancelled: the frame has to outlive this one
+        while (state == IMG_LOAD_BUSY) vTaskDelay(1);
+        uint32_t us = micros() - t0;
+        if (state == IMG_LOAD_READY) r.jpeg_us = us ? us : 1;
+    }
+    mem_free(MEM_POOL_IMAGES, frame);
+}
+
+static void bench_config(HwBenchResult &r) {
+    if (!sdcard_mounted()) return;
+    ui_lock();   // ConfigStr pool: UI-owned
+    uint32_t t0 = micros();
+    {
+        AppConfig cfg = config_load(&r.config_from_sd);
+    }
+    r.config_load_us = micros() - t0;
+    ui_unlock();
+}
+
+static void bench_pings(HwBenchResult &r) {
+    if (!espnow_is_paired()) return;
+    uint32_t rtt[HW_BENCH_PINGS];
+    uint16_t n = 0;
+    for (uint16_t i = 0; i < HW_BENCH_PINGS; i++) {
+        ui_lock();
+        bool sent = espnow_ping_probe();
+        ui_unlock();
+        if (!sent) {
+            vTaskDelay(pdMS_TO_TICKS(10));   // Window full or the last one still out
+            continue;
+        }
+        r.pings_sent++;
+        uint32_t result = 0;
+        uint32_t t0 = millis();
+        while (result == 0 && millis() - t0 < HW_BENCH_PING_TIMEOUT_MS) {
+            vTaskDelay(1);
+            ui_lock();
+            result = espnow_ping_result();
+            ui_unlock();
+        }
+        if (result != 0 && result != UINT32_MAX) rtt[n++] = result;
+        vTaskDelay(pdMS_TO_TICKS(5));
+    }
+    std::sort(rtt, rtt + n);
+    r.pings_acked = n;
+    r.ping_p50_us = percentile(rtt, n, 50);
+    r.ping_p99_us = percentile(rtt, n, 99);
+}
+
+bool hw_bench_run(HwBenchResult &r, const char *png_path, const char *jpeg_path) {
+    portENTER_CRITICAL(&run_mux);
+    bool busy = running;
+    running = true;
+    portEXIT_CRITICAL(&run_mux);
+    if (busy) return false;
+
+    r = {};
+    uint32_t t0 = millis();
+    Serial.println("[hw_bench] run started");
+
+    r.draw_ok = draw_accel_measure(r.draw);
+    r.flush_ok = bench_flush(r.flush);
+    if (r.flush_ok) r.pclk_ok = bench_pclk(r.pclk);   // After: shares the semaphore bench_flush made
+    r.sd_ok = sdcard_benchmark(&r.sd, true);
+    bench_png(png_path, r);
+    bench_jpeg(jpeg_path, r);
+    bench_config(r);
+    bench_pings(r);
+    for (int d = 0; d < I2C_DEV_COUNT; d++) i2c_bench((I2cDevice)d, HW_BENCH_I2C_RUNS, &r.i2c[d]);
+
+    r.elapsed_ms = millis() - t0;
+    Serial.printf("[hw_bench] done in %lu ms: fill %lu us, redraw %lu us, png %lu us, jpeg %lu us, "
+                  "config %lu us, ping p50 %lu us (%u/%u), max pclk %lu Hz\n",
+                  (unsigned long)r.elapsed_ms, (unsigned long)r.draw.fill_us, (unsigned long)r.flush.frame_us,
+                  (unsigned long)r.png_us, (unsigned long)r.jpeg_us, (unsigned long)r.config_load_us,
+                  (unsigned long)r.ping_p50_us, r.pings_acked, r.pings_sent,
+                  (unsigned long)r.pclk.max_stable_hz);
+
+    portENTER_CRITICAL(&run_mux);
+    running = false;
+    portEXIT_CRITICAL(&run_mux);
+    return true;
+}
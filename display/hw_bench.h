@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+#include "display_hw.h"
+#include "draw_accel.h"
+#include "sdcard.h"
+#include "i2c_bus.h"
+
+// ============================================================
+// Hardware microbenchmarks (POST /api/bench, config mode)
+//
+// One run measures, in order: full-screen fill/blend passes, full-screen
+// redraws through disp_flush_cb (on the UI task), the PCLK ceiling
+// (bounce-buffer builds, display_pclk_probe), SD sequential and random
+// reads and writes, decode of the reference PNG and SJPG/JPEG,
+// config_load(), ESP-NOW PING round trips to the bridge and a probe
+// transaction per I2C device. A stage that can't run (no card, reference
+// image missing, unpaired) is left out of the result. Takes several
+// seconds: run it on a config server worker. The companion collects runs
+// from many units for comparison (hotkey_companion.py --hw-bench).
+//
+// Not to be confused with bench.h, the end-to-end press latency run.
+// ============================================================
+
+#define HW_BENCH_REF_PNG  "/bench/ref.png"    // Uploaded by the companion
+#define HW_BENCH_REF_JPEG "/bench/ref.sjpg"
+#define HW_BENCH_REDRAWS  10
+#define HW_BENCH_PINGS    50
+#define HW_BENCH_PING_TIMEOUT_MS 250          // Past the link's last retransmit
+#define HW_BENCH_I2C_RUNS 50
+
+struct HwBenchResult {
+    uint32_t elapsed_ms;
+
+    bool draw_ok;
+    DrawBenchResult draw;
+
+    bool flush_ok;
+    DisplayFlushBench flush;
+
+    bool pclk_ok;                  // Bounce-buffer builds only
+    DisplayPclkProbe pclk;
+
+    bool sd_ok;
+    SdBenchResult sd;
+
+    uint32_t png_us;               // 0: not run (missing or undecodable)
+    uint16_t png_w, png_h;
+    uint32_t jpeg_us;              // Request -> frame ready on the loader task
+
+    uint32_t config_load_us;       // 0: no card
+    bool config_from_sd;
+
+    uint16_t pings_sent;           // 0: unpaired
+    uint16_t pings_acked;
+    uint32_t ping_p50_us;
+    uint32_t ping_p99_us;
+
+    I2cBenchResult i2c[I2C_DEV_COUNT];
+};
+
+// Run every stage into `out`. False (nothing run) while a run is going.
+bool hw_bench_run(HwBenchResult &out, const char *png_path = HW_BENCH_REF_PNG,
+                  const char *jpeg_path = HW_BENCH_REF_JPEG);
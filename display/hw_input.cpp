@@ -1,13 +1,22 @@
 #include "hw_input.h"
 #include <Arduino.h>
 #include <Wire.h>
-#include "touch.h"     // i2c_take/i2c_give
+#include "i2c_bus.h"
 #include "config.h"
 #include "protocol.h"
 #include "ui.h"
 #include "power.h"
 #include "espnow_link.h"
-#include "config_server.h"
+#include "events.h"
+#include "log.h"
+#include "trace.h"
+#include "actions.h"
+#include "runtime_state.h"
+#include "stats_log.h"
+#include "input_replay.h"
+#include "rotary_encoder.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
 
 // ============================================================
 // TCA9548A I2C Mux + PCF8575 Addresses
@@ -26,12 +35,32 @@
 
 // Debounce timing
 #define BUTTON_DEBOUNCE_MS  50
-#define ENCODER_ROT_MIN_MS  80  // Minimum interval between rotation events
 #define REBOOT_HOLD_MS      5000 // Hold all 4 buttons for 5s to force reboot
 
+// Encoder: one detent per return to the rest state, accelerated by velocity
+#define ENCODER_ACCEL_FAST_MS   30   // Detent interval for 4x step
+#define ENCODER_ACCEL_MED_MS    70   // Detent interval for 2x step
+#ifndef ENCODER_COALESCE_MS
+#define ENCODER_COALESCE_MS     40   // Volume/DDC detents merged into one message
+#endif
+#define ENCODER_MAX_PENDING     20   // Cap on accumulated (accelerated) steps
+
+// Pin samples in flight from the input task to the UI task (5 ms fast poll:
+// 32 covers a UI pass of well over 100 ms without losing an encoder edge)
+#define HW_SAMPLE_QUEUE_LEN     32
+
 // ============================================================
 // State
 // ============================================================
+// Sampled on the input task, decoded/dispatched on the UI task
+struct PinSample {
+    uint16_t pins;
+    uint32_t ms;
+};
+static QueueHandle_t sample_queue = nullptr;
+static uint16_t last_sampled = 0xFFFF;       // Input task only
+static volatile uint32_t samples_dropped = 0;
+
 static bool pcf_available = false;
 static uint8_t pcf_addr = 0;
 
@@ -42,7 +71,13 @@ static bool btn_prev_pressed[5] = {false};
 
 // Encoder quadrature state
 static uint8_t enc_prev_state = 0;
-static uint32_t enc_last_rotation_ms = 0;
+static uint8_t enc_rest_state = 0;       // CLK/DT level between detents (sampled at init)
+static int8_t enc_quarter_steps = 0;     // Net transitions since the last rest state
+static uint32_t enc_last_detent_ms = 0;
+
+// Coalesced volume/DDC rotation (flushed every ENCODER_COALESCE_MS)
+static int16_t enc_pending_steps = 0;
+static uint32_t enc_pending_since = 0;
 
 // All-buttons-held reboot detection
 static uint32_t all_btn_hold_start = 0;
@@ -54,7 +89,7 @@ static lv_obj_t *focus_highlight_obj = nullptr;
 static lv_opa_t focus_prev_opa = LV_OPA_TRANSP;  // Restore original opacity on clear
 
 // ============================================================
-// I2C helpers (all PCF8575 access must hold i2c mutex)
+// I2C helpers (PCF8575 access runs inside i2c_bus jobs)
 // ============================================================
 
 static bool tca_select_channel(uint8_t ch) {
@@ -70,7 +105,7 @@ static void tca_deselect() {
 }
 
 static uint16_t pcf8575_read() {
-    // Must be called with i2c mutex held and mux channel selected
+    // Mux channel must be selected
     Wire.requestFrom(pcf_addr, (uint8_t)2);
     if (Wire.available() < 2) return 0xFFFF;
     uint8_t lo = Wire.read();
@@ -81,12 +116,8 @@ static uint16_t pcf8575_read() {
 // ============================================================
 // hw_input_init()
 // ============================================================
-bool hw_input_init() {
-    if (!i2c_take(50)) {
-        Serial.println("[hw_input] I2C mutex timeout at init");
-        return false;
-    }
-
+// Setup: scan for debugging, then find the PCF8575 behind the mux
+static bool pcf_probe_job(void *) {
     // I2C bus scan for debugging
     Serial.print("[hw_input] I2C scan:");
     for (uint8_t addr = 0x08; addr < 0x78; addr++) {
@@ -101,7 +132,6 @@ bool hw_input_init() {
     if (!tca_select_channel(PCF8575_MUX_CH)) {
         Serial.println("[hw_input] TCA9548A not found at 0x70");
         tca_deselect();
-        i2c_give();
         return false;
     }
 
@@ -117,26 +147,38 @@ bool hw_input_init() {
     }
 
     tca_deselect();
-    i2c_give();
+    return true;
+}
+
+static bool pcf_read_job(void *arg) {
+    if (!tca_select_channel(PCF8575_MUX_CH)) return false;
+    *(uint16_t *)arg = pcf8575_read();
+    tca_deselect();
+    return true;
+}
 
+bool hw_input_init() {
+    rotary_encoder_init();   // Encoder on GPIOs: PCNT, whether or not the PCF8575 is there
+    i2c_run(I2C_DEV_PCF8575, I2C_PRIO_BACKGROUND, pcf_probe_job);
     if (!pcf_available) {
         Serial.println("[hw_input] PCF8575 not found (hardware buttons disabled)");
         return false;
     }
+    static uint16_t probe_pins;   // Benchmark probe: the same read as a button sample
+    i2c_register_probe(I2C_DEV_PCF8575, pcf_read_job, &probe_pins);
 
     // Initialize encoder quadrature state
-    if (i2c_take(10)) {
-        tca_select_channel(PCF8575_MUX_CH);
-        uint16_t pins = pcf8575_read();
-        tca_deselect();
-        i2c_give();
-
+    uint16_t pins;
+    if (i2c_run(I2C_DEV_PCF8575, I2C_PRIO_INPUT, pcf_read_job, &pins)) {
         uint8_t clk = (pins & PIN_ENC_CLK) ? 1 : 0;
         uint8_t dt  = (pins & PIN_ENC_DT)  ? 1 : 0;
         enc_prev_state = (clk << 1) | dt;
+        enc_rest_state = enc_prev_state;
         prev_pin_state = pins;
+        last_sampled = pins;
     }
 
+    sample_queue = xQueueCreate(HW_SAMPLE_QUEUE_LEN, sizeof(PinSample));
     return true;
 }
 
@@ -145,77 +187,21 @@ bool hw_input_available() {
 }
 
 // ============================================================
-// Action dispatch (shared by buttons and encoder push)
+// Actions: buttons and the encoder push go through action_run()
 // ============================================================
-static void dispatch_action(ActionType action, uint8_t keycode, uint16_t consumer_code,
-                            uint8_t modifiers, uint8_t hw_btn_idx) {
-    power_activity();
-
+void hw_input_run_action(uint8_t action, uint8_t keycode, uint16_t consumer_code, uint8_t modifiers) {
     switch (action) {
-        case ACTION_HOTKEY:
-            send_hotkey_to_bridge(modifiers, keycode);
-            break;
-        case ACTION_MEDIA_KEY:
-            send_media_key_to_bridge(consumer_code);
-            break;
         case ACTION_LAUNCH_APP:
         case ACTION_SHELL_CMD:
         case ACTION_OPEN_URL:
-            // Send as button press for companion to handle
-            // Use page 0xFF and hw_btn_idx as widget to signal hardware button
-            send_button_press_to_bridge(0xFF, hw_btn_idx);
-            break;
-        case ACTION_DISPLAY_SETTINGS:
-        case ACTION_CONFIG_MODE:
-            if (!config_server_active()) {
-                config_server_start();
-                show_config_screen();
-            } else {
-                config_server_stop();
-                hide_config_screen();
-            }
-            break;
-        case ACTION_DISPLAY_CLOCK:
-            display_set_mode(MODE_CLOCK);
-            break;
-        case ACTION_DISPLAY_PICTURE:
-            display_set_mode(MODE_PICTURE_FRAME);
-            break;
-        case ACTION_PAGE_NEXT:
-            ui_next_page();
-            break;
-        case ACTION_PAGE_PREV:
-            ui_prev_page();
-            break;
-        case ACTION_PAGE_GOTO:
-            ui_goto_page(keycode);
-            break;
-        case ACTION_MODE_CYCLE:
-            mode_cycle_next(get_global_config().mode_cycle.enabled_modes);
-            break;
-        case ACTION_BRIGHTNESS:
-            power_cycle_brightness();
-            break;
-        case ACTION_DDC: {
-            const HwButtonConfig &hbc = get_global_config().hw_buttons[hw_btn_idx < 4 ? hw_btn_idx : 0];
-            DdcCmdMsg ddc;
-            ddc.vcp_code = hbc.ddc_vcp_code;
-            ddc.value = hbc.ddc_value;
-            ddc.adjustment = hbc.ddc_adjustment;
-            ddc.display_num = hbc.ddc_display;
-            espnow_send(MSG_DDC_CMD, (const uint8_t *)&ddc, sizeof(ddc));
-            Serial.printf("[hw_input] DDC cmd: vcp=0x%02X val=%d adj=%d disp=%d\n",
-                          ddc.vcp_code, ddc.value, ddc.adjustment, ddc.display_num);
-            break;
-        }
-        case ACTION_FOCUS_NEXT:
-            hw_input_focus_next();
-            break;
-        case ACTION_FOCUS_PREV:
-            hw_input_focus_prev();
-            break;
-        case ACTION_FOCUS_ACTIVATE:
-            hw_input_activate_focus();
+        case ACTION_DDC:
+        case ACTION_MACRO:
+        case ACTION_TYPE_TEXT:
+            // These resolve their parameters through a hardware button slot
+            Serial.printf("[hw_input] action %d needs a button slot, ignored\n", action);
+            return;
+        default:
+            action_run(action_simple(action, keycode, consumer_code, modifiers));
             break;
     }
 }
@@ -223,22 +209,65 @@ static void dispatch_action(ActionType action, uint8_t keycode, uint16_t consume
 // ============================================================
 // Encoder rotation dispatch
 // ============================================================
-static void dispatch_encoder_rotation(int8_t direction) {
+static bool encoder_mode_coalesces(uint8_t mode) {
+    return mode == 1 || mode == 5;  // volume, ddc_control
+}
+
+// Send accumulated volume/DDC steps as a single message
+static void flush_encoder_steps() {
+    if (enc_pending_steps == 0) return;
+    const AppConfig &cfg = get_global_config();
+    int16_t steps = enc_pending_steps;
+    enc_pending_steps = 0;
+    if (replay_running()) return;   // Replayed volume/DDC turns stay on the panel
+
+    if (cfg.encoder.encoder_mode == 5) { // ddc_control
+        DdcCmdMsg ddc;
+        ddc.vcp_code = cfg.encoder.ddc_vcp_code;
+        ddc.value = 0;
+        ddc.adjustment = steps * (int16_t)cfg.encoder.ddc_step;
+        ddc.display_num = cfg.encoder.ddc_display;
+        send_ddc_to_bridge(ddc);
+        Serial.printf("[hw_input] Encoder DDC: vcp=0x%02X adj=%d\n", ddc.vcp_code, ddc.adjustment);
+    } else { // volume: one macro of N media taps instead of N messages
+        uint16_t code = (steps > 0) ? 0x00E9 : 0x00EA;  // Vol+ / Vol-
+        uint8_t count = (uint8_t)abs(steps);
+        if (count == 1) {
+            hid_send_media(code);
+        } else {
+            MacroStep taps[ENCODER_MAX_PENDING];
+            for (uint8_t i = 0; i < count; i++) {
+                taps[i] = {MACRO_OP_MEDIA, (uint8_t)(code & 0xFF), (uint8_t)(code >> 8)};
+            }
+            hid_send_macro(taps, count);
+        }
+    }
+}
+
+static void dispatch_encoder_rotation(int8_t direction, uint8_t accel) {
     power_activity();
     const AppConfig &cfg = get_global_config();
     uint8_t mode = cfg.encoder.encoder_mode;
 
+    if (encoder_mode_coalesces(mode)) {
+        // Direction change: send what we have so it isn't cancelled out
+        if (enc_pending_steps != 0 && (enc_pending_steps > 0) != (direction > 0)) {
+            flush_encoder_steps();
+        }
+        if (enc_pending_steps == 0) enc_pending_since = millis();
+        enc_pending_steps += direction * accel;
+        if (enc_pending_steps > ENCODER_MAX_PENDING) enc_pending_steps = ENCODER_MAX_PENDING;
+        if (enc_pending_steps < -ENCODER_MAX_PENDING) enc_pending_steps = -ENCODER_MAX_PENDING;
+        return;
+    }
+
     switch (mode) {
         case 0: // page_nav
             if (direction > 0) ui_next_page();
             else ui_prev_page();
             break;
-        case 1: // volume
-            if (direction > 0) send_media_key_to_bridge(0x00E9); // Vol+
-            else send_media_key_to_bridge(0x00EA);               // Vol-
-            break;
         case 2: // brightness
-            power_cycle_brightness();
+            power_step_brightness(direction * accel);
             break;
         case 3: // app_select
             if (direction > 0) hw_input_focus_next();
@@ -250,16 +279,6 @@ static void dispatch_encoder_rotation(int8_t direction) {
             else
                 mode_cycle_next(cfg.mode_cycle.enabled_modes); // same direction, just cycle
             break;
-        case 5: { // ddc_control
-            DdcCmdMsg ddc;
-            ddc.vcp_code = cfg.encoder.ddc_vcp_code;
-            ddc.value = 0;
-            ddc.adjustment = (direction > 0) ? (int16_t)cfg.encoder.ddc_step : -(int16_t)cfg.encoder.ddc_step;
-            ddc.display_num = cfg.encoder.ddc_display;
-            espnow_send(MSG_DDC_CMD, (const uint8_t *)&ddc, sizeof(ddc));
-            Serial.printf("[hw_input] Encoder DDC: vcp=0x%02X adj=%d\n", ddc.vcp_code, ddc.adjustment);
-            break;
-        }
     }
 }
 
@@ -274,6 +293,9 @@ static const int8_t QUAD_TABLE[16] = {
     0,  1, -1,  0
 };
 
+// Returns +1/-1 once per detent (when the encoder settles back to its rest
+// state with net movement), 0 otherwise. Intermediate transitions missed
+// by a slow poll still resolve to the right direction.
 static int8_t decode_encoder(uint16_t pins) {
     uint8_t clk = (pins & PIN_ENC_CLK) ? 1 : 0;
     uint8_t dt  = (pins & PIN_ENC_DT)  ? 1 : 0;
@@ -283,51 +305,97 @@ static int8_t decode_encoder(uint16_t pins) {
 
     uint8_t idx = (enc_prev_state << 2) | new_state;
     enc_prev_state = new_state;
+    enc_quarter_steps += QUAD_TABLE[idx];
 
-    int8_t dir = QUAD_TABLE[idx];
+    if (new_state != enc_rest_state) return 0;
+    int8_t dir = (enc_quarter_steps > 0) ? 1 : (enc_quarter_steps < 0) ? -1 : 0;
+    enc_quarter_steps = 0;
+    return dir;
+}
 
-    // Enforce minimum interval between rotation events
-    if (dir != 0) {
-        uint32_t now = millis();
-        if (now - enc_last_rotation_ms < ENCODER_ROT_MIN_MS) {
-            return 0; // Too fast, ignore
-        }
-        enc_last_rotation_ms = now;
-    }
+// Step multiplier from the interval since the previous detent (over
+// `detents` detents: the PCNT path hands over several at once)
+static uint8_t encoder_accel(uint32_t now, uint32_t detents = 1) {
+    uint32_t dt = (now - enc_last_detent_ms) / detents;
+    enc_last_detent_ms = now;
+    if (dt < ENCODER_ACCEL_FAST_MS) return 4;
+    if (dt < ENCODER_ACCEL_MED_MS) return 2;
+    return 1;
+}
 
-    return dir;
+// Detents counted by the PCNT unit since the last UI pass
+static void process_pcnt_detents() {
+    uint32_t last_ms;
+    int32_t delta = rotary_encoder_take(&last_ms);
+    if (delta == 0 || replay_running()) return;   // Replay owns the input meanwhile
+    int8_t dir = delta > 0 ? 1 : -1;
+    uint32_t count = (uint32_t)abs(delta);
+    uint8_t accel = encoder_accel(last_ms, count);
+    LOG_D("[hw_input] Encoder rotation (PCNT): %s %lu x%d\n", dir > 0 ? "CW" : "CCW",
+          (unsigned long)count, accel);
+    // Volume/DDC coalesce and cap anyway; page/focus steps are one per detent
+    if (count > ENCODER_MAX_PENDING) count = ENCODER_MAX_PENDING;
+    for (uint32_t i = 0; i < count; i++) dispatch_encoder_rotation(dir, accel);
 }
 
 // ============================================================
-// hw_input_poll()
+// hw_input_sample() -- input task: I2C read only
 // ============================================================
-void hw_input_poll() {
-    if (!pcf_available) return;
-
-    if (!i2c_take(5)) return;  // Don't block if touch is using I2C
-
-    tca_select_channel(PCF8575_MUX_CH);
-    uint16_t pins = pcf8575_read();
-    tca_deselect();
-    i2c_give();
+bool hw_input_sample() {
+    if (!pcf_available) return false;
+    uint16_t pins;
+    if (!i2c_run(I2C_DEV_PCF8575, I2C_PRIO_INPUT, pcf_read_job, &pins)) return false;
 
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
     // Debug: log raw pin state every 2 seconds
     static uint32_t dbg_timer = 0;
     if (millis() - dbg_timer >= 2000) {
         dbg_timer = millis();
-        Serial.printf("[hw_input] raw pins=0x%04X\n", pins);
+        LOG_D("[hw_input] raw pins=0x%04X\n", pins);
+    }
+#endif
+
+    if (replay_running()) return false;   // Replayed pins come in through hw_input_inject()
+
+    bool changed = pins != last_sampled;
+    last_sampled = pins;
+    if (changed && replay_recording()) replay_record_pins(pins);
+    // Held buttons keep sampling through so the 4-button reboot hold can time out
+    if (changed || pins != 0xFFFF) {
+        PinSample smp = { pins, millis() };
+        if (xQueueSend(sample_queue, &smp, 0) != pdTRUE) {
+            if (++samples_dropped % 16 == 1) {
+                LOG_W("[hw_input] sample queue full (%lu dropped)\n", (unsigned long)samples_dropped);
+            }
+        }
+        events_post(EVT_HW_DATA);
     }
+    return changed;
+}
+
+void hw_input_inject(uint16_t pins) {
+    if (!sample_queue) return;
+    PinSample smp = { pins, millis() };
+    if (xQueueSend(sample_queue, &smp, 0) != pdTRUE) samples_dropped++;
+    events_post(EVT_HW_DATA);
+}
 
+// ============================================================
+// process_pins() -- UI task: debounce, decode and dispatch one sample
+// ============================================================
+static void process_pins(uint16_t pins, uint32_t now) {
     // --- All-4-buttons held reboot check ---
     bool all_four = !(pins & PIN_BTN1) && !(pins & PIN_BTN2) &&
-                    !(pins & PIN_BTN3) && !(pins & PIN_BTN4);
+                    !(pins & PIN_BTN3) && !(pins & PIN_BTN4) && !replay_running();
     if (all_four) {
         if (!all_btn_held) {
             all_btn_held = true;
-            all_btn_hold_start = millis();
+            all_btn_hold_start = now;
             Serial.println("[hw_input] All 4 buttons held — hold 5s to reboot");
-        } else if (millis() - all_btn_hold_start >= REBOOT_HOLD_MS) {
+        } else if (now - all_btn_hold_start >= REBOOT_HOLD_MS) {
             Serial.println("[hw_input] REBOOT triggered by 4-button hold");
+            runtime_state_flush();
+            stats_log_flush();
             delay(100);
             ESP.restart();
         }
@@ -335,9 +403,9 @@ void hw_input_poll() {
         all_btn_held = false;
     }
 
-    if (pins == 0xFFFF && prev_pin_state == 0xFFFF) return; // No change, all high
+    bool changed = pins != prev_pin_state;
+    if (pins == 0xFFFF && !changed) return; // No change, all high
 
-    uint32_t now = millis();
     const AppConfig &cfg = get_global_config();
 
     // --- Debounce and dispatch 4 hardware buttons ---
@@ -351,9 +419,9 @@ void hw_input_poll() {
                 if (pressed) {
                     // Press edge - dispatch action
                     const HwButtonConfig &bc = cfg.hw_buttons[i];
-                    Serial.printf("[hw_input] Button %d pressed (action=%d)\n", i + 1, bc.action_type);
-                    dispatch_action(bc.action_type, bc.keycode, bc.consumer_code,
-                                    bc.modifiers, i);
+                    trace(TR_HW_BUTTON, i, bc.action_type);
+                    LOG_D("[hw_input] Button %d pressed (action=%d)\n", i + 1, bc.action_type);
+                    action_run(action_from_hw(bc, (uint8_t)i));
                 }
             }
         }
@@ -372,54 +440,90 @@ void hw_input_poll() {
                         hw_input_activate_focus();
                     } else {
                         // Normal push action
-                        Serial.printf("[hw_input] Encoder push (action=%d)\n", cfg.encoder.push_action);
-                        dispatch_action(cfg.encoder.push_action, cfg.encoder.push_keycode,
-                                        cfg.encoder.push_consumer_code, cfg.encoder.push_modifiers, 0xFF);
+                        trace(TR_HW_BUTTON, 4, cfg.encoder.push_action);
+                        LOG_D("[hw_input] Encoder push (action=%d)\n", cfg.encoder.push_action);
+                        action_run(action_simple(cfg.encoder.push_action, cfg.encoder.push_keycode,
+                                                 cfg.encoder.push_consumer_code, cfg.encoder.push_modifiers));
                     }
                 }
             }
         }
     }
 
-    // --- Quadrature encoder rotation ---
-    int8_t rot = decode_encoder(pins);
+    // --- Quadrature encoder rotation (unless the PCNT unit decodes it) ---
+    int8_t rot = rotary_encoder_active() ? 0 : decode_encoder(pins);
     if (rot != 0) {
-        Serial.printf("[hw_input] Encoder rotation: %s\n", rot > 0 ? "CW" : "CCW");
-        dispatch_encoder_rotation(rot);
+        uint8_t accel = encoder_accel(now);
+        LOG_D("[hw_input] Encoder rotation: %s x%d\n", rot > 0 ? "CW" : "CCW", accel);
+        dispatch_encoder_rotation(rot, accel);
     }
 
     prev_pin_state = pins;
 }
 
+// ============================================================
+// hw_input_process() -- UI task
+// ============================================================
+uint32_t hw_input_process() {
+    if (!pcf_available && !rotary_encoder_active()) return UINT32_MAX;
+
+    if (rotary_encoder_active()) process_pcnt_detents();
+
+    // Coalesced rotation is due even if the pins haven't moved since
+    if (enc_pending_steps != 0 && millis() - enc_pending_since >= ENCODER_COALESCE_MS) {
+        flush_encoder_steps();
+    }
+
+    PinSample smp;
+    while (sample_queue && xQueueReceive(sample_queue, &smp, 0) == pdTRUE) {
+        process_pins(smp.pins, smp.ms);
+    }
+
+    if (enc_pending_steps == 0) return UINT32_MAX;
+    uint32_t age = millis() - enc_pending_since;
+    return age >= ENCODER_COALESCE_MS ? 0 : ENCODER_COALESCE_MS - age;
+}
+
 // ============================================================
 // App-select focus management
 // ============================================================
-void hw_input_focus_next() {
-    int page = ui_get_current_page();
+// Highlight widget idx of the current page (caller cleared the old focus)
+static void set_focus(int page, int idx) {
+    focused_widget_idx = idx;
+    runtime_state_set_focus((int8_t)idx);
+    lv_obj_t *obj = ui_get_widget_obj(page, idx);
+    if (obj) {
+        // Save current opacity, then increase by ~20%
+        focus_prev_opa = lv_obj_get_style_bg_opa(obj, LV_PART_MAIN);
+        lv_opa_t new_opa = (focus_prev_opa <= (LV_OPA_COVER - 50)) ? (focus_prev_opa + 50) : LV_OPA_COVER;
+        lv_obj_set_style_bg_opa(obj, new_opa, LV_PART_MAIN);
+        focus_highlight_obj = obj;
+    }
+}
+
+// Widgets of the current page, or nullptr
+static const std::vector<WidgetConfig> *focus_widgets(int page) {
     const AppConfig &cfg = get_global_config();
     const ProfileConfig *profile = cfg.get_active_profile();
-    if (!profile || page >= (int)profile->pages.size()) return;
+    if (!profile || page >= (int)profile->pages.size()) return nullptr;
+    return &profile->pages[page].widgets;
+}
 
-    const auto &widgets = profile->pages[page].widgets;
-    int widget_count = (int)widgets.size();
+void hw_input_focus_next() {
+    int page = ui_get_current_page();
+    const auto *widgets = focus_widgets(page);
+    if (!widgets) return;
+    int widget_count = (int)widgets->size();
     if (widget_count <= 0) return;
 
+    int start = focused_widget_idx;   // Before clearing resets it
     hw_input_clear_focus();
 
     // Scan forward for next actionable widget (hotkey button)
-    int start = focused_widget_idx;
     for (int i = 0; i < widget_count; i++) {
         int idx = (start + 1 + i) % widget_count;
-        if (widgets[idx].widget_type == WIDGET_HOTKEY_BUTTON) {
-            focused_widget_idx = idx;
-            lv_obj_t *obj = ui_get_widget_obj(page, idx);
-            if (obj) {
-                // Save current opacity, then increase by ~20%
-                focus_prev_opa = lv_obj_get_style_bg_opa(obj, LV_PART_MAIN);
-                lv_opa_t new_opa = (focus_prev_opa <= (LV_OPA_COVER - 50)) ? (focus_prev_opa + 50) : LV_OPA_COVER;
-                lv_obj_set_style_bg_opa(obj, new_opa, LV_PART_MAIN);
-                focus_highlight_obj = obj;
-            }
+        if ((*widgets)[idx].widget_type == WIDGET_HOTKEY_BUTTON) {
+            set_focus(page, idx);
             return;
         }
     }
@@ -427,51 +531,38 @@ void hw_input_focus_next() {
 
 void hw_input_focus_prev() {
     int page = ui_get_current_page();
-    const AppConfig &cfg = get_global_config();
-    const ProfileConfig *profile = cfg.get_active_profile();
-    if (!profile || page >= (int)profile->pages.size()) return;
-
-    const auto &widgets = profile->pages[page].widgets;
-    int widget_count = (int)widgets.size();
+    const auto *widgets = focus_widgets(page);
+    if (!widgets) return;
+    int widget_count = (int)widgets->size();
     if (widget_count <= 0) return;
 
+    int start = focused_widget_idx <= 0 ? widget_count : focused_widget_idx;
     hw_input_clear_focus();
 
     // Scan backward for previous actionable widget (hotkey button)
-    int start = focused_widget_idx <= 0 ? widget_count : focused_widget_idx;
     for (int i = 0; i < widget_count; i++) {
         int idx = (start - 1 - i + widget_count) % widget_count;
-        if (widgets[idx].widget_type == WIDGET_HOTKEY_BUTTON) {
-            focused_widget_idx = idx;
-            lv_obj_t *obj = ui_get_widget_obj(page, idx);
-            if (obj) {
-                focus_prev_opa = lv_obj_get_style_bg_opa(obj, LV_PART_MAIN);
-                lv_opa_t new_opa = (focus_prev_opa <= (LV_OPA_COVER - 50)) ? (focus_prev_opa + 50) : LV_OPA_COVER;
-                lv_obj_set_style_bg_opa(obj, new_opa, LV_PART_MAIN);
-                focus_highlight_obj = obj;
-            }
+        if ((*widgets)[idx].widget_type == WIDGET_HOTKEY_BUTTON) {
+            set_focus(page, idx);
             return;
         }
     }
 }
 
-void hw_input_activate_focus() {
-    if (focused_widget_idx < 0) return;
-
+void hw_input_restore_focus(int idx) {
     int page = ui_get_current_page();
-    const AppConfig &cfg = get_global_config();
-    const ProfileConfig *profile = cfg.get_active_profile();
-    if (!profile || page >= (int)profile->pages.size()) return;
+    const auto *widgets = focus_widgets(page);
+    if (!widgets || idx < 0 || idx >= (int)widgets->size()) return;
+    if ((*widgets)[idx].widget_type != WIDGET_HOTKEY_BUTTON) return;
+    hw_input_clear_focus();
+    set_focus(page, idx);
+}
 
-    const std::vector<WidgetConfig> &widgets = profile->pages[page].widgets;
-    if (focused_widget_idx >= (int)widgets.size()) return;
+void hw_input_activate_focus() {
+    if (focused_widget_idx < 0) return;
 
-    const WidgetConfig &w = widgets[focused_widget_idx];
-    if (w.widget_type == WIDGET_HOTKEY_BUTTON) {
-        Serial.printf("[hw_input] Activating focused widget %d (action=%d)\n",
-                      focused_widget_idx, w.action_type);
-        dispatch_action(w.action_type, w.keycode, w.consumer_code, w.modifiers, focused_widget_idx);
-    }
+    LOG_D("[hw_input] Activating focused widget %d\n", focused_widget_idx);
+    ui_run_widget_action(ui_get_current_page(), focused_widget_idx);
 }
 
 void hw_input_clear_focus() {
@@ -481,4 +572,5 @@ void hw_input_clear_focus() {
         focus_prev_opa = LV_OPA_TRANSP;
     }
     focused_widget_idx = -1;
+    runtime_state_set_focus(-1);
 }
@@ -1,20 +1,42 @@
 #pragma once
 #include <stdint.h>
 
+// GPIO wired to the PCF8575 /INT output, or -1 to poll on a timer.
+#ifndef HW_INPUT_INT_GPIO
+#define HW_INPUT_INT_GPIO -1
+#endif
+
 // Initialize PCF8575 hardware input: scan TCA9548A channel 0 for PCF8575 at 0x20-0x27
 // Returns true if PCF8575 found, false if not (hardware buttons disabled gracefully)
 bool hw_input_init();
 
-// Poll hardware buttons and encoder. Call every 50ms from loop().
-// Reads PCF8575 via I2C mux, debounces buttons, decodes encoder quadrature.
-// Dispatches configured actions for button presses and encoder events.
-void hw_input_poll();
+// Input task: read the PCF8575 via the I2C mux. Call on PCF8575 INT and on
+// the poll timer. Changed (or held) pin states are queued for the UI task
+// and EVT_HW_DATA is posted. Returns true if the pins changed, so the
+// caller can keep polling fast until input settles.
+bool hw_input_sample();
+
+// UI task: drain queued samples -- debounce buttons, decode encoder
+// quadrature (or take the PCNT unit's detents, rotary_encoder.h),
+// dispatch configured actions; volume/DDC rotation is
+// accelerated and coalesced into one message. Returns the ms until it
+// must run again to flush coalesced rotation (UINT32_MAX if nothing pending).
+uint32_t hw_input_process();
+
+// Input replay: queue a pin state as if sampled now (UI task). Real
+// samples are dropped while replay_running(). No-op without a PCF8575.
+void hw_input_inject(uint16_t pins);
 
 // Check if PCF8575 was detected at init
 bool hw_input_available();
 
+// Run a display-local/HID action outside the button table (touch gestures).
+// PC-side, DDC and macro actions need a hardware button slot and are ignored.
+void hw_input_run_action(uint8_t action, uint8_t keycode, uint16_t consumer_code, uint8_t modifiers);
+
 // Focus management for app-select encoder mode
 void hw_input_focus_next();    // Highlight next widget on current page
 void hw_input_focus_prev();    // Highlight previous widget
 void hw_input_activate_focus(); // Fire the focused widget's action
 void hw_input_clear_focus();   // Remove focus highlight (call on page change)
+void hw_input_restore_focus(int idx); // Focus widget idx of the current page if it is a hotkey button
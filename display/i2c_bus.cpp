@@ -0,0 +1,218 @@
+/**
+ * @file i2c_bus.cpp
+ * One task owns the I2C bus and runs client jobs by priority
+ *
+ * Each priority level has its own queue; a counting semaphore holds the
+ * number of queued jobs across all of them, so the task wakes once per job
+ * and always takes from the most urgent non-empty queue. The bus lock is
+ * still taken around every job, so inline jobs (setup, or a job started
+ * from a completion callback) can't interleave with the task's own.
+ */
+
+#include "i2c_bus.h"
+#include <Arduino.h>
+#include <Wire.h>
+#include <algorithm>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#define I2C_TASK_STACK 4096   // The fuel gauge library runs in jobs
+
+struct I2cJob {
+    I2cJobFn fn;
+    void *arg;
+    I2cDoneFn done;
+    SemaphoreHandle_t waiter;   // i2c_run(): given when finished
+    bool *result;
+    uint32_t queued_us;
+    uint8_t dev;
+};
+
+struct DevCounters {
+    uint32_t jobs, errors, dropped;
+    uint64_t wait_total_us, busy_total_us;
+    uint32_t wait_max_us, busy_max_us;
+};
+
+static const char *const DEV_NAMES[I2C_DEV_COUNT] = { "gt911", "pcf8575", "max17048", "pca9557" };
+
+static SemaphoreHandle_t bus_mutex = nullptr;
+static SemaphoreHandle_t pending = nullptr;   // Counting: jobs queued over all levels
+static QueueHandle_t queues[I2C_PRIO_COUNT] = {};
+static TaskHandle_t bus_task = nullptr;
+
+static DevCounters counters[I2C_DEV_COUNT];
+static portMUX_TYPE stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void i2c_bus_init() {
+    if (!bus_mutex) bus_mutex = xSemaphoreCreateMutex();
+    configASSERT(bus_mutex != NULL);
+    Wire.setClock(I2C_BUS_HZ);
+    Wire.setTimeOut(I2C_TIMEOUT_MS);
+    Serial.printf("[i2c] bus at %lu Hz, %d ms timeout\n", (unsigned long)I2C_BUS_HZ, I2C_TIMEOUT_MS);
+}
+
+// ============================================================
+// Running jobs
+// ============================================================
+static bool execute(const I2cJob &job) {
+    uint32_t start = micros();
+    xSemaphoreTake(bus_mutex, portMAX_DELAY);
+    bool ok = job.fn(job.arg);
+    xSemaphoreGive(bus_mutex);
+    uint32_t end = micros();
+
+    uint32_t wait = start - job.queued_us, busy = end - start;
+    portENTER_CRITICAL(&stats_mux);
+    DevCounters &c = counters[job.dev];
+    c.jobs++;
+    if (!ok) c.errors++;
+    c.wait_total_us += wait;
+    c.busy_total_us += busy;
+    if (wait > c.wait_max_us) c.wait_max_us = wait;
+    if (busy > c.busy_max_us) c.busy_max_us = busy;
+    portEXIT_CRITICAL(&stats_mux);
+    return ok;
+}
+
+static void bus_task_fn(void *) {
+    for (;;) {
+        xSemaphoreTake(pending, portMAX_DELAY);
+        I2cJob job;
+        bool got = false;
+        for (int p = 0; p < I2C_PRIO_COUNT && !got; p++) got = xQueueReceive(queues[p], &job, 0) == pdTRUE;
+        if (!got) continue;
+
+        bool ok = execute(job);
+        if (job.waiter) {
+            *job.result = ok;
+            xSemaphoreGive(job.waiter);
+        } else if (job.done) {
+            job.done(job.arg, ok);
+        }
+    }
+}
+
+void i2c_bus_start() {
+    if (bus_task) return;
+    for (auto &q : queues) q = xQueueCreate(I2C_QUEUE_LEN, sizeof(I2cJob));
+    pending = xSemaphoreCreateCounting(I2C_QUEUE_LEN * I2C_PRIO_COUNT, 0);
+    xTaskCreatePinnedToCore(bus_task_fn, "i2c", I2C_TASK_STACK, nullptr,
+                            I2C_TASK_PRIORITY, &bus_task, I2C_TASK_CORE);
+}
+
+static bool enqueue(const I2cJob &job, I2cPriority prio) {
+    if (xQueueSend(queues[prio], &job, 0) != pdTRUE) {
+        portENTER_CRITICAL(&stats_mux);
+        counters[job.dev].dropped++;
+        portEXIT_CRITICAL(&stats_mux);
+        return false;
+    }
+    xSemaphoreGive(pending);
+    return true;
+}
+
+// ============================================================
+// Clients
+// ============================================================
+bool i2c_run(I2cDevice dev, I2cPriority prio, I2cJobFn fn, void *arg) {
+    I2cJob job = { fn, arg, nullptr, nullptr, nullptr, micros(), dev };
+    if (!bus_task || xTaskGetCurrentTaskHandle() == bus_task) return execute(job);
+
+    StaticSemaphore_t sem_buf;
+    bool result = false;
+    job.waiter = xSemaphoreCreateBinaryStatic(&sem_buf);
+    job.result = &result;
+    bool queued = enqueue(job, prio);
+    // No timeout: the job still points at this frame, and Wire's timeout
+    // bounds it anyway
+    if (queued) xSemaphoreTake(job.waiter, portMAX_DELAY);
+    vSemaphoreDelete(job.waiter);
+    return queued && result;
+}
+
+bool i2c_submit(I2cDevice dev, I2cPriority prio, I2cJobFn fn, void *arg, I2cDoneFn done) {
+    I2cJob job = { fn, arg, done, nullptr, nullptr, micros(), dev };
+    if (!bus_task) {
+        bool ok = execute(job);
+        if (done) done(arg, ok);
+        return true;
+    }
+    return enqueue(job, prio);
+}
+
+// ============================================================
+// Benchmark
+// ============================================================
+struct Probe {
+    I2cJobFn fn;
+    void *arg;
+};
+static Probe probes[I2C_DEV_COUNT] = {};
+
+struct ProbeRun {
+    const Probe *probe;
+    uint32_t busy_us;
+};
+
+static bool probe_job(void *arg) {
+    ProbeRun *run = (ProbeRun *)arg;
+    uint32_t t0 = micros();
+    bool ok = run->probe->fn(run->probe->arg);
+    run->busy_us = micros() - t0;
+    return ok;
+}
+
+void i2c_register_probe(I2cDevice dev, I2cJobFn fn, void *arg) {
+    probes[dev] = { fn, arg };
+}
+
+static uint32_t percentile(uint32_t *v, uint16_t n, int pct) {
+    if (n == 0) return 0;
+    return v[(uint32_t)(n - 1) * pct / 100];
+}
+
+bool i2c_bench(I2cDevice dev, uint16_t runs, I2cBenchResult *out) {
+    *out = {};
+    out->name = DEV_NAMES[dev];
+    if (!probes[dev].fn) return false;
+    out->present = true;
+    if (runs > I2C_BENCH_MAX_RUNS) runs = I2C_BENCH_MAX_RUNS;
+
+    uint32_t busy[I2C_BENCH_MAX_RUNS], total[I2C_BENCH_MAX_RUNS];
+    uint16_t n = 0;
+    for (uint16_t i = 0; i < runs; i++) {
+        ProbeRun run = { &probes[dev], 0 };
+        uint32_t t0 = micros();
+        if (!i2c_run(dev, I2C_PRIO_BACKGROUND, probe_job, &run)) {
+            out->errors++;
+            continue;
+        }
+        total[n] = micros() - t0;
+        busy[n++] = run.busy_us;
+    }
+    std::sort(busy, busy + n);
+    std::sort(total, total + n);
+    out->runs = n;
+    out->busy_p50_us = percentile(busy, n, 50);
+    out->busy_p99_us = percentile(busy, n, 99);
+    out->total_p50_us = percentile(total, n, 50);
+    out->total_p99_us = percentile(total, n, 99);
+    return true;
+}
+
+void i2c_get_stats(I2cDevice dev, I2cDevStats *out) {
+    portENTER_CRITICAL(&stats_mux);
+    DevCounters c = counters[dev];
+    portEXIT_CRITICAL(&stats_mux);
+    out->name = DEV_NAMES[dev];
+    out->jobs = c.jobs;
+    out->errors = c.errors;
+    out->dropped = c.dropped;
+    out->wait_avg_us = c.jobs ? (uint32_t)(c.wait_total_us / c.jobs) : 0;
+    out->wait_max_us = c.wait_max_us;
+    out->busy_avg_us = c.jobs ? (uint32_t)(c.busy_total_us / c.jobs) : 0;
+    out->busy_max_us = c.busy_max_us;
+}
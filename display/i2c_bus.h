@@ -0,0 +1,109 @@
+#pragma once
+#include <stdint.h>
+
+// ============================================================
+// I2C bus scheduler
+//
+// GT911 touch, the PCF8575 behind the TCA9548A mux, the MAX17048 fuel
+// gauge and the PCA9557 share one bus (Wire, SDA 19 / SCL 20). Once
+// i2c_bus_start() has run, the "i2c" task owns it and runs queued jobs,
+// highest priority first: a touch read waits for at most the transaction
+// in progress, never behind gauge or button reads. A job is a function doing
+// its Wire transactions with the bus held. Clients either wait for it
+// (i2c_run) or get a completion callback on the bus task (i2c_submit).
+// Before the task starts (setup) jobs run inline on the caller.
+//
+// The bus stays on Wire rather than the IDF i2c_master driver: the gauge
+// and PCA9557 libraries talk through Wire, and the IDF aborts when both
+// drivers claim one port. Wire's timeout bounds every job.
+// ============================================================
+
+#ifndef I2C_BUS_HZ
+#define I2C_BUS_HZ 400000       // Every device on the bus is rated for fast mode
+#endif
+#ifndef I2C_TIMEOUT_MS
+#define I2C_TIMEOUT_MS 20       // Per Wire transaction (a stuck device costs at most this)
+#endif
+#ifndef I2C_TASK_CORE
+#define I2C_TASK_CORE 0
+#endif
+#ifndef I2C_TASK_PRIORITY
+#define I2C_TASK_PRIORITY 5     // Above the input task, which waits on touch reads
+#endif
+#define I2C_QUEUE_LEN 8         // Jobs per priority level
+
+enum I2cPriority : uint8_t {
+    I2C_PRIO_TOUCH,             // GT911 reads
+    I2C_PRIO_INPUT,             // Buttons / encoder
+    I2C_PRIO_BACKGROUND,        // Fuel gauge, probes
+    I2C_PRIO_COUNT
+};
+
+// Per-device accounting, not addressing (jobs do their own)
+enum I2cDevice : uint8_t {
+    I2C_DEV_GT911,
+    I2C_DEV_PCF8575,            // Including the TCA9548A channel select around it
+    I2C_DEV_MAX17048,
+    I2C_DEV_PCA9557,
+    I2C_DEV_COUNT
+};
+
+// Runs with the bus held (on the bus task, or inline before it starts).
+// Return false on a bus error; it is counted against the device.
+typedef bool (*I2cJobFn)(void *arg);
+// Completion of an i2c_submit() job, on the bus task: keep it short, hand
+// real work to the UI with ui_post()
+typedef void (*I2cDoneFn)(void *arg, bool ok);
+
+struct I2cDevStats {
+    const char *name;
+    uint32_t jobs;
+    uint32_t errors;            // Job returned false
+    uint32_t dropped;           // Queue full at submit
+    uint32_t wait_avg_us;       // Submit to start
+    uint32_t wait_max_us;
+    uint32_t busy_avg_us;       // Job run time
+    uint32_t busy_max_us;
+};
+
+void i2c_bus_init();            // After Wire.begin(): bus lock, clock, timeout
+void i2c_bus_start();           // Start the bus task (tasks_start())
+
+// Queue `job` and wait for it. Returns its result (false also when the
+// queue was full). Called on the bus task itself, it runs inline; never
+// call it from inside a job.
+bool i2c_run(I2cDevice dev, I2cPriority prio, I2cJobFn job, void *arg = nullptr);
+
+// Queue `job` without waiting; `done` (optional) gets its result. `arg`
+// must stay valid until then. False if the queue is full.
+bool i2c_submit(I2cDevice dev, I2cPriority prio, I2cJobFn job, void *arg = nullptr,
+                I2cDoneFn done = nullptr);
+
+void i2c_get_stats(I2cDevice dev, I2cDevStats *out);
+
+// ------------------------------------------------------------
+// Benchmark (POST /api/bench)
+//
+// Each driver registers one representative transaction of its device once
+// it has found it (a register read, or an address ACK where reads have
+// side effects). i2c_bench() runs it `runs` times at background priority:
+// busy is the transaction itself, total the i2c_run() round trip from the
+// caller, queueing behind touch reads and task switches included.
+// ------------------------------------------------------------
+#define I2C_BENCH_MAX_RUNS 100
+
+void i2c_register_probe(I2cDevice dev, I2cJobFn fn, void *arg = nullptr);
+
+struct I2cBenchResult {
+    const char *name;
+    bool present;               // A probe is registered
+    uint16_t runs;
+    uint16_t errors;
+    uint32_t busy_p50_us;
+    uint32_t busy_p99_us;
+    uint32_t total_p50_us;
+    uint32_t total_p99_us;
+};
+
+// Any task but the bus task. False (out->present false) without a probe.
+bool i2c_bench(I2cDevice dev, uint16_t runs, I2cBenchResult *out);
@@ -0,0 +1,366 @@
+/**
+ * @file icon_cache.cpp
+ * Pre-scaled RGB565+alpha icon cache (PSRAM LRU backed by .bin files on SD)
+ *
+ * A miss first looks for "<ICON_CACHE_DIR>/<path hash>_<src size>_<w>x<h>.bin"
+ * (LVGL's raw image format: lv_img_header_t + pixels). Only when that is
+ * missing is the source decoded: PNGs stream through png_stream straight
+ * into the fit size, anything else (or an interlaced PNG) goes through
+ * LVGL's decoder and is box-filtered down. Either way the result is written
+ * back. The source size in the name catches files replaced without
+ * icon_cache_invalidate().
+ *
+ * Sources that are already .bin (the companion renders icons straight to
+ * RGB565+alpha) skip both: they are read as-is and only resampled when the
+ * widget lays them out at another size.
+ */
+
+#include "icon_cache.h"
+#include "sdcard.h"
+#include "mem_budget.h"
+#include "png_stream.h"
+#include "tasks.h"
+#include <Arduino.h>
+#include <SD.h>
+#include <string>
+#include <vector>
+#include <string.h>
+
+#define ICON_CACHE_SLOTS 64
+#define ICON_PX_BYTES    LV_IMG_PX_SIZE_ALPHA_BYTE   // 3 at 16-bit colour
+
+struct IconEntry {
+    std::string path;
+    uint16_t fit_w, fit_h;
+    uint8_t *buf;            // lv_img_header_t + pixels, so .bin I/O is one read/write
+    lv_img_dsc_t dsc;        // data points into buf
+    uint16_t refs;           // Live lv_img objects showing it
+    bool stale;              // Source replaced while pinned: free on last release
+    uint32_t last_used;
+};
+
+static IconEntry entries[ICON_CACHE_SLOTS];
+static uint32_t cache_bytes = 0;
+static uint32_t use_clock = 0;
+static bool dir_ready = false;
+
+static uint32_t path_hash(const char *path) {
+    uint32_t h = 2166136261u;  // FNV-1a
+    for (; *path; path++) h = (h ^ (uint8_t)*path) * 16777619u;
+    return h;
+}
+
+static void entry_free(IconEntry &e) {
+    // LVGL's image cache is keyed by source pointer and the slot is reused
+    lv_img_cache_invalidate_src(&e.dsc);
+    cache_bytes -= e.dsc.data_size;
+    mem_free(MEM_POOL_IMAGES, e.buf);
+    e = IconEntry();
+}
+
+static IconEntry *lru_victim() {
+    IconEntry *victim = nullptr;
+    for (auto &e : entries) {
+        if (!e.buf || e.refs) continue;
+        if (!victim || e.last_used < victim->last_used) victim = &e;
+    }
+    return victim;
+}
+
+// Free unpinned entries, least recently used first, until `need` more fits
+static void make_room(uint32_t need) {
+    while (cache_bytes + need > ICON_CACHE_BYTES) {
+        IconEntry *victim = lru_victim();
+        if (!victim) return;
+        entry_free(*victim);
+    }
+}
+
+// Images pool evictor (any task): same LRU order, under the UI lock
+static size_t trim(size_t want) {
+    size_t freed = 0;
+    ui_lock();
+    while (freed < want) {
+        IconEntry *victim = lru_victim();
+        if (!victim) break;
+        freed += sizeof(lv_img_header_t) + victim->dsc.data_size;
+        entry_free(*victim);
+    }
+    ui_unlock();
+    return freed;
+}
+
+static IconEntry *free_slot() {
+    for (auto &e : entries) {
+        if (!e.buf) return &e;
+    }
+    make_room(ICON_CACHE_BYTES);  // Table full: drop every unpinned entry
+    for (auto &e : entries) {
+        if (!e.buf) return &e;
+    }
+    return nullptr;
+}
+
+static uint8_t *alloc_image(uint16_t w, uint16_t h) {
+    size_t bytes = sizeof(lv_img_header_t) + (size_t)w * h * ICON_PX_BYTES;
+    static bool evictor_added = false;
+    if (!evictor_added) {
+        mem_add_evictor(MEM_POOL_IMAGES, trim);
+        evictor_added = true;
+    }
+    make_room(bytes);
+    uint8_t *buf = (uint8_t *)mem_alloc(MEM_POOL_IMAGES, bytes);
+    if (buf) {
+        lv_img_header_t hdr = {};
+        hdr.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+        hdr.w = w;
+        hdr.h = h;
+        memcpy(buf, &hdr, sizeof(hdr));
+    }
+    return buf;
+}
+
+// Scaled size that fits the box (same rounding as the old lv_img_set_zoom path)
+void icon_fit_size(uint32_t sw, uint32_t sh, uint16_t max_w, uint16_t max_h, uint16_t *w, uint16_t *h) {
+    if (sw * max_h <= sh * max_w) {
+        *h = max_h;
+        *w = (uint16_t)(sw * max_h / sh);
+    } else {
+        *w = max_w;
+        *h = (uint16_t)(sh * max_w / sw);
+    }
+    if (*w == 0) *w = 1;
+    if (*h == 0) *h = 1;
+}
+
+// Area-average resample into RGB565+A. Colour is alpha-weighted so
+// transparent pixels don't bleed dark fringes into the edges.
+void icon_resample(const uint8_t *src, uint16_t sw, uint16_t sh, bool src_alpha,
+                   uint8_t *dst, uint16_t dw, uint16_t dh) {
+    const uint8_t sbpp = src_alpha ? LV_IMG_PX_SIZE_ALPHA_BYTE : sizeof(lv_color_t);
+    for (uint16_t dy = 0; dy < dh; dy++) {
+        uint32_t y0 = (uint32_t)dy * sh / dh;
+        uint32_t y1 = (uint32_t)(dy + 1) * sh / dh;
+        if (y1 <= y0) y1 = y0 + 1;
+        for (uint16_t dx = 0; dx < dw; dx++) {
+            uint32_t x0 = (uint32_t)dx * sw / dw;
+            uint32_t x1 = (uint32_t)(dx + 1) * sw / dw;
+            if (x1 <= x0) x1 = x0 + 1;
+
+            uint32_t n = 0, sa = 0, sr = 0, sg = 0, sb = 0;
+            for (uint32_t y = y0; y < y1; y++) {
+                const uint8_t *p = src + ((size_t)y * sw + x0) * sbpp;
+                for (uint32_t x = x0; x < x1; x++, p += sbpp) {
+                    uint16_t c = p[0] | (p[1] << 8);
+                    uint32_t a = src_alpha ? p[2] : 255;
+                    sr += ((c >> 11) & 0x1F) * a;
+                    sg += ((c >> 5) & 0x3F) * a;
+                    sb += (c & 0x1F) * a;
+                    sa += a;
+                    n++;
+                }
+            }
+            uint16_t c = 0;
+            if (sa) c = (uint16_t)(((sr / sa) << 11) | ((sg / sa) << 5) | (sb / sa));
+            uint8_t *o = dst + ((size_t)dy * dw + dx) * ICON_PX_BYTES;
+            o[0] = c & 0xFF;
+            o[1] = c >> 8;
+            o[2] = (uint8_t)(sa / n);
+        }
+    }
+}
+
+static std::string bin_path(const char *path, uint32_t src_size, uint16_t fit_w, uint16_t fit_h) {
+    char name[64];
+    snprintf(name, sizeof(name), ICON_CACHE_DIR "/%08lx_%lx_%ux%u.bin",
+             (unsigned long)path_hash(path), (unsigned long)src_size, fit_w, fit_h);
+    return name;
+}
+
+static uint8_t *load_bin(const std::string &bin, uint16_t fit_w, uint16_t fit_h) {
+    File f = SD.open(bin.c_str(), FILE_READ);
+    if (!f) return nullptr;
+    lv_img_header_t hdr;
+    uint8_t *buf = nullptr;
+    if (f.read((uint8_t *)&hdr, sizeof(hdr)) == sizeof(hdr) &&
+        hdr.cf == LV_IMG_CF_TRUE_COLOR_ALPHA && hdr.w && hdr.h && hdr.w <= fit_w && hdr.h <= fit_h &&
+        f.size() == sizeof(hdr) + (size_t)hdr.w * hdr.h * ICON_PX_BYTES) {
+        buf = alloc_image(hdr.w, hdr.h);
+        size_t px_bytes = (size_t)hdr.w * hdr.h * ICON_PX_BYTES;
+        if (buf && f.read(buf + sizeof(hdr), px_bytes) != px_bytes) {
+            mem_free(MEM_POOL_IMAGES, buf);
+            buf = nullptr;
+        }
+    }
+    f.close();
+    return buf;
+}
+
+// Line by line into the fit size: no full-size frame is ever held
+static uint8_t *decode_png(const std::string &src, uint16_t fit_w, uint16_t fit_h) {
+    uint32_t sw, sh;
+    if (!png_stream_info(src.c_str(), &sw, &sh)) return nullptr;
+    uint16_t w, h;
+    icon_fit_size(sw, sh, fit_w, fit_h, &w, &h);
+    uint8_t *buf = alloc_image(w, h);
+    if (buf && !png_stream_decode(src.c_str(), buf + sizeof(lv_img_header_t), w, h)) {
+        mem_free(MEM_POOL_IMAGES, buf);
+        buf = nullptr;
+    }
+    return buf;
+}
+
+static uint8_t *decode_source(const char *path, uint16_t fit_w, uint16_t fit_h) {
+    std::string src = std::string("S:") + path;
+    uint8_t *png = decode_png(src, fit_w, fit_h);
+    if (png) return png;
+
+    lv_img_decoder_dsc_t dec;
+    if (lv_img_decoder_open(&dec, src.c_str(), lv_color_white(), 0) != LV_RES_OK) return nullptr;
+
+    uint8_t *buf = nullptr;
+    bool alpha = dec.header.cf == LV_IMG_CF_TRUE_COLOR_ALPHA;
+    if (dec.img_data && (alpha || dec.header.cf == LV_IMG_CF_TRUE_COLOR) && dec.header.w && dec.header.h) {
+        uint16_t w, h;
+        icon_fit_size(dec.header.w, dec.header.h, fit_w, fit_h, &w, &h);
+        buf = alloc_image(w, h);
+        if (buf) icon_resample(dec.img_data, dec.header.w, dec.header.h, alpha, buf + sizeof(lv_img_header_t), w, h);
+    } else {
+        Serial.printf("[icons] %s: decoder gave cf %d without a frame buffer\n", path, dec.header.cf);
+    }
+    lv_img_decoder_close(&dec);
+    return buf;
+}
+
+static bool is_raw_source(const char *path) {
+    size_t n = strlen(path);
+    return n > 4 && strcasecmp(path + n - 4, ".bin") == 0;
+}
+
+static uint8_t *load_raw_source(const char *path, uint16_t fit_w, uint16_t fit_h) {
+    File f = SD.open(path, FILE_READ);
+    if (!f) return nullptr;
+    lv_img_header_t hdr;
+    uint8_t *buf = nullptr;
+    if (f.read((uint8_t *)&hdr, sizeof(hdr)) == sizeof(hdr) &&
+        hdr.cf == LV_IMG_CF_TRUE_COLOR_ALPHA && hdr.w && hdr.h &&
+        f.size() == sizeof(hdr) + (size_t)hdr.w * hdr.h * ICON_PX_BYTES) {
+        size_t px_bytes = (size_t)hdr.w * hdr.h * ICON_PX_BYTES;
+        uint8_t *src = (uint8_t *)mem_alloc(MEM_POOL_IMAGES, px_bytes);
+        if (src && f.read(src, px_bytes) == px_bytes) {
+            uint16_t w, h;
+            icon_fit_size(hdr.w, hdr.h, fit_w, fit_h, &w, &h);
+            buf = alloc_image(w, h);
+            if (buf) icon_resample(src, hdr.w, hdr.h, true, buf + sizeof(lv_img_header_t), w, h);
+        }
+        mem_free(MEM_POOL_IMAGES, src);
+    } else {
+        Serial.printf("[icons] %s: not an RGB565+alpha LVGL image\n", path);
+    }
+    f.close();
+    return buf;
+}
+
+const lv_img_dsc_t *icon_cache_acquire(const char *path, uint16_t max_w, uint16_t max_h) {
+    if (!path || !*path || !max_w || !max_h || !sdcard_mounted()) return nullptr;
+
+    for (auto &e : entries) {
+        if (e.buf && !e.stale && e.fit_w == max_w && e.fit_h == max_h && e.path == path) {
+            e.refs++;
+            e.last_used = ++use_clock;
+            return &e.dsc;
+        }
+    }
+
+    File src = SD.open(path, FILE_READ);
+    if (!src) return nullptr;
+    uint32_t src_size = src.size();
+    src.close();
+
+    IconEntry *slot = free_slot();
+    if (!slot) {
+        Serial.println("[icons] All cache slots pinned");
+        return nullptr;
+    }
+
+    uint32_t t0 = millis();
+    std::string bin = bin_path(path, src_size, max_w, max_h);
+    bool from_bin = true;
+    uint8_t *buf = nullptr;
+    if (is_raw_source(path)) {
+        buf = load_raw_source(path, max_w, max_h);   // As cheap as a cache hit: no copy kept
+        if (!buf) return nullptr;
+    } else {
+        buf = load_bin(bin, max_w, max_h);
+    }
+    if (!buf) {
+        from_bin = false;
+        buf = decode_source(path, max_w, max_h);
+        if (!buf) return nullptr;
+    }
+
+    lv_img_header_t hdr;
+    memcpy(&hdr, buf, sizeof(hdr));
+    size_t px_bytes = (size_t)hdr.w * hdr.h * ICON_PX_BYTES;
+    if (!from_bin) {
+        if (!dir_ready) dir_ready = sdcard_mkdir(ICON_CACHE_DIR);
+        if (!sdcard_write_file(bin.c_str(), buf, sizeof(hdr) + px_bytes)) {
+            Serial.printf("[icons] Could not write %s\n", bin.c_str());
+        }
+    }
+
+    slot->path = path;
+    slot->fit_w = max_w;
+    slot->fit_h = max_h;
+    slot->buf = buf;
+    slot->dsc = {};
+    slot->dsc.header = hdr;
+    slot->dsc.data_size = px_bytes;
+    slot->dsc.data = buf + sizeof(hdr);
+    slot->refs = 1;
+    slot->stale = false;
+    slot->last_used = ++use_clock;
+    cache_bytes += px_bytes;
+
+    Serial.printf("[icons] %s %ux%u from %s in %lums (cache %lu KB)\n", path, hdr.w, hdr.h,
+                  from_bin ? "bin" : "decode", (unsigned long)(millis() - t0),
+                  (unsigned long)(cache_bytes / 1024));
+    return &slot->dsc;
+}
+
+void icon_cache_release(const lv_img_dsc_t *img) {
+    for (auto &e : entries) {
+        if (!e.buf || &e.dsc != img) continue;
+        if (e.refs) e.refs--;
+        if (!e.refs && e.stale) entry_free(e);
+        return;
+    }
+}
+
+struct BinSweep {
+    char prefix[10];
+    std::vector<std::string> names;
+};
+
+static void collect_bin(const char *name, size_t, bool is_dir, void *user_data) {
+    BinSweep *sw = (BinSweep *)user_data;
+    if (!is_dir && strncmp(name, sw->prefix, strlen(sw->prefix)) == 0) sw->names.push_back(name);
+}
+
+void icon_cache_invalidate(const char *path) {
+    if (!path || !*path) return;
+    for (auto &e : entries) {
+        if (!e.buf || e.path != path) continue;
+        if (e.refs) e.stale = true;
+        else entry_free(e);
+    }
+
+    // Collect first: removing entries mid-listing skips some on FAT
+    BinSweep sw;
+    snprintf(sw.prefix, sizeof(sw.prefix), "%08lx_", (unsigned long)path_hash(path));
+    sdcard_list_dir(ICON_CACHE_DIR, collect_bin, &sw);
+    for (const auto &name : sw.names) {
+        sdcard_file_remove((std::string(ICON_CACHE_DIR "/") + name).c_str());
+    }
+    if (!sw.names.empty()) Serial.printf("[icons] Dropped %zu cached size(s) of %s\n", sw.names.size(), path);
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <lvgl.h>
+#include <stdint.h>
+
+// ============================================================
+// Button icon cache
+//
+// SD card images (PNG) are decoded once, scaled to the exact size a widget
+// shows them at and kept as RGB565+alpha (LV_IMG_CF_TRUE_COLOR_ALPHA):
+//   - in a PSRAM LRU keyed by path + fit box, so redraws and page rebuilds
+//     never touch the decoder or the SD card
+//   - as a raw LVGL .bin under ICON_CACHE_DIR, so the next boot skips the
+//     PNG decode too
+// A source that is itself such a .bin is used directly (resampled if needed).
+// ============================================================
+
+#define ICON_CACHE_DIR "/.iconcache"
+
+// Decoded pixel budget in PSRAM. Icons still shown by a widget are never
+// evicted, so the cache may exceed this while they are all on screen.
+#ifndef ICON_CACHE_BYTES
+#define ICON_CACHE_BYTES (1536 * 1024)
+#endif
+
+// Image for `path` (e.g. "/icons/calc.png") scaled to fit max_w x max_h with
+// its aspect ratio kept. Pinned until icon_cache_release(); nullptr when the
+// file is missing or its decoder doesn't produce full frames.
+const lv_img_dsc_t *icon_cache_acquire(const char *path, uint16_t max_w, uint16_t max_h);
+void icon_cache_release(const lv_img_dsc_t *img);
+
+// `path` was replaced on the SD card: drop its decoded copies (RAM and .bin)
+void icon_cache_invalidate(const char *path);
+
+// Shared with anim_icon.cpp: the size an sw x sh image is shown at in a
+// max_w x max_h box, and the area-average resample into it (RGB565+A out;
+// src is RGB565, with alpha when src_alpha)
+void icon_fit_size(uint32_t sw, uint32_t sh, uint16_t max_w, uint16_t max_h, uint16_t *w, uint16_t *h);
+void icon_resample(const uint8_t *src, uint16_t sw, uint16_t sh, bool src_alpha,
+                   uint8_t *dst, uint16_t dw, uint16_t dh);
@@ -0,0 +1,525 @@
+/**
+ * @file img_loader.cpp
+ * Background JPEG/SJPG decoder for the picture frame slideshow and page backgrounds
+ *
+ * Frames are SCREEN_WIDTH x SCREEN_HEIGHT RGB565 in PSRAM. The image is
+ * decoded at the largest scale (1/1..1/8) that fits the screen and centred
+ * on black. SJPG ("_SJPG__" header + JPEG strips, LVGL's split format) is
+ * decoded strip by strip into the same frame.
+ *
+ * Each JPEG stream goes to JPEGDEC first (ESP32-S3 SIMD IDCT and colour
+ * conversion, RGB565 rows straight out) and to LVGL's TJpgDec when JPEGDEC
+ * rejects it or IMG_LOADER_JPEGDEC=0.
+ *
+ * Raw RGB565 sources (LVGL .bin TRUE_COLOR, RGB565 BMP) aren't decoded at
+ * all: their visible rows are read from the file straight into the frame.
+ */
+
+#include "img_loader.h"
+#include "display_hw.h"
+#include "mem_budget.h"
+#include <Arduino.h>
+#include <SD.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <string.h>
+#include <strings.h>
+#include <new>
+#include <src/extra/libs/sjpg/tjpgd.h>
+#if IMG_LOADER_JPEGDEC
+#include <JPEGDEC.h>
+#endif
+
+#define LOADER_STACK      6144
+#define LOADER_PRIORITY   1      // Below the flush task and the Arduino loop
+#define LOADER_WORK_BYTES 4096   // TJpgDec pool (same size lv_sjpg uses)
+#define LOADER_PATH_MAX   96
+#define LOADER_QUEUE_LEN  (IMG_LOADER_SLOTS + 4)   // Slideshow slots + page backgrounds
+
+// SJPG header layout (see lv_sjpg.c)
+#define SJPG_MAGIC           "_SJPG__"
+#define SJPG_X_RES_OFFSET    14
+#define SJPG_Y_RES_OFFSET    16
+#define SJPG_FRAMES_OFFSET   18
+#define SJPG_BLOCK_H_OFFSET  20
+#define SJPG_INFO_OFFSET     22
+
+struct LoaderJob {
+    uint16_t *pixels;                // SCREEN_WIDTH x SCREEN_HEIGHT frame
+    volatile ImgLoadState *state;    // Set to READY / FAILED when done
+    bool cancellable;                // Slideshow slot: img_loader_end() aborts it
+    char path[LOADER_PATH_MAX];
+};
+
+struct LoaderSlot {
+    uint16_t *pixels;
+    lv_img_dsc_t dsc;
+    volatile ImgLoadState state;
+};
+
+// Decode context handed to the TJpgDec callbacks
+struct JpegCtx {
+    File *file;
+    uint32_t remaining;    // Bytes of this JPEG stream left in the file
+    uint16_t *frame;
+    int16_t off_x, off_y;  // Where the (scaled) stream lands in the frame
+    int16_t right, bottom; // Exclusive edge of the scaled image (MCU padding is cut)
+};
+
+static LoaderSlot slots[IMG_LOADER_SLOTS];
+static QueueHandle_t job_queue = nullptr;
+static SemaphoreHandle_t idle_sem = nullptr;   // Given whenever the task finishes a job
+static TaskHandle_t loader_task = nullptr;
+static volatile bool cancel = false;
+static volatile bool job_cancellable = false;   // Running job is a slideshow slot
+static uint8_t *work = nullptr;
+#if IMG_LOADER_JPEGDEC
+static JPEGDEC *jpegdec = nullptr;   // Large decoder state: internal RAM, allocated once
+#endif
+
+static inline bool aborted() {
+    return cancel && job_cancellable;
+}
+
+static size_t jpeg_in(JDEC *jd, uint8_t *buf, size_t len) {
+    JpegCtx *ctx = (JpegCtx *)jd->device;
+    if (len > ctx->remaining) len = ctx->remaining;
+    ctx->remaining -= len;
+    if (!buf) {
+        ctx->file->seek(ctx->file->position() + len);
+        return len;
+    }
+    return ctx->file->read(buf, len);
+}
+
+static int jpeg_out(JDEC *jd, void *bitmap, JRECT *rect) {
+    if (aborted()) return 0;
+    JpegCtx *ctx = (JpegCtx *)jd->device;
+    uint16_t w = rect->right - rect->left + 1;
+    for (uint16_t y = rect->top; y <= rect->bottom; y++) {
+        int fy = ctx->off_y + y;
+        if (fy < 0 || fy >= SCREEN_HEIGHT) continue;
+#if JD_FORMAT == 1
+        const uint16_t *src = (const uint16_t *)bitmap + (y - rect->top) * w;
+#else
+        const uint8_t *src = (const uint8_t *)bitmap + (y - rect->top) * w * 3;
+#endif
+        for (uint16_t x = 0; x < w; x++) {
+            int fx = ctx->off_x + rect->left + x;
+            if (fx < 0 || fx >= SCREEN_WIDTH) continue;
+#if JD_FORMAT == 1
+            ctx->frame[fy * SCREEN_WIDTH + fx] = src[x];
+#else
+            const uint8_t *p = src + x * 3;
+            ctx->frame[fy * SCREEN_WIDTH + fx] = ((p[0] & 0xF8) << 8) | ((p[1] & 0xFC) << 3) | (p[2] >> 3);
+#endif
+        }
+    }
+    return 1;
+}
+
+// Largest 1/2^n reduction that fits the screen (TJpgDec supports n = 0..3)
+static uint8_t pick_scale(uint16_t w, uint16_t h) {
+    uint8_t s = 0;
+    while (s < 3 && ((w >> s) > SCREEN_WIDTH || (h >> s) > SCREEN_HEIGHT)) s++;
+    return s;
+}
+
+#if IMG_LOADER_JPEGDEC
+// JPEGDEC reads one JPEG stream: `len` bytes at `base` of the file
+struct StreamWindow {
+    File *file;
+    uint32_t base, len;
+};
+
+static int32_t jpegdec_read(JPEGFILE *jf, uint8_t *buf, int32_t len) {
+    StreamWindow *w = (StreamWindow *)jf->fHandle;
+    uint32_t pos = w->file->position() - w->base;
+    if (pos >= w->len) return 0;
+    if ((uint32_t)len > w->len - pos) len = w->len - pos;
+    return w->file->read(buf, len);
+}
+
+static int32_t jpegdec_seek(JPEGFILE *jf, int32_t pos) {
+    StreamWindow *w = (StreamWindow *)jf->fHandle;
+    if (pos < 0) pos = 0;
+    if ((uint32_t)pos > w->len) pos = w->len;
+    return w->file->seek(w->base + pos) ? pos : -1;
+}
+
+static void jpegdec_close(void *) {}   // The File belongs to decode_file()
+
+// One MCU row of RGB565 pixels; clipped to the image and the frame
+static int jpegdec_draw(JPEGDRAW *d) {
+    if (aborted()) return 0;
+    JpegCtx *ctx = (JpegCtx *)d->pUser;
+    int x0 = ctx->off_x + d->x;
+    int skip = x0 < 0 ? -x0 : 0;
+    int x1 = x0 + d->iWidth;
+    if (x1 > ctx->right) x1 = ctx->right;
+    if (x1 > SCREEN_WIDTH) x1 = SCREEN_WIDTH;
+    int w = x1 - (x0 + skip);
+    if (w <= 0) return 1;
+    for (int y = 0; y < d->iHeight; y++) {
+        int fy = ctx->off_y + d->y + y;
+        if (fy < 0) continue;
+        if (fy >= ctx->bottom || fy >= SCREEN_HEIGHT) break;
+        memcpy(ctx->frame + fy * SCREEN_WIDTH + x0 + skip, d->pPixels + y * d->iWidth + skip,
+               w * sizeof(uint16_t));
+    }
+    return 1;
+}
+
+static bool jpegdec_open(StreamWindow &win) {
+    if (!jpegdec || !win.file->seek(win.base)) return false;
+    return jpegdec->open((void *)&win, (int)win.len, jpegdec_close, jpegdec_read, jpegdec_seek,
+                         jpegdec_draw) == 1;
+}
+
+static bool jpegdec_decode(JpegCtx &ctx, uint8_t scale) {
+    static const int SCALE_OPTIONS[4] = { 0, JPEG_SCALE_HALF, JPEG_SCALE_QUARTER, JPEG_SCALE_EIGHTH };
+    jpegdec->setPixelType(RGB565_LITTLE_ENDIAN);
+    jpegdec->setUserPointer(&ctx);
+    bool ok = jpegdec->decode(0, 0, SCALE_OPTIONS[scale]) == 1;
+    jpegdec->close();
+    return ok;
+}
+#endif
+
+// Decode `len` bytes at `base` into the frame at (off_x, off_y). off_x/y
+// mark where the scaled image starts; right/bottom where it ends.
+static bool decode_stream(File &f, uint32_t base, uint32_t len, JpegCtx ctx, uint8_t scale) {
+#if IMG_LOADER_JPEGDEC
+    StreamWindow win = { &f, base, len };
+    if (jpegdec_open(win)) {
+        if (jpegdec_decode(ctx, scale)) return true;
+        if (aborted()) return false;
+    }
+#endif
+    // TJpgDec: also what JPEGDEC turns down (e.g. arithmetic coding)
+    if (!f.seek(base)) return false;
+    ctx.remaining = len;
+    JDEC jd;
+    if (jd_prepare(&jd, jpeg_in, work, LOADER_WORK_BYTES, &ctx) != JDR_OK) return false;
+    return jd_decomp(&jd, jpeg_out, scale) == JDR_OK;
+}
+
+// Stream dimensions without decoding
+static bool stream_size(File &f, uint32_t len, uint16_t &w, uint16_t &h) {
+#if IMG_LOADER_JPEGDEC
+    StreamWindow win = { &f, 0, len };
+    if (jpegdec_open(win)) {
+        w = jpegdec->getWidth();
+        h = jpegdec->getHeight();
+        jpegdec->close();
+        return true;
+    }
+#endif
+    JpegCtx ctx = {};
+    ctx.file = &f;
+    ctx.remaining = len;
+    JDEC jd;
+    if (!f.seek(0) || jd_prepare(&jd, jpeg_in, work, LOADER_WORK_BYTES, &ctx) != JDR_OK) return false;
+    w = jd.width;
+    h = jd.height;
+    return true;
+}
+
+static JpegCtx frame_ctx(File &f, uint16_t *frame, uint16_t w, uint16_t h, uint8_t scale) {
+    JpegCtx ctx = {};
+    ctx.file = &f;
+    ctx.frame = frame;
+    ctx.off_x = (SCREEN_WIDTH - (w >> scale)) / 2;
+    ctx.off_y = (SCREEN_HEIGHT - (h >> scale)) / 2;
+    ctx.right = ctx.off_x + (w >> scale);
+    ctx.bottom = ctx.off_y + (h >> scale);
+    return ctx;
+}
+
+static bool decode_jpeg(File &f, uint16_t *frame) {
+    uint16_t w, h;
+    if (!stream_size(f, f.size(), w, h)) return false;
+    uint8_t scale = pick_scale(w, h);
+    return decode_stream(f, 0, f.size(), frame_ctx(f, frame, w, h, scale), scale);
+}
+
+static bool decode_sjpg(File &f, uint16_t *frame) {
+    uint8_t hdr[SJPG_INFO_OFFSET];
+    if (f.read(hdr, sizeof(hdr)) != sizeof(hdr)) return false;
+    uint16_t w = hdr[SJPG_X_RES_OFFSET] | (hdr[SJPG_X_RES_OFFSET + 1] << 8);
+    uint16_t h = hdr[SJPG_Y_RES_OFFSET] | (hdr[SJPG_Y_RES_OFFSET + 1] << 8);
+    uint16_t frames = hdr[SJPG_FRAMES_OFFSET] | (hdr[SJPG_FRAMES_OFFSET + 1] << 8);
+    uint16_t block_h = hdr[SJPG_BLOCK_H_OFFSET] | (hdr[SJPG_BLOCK_H_OFFSET + 1] << 8);
+    if (!w || !h || !frames || !block_h) return false;
+
+    uint16_t *lens = (uint16_t *)malloc(frames * sizeof(uint16_t));
+    if (!lens) return false;
+    bool ok = f.read((uint8_t *)lens, frames * sizeof(uint16_t)) == frames * sizeof(uint16_t);
+
+    uint8_t scale = pick_scale(w, h);
+    JpegCtx ctx = frame_ctx(f, frame, w, h, scale);
+    int16_t top = ctx.off_y;
+    uint32_t pos = SJPG_INFO_OFFSET + frames * sizeof(uint16_t);
+    for (uint16_t i = 0; ok && i < frames && !aborted(); i++) {
+        ctx.off_y = top + (int16_t)((i * block_h) >> scale);
+        ok = decode_stream(f, pos, lens[i], ctx, scale);
+        pos += lens[i];
+    }
+    free(lens);
+    return ok && !aborted();
+}
+
+// ============================================================
+// Uncompressed sources: no decode, rows copied into the frame
+// ============================================================
+
+// Source rows/columns that land on screen when a w x h image is centred
+// (cropped when larger, letterboxed when smaller)
+struct RawPlacement {
+    uint16_t src_x, src_y;   // First source pixel shown
+    uint16_t dst_x, dst_y;   // Where it goes in the frame
+    uint16_t w, h;           // Span copied
+};
+
+static RawPlacement raw_placement(uint16_t w, uint16_t h) {
+    RawPlacement p;
+    p.w = w < SCREEN_WIDTH ? w : SCREEN_WIDTH;
+    p.h = h < SCREEN_HEIGHT ? h : SCREEN_HEIGHT;
+    p.src_x = (w - p.w) / 2;
+    p.src_y = (h - p.h) / 2;
+    p.dst_x = (SCREEN_WIDTH - p.w) / 2;
+    p.dst_y = (SCREEN_HEIGHT - p.h) / 2;
+    return p;
+}
+
+static inline uint16_t rgb565(uint8_t r, uint8_t g, uint8_t b) {
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+}
+
+// LVGL binary image ("S:" .bin): 4-byte lv_img_header_t, then rows.
+// TRUE_COLOR is already the frame's RGB565, read straight into PSRAM;
+// TRUE_COLOR_ALPHA is put on black.
+static bool decode_bin(File &f, uint16_t *frame) {
+    uint32_t hdr;
+    if (f.read((uint8_t *)&hdr, sizeof(hdr)) != sizeof(hdr)) return false;
+    uint8_t cf = hdr & 0x1F;
+    uint16_t w = (hdr >> 10) & 0x7FF, h = (hdr >> 21) & 0x7FF;
+    if (!w || !h || (cf != LV_IMG_CF_TRUE_COLOR && cf != LV_IMG_CF_TRUE_COLOR_ALPHA)) return false;
+    uint8_t px_bytes = cf == LV_IMG_CF_TRUE_COLOR ? sizeof(uint16_t) : LV_IMG_PX_SIZE_ALPHA_BYTE;
+    RawPlacement p = raw_placement(w, h);
+
+    if (cf == LV_IMG_CF_TRUE_COLOR && w == SCREEN_WIDTH && h <= SCREEN_HEIGHT) {
+        // Whole rows: one read of the image
+        size_t bytes = (size_t)w * h * sizeof(uint16_t);
+        return f.read((uint8_t *)(frame + p.dst_y * SCREEN_WIDTH), bytes) == bytes;
+    }
+    uint8_t *row = (uint8_t *)malloc((size_t)p.w * px_bytes);
+    if (!row) return false;
+    bool ok = true;
+    for (uint16_t y = 0; ok && y < p.h && !aborted(); y++) {
+        uint16_t *dst = frame + (p.dst_y + y) * SCREEN_WIDTH + p.dst_x;
+        uint32_t pos = sizeof(hdr) + ((uint32_t)(p.src_y + y) * w + p.src_x) * px_bytes;
+        if (cf == LV_IMG_CF_TRUE_COLOR) {
+            ok = f.seek(pos) && f.read((uint8_t *)dst, p.w * px_bytes) == (size_t)p.w * px_bytes;
+            continue;
+        }
+        ok = f.seek(pos) && f.read(row, p.w * px_bytes) == (size_t)p.w * px_bytes;
+        for (uint16_t x = 0; ok && x < p.w; x++) {
+            const uint8_t *s = row + x * px_bytes;
+            uint16_t c = s[0] | (s[1] << 8);
+            uint8_t a = s[2];
+            dst[x] = rgb565((c >> 8 & 0xF8) * a / 255, (c >> 3 & 0xFC) * a / 255, (c << 3 & 0xF8) * a / 255);
+        }
+    }
+    free(row);
+    return ok && !aborted();
+}
+
+static uint32_t le32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Uncompressed BMP: 24/32-bit BI_RGB or 16-bit RGB565 BI_BITFIELDS, either
+// row order
+static bool decode_bmp(File &f, uint16_t *frame) {
+    uint8_t hdr[70];
+    size_t got = f.read(hdr, sizeof(hdr));
+    if (got < 54 || hdr[0] != 'B' || hdr[1] != 'M') return false;
+    uint32_t data_off = le32(&hdr[10]);
+    int32_t w = (int32_t)le32(&hdr[18]), h = (int32_t)le32(&hdr[22]);
+    uint16_t bpp = hdr[28] | (hdr[29] << 8);
+    uint32_t compression = le32(&hdr[30]);
+    bool top_down = h < 0;
+    if (top_down) h = -h;
+    if (w <= 0 || h <= 0 || w > 0xFFFF || h > 0xFFFF) return false;
+    bool rgb565_fields = bpp == 16 && compression == 3 && got >= 66 &&   // BI_BITFIELDS masks after the header
+                         le32(&hdr[54]) == 0xF800 && le32(&hdr[58]) == 0x07E0 && le32(&hdr[62]) == 0x001F;
+    if (!rgb565_fields && !((bpp == 24 || bpp == 32) && compression == 0)) return false;
+
+    uint8_t px_bytes = bpp / 8;
+    uint32_t stride = ((uint32_t)w * px_bytes + 3) & ~3u;
+    RawPlacement p = raw_placement(w, h);
+    uint8_t *row = (uint8_t *)malloc((size_t)p.w * px_bytes);
+    if (!row) return false;
+    bool ok = true;
+    for (uint16_t y = 0; ok && y < p.h && !aborted(); y++) {
+        uint32_t sy = p.src_y + y;
+        uint32_t file_row = top_down ? sy : h - 1 - sy;
+        uint16_t *dst = frame + (p.dst_y + y) * SCREEN_WIDTH + p.dst_x;
+        uint32_t pos = data_off + file_row * stride + p.src_x * px_bytes;
+        if (rgb565_fields) {
+            ok = f.seek(pos) && f.read((uint8_t *)dst, p.w * px_bytes) == (size_t)p.w * px_bytes;
+            continue;
+        }
+        ok = f.seek(pos) && f.read(row, p.w * px_bytes) == (size_t)p.w * px_bytes;
+        for (uint16_t x = 0; ok && x < p.w; x++) {
+            const uint8_t *s = row + x * px_bytes;
+            dst[x] = rgb565(s[2], s[1], s[0]);
+        }
+    }
+    free(row);
+    return ok && !aborted();
+}
+
+static const char *path_ext(const char *path) {
+    const char *dot = strrchr(path, '.');
+    return dot ? dot : "";
+}
+
+bool img_loader_takes(const char *path) {
+    const char *ext = path_ext(path);
+    return !strcasecmp(ext, ".jpg") || !strcasecmp(ext, ".jpeg") || !strcasecmp(ext, ".sjpg") ||
+           !strcasecmp(ext, ".bmp") || !strcasecmp(ext, ".bin");
+}
+
+static bool decode_file(const char *path, uint16_t *frame) {
+    File f = SD.open(path, FILE_READ);
+    if (!f) return false;
+    char magic[sizeof(SJPG_MAGIC)] = {};
+    f.read((uint8_t *)magic, sizeof(magic) - 1);
+    f.seek(0);
+
+    // Letterbox to black; a cancelled/failed decode leaves the frame unused
+    memset(frame, 0, SCREEN_WIDTH * SCREEN_HEIGHT * sizeof(uint16_t));
+    const char *ext = path_ext(path);
+    bool ok;
+    if (!strcasecmp(ext, ".bin")) ok = decode_bin(f, frame);
+    else if (magic[0] == 'B' && magic[1] == 'M') ok = decode_bmp(f, frame);
+    else if (strcmp(magic, SJPG_MAGIC) == 0) ok = decode_sjpg(f, frame);
+    else ok = decode_jpeg(f, frame);
+    f.close();
+    return ok;
+}
+
+static void loader_task_fn(void *) {
+    LoaderJob job;
+    for (;;) {
+        if (xQueueReceive(job_queue, &job, portMAX_DELAY) != pdTRUE) continue;
+        job_cancellable = job.cancellable;
+        if (!(cancel && job.cancellable) && job.pixels) {
+            uint32_t t0 = millis();
+            bool ok = decode_file(job.path, job.pixels);
+            if (!aborted()) {
+                Serial.printf("[img] %s %s in %lu ms\n", job.path, ok ? "decoded" : "FAILED",
+                              (unsigned long)(millis() - t0));
+            }
+            *job.state = ok && !aborted() ? IMG_LOAD_READY : IMG_LOAD_FAILED;
+        } else {
+            *job.state = IMG_LOAD_FAILED;
+        }
+        job_cancellable = false;
+        xSemaphoreGive(idle_sem);
+    }
+}
+
+// Task, queue and decoder state (first call only)
+static bool loader_start() {
+    if (!work) work = (uint8_t *)malloc(LOADER_WORK_BYTES);  // Internal RAM: hot during decode
+    if (!work) return false;
+#if IMG_LOADER_JPEGDEC
+    if (!jpegdec) jpegdec = new (std::nothrow) JPEGDEC();   // nullptr: TJpgDec only
+#endif
+    if (!loader_task) {
+        job_queue = xQueueCreate(LOADER_QUEUE_LEN, sizeof(LoaderJob));
+        idle_sem = xSemaphoreCreateCounting(LOADER_QUEUE_LEN, 0);
+        xTaskCreatePinnedToCore(loader_task_fn, "img_loader", LOADER_STACK, nullptr,
+                                LOADER_PRIORITY, &loader_task, 0);
+    }
+    return true;
+}
+
+static bool queue_job(uint16_t *pixels, volatile ImgLoadState *state, bool cancellable, const char *path) {
+    LoaderJob job;
+    job.pixels = pixels;
+    job.state = state;
+    job.cancellable = cancellable;
+    strlcpy(job.path, path, sizeof(job.path));
+    *state = IMG_LOAD_BUSY;
+    if (xQueueSend(job_queue, &job, 0) != pdTRUE) {
+        *state = IMG_LOAD_IDLE;
+        return false;
+    }
+    return true;
+}
+
+bool img_loader_begin() {
+    cancel = false;
+    if (!loader_start()) return false;
+    for (auto &s : slots) {
+        if (!s.pixels) {
+            s.pixels = (uint16_t *)mem_alloc(MEM_POOL_IMAGES, SCREEN_WIDTH * SCREEN_HEIGHT * sizeof(uint16_t));
+            if (!s.pixels) {
+                Serial.println("[img] PSRAM frame alloc failed");
+                img_loader_end();
+                return false;
+            }
+        }
+        s.dsc = {};
+        s.dsc.header.cf = LV_IMG_CF_TRUE_COLOR;
+        s.dsc.header.w = SCREEN_WIDTH;
+        s.dsc.header.h = SCREEN_HEIGHT;
+        s.dsc.data_size = SCREEN_WIDTH * SCREEN_HEIGHT * sizeof(uint16_t);
+        s.dsc.data = (const uint8_t *)s.pixels;
+        s.state = IMG_LOAD_IDLE;
+    }
+    return true;
+}
+
+bool img_loader_request(uint8_t slot, const char *path) {
+    if (slot >= IMG_LOADER_SLOTS || !loader_task || !slots[slot].pixels) return false;
+    if (slots[slot].state == IMG_LOAD_BUSY) return false;
+    return queue_job(slots[slot].pixels, &slots[slot].state, true, path);
+}
+
+bool img_loader_decode_into(const char *path, uint16_t *pixels, volatile ImgLoadState *state) {
+    if (!pixels || !state || *state == IMG_LOAD_BUSY || !loader_start()) return false;
+    return queue_job(pixels, state, false, path);
+}
+
+ImgLoadState img_loader_state(uint8_t slot) {
+    return slot < IMG_LOADER_SLOTS ? slots[slot].state : IMG_LOAD_IDLE;
+}
+
+const lv_img_dsc_t *img_loader_frame(uint8_t slot) {
+    if (slot >= IMG_LOADER_SLOTS || slots[slot].state != IMG_LOAD_READY) return nullptr;
+    return &slots[slot].dsc;
+}
+
+void img_loader_end() {
+    cancel = true;
+    // Wait for queued/running slot jobs to drain (the output callbacks abort
+    // early); background jobs run to completion
+    for (auto &s : slots) {
+        while (s.state == IMG_LOAD_BUSY) xSemaphoreTake(idle_sem, pdMS_TO_TICKS(50));
+    }
+    cancel = false;
+    while (idle_sem && xSemaphoreTake(idle_sem, 0) == pdTRUE) {}
+    for (auto &s : slots) {
+        if (s.pixels) {
+            lv_img_cache_invalidate_src(&s.dsc);
+            mem_free(MEM_POOL_IMAGES, s.pixels);
+        }
+        s = LoaderSlot();
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <lvgl.h>
+#include <stdint.h>
+
+// ============================================================
+// Background image loader (picture frame slideshow, page backgrounds)
+//
+// A low-priority task on core 0 decodes JPEG / SJPG files from the SD card
+// into full-screen RGB565 PSRAM frames, so the LVGL thread only swaps
+// lv_img_dsc_t pointers. Raw RGB565 files (LVGL .bin, BMP) are copied in
+// row by row, no decode. Either way the frame is opaque TRUE_COLOR: LVGL
+// blits it with a row memcpy and skips everything the image covers. The task never calls into LVGL: it reads through
+// the SD library and decodes with JPEGDEC (SIMD on the S3), falling back to
+// the TJpgDec copy that ships with LVGL.
+// ============================================================
+
+#define IMG_LOADER_SLOTS 2   // Frame shown + frame being prepared
+
+// JPEGDEC for baseline JPEG streams (0 = TJpgDec only)
+#ifndef IMG_LOADER_JPEGDEC
+#define IMG_LOADER_JPEGDEC 1
+#endif
+
+enum ImgLoadState : uint8_t {
+    IMG_LOAD_IDLE = 0,       // Slot empty / released
+    IMG_LOAD_BUSY,           // Decode queued or running
+    IMG_LOAD_READY,          // Frame valid, img_loader_frame() may be shown
+    IMG_LOAD_FAILED,         // File unreadable or in a format the loader doesn't take
+};
+
+// Formats the loader reads (by extension): .jpg .jpeg .sjpg, .bmp
+// (24/32-bit, RGB565 bitfields), .bin (LVGL TRUE_COLOR / TRUE_COLOR_ALPHA)
+bool img_loader_takes(const char *path);
+
+// Allocate the frames and start the task (first call only). False if PSRAM is short.
+bool img_loader_begin();
+
+// Decode `path` (SD path, e.g. "/pictures/a.sjpg") into `slot` in the background.
+// The slot must not be on screen. False if the slot is busy or the queue is full.
+bool img_loader_request(uint8_t slot, const char *path);
+
+ImgLoadState img_loader_state(uint8_t slot);
+
+// Image descriptor for a READY slot (letterboxed to SCREEN_WIDTH x SCREEN_HEIGHT)
+const lv_img_dsc_t *img_loader_frame(uint8_t slot);
+
+// Cancel pending slot work and free the slot frames (leaving picture frame
+// mode). Nothing may still display a frame.
+void img_loader_end();
+
+// Decode `path` into a caller-owned SCREEN_WIDTH x SCREEN_HEIGHT RGB565
+// frame (a page background), independent of the slots and of
+// img_loader_begin()/end(). *state goes BUSY, then READY or FAILED; the
+// frame must stay allocated while it is BUSY. False if the queue is full.
+bool img_loader_decode_into(const char *path, uint16_t *pixels, volatile ImgLoadState *state);
@@ -0,0 +1,449 @@
+/**
+ * @file input_replay.cpp
+ * Input recorder and deterministic replay (see input_replay.h)
+ *
+ * One PSRAM buffer holds the file image, header then events, both while
+ * recording (the input task appends under rec_mux) and while replaying
+ * (loaded once, read by the UI task). Timestamps are ms from the start of
+ * the recording; a replay pass fires each event once its offset has
+ * elapsed and so follows the recording's timing to within a loop pass.
+ */
+
+#include "input_replay.h"
+#include "espnow_link.h"
+#include "hw_input.h"
+#include "perf.h"
+#include "sdcard.h"
+#include "ui.h"
+#include "log.h"
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <string.h>
+
+#define REPLAY_MAGIC    0x314C5052   // "RPL1"
+#define REPLAY_VERSION  1
+
+enum ReplayEventKind : uint8_t {
+    REPLAY_EV_TOUCH = 0,   // points[0..count) down (count 0 = released)
+    REPLAY_EV_PINS  = 1,   // PCF8575 pin state
+};
+
+struct __attribute__((packed)) ReplayPoint {
+    uint8_t  id;
+    uint16_t x;
+    uint16_t y;
+};
+
+struct __attribute__((packed)) ReplayEvent {
+    uint32_t t_ms;
+    uint8_t  kind;          // ReplayEventKind
+    uint8_t  count;
+    uint16_t pins;
+    ReplayPoint points[TOUCH_MAX_POINTS];
+};
+
+struct __attribute__((packed)) ReplayFileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t events;
+    uint32_t duration_ms;
+    int8_t   profile;       // ui_active_profile_index() at the start, -1 = none
+    uint8_t  page;
+    uint16_t reserved;
+};
+
+#define REPLAY_BUF_BYTES (sizeof(ReplayFileHeader) + REPLAY_MAX_EVENTS * sizeof(ReplayEvent))
+
+enum ReplayPhase : uint8_t {
+    PHASE_PROFILE,   // Profile switch requested, waiting for the rebuild
+    PHASE_PAGE,      // On the recorded page, letting it settle
+    PHASE_RUN,       // Feeding events
+};
+
+static uint8_t *buf = nullptr;   // REPLAY_BUF_BYTES, PSRAM
+static ReplayFileHeader *hdr = nullptr;
+static ReplayEvent *evs = nullptr;
+static char name[REPLAY_NAME_MAX] = "";
+
+// Recording
+static portMUX_TYPE rec_mux = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool recording = false;
+static uint32_t rec_start_ms = 0;
+static uint16_t rec_count = 0;
+static bool rec_overflow = false;
+
+// Replay
+static volatile bool running = false;
+static ReplayPhase phase = PHASE_RUN;
+static uint8_t loops_left = 0;
+static uint16_t next_event = 0;
+static uint32_t events_fed = 0;
+static uint32_t run_start_ms = 0;
+static uint32_t pass_start_ms = 0;
+static uint32_t phase_due_ms = 0;
+static uint32_t stats_tick = 0;
+static uint32_t next_stats_ms = 0;
+
+static ReplayReportMsg last_report = { 0, 0xFF };
+
+bool replay_running() {
+    return running;
+}
+
+bool replay_recording() {
+    return recording;
+}
+
+void replay_last_report(ReplayReportMsg &out) {
+    out = last_report;
+}
+
+// ============================================================
+// Buffer, names, files
+// ============================================================
+
+static bool alloc_buf() {
+    if (!buf) buf = (uint8_t *)ps_malloc(REPLAY_BUF_BYTES);
+    if (!buf) return false;
+    hdr = (ReplayFileHeader *)buf;
+    evs = (ReplayEvent *)(buf + sizeof(ReplayFileHeader));
+    return true;
+}
+
+static void free_buf() {
+    free(buf);
+    buf = nullptr;
+    hdr = nullptr;
+    evs = nullptr;
+}
+
+// File stem: letters, digits, '-' and '_' only, so it can't leave /replay
+static bool set_name(const char *src) {
+    size_t len = strnlen(src, REPLAY_NAME_MAX);
+    if (len == 0 || len >= REPLAY_NAME_MAX) return false;
+    for (size_t i = 0; i < len; i++) {
+        char c = src[i];
+        if (!isalnum((unsigned char)c) && c != '-' && c != '_') return false;
+    }
+    memcpy(name, src, len);
+    name[len] = '\0';
+    return true;
+}
+
+static void file_path(char *out, size_t size, const char *ext) {
+    snprintf(out, size, REPLAY_DIR "/%s.%s", name, ext);
+}
+
+static void send_report(ReplayReportMsg &rep) {
+    memcpy(rep.name, name, sizeof(rep.name));
+    last_report = rep;
+    espnow_send_reliable(MSG_REPLAY_REPORT, (const uint8_t *)&rep, sizeof(rep));
+}
+
+static void report_error(uint8_t op, uint8_t status) {
+    ReplayReportMsg rep = {};
+    rep.op = op;
+    rep.status = status;
+    static const char *const OP_NAMES[] = { "record", "stop", "replay" };
+    Serial.printf("REPLAY: %s '%s' failed (status %u)\n", op <= REPLAY_OP_RUN ? OP_NAMES[op] : "?", name, status);
+    send_report(rep);
+}
+
+// ============================================================
+// Recording
+// ============================================================
+
+static void record(const ReplayEvent &ev) {
+    portENTER_CRITICAL(&rec_mux);
+    if (recording) {
+        if (rec_count < REPLAY_MAX_EVENTS) {
+            evs[rec_count] = ev;
+            evs[rec_count].t_ms = millis() - rec_start_ms;
+            rec_count++;
+        } else {
+            rec_overflow = true;
+        }
+    }
+    portEXIT_CRITICAL(&rec_mux);
+}
+
+void replay_record_touch(const TouchPoint *pts, uint8_t n) {
+    ReplayEvent ev = {};
+    ev.kind = REPLAY_EV_TOUCH;
+    ev.count = n < TOUCH_MAX_POINTS ? n : TOUCH_MAX_POINTS;
+    for (uint8_t i = 0; i < ev.count; i++) ev.points[i] = { pts[i].id, pts[i].x, pts[i].y };
+    record(ev);
+}
+
+void replay_record_pins(uint16_t pins) {
+    ReplayEvent ev = {};
+    ev.kind = REPLAY_EV_PINS;
+    ev.pins = pins;
+    record(ev);
+}
+
+static void record_start() {
+    if (recording || running) return report_error(REPLAY_OP_RECORD, REPLAY_ERR_BUSY);
+    if (!sdcard_mounted()) return report_error(REPLAY_OP_RECORD, REPLAY_ERR_IO);
+    if (!alloc_buf()) {
+        Serial.println("REPLAY: out of memory");
+        return report_error(REPLAY_OP_RECORD, REPLAY_ERR_IO);
+    }
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->magic = REPLAY_MAGIC;
+    hdr->version = REPLAY_VERSION;
+    hdr->profile = (int8_t)ui_active_profile_index();
+    hdr->page = (uint8_t)ui_get_current_page();
+
+    portENTER_CRITICAL(&rec_mux);
+    rec_count = 0;
+    rec_overflow = false;
+    rec_start_ms = millis();
+    recording = true;
+    portEXIT_CRITICAL(&rec_mux);
+    Serial.printf("REPLAY: recording '%s' from profile %d page %u\n", name, hdr->profile, hdr->page);
+}
+
+static void record_stop() {
+    portENTER_CRITICAL(&rec_mux);
+    recording = false;
+    portEXIT_CRITICAL(&rec_mux);
+
+    hdr->events = rec_count;
+    hdr->duration_ms = millis() - rec_start_ms;
+    if (rec_overflow) Serial.printf("REPLAY: buffer full, kept the first %u events\n", rec_count);
+
+    char path[48];
+    file_path(path, sizeof(path), "rec");
+    sdcard_mkdir(REPLAY_DIR);
+    bool ok = rec_count > 0 &&
+              sdcard_write_file(path, buf, sizeof(ReplayFileHeader) + rec_count * sizeof(ReplayEvent));
+
+    ReplayReportMsg rep = {};
+    rep.op = REPLAY_OP_RECORD;
+    rep.status = ok ? REPLAY_OK : rec_count ? REPLAY_ERR_IO : REPLAY_ERR_BAD;
+    rep.events = rec_count;
+    rep.duration_ms = hdr->duration_ms;
+    free_buf();
+
+    if (ok) Serial.printf("REPLAY: saved %s, %u events over %lu ms\n", path, rep.events, (unsigned long)rep.duration_ms);
+    else Serial.printf("REPLAY: recording '%s' not saved (status %u)\n", name, rep.status);
+    send_report(rep);
+}
+
+// ============================================================
+// Replay
+// ============================================================
+
+static uint16_t triangle(uint32_t tick, uint16_t lo, uint16_t hi, uint16_t period) {
+    uint32_t half = period / 2;
+    uint32_t phase_pos = tick % period;
+    uint32_t t = phase_pos < half ? phase_pos : period - phase_pos;
+    return lo + (uint32_t)(hi - lo) * t / half;
+}
+
+// Same values on every run: the stat widgets redraw identically
+static void feed_stats() {
+    const uint8_t types[] = { STAT_CPU_PERCENT, STAT_RAM_PERCENT, STAT_GPU_PERCENT, STAT_CPU_TEMP,
+                              STAT_GPU_TEMP, STAT_DISK_PERCENT, STAT_NET_UP, STAT_NET_DOWN };
+    const uint16_t values[] = {
+        triangle(stats_tick, 5, 95, 20), triangle(stats_tick, 30, 70, 40),
+        triangle(stats_tick, 0, 100, 16), triangle(stats_tick, 40, 85, 30),
+        triangle(stats_tick, 35, 80, 24), 62,
+        triangle(stats_tick, 0, 2000, 10), triangle(stats_tick, 0, 20000, 14),
+    };
+    uint8_t tlv[1 + sizeof(types) * 4];
+    uint8_t pos = 1;
+    for (size_t i = 0; i < sizeof(types); i++) {
+        tlv[pos++] = types[i];
+        tlv[pos++] = TLV_ENC_UINT | 2;
+        tlv[pos++] = values[i] & 0xFF;
+        tlv[pos++] = values[i] >> 8;
+    }
+    tlv[0] = sizeof(types);
+    update_stats(tlv, pos, true, espnow_active_host());
+    stats_tick++;
+}
+
+static void release_all() {
+    touch_inject(nullptr, 0);
+    hw_input_inject(0xFFFF);
+}
+
+static void begin_pass() {
+    release_all();
+    uint32_t now = millis();
+    if (hdr->profile >= 0 && ui_active_profile_index() != hdr->profile) {
+        ui_switch_profile_index(hdr->profile);   // Applied by the next pass's deferred rebuild
+        phase = PHASE_PROFILE;
+    } else {
+        ui_goto_page(hdr->page);
+        phase = PHASE_PAGE;
+    }
+    phase_due_ms = now + REPLAY_SETTLE_MS;
+}
+
+static void fire(const ReplayEvent &ev) {
+    if (ev.kind == REPLAY_EV_PINS) {
+        hw_input_inject(ev.pins);
+        return;
+    }
+    TouchPoint pts[TOUCH_MAX_POINTS];
+    for (uint8_t i = 0; i < ev.count; i++) pts[i] = { ev.points[i].id, ev.points[i].x, ev.points[i].y };
+    touch_inject(pts, ev.count);
+}
+
+static void write_json(const ReplayReportMsg &rep) {
+    char json[512];
+    int n = snprintf(json, sizeof(json),
+        "{\"name\":\"%s\",\"status\":%u,\"events\":%u,\"duration_ms\":%lu,"
+        "\"frames\":%lu,\"frame_p50_ms\":%u,\"frame_p99_ms\":%u,\"frame_max_ms\":%u,\"frame_avg_us\":%lu,"
+        "\"flushes\":%lu,\"flush_px\":%lu,\"flush_avg_us\":%lu,"
+        "\"heap_min_free\":%lu,\"heap_delta\":%ld,\"psram_min_free\":%lu}\n",
+        name, rep.status, rep.events, (unsigned long)rep.duration_ms,
+        (unsigned long)rep.frames, rep.frame_p50_ms, rep.frame_p99_ms, rep.frame_max_ms,
+        (unsigned long)rep.frame_avg_us, (unsigned long)rep.flushes, (unsigned long)rep.flush_px,
+        (unsigned long)rep.flush_avg_us, (unsigned long)rep.heap_min_free, (long)rep.heap_delta,
+        (unsigned long)rep.psram_min_free);
+    char path[48];
+    file_path(path, sizeof(path), "json");
+    if (n > 0 && n < (int)sizeof(json)) sdcard_write_file(path, (const uint8_t *)json, n);
+}
+
+static void finish(uint8_t status) {
+    release_all();
+    running = false;
+
+    PerfCapture cap;
+    perf_capture_end(cap);
+    ReplayReportMsg rep = {};
+    rep.op = REPLAY_OP_RUN;
+    rep.status = status;
+    rep.events = events_fed > UINT16_MAX ? UINT16_MAX : (uint16_t)events_fed;
+    rep.duration_ms = millis() - run_start_ms;
+    rep.frames = cap.frames;
+    rep.frame_p50_ms = cap.frame_p50_ms;
+    rep.frame_p99_ms = cap.frame_p99_ms;
+    rep.frame_max_ms = cap.frame_max_ms;
+    rep.frame_avg_us = cap.frame_avg_us;
+    rep.flushes = cap.flushes;
+    rep.flush_px = cap.flush_px > UINT32_MAX ? UINT32_MAX : (uint32_t)cap.flush_px;
+    rep.flush_avg_us = cap.flushes ? (uint32_t)(cap.flush_us / cap.flushes) : 0;
+    rep.heap_min_free = cap.heap_min_free;
+    rep.heap_delta = (int32_t)cap.heap_end - (int32_t)cap.heap_start;
+    rep.psram_min_free = cap.psram_min_free;
+    free_buf();
+
+    Serial.printf("REPLAY: '%s' %s, %u events in %lu ms\n", name,
+                  status == REPLAY_STOPPED ? "stopped" : "done", rep.events, (unsigned long)rep.duration_ms);
+    Serial.printf("REPLAY: %lu frames p50=%ums p99=%ums max=%ums avg=%luus\n", (unsigned long)rep.frames,
+                  rep.frame_p50_ms, rep.frame_p99_ms, rep.frame_max_ms, (unsigned long)rep.frame_avg_us);
+    Serial.printf("REPLAY: %lu flushes %lu px avg=%luus, heap min=%lu delta=%ld, psram min=%lu\n",
+                  (unsigned long)rep.flushes, (unsigned long)rep.flush_px, (unsigned long)rep.flush_avg_us,
+                  (unsigned long)rep.heap_min_free, (long)rep.heap_delta, (unsigned long)rep.psram_min_free);
+    write_json(rep);
+    send_report(rep);
+}
+
+static void run_start(uint8_t loops) {
+    if (recording || running) return report_error(REPLAY_OP_RUN, REPLAY_ERR_BUSY);
+    if (!sdcard_mounted()) return report_error(REPLAY_OP_RUN, REPLAY_ERR_IO);
+    if (!alloc_buf()) {
+        Serial.println("REPLAY: out of memory");
+        return report_error(REPLAY_OP_RUN, REPLAY_ERR_IO);
+    }
+
+    char path[48];
+    file_path(path, sizeof(path), "rec");
+    int n = sdcard_read_file(path, buf, REPLAY_BUF_BYTES);
+    if (n < 0) {
+        free_buf();
+        return report_error(REPLAY_OP_RUN, REPLAY_ERR_IO);
+    }
+    if ((size_t)n < sizeof(ReplayFileHeader) || hdr->magic != REPLAY_MAGIC || hdr->version != REPLAY_VERSION ||
+        hdr->events == 0 || hdr->events > REPLAY_MAX_EVENTS ||
+        (size_t)n < sizeof(ReplayFileHeader) + hdr->events * sizeof(ReplayEvent)) {
+        free_buf();
+        return report_error(REPLAY_OP_RUN, REPLAY_ERR_BAD);
+    }
+    if (!perf_capture_begin()) {
+        free_buf();
+        Serial.println("REPLAY: no memory for the frame capture");
+        return report_error(REPLAY_OP_RUN, REPLAY_ERR_IO);
+    }
+
+    loops_left = loops ? loops : 1;
+    events_fed = 0;
+    stats_tick = 0;
+    run_start_ms = next_stats_ms = millis();
+    running = true;
+    Serial.printf("REPLAY: '%s', %u events over %lu ms, %u pass(es)\n", name, hdr->events,
+                  (unsigned long)hdr->duration_ms, loops_left);
+    begin_pass();
+}
+
+uint32_t replay_update() {
+    if (!running) return UINT32_MAX;
+    uint32_t now = millis();
+
+    if ((int32_t)(now - next_stats_ms) >= 0) {
+        feed_stats();
+        next_stats_ms += REPLAY_STATS_MS;
+    }
+    uint32_t wait = next_stats_ms - now;
+
+    if (phase != PHASE_RUN) {
+        if ((int32_t)(now - phase_due_ms) < 0) return min(wait, phase_due_ms - now);
+        if (phase == PHASE_PROFILE) {
+            ui_goto_page(hdr->page);
+            phase = PHASE_PAGE;
+            phase_due_ms = now + REPLAY_SETTLE_MS;
+            return min(wait, (uint32_t)REPLAY_SETTLE_MS);
+        }
+        phase = PHASE_RUN;
+        pass_start_ms = now;
+        next_event = 0;
+    }
+
+    uint32_t elapsed = now - pass_start_ms;
+    while (next_event < hdr->events && evs[next_event].t_ms <= elapsed) {
+        fire(evs[next_event++]);
+        events_fed++;
+    }
+    if (next_event < hdr->events) return min(wait, evs[next_event].t_ms - elapsed);
+    if (elapsed < hdr->duration_ms) return min(wait, hdr->duration_ms - elapsed);
+
+    if (--loops_left > 0) {
+        begin_pass();
+        return 0;
+    }
+    finish(REPLAY_OK);
+    return UINT32_MAX;
+}
+
+// ============================================================
+// MSG_REPLAY
+// ============================================================
+
+void replay_handle(const ReplayCmdMsg &cmd) {
+    switch (cmd.op) {
+        case REPLAY_OP_RECORD:
+        case REPLAY_OP_RUN:
+            if (recording || running) return report_error(cmd.op, REPLAY_ERR_BUSY);
+            if (!set_name(cmd.name)) {
+                name[0] = '\0';
+                return report_error(cmd.op, REPLAY_ERR_BAD);
+            }
+            if (cmd.op == REPLAY_OP_RECORD) record_start();
+            else run_start(cmd.loops);
+            return;
+        case REPLAY_OP_STOP:
+            if (recording) record_stop();
+            else if (running) finish(REPLAY_STOPPED);
+            else report_error(REPLAY_OP_STOP, REPLAY_ERR_BAD);
+            return;
+        default:
+            LOG_W("REPLAY: unknown op %u\n", cmd.op);
+            return;
+    }
+}
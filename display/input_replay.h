@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include "protocol.h"
+#include "touch.h"
+
+// ============================================================
+// Input record / replay (MSG_REPLAY, see protocol.h)
+//
+// Recording taps the input task: every change of the GT911 point set
+// (touch_poll) and of the PCF8575 pins (hw_input_sample) goes into a PSRAM
+// buffer with its millis() offset, along with the profile and page it
+// started on. Stopping saves it to /replay/<name>.rec.
+//
+// Replaying loads the file, returns to that profile and page, and feeds
+// the events back on schedule: points through touch_inject() (so
+// touch_read_cb, gestures and the down hook see them as the GT911's),
+// pins through hw_input_inject() (debounce, encoder decode, action_run()).
+// While it runs the real touch panel and buttons are muted, the
+// companion's stats are ignored in favour of a scripted 1 Hz feed, and
+// action_run() only runs panel-local actions (actions.cpp). perf.h
+// captures every frame and flush plus the heap low-water marks; the
+// report goes to the companion (MSG_REPLAY_REPORT), to Serial and to
+// /replay/<name>.json.
+//
+// Started by the companion (hotkey_companion.py --record / --replay).
+// ============================================================
+
+#define REPLAY_DIR          "/replay"
+#define REPLAY_MAX_EVENTS   8192   // ~270 KB of PSRAM while recording or replaying
+#define REPLAY_STATS_MS     1000   // Scripted stats period
+#define REPLAY_SETTLE_MS    300    // After the profile / page switch, before the clock starts
+
+// MSG_REPLAY from the main loop (UI task)
+void replay_handle(const ReplayCmdMsg &cmd);
+
+// Due events and stats, the end of a pass. Returns ms until the next one
+// (UINT32_MAX when idle). Call every loop() pass.
+uint32_t replay_update();
+
+// Any task
+bool replay_running();     // Replaying: real input muted, actions panel-local
+bool replay_recording();
+
+// Input task, from touch_poll() / hw_input_sample() while recording
+void replay_record_touch(const TouchPoint *pts, uint8_t n);
+void replay_record_pins(uint16_t pins);
+
+// Most recent finished record/replay, for GET /api/perf (status 0xFF = none yet)
+void replay_last_report(ReplayReportMsg &out);
@@ -0,0 +1,278 @@
+/**
+ * @file live_edit.cpp
+ * WebSocket live-edit channel for the config server
+ *
+ * Just enough RFC 6455 for one editor: the upgrade handshake, masked
+ * client frames up to LIVE_EDIT_MAX_MSG (no fragmentation, no
+ * extensions), text/ping/close. Frames are reassembled in one PSRAM
+ * buffer from the non-blocking WiFiClient as the network task polls.
+ */
+
+#include "live_edit.h"
+#include <Arduino.h>
+#include <WiFi.h>
+#include <mbedtls/base64.h>
+#include <mbedtls/sha1.h>
+#include <string.h>
+#include "config.h"
+#include "mem_budget.h"
+#include "ui.h"
+#include "tasks.h"
+
+#define WS_GUID        "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define WS_OP_TEXT     0x1
+#define WS_OP_CLOSE    0x8
+#define WS_OP_PING     0x9
+#define WS_OP_PONG     0xA
+#define WS_REQUEST_MAX 1024                       // Upgrade request, headers included
+#define WS_RX_SIZE     (LIVE_EDIT_MAX_MSG + 8)    // Payload + longest client header we take
+
+static WiFiServer *ws_server = nullptr;
+static WiFiClient ws_client;
+static bool ws_open = false;          // Handshake done
+static uint8_t *rx = nullptr;         // WS_RX_SIZE + 1 (request terminator)
+static size_t rx_len = 0;
+static uint32_t rev = 0;              // Edits applied since boot
+static bool save_pending = false;
+static uint32_t last_edit_ms = 0;
+
+// ============================================================
+// UI side (ui_post)
+// ============================================================
+
+// The editor wants to see the pages, not the SoftAP instructions
+static void show_layout_cb(uint32_t page) {
+    hide_config_screen();
+    if ((int)page != ui_get_current_page()) ui_goto_page((int)page);
+}
+
+static void show_config_cb(uint32_t) {
+    show_config_screen();
+}
+
+// ============================================================
+// Frames
+// ============================================================
+
+static void send_frame(uint8_t opcode, const uint8_t *data, size_t len) {
+    uint8_t hdr[4] = { (uint8_t)(0x80 | opcode) };
+    size_t hdr_len = 2;
+    if (len < 126) {
+        hdr[1] = (uint8_t)len;
+    } else {
+        hdr[1] = 126;
+        hdr[2] = len >> 8;
+        hdr[3] = len & 0xFF;
+        hdr_len = 4;
+    }
+    ws_client.write(hdr, hdr_len);
+    if (len) ws_client.write(data, len);
+}
+
+static void drop_client(uint16_t close_code, const char *why) {
+    if (ws_open && close_code) {
+        uint8_t code[2] = { (uint8_t)(close_code >> 8), (uint8_t)(close_code & 0xFF) };
+        send_frame(WS_OP_CLOSE, code, sizeof(code));
+    }
+    Serial.printf("Live edit: client dropped (%s)\n", why);
+    ws_client.stop();
+    if (ws_open) ui_post(show_config_cb);
+    ws_open = false;
+    rx_len = 0;
+}
+
+static void save_now() {
+    save_pending = false;
+    ui_lock();
+    bool ok = config_save(get_global_config());
+    ui_unlock();
+    Serial.printf("Live edit: %s /config.json (rev %lu)\n", ok ? "saved" : "FAILED to save",
+                  (unsigned long)rev);
+}
+
+static void handle_patch(const uint8_t *json, size_t len) {
+    int page = -1;
+    ui_lock();
+    const char *err = config_apply_patch(get_global_config(), (const char *)json, len, &page);
+    if (!err) request_ui_rebuild();
+    ui_unlock();
+
+    char reply[96];
+    if (err) {
+        Serial.printf("Live edit: patch rejected: %s\n", err);
+        snprintf(reply, sizeof(reply), "{\"ok\":false,\"error\":\"%s\"}", err);
+    } else {
+        rev++;
+        save_pending = true;
+        last_edit_ms = millis();
+        if (page >= 0) ui_post(show_layout_cb, (uint32_t)page);
+        snprintf(reply, sizeof(reply), "{\"ok\":true,\"rev\":%lu}", (unsigned long)rev);
+    }
+    send_frame(WS_OP_TEXT, (const uint8_t *)reply, strlen(reply));
+}
+
+// One complete frame at the start of rx: returns the bytes it used, 0 if it
+// hasn't all arrived (or the client was dropped)
+static size_t take_frame() {
+    if (rx_len < 2) return 0;
+    uint8_t opcode = rx[0] & 0x0F;
+    bool fin = rx[0] & 0x80;
+    size_t len = rx[1] & 0x7F;
+    size_t pos = 2;
+    if (!(rx[1] & 0x80)) {
+        drop_client(1002, "unmasked frame");
+        return 0;
+    }
+    if (len == 126) {
+        if (rx_len < 4) return 0;
+        len = (size_t)rx[2] << 8 | rx[3];
+        pos = 4;
+    }
+    if (len == 127 || len > LIVE_EDIT_MAX_MSG) {
+        drop_client(1009, "frame too large");
+        return 0;
+    }
+    if (rx_len < pos + 4 + len) return 0;
+
+    const uint8_t *mask = rx + pos;
+    uint8_t *payload = rx + pos + 4;
+    for (size_t i = 0; i < len; i++) payload[i] ^= mask[i & 3];
+
+    switch (opcode) {
+        case WS_OP_TEXT:
+            if (!fin) {
+                drop_client(1009, "fragmented frame");
+                return 0;
+            }
+            handle_patch(payload, len);
+            break;
+        case WS_OP_PING:
+            send_frame(WS_OP_PONG, payload, len);
+            break;
+        case WS_OP_PONG:
+            break;
+        case WS_OP_CLOSE:
+            drop_client(1000, "closed by editor");
+            return 0;
+        default:
+            drop_client(1003, "binary or continuation frame");
+            return 0;
+    }
+    return pos + 4 + len;
+}
+
+// ============================================================
+// Handshake
+// ============================================================
+
+// Value of header `name` (case-insensitive) in a terminated request
+static bool header_value(const char *req, const char *name, char *out, size_t out_size) {
+    size_t n = strlen(name);
+    for (const char *line = strstr(req, "\r\n"); line; line = strstr(line, "\r\n")) {
+        line += 2;
+        if (strncasecmp(line, name, n) != 0 || line[n] != ':') continue;
+        const char *v = line + n + 1;
+        while (*v == ' ') v++;
+        size_t len = strcspn(v, "\r\n");
+        if (len >= out_size) return false;
+        memcpy(out, v, len);
+        out[len] = '\0';
+        return true;
+    }
+    return false;
+}
+
+// Returns the request length once it is complete and answered, else 0
+static size_t take_handshake() {
+    rx[rx_len] = '\0';
+    const char *req = (const char *)rx;
+    const char *end = strstr(req, "\r\n\r\n");
+    if (!end) {
+        if (rx_len >= WS_REQUEST_MAX) drop_client(0, "request too large");
+        return 0;
+    }
+
+    char key[64];
+    if (strncmp(req, "GET /api/live ", 14) != 0 || !header_value(req, "Sec-WebSocket-Key", key, sizeof(key))) {
+        ws_client.print("HTTP/1.1 404 Not Found\r\nConnection: close\r\nContent-Length: 0\r\n\r\n");
+        drop_client(0, "not a live-edit upgrade");
+        return 0;
+    }
+
+    char src[sizeof(key) + sizeof(WS_GUID)];
+    snprintf(src, sizeof(src), "%s" WS_GUID, key);
+    uint8_t sha[20];
+    mbedtls_sha1((const uint8_t *)src, strlen(src), sha);
+    uint8_t accept[32];
+    size_t accept_len = 0;
+    mbedtls_base64_encode(accept, sizeof(accept) - 1, &accept_len, sha, sizeof(sha));
+    accept[accept_len] = '\0';
+    ws_client.printf("HTTP/1.1 101 Switching Protocols\r\n"
+                     "Upgrade: websocket\r\n"
+                     "Connection: Upgrade\r\n"
+                     "Sec-WebSocket-Accept: %s\r\n\r\n", (const char *)accept);
+
+    ws_open = true;
+    Serial.println("Live edit: editor connected");
+    ui_post(show_layout_cb, (uint32_t)ui_get_current_page());
+    return (end + 4) - req;
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+void live_edit_start() {
+    if (ws_server) return;
+    if (!rx) rx = (uint8_t *)mem_alloc(MEM_POOL_UPLOAD, WS_RX_SIZE + 1);
+    if (!rx) {
+        Serial.println("Live edit: out of memory, disabled");
+        return;
+    }
+    ws_server = new WiFiServer(LIVE_EDIT_PORT);
+    ws_server->begin();
+    ws_server->setNoDelay(true);
+    Serial.printf("Live edit: ws://%s:%d/api/live\n", WiFi.softAPIP().toString().c_str(), LIVE_EDIT_PORT);
+}
+
+void live_edit_stop() {
+    if (!ws_server) return;
+    if (ws_client) drop_client(1001, "server stopping");
+    ws_server->end();
+    delete ws_server;
+    ws_server = nullptr;
+    if (save_pending) save_now();
+}
+
+bool live_edit_service() {
+    if (!ws_server) return false;
+    bool traffic = false;
+
+    if (!ws_client.connected()) {
+        if (ws_open) drop_client(0, "disconnected");
+        else ws_client.stop();
+        ws_client = ws_server->accept();
+        if (ws_client) {
+            ws_client.setNoDelay(true);
+            rx_len = 0;
+            traffic = true;
+        }
+    }
+
+    while (ws_client.connected() && ws_client.available() > 0 && rx_len < WS_RX_SIZE) {
+        int n = ws_client.read(rx + rx_len, WS_RX_SIZE - rx_len);
+        if (n <= 0) break;
+        rx_len += n;
+        traffic = true;
+
+        for (;;) {
+            size_t used = ws_open ? take_frame() : take_handshake();
+            if (!used) break;
+            memmove(rx, rx + used, rx_len - used);
+            rx_len -= used;
+        }
+    }
+
+    if (save_pending && millis() - last_edit_ms >= LIVE_EDIT_SAVE_MS) save_now();
+    return traffic;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+
+// ============================================================
+// Live edit: layout patches over a WebSocket while the SoftAP is up
+//
+// ws://<softap-ip>:LIVE_EDIT_PORT/api/live, one client at a time. Each text
+// frame is a patch for the active profile (format: config_apply_patch() in
+// config.h). It goes into the in-memory config under the UI lock and the
+// pages follow on the next loop pass (rebuild_ui() only moves or recreates
+// the widgets that changed, so a drag is an lv_obj_set_pos()). Every frame
+// is answered with {"ok":true,"rev":N} or {"ok":false,"error":"..."}.
+//
+// /config.json is written LIVE_EDIT_SAVE_MS after the last edit rather
+// than per frame, and on stop. Network task only (config_server.cpp).
+// ============================================================
+
+#ifndef LIVE_EDIT_PORT
+#define LIVE_EDIT_PORT 81
+#endif
+#ifndef LIVE_EDIT_SAVE_MS
+#define LIVE_EDIT_SAVE_MS 2000     // Quiet time before edits are saved to SD
+#endif
+#ifndef LIVE_EDIT_MAX_MSG
+#define LIVE_EDIT_MAX_MSG 8192     // Largest patch frame accepted
+#endif
+
+void live_edit_start();
+void live_edit_stop();             // Drops the client, saves pending edits
+
+// Returns true when the client sent anything (counts as server activity)
+bool live_edit_service();
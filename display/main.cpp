@@ -4,8 +4,11 @@
 #include <sys/time.h>
 #include "display_hw.h"
 #include "touch.h"
+#include "i2c_bus.h"
 #include "ui.h"
 #include "espnow_link.h"
+#include "ble_hid.h"
+#include "wired_link.h"
 #include "protocol.h"
 #include "battery.h"
 #include "power.h"
@@ -13,20 +16,72 @@
 #include "config.h"
 #include "config_server.h"
 #include "hw_input.h"
+#include "events.h"
+#include "perf.h"
+#include "bulk_xfer.h"
+#include "tasks.h"
+#include "bench.h"
+#include "input_replay.h"
+#include "anim_icon.h"
+#include "status_store.h"
+#include "ota_update.h"
+#include "log.h"
+#include "trace.h"
+#include "loop_watch.h"
+#include "clock_sync.h"
+#include "runtime_state.h"
+#include "stats_log.h"
+#include "draw_accel.h"
+#include "clock_direct.h"
+#include "ui_jobs.h"
 
-static uint32_t touch_timer = 0;
 static uint32_t last_stats_time = 0;
 static bool stats_active = false;
 
-// Power/battery timing
-static uint32_t battery_timer = 0;
+// Power/link timing
 static uint32_t device_status_timer = 0;
-static uint32_t clock_update_timer = 0;
 static uint32_t last_bridge_msg_time = 0;
 static const uint32_t BRIDGE_LINK_TIMEOUT_MS = 10000;  // 10s to consider link stale
 
-// Hardware input (PCF8575 buttons + encoder) polling timer
-static uint32_t encoder_timer = 0;
+// Event-driven loop timing (touch/button polling lives in the input task, tasks.cpp)
+static const uint32_t MAX_SLEEP_MS = 100;  // Upper bound so housekeeping stays responsive
+
+// A loop() pass longer than this is logged as a stall (loop_watch.h).
+// Three frames at 60 Hz: a rebuild or a cold SD read gets past it, a
+// normal pass stays well under a millisecond.
+#ifndef LOOP_STALL_BUDGET_US
+#define LOOP_STALL_BUDGET_US 50000
+#endif
+
+// loop() sections, in pass order
+enum LoopSection : uint8_t {
+    LS_UI_LOCK,      // Waiting for the UI lock: config server / net task handlers
+    LS_POSTED,       // ui_post() calls, serial console
+    LS_TOUCH,
+    LS_HW_INPUT,
+    LS_ANIM,         // Animated icon frames (decode budget)
+    LS_JOBS,         // Time-sliced UI jobs: page builds and patches, picture index
+    LS_LVGL,         // lv_timer_handler: rendering, LVGL timers, widget ticks; direct clock
+    LS_REBUILD,      // Deferred UI rebuild
+    LS_POWER,        // Config server timeout, power state machine, OTA
+    LS_ESPNOW,       // Link update, ACKs, message handlers, clock sync
+    LS_BLE,          // BLE HID releases, macro steps, connection parameters
+    LS_BENCH,
+    LS_HEARTBEAT,    // Stats timeout, device status, link counters
+    LS_BATTERY,
+    LS_STATUS,       // Clock and status redraws, runtime state
+    LS_COUNT
+};
+static const char *const LOOP_SECTION_NAMES[LS_COUNT] = {
+    "ui_lock", "posted", "touch", "hw_input", "anim", "jobs", "lvgl", "rebuild",
+    "power", "espnow", "ble", "bench", "heartbeat", "battery", "status",
+};
+
+// Milliseconds until `period` has elapsed since `last` (0 if already due)
+static uint32_t ms_until(uint32_t last, uint32_t period) {
+    uint32_t elapsed = millis() - last;
+    return elapsed >= period ? 0 : period - elapsed;
+}
 
 // Global config with program lifetime (ButtonConfig* in LVGL events point into this)
 static AppConfig g_app_config;
@@ -34,66 +89,530 @@ static AppConfig g_app_config;
 // Deferred UI rebuild flag (set by config_server, consumed by loop)
 static volatile bool g_rebuild_pending = false;
 
-// Public accessor for global config (used by config_server to update config)
+// An uploaded config parsed off the UI task, waiting for loop() to swap it
+// in (stage_config). Only the pointer handoff is under the spinlock.
+static AppConfig *g_staged_config = nullptr;
+static portMUX_TYPE g_staged_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// One config_load() off the UI task at a time: they share the snapshot cache file
+static SemaphoreHandle_t g_reload_mutex = nullptr;
+
+// Public accessor for global config (UI task: live edit, profile switching)
 AppConfig& get_global_config() { return g_app_config; }
 
+void stage_config(AppConfig *cfg) {
+    portENTER_CRITICAL(&g_staged_mux);
+    AppConfig *replaced = g_staged_config;
+    g_staged_config = cfg;
+    portEXIT_CRITICAL(&g_staged_mux);
+    delete replaced;   // Never swapped in, so nothing points into it
+    request_ui_rebuild();
+}
+
+static AppConfig *take_staged_config() {
+    portENTER_CRITICAL(&g_staged_mux);
+    AppConfig *cfg = g_staged_config;
+    g_staged_config = nullptr;
+    portEXIT_CRITICAL(&g_staged_mux);
+    return cfg;
+}
+
+const char *config_reload_staged() {
+    xSemaphoreTake(g_reload_mutex, portMAX_DELAY);
+    bool from_sd = false;
+    AppConfig *cfg = new AppConfig(config_load(&from_sd));
+    xSemaphoreGive(g_reload_mutex);
+    const ProfileConfig *profile = cfg->get_active_profile();
+    if (!from_sd || !profile || profile->pages.empty()) {
+        delete cfg;
+        return from_sd ? "Config loaded but has no valid pages" : "Config is not valid JSON or has no valid profile";
+    }
+    Serial.printf("Config: staged new config, profile: %s, %zu pages\n",
+                  cfg->active_profile_name.c_str(), profile->pages.size());
+    stage_config(cfg);
+    return nullptr;
+}
+
+// Gesture recognition follows the config (swipes are always page navigation)
+static void apply_gesture_config(const GestureConfig &gc) {
+    uint8_t mask = 0;
+    if (gc.swipe_pages) mask |= GESTURE_BIT(GESTURE_SWIPE_LEFT) | GESTURE_BIT(GESTURE_SWIPE_RIGHT);
+    if (gc.two_finger_tap.enabled) mask |= GESTURE_BIT(GESTURE_TWO_FINGER_TAP);
+    if (gc.long_press.enabled) mask |= GESTURE_BIT(GESTURE_LONG_PRESS);
+    touch_set_gestures(mask);
+}
+
+static void handle_gesture(TouchGesture gesture) {
+    // Gestures only drive the hotkey pages, not clock/slideshow/config screens
+    if (display_get_mode() != MODE_HOTKEYS || config_server_active()) return;
+
+    const GestureConfig &gc = g_app_config.gestures;
+    const GestureAction *bound = nullptr;
+    switch (gesture) {
+        case GESTURE_SWIPE_LEFT:     ui_swipe_page(1); break;
+        case GESTURE_SWIPE_RIGHT:    ui_swipe_page(-1); break;
+        case GESTURE_TWO_FINGER_TAP: bound = &gc.two_finger_tap; break;
+        case GESTURE_LONG_PRESS:     bound = &gc.long_press; break;
+        default: break;
+    }
+    if (bound) {
+        hw_input_run_action(bound->action_type, bound->keycode, bound->consumer_code, bound->modifiers);
+    }
+    LOG_D("[main] gesture %d\n", gesture);
+}
+
 // Public function to request deferred UI rebuild from loop() context
-void request_ui_rebuild() { g_rebuild_pending = true; }
+void request_ui_rebuild() {
+    g_rebuild_pending = true;
+    events_post(EVT_UI_REQUEST);
+}
+
+// ESP-NOW message handlers (espnow_dispatch() from loop(), UI lock held).
+// Payloads are views into the RX queue, valid until the handler returns.
+static bool on_bridge_msg(const EspnowMsg &msg) {
+    // Background hosts only feed their stats: no link activity, no wake-up
+    if (msg.host != espnow_active_host()) return true;
+    last_bridge_msg_time = millis();
+    power_activity();
+
+    // Wake detection: if in CLOCK mode and a non-shutdown message arrives, wake up
+    // (a wake result alone says nothing about the PC being up)
+    if (power_get_state() == POWER_CLOCK && msg.type != MSG_POWER_STATE && msg.type != MSG_WAKE_HOST) {
+        power_wake_detected();
+        show_hotkey_view();
+    }
+    return true;
+}
+
+static void on_stats(const EspnowMsg &msg) {
+    if (msg.len < 1) return;
+    // A replay draws its own scripted stats; the link bookkeeping carries on
+    if (!replay_running()) update_stats(msg.payload, msg.len, msg.version >= PROTO_VERSION, msg.host);
+    if (msg.host != espnow_active_host()) return;
+    last_stats_time = millis();
+    stats_active = true;
+    status_set_pc_active(true);
+}
+
+static void on_host_stats(const EspnowMsg &msg) {
+    if (msg.len < 2 || replay_running()) return;
+    update_remote_stats(msg.payload[0], msg.payload + 1, msg.len - 1);
+}
+
+static void on_power_state(const EspnowMsg &msg) {
+    if (msg.len < sizeof(PowerStateMsg)) return;
+    const PowerStateMsg *ps = (const PowerStateMsg *)msg.payload;
+    if (ps->state == POWER_SHUTDOWN || ps->state == POWER_LOCKED) {
+        power_shutdown_received();
+        show_clock_mode();
+    } else if (ps->state == POWER_WAKE) {
+        if (power_get_state() == POWER_CLOCK) {
+            power_wake_detected();
+            show_hotkey_view();
+        }
+    }
+}
+
+// How the bridge's USB remote wakeup went (send_wake_to_bridge)
+static void on_wake_host(const EspnowMsg &msg) {
+    if (msg.len < sizeof(WakeHostMsg)) return;
+    WakeHostMsg w;
+    memcpy(&w, msg.payload, sizeof(w));
+    if (w.op != WAKE_RESULT) return;
+    char summary[48];
+    switch (w.status) {
+        case WAKE_SIGNALLED:
+            Serial.println("[wake] bridge signalled USB remote wakeup");
+            return;
+        case WAKE_BUS_AWAKE:
+            Serial.println("[wake] USB bus not suspended, waiting for the PC");
+            return;
+        case WAKE_NOT_ARMED:
+            Serial.println("[wake] PC has USB wakeup disabled for the bridge");
+            show_notification_toast("Display", "PC won't wake over USB", "Enable wakeup for the bridge", NOTIF_LOW);
+            return;
+        case WAKE_DONE:
+            if (w.resume_ms != 0xFFFF) {
+                Serial.printf("[wake] PC awake after %lu ms (USB resumed after %u ms)\n",
+                              (unsigned long)w.latency_ms, w.resume_ms);
+            } else {
+                Serial.printf("[wake] PC awake after %lu ms\n", (unsigned long)w.latency_ms);
+            }
+            snprintf(summary, sizeof(summary), "PC awake in %lu.%lu s", (unsigned long)(w.latency_ms / 1000),
+                     (unsigned long)(w.latency_ms % 1000 / 100));
+            show_notification_toast("Display", summary, "", NOTIF_LOW);
+            return;
+        case WAKE_TIMEOUT:
+            Serial.printf("[wake] no word from the PC after %lu ms\n", (unsigned long)w.latency_ms);
+            show_notification_toast("Display", "PC did not wake", "", NOTIF_LOW);
+            return;
+    }
+}
+
+#define CLOCK_WALL_STEP_US 20000   // Wall clock further off than this from the shared timebase gets set
+
+static void on_time_sync(const EspnowMsg &msg) {
+    if (msg.len < 4) return;
+    const TimeSyncMsg *ts = (const TimeSyncMsg *)msg.payload;
+    // Whole seconds, sent without latency compensation: only until MSG_CLOCK_SYNC has locked
+    if (!clock_sync_valid()) {
+        struct timeval tv = { .tv_sec = (time_t)ts->epoch_seconds, .tv_usec = 0 };
+        settimeofday(&tv, nullptr);
+    }
+    // Set timezone if offset provided (len >= 6 means new format with tz_offset)
+    if (msg.len >= sizeof(TimeSyncMsg)) {
+        int16_t offset_min = ts->tz_offset_min;
+        // POSIX TZ uses inverted sign: UTC+5 = "UTC-5"
+        int hours = -(offset_min / 60);
+        int mins = abs(offset_min % 60);
+        char tz_buf[16];
+        snprintf(tz_buf, sizeof(tz_buf), "UTC%+d:%02d", hours, mins);
+        setenv("TZ", tz_buf, 1);
+        tzset();
+    }
+    status_clock_resync();  // Clocks show the new time now, not at the next minute
+    Serial.printf("Time synced: %lu\n", (unsigned long)ts->epoch_seconds);
+}
+
+// The bridge's answer to our clock_sync_poll() request (loop()). The shared
+// timebase is the companion's Unix time, so it also keeps the wall clock right.
+static void on_clock_sync(const EspnowMsg &msg) {
+    ClockSyncMsg reply;
+    if (msg.len < sizeof(reply)) return;
+    memcpy(&reply, msg.payload, sizeof(reply));
+    bool stepped;
+    if (!clock_sync_sample(reply, clock_local_from_micros(msg.rx_us), &stepped)) return;
+    if (stepped) {
+        Serial.printf("Clock: locked to bridge (round trip %lu us)\n", (unsigned long)clock_sync.delay_us);
+    } else {
+        LOG_D("Clock: error %ld us, drift %.2f ppm, round trip %lu us\n", (long)clock_sync.last_error_us,
+              clock_sync.drift_ppm, (unsigned long)clock_sync.delay_us);
+    }
+
+    int64_t host = clock_sync_now_us();
+    struct timeval now;
+    gettimeofday(&now, nullptr);
+    int64_t off = host - ((int64_t)now.tv_sec * 1000000 + now.tv_usec);
+    if (off > -CLOCK_WALL_STEP_US && off < CLOCK_WALL_STEP_US) return;
+    struct timeval tv = { .tv_sec = (time_t)(host / 1000000), .tv_usec = (suseconds_t)(host % 1000000) };
+    settimeofday(&tv, nullptr);
+    status_clock_resync();
+}
+
+static void on_notification(const EspnowMsg &msg) {
+    // Own copy: the strings get terminated and the slot is read-only
+    static NotifText notif;
+    if (!notif_parse(msg.payload, msg.len, notif)) {
+        LOG_W("Notification: malformed (%u bytes)\n", msg.len);
+        return;
+    }
+    show_notification_toast(notif.app_name, notif.summary, notif.body, notif.urgency);
+}
+
+static void on_profile_switch(const EspnowMsg &msg) {
+    if (msg.len < 1) return;
+    ProfileSwitchMsg ps = {};
+    memcpy(ps.name, msg.payload, msg.len < sizeof(ps.name) ? msg.len : sizeof(ps.name) - 1);
+    ps.name[sizeof(ps.name) - 1] = '\0';
+    ui_switch_profile(ps.name);
+}
+
+static void on_action_result(const EspnowMsg &msg) {
+    if (msg.len < sizeof(ActionResultMsg)) return;
+    ActionResultMsg res;
+    memcpy(&res, msg.payload, sizeof(res));
+    uint32_t rtt_ms = millis() - res.display_ms;
+    perf_record_press(rtt_ms, res.host_queue_us, res.host_exec_ms, res.status == ACTION_RESULT_OK);
+    trace(TR_PRESS_RESULT, res.press_id, (uint32_t)res.status << 24 | (rtt_ms & 0xFFFFFF));
+    LOG_D("Button press #%u: status=%u rtt=%lums (host queue %uus, exec %ums)\n",
+          res.press_id, res.status, (unsigned long)rtt_ms, res.host_queue_us, res.host_exec_ms);
+}
+
+static void on_ddc_state(const EspnowMsg &msg) {
+    if (msg.len < sizeof(DdcStateMsg)) return;
+    DdcStateMsg st;
+    memcpy(&st, msg.payload, sizeof(st));
+    char name[16];
+    switch (st.vcp_code) {
+        case 0x10: snprintf(name, sizeof(name), "Brightness"); break;
+        case 0x12: snprintf(name, sizeof(name), "Contrast"); break;
+        case 0x62: snprintf(name, sizeof(name), "Volume"); break;
+        default:   snprintf(name, sizeof(name), "VCP 0x%02X", st.vcp_code); break;
+    }
+    ui_show_level(name, st.value, st.max_value);
+    LOG_D("DDC state: vcp=0x%02X value=%u/%u disp=%u\n", st.vcp_code, st.value, st.max_value,
+          st.display_num);
+}
+
+static void on_bench_echo(const EspnowMsg &msg) {
+    bench_on_echo(msg.payload, msg.len);
+}
+
+static void on_bench_start(const EspnowMsg &msg) {
+    if (msg.len < sizeof(BenchStartMsg)) return;
+    BenchStartMsg bs;
+    memcpy(&bs, msg.payload, sizeof(bs));
+    bench_start(bs.rate_hz, bs.count);
+}
+
+static void on_replay(const EspnowMsg &msg) {
+    if (msg.len < sizeof(ReplayCmdMsg)) return;
+    ReplayCmdMsg cmd;
+    memcpy(&cmd, msg.payload, sizeof(cmd));
+    replay_handle(cmd);
+}
+
+static void on_bulk(const EspnowMsg &msg) {
+    bulk_handle_msg(msg.type, msg.payload, msg.len);
+}
+
+static void on_config_mode(const EspnowMsg &) {
+    if (!config_server_active()) {
+        Serial.println("CONFIG_MODE: starting SoftAP config server");
+        config_server_start();
+        show_config_screen();
+    }
+}
+
+static void on_config_done(const EspnowMsg &) {
+    if (config_server_active()) {
+        Serial.println("CONFIG_DONE: stopping config server");
+        config_server_stop();
+        hide_config_screen();
+    }
+}
+
+static void register_msg_handlers() {
+    espnow_set_rx_filter(on_bridge_msg);
+    espnow_register_handler(MSG_STATS, on_stats);
+    espnow_register_handler(MSG_HOST_STATS, on_host_stats);
+    espnow_register_handler(MSG_POWER_STATE, on_power_state);
+    espnow_register_handler(MSG_WAKE_HOST, on_wake_host);
+    espnow_register_handler(MSG_TIME_SYNC, on_time_sync);
+    espnow_register_handler(MSG_NOTIFICATION, on_notification);
+    espnow_register_handler(MSG_PROFILE_SWITCH, on_profile_switch);
+    espnow_register_handler(MSG_ACTION_RESULT, on_action_result);
+    espnow_register_handler(MSG_DDC_STATE, on_ddc_state);
+    espnow_register_handler(MSG_CLOCK_SYNC, on_clock_sync);
+    espnow_register_handler(MSG_BENCH_ECHO, on_bench_echo);
+    espnow_register_handler(MSG_BENCH_START, on_bench_start);
+    espnow_register_handler(MSG_REPLAY, on_replay);
+    espnow_register_handler(MSG_BULK_BEGIN, on_bulk);
+    espnow_register_handler(MSG_BULK_DATA, on_bulk);
+    espnow_register_handler(MSG_BULK_END, on_bulk);
+    espnow_register_handler(MSG_CONFIG_MODE, on_config_mode);
+    espnow_register_handler(MSG_CONFIG_DONE, on_config_done);
+}
+
+// SD mount + config parse on core 0 while setup() brings up the panel,
+// LVGL and the radio on core 1. Nothing else touches the SD card or
+// g_app_config until setup() has taken the notification.
+#ifndef BOOT_IO_STACK
+#define BOOT_IO_STACK 8192   // config_load() was sized for the loop task's stack
+#endif
+static TaskHandle_t boot_waiter = nullptr;
+
+static void boot_io_task(void *) {
+    perf_boot_mark("boot task start");   // Core 0's phases are timed from here
+    sdcard_init();       // Mount TF Card if present (non-fatal if absent)
+    perf_boot_mark("sd mount");
+    g_app_config = config_load();
+    perf_boot_mark("config load");
+    xTaskNotifyGive(boot_waiter);
+    vTaskDelete(nullptr);
+}
+
+static void on_battery_sample(const BatteryState &battery) {
+    power_record_battery(battery);   // Policy + status bar gauge
+}
 
 void setup() {
-    Serial.begin(115200);
+    wired_link_init();   // UART rings sized before begin()
+    Serial.begin(WIRED_LINK_BAUD);
     Serial.println("\n=== Display Unit Starting ===");
     Serial.printf("PSRAM: %d bytes (free %d)\n", ESP.getPsramSize(), ESP.getFreePsram());
     Serial.printf("Heap: %d bytes (free %d)\n", ESP.getHeapSize(), ESP.getFreeHeap());
+    perf_boot_mark("serial");
+
+    events_init();       // loop() is the event consumer (setup runs on the same task)
+    loop_watch_init(LOOP_SECTION_NAMES, LS_COUNT, LOOP_STALL_BUDGET_US);
+
+    g_reload_mutex = xSemaphoreCreateMutex();
+    boot_waiter = xTaskGetCurrentTaskHandle();
+    xTaskCreatePinnedToCore(boot_io_task, "boot_io", BOOT_IO_STACK, nullptr, 1, nullptr, 0);
 
     Wire.begin(19, 20);  // I2C SDA=19, SCL=20
 
-    touch_init();      // Create I2C mutex (must be before hw_input_init)
+    i2c_bus_init();    // Bus lock, 400 kHz; jobs run inline until tasks_start()
     display_init();    // PCA9557 touch reset + LCD init
+    perf_boot_mark("lcd init");
+    lvgl_init();       // LVGL buffers + drivers
+    perf_boot_mark("lvgl init");
+    ui_show_splash();
+    perf_boot_mark("splash");
     gt911_discover();  // Discover GT911 (after PCA9557 reset)
+    perf_boot_mark("touch probe");
     bool hw_ok = hw_input_init();
     Serial.printf("[main] hw_input_init: %s\n", hw_ok ? "PCF8575 FOUND" : "NOT FOUND (hw buttons disabled)");
-    lvgl_init();       // LVGL buffers + drivers
+    perf_boot_mark("hw input");
 
     espnow_link_init();  // ESP-NOW to bridge
+    register_msg_handlers();
+    perf_boot_mark("esp-now");
+#if BLE_HID_ENABLE
+    ble_hid_init();      // Optional bridge-less HID (ble_hid.h)
+    perf_boot_mark("ble hid");
+#endif
     battery_init();      // Try to find MAX17048 (non-fatal if absent)
-    sdcard_init();       // Mount TF Card if present (non-fatal if absent)
+    perf_boot_mark("battery");
 
-    // Load configuration from SD card (or use defaults)
-    g_app_config = config_load();
+    // Configuration from SD card (or defaults), loaded by boot_io_task
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    perf_boot_mark("wait sd/config");
     Serial.printf("Config: loaded profile '%s' with %zu page(s)\n",
                   g_app_config.active_profile_name.c_str(),
                   g_app_config.profiles.empty() ? 0 : g_app_config.get_active_profile()->pages.size());
+#if CONFIG_BENCH_AT_BOOT
+    config_benchmark(g_app_config);
+#endif
+#if DRAW_ACCEL_BENCH_AT_BOOT
+    draw_accel_benchmark();
+#endif
+
+    // Page, brightness preset, mode and focus from before the reboot (NVS).
+    // A copy: building the UI lands on page 0 first.
+    runtime_state_restore();
+    const RuntimeState saved_state = runtime_state_get();
+
+    // Stats history on SD: graphs backfill from it as the UI comes up
+    stats_log_begin();
 
     create_ui(&g_app_config);  // Build hotkey tabview UI with loaded config
+    apply_gesture_config(g_app_config.gestures);
+    ui_goto_page(saved_state.page);
+    perf_boot_mark("create ui");
 
     power_init();      // Set initial power state to ACTIVE
+    power_set_battery_thresholds(g_app_config.display_settings.battery_saver_pct,
+                                 g_app_config.display_settings.battery_critical_pct);
+
+    // Interrupt lines (optional; fall back to timed polling when not wired)
+    bool touch_int_enabled = events_attach_gpio(TOUCH_INT_GPIO, EVT_TOUCH_INT);
+    bool hw_input_int_enabled = hw_ok && events_attach_gpio(HW_INPUT_INT_GPIO, EVT_HW_INPUT);
+    if (battery_present()) events_attach_gpio(BATTERY_ALERT_GPIO, EVT_BATTERY_ALERT);
+    Serial.printf("[main] touch %s, hw_input %s\n",
+                  touch_int_enabled ? "INT" : "polled",
+                  hw_input_int_enabled ? "INT" : "polled");
+
+    ui_hide_splash();
+    if (saved_state.display_mode != RUNTIME_STATE_NONE && saved_state.display_mode <= MODE_STANDBY) {
+        display_set_mode((DisplayMode)saved_state.display_mode);
+    }
+    hw_input_restore_focus(saved_state.focus_index);
+    lv_refr_now(NULL);   // Real UI on the panel before other tasks may take the UI lock
+    perf_boot_mark("first frame");
+
+    // I2C polling and the config server move off this (UI) task
+    tasks_start(touch_int_enabled, hw_input_int_enabled);
 
     Serial.println("Display setup complete");
+    perf_boot_report();
 }
 
+// UI task: the only place LVGL runs. Holds the UI lock for the whole pass
+// and drops it only to sleep (see tasks.h).
 void loop() {
-    // Poll touch at ~20Hz
-    if (millis() - touch_timer >= 50) {
-        touch_timer = millis();
-        touch_poll();
+    // Sleep until an event arrives or the next deadline is due. Deadlines:
+    // LVGL's own timers, coalesced encoder steps and the periodic tasks below.
+    static uint32_t lv_sleep_ms = 0;
+    static uint32_t hw_input_wait_ms = UINT32_MAX;
+    static uint32_t bench_wait_ms = UINT32_MAX;
+    static uint32_t replay_wait_ms = UINT32_MAX;
+    static uint32_t clock_wait_ms = 0;
+    static uint32_t state_wait_ms = UINT32_MAX;
+    static uint32_t stats_log_wait_ms = UINT32_MAX;
+    static uint32_t battery_wait_ms = 0;
+    static uint32_t ble_wait_ms = UINT32_MAX;
+    static uint32_t anim_wait_ms = UINT32_MAX;
+    static uint32_t jobs_wait_ms = UINT32_MAX;
+    // Direct clock: LVGL stays stopped only while the last pass (a wake
+    // message, say) left nothing for it to draw; back to it at once if so
+    uint32_t max_sleep_ms = MAX_SLEEP_MS;
+    if (clock_direct_active()) {
+        clock_direct_update(power_get_state() == POWER_CLOCK);
+        max_sleep_ms = clock_direct_active() ? CLOCK_DIRECT_MAX_SLEEP_MS : 0;
+    }
+    uint32_t wait_ms = lv_sleep_ms;
+    wait_ms = min(wait_ms, hw_input_wait_ms);
+    wait_ms = min(wait_ms, bench_wait_ms);
+    wait_ms = min(wait_ms, replay_wait_ms);   // Next replayed input event
+    wait_ms = min(wait_ms, ms_until(device_status_timer, power_heartbeat_ms()));
+    wait_ms = min(wait_ms, clock_wait_ms);  // Next minute boundary
+    wait_ms = min(wait_ms, state_wait_ms);  // Coalesced runtime state write
+    wait_ms = min(wait_ms, stats_log_wait_ms);  // Stats log block write
+    wait_ms = min(wait_ms, battery_wait_ms);  // Gauge alert poll / fallback read
+    wait_ms = min(wait_ms, ble_wait_ms);      // BLE key release / macro step
+    wait_ms = min(wait_ms, anim_wait_ms);     // Next animated icon frame
+    wait_ms = min(wait_ms, jobs_wait_ms);     // Queued UI job slices
+    wait_ms = min(wait_ms, espnow_link_update());  // Retransmit deadline
+    wait_ms = min(wait_ms, max_sleep_ms);
+
+    uint32_t events = events_wait(wait_ms);
+    loop_watch_begin();
+    ui_lock();
+    loop_watch_mark(LS_UI_LOCK);
+    ui_run_posted();
+    wired_link_poll();    // Companion frames on the console; 't' dumps the trace ring
+    loop_watch_mark(LS_POSTED);
+
+    // Touch: the input task polled the GT911 and saw a change or a held finger
+    if (events & EVT_TOUCH_DATA) {
+        clock_direct_wake();  // LVGL has to see this touch
+        lvgl_indev_kick();  // Feed LVGL now instead of waiting for its read period
+        TouchGesture gesture = touch_take_gesture();
+        if (gesture != GESTURE_NONE) handle_gesture(gesture);
         // Touch activity resets idle timer (cheap millis() assignment)
         power_activity();
     }
+    loop_watch_mark(LS_TOUCH);
+
+    // Hardware input: samples queued by the input task, plus the coalesced
+    // volume/DDC flush deadline
+    hw_input_wait_ms = hw_input_process();
+    loop_watch_mark(LS_HW_INPUT);
+
+    // Animated icons: due frames, decoded within the shared budget so the
+    // render below picks them up
+    anim_wait_ms = anim_icon_update();
+    loop_watch_mark(LS_ANIM);
+
+    // UI jobs: a few ms of off-screen page work per pass, ahead of the render
+    jobs_wait_ms = ui_jobs_run();
+    loop_watch_mark(LS_JOBS);
+
+    // Clock mode: LVGL stops once the clock screen is quiet, restarts on change
+    clock_direct_update(power_get_state() == POWER_CLOCK);
 
     // Drive LVGL
-    lvgl_tick();
+    lv_sleep_ms = lvgl_tick();
+    perf_update();
+    loop_watch_mark(LS_LVGL);
 
-    // Deferred UI rebuild (triggered by config upload)
+    // Deferred UI rebuild (config upload, live edit, profile switch), after
+    // this pass's frame. A staged upload is swapped in first, so the UI goes
+    // from one whole config to the other; the old one is freed once
+    // rebuild_ui() has moved everything over.
     if (g_rebuild_pending) {
         g_rebuild_pending = false;
+        AppConfig *retired = take_staged_config();
+        if (retired) std::swap(g_app_config, *retired);
         rebuild_ui(&g_app_config);
+        apply_gesture_config(g_app_config.gestures);
+        power_set_battery_thresholds(g_app_config.display_settings.battery_saver_pct,
+                                     g_app_config.display_settings.battery_critical_pct);
+        delete retired;
     }
-
-    // Config server polling (WiFi SoftAP + config upload + OTA + ArduinoOTA)
-    if (config_server_active()) {
-        config_server_poll();
-    }
+    loop_watch_mark(LS_REBUILD);
 
     // Handle config server inactivity timeout (auto-stopped, return to main view)
     if (config_server_timed_out()) {
@@ -104,116 +623,105 @@ void loop() {
     // Power state machine update (checks idle timeout)
     power_update();
 
-    // Check for ACK from bridge (non-blocking)
+    // Keep a freshly flashed image once it has run long enough (else rollback);
+    // boot one pushed over ESP-NOW once nobody is using the panel
+    ota_confirm_update();
+    ota_swap_when_idle(power_get_state() != POWER_ACTIVE && !bulk_active());
+    loop_watch_mark(LS_POWER);
+
+    // Check for ACK from bridge (non-blocking); also drives retransmits
+    espnow_link_update();
     uint8_t ack_status;
     if (espnow_poll_ack(ack_status)) {
-        Serial.printf("ACK: status=%d\n", ack_status);
+        trace(TR_ACK_RX, ack_status);
+        LOG_D("ACK: status=%d\n", ack_status);
         last_bridge_msg_time = millis();
         power_activity();
     }
 
-    // Poll for incoming messages (MSG_STATS, MSG_POWER_STATE, MSG_TIME_SYNC, etc.)
-    uint8_t msg_type;
-    uint8_t msg_payload[PROTO_MAX_PAYLOAD];
-    uint8_t msg_len;
-    if (espnow_poll_msg(msg_type, msg_payload, msg_len)) {
-        last_bridge_msg_time = millis();
-        power_activity();
+    // Run the handlers for incoming messages (MSG_STATS, MSG_POWER_STATE, MSG_TIME_SYNC, etc.)
+    espnow_dispatch();
 
-        // Wake detection: if in CLOCK mode and a non-shutdown message arrives, wake up
-        if (power_get_state() == POWER_CLOCK && msg_type != MSG_POWER_STATE) {
-            power_wake_detected();
-            show_hotkey_view();
-        }
-
-        if (msg_type == MSG_STATS && msg_len >= 1) {
-            update_stats(msg_payload, msg_len);
-            last_stats_time = millis();
-            stats_active = true;
-        }
-        else if (msg_type == MSG_POWER_STATE && msg_len >= sizeof(PowerStateMsg)) {
-            PowerStateMsg *ps = (PowerStateMsg *)msg_payload;
-            if (ps->state == POWER_SHUTDOWN || ps->state == POWER_LOCKED) {
-                power_shutdown_received();
-                show_clock_mode();
-            } else if (ps->state == POWER_WAKE) {
-                if (power_get_state() == POWER_CLOCK) {
-                    power_wake_detected();
-                    show_hotkey_view();
-                }
-            }
-        }
-        else if (msg_type == MSG_TIME_SYNC && msg_len >= 4) {
-            TimeSyncMsg *ts = (TimeSyncMsg *)msg_payload;
-            struct timeval tv = { .tv_sec = (time_t)ts->epoch_seconds, .tv_usec = 0 };
-            settimeofday(&tv, nullptr);
-            // Set timezone if offset provided (msg_len >= 6 means new format with tz_offset)
-            if (msg_len >= sizeof(TimeSyncMsg)) {
-                int16_t offset_min = ts->tz_offset_min;
-                // POSIX TZ uses inverted sign: UTC+5 = "UTC-5"
-                int hours = -(offset_min / 60);
-                int mins = abs(offset_min % 60);
-                char tz_buf[16];
-                snprintf(tz_buf, sizeof(tz_buf), "UTC%+d:%02d", hours, mins);
-                setenv("TZ", tz_buf, 1);
-                tzset();
-            }
-            Serial.printf("Time synced: %lu\n", (unsigned long)ts->epoch_seconds);
-        }
-        else if (msg_type == MSG_NOTIFICATION && msg_len >= sizeof(NotificationMsg)) {
-            NotificationMsg *notif = (NotificationMsg *)msg_payload;
-            // Safety: force null-terminate all strings
-            notif->app_name[31] = '\0';
-            notif->summary[99] = '\0';
-            notif->body[115] = '\0';
-            show_notification_toast(notif->app_name, notif->summary, notif->body);
-        }
-        else if (msg_type == MSG_CONFIG_MODE) {
-            if (!config_server_active()) {
-                Serial.println("CONFIG_MODE: starting SoftAP config server");
-                config_server_start();
-                show_config_screen();
-            }
-        }
-        else if (msg_type == MSG_CONFIG_DONE) {
-            if (config_server_active()) {
-                Serial.println("CONFIG_DONE: stopping config server");
-                config_server_stop();
-                hide_config_screen();
-            }
-        }
+    // Shared timebase from the bridge (clock_sync.h)
+    ClockSyncMsg clock_req;
+    bool bridge_up = (espnow_is_paired() || wired_link_up()) &&
+                     millis() - last_bridge_msg_time < BRIDGE_LINK_TIMEOUT_MS;
+    if (clock_sync_poll(clock_req, bridge_up)) {
+        espnow_send(MSG_CLOCK_SYNC, (const uint8_t *)&clock_req, sizeof(clock_req));
     }
+    loop_watch_mark(LS_ESPNOW);
+
+    // Bridge-less BLE keyboard: fast connection parameters while the panel is in use
+    ble_wait_ms = ble_hid_update(power_get_state() == POWER_ACTIVE);
+    loop_watch_mark(LS_BLE);
 
-    // Stats timeout: mark stats as inactive if no data for 5 seconds
-    if (stats_active && (millis() - last_stats_time > 5000)) {
+    // Latency benchmark: fire due probes (after the drain so echoes are counted first);
+    // input replay: inject due events
+    bench_wait_ms = bench_update();
+    replay_wait_ms = replay_update();
+    loop_watch_mark(LS_BENCH);
+
+    // Stats timeout: mark stats as inactive after ~3 missed intervals (5 s at full rate)
+    if (stats_active && (millis() - last_stats_time > power_stats_timeout_ms())) {
         stats_active = false;
+        status_set_pc_active(false);
         Serial.println("Stats timeout -- no data");
     }
 
-    // Hardware input polling (~20Hz, same rate as touch)
-    // Reads PCF8575 via TCA9548A mux for buttons + encoder
-    if (millis() - encoder_timer >= 50) {
-        encoder_timer = millis();
-        hw_input_poll();
-    }
-
-    // Device status + ping (every 5 seconds)
-    if (millis() - device_status_timer >= 5000) {
+    // Device status + ping (every 5 seconds, slower under the battery policy)
+    uint32_t heartbeat_ms = power_heartbeat_ms();
+    if (millis() - device_status_timer >= heartbeat_ms) {
         device_status_timer = millis();
-        espnow_send(MSG_PING, nullptr, 0);  // Heartbeat to get fresh RSSI
-        bool link_ok = (millis() - last_bridge_msg_time) < BRIDGE_LINK_TIMEOUT_MS;
-        update_device_status(espnow_get_rssi(), link_ok, get_backlight(), stats_active);
-    }
+        espnow_send_heartbeat(heartbeat_ms);  // PING (or PAIR_REQ) to get fresh RSSI
+        uint32_t link_timeout = max(BRIDGE_LINK_TIMEOUT_MS, 2 * heartbeat_ms);
+        bool link_ok = (millis() - last_bridge_msg_time) < link_timeout;
+        status_set_link(espnow_get_rssi(), link_ok);
+        status_set_brightness(get_backlight());
 
-    // Clock updates every 30 seconds (clock mode screen + page clock widgets + display uptime)
-    if (millis() - clock_update_timer >= 30000) {
-        clock_update_timer = millis();
-        if (power_get_state() == POWER_CLOCK) {
-            update_clock_time();
+        static uint32_t last_rx_overflow = 0;
+        uint32_t rx_overflow = espnow_rx_overflow_total();
+        if (rx_overflow != last_rx_overflow) {
+            Serial.printf("ESP-NOW RX overflow: %lu total (stats superseded: %lu)\n",
+                          (unsigned long)rx_overflow,
+                          (unsigned long)espnow_rx_overflow_count(MSG_STATS));
+            last_rx_overflow = rx_overflow;
+        }
+
+        static uint32_t last_link_retries = 0, last_link_lost = 0, last_tx_fail = 0;
+        LinkStats ls;
+        espnow_get_link_stats(ls);
+        if (ls.retries != last_link_retries || ls.lost != last_link_lost ||
+            ls.tx_fail != last_tx_fail) {
+            Serial.printf("ESP-NOW link: sent=%lu acked=%lu retries=%lu lost=%lu rtt avg=%luus max=%luus\n",
+                          (unsigned long)ls.sent, (unsigned long)ls.acked,
+                          (unsigned long)ls.retries, (unsigned long)ls.lost,
+                          (unsigned long)ls.rtt_avg_us, (unsigned long)ls.rtt_max_us);
+            Serial.printf("ESP-NOW tx: ok=%lu fail=%lu no_mem=%lu dropped=%lu latency avg=%luus max=%luus\n",
+                          (unsigned long)ls.tx_ok, (unsigned long)ls.tx_fail,
+                          (unsigned long)ls.tx_no_mem, (unsigned long)ls.tx_dropped,
+                          (unsigned long)ls.tx_avg_us, (unsigned long)ls.tx_max_us);
+            last_link_retries = ls.retries;
+            last_link_lost = ls.lost;
+            last_tx_fail = ls.tx_fail;
         }
-        update_page_clocks();
-        update_display_uptime();
     }
+    loop_watch_mark(LS_HEARTBEAT);
+
+    // Fuel gauge (I2C) on its SOC-change alert or the fallback interval; the
+    // read runs on the bus task and the result comes back through ui_post()
+    battery_wait_ms = battery_update(events & EVT_BATTERY_ALERT, on_battery_sample);
+    loop_watch_mark(LS_BATTERY);
+
+    // Wall clock on minute boundaries, then redraw whatever status changed
+    // (status bars, page clocks, clock screen, display uptime)
+    clock_wait_ms = status_clock_update();
+    status_flush();
+
+    // Page/preset/mode/focus to NVS once they have settled, stats frames to SD
+    state_wait_ms = runtime_state_poll();
+    stats_log_wait_ms = stats_log_poll();
+    loop_watch_mark(LS_STATUS);
+    loop_watch_end();
 
-    delay(5);
+    ui_unlock();
 }
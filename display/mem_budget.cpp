@@ -0,0 +1,193 @@
+/**
+ * @file mem_budget.cpp
+ * Pool accounting over heap_caps, eviction on budget/heap pressure
+ *
+ * Sizes are the heap's own block sizes (heap_caps_get_allocated_size), so
+ * mem_free() needs no size from the caller and the counters match what
+ * heap_caps_get_free_size() loses. Counters are updated under a spinlock;
+ * evictors run outside it, since they free memory back through mem_free().
+ */
+
+#include "mem_budget.h"
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <esp_memory_utils.h>
+#include <string.h>
+
+#define MEM_MAX_EVICTORS 4
+#define CAPS_PSRAM      (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#define CAPS_INTERNAL   (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+
+struct Pool {
+    const char *name;
+    uint32_t budget;
+    bool hard;                         // Refuse allocations past the budget
+    MemEvictFn evictors[MEM_MAX_EVICTORS];
+    uint8_t evictor_count;
+    uint32_t used, peak, blocks, internal_used;
+    uint32_t over_budget, failed, evicted;
+};
+
+static Pool pools[MEM_POOL_COUNT] = {
+    { "lvgl",   MEM_BUDGET_LVGL,   false },
+    { "images", MEM_BUDGET_IMAGES, false },
+    { "upload", MEM_BUDGET_UPLOAD, true },
+    { "config", MEM_BUDGET_CONFIG, false },
+};
+static portMUX_TYPE mem_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static void charge(Pool &p, void *block) {
+    uint32_t n = heap_caps_get_allocated_size(block);
+    portENTER_CRITICAL(&mem_mux);
+    p.used += n;
+    p.blocks++;
+    if (!esp_ptr_external_ram(block)) p.internal_used += n;
+    if (p.used > p.peak) p.peak = p.used;
+    if (p.used > p.budget) p.over_budget++;
+    portEXIT_CRITICAL(&mem_mux);
+}
+
+static void uncharge(Pool &p, void *block) {
+    uint32_t n = heap_caps_get_allocated_size(block);
+    portENTER_CRITICAL(&mem_mux);
+    p.used -= n;
+    p.blocks--;
+    if (!esp_ptr_external_ram(block)) p.internal_used -= n;
+    portEXIT_CRITICAL(&mem_mux);
+}
+
+static size_t run_evictors(Pool &p, size_t want) {
+    size_t freed = 0;
+    for (uint8_t i = 0; i < p.evictor_count && freed < want; i++) {
+        freed += p.evictors[i](want - freed);
+    }
+    portENTER_CRITICAL(&mem_mux);
+    p.evicted += freed;
+    portEXIT_CRITICAL(&mem_mux);
+    return freed;
+}
+
+// PSRAM is out: ask every pool to give something back
+static size_t relieve(size_t want) {
+    size_t freed = 0;
+    for (auto &p : pools) freed += run_evictors(p, want);
+    return freed;
+}
+
+// ============================================================
+// Pools
+// ============================================================
+
+void *mem_alloc(MemPool pool, size_t bytes) {
+    Pool &p = pools[pool];
+    if (p.used + bytes > p.budget) {
+        run_evictors(p, p.used + bytes - p.budget);
+        if (p.hard && p.used + bytes > p.budget) {
+            p.failed++;
+            Serial.printf("MEM: %s budget exceeded (%lu + %u > %lu)\n", p.name, (unsigned long)p.used,
+                          (unsigned)bytes, (unsigned long)p.budget);
+            return nullptr;
+        }
+    }
+
+    void *block = heap_caps_malloc(bytes, CAPS_PSRAM);
+    if (!block && relieve(bytes)) block = heap_caps_malloc(bytes, CAPS_PSRAM);
+    if (!block) block = malloc(bytes);
+    if (!block) {
+        p.failed++;
+        Serial.printf("MEM: %s: %u bytes failed (PSRAM free %u)\n", p.name, (unsigned)bytes,
+                      (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+        return nullptr;
+    }
+    charge(p, block);
+    return block;
+}
+
+void mem_free(MemPool pool, void *block) {
+    if (!block) return;
+    uncharge(pools[pool], block);
+    heap_caps_free(block);
+}
+
+void mem_add_evictor(MemPool pool, MemEvictFn fn) {
+    Pool &p = pools[pool];
+    for (uint8_t i = 0; i < p.evictor_count; i++) {
+        if (p.evictors[i] == fn) return;
+    }
+    if (p.evictor_count < MEM_MAX_EVICTORS) p.evictors[p.evictor_count++] = fn;
+}
+
+void mem_get_stats(MemPool pool, MemPoolStats *out) {
+    const Pool &p = pools[pool];
+    portENTER_CRITICAL(&mem_mux);
+    out->name = p.name;
+    out->budget = p.budget;
+    out->used = p.used;
+    out->peak = p.peak;
+    out->blocks = p.blocks;
+    out->internal_used = p.internal_used;
+    out->over_budget = p.over_budget;
+    out->failed = p.failed;
+    out->evicted = p.evicted;
+    portEXIT_CRITICAL(&mem_mux);
+}
+
+void mem_reset_peaks() {
+    portENTER_CRITICAL(&mem_mux);
+    for (auto &p : pools) {
+        p.peak = p.used;
+        p.over_budget = p.failed = p.evicted = 0;
+    }
+    portEXIT_CRITICAL(&mem_mux);
+}
+
+// ============================================================
+// LVGL heap
+//
+// LVGL runs on the UI task only. Never evicts: an LVGL allocation can
+// happen inside the icon cache's own LVGL calls.
+// ============================================================
+
+static bool fast_fits(size_t size) {
+    return MEM_LVGL_FAST_BYTES && size <= MEM_LVGL_FAST_MAX &&
+           pools[MEM_POOL_LVGL].internal_used + size <= MEM_LVGL_FAST_BYTES &&
+           heap_caps_get_free_size(MALLOC_CAP_INTERNAL) > MEM_INTERNAL_RESERVE;
+}
+
+void *mem_lvgl_alloc(size_t size) {
+    void *block = fast_fits(size) ? heap_caps_malloc(size, CAPS_INTERNAL) : nullptr;
+    if (!block) block = heap_caps_malloc(size, CAPS_PSRAM);
+    if (!block) block = heap_caps_malloc(size, CAPS_INTERNAL);
+    if (!block) {
+        pools[MEM_POOL_LVGL].failed++;
+        return nullptr;
+    }
+    charge(pools[MEM_POOL_LVGL], block);
+    return block;
+}
+
+void mem_lvgl_free(void *block) {
+    mem_free(MEM_POOL_LVGL, block);
+}
+
+void *mem_lvgl_realloc(void *block, size_t size) {
+    if (!block) return mem_lvgl_alloc(size);
+    Pool &p = pools[MEM_POOL_LVGL];
+
+    // A PSRAM block stays in PSRAM; an internal one stays while it is small
+    bool internal = !esp_ptr_external_ram(block);
+    if (!internal || size <= MEM_LVGL_FAST_MAX) {
+        uncharge(p, block);
+        void *moved = heap_caps_realloc(block, size, internal ? CAPS_INTERNAL : CAPS_PSRAM);
+        charge(p, moved ? moved : block);   // On failure the old block is still valid
+        if (moved) return moved;
+        // Region full: fall through to a copy into whatever mem_lvgl_alloc finds
+    }
+
+    void *fresh = mem_lvgl_alloc(size);
+    if (!fresh) return nullptr;
+    size_t old = heap_caps_get_allocated_size(block);
+    memcpy(fresh, block, old < size ? old : size);
+    mem_lvgl_free(block);
+    return fresh;
+}
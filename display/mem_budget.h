@@ -0,0 +1,94 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================
+// Memory budgets: named pools over PSRAM, and a small internal-RAM tier
+//
+//   lvgl     LVGL's heap (lv_conf.h routes LV_MEM_CUSTOM_* here). Blocks up
+//            to MEM_LVGL_FAST_MAX bytes -- objects, style property lists,
+//            event descriptors -- go to internal SRAM until
+//            MEM_LVGL_FAST_BYTES is used, the rest to PSRAM.
+//   images   Icon cache, button skins, slideshow frames, snapshots
+//   upload   Transfer buffers: OTA inflate window, live-edit frames, trace
+//   config   Interned config strings, config cache body
+//
+// Each pool counts its bytes against a budget and keeps a high-water mark.
+// Going over a budget first runs the pool's eviction callbacks; the upload
+// budget is hard (the allocation then fails, transfers report "out of
+// memory"), the others are soft: LVGL can't handle a NULL and pinned icons
+// can't be dropped, so the overrun is only counted. When PSRAM itself is
+// exhausted every pool's evictors run once before the allocation fails.
+//
+// Included by lv_conf.h, so this header stays plain C.
+// ============================================================
+
+#ifndef MEM_BUDGET_LVGL
+#define MEM_BUDGET_LVGL      (2048 * 1024)
+#endif
+#ifndef MEM_BUDGET_IMAGES
+#define MEM_BUDGET_IMAGES    (5120 * 1024)   // Icon LRU, slideshow frames, page snapshots, skins
+#endif
+#ifndef MEM_BUDGET_UPLOAD
+#define MEM_BUDGET_UPLOAD    (256 * 1024)
+#endif
+#ifndef MEM_BUDGET_CONFIG
+#define MEM_BUDGET_CONFIG    (512 * 1024)
+#endif
+#ifndef MEM_LVGL_FAST_BYTES
+#define MEM_LVGL_FAST_BYTES  (32 * 1024)     // Internal SRAM for small LVGL blocks (0 = all PSRAM)
+#endif
+#ifndef MEM_LVGL_FAST_MAX
+#define MEM_LVGL_FAST_MAX    128             // Largest LVGL block put in internal SRAM
+#endif
+#ifndef MEM_INTERNAL_RESERVE
+#define MEM_INTERNAL_RESERVE (64 * 1024)     // Internal heap kept free for WiFi/ESP-NOW
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    MEM_POOL_LVGL,
+    MEM_POOL_IMAGES,
+    MEM_POOL_UPLOAD,
+    MEM_POOL_CONFIG,
+    MEM_POOL_COUNT
+} MemPool;
+
+// Free up to `want` bytes of the pool's memory; returns the bytes freed.
+// May be called from any task: take whatever lock the owner needs.
+typedef size_t (*MemEvictFn)(size_t want);
+
+typedef struct {
+    const char *name;
+    uint32_t budget;
+    uint32_t used;           // Bytes held now (heap block sizes)
+    uint32_t peak;           // High-water mark since boot / mem_reset_peaks()
+    uint32_t blocks;         // Live allocations
+    uint32_t internal_used;  // Of `used`, in internal SRAM
+    uint32_t over_budget;    // Allocations that left the pool above its budget
+    uint32_t failed;
+    uint32_t evicted;        // Bytes freed by the pool's evictors
+} MemPoolStats;
+
+// PSRAM block charged to `pool` (internal RAM if PSRAM is gone). nullptr
+// when the heap is out, or the upload budget would be exceeded.
+void *mem_alloc(MemPool pool, size_t bytes);
+void mem_free(MemPool pool, void *p);   // nullptr is fine
+
+// Register an evictor (up to 4 per pool), e.g. the icon cache's LRU trim
+void mem_add_evictor(MemPool pool, MemEvictFn fn);
+
+void mem_get_stats(MemPool pool, MemPoolStats *out);
+void mem_reset_peaks(void);
+
+// LVGL hooks (LV_MEM_CUSTOM_ALLOC/FREE/REALLOC)
+void *mem_lvgl_alloc(size_t size);
+void mem_lvgl_free(void *p);
+void *mem_lvgl_realloc(void *p, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
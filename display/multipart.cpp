@@ -0,0 +1,182 @@
+/**
+ * @file multipart.cpp
+ * Streaming multipart/form-data parser for the config server
+ */
+
+#include "multipart.h"
+#include <string.h>
+#include <strings.h>
+
+enum MultipartState : uint8_t {
+    ST_BODY,          // Part body, or the preamble before the first delimiter
+    ST_DELIM_TAIL,    // After a delimiter: "--" closes, CRLF starts a part
+    ST_CLOSE_DASH,
+    ST_DELIM_LF,
+    ST_HEADERS,
+    ST_DONE,          // Closing delimiter seen; the epilogue is ignored
+    ST_ERROR,
+};
+
+// Value of `key` in a "type; key=value; key2="value"" header, into out
+static bool header_param(const char *header, const char *key, char *out, size_t out_len) {
+    size_t key_len = strlen(key);
+    for (const char *p = strchr(header, ';'); p; p = strchr(p, ';')) {
+        p++;
+        while (*p == ' ' || *p == '\t') p++;
+        if (strncasecmp(p, key, key_len) != 0 || p[key_len] != '=') continue;
+        p += key_len + 1;
+        bool quoted = *p == '"';
+        if (quoted) p++;
+        size_t n = 0;
+        while (*p && (quoted ? *p != '"' : *p != ';' && *p != ' ')) {
+            if (n + 1 < out_len) out[n++] = *p;
+            p++;
+        }
+        out[n] = '\0';
+        return true;
+    }
+    return false;
+}
+
+bool multipart_begin(MultipartParser &p, const char *content_type,
+                     const MultipartCallbacks *cb, void *user) {
+    memset(&p, 0, sizeof(p));
+    p.cb = cb;
+    p.user = user;
+    p.state = ST_ERROR;
+    if (!content_type || strncasecmp(content_type, "multipart/form-data", 19) != 0) return false;
+
+    char boundary[MULTIPART_BOUNDARY_MAX + 2];
+    if (!header_param(content_type, "boundary", boundary, sizeof(boundary))) return false;
+    size_t len = strlen(boundary);
+    if (len == 0 || len > MULTIPART_BOUNDARY_MAX) return false;
+    memcpy(p.delim, "\r\n--", 4);
+    memcpy(p.delim + 4, boundary, len);
+    p.delim_len = 4 + len;
+
+    // The first delimiter has no CRLF in front of it: start as if it was seen
+    p.match = 2;
+    p.state = ST_BODY;
+    return true;
+}
+
+static void emit(MultipartParser &p, const uint8_t *data, size_t len) {
+    if (!p.in_part || !len) return;
+    if (p.is_file) {
+        p.cb->file_data(p.user, data, len);
+        return;
+    }
+    size_t room = MULTIPART_FIELD_MAX - 1 - p.field_len;
+    if (len > room) len = room;
+    memcpy(p.field + p.field_len, data, len);
+    p.field_len += len;
+}
+
+static void part_end(MultipartParser &p) {
+    if (!p.in_part) return;
+    p.in_part = false;
+    if (p.is_file) {
+        p.cb->file_end(p.user);
+    } else {
+        p.field[p.field_len] = '\0';
+        p.cb->field(p.user, p.name, p.field);
+    }
+}
+
+static void header_line(MultipartParser &p) {
+    p.line[p.line_len] = '\0';
+    if (strncasecmp(p.line, "Content-Disposition:", 20) != 0) return;
+    header_param(p.line, "name", p.name, sizeof(p.name));
+    p.is_file = header_param(p.line, "filename", p.filename, sizeof(p.filename));
+}
+
+static void part_begin(MultipartParser &p) {
+    p.in_part = true;
+    p.field_len = 0;
+    if (p.is_file) p.cb->file_begin(p.user, p.name, p.filename);
+}
+
+// Everything after a delimiter up to the part body, one byte at a time
+static void feed_byte(MultipartParser &p, uint8_t c) {
+    switch (p.state) {
+    case ST_DELIM_TAIL:
+        if (c == '-') p.state = ST_CLOSE_DASH;
+        else if (c == '\r') p.state = ST_DELIM_LF;
+        else if (c != ' ' && c != '\t') p.state = ST_ERROR;   // Only padding may follow
+        break;
+    case ST_CLOSE_DASH:
+        p.state = c == '-' ? ST_DONE : ST_ERROR;
+        break;
+    case ST_DELIM_LF:
+        if (c != '\n') {
+            p.state = ST_ERROR;
+            break;
+        }
+        p.state = ST_HEADERS;
+        p.line_len = 0;
+        p.name[0] = p.filename[0] = '\0';
+        p.is_file = false;
+        break;
+    case ST_HEADERS:
+        if (c != '\n') {
+            if (p.line_len < MULTIPART_LINE_MAX - 1) p.line[p.line_len++] = c;
+            break;
+        }
+        if (p.line_len && p.line[p.line_len - 1] == '\r') p.line_len--;
+        if (p.line_len == 0) {
+            p.state = ST_BODY;
+            part_begin(p);
+        } else {
+            header_line(p);
+        }
+        p.line_len = 0;
+        break;
+    default:   // ST_DONE, ST_ERROR
+        break;
+    }
+}
+
+// Body bytes up to and including the next delimiter. Returns bytes used.
+static size_t feed_body(MultipartParser &p, const uint8_t *data, size_t len) {
+    size_t run = 0;   // Start of body bytes not passed on yet
+    for (size_t i = 0; i < len; i++) {
+        uint8_t c = data[i];
+        if (c == (uint8_t)p.delim[p.match]) {
+            if (p.match == 0) emit(p, data + run, i - run);
+            if (++p.match == p.delim_len) {
+                p.match = 0;
+                part_end(p);
+                p.state = ST_DELIM_TAIL;
+                return i + 1;
+            }
+            continue;
+        }
+        if (p.match) {
+            emit(p, (const uint8_t *)p.delim, p.match);   // A false start: it was body after all
+            p.match = 0;
+            if (c == (uint8_t)p.delim[0]) {
+                p.match = 1;
+                continue;
+            }
+            run = i;
+        }
+    }
+    if (p.match == 0) emit(p, data + run, len - run);
+    return len;
+}
+
+void multipart_feed(MultipartParser &p, const uint8_t *data, size_t len) {
+    size_t i = 0;
+    while (i < len) {
+        if (p.state == ST_BODY) i += feed_body(p, data + i, len - i);
+        else feed_byte(p, data[i++]);
+    }
+}
+
+bool multipart_finish(MultipartParser &p) {
+    if (p.state == ST_DONE) return true;
+    if (p.in_part && p.is_file) p.cb->file_abort(p.user);
+    p.in_part = false;
+    p.state = ST_ERROR;
+    return false;
+}
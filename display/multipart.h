@@ -0,0 +1,61 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================
+// Streaming multipart/form-data parser (config server uploads)
+//
+// The request body is fed in whatever pieces the socket hands over; file
+// bytes come out of file_data() as they arrive, never buffered past the
+// piece they came in. Only part headers (one line at a time) and plain
+// form fields (up to MULTIPART_FIELD_MAX, the rest dropped) are held.
+//
+// The delimiter is matched byte by byte. Its only CR is the first byte and
+// boundary characters never include one, so a failed partial match can
+// only restart at the byte that broke it: the held prefix is known to be
+// the delimiter's own first bytes and goes out as data from there.
+// ============================================================
+
+#define MULTIPART_BOUNDARY_MAX 70    // RFC 2046
+#define MULTIPART_LINE_MAX     256   // Part header line; longer is truncated
+#define MULTIPART_NAME_MAX     32
+#define MULTIPART_FILENAME_MAX 96
+#define MULTIPART_FIELD_MAX    64
+
+struct MultipartCallbacks {
+    // A part without a filename, once its value is complete
+    void (*field)(void *user, const char *name, const char *value);
+    // A part with a filename: begin, its bytes in order, then end or abort
+    void (*file_begin)(void *user, const char *name, const char *filename);
+    void (*file_data)(void *user, const uint8_t *data, size_t len);
+    void (*file_end)(void *user);
+    void (*file_abort)(void *user);   // Body ended inside the part
+};
+
+struct MultipartParser {
+    const MultipartCallbacks *cb;
+    void *user;
+    char delim[MULTIPART_BOUNDARY_MAX + 4];   // "\r\n--" + boundary
+    uint8_t delim_len;
+    uint8_t match;        // Delimiter bytes matched so far
+    uint8_t state;
+    bool in_part;         // Body bytes belong to a part (not the preamble)
+    bool is_file;
+    char line[MULTIPART_LINE_MAX];
+    uint16_t line_len;
+    char name[MULTIPART_NAME_MAX];
+    char filename[MULTIPART_FILENAME_MAX];
+    char field[MULTIPART_FIELD_MAX];
+    uint8_t field_len;
+};
+
+// Set up for a body with this Content-Type. False when it isn't
+// multipart/form-data or has no usable boundary.
+bool multipart_begin(MultipartParser &p, const char *content_type,
+                     const MultipartCallbacks *cb, void *user);
+
+void multipart_feed(MultipartParser &p, const uint8_t *data, size_t len);
+
+// End of the body. True if the closing delimiter was seen; otherwise a file
+// part still open gets file_abort().
+bool multipart_finish(MultipartParser &p);
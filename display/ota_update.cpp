@@ -0,0 +1,226 @@
+/**
+ * @file ota_update.cpp
+ * Firmware update: plain or gzip image -> inactive OTA slot, rollback guard
+ *
+ * gzip is parsed here (header, trailer) and the deflate stream in between
+ * goes through the ROM's tinfl with a wrapping 32 KB output window, so the
+ * flash sees an ordinary firmware.bin written in window-sized pieces. The
+ * header has to arrive in the first chunk (one socket read, ~1.4 KB at least),
+ * which any header without a multi-kilobyte FEXTRA/FNAME field does.
+ */
+
+#include "ota_update.h"
+#include "protocol.h"
+#include "mem_budget.h"
+#include <Arduino.h>
+#include <Update.h>
+#include <esp_ota_ops.h>
+#include <esp32s3/rom/miniz.h>
+#include <string.h>
+
+#define GZIP_ID1       0x1F
+#define GZIP_ID2       0x8B
+#define GZIP_DEFLATE   8
+#define GZIP_FHCRC     0x02
+#define GZIP_FEXTRA    0x04
+#define GZIP_FNAME     0x08
+#define GZIP_FCOMMENT  0x10
+#define GZIP_TRAILER   8      // CRC-32 + ISIZE, little endian
+
+enum OtaState : uint8_t { OTA_IDLE, OTA_RAW, OTA_GZIP, OTA_GZIP_TRAILER, OTA_FAILED };
+
+static OtaState state = OTA_IDLE;
+static const char *error = "";
+static bool started = false;                 // First chunk seen (format known)
+static tinfl_decompressor *inflator = nullptr;
+static uint8_t *window = nullptr;            // TINFL_LZ_DICT_SIZE, wraps
+static size_t window_pos = 0;
+static uint32_t out_crc = 0;
+static uint32_t out_size = 0;
+static uint32_t in_size = 0;
+static uint8_t trailer[GZIP_TRAILER];
+static uint8_t trailer_len = 0;
+static bool staged = false;                  // Verified image waiting for a reboot
+
+static void release() {
+    mem_free(MEM_POOL_UPLOAD, inflator);
+    mem_free(MEM_POOL_UPLOAD, window);
+    inflator = nullptr;
+    window = nullptr;
+}
+
+static bool fail(const char *why) {
+    Serial.printf("OTA: %s\n", why);
+    if (Update.isRunning()) Update.abort();
+    release();
+    error = why;
+    state = OTA_FAILED;
+    return false;
+}
+
+bool ota_begin(const char *filename) {
+    ota_abort();
+    error = "";
+    started = false;
+    out_crc = out_size = in_size = 0;
+    trailer_len = 0;
+    window_pos = 0;
+    Serial.printf("OTA: receiving %s\n", filename);
+    if (!Update.begin(UPDATE_SIZE_UNKNOWN)) {
+        Update.printError(Serial);
+        return fail("no OTA slot (partition table without ota_1?)");
+    }
+    state = OTA_RAW;   // Decided on the first chunk
+    return true;
+}
+
+static bool flash(const uint8_t *data, size_t len) {
+    if (Update.write(const_cast<uint8_t *>(data), len) != len) {
+        Update.printError(Serial);
+        return fail("flash write failed");
+    }
+    out_crc = crc32_update(out_crc, data, len);
+    out_size += len;
+    return true;
+}
+
+// Parse the gzip member header; returns its length, 0 if malformed
+static size_t gzip_header(const uint8_t *p, size_t len) {
+    if (len < 10 || p[2] != GZIP_DEFLATE) return 0;
+    uint8_t flags = p[3];
+    size_t pos = 10;
+    if (flags & GZIP_FEXTRA) {
+        if (pos + 2 > len) return 0;
+        pos += 2 + (p[pos] | p[pos + 1] << 8);
+    }
+    if (flags & GZIP_FNAME) {
+        while (pos < len && p[pos]) pos++;
+        pos++;
+    }
+    if (flags & GZIP_FCOMMENT) {
+        while (pos < len && p[pos]) pos++;
+        pos++;
+    }
+    if (flags & GZIP_FHCRC) pos += 2;
+    return pos <= len ? pos : 0;
+}
+
+static bool start(const uint8_t *&data, size_t &len) {
+    started = true;
+    if (len < 2 || data[0] != GZIP_ID1 || data[1] != GZIP_ID2) return true;   // Plain image
+
+    size_t header = gzip_header(data, len);
+    if (!header) return fail("bad gzip header");
+    inflator = (tinfl_decompressor *)mem_alloc(MEM_POOL_UPLOAD, sizeof(tinfl_decompressor));
+    window = (uint8_t *)mem_alloc(MEM_POOL_UPLOAD, TINFL_LZ_DICT_SIZE);
+    if (!inflator || !window) return fail("out of memory");
+    tinfl_init(inflator);
+    data += header;
+    len -= header;
+    state = OTA_GZIP;
+    Serial.println("OTA: gzip image, inflating");
+    return true;
+}
+
+static bool inflate(const uint8_t *&data, size_t &len) {
+    for (;;) {
+        size_t in_n = len;
+        size_t out_n = TINFL_LZ_DICT_SIZE - window_pos;
+        tinfl_status st = tinfl_decompress(inflator, data, &in_n, window, window + window_pos,
+                                           &out_n, TINFL_FLAG_HAS_MORE_INPUT);
+        data += in_n;
+        len -= in_n;
+        if (out_n && !flash(window + window_pos, out_n)) return false;
+        window_pos = (window_pos + out_n) & (TINFL_LZ_DICT_SIZE - 1);
+
+        if (st == TINFL_STATUS_DONE) {
+            release();
+            state = OTA_GZIP_TRAILER;
+            return true;
+        }
+        if (st < 0) return fail("corrupt gzip data");
+        if (st == TINFL_STATUS_NEEDS_MORE_INPUT) return true;
+        // TINFL_STATUS_HAS_MORE_OUTPUT: window full, go round again
+    }
+}
+
+bool ota_write(const uint8_t *data, size_t len) {
+    if (state == OTA_IDLE || state == OTA_FAILED) return false;
+    in_size += len;
+    if (!started && !start(data, len)) return false;
+
+    if (state == OTA_RAW) return flash(data, len);
+    if (state == OTA_GZIP && len && !inflate(data, len)) return false;
+    if (state == OTA_GZIP_TRAILER) {
+        size_t n = len < (size_t)(GZIP_TRAILER - trailer_len) ? len : GZIP_TRAILER - trailer_len;
+        memcpy(trailer + trailer_len, data, n);
+        trailer_len += n;   // Anything after the trailer (a second member) is ignored
+    }
+    return true;
+}
+
+bool ota_end() {
+    if (state == OTA_IDLE || state == OTA_FAILED) return false;
+    if (state == OTA_GZIP) return fail("gzip stream truncated");
+    if (state == OTA_GZIP_TRAILER) {
+        if (trailer_len < GZIP_TRAILER) return fail("gzip trailer missing");
+        uint32_t crc, isize;
+        memcpy(&crc, trailer, 4);
+        memcpy(&isize, trailer + 4, 4);
+        if (crc != out_crc || isize != out_size) return fail("gzip CRC mismatch");
+    }
+    // Checks the image header, checksum and SHA-256, then switches the boot slot
+    if (!Update.end(true)) {
+        Update.printError(Serial);
+        return fail("image verification failed");
+    }
+    Serial.printf("OTA: success, %lu bytes received, %lu bytes written\n",
+                  (unsigned long)in_size, (unsigned long)out_size);
+    state = OTA_IDLE;
+    staged = true;
+    return true;
+}
+
+void ota_abort() {
+    if (Update.isRunning()) Update.abort();
+    release();
+    state = OTA_IDLE;
+}
+
+const char *ota_error() {
+    return error;
+}
+
+bool ota_staged() {
+    return staged;
+}
+
+void ota_swap_when_idle(bool idle) {
+    if (!staged || !idle) return;
+    Serial.println("OTA: idle, rebooting into the staged image");
+    Serial.flush();
+    ESP.restart();
+}
+
+// ============================================================
+// Rollback guard
+// ============================================================
+
+// The core would mark every image valid as soon as it boots; hold that back
+extern "C" bool verifyRollbackLater() {
+    return true;
+}
+
+void ota_confirm_update() {
+    static bool checked = false;
+    if (checked || millis() < OTA_CONFIRM_MS) return;
+    checked = true;
+
+    esp_ota_img_states_t img_state;
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    if (esp_ota_get_state_partition(running, &img_state) != ESP_OK) return;
+    if (img_state != ESP_OTA_IMG_PENDING_VERIFY) return;
+    if (esp_ota_mark_app_valid_cancel_rollback() == ESP_OK) {
+        Serial.printf("OTA: image in %s confirmed\n", running->label);
+    }
+}
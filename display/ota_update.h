@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// ============================================================
+// Firmware update sink (POST /update) and boot confirmation
+//
+// Accepts the plain firmware.bin or a gzip of it (firmware.bin.gz, written
+// next to the .bin by tools/ota_gzip.py). A gzip image is inflated on the
+// fly into the inactive OTA slot: a 32 KB window in PSRAM, never the whole
+// image. The ESP image itself (magic, checksum, SHA-256) is verified by
+// Update.end(); the gzip CRC-32 and length are checked on top.
+//
+// A freshly flashed image boots in PENDING_VERIFY. ota_confirm_update()
+// marks it valid once it has run OTA_CONFIRM_MS; if it crashes or resets
+// before that, the bootloader goes back to the previous slot.
+// ============================================================
+
+#ifndef OTA_CONFIRM_MS
+#define OTA_CONFIRM_MS 60000   // Uptime before a new image is kept
+#endif
+
+// Upload chunks, in order. begin() resets any previous attempt.
+bool ota_begin(const char *filename);
+bool ota_write(const uint8_t *data, size_t len);
+bool ota_end();                // Verify and make the new slot the boot slot
+void ota_abort();
+
+// Last failure, "" if none since ota_begin()
+const char *ota_error();
+
+// Call from loop(): keeps the running image once it has proven itself
+void ota_confirm_update();
+
+// An image staged in the background (MSG_BULK_* with BULK_FLAG_FIRMWARE) is
+// booted once `idle` (power state DIMMED/CLOCK), not in the user's face
+bool ota_staged();
+void ota_swap_when_idle(bool idle);
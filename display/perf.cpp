@@ -0,0 +1,334 @@
+/**
+ * @file perf.cpp
+ * Render performance counters and HUD overlay
+ *
+ * Counters are plain integers: the flush path may run on the core-0 flush
+ * task, and a torn read of a statistic is harmless.
+ */
+
+#include "perf.h"
+#include "display_hw.h"
+#include "espnow_link.h"
+#include <Arduino.h>
+#include <lvgl.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <string.h>
+#include <algorithm>
+
+#define PERF_WINDOW_MS  1000
+#define PERF_HUD_MS     500
+
+// Since-reset counters
+static volatile uint32_t frame_hist[PERF_HIST_BUCKETS] = {};
+static volatile uint32_t frames_total = 0;
+static volatile uint32_t last_frame_ms = 0;
+static volatile uint32_t max_frame_ms = 0;
+static volatile uint32_t flush_max_us = 0;
+static volatile uint32_t timer_max_us = 0;
+
+// Button press round trips (loop task only)
+static uint32_t press_hist[PERF_PRESS_BUCKETS] = {};
+static uint32_t presses_total = 0;
+static uint32_t presses_failed = 0;
+static uint32_t press_last_ms = 0;
+static uint32_t press_max_ms = 0;
+static uint64_t host_queue_sum_us = 0;
+static uint64_t host_exec_sum_ms = 0;
+
+// Current window accumulators
+static volatile uint32_t win_flush_count = 0;
+static volatile uint32_t win_flush_us = 0;
+static volatile uint32_t win_px = 0;
+static uint32_t win_stat_updates = 0;
+static uint32_t win_timer_calls = 0;
+static uint32_t win_timer_us = 0;
+static uint32_t window_start = 0;
+
+// Last completed window
+static uint32_t flush_count = 0;
+static uint32_t flush_avg_us = 0;
+static uint32_t px_per_sec = 0;
+static uint32_t stat_updates = 0;
+static uint32_t px_per_stat_update = 0;
+static uint32_t timer_avg_us = 0;
+
+// Capture (perf_capture_begin/end). frame_ms is PSRAM, allocated per capture.
+static volatile bool capturing = false;
+static uint16_t *cap_frame_ms = nullptr;
+static volatile uint32_t cap_frames = 0;
+static uint64_t cap_frame_ms_sum = 0;
+static volatile uint32_t cap_flushes = 0;
+static volatile uint64_t cap_flush_px = 0;
+static volatile uint64_t cap_flush_us = 0;
+static uint32_t cap_heap_start = 0;
+static uint32_t cap_heap_min = 0;
+static uint32_t cap_psram_min = 0;
+
+// HUD
+static lv_obj_t *hud_label = NULL;
+static uint32_t hud_timer = 0;
+
+void perf_record_frame(uint32_t render_ms, uint32_t px) {
+    int b = 0;
+    while (b < PERF_HIST_BUCKETS - 1 && render_ms >= PERF_HIST_LIMITS_MS[b]) b++;
+    frame_hist[b]++;
+    frames_total++;
+    last_frame_ms = render_ms;
+    if (render_ms > max_frame_ms) max_frame_ms = render_ms;
+    if (capturing) {
+        if (cap_frames < PERF_CAPTURE_FRAMES) cap_frame_ms[cap_frames] = render_ms > UINT16_MAX ? UINT16_MAX : render_ms;
+        cap_frames++;
+        cap_frame_ms_sum += render_ms;
+    }
+}
+
+void perf_record_flush(uint32_t us, uint32_t px) {
+    win_flush_count++;
+    win_flush_us += us;
+    win_px += px;
+    if (us > flush_max_us) flush_max_us = us;
+    if (capturing) {
+        cap_flushes++;
+        cap_flush_px += px;
+        cap_flush_us += us;
+    }
+}
+
+void perf_record_stat_update() {
+    win_stat_updates++;
+}
+
+void perf_record_timer_handler(uint32_t us) {
+    win_timer_calls++;
+    win_timer_us += us;
+    if (us > timer_max_us) timer_max_us = us;
+}
+
+void perf_record_press(uint32_t rtt_ms, uint32_t host_queue_us, uint32_t host_exec_ms, bool ok) {
+    int b = 0;
+    while (b < PERF_PRESS_BUCKETS - 1 && rtt_ms >= PERF_PRESS_LIMITS_MS[b]) b++;
+    press_hist[b]++;
+    presses_total++;
+    if (!ok) presses_failed++;
+    press_last_ms = rtt_ms;
+    if (rtt_ms > press_max_ms) press_max_ms = rtt_ms;
+    host_queue_sum_us += host_queue_us;
+    host_exec_sum_ms += host_exec_ms;
+}
+
+static void hud_refresh() {
+    if (!hud_label) return;
+    PerfStats s;
+    perf_get(s);
+    LinkStats ls;
+    espnow_get_link_stats(ls);
+    lv_label_set_text_fmt(hud_label,
+        "%u fps  frame %lu/%lu ms\n"
+        "flush %lu/s avg %lu us  %lu kpx/s\n"
+        "timer avg %lu us max %lu us\n"
+        "vsync %lu us  miss %lu  jitter %lu us  beam %lu  udf %lu\n"
+        "heap %lu K  psram %lu K\n"
+        "tx %lu us  fail %lu  rtt %lu us  retry %lu\n"
+        "radio %d.%02d dBm  rate %u  far %d dBm  adapt %lu\n"
+        "press %lu/%lu ms  host q %lu us x %lu ms",
+        s.fps, (unsigned long)s.last_frame_ms, (unsigned long)s.max_frame_ms,
+        (unsigned long)s.flush_count, (unsigned long)s.flush_avg_us,
+        (unsigned long)(s.px_per_sec / 1000),
+        (unsigned long)s.timer_handler_avg_us, (unsigned long)s.timer_handler_max_us,
+        (unsigned long)s.vsync.period_us, (unsigned long)s.vsync.missed,
+        (unsigned long)s.vsync.jitter_us, (unsigned long)s.vsync.beam_hits,
+        (unsigned long)s.scanout.underruns,
+        (unsigned long)(s.heap_free / 1024), (unsigned long)(s.psram_free / 1024),
+        (unsigned long)ls.tx_avg_us, (unsigned long)ls.tx_fail,
+        (unsigned long)ls.rtt_avg_us, (unsigned long)ls.retries,
+        ls.tx_power_qdbm / 4, (ls.tx_power_qdbm % 4) * 25, ls.phy_rate_step, ls.far_rssi,
+        (unsigned long)ls.adapt_changes,
+        (unsigned long)s.press_last_ms, (unsigned long)s.press_max_ms,
+        (unsigned long)s.host_queue_avg_us, (unsigned long)s.host_exec_avg_ms);
+}
+
+void perf_update() {
+    uint32_t now = millis();
+    if (now - window_start >= PERF_WINDOW_MS) {
+        uint32_t elapsed = now - window_start;
+        flush_count = win_flush_count;
+        flush_avg_us = flush_count ? win_flush_us / flush_count : 0;
+        px_per_sec = (uint32_t)((uint64_t)win_px * 1000 / elapsed);
+        timer_avg_us = win_timer_calls ? win_timer_us / win_timer_calls : 0;
+        stat_updates = win_stat_updates;
+        px_per_stat_update = stat_updates ? win_px / stat_updates : 0;
+        win_flush_count = 0;
+        win_flush_us = 0;
+        win_px = 0;
+        win_stat_updates = 0;
+        win_timer_calls = 0;
+        win_timer_us = 0;
+        window_start = now;
+    }
+
+    if (capturing) {
+        uint32_t heap = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+        uint32_t psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+        if (heap < cap_heap_min) cap_heap_min = heap;
+        if (psram < cap_psram_min) cap_psram_min = psram;
+    }
+
+    if (hud_label && now - hud_timer >= PERF_HUD_MS) {
+        hud_timer = now;
+        hud_refresh();
+    }
+}
+
+void perf_get(PerfStats &out) {
+    for (int i = 0; i < PERF_HIST_BUCKETS; i++) out.frame_hist[i] = frame_hist[i];
+    out.frames_total = frames_total;
+    out.fps = display_get_fps();
+    out.last_frame_ms = last_frame_ms;
+    out.max_frame_ms = max_frame_ms;
+    out.flush_count = flush_count;
+    out.flush_avg_us = flush_avg_us;
+    out.flush_max_us = flush_max_us;
+    out.px_per_sec = px_per_sec;
+    out.stat_updates = stat_updates;
+    out.px_per_stat_update = px_per_stat_update;
+    out.timer_handler_avg_us = timer_avg_us;
+    out.timer_handler_max_us = timer_max_us;
+    display_get_vsync_stats(out.vsync);
+    display_get_scanout_stats(out.scanout);
+    for (int i = 0; i < PERF_PRESS_BUCKETS; i++) out.press_hist[i] = press_hist[i];
+    out.presses_total = presses_total;
+    out.presses_failed = presses_failed;
+    out.press_last_ms = press_last_ms;
+    out.press_max_ms = press_max_ms;
+    out.host_queue_avg_us = presses_total ? (uint32_t)(host_queue_sum_us / presses_total) : 0;
+    out.host_exec_avg_ms = presses_total ? (uint32_t)(host_exec_sum_ms / presses_total) : 0;
+    out.heap_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    out.heap_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+    out.psram_free = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    out.psram_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM);
+}
+
+void perf_reset() {
+    for (int i = 0; i < PERF_HIST_BUCKETS; i++) frame_hist[i] = 0;
+    frames_total = 0;
+    max_frame_ms = 0;
+    flush_max_us = 0;
+    timer_max_us = 0;
+    display_reset_vsync_stats();
+    for (int i = 0; i < PERF_PRESS_BUCKETS; i++) press_hist[i] = 0;
+    presses_total = 0;
+    presses_failed = 0;
+    press_max_ms = 0;
+    host_queue_sum_us = 0;
+    host_exec_sum_ms = 0;
+}
+
+// ============================================================
+// Capture
+// ============================================================
+bool perf_capture_begin() {
+    if (capturing) return false;
+    if (!cap_frame_ms) {
+        cap_frame_ms = (uint16_t *)ps_malloc(PERF_CAPTURE_FRAMES * sizeof(uint16_t));
+        if (!cap_frame_ms) return false;
+    }
+    cap_frames = 0;
+    cap_frame_ms_sum = 0;
+    cap_flushes = 0;
+    cap_flush_px = 0;
+    cap_flush_us = 0;
+    cap_heap_start = cap_heap_min = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    cap_psram_min = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    capturing = true;
+    return true;
+}
+
+void perf_capture_end(PerfCapture &out) {
+    capturing = false;
+    out = {};
+    out.frames = cap_frames;
+    out.flushes = cap_flushes;
+    out.flush_px = cap_flush_px;
+    out.flush_us = cap_flush_us;
+    out.frame_avg_us = cap_frames ? (uint32_t)(cap_frame_ms_sum * 1000 / cap_frames) : 0;
+    uint32_t kept = cap_frames < PERF_CAPTURE_FRAMES ? cap_frames : PERF_CAPTURE_FRAMES;
+    if (kept) {
+        std::sort(cap_frame_ms, cap_frame_ms + kept);
+        out.frame_p50_ms = cap_frame_ms[(kept - 1) * 50 / 100];
+        out.frame_p99_ms = cap_frame_ms[(kept - 1) * 99 / 100];
+        out.frame_max_ms = cap_frame_ms[kept - 1];
+    }
+    out.heap_start = cap_heap_start;
+    out.heap_end = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    out.heap_min_free = out.heap_end < cap_heap_min ? out.heap_end : cap_heap_min;
+    out.psram_min_free = cap_psram_min;
+}
+
+// ============================================================
+// Boot profile
+// ============================================================
+static BootPhase boot_phases[PERF_BOOT_PHASES];
+static uint8_t boot_count = 0;
+static uint32_t boot_last_us[2] = {};   // Previous mark per core
+static portMUX_TYPE boot_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void perf_boot_mark(const char *phase) {
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    uint8_t core = xPortGetCoreID();
+    portENTER_CRITICAL(&boot_mux);
+    if (boot_count < PERF_BOOT_PHASES) {
+        boot_phases[boot_count++] = { phase, boot_last_us[core], now - boot_last_us[core], core };
+    }
+    boot_last_us[core] = now;
+    portEXIT_CRITICAL(&boot_mux);
+}
+
+size_t perf_boot_get(BootPhase *out, size_t max) {
+    portENTER_CRITICAL(&boot_mux);
+    size_t n = boot_count < max ? boot_count : max;
+    memcpy(out, boot_phases, n * sizeof(BootPhase));
+    portEXIT_CRITICAL(&boot_mux);
+    return n;
+}
+
+void perf_boot_report() {
+    BootPhase phases[PERF_BOOT_PHASES];
+    size_t n = perf_boot_get(phases, PERF_BOOT_PHASES);
+    Serial.println("BOOT: phase               core   start ms   took ms");
+    uint32_t end_us = 0;
+    for (size_t i = 0; i < n; i++) {
+        const BootPhase &p = phases[i];
+        Serial.printf("BOOT: %-20s %4u %10.1f %9.1f\n", p.name, p.core, p.start_us / 1000.0f, p.us / 1000.0f);
+        if (p.start_us + p.us > end_us) end_us = p.start_us + p.us;
+    }
+    Serial.printf("BOOT: usable %.1f ms after app start\n", end_us / 1000.0f);
+}
+
+void perf_hud_set(bool visible) {
+    if (visible && !hud_label) {
+        // Top layer: stays above every screen and toast
+        hud_label = lv_label_create(lv_layer_top());
+        lv_obj_set_style_bg_color(hud_label, lv_color_hex(0x000000), LV_PART_MAIN);
+        lv_obj_set_style_bg_opa(hud_label, LV_OPA_70, LV_PART_MAIN);
+        lv_obj_set_style_text_color(hud_label, lv_color_hex(0x2ECC71), LV_PART_MAIN);
+        lv_obj_set_style_text_font(hud_label, &lv_font_montserrat_12, LV_PART_MAIN);
+        lv_obj_set_style_pad_all(hud_label, 4, LV_PART_MAIN);
+        lv_obj_align(hud_label, LV_ALIGN_BOTTOM_LEFT, 4, -4);
+        lv_obj_clear_flag(hud_label, LV_OBJ_FLAG_CLICKABLE);
+        hud_refresh();
+        Serial.println("[perf] HUD on");
+    } else if (!visible && hud_label) {
+        lv_obj_del(hud_label);
+        hud_label = NULL;
+        Serial.println("[perf] HUD off");
+    }
+}
+
+bool perf_hud_visible() {
+    return hud_label != NULL;
+}
+
+void perf_hud_toggle() {
+    perf_hud_set(!hud_label);
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <cstdint>
+#include "display_hw.h"
+
+// ============================================================
+// Render performance counters + on-screen HUD
+//
+// Fed from display_hw (LVGL monitor_cb, flush path, lv_timer_handler) and
+// the MSG_ACTION_RESULT handler, read by the HUD overlay and GET /api/perf.
+// ============================================================
+
+// Frame render-time histogram bucket upper bounds (ms); last bucket is open-ended
+#define PERF_HIST_BUCKETS 7
+static const uint16_t PERF_HIST_LIMITS_MS[PERF_HIST_BUCKETS - 1] = {4, 8, 16, 33, 50, 100};
+
+// Button press -> companion "executed" round-trip histogram (ms)
+#define PERF_PRESS_BUCKETS 7
+static const uint16_t PERF_PRESS_LIMITS_MS[PERF_PRESS_BUCKETS - 1] = {10, 20, 50, 100, 200, 500};
+
+struct PerfStats {
+    uint32_t frame_hist[PERF_HIST_BUCKETS];  // Frames per render-time bucket (since reset)
+    uint32_t frames_total;
+    uint16_t fps;                  // Frames completed in the last 1 s window
+    uint32_t last_frame_ms;        // Render time of the most recent frame
+    uint32_t max_frame_ms;         // Since reset
+
+    uint32_t flush_count;          // Flushed areas in the last 1 s window
+    uint32_t flush_avg_us;         // Mean time per flushed area (last window)
+    uint32_t flush_max_us;         // Since reset
+    uint32_t px_per_sec;           // Pixels flushed in the last 1 s window
+    uint32_t stat_updates;         // Stat value labels changed in the last 1 s window
+    uint32_t px_per_stat_update;   // px_per_sec / stat_updates (0 without updates); only
+                                   // a clean figure while nothing else animates
+
+    uint32_t timer_handler_avg_us; // lv_timer_handler duration (last window)
+    uint32_t timer_handler_max_us; // Since reset
+
+    DisplayVsyncStats vsync;       // Frame pacing against the panel scan
+    DisplayScanoutStats scanout;   // PCLK, bounce buffers, underruns
+
+    uint32_t press_hist[PERF_PRESS_BUCKETS];  // Companion presses per round-trip bucket (since reset)
+    uint32_t presses_total;        // MSG_ACTION_RESULT received (since reset)
+    uint32_t presses_failed;       // ... with a non-OK status
+    uint32_t press_last_ms;        // Press -> executed, most recent
+    uint32_t press_max_ms;         // Since reset
+    uint32_t host_queue_avg_us;    // Companion HID read -> handler start (since reset)
+    uint32_t host_exec_avg_ms;     // Companion handler run time (since reset)
+
+    uint32_t heap_free;            // Internal RAM
+    uint32_t heap_min_free;
+    uint32_t psram_free;
+    uint32_t psram_min_free;
+};
+
+// --- Producers (display_hw) ---
+void perf_record_frame(uint32_t render_ms, uint32_t px);      // LVGL monitor_cb
+void perf_record_flush(uint32_t us, uint32_t px);             // Per flushed area
+void perf_record_timer_handler(uint32_t us);                  // Per lv_timer_handler call
+void perf_record_stat_update();                               // ui: a stat value label changed
+// --- Producer (main loop, MSG_ACTION_RESULT) ---
+void perf_record_press(uint32_t rtt_ms, uint32_t host_queue_us, uint32_t host_exec_ms, bool ok);
+
+// Roll the 1 s windows and refresh the HUD. Call from loop().
+void perf_update();
+
+// Snapshot for /api/perf
+void perf_get(PerfStats &out);
+void perf_reset();
+
+// --- Capture (input replay, input_replay.h) ---
+// Every frame and flush between begin and end, plus the heap low-water
+// marks, sampled from perf_update(). One capture at a time.
+#define PERF_CAPTURE_FRAMES 8192   // Frame times kept for the percentiles (PSRAM)
+struct PerfCapture {
+    uint32_t frames;
+    uint16_t frame_p50_ms;
+    uint16_t frame_p99_ms;
+    uint16_t frame_max_ms;
+    uint32_t frame_avg_us;
+    uint32_t flushes;
+    uint64_t flush_px;
+    uint64_t flush_us;
+    uint32_t heap_start;       // Internal RAM free at begin / end
+    uint32_t heap_end;
+    uint32_t heap_min_free;
+    uint32_t psram_min_free;
+};
+bool perf_capture_begin();          // False if the frame buffer can't be had
+void perf_capture_end(PerfCapture &out);
+
+// --- Boot profile (setup() and the core-0 boot task) ---
+// Each mark closes a phase that began at the previous mark on the same
+// core (or at app start, esp_timer 0: the ROM and 2nd-stage bootloader
+// come before that and are not counted).
+#define PERF_BOOT_PHASES 20
+struct BootPhase {
+    const char *name;        // Static string
+    uint32_t start_us;       // esp_timer_get_time()
+    uint32_t us;
+    uint8_t core;
+};
+void perf_boot_mark(const char *phase);
+void perf_boot_report();                            // Serial table, once setup() is done
+size_t perf_boot_get(BootPhase *out, size_t max);   // Phases in mark order
+
+// On-screen HUD overlay (lv_layer_top, survives screen changes)
+void perf_hud_set(bool visible);
+bool perf_hud_visible();
+void perf_hud_toggle();
@@ -0,0 +1,243 @@
+/**
+ * @file picture_index.cpp
+ * On-SD index of the picture frame library
+ *
+ * Layout: PictureIndexHeader, then `count` records of PICTURE_NAME_MAX
+ * bytes (NUL padded file name). Records past `count` are leftovers of
+ * removals and never read. A rebuild streams into a .part file that is
+ * renamed over the index, so a reset mid-walk leaves the old one intact.
+ * The walk itself can be spread over many calls (picture_index_scan_step).
+ */
+
+#include "picture_index.h"
+#include "sdcard.h"
+#include <Arduino.h>
+#include <SD.h>
+#include <string.h>
+#include <strings.h>
+
+#define PICTURE_INDEX_MAGIC   0x58444950u   // "PIDX"
+#define PICTURE_INDEX_VERSION 1
+#define PICTURE_INDEX_PART    PICTURE_INDEX_PATH ".part"
+
+struct PictureIndexHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;   // PICTURE_NAME_MAX
+    uint32_t count;
+};
+
+static inline uint32_t record_offset(uint32_t i) {
+    return sizeof(PictureIndexHeader) + i * PICTURE_NAME_MAX;
+}
+
+// Slideshow formats img_loader / the LVGL decoders take
+static bool picture_name_ok(const char *name) {
+    size_t n = strlen(name);
+    if (n == 0 || n >= PICTURE_NAME_MAX || name[0] == '.') return false;
+    const char *dot = strrchr(name, '.');
+    return dot && (!strcasecmp(dot, ".jpg") || !strcasecmp(dot, ".jpeg") || !strcasecmp(dot, ".sjpg"));
+}
+
+// File name of `path` if it is directly under PICTURE_DIR, else nullptr
+static const char *picture_name_of(const char *path) {
+    size_t dir_len = sizeof(PICTURE_DIR) - 1;
+    if (!path || strncmp(path, PICTURE_DIR "/", dir_len + 1) != 0) return nullptr;
+    const char *name = path + dir_len + 1;
+    return strchr(name, '/') || !picture_name_ok(name) ? nullptr : name;
+}
+
+static bool read_header(File &f, PictureIndexHeader &h) {
+    if (!f || f.read((uint8_t *)&h, sizeof(h)) != sizeof(h)) return false;
+    return h.magic == PICTURE_INDEX_MAGIC && h.version == PICTURE_INDEX_VERSION &&
+           h.record_size == PICTURE_NAME_MAX && f.size() >= record_offset(h.count);
+}
+
+static bool write_header(File &f, uint32_t count) {
+    PictureIndexHeader h = { PICTURE_INDEX_MAGIC, PICTURE_INDEX_VERSION, PICTURE_NAME_MAX, count };
+    return f.seek(0) && f.write((const uint8_t *)&h, sizeof(h)) == sizeof(h);
+}
+
+static bool read_record(File &f, uint32_t i, char *name) {
+    if (!f.seek(record_offset(i)) || f.read((uint8_t *)name, PICTURE_NAME_MAX) != PICTURE_NAME_MAX) return false;
+    name[PICTURE_NAME_MAX - 1] = '\0';
+    return true;
+}
+
+static bool write_record(File &f, uint32_t i, const char *name) {
+    char rec[PICTURE_NAME_MAX] = {};
+    strlcpy(rec, name, sizeof(rec));
+    return f.seek(record_offset(i)) && f.write((const uint8_t *)rec, sizeof(rec)) == sizeof(rec);
+}
+
+// Record holding `name`, or -1
+static int32_t find_record(File &f, uint32_t count, const char *name) {
+    char rec[PICTURE_NAME_MAX];
+    for (uint32_t i = 0; i < count; i++) {
+        if (!read_record(f, i, rec)) return -1;
+        if (!strcmp(rec, name)) return (int32_t)i;
+    }
+    return -1;
+}
+
+// Rescan state: the .part file being written and the directory walk
+static bool scanning = false;
+static File scan_out;
+static File scan_dir;
+static uint32_t scan_count = 0;
+static uint32_t scan_t0 = 0;
+
+void picture_index_scan_abort() {
+    if (!scanning) return;
+    scanning = false;
+    if (scan_dir) scan_dir.close();
+    scan_out.close();
+    sdcard_file_remove(PICTURE_INDEX_PART);
+}
+
+bool picture_index_scan_begin() {
+    picture_index_scan_abort();
+    if (!sdcard_mounted()) return false;
+    scan_t0 = millis();
+    scan_count = 0;
+    scan_out = SD.open(PICTURE_INDEX_PART, FILE_WRITE);
+    if (!scan_out) {
+        Serial.println("[pictures] can't write " PICTURE_INDEX_PART);
+        return false;
+    }
+    write_header(scan_out, 0);
+    scan_dir = SD.open(PICTURE_DIR);
+    if (scan_dir && !scan_dir.isDirectory()) scan_dir.close();
+    scanning = true;
+    return true;
+}
+
+static void scan_finish() {
+    scanning = false;
+    if (scan_dir) scan_dir.close();
+    bool ok = write_header(scan_out, scan_count);
+    scan_out.close();
+    if (!ok || !sdcard_file_rename(PICTURE_INDEX_PART, PICTURE_INDEX_PATH)) {
+        sdcard_file_remove(PICTURE_INDEX_PART);
+        Serial.println("[pictures] index rebuild failed");
+        return;
+    }
+    Serial.printf("[pictures] indexed %lu pictures in %lu ms\n", (unsigned long)scan_count,
+                  (unsigned long)(millis() - scan_t0));
+}
+
+bool picture_index_scan_step(uint16_t entries) {
+    if (!scanning) return false;
+    for (uint16_t i = 0; i < entries; i++) {
+        File entry = scan_dir ? scan_dir.openNextFile() : File();
+        if (!entry) {
+            scan_finish();
+            return false;
+        }
+        if (!entry.isDirectory()) {
+            // Older cores give the full path, newer ones the bare name
+            const char *name = entry.name();
+            const char *slash = strrchr(name, '/');
+            if (slash) name = slash + 1;
+            if (picture_name_ok(name) && write_record(scan_out, scan_count, name)) scan_count++;
+        }
+        entry.close();
+    }
+    return true;
+}
+
+uint32_t picture_index_rebuild() {
+    if (!picture_index_scan_begin()) return 0;
+    while (picture_index_scan_step(UINT16_MAX)) {
+    }
+    return scan_count;
+}
+
+bool picture_index_valid() {
+    if (!sdcard_mounted()) return false;
+    File f = SD.open(PICTURE_INDEX_PATH, FILE_READ);
+    PictureIndexHeader h;
+    bool ok = read_header(f, h);
+    if (f) f.close();
+    return ok;
+}
+
+uint32_t picture_index_count() {
+    if (!sdcard_mounted()) return 0;
+    File f = SD.open(PICTURE_INDEX_PATH, FILE_READ);
+    PictureIndexHeader h;
+    if (read_header(f, h)) return h.count;
+    if (f) f.close();
+    return picture_index_rebuild();
+}
+
+bool picture_index_path(uint32_t i, char *out, size_t size) {
+    File f = SD.open(PICTURE_INDEX_PATH, FILE_READ);
+    PictureIndexHeader h;
+    char name[PICTURE_NAME_MAX];
+    if (!read_header(f, h) || i >= h.count || !read_record(f, i, name)) return false;
+    snprintf(out, size, PICTURE_DIR "/%s", name);
+    return true;
+}
+
+void picture_index_added(const char *path) {
+    const char *name = picture_name_of(path);
+    if (!name || !sdcard_mounted()) return;
+    File f = SD.open(PICTURE_INDEX_PATH, "r+");
+    PictureIndexHeader h;
+    if (!read_header(f, h)) {
+        if (f) f.close();
+        picture_index_rebuild();   // Picks up the new file with the rest
+        return;
+    }
+    // Overwriting an existing picture keeps its record
+    if (find_record(f, h.count, name) < 0) {
+        if (!write_record(f, h.count, name) || !write_header(f, h.count + 1)) {
+            Serial.printf("[pictures] index append failed for %s\n", name);
+        }
+    }
+    f.close();
+}
+
+void picture_index_removed(const char *path) {
+    const char *name = picture_name_of(path);
+    if (!name || !sdcard_mounted()) return;
+    File f = SD.open(PICTURE_INDEX_PATH, "r+");
+    PictureIndexHeader h;
+    if (!read_header(f, h)) {
+        if (f) f.close();
+        return;   // Rebuilt from the directory on next use
+    }
+    int32_t i = find_record(f, h.count, name);
+    if (i >= 0) {
+        // The last record fills the hole: no shifting, order is shuffled anyway
+        char last[PICTURE_NAME_MAX];
+        bool ok = (uint32_t)i == h.count - 1 ||
+                  (read_record(f, h.count - 1, last) && write_record(f, (uint32_t)i, last));
+        if (!ok || !write_header(f, h.count - 1)) {
+            Serial.printf("[pictures] index update failed for %s\n", name);
+        }
+    }
+    f.close();
+}
+
+// ============================================================
+// Shuffle order
+// ============================================================
+
+static uint32_t gcd(uint32_t a, uint32_t b) {
+    while (b) { uint32_t t = a % b; a = b; b = t; }
+    return a;
+}
+
+void picture_order_init(PictureOrder &o, uint32_t n, bool shuffle) {
+    o.n = n ? n : 1;
+    o.stride = 1;
+    o.offset = 0;
+    if (!shuffle || o.n < 3) return;
+    o.offset = esp_random() % o.n;
+    // Random stride in 2..n-1; walk up to the next one coprime to n
+    uint32_t s = 2 + esp_random() % (o.n - 2);
+    for (uint32_t tries = 0; tries < o.n && gcd(s, o.n) != 1; tries++) s = s + 1 < o.n ? s + 1 : 2;
+    if (gcd(s, o.n) == 1) o.stride = s;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================
+// Picture library index (/pictures/.index)
+//
+// Picture frame mode used to walk /pictures on every entry; with thousands
+// of photos that took seconds and a String per file. The index is a small
+// header and one fixed-size record (file name) per picture, so:
+//   - entry costs one header read, the slideshow reads one record per slide
+//   - uploads and deletes patch it in place (append / move the last record
+//     into the hole), never a rescan
+//   - a missing or unreadable index is rebuilt by one directory walk
+// Files copied onto the card from a PC are picked up by deleting the index
+// (or picture_index_rebuild()).
+//
+// Callers hold ui_lock() while writing, like icon_cache_invalidate().
+// ============================================================
+
+#define PICTURE_DIR        "/pictures"
+#define PICTURE_INDEX_PATH "/pictures/.index"
+#define PICTURE_NAME_MAX   64   // Record size: file name within PICTURE_DIR, NUL padded
+
+// Number of pictures, (re)building the index first if needed
+uint32_t picture_index_count();
+
+// SD path ("/pictures/<name>") of picture `i` < picture_index_count()
+bool picture_index_path(uint32_t i, char *out, size_t size);
+
+// A file under PICTURE_DIR was written or removed; other paths are ignored
+void picture_index_added(const char *path);
+void picture_index_removed(const char *path);
+
+// Rescan PICTURE_DIR. Returns the number of pictures found.
+uint32_t picture_index_rebuild();
+
+// The same rescan in slices (ui_jobs.h), so entering picture frame mode
+// doesn't stall on a large library. picture_index_valid() tells whether
+// one is needed (a header read); scan_begin() opens the walk and each
+// scan_step() takes up to `entries` directory entries, returning false
+// once the index is written or the walk failed. A rebuild, or another
+// begin, drops a walk in progress; so does scan_abort().
+bool picture_index_valid();
+bool picture_index_scan_begin();
+bool picture_index_scan_step(uint16_t entries);
+void picture_index_scan_abort();
+
+// ============================================================
+// Shuffle order
+//
+// A permutation of 0..n-1 with no table: position k maps to
+// (stride * k + offset) mod n, with a random stride coprime to n.
+// ============================================================
+
+struct PictureOrder {
+    uint32_t n;
+    uint32_t stride;   // 1 = index order
+    uint32_t offset;
+};
+
+void picture_order_init(PictureOrder &o, uint32_t n, bool shuffle);
+inline uint32_t picture_order_at(const PictureOrder &o, uint32_t k) {
+    return (uint32_t)(((uint64_t)o.stride * (k % o.n) + o.offset) % o.n);
+}
@@ -0,0 +1,638 @@
+/**
+ * @file png_stream.cpp
+ * Line-streaming PNG decoder straight to RGB565+alpha at the target size
+ *
+ * Chunks are read through a small buffer; IDAT payloads feed a table-driven
+ * inflate (9-bit fast lookup, canonical decode for longer codes) whose
+ * output goes to the 32 KB back-reference window and the current scanline.
+ * Each completed scanline is unfiltered against the previous one and
+ * accumulated, alpha-weighted, into the destination row it maps to, the
+ * same boxes icon_cache's resample() uses. Decoding stops at the last
+ * scanline, without waiting for the final block.
+ */
+
+#include "png_stream.h"
+#include "mem_budget.h"
+#include <Arduino.h>
+#include <string.h>
+#include <strings.h>
+
+#define PNG_READ_BYTES  512
+#define PNG_WINDOW      32768          // Deflate's largest back-reference
+#define PNG_FAST_BITS   9
+#define PNG_MAX_BOX     65536          // Source pixels per output pixel (keeps the sums in 32 bits)
+
+#define PNG_IHDR 0x49484452u
+#define PNG_PLTE 0x504C5445u
+#define PNG_TRNS 0x74524E53u
+#define PNG_IDAT 0x49444154u
+#define PNG_IEND 0x49454E44u
+
+static const uint8_t png_signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+struct PngHeader {
+    uint32_t w, h;
+    uint8_t depth, color, channels;
+};
+
+struct Huffman {
+    uint16_t fast[1 << PNG_FAST_BITS];   // (length << 9) | symbol, 0 = longer code
+    uint16_t firstcode[16];
+    uint32_t maxcode[17];
+    uint16_t firstsymbol[16];
+    uint8_t size[288];
+    uint16_t value[288];
+};
+
+struct Acc {
+    uint32_t r, g, b, a, n;
+};
+
+struct PngStream {
+    lv_fs_file_t f;
+    uint8_t in[PNG_READ_BYTES];
+    uint32_t in_len, in_pos;
+    uint32_t idat_left;
+
+    PngHeader hdr;
+    uint8_t pal[256][4];
+    uint16_t pal_n;
+    uint16_t key[3];                     // tRNS colour key (grey / RGB)
+    bool has_key;
+
+    uint32_t bitbuf, bitcnt;
+    uint8_t overrun;                     // Zero bytes fed past the end of IDAT
+    Huffman lit, dist;
+    uint8_t win[PNG_WINDOW];
+    uint32_t out_total;
+
+    uint8_t *rows;                       // cur + prev scanlines, then dw accumulators
+    uint8_t *cur, *prev;
+    uint32_t row_bytes, row_pos, bpp, y;
+    Acc *acc;
+    uint8_t *dst;
+    uint16_t dw, dh, dy;
+    bool bad;
+};
+
+static inline uint32_t be32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+// Signature + IHDR chunk with its CRC (the first 33 bytes); false for anything we don't take
+static bool parse_ihdr(const uint8_t *p, PngHeader &h) {
+    if (memcmp(p, png_signature, 8) != 0 || be32(p + 8) != 13 || be32(p + 12) != PNG_IHDR) return false;
+    h.w = be32(p + 16);
+    h.h = be32(p + 20);
+    h.depth = p[24];
+    h.color = p[25];
+    if (!h.w || !h.h || h.w > 0xFFFF || h.h > 0xFFFF) return false;
+    if (p[26] != 0 || p[27] != 0 || p[28] != 0) return false;   // deflate, filter 0, no interlace
+    bool depth_ok;
+    switch (h.color) {
+        case 0: h.channels = 1; depth_ok = h.depth == 1 || h.depth == 2 || h.depth == 4 || h.depth == 8 || h.depth == 16; break;
+        case 3: h.channels = 1; depth_ok = h.depth == 1 || h.depth == 2 || h.depth == 4 || h.depth == 8; break;
+        case 2: h.channels = 3; depth_ok = h.depth == 8 || h.depth == 16; break;
+        case 4: h.channels = 2; depth_ok = h.depth == 8 || h.depth == 16; break;
+        case 6: h.channels = 4; depth_ok = h.depth == 8 || h.depth == 16; break;
+        default: return false;
+    }
+    return depth_ok;
+}
+
+// ============================================================
+// Chunk reader
+// ============================================================
+
+static int in_byte(PngStream &s) {
+    if (s.in_pos == s.in_len) {
+        uint32_t n = 0;
+        if (lv_fs_read(&s.f, s.in, sizeof(s.in), &n) != LV_FS_RES_OK || n == 0) return -1;
+        s.in_len = n;
+        s.in_pos = 0;
+    }
+    return s.in[s.in_pos++];
+}
+
+static bool in_read(PngStream &s, uint8_t *dst, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        int c = in_byte(s);
+        if (c < 0) return false;
+        dst[i] = (uint8_t)c;
+    }
+    return true;
+}
+
+static bool in_skip(PngStream &s, uint32_t n) {
+    uint32_t buffered = s.in_len - s.in_pos;
+    if (n <= buffered) {
+        s.in_pos += n;
+        return true;
+    }
+    s.in_pos = s.in_len;   // The file sits at the end of the buffer
+    return lv_fs_seek(&s.f, n - buffered, LV_FS_SEEK_CUR) == LV_FS_RES_OK;
+}
+
+static bool chunk_head(PngStream &s, uint32_t *len, uint32_t *type) {
+    uint8_t b[8];
+    if (!in_read(s, b, sizeof(b))) return false;
+    *len = be32(b);
+    *type = be32(b + 4);
+    return true;
+}
+
+// IHDR, PLTE and tRNS up to the first IDAT, which is left open
+static bool read_header(PngStream &s) {
+    uint8_t ihdr[33];
+    if (!in_read(s, ihdr, sizeof(ihdr)) || !parse_ihdr(ihdr, s.hdr)) return false;
+    for (uint32_t i = 0; i < 256; i++) s.pal[i][3] = 255;
+
+    for (;;) {
+        uint32_t len, type;
+        if (!chunk_head(s, &len, &type)) return false;
+        if (type == PNG_IDAT) {
+            s.idat_left = len;
+            return s.hdr.color != 3 || s.pal_n;
+        }
+        if (type == PNG_IEND) return false;
+        uint32_t used = 0;
+        if (type == PNG_PLTE && len % 3 == 0 && len <= 768) {
+            for (uint32_t i = 0; i < len / 3; i++) {
+                if (!in_read(s, s.pal[i], 3)) return false;
+            }
+            s.pal_n = (uint16_t)(len / 3);
+            used = len;
+        } else if (type == PNG_TRNS) {
+            uint8_t b[6];
+            if (s.hdr.color == 3 && len <= 256) {
+                for (uint32_t i = 0; i < len; i++) {
+                    if (!in_read(s, &s.pal[i][3], 1)) return false;
+                }
+                used = len;
+            } else if ((s.hdr.color == 0 && len == 2) || (s.hdr.color == 2 && len == 6)) {
+                if (!in_read(s, b, len)) return false;
+                for (uint32_t i = 0; i < len / 2; i++) s.key[i] = (uint16_t)((b[2 * i] << 8) | b[2 * i + 1]);
+                s.has_key = true;
+                used = len;
+            }
+        }
+        if (!in_skip(s, len - used + 4)) return false;   // Rest of the chunk and its CRC
+    }
+}
+
+// Next byte of the zlib stream, across IDAT chunk boundaries
+static int idat_byte(PngStream &s) {
+    while (s.idat_left == 0) {
+        uint32_t len, type;
+        if (!in_skip(s, 4) || !chunk_head(s, &len, &type) || type != PNG_IDAT) return -1;
+        s.idat_left = len;
+    }
+    s.idat_left--;
+    return in_byte(s);
+}
+
+// ============================================================
+// Scanlines -> destination rows
+// ============================================================
+
+// Sample `i` of the row, at the file's bit depth
+static inline uint32_t sample(const PngStream &s, const uint8_t *row, uint32_t i) {
+    switch (s.hdr.depth) {
+        case 8: return row[i];
+        case 16: return ((uint32_t)row[2 * i] << 8) | row[2 * i + 1];
+        default: {
+            uint32_t bit = i * s.hdr.depth;
+            return (row[bit >> 3] >> (8 - s.hdr.depth - (bit & 7))) & ((1u << s.hdr.depth) - 1);
+        }
+    }
+}
+
+static inline uint8_t to8(const PngStream &s, uint32_t v) {
+    if (s.hdr.depth == 16) return (uint8_t)(v >> 8);
+    if (s.hdr.depth == 8) return (uint8_t)v;
+    return (uint8_t)(v * 255 / ((1u << s.hdr.depth) - 1));
+}
+
+static void pixel(const PngStream &s, const uint8_t *row, uint32_t x, uint8_t px[4]) {
+    uint32_t i = x * s.hdr.channels;
+    switch (s.hdr.color) {
+        case 0: {
+            uint32_t v = sample(s, row, i);
+            px[0] = px[1] = px[2] = to8(s, v);
+            px[3] = s.has_key && v == s.key[0] ? 0 : 255;
+            break;
+        }
+        case 2: {
+            uint32_t r = sample(s, row, i), g = sample(s, row, i + 1), b = sample(s, row, i + 2);
+            px[0] = to8(s, r);
+            px[1] = to8(s, g);
+            px[2] = to8(s, b);
+            px[3] = s.has_key && r == s.key[0] && g == s.key[1] && b == s.key[2] ? 0 : 255;
+            break;
+        }
+        case 3: {
+            uint32_t v = sample(s, row, i);
+            if (v < s.pal_n) memcpy(px, s.pal[v], 4);
+            else { px[0] = px[1] = px[2] = 0; px[3] = 255; }
+            break;
+        }
+        case 4:
+            px[0] = px[1] = px[2] = to8(s, sample(s, row, i));
+            px[3] = to8(s, sample(s, row, i + 1));
+            break;
+        default:
+            for (int c = 0; c < 4; c++) px[c] = to8(s, sample(s, row, i + c));
+            break;
+    }
+}
+
+static void flush_row(PngStream &s) {
+    uint8_t *o = s.dst + (size_t)s.dy * s.dw * LV_IMG_PX_SIZE_ALPHA_BYTE;
+    for (uint16_t dx = 0; dx < s.dw; dx++, o += LV_IMG_PX_SIZE_ALPHA_BYTE) {
+        Acc &a = s.acc[dx];
+        lv_color_t c = lv_color_black();
+        if (a.a) c = lv_color_make(a.r / a.a, a.g / a.a, a.b / a.a);
+        memcpy(o, &c, sizeof(c));
+        o[LV_IMG_PX_SIZE_ALPHA_BYTE - 1] = (uint8_t)(a.n ? a.a / a.n : 0);
+        a = Acc();
+    }
+}
+
+// Add the finished scanline to every destination row whose box covers it.
+// Colour is alpha-weighted so transparent pixels don't bleed into edges.
+static void scale_row(PngStream &s, const uint8_t *row) {
+    const uint32_t sw = s.hdr.w, sh = s.hdr.h;
+    while (s.dy < s.dh) {
+        uint32_t y0 = (uint32_t)s.dy * sh / s.dh;
+        uint32_t y1 = (uint32_t)(s.dy + 1) * sh / s.dh;
+        if (y1 <= y0) y1 = y0 + 1;
+        if (s.y < y0) break;
+        for (uint16_t dx = 0; dx < s.dw; dx++) {
+            uint32_t x0 = (uint32_t)dx * sw / s.dw;
+            uint32_t x1 = (uint32_t)(dx + 1) * sw / s.dw;
+            if (x1 <= x0) x1 = x0 + 1;
+            Acc &a = s.acc[dx];
+            for (uint32_t x = x0; x < x1; x++) {
+                uint8_t px[4];
+                pixel(s, row, x, px);
+                a.r += px[0] * px[3];
+                a.g += px[1] * px[3];
+                a.b += px[2] * px[3];
+                a.a += px[3];
+                a.n++;
+            }
+        }
+        if (s.y + 1 < y1) break;   // Box continues on the next scanline
+        flush_row(s);
+        s.dy++;
+    }
+}
+
+static inline uint8_t paeth(uint8_t a, uint8_t b, uint8_t c) {
+    int p = a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+static bool row_done(PngStream &s) {
+    uint8_t filter = s.cur[0];
+    uint8_t *cur = s.cur + 1;
+    const uint8_t *prev = s.prev + 1;
+    uint32_t n = s.row_bytes - 1, bpp = s.bpp;
+    switch (filter) {
+        case 0: break;
+        case 1: for (uint32_t i = bpp; i < n; i++) cur[i] += cur[i - bpp]; break;
+        case 2: for (uint32_t i = 0; i < n; i++) cur[i] += prev[i]; break;
+        case 3:
+            for (uint32_t i = 0; i < n; i++) cur[i] += ((i >= bpp ? cur[i - bpp] : 0) + prev[i]) >> 1;
+            break;
+        case 4:
+            for (uint32_t i = 0; i < n; i++) {
+                cur[i] += i >= bpp ? paeth(cur[i - bpp], prev[i], prev[i - bpp]) : prev[i];
+            }
+            break;
+        default: return false;
+    }
+    scale_row(s, cur);
+    uint8_t *t = s.prev;
+    s.prev = s.cur;
+    s.cur = t;
+    s.row_pos = 0;
+    s.y++;
+    return true;
+}
+
+// One inflated byte; false once the last scanline is in (or on a bad filter)
+static inline bool emit(PngStream &s, uint8_t b) {
+    s.win[s.out_total++ & (PNG_WINDOW - 1)] = b;
+    s.cur[s.row_pos++] = b;
+    if (s.row_pos < s.row_bytes) return true;
+    if (!row_done(s)) {
+        s.bad = true;
+        return false;
+    }
+    return s.y < s.hdr.h;
+}
+
+// ============================================================
+// Inflate
+// ============================================================
+
+static const uint16_t len_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                       35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t len_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                       3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t dist_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                        8193, 12289, 16385, 24577 };
+static const uint8_t dist_extra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+static void fill_bits(PngStream &s) {
+    while (s.bitcnt <= 24) {
+        int c = idat_byte(s);
+        if (c < 0) {
+            c = 0;   // Reads ahead of the last code; only a truncated stream gets far
+            if (++s.overrun > 8) s.bad = true;
+        }
+        s.bitbuf |= (uint32_t)c << s.bitcnt;
+        s.bitcnt += 8;
+    }
+}
+
+static inline uint32_t get_bits(PngStream &s, uint32_t n) {
+    if (s.bitcnt < n) fill_bits(s);
+    uint32_t v = s.bitbuf & ((1u << n) - 1);
+    s.bitbuf >>= n;
+    s.bitcnt -= n;
+    return v;
+}
+
+static inline uint32_t bit_reverse(uint32_t v, uint32_t bits) {
+    uint32_t r = 0;
+    for (uint32_t i = 0; i < bits; i++, v >>= 1) r = (r << 1) | (v & 1);
+    return r;
+}
+
+static bool huff_build(Huffman &z, const uint8_t *lens, uint32_t num) {
+    uint32_t sizes[17] = {};
+    uint32_t next_code[16];
+    memset(z.fast, 0, sizeof(z.fast));
+    for (uint32_t i = 0; i < num; i++) sizes[lens[i]]++;
+    sizes[0] = 0;
+    uint32_t code = 0, k = 0;
+    for (uint32_t i = 1; i < 16; i++) {
+        if (sizes[i] > (1u << i)) return false;
+        next_code[i] = code;
+        z.firstcode[i] = (uint16_t)code;
+        z.firstsymbol[i] = (uint16_t)k;
+        code += sizes[i];
+        if (sizes[i] && code - 1 >= (1u << i)) return false;   // Over-subscribed
+        z.maxcode[i] = code << (16 - i);
+        code <<= 1;
+        k += sizes[i];
+    }
+    z.maxcode[16] = 0x10000;
+    for (uint32_t i = 0; i < num; i++) {
+        uint32_t len = lens[i];
+        if (!len) continue;
+        uint32_t c = next_code[len] - z.firstcode[len] + z.firstsymbol[len];
+        z.size[c] = (uint8_t)len;
+        z.value[c] = (uint16_t)i;
+        if (len <= PNG_FAST_BITS) {
+            uint16_t fast = (uint16_t)((len << 9) | i);
+            for (uint32_t j = bit_reverse(next_code[len], len); j < (1u << PNG_FAST_BITS); j += 1u << len) {
+                z.fast[j] = fast;
+            }
+        }
+        next_code[len]++;
+    }
+    return true;
+}
+
+static int huff_decode(PngStream &s, const Huffman &z) {
+    if (s.bitcnt < 16) fill_bits(s);
+    uint32_t fast = z.fast[s.bitbuf & ((1u << PNG_FAST_BITS) - 1)];
+    uint32_t len;
+    if (fast) {
+        len = fast >> 9;
+        s.bitbuf >>= len;
+        s.bitcnt -= len;
+        return (int)(fast & 511);
+    }
+    uint32_t k = bit_reverse(s.bitbuf & 0xFFFF, 16);
+    for (len = PNG_FAST_BITS + 1; k >= z.maxcode[len]; len++) {}
+    if (len >= 16) return -1;
+    uint32_t c = (k >> (16 - len)) - z.firstcode[len] + z.firstsymbol[len];
+    if (c >= 288 || z.size[c] != len) return -1;
+    s.bitbuf >>= len;
+    s.bitcnt -= len;
+    return z.value[c];
+}
+
+static bool build_fixed(PngStream &s) {
+    uint8_t lens[288];
+    memset(lens, 8, 144);
+    memset(lens + 144, 9, 112);
+    memset(lens + 256, 7, 24);
+    memset(lens + 280, 8, 8);
+    if (!huff_build(s.lit, lens, 288)) return false;
+    memset(lens, 5, 32);
+    return huff_build(s.dist, lens, 32);
+}
+
+static bool build_dynamic(PngStream &s) {
+    static const uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+    uint32_t hlit = get_bits(s, 5) + 257;
+    uint32_t hdist = get_bits(s, 5) + 1;
+    uint32_t hclen = get_bits(s, 4) + 4;
+    if (hlit > 286 || hdist > 30) return false;
+
+    uint8_t cl[19] = {};
+    for (uint32_t i = 0; i < hclen; i++) cl[order[i]] = (uint8_t)get_bits(s, 3);
+    if (!huff_build(s.dist, cl, 19)) return false;   // Code-length code, in the distance table for now
+
+    uint8_t lens[286 + 30];
+    uint32_t n = 0, total = hlit + hdist;
+    while (n < total) {
+        int sym = huff_decode(s, s.dist);
+        if (sym < 0 || sym > 18) return false;
+        if (sym < 16) {
+            lens[n++] = (uint8_t)sym;
+            continue;
+        }
+        uint8_t v = 0;
+        uint32_t rep;
+        if (sym == 16) {
+            if (n == 0) return false;
+            v = lens[n - 1];
+            rep = 3 + get_bits(s, 2);
+        } else if (sym == 17) {
+            rep = 3 + get_bits(s, 3);
+        } else {
+            rep = 11 + get_bits(s, 7);
+        }
+        if (n + rep > total) return false;
+        memset(lens + n, v, rep);
+        n += rep;
+    }
+    if (lens[256] == 0) return false;   // No end-of-block code
+    return huff_build(s.lit, lens, hlit) && huff_build(s.dist, lens + hlit, hdist);
+}
+
+// Inflate until every scanline is in. True when the image is complete.
+static bool inflate_rows(PngStream &s) {
+    uint32_t cmf = get_bits(s, 8), flg = get_bits(s, 8);
+    if ((cmf & 0x0F) != 8 || ((cmf << 8) | flg) % 31 != 0 || (flg & 0x20)) return false;
+
+    bool last = false;
+    while (!last && !s.bad) {
+        last = get_bits(s, 1);
+        uint32_t type = get_bits(s, 2);
+        if (type == 0) {
+            get_bits(s, s.bitcnt & 7);   // Stored: byte aligned
+            uint32_t len = get_bits(s, 16), nlen = get_bits(s, 16);
+            if ((len ^ 0xFFFF) != nlen) return false;
+            while (len--) {
+                if (s.bad) return false;
+                if (!emit(s, (uint8_t)get_bits(s, 8))) return !s.bad;
+            }
+            continue;
+        }
+        if (type == 3 || !(type == 1 ? build_fixed(s) : build_dynamic(s))) return false;
+
+        for (;;) {
+            int sym = huff_decode(s, s.lit);
+            if (sym < 0 || s.bad) return false;
+            if (sym < 256) {
+                if (!emit(s, (uint8_t)sym)) return !s.bad;
+                continue;
+            }
+            if (sym == 256) break;
+            sym -= 257;
+            if (sym >= 29) return false;
+            uint32_t len = len_base[sym] + get_bits(s, len_extra[sym]);
+            int dsym = huff_decode(s, s.dist);
+            if (dsym < 0 || dsym >= 30) return false;
+            uint32_t dist = dist_base[dsym] + get_bits(s, dist_extra[dsym]);
+            if (dist > s.out_total) return false;
+            while (len--) {
+                if (!emit(s, s.win[(s.out_total - dist) & (PNG_WINDOW - 1)])) return !s.bad;
+            }
+        }
+    }
+    return false;   // Stream ended short of the last scanline
+}
+
+// ============================================================
+// Public
+// ============================================================
+
+bool png_stream_info(const char *src, uint32_t *w, uint32_t *h) {
+    lv_fs_file_t f;
+    if (lv_fs_open(&f, src, LV_FS_MODE_RD) != LV_FS_RES_OK) return false;
+    uint8_t ihdr[33];
+    uint32_t n = 0;
+    PngHeader hdr;
+    bool ok = lv_fs_read(&f, ihdr, sizeof(ihdr), &n) == LV_FS_RES_OK && n == sizeof(ihdr) &&
+              parse_ihdr(ihdr, hdr);
+    lv_fs_close(&f);
+    if (ok) {
+        *w = hdr.w;
+        *h = hdr.h;
+    }
+    return ok;
+}
+
+bool png_stream_decode(const char *src, uint8_t *dst, uint16_t dw, uint16_t dh) {
+    if (!dst || !dw || !dh) return false;
+    PngStream *s = (PngStream *)mem_alloc(MEM_POOL_IMAGES, sizeof(PngStream));
+    if (!s) return false;
+    memset(s, 0, sizeof(*s));
+    if (lv_fs_open(&s->f, src, LV_FS_MODE_RD) != LV_FS_RES_OK) {
+        mem_free(MEM_POOL_IMAGES, s);
+        return false;
+    }
+
+    bool ok = read_header(*s);
+    const PngHeader &h = s->hdr;
+    if (ok && ((h.w + dw - 1) / dw) * ((h.h + dh - 1) / dh) > PNG_MAX_BOX) ok = false;
+    if (ok) {
+        uint32_t bits = h.depth * h.channels;
+        s->bpp = bits >= 8 ? bits / 8 : 1;
+        s->row_bytes = 1 + (h.w * bits + 7) / 8;
+        s->rows = (uint8_t *)mem_alloc(MEM_POOL_IMAGES, 2 * s->row_bytes + (size_t)dw * sizeof(Acc));
+        ok = s->rows != nullptr;
+    }
+    if (ok) {
+        memset(s->rows, 0, 2 * s->row_bytes + (size_t)dw * sizeof(Acc));
+        s->cur = s->rows;
+        s->prev = s->rows + s->row_bytes;
+        s->acc = (Acc *)(void *)(s->rows + 2 * s->row_bytes);
+        s->dst = dst;
+        s->dw = dw;
+        s->dh = dh;
+        ok = inflate_rows(*s) && s->dy == dh;
+        if (!ok) Serial.printf("[png] %s: corrupt or truncated at line %lu\n", src, (unsigned long)s->y);
+    }
+    lv_fs_close(&s->f);
+    mem_free(MEM_POOL_IMAGES, s->rows);
+    mem_free(MEM_POOL_IMAGES, s);
+    return ok;
+}
+
+// ============================================================
+// LVGL decoder (native size, S: paths ending in .png)
+// ============================================================
+
+static bool is_png_path(const void *src) {
+    if (lv_img_src_get_type(src) != LV_IMG_SRC_FILE) return false;
+    const char *ext = strrchr((const char *)src, '.');
+    return ext && !strcasecmp(ext, ".png");
+}
+
+static lv_res_t decoder_info(lv_img_decoder_t *, const void *src, lv_img_header_t *header) {
+    uint32_t w, h;
+    // lv_img_header_t holds 11-bit sizes; larger files stay with lodepng
+    if (!is_png_path(src) || !png_stream_info((const char *)src, &w, &h) || w > 2047 || h > 2047) {
+        return LV_RES_INV;
+    }
+    header->always_zero = 0;
+    header->cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+    header->w = w;
+    header->h = h;
+    return LV_RES_OK;
+}
+
+static lv_res_t decoder_open(lv_img_decoder_t *, lv_img_decoder_dsc_t *dsc) {
+    if (dsc->src_type != LV_IMG_SRC_FILE || !is_png_path(dsc->src)) return LV_RES_INV;
+    uint16_t w = dsc->header.w, h = dsc->header.h;
+    uint8_t *px = (uint8_t *)mem_alloc(MEM_POOL_IMAGES, (size_t)w * h * LV_IMG_PX_SIZE_ALPHA_BYTE);
+    if (!px) return LV_RES_INV;
+    if (!png_stream_decode((const char *)dsc->src, px, w, h)) {
+        mem_free(MEM_POOL_IMAGES, px);
+        return LV_RES_INV;   // lodepng gets a go
+    }
+    dsc->img_data = px;
+    return LV_RES_OK;
+}
+
+static void decoder_close(lv_img_decoder_t *, lv_img_decoder_dsc_t *dsc) {
+    mem_free(MEM_POOL_IMAGES, (void *)dsc->img_data);
+    dsc->img_data = nullptr;
+}
+
+void png_stream_register_decoder() {
+#if PNG_STREAM_DECODER
+    static bool registered = false;
+    if (registered) return;
+    // Decoders are tried newest first, so this one runs ahead of lodepng
+    lv_img_decoder_t *dec = lv_img_decoder_create();
+    if (!dec) return;
+    lv_img_decoder_set_info_cb(dec, decoder_info);
+    lv_img_decoder_set_open_cb(dec, decoder_open);
+    lv_img_decoder_set_close_cb(dec, decoder_close);
+    registered = true;
+#endif
+}
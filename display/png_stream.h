@@ -0,0 +1,35 @@
+#pragma once
+#include <stdint.h>
+#include <lvgl.h>
+
+// ============================================================
+// Line-streaming PNG decoder (RGB565 + alpha output)
+//
+// LVGL's lodepng decoder inflates the whole file into an RGBA8888 frame
+// before converting it, so a 256x256 icon peaks at ~256 KB plus the
+// compressed copy, only to be box-filtered down to 64x64 by the icon cache.
+// This one inflates IDAT in 512 B reads through a 32 KB window, unfilters
+// one scanline at a time and area-averages each line straight into the
+// LV_IMG_CF_TRUE_COLOR_ALPHA target at its final size: peak memory is the
+// window plus two scanlines and one row of accumulators.
+//
+// Takes every non-interlaced PNG (grey, RGB, palette, with alpha or tRNS,
+// 1..16 bit). Adam7 files are left to lodepng.
+//
+// Used by the icon cache build and, when PNG_STREAM_DECODER=1, registered
+// ahead of lodepng as LVGL's decoder for "S:...png" at native size.
+// ============================================================
+
+#ifndef PNG_STREAM_DECODER
+#define PNG_STREAM_DECODER 1
+#endif
+
+// Size of a PNG this decoder takes (`src` is an LVGL path, "S:/icons/a.png")
+bool png_stream_info(const char *src, uint32_t *w, uint32_t *h);
+
+// Decode `src` area-averaged to dw x dh into `dst` (dw * dh pixels of
+// lv_color_t + alpha byte). False on unsupported or corrupt files.
+bool png_stream_decode(const char *src, uint8_t *dst, uint16_t dw, uint16_t dh);
+
+// Register the LVGL image decoder (after lv_init(), so it is tried first)
+void png_stream_register_decoder();
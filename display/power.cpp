@@ -1,7 +1,14 @@
 #include "power.h"
 #include "display_hw.h"
+#include "battery.h"
+#include "tasks.h"
+#include "espnow_link.h"
+#include "status_store.h"
+#include "runtime_state.h"
+#include "stats_log.h"
 
 #include <Arduino.h>
+#include <lvgl.h>
 #include <vector>
 
 // ============================================================
@@ -15,8 +22,45 @@ static constexpr uint8_t BRIGHTNESS_CLOCK   = 16;
 
 // User-selectable brightness presets (cycled in ACTIVE state)
 static const uint8_t BRIGHTNESS_PRESETS[] = {255, 180, 100};
+static constexpr uint8_t BRIGHTNESS_STEP = 8;   // Per encoder detent, times its acceleration
+static constexpr uint8_t BRIGHTNESS_MIN  = 8;
 static constexpr uint8_t NUM_PRESETS = sizeof(BRIGHTNESS_PRESETS) / sizeof(BRIGHTNESS_PRESETS[0]);
 
+// Per-state power profile. 80 MHz is the lowest clock that keeps WiFi
+// (ESP-NOW, SoftAP) running; the RGB panel scanout and PSRAM clocks come
+// from the PLL and don't change with it.
+struct PowerProfile {
+    const char *name;
+    uint16_t refresh_ms;    // LVGL display refresh period
+    uint16_t cpu_mhz;
+    bool input_low_power;   // Slow polled touch/buttons (tasks.cpp)
+};
+static const PowerProfile PROFILES[POWER_STATE_COUNT] = {
+    { "ACTIVE", LV_DISP_DEF_REFR_PERIOD, 240, false },
+    { "DIMMED", 33,                      160, true  },   // ~30 fps, wakes on first touch anyway
+    { "CLOCK",  100,                     80,  true  },   // Minute clock: 10 fps is plenty
+};
+
+// Battery policy levels. Stats intervals are requests: the companion never
+// goes faster than its own configuration.
+struct PolicyLimits {
+    const char *name;
+    uint16_t heartbeat_ms;
+    uint16_t stats_interval_ms;   // 0 = companion default (1 s)
+    bool live_stats;
+    uint16_t min_refresh_ms;      // Floor under the state profile's refresh period
+    bool animations;
+};
+static const PolicyLimits POLICIES[POLICY_COUNT] = {
+    { "normal",   5000,  0,    true,  0,  true  },
+    { "saver",    15000, 2000, false, 33, false },
+    { "critical", 30000, 5000, false, 66, false },
+};
+
+static constexpr float    DISCHARGE_PCT_H      = -0.5f;  // CRATE below this = running on battery
+static constexpr uint8_t  POLICY_HYSTERESIS    = 3;      // % above a threshold before leaving it
+static constexpr uint32_t STATS_TIMEOUT_MIN_MS = 5000;
+
 // ============================================================
 // State
 // ============================================================
@@ -28,14 +72,148 @@ static uint8_t    user_brightness   = BRIGHTNESS_ACTIVE;  // Tracks user-chosen
 // Display mode state (orthogonal to power state)
 static DisplayMode current_mode = MODE_HOTKEYS;
 
+// Time and fuel-gauge discharge rate per power state (since boot)
+struct StateEnergy {
+    uint32_t time_ms;
+    float rate_sum;         // Sum of CRATE samples, %/h
+    uint32_t samples;
+};
+static StateEnergy energy[POWER_STATE_COUNT] = {};
+static uint32_t state_entered_ms = 0;
+
+// Battery policy
+static BatteryPolicy policy = POLICY_NORMAL;
+static uint8_t saver_pct = 30;
+static uint8_t critical_pct = 15;
+
+// ============================================================
+// Profiles + per-state accounting
+// ============================================================
+static void apply_profile(PowerState state) {
+    const PowerProfile &p = PROFILES[state];
+    uint16_t refresh_ms = p.refresh_ms;
+    if (refresh_ms < POLICIES[policy].min_refresh_ms) refresh_ms = POLICIES[policy].min_refresh_ms;
+    lvgl_set_refresh_period(refresh_ms);
+    tasks_set_input_low_power(p.input_low_power);
+#if POWER_DFS
+    if (getCpuFrequencyMhz() != p.cpu_mhz) setCpuFrequencyMhz(p.cpu_mhz);
+#endif
+}
+
+static void report_state(PowerState state) {
+    const StateEnergy &e = energy[state];
+    if (e.samples == 0) {
+        Serial.printf("[power] %s: %lu s total, no fuel gauge samples\n", PROFILES[state].name,
+                      (unsigned long)(e.time_ms / 1000));
+        return;
+    }
+    float rate = e.rate_sum / e.samples;
+#if BATTERY_CAPACITY_MAH > 0
+    Serial.printf("[power] %s: %lu s total, %.1f %%/h (~%d mA)\n", PROFILES[state].name,
+                  (unsigned long)(e.time_ms / 1000), rate, (int)(-rate * BATTERY_CAPACITY_MAH / 100.0f));
+#else
+    Serial.printf("[power] %s: %lu s total, %.1f %%/h\n", PROFILES[state].name,
+                  (unsigned long)(e.time_ms / 1000), rate);
+#endif
+}
+
+// Every state change goes through here: profile, accounting, report
+static void enter_state(PowerState next) {
+    uint32_t now = millis();
+    PowerState prev = current_state;
+    energy[prev].time_ms += now - state_entered_ms;
+    state_entered_ms = now;
+    current_state = next;
+    apply_profile(next);
+    report_state(prev);
+    if (next != POWER_ACTIVE) {   // Nobody's using it: a good time to write
+        runtime_state_flush();
+        stats_log_flush();
+    }
+}
+
+// Ask the companion for the policy's stats cadence
+static void send_stats_rate() {
+    const PolicyLimits &lim = POLICIES[policy];
+    StatsRateMsg msg = { lim.stats_interval_ms, (uint8_t)lim.live_stats };
+    espnow_send_reliable(MSG_STATS_RATE, (const uint8_t *)&msg, sizeof(msg));
+}
+
+static BatteryPolicy pick_policy(const BatteryState &battery) {
+    if (battery.rate_pct_h >= DISCHARGE_PCT_H) return POLICY_NORMAL;   // Charging / on USB
+    // Stay in the current level until the charge is clearly above its threshold
+    uint8_t margin_critical = policy >= POLICY_CRITICAL ? POLICY_HYSTERESIS : 0;
+    uint8_t margin_saver = policy >= POLICY_SAVER ? POLICY_HYSTERESIS : 0;
+    if (critical_pct && battery.percent <= critical_pct + margin_critical) return POLICY_CRITICAL;
+    if (saver_pct && battery.percent <= saver_pct + margin_saver) return POLICY_SAVER;
+    return POLICY_NORMAL;
+}
+
+void power_record_battery(const BatteryState &battery) {
+    if (!battery.available) return;
+    StateEnergy &e = energy[current_state];
+    e.rate_sum += battery.rate_pct_h;
+    e.samples++;
+
+    BatteryPolicy next = pick_policy(battery);
+    if (next != policy) {
+        Serial.printf("[power] Battery policy %s -> %s (%u%%, %.1f %%/h)\n", POLICIES[policy].name,
+                      POLICIES[next].name, battery.percent, battery.rate_pct_h);
+        policy = next;
+        apply_profile(current_state);
+        send_stats_rate();
+    } else if (policy != POLICY_NORMAL) {
+        send_stats_rate();   // Repeat while throttled: a restarted companion starts at full rate
+    }
+
+    // Estimated runtime at the current discharge rate (0 = charging / unknown)
+    uint16_t runtime_min = 0;
+    if (battery.rate_pct_h < DISCHARGE_PCT_H) {
+        float minutes = battery.percent * 60.0f / -battery.rate_pct_h;
+        runtime_min = minutes > 0xFFFF ? 0xFFFF : (uint16_t)minutes;
+    }
+    status_set_battery(battery.percent, runtime_min, policy);
+}
+
+void power_set_battery_thresholds(uint8_t saver, uint8_t critical) {
+    saver_pct = saver;
+    critical_pct = critical;
+    battery_set_low_threshold(critical);   // Gauge alerts when crossing into critical
+}
+
+BatteryPolicy power_get_policy() {
+    return policy;
+}
+
+uint32_t power_heartbeat_ms() {
+    return POLICIES[policy].heartbeat_ms;
+}
+
+uint32_t power_stats_timeout_ms() {
+    uint32_t timeout = POLICIES[policy].stats_interval_ms * 3u;
+    return timeout > STATS_TIMEOUT_MIN_MS ? timeout : STATS_TIMEOUT_MIN_MS;
+}
+
+bool power_animations_enabled() {
+    return POLICIES[policy].animations;
+}
+
 // ============================================================
 // power_init()
 // ============================================================
 void power_init() {
     current_state    = POWER_ACTIVE;
     last_activity_ms = millis();
+    state_entered_ms = last_activity_ms;
     user_brightness  = BRIGHTNESS_ACTIVE;
-    set_backlight(BRIGHTNESS_ACTIVE);
+    // Preset chosen before the last reboot (runtime_state_restore() ran first)
+    uint8_t saved = runtime_state_get().preset_index;
+    if (saved < NUM_PRESETS) {
+        preset_index = saved;
+        user_brightness = BRIGHTNESS_PRESETS[saved];
+    }
+    set_backlight(user_brightness);
+    apply_profile(POWER_ACTIVE);
 }
 
 // ============================================================
@@ -44,7 +222,7 @@ void power_init() {
 void power_update() {
     if (current_state == POWER_ACTIVE) {
         if (millis() - last_activity_ms > IDLE_TIMEOUT_MS) {
-            current_state = POWER_DIMMED;
+            enter_state(POWER_DIMMED);
             set_backlight(BRIGHTNESS_DIMMED);
             Serial.println("[power] ACTIVE -> DIMMED (idle timeout)");
         }
@@ -59,7 +237,7 @@ void power_activity() {
     last_activity_ms = millis();
 
     if (current_state == POWER_DIMMED) {
-        current_state = POWER_ACTIVE;
+        enter_state(POWER_ACTIVE);
         set_backlight(user_brightness);
         Serial.println("[power] DIMMED -> ACTIVE (activity)");
     }
@@ -70,7 +248,7 @@ void power_activity() {
 // power_shutdown_received() -- PC going to sleep/shutdown
 // ============================================================
 void power_shutdown_received() {
-    current_state = POWER_CLOCK;
+    if (current_state != POWER_CLOCK) enter_state(POWER_CLOCK);
     set_backlight(BRIGHTNESS_CLOCK);
     Serial.println("[power] -> CLOCK_MODE (PC shutdown)");
 }
@@ -80,7 +258,7 @@ void power_shutdown_received() {
 // ============================================================
 void power_wake_detected() {
     if (current_state == POWER_CLOCK) {
-        current_state    = POWER_ACTIVE;
+        enter_state(POWER_ACTIVE);
         last_activity_ms = millis();
         set_backlight(BRIGHTNESS_ACTIVE);
         Serial.println("[power] CLOCK_MODE -> ACTIVE (wake)");
@@ -102,6 +280,7 @@ void display_set_mode(DisplayMode mode) {
 
     DisplayMode prev_mode = current_mode;
     current_mode = mode;
+    runtime_state_set_mode(mode);
 
     // Call UI transition handler (implemented in ui.cpp)
     extern void ui_transition_mode(DisplayMode from, DisplayMode to);
@@ -127,10 +306,27 @@ void power_cycle_brightness() {
     user_brightness = BRIGHTNESS_PRESETS[preset_index];
     set_backlight(user_brightness);
     last_activity_ms = millis();
+    runtime_state_set_preset(preset_index);
 
     Serial.printf("[power] Brightness preset %d: %d\n", preset_index, user_brightness);
 }
 
+// ============================================================
+// power_step_brightness() -- encoder brightness mode (ACTIVE only)
+// ============================================================
+void power_step_brightness(int8_t steps) {
+    if (current_state != POWER_ACTIVE) return;
+
+    int level = user_brightness + steps * BRIGHTNESS_STEP;
+    if (level < BRIGHTNESS_MIN) level = BRIGHTNESS_MIN;
+    if (level > 255) level = 255;
+    if (level == user_brightness) return;
+    user_brightness = (uint8_t)level;
+    // Short fades: each detent retargets the ramp still running from the last one
+    set_backlight(user_brightness, BACKLIGHT_STEP_FADE_MS);
+    last_activity_ms = millis();
+}
+
 // ============================================================
 // mode_cycle_next() -- cycle through user-configured enabled modes
 // ============================================================
@@ -2,10 +2,25 @@
 #include <cstdint>
 #include <vector>
 
+struct BatteryState;
+
+// Power profiles: besides the backlight, each PowerState sets the LVGL
+// refresh period, the CPU clock (build flag -DPOWER_DFS=0 keeps 240 MHz)
+// and the input polling rate. See PROFILES in power.cpp.
+#ifndef POWER_DFS
+#define POWER_DFS 1
+#endif
+
+// Pack capacity for the per-state current estimate (0 = report %/h only)
+#ifndef BATTERY_CAPACITY_MAH
+#define BATTERY_CAPACITY_MAH 0
+#endif
+
 enum PowerState : uint8_t {
     POWER_ACTIVE,   // Full brightness, normal operation
     POWER_DIMMED,   // Reduced brightness, idle timeout
     POWER_CLOCK,    // Minimal brightness, clock mode (PC off)
+    POWER_STATE_COUNT
 };
 
 // Display modes -- orthogonal to PowerState
@@ -24,8 +39,30 @@ void power_shutdown_received(); // Call when MSG_POWER_STATE shutdown received -
 void power_wake_detected();     // Call when any bridge message received in CLOCK_MODE -- return to ACTIVE
 PowerState power_get_state();   // Get current power state
 
+// Fuel gauge sample (every ~30 s): accumulates the discharge rate per power
+// state, printed with the time spent in a state each time it is left, and
+// re-evaluates the battery policy
+void power_record_battery(const BatteryState &battery);
+
+// Battery policy: on battery (fuel gauge discharging) at or below the
+// display_settings thresholds, the heartbeat and companion stats slow down,
+// animations are skipped and the frame rate is capped. Back to NORMAL as
+// soon as external power returns. Thresholds of 0 disable a level.
+enum BatteryPolicy : uint8_t {
+    POLICY_NORMAL,
+    POLICY_SAVER,
+    POLICY_CRITICAL,
+    POLICY_COUNT
+};
+void power_set_battery_thresholds(uint8_t saver_pct, uint8_t critical_pct);
+BatteryPolicy power_get_policy();
+uint32_t power_heartbeat_ms();      // PING + device status period
+uint32_t power_stats_timeout_ms();  // No MSG_STATS for this long = companion gone
+bool power_animations_enabled();    // Toast fade, slideshow transitions
+
 // Brightness cycling for user control (3 presets: HIGH/MED/LOW)
 void power_cycle_brightness();  // Cycle through brightness presets (only in ACTIVE state)
+void power_step_brightness(int8_t steps);  // Encoder: nudge the level up/down, ramped (ACTIVE only)
 
 // Display mode switching (orthogonal to power state)
 void display_set_mode(DisplayMode mode);   // Switch to new display mode
@@ -0,0 +1,249 @@
+/**
+ * @file remote_image.cpp
+ * PSRAM frames for WIDGET_REMOTE_IMAGE, patched tile by tile from the companion
+ *
+ * One frame per source name, shared by every widget that shows it. Patches
+ * are validated while they are applied: a malformed tile stops the patch
+ * and leaves the frame without a sequence number, so the next delta is
+ * refused and the companion resends a key frame.
+ */
+
+#include "remote_image.h"
+#include "protocol.h"
+#include "mem_budget.h"
+#include "log.h"
+#include <Arduino.h>
+#include <string.h>
+#include <vector>
+
+struct RemoteSource {
+    char name[BULK_PATH_MAX];             // "" = free slot
+    uint16_t *px;                         // MEM_POOL_IMAGES, w * h
+    uint16_t w, h;
+    uint16_t seq;                         // Frame held, 0 = none / incomplete
+    lv_img_dsc_t dsc;
+    std::vector<lv_obj_t *> views;
+};
+
+static RemoteSource sources[REMOTE_IMAGE_SOURCES];
+
+// Patch being received
+static uint8_t *staged = nullptr;         // MEM_POOL_UPLOAD
+static uint32_t staged_size = 0;
+static uint32_t staged_len = 0;
+static char staged_source[BULK_PATH_MAX];
+
+// ============================================================
+// Sources
+// ============================================================
+
+static void frame_free(RemoteSource &s) {
+    for (lv_obj_t *v : s.views) lv_img_set_src(v, nullptr);
+    if (s.px) lv_img_cache_invalidate_src(&s.dsc);
+    mem_free(MEM_POOL_IMAGES, s.px);
+    s.px = nullptr;
+    s.w = s.h = 0;
+    s.seq = 0;
+    s.dsc = {};
+}
+
+// Slot for `name`; with `create`, a free one or one no widget shows
+static RemoteSource *find_source(const char *name, bool create) {
+    for (auto &s : sources) {
+        if (s.name[0] && strcmp(s.name, name) == 0) return &s;
+    }
+    if (!create) return nullptr;
+    RemoteSource *pick = nullptr;
+    for (auto &s : sources) {
+        if (!s.name[0]) return &s;
+        if (!pick && s.views.empty()) pick = &s;
+    }
+    if (pick) {
+        Serial.printf("[remote] dropping unused source '%s'\n", pick->name);
+        frame_free(*pick);
+        pick->name[0] = '\0';
+    }
+    return pick;
+}
+
+static RemoteSource &claim(RemoteSource &s, const char *name) {
+    if (!s.name[0]) snprintf(s.name, sizeof(s.name), "%s", name);
+    return s;
+}
+
+// Cleared w x h frame; views are re-pointed when the size changes
+static bool frame_alloc(RemoteSource &s, uint16_t w, uint16_t h) {
+    size_t bytes = (size_t)w * h * sizeof(uint16_t);
+    if (s.px && s.w == w && s.h == h) {
+        memset(s.px, 0, bytes);
+        return true;
+    }
+    frame_free(s);
+    s.px = (uint16_t *)mem_alloc(MEM_POOL_IMAGES, bytes);
+    if (!s.px) return false;
+    memset(s.px, 0, bytes);
+    s.w = w;
+    s.h = h;
+    s.dsc.header.always_zero = 0;
+    s.dsc.header.cf = LV_IMG_CF_TRUE_COLOR;
+    s.dsc.header.w = w;
+    s.dsc.header.h = h;
+    s.dsc.data_size = bytes;
+    s.dsc.data = (const uint8_t *)s.px;
+    for (lv_obj_t *v : s.views) lv_img_set_src(v, &s.dsc);
+    return true;
+}
+
+static void view_deleted_cb(lv_event_t *e) {
+    lv_obj_t *obj = lv_event_get_target(e);
+    for (auto &s : sources) {
+        for (size_t i = 0; i < s.views.size(); i++) {
+            if (s.views[i] == obj) {
+                s.views.erase(s.views.begin() + i);
+                return;
+            }
+        }
+    }
+}
+
+void remote_image_attach(lv_obj_t *img, const char *source) {
+    RemoteSource *s = find_source(source, true);
+    if (!s) {
+        Serial.printf("[remote] no slot for source '%s' (max %d)\n", source, REMOTE_IMAGE_SOURCES);
+        return;
+    }
+    claim(*s, source).views.push_back(img);
+    lv_obj_add_event_cb(img, view_deleted_cb, LV_EVENT_DELETE, nullptr);
+    if (s->px) lv_img_set_src(img, &s->dsc);
+}
+
+// ============================================================
+// Tiles
+// ============================================================
+
+static bool apply_tile(RemoteSource &s, const RemoteTileHdr &t, const uint8_t *d) {
+    uint32_t x0 = (uint32_t)t.tx * REMOTE_TILE, y0 = (uint32_t)t.ty * REMOTE_TILE;
+    if (x0 >= s.w || y0 >= s.h) return false;
+    uint32_t tw = s.w - x0 < REMOTE_TILE ? s.w - x0 : REMOTE_TILE;
+    uint32_t th = s.h - y0 < REMOTE_TILE ? s.h - y0 : REMOTE_TILE;
+    uint16_t *origin = s.px + y0 * s.w + x0;
+
+    switch (t.encoding) {
+        case TILE_RAW:
+            if (t.len != tw * th * 2) return false;
+            for (uint32_t r = 0; r < th; r++) memcpy(origin + r * s.w, d + r * tw * 2, tw * 2);
+            return true;
+        case TILE_FILL: {
+            if (t.len != 2) return false;
+            uint16_t c = d[0] | d[1] << 8;
+            for (uint32_t r = 0; r < th; r++) {
+                uint16_t *row = origin + r * s.w;
+                for (uint32_t i = 0; i < tw; i++) row[i] = c;
+            }
+            return true;
+        }
+        case TILE_RLE: {
+            const uint8_t *p = d, *end = d + t.len;
+            uint32_t n = tw * th, i = 0;
+            while (i < n) {
+                if (end - p < 3) return false;
+                uint32_t run = p[0] + 1u;
+                uint16_t c = p[1] | p[2] << 8;
+                p += 3;
+                if (run > n - i) return false;
+                for (; run; run--, i++) origin[(i / tw) * s.w + i % tw] = c;
+            }
+            return p == end;
+        }
+        default:
+            return false;
+    }
+}
+
+static void invalidate_tile(const RemoteSource &s, const RemoteTileHdr &t) {
+    lv_coord_t x0 = t.tx * REMOTE_TILE, y0 = t.ty * REMOTE_TILE;
+    for (lv_obj_t *v : s.views) {
+        lv_area_t c;
+        lv_obj_get_coords(v, &c);
+        lv_area_t a = { (lv_coord_t)(c.x1 + x0), (lv_coord_t)(c.y1 + y0),
+                        (lv_coord_t)(c.x1 + x0 + REMOTE_TILE - 1), (lv_coord_t)(c.y1 + y0 + REMOTE_TILE - 1) };
+        lv_obj_invalidate_area(v, &a);   // Clipped to the object
+    }
+}
+
+static uint8_t apply_patch() {
+    RemoteImageHdr h;
+    if (staged_len < sizeof(h)) return BULK_ERR_BAD;
+    memcpy(&h, staged, sizeof(h));
+    if (!h.width || !h.height || h.width > REMOTE_IMAGE_MAX_DIM || h.height > REMOTE_IMAGE_MAX_DIM || !h.seq) {
+        return BULK_ERR_BAD;
+    }
+    RemoteSource *found = find_source(staged_source, true);
+    if (!found) return BULK_ERR_IO;
+    RemoteSource &s = claim(*found, staged_source);
+
+    bool key = h.base_seq == 0;
+    if (!key && (!s.px || s.seq != h.base_seq || s.w != h.width || s.h != h.height)) {
+        LOG_D("[remote] %s: patch on frame %u, holding %u: key frame needed\n", s.name, h.base_seq, s.seq);
+        return BULK_ERR_BAD;
+    }
+    if (key && !frame_alloc(s, h.width, h.height)) {
+        Serial.printf("[remote] %s: no memory for %ux%u\n", s.name, h.width, h.height);
+        return BULK_ERR_IO;
+    }
+
+    s.seq = 0;   // Until every tile is in
+    const uint8_t *p = staged + sizeof(h), *end = staged + staged_len;
+    for (uint16_t i = 0; i < h.tile_count; i++) {
+        RemoteTileHdr t;
+        if ((size_t)(end - p) < sizeof(t)) return BULK_ERR_BAD;
+        memcpy(&t, p, sizeof(t));
+        p += sizeof(t);
+        if ((size_t)(end - p) < t.len || !apply_tile(s, t, p)) {
+            Serial.printf("[remote] %s: bad tile %u (%u,%u)\n", s.name, i, t.tx, t.ty);
+            return BULK_ERR_BAD;
+        }
+        p += t.len;
+        if (!key) invalidate_tile(s, t);
+    }
+    if (key) {
+        for (lv_obj_t *v : s.views) lv_obj_invalidate(v);
+    }
+    s.seq = h.seq;
+    LOG_D("[remote] %s: frame %u, %u tiles (%lu bytes)%s\n", s.name, h.seq, h.tile_count,
+          (unsigned long)staged_len, key ? ", key" : "");
+    return BULK_DONE;
+}
+
+// ============================================================
+// Bulk receiver
+// ============================================================
+
+bool remote_image_begin(const char *source, uint32_t size) {
+    remote_image_abort();
+    if (!source[0] || size < sizeof(RemoteImageHdr) || size > REMOTE_IMAGE_PATCH_MAX) return false;
+    staged = (uint8_t *)mem_alloc(MEM_POOL_UPLOAD, size);
+    if (!staged) return false;
+    staged_size = size;
+    snprintf(staged_source, sizeof(staged_source), "%s", source);
+    return true;
+}
+
+bool remote_image_write(const uint8_t *data, uint32_t len) {
+    if (!staged || staged_len + len > staged_size) return false;
+    memcpy(staged + staged_len, data, len);
+    staged_len += len;
+    return true;
+}
+
+uint8_t remote_image_end() {
+    uint8_t status = staged ? apply_patch() : (uint8_t)BULK_ERR_BAD;
+    remote_image_abort();
+    return status;
+}
+
+void remote_image_abort() {
+    mem_free(MEM_POOL_UPLOAD, staged);
+    staged = nullptr;
+    staged_size = staged_len = 0;
+}
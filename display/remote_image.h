@@ -0,0 +1,33 @@
+#pragma once
+#include <lvgl.h>
+#include <stdint.h>
+
+// ============================================================
+// Remote images (WIDGET_REMOTE_IMAGE, BULK_FLAG_IMAGE patches)
+//
+// Frames pushed by the companion -- now-playing art, thumbnails, graphs
+// rendered on the host -- live in PSRAM per source name, RGB565 with no
+// alpha, shown by lv_img objects pointing straight at them. A patch is
+// staged whole (bulk DATA arrives in order, CRC-checked at END), then its
+// tiles are written into the frame and only those tiles are invalidated.
+// The frame survives page switches and UI rebuilds; a source no widget
+// shows is the first to go when a new one needs a slot.
+// ============================================================
+
+#ifndef REMOTE_IMAGE_SOURCES
+#define REMOTE_IMAGE_SOURCES    4              // Distinct source names held at once
+#endif
+#ifndef REMOTE_IMAGE_PATCH_MAX
+#define REMOTE_IMAGE_PATCH_MAX  (160 * 1024)   // Largest patch (upload pool)
+#endif
+
+// Show `source` in `img` (an lv_img); blank until its first frame arrives.
+// The object unregisters itself when deleted.
+void remote_image_attach(lv_obj_t *img, const char *source);
+
+// Bulk receiver side (UI task): stage a patch of `size` bytes for `source`,
+// append in order, then apply. remote_image_end() returns a BulkStatus.
+bool remote_image_begin(const char *source, uint32_t size);
+bool remote_image_write(const uint8_t *data, uint32_t len);
+uint8_t remote_image_end();
+void remote_image_abort();
@@ -0,0 +1,94 @@
+/**
+ * @file rgb_bounce.cpp
+ * esp_lcd RGB panel with internal-SRAM bounce buffers
+ *
+ * Replaces Bus_RGB/Panel_RGB when DISPLAY_BOUNCE_LINES > 0; display_hw
+ * routes its framebuffer writes and reads here.
+ */
+
+#include "display_hw.h"
+#if DISPLAY_BOUNCE_LINES
+#include "rgb_bounce.h"
+#include <Arduino.h>
+#include <esp_lcd_panel_ops.h>
+#include <esp_lcd_panel_rgb.h>
+#include <string.h>
+
+static esp_lcd_panel_handle_t panel = nullptr;
+static uint16_t *fb = nullptr;
+static uint32_t pclk_hz = 0;
+
+bool rgb_bounce_init(const lgfx::Bus_RGB::config_t &bus, uint16_t bounce_lines) {
+    esp_lcd_rgb_panel_config_t cfg = {};
+    cfg.clk_src = LCD_CLK_SRC_DEFAULT;
+    cfg.timings.pclk_hz = bus.freq_write;
+    cfg.timings.h_res = SCREEN_WIDTH;
+    cfg.timings.v_res = SCREEN_HEIGHT;
+    cfg.timings.hsync_pulse_width = bus.hsync_pulse_width;
+    cfg.timings.hsync_back_porch = bus.hsync_back_porch;
+    cfg.timings.hsync_front_porch = bus.hsync_front_porch;
+    cfg.timings.vsync_pulse_width = bus.vsync_pulse_width;
+    cfg.timings.vsync_back_porch = bus.vsync_back_porch;
+    cfg.timings.vsync_front_porch = bus.vsync_front_porch;
+    // Bus_RGB's polarity is the LCD_CAM idle level; esp_lcd asks the opposite question
+    cfg.timings.flags.hsync_idle_low = !bus.hsync_polarity;
+    cfg.timings.flags.vsync_idle_low = !bus.vsync_polarity;
+    cfg.timings.flags.de_idle_high = bus.de_idle_high;
+    cfg.timings.flags.pclk_active_neg = bus.pclk_active_neg;
+    cfg.timings.flags.pclk_idle_high = bus.pclk_idle_high;
+    cfg.data_width = 16;
+    cfg.bits_per_pixel = 16;
+    cfg.num_fbs = 1;
+    cfg.bounce_buffer_size_px = SCREEN_WIDTH * bounce_lines;
+    cfg.hsync_gpio_num = bus.pin_hsync;
+    cfg.vsync_gpio_num = bus.pin_vsync;
+    cfg.de_gpio_num = bus.pin_henable;
+    cfg.pclk_gpio_num = bus.pin_pclk;
+    cfg.disp_gpio_num = -1;
+    const int8_t data[16] = {
+        bus.pin_d0, bus.pin_d1, bus.pin_d2, bus.pin_d3, bus.pin_d4, bus.pin_d5, bus.pin_d6, bus.pin_d7,
+        bus.pin_d8, bus.pin_d9, bus.pin_d10, bus.pin_d11, bus.pin_d12, bus.pin_d13, bus.pin_d14, bus.pin_d15,
+    };
+    for (int i = 0; i < 16; i++) cfg.data_gpio_nums[i] = data[i];
+    cfg.flags.fb_in_psram = 1;
+
+    esp_err_t err = esp_lcd_new_rgb_panel(&cfg, &panel);
+    if (err == ESP_OK) err = esp_lcd_panel_reset(panel);
+    if (err == ESP_OK) err = esp_lcd_panel_init(panel);
+    if (err == ESP_OK) err = esp_lcd_rgb_panel_get_frame_buffer(panel, 1, (void **)&fb);
+    if (err != ESP_OK) {
+        Serial.printf("[rgb_bounce] panel init failed (%d)\n", err);
+        if (panel) esp_lcd_panel_del(panel);
+        panel = nullptr;
+        fb = nullptr;
+        return false;
+    }
+    pclk_hz = bus.freq_write;
+    memset(fb, 0, SCREEN_WIDTH * SCREEN_HEIGHT * sizeof(uint16_t));
+    esp_lcd_panel_draw_bitmap(panel, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, fb);   // Write-back only
+    Serial.printf("[rgb_bounce] %lu Hz PCLK, 2x%u-line bounce buffers (%u KB internal)\n",
+                  (unsigned long)pclk_hz, bounce_lines,
+                  (unsigned)(2 * SCREEN_WIDTH * bounce_lines * sizeof(uint16_t) / 1024));
+    return true;
+}
+
+uint16_t *rgb_bounce_frame_buffer() {
+    return fb;
+}
+
+void rgb_bounce_draw(int x1, int y1, int x2, int y2, const uint16_t *px) {
+    if (!panel) return;
+    // Within the framebuffer itself (direct mode) esp_lcd only writes the cache back
+    esp_lcd_panel_draw_bitmap(panel, x1, y1, x2 + 1, y2 + 1, px);
+}
+
+bool rgb_bounce_set_pclk(uint32_t hz) {
+    if (!panel || esp_lcd_rgb_panel_set_pclk(panel, hz) != ESP_OK) return false;
+    pclk_hz = hz;
+    return true;
+}
+
+uint32_t rgb_bounce_pclk() {
+    return pclk_hz;
+}
+#endif
@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+#include <LovyanGFX.hpp>
+#include <lgfx/v1/platforms/esp32s3/Bus_RGB.hpp>
+
+// ============================================================
+// RGB panel scan-out through internal-SRAM bounce buffers
+// (-DDISPLAY_BOUNCE_LINES=N, see display_hw.h)
+//
+// Bus_RGB points the scan-out DMA straight at the PSRAM framebuffer, so
+// every LVGL render and stripe copy competes with the panel for PSRAM
+// bandwidth, and a PCLK much above 12 MHz underruns. Here esp_lcd's RGB
+// driver drives the panel instead: the DMA reads two N-line buffers in
+// internal RAM that its ISR refills from the PSRAM framebuffer, a burst
+// at a time, leaving headroom for a faster PCLK.
+//
+// Pins and timings come from the Bus_RGB config in display_hw.cpp, which
+// stays the single description of the wiring. UI task only, apart from
+// rgb_bounce_draw() (whichever task flushes).
+// ============================================================
+
+bool rgb_bounce_init(const lgfx::Bus_RGB::config_t &bus, uint16_t bounce_lines);
+
+uint16_t *rgb_bounce_frame_buffer();      // SCREEN_WIDTH x SCREEN_HEIGHT, contiguous
+
+// Copy a rectangle (inclusive corners, RGB565) into the framebuffer and
+// write it back from the CPU cache for the refill ISR
+void rgb_bounce_draw(int x1, int y1, int x2, int y2, const uint16_t *px);
+
+// Change the pixel clock; the driver applies it on the next vsync
+bool rgb_bounce_set_pclk(uint32_t hz);
+uint32_t rgb_bounce_pclk();
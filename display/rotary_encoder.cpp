@@ -1 +1,123 @@
-// Replaced by hw_input.h/cpp in Phase 11
+/**
+ * @file rotary_encoder.cpp
+ * Quadrature decoding of the rotary encoder on the PCNT peripheral
+ *
+ * Two channels on one unit give x4 decoding: each counts the edges of one
+ * line, in the direction the other line's level says. Contact bounce on
+ * one line only toggles the count back and forth, and the glitch filter
+ * drops spikes shorter than ENCODER_PCNT_GLITCH_NS before they count.
+ */
+
+#include "rotary_encoder.h"
+#include "events.h"
+#include <Arduino.h>
+#include <driver/gpio.h>
+#include <driver/pulse_cnt.h>
+
+// ============================================================
+// State
+// ============================================================
+static pcnt_unit_handle_t unit = nullptr;
+static pcnt_channel_handle_t chan_clk = nullptr;
+static pcnt_channel_handle_t chan_dt = nullptr;
+
+// Written by the PCNT ISR, read by the UI task
+static volatile int32_t detent_total = 0;
+static volatile uint32_t detent_ms = 0;
+static int32_t detent_taken = 0;   // UI task only
+
+// ============================================================
+// ISR: one limit reached = one detent (the unit is back at 0)
+// ============================================================
+static bool IRAM_ATTR on_reach(pcnt_unit_handle_t, const pcnt_watch_event_data_t *edata, void *) {
+    detent_total += edata->watch_point_value > 0 ? 1 : -1;
+    detent_ms = millis();
+    events_post_from_isr(EVT_HW_DATA);
+    return false;   // events_post_from_isr() yields if it woke a task
+}
+
+// ============================================================
+// Setup
+// ============================================================
+static void teardown() {
+    if (chan_clk) pcnt_del_channel(chan_clk);
+    if (chan_dt) pcnt_del_channel(chan_dt);
+    if (unit) pcnt_del_unit(unit);
+    chan_clk = chan_dt = nullptr;
+    unit = nullptr;
+}
+
+static bool check(esp_err_t err, const char *what) {
+    if (err == ESP_OK) return true;
+    Serial.printf("[encoder] %s failed: %s\n", what, esp_err_to_name(err));
+    return false;
+}
+
+bool rotary_encoder_init() {
+    if (ENCODER_PCNT_CLK_GPIO < 0 || ENCODER_PCNT_DT_GPIO < 0) return false;
+
+    pcnt_unit_config_t unit_cfg = {};
+    unit_cfg.low_limit = -ENCODER_PCNT_COUNTS_PER_DETENT;
+    unit_cfg.high_limit = ENCODER_PCNT_COUNTS_PER_DETENT;
+    if (!check(pcnt_new_unit(&unit_cfg, &unit), "pcnt_new_unit")) return false;
+
+    pcnt_glitch_filter_config_t filter_cfg = {};
+    filter_cfg.max_glitch_ns = ENCODER_PCNT_GLITCH_NS;
+
+    pcnt_chan_config_t clk_cfg = {};
+    clk_cfg.edge_gpio_num = ENCODER_PCNT_CLK_GPIO;
+    clk_cfg.level_gpio_num = ENCODER_PCNT_DT_GPIO;
+    pcnt_chan_config_t dt_cfg = {};
+    dt_cfg.edge_gpio_num = ENCODER_PCNT_DT_GPIO;
+    dt_cfg.level_gpio_num = ENCODER_PCNT_CLK_GPIO;
+
+    // CW (as the PCF8575 decoder counts it): CLK rises with DT low, DT rises with CLK high
+    pcnt_event_callbacks_t cbs = {};
+    cbs.on_reach = on_reach;
+    bool ok = check(pcnt_unit_set_glitch_filter(unit, &filter_cfg), "glitch filter") &&
+              check(pcnt_new_channel(unit, &clk_cfg, &chan_clk), "CLK channel") &&
+              check(pcnt_new_channel(unit, &dt_cfg, &chan_dt), "DT channel") &&
+              check(pcnt_channel_set_edge_action(chan_clk, PCNT_CHANNEL_EDGE_ACTION_DECREASE,
+                                                 PCNT_CHANNEL_EDGE_ACTION_INCREASE), "CLK edges") &&
+              check(pcnt_channel_set_level_action(chan_clk, PCNT_CHANNEL_LEVEL_ACTION_KEEP,
+                                                  PCNT_CHANNEL_LEVEL_ACTION_INVERSE), "CLK levels") &&
+              check(pcnt_channel_set_edge_action(chan_dt, PCNT_CHANNEL_EDGE_ACTION_INCREASE,
+                                                 PCNT_CHANNEL_EDGE_ACTION_DECREASE), "DT edges") &&
+              check(pcnt_channel_set_level_action(chan_dt, PCNT_CHANNEL_LEVEL_ACTION_KEEP,
+                                                  PCNT_CHANNEL_LEVEL_ACTION_INVERSE), "DT levels") &&
+              check(pcnt_unit_add_watch_point(unit, unit_cfg.low_limit), "watch point") &&
+              check(pcnt_unit_add_watch_point(unit, unit_cfg.high_limit), "watch point") &&
+              check(pcnt_unit_register_event_callbacks(unit, &cbs, nullptr), "callbacks") &&
+              check(pcnt_unit_enable(unit), "enable") &&
+              check(pcnt_unit_clear_count(unit), "clear") &&
+              check(pcnt_unit_start(unit), "start");
+    if (!ok) {
+        teardown();
+        return false;
+    }
+
+    // Common-to-ground encoder, like the PCF8575's quasi-bidirectional inputs
+    gpio_set_pull_mode((gpio_num_t)ENCODER_PCNT_CLK_GPIO, GPIO_PULLUP_ONLY);
+    gpio_set_pull_mode((gpio_num_t)ENCODER_PCNT_DT_GPIO, GPIO_PULLUP_ONLY);
+
+    Serial.printf("[encoder] PCNT on CLK=%d DT=%d, %d counts/detent, %d ns glitch filter\n",
+                  ENCODER_PCNT_CLK_GPIO, ENCODER_PCNT_DT_GPIO,
+                  ENCODER_PCNT_COUNTS_PER_DETENT, ENCODER_PCNT_GLITCH_NS);
+    return true;
+}
+
+bool rotary_encoder_active() {
+    return unit != nullptr;
+}
+
+// ============================================================
+// UI task
+// ============================================================
+int32_t rotary_encoder_take(uint32_t *last_ms) {
+    if (!unit) return 0;
+    int32_t total = detent_total;
+    int32_t delta = total - detent_taken;
+    detent_taken = total;
+    if (last_ms) *last_ms = detent_ms;
+    return delta;
+}
@@ -1,2 +1,35 @@
-// Replaced by hw_input.h/cpp in Phase 11
 #pragma once
+#include <stdint.h>
+
+// Rotary encoder on the ESP32-S3 pulse counter (PCNT)
+//
+// With CLK and DT wired to GPIOs, the PCNT unit decodes the quadrature in
+// hardware (both edges of both lines, glitch filtered), so no detent is
+// lost however fast the knob spins or however late the UI task polls.
+// The unit counts ENCODER_PCNT_COUNTS_PER_DETENT steps each way and resets
+// at its limits; each limit reached is one detent, tallied by the PCNT
+// interrupt, which also posts EVT_HW_DATA. Unset pins (-1, the default)
+// leave the encoder on the PCF8575 and its software decoder (hw_input.cpp).
+#ifndef ENCODER_PCNT_CLK_GPIO
+#define ENCODER_PCNT_CLK_GPIO -1
+#endif
+#ifndef ENCODER_PCNT_DT_GPIO
+#define ENCODER_PCNT_DT_GPIO -1
+#endif
+#ifndef ENCODER_PCNT_COUNTS_PER_DETENT
+#define ENCODER_PCNT_COUNTS_PER_DETENT 4   // Full quadrature cycle per detent (2 for half-cycle encoders)
+#endif
+#ifndef ENCODER_PCNT_GLITCH_NS
+#define ENCODER_PCNT_GLITCH_NS 1000        // Pulses shorter than this are ignored (max ~12700)
+#endif
+
+// Set up the PCNT unit (setup). Returns true if it drives the encoder,
+// false if the pins are unset or the driver refused (log says why).
+bool rotary_encoder_init();
+
+// PCNT decoding in use
+bool rotary_encoder_active();
+
+// UI task: net detents since the previous call (+ = CW), and in *last_ms
+// the millis() of the latest one. 0 while inactive.
+int32_t rotary_encoder_take(uint32_t *last_ms);
@@ -0,0 +1,121 @@
+/**
+ * @file runtime_state.cpp
+ * Coalesced NVS store for the UI state that should survive a reboot
+ *
+ * One fixed-size blob under "rtstate"/"state": a header (magic, version,
+ * write count) and the RuntimeState. A blob of another size or version is
+ * ignored, so adding a field only costs one boot on defaults.
+ */
+
+#include "runtime_state.h"
+#include <Arduino.h>
+#include <Preferences.h>
+
+#define RUNTIME_STATE_MAGIC   0x5452u   // "RT"
+#define RUNTIME_STATE_VERSION 1
+
+struct RuntimeStateBlob {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t reserved;
+    uint32_t writes;        // Flash writes since the blob was first created
+    RuntimeState state;
+};
+
+static RuntimeState state = { 0, RUNTIME_STATE_NONE, RUNTIME_STATE_NONE, -1 };
+static RuntimeState stored = state;   // What NVS holds
+static uint32_t writes = 0;
+static bool dirty = false;
+static uint32_t last_change_ms = 0;
+static uint32_t changes = 0;          // Setter calls since the last write
+
+void runtime_state_restore() {
+    uint32_t t0 = micros();
+    Preferences prefs;
+    if (!prefs.begin("rtstate", true)) {
+        Serial.println("[state] no stored runtime state, using defaults");
+        return;
+    }
+    RuntimeStateBlob blob;
+    size_t n = prefs.getBytes("state", &blob, sizeof(blob));
+    prefs.end();
+    if (n != sizeof(blob) || blob.magic != RUNTIME_STATE_MAGIC || blob.version != RUNTIME_STATE_VERSION) {
+        Serial.println("[state] stored runtime state unusable, using defaults");
+        return;
+    }
+    state = stored = blob.state;
+    writes = blob.writes;
+    Serial.printf("[state] restored page %u, preset %d, mode %d, focus %d in %lu us (%lu writes)\n",
+                  state.page, state.preset_index == RUNTIME_STATE_NONE ? -1 : state.preset_index,
+                  state.display_mode == RUNTIME_STATE_NONE ? -1 : state.display_mode, state.focus_index,
+                  (unsigned long)(micros() - t0), (unsigned long)writes);
+}
+
+const RuntimeState &runtime_state_get() {
+    return state;
+}
+
+static void mark_dirty() {
+    dirty = true;
+    last_change_ms = millis();
+    changes++;
+}
+
+void runtime_state_set_page(uint8_t page) {
+    if (page == state.page) return;
+    state.page = page;
+    mark_dirty();
+}
+
+void runtime_state_set_preset(uint8_t preset_index) {
+    if (preset_index == state.preset_index) return;
+    state.preset_index = preset_index;
+    mark_dirty();
+}
+
+void runtime_state_set_mode(uint8_t display_mode) {
+    if (display_mode == state.display_mode) return;
+    state.display_mode = display_mode;
+    mark_dirty();
+}
+
+void runtime_state_set_focus(int8_t focus_index) {
+    if (focus_index == state.focus_index) return;
+    state.focus_index = focus_index;
+    mark_dirty();
+}
+
+void runtime_state_flush() {
+    if (!dirty) return;
+    dirty = false;
+    // Paged back to where it was: nothing to write
+    if (!memcmp(&state, &stored, sizeof(state))) {
+        changes = 0;
+        return;
+    }
+    Preferences prefs;
+    if (!prefs.begin("rtstate", false)) {
+        Serial.println("[state] NVS open failed, runtime state not saved");
+        return;
+    }
+    RuntimeStateBlob blob = { RUNTIME_STATE_MAGIC, RUNTIME_STATE_VERSION, 0, writes + 1, state };
+    bool ok = prefs.putBytes("state", &blob, sizeof(blob)) == sizeof(blob);
+    prefs.end();
+    if (!ok) {
+        Serial.println("[state] NVS write failed, runtime state not saved");
+        return;
+    }
+    stored = state;
+    writes++;
+    Serial.printf("[state] saved runtime state (write %lu, %lu changes coalesced)\n",
+                  (unsigned long)writes, (unsigned long)changes);
+    changes = 0;
+}
+
+uint32_t runtime_state_poll() {
+    if (!dirty) return UINT32_MAX;
+    uint32_t quiet = millis() - last_change_ms;
+    if (quiet < RUNTIME_STATE_FLUSH_MS) return RUNTIME_STATE_FLUSH_MS - quiet;
+    runtime_state_flush();
+    return UINT32_MAX;
+}
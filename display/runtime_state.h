@@ -0,0 +1,45 @@
+#pragma once
+#include <stdint.h>
+
+// ============================================================
+// Runtime UI state kept across reboots (NVS, namespace "rtstate")
+//
+// Current page, brightness preset, display mode and encoder focus change
+// far too often for config_save(). Setters only update RAM and mark the
+// state dirty; runtime_state_poll() writes it as one NVS blob once nothing
+// has changed for RUNTIME_STATE_FLUSH_MS, and runtime_state_flush() writes
+// it right away (dimming, clock mode, reboots). A flush whose contents
+// match what is already stored costs no flash write. The blob carries a
+// write counter, so wear shows up in the log.
+//
+// runtime_state_restore() is one NVS read at boot. UI task only.
+// ============================================================
+
+#ifndef RUNTIME_STATE_FLUSH_MS
+#define RUNTIME_STATE_FLUSH_MS 10000   // Quiet time before a change is written
+#endif
+
+#define RUNTIME_STATE_NONE 0xFF   // preset_index / display_mode never set
+
+struct RuntimeState {
+    uint8_t page;           // Current page of the active profile
+    uint8_t preset_index;   // Brightness preset (power.cpp), NONE = default brightness
+    uint8_t display_mode;   // DisplayMode (power.h), NONE = MODE_HOTKEYS
+    int8_t focus_index;     // Encoder app-select focus, -1 = none
+};
+
+// Load the stored state (defaults if there is none). Call before power_init().
+void runtime_state_restore();
+const RuntimeState &runtime_state_get();
+
+void runtime_state_set_page(uint8_t page);
+void runtime_state_set_preset(uint8_t preset_index);
+void runtime_state_set_mode(uint8_t display_mode);
+void runtime_state_set_focus(int8_t focus_index);
+
+// Write it if it has been quiet long enough. Returns the ms until it must
+// run again (UINT32_MAX if nothing is pending).
+uint32_t runtime_state_poll();
+
+// Write pending changes now
+void runtime_state_flush();
@@ -0,0 +1,250 @@
+/**
+ * @file screenshot.cpp
+ * Streamed PNG / BMP screenshots of the framebuffer (see screenshot.h)
+ *
+ * The PNG deflate stream is a single fixed-Huffman block whose only matches
+ * are runs (distance 1): a filtered UI row is mostly repeated bytes, so that
+ * gets most of what a full LZ77 would, without its 32 KB window and hash
+ * tables. Compressed bytes collect in one IDAT-sized buffer; each full
+ * buffer goes out as a chunk, so the client sees data while rows are still
+ * being read.
+ */
+
+#include "screenshot.h"
+#include "display_hw.h"
+#include "mem_budget.h"
+#include "protocol.h"
+#include "tasks.h"
+#include <string.h>
+
+#define ROW_PIXELS SCREEN_WIDTH
+#define ROW_BYTES  (SCREEN_WIDTH * 3)
+
+struct ShotBuffers {
+    uint16_t band[SCREENSHOT_BAND_ROWS * ROW_PIXELS];   // RGB565 as read
+    uint8_t  rgb[ROW_BYTES];                        // Current row, R G B (BMP: B G R)
+    uint8_t  prev[ROW_BYTES];                       // Previous row, for the Up filter
+    uint8_t  sub[1 + ROW_BYTES];                    // [filter type][filtered row]
+    uint8_t  up[1 + ROW_BYTES];
+    uint8_t  idat[SCREENSHOT_IDAT_BYTES];
+};
+
+// RGB565 -> 8-bit channels, low bits filled from the high ones (0x1F -> 0xFF)
+static void expand_row(const uint16_t *px, uint8_t *out, bool bgr) {
+    for (int x = 0; x < ROW_PIXELS; x++) {
+        uint16_t c = px[x];
+        uint8_t r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+        r = (r << 3) | (r >> 2);
+        g = (g << 2) | (g >> 4);
+        b = (b << 3) | (b >> 2);
+        out[0] = bgr ? b : r;
+        out[1] = g;
+        out[2] = bgr ? r : b;
+        out += 3;
+    }
+}
+
+// Read the framebuffer band by band; fn(row) for each row, top to bottom
+template <typename RowFn>
+static void for_each_row(ShotBuffers &sb, bool bgr, RowFn fn) {
+    for (uint16_t y0 = 0; y0 < SCREEN_HEIGHT; y0 += SCREENSHOT_BAND_ROWS) {
+        uint16_t rows = SCREEN_HEIGHT - y0 < SCREENSHOT_BAND_ROWS ? SCREEN_HEIGHT - y0 : SCREENSHOT_BAND_ROWS;
+        ui_lock();   // Between LVGL passes: no half-rendered band
+        display_read_rows(y0, rows, sb.band);
+        ui_unlock();
+        for (uint16_t r = 0; r < rows; r++) {
+            expand_row(&sb.band[r * ROW_PIXELS], sb.rgb, bgr);
+            fn();
+        }
+    }
+}
+
+// ============================================================
+// BMP
+// ============================================================
+
+#define BMP_HEADER_BYTES 54
+
+size_t screenshot_bmp_size() {
+    return BMP_HEADER_BYTES + (size_t)ROW_BYTES * SCREEN_HEIGHT;   // 2400-byte rows need no padding
+}
+
+static void put_le(uint8_t *p, uint32_t v, int n) {
+    for (int i = 0; i < n; i++) p[i] = v >> (8 * i);
+}
+
+static void write_bmp(ShotBuffers &sb, Print &out) {
+    uint8_t h[BMP_HEADER_BYTES] = { 'B', 'M' };
+    put_le(&h[2], screenshot_bmp_size(), 4);
+    put_le(&h[10], BMP_HEADER_BYTES, 4);                // Pixel data offset
+    put_le(&h[14], 40, 4);                              // BITMAPINFOHEADER
+    put_le(&h[18], SCREEN_WIDTH, 4);
+    put_le(&h[22], (uint32_t)-(int32_t)SCREEN_HEIGHT, 4);   // Negative: top-down
+    put_le(&h[26], 1, 2);                               // Planes
+    put_le(&h[28], 24, 2);                              // Bits per pixel, BI_RGB
+    put_le(&h[34], ROW_BYTES * SCREEN_HEIGHT, 4);
+    put_le(&h[38], 2835, 4);                            // 72 dpi
+    put_le(&h[42], 2835, 4);
+    out.write(h, sizeof(h));
+    for_each_row(sb, true, [&]() { out.write(sb.rgb, ROW_BYTES); });
+}
+
+// ============================================================
+// PNG
+// ============================================================
+
+struct PngWriter {
+    ShotBuffers &sb;
+    Print &out;
+    size_t idat_len = 0;
+    uint32_t bits = 0;        // Deflate bit buffer, LSB first
+    uint8_t nbits = 0;
+    uint32_t adler_a = 1, adler_b = 0;
+
+    PngWriter(ShotBuffers &sb, Print &out) : sb(sb), out(out) {}
+
+    void chunk(const char *type, const uint8_t *data, uint32_t len) {
+        uint8_t head[8];
+        for (int i = 0; i < 4; i++) head[i] = len >> (24 - 8 * i);
+        memcpy(&head[4], type, 4);
+        uint32_t crc = crc32_update(crc32_update(0, &head[4], 4), data, len);
+        uint8_t tail[4];
+        for (int i = 0; i < 4; i++) tail[i] = crc >> (24 - 8 * i);
+        out.write(head, 8);
+        if (len) out.write(data, len);
+        out.write(tail, 4);
+    }
+
+    void byte(uint8_t b) {
+        sb.idat[idat_len++] = b;
+        if (idat_len == sizeof(sb.idat)) {
+            chunk("IDAT", sb.idat, idat_len);
+            idat_len = 0;
+        }
+    }
+
+    void put_bits(uint32_t v, uint8_t n) {
+        bits |= v << nbits;
+        nbits += n;
+        while (nbits >= 8) {
+            byte(bits & 0xFF);
+            bits >>= 8;
+            nbits -= 8;
+        }
+    }
+
+    // Huffman codes go out most significant bit first
+    void put_code(uint32_t code, uint8_t len) {
+        uint32_t rev = 0;
+        for (uint8_t i = 0; i < len; i++) rev |= ((code >> i) & 1) << (len - 1 - i);
+        put_bits(rev, len);
+    }
+
+    // Fixed literal/length alphabet (RFC 1951 3.2.6)
+    void symbol(uint16_t sym) {
+        if (sym < 144) put_code(0x30 + sym, 8);
+        else if (sym < 256) put_code(0x190 + sym - 144, 9);
+        else if (sym < 280) put_code(sym - 256, 7);
+        else put_code(0xC0 + sym - 280, 8);
+    }
+
+    // Repeat the previous byte `len` (3-258) more times
+    void run(uint16_t len) {
+        static const uint16_t BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                           35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        static const uint8_t EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                           3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        int i = 28;
+        while (BASE[i] > len) i--;
+        symbol(257 + i);
+        if (EXTRA[i]) put_bits(len - BASE[i], EXTRA[i]);
+        put_code(0, 5);   // Distance 1
+    }
+
+    void deflate(const uint8_t *data, size_t len) {
+        for (size_t i = 0; i < len;) {
+            uint8_t b = data[i];
+            adler_update(data + i, 1);
+            symbol(b);
+            size_t n = 1;
+            while (i + n < len && data[i + n] == b) n++;
+            adler_update(data + i + 1, n - 1);
+            size_t left = n - 1;
+            while (left >= 3) {
+                uint16_t take = left > 258 ? 258 : left;
+                // Don't leave a tail of 1-2 that could have been part of this run
+                if (left - take && left - take < 3) take = left - 3;
+                run(take);
+                left -= take;
+            }
+            while (left--) symbol(b);
+            i += n;
+        }
+    }
+
+    void adler_update(const uint8_t *p, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            adler_a = (adler_a + p[i]) % 65521;
+            adler_b = (adler_b + adler_a) % 65521;
+        }
+    }
+};
+
+static size_t count_zeros(const uint8_t *p, size_t n) {
+    size_t z = 0;
+    for (size_t i = 0; i < n; i++) z += p[i] == 0;
+    return z;
+}
+
+static void write_png(ShotBuffers &sb, Print &out) {
+    static const uint8_t SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    out.write(SIGNATURE, sizeof(SIGNATURE));
+    uint8_t ihdr[13] = {};
+    ihdr[2] = SCREEN_WIDTH >> 8;
+    ihdr[3] = SCREEN_WIDTH & 0xFF;
+    ihdr[6] = SCREEN_HEIGHT >> 8;
+    ihdr[7] = SCREEN_HEIGHT & 0xFF;
+    ihdr[8] = 8;   // Bit depth
+    ihdr[9] = 2;   // Truecolour RGB
+
+    PngWriter png(sb, out);
+    png.chunk("IHDR", ihdr, sizeof(ihdr));
+
+    png.byte(0x78);   // zlib: deflate, 32 KB window (only distance 1 is used)
+    png.byte(0x01);
+    png.put_bits(1, 1);   // BFINAL
+    png.put_bits(1, 2);   // BTYPE = fixed Huffman
+
+    memset(sb.prev, 0, sizeof(sb.prev));
+    for_each_row(sb, false, [&]() {
+        sb.sub[0] = 1;
+        sb.up[0] = 2;
+        for (int i = 0; i < ROW_BYTES; i++) {
+            sb.sub[1 + i] = sb.rgb[i] - (i >= 3 ? sb.rgb[i - 3] : 0);
+            sb.up[1 + i] = sb.rgb[i] - sb.prev[i];
+        }
+        bool use_up = count_zeros(sb.up + 1, ROW_BYTES) > count_zeros(sb.sub + 1, ROW_BYTES);
+        png.deflate(use_up ? sb.up : sb.sub, 1 + ROW_BYTES);
+        memcpy(sb.prev, sb.rgb, ROW_BYTES);
+    });
+
+    png.symbol(256);   // End of block
+    if (png.nbits) png.put_bits(0, 8 - png.nbits);
+    uint32_t adler = (png.adler_b << 16) | png.adler_a;
+    for (int i = 0; i < 4; i++) png.byte(adler >> (24 - 8 * i));
+    if (png.idat_len) png.chunk("IDAT", sb.idat, png.idat_len);
+    png.chunk("IEND", nullptr, 0);
+}
+
+ShotBuffers *screenshot_alloc() {
+    return (ShotBuffers *)mem_alloc(MEM_POOL_UPLOAD, sizeof(ShotBuffers));
+}
+
+void screenshot_free(ShotBuffers *sb) {
+    mem_free(MEM_POOL_UPLOAD, sb);
+}
+
+void screenshot_write(ShotBuffers *sb, ScreenshotFormat fmt, Print &out) {
+    if (fmt == SCREENSHOT_BMP) write_bmp(*sb, out);
+    else write_png(*sb, out);
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <Print.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================
+// Screenshots of the panel (GET /api/screenshot)
+//
+// The framebuffer is read SCREENSHOT_BAND_ROWS rows at a time under
+// ui_lock() -- so the image is one frame, not a render in progress -- and
+// each band is encoded and written out before the next is read. Nothing
+// frame-sized is ever allocated: one band plus, for PNG, two rows and a
+// compressed chunk, from the upload pool.
+//
+//   PNG  RGB 8-bit; each row Sub- or Up-filtered (whichever leaves more
+//        zeros), then deflated with a run-length-only fixed-Huffman
+//        encoder. Flat UI areas shrink to a few bits per row, so a typical
+//        page is a few tens of KB instead of 1.1 MB over the SoftAP.
+//   BMP  24-bit top-down, uncompressed; its size is known up front.
+// ============================================================
+
+#define SCREENSHOT_BAND_ROWS  8      // Rows read per ui_lock()
+#define SCREENSHOT_IDAT_BYTES 4096   // Compressed bytes per PNG IDAT chunk
+
+enum ScreenshotFormat : uint8_t {
+    SCREENSHOT_PNG = 0,
+    SCREENSHOT_BMP = 1,
+};
+
+struct ShotBuffers;
+
+// Exact byte count of a BMP screenshot (for Content-Length)
+size_t screenshot_bmp_size();
+
+// Band and encoder buffers from the upload pool, nullptr when out of
+// memory -- taken before the response headers go out
+ShotBuffers *screenshot_alloc();
+void screenshot_free(ShotBuffers *sb);
+
+// Encode the current frame into `out`
+void screenshot_write(ShotBuffers *sb, ScreenshotFormat fmt, Print &out);
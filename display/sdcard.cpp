@@ -2,6 +2,7 @@
 #include <Arduino.h>
 #include <SPI.h>
 #include <SD.h>
+#include <string.h>
 
 // CrowPanel 7.0" TF Card slot SPI pins
 #define SD_CS   10
@@ -9,33 +10,164 @@
 #define SD_CLK  12
 #define SD_MISO 13
 
+// The TF slot is wired for SPI only (no DAT1/DAT2), so 4-bit SDMMC is out;
+// SPI is clocked as fast as the card verifies, stepping down on errors.
+#ifndef SD_SPI_MAX_HZ
+#define SD_SPI_MAX_HZ 40000000
+#endif
+static const uint32_t SD_SPI_LADDER_HZ[] = {40000000, 26000000, 20000000, 10000000, 4000000};
+
+#define SD_VERIFY_SECTORS 8
+
+#ifndef SD_BENCH_AT_BOOT
+#define SD_BENCH_AT_BOOT 1
+#endif
+#define SD_BENCH_FILE   "/.sdbench"
+#define SD_BENCH_BYTES  (1024 * 1024)
+#define SD_BENCH_CHUNK  (32 * 1024)
+#define SD_BENCH_RANDOM 64           // 4 KB reads at random offsets
+
 static SPIClass sd_spi(HSPI);
 static bool mounted = false;
+static uint32_t bus_hz = 0;
+
+// Read the first sectors twice and compare: CRC-protected reads fail
+// outright at a clock the wiring can't carry, marginal ones disagree
+static bool verify_reads() {
+    static uint8_t a[512], b[512];
+    for (uint32_t sector = 0; sector < SD_VERIFY_SECTORS; sector++) {
+        if (!SD.readRAW(a, sector) || !SD.readRAW(b, sector)) return false;
+        if (memcmp(a, b, sizeof(a)) != 0) return false;
+    }
+    return true;
+}
 
 bool sdcard_init() {
     sd_spi.begin(SD_CLK, SD_MISO, SD_MOSI, SD_CS);
 
-    if (!SD.begin(SD_CS, sd_spi, 4000000)) {  // 4 MHz SPI clock
+    mounted = false;
+    for (uint32_t hz : SD_SPI_LADDER_HZ) {
+        if (hz > SD_SPI_MAX_HZ) continue;
+        if (!SD.begin(SD_CS, sd_spi, hz)) {
+            SD.end();
+            continue;
+        }
+        if (SD.cardType() == CARD_NONE) {
+            Serial.println("SD: no card detected");
+            SD.end();
+            return false;
+        }
+        if (verify_reads()) {
+            bus_hz = hz;
+            mounted = true;
+            break;
+        }
+        Serial.printf("SD: read check failed at %lu MHz, stepping down\n", (unsigned long)(hz / 1000000));
+        SD.end();
+    }
+    if (!mounted) {
         Serial.println("SD: mount failed");
-        mounted = false;
         return false;
     }
 
     uint8_t cardType = SD.cardType();
-    if (cardType == CARD_NONE) {
-        Serial.println("SD: no card detected");
-        mounted = false;
-        return false;
-    }
-
     const char *typeStr = "UNKNOWN";
     if (cardType == CARD_MMC)       typeStr = "MMC";
     else if (cardType == CARD_SD)   typeStr = "SD";
     else if (cardType == CARD_SDHC) typeStr = "SDHC";
 
     uint64_t cardSize = SD.cardSize() / (1024 * 1024);
-    Serial.printf("SD: %s card, %llu MB\n", typeStr, cardSize);
-    mounted = true;
+    Serial.printf("SD: %s card, %llu MB, SPI %lu MHz\n", typeStr, cardSize, (unsigned long)(bus_hz / 1000000));
+#if SD_BENCH_AT_BOOT
+    sdcard_benchmark();
+#endif
+    return true;
+}
+
+uint32_t sdcard_bus_hz() {
+    return mounted ? bus_hz : 0;
+}
+
+// Scratch file, written whole; us including the close (FAT and cache flush)
+static uint32_t write_scratch(uint8_t *buf) {
+    for (size_t i = 0; i < SD_BENCH_CHUNK; i++) buf[i] = (uint8_t)(i * 31);
+    uint32_t t0 = micros();
+    File f = SD.open(SD_BENCH_FILE, FILE_WRITE);
+    if (!f) return 0;
+    size_t total = 0;
+    for (size_t done = 0; done < SD_BENCH_BYTES; done += SD_BENCH_CHUNK) total += f.write(buf, SD_BENCH_CHUNK);
+    f.close();
+    return total == SD_BENCH_BYTES ? micros() - t0 : 0;
+}
+
+bool sdcard_benchmark(SdBenchResult *out, bool writes) {
+    SdBenchResult r = {};
+    if (out) *out = r;
+    if (!mounted) return false;
+    uint8_t *buf = (uint8_t *)malloc(SD_BENCH_CHUNK);
+    if (!buf) return false;
+    const uint32_t blocks = SD_BENCH_BYTES / 4096;
+
+    // One-time scratch file, so the boot benchmark doesn't write every time
+    uint32_t seq_write_us = 0;
+    File f = SD.open(SD_BENCH_FILE, FILE_READ);
+    if (writes || !f || f.size() < SD_BENCH_BYTES) {
+        if (f) f.close();
+        seq_write_us = write_scratch(buf);
+        f = SD.open(SD_BENCH_FILE, FILE_READ);
+        if (!seq_write_us || !f) {
+            if (f) f.close();
+            free(buf);
+            return false;
+        }
+    }
+
+    uint32_t t0 = micros();
+    size_t total = 0;
+    while (total < SD_BENCH_BYTES) {
+        size_t n = f.read(buf, SD_BENCH_CHUNK);
+        if (n == 0) break;
+        total += n;
+    }
+    uint32_t seq_us = micros() - t0;
+
+    t0 = micros();
+    size_t rnd_total = 0;
+    for (int i = 0; i < SD_BENCH_RANDOM; i++) {
+        f.seek((esp_random() % blocks) * 4096);
+        rnd_total += f.read(buf, 4096);
+    }
+    uint32_t rnd_us = micros() - t0;
+    f.close();
+
+    // bytes/us == MB/s
+    r.seq_read_mbs = seq_us ? (float)total / seq_us : 0.0f;
+    r.rnd_read_mbs = rnd_us ? (float)rnd_total / rnd_us : 0.0f;
+    r.rnd_read_ms = rnd_us / 1000.0f / SD_BENCH_RANDOM;
+    Serial.printf("SD: bench seq %.2f MB/s (%u KB), random 4K %.2f MB/s (%.2f ms/read)\n",
+                  r.seq_read_mbs, (unsigned)(total / 1024), r.rnd_read_mbs, r.rnd_read_ms);
+
+    if (writes) {
+        r.seq_write_mbs = (float)SD_BENCH_BYTES / seq_write_us;
+        // In place: each block costs a read-modify-write of its cluster
+        f = SD.open(SD_BENCH_FILE, "r+");
+        size_t rnd_written = 0;
+        if (f) {
+            t0 = micros();
+            for (int i = 0; i < SD_BENCH_RANDOM; i++) {
+                f.seek((esp_random() % blocks) * 4096);
+                rnd_written += f.write(buf, 4096);
+            }
+            f.close();
+            rnd_us = micros() - t0;
+            r.rnd_write_mbs = rnd_us ? (float)rnd_written / rnd_us : 0.0f;
+            r.rnd_write_ms = rnd_us / 1000.0f / SD_BENCH_RANDOM;
+        }
+        Serial.printf("SD: bench write seq %.2f MB/s, random 4K %.2f MB/s (%.2f ms/write)\n",
+                      r.seq_write_mbs, r.rnd_write_mbs, r.rnd_write_ms);
+    }
+    free(buf);
+    if (out) *out = r;
     return true;
 }
 
@@ -83,6 +215,49 @@ bool sdcard_write_file(const char *path, const uint8_t *data, size_t len) {
     return true;
 }
 
+bool sdcard_append_file(const char *path, const uint8_t *data, size_t len) {
+    if (!mounted) return false;
+
+    File f = SD.open(path, FILE_APPEND);
+    if (!f) {
+        Serial.printf("SD: append open failed: %s\n", path);
+        return false;
+    }
+
+    size_t written = f.write(data, len);
+    f.close();
+
+    if (written != len) {
+        Serial.printf("SD: append incomplete: %zu/%zu\n", written, len);
+        return false;
+    }
+    return true;
+}
+
+bool sdcard_copy_file(const char *src_path, const char *dst_path) {
+    if (!mounted) return false;
+
+    File src = SD.open(src_path, FILE_READ);
+    if (!src) return false;
+    File dst = SD.open(dst_path, FILE_WRITE);
+    if (!dst) {
+        src.close();
+        Serial.printf("SD: copy open failed: %s\n", dst_path);
+        return false;
+    }
+
+    uint8_t buf[1024];
+    bool ok = true;
+    int n;
+    while (ok && (n = src.read(buf, sizeof(buf))) > 0) {
+        ok = dst.write(buf, n) == (size_t)n;
+    }
+    src.close();
+    dst.close();
+    if (!ok) Serial.printf("SD: copy incomplete: %s -> %s\n", src_path, dst_path);
+    return ok;
+}
+
 bool sdcard_file_exists(const char *path) {
     if (!mounted) return false;
     return SD.exists(path);
@@ -146,6 +321,14 @@ int sdcard_list_dir(const char* path, sdcard_dir_callback_t cb, void* user_data)
     return count;
 }
 
+bool sdcard_is_dir(const char* path) {
+    if (!mounted) return false;
+    File dir = SD.open(path);
+    bool ok = dir && dir.isDirectory();
+    dir.close();
+    return ok;
+}
+
 bool sdcard_get_usage(uint64_t* total_bytes, uint64_t* used_bytes) {
     if (!mounted) return false;
     *total_bytes = SD.totalBytes();
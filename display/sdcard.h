@@ -9,6 +9,24 @@ bool sdcard_init();
 // Check if SD card is mounted and accessible.
 bool sdcard_mounted();
 
+// SPI clock the card was verified at (0 when not mounted).
+uint32_t sdcard_bus_hz();
+
+// Sequential + random read throughput to Serial (runs at boot unless
+// SD_BENCH_AT_BOOT=0). Uses a 1 MB scratch file written on first run.
+// With `writes` (POST /api/bench) the scratch file is rewritten and timed,
+// then 4 KB blocks of it are overwritten at random offsets. Fills `out`
+// when given; false if the card or the scratch file isn't usable.
+struct SdBenchResult {
+    float seq_read_mbs;        // MB/s
+    float rnd_read_mbs;        // 4 KB reads at random offsets
+    float rnd_read_ms;         // ... per read
+    float seq_write_mbs;       // Only with writes, else 0
+    float rnd_write_mbs;
+    float rnd_write_ms;
+};
+bool sdcard_benchmark(SdBenchResult *out = nullptr, bool writes = false);
+
 // Get card size in MB.
 uint32_t sdcard_size_mb();
 
@@ -19,6 +37,12 @@ int sdcard_read_file(const char *path, uint8_t *buf, size_t max_len);
 // Write buffer to file (creates or overwrites). Returns true on success.
 bool sdcard_write_file(const char *path, const uint8_t *data, size_t len);
 
+// Append buffer to file (creates it if missing). Returns true on success.
+bool sdcard_append_file(const char *path, const uint8_t *data, size_t len);
+
+// Copy a file of any size through a small stack buffer. Returns true on success.
+bool sdcard_copy_file(const char *src_path, const char *dst_path);
+
 // Check if a file exists.
 bool sdcard_file_exists(const char *path);
 
@@ -37,5 +61,8 @@ bool sdcard_mkdir(const char *path);
 typedef void (*sdcard_dir_callback_t)(const char* name, size_t size, bool is_dir, void* user_data);
 int sdcard_list_dir(const char* path, sdcard_dir_callback_t cb, void* user_data);
 
+// True if path names a directory (lets a caller fail before streaming a listing)
+bool sdcard_is_dir(const char* path);
+
 // Get SD card usage stats. Returns total and used in bytes.
 bool sdcard_get_usage(uint64_t* total_bytes, uint64_t* used_bytes);
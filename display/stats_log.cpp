@@ -0,0 +1,350 @@
+/**
+ * @file stats_log.cpp
+ * Block-structured stats history on the SD card (see stats_log.h)
+ *
+ * One mutex covers the block in RAM and every file operation, so a reader
+ * on the net task sees either the old or the new copy of a block and never
+ * a file mid-rotation. Readers take it per block, not per read: a 24 h
+ * window is a hundred-odd blocks, and a flush on the UI task only ever
+ * waits for one.
+ */
+
+#include "stats_log.h"
+#include "mem_budget.h"
+#include "protocol.h"
+#include "sdcard.h"
+#include <Arduino.h>
+#include <SD.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <esp_heap_caps.h>
+#include <string.h>
+
+#define STATS_LOG_MAGIC 0x31474C53   // "SLG1"
+
+struct __attribute__((packed)) BlockHeader {
+    uint32_t magic;
+    uint32_t seq;         // One more than the block before it, across both files
+    uint32_t t0, t1;      // First / last frame, Unix seconds
+    uint32_t crc;         // CRC-32 of the `used` payload bytes
+    uint16_t used;
+    uint16_t frames;
+    uint8_t host;
+    uint8_t reserved[3];
+};
+
+#define PAYLOAD_BYTES (STATS_LOG_BLOCK_BYTES - sizeof(BlockHeader))
+#define FRAME_MAX_BYTES(n) (5 + 1 + (size_t)(n) * 6)   // Varint time, count, type + varint each
+
+static uint8_t *block = nullptr;       // Block being filled (PSRAM)
+static uint32_t block_off = 0;         // Its offset in STATS_LOG_PATH
+static uint32_t next_seq = 1;
+static int32_t prev_value[STAT_TYPE_MAX + 1];   // Delta base per type, this block
+static bool dirty = false;             // Frames not on the card yet
+static uint32_t dirty_since = 0;
+static bool ready = false;
+static SemaphoreHandle_t log_mutex = nullptr;
+static StatsLogStats counters;
+
+static inline BlockHeader &hdr() {
+    return *(BlockHeader *)block;
+}
+
+static void lock() { xSemaphoreTake(log_mutex, portMAX_DELAY); }
+static void unlock() { xSemaphoreGive(log_mutex); }
+
+// ============================================================
+// Encoding
+// ============================================================
+
+static size_t put_varint(uint8_t *p, uint32_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+// False past `end` or on a varint longer than 5 bytes
+static bool get_varint(const uint8_t *&p, const uint8_t *end, uint32_t &v) {
+    v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (p >= end) return false;
+        uint8_t b = *p++;
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+static inline uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static bool block_valid(const uint8_t *blk) {
+    const BlockHeader &h = *(const BlockHeader *)blk;
+    return h.magic == STATS_LOG_MAGIC && h.used <= PAYLOAD_BYTES &&
+           crc32_update(0, blk + sizeof(BlockHeader), h.used) == h.crc;
+}
+
+// fn() for every entry of a valid block. Returns false on a corrupt payload
+// (entries up to there were delivered).
+static bool decode_block(const uint8_t *blk, StatsLogVisitor fn, void *user) {
+    const BlockHeader &h = *(const BlockHeader *)blk;
+    const uint8_t *p = blk + sizeof(BlockHeader);
+    const uint8_t *end = p + h.used;
+    int32_t value[STAT_TYPE_MAX + 1] = {};
+    uint32_t t = h.t0;
+    for (uint16_t f = 0; f < h.frames; f++) {
+        uint32_t dt;
+        if (!get_varint(p, end, dt) || p >= end) return false;
+        t += dt;
+        uint8_t n = *p++;
+        for (uint8_t i = 0; i < n; i++) {
+            uint32_t dv;
+            if (p >= end) return false;
+            uint8_t type = *p++;
+            if (type > STAT_TYPE_MAX || !get_varint(p, end, dv)) return false;
+            value[type] += unzigzag(dv);
+            fn(t, type, value[type], user);
+        }
+    }
+    return true;
+}
+
+// ============================================================
+// Card
+// ============================================================
+
+static void reset_block() {
+    memset(block, 0, STATS_LOG_BLOCK_BYTES);
+    memset(prev_value, 0, sizeof(prev_value));
+}
+
+static bool read_block(const char *path, uint32_t index, uint8_t *buf, size_t bytes) {
+    File f = SD.open(path, FILE_READ);
+    if (!f) return false;
+    bool ok = f.seek(index * STATS_LOG_BLOCK_BYTES) && f.read(buf, bytes) == bytes;
+    f.close();
+    return ok;
+}
+
+static uint32_t block_count(const char *path) {
+    File f = SD.open(path, FILE_READ);
+    if (!f) return 0;
+    uint32_t n = f.size() / STATS_LOG_BLOCK_BYTES;   // A torn tail is overwritten by the next block
+    f.close();
+    return n;
+}
+
+static void rotate() {
+    sdcard_file_rename(STATS_LOG_PATH, STATS_LOG_OLD_PATH);
+    block_off = 0;
+    Serial.println("[stats] Log rotated");
+}
+
+// The block in RAM to its place in the file (partial or full)
+static bool write_block() {
+    if (block_off >= STATS_LOG_FILE_BYTES) rotate();
+    BlockHeader &h = hdr();
+    h.crc = crc32_update(0, block + sizeof(BlockHeader), h.used);
+    File f = SD.open(STATS_LOG_PATH, SD.exists(STATS_LOG_PATH) ? "r+" : FILE_WRITE);
+    bool ok = f && f.seek(block_off) && f.write(block, STATS_LOG_BLOCK_BYTES) == STATS_LOG_BLOCK_BYTES;
+    if (f) f.close();
+    if (!ok) {
+        counters.write_failed++;
+        Serial.printf("[stats] Block %lu write failed\n", (unsigned long)h.seq);
+    }
+    dirty = false;   // A failed write is not retried: the next one carries it
+    return ok;
+}
+
+// Write a full block and start the next one
+static void close_block() {
+    if (hdr().frames) {
+        write_block();
+        counters.blocks_written++;
+        block_off += STATS_LOG_BLOCK_BYTES;
+    }
+    reset_block();
+}
+
+static void restore_prev(uint32_t, uint8_t type, int32_t value, void *) {
+    prev_value[type] = value;
+}
+
+bool stats_log_begin() {
+    if (ready) return true;
+    if (!STATS_LOG_ENABLE || !sdcard_mounted() || !sdcard_mkdir(STATS_LOG_DIR)) return false;
+    if (!log_mutex) log_mutex = xSemaphoreCreateMutex();
+    if (!block) {
+        block = (uint8_t *)heap_caps_malloc(STATS_LOG_BLOCK_BYTES, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!block) block = (uint8_t *)malloc(STATS_LOG_BLOCK_BYTES);
+        if (!block) return false;
+    }
+    reset_block();
+
+    // Sequence from the newest block on the card; keep filling it if there's room
+    uint32_t n = block_count(STATS_LOG_PATH);
+    block_off = n * STATS_LOG_BLOCK_BYTES;
+    if (n && read_block(STATS_LOG_PATH, n - 1, block, STATS_LOG_BLOCK_BYTES) && block_valid(block)) {
+        next_seq = hdr().seq + 1;
+        if (hdr().frames && hdr().used + FRAME_MAX_BYTES(STAT_TYPE_MAX) <= PAYLOAD_BYTES &&
+            decode_block(block, restore_prev, nullptr)) {
+            block_off -= STATS_LOG_BLOCK_BYTES;
+        } else {
+            reset_block();
+        }
+    } else {
+        reset_block();
+        uint32_t old = block_count(STATS_LOG_OLD_PATH);
+        BlockHeader h;
+        if (old && read_block(STATS_LOG_OLD_PATH, old - 1, (uint8_t *)&h, sizeof(h)) && h.magic == STATS_LOG_MAGIC) {
+            next_seq = h.seq + 1;
+        }
+    }
+    ready = true;
+    Serial.printf("[stats] Log %s: %lu block(s), next #%lu%s\n", STATS_LOG_PATH, (unsigned long)n,
+                  (unsigned long)next_seq, hdr().frames ? " (continuing the last)" : "");
+    return true;
+}
+
+void stats_log_record(uint32_t epoch, uint8_t host, const StatsLogEntry *entries, uint8_t count) {
+    if (!ready || !count) return;
+    lock();
+    BlockHeader &h = hdr();
+    // New block for another host, a clock stepped back, or no room
+    if (h.frames && (host != h.host || epoch < h.t1 || h.used + FRAME_MAX_BYTES(count) > PAYLOAD_BYTES)) {
+        close_block();
+    }
+    if (!h.frames) {
+        h.magic = STATS_LOG_MAGIC;
+        h.seq = next_seq++;
+        h.t0 = h.t1 = epoch;
+        h.host = host;
+    }
+    uint8_t *p = block + sizeof(BlockHeader) + h.used;
+    uint8_t *start = p;
+    p += put_varint(p, epoch - h.t1);
+    uint8_t *count_at = p++;
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t type = entries[i].type;
+        if (type > STAT_TYPE_MAX) continue;
+        *p++ = type;
+        p += put_varint(p, zigzag(entries[i].value - prev_value[type]));
+        prev_value[type] = entries[i].value;
+        n++;
+    }
+    *count_at = n;
+    h.used += p - start;
+    h.frames++;
+    h.t1 = epoch;
+    if (!dirty) dirty_since = millis();
+    dirty = true;
+    counters.frames++;
+    counters.last_epoch = epoch;
+    unlock();
+}
+
+uint32_t stats_log_poll() {
+    if (!ready || !dirty) return UINT32_MAX;
+    uint32_t waited = millis() - dirty_since;
+    if (waited < STATS_LOG_FLUSH_MS) return STATS_LOG_FLUSH_MS - waited;
+    stats_log_flush();
+    return UINT32_MAX;
+}
+
+void stats_log_flush() {
+    if (!ready || !dirty) return;
+    lock();
+    if (write_block()) counters.flushes++;
+    unlock();
+}
+
+// ============================================================
+// Reading
+// ============================================================
+
+struct ReadFilter {
+    uint32_t from, to;
+    StatsLogVisitor fn;
+    void *user;
+};
+
+static void filter_visit(uint32_t epoch, uint8_t type, int32_t value, void *user) {
+    ReadFilter *rf = (ReadFilter *)user;
+    if (epoch >= rf->from && epoch <= rf->to) rf->fn(epoch, type, value, rf->user);
+}
+
+static bool read_locked(const char *path, uint32_t index, uint8_t *buf, size_t bytes) {
+    lock();
+    bool ok = read_block(path, index, buf, bytes);
+    unlock();
+    return ok;
+}
+
+// Blocks of one file overlapping [from, to]; `skip_seq` is the block in
+// RAM, whose copy on the card may be behind
+static void read_file(const char *path, uint8_t host, uint32_t skip_seq, ReadFilter &rf, uint8_t *buf) {
+    lock();
+    uint32_t n = block_count(path);
+    unlock();
+
+    // First block whose last frame is in the window (unreadable ones sort early)
+    uint32_t lo = 0, hi = n;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        BlockHeader h;
+        bool ok = read_locked(path, mid, (uint8_t *)&h, sizeof(h)) && h.magic == STATS_LOG_MAGIC;
+        if (!ok || h.t1 < rf.from) lo = mid + 1;
+        else hi = mid;
+    }
+    for (uint32_t i = lo; i < n; i++) {
+        if (!read_locked(path, i, buf, STATS_LOG_BLOCK_BYTES) || !block_valid(buf)) continue;
+        const BlockHeader &h = *(const BlockHeader *)buf;
+        if (h.t0 > rf.to) break;
+        if (h.host == host && h.seq != skip_seq) decode_block(buf, filter_visit, &rf);
+    }
+}
+
+bool stats_log_read(uint8_t host, uint32_t from, uint32_t to, StatsLogVisitor fn, void *user) {
+    if (!ready || from > to) return false;
+    uint8_t *buf = (uint8_t *)mem_alloc(MEM_POOL_UPLOAD, STATS_LOG_BLOCK_BYTES);
+    if (!buf) return false;
+    ReadFilter rf = { from, to, fn, user };
+
+    lock();
+    uint32_t ram_seq = hdr().frames ? hdr().seq : 0;
+    unlock();
+    read_file(STATS_LOG_OLD_PATH, host, ram_seq, rf, buf);
+    read_file(STATS_LOG_PATH, host, ram_seq, rf, buf);
+
+    // Then the block in RAM, as of now
+    lock();
+    bool ram = hdr().frames && hdr().seq == ram_seq;
+    if (ram) memcpy(buf, block, STATS_LOG_BLOCK_BYTES);
+    unlock();
+    const BlockHeader &h = *(const BlockHeader *)buf;
+    if (ram && h.host == host && h.t1 >= from && h.t0 <= to) decode_block(buf, filter_visit, &rf);
+    mem_free(MEM_POOL_UPLOAD, buf);
+    return true;
+}
+
+void stats_log_get_stats(StatsLogStats &out) {
+    if (!ready) {
+        out = StatsLogStats();
+        return;
+    }
+    lock();
+    out = counters;
+    out.ready = ready;
+    out.file_bytes = block_off + (hdr().frames ? STATS_LOG_BLOCK_BYTES : 0);
+    unlock();
+}
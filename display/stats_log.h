@@ -0,0 +1,87 @@
+#pragma once
+#include <stdint.h>
+
+// ============================================================
+// Stats history on SD (/stats/history.log)
+//
+// The UI records one frame per STATS_LOG_INTERVAL_S: every stat of the
+// active host that is still fresh, as (type, value) pairs. Frames go into
+// fixed STATS_LOG_BLOCK_BYTES blocks:
+//
+//   header   magic, sequence number, first/last frame time (Unix seconds),
+//            host slot, payload bytes, frame count, CRC-32 of the payload
+//   frame    varint seconds since the previous frame, entry count, then per
+//            entry the StatType and the zigzag varint change since that
+//            type's previous value in the block (the first is absolute)
+//
+// A slowly moving stat costs about 2 bytes per frame: a block holds a
+// quarter of an hour of 20 stats, a day of them is ~350 KB. Every block
+// decodes on its own, and blocks are in time order at fixed offsets: a
+// read binary-searches the headers and only touches the blocks in its
+// window.
+//
+// The block being filled stays in RAM. It goes to the card as one
+// block-sized write when it is full, and at most STATS_LOG_FLUSH_MS after
+// its first unwritten frame (rewritten in place; a torn write fails the
+// CRC and is skipped). Past STATS_LOG_FILE_BYTES the log becomes
+// history.old and a new one starts, so the card holds between one and two
+// files' worth.
+//
+// Records are only taken while the wall clock is set (MSG_TIME_SYNC).
+// stats_log_record()/poll()/flush() run on the UI task; stats_log_read()
+// from any task (the block I/O is under the log's own mutex).
+// ============================================================
+
+#ifndef STATS_LOG_ENABLE
+#define STATS_LOG_ENABLE 1
+#endif
+#ifndef STATS_LOG_INTERVAL_S
+#define STATS_LOG_INTERVAL_S 10                   // One frame per this many seconds
+#endif
+#ifndef STATS_LOG_FLUSH_MS
+#define STATS_LOG_FLUSH_MS (5 * 60 * 1000)        // Longest a frame waits in RAM
+#endif
+#ifndef STATS_LOG_FILE_BYTES
+#define STATS_LOG_FILE_BYTES (2 * 1024 * 1024)    // Rotate to history.old past this
+#endif
+#define STATS_LOG_BLOCK_BYTES 4096
+#define STATS_LOG_DIR      "/stats"
+#define STATS_LOG_PATH     "/stats/history.log"
+#define STATS_LOG_OLD_PATH "/stats/history.old"
+
+struct StatsLogEntry {
+    uint8_t type;    // StatType
+    int32_t value;   // As received (tenths for the tenths types)
+};
+
+struct StatsLogStats {
+    bool ready;               // Card mounted, log open
+    uint32_t frames;          // Recorded since boot
+    uint32_t blocks_written;  // Full blocks
+    uint32_t flushes;         // Partial block writes
+    uint32_t write_failed;
+    uint32_t file_bytes;      // Current file, including the block in RAM
+    uint32_t last_epoch;      // Time of the newest frame
+};
+
+// Open the log (after the SD card is mounted) and continue its last block.
+// False when there is no card or no memory for the block.
+bool stats_log_begin();
+
+// Append one frame of `count` entries at `epoch` for host slot `host`
+void stats_log_record(uint32_t epoch, uint8_t host, const StatsLogEntry *entries, uint8_t count);
+
+// Write the block in RAM once it has waited STATS_LOG_FLUSH_MS. Returns ms
+// until that is due (UINT32_MAX when nothing is unwritten).
+uint32_t stats_log_poll();
+
+// Write it now (leaving POWER_ACTIVE, before a reboot)
+void stats_log_flush();
+
+// fn(epoch, type, value) for every logged value of `host` with
+// from <= epoch <= to, oldest first, including frames not written yet.
+// False when the log isn't open or no read buffer was free.
+typedef void (*StatsLogVisitor)(uint32_t epoch, uint8_t type, int32_t value, void *user);
+bool stats_log_read(uint8_t host, uint32_t from, uint32_t to, StatsLogVisitor fn, void *user);
+
+void stats_log_get_stats(StatsLogStats &out);
@@ -0,0 +1,122 @@
+/**
+ * @file status_store.cpp
+ * Device status store with dirty tracking
+ *
+ * The clock is read on minute boundaries (wall clock, not a free-running
+ * millis() period), so page clocks flip with the real minute instead of up
+ * to 30 s late, and nothing is redrawn in between.
+ */
+
+#include "status_store.h"
+#include <Arduino.h>
+#include <sys/time.h>
+#include <time.h>
+
+#define STATUS_MAX_LISTENERS 4
+#define CLOCK_BOUNDARY_SLACK_MS 20   // Wake just past the boundary so the read lands in the new minute
+
+struct Listener {
+    uint8_t mask;
+    StatusListener fn;
+};
+
+static Listener listeners[STATUS_MAX_LISTENERS];
+static int listener_count = 0;
+
+static StatusState state = { RSSI_NONE, false, false, 0, 0xFF, 0, 0, false, 0 };
+static uint8_t dirty = STATUS_ALL;   // First flush paints everything
+
+static bool clock_due_valid = false;
+static uint32_t clock_due_ms = 0;
+
+void status_subscribe(uint8_t mask, StatusListener fn) {
+    if (!fn || listener_count >= STATUS_MAX_LISTENERS) return;
+    listeners[listener_count++] = { mask, fn };
+}
+
+const StatusState &status_get() {
+    return state;
+}
+
+static uint8_t rssi_bucket(int rssi_dbm) {
+    if (rssi_dbm == 0) return RSSI_NONE;
+    if (rssi_dbm > -50) return RSSI_GOOD;
+    if (rssi_dbm > -70) return RSSI_FAIR;
+    return RSSI_WEAK;
+}
+
+void status_set_link(int rssi_dbm, bool linked) {
+    uint8_t bucket = rssi_bucket(rssi_dbm);
+    if (bucket != state.rssi_bucket) {
+        state.rssi_bucket = bucket;
+        dirty |= STATUS_RSSI;
+    }
+    if (linked != state.linked) {
+        state.linked = linked;
+        dirty |= STATUS_LINK;
+    }
+}
+
+void status_set_pc_active(bool active) {
+    if (active == state.pc_active) return;
+    state.pc_active = active;
+    dirty |= STATUS_PC;
+}
+
+void status_set_brightness(uint8_t level) {
+    if (level == state.brightness) return;
+    state.brightness = level;
+    dirty |= STATUS_BRIGHTNESS;
+}
+
+void status_set_battery(uint8_t percent, uint16_t runtime_min, uint8_t policy) {
+    // The label shows whole hours above an hour: don't repaint for every minute
+    if (runtime_min >= 60) runtime_min -= runtime_min % 60;
+    if (percent == state.battery_pct && runtime_min == state.runtime_min &&
+        policy == state.battery_policy) return;
+    state.battery_pct = percent;
+    state.runtime_min = runtime_min;
+    state.battery_policy = policy;
+    dirty |= STATUS_BATTERY;
+}
+
+static void read_clock() {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    time_t now = tv.tv_sec;
+    struct tm tm_info;
+    localtime_r(&now, &tm_info);
+
+    bool synced = now > 1000000000;   // Post-2001: set by MSG_TIME_SYNC
+    uint16_t minute = (uint16_t)(tm_info.tm_hour * 60 + tm_info.tm_min);
+    if (minute != state.minute || synced != state.time_synced) {
+        state.minute = minute;
+        state.time_synced = synced;
+        dirty |= STATUS_MINUTE;
+    }
+
+    uint32_t into_minute_ms = (uint32_t)tm_info.tm_sec * 1000 + tv.tv_usec / 1000;
+    uint32_t to_boundary = into_minute_ms < 60000 ? 60000 - into_minute_ms : 1000;   // Leap second
+    clock_due_ms = millis() + to_boundary + CLOCK_BOUNDARY_SLACK_MS;
+    clock_due_valid = true;
+}
+
+uint32_t status_clock_update() {
+    if (!clock_due_valid || (int32_t)(millis() - clock_due_ms) >= 0) read_clock();
+    int32_t remaining = (int32_t)(clock_due_ms - millis());
+    return remaining > 0 ? (uint32_t)remaining : 0;
+}
+
+void status_clock_resync() {
+    clock_due_valid = false;
+    status_clock_update();
+}
+
+void status_flush() {
+    if (!dirty) return;
+    uint8_t changed = dirty;
+    dirty = 0;
+    for (int i = 0; i < listener_count; i++) {
+        if (listeners[i].mask & changed) listeners[i].fn(state, changed & listeners[i].mask);
+    }
+}
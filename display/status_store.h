@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+
+// ============================================================
+// Device status store (status bars, clocks, clock screen)
+//
+// Holds the values the status widgets render, quantized to what they can
+// actually show (RSSI as a colour bucket, time as minute of day). Setters
+// only mark a field dirty when its quantized value changes; status_flush()
+// then hands the changed mask to each subscriber once, so unchanged labels
+// and icons are never rewritten or invalidated. UI task only.
+// ============================================================
+
+enum StatusField : uint8_t {
+    STATUS_RSSI       = 1 << 0,
+    STATUS_LINK       = 1 << 1,
+    STATUS_PC         = 1 << 2,   // Host stats streaming
+    STATUS_BRIGHTNESS = 1 << 3,
+    STATUS_BATTERY    = 1 << 4,
+    STATUS_MINUTE     = 1 << 5,   // Wall-clock minute (also ticks before the first time sync)
+    STATUS_ALL        = 0x3F
+};
+
+// RSSI colour buckets
+enum RssiBucket : uint8_t {
+    RSSI_NONE = 0,   // No packet yet
+    RSSI_WEAK,       // <= -70 dBm
+    RSSI_FAIR,       // -70 .. -50 dBm
+    RSSI_GOOD        // > -50 dBm
+};
+
+struct StatusState {
+    uint8_t rssi_bucket;    // RssiBucket
+    bool linked;            // Bridge heard from recently
+    bool pc_active;         // Stats arriving from the companion
+    uint8_t brightness;     // Backlight level
+    uint8_t battery_pct;    // 0-100, 0xFF = no fuel gauge
+    uint16_t runtime_min;   // Estimated minutes left on battery, 0 = charging / unknown
+    uint8_t battery_policy; // BatteryPolicy (power.h)
+    bool time_synced;       // Wall clock set by MSG_TIME_SYNC
+    uint16_t minute;        // Minute of day, local time
+};
+
+typedef void (*StatusListener)(const StatusState &state, uint8_t changed);
+
+// Call `fn` from status_flush() whenever a field in `mask` changed
+void status_subscribe(uint8_t mask, StatusListener fn);
+
+const StatusState &status_get();
+
+void status_set_link(int rssi_dbm, bool linked);
+void status_set_pc_active(bool active);
+void status_set_brightness(uint8_t level);
+void status_set_battery(uint8_t percent, uint16_t runtime_min, uint8_t policy);
+
+// Re-read the wall clock once the current minute is over. Returns ms until
+// the next minute boundary, for the loop's sleep deadline.
+uint32_t status_clock_update();
+
+// Re-read the wall clock now (time sync, timezone change)
+void status_clock_resync();
+
+// Deliver the pending changes to the subscribers
+void status_flush();
@@ -0,0 +1,171 @@
+/**
+ * @file tasks.cpp
+ * Input / network tasks, UI lock and the ui_post() queue
+ *
+ * The input task owns the I2C polling schedule that used to live in loop():
+ * touch on INT (or a poll timer), fast polling while a finger is down, and
+ * the PCF8575 fast/idle poll periods. I2C transactions with their mutex
+ * waits no longer delay LVGL, and a long render no longer delays sampling.
+ */
+
+#include "tasks.h"
+#include "events.h"
+#include "touch.h"
+#include "hw_input.h"
+#include "i2c_bus.h"
+#include "config_server.h"
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#define INPUT_TASK_STACK  4096
+#define NET_TASK_STACK    8192   // Live edit saves the config (config_save) here
+#define UI_POST_QUEUE_LEN 16
+
+// Input polling
+static const uint32_t TOUCH_POLL_MS         = 25;   // Touch poll period without INT (one status read when idle)
+static const uint32_t TOUCH_HELD_POLL_MS    = 20;   // Track drags/release while pressed (INT mode)
+static const uint32_t TOUCH_TRACK_POLL_MS   = 8;    // Finger down on a trackpad widget (any mode, 125 Hz)
+static const uint32_t HW_INPUT_POLL_MS      = 50;   // Button/encoder poll period
+static const uint32_t HW_INPUT_FAST_POLL_MS = 5;    // While buttons/encoder are moving
+static const uint32_t HW_INPUT_IDLE_POLL_MS = 250;  // INT mode: slow poll for hold detection
+static const uint32_t HW_INPUT_SETTLE_MS    = 1000; // Fast poll after activity for debounce/coalescing
+static const uint32_t TOUCH_LOW_POWER_POLL_MS    = 100;  // Polled touch while dimmed / in clock mode
+static const uint32_t HW_INPUT_LOW_POWER_POLL_MS = 250;  // Polled buttons while dimmed / in clock mode
+
+struct UiCall {
+    UiCallFn fn;
+    uint32_t arg;
+};
+
+static SemaphoreHandle_t ui_mutex = nullptr;
+static QueueHandle_t ui_queue = nullptr;
+static TaskHandle_t input_task = nullptr;
+static TaskHandle_t net_task = nullptr;
+static bool touch_int_enabled = false;
+static bool hw_input_int_enabled = false;
+static volatile bool input_low_power = false;   // Set by the UI task (power profiles)
+
+// Milliseconds until `period` has elapsed since `last` (0 if already due)
+static uint32_t ms_until(uint32_t last, uint32_t period) {
+    uint32_t elapsed = millis() - last;
+    return elapsed >= period ? 0 : period - elapsed;
+}
+
+// ============================================================
+// Input task
+// ============================================================
+static void input_task_fn(void *) {
+    events_claim(EVT_TOUCH_INT | EVT_HW_INPUT);
+    uint32_t touch_timer = 0;
+    uint32_t hw_timer = 0;
+    uint32_t hw_event_time = 0;
+
+    for (;;) {
+        // Button/encoder poll period: fast while input is active so no
+        // quadrature edge is missed, then back to the idle rate
+        uint32_t hw_period = millis() - hw_event_time <= HW_INPUT_SETTLE_MS ? HW_INPUT_FAST_POLL_MS
+                           : hw_input_int_enabled ? HW_INPUT_IDLE_POLL_MS
+                           : input_low_power ? HW_INPUT_LOW_POWER_POLL_MS : HW_INPUT_POLL_MS;
+        uint32_t touch_period = input_low_power ? TOUCH_LOW_POWER_POLL_MS : TOUCH_POLL_MS;
+        uint32_t held_period = TOUCH_HELD_POLL_MS;
+        if (touch_tracking() && touch_is_down()) touch_period = held_period = TOUCH_TRACK_POLL_MS;
+
+        uint32_t wait_ms = ms_until(hw_timer, hw_period);
+        if (!touch_int_enabled) {
+            wait_ms = min(wait_ms, ms_until(touch_timer, touch_period));
+        } else if (touch_is_down()) {
+            wait_ms = min(wait_ms, ms_until(touch_timer, held_period));
+        }
+        uint32_t events = events_wait(wait_ms);
+
+        // Touch: on INT, while pressed (INT mode), or on the poll timer
+        bool touch_due;
+        if (touch_int_enabled) {
+            touch_due = (events & EVT_TOUCH_INT) ||
+                        (touch_is_down() && millis() - touch_timer >= held_period);
+        } else {
+            // EVT_TOUCH_INT without the GPIO: a replayed point (touch_inject)
+            touch_due = (events & EVT_TOUCH_INT) || millis() - touch_timer >= touch_period;
+        }
+        if (touch_due) {
+            touch_timer = millis();
+            // loop() feeds LVGL, picks up gestures and counts this as activity
+            if (touch_poll() || touch_is_down()) events_post(EVT_TOUCH_DATA);
+        }
+
+        // Hardware input: on PCF8575 INT, else on the poll timer
+        if (events & EVT_HW_INPUT) hw_event_time = millis();
+        if ((events & EVT_HW_INPUT) || millis() - hw_timer >= hw_period) {
+            hw_timer = millis();
+            if (hw_input_sample()) hw_event_time = millis();
+        }
+    }
+}
+
+// ============================================================
+// Network task
+// ============================================================
+static void net_task_fn(void *) {
+    for (;;) {
+        uint32_t wait_ms = config_server_service();
+        ulTaskNotifyTake(pdTRUE, wait_ms == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(wait_ms));
+    }
+}
+
+void tasks_wake_net() {
+    if (net_task) xTaskNotifyGive(net_task);
+}
+
+void tasks_set_input_low_power(bool low_power) {
+    input_low_power = low_power;   // Picked up at the input task's next wake (<= 250 ms)
+}
+
+// ============================================================
+// Startup
+// ============================================================
+void tasks_start(bool touch_int, bool hw_input_int) {
+    touch_int_enabled = touch_int;
+    hw_input_int_enabled = hw_input_int;
+    if (!ui_mutex) ui_mutex = xSemaphoreCreateRecursiveMutex();
+    if (!ui_queue) ui_queue = xQueueCreate(UI_POST_QUEUE_LEN, sizeof(UiCall));
+
+    i2c_bus_start();   // Before the input task: its reads go through the bus queue
+    xTaskCreatePinnedToCore(input_task_fn, "input", INPUT_TASK_STACK, nullptr,
+                            INPUT_TASK_PRIORITY, &input_task, INPUT_TASK_CORE);
+    xTaskCreatePinnedToCore(net_task_fn, "net", NET_TASK_STACK, nullptr,
+                            NET_TASK_PRIORITY, &net_task, NET_TASK_CORE);
+    Serial.printf("[tasks] UI on core %d, input on core %d (prio %d), net on core %d (prio %d)\n",
+                  xPortGetCoreID(), INPUT_TASK_CORE, INPUT_TASK_PRIORITY,
+                  NET_TASK_CORE, NET_TASK_PRIORITY);
+}
+
+// ============================================================
+// UI lock + posted calls
+// ============================================================
+void ui_lock() {
+    if (ui_mutex) xSemaphoreTakeRecursive(ui_mutex, portMAX_DELAY);
+}
+
+void ui_unlock() {
+    if (ui_mutex) xSemaphoreGiveRecursive(ui_mutex);
+}
+
+bool ui_post(UiCallFn fn, uint32_t arg) {
+    if (!ui_queue || !fn) return false;
+    UiCall call = { fn, arg };
+    if (xQueueSend(ui_queue, &call, 0) != pdTRUE) {
+        Serial.println("[tasks] ui_post: queue full, call dropped");
+        return false;
+    }
+    events_post(EVT_UI_REQUEST);
+    return true;
+}
+
+void ui_run_posted() {
+    if (!ui_queue) return;
+    UiCall call;
+    while (xQueueReceive(ui_queue, &call, 0) == pdTRUE) call.fn(call.arg);
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <stdint.h>
+
+// ============================================================
+// Task layout
+//
+//   core 1  loopTask    UI: LVGL, global config, ESP-NOW messages (Arduino loop)
+//   core 0  lv_flush    Async panel flush (display_hw)
+//   core 0  input       GT911 touch + PCF8575 buttons/encoder polling schedule
+//   core 0  i2c         Bus owner: runs I2C jobs by priority (i2c_bus.h)
+//   core 0  net         Config server: SoftAP, ArduinoOTA, live edit
+//   core 0  httpd       Config server HTTP (esp_http_server), quick handlers
+//   core 0  http_wN     Config server uploads and streamed replies
+//   core 0  img_loader  Slideshow JPEG decode
+//
+// LVGL and the global config belong to the UI task. loop() holds the UI
+// lock while it runs and only drops it to sleep in events_wait(). Other
+// tasks take the lock around the few places that touch UI-owned state
+// (icon cache, picture index), or hand the work over with ui_post().
+// Config uploads are parsed off the UI task and handed over whole with
+// stage_config() (ui.h).
+// The input task never calls into the UI: it publishes touch state and
+// queues button samples, and wakes loop() with EVT_TOUCH_DATA/EVT_HW_DATA.
+// ============================================================
+
+#ifndef INPUT_TASK_CORE
+#define INPUT_TASK_CORE 0
+#endif
+#ifndef INPUT_TASK_PRIORITY
+#define INPUT_TASK_PRIORITY 4   // Above the loop task (1): touch is sampled on time
+#endif
+#ifndef NET_TASK_CORE
+#define NET_TASK_CORE 0
+#endif
+#ifndef NET_TASK_PRIORITY
+#define NET_TASK_PRIORITY 1     // Uploads and OTA are bulk work
+#endif
+
+// Start the input and network tasks. Call once at the end of setup(), after
+// the touch/hw_input INT lines have been attached.
+void tasks_start(bool touch_int, bool hw_input_int);
+
+// Wake the network task (config server started or asked to stop)
+void tasks_wake_net();
+
+// Low-power input polling (DIMMED/CLOCK power profiles): polled touch and
+// idle button polling slow down; INT-driven sampling is unaffected.
+void tasks_set_input_low_power(bool low_power);
+
+// UI lock (recursive). Held by loop() for its whole pass.
+void ui_lock();
+void ui_unlock();
+
+// Queue fn(arg) to run on the UI task at the start of its next pass. Safe
+// from any task. Returns false if the queue is full or tasks aren't up yet.
+typedef void (*UiCallFn)(uint32_t arg);
+bool ui_post(UiCallFn fn, uint32_t arg = 0);
+
+// Run everything queued by ui_post(). UI task only.
+void ui_run_posted();
@@ -1,127 +1,354 @@
 #include "touch.h"
+#include "i2c_bus.h"
+#include "events.h"
+#include "input_replay.h"
 
 #include <Arduino.h>
 #include <Wire.h>
 #include <freertos/FreeRTOS.h>
-#include <freertos/semphr.h>
 
 // ============================================================
-// I2C Mutex -- protects all Wire operations
-// ============================================================
-static SemaphoreHandle_t i2c_mutex = NULL;
-
-bool i2c_take(uint32_t timeout_ms) {
-    return xSemaphoreTake(i2c_mutex, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
-}
-
-void i2c_give() {
-    xSemaphoreGive(i2c_mutex);
-}
-
-// ============================================================
-// GT911 Touch -- direct I2C via Wire
+// GT911 Touch -- Wire transactions run as i2c_bus jobs
 // ============================================================
 static uint8_t gt911_addr = 0;
 
+// Written by touch_poll() (its GT911 job runs on the bus task while the
+// input task waits), read by LVGL on the UI task:
+// everything below that crosses over is accessed under touch_mux
+static portMUX_TYPE touch_mux = portMUX_INITIALIZER_UNLOCKED;
+
 static volatile bool     touch_down = false;
 static volatile uint16_t touch_x = 0;
 static volatile uint16_t touch_y = 0;
 
 static uint32_t touch_err_timer = 0;  // Rate-limit error logging
 
-// ============================================================
-// touch_init() -- create mutex only (GT911 not yet reset)
-// ============================================================
-void touch_init() {
-    i2c_mutex = xSemaphoreCreateMutex();
-    configASSERT(i2c_mutex != NULL);
-    Serial.println("I2C mutex created");
-}
-
 // ============================================================
 // gt911_discover() -- probe for GT911 at 0x5D and 0x14
 // Call AFTER display_init() since PCA9557 resets the GT911.
 // ============================================================
+static bool gt911_probe_job(void *arg) {
+    uint8_t addr = *(uint8_t *)arg;
+    Wire.beginTransmission(addr);
+    return Wire.endTransmission() == 0;
+}
+
 void gt911_discover() {
     uint8_t addrs[] = {0x5D, 0x14};
-    for (int attempt = 0; attempt < 10; attempt++) {
+    for (int attempt = 0; attempt < 50; attempt++) {   // Up to ~1 s, in 20 ms steps
         for (int i = 0; i < 2; i++) {
-            if (!i2c_take(50)) continue;
-            Wire.beginTransmission(addrs[i]);
-            uint8_t err = Wire.endTransmission();
-            i2c_give();
-
-            if (err == 0) {
+            if (i2c_run(I2C_DEV_GT911, I2C_PRIO_BACKGROUND, gt911_probe_job, &addrs[i])) {
                 gt911_addr = addrs[i];
                 Serial.printf("GT911 found at 0x%02X (attempt %d)\n", gt911_addr, attempt);
+                // Benchmark probe: an address ACK (status reads have to be acknowledged)
+                i2c_register_probe(I2C_DEV_GT911, gt911_probe_job, &gt911_addr);
                 return;
             }
         }
-        delay(100);
+        delay(20);
     }
     Serial.println("GT911 not found!");
 }
 
 // ============================================================
-// touch_poll() -- read GT911 with full mutex protection
+// GT911 register access -- inside an i2c_bus job
 // ============================================================
-void touch_poll() {
-    if (gt911_addr == 0) return;
-
-    // Acquire mutex for the entire GT911 transaction
-    if (!i2c_take(10)) return;  // Skip this cycle if bus is busy
+#define GT911_REG_STATUS  0x814E   // [7]=buffer ready, [3:0]=touch count
+#define GT911_POINT_SIZE  8        // track_id, x(2), y(2), size(2), reserved
+#define GT911_STALE_MS    200      // Release if a held touch stops reporting
 
-    // Read status register (0x814E)
+static bool gt911_read_regs(uint16_t reg, uint8_t *buf, uint8_t len) {
     Wire.beginTransmission(gt911_addr);
-    Wire.write(0x81);
-    Wire.write(0x4E);
-    int err = Wire.endTransmission();
+    Wire.write(reg >> 8);
+    Wire.write(reg & 0xFF);
+    int err = Wire.endTransmission(false);  // Repeated start, no settle delay needed
     if (err != 0) {
-        i2c_give();
         if (millis() - touch_err_timer > 2000) {
             touch_err_timer = millis();
             Serial.printf("GT911 i2c err: %d\n", err);
         }
-        touch_down = false;
-        return;
+        return false;
     }
+    if (Wire.requestFrom(gt911_addr, len) != len) return false;
+    for (uint8_t i = 0; i < len; i++) buf[i] = Wire.read();
+    return true;
+}
+
+static void gt911_write_reg(uint16_t reg, uint8_t val) {
+    Wire.beginTransmission(gt911_addr);
+    Wire.write(reg >> 8);
+    Wire.write(reg & 0xFF);
+    Wire.write(val);
+    Wire.endTransmission();
+}
+
+static uint32_t last_report_ms = 0;
+
+static TouchPoint points[TOUCH_MAX_POINTS];
+static uint8_t point_count = 0;
 
-    delay(1);
-    Wire.requestFrom(gt911_addr, (uint8_t)1);
-    if (!Wire.available()) {
-        i2c_give();
+// ============================================================
+// gt911_read() -- one burst read of status + all points, then clear.
+// The status register is only cleared when it had data, so an idle
+// panel costs a single I2C transaction per poll.
+// ============================================================
+static bool gt911_read_job(void *) {
+    uint8_t buf[1 + TOUCH_MAX_POINTS * GT911_POINT_SIZE];
+    if (!gt911_read_regs(GT911_REG_STATUS, buf, sizeof(buf))) {
+        portENTER_CRITICAL(&touch_mux);
         touch_down = false;
-        return;
+        point_count = 0;
+        portEXIT_CRITICAL(&touch_mux);
+        return false;
+    }
+
+    uint8_t status = buf[0];
+    if (!(status & 0x80)) {
+        // No new report: keep the current state, but don't stay pressed forever
+        if (touch_down && millis() - last_report_ms > GT911_STALE_MS) {
+            portENTER_CRITICAL(&touch_mux);
+            touch_down = false;
+            point_count = 0;
+            portEXIT_CRITICAL(&touch_mux);
+        }
+        return true;
     }
 
-    uint8_t status = Wire.read();
     uint8_t touches = status & 0x0F;
+    if (touches > TOUCH_MAX_POINTS) touches = TOUCH_MAX_POINTS;
+    TouchPoint fresh[TOUCH_MAX_POINTS];
+    for (uint8_t i = 0; i < touches; i++) {
+        // Point layout: track id, then x/y little-endian
+        const uint8_t *p = &buf[1 + i * GT911_POINT_SIZE];
+        fresh[i].id = p[0];
+        fresh[i].x  = p[1] | (p[2] << 8);
+        fresh[i].y  = p[3] | (p[4] << 8);
+    }
 
-    if ((status & 0x80) && touches > 0) {
-        // Read touch point 0 data (0x8150)
-        Wire.beginTransmission(gt911_addr);
-        Wire.write(0x81);
-        Wire.write(0x50);
-        Wire.endTransmission();
-        delay(1);
-        Wire.requestFrom(gt911_addr, (uint8_t)4);
-        if (Wire.available() >= 4) {
-            touch_x = Wire.read() | (Wire.read() << 8);
-            touch_y = Wire.read() | (Wire.read() << 8);
-            touch_down = true;
-        }
+    portENTER_CRITICAL(&touch_mux);
+    for (uint8_t i = 0; i < touches; i++) points[i] = fresh[i];
+    point_count = touches;
+    if (touches > 0) {
+        touch_x = points[0].x;
+        touch_y = points[0].y;
+        touch_down = true;
     } else {
         touch_down = false;
     }
+    portEXIT_CRITICAL(&touch_mux);
+    last_report_ms = millis();
 
-    // Clear status register
-    Wire.beginTransmission(gt911_addr);
-    Wire.write(0x81);
-    Wire.write(0x4E);
-    Wire.write(0x00);
-    Wire.endTransmission();
+    // Clear buffer-ready so the GT911 posts the next report
+    gt911_write_reg(GT911_REG_STATUS, 0x00);
+    return true;
+}
+
+// Ahead of every other bus client: waits for at most the job on the bus
+static void gt911_read() {
+    if (gt911_addr == 0) return;
+    i2c_run(I2C_DEV_GT911, I2C_PRIO_TOUCH, gt911_read_job);
+}
+
+// ============================================================
+// Gesture recognizer -- runs on the cached points after every poll
+// ============================================================
+#define GESTURE_TAP_SLOP_PX      20    // Movement still counted as "not moved"
+#define GESTURE_SWIPE_MIN_PX     120   // Horizontal travel for a swipe
+#define GESTURE_SWIPE_MAX_MS     600   // Slower drags are not swipes
+#define GESTURE_TWO_FINGER_MS    400   // Max duration of a two-finger tap
+#define GESTURE_LONG_PRESS_MS    800   // Hold time for a long press
+
+static volatile uint8_t gesture_mask = GESTURE_BIT(GESTURE_SWIPE_LEFT) | GESTURE_BIT(GESTURE_SWIPE_RIGHT);
+static volatile TouchGesture gesture_pending = GESTURE_NONE;
+static volatile bool lvgl_cancel_pending = false;  // Applied in touch_read_cb (LVGL context)
+static volatile bool pointer_tracking = false;     // Trackpad widget owns the contact
+
+static struct {
+    bool     active;
+    bool     consumed;     // Gesture emitted, ignore the rest of this contact
+    bool     moved;
+    uint8_t  max_fingers;
+    uint8_t  track_id;     // Finger the swipe/long-press tracks
+    uint16_t x0, y0;
+    uint32_t t0;
+} gesture = {};
+
+static void gesture_emit(TouchGesture g) {
+    portENTER_CRITICAL(&touch_mux);
+    gesture_pending = g;
+    lvgl_cancel_pending = true;
+    portEXIT_CRITICAL(&touch_mux);
+    gesture.consumed = true;
+}
+
+static void gesture_update() {
+    uint32_t now = millis();
+
+    if (point_count == 0) {
+        if (gesture.active && !gesture.consumed && gesture.max_fingers >= 2 && !gesture.moved &&
+            now - gesture.t0 <= GESTURE_TWO_FINGER_MS &&
+            (gesture_mask & GESTURE_BIT(GESTURE_TWO_FINGER_TAP))) {
+            gesture_emit(GESTURE_TWO_FINGER_TAP);
+        }
+        gesture.active = false;
+        return;
+    }
+
+    if (!gesture.active) {
+        gesture = {};
+        gesture.active = true;
+        gesture.max_fingers = point_count;
+        gesture.track_id = points[0].id;
+        gesture.x0 = points[0].x;
+        gesture.y0 = points[0].y;
+        gesture.t0 = now;
+        return;
+    }
+
+    if (pointer_tracking) {
+        // Swipes and two-finger taps on a trackpad are pointer input
+        gesture.consumed = true;
+        gesture.max_fingers = point_count;
+        return;
+    }
+
+    if (point_count > gesture.max_fingers) {
+        gesture.max_fingers = point_count;
+        // A second finger means this isn't a click on whatever is under the first
+        if (gesture_mask & GESTURE_BIT(GESTURE_TWO_FINGER_TAP)) lvgl_cancel_pending = true;
+    }
+    if (gesture.consumed || gesture.max_fingers > 1) {
+        // Multi-finger contacts only qualify as a tap; flag any travel
+        for (uint8_t i = 0; i < point_count; i++) {
+            if (points[i].id != gesture.track_id) continue;
+            if (abs((int)points[i].x - gesture.x0) > GESTURE_TAP_SLOP_PX ||
+                abs((int)points[i].y - gesture.y0) > GESTURE_TAP_SLOP_PX) gesture.moved = true;
+        }
+        return;
+    }
+
+    const TouchPoint *tp = nullptr;
+    for (uint8_t i = 0; i < point_count; i++) {
+        if (points[i].id == gesture.track_id) tp = &points[i];
+    }
+    if (!tp) return;  // Tracked finger lifted, another one is still down
+
+    int dx = (int)tp->x - gesture.x0;
+    int dy = (int)tp->y - gesture.y0;
+    if (abs(dx) > GESTURE_TAP_SLOP_PX || abs(dy) > GESTURE_TAP_SLOP_PX) gesture.moved = true;
+
+    if (abs(dx) >= GESTURE_SWIPE_MIN_PX && abs(dx) > 2 * abs(dy) &&
+        now - gesture.t0 <= GESTURE_SWIPE_MAX_MS) {
+        TouchGesture g = dx < 0 ? GESTURE_SWIPE_LEFT : GESTURE_SWIPE_RIGHT;
+        if (gesture_mask & GESTURE_BIT(g)) gesture_emit(g);
+    } else if (!gesture.moved && now - gesture.t0 >= GESTURE_LONG_PRESS_MS &&
+               (gesture_mask & GESTURE_BIT(GESTURE_LONG_PRESS))) {
+        gesture_emit(GESTURE_LONG_PRESS);
+    }
+}
+
+void touch_set_gestures(uint8_t mask) {
+    gesture_mask = mask;
+}
 
-    i2c_give();
+void touch_set_tracking(bool on) {
+    pointer_tracking = on;
+}
+
+bool touch_tracking() {
+    return pointer_tracking;
+}
+
+TouchGesture touch_take_gesture() {
+    portENTER_CRITICAL(&touch_mux);
+    TouchGesture g = gesture_pending;
+    gesture_pending = GESTURE_NONE;
+    portEXIT_CRITICAL(&touch_mux);
+    return g;
+}
+
+// ============================================================
+// Replay -- injected points stand in for the GT911 (input_replay.h)
+// ============================================================
+static TouchPoint inject_points[TOUCH_MAX_POINTS];
+static uint8_t inject_count = 0;
+static volatile bool inject_pending = false;
+
+void touch_inject(const TouchPoint *pts, uint8_t n) {
+    if (n > TOUCH_MAX_POINTS) n = TOUCH_MAX_POINTS;
+    portENTER_CRITICAL(&touch_mux);
+    for (uint8_t i = 0; i < n; i++) inject_points[i] = pts[i];
+    inject_count = n;
+    inject_pending = true;
+    portEXIT_CRITICAL(&touch_mux);
+    events_post(EVT_TOUCH_INT);   // Input task applies it on its next pass
+}
+
+// Input task: hand every change of the point set to the recorder
+static void record_points() {
+    static TouchPoint recorded[TOUCH_MAX_POINTS];
+    static uint8_t recorded_count = 0;
+    bool same = point_count == recorded_count;
+    for (uint8_t i = 0; same && i < point_count; i++) {
+        same = points[i].id == recorded[i].id && points[i].x == recorded[i].x && points[i].y == recorded[i].y;
+    }
+    if (same) return;
+    for (uint8_t i = 0; i < point_count; i++) recorded[i] = points[i];
+    recorded_count = point_count;
+    replay_record_touch(points, point_count);
+}
+
+// Input task, in place of gt911_read() while a replay runs
+static void apply_injected() {
+    portENTER_CRITICAL(&touch_mux);
+    if (inject_pending) {
+        inject_pending = false;
+        for (uint8_t i = 0; i < inject_count; i++) points[i] = inject_points[i];
+        point_count = inject_count;
+        touch_down = inject_count > 0;
+        if (touch_down) {
+            touch_x = points[0].x;
+            touch_y = points[0].y;
+        }
+    }
+    portEXIT_CRITICAL(&touch_mux);
+}
+
+// ============================================================
+// touch_poll() -- returns true if pressed state or position changed
+// ============================================================
+static volatile TouchDownHook down_hook = nullptr;
+
+void touch_set_down_hook(TouchDownHook fn) {
+    down_hook = fn;
+}
+
+bool touch_poll() {
+    bool     was_down = touch_down;
+    uint16_t prev_x = touch_x;
+    uint16_t prev_y = touch_y;
+
+
+    if (replay_running()) apply_injected();   // The panel itself is muted
+    else gt911_read();
+    if (replay_recording()) record_points();
+    TouchDownHook hook = down_hook;
+    if (hook && touch_down && !was_down) hook(touch_x, touch_y);
+    gesture_update();  // Also runs without a fresh report so long-press can time out
+
+    return lvgl_cancel_pending || touch_down != was_down || (touch_down && (touch_x != prev_x || touch_y != prev_y));
+}
+
+bool touch_is_down() {
+    return touch_down;
+}
+
+uint8_t touch_get_points(TouchPoint *out, uint8_t max) {
+    portENTER_CRITICAL(&touch_mux);
+    uint8_t n = point_count < max ? point_count : max;
+    for (uint8_t i = 0; i < n; i++) out[i] = points[i];
+    portEXIT_CRITICAL(&touch_mux);
+    return n;
 }
 
 // ============================================================
@@ -129,7 +356,15 @@ void touch_poll() {
 // Returns cached touch state, no I2C here.
 // ============================================================
 void touch_read_cb(lv_indev_drv_t *drv, lv_indev_data_t *data) {
+    portENTER_CRITICAL(&touch_mux);
+    bool cancel = lvgl_cancel_pending;
+    lvgl_cancel_pending = false;
     data->point.x = touch_x;
     data->point.y = touch_y;
     data->state   = touch_down ? LV_INDEV_STATE_PR : LV_INDEV_STATE_REL;
+    portEXIT_CRITICAL(&touch_mux);
+    if (cancel) {
+        // Gesture took over: drop the press (PRESS_LOST, no CLICKED) until release
+        lv_indev_wait_release(lv_indev_get_act());
+    }
 }
@@ -2,11 +2,52 @@
 #include <cstdint>
 #include <lvgl.h>
 
-void touch_init();       // Create I2C mutex
+// GPIO wired to the GT911 INT line, or -1 when INT only reaches the PCA9557
+// (stock CrowPanel wiring) and touch has to be polled. The PCA9557 has no
+// interrupt output, and sampling IO1 over I2C costs the same transaction as
+// reading the GT911 status register, so polled mode gates on status bit 7.
+#ifndef TOUCH_INT_GPIO
+#define TOUCH_INT_GPIO -1
+#endif
+
+#define TOUCH_MAX_POINTS 5   // GT911 reports up to 5 simultaneous points
+
+struct TouchPoint {
+    uint8_t  id;     // GT911 track id (stable while the finger stays down)
+    uint16_t x;
+    uint16_t y;
+};
+
+// Gestures recognized on top of the raw points. A recognized gesture cancels
+// the LVGL press in progress, so the widget under the finger doesn't click.
+enum TouchGesture : uint8_t {
+    GESTURE_NONE = 0,
+    GESTURE_SWIPE_LEFT,       // Finger moved right-to-left (next page)
+    GESTURE_SWIPE_RIGHT,      // Finger moved left-to-right (previous page)
+    GESTURE_TWO_FINGER_TAP,   // Two or more fingers down and up without moving
+    GESTURE_LONG_PRESS,       // One finger held still
+};
+
+#define GESTURE_BIT(g) (1u << (g))
+
 void gt911_discover();   // Discover GT911 address -- call after display_init()
-void touch_poll();       // Poll GT911 with mutex protection -- call from loop() at 20Hz
+// touch_poll() runs on the input task; the getters and touch_read_cb may be
+// called from any task (state is published under a spinlock).
+bool touch_poll();       // Burst-read GT911 (status + point, then clear) -- true if touch state changed
+bool touch_is_down();    // Last polled pressed state
+uint8_t touch_get_points(TouchPoint *out, uint8_t max);  // Copy current points, returns count
+void touch_set_gestures(uint8_t mask);  // GESTURE_BIT()s to recognize (0 = raw touch only)
+TouchGesture touch_take_gesture();      // Pending gesture, cleared on read
+// A trackpad widget owns the current contact: no gestures are recognized
+// for it and the input task polls at the tracking rate while it is down
+void touch_set_tracking(bool on);
+bool touch_tracking();
 void touch_read_cb(lv_indev_drv_t *drv, lv_indev_data_t *data);  // LVGL callback
-
-// I2C mutex helpers -- used by any module needing I2C
-bool i2c_take(uint32_t timeout_ms = 10);
-void i2c_give();
+// Called on the input task, from touch_poll(), when a contact starts (the
+// first finger going down). Must not block or touch LVGL: it exists so the
+// UI can hit-test the press before the read callback ever sees it.
+typedef void (*TouchDownHook)(uint16_t x, uint16_t y);
+void touch_set_down_hook(TouchDownHook fn);
+// Input replay: the next touch_poll() takes these points (n = 0 releases)
+// instead of reading the GT911, which stays unread while replay_running()
+void touch_inject(const TouchPoint *pts, uint8_t n);
@@ -0,0 +1,199 @@
+/**
+ * @file trackpad.cpp
+ * Trackpad widget input: touch samples -> MSG_POINTER frames
+ *
+ * Runs on LVGL events (UI task). LVGL is kicked on every input task poll
+ * (EVT_TOUCH_DATA), so LV_EVENT_PRESSING arrives at the tracking poll rate;
+ * the fingers themselves come from touch_get_points(), which also tells one
+ * finger from two. Relative motion keeps a sub-pixel remainder so slow
+ * drags at low speed settings still move the pointer.
+ */
+
+#include "trackpad.h"
+#include "espnow_link.h"
+#include "protocol.h"
+#include "touch.h"
+#include "log.h"
+#include <Arduino.h>
+#include <stdlib.h>
+
+#define TRACKPAD_TAP_MS      200   // Shorter contact without travel = click
+#define TRACKPAD_TAP_SLOP_PX 10    // Travel still counted as a tap
+#define TRACKPAD_SCROLL_PX   24    // Two-finger travel per wheel step
+
+// Widget settings ride in the event user_data: speed << 1 | absolute
+#define TRACKPAD_PARAM(absolute, speed) ((void *)(uintptr_t)(((speed) << 1) | ((absolute) ? 1 : 0)))
+
+static struct {
+    lv_obj_t *obj;            // Widget owning the contact
+    bool active;
+    bool absolute;
+    bool moved;
+    uint8_t speed;            // Tenths
+    uint8_t max_fingers;
+    uint8_t track_id;         // GT911 id of the finger that moves the pointer
+    lv_area_t area;           // Widget on screen (absolute mapping)
+    int16_t start_x, start_y;
+    int16_t last_x, last_y;
+    int32_t rem_x, rem_y;     // Sub-pixel motion, tenths of a host pixel
+    int32_t scroll_x, scroll_y;
+    uint32_t t0;
+} contact = {};
+
+static uint8_t buttons = 0;
+static uint8_t button_seq = 0;
+
+static void send(int16_t x, int16_t y, int8_t wheel, int8_t pan, bool reliable) {
+    PointerMsg m = {};
+    m.flags = contact.absolute ? POINTER_ABSOLUTE : 0;
+    m.buttons = buttons;
+    m.button_seq = button_seq;
+    m.x = x;
+    m.y = y;
+    m.wheel = wheel;
+    m.pan = pan;
+    espnow_send_pointer(m, reliable);
+}
+
+// Panel coordinates -> 0..POINTER_ABS_MAX over the widget
+static void abs_position(int px, int py, int16_t &x, int16_t &y) {
+    int w = lv_area_get_width(&contact.area) - 1;
+    int h = lv_area_get_height(&contact.area) - 1;
+    px = constrain(px - contact.area.x1, 0, w);
+    py = constrain(py - contact.area.y1, 0, h);
+    x = (int16_t)((int32_t)px * POINTER_ABS_MAX / (w > 0 ? w : 1));
+    y = (int16_t)((int32_t)py * POINTER_ABS_MAX / (h > 0 ? h : 1));
+}
+
+// Button edges go sequenced; in absolute mode they carry the position too
+static void set_buttons(uint8_t b) {
+    if (b == buttons) return;
+    buttons = b;
+    button_seq++;
+    int16_t x = 0, y = 0;
+    if (contact.absolute) abs_position(contact.last_x, contact.last_y, x, y);
+    send(x, y, 0, 0, true);
+}
+
+static void contact_begin(lv_obj_t *obj, uintptr_t param) {
+    TouchPoint pts[TOUCH_MAX_POINTS];
+    uint8_t n = touch_get_points(pts, TOUCH_MAX_POINTS);
+    lv_point_t p;
+    lv_indev_get_point(lv_indev_get_act(), &p);
+
+    contact = {};
+    contact.obj = obj;
+    contact.active = true;
+    contact.absolute = param & 1;
+    contact.speed = (uint8_t)(param >> 1);
+    contact.max_fingers = n ? n : 1;
+    contact.track_id = n ? pts[0].id : 0;
+    contact.start_x = contact.last_x = n ? pts[0].x : p.x;
+    contact.start_y = contact.last_y = n ? pts[0].y : p.y;
+    contact.t0 = millis();
+    lv_obj_get_coords(obj, &contact.area);
+    touch_set_tracking(true);
+
+    if (contact.absolute) set_buttons(POINTER_BTN_LEFT);
+}
+
+static void contact_track() {
+    TouchPoint pts[TOUCH_MAX_POINTS];
+    uint8_t n = touch_get_points(pts, TOUCH_MAX_POINTS);
+    if (n == 0) return;
+
+    const TouchPoint *tp = nullptr;
+    for (uint8_t i = 0; i < n; i++) {
+        if (pts[i].id == contact.track_id) tp = &pts[i];
+    }
+    if (n > contact.max_fingers) contact.max_fingers = n;
+    if (!tp) {
+        // Tracked finger lifted while another stays down: follow that one, no jump
+        contact.track_id = pts[0].id;
+        contact.last_x = pts[0].x;
+        contact.last_y = pts[0].y;
+        return;
+    }
+
+    int dx = tp->x - contact.last_x;
+    int dy = tp->y - contact.last_y;
+    contact.last_x = tp->x;
+    contact.last_y = tp->y;
+    if (abs(tp->x - contact.start_x) > TRACKPAD_TAP_SLOP_PX ||
+        abs(tp->y - contact.start_y) > TRACKPAD_TAP_SLOP_PX) contact.moved = true;
+    if (!dx && !dy) return;
+
+    if (contact.absolute) {
+        if (n > 1) return;
+        int16_t x, y;
+        abs_position(tp->x, tp->y, x, y);
+        send(x, y, 0, 0, false);
+        return;
+    }
+
+    if (n > 1) {
+        // Two fingers scroll, content follows the fingers
+        contact.scroll_x += dx;
+        contact.scroll_y += dy;
+        int wheel = contact.scroll_y / TRACKPAD_SCROLL_PX;
+        int pan = contact.scroll_x / TRACKPAD_SCROLL_PX;
+        contact.scroll_y -= wheel * TRACKPAD_SCROLL_PX;
+        contact.scroll_x -= pan * TRACKPAD_SCROLL_PX;
+        if (wheel || pan) send(0, 0, (int8_t)constrain(wheel, -127, 127), (int8_t)constrain(-pan, -127, 127), false);
+        return;
+    }
+
+    int32_t vx = dx * contact.speed + contact.rem_x;
+    int32_t vy = dy * contact.speed + contact.rem_y;
+    int16_t mx = (int16_t)(vx / 10);
+    int16_t my = (int16_t)(vy / 10);
+    contact.rem_x = vx - mx * 10;
+    contact.rem_y = vy - my * 10;
+    if (mx || my) send(mx, my, 0, 0, false);
+}
+
+static void contact_end(bool released) {
+    if (!contact.active) return;
+    contact.active = false;
+    touch_set_tracking(false);
+
+    if (contact.absolute) {
+        set_buttons(0);
+        return;
+    }
+    if (released && !contact.moved && millis() - contact.t0 <= TRACKPAD_TAP_MS) {
+        set_buttons(contact.max_fingers >= 2 ? POINTER_BTN_RIGHT : POINTER_BTN_LEFT);
+        set_buttons(0);
+        LOG_D("[trackpad] %s click\n", contact.max_fingers >= 2 ? "right" : "left");
+    }
+}
+
+static void trackpad_event_cb(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    switch (code) {
+        case LV_EVENT_PRESSED:
+            contact_begin(lv_event_get_target(e), (uintptr_t)lv_event_get_user_data(e));
+            break;
+        case LV_EVENT_PRESSING:
+            if (contact.active) contact_track();
+            break;
+        case LV_EVENT_RELEASED:
+        case LV_EVENT_PRESS_LOST:
+            contact_end(code == LV_EVENT_RELEASED);
+            break;
+        case LV_EVENT_DELETE:
+            // Page rebuilt under the finger: don't leave a button held
+            if (contact.obj == lv_event_get_target(e)) contact_end(false);
+            break;
+        default:
+            break;
+    }
+}
+
+void trackpad_attach(lv_obj_t *obj, const WidgetConfig *cfg) {
+    // Keep the contact when the finger slides off, and never scroll the page
+    lv_obj_add_flag(obj, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_PRESS_LOCK);
+    lv_obj_clear_flag(obj, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_SCROLL_CHAIN | LV_OBJ_FLAG_GESTURE_BUBBLE);
+    lv_obj_add_event_cb(obj, trackpad_event_cb, LV_EVENT_ALL,
+                        TRACKPAD_PARAM(cfg->trackpad_absolute, cfg->trackpad_speed));
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <lvgl.h>
+#include "config.h"
+
+// ============================================================
+// Trackpad widgets (WIDGET_TRACKPAD -> MSG_POINTER -> bridge pointer HID)
+//
+// Relative mode works like a laptop touchpad: one finger moves the
+// pointer (scaled by trackpad_speed), two fingers scroll, a short tap
+// clicks (two-finger tap = right click). Absolute mode maps the widget
+// onto the host's whole screen and holds the left button while the
+// finger is down, for drawing and tablet-style use.
+//
+// While a finger is down on a trackpad the input task samples touch at
+// 125 Hz and page gestures are off for that contact. Every sample becomes
+// a MSG_POINTER frame; espnow_send_pointer() merges the ones that queue up
+// behind the radio, so the link carries one motion frame per slot.
+// ============================================================
+
+// Make `obj` (already sized and styled) a trackpad for `cfg`
+void trackpad_attach(lv_obj_t *obj, const WidgetConfig *cfg);
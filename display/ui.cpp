@@ -1,17 +1,46 @@
 #include <lvgl.h>
 #include <Arduino.h>
 #include <ctime>
+#include <sys/time.h>
 #include <cmath>
 #include <vector>
+#include <deque>
 #include <SD.h>
+#include <strings.h>
 #include "protocol.h"
 #include "config.h"
 #include "display_hw.h"
 #include "espnow_link.h"
 #include "power.h"
+#include "battery.h"
 #include "config_server.h"
+#include "live_edit.h"
 #include "ui.h"
+#include "perf.h"
+#include "mem_budget.h"
+#include "tasks.h"
+#include "status_store.h"
+#include "hw_input.h"
+#include "icon_cache.h"
+#include "anim_icon.h"
+#include "png_stream.h"
+#include "button_skin.h"
+#include "trackpad.h"
+#include "touch.h"
+#include "actions.h"
+#include "remote_image.h"
+#include "font_store.h"
+#include "img_loader.h"
+#include "picture_index.h"
+#include "runtime_state.h"
+#include "stats_log.h"
+#include "clock_direct.h"
+#include "widget_registry.h"
+#include "ui_jobs.h"
+#include "log.h"
+#include "trace.h"
 #include <WiFi.h>
+#include <esp_heap_caps.h>
 
 // ============================================================
 //  Color Palette
@@ -31,14 +60,149 @@
 #define CLR_LIME    0x8BC34A
 #define CLR_AMBER   0xFFC107
 
+// Stat labels on hidden pages are only brought up to date when the page is
+// shown (from the per-type value cache). Set to 0 to update them live.
+#ifndef UI_DEFER_HIDDEN_STAT_UPDATES
+#define UI_DEFER_HIDDEN_STAT_UPDATES 1
+#endif
+
+// Pages are built on first visit; at most UI_PAGE_CACHE_SIZE stay realized
+// (least recently shown is deleted first). Neighbours of the current page
+// are prefetched once input has been idle for UI_PREFETCH_IDLE_MS.
+#ifndef UI_PAGE_CACHE_SIZE
+#define UI_PAGE_CACHE_SIZE 3
+#endif
+#define UI_PREFETCH_IDLE_MS 250
+
+// The companion is told which stats are on screen (MSG_STATS_SUBSCRIBE) and
+// collects only those. Set to 0 to have it send everything configured.
+#ifndef UI_STATS_SUBSCRIBE
+#define UI_STATS_SUBSCRIBE 1
+#endif
+
+// Page snapshots: an RGB565 copy of a realized page, taken by the idle
+// timer (750 KB of PSRAM each, images pool). Showing a page that has one
+// puts the snapshot on an opaque overlay above the live page, which LVGL
+// then doesn't draw at all; the overlay is dropped, and the page rendered
+// for real, once navigation pauses for UI_SNAPSHOT_SETTLE_MS or the screen
+// is touched. Swipes slide the outgoing and incoming snapshots. 0 = off.
+#ifndef UI_PAGE_SNAPSHOTS
+#define UI_PAGE_SNAPSHOTS 2
+#endif
+#define UI_SNAPSHOT_SETTLE_MS 300
+#define UI_SWIPE_ANIM_MS      200
+
+// Once the neighbour pages are built, the same idle timer parses the
+// profiles config_load() only indexed, one per tick, so switching profile
+// never waits on the SD card. Set to 0 to parse them on first switch.
+#ifndef UI_PROFILE_PREFETCH
+#define UI_PROFILE_PREFETCH 1
+#endif
+
+// Touch hit grid for fire-on-press buttons: cell size in pixels. The grid
+// only exists for pages that have such a button.
+#ifndef UI_HIT_CELL
+#define UI_HIT_CELL 40
+#endif
+
+// Scroll grids keep LVGL objects for the visible rows plus this many above
+// and below; off-screen icons are loaded one per UI_GRID_ICON_MS tick
+// while the grid is not being dragged.
+#ifndef UI_GRID_OVERSCAN_ROWS
+#define UI_GRID_OVERSCAN_ROWS 1
+#endif
+#define UI_GRID_ICON_MS  20
+#define UI_GRID_CELL_GAP 6
+
+// Full-screen JPEG/SJPG/BMP/.bin page backgrounds are decoded (raw ones
+// just read) once on the image loader task into an opaque RGB565 PSRAM
+// frame (750 KB, images pool) instead of through LVGL's decoders on every
+// redraw; the page shows without it until the frame is ready. 0 = always
+// the "S:" drive.
+#ifndef UI_ASYNC_BACKGROUNDS
+#define UI_ASYNC_BACKGROUNDS 1
+#endif
+#define UI_BG_POLL_MS 40
+
+// Page layers: once a page is built and its background is up, the idle
+// timer renders the background, plus the text labels and separators with no
+// live widget under them, into one RGB565 image (750 KB, images pool) and
+// deletes their objects. Redraws then blit one opaque image instead of
+// compositing each of them; a PNG background is no longer decoded from
+// the "S:" drive. Worth it with a background or at least
+// UI_PAGE_LAYER_MIN_WIDGETS such widgets. 0 = off.
+#ifndef UI_PAGE_LAYERS
+#define UI_PAGE_LAYERS 1
+#endif
+#define UI_PAGE_LAYER_MIN_WIDGETS 3
+
+// Read buffer per file opened through the "S:" LVGL drive (PSRAM, 4-16 KB)
+#ifndef SD_LVGL_READ_CACHE
+#define SD_LVGL_READ_CACHE 16384
+#endif
+
 // ============================================================
 //  UI State
 // ============================================================
 static const AppConfig *g_active_config = nullptr;
 
-// Page management (replaces tabview)
-static std::vector<lv_obj_t *> page_containers;
+// Page background being decoded / shown from an img_loader frame. Owned by
+// page_backgrounds; a page that goes away only drops `img`, the frame is
+// freed once the loader no longer writes to it.
+struct PageBackground {
+    uint16_t *pixels;
+    lv_img_dsc_t dsc;
+    volatile ImgLoadState state;
+    lv_obj_t *img;                     // nullptr once the page is gone
+    int page;
+    bool shown;
+    std::string path;                  // For the "S:" fallback
+};
+static std::vector<PageBackground *> page_backgrounds;
+static lv_timer_t *bg_poll_timer = nullptr;
+
+// Page management (replaces tabview). One slot per page of the active
+// profile; container is nullptr until realized, the PageConfig is the descriptor.
+struct PageSlot {
+    lv_obj_t *container;
+    uint32_t last_used;                // LRU stamp, 0 = never shown
+    std::vector<lv_obj_t *> widgets;   // Top-level object per WidgetConfig
+    PageConfig built;                  // Config the widgets were built from (for rebuild diff)
+    ActionTable actions;               // Button actions, generated with the widgets
+    PageBackground *bg = nullptr;      // Async background, if any
+    uint16_t widget_types = 0;         // Bit per WidgetType in `built`, for the ticker
+    lv_obj_t *bg_obj = nullptr;        // Background image object until baked into the layer
+    std::vector<bool> layer_mask;      // Per widget: may go into the layer (page_layer_mask())
+    lv_obj_t *layer = nullptr;         // Baked static content, bottom of the page
+    lv_img_dsc_t layer_dsc = {};
+    void *layer_buf = nullptr;
+    bool layer_failed = false;         // No memory for it: widgets stay live until rebuilt
+    // Background build / patch in slices (ui_jobs.h); container is only set once built
+    UiJobId job = 0;
+    lv_obj_t *job_container = nullptr; // Build: the page so far, hidden
+    uint16_t job_next = 0;             // Next widget
+};
+static std::vector<PageSlot> pages;
+static uint32_t page_use_clock = 0;
+static lv_obj_t *pages_parent = nullptr;
+static lv_timer_t *page_prefetch_timer = nullptr;
 static int current_page = 0;
+static size_t profile_prefetch_next = 0;   // Next profile the idle timer looks at
+static int rebuild_target_page = -1;       // Page rebuild_ui() lands on after a profile switch
+
+struct PageSnapshot {
+    int page = -1;                     // -1 = empty (buffer may still be allocated)
+    void *buf = nullptr;
+    uint32_t size = 0;
+    lv_img_dsc_t img = {};
+    uint32_t last_used = 0;            // page_use_clock when taken / shown
+};
+static PageSnapshot page_snapshots[UI_PAGE_SNAPSHOTS > 0 ? UI_PAGE_SNAPSHOTS : 1];
+static bool snapshot_taken_this_visit = false;  // Current page captured since it was shown
+static lv_obj_t *snap_strip = nullptr;          // Two screens wide, opaque, above the pages
+static lv_obj_t *snap_img[2] = {};              // Left and right half of the strip
+static lv_timer_t *snap_settle_timer = nullptr;
+static uint32_t snap_shown_ms = 0;
 
 // Main screen
 static lv_obj_t *main_screen = nullptr;
@@ -52,19 +216,42 @@ static lv_obj_t *clock_rssi_label = nullptr;
 static lv_obj_t *config_screen = nullptr;
 static lv_obj_t *config_info_label = nullptr;
 
-// Analog clock widgets
-static lv_obj_t *analog_clock_face = nullptr;
-static lv_obj_t *analog_hour_hand = nullptr;
-static lv_obj_t *analog_min_hand = nullptr;
-static lv_point_t hour_points[2];
-static lv_point_t min_points[2];
+// Analog clock widgets. The face is baked into a PSRAM image the first time
+// it is shown; each hand is a line object only as big as the hand itself,
+// so moving one redraws that box and not the whole screen.
+#ifndef CLOCK_SECOND_HAND_FPS
+#define CLOCK_SECOND_HAND_FPS 10   // Cap on second hand steps per second
+#endif
+#define CLOCK_FACE_SIZE  300
+#define CLOCK_BG         0x0f0f23
+
+struct ClockHand {
+    lv_obj_t *line;
+    int16_t length;          // Centre to tip
+    int16_t tail;            // Centre to the back end
+    lv_point_t pos;          // Object position (bounding box corner)
+    lv_point_t pts[2];       // Relative to pos
+};
+static lv_obj_t *analog_clock_face = nullptr;    // lv_img of analog_face_img
+static lv_img_dsc_t analog_face_img;
+static void *analog_face_buf = nullptr;
+static bool analog_face_failed = false;          // Bake failed, stay digital
+static ClockHand hour_hand = { nullptr, 80, 0 };
+static ClockHand min_hand = { nullptr, 120, 0 };
+static ClockHand sec_hand = { nullptr, 130, 24 };
+static lv_obj_t *analog_center_cap = nullptr;
+static lv_timer_t *second_hand_timer = nullptr;
 
 // Picture frame mode state
 static lv_obj_t *picture_frame_screen = nullptr;
-static lv_obj_t *slideshow_img = nullptr;
+static lv_obj_t *slideshow_img = nullptr;              // Synchronous fallback (no loader)
+static lv_obj_t *slideshow_slot_img[IMG_LOADER_SLOTS];  // One lv_img per loader frame
+static int8_t slideshow_shown = -1;                     // Loader slot on screen, -1 = none yet
+static bool slideshow_async = false;                    // Frames come from img_loader
 static lv_obj_t *slideshow_fallback_label = nullptr;
-static std::vector<String> slideshow_files;
-static size_t slideshow_index = 0;
+static uint32_t slideshow_count = 0;                    // Pictures in the index
+static PictureOrder slideshow_order;                    // Index order or shuffled
+static uint32_t slideshow_index = 0;                    // Position in slideshow_order
 static lv_timer_t *slideshow_timer = nullptr;
 
 // Standby mode state
@@ -72,31 +259,151 @@ static lv_obj_t *standby_screen = nullptr;
 static lv_obj_t *standby_time_label = nullptr;
 static lv_obj_t *standby_stats_label = nullptr;
 
+// Secondary screens (clock, config, standby, picture frame) are built the
+// first time they are shown and deleted UI_SCREEN_IDLE_MS after they were
+// last left (0 = kept once built), which hands their objects back to the
+// LVGL heap. The analog clock face stays baked in PSRAM across that, so a
+// rebuild is a few labels and lines.
+#ifndef UI_SCREEN_IDLE_MS
+#define UI_SCREEN_IDLE_MS 60000
+#endif
+enum SecondaryScreenId : uint8_t { SCREEN_CLOCK, SCREEN_CONFIG, SCREEN_STANDBY, SCREEN_PICTURE, SCREEN_COUNT };
+static void screen_track(lv_obj_t *scr, SecondaryScreenId id);
+static void ensure_clock_screen();
+static void ensure_config_screen();
+
 // LVGL SD card filesystem driver state
 static bool sd_fs_registered = false;
 
 // Stat monitor tracking: widget pointer + stat type for live updates
+// Name and value are separate labels in every layout: updates only touch the
+// fixed-width value label, so each one invalidates just the digits' box.
 struct StatWidgetRef {
-    lv_obj_t *label;         // Value label (or combined label when inline)
-    lv_obj_t *name_label;    // Separate name label (when value_position != 0), or nullptr
+    lv_obj_t *label;         // Value label (fixed width, text only changes here)
+    lv_obj_t *name_label;    // Static name label
     uint8_t stat_type;
-    uint8_t value_position;  // 0=inline, 1=value top, 2=value bottom
+    uint8_t page_idx;        // Owning page (for deferred hidden-page updates)
+    uint8_t host;            // WidgetConfig::stat_host: 0 = active host, N = host slot N-1
+    uint8_t remote;          // WidgetConfig::stat_remote: 0 = none, N = remote_stats[N-1]
+    bool has_value;          // last_value is what the label currently shows
+    int32_t last_value;
+    bool animating;          // Counting from anim_from to anim_to (stat_anim_timer)
+    int32_t anim_from, anim_to;
+    uint32_t anim_start_ms;
+    uint16_t anim_ms;
 };
 static std::vector<StatWidgetRef> stat_widget_refs;
 
+// Per-StatType dispatch: indices into stat_widget_refs, built by create_pages()
+static std::vector<uint16_t> stat_index[STAT_TYPE_MAX + 1];
+
+// Latest value per stat type: the companion only sends changed stats between
+// keyframes, so widgets created by a rebuild start from here instead of "--".
+// Temperatures are kept in tenths of a degree however they arrived, byte
+// stats' 0xFF "unavailable" as STAT_NA.
+#define STAT_NA INT32_MIN
+static int32_t stat_cache[STAT_TYPE_MAX + 1];
+static bool stat_cache_valid[STAT_TYPE_MAX + 1];
+static uint32_t stat_cache_ms[STAT_TYPE_MAX + 1];
+
+// The same per host slot, fed by every host's MSG_STATS. stat_cache above
+// follows stats_host (the active one); switching hosts reloads it from
+// here, and widgets pinned to a background host (stat_host) read from here.
+struct HostStats {
+    int32_t value[STAT_TYPE_MAX + 1];
+    uint32_t ms[STAT_TYPE_MAX + 1];
+    bool valid[STAT_TYPE_MAX + 1];
+};
+static HostStats host_stats[ESPNOW_MAX_HOSTS];
+static uint8_t stats_host = 0;
+static uint8_t decode_host = 0;              // Host of the MSG_STATS being decoded
+static std::string host_profile[ESPNOW_MAX_HOSTS];   // Last profile shown while each host was active
+
+// Remote collectors' stats (MSG_HOST_STATS), by id - 1. Only stat monitors
+// pinned to one (stat_remote) read them: no graphs, alerts or history.
+static HostStats remote_stats[REMOTE_HOST_MAX];
+
+// Live (10-30 Hz) stats: labels are touched at most once per display refresh
+// period. A value arriving sooner is parked in stat_dirty and applied by
+// stat_flush_timer, so only the latest one of a burst is formatted.
+#define STAT_LABEL_MIN_MS LV_DISP_DEF_REFR_PERIOD
+static uint32_t stat_label_ms[STAT_TYPE_MAX + 1];
+static uint8_t stat_dirty[(STAT_TYPE_MAX + 8) / 8];
+static lv_timer_t *stat_flush_timer = nullptr;
+static bool stat_flush_pending = false;
+
+// Smoothed time between updates per type (EWMA, ms). A type arriving faster
+// than STAT_LIVE_INTERVAL_MS is treated as live: its graph history is sampled
+// every STAT_GRAPH_LIVE_SAMPLE_MS instead of once a second.
+#define STAT_LIVE_INTERVAL_MS 250
+static uint16_t stat_interval_ms[STAT_TYPE_MAX + 1];
+
+// Stat labels count from the value shown to a new one over the type's
+// update interval (at most STAT_ANIM_MAX_MS) instead of jumping. One timer
+// steps every moving label, at STAT_ANIM_FPS (STAT_ANIM_DIM_FPS while
+// dimmed), and only while one is moving. Live stats, hidden pages and the
+// battery saver snap. -DSTAT_ANIM_FPS=0 turns it off.
+#ifndef STAT_ANIM_FPS
+#define STAT_ANIM_FPS 20
+#endif
+#define STAT_ANIM_DIM_FPS 5
+#define STAT_ANIM_MAX_MS  1000
+static lv_timer_t *stat_anim_timer = nullptr;
+
+// Stat history for graph widgets: one ring per subscribed StatType (PSRAM),
+// sampled from stat_cache at a fixed rate so delta-encoded stats still plot
+// on an even time axis. Kept across rebuilds while any graph uses the type.
+#define STAT_GRAPH_SAMPLE_MS 1000
+#define STAT_GRAPH_LIVE_SAMPLE_MS 100
+#define STAT_GRAPH_STALE_MS  6000   // No update for this long: plot a gap
+
+struct StatHistory {
+    uint8_t  *samples;       // uint8 or uint16 (wide) per sample
+    uint16_t capacity;
+    uint16_t head;           // Next write index
+    uint16_t count;
+    bool     wide;
+    bool     used;           // Subscribed by a graph in the current build
+    uint16_t peak;           // Max over the ring, for auto-range
+    uint16_t peak_age;       // Samples since peak was recorded
+    uint32_t sampled_ms;     // When the last sample was pushed
+    bool     prefilled;      // Older part already read back from the stats log
+};
+static StatHistory stat_history[STAT_TYPE_MAX + 1];
+
+struct StatGraphRef {
+    lv_obj_t *chart;
+    lv_chart_series_t *series;
+    uint8_t stat_type;
+    uint16_t fixed_max;      // 0 = auto
+    uint16_t range_max;      // Currently applied Y maximum
+    uint8_t page_idx;
+};
+static std::vector<StatGraphRef> stat_graph_refs;
+static lv_timer_t *stat_graph_timer = nullptr;
+
 // Status bar widget references for live updates
 struct StatusBarRef {
+    lv_obj_t *bar;
     lv_obj_t *rssi_label;
     lv_obj_t *pc_label;
+    lv_obj_t *battery_label;
     lv_obj_t *time_label;
+    uint8_t page_idx;
 };
 static std::vector<StatusBarRef> status_bar_refs;
 
+// Objects on a page that need periodic updates
+struct PageObjRef {
+    lv_obj_t *obj;
+    uint8_t page_idx;
+};
+
 // Page nav widget references
-static std::vector<lv_obj_t *> page_nav_refs;
+static std::vector<PageObjRef> page_nav_refs;
 
 // Clock widget labels on pages (for periodic time updates)
-static std::vector<lv_obj_t *> clock_widget_labels;
+static std::vector<PageObjRef> clock_widget_labels;
 
 // Forward declarations
 void update_clock_time();
@@ -108,7 +415,169 @@ static void init_standby_mode();
 static void load_next_slideshow_image();
 static void slideshow_timer_cb(lv_timer_t *timer);
 static void lvgl_register_sd_driver();
-static void update_page_nav_indicators();
+static void apply_status_bar(const StatusBarRef &ref, const StatusState &st, uint8_t changed);
+static void stats_subscribe(bool force);
+
+// ============================================================
+//  Status helpers
+// ============================================================
+
+// lv_label_set_text relayouts and invalidates even for identical text
+static void label_set_text_if_changed(lv_obj_t *lbl, const char *text) {
+    if (strcmp(lv_label_get_text(lbl), text) != 0) lv_label_set_text(lbl, text);
+}
+
+// "HH:MM" or "H:MMa/p" per display settings, "--:--" before the first time sync
+static void format_clock(char *buf, size_t size, const StatusState &st) {
+    if (!st.time_synced) {
+        snprintf(buf, size, "--:--");
+        return;
+    }
+    int hour = st.minute / 60;
+    int minute = st.minute % 60;
+    bool use_24h = g_active_config ? g_active_config->display_settings.clock_24h : true;
+    if (use_24h) {
+        snprintf(buf, size, "%02d:%02d", hour, minute);
+    } else {
+        int hour12 = hour % 12;
+        if (hour12 == 0) hour12 = 12;
+        snprintf(buf, size, "%d:%02d%s", hour12, minute, hour >= 12 ? "p" : "a");
+    }
+}
+
+static uint32_t rssi_color(uint8_t bucket) {
+    switch (bucket) {
+        case RSSI_GOOD: return CLR_GREEN;
+        case RSSI_FAIR: return CLR_YELLOW;
+        case RSSI_WEAK: return CLR_RED;
+        default:        return CLR_GREY;
+    }
+}
+
+// "<gauge> 45% 3h": runtime only while discharging, hours above an hour
+static void format_battery(char *buf, size_t size, const StatusState &st) {
+    if (st.battery_pct > 100) {
+        buf[0] = '\0';
+        return;
+    }
+    const char *symbol = st.runtime_min == 0 ? LV_SYMBOL_CHARGE
+                       : st.battery_pct > 75 ? LV_SYMBOL_BATTERY_FULL
+                       : st.battery_pct > 50 ? LV_SYMBOL_BATTERY_3
+                       : st.battery_pct > 25 ? LV_SYMBOL_BATTERY_2
+                       : st.battery_pct > 10 ? LV_SYMBOL_BATTERY_1
+                       : LV_SYMBOL_BATTERY_EMPTY;
+    if (st.runtime_min == 0) {
+        snprintf(buf, size, "%s %u%%", symbol, st.battery_pct);
+    } else if (st.runtime_min >= 60) {
+        snprintf(buf, size, "%s %u%% %uh", symbol, st.battery_pct, st.runtime_min / 60);
+    } else {
+        snprintf(buf, size, "%s %u%% %um", symbol, st.battery_pct, st.runtime_min);
+    }
+}
+
+static uint32_t battery_color(uint8_t policy) {
+    switch (policy) {
+        case POLICY_CRITICAL: return CLR_RED;
+        case POLICY_SAVER:    return CLR_YELLOW;
+        default:              return CLR_GREY;
+    }
+}
+
+// ============================================================
+//  Shared widget styles
+//
+// Hotkey buttons and their labels take shared lv_style_t objects instead of
+// lv_obj_set_style_* local styles: a local style is a per-object allocation
+// holding its own copy of every property, and each one is another entry
+// walked on every style lookup while drawing. The cache makes one style per
+// distinct colour / font combination; entries live for the session (one per
+// combination seen in any config loaded since boot, a few dozen at most).
+// std::deque: push_back never moves existing entries, LVGL holds pointers.
+// ============================================================
+struct ButtonStyleEntry {
+    uint32_t bg_color;       // 0 = transparent, no shadow
+    uint32_t pressed_color;  // Resolved (darkened default or configured)
+    lv_style_t main;
+    lv_style_t pressed;
+};
+
+struct TextStyleEntry {
+    uint32_t color;
+    const lv_font_t *font;
+    lv_style_t style;
+};
+
+static std::deque<ButtonStyleEntry> button_styles;
+static std::deque<TextStyleEntry> text_styles;
+static lv_style_t button_base_style;          // Geometry + flex, all buttons
+static lv_style_t button_base_pressed_style;  // Press squish, all buttons
+static lv_style_t button_baked_style;         // Baked buttons: no live bg/shadow (button_skin.h)
+static bool button_base_ready = false;
+
+static void init_button_base_styles() {
+    lv_style_init(&button_base_style);
+    lv_style_set_radius(&button_base_style, BUTTON_RADIUS);
+    lv_style_set_border_width(&button_base_style, 0);
+    lv_style_set_pad_all(&button_base_style, 8);
+    lv_style_set_layout(&button_base_style, LV_LAYOUT_FLEX);
+    lv_style_set_flex_flow(&button_base_style, LV_FLEX_FLOW_COLUMN);
+    lv_style_set_flex_main_place(&button_base_style, LV_FLEX_ALIGN_CENTER);
+    lv_style_set_flex_cross_place(&button_base_style, LV_FLEX_ALIGN_CENTER);
+    lv_style_set_flex_track_place(&button_base_style, LV_FLEX_ALIGN_CENTER);
+
+    lv_style_init(&button_base_pressed_style);
+    lv_style_set_bg_opa(&button_base_pressed_style, LV_OPA_COVER);
+    lv_style_set_transform_width(&button_base_pressed_style, -BUTTON_PRESS_INSET);
+    lv_style_set_transform_height(&button_base_pressed_style, -BUTTON_PRESS_INSET);
+
+    lv_style_init(&button_baked_style);
+    lv_style_set_bg_opa(&button_baked_style, LV_OPA_TRANSP);
+    lv_style_set_shadow_width(&button_baked_style, 0);
+    button_base_ready = true;
+}
+
+static ButtonStyleEntry &button_style(uint32_t bg_color, uint32_t pressed_color) {
+    for (auto &e : button_styles) {
+        if (e.bg_color == bg_color && e.pressed_color == pressed_color) return e;
+    }
+    ButtonStyleEntry &e = button_styles.emplace_back();
+    e.bg_color = bg_color;
+    e.pressed_color = pressed_color;
+
+    // Normal: bg_color controls the fill (0 = transparent, flat)
+    lv_style_init(&e.main);
+    if (bg_color) {
+        lv_style_set_bg_color(&e.main, lv_color_hex(bg_color));
+        lv_style_set_bg_opa(&e.main, LV_OPA_COVER);
+        lv_style_set_shadow_width(&e.main, BUTTON_SHADOW_W);
+        lv_style_set_shadow_ofs_y(&e.main, BUTTON_SHADOW_OFS_Y);
+        lv_style_set_shadow_opa(&e.main, BUTTON_SHADOW_OPA);
+    } else {
+        lv_style_set_bg_opa(&e.main, LV_OPA_TRANSP);
+        lv_style_set_shadow_width(&e.main, 0);
+    }
+
+    lv_style_init(&e.pressed);
+    lv_style_set_bg_color(&e.pressed, lv_color_hex(pressed_color));
+    return e;
+}
+
+static lv_style_t *text_style(uint32_t color, const lv_font_t *font) {
+    for (auto &e : text_styles) {
+        if (e.color == color && e.font == font) return &e.style;
+    }
+    TextStyleEntry &e = text_styles.emplace_back();
+    e.color = color;
+    e.font = font;
+    lv_style_init(&e.style);
+    lv_style_set_text_color(&e.style, lv_color_hex(color));
+    lv_style_set_text_font(&e.style, font);
+    return &e.style;
+}
+
+static void add_text_style(lv_obj_t *obj, uint32_t color, const lv_font_t *font) {
+    lv_obj_add_style(obj, text_style(color, font), LV_PART_MAIN);
+}
 
 // ============================================================
 //  Stat helpers
@@ -142,254 +611,101 @@ static const char *get_stat_name(uint8_t type) {
     }
 }
 
-static void format_stat_value(lv_obj_t *lbl, uint8_t type, uint16_t value) {
-    const char *name = get_stat_name(type);
-    switch (type) {
-        case STAT_CPU_PERCENT: case STAT_RAM_PERCENT: case STAT_GPU_PERCENT:
-        case STAT_DISK_PERCENT: case STAT_SWAP_PERCENT: case STAT_BATTERY_PCT:
-        case STAT_GPU_MEM_PCT:
-            if ((value & 0xFF) == 0xFF) lv_label_set_text_fmt(lbl, "%s N/A", name);
-            else lv_label_set_text_fmt(lbl, "%s %d%%", name, value & 0xFF);
-            break;
-        case STAT_CPU_TEMP: case STAT_GPU_TEMP:
-            if ((value & 0xFF) == 0xFF) lv_label_set_text_fmt(lbl, "%s N/A", name);
-            else lv_label_set_text_fmt(lbl, "%s %d\xC2\xB0""C", name, value & 0xFF);
-            break;
-        case STAT_NET_UP: case STAT_NET_DOWN:
-            if (value >= 1024) lv_label_set_text_fmt(lbl, "%s %.1f MB/s", name, value / 1024.0f);
-            else lv_label_set_text_fmt(lbl, "%s %d KB/s", name, value);
-            break;
-        case STAT_CPU_FREQ: case STAT_GPU_FREQ:
-            lv_label_set_text_fmt(lbl, "%s %d MHz", name, value); break;
-        case STAT_UPTIME_HOURS: case STAT_DISPLAY_UPTIME:
-            lv_label_set_text_fmt(lbl, "%s %dh", name, value); break;
-        case STAT_FAN_RPM: case STAT_PROC_COUNT:
-        case STAT_PROC_USER: case STAT_PROC_SYSTEM:
-            lv_label_set_text_fmt(lbl, "%s %d", name, value); break;
-        case STAT_LOAD_AVG:
-            lv_label_set_text_fmt(lbl, "%s %.2f", name, value / 100.0f); break;
-        case STAT_GPU_POWER_W:
-            lv_label_set_text_fmt(lbl, "%s %dW", name, value); break;
-        case STAT_DISK_READ_KBS: case STAT_DISK_WRITE_KBS:
-            if (value >= 1024) lv_label_set_text_fmt(lbl, "%s %.1f MB/s", name, value / 1024.0f);
-            else lv_label_set_text_fmt(lbl, "%s %d KB/s", name, value);
-            break;
-        default:
-            lv_label_set_text_fmt(lbl, "? %d", value); break;
-    }
-}
-
-static const char *get_stat_placeholder(uint8_t type) {
-    switch (type) {
-        case STAT_CPU_PERCENT:    return "CPU --%";
-        case STAT_RAM_PERCENT:    return "RAM --%";
-        case STAT_GPU_PERCENT:    return "GPU --%";
-        case STAT_CPU_TEMP:       return "CPU --\xC2\xB0""C";
-        case STAT_GPU_TEMP:       return "GPU --\xC2\xB0""C";
-        case STAT_DISK_PERCENT:   return "Disk --%";
-        case STAT_NET_UP:         return LV_SYMBOL_UPLOAD " -- KB/s";
-        case STAT_NET_DOWN:       return LV_SYMBOL_DOWNLOAD " -- KB/s";
-        case STAT_CPU_FREQ:       return "CPU -- MHz";
-        case STAT_GPU_FREQ:       return "GPU -- MHz";
-        case STAT_SWAP_PERCENT:   return "Swap --%";
-        case STAT_UPTIME_HOURS:   return "Up --h";
-        case STAT_BATTERY_PCT:    return "Bat --%";
-        case STAT_FAN_RPM:        return "Fan --";
-        case STAT_LOAD_AVG:       return "Load --";
-        case STAT_PROC_COUNT:     return "Proc --";
-        case STAT_GPU_MEM_PCT:    return "VRAM --%";
-        case STAT_GPU_POWER_W:    return "GPU --W";
-        case STAT_DISK_READ_KBS:  return LV_SYMBOL_DOWNLOAD " R -- KB/s";
-        case STAT_DISK_WRITE_KBS: return LV_SYMBOL_UPLOAD " W -- KB/s";
-        case STAT_DISPLAY_UPTIME: return "Disp --h";
-        case STAT_PROC_USER:      return "User --";
-        case STAT_PROC_SYSTEM:    return "Sys --";
-        default:                  return "---";
-    }
-}
-
 // ============================================================
 //  Widget Renderers — one per widget type
 // ============================================================
 
-// --- Button Event Data (identity-based: page + widget index + action data) ---
-struct ButtonEventData {
-    uint8_t page_idx;
-    uint8_t widget_idx;
-    uint8_t action_type;
-    uint8_t keycode;       // For PAGE_GOTO target page, or HOTKEY keycode
-    uint8_t modifiers;     // For ACTION_HOTKEY modifier mask
-    uint16_t consumer_code; // For ACTION_MEDIA_KEY consumer control code
-    uint8_t ddc_vcp_code;  // For ACTION_DDC
-    uint16_t ddc_value;
-    int16_t ddc_adjustment;
-    uint8_t ddc_display;
-};
-static ButtonEventData btn_event_data[CONFIG_MAX_WIDGETS * CONFIG_MAX_PAGES];
-static int btn_event_count = 0;
-
 // --- Hotkey Button ---
-static void btn_event_cb(lv_event_t *e) {
-    lv_event_code_t code = lv_event_get_code(e);
-    if (code == LV_EVENT_CLICKED) {
-        const ButtonEventData *bed = (const ButtonEventData *)lv_event_get_user_data(e);
-        if (!bed) return;
-
-        // Display-local actions are handled here without sending to bridge
-        switch (bed->action_type) {
-            case ACTION_DISPLAY_SETTINGS:
-                Serial.println("Button: toggle config AP mode");
-                if (!config_server_active()) {
-                    if (config_server_start()) show_config_screen();
-                } else {
-                    config_server_stop();
-                    hide_config_screen();
-                }
-                return;
-            case ACTION_DISPLAY_CLOCK:
-                Serial.println("Button: switch to clock mode");
-                display_set_mode(MODE_CLOCK);
-                return;
-            case ACTION_DISPLAY_PICTURE:
-                Serial.println("Button: switch to picture frame mode");
-                display_set_mode(MODE_PICTURE_FRAME);
-                return;
-            case ACTION_PAGE_NEXT:
-                Serial.println("Button: next page");
-                ui_next_page();
-                return;
-            case ACTION_PAGE_PREV:
-                Serial.println("Button: prev page");
-                ui_prev_page();
-                return;
-            case ACTION_PAGE_GOTO:
-                Serial.printf("Button: goto page %d\n", bed->keycode);
-                ui_goto_page(bed->keycode);
-                return;
-            case ACTION_MODE_CYCLE:
-                Serial.println("Button: mode cycle");
-                mode_cycle_next(get_global_config().mode_cycle.enabled_modes);
-                return;
-            case ACTION_BRIGHTNESS:
-                Serial.println("Button: brightness cycle");
-                power_cycle_brightness();
-                return;
-            case ACTION_CONFIG_MODE:
-                Serial.println("Button: enter config mode");
-                if (!config_server_active()) {
-                    if (config_server_start()) show_config_screen();
-                } else {
-                    config_server_stop();
-                    hide_config_screen();
-                }
-                return;
-            default:
-                break;
-        }
+// Contacts counted by the touch-down hook (input task); the last one whose
+// press already ran a fire-on-press action, by either path (UI task)
+static volatile uint16_t hit_contact = 0;
+static uint16_t fired_contact = 0;
+static volatile int hit_page = -1;   // current_page, for the input task
+
+// Run a realized page's button action from its ActionTable
+static bool run_widget_action(int page, int widget) {
+    if (page < 0 || page >= (int)pages.size() || widget < 0) return false;
+    ActionDesc a;
+    if (!action_table_get(pages[page].actions, (uint8_t)widget, a)) return false;
+    action_run(a);
+    return true;
+}
 
-        // Route based on action type:
-        // - HID actions (hotkey, media key) go directly through bridge USB HID
-        // - Companion actions (launch app, shell cmd, open URL) go via button identity
-        switch (bed->action_type) {
-            case ACTION_HOTKEY:
-                send_hotkey_to_bridge(bed->modifiers, bed->keycode);
-                Serial.printf("Hotkey: mod=0x%02X key=0x%02X\n", bed->modifiers, bed->keycode);
-                break;
-            case ACTION_MEDIA_KEY:
-                send_media_key_to_bridge(bed->consumer_code);
-                Serial.printf("Media key: 0x%04X\n", bed->consumer_code);
-                break;
-            case ACTION_DDC: {
-                DdcCmdMsg ddc;
-                ddc.vcp_code = bed->ddc_vcp_code;
-                ddc.value = bed->ddc_value;
-                ddc.adjustment = bed->ddc_adjustment;
-                ddc.display_num = bed->ddc_display;
-                espnow_send(MSG_DDC_CMD, (const uint8_t *)&ddc, sizeof(ddc));
-                Serial.printf("DDC cmd: vcp=0x%02X val=%d adj=%d disp=%d\n",
-                              ddc.vcp_code, ddc.value, ddc.adjustment, ddc.display_num);
-                break;
-            }
-            default:
-                // Companion-handled actions: send button identity for lookup
-                send_button_press_to_bridge(bed->page_idx, bed->widget_idx);
-                Serial.printf("Button press: page=%d widget=%d action=%d\n",
-                              bed->page_idx, bed->widget_idx, bed->action_type);
-                break;
-        }
+static void btn_event_cb(lv_event_t *e) {
+    uint8_t page, widget;
+    if (!action_ref_decode(lv_event_get_user_data(e), page, widget)) return;
+    if (lv_event_get_code(e) == LV_EVENT_PRESSED) {
+        // Fire-on-press button: the hit grid normally got here first
+        uint16_t contact = hit_contact;
+        if (fired_contact == contact) return;
+        fired_contact = contact;
     }
+    run_widget_action(page, widget);
 }
 
 static void render_hotkey_button(lv_obj_t *parent, const WidgetConfig *cfg, uint8_t page_idx, uint8_t widget_idx) {
     lv_obj_t *btn = lv_btn_create(parent);
     lv_obj_set_pos(btn, cfg->x, cfg->y);
     lv_obj_set_size(btn, cfg->width, cfg->height);
-    // Store button identity + action data in static pool for event callback
-    ButtonEventData *bed = nullptr;
-    if (btn_event_count < CONFIG_MAX_WIDGETS * CONFIG_MAX_PAGES) {
-        btn_event_data[btn_event_count] = {
-            page_idx, widget_idx, (uint8_t)cfg->action_type,
-            cfg->keycode, cfg->modifiers, cfg->consumer_code,
-            cfg->ddc_vcp_code, cfg->ddc_value, cfg->ddc_adjustment, cfg->ddc_display
-        };
-        bed = &btn_event_data[btn_event_count++];
-    }
-    lv_obj_add_event_cb(btn, btn_event_cb, LV_EVENT_CLICKED, (void *)bed);
-
-    // Normal style: bg_color controls button fill (0 = transparent)
-    if (cfg->bg_color) {
-        lv_obj_set_style_bg_color(btn, lv_color_hex(cfg->bg_color), LV_PART_MAIN);
-        lv_obj_set_style_bg_opa(btn, LV_OPA_COVER, LV_PART_MAIN);
-        lv_obj_set_style_shadow_width(btn, 8, LV_PART_MAIN);
-        lv_obj_set_style_shadow_ofs_y(btn, 4, LV_PART_MAIN);
-        lv_obj_set_style_shadow_opa(btn, LV_OPA_30, LV_PART_MAIN);
-    } else {
-        lv_obj_set_style_bg_opa(btn, LV_OPA_TRANSP, LV_PART_MAIN);
-        lv_obj_set_style_shadow_width(btn, 0, LV_PART_MAIN);
-    }
-    lv_obj_set_style_radius(btn, 12, LV_PART_MAIN);
-    lv_obj_set_style_border_width(btn, 0, LV_PART_MAIN);
+    // The action itself is looked up in the page's ActionTable
+    lv_obj_add_event_cb(btn, btn_event_cb, cfg->fire_on_press ? LV_EVENT_PRESSED : LV_EVENT_CLICKED,
+                        action_ref(page_idx, widget_idx));
 
-    // Pressed style
-    lv_color_t pressed_clr;
-    if (cfg->pressed_color == 0x000000) {
+    // Shared styles: geometry + column flex, then fill and pressed colours
+    uint32_t pressed_rgb = cfg->pressed_color;
+    if (pressed_rgb == 0x000000) {
         lv_color_t base = cfg->bg_color ? lv_color_hex(cfg->bg_color) : lv_color_hex(0x333333);
-        pressed_clr = lv_color_darken(base, LV_OPA_30);
-    } else {
-        pressed_clr = lv_color_hex(cfg->pressed_color);
+        pressed_rgb = lv_color_to32(lv_color_darken(base, LV_OPA_30)) & 0xFFFFFF;
+    }
+    if (!button_base_ready) init_button_base_styles();
+    lv_obj_add_style(btn, &button_base_style, LV_PART_MAIN);
+#if UI_BAKED_BUTTONS
+    // Filled buttons blit a pre-rendered background + shadow instead
+    if (cfg->bg_color && button_skin_attach(btn, cfg->width, cfg->height, cfg->bg_color, pressed_rgb)) {
+        lv_obj_add_style(btn, &button_baked_style, LV_PART_MAIN);
+    } else
+#endif
+    {
+        ButtonStyleEntry &styles = button_style(cfg->bg_color, pressed_rgb);
+        lv_obj_add_style(btn, &styles.main, LV_PART_MAIN);
+        lv_obj_add_style(btn, &button_base_pressed_style, LV_STATE_PRESSED);
+        lv_obj_add_style(btn, &styles.pressed, LV_STATE_PRESSED);
     }
-    lv_obj_set_style_bg_color(btn, pressed_clr, LV_STATE_PRESSED);
-    lv_obj_set_style_bg_opa(btn, LV_OPA_COVER, LV_STATE_PRESSED);
-    lv_obj_set_style_transform_width(btn, -3, LV_STATE_PRESSED);
-    lv_obj_set_style_transform_height(btn, -3, LV_STATE_PRESSED);
-
-    // Column flex layout
-    lv_obj_set_flex_flow(btn, LV_FLEX_FLOW_COLUMN);
-    lv_obj_set_flex_align(btn, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
-    lv_obj_set_style_pad_all(btn, 8, LV_PART_MAIN);
 
     // Determine if label/description will be shown (affects icon sizing)
     bool has_label = cfg->show_label && !cfg->label.empty();
     bool has_desc = cfg->show_description && !cfg->description.empty();
     bool icon_only = !has_label && !has_desc;
 
-    // Icon: image from SD card takes priority over symbol
+    // Icon: image from SD card takes priority over symbol. Pre-scaled from
+    // the icon cache; the zoomed-source path is only for formats it can't take.
     bool icon_rendered = false;
     if (!cfg->icon_path.empty()) {
-        std::string img_src = "S:" + cfg->icon_path;
-        // Verify image file exists before creating widget
-        if (SD.exists(cfg->icon_path.c_str())) {
+        // Scale image to fit button area — larger when icon-only
+        lv_coord_t max_icon_w, max_icon_h;
+        if (icon_only) {
+            max_icon_w = cfg->width * 8 / 10;
+            max_icon_h = cfg->height * 8 / 10;
+        } else {
+            max_icon_w = cfg->width * 6 / 10;
+            max_icon_h = cfg->height * 4 / 10;
+        }
+        lv_coord_t fit_w = max_icon_w > 0 ? max_icon_w : 1, fit_h = max_icon_h > 0 ? max_icon_h : 1;
+        const lv_img_dsc_t *cached = nullptr;
+        if (anim_icon_matches(cfg->icon_path.c_str())) {
+            // GIF: frames advanced by anim_icon_update() on the shared decode budget
+            icon_rendered = anim_icon_create(btn, cfg->icon_path.c_str(), fit_w, fit_h) != nullptr;
+        } else if ((cached = icon_cache_acquire(cfg->icon_path.c_str(), fit_w, fit_h))) {
+            lv_obj_t *img = lv_img_create(btn);
+            lv_img_set_src(img, cached);
+            lv_obj_add_event_cb(img, [](lv_event_t *e) {
+                icon_cache_release((const lv_img_dsc_t *)lv_event_get_user_data(e));
+            }, LV_EVENT_DELETE, (void *)cached);
+            icon_rendered = true;
+        } else if (SD.exists(cfg->icon_path.c_str())) {
+            std::string img_src = std::string("S:") + cfg->icon_path.c_str();
             lv_obj_t *img = lv_img_create(btn);
             lv_img_set_src(img, img_src.c_str());
-            // Scale image to fit button area — larger when icon-only
-            lv_coord_t max_icon_w, max_icon_h;
-            if (icon_only) {
-                max_icon_w = cfg->width * 8 / 10;
-                max_icon_h = cfg->height * 8 / 10;
-            } else {
-                max_icon_w = cfg->width * 6 / 10;
-                max_icon_h = cfg->height * 4 / 10;
-            }
             lv_img_header_t header;
             if (lv_img_decoder_get_info(img_src.c_str(), &header) == LV_RES_OK && header.w > 0 && header.h > 0) {
                 uint16_t zoom_w = (uint16_t)((uint32_t)max_icon_w * 256 / header.w);
@@ -414,58 +730,60 @@ static void render_hotkey_button(lv_obj_t *parent, const WidgetConfig *cfg, uint
         else if (icon_area >= 50)  icon_font = &lv_font_montserrat_22;
         else if (icon_area >= 40)  icon_font = &lv_font_montserrat_20;
         else                       icon_font = &lv_font_montserrat_16;
-        lv_obj_set_style_text_font(icon, icon_font, LV_PART_MAIN);
-        lv_obj_set_style_text_color(icon, lv_color_hex(cfg->color), LV_PART_MAIN);
+        add_text_style(icon, cfg->color, icon_font);
     }
 
     // Label
     if (cfg->show_label && !cfg->label.empty()) {
         lv_obj_t *label = lv_label_create(btn);
         lv_label_set_text(label, cfg->label.c_str());
-        lv_obj_set_style_text_font(label, &lv_font_montserrat_16, LV_PART_MAIN);
-        lv_obj_set_style_text_color(label, lv_color_hex(cfg->color), LV_PART_MAIN);
+        add_text_style(label, cfg->color, &lv_font_montserrat_16);
     }
 
     // Description
     if (cfg->show_description && !cfg->description.empty()) {
         lv_obj_t *sub = lv_label_create(btn);
         lv_label_set_text(sub, cfg->description.c_str());
-        lv_obj_set_style_text_font(sub, &lv_font_montserrat_12, LV_PART_MAIN);
-        lv_obj_set_style_text_color(sub, lv_color_hex(cfg->color), LV_PART_MAIN);
+        add_text_style(sub, cfg->color, &lv_font_montserrat_12);
     }
 }
 
-// Format just the value part (no name prefix) for split-label mode
-static void format_stat_value_only(lv_obj_t *lbl, uint8_t type, uint16_t value) {
+// Value text without the name (that is a label of its own)
+static void format_stat_value(char *buf, size_t size, uint8_t type, int32_t value) {
+    if (value == STAT_NA) {
+        snprintf(buf, size, "N/A");
+        return;
+    }
+    long v = value;
     switch (type) {
         case STAT_CPU_PERCENT: case STAT_RAM_PERCENT: case STAT_GPU_PERCENT:
         case STAT_DISK_PERCENT: case STAT_SWAP_PERCENT: case STAT_BATTERY_PCT:
         case STAT_GPU_MEM_PCT:
-            if ((value & 0xFF) == 0xFF) lv_label_set_text(lbl, "N/A");
-            else lv_label_set_text_fmt(lbl, "%d%%", value & 0xFF);
-            break;
+            snprintf(buf, size, "%ld%%", v); break;
         case STAT_CPU_TEMP: case STAT_GPU_TEMP:
-            if ((value & 0xFF) == 0xFF) lv_label_set_text(lbl, "N/A");
-            else lv_label_set_text_fmt(lbl, "%d\xC2\xB0""C", value & 0xFF);
+            // Whole degrees read as before; a sensor with decimals gets one
+            if (v % 10) snprintf(buf, size, "%.1f\xC2\xB0""C", v / 10.0f);
+            else snprintf(buf, size, "%ld\xC2\xB0""C", v / 10);
             break;
         case STAT_NET_UP: case STAT_NET_DOWN:
         case STAT_DISK_READ_KBS: case STAT_DISK_WRITE_KBS:
-            if (value >= 1024) lv_label_set_text_fmt(lbl, "%.1f MB/s", value / 1024.0f);
-            else lv_label_set_text_fmt(lbl, "%d KB/s", value);
+            if (v >= 1024L * 1024) snprintf(buf, size, "%.1f GB/s", v / (1024.0f * 1024.0f));
+            else if (v >= 1024) snprintf(buf, size, "%.1f MB/s", v / 1024.0f);
+            else snprintf(buf, size, "%ld KB/s", v);
             break;
         case STAT_CPU_FREQ: case STAT_GPU_FREQ:
-            lv_label_set_text_fmt(lbl, "%d MHz", value); break;
+            snprintf(buf, size, "%ld MHz", v); break;
         case STAT_UPTIME_HOURS: case STAT_DISPLAY_UPTIME:
-            lv_label_set_text_fmt(lbl, "%dh", value); break;
+            snprintf(buf, size, "%ldh", v); break;
         case STAT_FAN_RPM: case STAT_PROC_COUNT:
         case STAT_PROC_USER: case STAT_PROC_SYSTEM:
-            lv_label_set_text_fmt(lbl, "%d", value); break;
+            snprintf(buf, size, "%ld", v); break;
         case STAT_LOAD_AVG:
-            lv_label_set_text_fmt(lbl, "%.2f", value / 100.0f); break;
+            snprintf(buf, size, "%.2f", v / 100.0f); break;
         case STAT_GPU_POWER_W:
-            lv_label_set_text_fmt(lbl, "%dW", value); break;
+            snprintf(buf, size, "%ldW", v); break;
         default:
-            lv_label_set_text_fmt(lbl, "%d", value); break;
+            snprintf(buf, size, "%ld", v); break;
     }
 }
 
@@ -487,139 +805,770 @@ static const char *get_stat_value_placeholder(uint8_t type) {
     }
 }
 
-// --- Stat Monitor ---
-static void render_stat_monitor(lv_obj_t *parent, const WidgetConfig *cfg) {
-    lv_obj_t *container = lv_obj_create(parent);
-    lv_obj_set_pos(container, cfg->x, cfg->y);
-    lv_obj_set_size(container, cfg->width, cfg->height);
-    lv_obj_set_style_bg_color(container, cfg->bg_color ? lv_color_hex(cfg->bg_color) : lv_color_hex(0x0d1b2a), LV_PART_MAIN);
-    lv_obj_set_style_bg_opa(container, LV_OPA_COVER, LV_PART_MAIN);
-    lv_obj_set_style_border_width(container, 0, LV_PART_MAIN);
-    lv_obj_set_style_radius(container, 6, LV_PART_MAIN);
-    lv_obj_clear_flag(container, LV_OBJ_FLAG_SCROLLABLE);
+// Widest text format_stat_value() can produce for a type ('8' stands in for
+// any digit), which sizes the value label once
+static const char *stat_value_template(uint8_t type) {
+    switch (type) {
+        case STAT_CPU_PERCENT: case STAT_RAM_PERCENT: case STAT_GPU_PERCENT:
+        case STAT_DISK_PERCENT: case STAT_SWAP_PERCENT: case STAT_BATTERY_PCT:
+        case STAT_GPU_MEM_PCT: return "188%";
+        case STAT_CPU_TEMP: case STAT_GPU_TEMP: return "288.8\xC2\xB0""C";
+        case STAT_NET_UP: case STAT_NET_DOWN:
+        case STAT_DISK_READ_KBS: case STAT_DISK_WRITE_KBS: return "8888 KB/s";
+        case STAT_CPU_FREQ: case STAT_GPU_FREQ: return "88888 MHz";
+        case STAT_UPTIME_HOURS: case STAT_DISPLAY_UPTIME: return "88888h";
+        case STAT_LOAD_AVG: return "888.88";
+        case STAT_GPU_POWER_W: return "88888W";
+        default: return "88888";
+    }
+}
 
-    if (cfg->value_position == 0) {
-        // Inline mode: single centered label with "Name Value"
-        lv_obj_t *lbl = lv_label_create(container);
-        lv_label_set_text(lbl, get_stat_placeholder(cfg->stat_type));
-        lv_obj_set_style_text_font(lbl, &lv_font_montserrat_14, LV_PART_MAIN);
-        lv_obj_set_style_text_color(lbl, lv_color_hex(cfg->color), LV_PART_MAIN);
-        lv_obj_center(lbl);
-        stat_widget_refs.push_back({lbl, nullptr, cfg->stat_type, 0});
+static lv_coord_t text_width(const char *text, const lv_font_t *font) {
+    lv_point_t size;
+    lv_txt_get_size(&size, text, font, 0, 0, LV_COORD_MAX, LV_TEXT_FLAG_NONE);
+    return size.x;
+}
+
+// Value label with a fixed width: a new value redraws that box and nothing
+// else (a content-sized label would also invalidate its old and new extent
+// and move its flex/aligned neighbours)
+static lv_obj_t *create_stat_value_label(lv_obj_t *parent, uint8_t type, const lv_font_t *font,
+                                         uint32_t color, lv_text_align_t align) {
+    lv_obj_t *lbl = lv_label_create(parent);
+    lv_obj_set_style_text_font(lbl, font, LV_PART_MAIN);
+    lv_obj_set_style_text_color(lbl, lv_color_hex(color), LV_PART_MAIN);
+    lv_obj_set_style_text_align(lbl, align, LV_PART_MAIN);
+    lv_label_set_long_mode(lbl, LV_LABEL_LONG_CLIP);
+    lv_obj_set_width(lbl, text_width(stat_value_template(type), font) + 2);
+    lv_label_set_text(lbl, get_stat_value_placeholder(type));
+    return lbl;
+}
+
+// "Name Value" on one line as two labels, the pair aligned to `align`
+// (LV_ALIGN_CENTER or LV_ALIGN_TOP_LEFT) as the single label used to be
+static void create_inline_stat(lv_obj_t *parent, uint8_t type, const lv_font_t *font, uint32_t color,
+                               lv_align_t align, uint8_t page_idx) {
+    const char *name = get_stat_name(type);
+    lv_obj_t *name_lbl = lv_label_create(parent);
+    lv_label_set_text(name_lbl, name);
+    lv_obj_set_style_text_font(name_lbl, font, LV_PART_MAIN);
+    lv_obj_set_style_text_color(name_lbl, lv_color_hex(color), LV_PART_MAIN);
+    lv_obj_t *value_lbl = create_stat_value_label(parent, type, font, color, LV_TEXT_ALIGN_LEFT);
+
+    lv_coord_t name_w = text_width(name, font);
+    lv_coord_t value_x = name_w + lv_font_get_glyph_width(font, ' ', 0);
+    if (align == LV_ALIGN_CENTER) {
+        lv_coord_t value_w = lv_obj_get_style_width(value_lbl, LV_PART_MAIN);
+        lv_coord_t total = value_x + value_w;
+        lv_obj_align(name_lbl, LV_ALIGN_CENTER, (name_w - total) / 2, 0);
+        lv_obj_align(value_lbl, LV_ALIGN_CENTER, value_x + (value_w - total) / 2, 0);
     } else {
-        // Split mode: two labels stacked vertically
-        lv_obj_set_flex_flow(container, LV_FLEX_FLOW_COLUMN);
-        lv_obj_set_flex_align(container, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
-        lv_obj_set_style_pad_all(container, 2, LV_PART_MAIN);
+        lv_obj_align(name_lbl, align, 0, 0);
+        lv_obj_align(value_lbl, align, value_x, 0);
+    }
+    stat_widget_refs.push_back({value_lbl, name_lbl, type, page_idx});
+}
+
+static void show_stat_ref(StatWidgetRef &ref, int32_t value) {
+    // Unchanged value: skip the relayout + invalidate lv_label_set_text costs
+    if (ref.has_value && ref.last_value == value) return;
+    ref.has_value = true;
+    ref.last_value = value;
+    char text[16];
+    format_stat_value(text, sizeof(text), ref.stat_type, value);
+    // Different values can read the same ("1.0 MB/s"): leave the label alone
+    if (strcmp(lv_label_get_text(ref.label), text) == 0) return;
+    lv_label_set_text(ref.label, text);
+    perf_record_stat_update();
+}
 
-        lv_obj_t *top_lbl = lv_label_create(container);
-        lv_obj_t *bot_lbl = lv_label_create(container);
+// Straight to `value`, dropping any count in progress
+static void set_stat_ref(StatWidgetRef &ref, int32_t value) {
+    ref.animating = false;
+    show_stat_ref(ref, value);
+}
 
-        lv_obj_t *value_lbl, *name_lbl;
-        if (cfg->value_position == 1) {
-            // Value on top, name on bottom
-            value_lbl = top_lbl;
-            name_lbl = bot_lbl;
-        } else {
-            // Name on top, value on bottom
-            name_lbl = top_lbl;
-            value_lbl = bot_lbl;
-        }
+// The background host a ref is pinned to, ESPNOW_HOST_NONE if it follows stat_cache
+static uint8_t stat_ref_host(const StatWidgetRef &ref) {
+    return ref.host && ref.host - 1 != stats_host ? ref.host - 1 : ESPNOW_HOST_NONE;
+}
 
-        lv_label_set_text(name_lbl, get_stat_name(cfg->stat_type));
-        lv_obj_set_style_text_font(name_lbl, &lv_font_montserrat_12, LV_PART_MAIN);
-        lv_obj_set_style_text_color(name_lbl, lv_color_hex(cfg->color), LV_PART_MAIN);
+// Latest value for a ref from whichever cache feeds it
+static bool stat_ref_value(const StatWidgetRef &ref, int32_t &value) {
+    if (ref.stat_type > STAT_TYPE_MAX) return false;
+    if (ref.remote) {
+        value = remote_stats[ref.remote - 1].value[ref.stat_type];
+        return remote_stats[ref.remote - 1].valid[ref.stat_type];
+    }
+    uint8_t host = stat_ref_host(ref);
+    if (host == ESPNOW_HOST_NONE) {
+        value = stat_cache[ref.stat_type];
+        return stat_cache_valid[ref.stat_type];
+    }
+    value = host_stats[host].value[ref.stat_type];
+    return host_stats[host].valid[ref.stat_type];
+}
+
+// Back to the placeholder: the value shown belonged to another host
+static void clear_stat_ref(StatWidgetRef &ref) {
+    ref.animating = false;
+    if (!ref.has_value) return;
+    ref.has_value = false;
+    lv_label_set_text(ref.label, get_stat_value_placeholder(ref.stat_type));
+}
 
-        lv_label_set_text(value_lbl, get_stat_value_placeholder(cfg->stat_type));
-        lv_obj_set_style_text_font(value_lbl, &lv_font_montserrat_16, LV_PART_MAIN);
-        lv_obj_set_style_text_color(value_lbl, lv_color_hex(cfg->color), LV_PART_MAIN);
+// --- Stat History ---
 
-        stat_widget_refs.push_back({value_lbl, name_lbl, cfg->stat_type, cfg->value_position});
+// Percentages, temperatures and the like fit a byte (0xFF = N/A on the wire)
+static bool stat_is_wide(uint8_t type) {
+    switch (type) {
+        case STAT_CPU_PERCENT: case STAT_RAM_PERCENT: case STAT_GPU_PERCENT:
+        case STAT_CPU_TEMP: case STAT_GPU_TEMP: case STAT_DISK_PERCENT:
+        case STAT_SWAP_PERCENT: case STAT_BATTERY_PCT: case STAT_GPU_MEM_PCT:
+            return false;
+        default:
+            return true;
     }
+}
 
-    // Display uptime: initialize with current millis-based hours
-    if (cfg->stat_type == STAT_DISPLAY_UPTIME) {
-        uint16_t hours = (uint16_t)(millis() / 3600000UL);
-        if (cfg->value_position == 0) {
-            auto &ref = stat_widget_refs.back();
-            lv_label_set_text_fmt(ref.label, "Disp %dh", hours);
-        } else {
-            auto &ref = stat_widget_refs.back();
-            lv_label_set_text_fmt(ref.label, "%dh", hours);
-        }
+static bool stat_in_tenths(uint8_t type) {
+    return type == STAT_CPU_TEMP || type == STAT_GPU_TEMP;
+}
+
+static bool stat_is_percent(uint8_t type) {
+    switch (type) {
+        case STAT_CPU_PERCENT: case STAT_RAM_PERCENT: case STAT_GPU_PERCENT:
+        case STAT_DISK_PERCENT: case STAT_SWAP_PERCENT: case STAT_BATTERY_PCT:
+        case STAT_GPU_MEM_PCT:
+            return true;
+        default:
+            return false;
     }
 }
 
-// --- Status Bar ---
-static void config_btn_event_cb(lv_event_t *e) {
-    lv_event_code_t code = lv_event_get_code(e);
-    if (code == LV_EVENT_CLICKED) {
-        if (!config_server_active()) {
-            if (config_server_start()) show_config_screen();
-        } else {
-            config_server_stop();
-            hide_config_screen();
+static uint16_t history_gap(const StatHistory &h) {
+    return h.wide ? 0xFFFF : 0xFF;
+}
+
+// i = 0 is the oldest sample
+static uint16_t history_at(const StatHistory &h, uint16_t i) {
+    uint16_t idx = (uint16_t)((h.head + h.capacity - h.count + i) % h.capacity);
+    return h.wide ? ((uint16_t *)h.samples)[idx] : h.samples[idx];
+}
+
+static void history_rescan_peak(StatHistory &h) {
+    h.peak = 0;
+    h.peak_age = 0;
+    uint16_t gap = history_gap(h);
+    for (uint16_t i = 0; i < h.count; i++) {
+        uint16_t v = history_at(h, i);
+        if (v != gap && v >= h.peak) {
+            h.peak = v;
+            h.peak_age = h.count - 1 - i;
         }
     }
 }
 
-static void brightness_event_cb(lv_event_t *e) {
-    if (lv_event_get_code(e) == LV_EVENT_CLICKED) power_cycle_brightness();
+// Grow the ring for `type` to at least `points`, keeping the newest samples
+static bool history_reserve(uint8_t type, uint16_t points) {
+    StatHistory &h = stat_history[type];
+    h.used = true;
+    if (h.samples && h.capacity >= points) return true;
+
+    bool wide = stat_is_wide(type);
+    size_t bytes = (size_t)points * (wide ? 2 : 1);
+    uint8_t *buf = (uint8_t *)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!buf) buf = (uint8_t *)malloc(bytes);
+    if (!buf) {
+        Serial.printf("[ui] Stat history alloc failed (type %d, %u points)\n", type, points);
+        return false;
+    }
+
+    uint16_t keep = h.samples ? h.count : 0;
+    for (uint16_t i = 0; i < keep; i++) {
+        uint16_t v = history_at(h, i);
+        if (wide) ((uint16_t *)buf)[i] = v;
+        else buf[i] = (uint8_t)v;
+    }
+    if (h.samples) heap_caps_free(h.samples);
+    h.samples = buf;
+    h.capacity = points;
+    h.count = keep;
+    h.head = keep % points;
+    h.wide = wide;
+    h.prefilled = false;   // A longer window: its new older part can come from the log
+    history_rescan_peak(h);
+    return true;
 }
 
-static void brightness_long_press_cb(lv_event_t *e) {
-    if (lv_event_get_code(e) == LV_EVENT_LONG_PRESSED) {
-        DisplayMode current = display_get_mode();
-        DisplayMode next = (DisplayMode)((current + 1) % 4);
-        display_set_mode(next);
+// A value of `type` as a history sample: whole units, clamped below the
+// gap marker
+static uint16_t history_value(const StatHistory &h, uint8_t type, int32_t v) {
+    if (v == STAT_NA) return history_gap(h);
+    if (stat_in_tenths(type)) v = (v + 5) / 10;
+    if (v < 0) v = 0;
+    if (v >= history_gap(h)) v = history_gap(h) - 1;
+    return (uint16_t)v;
+}
+
+static uint16_t history_sample(const StatHistory &h, uint8_t type) {
+    return history_value(h, type, stat_cache[type]);
+}
+
+static void history_push(StatHistory &h, uint16_t v) {
+    if (h.wide) ((uint16_t *)h.samples)[h.head] = v;
+    else h.samples[h.head] = (uint8_t)v;
+    h.head = (h.head + 1) % h.capacity;
+    if (h.count < h.capacity) h.count++;
+
+    // Running max: only rescan once the recorded peak has scrolled out,
+    // so the cost per sample stays flat regardless of history length
+    if (v != history_gap(h) && v >= h.peak) {
+        h.peak = v;
+        h.peak_age = 0;
+    } else if (++h.peak_age >= h.capacity) {
+        history_rescan_peak(h);
     }
 }
 
-static void render_status_bar(lv_obj_t *parent, const WidgetConfig *cfg) {
-    lv_obj_t *bar = lv_obj_create(parent);
-    lv_obj_set_pos(bar, cfg->x, cfg->y);
-    lv_obj_set_size(bar, cfg->width, cfg->height);
-    lv_obj_set_style_bg_color(bar, cfg->bg_color ? lv_color_hex(cfg->bg_color) : lv_color_hex(0x16213e), LV_PART_MAIN);
-    lv_obj_set_style_bg_opa(bar, LV_OPA_COVER, LV_PART_MAIN);
-    lv_obj_set_style_border_width(bar, 0, LV_PART_MAIN);
-    lv_obj_set_style_radius(bar, 0, LV_PART_MAIN);
-    lv_obj_clear_flag(bar, LV_OBJ_FLAG_SCROLLABLE);
+static lv_coord_t history_to_coord(const StatHistory &h, uint16_t v) {
+    if (v == history_gap(h)) return LV_CHART_POINT_NONE;
+    return (lv_coord_t)(v > 32767 ? 32767 : v);
+}
 
-    // Title
-    lv_obj_t *title = lv_label_create(bar);
-    lv_label_set_text_fmt(title, LV_SYMBOL_KEYBOARD "  %s", cfg->label.c_str());
-    lv_obj_set_style_text_font(title, &lv_font_montserrat_20, LV_PART_MAIN);
-    lv_obj_set_style_text_color(title, lv_color_hex(cfg->color), LV_PART_MAIN);
-    lv_obj_align(title, LV_ALIGN_LEFT_MID, 15, 0);
+// Series points from the history ring: oldest point at index 0, start
+// index 0, newest at the right edge
+static void chart_backfill(lv_obj_t *chart, lv_chart_series_t *ser, const StatHistory &h) {
+    uint16_t points = lv_chart_get_point_count(chart);
+    lv_coord_t *ys = lv_chart_get_y_array(chart, ser);
+    uint16_t n = h.count < points ? h.count : points;
+    uint16_t pad = points - n;
+    for (uint16_t i = 0; i < pad; i++) ys[i] = LV_CHART_POINT_NONE;
+    for (uint16_t i = 0; i < n; i++) ys[pad + i] = history_to_coord(h, history_at(h, h.count - n + i));
+    lv_chart_set_x_start_point(chart, ser, 0);
+}
 
-    // Dynamic right-to-left icon packing
-    StatusBarRef ref = {};
-    int x_offset = -10;  // start 10px from right edge
-    const int ICON_GAP = cfg->icon_spacing;
-    const int ICON_W = 22;
+// Round up to 1/2/5 x 10^n so the axis doesn't twitch on every new peak
+static uint16_t nice_ceiling(uint16_t v) {
+    uint32_t step = 1;
+    while (step * 10 <= v) step *= 10;
+    uint32_t nice = step;
+    if (nice < v) nice = step * 2;
+    if (nice < v) nice = step * 5;
+    if (nice < v) nice = step * 10;
+    if (nice < 10) nice = 10;
+    return (uint16_t)(nice > 32767 ? 32767 : nice);
+}
 
-    // WiFi indicator
-    if (cfg->show_wifi) {
-        ref.rssi_label = lv_label_create(bar);
-        lv_label_set_text(ref.rssi_label, LV_SYMBOL_WIFI);
-        lv_obj_set_style_text_font(ref.rssi_label, &lv_font_montserrat_18, LV_PART_MAIN);
-        lv_obj_set_style_text_color(ref.rssi_label, lv_color_hex(CLR_GREY), LV_PART_MAIN);
-        lv_obj_align(ref.rssi_label, LV_ALIGN_RIGHT_MID, x_offset, 0);
-        x_offset -= (ICON_W + ICON_GAP);
+static void graph_apply_range(StatGraphRef &g) {
+    uint16_t max;
+    if (g.fixed_max) max = g.fixed_max;
+    else if (stat_is_percent(g.stat_type)) max = 100;
+    else max = nice_ceiling(stat_history[g.stat_type].peak);
+    if (max == g.range_max) return;
+    g.range_max = max;
+    lv_chart_set_range(g.chart, LV_CHART_AXIS_PRIMARY_Y, 0, max);
+}
+
+static bool stat_is_live(uint8_t type) {
+    return stat_cache_valid[type] && stat_interval_ms[type] &&
+           stat_interval_ms[type] < STAT_LIVE_INTERVAL_MS &&
+           millis() - stat_cache_ms[type] < STAT_LIVE_INTERVAL_MS * 4;
+}
+
+// Append the latest value of every subscribed stat once its sample period
+// (STAT_GRAPH_SAMPLE_MS, or STAT_GRAPH_LIVE_SAMPLE_MS for live types) is up
+// and shift it into its charts. lv_chart_set_next_value() in SHIFT mode just
+// advances the series' start index, nothing is copied. The timer runs at the
+// live rate only while some graphed stat is live.
+static void stat_graph_timer_cb(lv_timer_t *timer) {
+    uint32_t now = millis();
+    bool pushed[STAT_TYPE_MAX + 1] = {};
+    bool any_live = false;
+    for (uint8_t type = 1; type <= STAT_TYPE_MAX; type++) {
+        StatHistory &h = stat_history[type];
+        if (!h.samples) continue;
+        bool live = stat_is_live(type);
+        any_live |= live;
+        uint32_t period = live ? STAT_GRAPH_LIVE_SAMPLE_MS : STAT_GRAPH_SAMPLE_MS;
+        if (h.count && now - h.sampled_ms + LV_DISP_DEF_REFR_PERIOD < period) continue;
+        h.sampled_ms = now;
+        bool fresh = stat_cache_valid[type] && now - stat_cache_ms[type] < STAT_GRAPH_STALE_MS;
+        history_push(h, fresh ? history_sample(h, type) : history_gap(h));
+        pushed[type] = true;
+    }
+    for (auto &g : stat_graph_refs) {
+        if (!pushed[g.stat_type]) continue;
+        const StatHistory &h = stat_history[g.stat_type];
+        lv_chart_set_next_value(g.chart, g.series, history_to_coord(h, history_at(h, h.count - 1)));
+        graph_apply_range(g);
     }
+    lv_timer_set_period(timer, any_live ? STAT_GRAPH_LIVE_SAMPLE_MS : STAT_GRAPH_SAMPLE_MS);
+}
 
-    // PC connection indicator (USB icon)
-    if (cfg->show_pc) {
-        ref.pc_label = lv_label_create(bar);
-        lv_label_set_text(ref.pc_label, LV_SYMBOL_USB);
-        lv_obj_set_style_text_font(ref.pc_label, &lv_font_montserrat_18, LV_PART_MAIN);
-        lv_obj_set_style_text_color(ref.pc_label, lv_color_hex(CLR_RED), LV_PART_MAIN);
-        lv_obj_align(ref.pc_label, LV_ALIGN_RIGHT_MID, x_offset, 0);
-        x_offset -= (ICON_W + ICON_GAP);
+// ============================================================
+//  Stats log (stats_log.h)
+//
+// stats_log_timer records a frame of the active host's fresh stats every
+// STATS_LOG_INTERVAL_S. Reading it back, a graph ring that starts empty
+// (reboot, new graph, host switch) gets its older part from the log: one
+// sample per STAT_GRAPH_SAMPLE_MS, each logged value held until the next
+// one but never longer than two log intervals.
+// ============================================================
+#if STATS_LOG_ENABLE
+#define STATS_LOG_HOLD_SLOTS (STATS_LOG_INTERVAL_S * 2000 / STAT_GRAPH_SAMPLE_MS)
+
+static lv_timer_t *stats_log_timer = nullptr;
+
+static void stats_log_timer_cb(lv_timer_t *) {
+    if (!status_get().time_synced) return;
+    StatsLogEntry entries[STAT_TYPE_MAX];
+    uint8_t n = 0;
+    uint32_t now = millis();
+    for (uint8_t type = 1; type <= STAT_TYPE_MAX; type++) {
+        if (type == STAT_DISPLAY_UPTIME || !stat_cache_valid[type]) continue;   // The display's own
+        if (now - stat_cache_ms[type] >= STAT_GRAPH_STALE_MS) continue;
+        entries[n].type = type;
+        entries[n].value = stat_cache[type];
+        n++;
     }
+    stats_log_record((uint32_t)time(nullptr), stats_host, entries, n);
+}
 
-    // Config/settings button
-    if (cfg->show_settings) {
+// Per type: the ring's empty older part, slot 0 at base[type]
+struct HistoryFill {
+    std::vector<uint16_t> slots[STAT_TYPE_MAX + 1];   // Empty: type not filled
+    uint32_t base[STAT_TYPE_MAX + 1];
+    int32_t last_slot[STAT_TYPE_MAX + 1];         // Slot of the type's previous value, -1 = none
+};
+
+// Hold the previous value of `type` up to (not including) slot `until`
+static void fill_hold(HistoryFill &f, uint8_t type, int32_t until) {
+    std::vector<uint16_t> &v = f.slots[type];
+    int32_t last = f.last_slot[type];
+    if (last < 0) return;
+    int32_t end = last + 1 + STATS_LOG_HOLD_SLOTS;
+    if (end > until) end = until;
+    if (end > (int32_t)v.size()) end = (int32_t)v.size();
+    for (int32_t k = last + 1; k < end; k++) v[k] = v[last];
+}
+
+static void fill_visit(uint32_t epoch, uint8_t type, int32_t value, void *user) {
+    HistoryFill &f = *(HistoryFill *)user;
+    std::vector<uint16_t> &v = f.slots[type];
+    if (v.empty() || epoch < f.base[type]) return;
+    int32_t k = (int32_t)((uint64_t)(epoch - f.base[type]) * 1000 / STAT_GRAPH_SAMPLE_MS);
+    if (k >= (int32_t)v.size()) return;
+    fill_hold(f, type, k);
+    v[k] = history_value(stat_history[type], type, value);
+    f.last_slot[type] = k;
+}
+
+// Backfill the empty part of every ring not read back yet. Needs the wall
+// clock; until it is set, nothing is marked and this runs again on sync.
+static void history_prefill() {
+    if (!status_get().time_synced) return;
+    uint32_t now = (uint32_t)time(nullptr);
+    uint32_t from = now;
+    HistoryFill f;
+    for (uint8_t type = 1; type <= STAT_TYPE_MAX; type++) {
+        StatHistory &h = stat_history[type];
+        f.last_slot[type] = -1;
+        if (!h.samples || h.prefilled) continue;
+        h.prefilled = true;
+        if (h.count >= h.capacity || stat_is_live(type)) continue;   // Full, or not on a 1 s axis
+        // The ring's window ends now; its live samples are the newest `count` slots
+        f.slots[type].assign(h.capacity - h.count, history_gap(h));
+        f.base[type] = now - (uint32_t)(h.capacity - 1) * STAT_GRAPH_SAMPLE_MS / 1000;
+        if (f.base[type] < from) from = f.base[type];
+    }
+    uint32_t t0 = millis();
+    if (from < now && stats_log_read(stats_host, from, now, fill_visit, &f)) {
+        int filled = 0;
+        for (uint8_t type = 1; type <= STAT_TYPE_MAX; type++) {
+            std::vector<uint16_t> &v = f.slots[type];
+            if (v.empty() || f.last_slot[type] < 0) continue;
+            StatHistory &h = stat_history[type];
+            fill_hold(f, type, (int32_t)v.size());
+            std::vector<uint16_t> live(h.count);
+            for (uint16_t i = 0; i < h.count; i++) live[i] = history_at(h, i);
+            h.count = h.head = 0;
+            h.peak = h.peak_age = 0;
+            for (uint16_t sample : v) history_push(h, sample);
+            for (uint16_t sample : live) history_push(h, sample);
+            filled++;
+            for (auto &g : stat_graph_refs) {
+                if (g.stat_type != type) continue;
+                chart_backfill(g.chart, g.series, h);
+                graph_apply_range(g);
+                lv_chart_refresh(g.chart);
+            }
+        }
+        if (filled) Serial.printf("[ui] %d graph(s) backfilled from the stats log in %lums\n", filled,
+                                  (unsigned long)(millis() - t0));
+    }
+}
+#else
+static void history_prefill() {}
+#endif
+
+// ============================================================
+//  Stat alerts
+//
+// One entry per stat widget with rules in the active profile, built from
+// the config by sync_stat_alerts() whether or not its page is realized, so
+// a toast fires for a page nobody is looking at. A realized widget binds
+// its value label and chart; a rule taking over is a text / series colour
+// swap on those, which redraws their box and never relayouts.
+// ============================================================
+#define STAT_ALERT_BLINK_MS 500
+
+struct StatAlert {
+    uint8_t page_idx;
+    uint8_t widget_idx;
+    uint8_t stat_type;
+    uint8_t rule_count;
+    StatRule rules[STAT_RULES_MAX];
+    uint32_t base_color;         // Widget colour, back when no rule holds
+    uint8_t holding;             // Bit per rule within threshold (+ hysteresis)
+    int8_t shown;                // Rule whose colour is applied, -1 = none
+    char name[24];               // Toast title
+    lv_obj_t *label;             // Value label, while the widget is realized
+    lv_obj_t *chart;
+    lv_chart_series_t *series;
+};
+static std::vector<StatAlert> stat_alerts;
+static std::vector<uint16_t> alert_index[STAT_TYPE_MAX + 1];
+static lv_timer_t *alert_blink_timer = nullptr;
+static bool alert_blink_off = false;
+
+static bool alert_blinking(const StatAlert &a) {
+    return a.shown >= 0 && (a.rules[a.shown].flags & RULE_BLINK);
+}
+
+static void alert_apply(const StatAlert &a) {
+    uint32_t color = a.shown >= 0 && a.rules[a.shown].color ? a.rules[a.shown].color : a.base_color;
+    if (a.label) {
+        lv_obj_set_style_text_color(a.label, lv_color_hex(color), LV_PART_MAIN);
+        bool hide = alert_blinking(a) && alert_blink_off;
+        lv_obj_set_style_text_opa(a.label, hide ? LV_OPA_TRANSP : LV_OPA_COVER, LV_PART_MAIN);
+    }
+    if (a.chart) lv_chart_set_series_color(a.chart, a.series, lv_color_hex(color));
+}
+
+static void alert_blink_cb(lv_timer_t *timer) {
+    alert_blink_off = !alert_blink_off;
+    bool any = false;
+    for (const auto &a : stat_alerts) {
+        if (!alert_blinking(a)) continue;
+        any = true;
+        if (a.label) lv_obj_set_style_text_opa(a.label, alert_blink_off ? LV_OPA_TRANSP : LV_OPA_COVER, LV_PART_MAIN);
+    }
+    if (!any) {
+        alert_blink_off = false;
+        lv_timer_pause(timer);
+    }
+}
+
+static void alert_toast(const StatAlert &a, const StatRule &rule, int32_t value) {
+    int32_t scale = stat_in_tenths(a.stat_type) ? 10 : 1;
+    char now[16], limit[16], summary[48];
+    format_stat_value(now, sizeof(now), a.stat_type, value);
+    format_stat_value(limit, sizeof(limit), a.stat_type, rule.threshold * scale);
+    snprintf(summary, sizeof(summary), "%s %s (%s %s)", get_stat_name(a.stat_type), now,
+             (rule.flags & RULE_BELOW) ? "below" : "above", limit);
+    show_notification_toast(a.name, summary, "", NOTIF_NORMAL);
+}
+
+// Run the rules on a new value (stat_cache units). Rules that start holding
+// toast if asked to and `toast` is set (not when a rebuild re-evaluates).
+static void alert_eval(StatAlert &a, int32_t value, bool toast) {
+    int64_t scale = stat_in_tenths(a.stat_type) ? 10 : 1;
+    uint8_t rising = 0;
+    for (uint8_t r = 0; r < a.rule_count; r++) {
+        const StatRule &rule = a.rules[r];
+        bool was = a.holding & (1 << r);
+        bool holds = false;
+        if (value != STAT_NA) {
+            int64_t t = rule.threshold * scale;
+            int64_t h = was ? rule.hysteresis * scale : 0;
+            holds = (rule.flags & RULE_BELOW) ? value <= t + h : value >= t - h;
+        }
+        if (holds && !was) rising |= 1 << r;
+        a.holding = holds ? (a.holding | (1 << r)) : (a.holding & ~(1 << r));
+    }
+
+    int8_t shown = -1;
+    for (int8_t r = a.rule_count - 1; r >= 0 && shown < 0; r--) {
+        if (a.holding & (1 << r)) shown = r;
+    }
+    if (shown != a.shown) {
+        a.shown = shown;
+        alert_apply(a);
+        if (alert_blinking(a)) {
+            if (!alert_blink_timer) alert_blink_timer = lv_timer_create(alert_blink_cb, STAT_ALERT_BLINK_MS, nullptr);
+            else lv_timer_resume(alert_blink_timer);
+        }
+    }
+    if (!toast) return;
+    for (uint8_t r = 0; r < a.rule_count; r++) {
+        if ((rising & (1 << r)) && (a.rules[r].flags & RULE_TOAST)) alert_toast(a, a.rules[r], value);
+    }
+}
+
+static void alerts_check(uint8_t type, int32_t value) {
+    for (uint16_t i : alert_index[type]) alert_eval(stat_alerts[i], value, true);
+}
+
+// A stat widget was just rendered: hook its label / chart to its alert
+static void alert_bind(uint8_t page_idx, uint8_t widget_idx, lv_obj_t *label,
+                       lv_obj_t *chart, lv_chart_series_t *series) {
+    for (auto &a : stat_alerts) {
+        if (a.page_idx != page_idx || a.widget_idx != widget_idx) continue;
+        a.label = label;
+        a.chart = chart;
+        a.series = series;
+        if (a.shown >= 0) alert_apply(a);
+        return;
+    }
+}
+
+static void alert_unbind(StatAlert &a) {
+    a.label = nullptr;
+    a.chart = nullptr;
+    a.series = nullptr;
+}
+
+// Rebuild the alert list from the profile. An alert whose widget and rules
+// are unchanged keeps its state and bound objects (no second toast for a
+// limit that was already crossed); new ones start from the cached value.
+static void sync_stat_alerts(const ProfileConfig *active) {
+    std::vector<StatAlert> old;
+    old.swap(stat_alerts);
+    for (auto &idx : alert_index) idx.clear();
+
+    for (size_t pi = 0; pi < active->pages.size(); pi++) {
+        const std::vector<WidgetConfig> &widgets = active->pages[pi].widgets;
+        for (size_t wi = 0; wi < widgets.size(); wi++) {
+            const WidgetConfig &w = widgets[wi];
+            // Rules follow the active host's values, so widgets pinned to a host have none
+            if ((w.widget_type != WIDGET_STAT_MONITOR && w.widget_type != WIDGET_STAT_GRAPH) ||
+                w.stat_rules.empty() || w.stat_type > STAT_TYPE_MAX || w.stat_host != 0 ||
+                w.stat_remote != 0) {
+                continue;
+            }
+            StatAlert a = {};
+            a.page_idx = (uint8_t)pi;
+            a.widget_idx = (uint8_t)wi;
+            a.stat_type = w.stat_type;
+            a.rule_count = (uint8_t)(w.stat_rules.size() < STAT_RULES_MAX ? w.stat_rules.size() : STAT_RULES_MAX);
+            memcpy(a.rules, w.stat_rules.data(), a.rule_count * sizeof(StatRule));
+            a.base_color = w.color;
+            a.shown = -1;
+            snprintf(a.name, sizeof(a.name), "%s", w.label.empty() ? get_stat_name(w.stat_type) : w.label.c_str());
+
+            bool carried = false;
+            for (const auto &o : old) {
+                if (o.page_idx != a.page_idx || o.widget_idx != a.widget_idx) continue;
+                a.label = o.label;
+                a.chart = o.chart;
+                a.series = o.series;
+                if (o.stat_type == a.stat_type && o.rule_count == a.rule_count && o.base_color == a.base_color &&
+                    memcmp(o.rules, a.rules, a.rule_count * sizeof(StatRule)) == 0) {
+                    a.holding = o.holding;
+                    a.shown = o.shown;
+                    carried = true;
+                }
+                break;
+            }
+            if (!carried && stat_cache_valid[a.stat_type]) alert_eval(a, stat_cache[a.stat_type], false);
+            alert_index[a.stat_type].push_back((uint16_t)stat_alerts.size());
+            stat_alerts.push_back(a);
+        }
+    }
+}
+
+// --- Stat Monitor ---
+static void render_stat_monitor(lv_obj_t *parent, const WidgetConfig *cfg, uint8_t page_idx) {
+    lv_obj_t *container = lv_obj_create(parent);
+    lv_obj_set_pos(container, cfg->x, cfg->y);
+    lv_obj_set_size(container, cfg->width, cfg->height);
+    lv_obj_set_style_bg_color(container, cfg->bg_color ? lv_color_hex(cfg->bg_color) : lv_color_hex(0x0d1b2a), LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(container, LV_OPA_COVER, LV_PART_MAIN);
+    lv_obj_set_style_border_width(container, 0, LV_PART_MAIN);
+    lv_obj_set_style_radius(container, 6, LV_PART_MAIN);
+    lv_obj_clear_flag(container, LV_OBJ_FLAG_SCROLLABLE);
+
+    if (cfg->value_position == 0) {
+        // Inline mode: "Name Value" centered
+        create_inline_stat(container, cfg->stat_type, &lv_font_montserrat_14, cfg->color,
+                           LV_ALIGN_CENTER, page_idx);
+    } else {
+        // Split mode: two labels stacked vertically
+        lv_obj_set_flex_flow(container, LV_FLEX_FLOW_COLUMN);
+        lv_obj_set_flex_align(container, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+        lv_obj_set_style_pad_all(container, 2, LV_PART_MAIN);
+
+        lv_obj_t *name_lbl = lv_label_create(container);
+        lv_label_set_text(name_lbl, get_stat_name(cfg->stat_type));
+        lv_obj_set_style_text_font(name_lbl, &lv_font_montserrat_12, LV_PART_MAIN);
+        lv_obj_set_style_text_color(name_lbl, lv_color_hex(cfg->color), LV_PART_MAIN);
+
+        // Fixed width: the flex column never relayouts on a new value
+        lv_obj_t *value_lbl = create_stat_value_label(container, cfg->stat_type, &lv_font_montserrat_16,
+                                                      cfg->color, LV_TEXT_ALIGN_CENTER);
+        if (cfg->value_position == 1) lv_obj_move_to_index(value_lbl, 0);  // Value on top, name below
+
+        stat_widget_refs.push_back({value_lbl, name_lbl, cfg->stat_type, page_idx});
+    }
+
+    StatWidgetRef &ref = stat_widget_refs.back();
+    ref.host = cfg->stat_host;
+    ref.remote = cfg->stat_type == STAT_DISPLAY_UPTIME ? 0 : cfg->stat_remote;
+    int32_t value;
+    if (stat_ref_value(ref, value)) set_stat_ref(ref, value);
+
+    // Display uptime: initialize with current millis-based hours
+    if (cfg->stat_type == STAT_DISPLAY_UPTIME) {
+        set_stat_ref(ref, (int32_t)(millis() / 3600000UL));
+    }
+}
+
+// --- Stat Graph ---
+static void render_stat_graph(lv_obj_t *parent, const WidgetConfig *cfg, uint8_t page_idx) {
+    lv_obj_t *container = lv_obj_create(parent);
+    lv_obj_set_pos(container, cfg->x, cfg->y);
+    lv_obj_set_size(container, cfg->width, cfg->height);
+    lv_obj_set_style_bg_color(container, cfg->bg_color ? lv_color_hex(cfg->bg_color) : lv_color_hex(0x0d1b2a), LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(container, LV_OPA_COVER, LV_PART_MAIN);
+    lv_obj_set_style_border_width(container, 0, LV_PART_MAIN);
+    lv_obj_set_style_radius(container, 6, LV_PART_MAIN);
+    lv_obj_set_style_pad_all(container, 4, LV_PART_MAIN);
+    lv_obj_clear_flag(container, LV_OBJ_FLAG_SCROLLABLE);
+
+    uint8_t type = cfg->stat_type;
+    lv_coord_t chart_h = cfg->height - 8;
+    if (cfg->show_label) {
+        // "Name Value" caption, kept current by the regular stat dispatch
+        create_inline_stat(container, type, &lv_font_montserrat_12, cfg->color, LV_ALIGN_TOP_LEFT, page_idx);
+        if (stat_cache_valid[type]) set_stat_ref(stat_widget_refs.back(), stat_cache[type]);
+        chart_h -= 16;
+    }
+    if (chart_h < 10) chart_h = 10;
+
+    if (!history_reserve(type, cfg->graph_points)) return;
+    const StatHistory &h = stat_history[type];
+
+    lv_obj_t *chart = lv_chart_create(container);
+    lv_obj_set_size(chart, cfg->width - 8, chart_h);
+    lv_obj_align(chart, LV_ALIGN_BOTTOM_MID, 0, 0);
+    lv_obj_set_style_bg_opa(chart, LV_OPA_TRANSP, LV_PART_MAIN);
+    lv_obj_set_style_border_width(chart, 0, LV_PART_MAIN);
+    lv_obj_set_style_pad_all(chart, 0, LV_PART_MAIN);
+    lv_obj_set_style_line_width(chart, 2, LV_PART_ITEMS);
+    lv_obj_set_style_size(chart, 0, LV_PART_INDICATOR);  // No point markers
+    lv_obj_clear_flag(chart, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_clear_flag(chart, LV_OBJ_FLAG_SCROLLABLE);
+    lv_chart_set_type(chart, LV_CHART_TYPE_LINE);
+    lv_chart_set_update_mode(chart, LV_CHART_UPDATE_MODE_SHIFT);
+    lv_chart_set_div_line_count(chart, 0, 0);
+    lv_chart_set_point_count(chart, cfg->graph_points);
+    lv_chart_series_t *ser = lv_chart_add_series(chart, lv_color_hex(cfg->color), LV_CHART_AXIS_PRIMARY_Y);
+
+    // Backfill from the history ring so a rebuild keeps the trend
+    chart_backfill(chart, ser, h);
+
+    stat_graph_refs.push_back({chart, ser, type, cfg->graph_max, 0, page_idx});
+    graph_apply_range(stat_graph_refs.back());
+    lv_chart_refresh(chart);
+}
+
+// --- Status Bar ---
+static void config_btn_event_cb(lv_event_t *e) {
+    lv_event_code_t code = lv_event_get_code(e);
+    if (code == LV_EVENT_CLICKED) {
+        if (!config_server_active()) {
+            if (config_server_start()) show_config_screen();
+        } else {
+            config_server_stop();
+            hide_config_screen();
+        }
+    }
+}
+
+static void brightness_event_cb(lv_event_t *e) {
+    if (lv_event_get_code(e) == LV_EVENT_CLICKED) power_cycle_brightness();
+}
+
+static void brightness_long_press_cb(lv_event_t *e) {
+    if (lv_event_get_code(e) == LV_EVENT_LONG_PRESSED) {
+        DisplayMode current = display_get_mode();
+        DisplayMode next = (DisplayMode)((current + 1) % 4);
+        display_set_mode(next);
+    }
+}
+
+static void apply_device_status(const StatusBarRef &ref);
+
+static void render_status_bar(lv_obj_t *parent, const WidgetConfig *cfg, uint8_t page_idx) {
+    lv_obj_t *bar = lv_obj_create(parent);
+    lv_obj_set_pos(bar, cfg->x, cfg->y);
+    lv_obj_set_size(bar, cfg->width, cfg->height);
+    lv_obj_set_style_bg_color(bar, cfg->bg_color ? lv_color_hex(cfg->bg_color) : lv_color_hex(0x16213e), LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(bar, LV_OPA_COVER, LV_PART_MAIN);
+    lv_obj_set_style_border_width(bar, 0, LV_PART_MAIN);
+    lv_obj_set_style_radius(bar, 0, LV_PART_MAIN);
+    lv_obj_clear_flag(bar, LV_OBJ_FLAG_SCROLLABLE);
+
+    // Title
+    lv_obj_t *title = lv_label_create(bar);
+    lv_label_set_text_fmt(title, LV_SYMBOL_KEYBOARD "  %s", cfg->label.c_str());
+    lv_obj_set_style_text_font(title, &lv_font_montserrat_20, LV_PART_MAIN);
+    lv_obj_set_style_text_color(title, lv_color_hex(cfg->color), LV_PART_MAIN);
+    lv_obj_align(title, LV_ALIGN_LEFT_MID, 15, 0);
+
+    // Dynamic right-to-left icon packing
+    StatusBarRef ref = {};
+    ref.bar = bar;
+    ref.page_idx = page_idx;
+    int x_offset = -10;  // start 10px from right edge
+    const int ICON_GAP = cfg->icon_spacing;
+    const int ICON_W = 22;
+
+    // WiFi indicator
+    if (cfg->show_wifi) {
+        ref.rssi_label = lv_label_create(bar);
+        lv_label_set_text(ref.rssi_label, LV_SYMBOL_WIFI);
+        lv_obj_set_style_text_font(ref.rssi_label, &lv_font_montserrat_18, LV_PART_MAIN);
+        lv_obj_set_style_text_color(ref.rssi_label, lv_color_hex(CLR_GREY), LV_PART_MAIN);
+        lv_obj_align(ref.rssi_label, LV_ALIGN_RIGHT_MID, x_offset, 0);
+        x_offset -= (ICON_W + ICON_GAP);
+    }
+
+    // PC connection indicator (USB icon)
+    if (cfg->show_pc) {
+        ref.pc_label = lv_label_create(bar);
+        lv_label_set_text(ref.pc_label, LV_SYMBOL_USB);
+        lv_obj_set_style_text_font(ref.pc_label, &lv_font_montserrat_18, LV_PART_MAIN);
+        lv_obj_set_style_text_color(ref.pc_label, lv_color_hex(CLR_RED), LV_PART_MAIN);
+        lv_obj_align(ref.pc_label, LV_ALIGN_RIGHT_MID, x_offset, 0);
+        x_offset -= (ICON_W + ICON_GAP);
+    }
+
+    // Battery gauge (only with a fuel gauge fitted: no empty slot otherwise)
+    if (cfg->show_battery && battery_present()) {
+        const int BATTERY_W = 90;
+        ref.battery_label = lv_label_create(bar);
+        lv_label_set_text(ref.battery_label, "");
+        lv_obj_set_width(ref.battery_label, BATTERY_W);
+        lv_obj_set_style_text_align(ref.battery_label, LV_TEXT_ALIGN_RIGHT, LV_PART_MAIN);
+        lv_obj_set_style_text_font(ref.battery_label, &lv_font_montserrat_14, LV_PART_MAIN);
+        lv_obj_align(ref.battery_label, LV_ALIGN_RIGHT_MID, x_offset, 0);
+        x_offset -= (BATTERY_W + ICON_GAP);
+    }
+
+    // Config/settings button
+    if (cfg->show_settings) {
         lv_obj_t *cfg_btn = lv_label_create(bar);
         lv_label_set_text(cfg_btn, LV_SYMBOL_SETTINGS);
         lv_obj_set_style_text_font(cfg_btn, &lv_font_montserrat_16, LV_PART_MAIN);
@@ -652,11 +1601,12 @@ static void render_status_bar(lv_obj_t *parent, const WidgetConfig *cfg) {
         lv_obj_align(ref.time_label, LV_ALIGN_CENTER, 0, 0);
     }
 
+    apply_status_bar(ref, status_get(), STATUS_ALL);
     status_bar_refs.push_back(ref);
 }
 
 // --- Clock Widget ---
-static void render_clock(lv_obj_t *parent, const WidgetConfig *cfg) {
+static void render_clock(lv_obj_t *parent, const WidgetConfig *cfg, uint8_t page_idx) {
     lv_obj_t *container = lv_obj_create(parent);
     lv_obj_set_pos(container, cfg->x, cfg->y);
     lv_obj_set_size(container, cfg->width, cfg->height);
@@ -686,23 +1636,11 @@ static void render_clock(lv_obj_t *parent, const WidgetConfig *cfg) {
         lv_obj_set_style_text_color(lbl, lv_color_hex(cfg->color), LV_PART_MAIN);
         lv_obj_center(lbl);
 
-        // Set initial time and track for periodic updates
-        time_t now = time(nullptr);
-        struct tm *tm_info = localtime(&now);
-        bool use_24h = g_active_config ? g_active_config->display_settings.clock_24h : true;
-        if (tm_info && now > 1000000000) {
-            if (use_24h) {
-                lv_label_set_text_fmt(lbl, "%02d:%02d", tm_info->tm_hour, tm_info->tm_min);
-            } else {
-                int hour12 = tm_info->tm_hour % 12;
-                if (hour12 == 0) hour12 = 12;
-                lv_label_set_text_fmt(lbl, "%d:%02d%s", hour12, tm_info->tm_min,
-                                      tm_info->tm_hour >= 12 ? "p" : "a");
-            }
-        } else {
-            lv_label_set_text(lbl, "--:--");
-        }
-        clock_widget_labels.push_back(lbl);
+        // Set initial time and track for minute updates
+        char text[8];
+        format_clock(text, sizeof(text), status_get());
+        lv_label_set_text(lbl, text);
+        clock_widget_labels.push_back({lbl, page_idx});
     }
 }
 
@@ -720,17 +1658,8 @@ static void render_text_label(lv_obj_t *parent, const WidgetConfig *cfg) {
     lv_obj_t *lbl = lv_label_create(container);
     lv_label_set_text(lbl, cfg->label.c_str());
 
-    // Select font size
-    const lv_font_t *font = &lv_font_montserrat_16;
-    if (cfg->font_size >= 40) font = &lv_font_montserrat_40;
-    else if (cfg->font_size >= 28) font = &lv_font_montserrat_28;
-    else if (cfg->font_size >= 22) font = &lv_font_montserrat_22;
-    else if (cfg->font_size >= 20) font = &lv_font_montserrat_20;
-    else if (cfg->font_size >= 16) font = &lv_font_montserrat_16;
-    else if (cfg->font_size >= 14) font = &lv_font_montserrat_14;
-    else font = &lv_font_montserrat_12;
-
-    lv_obj_set_style_text_font(lbl, font, LV_PART_MAIN);
+    // Flash font for the stock sizes, SD card font (or nearest smaller) for the rest
+    lv_obj_set_style_text_font(lbl, font_store_get(cfg->font_size), LV_PART_MAIN);
     lv_obj_set_style_text_color(lbl, lv_color_hex(cfg->color), LV_PART_MAIN);
 
     // Alignment
@@ -755,8 +1684,263 @@ static void render_separator(lv_obj_t *parent, const WidgetConfig *cfg) {
     lv_obj_clear_flag(line, LV_OBJ_FLAG_SCROLLABLE);
 }
 
+// --- Trackpad ---
+static void render_trackpad(lv_obj_t *parent, const WidgetConfig *cfg) {
+    lv_obj_t *pad = lv_obj_create(parent);
+    lv_obj_set_pos(pad, cfg->x, cfg->y);
+    lv_obj_set_size(pad, cfg->width, cfg->height);
+    lv_obj_set_style_bg_color(pad, cfg->bg_color ? lv_color_hex(cfg->bg_color) : lv_color_hex(0x0d1b2a), LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(pad, LV_OPA_COVER, LV_PART_MAIN);
+    lv_obj_set_style_border_color(pad, lv_color_hex(cfg->color), LV_PART_MAIN);
+    lv_obj_set_style_border_width(pad, 1, LV_PART_MAIN);
+    lv_obj_set_style_border_opa(pad, LV_OPA_30, LV_PART_MAIN);
+    lv_obj_set_style_border_opa(pad, LV_OPA_80, LV_PART_MAIN | LV_STATE_PRESSED);
+    lv_obj_set_style_radius(pad, BUTTON_RADIUS, LV_PART_MAIN);
+    trackpad_attach(pad, cfg);
+
+    if (cfg->show_label && !cfg->label.empty()) {
+        lv_obj_t *lbl = lv_label_create(pad);
+        lv_label_set_text(lbl, cfg->label.c_str());
+        lv_obj_set_style_text_font(lbl, &lv_font_montserrat_14, LV_PART_MAIN);
+        lv_obj_set_style_text_color(lbl, lv_color_hex(cfg->color), LV_PART_MAIN);
+        lv_obj_set_style_text_opa(lbl, LV_OPA_50, LV_PART_MAIN);
+        lv_obj_center(lbl);
+    }
+}
+
+// --- Remote Image ---
+// The frame is centred and clipped; its tiles are invalidated as they arrive
+static void render_remote_image(lv_obj_t *parent, const WidgetConfig *cfg) {
+    lv_obj_t *box = lv_obj_create(parent);
+    lv_obj_set_pos(box, cfg->x, cfg->y);
+    lv_obj_set_size(box, cfg->width, cfg->height);
+    lv_obj_set_style_bg_color(box, lv_color_hex(cfg->bg_color), LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(box, cfg->bg_color ? LV_OPA_COVER : LV_OPA_TRANSP, LV_PART_MAIN);
+    lv_obj_set_style_border_width(box, 0, LV_PART_MAIN);
+    lv_obj_set_style_pad_all(box, 0, LV_PART_MAIN);
+    lv_obj_set_style_radius(box, 0, LV_PART_MAIN);
+    lv_obj_clear_flag(box, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICKABLE);
+
+    lv_obj_t *img = lv_img_create(box);
+    lv_obj_center(img);
+    if (!cfg->image_source.empty()) remote_image_attach(img, cfg->image_source.c_str());
+}
+
+// --- Scroll Grid ---
+// Hundreds of entries, but only (visible + overscan) rows of cells exist:
+// the container reports the full content height, and on every scroll step
+// row r is shown by pool slot r % pool_rows, so only the slots that come
+// into view are moved and rebound. Icons are pinned in the icon cache for
+// as long as their cell shows them and load lazily from a timer, never
+// in the middle of a drag.
+struct ScrollGrid;
+
+struct GridCell {
+    ScrollGrid *grid;
+    lv_obj_t *btn;
+    lv_obj_t *img;
+    lv_obj_t *label;
+    int entry;                     // Bound entry, -1 = none
+    const lv_img_dsc_t *icon;      // Pinned in the icon cache
+    bool icon_pending;
+};
+
+struct ScrollGrid {
+    std::vector<GridEntry> entries;   // Own copy: an unchanged grid outlives the config it was built from
+    lv_obj_t *cont;
+    lv_timer_t *icon_timer;
+    uint8_t page, widget, cols;
+    lv_coord_t row_h, icon_w, icon_h;
+    int rows, pool_rows;
+    bool scrolling;
+    std::vector<int> slot_row;        // Row each pool slot shows, -1 = none yet
+    std::vector<GridCell> cells;      // pool_rows * cols, never resized (cells are user data)
+};
+
+static lv_style_t grid_cell_style;
+static bool grid_style_ready = false;
+
+static void grid_bind_cell(ScrollGrid &g, GridCell &c, int entry) {
+    if (entry >= (int)g.entries.size()) entry = -1;
+    if (c.entry == entry) return;
+    if (c.icon) {
+        lv_img_set_src(c.img, nullptr);
+        icon_cache_release(c.icon);
+        c.icon = nullptr;
+    }
+    c.entry = entry;
+    c.icon_pending = false;
+    if (entry < 0) {
+        lv_obj_add_flag(c.btn, LV_OBJ_FLAG_HIDDEN);
+        return;
+    }
+    const GridEntry &e = g.entries[entry];
+    lv_obj_clear_flag(c.btn, LV_OBJ_FLAG_HIDDEN);
+    lv_label_set_text(c.label, e.label.c_str());
+    if (!e.icon_path.empty()) {
+        c.icon_pending = true;
+        lv_timer_resume(g.icon_timer);
+    }
+}
+
+static void grid_update(ScrollGrid &g) {
+    lv_coord_t y = lv_obj_get_scroll_y(g.cont);
+    int first = (y > 0 ? y / g.row_h : 0) - UI_GRID_OVERSCAN_ROWS;
+    if (first > g.rows - g.pool_rows) first = g.rows - g.pool_rows;
+    if (first < 0) first = 0;
+    for (int r = first; r < first + g.pool_rows; r++) {
+        int slot = r % g.pool_rows;
+        if (g.slot_row[slot] == r) continue;
+        g.slot_row[slot] = r;
+        for (int c = 0; c < g.cols; c++) {
+            GridCell &cell = g.cells[slot * g.cols + c];
+            lv_obj_set_y(cell.btn, r * g.row_h + UI_GRID_CELL_GAP / 2);
+            grid_bind_cell(g, cell, r * g.cols + c);
+        }
+    }
+}
+
+static void grid_icon_timer_cb(lv_timer_t *t) {
+    ScrollGrid &g = *(ScrollGrid *)t->user_data;
+    if (g.scrolling) return;
+    for (GridCell &c : g.cells) {
+        if (!c.icon_pending) continue;
+        c.icon_pending = false;
+        c.icon = icon_cache_acquire(g.entries[c.entry].icon_path.c_str(), g.icon_w, g.icon_h);
+        if (c.icon) lv_img_set_src(c.img, c.icon);
+        return;   // One decode per tick
+    }
+    lv_timer_pause(t);
+}
+
+static void grid_cont_event_cb(lv_event_t *e) {
+    ScrollGrid *g = (ScrollGrid *)lv_event_get_user_data(e);
+    switch (lv_event_get_code(e)) {
+        case LV_EVENT_SCROLL:       grid_update(*g); break;
+        case LV_EVENT_SCROLL_BEGIN: g->scrolling = true; break;
+        case LV_EVENT_SCROLL_END:   g->scrolling = false; break;
+        case LV_EVENT_GET_SELF_SIZE: {
+            // Content height of every row, realized or not
+            lv_point_t *p = (lv_point_t *)lv_event_get_param(e);
+            lv_coord_t h = (lv_coord_t)(g->rows * g->row_h);
+            if (p->y < h) p->y = h;
+            break;
+        }
+        case LV_EVENT_DELETE:
+            lv_timer_del(g->icon_timer);
+            for (GridCell &c : g->cells) {
+                if (c.icon) icon_cache_release(c.icon);
+            }
+            delete g;
+            break;
+        default: break;
+    }
+}
+
+static void grid_cell_event_cb(lv_event_t *e) {
+    GridCell *c = (GridCell *)lv_event_get_user_data(e);
+    if (c->entry < 0) return;
+    const ScrollGrid &g = *c->grid;
+    const GridEntry &entry = g.entries[c->entry];
+    ActionDesc a = action_simple(entry.action_type, entry.keycode, entry.consumer_code, entry.modifiers);
+    a.page = g.page;
+    a.widget = g.widget;
+    a.entry = (uint16_t)c->entry;
+    action_run(a);
+}
+
+static void render_scroll_grid(lv_obj_t *parent, const WidgetConfig *cfg, uint8_t page_idx, uint8_t widget_idx) {
+    lv_obj_t *cont = lv_obj_create(parent);
+    lv_obj_set_pos(cont, cfg->x, cfg->y);
+    lv_obj_set_size(cont, cfg->width, cfg->height);
+    lv_obj_set_style_bg_color(cont, lv_color_hex(cfg->bg_color), LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(cont, cfg->bg_color ? LV_OPA_COVER : LV_OPA_TRANSP, LV_PART_MAIN);
+    lv_obj_set_style_border_width(cont, 0, LV_PART_MAIN);
+    lv_obj_set_style_pad_all(cont, 0, LV_PART_MAIN);
+    lv_obj_set_style_radius(cont, 0, LV_PART_MAIN);
+    lv_obj_set_scroll_dir(cont, LV_DIR_VER);
+    lv_obj_set_scrollbar_mode(cont, LV_SCROLLBAR_MODE_ACTIVE);
+    lv_obj_clear_flag(cont, LV_OBJ_FLAG_SCROLL_CHAIN_VER);
+
+    ScrollGrid *g = new ScrollGrid();
+    g->entries = cfg->grid_entries;
+    g->cont = cont;
+    g->page = page_idx;
+    g->widget = widget_idx;
+    g->cols = cfg->grid_columns ? cfg->grid_columns : 1;
+    g->row_h = cfg->grid_row_height;
+    g->rows = ((int)g->entries.size() + g->cols - 1) / g->cols;
+    int visible = (cfg->height + g->row_h - 1) / g->row_h + 1;   // A partly shown row at each edge
+    g->pool_rows = visible + 2 * UI_GRID_OVERSCAN_ROWS;
+    if (g->pool_rows > g->rows) g->pool_rows = g->rows;
+    g->scrolling = false;
+
+    lv_coord_t cell_w = (cfg->width - UI_GRID_CELL_GAP * (g->cols + 1)) / g->cols;
+    lv_coord_t cell_h = g->row_h - UI_GRID_CELL_GAP;
+    bool list = g->cols == 1;
+    // List: icon left of the label; grid: icon above it
+    g->icon_w = list ? cell_h - 8 : cell_w * 6 / 10;
+    g->icon_h = list ? cell_h - 8 : cell_h - 32;
+    if (g->icon_w < 1) g->icon_w = 1;
+    if (g->icon_h < 1) g->icon_h = 1;
+
+    if (!grid_style_ready) {
+        lv_style_init(&grid_cell_style);
+        lv_style_set_radius(&grid_cell_style, BUTTON_RADIUS);
+        lv_style_set_border_width(&grid_cell_style, 0);
+        lv_style_set_pad_all(&grid_cell_style, 0);
+        lv_style_set_shadow_width(&grid_cell_style, 0);   // Redrawn every scroll frame
+        lv_style_set_bg_opa(&grid_cell_style, LV_OPA_TRANSP);
+        grid_style_ready = true;
+    }
+    if (!button_base_ready) init_button_base_styles();
+    lv_color_t base = cfg->bg_color ? lv_color_hex(cfg->bg_color) : lv_color_hex(0x333333);
+    uint32_t pressed_rgb = lv_color_to32(lv_color_lighten(base, LV_OPA_20)) & 0xFFFFFF;
+    ButtonStyleEntry &styles = button_style(0, pressed_rgb);
+
+    g->slot_row.assign(g->pool_rows, -1);
+    g->cells.resize((size_t)g->pool_rows * g->cols);
+    for (int i = 0; i < (int)g->cells.size(); i++) {
+        GridCell &c = g->cells[i];
+        c.grid = g;
+        c.entry = -1;
+        c.icon = nullptr;
+        c.icon_pending = false;
+        c.btn = lv_btn_create(cont);
+        lv_obj_remove_style_all(c.btn);
+        lv_obj_add_style(c.btn, &grid_cell_style, LV_PART_MAIN);
+        lv_obj_add_style(c.btn, &button_base_pressed_style, LV_STATE_PRESSED);
+        lv_obj_add_style(c.btn, &styles.pressed, LV_STATE_PRESSED);
+        lv_obj_set_size(c.btn, cell_w, cell_h);
+        lv_obj_set_x(c.btn, UI_GRID_CELL_GAP + (i % g->cols) * (cell_w + UI_GRID_CELL_GAP));
+        lv_obj_add_flag(c.btn, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_add_event_cb(c.btn, grid_cell_event_cb, LV_EVENT_CLICKED, &c);
+
+        c.img = lv_img_create(c.btn);
+        c.label = lv_label_create(c.btn);
+        lv_label_set_long_mode(c.label, LV_LABEL_LONG_DOT);
+        add_text_style(c.label, cfg->color, &lv_font_montserrat_16);
+        if (list) {
+            lv_obj_align(c.img, LV_ALIGN_LEFT_MID, 4, 0);
+            lv_obj_set_width(c.label, cell_w - g->icon_w - 20);
+            lv_obj_align(c.label, LV_ALIGN_LEFT_MID, g->icon_w + 12, 0);
+        } else {
+            lv_obj_align(c.img, LV_ALIGN_TOP_MID, 0, 4);
+            lv_obj_set_width(c.label, cell_w - 8);
+            lv_obj_set_style_text_align(c.label, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN);
+            lv_obj_align(c.label, LV_ALIGN_BOTTOM_MID, 0, -4);
+        }
+    }
+
+    g->icon_timer = lv_timer_create(grid_icon_timer_cb, UI_GRID_ICON_MS, g);
+    lv_timer_pause(g->icon_timer);
+    lv_obj_add_event_cb(cont, grid_cont_event_cb, LV_EVENT_ALL, g);
+    lv_obj_refresh_self_size(cont);
+    grid_update(*g);
+}
+
 // --- Page Nav ---
-static void render_page_nav(lv_obj_t *parent, const WidgetConfig *cfg) {
+static void render_page_nav(lv_obj_t *parent, const WidgetConfig *cfg, uint8_t page_idx) {
     lv_obj_t *container = lv_obj_create(parent);
     lv_obj_set_pos(container, cfg->x, cfg->y);
     lv_obj_set_size(container, cfg->width, cfg->height);
@@ -769,21 +1953,26 @@ static void render_page_nav(lv_obj_t *parent, const WidgetConfig *cfg) {
     lv_obj_set_flex_align(container, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
     lv_obj_set_style_pad_column(container, 8, LV_PART_MAIN);
 
-    page_nav_refs.push_back(container);
+    page_nav_refs.push_back({container, page_idx});
 }
 
-static void update_page_nav_indicators() {
-    int total_pages = (int)page_containers.size();
-    for (auto *container : page_nav_refs) {
-        if (!container) continue;
-        lv_obj_clean(container);
-        for (int i = 0; i < total_pages; i++) {
+// The dots of a page's nav highlight that page: it is only seen while current.
+// When the page count changes, dots are added or dropped at the end; the
+// ones already there (the highlighted one among them) are kept.
+static void tick_page_navs(uint8_t, int page_idx) {
+    int total_pages = (int)pages.size();
+    for (auto &ref : page_nav_refs) {
+        lv_obj_t *container = ref.obj;
+        if (!container || (page_idx >= 0 && ref.page_idx != page_idx)) continue;
+        int have = (int)lv_obj_get_child_cnt(container);
+        while (have > total_pages) lv_obj_del(lv_obj_get_child(container, --have));
+        for (int i = have; i < total_pages; i++) {
             lv_obj_t *dot = lv_obj_create(container);
             lv_obj_set_size(dot, 10, 10);
             lv_obj_set_style_radius(dot, LV_RADIUS_CIRCLE, LV_PART_MAIN);
             lv_obj_set_style_border_width(dot, 0, LV_PART_MAIN);
             lv_obj_clear_flag(dot, LV_OBJ_FLAG_SCROLLABLE);
-            if (i == current_page) {
+            if (i == ref.page_idx) {
                 lv_obj_set_style_bg_color(dot, lv_color_hex(CLR_BLUE), LV_PART_MAIN);
                 lv_obj_set_style_bg_opa(dot, LV_OPA_COVER, LV_PART_MAIN);
             } else {
@@ -795,388 +1984,2070 @@ static void update_page_nav_indicators() {
 }
 
 // ============================================================
-//  Widget Dispatcher
+//  Widget Registry (widget_registry.h)
 // ============================================================
-static void render_widget(lv_obj_t *parent, const WidgetConfig *cfg, uint8_t page_idx, uint8_t widget_idx) {
-    switch (cfg->widget_type) {
-        case WIDGET_HOTKEY_BUTTON: render_hotkey_button(parent, cfg, page_idx, widget_idx); break;
-        case WIDGET_STAT_MONITOR:  render_stat_monitor(parent, cfg);  break;
-        case WIDGET_STATUS_BAR:    render_status_bar(parent, cfg);    break;
-        case WIDGET_CLOCK:         render_clock(parent, cfg);         break;
-        case WIDGET_TEXT_LABEL:    render_text_label(parent, cfg);    break;
-        case WIDGET_SEPARATOR:     render_separator(parent, cfg);     break;
-        case WIDGET_PAGE_NAV:      render_page_nav(parent, cfg);      break;
-        default:
-            Serial.printf("[ui] Unknown widget type %d, skipping\n", cfg->widget_type);
-            break;
+static void tick_stat_monitors(uint8_t events, int page_idx);
+static void tick_status_bars(uint8_t events, int page_idx);
+static void tick_clocks(uint8_t events, int page_idx);
+static void tick_page_navs(uint8_t events, int page_idx);
+
+template <> struct WidgetTraits<WIDGET_HOTKEY_BUTTON> : WidgetTraitsBase {
+    static constexpr bool enabled = UI_WIDGET_HOTKEY_BUTTON;
+    static void render(lv_obj_t *p, const WidgetConfig *cfg, uint8_t page, uint8_t widget) {
+        render_hotkey_button(p, cfg, page, widget);
     }
-}
-
-// ============================================================
-//  Page Management
-// ============================================================
-static void show_page(int index) {
-    if (index < 0 || index >= (int)page_containers.size()) return;
-
-    // Hide all pages
-    for (auto *p : page_containers) {
-        lv_obj_add_flag(p, LV_OBJ_FLAG_HIDDEN);
+};
+template <> struct WidgetTraits<WIDGET_STAT_MONITOR> : WidgetTraitsBase {
+    static constexpr bool enabled = UI_WIDGET_STAT_MONITOR;
+    static constexpr uint8_t events = STATUS_MINUTE | WIDGET_TICK_PAGE;   // Uptime; values held back while hidden
+    static void render(lv_obj_t *p, const WidgetConfig *cfg, uint8_t page, uint8_t) { render_stat_monitor(p, cfg, page); }
+    static void tick(uint8_t events, int page) { tick_stat_monitors(events, page); }
+};
+template <> struct WidgetTraits<WIDGET_STATUS_BAR> : WidgetTraitsBase {
+    static constexpr bool enabled = UI_WIDGET_STATUS_BAR;
+    static constexpr uint8_t events = STATUS_RSSI | STATUS_LINK | STATUS_PC | STATUS_BATTERY | STATUS_MINUTE |
+                                      WIDGET_TICK_PAGE;
+    static void render(lv_obj_t *p, const WidgetConfig *cfg, uint8_t page, uint8_t) { render_status_bar(p, cfg, page); }
+    static void tick(uint8_t events, int page) { tick_status_bars(events, page); }
+};
+template <> struct WidgetTraits<WIDGET_CLOCK> : WidgetTraitsBase {
+    static constexpr bool enabled = UI_WIDGET_CLOCK;
+    static constexpr uint8_t events = STATUS_MINUTE | WIDGET_TICK_PAGE;
+    static void render(lv_obj_t *p, const WidgetConfig *cfg, uint8_t page, uint8_t) { render_clock(p, cfg, page); }
+    static void tick(uint8_t events, int page) { tick_clocks(events, page); }
+};
+template <> struct WidgetTraits<WIDGET_TEXT_LABEL> : WidgetTraitsBase {
+    static constexpr bool enabled = UI_WIDGET_TEXT_LABEL;
+    static void render(lv_obj_t *p, const WidgetConfig *cfg, uint8_t, uint8_t) { render_text_label(p, cfg); }
+};
+template <> struct WidgetTraits<WIDGET_SEPARATOR> : WidgetTraitsBase {
+    static constexpr bool enabled = UI_WIDGET_SEPARATOR;
+    static void render(lv_obj_t *p, const WidgetConfig *cfg, uint8_t, uint8_t) { render_separator(p, cfg); }
+};
+template <> struct WidgetTraits<WIDGET_PAGE_NAV> : WidgetTraitsBase {
+    static constexpr bool enabled = UI_WIDGET_PAGE_NAV;
+    static constexpr uint8_t events = WIDGET_TICK_PAGE;
+    static void render(lv_obj_t *p, const WidgetConfig *cfg, uint8_t page, uint8_t) { render_page_nav(p, cfg, page); }
+    static void tick(uint8_t events, int page) { tick_page_navs(events, page); }
+};
+template <> struct WidgetTraits<WIDGET_STAT_GRAPH> : WidgetTraitsBase {
+    static constexpr bool enabled = UI_WIDGET_STAT_GRAPH;
+    static constexpr uint8_t events = STATUS_MINUTE | WIDGET_TICK_PAGE;   // Its header is a stat label
+    static void render(lv_obj_t *p, const WidgetConfig *cfg, uint8_t page, uint8_t) { render_stat_graph(p, cfg, page); }
+    static void tick(uint8_t events, int page) { tick_stat_monitors(events, page); }
+};
+template <> struct WidgetTraits<WIDGET_TRACKPAD> : WidgetTraitsBase {
+    static constexpr bool enabled = UI_WIDGET_TRACKPAD;
+    static void render(lv_obj_t *p, const WidgetConfig *cfg, uint8_t, uint8_t) { render_trackpad(p, cfg); }
+};
+template <> struct WidgetTraits<WIDGET_REMOTE_IMAGE> : WidgetTraitsBase {
+    static constexpr bool enabled = UI_WIDGET_REMOTE_IMAGE;
+    static void render(lv_obj_t *p, const WidgetConfig *cfg, uint8_t, uint8_t) { render_remote_image(p, cfg); }
+};
+template <> struct WidgetTraits<WIDGET_SCROLL_GRID> : WidgetTraitsBase {
+    static constexpr bool enabled = UI_WIDGET_SCROLL_GRID;
+    static void render(lv_obj_t *p, const WidgetConfig *cfg, uint8_t page, uint8_t widget) {
+        render_scroll_grid(p, cfg, page, widget);
     }
+};
 
-    // Show target page
-    lv_obj_clear_flag(page_containers[index], LV_OBJ_FLAG_HIDDEN);
-    current_page = index;
-
-    update_page_nav_indicators();
-    Serial.printf("[ui] Showing page %d/%zu\n", index + 1, page_containers.size());
-}
+// Indexed by WidgetType
+static constexpr WidgetTypeEntry widget_registry[] = {
+    widget_type_entry<WidgetTraits<WIDGET_HOTKEY_BUTTON>>(),
+    widget_type_entry<WidgetTraits<WIDGET_STAT_MONITOR>>(),
+    widget_type_entry<WidgetTraits<WIDGET_STATUS_BAR>>(),
+    widget_type_entry<WidgetTraits<WIDGET_CLOCK>>(),
+    widget_type_entry<WidgetTraits<WIDGET_TEXT_LABEL>>(),
+    widget_type_entry<WidgetTraits<WIDGET_SEPARATOR>>(),
+    widget_type_entry<WidgetTraits<WIDGET_PAGE_NAV>>(),
+    widget_type_entry<WidgetTraits<WIDGET_STAT_GRAPH>>(),
+    widget_type_entry<WidgetTraits<WIDGET_TRACKPAD>>(),
+    widget_type_entry<WidgetTraits<WIDGET_REMOTE_IMAGE>>(),
+    widget_type_entry<WidgetTraits<WIDGET_SCROLL_GRID>>(),
+};
+static_assert(sizeof(widget_registry) / sizeof(widget_registry[0]) == WIDGET_TYPE_MAX + 1,
+              "widget_registry needs one row per WidgetType");
 
-void ui_next_page() {
-    if (current_page < (int)page_containers.size() - 1) {
-        show_page(current_page + 1);
+static uint16_t widget_type_mask(const PageConfig &page) {
+    uint16_t mask = 0;
+    for (const auto &w : page.widgets) {
+        if (w.widget_type <= WIDGET_TYPE_MAX) mask |= 1u << w.widget_type;
     }
+    return mask;
 }
 
-void ui_prev_page() {
-    if (current_page > 0) {
-        show_page(current_page - 1);
+// Run the tick hooks subscribed to `events` of the types present on `page_idx`
+// (-1 = every realized page). Types sharing a hook run it once.
+static void widgets_tick(uint8_t events, int page_idx) {
+    uint16_t present = 0;
+    if (page_idx >= 0) {
+        if (page_idx < (int)pages.size() && pages[page_idx].container) present = pages[page_idx].widget_types;
+    } else {
+        for (const auto &slot : pages) {
+            if (slot.container) present |= slot.widget_types;
+        }
+    }
+    WidgetTickFn done[WIDGET_TYPE_MAX + 1];
+    uint8_t n_done = 0;
+    for (uint8_t t = 0; t <= WIDGET_TYPE_MAX; t++) {
+        const WidgetTypeEntry &e = widget_registry[t];
+        if (!e.tick || !(e.events & events) || !(present & (1u << t))) continue;
+        bool ran = false;
+        for (uint8_t i = 0; i < n_done; i++) ran |= done[i] == e.tick;
+        if (ran) continue;
+        done[n_done++] = e.tick;
+        e.tick(events & e.events, page_idx);
     }
 }
 
+static void render_widget(lv_obj_t *parent, const WidgetConfig *cfg, uint8_t page_idx, uint8_t widget_idx) {
+    size_t refs_before = stat_widget_refs.size(), graphs_before = stat_graph_refs.size();
+    WidgetRenderFn render = cfg->widget_type <= WIDGET_TYPE_MAX ? widget_registry[cfg->widget_type].render : nullptr;
+    if (!render) {
+        Serial.printf("[ui] Widget type %d unknown or not in this build, skipping\n", cfg->widget_type);
+        return;
+    }
+    render(parent, cfg, page_idx, widget_idx);
+    if (!cfg->stat_rules.empty() &&
+        (cfg->widget_type == WIDGET_STAT_MONITOR || cfg->widget_type == WIDGET_STAT_GRAPH)) {
+        bool has_label = stat_widget_refs.size() > refs_before;
+        bool has_chart = stat_graph_refs.size() > graphs_before;
+        alert_bind(page_idx, widget_idx, has_label ? stat_widget_refs.back().label : nullptr,
+                   has_chart ? stat_graph_refs.back().chart : nullptr,
+                   has_chart ? stat_graph_refs.back().series : nullptr);
+    }
+}
+
+// ============================================================
+//  Page Management
+// ============================================================
+
+// Bring a page's stat labels up to date from the value cache (they were
+// skipped while it was hidden; -1 = every page). set_stat_ref() no-ops on
+// unchanged values.
+static void refresh_page_stats(int index) {
+#if UI_DEFER_HIDDEN_STAT_UPDATES
+    for (auto &ref : stat_widget_refs) {
+        if ((index >= 0 && ref.page_idx != index) || !ref.label) continue;
+        int32_t value;
+        if (stat_ref_value(ref, value)) set_stat_ref(ref, value);
+    }
+#else
+    (void)index;
+#endif
+}
+
+// render_widget() returning the widget's top-level object: every renderer
+// adds exactly one child to the page (none for unknown types)
+static lv_obj_t *render_widget_obj(lv_obj_t *parent, const WidgetConfig *cfg, uint8_t page_idx, uint8_t widget_idx) {
+    uint32_t before = lv_obj_get_child_cnt(parent);
+    render_widget(parent, cfg, page_idx, widget_idx);
+    uint32_t after = lv_obj_get_child_cnt(parent);
+    return after > before ? lv_obj_get_child(parent, after - 1) : nullptr;
+}
+
+// One page's widget tree, built from its PageConfig; starts hidden
+// ============================================================
+//  Page backgrounds (img_loader)
+// ============================================================
+static void drop_page_snapshot(int page);
+
+static void page_bg_free(PageBackground *b) {
+    lv_img_cache_invalidate_src(&b->dsc);
+    mem_free(MEM_POOL_IMAGES, b->pixels);
+    delete b;
+}
+
+static void bg_poll_cb(lv_timer_t *timer) {
+    bool pending = false;
+    for (size_t i = 0; i < page_backgrounds.size();) {
+        PageBackground *b = page_backgrounds[i];
+        if (b->state == IMG_LOAD_BUSY) {
+            pending = true;
+            i++;
+            continue;
+        }
+        if (!b->img) {
+            page_bg_free(b);   // Page went away while decoding
+            page_backgrounds.erase(page_backgrounds.begin() + i);
+            continue;
+        }
+        if (!b->shown) {
+            b->shown = true;
+            drop_page_snapshot(b->page);   // Taken without the background
+            if (UI_PAGE_LAYERS && page_prefetch_timer) lv_timer_resume(page_prefetch_timer);   // Bake it
+            if (b->state == IMG_LOAD_READY) {
+                lv_img_set_src(b->img, &b->dsc);
+            } else {
+                std::string bg_src = std::string("S:") + b->path;   // Loader couldn't decode it
+                lv_img_set_src(b->img, bg_src.c_str());
+            }
+        }
+        i++;
+    }
+    if (!pending) lv_timer_pause(timer);
+}
+
+// Queue the decode of a full-screen background for `img`; nullptr to use
+// the "S:" drive instead
+static PageBackground *page_bg_start(lv_obj_t *img, const char *path, int page) {
+#if UI_ASYNC_BACKGROUNDS
+    if (!img_loader_takes(path)) return nullptr;   // PNG: the page layer bakes it
+    size_t bytes = SCREEN_WIDTH * SCREEN_HEIGHT * sizeof(uint16_t);
+    uint16_t *pixels = (uint16_t *)mem_alloc(MEM_POOL_IMAGES, bytes);
+    if (!pixels) return nullptr;
+    PageBackground *b = new PageBackground();
+    b->pixels = pixels;
+    b->dsc.header.cf = LV_IMG_CF_TRUE_COLOR;
+    b->dsc.header.w = SCREEN_WIDTH;
+    b->dsc.header.h = SCREEN_HEIGHT;
+    b->dsc.data_size = bytes;
+    b->dsc.data = (const uint8_t *)pixels;
+    b->state = IMG_LOAD_IDLE;
+    b->img = img;
+    b->page = page;
+    b->shown = false;
+    b->path = path;
+    if (!img_loader_decode_into(path, pixels, &b->state)) {
+        mem_free(MEM_POOL_IMAGES, pixels);
+        delete b;
+        return nullptr;
+    }
+    page_backgrounds.push_back(b);
+    if (!bg_poll_timer) bg_poll_timer = lv_timer_create(bg_poll_cb, UI_BG_POLL_MS, nullptr);
+    lv_timer_resume(bg_poll_timer);
+    return b;
+#else
+    (void)img; (void)path; (void)page;
+    return nullptr;
+#endif
+}
+
+// The page's objects are about to be deleted: nothing may draw the frame
+// after this. Freed now, or by bg_poll_cb() once the loader is done with it.
+static void page_bg_release(PageSlot &slot) {
+    PageBackground *b = slot.bg;
+    if (!b) return;
+    slot.bg = nullptr;
+    if (b->img) lv_img_set_src(b->img, nullptr);
+    b->img = nullptr;
+    if (b->state == IMG_LOAD_BUSY) return;
+    for (size_t i = 0; i < page_backgrounds.size(); i++) {
+        if (page_backgrounds[i] == b) {
+            page_backgrounds.erase(page_backgrounds.begin() + i);
+            break;
+        }
+    }
+    page_bg_free(b);
+}
+
+// ============================================================
+//  Page layers
+// ============================================================
+static bool rects_overlap(const WidgetConfig &a, const WidgetConfig &b) {
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+// Widgets that may be drawn into the layer: text labels and separators that
+// nothing live lies under (the layer goes below every object)
+static std::vector<bool> page_layer_mask(const PageConfig &page) {
+    std::vector<bool> mask(page.widgets.size(), false);
+    for (size_t i = 0; i < page.widgets.size(); i++) {
+        const WidgetConfig &w = page.widgets[i];
+        if (w.widget_type != WIDGET_TEXT_LABEL && w.widget_type != WIDGET_SEPARATOR) continue;
+        bool covers_live = false;
+        for (size_t j = 0; j < i && !covers_live; j++) {
+            covers_live = !mask[j] && rects_overlap(page.widgets[j], w);
+        }
+        mask[i] = !covers_live;
+    }
+    return mask;
+}
+
+// Something (still) live that belongs in the layer, and enough of it
+static bool page_layer_wanted(const PageSlot &slot) {
+    if (slot.bg && !slot.bg->shown) return false;   // Background still decoding
+    size_t n = 0;
+    for (size_t wi = 0; wi < slot.widgets.size(); wi++) n += slot.widgets[wi] && slot.layer_mask[wi];
+    if (n >= UI_PAGE_LAYER_MIN_WIDGETS) return true;
+    if (n && (slot.layer || slot.bg_obj)) return true;
+    return slot.bg_obj && !slot.bg;   // "S:" background: decoded on every redraw
+}
+
+// Render the background, the current layer and the layer widgets into a new
+// layer, then delete what went into it. False when there was nothing to do.
+static bool bake_page_layer(int pi) {
+    if (!UI_PAGE_LAYERS || pi < 0 || pi >= (int)pages.size()) return false;
+    PageSlot &slot = pages[pi];
+    if (!slot.container || slot.job || slot.layer_failed || !page_layer_wanted(slot)) return false;
+
+    std::vector<lv_obj_t *> hidden;
+    for (size_t wi = 0; wi < slot.widgets.size(); wi++) {
+        lv_obj_t *obj = slot.widgets[wi];
+        if (!obj || slot.layer_mask[wi] || lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN)) continue;
+        lv_obj_add_flag(obj, LV_OBJ_FLAG_HIDDEN);
+        hidden.push_back(obj);
+    }
+    uint32_t t0 = millis();
+    lv_obj_update_layout(slot.container);
+    uint32_t size = lv_snapshot_buf_size_needed(slot.container, LV_IMG_CF_TRUE_COLOR);
+    void *buf = mem_alloc(MEM_POOL_IMAGES, size);
+    lv_img_dsc_t dsc;
+    bool ok = buf && lv_snapshot_take_to_buf(slot.container, LV_IMG_CF_TRUE_COLOR, &dsc, buf, size) == LV_RES_OK;
+    for (lv_obj_t *obj : hidden) lv_obj_clear_flag(obj, LV_OBJ_FLAG_HIDDEN);
+    if (!ok) {
+        mem_free(MEM_POOL_IMAGES, buf);
+        slot.layer_failed = true;
+        Serial.printf("[ui] Page %d: no room for a layer, its widgets stay live\n", pi + 1);
+        return true;
+    }
+
+    int baked = 0;
+    for (size_t wi = 0; wi < slot.widgets.size(); wi++) {
+        if (!slot.widgets[wi] || !slot.layer_mask[wi]) continue;
+        lv_obj_del(slot.widgets[wi]);
+        slot.widgets[wi] = nullptr;
+        baked++;
+    }
+    bool had_bg = slot.bg_obj;
+    if (slot.bg_obj) {
+        page_bg_release(slot);
+        lv_obj_del(slot.bg_obj);
+        slot.bg_obj = nullptr;
+    }
+    if (!slot.layer) {
+        slot.layer = lv_img_create(slot.container);
+        lv_obj_clear_flag(slot.layer, LV_OBJ_FLAG_CLICKABLE);
+        lv_obj_move_to_index(slot.layer, 0);
+    }
+    void *old = slot.layer_buf;
+    slot.layer_dsc = dsc;
+    slot.layer_buf = buf;
+    lv_img_cache_invalidate_src(&slot.layer_dsc);   // Same descriptor, new pixels
+    lv_img_set_src(slot.layer, &slot.layer_dsc);
+    lv_obj_invalidate(slot.layer);
+    mem_free(MEM_POOL_IMAGES, old);
+    Serial.printf("[ui] Page %d layer: %d widget(s)%s baked in %lums\n", pi + 1, baked,
+                  had_bg ? " + background" : "", (unsigned long)(millis() - t0));
+    return true;
+}
+
+// Like page_bg_release(): the container is deleted async, so nothing may
+// draw the buffer after this
+static void page_layer_release(PageSlot &slot) {
+    if (slot.layer) lv_img_set_src(slot.layer, nullptr);
+    lv_img_cache_invalidate_src(&slot.layer_dsc);
+    mem_free(MEM_POOL_IMAGES, slot.layer_buf);
+    slot.layer = nullptr;
+    slot.layer_dsc = {};
+    slot.layer_buf = nullptr;
+    slot.layer_failed = false;
+    slot.bg_obj = nullptr;
+    slot.layer_mask.clear();
+}
+
+// A rebuild may keep the layer only if what was baked into it is unchanged
+// and may still be under everything
+static bool page_layer_valid(const PageSlot &slot, const PageConfig &page) {
+    if (!slot.layer) return true;
+    std::vector<bool> mask = page_layer_mask(page);
+    for (size_t wi = 0; wi < slot.widgets.size(); wi++) {
+        if (slot.widgets[wi] || !slot.layer_mask[wi]) continue;   // Not baked
+        if (!mask[wi] || !widget_config_equal(slot.built.widgets[wi], page.widgets[wi])) return false;
+    }
+    return true;
+}
+
+// The hidden container with its background and the page's action table;
+// widgets follow with build_page_widget(), build_page_end() publishes it
+static lv_obj_t *build_page_begin(PageSlot &slot, const PageConfig &page, uint8_t pi) {
+    lv_obj_t *container = lv_obj_create(pages_parent);
+    lv_obj_set_size(container, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    lv_obj_set_pos(container, 0, 0);
+    // Default layout is none (absolute positioning) in LVGL v8
+    lv_obj_set_style_bg_color(container, lv_color_hex(0x0D1117), LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(container, LV_OPA_COVER, LV_PART_MAIN);
+    lv_obj_set_style_border_width(container, 0, LV_PART_MAIN);
+    lv_obj_set_style_radius(container, 0, LV_PART_MAIN);
+    lv_obj_set_style_pad_all(container, 0, LV_PART_MAIN);
+    lv_obj_clear_flag(container, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_add_flag(container, LV_OBJ_FLAG_HIDDEN);
+
+    // Background image from SD card (rendered behind all widgets)
+    if (!page.bg_image.empty() && SD.exists(page.bg_image.c_str())) {
+        lv_obj_t *bg = lv_img_create(container);
+        lv_obj_set_size(bg, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+        lv_obj_set_pos(bg, 0, 0);
+        lv_obj_clear_flag(bg, LV_OBJ_FLAG_CLICKABLE);
+        slot.bg_obj = bg;
+        slot.bg = page_bg_start(bg, page.bg_image.c_str(), pi);
+        if (!slot.bg) {
+            std::string bg_src = std::string("S:") + page.bg_image.c_str();
+            lv_img_set_src(bg, bg_src.c_str());
+        }
+    }
+
+    action_table_build(slot.actions, page, pi);
+    slot.widgets.clear();
+    return container;
+}
+
+static void build_page_widget(PageSlot &slot, lv_obj_t *container, const PageConfig &page, uint8_t pi, size_t wi) {
+    slot.widgets.push_back(render_widget_obj(container, &page.widgets[wi], pi, (uint8_t)wi));
+}
+
+static void build_page_end(PageSlot &slot, lv_obj_t *container, const PageConfig &page) {
+    slot.container = container;
+    slot.built = page;
+    slot.widget_types = widget_type_mask(page);
+    slot.layer_mask = page_layer_mask(page);
+}
+
+static void build_page(PageSlot &slot, const PageConfig &page, uint8_t pi) {
+    lv_obj_t *container = build_page_begin(slot, page, pi);
+    for (size_t wi = 0; wi < page.widgets.size(); wi++) build_page_widget(slot, container, page, pi, wi);
+    build_page_end(slot, container, page);
+}
+
+// Index stat widgets by type so each TLV entry touches only its own labels
+static void rebuild_stat_index() {
+    for (auto &idx : stat_index) idx.clear();
+    for (size_t i = 0; i < stat_widget_refs.size(); i++) {
+        uint8_t type = stat_widget_refs[i].stat_type;
+        if (type <= STAT_TYPE_MAX) stat_index[type].push_back((uint16_t)i);
+    }
+}
+
+template <typename T, typename Pred>
+static void erase_refs_if(std::vector<T> &refs, Pred drop) {
+    size_t out = 0;
+    for (size_t i = 0; i < refs.size(); i++) {
+        if (!drop(refs[i])) refs[out++] = refs[i];
+    }
+    refs.resize(out);
+}
+
+static void erase_page_refs(int index) {
+    auto on_page = [index](const auto &ref) { return ref.page_idx == index; };
+    erase_refs_if(stat_widget_refs, on_page);
+    erase_refs_if(stat_graph_refs, on_page);
+    erase_refs_if(status_bar_refs, on_page);
+    erase_refs_if(page_nav_refs, on_page);
+    erase_refs_if(clock_widget_labels, on_page);
+    for (auto &a : stat_alerts) {
+        if (a.page_idx == index) alert_unbind(a);
+    }
+}
+
+static bool obj_within(lv_obj_t *obj, lv_obj_t *root) {
+    for (; obj; obj = lv_obj_get_parent(obj)) {
+        if (obj == root) return true;
+    }
+    return false;
+}
+
+// Drop the live-update refs of one widget about to be deleted
+static void erase_widget_refs(lv_obj_t *root) {
+    erase_refs_if(stat_widget_refs, [root](const StatWidgetRef &r) { return obj_within(r.label, root); });
+    erase_refs_if(stat_graph_refs, [root](const StatGraphRef &r) { return obj_within(r.chart, root); });
+    erase_refs_if(status_bar_refs, [root](const StatusBarRef &r) { return obj_within(r.bar, root); });
+    erase_refs_if(page_nav_refs, [root](const PageObjRef &r) { return obj_within(r.obj, root); });
+    erase_refs_if(clock_widget_labels, [root](const PageObjRef &r) { return obj_within(r.obj, root); });
+    for (auto &a : stat_alerts) {
+        if (obj_within(a.label, root) || obj_within(a.chart, root)) alert_unbind(a);
+    }
+}
+
+// ============================================================
+//  Page snapshots
+// ============================================================
+static PageSnapshot *find_snapshot(int page) {
+    if (!UI_PAGE_SNAPSHOTS) return nullptr;
+    for (auto &s : page_snapshots) {
+        if (s.page == page && page >= 0) return &s;
+    }
+    return nullptr;
+}
+
+static bool overlay_showing() {
+    return snap_strip && !lv_obj_has_flag(snap_strip, LV_OBJ_FLAG_HIDDEN);
+}
+
+static bool overlay_uses(const PageSnapshot &s) {
+    if (!overlay_showing() || s.page < 0) return false;
+    return lv_img_get_src(snap_img[0]) == &s.img || lv_img_get_src(snap_img[1]) == &s.img;
+}
+
+static void snapshot_overlay_hide() {
+    if (!overlay_showing()) return;
+    lv_anim_del(snap_strip, nullptr);
+    lv_obj_add_flag(snap_strip, LV_OBJ_FLAG_HIDDEN);   // The live page gets its real render now
+    if (snap_settle_timer) lv_timer_pause(snap_settle_timer);
+}
+
+static void drop_page_snapshot(int page) {
+    PageSnapshot *s = find_snapshot(page);
+    if (!s) return;
+    if (overlay_uses(*s)) snapshot_overlay_hide();
+    s->page = -1;
+    if (page == current_page) snapshot_taken_this_visit = false;
+}
+
+static void drop_all_page_snapshots() {
+    snapshot_overlay_hide();
+    for (auto &s : page_snapshots) s.page = -1;
+    snapshot_taken_this_visit = false;
+}
+
+// Images pool evictor (any task): free buffers the overlay isn't showing
+static size_t snapshot_trim(size_t want) {
+    size_t freed = 0;
+    ui_lock();
+    for (auto &s : page_snapshots) {
+        if (freed >= want) break;
+        if (!s.buf || overlay_uses(s)) continue;
+        freed += s.size;
+        mem_free(MEM_POOL_IMAGES, s.buf);
+        s = PageSnapshot();
+    }
+    ui_unlock();
+    return freed;
+}
+
+// Render a realized page (hidden or not) into a snapshot slot: its own, or
+// the least recently used one the overlay isn't showing
+static bool capture_page_snapshot(int pi) {
+    if (!UI_PAGE_SNAPSHOTS || pi < 0 || pi >= (int)pages.size() || !pages[pi].container) return false;
+    if (pages[pi].job) return false;   // Half patched: taken once its job is done
+    PageSnapshot *slot = find_snapshot(pi);
+    if (!slot) {
+        for (auto &s : page_snapshots) {
+            if (overlay_uses(s)) continue;
+            if (s.page < 0) { slot = &s; break; }
+            if (!slot || s.last_used < slot->last_used) slot = &s;
+        }
+    }
+    if (!slot || overlay_uses(*slot)) return false;
+
+    static bool evictor_added = false;
+    if (!evictor_added) {
+        mem_add_evictor(MEM_POOL_IMAGES, snapshot_trim);
+        evictor_added = true;
+    }
+    lv_obj_t *container = pages[pi].container;
+    lv_obj_update_layout(container);
+    uint32_t need = lv_snapshot_buf_size_needed(container, LV_IMG_CF_TRUE_COLOR);
+    if (slot->buf && slot->size < need) {
+        mem_free(MEM_POOL_IMAGES, slot->buf);
+        slot->buf = nullptr;
+    }
+    if (!slot->buf) {
+        slot->buf = mem_alloc(MEM_POOL_IMAGES, need);
+        slot->size = slot->buf ? need : 0;
+        if (!slot->buf) {
+            slot->page = -1;
+            return false;
+        }
+    }
+
+    uint32_t t0 = millis();
+    if (lv_snapshot_take_to_buf(container, LV_IMG_CF_TRUE_COLOR, &slot->img, slot->buf, slot->size) != LV_RES_OK) {
+        slot->page = -1;
+        return false;
+    }
+    lv_img_cache_invalidate_src(&slot->img);  // Same descriptor, new pixels
+    slot->page = pi;
+    slot->last_used = pages[pi].last_used;
+    LOG_D("[ui] Snapshot of page %d in %lums\n", pi + 1, (unsigned long)(millis() - t0));
+    return true;
+}
+
+static void snapshot_settle_cb(lv_timer_t *timer) {
+    if (!overlay_showing()) {
+        lv_timer_pause(timer);
+        return;
+    }
+    if (lv_anim_get(snap_strip, nullptr)) return;   // Still sliding
+    uint32_t shown_for = millis() - snap_shown_ms;
+    bool touched = lv_disp_get_inactive_time(NULL) < shown_for;   // Taps go to the live page below
+    if (touched || shown_for >= UI_SNAPSHOT_SETTLE_MS) snapshot_overlay_hide();
+}
+
+static void ensure_snapshot_overlay() {
+    if (snap_strip) return;
+    snap_strip = lv_obj_create(pages_parent);
+    lv_obj_remove_style_all(snap_strip);
+    lv_obj_set_size(snap_strip, DISPLAY_WIDTH * 2, DISPLAY_HEIGHT);
+    lv_obj_set_style_bg_color(snap_strip, lv_color_hex(0x0D1117), LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(snap_strip, LV_OPA_COVER, LV_PART_MAIN);   // Opaque: LVGL skips what's under it
+    lv_obj_clear_flag(snap_strip, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_clear_flag(snap_strip, LV_OBJ_FLAG_SCROLLABLE);
+    for (int i = 0; i < 2; i++) {
+        snap_img[i] = lv_img_create(snap_strip);
+        lv_obj_set_pos(snap_img[i], i * DISPLAY_WIDTH, 0);
+        lv_obj_clear_flag(snap_img[i], LV_OBJ_FLAG_CLICKABLE);
+    }
+    lv_obj_add_flag(snap_strip, LV_OBJ_FLAG_HIDDEN);
+    snap_settle_timer = lv_timer_create(snapshot_settle_cb, 20, nullptr);
+    lv_timer_pause(snap_settle_timer);
+}
+
+// Cover the (already shown) live page with its snapshot, if there is one
+static void snapshot_overlay_show(int pi) {
+    PageSnapshot *s = find_snapshot(pi);
+    if (!s) {
+        snapshot_overlay_hide();
+        return;
+    }
+    ensure_snapshot_overlay();
+    lv_anim_del(snap_strip, nullptr);
+    lv_img_set_src(snap_img[0], &s->img);
+    lv_img_set_src(snap_img[1], &s->img);
+    lv_obj_set_x(snap_strip, 0);
+    lv_obj_move_foreground(snap_strip);
+    lv_obj_clear_flag(snap_strip, LV_OBJ_FLAG_HIDDEN);
+    s->last_used = page_use_clock;
+    snap_shown_ms = millis();
+    lv_timer_resume(snap_settle_timer);
+}
+
+static void snap_strip_x_cb(void *obj, int32_t v) {
+    lv_obj_set_x((lv_obj_t *)obj, (lv_coord_t)v);
+}
+
+static void page_job_cancel(int index);
+
+static void evict_page(int index) {
+    PageSlot &slot = pages[index];
+    page_job_cancel(index);   // A half-built page goes with it, a half-patched one evicts itself
+    if (!slot.container) return;
+    if (index == current_page) hw_input_clear_focus();
+    page_bg_release(slot);
+    page_layer_release(slot);
+    // Async: the evicting call may come from a click on this very page
+    lv_obj_del_async(slot.container);
+    slot.container = nullptr;
+    drop_page_snapshot(index);
+    slot.widgets.clear();
+    slot.built = PageConfig();
+    action_table_clear(slot.actions);
+    erase_page_refs(index);
+    rebuild_stat_index();
+    Serial.printf("[ui] Evicted page %d\n", index + 1);
+}
+
+// Make room for one more realized page; `keep` is never evicted
+static void evict_lru(int keep) {
+    for (;;) {
+        int realized = 0, victim = -1;
+        for (int i = 0; i < (int)pages.size(); i++) {
+            if (!pages[i].container) continue;
+            realized++;
+            if (i == keep) continue;
+            if (victim < 0 || pages[i].last_used < pages[victim].last_used) victim = i;
+        }
+        if (realized < UI_PAGE_CACHE_SIZE || victim < 0) return;
+        evict_page(victim);
+    }
+}
+
+static lv_obj_t *realize_page(int index, int keep) {
+    PageSlot &slot = pages[index];
+    if (slot.job) ui_job_finish(slot.job);   // Wanted now: the rest of its slices at once
+    if (slot.container) return slot.container;
+    const ProfileConfig *active = g_active_config ? g_active_config->get_active_profile() : nullptr;
+    if (!active || index >= (int)active->pages.size()) return nullptr;
+
+    evict_lru(keep);
+    lv_mem_monitor_t mon_pre;
+    lv_mem_monitor(&mon_pre);
+    uint32_t t0 = millis();
+    build_page(slot, active->pages[index], (uint8_t)index);
+    rebuild_stat_index();
+
+    lv_mem_monitor_t mon_post;
+    lv_mem_monitor(&mon_post);
+    Serial.printf("[ui] Realized page %d (%zu widgets) in %lums, LVGL mem +%d, %u/%u shared styles\n",
+                  index + 1, active->pages[index].widgets.size(), (unsigned long)(millis() - t0),
+                  (int32_t)(mon_pre.free_size - mon_post.free_size),
+                  (unsigned)button_styles.size(), (unsigned)text_styles.size());
+    return slot.container;
+}
+
+// --- Background page builds (ui_jobs.h) ---
+//
+// A prefetched page is built a widget per slice into a hidden container
+// that only becomes slot.container on the last one, so everything else
+// treats it as unrealized until then. Showing it finishes the job first.
+
+static const PageConfig *active_page_config(int index) {
+    const ProfileConfig *active = g_active_config ? g_active_config->get_active_profile() : nullptr;
+    return active && index < (int)active->pages.size() ? &active->pages[index] : nullptr;
+}
+
+static bool page_build_step(void *arg) {
+    int pi = (int)(intptr_t)arg;
+    PageSlot &slot = pages[pi];
+    const PageConfig *page = active_page_config(pi);
+    if (!page) return false;   // Profile changed under it: end() discards the partial page
+    if (!slot.job_container) {
+        slot.job_container = build_page_begin(slot, *page, (uint8_t)pi);
+        slot.job_next = 0;
+        return true;
+    }
+    if (slot.job_next < page->widgets.size()) {
+        build_page_widget(slot, slot.job_container, *page, (uint8_t)pi, slot.job_next++);
+        return true;
+    }
+    evict_lru(current_page);   // Room for it, counted from now
+    build_page_end(slot, slot.job_container, *page);
+    slot.job_container = nullptr;
+    rebuild_stat_index();
+    return false;
+}
+
+static void page_build_end(void *arg, bool) {
+    int pi = (int)(intptr_t)arg;
+    PageSlot &slot = pages[pi];
+    slot.job = 0;
+    if (slot.job_container) {
+        // Cancelled (or its config went away) part way through
+        lv_obj_del(slot.job_container);
+        slot.job_container = nullptr;
+        page_bg_release(slot);
+        slot.widgets.clear();
+        action_table_clear(slot.actions);
+        erase_page_refs(pi);
+        rebuild_stat_index();
+        return;
+    }
+    if (!slot.container) return;
+    slot.last_used = page_use_clock;   // As recent as the page it neighbours
+    widgets_tick(WIDGET_TICK_ALL, pi);
+    if (page_prefetch_timer) lv_timer_resume(page_prefetch_timer);   // Layer, snapshot, next neighbour
+}
+
+static void page_job_cancel(int index) {
+    if (pages[index].job) ui_job_cancel(pages[index].job);
+}
+
+static void cancel_page_jobs() {
+    for (int pi = 0; pi < (int)pages.size(); pi++) page_job_cancel(pi);
+}
+
+// Build the nearest unrealized neighbour of the current page once input is
+// idle: one page at a time, as a background job, so no frame stalls on it
+static void page_prefetch_cb(lv_timer_t *timer) {
+    if (lv_disp_get_inactive_time(NULL) < UI_PREFETCH_IDLE_MS) return;
+    if (bake_page_layer(current_page)) return;   // Before its snapshot: same pixels, fewer objects
+    if (UI_PAGE_SNAPSHOTS && !snapshot_taken_this_visit && !overlay_showing() &&
+        lv_scr_act() == pages_parent) {
+        snapshot_taken_this_visit = true;
+        capture_page_snapshot(current_page);   // As it looks now, values and all
+        return;
+    }
+    int max_neighbours = UI_PAGE_CACHE_SIZE - 1;
+    const int candidates[2] = {current_page + 1, current_page - 1};
+    for (int n = 0; n < 2 && n < max_neighbours; n++) {
+        int pi = candidates[n];
+        if (pi < 0 || pi >= (int)pages.size() || pages[pi].container) continue;
+        if (pages[pi].job) {
+            lv_timer_pause(timer);   // page_build_end() resumes it
+            return;
+        }
+        if (!active_page_config(pi)) continue;
+        pages[pi].job = ui_job_start("page build", UI_JOB_IDLE, page_build_step, page_build_end, (void *)(intptr_t)pi);
+        if (pages[pi].job) {
+            lv_timer_pause(timer);
+            return;
+        }
+        if (!realize_page(pi, current_page)) continue;   // No job slot: the old way, in one go
+        page_build_end((void *)(intptr_t)pi, true);
+        return;
+    }
+    for (int n = 0; n < 2; n++) {
+        if (bake_page_layer(candidates[n])) return;
+    }
+    // Snapshot slots left over after the current page go to its neighbours
+    for (int n = 0; n < 2 && n < UI_PAGE_SNAPSHOTS - 1; n++) {
+        int pi = candidates[n];
+        if (pi < 0 || pi >= (int)pages.size() || !pages[pi].container || find_snapshot(pi)) continue;
+        widgets_tick(WIDGET_TICK_ALL, pi);   // As it will look when shown
+        capture_page_snapshot(pi);
+        return;
+    }
+#if UI_PROFILE_PREFETCH
+    AppConfig &cfg = get_global_config();
+    while (profile_prefetch_next < cfg.profiles.size()) {
+        ProfileConfig &profile = cfg.profiles[profile_prefetch_next++];
+        if (profile.loaded) continue;
+        config_load_profile(profile);  // Only touches inactive profiles: no live pointers into it
+        return;
+    }
+#endif
+    lv_timer_pause(timer);
+}
+
+static void show_page(int index) {
+    if (index < 0 || index >= (int)pages.size()) return;
+    if (!realize_page(index, -1)) return;
+
+    // Hide all pages
+    for (auto &slot : pages) {
+        if (slot.container) lv_obj_add_flag(slot.container, LV_OBJ_FLAG_HIDDEN);
+    }
+
+    // Show target page, caught up on what its widgets skipped while hidden
+    widgets_tick(WIDGET_TICK_ALL, index);
+    lv_obj_clear_flag(pages[index].container, LV_OBJ_FLAG_HIDDEN);
+    if (index != current_page) snapshot_taken_this_visit = false;
+    current_page = index;
+    hit_page = index;
+    runtime_state_set_page((uint8_t)index);
+    pages[index].last_used = ++page_use_clock;
+    snapshot_overlay_show(index);
+
+    if (page_prefetch_timer && UI_PAGE_CACHE_SIZE > 1) {
+        lv_timer_reset(page_prefetch_timer);
+        lv_timer_resume(page_prefetch_timer);
+    }
+    Serial.printf("[ui] Showing page %d/%zu\n", index + 1, pages.size());
+    stats_subscribe(false);
+}
+
+void ui_next_page() {
+    if (current_page < (int)pages.size() - 1) {
+        show_page(current_page + 1);
+    }
+}
+
+void ui_prev_page() {
+    if (current_page > 0) {
+        show_page(current_page - 1);
+    }
+}
+
+void ui_swipe_page(int dir) {
+    int from = current_page, to = current_page + dir;
+    if (dir == 0 || to < 0 || to >= (int)pages.size()) return;
+    show_page(to);
+    PageSnapshot *out = find_snapshot(from);
+    PageSnapshot *in = find_snapshot(to);
+    if (current_page != to || !out || !in || !overlay_showing() || !power_animations_enabled()) return;
+
+    // Strip = [left | right]; slide it one screen so the incoming page ends up in view
+    lv_img_set_src(snap_img[0], dir > 0 ? &out->img : &in->img);
+    lv_img_set_src(snap_img[1], dir > 0 ? &in->img : &out->img);
+    lv_anim_t a;
+    lv_anim_init(&a);
+    lv_anim_set_var(&a, snap_strip);
+    lv_anim_set_exec_cb(&a, snap_strip_x_cb);
+    lv_anim_set_values(&a, dir > 0 ? 0 : -DISPLAY_WIDTH, dir > 0 ? -DISPLAY_WIDTH : 0);
+    lv_anim_set_time(&a, UI_SWIPE_ANIM_MS);
+    lv_anim_set_path_cb(&a, lv_anim_path_ease_out);
+    lv_anim_set_ready_cb(&a, [](lv_anim_t *) { snap_shown_ms = millis(); });
+    lv_anim_start(&a);
+}
+
 void ui_goto_page(int page_index) {
-    if (page_index >= 0 && page_index < (int)page_containers.size()) {
+    if (page_index >= 0 && page_index < (int)pages.size()) {
         show_page(page_index);
     }
 }
 
 int ui_get_current_page() { return current_page; }
-int ui_get_page_count() { return (int)page_containers.size(); }
+int ui_get_page_count() { return (int)pages.size(); }
+
+// ============================================================
+//  Profile switching
+// ============================================================
+bool ui_switch_profile(const char *name) {
+    AppConfig &cfg = get_global_config();
+    ProfileConfig *target = name ? cfg.get_profile(name) : nullptr;
+    if (!target) {
+        Serial.printf("[ui] Profile switch: no profile '%s'\n", name ? name : "");
+        return false;
+    }
+    if (target->name == cfg.active_profile_name) return true;
+
+    uint32_t t0 = millis();
+    bool was_loaded = target->loaded;
+    if (!config_load_profile(*target) || target->pages.empty()) {
+        Serial.printf("[ui] Profile switch: '%s' has no pages, staying on '%s'\n",
+                      target->name.c_str(), cfg.active_profile_name.c_str());
+        return false;
+    }
+    cfg.active_profile_name = target->name;
+    rebuild_target_page = 0;
+    request_ui_rebuild();
+    Serial.printf("[ui] Profile switch -> '%s' (%s, %lums)\n", target->name.c_str(),
+                  was_loaded ? "prefetched" : "parsed now", (unsigned long)(millis() - t0));
+    return true;
+}
+
+bool ui_switch_profile_index(int profile_index) {
+    const AppConfig &cfg = get_global_config();
+    if (profile_index < 0 || profile_index >= (int)cfg.profiles.size()) {
+        Serial.printf("[ui] Profile switch: index %d out of range\n", profile_index);
+        return false;
+    }
+    return ui_switch_profile(cfg.profiles[profile_index].name.c_str());
+}
+
+int ui_active_profile_index() {
+    const AppConfig &cfg = get_global_config();
+    for (int i = 0; i < (int)cfg.profiles.size(); i++) {
+        if (cfg.profiles[i].name == cfg.active_profile_name) return i;
+    }
+    return -1;
+}
+
+void ui_next_profile() {
+    const AppConfig &cfg = get_global_config();
+    int n = (int)cfg.profiles.size();
+    if (n < 2) return;
+    int cur = ui_active_profile_index();
+    if (cur < 0) cur = 0;
+    // Skip profiles that fail to load rather than getting stuck on them
+    for (int step = 1; step < n; step++) {
+        if (ui_switch_profile_index((cur + step) % n)) return;
+    }
+}
+
+bool ui_run_widget_action(int page_idx, int widget_idx) {
+    return run_widget_action(page_idx, widget_idx);
+}
 
 lv_obj_t* ui_get_widget_obj(int page_idx, int widget_idx) {
-    if (page_idx < 0 || page_idx >= (int)page_containers.size()) return nullptr;
-    lv_obj_t *page = page_containers[page_idx];
-    int child_count = (int)lv_obj_get_child_cnt(page);
-    if (widget_idx < 0 || widget_idx >= child_count) return nullptr;
-    return lv_obj_get_child(page, widget_idx);
+    if (page_idx < 0 || page_idx >= (int)pages.size()) return nullptr;
+    const PageSlot &slot = pages[page_idx];  // Empty when not realized
+    if (widget_idx < 0 || widget_idx >= (int)slot.widgets.size()) return nullptr;
+    return slot.widgets[widget_idx];
+}
+
+// Graph histories are sampled for every page, realized or not, so a
+// graph shows its trend the first time its page is visited
+static void sync_graph_histories(const ProfileConfig *active) {
+    for (auto &h : stat_history) h.used = false;
+    for (const PageConfig &page : active->pages) {
+        for (const WidgetConfig &w : page.widgets) {
+            if (w.widget_type == WIDGET_STAT_GRAPH && w.stat_type <= STAT_TYPE_MAX) {
+                history_reserve(w.stat_type, w.graph_points);
+            }
+        }
+    }
+
+    // Drop history rings no graph subscribes to any more; sample only while graphs exist
+    bool any_history = false;
+    for (auto &h : stat_history) {
+        if (h.samples && !h.used) {
+            heap_caps_free(h.samples);
+            h = StatHistory();
+        }
+        if (h.samples) any_history = true;
+    }
+    history_prefill();
+    if (any_history) {
+        if (!stat_graph_timer) stat_graph_timer = lv_timer_create(stat_graph_timer_cb, STAT_GRAPH_SAMPLE_MS, nullptr);
+        else lv_timer_resume(stat_graph_timer);
+    } else if (stat_graph_timer) {
+        lv_timer_pause(stat_graph_timer);
+    }
 }
 
 // ============================================================
-//  Create all pages from config
+//  Touch hit grid: fire-on-press buttons act on touch-down
+//
+//  Rebuilt from the config with the pages, so it covers pages that aren't
+//  realized. Every widget's rectangle goes in, topmost first: the press
+//  fires only when the first rectangle under the finger is a fire-on-press
+//  hotkey. Anything drawn on top of it, clickable or not, leaves the press
+//  to LVGL, which then fires it on LV_EVENT_PRESSED.
+//
+//  The touch-down hook runs on the input task right after the GT911 read
+//  and hands the hit to the UI task with ui_post(), so the action runs at
+//  the top of the next loop() pass, ahead of LVGL reading the press and
+//  drawing the pressed state. ESP-NOW sends stay on the UI task.
+// ============================================================
+struct HitRect {
+    int16_t x1, y1, x2, y2;   // Inclusive
+    uint8_t widget;
+    bool fire;
+};
+
+struct HitGrid {
+    std::vector<HitRect> rects;    // Topmost first
+    std::vector<uint16_t> cells;   // Start of each cell's run in items, plus an end
+    std::vector<uint8_t> items;    // Indices into rects, topmost first
+};
+
+#define HIT_COLS ((DISPLAY_WIDTH + UI_HIT_CELL - 1) / UI_HIT_CELL)
+#define HIT_ROWS ((DISPLAY_HEIGHT + UI_HIT_CELL - 1) / UI_HIT_CELL)
+
+static std::vector<HitGrid> hit_grids;   // Per page; empty grid = no fire-on-press button
+static portMUX_TYPE hit_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static void build_hit_grid(const PageConfig &page, HitGrid &g) {
+    bool any = false;
+    for (const auto &w : page.widgets) {
+        any |= w.widget_type == WIDGET_HOTKEY_BUTTON && w.fire_on_press;
+    }
+    if (!any) return;
+
+    for (int i = (int)page.widgets.size() - 1; i >= 0 && i < CONFIG_MAX_WIDGETS; i--) {
+        const WidgetConfig &w = page.widgets[i];
+        if (w.width <= 0 || w.height <= 0) continue;
+        g.rects.push_back({ (int16_t)w.x, (int16_t)w.y, (int16_t)(w.x + w.width - 1), (int16_t)(w.y + w.height - 1),
+                            (uint8_t)i, w.widget_type == WIDGET_HOTKEY_BUTTON && w.fire_on_press });
+    }
+    g.cells.assign(HIT_COLS * HIT_ROWS + 1, 0);
+    for (int c = 0; c < HIT_COLS * HIT_ROWS; c++) {
+        int cx1 = (c % HIT_COLS) * UI_HIT_CELL, cy1 = (c / HIT_COLS) * UI_HIT_CELL;
+        int cx2 = cx1 + UI_HIT_CELL - 1, cy2 = cy1 + UI_HIT_CELL - 1;
+        g.cells[c] = (uint16_t)g.items.size();
+        for (size_t r = 0; r < g.rects.size(); r++) {
+            const HitRect &h = g.rects[r];
+            if (h.x1 <= cx2 && h.x2 >= cx1 && h.y1 <= cy2 && h.y2 >= cy1) g.items.push_back((uint8_t)r);
+        }
+    }
+    g.cells[HIT_COLS * HIT_ROWS] = (uint16_t)g.items.size();
+}
+
+static void rebuild_hit_grids(const ProfileConfig *active) {
+    std::vector<HitGrid> grids(active ? active->pages.size() : 0);
+    for (size_t pi = 0; pi < grids.size(); pi++) build_hit_grid(active->pages[pi], grids[pi]);
+    portENTER_CRITICAL(&hit_mux);
+    hit_grids.swap(grids);
+    portEXIT_CRITICAL(&hit_mux);
+}   // The old grids are freed here, outside the critical section
+
+// UI task: the hit from the input task, arg = contact << 16 | page << 8 | widget
+static void fast_press_cb(uint32_t arg) {
+    uint16_t contact = arg >> 16;
+    int page = (arg >> 8) & 0xFF, widget = arg & 0xFF;
+    if (fired_contact == contact) return;   // LVGL's PRESSED was faster
+    // Only what the user is looking at: the hotkey view, on the page hit
+    if (display_get_mode() != MODE_HOTKEYS || lv_scr_act() != pages_parent || page != current_page) return;
+    const ProfileConfig *active = g_active_config ? g_active_config->get_active_profile() : nullptr;
+    if (!active || page >= (int)active->pages.size() || widget >= (int)active->pages[page].widgets.size()) return;
+    const WidgetConfig &w = active->pages[page].widgets[widget];
+    if (w.widget_type != WIDGET_HOTKEY_BUTTON || !w.fire_on_press || !pages[page].container) return;
+
+    fired_contact = contact;
+    run_widget_action(page, widget);
+}
+
+// Input task (touch_poll): first finger down at x, y
+static void touch_down_hit(uint16_t x, uint16_t y) {
+    uint16_t contact = hit_contact + 1;
+    hit_contact = contact;
+    if (x >= DISPLAY_WIDTH || y >= DISPLAY_HEIGHT) return;
+    int page = hit_page, widget = -1;
+    portENTER_CRITICAL(&hit_mux);
+    if (page >= 0 && page < (int)hit_grids.size() && !hit_grids[page].cells.empty()) {
+        const HitGrid &g = hit_grids[page];
+        int c = (y / UI_HIT_CELL) * HIT_COLS + x / UI_HIT_CELL;
+        for (uint16_t i = g.cells[c]; i < g.cells[c + 1]; i++) {
+            const HitRect &h = g.rects[g.items[i]];
+            if (x < h.x1 || x > h.x2 || y < h.y1 || y > h.y2) continue;
+            if (h.fire) widget = h.widget;
+            break;   // Topmost widget under the finger decides
+        }
+    }
+    portEXIT_CRITICAL(&hit_mux);
+    if (widget < 0) return;
+    trace(TR_TOUCH_HIT, page << 8 | widget, contact);
+    ui_post(fast_press_cb, (uint32_t)contact << 16 | page << 8 | widget);
+}
+
+// ============================================================
+//  Create page slots from config (widgets are built on first show)
 // ============================================================
 static void create_pages(lv_obj_t *screen, const AppConfig *cfg) {
+    cancel_page_jobs();
     // Clear tracking arrays
     stat_widget_refs.clear();
+    for (auto &idx : stat_index) idx.clear();
+    stat_graph_refs.clear();
     status_bar_refs.clear();
     page_nav_refs.clear();
     clock_widget_labels.clear();
-    page_containers.clear();
-    btn_event_count = 0;
+    for (auto &a : stat_alerts) alert_unbind(a);   // Their pages are gone
+    drop_all_page_snapshots();
+    pages.clear();
+    pages_parent = screen;
 
     const ProfileConfig *active = cfg->get_active_profile();
+    rebuild_hit_grids(active);
+    touch_set_down_hook(touch_down_hit);
     if (!active) {
         Serial.println("[ui] No active profile");
         return;
     }
 
-    for (size_t pi = 0; pi < active->pages.size(); pi++) {
-        const PageConfig &page = active->pages[pi];
-
-        // Create a full-screen container for this page
-        lv_obj_t *container = lv_obj_create(screen);
-        lv_obj_set_size(container, DISPLAY_WIDTH, DISPLAY_HEIGHT);
-        lv_obj_set_pos(container, 0, 0);
-        // Default layout is none (absolute positioning) in LVGL v8
-        lv_obj_set_style_bg_color(container, lv_color_hex(0x0D1117), LV_PART_MAIN);
-        lv_obj_set_style_bg_opa(container, LV_OPA_COVER, LV_PART_MAIN);
-        lv_obj_set_style_border_width(container, 0, LV_PART_MAIN);
-        lv_obj_set_style_radius(container, 0, LV_PART_MAIN);
-        lv_obj_set_style_pad_all(container, 0, LV_PART_MAIN);
-        lv_obj_clear_flag(container, LV_OBJ_FLAG_SCROLLABLE);
-
-        // Background image from SD card (rendered behind all widgets)
-        if (!page.bg_image.empty() && SD.exists(page.bg_image.c_str())) {
-            std::string bg_src = "S:" + page.bg_image;
-            lv_obj_t *bg = lv_img_create(container);
-            lv_img_set_src(bg, bg_src.c_str());
-            lv_obj_set_size(bg, DISPLAY_WIDTH, DISPLAY_HEIGHT);
-            lv_obj_set_pos(bg, 0, 0);
-            lv_obj_clear_flag(bg, LV_OBJ_FLAG_CLICKABLE);
+    pages.resize(active->pages.size());
+    profile_prefetch_next = 0;
+
+    sync_graph_histories(active);
+    sync_stat_alerts(active);
+
+    if (!page_prefetch_timer) page_prefetch_timer = lv_timer_create(page_prefetch_cb, UI_PREFETCH_IDLE_MS, nullptr);
+    lv_timer_pause(page_prefetch_timer);
+
+    current_page = 0;
+    page_use_clock = 0;
+    show_page(0);
+
+    Serial.printf("[ui] Created %zu pages (cache %d), %zu stat widgets on page 1\n",
+                  pages.size(), UI_PAGE_CACHE_SIZE, stat_widget_refs.size());
+}
+
+// ============================================================
+//  Public: update_stats()
+// ============================================================
+// --- Stat label interpolation (see STAT_ANIM_FPS) ---
+
+static int32_t stat_anim_value(const StatWidgetRef &ref, uint32_t now) {
+    uint32_t t = now - ref.anim_start_ms;
+    if (t >= ref.anim_ms) return ref.anim_to;
+    // Ease-out, as lv_anim_path_ease_out: most of the change shows at once
+    uint32_t p = lv_bezier3(t * LV_BEZIER_VAL_MAX / ref.anim_ms, 0, 900, 950, LV_BEZIER_VAL_MAX);
+    int64_t v = ref.anim_from + (int64_t)(ref.anim_to - ref.anim_from) * (int32_t)p / LV_BEZIER_VAL_MAX;
+    // Whole degrees stay whole: no "45.3°C" on the way from 45 to 47
+    if (stat_in_tenths(ref.stat_type) && ref.anim_from % 10 == 0 && ref.anim_to % 10 == 0) {
+        v = (v + (v < 0 ? -5 : 5)) / 10 * 10;
+    }
+    return (int32_t)v;
+}
+
+static void stat_anim_timer_cb(lv_timer_t *timer) {
+    uint32_t now = millis();
+    bool moving = false;
+    for (auto &ref : stat_widget_refs) {
+        if (!ref.animating) continue;
+        show_stat_ref(ref, stat_anim_value(ref, now));
+        if (now - ref.anim_start_ms >= ref.anim_ms) ref.animating = false;
+        else moving = true;
+    }
+    if (!moving) lv_timer_pause(timer);
+}
+
+// Count the label to `value`, or set it where that isn't worth a frame
+static void animate_stat_ref(StatWidgetRef &ref, int32_t value) {
+    uint8_t type = ref.stat_type;
+    uint16_t interval = stat_interval_ms[type];
+    if (!STAT_ANIM_FPS || !ref.has_value || ref.last_value == STAT_NA || value == STAT_NA ||
+        type == STAT_UPTIME_HOURS || type == STAT_DISPLAY_UPTIME || interval < STAT_LIVE_INTERVAL_MS ||
+        ref.page_idx != current_page || lv_scr_act() != main_screen || !power_animations_enabled()) {
+        set_stat_ref(ref, value);
+        return;
+    }
+    if (ref.animating ? ref.anim_to == value : ref.last_value == value) return;
+    ref.anim_from = ref.last_value;   // Where a count in progress has got to
+    ref.anim_to = value;
+    ref.anim_start_ms = millis();
+    ref.anim_ms = interval < STAT_ANIM_MAX_MS ? interval : STAT_ANIM_MAX_MS;
+    ref.animating = true;
+
+    uint32_t fps = power_get_state() == POWER_DIMMED ? STAT_ANIM_DIM_FPS : STAT_ANIM_FPS;
+    uint32_t period = 1000 / fps;
+    if (!stat_anim_timer) {
+        stat_anim_timer = lv_timer_create(stat_anim_timer_cb, period, nullptr);
+    } else {
+        lv_timer_set_period(stat_anim_timer, period);
+        lv_timer_resume(stat_anim_timer);
+    }
+}
+
+static void apply_stat_labels(uint8_t type, int32_t value) {
+    stat_label_ms[type] = millis();
+    for (uint16_t i : stat_index[type]) {
+        StatWidgetRef &ref = stat_widget_refs[i];
+        if (!ref.label || ref.remote || stat_ref_host(ref) != ESPNOW_HOST_NONE) continue;
+#if UI_DEFER_HIDDEN_STAT_UPDATES
+        if (ref.page_idx != current_page) continue;  // refresh_page_stats() on show
+#endif
+        animate_stat_ref(ref, value);
+    }
+}
+
+static void stat_flush_timer_cb(lv_timer_t *timer) {
+    for (uint8_t type = 1; type <= STAT_TYPE_MAX; type++) {
+        if (!(stat_dirty[type / 8] & (1 << (type % 8)))) continue;
+        stat_dirty[type / 8] &= ~(1 << (type % 8));
+        apply_stat_labels(type, stat_cache[type]);
+    }
+    stat_flush_pending = false;
+    lv_timer_pause(timer);
+}
+
+// Wire value -> stat_cache units (see there)
+static int32_t stat_normalize(uint8_t type, int32_t value, bool tenths) {
+    if (!tenths && !stat_is_wide(type) && value == 0xFF) return STAT_NA;
+    if (stat_in_tenths(type) && !tenths) {
+        const int32_t lim = INT32_MAX / 10;
+        return (value > lim ? lim : value < -lim ? -lim : value) * 10;
+    }
+    if (!stat_in_tenths(type) && tenths) return (value + (value < 0 ? -5 : 5)) / 10;
+    return value;
+}
+
+static void host_stat_store(uint8_t host, uint8_t type, int32_t value, uint32_t now) {
+    HostStats &hs = host_stats[host];
+    hs.value[type] = value;
+    hs.ms[type] = now;
+    hs.valid[type] = true;
+}
+
+// A stat from a background host: its cache, plus the widgets pinned to it
+static void update_host_stat(uint8_t type, int32_t value, bool tenths = false) {
+    if (type > STAT_TYPE_MAX) return;
+    value = stat_normalize(type, value, tenths);
+    host_stat_store(decode_host, type, value, millis());
+    for (uint16_t i : stat_index[type]) {
+        StatWidgetRef &ref = stat_widget_refs[i];
+        if (!ref.label || ref.remote || ref.host != decode_host + 1) continue;
+#if UI_DEFER_HIDDEN_STAT_UPDATES
+        if (ref.page_idx != current_page) continue;
+#endif
+        set_stat_ref(ref, value);
+    }
+}
+
+static void update_stat_widget(uint8_t type, int32_t value, bool tenths = false) {
+    if (type > STAT_TYPE_MAX) return;
+    value = stat_normalize(type, value, tenths);
+    uint32_t now = millis();
+    host_stat_store(stats_host, type, value, now);
+    if (stat_cache_valid[type]) {
+        uint32_t dt = now - stat_cache_ms[type];
+        if (dt > 0xFFFF) dt = 0xFFFF;
+        stat_interval_ms[type] = stat_interval_ms[type]
+            ? (uint16_t)((stat_interval_ms[type] * 3 + dt) / 4) : (uint16_t)dt;
+    }
+    stat_cache[type] = value;
+    stat_cache_valid[type] = true;
+    stat_cache_ms[type] = now;
+    alerts_check(type, value);
+
+    if (now - stat_label_ms[type] >= STAT_LABEL_MIN_MS) {
+        stat_dirty[type / 8] &= ~(1 << (type % 8));
+        apply_stat_labels(type, value);
+        return;
+    }
+    stat_dirty[type / 8] |= 1 << (type % 8);
+    if (stat_flush_pending) return;  // Already scheduled: don't push it back
+    stat_flush_pending = true;
+    if (!stat_flush_timer) {
+        stat_flush_timer = lv_timer_create(stat_flush_timer_cb, STAT_LABEL_MIN_MS, nullptr);
+    } else {
+        lv_timer_reset(stat_flush_timer);
+        lv_timer_resume(stat_flush_timer);
+    }
+}
+
+typedef void (*StatSink)(uint8_t type, int32_t value, bool tenths);
+
+static void update_stats_legacy(const StatsPayload *stats, StatSink sink) {
+    sink(STAT_CPU_PERCENT, stats->cpu_percent, false);
+    sink(STAT_RAM_PERCENT, stats->ram_percent, false);
+    sink(STAT_GPU_PERCENT, stats->gpu_percent, false);
+    sink(STAT_CPU_TEMP, stats->cpu_temp, false);
+    sink(STAT_GPU_TEMP, stats->gpu_temp, false);
+    sink(STAT_DISK_PERCENT, stats->disk_percent, false);
+    sink(STAT_NET_UP, stats->net_up_kbps, false);
+    sink(STAT_NET_DOWN, stats->net_down_kbps, false);
+}
+
+void update_stats(const uint8_t *data, uint8_t len, bool tlv, uint8_t host) {
+    if (!data || len == 0 || host >= ESPNOW_MAX_HOSTS) return;
+
+    // The active host drives everything; the others only their caches and pinned widgets
+    StatSink sink = host == stats_host ? update_stat_widget : update_host_stat;
+    decode_host = host;
+    if (!tlv && len >= sizeof(StatsPayload) && data[0] > STAT_TYPE_MAX) {
+        update_stats_legacy((const StatsPayload *)data, sink);
+    } else {
+        tlv_decode_stats(data, len, sink);
+    }
+}
+
+// A remote collector's stat: its cache and the monitors pinned to it
+static uint8_t decode_remote = 0;   // Id of the MSG_HOST_STATS being decoded
+
+static void update_remote_stat(uint8_t type, int32_t value, bool tenths) {
+    if (type > STAT_TYPE_MAX || type == STAT_DISPLAY_UPTIME) return;
+    value = stat_normalize(type, value, tenths);
+    HostStats &rs = remote_stats[decode_remote - 1];
+    rs.value[type] = value;
+    rs.ms[type] = millis();
+    rs.valid[type] = true;
+    for (uint16_t i : stat_index[type]) {
+        StatWidgetRef &ref = stat_widget_refs[i];
+        if (!ref.label || ref.remote != decode_remote) continue;
+#if UI_DEFER_HIDDEN_STAT_UPDATES
+        if (ref.page_idx != current_page) continue;
+#endif
+        set_stat_ref(ref, value);
+    }
+}
+
+void update_remote_stats(uint8_t remote, const uint8_t *data, uint8_t len) {
+    if (remote < 1 || remote > REMOTE_HOST_MAX || !data || len == 0) return;
+    if (data[0] == 0) {
+        // Unreachable: its monitors back to the placeholder
+        remote_stats[remote - 1] = HostStats();
+        for (auto &ref : stat_widget_refs) {
+            if (ref.label && ref.remote == remote) clear_stat_ref(ref);
         }
+        return;
+    }
+    decode_remote = remote;
+    tlv_decode_stats(data, len, update_remote_stat);
+}
+
+// stat_cache, labels, alerts and graphs over to another host's values
+static void stats_switch_host(uint8_t host) {
+    if (host == stats_host) return;
+    stats_host = host;
+    const HostStats &hs = host_stats[host];
+    for (uint8_t type = 1; type <= STAT_TYPE_MAX; type++) {
+        if (type == STAT_DISPLAY_UPTIME) continue;   // The display's own
+        stat_cache[type] = hs.valid[type] ? hs.value[type] : STAT_NA;
+        stat_cache_valid[type] = hs.valid[type];
+        stat_cache_ms[type] = hs.ms[type];
+        stat_interval_ms[type] = 0;
+        stat_dirty[type / 8] &= ~(1 << (type % 8));
+        if (hs.valid[type]) alerts_check(type, hs.value[type]);
+        // The other host's history would plot as one line: start over
+        StatHistory &h = stat_history[type];
+        h.count = h.head = 0;
+        h.peak = h.peak_age = 0;
+        h.prefilled = false;
+    }
+    for (auto &g : stat_graph_refs) {
+        lv_chart_set_all_value(g.chart, g.series, LV_CHART_POINT_NONE);
+    }
+    history_prefill();   // The new host's own trend, if it was logged
+    // Pinned refs too: the one pinned to the new host now reads stat_cache,
+    // the one pinned to the old host its cache.
+    for (auto &ref : stat_widget_refs) {
+        if (!ref.label || ref.remote || ref.stat_type == STAT_DISPLAY_UPTIME) continue;
+#if UI_DEFER_HIDDEN_STAT_UPDATES
+        if (ref.page_idx != current_page) {
+            ref.has_value = false;   // refresh_page_stats() on show
+            continue;
+        }
+#endif
+        int32_t value;
+        if (stat_ref_value(ref, value)) set_stat_ref(ref, value);
+        else clear_stat_ref(ref);
+    }
+}
+
+// ============================================================
+//  Hosts (several bridges, one active)
+// ============================================================
+bool ui_select_host(int slot) {
+    uint8_t prev = espnow_active_host();
+    if (slot < 0 || slot >= espnow_host_count()) return false;
+    if (slot == prev) return true;
+    if (!espnow_select_host((uint8_t)slot)) return false;
+
+    AppConfig &cfg = get_global_config();
+    if (prev < ESPNOW_MAX_HOSTS) host_profile[prev] = cfg.active_profile_name;
+    stats_switch_host((uint8_t)slot);
+    stats_subscribe(true);   // The new host's companion hasn't heard it yet
+
+    // Back to what this host showed last, else the first profile made for it
+    const ProfileConfig *target = cfg.get_profile(host_profile[slot].c_str());
+    if (!target) {
+        for (const ProfileConfig &p : cfg.profiles) {
+            if (p.host == slot + 1) { target = &p; break; }
+        }
+    }
+    if (target) ui_switch_profile(target->name.c_str());
+
+    char summary[32];
+    snprintf(summary, sizeof(summary), "Host %d of %u%s", slot + 1, espnow_host_count(),
+             espnow_host_linked((uint8_t)slot) ? "" : " (not linked)");
+    show_notification_toast("Display", summary, "", NOTIF_LOW);
+    return true;
+}
+
+void ui_next_host() {
+    uint8_t n = espnow_host_count();
+    if (n < 2) return;
+    ui_select_host((espnow_active_host() + 1) % n);
+}
+
+void ui_pair_host() {
+    espnow_pair_new_host();
+    show_notification_toast("Display", "Pairing a new host",
+                            "Start the companion on the other PC", NOTIF_LOW);
+}
+
+// ============================================================
+//  Stats subscription (MSG_STATS_SUBSCRIBE)
+//
+// The active host's companion only collects what the display needs: stat
+// monitors (and graph captions) on the page shown, plus every graph history
+// and alert rule of the profile, which follow their stat from any page.
+// Widgets pinned to another host or to a remote collector don't count. The
+// status bar shows no host stats; clock and picture frame show none.
+// ============================================================
+enum SubView : uint8_t {
+    SUB_VIEW_PAGES,      // main_screen
+    SUB_VIEW_STANDBY,    // CPU / RAM / GPU line
+    SUB_VIEW_NONE,       // Clock, picture frame
+};
+static SubView sub_view = SUB_VIEW_PAGES;
+static uint32_t sub_sent = 0;
+static bool sub_valid = false;       // sub_sent went out (to the active host)
+static lv_timer_t *sub_timer = nullptr;
+
+static uint32_t stats_subscription() {
+    uint32_t types = 0;
+    auto add = [&types](uint8_t type) {
+        if (type && type <= STAT_TYPE_MAX && type != STAT_DISPLAY_UPTIME) types |= 1UL << type;
+    };
+    if (sub_view == SUB_VIEW_PAGES) {
+        for (const auto &ref : stat_widget_refs) {
+            if (ref.label && ref.page_idx == current_page && !ref.remote &&
+                stat_ref_host(ref) == ESPNOW_HOST_NONE) {
+                add(ref.stat_type);
+            }
+        }
+    } else if (sub_view == SUB_VIEW_STANDBY) {
+        add(STAT_CPU_PERCENT);
+        add(STAT_RAM_PERCENT);
+        add(STAT_GPU_PERCENT);
+    }
+    for (uint8_t type = 1; type <= STAT_TYPE_MAX; type++) {
+        if (stat_history[type].used || !alert_index[type].empty()) add(type);
+    }
+    return types;
+}
+
+// Send the subscription if it changed (or always, with `force`)
+static void stats_subscribe(bool force) {
+    if (!UI_STATS_SUBSCRIBE) return;   // The companion sends everything configured
+    uint32_t types = stats_subscription();
+    if (!force && sub_valid && types == sub_sent) return;
+    StatsSubscribeMsg msg = { types };
+    if (!espnow_send_reliable(MSG_STATS_SUBSCRIBE, (const uint8_t *)&msg, sizeof(msg))) return;
+    if (types != sub_sent || !sub_valid) Serial.printf("[ui] Stats subscription 0x%08lX\n", (unsigned long)types);
+    sub_sent = types;
+    sub_valid = true;
+}
+
+static void stats_set_view(SubView view) {
+    sub_view = view;
+    stats_subscribe(false);
+}
+
+// ============================================================
+//  Status bars (driven by status_store.h)
+// ============================================================
+static void apply_status_bar(const StatusBarRef &ref, const StatusState &st, uint8_t changed) {
+    if (ref.rssi_label && (changed & (STATUS_RSSI | STATUS_LINK))) {
+        uint32_t color = !st.linked ? CLR_GREY : rssi_color(st.rssi_bucket);
+        lv_obj_set_style_text_color(ref.rssi_label, lv_color_hex(color), LV_PART_MAIN);
+    }
+    if (ref.pc_label && (changed & STATUS_PC)) {
+        lv_obj_set_style_text_color(ref.pc_label,
+            lv_color_hex(st.pc_active ? CLR_GREEN : CLR_RED), LV_PART_MAIN);
+    }
+    if (ref.battery_label && (changed & STATUS_BATTERY)) {
+        char text[32];
+        format_battery(text, sizeof(text), st);
+        label_set_text_if_changed(ref.battery_label, text);
+        lv_obj_set_style_text_color(ref.battery_label,
+            lv_color_hex(battery_color(st.battery_policy)), LV_PART_MAIN);
+    }
+    // Status bar time stays blank until the clock has been synced
+    if (ref.time_label && (changed & STATUS_MINUTE) && st.time_synced) {
+        char text[8];
+        format_clock(text, sizeof(text), st);
+        label_set_text_if_changed(ref.time_label, text);
+    }
+}
 
-        // Render all widgets
-        for (size_t wi = 0; wi < page.widgets.size(); wi++) {
-            render_widget(container, &page.widgets[wi], (uint8_t)pi, (uint8_t)wi);
+static void tick_status_bars(uint8_t events, int page_idx) {
+    const StatusState &st = status_get();
+    uint8_t changed = events & WIDGET_TICK_PAGE ? STATUS_ALL : events;
+    for (auto &ref : status_bar_refs) {
+        if (page_idx < 0 || ref.page_idx == page_idx) apply_status_bar(ref, st, changed);
+    }
+}
+
+static void on_status_changed(const StatusState &st, uint8_t changed) {
+    // Current page only: the others catch up in show_page()
+    widgets_tick(changed, current_page);
+    // Graph rings waiting for the wall clock to read the stats log
+    if ((changed & STATUS_MINUTE) && st.time_synced) history_prefill();
+    // Bridge back: the companion may have restarted meanwhile
+    if ((changed & STATUS_LINK) && st.linked) stats_subscribe(true);
+    // Clock screen: only while shown, show_clock_mode() refreshes it on entry
+    if (clock_screen && lv_scr_act() == clock_screen &&
+        (changed & (STATUS_MINUTE | STATUS_RSSI))) {
+        update_clock_time();
+    }
+}
+
+// ============================================================
+//  Notification Toast
+//
+// One toast widget on the top layer, built on first use and only re-texted
+// afterwards. Notifications wait in a small queue ordered by urgency, then
+// arrival; a repeat from an app already queued or on screen is folded into
+// that entry ("Slack - 3 new") instead of taking another slot, and a
+// critical one preempts whatever is showing. The fade-out animates a
+// snapshot of the toast, so each frame is one image blend over the page
+// instead of re-rendering the panel, its shadow and three labels.
+// ============================================================
+#define TOAST_QUEUE_LEN   6
+#define TOAST_FADE_MS     300
+#define TOAST_W           600
+#define TOAST_H           120
+
+struct ToastEntry {
+    char app_name[NOTIF_APP_MAX];
+    char summary[NOTIF_SUMMARY_MAX];
+    char body[NOTIF_BODY_MAX];
+    uint8_t urgency;      // NotifUrgency
+    uint16_t count;       // Notifications folded into this one
+    uint32_t seq;         // Arrival order
+};
+
+static ToastEntry toast_queue[TOAST_QUEUE_LEN];
+static int toast_queued = 0;
+static ToastEntry toast_shown;
+static bool toast_showing = false;
+static uint32_t toast_seq = 0;
+static uint32_t toast_dropped = 0;
+
+static lv_obj_t *toast_panel = nullptr;
+static lv_obj_t *toast_app_lbl = nullptr;
+static lv_obj_t *toast_sum_lbl = nullptr;
+static lv_obj_t *toast_body_lbl = nullptr;
+static lv_obj_t *toast_fade_img = nullptr;
+static lv_img_dsc_t toast_snapshot = {};
+static void *toast_snapshot_buf = nullptr;
+static uint32_t toast_snapshot_size = 0;
+static lv_timer_t *toast_timer = nullptr;
+
+static void toast_show_next();
+
+static int urgency_rank(uint8_t urgency) {
+    switch (urgency) {
+        case NOTIF_LOW:      return 0;
+        case NOTIF_CRITICAL: return 2;
+        default:             return 1;
+    }
+}
+
+static uint32_t toast_dwell_ms(uint8_t urgency) {
+    switch (urgency) {
+        case NOTIF_LOW:      return 3000;
+        case NOTIF_CRITICAL: return 10000;
+        default:             return 5000;
+    }
+}
+
+// a goes before b
+static bool toast_before(const ToastEntry &a, const ToastEntry &b) {
+    if (urgency_rank(a.urgency) != urgency_rank(b.urgency)) {
+        return urgency_rank(a.urgency) > urgency_rank(b.urgency);
+    }
+    return (int32_t)(a.seq - b.seq) < 0;
+}
+
+static void toast_hide() {
+    if (toast_panel) lv_obj_add_flag(toast_panel, LV_OBJ_FLAG_HIDDEN);
+    if (toast_fade_img) {
+        lv_anim_del(toast_fade_img, nullptr);
+        lv_obj_add_flag(toast_fade_img, LV_OBJ_FLAG_HIDDEN);
+    }
+    if (toast_timer) lv_timer_pause(toast_timer);
+    toast_showing = false;
+}
+
+static void toast_fade_opa_cb(void *obj, int32_t v) {
+    lv_obj_set_style_img_opa((lv_obj_t *)obj, (lv_opa_t)v, LV_PART_MAIN);
+}
+
+// Dwell over: fade a snapshot of the panel out, then move on
+static void toast_dismiss(bool fade) {
+    if (!toast_showing) return;
+    if (fade && power_animations_enabled()) {
+        uint32_t need = lv_snapshot_buf_size_needed(toast_panel, LV_IMG_CF_TRUE_COLOR_ALPHA);
+        if (need > toast_snapshot_size) {
+            mem_free(MEM_POOL_IMAGES, toast_snapshot_buf);
+            toast_snapshot_buf = mem_alloc(MEM_POOL_IMAGES, need);
+            toast_snapshot_size = toast_snapshot_buf ? need : 0;
+        }
+        if (toast_snapshot_buf &&
+            lv_snapshot_take_to_buf(toast_panel, LV_IMG_CF_TRUE_COLOR_ALPHA, &toast_snapshot,
+                                    toast_snapshot_buf, toast_snapshot_size) == LV_RES_OK) {
+            lv_img_cache_invalidate_src(&toast_snapshot);  // Same descriptor, new pixels
+            lv_img_set_src(toast_fade_img, &toast_snapshot);
+            // The snapshot includes the shadow margin around the panel
+            lv_coord_t ext = _lv_obj_get_ext_draw_size(toast_panel);
+            lv_obj_set_pos(toast_fade_img, lv_obj_get_x(toast_panel) - ext, lv_obj_get_y(toast_panel) - ext);
+            lv_obj_set_style_img_opa(toast_fade_img, LV_OPA_COVER, LV_PART_MAIN);
+            lv_obj_clear_flag(toast_fade_img, LV_OBJ_FLAG_HIDDEN);
+            lv_obj_add_flag(toast_panel, LV_OBJ_FLAG_HIDDEN);
+            if (toast_timer) lv_timer_pause(toast_timer);
+            toast_showing = false;
+
+            lv_anim_t a;
+            lv_anim_init(&a);
+            lv_anim_set_var(&a, toast_fade_img);
+            lv_anim_set_values(&a, LV_OPA_COVER, LV_OPA_TRANSP);
+            lv_anim_set_exec_cb(&a, toast_fade_opa_cb);
+            lv_anim_set_time(&a, TOAST_FADE_MS);
+            lv_anim_set_ready_cb(&a, [](lv_anim_t *anim) {
+                lv_obj_add_flag((lv_obj_t *)anim->var, LV_OBJ_FLAG_HIDDEN);
+                toast_show_next();
+            });
+            lv_anim_start(&a);
+            return;
         }
+    }
+    toast_hide();
+    toast_show_next();
+}
+
+static void toast_create() {
+    // Top layer: stays put across screen switches and UI rebuilds
+    toast_panel = lv_obj_create(lv_layer_top());
+    lv_obj_set_size(toast_panel, TOAST_W, TOAST_H);
+    lv_obj_align(toast_panel, LV_ALIGN_TOP_RIGHT, -20, 50);
+    lv_obj_set_style_bg_color(toast_panel, lv_color_hex(0x1a1a2e), LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(toast_panel, LV_OPA_90, LV_PART_MAIN);
+    lv_obj_set_style_border_color(toast_panel, lv_color_hex(CLR_BLUE), LV_PART_MAIN);
+    lv_obj_set_style_border_width(toast_panel, 2, LV_PART_MAIN);
+    lv_obj_set_style_radius(toast_panel, 12, LV_PART_MAIN);
+    lv_obj_set_style_shadow_width(toast_panel, 12, LV_PART_MAIN);
+    lv_obj_set_style_shadow_opa(toast_panel, LV_OPA_40, LV_PART_MAIN);
+    lv_obj_clear_flag(toast_panel, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_add_flag(toast_panel, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_HIDDEN);
+    lv_obj_add_event_cb(toast_panel, [](lv_event_t *) { toast_dismiss(false); },
+                        LV_EVENT_CLICKED, nullptr);
+
+    toast_app_lbl = lv_label_create(toast_panel);
+    lv_obj_set_style_text_font(toast_app_lbl, &lv_font_montserrat_14, LV_PART_MAIN);
+    lv_obj_set_style_text_color(toast_app_lbl, lv_color_hex(CLR_BLUE), LV_PART_MAIN);
+    lv_obj_align(toast_app_lbl, LV_ALIGN_TOP_LEFT, 12, 8);
+
+    toast_sum_lbl = lv_label_create(toast_panel);
+    lv_obj_set_style_text_font(toast_sum_lbl, &lv_font_montserrat_16, LV_PART_MAIN);
+    lv_obj_set_style_text_color(toast_sum_lbl, lv_color_white(), LV_PART_MAIN);
+    lv_obj_set_width(toast_sum_lbl, TOAST_W - 40);
+    lv_label_set_long_mode(toast_sum_lbl, LV_LABEL_LONG_DOT);
+    lv_obj_align(toast_sum_lbl, LV_ALIGN_TOP_LEFT, 12, 28);
+
+    toast_body_lbl = lv_label_create(toast_panel);
+    lv_label_set_long_mode(toast_body_lbl, LV_LABEL_LONG_DOT);
+    lv_obj_set_size(toast_body_lbl, TOAST_W - 40, TOAST_H - 60);   // Long bodies end in "..."
+    lv_obj_set_style_text_font(toast_body_lbl, &lv_font_montserrat_12, LV_PART_MAIN);
+    lv_obj_set_style_text_color(toast_body_lbl, lv_color_hex(0xBBBBBB), LV_PART_MAIN);
+    lv_obj_align(toast_body_lbl, LV_ALIGN_TOP_LEFT, 12, 52);
+
+    toast_fade_img = lv_img_create(lv_layer_top());
+    lv_obj_clear_flag(toast_fade_img, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_flag(toast_fade_img, LV_OBJ_FLAG_HIDDEN);
+
+    toast_timer = lv_timer_create([](lv_timer_t *) { toast_dismiss(true); }, 5000, nullptr);
+    lv_timer_pause(toast_timer);
+}
+
+// Put `e` on the panel (re-text only) and (re)start its dwell
+static void toast_present(const ToastEntry &e) {
+    if (!toast_panel) toast_create();
+    toast_shown = e;
+    toast_showing = true;
+
+    char app[48];
+    if (e.count > 1) snprintf(app, sizeof(app), "%s - %u new", e.app_name, e.count);
+    else snprintf(app, sizeof(app), "%s", e.app_name);
+    label_set_text_if_changed(toast_app_lbl, app);
+    label_set_text_if_changed(toast_sum_lbl, e.summary);
+    label_set_text_if_changed(toast_body_lbl, e.body);
+    if (e.body[0]) lv_obj_clear_flag(toast_body_lbl, LV_OBJ_FLAG_HIDDEN);
+    else lv_obj_add_flag(toast_body_lbl, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_set_style_border_color(toast_panel,
+        lv_color_hex(e.urgency == NOTIF_CRITICAL ? CLR_RED : CLR_BLUE), LV_PART_MAIN);
+
+    if (toast_fade_img) {
+        lv_anim_del(toast_fade_img, nullptr);
+        lv_obj_add_flag(toast_fade_img, LV_OBJ_FLAG_HIDDEN);
+    }
+    lv_obj_clear_flag(toast_panel, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_move_foreground(toast_panel);
+    lv_timer_set_period(toast_timer, toast_dwell_ms(e.urgency));
+    lv_timer_reset(toast_timer);
+    lv_timer_resume(toast_timer);
+}
+
+static void toast_show_next() {
+    if (toast_showing || toast_queued == 0) return;
+    int best = 0;
+    for (int i = 1; i < toast_queued; i++) {
+        if (toast_before(toast_queue[i], toast_queue[best])) best = i;
+    }
+    ToastEntry next = toast_queue[best];
+    toast_queue[best] = toast_queue[--toast_queued];
+    toast_present(next);
+}
+
+// Queue `e`; when full, the least important waiting entry (or `e`) is dropped
+static void toast_enqueue(const ToastEntry &e) {
+    if (toast_queued < TOAST_QUEUE_LEN) {
+        toast_queue[toast_queued++] = e;
+        return;
+    }
+    int victim = 0;
+    for (int i = 1; i < toast_queued; i++) {
+        if (toast_before(toast_queue[victim], toast_queue[i])) victim = i;
+    }
+    toast_dropped++;
+    LOG_W("Toast queue full: dropped one (%lu total)\n", (unsigned long)toast_dropped);
+    if (toast_before(e, toast_queue[victim])) toast_queue[victim] = e;
+}
 
-        // Hide all pages except the first
-        if (pi > 0) {
-            lv_obj_add_flag(container, LV_OBJ_FLAG_HIDDEN);
+static void fold_into(ToastEntry &e, const char *summary, const char *body, uint8_t urgency) {
+    snprintf(e.summary, sizeof(e.summary), "%s", summary);
+    snprintf(e.body, sizeof(e.body), "%s", body ? body : "");
+    if (urgency_rank(urgency) > urgency_rank(e.urgency)) e.urgency = urgency;
+    if (e.count < UINT16_MAX) e.count++;
+}
+
+void show_notification_toast(const char *app_name, const char *summary, const char *body,
+                             uint8_t urgency) {
+    // Repeat from the app on screen: update in place, dwell starts over
+    if (toast_showing && strcmp(toast_shown.app_name, app_name) == 0) {
+        ToastEntry e = toast_shown;
+        fold_into(e, summary, body, urgency);
+        toast_present(e);
+        return;
+    }
+    for (int i = 0; i < toast_queued; i++) {
+        if (strcmp(toast_queue[i].app_name, app_name) == 0) {
+            fold_into(toast_queue[i], summary, body, urgency);
+            return;
         }
+    }
 
-        page_containers.push_back(container);
+    ToastEntry e = {};
+    snprintf(e.app_name, sizeof(e.app_name), "%s", app_name);
+    fold_into(e, summary, body, urgency);   // count = 1
+    e.urgency = urgency;
+    e.seq = toast_seq++;
+
+    // Critical preempts: the current toast goes back in line
+    if (toast_showing && urgency_rank(urgency) > urgency_rank(toast_shown.urgency)) {
+        ToastEntry preempted = toast_shown;
+        toast_hide();
+        toast_enqueue(preempted);
+        toast_present(e);
+        return;
     }
+    toast_enqueue(e);
+    toast_show_next();
+}
 
-    current_page = 0;
-    update_page_nav_indicators();
+// ============================================================
+//  Level OSD
+// ============================================================
+#ifndef LEVEL_OSD_MS
+#define LEVEL_OSD_MS 1500
+#endif
+#define LEVEL_OSD_W  260
+#define LEVEL_OSD_H  64
+
+static lv_obj_t *osd_panel = nullptr;
+static lv_obj_t *osd_lbl = nullptr;
+static lv_obj_t *osd_bar = nullptr;
+static lv_timer_t *osd_timer = nullptr;
+
+static void osd_create() {
+    // Top layer, like the toast, but centred low so it doesn't cover one
+    osd_panel = lv_obj_create(lv_layer_top());
+    lv_obj_set_size(osd_panel, LEVEL_OSD_W, LEVEL_OSD_H);
+    lv_obj_align(osd_panel, LV_ALIGN_BOTTOM_MID, 0, -40);
+    lv_obj_set_style_bg_color(osd_panel, lv_color_hex(0x1a1a2e), LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(osd_panel, LV_OPA_90, LV_PART_MAIN);
+    lv_obj_set_style_border_width(osd_panel, 0, LV_PART_MAIN);
+    lv_obj_set_style_radius(osd_panel, 12, LV_PART_MAIN);
+    lv_obj_clear_flag(osd_panel, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_flag(osd_panel, LV_OBJ_FLAG_HIDDEN);
+
+    osd_lbl = lv_label_create(osd_panel);
+    lv_obj_set_style_text_font(osd_lbl, &lv_font_montserrat_16, LV_PART_MAIN);
+    lv_obj_set_style_text_color(osd_lbl, lv_color_white(), LV_PART_MAIN);
+    lv_obj_align(osd_lbl, LV_ALIGN_TOP_MID, 0, -4);
+
+    osd_bar = lv_bar_create(osd_panel);
+    lv_obj_set_size(osd_bar, LEVEL_OSD_W - 40, 10);
+    lv_obj_align(osd_bar, LV_ALIGN_BOTTOM_MID, 0, 0);
+    lv_obj_set_style_bg_color(osd_bar, lv_color_hex(CLR_BLUE), LV_PART_INDICATOR);
+
+    osd_timer = lv_timer_create([](lv_timer_t *) {
+        lv_obj_add_flag(osd_panel, LV_OBJ_FLAG_HIDDEN);
+        lv_timer_pause(osd_timer);
+    }, LEVEL_OSD_MS, nullptr);
+    lv_timer_pause(osd_timer);
+}
 
-    Serial.printf("[ui] Created %zu pages\n", page_containers.size());
+void ui_show_level(const char *name, uint16_t value, uint16_t max) {
+    if (!osd_panel) osd_create();
+    if (max == 0) max = 100;
+    if (value > max) value = max;
+    lv_label_set_text_fmt(osd_lbl, "%s  %u", name, (unsigned)value);
+    lv_bar_set_range(osd_bar, 0, max);
+    lv_bar_set_value(osd_bar, value, LV_ANIM_OFF);
+    lv_obj_clear_flag(osd_panel, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_move_foreground(osd_panel);
+    lv_timer_reset(osd_timer);
+    lv_timer_resume(osd_timer);
 }
 
 // ============================================================
-//  Public: update_stats()
+//  Clock Mode Screen
 // ============================================================
-static void update_stat_widget(uint8_t type, uint16_t value) {
-    for (auto &ref : stat_widget_refs) {
-        if (ref.stat_type == type && ref.label) {
-            if (ref.value_position == 0) {
-                format_stat_value(ref.label, type, value);
-            } else {
-                format_stat_value_only(ref.label, type, value);
-            }
-        }
-    }
+// Point the hand at angle_deg (0 = 12 o'clock, clockwise). The line object
+// is moved to the hand's bounding box, so LVGL invalidates the old and new
+// boxes only; an unchanged result touches nothing.
+static void set_hand(ClockHand &h, float angle_deg) {
+    float rad = (angle_deg - 90.0f) * (float)M_PI / 180.0f;
+    float dx = cosf(rad), dy = sinf(rad);
+    lv_coord_t cx = SCREEN_WIDTH / 2, cy = SCREEN_HEIGHT / 2;
+    lv_coord_t x0 = cx - (lv_coord_t)lroundf(h.tail * dx);
+    lv_coord_t y0 = cy - (lv_coord_t)lroundf(h.tail * dy);
+    lv_coord_t x1 = cx + (lv_coord_t)lroundf(h.length * dx);
+    lv_coord_t y1 = cy + (lv_coord_t)lroundf(h.length * dy);
+    lv_point_t pos = { LV_MIN(x0, x1), LV_MIN(y0, y1) };
+    lv_point_t pts[2] = { { (lv_coord_t)(x0 - pos.x), (lv_coord_t)(y0 - pos.y) },
+                          { (lv_coord_t)(x1 - pos.x), (lv_coord_t)(y1 - pos.y) } };
+    if (pos.x == h.pos.x && pos.y == h.pos.y && memcmp(pts, h.pts, sizeof(pts)) == 0) return;
+
+    h.pos = pos;
+    memcpy(h.pts, pts, sizeof(pts));
+    lv_obj_set_pos(h.line, pos.x, pos.y);
+    lv_line_set_points(h.line, h.pts, 2);
 }
 
-static void update_stats_legacy(const StatsPayload *stats) {
-    update_stat_widget(STAT_CPU_PERCENT, stats->cpu_percent);
-    update_stat_widget(STAT_RAM_PERCENT, stats->ram_percent);
-    update_stat_widget(STAT_GPU_PERCENT, stats->gpu_percent);
-    update_stat_widget(STAT_CPU_TEMP, stats->cpu_temp);
-    update_stat_widget(STAT_GPU_TEMP, stats->gpu_temp);
-    update_stat_widget(STAT_DISK_PERCENT, stats->disk_percent);
-    update_stat_widget(STAT_NET_UP, stats->net_up_kbps);
-    update_stat_widget(STAT_NET_DOWN, stats->net_down_kbps);
-}
+// Ring, 60 ticks and the four numerals as throwaway LVGL objects, rendered
+// once with lv_snapshot into PSRAM (kept when the clock screen is released)
+static bool bake_analog_face() {
+    const lv_coord_t c = CLOCK_FACE_SIZE / 2;
+    lv_obj_t *tmp = lv_obj_create(clock_screen);
+    lv_obj_remove_style_all(tmp);
+    lv_obj_set_size(tmp, CLOCK_FACE_SIZE, CLOCK_FACE_SIZE);
+    lv_obj_set_style_bg_color(tmp, lv_color_hex(CLOCK_BG), LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(tmp, LV_OPA_COVER, LV_PART_MAIN);
+
+    lv_obj_t *ring = lv_arc_create(tmp);
+    lv_obj_set_size(ring, CLOCK_FACE_SIZE, CLOCK_FACE_SIZE);
+    lv_obj_center(ring);
+    lv_arc_set_bg_angles(ring, 0, 360);
+    lv_obj_remove_style(ring, NULL, LV_PART_KNOB);
+    lv_obj_remove_style(ring, NULL, LV_PART_INDICATOR);
+    lv_obj_set_style_arc_width(ring, 4, LV_PART_MAIN);
+    lv_obj_set_style_arc_color(ring, lv_color_hex(0x888888), LV_PART_MAIN);
+
+    // lv_line keeps a pointer to its points: they have to outlive the snapshot
+    std::vector<lv_point_t> tick_pts(120);
+    const lv_coord_t r_out = c - 12;
+    for (int i = 0; i < 60; i++) {
+        bool hour_tick = i % 5 == 0;
+        float rad = (i * 6.0f - 90.0f) * (float)M_PI / 180.0f;
+        lv_coord_t r_in = r_out - (hour_tick ? 16 : 6);
+        lv_point_t *p = &tick_pts[i * 2];
+        p[0] = { (lv_coord_t)(c + lroundf(r_in * cosf(rad))), (lv_coord_t)(c + lroundf(r_in * sinf(rad))) };
+        p[1] = { (lv_coord_t)(c + lroundf(r_out * cosf(rad))), (lv_coord_t)(c + lroundf(r_out * sinf(rad))) };
+        lv_obj_t *tick = lv_line_create(tmp);
+        lv_line_set_points(tick, p, 2);
+        lv_obj_set_style_line_width(tick, hour_tick ? 4 : 2, LV_PART_MAIN);
+        lv_obj_set_style_line_color(tick, lv_color_hex(hour_tick ? 0xCCCCCC : 0x555555), LV_PART_MAIN);
+        lv_obj_set_style_line_rounded(tick, hour_tick, LV_PART_MAIN);
+    }
 
-void update_stats(const uint8_t *data, uint8_t len) {
-    if (!data || len == 0) return;
+    static const char *const numerals[4] = { "12", "3", "6", "9" };
+    const lv_coord_t r_num = r_out - 36;
+    const lv_coord_t num_xy[4][2] = { { 0, -r_num }, { r_num, 0 }, { 0, r_num }, { -r_num, 0 } };
+    for (int i = 0; i < 4; i++) {
+        lv_obj_t *num = lv_label_create(tmp);
+        lv_label_set_text_static(num, numerals[i]);
+        lv_obj_set_style_text_font(num, &lv_font_montserrat_22, LV_PART_MAIN);
+        lv_obj_set_style_text_color(num, lv_color_hex(0x888888), LV_PART_MAIN);
+        lv_obj_align(num, LV_ALIGN_CENTER, num_xy[i][0], num_xy[i][1]);
+    }
 
-    if (len >= sizeof(StatsPayload) && data[0] > STAT_TYPE_MAX) {
-        update_stats_legacy((const StatsPayload *)data);
-    } else {
-        tlv_decode_stats(data, len, update_stat_widget);
+    lv_obj_update_layout(tmp);
+    uint32_t need = lv_snapshot_buf_size_needed(tmp, LV_IMG_CF_TRUE_COLOR);
+    analog_face_buf = mem_alloc(MEM_POOL_IMAGES, need);
+    bool ok = analog_face_buf &&
+              lv_snapshot_take_to_buf(tmp, LV_IMG_CF_TRUE_COLOR, &analog_face_img,
+                                      analog_face_buf, need) == LV_RES_OK;
+    lv_obj_del(tmp);
+    if (!ok) {
+        Serial.println("Clock: analog face bake failed, showing digital");
+        mem_free(MEM_POOL_IMAGES, analog_face_buf);
+        analog_face_buf = nullptr;
+        return false;
     }
+    Serial.printf("Clock: analog face baked (%lu bytes PSRAM)\n", (unsigned long)need);
+    return true;
 }
 
-// ============================================================
-//  Public: update_device_status()
-// ============================================================
-void update_device_status(int rssi_dbm, bool espnow_linked, uint8_t brightness_level, bool stats_active) {
-    for (auto &ref : status_bar_refs) {
-        if (ref.rssi_label) {
-            if (rssi_dbm == 0 || !espnow_linked) {
-                lv_obj_set_style_text_color(ref.rssi_label, lv_color_hex(CLR_GREY), LV_PART_MAIN);
-            } else if (rssi_dbm > -50) {
-                lv_obj_set_style_text_color(ref.rssi_label, lv_color_hex(CLR_GREEN), LV_PART_MAIN);
-            } else if (rssi_dbm > -70) {
-                lv_obj_set_style_text_color(ref.rssi_label, lv_color_hex(CLR_YELLOW), LV_PART_MAIN);
-            } else {
-                lv_obj_set_style_text_color(ref.rssi_label, lv_color_hex(CLR_RED), LV_PART_MAIN);
-            }
-        }
-        if (ref.pc_label) {
-            lv_obj_set_style_text_color(ref.pc_label,
-                lv_color_hex(stats_active ? CLR_GREEN : CLR_RED), LV_PART_MAIN);
-        }
-        if (ref.time_label) {
-            time_t now = time(nullptr);
-            struct tm *tm_info = localtime(&now);
-            if (tm_info && now > 1000000000) { // Only show if time has been synced (post-2001)
-                bool use_24h = g_active_config ? g_active_config->display_settings.clock_24h : true;
-                if (use_24h) {
-                    lv_label_set_text_fmt(ref.time_label, "%02d:%02d", tm_info->tm_hour, tm_info->tm_min);
-                } else {
-                    int hour12 = tm_info->tm_hour % 12;
-                    if (hour12 == 0) hour12 = 12;
-                    lv_label_set_text_fmt(ref.time_label, "%d:%02d%s", hour12, tm_info->tm_min,
-                                          tm_info->tm_hour >= 12 ? "p" : "a");
-                }
-            }
-        }
-    }
-    (void)brightness_level;
+// The baked face as a single opaque image under the hands, baking it first if needed
+static bool place_analog_face() {
+    if (!analog_face_buf && !bake_analog_face()) return false;
+    analog_clock_face = lv_img_create(clock_screen);
+    lv_img_set_src(analog_clock_face, &analog_face_img);
+    lv_obj_center(analog_clock_face);
+    lv_obj_clear_flag(analog_clock_face, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_move_to_index(analog_clock_face, 0);   // Under the hands and labels
+    return true;
 }
 
-// ============================================================
-//  Notification Toast
-// ============================================================
-static lv_obj_t *active_toast = nullptr;
-
-static void toast_anim_opa_cb(void *obj, int32_t v) {
-    lv_obj_set_style_opa((lv_obj_t *)obj, (lv_opa_t)v, LV_PART_MAIN);
-}
-
-void show_notification_toast(const char *app_name, const char *summary, const char *body) {
-    if (active_toast) {
-        lv_anim_del(active_toast, nullptr);
-        lv_obj_del(active_toast);
-        active_toast = nullptr;
-    }
-
-    lv_obj_t *toast = lv_obj_create(lv_scr_act());
-    lv_obj_set_size(toast, 600, 120);
-    lv_obj_align(toast, LV_ALIGN_TOP_RIGHT, -20, 50);
-    lv_obj_set_style_bg_color(toast, lv_color_hex(0x1a1a2e), LV_PART_MAIN);
-    lv_obj_set_style_bg_opa(toast, LV_OPA_90, LV_PART_MAIN);
-    lv_obj_set_style_border_color(toast, lv_color_hex(CLR_BLUE), LV_PART_MAIN);
-    lv_obj_set_style_border_width(toast, 2, LV_PART_MAIN);
-    lv_obj_set_style_radius(toast, 12, LV_PART_MAIN);
-    lv_obj_set_style_shadow_width(toast, 12, LV_PART_MAIN);
-    lv_obj_set_style_shadow_opa(toast, LV_OPA_40, LV_PART_MAIN);
-    lv_obj_clear_flag(toast, LV_OBJ_FLAG_SCROLLABLE);
-
-    lv_obj_t *app_lbl = lv_label_create(toast);
-    lv_label_set_text(app_lbl, app_name);
-    lv_obj_set_style_text_font(app_lbl, &lv_font_montserrat_14, LV_PART_MAIN);
-    lv_obj_set_style_text_color(app_lbl, lv_color_hex(CLR_BLUE), LV_PART_MAIN);
-    lv_obj_align(app_lbl, LV_ALIGN_TOP_LEFT, 12, 8);
-
-    lv_obj_t *sum_lbl = lv_label_create(toast);
-    lv_label_set_text(sum_lbl, summary);
-    lv_obj_set_style_text_font(sum_lbl, &lv_font_montserrat_16, LV_PART_MAIN);
-    lv_obj_set_style_text_color(sum_lbl, lv_color_white(), LV_PART_MAIN);
-    lv_obj_set_width(sum_lbl, 560);
-    lv_label_set_long_mode(sum_lbl, LV_LABEL_LONG_DOT);
-    lv_obj_align(sum_lbl, LV_ALIGN_TOP_LEFT, 12, 28);
-
-    if (body && strlen(body) > 0) {
-        lv_obj_t *body_lbl = lv_label_create(toast);
-        lv_label_set_text(body_lbl, body);
-        lv_label_set_long_mode(body_lbl, LV_LABEL_LONG_DOT);
-        lv_obj_set_width(body_lbl, 560);
-        lv_obj_set_style_text_font(body_lbl, &lv_font_montserrat_12, LV_PART_MAIN);
-        lv_obj_set_style_text_color(body_lbl, lv_color_hex(0xBBBBBB), LV_PART_MAIN);
-        lv_obj_align(body_lbl, LV_ALIGN_TOP_LEFT, 12, 52);
-    }
-
-    lv_obj_add_flag(toast, LV_OBJ_FLAG_CLICKABLE);
-    lv_obj_add_event_cb(toast, [](lv_event_t *e) {
-        lv_obj_t *obj = lv_event_get_target(e);
-        lv_anim_del(obj, nullptr);
-        lv_obj_del(obj);
-        active_toast = nullptr;
-    }, LV_EVENT_CLICKED, nullptr);
+static void set_analog_clock_visible(bool visible) {
+    lv_obj_t *objs[] = { analog_clock_face, hour_hand.line, min_hand.line, sec_hand.line, analog_center_cap };
+    for (lv_obj_t *o : objs) {
+        if (!o) continue;
+        if (visible && o != sec_hand.line) lv_obj_clear_flag(o, LV_OBJ_FLAG_HIDDEN);
+        else if (!visible) lv_obj_add_flag(o, LV_OBJ_FLAG_HIDDEN);
+    }
+}
 
-    lv_anim_t a;
-    lv_anim_init(&a);
-    lv_anim_set_var(&a, toast);
-    lv_anim_set_values(&a, LV_OPA_90, LV_OPA_TRANSP);
-    lv_anim_set_exec_cb(&a, toast_anim_opa_cb);
-    lv_anim_set_time(&a, 300);
-    lv_anim_set_delay(&a, 5000);
-    lv_anim_set_ready_cb(&a, [](lv_anim_t *anim) {
-        lv_obj_del((lv_obj_t *)anim->var);
-        active_toast = nullptr;
-    });
-    lv_anim_start(&a);
-    active_toast = toast;
+// Sweeps the second hand from the wall clock's sub-second time; capped at
+// CLOCK_SECOND_HAND_FPS, ticking once a second when animations are off.
+// Pauses itself as soon as the clock screen goes away.
+static void second_hand_timer_cb(lv_timer_t *timer) {
+    if (lv_scr_act() != clock_screen || lv_obj_has_flag(sec_hand.line, LV_OBJ_FLAG_HIDDEN)) {
+        lv_timer_pause(timer);
+        return;
+    }
+    bool smooth = power_animations_enabled();
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    float sec = (float)(tv.tv_sec % 60);
+    if (smooth) sec += tv.tv_usec / 1000000.0f;
+    set_hand(sec_hand, sec * 6.0f);
+    lv_timer_set_period(timer, smooth ? 1000 / CLOCK_SECOND_HAND_FPS : 1000 - tv.tv_usec / 1000);
 }
 
-// ============================================================
-//  Clock Mode Screen
-// ============================================================
 void show_clock_mode() {
-    if (clock_screen) {
-        update_clock_time();
-        lv_scr_load(clock_screen);
-    }
+    ensure_clock_screen();
+    update_clock_time();
+    lv_scr_load(clock_screen);
+    stats_set_view(SUB_VIEW_NONE);
 }
 
 void show_hotkey_view() {
     if (main_screen) lv_scr_load(main_screen);
+    stats_set_view(SUB_VIEW_PAGES);
 }
 
 void update_clock_time() {
     if (!clock_time_label || !clock_rssi_label) return;
 
-    time_t now = time(nullptr);
-    struct tm *tm_info = localtime(&now);
-    if (!tm_info) return;
+    const StatusState &st = status_get();
+    int hour = st.minute / 60;
+    int minute = st.minute % 60;
+
+    if (clock_direct_active()) {
+        // LVGL is stopped: digits go straight to the panel, the label and
+        // RSSI colour catch up at hand-off
+        char text[8];
+        snprintf(text, sizeof(text), "%02d:%02d", hour, minute);
+        clock_direct_draw(text);
+        return;
+    }
 
     bool use_analog = g_active_config ? g_active_config->clock_analog : false;
+    if (use_analog && !analog_clock_face && !analog_face_failed) analog_face_failed = !place_analog_face();
 
     if (use_analog && analog_clock_face) {
         lv_obj_add_flag(clock_time_label, LV_OBJ_FLAG_HIDDEN);
-        lv_obj_clear_flag(analog_clock_face, LV_OBJ_FLAG_HIDDEN);
-        lv_obj_clear_flag(analog_hour_hand, LV_OBJ_FLAG_HIDDEN);
-        lv_obj_clear_flag(analog_min_hand, LV_OBJ_FLAG_HIDDEN);
-
-        float hour_angle = (tm_info->tm_hour % 12) * 30.0f + tm_info->tm_min * 0.5f;
-        float min_angle = tm_info->tm_min * 6.0f;
-        int cx = SCREEN_WIDTH / 2;
-        int cy = SCREEN_HEIGHT / 2;
-        float hour_rad = (hour_angle - 90.0f) * M_PI / 180.0f;
-        float min_rad = (min_angle - 90.0f) * M_PI / 180.0f;
-
-        hour_points[0] = {(lv_coord_t)cx, (lv_coord_t)cy};
-        hour_points[1] = {(lv_coord_t)(cx + 80 * cosf(hour_rad)), (lv_coord_t)(cy + 80 * sinf(hour_rad))};
-        lv_line_set_points(analog_hour_hand, hour_points, 2);
-
-        min_points[0] = {(lv_coord_t)cx, (lv_coord_t)cy};
-        min_points[1] = {(lv_coord_t)(cx + 120 * cosf(min_rad)), (lv_coord_t)(cy + 120 * sinf(min_rad))};
-        lv_line_set_points(analog_min_hand, min_points, 2);
+        set_analog_clock_visible(true);
+        set_hand(hour_hand, (hour % 12) * 30.0f + minute * 0.5f);
+        set_hand(min_hand, minute * 6.0f);
+
+        bool seconds = g_active_config->clock_seconds && st.time_synced;
+        if (seconds) {
+            lv_obj_clear_flag(sec_hand.line, LV_OBJ_FLAG_HIDDEN);
+            if (!second_hand_timer) second_hand_timer = lv_timer_create(second_hand_timer_cb, 1000 / CLOCK_SECOND_HAND_FPS, nullptr);
+            lv_timer_resume(second_hand_timer);
+            lv_timer_ready(second_hand_timer);
+        } else {
+            lv_obj_add_flag(sec_hand.line, LV_OBJ_FLAG_HIDDEN);
+            if (second_hand_timer) lv_timer_pause(second_hand_timer);
+        }
     } else {
         lv_obj_clear_flag(clock_time_label, LV_OBJ_FLAG_HIDDEN);
-        lv_label_set_text_fmt(clock_time_label, "%02d:%02d", tm_info->tm_hour, tm_info->tm_min);
-        if (analog_clock_face) lv_obj_add_flag(analog_clock_face, LV_OBJ_FLAG_HIDDEN);
-        if (analog_hour_hand) lv_obj_add_flag(analog_hour_hand, LV_OBJ_FLAG_HIDDEN);
-        if (analog_min_hand) lv_obj_add_flag(analog_min_hand, LV_OBJ_FLAG_HIDDEN);
+        char text[8];
+        snprintf(text, sizeof(text), "%02d:%02d", hour, minute);
+        label_set_text_if_changed(clock_time_label, text);
+        set_analog_clock_visible(false);
+        if (second_hand_timer) lv_timer_pause(second_hand_timer);
     }
 
-    int rssi = espnow_get_rssi();
-    if (rssi != 0 && rssi > -50)
-        lv_obj_set_style_text_color(clock_rssi_label, lv_color_hex(CLR_GREEN), LV_PART_MAIN);
-    else if (rssi != 0 && rssi > -70)
-        lv_obj_set_style_text_color(clock_rssi_label, lv_color_hex(CLR_YELLOW), LV_PART_MAIN);
-    else if (rssi != 0)
-        lv_obj_set_style_text_color(clock_rssi_label, lv_color_hex(CLR_RED), LV_PART_MAIN);
-    else
-        lv_obj_set_style_text_color(clock_rssi_label, lv_color_hex(CLR_GREY), LV_PART_MAIN);
+    lv_obj_set_style_text_color(clock_rssi_label, lv_color_hex(rssi_color(st.rssi_bucket)), LV_PART_MAIN);
+}
+
+lv_obj_t *ui_clock_direct_label() {
+    if (!clock_screen || lv_scr_act() != clock_screen || !clock_time_label) return nullptr;
+    if (lv_obj_has_flag(clock_time_label, LV_OBJ_FLAG_HIDDEN)) return nullptr;   // Analog face
+    return clock_time_label;
 }
 
 // ============================================================
 //  Page Clock Widget Updates
 // ============================================================
-void update_page_clocks() {
+static void tick_clocks(uint8_t, int page_idx) {
     if (clock_widget_labels.empty()) return;
-    time_t now = time(nullptr);
-    struct tm *tm_info = localtime(&now);
-    if (!tm_info || now <= 1000000000) return;
-    bool use_24h = g_active_config ? g_active_config->display_settings.clock_24h : true;
-    for (lv_obj_t *lbl : clock_widget_labels) {
-        if (!lbl) continue;
-        if (use_24h) {
-            lv_label_set_text_fmt(lbl, "%02d:%02d", tm_info->tm_hour, tm_info->tm_min);
-        } else {
-            int hour12 = tm_info->tm_hour % 12;
-            if (hour12 == 0) hour12 = 12;
-            lv_label_set_text_fmt(lbl, "%d:%02d%s", hour12, tm_info->tm_min,
-                                  tm_info->tm_hour >= 12 ? "p" : "a");
-        }
+    const StatusState &st = status_get();
+    if (!st.time_synced) return;
+    char text[8];
+    format_clock(text, sizeof(text), st);
+    for (auto &ref : clock_widget_labels) {
+        if (ref.obj && (page_idx < 0 || ref.page_idx == page_idx)) label_set_text_if_changed(ref.obj, text);
     }
 }
 
+void update_page_clocks() {
+    tick_clocks(STATUS_MINUTE, -1);
+}
+
 // ============================================================
 //  Display Uptime Self-Update
 // ============================================================
-void update_display_uptime() {
+static void update_uptime_on(int page_idx) {
     uint16_t hours = (uint16_t)(millis() / 3600000UL);
-    for (auto &ref : stat_widget_refs) {
-        if (ref.stat_type == STAT_DISPLAY_UPTIME && ref.label) {
-            if (ref.value_position == 0) {
-                lv_label_set_text_fmt(ref.label, "Disp %dh", hours);
-            } else {
-                lv_label_set_text_fmt(ref.label, "%dh", hours);
-            }
-        }
+    for (uint16_t i : stat_index[STAT_DISPLAY_UPTIME]) {
+        StatWidgetRef &ref = stat_widget_refs[i];
+        if (ref.label && (page_idx < 0 || ref.page_idx == page_idx)) set_stat_ref(ref, hours);
     }
 }
 
+void update_display_uptime() {
+    update_uptime_on(-1);
+}
+
+static void tick_stat_monitors(uint8_t events, int page_idx) {
+    if (events & WIDGET_TICK_PAGE) refresh_page_stats(page_idx);
+    update_uptime_on(page_idx);
+}
+
 // ============================================================
 //  Config Screen
 // ============================================================
 void show_config_screen() {
-    if (!config_screen) return;
+    ensure_config_screen();
     if (config_info_label) {
         IPAddress ip = WiFi.softAPIP();
         lv_label_set_text_fmt(config_info_label,
@@ -1187,9 +4058,12 @@ void show_config_screen() {
             "  http://%s\n\n"
             "OTA firmware upload:\n"
             "  http://%s/update\n\n"
+            "Live edit (editor):\n"
+            "  ws://%s:%d/api/live\n\n"
             "PlatformIO:\n"
             "  pio run -t upload --upload-port %s",
-            ip.toString().c_str(), ip.toString().c_str(), ip.toString().c_str());
+            ip.toString().c_str(), ip.toString().c_str(), ip.toString().c_str(), LIVE_EDIT_PORT,
+            ip.toString().c_str());
     }
     lv_scr_load(config_screen);
 }
@@ -1201,48 +4075,267 @@ void hide_config_screen() {
 // ============================================================
 //  SD Card Filesystem Driver
 // ============================================================
+// Pooled handles, each with a PSRAM read buffer filled by sector-aligned
+// SD_LVGL_READ_CACHE reads. Small decoder reads and seeks inside the buffer
+// never reach the card; reads at least a buffer long go straight through.
+#define SD_FS_HANDLES       4
+#define SD_FS_SECTOR        512
+#define SD_FS_TRACE_MIN_MS  20    // Log per-file read stats when I/O took this long
+
+struct SdFsHandle {
+    bool used;
+    File file;
+    uint8_t *buf;          // Allocated on first use, kept for the slot
+    uint32_t buf_start;    // File offset of buf[0]
+    uint32_t buf_len;      // Valid bytes in buf
+    uint32_t pos;          // Logical position seen by LVGL
+    uint32_t file_pos;     // Where the File actually is (skips redundant seeks)
+    uint32_t size;
+    // Per-open trace
+    uint32_t lv_reads, sd_reads, bytes, io_us;
+    char name[48];
+};
+static SdFsHandle sd_fs_handles[SD_FS_HANDLES];
+
+static uint32_t sd_fs_raw_read(SdFsHandle *h, uint32_t offset, uint8_t *dst, uint32_t len) {
+    uint32_t t0 = micros();
+    if (h->file_pos != offset) {
+        h->file.seek(offset);
+        h->file_pos = offset;
+    }
+    uint32_t n = h->file.read(dst, len);
+    h->file_pos += n;
+    h->sd_reads++;
+    h->io_us += micros() - t0;
+    return n;
+}
+
+static void *sd_fs_open(lv_fs_drv_t *, const char *path, lv_fs_mode_t mode) {
+    if (mode != LV_FS_MODE_RD) return nullptr;
+    SdFsHandle *h = nullptr;
+    for (auto &slot : sd_fs_handles) {
+        if (!slot.used) { h = &slot; break; }
+    }
+    if (!h) {
+        Serial.printf("[sdfs] No free handle for %s\n", path);
+        return nullptr;
+    }
+    if (!h->buf) {
+        h->buf = (uint8_t *)heap_caps_aligned_alloc(16, SD_LVGL_READ_CACHE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!h->buf) return nullptr;
+    }
+    h->file = SD.open(path, FILE_READ);
+    if (!h->file) return nullptr;
+    h->used = true;
+    h->size = h->file.size();
+    h->pos = h->file_pos = 0;
+    h->buf_start = h->buf_len = 0;
+    h->lv_reads = h->sd_reads = h->bytes = h->io_us = 0;
+    strlcpy(h->name, path, sizeof(h->name));
+    return h;
+}
+
+static lv_fs_res_t sd_fs_close(lv_fs_drv_t *, void *file_p) {
+    SdFsHandle *h = (SdFsHandle *)file_p;
+    if (h->io_us >= SD_FS_TRACE_MIN_MS * 1000) {
+        Serial.printf("[sdfs] %s: %lu reads -> %lu SD reads, %lu KB in %lu ms\n", h->name,
+                      (unsigned long)h->lv_reads, (unsigned long)h->sd_reads,
+                      (unsigned long)(h->bytes / 1024), (unsigned long)(h->io_us / 1000));
+    }
+    h->file.close();
+    h->used = false;
+    return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t sd_fs_read(lv_fs_drv_t *, void *file_p, void *buf, uint32_t btr, uint32_t *br) {
+    SdFsHandle *h = (SdFsHandle *)file_p;
+    uint8_t *dst = (uint8_t *)buf;
+    uint32_t done = 0;
+    h->lv_reads++;
+    if (h->pos + btr > h->size) btr = h->pos < h->size ? h->size - h->pos : 0;
+
+    while (done < btr) {
+        uint32_t want = btr - done;
+        if (h->pos >= h->buf_start && h->pos < h->buf_start + h->buf_len) {
+            uint32_t off = h->pos - h->buf_start;
+            uint32_t n = h->buf_len - off < want ? h->buf_len - off : want;
+            memcpy(dst + done, h->buf + off, n);
+            h->pos += n;
+            done += n;
+        } else if (want >= SD_LVGL_READ_CACHE) {
+            // Large read: straight into the caller's buffer
+            uint32_t n = sd_fs_raw_read(h, h->pos, dst + done, want);
+            h->pos += n;
+            done += n;
+            h->bytes += n;
+            if (n < want) break;
+        } else {
+            uint32_t start = h->pos & ~(uint32_t)(SD_FS_SECTOR - 1);
+            uint32_t n = sd_fs_raw_read(h, start, h->buf, SD_LVGL_READ_CACHE);
+            h->buf_start = start;
+            h->buf_len = n;
+            h->bytes += n;
+            if (n <= h->pos - start) break;  // EOF / read error
+        }
+    }
+    *br = done;
+    return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t sd_fs_seek(lv_fs_drv_t *, void *file_p, uint32_t pos, lv_fs_whence_t whence) {
+    SdFsHandle *h = (SdFsHandle *)file_p;
+    if (whence == LV_FS_SEEK_SET) h->pos = pos;
+    else if (whence == LV_FS_SEEK_CUR) h->pos += pos;
+    else if (whence == LV_FS_SEEK_END) h->pos = h->size - pos;
+    return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t sd_fs_tell(lv_fs_drv_t *, void *file_p, uint32_t *pos_p) {
+    *pos_p = ((SdFsHandle *)file_p)->pos;
+    return LV_FS_RES_OK;
+}
+
 static void lvgl_register_sd_driver() {
     if (sd_fs_registered) return;
     static lv_fs_drv_t drv;
     lv_fs_drv_init(&drv);
     drv.letter = 'S';
-    drv.open_cb = [](lv_fs_drv_t *, const char *path, lv_fs_mode_t) -> void* {
-        File *file = new File();
-        *file = SD.open(path, FILE_READ);
-        if (!*file) { delete file; return nullptr; }
-        return file;
-    };
-    drv.close_cb = [](lv_fs_drv_t *, void *file_p) -> lv_fs_res_t {
-        File *file = (File*)file_p; file->close(); delete file; return LV_FS_RES_OK;
-    };
-    drv.read_cb = [](lv_fs_drv_t *, void *file_p, void *buf, uint32_t btr, uint32_t *br) -> lv_fs_res_t {
-        File *file = (File*)file_p; *br = file->read((uint8_t*)buf, btr); return LV_FS_RES_OK;
-    };
-    drv.seek_cb = [](lv_fs_drv_t *, void *file_p, uint32_t pos, lv_fs_whence_t whence) -> lv_fs_res_t {
-        File *file = (File*)file_p;
-        if (whence == LV_FS_SEEK_SET) file->seek(pos);
-        else if (whence == LV_FS_SEEK_CUR) file->seek(file->position() + pos);
-        else if (whence == LV_FS_SEEK_END) file->seek(file->size() - pos);
-        return LV_FS_RES_OK;
-    };
-    drv.tell_cb = [](lv_fs_drv_t *, void *file_p, uint32_t *pos_p) -> lv_fs_res_t {
-        File *file = (File*)file_p; *pos_p = file->position(); return LV_FS_RES_OK;
-    };
+    drv.cache_size = 0;  // Buffering is done per handle above
+    drv.open_cb = sd_fs_open;
+    drv.close_cb = sd_fs_close;
+    drv.read_cb = sd_fs_read;
+    drv.seek_cb = sd_fs_seek;
+    drv.tell_cb = sd_fs_tell;
     lv_fs_drv_register(&drv);
+    png_stream_register_decoder();  // "S:...png" ahead of lodepng
     sd_fs_registered = true;
 }
 
 // ============================================================
 //  Picture Frame Mode
 // ============================================================
+#define SLIDESHOW_POLL_MS       200   // Re-check while the next frame is still decoding
+#define SLIDESHOW_TRANSITION_MS 800
+
+static uint32_t slideshow_interval_ms() {
+    uint32_t interval_ms = g_active_config ? g_active_config->slideshow_interval_sec * 1000 : 30000;
+    return interval_ms < 5000 ? 5000 : interval_ms;
+}
+
+// Synchronous path, only used when the loader couldn't get its PSRAM frames
+// SD path of the next picture in slideshow order ("S:" + path when lvgl_drive)
+static bool slideshow_next_path(char *buf, size_t size, bool lvgl_drive) {
+    if (slideshow_count == 0) return false;
+    uint32_t i = picture_order_at(slideshow_order, slideshow_index);
+    slideshow_index = (slideshow_index + 1) % slideshow_count;
+    if (lvgl_drive) { buf[0] = 'S'; buf[1] = ':'; }
+    size_t skip = lvgl_drive ? 2 : 0;
+    return picture_index_path(i, buf + skip, size - skip);
+}
+
 static void load_next_slideshow_image() {
-    if (slideshow_files.empty() || !slideshow_img) return;
-    String path = "S:" + slideshow_files[slideshow_index];
-    lv_img_set_src(slideshow_img, path.c_str());
-    slideshow_index = (slideshow_index + 1) % slideshow_files.size();
+    char path[sizeof(PICTURE_DIR) + PICTURE_NAME_MAX + 2];
+    if (!slideshow_img || !slideshow_next_path(path, sizeof(path), true)) return;
+    lv_img_set_src(slideshow_img, path);
+}
+
+static void slideshow_request_next(uint8_t slot) {
+    char path[sizeof(PICTURE_DIR) + PICTURE_NAME_MAX + 2];
+    if (slideshow_next_path(path, sizeof(path), false)) img_loader_request(slot, path);
+}
+
+static void slideshow_anim_opa_cb(void *obj, int32_t v) {
+    lv_obj_set_style_img_opa((lv_obj_t *)obj, (lv_opa_t)v, LV_PART_MAIN);
+}
+
+static void slideshow_anim_x_cb(void *obj, int32_t v) {
+    lv_obj_set_x((lv_obj_t *)obj, (lv_coord_t)v);
+}
+
+static void slideshow_transition_done(lv_anim_t *a) {
+    (void)a;
+    // The outgoing frame is off screen now: decode the one after next into it
+    int8_t old = slideshow_shown;
+    slideshow_shown = 1 - old;
+    lv_obj_add_flag(slideshow_slot_img[old], LV_OBJ_FLAG_HIDDEN);
+    if (slideshow_count > 1) slideshow_request_next((uint8_t)old);
+    if (slideshow_timer) {
+        lv_timer_set_period(slideshow_timer, slideshow_interval_ms());
+        lv_timer_reset(slideshow_timer);
+        lv_timer_resume(slideshow_timer);
+    }
+}
+
+// Put a decoded frame on screen with the configured transition
+static void slideshow_present(uint8_t slot) {
+    lv_obj_t *img = slideshow_slot_img[slot];
+    const lv_img_dsc_t *frame = img_loader_frame(slot);
+    lv_img_cache_invalidate_src(frame);  // Same descriptor, new pixels
+    lv_img_set_src(img, frame);
+    lv_obj_set_x(img, 0);
+    lv_obj_set_style_img_opa(img, LV_OPA_COVER, LV_PART_MAIN);
+    lv_obj_clear_flag(img, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_move_foreground(img);
+
+    const std::string &mode = g_active_config ? g_active_config->display_settings.slideshow_transition : "none";
+    if (slideshow_shown < 0) {
+        // First frame: nothing to transition from
+        slideshow_shown = slot;
+        if (slideshow_count > 1) {
+            slideshow_request_next(1 - slot);
+            if (slideshow_timer) lv_timer_set_period(slideshow_timer, slideshow_interval_ms());
+        } else if (slideshow_timer) {
+            lv_timer_del(slideshow_timer);  // Single picture: nothing left to do
+            slideshow_timer = nullptr;
+        }
+        return;
+    }
+    // No polling while the transition runs; the ready callback re-arms the timer
+    if (slideshow_timer) lv_timer_pause(slideshow_timer);
+
+    lv_anim_t a;
+    lv_anim_init(&a);
+    lv_anim_set_var(&a, img);
+    bool animate = mode != "none" && power_animations_enabled();
+    lv_anim_set_time(&a, animate ? SLIDESHOW_TRANSITION_MS : 0);
+    lv_anim_set_path_cb(&a, lv_anim_path_ease_in_out);
+    lv_anim_set_ready_cb(&a, slideshow_transition_done);
+    if (mode == "slide") {
+        // Outgoing frame is left in place and simply covered
+        lv_anim_set_exec_cb(&a, slideshow_anim_x_cb);
+        lv_anim_set_values(&a, SCREEN_WIDTH, 0);
+    } else {
+        lv_anim_set_exec_cb(&a, slideshow_anim_opa_cb);
+        lv_anim_set_values(&a, LV_OPA_TRANSP, LV_OPA_COVER);
+    }
+    lv_anim_start(&a);
+}
+
+static void slideshow_timer_cb(lv_timer_t *timer) {
+    if (!slideshow_async) { load_next_slideshow_image(); return; }
+    uint8_t next = slideshow_shown < 0 ? 0 : (uint8_t)(1 - slideshow_shown);
+    switch (img_loader_state(next)) {
+        case IMG_LOAD_READY:
+            slideshow_present(next);
+            break;
+        case IMG_LOAD_FAILED:
+            slideshow_request_next(next);  // Skip the unreadable file
+            lv_timer_set_period(timer, SLIDESHOW_POLL_MS);
+            break;
+        default:
+            lv_timer_set_period(timer, SLIDESHOW_POLL_MS);  // Still decoding
+            break;
+    }
 }
 
-static void slideshow_timer_cb(lv_timer_t *timer) { (void)timer; load_next_slideshow_image(); }
+#define PICTURE_SCAN_ENTRIES 8   // Directory entries per job slice
+
+static UiJobId picture_scan_job = 0;
+
+static void slideshow_start();
+static void slideshow_message(const char *text);
+static bool picture_scan_step(void *);
+static void picture_scan_end(void *, bool completed);
 
 static void init_picture_frame_mode() {
     lvgl_register_sd_driver();
@@ -1250,49 +4343,100 @@ static void init_picture_frame_mode() {
         picture_frame_screen = lv_obj_create(NULL);
         lv_obj_set_style_bg_color(picture_frame_screen, lv_color_black(), LV_PART_MAIN);
         lv_obj_set_style_bg_opa(picture_frame_screen, LV_OPA_COVER, LV_PART_MAIN);
+        screen_track(picture_frame_screen, SCREEN_PICTURE);
     } else {
         lv_obj_clean(picture_frame_screen);
     }
     slideshow_img = nullptr; slideshow_fallback_label = nullptr;
-    slideshow_files.clear();
-
-    File dir = SD.open("/pictures");
-    if (dir && dir.isDirectory()) {
-        File entry;
-        while ((entry = dir.openNextFile())) {
-            if (!entry.isDirectory()) {
-                String name = String(entry.name()); String lower = name; lower.toLowerCase();
-                if (lower.endsWith(".jpg") || lower.endsWith(".jpeg") || lower.endsWith(".sjpg")) {
-                    slideshow_files.push_back(name.startsWith("/") ? name : "/pictures/" + name);
-                }
-            }
-            entry.close();
-        }
-        dir.close();
+    for (auto &img : slideshow_slot_img) img = nullptr;
+    slideshow_shown = -1;
+
+    // One header read; a missing index is built a few entries per loop pass
+    ui_job_cancel(picture_scan_job);
+    if (!picture_index_valid() && picture_index_scan_begin()) {
+        slideshow_message("Indexing pictures...");
+        picture_scan_job = ui_job_start("picture index", UI_JOB_NORMAL, picture_scan_step, picture_scan_end, nullptr);
+        if (picture_scan_job) return;
+        picture_index_rebuild();   // No job slot: walk it now
     }
+    slideshow_start();
+}
 
-    if (slideshow_files.empty()) {
+static void slideshow_message(const char *text) {
+    if (!slideshow_fallback_label) {
         slideshow_fallback_label = lv_label_create(picture_frame_screen);
-        lv_label_set_text(slideshow_fallback_label, "No images in /pictures\n\nUpload images via companion app");
-        lv_obj_center(slideshow_fallback_label);
         lv_obj_set_style_text_color(slideshow_fallback_label, lv_color_white(), LV_PART_MAIN);
         lv_obj_set_style_text_font(slideshow_fallback_label, &lv_font_montserrat_20, LV_PART_MAIN);
         lv_obj_set_style_text_align(slideshow_fallback_label, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN);
+    }
+    lv_label_set_text(slideshow_fallback_label, text);
+    lv_obj_center(slideshow_fallback_label);
+}
+
+static bool picture_scan_step(void *) {
+    return picture_index_scan_step(PICTURE_SCAN_ENTRIES);
+}
+
+static void picture_scan_end(void *, bool completed) {
+    picture_scan_job = 0;
+    if (!completed) {
+        picture_index_scan_abort();
+        return;
+    }
+    if (slideshow_fallback_label) {
+        lv_obj_del(slideshow_fallback_label);
+        slideshow_fallback_label = nullptr;
+    }
+    slideshow_start();
+}
+
+static void slideshow_start() {
+    slideshow_count = picture_index_count();
+    picture_order_init(slideshow_order, slideshow_count,
+                       g_active_config && g_active_config->display_settings.slideshow_shuffle);
+
+    if (slideshow_count == 0) {
+        slideshow_message("No images in /pictures\n\nUpload images via companion app");
+        return;
+    }
+
+    slideshow_index = 0;
+    slideshow_async = img_loader_begin();
+    if (slideshow_async) {
+        for (auto &img : slideshow_slot_img) {
+            img = lv_img_create(picture_frame_screen);
+            lv_obj_set_pos(img, 0, 0);
+            lv_obj_set_size(img, SCREEN_WIDTH, SCREEN_HEIGHT);
+            lv_obj_add_flag(img, LV_OBJ_FLAG_HIDDEN);
+        }
+        // Poll until the first frame is decoded, then switch to the interval
+        slideshow_request_next(0);
+        slideshow_timer = lv_timer_create(slideshow_timer_cb, SLIDESHOW_POLL_MS, nullptr);
         return;
     }
 
+    Serial.println("[ui] Slideshow: loader unavailable, decoding on the UI thread");
     slideshow_img = lv_img_create(picture_frame_screen);
     lv_obj_set_size(slideshow_img, SCREEN_WIDTH, SCREEN_HEIGHT);
     lv_obj_align(slideshow_img, LV_ALIGN_CENTER, 0, 0);
-    slideshow_index = 0;
     load_next_slideshow_image();
-    uint32_t interval_ms = g_active_config ? g_active_config->slideshow_interval_sec * 1000 : 30000;
-    if (interval_ms < 5000) interval_ms = 5000;
-    slideshow_timer = lv_timer_create(slideshow_timer_cb, interval_ms, nullptr);
+    slideshow_timer = lv_timer_create(slideshow_timer_cb, slideshow_interval_ms(), nullptr);
 }
 
 static void cleanup_picture_frame_mode() {
+    ui_job_cancel(picture_scan_job);
     if (slideshow_timer) { lv_timer_del(slideshow_timer); slideshow_timer = nullptr; }
+    if (!slideshow_async) return;
+    // Drop everything that points at the loader frames before they are freed
+    for (auto &img : slideshow_slot_img) {
+        if (!img) continue;
+        lv_anim_del(img, nullptr);
+        lv_obj_del(img);
+        img = nullptr;
+    }
+    slideshow_shown = -1;
+    slideshow_async = false;
+    img_loader_end();
 }
 
 // ============================================================
@@ -1313,6 +4457,7 @@ static void init_standby_mode() {
         lv_obj_set_style_text_font(standby_stats_label, &lv_font_montserrat_16, LV_PART_MAIN);
         lv_obj_set_style_text_color(standby_stats_label, lv_color_hex(0x888888), LV_PART_MAIN);
         lv_obj_align(standby_stats_label, LV_ALIGN_CENTER, 0, 20);
+        screen_track(standby_screen, SCREEN_STANDBY);
     }
     time_t now = time(nullptr);
     struct tm *tm_info = localtime(&now);
@@ -1338,36 +4483,31 @@ void update_standby_stats(const StatsPayload *stats) {
 // ============================================================
 //  Analog Clock Widgets (on clock_screen)
 // ============================================================
+static lv_obj_t *create_hand(lv_obj_t *parent, ClockHand &h, lv_coord_t width, uint32_t color) {
+    h.line = lv_line_create(parent);
+    lv_obj_set_style_line_width(h.line, width, LV_PART_MAIN);
+    lv_obj_set_style_line_color(h.line, lv_color_hex(color), LV_PART_MAIN);
+    lv_obj_set_style_line_rounded(h.line, true, LV_PART_MAIN);
+    lv_obj_add_flag(h.line, LV_OBJ_FLAG_HIDDEN);
+    h.pos = { -1, -1 };   // Never matches, so the first set_hand() places it
+    return h.line;
+}
+
+// Hands and cap only; the face image is baked on first use (bake_analog_face)
 static void create_analog_clock_widgets(lv_obj_t *parent) {
-    analog_clock_face = lv_arc_create(parent);
-    lv_obj_set_size(analog_clock_face, 300, 300);
-    lv_obj_center(analog_clock_face);
-    lv_arc_set_bg_angles(analog_clock_face, 0, 360);
-    lv_arc_set_value(analog_clock_face, 0);
-    lv_obj_remove_style(analog_clock_face, NULL, LV_PART_KNOB);
-    lv_obj_remove_style(analog_clock_face, NULL, LV_PART_INDICATOR);
-    lv_obj_set_style_arc_width(analog_clock_face, 4, LV_PART_MAIN);
-    lv_obj_set_style_arc_color(analog_clock_face, lv_color_hex(0x888888), LV_PART_MAIN);
-
-    hour_points[0] = {(lv_coord_t)(SCREEN_WIDTH / 2), (lv_coord_t)(SCREEN_HEIGHT / 2)};
-    hour_points[1] = {(lv_coord_t)(SCREEN_WIDTH / 2), (lv_coord_t)(SCREEN_HEIGHT / 2 - 80)};
-    analog_hour_hand = lv_line_create(parent);
-    lv_line_set_points(analog_hour_hand, hour_points, 2);
-    lv_obj_set_style_line_width(analog_hour_hand, 6, LV_PART_MAIN);
-    lv_obj_set_style_line_color(analog_hour_hand, lv_color_white(), LV_PART_MAIN);
-    lv_obj_set_style_line_rounded(analog_hour_hand, true, LV_PART_MAIN);
-
-    min_points[0] = {(lv_coord_t)(SCREEN_WIDTH / 2), (lv_coord_t)(SCREEN_HEIGHT / 2)};
-    min_points[1] = {(lv_coord_t)(SCREEN_WIDTH / 2), (lv_coord_t)(SCREEN_HEIGHT / 2 - 120)};
-    analog_min_hand = lv_line_create(parent);
-    lv_line_set_points(analog_min_hand, min_points, 2);
-    lv_obj_set_style_line_width(analog_min_hand, 4, LV_PART_MAIN);
-    lv_obj_set_style_line_color(analog_min_hand, lv_color_white(), LV_PART_MAIN);
-    lv_obj_set_style_line_rounded(analog_min_hand, true, LV_PART_MAIN);
-
-    lv_obj_add_flag(analog_clock_face, LV_OBJ_FLAG_HIDDEN);
-    lv_obj_add_flag(analog_hour_hand, LV_OBJ_FLAG_HIDDEN);
-    lv_obj_add_flag(analog_min_hand, LV_OBJ_FLAG_HIDDEN);
+    create_hand(parent, hour_hand, 6, 0xFFFFFF);
+    create_hand(parent, min_hand, 4, 0xFFFFFF);
+    create_hand(parent, sec_hand, 2, CLR_RED);
+
+    analog_center_cap = lv_obj_create(parent);
+    lv_obj_remove_style_all(analog_center_cap);
+    lv_obj_set_size(analog_center_cap, 12, 12);
+    lv_obj_center(analog_center_cap);
+    lv_obj_set_style_radius(analog_center_cap, LV_RADIUS_CIRCLE, LV_PART_MAIN);
+    lv_obj_set_style_bg_color(analog_center_cap, lv_color_white(), LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(analog_center_cap, LV_OPA_COVER, LV_PART_MAIN);
+    lv_obj_clear_flag(analog_center_cap, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_flag(analog_center_cap, LV_OBJ_FLAG_HIDDEN);
 }
 
 // ============================================================
@@ -1386,33 +4526,57 @@ void ui_transition_mode(DisplayMode from, DisplayMode to) {
         case MODE_PICTURE_FRAME:
             init_picture_frame_mode();
             if (picture_frame_screen) lv_scr_load(picture_frame_screen);
+            stats_set_view(SUB_VIEW_NONE);
             break;
         case MODE_STANDBY:
             init_standby_mode();
             if (standby_screen) lv_scr_load(standby_screen);
+            stats_set_view(SUB_VIEW_STANDBY);
             break;
     }
 }
 
 // ============================================================
-//  Public: create_ui()
+//  Boot splash
 // ============================================================
-void create_ui(const AppConfig* cfg) {
-    if (!cfg) { Serial.println("create_ui: nullptr config"); return; }
-    g_active_config = cfg;
+static lv_obj_t *splash_panel = nullptr;
+
+void ui_show_splash() {
+    splash_panel = lv_obj_create(lv_layer_top());
+    lv_obj_remove_style_all(splash_panel);
+    lv_obj_set_size(splash_panel, SCREEN_WIDTH, SCREEN_HEIGHT);
+    lv_obj_set_style_bg_color(splash_panel, lv_color_hex(0x0D1117), LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(splash_panel, LV_OPA_COVER, LV_PART_MAIN);
+    lv_obj_t *title = lv_label_create(splash_panel);
+    lv_label_set_text_static(title, "CrowDisplay");
+    lv_obj_set_style_text_font(title, &lv_font_montserrat_28, LV_PART_MAIN);
+    lv_obj_set_style_text_color(title, lv_color_hex(CLR_TEAL), LV_PART_MAIN);
+    lv_obj_center(title);
+    lv_refr_now(NULL);   // setup() doesn't reach lv_timer_handler() for a while yet
+}
 
-    // Register SD card filesystem driver for LVGL image loading
-    lvgl_register_sd_driver();
+void ui_hide_splash() {
+    if (!splash_panel) return;
+    lv_obj_del(splash_panel);
+    splash_panel = nullptr;
+}
 
-    main_screen = lv_scr_act();
-    lv_obj_set_style_bg_color(main_screen, lv_color_hex(0x0D1117), LV_PART_MAIN);
+// ============================================================
+//  Secondary screens: built on demand, released when idle
+// ============================================================
+static uint32_t screen_left_ms[SCREEN_COUNT];   // When each was last left (0 = showing, or not built)
+static lv_timer_t *screen_reap_timer = nullptr;
 
-    // Clock screen (tap anywhere to wake back to hotkey view)
+// Clock screen (tap anywhere to wake back to hotkey view, and the PC with it)
+static void ensure_clock_screen() {
+    if (clock_screen) return;
     clock_screen = lv_obj_create(NULL);
     lv_obj_set_style_bg_color(clock_screen, lv_color_hex(0x0f0f23), LV_PART_MAIN);
     lv_obj_set_style_bg_opa(clock_screen, LV_OPA_COVER, LV_PART_MAIN);
     lv_obj_add_flag(clock_screen, LV_OBJ_FLAG_CLICKABLE);
     lv_obj_add_event_cb(clock_screen, [](lv_event_t *) {
+        // Asleep PC (not just the clock display mode): the bridge wakes it over USB
+        if (power_get_state() == POWER_CLOCK) send_wake_to_bridge();
         power_wake_detected();
         show_hotkey_view();
     }, LV_EVENT_CLICKED, nullptr);
@@ -1427,8 +4591,11 @@ void create_ui(const AppConfig* cfg) {
     lv_obj_set_style_text_color(clock_rssi_label, lv_color_hex(CLR_GREY), LV_PART_MAIN);
     lv_obj_align(clock_rssi_label, LV_ALIGN_CENTER, 0, 30);
     create_analog_clock_widgets(clock_screen);
+    screen_track(clock_screen, SCREEN_CLOCK);
+}
 
-    // Config screen
+static void ensure_config_screen() {
+    if (config_screen) return;
     config_screen = lv_obj_create(NULL);
     lv_obj_set_style_bg_color(config_screen, lv_color_hex(0x0d1b2a), LV_PART_MAIN);
     lv_obj_set_style_bg_opa(config_screen, LV_OPA_COVER, LV_PART_MAIN);
@@ -1451,6 +4618,108 @@ void create_ui(const AppConfig* cfg) {
     lv_obj_t *exit_lbl = lv_label_create(cfg_exit);
     lv_label_set_text(exit_lbl, "Apply & Exit");
     lv_obj_center(exit_lbl);
+    screen_track(config_screen, SCREEN_CONFIG);
+}
+
+static void release_screen(SecondaryScreenId id) {
+    switch (id) {
+        case SCREEN_CLOCK:
+            if (second_hand_timer) lv_timer_del(second_hand_timer);
+            second_hand_timer = nullptr;
+            lv_obj_del(clock_screen);
+            clock_screen = clock_time_label = clock_rssi_label = nullptr;
+            analog_clock_face = analog_center_cap = nullptr;   // analog_face_buf stays baked
+            hour_hand.line = min_hand.line = sec_hand.line = nullptr;
+            break;
+        case SCREEN_CONFIG:
+            lv_obj_del(config_screen);
+            config_screen = config_info_label = nullptr;
+            break;
+        case SCREEN_STANDBY:
+            lv_obj_del(standby_screen);
+            standby_screen = standby_time_label = standby_stats_label = nullptr;
+            break;
+        case SCREEN_PICTURE:
+            cleanup_picture_frame_mode();   // No-op after leaving the mode
+            lv_obj_del(picture_frame_screen);
+            picture_frame_screen = slideshow_img = slideshow_fallback_label = nullptr;
+            for (auto &img : slideshow_slot_img) img = nullptr;
+            break;
+        default:
+            return;
+    }
+    screen_left_ms[id] = 0;
+}
+
+static lv_obj_t *screen_obj(SecondaryScreenId id) {
+    switch (id) {
+        case SCREEN_CLOCK:   return clock_screen;
+        case SCREEN_CONFIG:  return config_screen;
+        case SCREEN_STANDBY: return standby_screen;
+        case SCREEN_PICTURE: return picture_frame_screen;
+        default:             return nullptr;
+    }
+}
+
+static void screen_reap_timer_cb(lv_timer_t *timer) {
+    uint32_t now = millis();
+    bool waiting = false;
+    for (uint8_t i = 0; i < SCREEN_COUNT; i++) {
+        lv_obj_t *scr = screen_obj((SecondaryScreenId)i);
+        if (!scr || !screen_left_ms[i] || scr == lv_scr_act()) continue;
+        if (now - screen_left_ms[i] < UI_SCREEN_IDLE_MS) {
+            waiting = true;
+            continue;
+        }
+        release_screen((SecondaryScreenId)i);
+        Serial.printf("[ui] Secondary screen %u released (idle %lus)\n", i,
+                      (unsigned long)(UI_SCREEN_IDLE_MS / 1000));
+    }
+    if (!waiting) lv_timer_pause(timer);
+}
+
+static void screen_event_cb(lv_event_t *e) {
+    uint32_t &left_ms = screen_left_ms[(uintptr_t)lv_event_get_user_data(e)];
+    if (lv_event_get_code(e) == LV_EVENT_SCREEN_LOADED) {
+        left_ms = 0;
+        return;
+    }
+    left_ms = millis() | 1;
+    if (!screen_reap_timer) {
+        screen_reap_timer = lv_timer_create(screen_reap_timer_cb, UI_SCREEN_IDLE_MS / 4 + 1, nullptr);
+    } else {
+        lv_timer_resume(screen_reap_timer);
+    }
+}
+
+static void screen_track(lv_obj_t *scr, SecondaryScreenId id) {
+    screen_left_ms[id] = 0;
+    if (UI_SCREEN_IDLE_MS == 0) return;
+    lv_obj_add_event_cb(scr, screen_event_cb, LV_EVENT_SCREEN_LOADED, (void *)(uintptr_t)id);
+    lv_obj_add_event_cb(scr, screen_event_cb, LV_EVENT_SCREEN_UNLOADED, (void *)(uintptr_t)id);
+}
+
+// ============================================================
+//  Public: create_ui()
+// ============================================================
+void create_ui(const AppConfig* cfg) {
+    if (!cfg) { Serial.println("create_ui: nullptr config"); return; }
+    g_active_config = cfg;
+    status_subscribe(STATUS_RSSI | STATUS_LINK | STATUS_PC | STATUS_BATTERY | STATUS_MINUTE, on_status_changed);
+
+    // Register SD card filesystem driver for LVGL image loading
+    lvgl_register_sd_driver();
+#if STATS_LOG_ENABLE
+    if (!stats_log_timer) stats_log_timer = lv_timer_create(stats_log_timer_cb, STATS_LOG_INTERVAL_S * 1000, nullptr);
+#endif
+
+    // Repeated: a companion started after the last change still learns it
+    if (UI_STATS_SUBSCRIBE && !sub_timer) {
+        sub_timer = lv_timer_create([](lv_timer_t *) { stats_subscribe(true); }, STATS_SUBSCRIBE_REPEAT_MS, nullptr);
+    }
+
+    main_screen = lv_scr_act();
+    lv_obj_set_style_bg_color(main_screen, lv_color_hex(0x0D1117), LV_PART_MAIN);
 
     // Create widget pages
     create_pages(main_screen, cfg);
@@ -1462,26 +4731,174 @@ void create_ui(const AppConfig* cfg) {
 // ============================================================
 //  Public: rebuild_ui()
 // ============================================================
+// Counters for the rebuild log line
+struct PatchStats {
+    int kept, moved, recreated, pages_rebuilt;
+};
+
+// Bring a realized page in line with its new PageConfig. A changed
+// background or widget count rebuilds the page; otherwise only widgets that
+// differ are touched (moved in place, or recreated at the same z-order).
+// False if the page can't be patched and was evicted instead
+static bool patch_page_begin(int pi, const PageConfig &page, PatchStats &st) {
+    PageSlot &slot = pages[pi];
+    const PageConfig &old = slot.built;
+    if (old.bg_image != page.bg_image || old.widgets.size() != page.widgets.size() ||
+        !page_layer_valid(slot, page)) {
+        evict_page(pi);  // Realized again by show_page() / on next visit
+        st.pages_rebuilt++;
+        return false;
+    }
+
+    // Unchanged buttons keep their event ref; the table (macro pointers
+    // included) follows the new AppConfig
+    action_table_build(slot.actions, page, (uint8_t)pi);
+    return true;
+}
+
+static void patch_page_widget(int pi, const PageConfig &page, size_t wi, PatchStats &st) {
+    PageSlot &slot = pages[pi];
+    const WidgetConfig &ow = slot.built.widgets[wi];
+    const WidgetConfig &nw = page.widgets[wi];
+    lv_obj_t *obj = slot.widgets[wi];
+    if (widget_config_equal(ow, nw)) {
+        st.kept++;
+        return;
+    }
+
+    WidgetConfig moved = ow;
+    moved.x = nw.x;
+    moved.y = nw.y;
+    if (obj && widget_config_equal(moved, nw)) {
+        lv_obj_set_pos(obj, nw.x, nw.y);
+        st.moved++;
+        return;
+    }
+
+    int32_t z = -1;
+    if (obj) {
+        z = lv_obj_get_index(obj);
+        erase_widget_refs(obj);
+        lv_obj_del(obj);
+    }
+    obj = render_widget_obj(slot.container, &nw, (uint8_t)pi, (uint8_t)wi);
+    if (obj && z >= 0) lv_obj_move_to_index(obj, z);
+    slot.widgets[wi] = obj;
+    st.recreated++;
+}
+
+static void patch_page_end(int pi, const PageConfig &page) {
+    PageSlot &slot = pages[pi];
+    slot.built = page;
+    slot.widget_types = widget_type_mask(page);
+    slot.layer_mask = page_layer_mask(page);
+    if (UI_PAGE_LAYERS && page_prefetch_timer) lv_timer_resume(page_prefetch_timer);   // Recreated labels rejoin the layer
+}
+
+static void patch_page(int pi, const PageConfig &page, PatchStats &st) {
+    if (!patch_page_begin(pi, page, st)) return;
+    for (size_t wi = 0; wi < page.widgets.size(); wi++) patch_page_widget(pi, page, wi, st);
+    patch_page_end(pi, page);
+}
+
+// Realized pages other than the one shown are patched in the background, a
+// widget per slice; slot.built stays the old config until the last one.
+// Showing the page finishes the job, cancelling it evicts the half-patched
+// page. Their counts go to their own log line.
+static PatchStats job_patch_stats;
+
+static bool page_patch_step(void *arg) {
+    int pi = (int)(intptr_t)arg;
+    PageSlot &slot = pages[pi];
+    const PageConfig *page = active_page_config(pi);
+    if (!page || !slot.container) return false;
+    if (slot.job_next == 0 && !patch_page_begin(pi, *page, job_patch_stats)) return false;
+    if (slot.job_next < page->widgets.size()) {
+        patch_page_widget(pi, *page, slot.job_next++, job_patch_stats);
+        if (slot.job_next < page->widgets.size()) return true;
+    }
+    patch_page_end(pi, *page);
+    slot.job_next = UINT16_MAX;   // Done: end() keeps the page
+    rebuild_stat_index();
+    return false;
+}
+
+static void page_patch_end(void *arg, bool) {
+    int pi = (int)(intptr_t)arg;
+    PageSlot &slot = pages[pi];
+    bool done = slot.job_next == UINT16_MAX;
+    slot.job = 0;
+    slot.job_next = 0;
+    if (!done) {
+        evict_page(pi);   // Part old, part new: rebuilt from scratch on its next visit
+        return;
+    }
+    Serial.printf("[ui] Patched page %d in the background: kept=%d moved=%d recreated=%d\n", pi + 1,
+                  job_patch_stats.kept, job_patch_stats.moved, job_patch_stats.recreated);
+    job_patch_stats = {};
+    widgets_tick(WIDGET_TICK_ALL, pi);
+}
+
 void rebuild_ui(const AppConfig* cfg) {
     if (!cfg || !main_screen) { Serial.println("rebuild_ui: invalid args"); return; }
 
     lv_mem_monitor_t mon_pre;
     lv_mem_monitor(&mon_pre);
 
-    // Destroy all page containers
-    for (auto *p : page_containers) {
-        lv_obj_del(p);
-    }
-    page_containers.clear();
-    stat_widget_refs.clear();
-    status_bar_refs.clear();
-    page_nav_refs.clear();
-    clock_widget_labels.clear();
-
+    hw_input_clear_focus();
+    cancel_page_jobs();          // Built from the config being replaced
     g_active_config = cfg;
+    drop_all_page_snapshots();   // Retaken on the next idle tick
 
-    // Recreate pages
-    create_pages(main_screen, cfg);
+    // Diff realized pages against the new profile; unrealized pages are just
+    // descriptors and pick up the new config when first shown
+    const ProfileConfig *active = cfg->get_active_profile();
+    PatchStats st = {};
+    int target = rebuild_target_page;
+    rebuild_target_page = -1;
+    profile_prefetch_next = 0;
+    if (active && !active->pages.empty()) {
+        for (int pi = (int)pages.size() - 1; pi >= (int)active->pages.size(); pi--) {
+            evict_page(pi);
+        }
+        pages.resize(active->pages.size());
+        if (target >= (int)pages.size()) target = 0;
+        int shown = target >= 0 ? target : current_page < (int)pages.size() ? current_page : 0;
+        sync_stat_alerts(active);   // Before the patch: re-rendered widgets bind to the new list
+        for (int pi = 0; pi < (int)pages.size(); pi++) {
+            if (!pages[pi].container) continue;
+            // Profile switch: only the landing page is worth diffing, the old
+            // profile's other pages would just be rebuilt out of sight
+            if (target >= 0 && pi != target) {
+                evict_page(pi);
+            } else if (pi != shown) {
+                pages[pi].job_next = 0;
+                pages[pi].job = ui_job_start("page patch", UI_JOB_NORMAL, page_patch_step, page_patch_end,
+                                             (void *)(intptr_t)pi);
+                if (!pages[pi].job) patch_page(pi, active->pages[pi], st);
+            } else {
+                patch_page(pi, active->pages[pi], st);
+            }
+        }
+        sync_graph_histories(active);
+        rebuild_stat_index();
+        rebuild_hit_grids(active);
+        if (target >= 0) current_page = target;
+        if (current_page >= (int)pages.size()) current_page = 0;
+        show_page(current_page);
+        Serial.printf("UI rebuild: %zu pages, widgets kept=%d moved=%d recreated=%d, pages rebuilt=%d\n",
+                      pages.size(), st.kept, st.moved, st.recreated, st.pages_rebuilt);
+    } else {
+        for (auto &slot : pages) {
+            page_bg_release(slot);
+            if (slot.container) lv_obj_del(slot.container);
+        }
+        create_pages(main_screen, cfg);
+    }
+
+    // Kept clocks pick up a changed 12/24h setting now, not at the next minute;
+    // page navs a changed page count
+    widgets_tick(WIDGET_TICK_ALL, -1);
 
     lv_mem_monitor_t mon_post;
     lv_mem_monitor(&mon_post);
@@ -3,6 +3,11 @@
 #include "protocol.h"
 #include "config.h"
 
+// Boot splash on the top layer, drawn at once (call right after lvgl_init());
+// hidden again once create_ui() has built the real screens
+void ui_show_splash();
+void ui_hide_splash();
+
 // Build the complete UI from AppConfig (config required, no hardcoded fallback)
 void create_ui(const AppConfig* cfg);
 
@@ -10,20 +15,32 @@ void create_ui(const AppConfig* cfg);
 void rebuild_ui(const AppConfig* cfg);
 
 // Update stats for stat monitor widgets with new metrics from companion app.
-// Accepts raw payload bytes -- auto-detects TLV vs legacy StatsPayload format.
-void update_stats(const uint8_t *data, uint8_t len);
+// Accepts raw payload bytes -- auto-detects TLV vs legacy StatsPayload format
+// unless `tlv` says the frame was v2, which always carries TLV. `host` is
+// the sending bridge's slot: the active one drives every stat widget, graph
+// and alert, the others only the monitors pinned to them (stat_host).
+void update_stats(const uint8_t *data, uint8_t len, bool tlv = false, uint8_t host = 0);
+
+// Stats of remote collector `remote` (MSG_HOST_STATS: 1..REMOTE_HOST_MAX),
+// TLV as above: only the monitors pinned to it (stat_remote) show them. An
+// empty packet drops its values.
+void update_remote_stats(uint8_t remote, const uint8_t *data, uint8_t len);
 
 // Power state UI transitions
 void show_clock_mode();      // Switch to clock screen (called by power state machine)
 void show_hotkey_view();     // Switch back to main screen (called on wake)
 
-// Device status update (call from main loop every ~5s or on change)
-void update_device_status(int rssi_dbm, bool espnow_linked, uint8_t brightness_level, bool stats_active);
+// Status bars, page clocks and the clock screen follow status_store.h:
+// feed it and call status_flush(), they redraw only what changed.
 
-// Update clock display (call in clock mode from main loop)
+// Update clock display (clock screen; also run on status changes while shown)
 void update_clock_time();
 
-// Update clock widgets on pages (call periodically from main loop)
+// The clock screen's digital time label while it is the active screen
+// (else nullptr): what clock_direct.h draws in place of
+lv_obj_t *ui_clock_direct_label();
+
+// Update clock widgets on pages (run on every STATUS_MINUTE change)
 void update_page_clocks();
 
 // Update display uptime widgets (local millis-based, no companion data needed)
@@ -38,18 +55,56 @@ void hide_config_screen();
 // Request deferred UI rebuild (safe to call from any context, executes in loop)
 void request_ui_rebuild();
 
-// Show a desktop notification as a toast overlay (auto-dismisses after 5s, tap to dismiss)
-void show_notification_toast(const char *app_name, const char *summary, const char *body);
+// Queue a desktop notification for the toast overlay (tap to dismiss).
+// Shown by urgency, then arrival; repeats from an app already queued or on
+// screen are folded into one "N new" toast. urgency is a NotifUrgency.
+void show_notification_toast(const char *app_name, const char *summary, const char *body,
+                             uint8_t urgency = 0);
+
+// Brief level overlay ("Brightness 70" over a bar), e.g. where a DDC/CI
+// encoder spin landed. Repeats update it in place; it hides LEVEL_OSD_MS
+// after the last one. max 0 = unknown (shown against 100).
+void ui_show_level(const char *name, uint16_t value, uint16_t max);
 
-// Access the global config (for config_server to update before rebuild)
+// Access the global config (UI task only)
 AppConfig& get_global_config();
 
+// Hand over a config parsed off the UI task (takes ownership of a new'd
+// AppConfig). loop() swaps it in at its next rebuild point, between frames,
+// and frees the old one after rebuild_ui(); one staged before that is
+// replaced. Safe from any task.
+void stage_config(AppConfig *cfg);
+
+// Parse /config.json into a fresh AppConfig and stage_config() it if its
+// active profile has pages. Blocks for the whole parse: never on the UI
+// task. nullptr once staged, else why it was refused (live config untouched).
+const char *config_reload_staged();
+
 // Page navigation (called from rotary encoder or touch)
 void ui_next_page();
 void ui_prev_page();
+void ui_swipe_page(int dir);        // Touch swipe: +1/-1, slides page snapshots when it can
 void ui_goto_page(int page_index);  // Jump to specific page by index
 int ui_get_current_page();
 int ui_get_page_count();
 
+// Profile switching (buttons, hardware input, companion focus following).
+// Takes effect on the next loop pass via the deferred rebuild, landing on
+// the target profile's first page. Unknown names/indices are ignored.
+bool ui_switch_profile(const char *name);
+bool ui_switch_profile_index(int profile_index);
+void ui_next_profile();
+// Index of the active profile in get_global_config().profiles, -1 if none
+int ui_active_profile_index();
+
+// Host switching (several paired bridges, espnow_link.h). Selecting a host
+// swaps the stat widgets over to its values and returns to the profile last
+// shown for it, else the first profile with host == slot + 1.
+bool ui_select_host(int slot);
+void ui_next_host();
+void ui_pair_host();        // Open the pairing window for one more bridge
+
 // Widget object access for hardware input focus management
 lv_obj_t* ui_get_widget_obj(int page_idx, int widget_idx);
+// Run a realized page's button action (actions.h); false if it has none
+bool ui_run_widget_action(int page_idx, int widget_idx);
@@ -0,0 +1,138 @@
+/**
+ * @file ui_jobs.cpp
+ * Cooperative, time-sliced UI jobs (see ui_jobs.h)
+ *
+ * A fixed table of UI_JOB_MAX slots, looked through on every pick: there
+ * are never more than a handful queued. A slot stays taken while its step
+ * or end callback runs, so a callback cancelling or finishing jobs
+ * (itself included) never has a slot reused under it.
+ */
+
+#include "ui_jobs.h"
+#include <Arduino.h>
+#include <lvgl.h>
+
+struct UiJob {
+    UiJobId id;                // 0 = free
+    UiJobPriority prio;
+    UiJobStep step;
+    UiJobEnd end;
+    void *arg;
+    const char *name;
+    uint32_t seq;              // Queue order within a priority
+    bool running;              // In step(): cancel/finish are deferred to the runner
+    bool cancelled;
+    uint16_t slices;
+    uint32_t busy_us;
+    uint32_t started_ms;
+};
+
+static UiJob jobs[UI_JOB_MAX];
+static UiJobId next_id = 0;
+static uint32_t next_seq = 0;
+
+static UiJob *find(UiJobId id) {
+    if (!id) return nullptr;
+    for (auto &j : jobs) {
+        if (j.id == id) return &j;
+    }
+    return nullptr;
+}
+
+static void release(UiJob &j, bool completed) {
+    UiJobEnd end = j.end;
+    void *arg = j.arg;
+    if (completed) {
+        Serial.printf("[jobs] %s: %u slices, %lu ms busy over %lu ms\n", j.name, j.slices,
+                      (unsigned long)(j.busy_us / 1000), (unsigned long)(millis() - j.started_ms));
+    }
+    j.running = true;   // Slot stays taken through end()
+    if (end) end(arg, completed);
+    j = UiJob();
+}
+
+// One slice; false once the job is gone (done or cancelled meanwhile)
+static bool step_once(UiJob &j) {
+    j.running = true;
+    uint32_t t0 = micros();
+    bool more = j.step(j.arg);
+    j.busy_us += micros() - t0;
+    j.slices++;
+    j.running = false;
+    if (j.cancelled) {
+        release(j, false);
+        return false;
+    }
+    if (!more) {
+        release(j, true);
+        return false;
+    }
+    return true;
+}
+
+UiJobId ui_job_start(const char *name, UiJobPriority prio, UiJobStep step, UiJobEnd end, void *arg) {
+    if (!step) return 0;
+    for (auto &j : jobs) {
+        if (j.id) continue;
+        if (++next_id == 0) next_id = 1;
+        j.id = next_id;
+        j.prio = prio;
+        j.step = step;
+        j.end = end;
+        j.arg = arg;
+        j.name = name ? name : "job";
+        j.seq = next_seq++;
+        j.started_ms = millis();
+        return j.id;
+    }
+    Serial.printf("[jobs] table full, %s not queued\n", name ? name : "job");
+    return 0;
+}
+
+void ui_job_cancel(UiJobId id) {
+    UiJob *j = find(id);
+    if (!j || j->cancelled) return;
+    if (j->running) {
+        j->cancelled = true;   // The runner ends it once the slice returns
+        return;
+    }
+    release(*j, false);
+}
+
+bool ui_job_finish(UiJobId id) {
+    UiJob *j = find(id);
+    if (!j || j->running || j->cancelled) return false;
+    while (step_once(*j)) {
+    }
+    return true;
+}
+
+bool ui_job_pending(UiJobId id) {
+    UiJob *j = find(id);
+    return j && !j->cancelled;
+}
+
+static UiJob *pick(bool idle) {
+    UiJob *best = nullptr;
+    for (auto &j : jobs) {
+        if (!j.id || j.running || j.cancelled) continue;
+        if (j.prio == UI_JOB_IDLE && !idle) continue;
+        if (!best || j.prio < best->prio || (j.prio == best->prio && (int32_t)(j.seq - best->seq) < 0)) best = &j;
+    }
+    return best;
+}
+
+uint32_t ui_jobs_run() {
+    uint32_t inactive = lv_disp_get_inactive_time(NULL);
+    bool idle = inactive >= UI_JOB_IDLE_MS;
+    uint32_t t0 = micros();
+    UiJob *j;
+    while ((j = pick(idle)) != nullptr) {
+        step_once(*j);
+        if (micros() - t0 >= UI_JOB_BUDGET_US) return 0;
+    }
+    for (auto &q : jobs) {
+        if (q.id && q.prio == UI_JOB_IDLE && !q.running) return UI_JOB_IDLE_MS - inactive;
+    }
+    return UINT32_MAX;
+}
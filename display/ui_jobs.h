@@ -0,0 +1,56 @@
+#pragma once
+#include <stdint.h>
+
+// ============================================================
+// Time-sliced UI work (UI task, under the UI lock)
+//
+// Work too big for one frame -- building or patching an off-screen page,
+// indexing the picture library -- runs as a job: a step callback that does
+// one small piece and returns true while there is more. ui_jobs_run(),
+// once per loop pass before LVGL renders, steps queued jobs until
+// UI_JOB_BUDGET_US is spent, so input and animations keep their frame rate
+// while a big job proceeds over many passes. A slice is never interrupted:
+// keep each one well under the budget.
+//
+//   - Highest priority first, then oldest first. UI_JOB_IDLE jobs only
+//     run once input has been idle for UI_JOB_IDLE_MS.
+//   - ui_job_cancel() drops a job between slices; ui_job_finish() runs
+//     all its remaining slices at once, for a caller that needs the
+//     result now (showing the page being built).
+//   - `end` runs exactly once: after the last slice (completed = true)
+//     or on cancel (false). It may start or cancel other jobs.
+// ============================================================
+
+#ifndef UI_JOB_BUDGET_US
+#define UI_JOB_BUDGET_US 4000      // Slices per loop pass, all jobs together
+#endif
+#define UI_JOB_IDLE_MS   250       // Input quiet this long before UI_JOB_IDLE jobs run
+#define UI_JOB_MAX       8
+
+enum UiJobPriority : uint8_t {
+    UI_JOB_HIGH,      // Soon on screen
+    UI_JOB_NORMAL,    // Off screen, wanted anyway (rebuild of a realized page, picture index)
+    UI_JOB_IDLE,      // Speculative (page prefetch)
+};
+
+typedef uint16_t UiJobId;              // 0 = none
+typedef bool (*UiJobStep)(void *arg);  // One slice; false once the job is done
+typedef void (*UiJobEnd)(void *arg, bool completed);
+
+// Queue a job. 0 when all UI_JOB_MAX slots are taken (run it inline then).
+// `name` must outlive the job (a literal).
+UiJobId ui_job_start(const char *name, UiJobPriority prio, UiJobStep step, UiJobEnd end, void *arg);
+
+// Drop a queued job (its end(arg, false) runs now). No-op for 0 or a
+// finished id.
+void ui_job_cancel(UiJobId id);
+
+// Run the job to completion now. False if it wasn't queued.
+bool ui_job_finish(UiJobId id);
+
+bool ui_job_pending(UiJobId id);
+
+// Step queued jobs within the budget. Returns ms until there is work
+// again: 0 while jobs are runnable, until input idles for UI_JOB_IDLE
+// ones, UINT32_MAX with none queued.
+uint32_t ui_jobs_run();
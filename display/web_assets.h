@@ -0,0 +1,111 @@
+// Generated by tools/web_assets.py from display/web/ -- do not edit
+#pragma once
+#include <Arduino.h>
+
+struct WebAsset {
+    const char *path;       // URL
+    const char *mime;
+    const uint8_t *gz;      // gzip-compressed body
+    size_t gz_len;
+    const char *etag;       // Quoted CRC-32 of gz
+};
+
+// index.html: 4195 -> 1462 bytes
+static const uint8_t web_index_html_gz[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xcd, 0x58, 0xdd, 0x6f, 0xdb, 0x36,
+    0x10, 0x7f, 0xf7, 0x5f, 0x71, 0x55, 0x81, 0xda, 0xc6, 0x62, 0x59, 0xb6, 0xb3, 0xa4, 0xb3, 0x65,
+    0x01, 0x5b, 0xda, 0x62, 0xc1, 0x36, 0x24, 0x58, 0x93, 0x87, 0xa1, 0xe8, 0x03, 0x2d, 0x51, 0x36,
+    0x17, 0x9a, 0x14, 0x28, 0x2a, 0x8e, 0xdb, 0xfa, 0x7f, 0xdf, 0xf1, 0x43, 0xf2, 0x57, 0x8a, 0x36,
+    0x5b, 0x1e, 0xf6, 0x62, 0x49, 0x27, 0xde, 0xf1, 0x77, 0x77, 0xbf, 0x3b, 0x9e, 0x1c, 0xbf, 0x78,
+    0x73, 0x75, 0x71, 0xf3, 0xd7, 0xf5, 0x5b, 0x58, 0xe8, 0x25, 0x4f, 0x62, 0xff, 0x4b, 0x49, 0x96,
+    0xc4, 0x9a, 0x69, 0x4e, 0x93, 0x0b, 0x25, 0x57, 0xd7, 0x44, 0x50, 0x0e, 0x17, 0x52, 0xe4, 0x6c,
+    0x1e, 0xf7, 0x9d, 0xbc, 0x15, 0x97, 0x7a, 0x6d, 0xae, 0x33, 0x99, 0xad, 0xe1, 0x73, 0x0b, 0x20,
+    0x97, 0x42, 0xf7, 0x72, 0xb2, 0x64, 0x7c, 0x3d, 0x86, 0x92, 0x88, 0xb2, 0x57, 0x52, 0xc5, 0xf2,
+    0x09, 0xbe, 0x5a, 0x92, 0x87, 0xde, 0x8a, 0x65, 0x7a, 0x31, 0x86, 0xb3, 0x28, 0x2a, 0x1e, 0x9c,
+    0x4c, 0xcd, 0x99, 0x18, 0xc3, 0x29, 0x3e, 0x03, 0xa9, 0xb4, 0x34, 0xc2, 0x82, 0x64, 0x19, 0x13,
+    0xf3, 0x31, 0x0c, 0xfd, 0x2a, 0x4d, 0x1f, 0x74, 0x8f, 0x70, 0x36, 0xc7, 0x95, 0x29, 0x15, 0x9a,
+    0x2a, 0x23, 0x9d, 0x91, 0xf4, 0x6e, 0xae, 0x64, 0x25, 0xb2, 0x31, 0xbc, 0x1c, 0x90, 0x01, 0x19,
+    0x52, 0x23, 0x4e, 0x25, 0x97, 0x0a, 0x25, 0x94, 0xe2, 0xe3, 0xa6, 0xb5, 0x18, 0xc2, 0xe7, 0x46,
+    0x36, 0x3a, 0xfd, 0xe9, 0x75, 0x36, 0x9b, 0xc0, 0xa6, 0x15, 0xa6, 0x08, 0x94, 0x30, 0x41, 0x15,
+    0xbe, 0xde, 0xb7, 0x74, 0x36, 0x1c, 0x8c, 0xe8, 0x64, 0x8b, 0x62, 0x64, 0x50, 0xc0, 0x4c, 0xaa,
+    0x8c, 0xaa, 0x9e, 0x22, 0x19, 0xab, 0xca, 0x31, 0xbc, 0x36, 0xb2, 0x4d, 0x8b, 0x89, 0xa2, 0xd2,
+    0x1f, 0xf4, 0xba, 0xa0, 0xd3, 0x9c, 0x71, 0xfa, 0x11, 0x8d, 0xd5, 0x2e, 0x19, 0xf0, 0x10, 0x4d,
+    0x20, 0x63, 0x65, 0xc1, 0x09, 0x46, 0x63, 0xc6, 0x65, 0x7a, 0x67, 0x94, 0x66, 0x95, 0xd6, 0x52,
+    0xd8, 0x70, 0x35, 0x9b, 0x0c, 0x86, 0xb8, 0xfa, 0xd4, 0xfb, 0x6b, 0x83, 0x58, 0xb2, 0x4f, 0x14,
+    0xe5, 0x67, 0x4e, 0xb4, 0x07, 0x71, 0x48, 0xd3, 0xf4, 0x7c, 0x60, 0xc5, 0x16, 0xd5, 0x18, 0x84,
+    0x14, 0x7b, 0xce, 0xe7, 0x79, 0xbe, 0x7d, 0xbd, 0x07, 0xda, 0x2c, 0xaa, 0x54, 0x69, 0x56, 0x15,
+    0x92, 0xd5, 0xb1, 0xac, 0x41, 0x0f, 0x2c, 0x82, 0x1a, 0xe2, 0x78, 0x21, 0xef, 0x8f, 0x03, 0x34,
+    0x3c, 0x27, 0xf4, 0x2c, 0xb2, 0x41, 0x64, 0x22, 0x97, 0xd6, 0x8f, 0x03, 0xa7, 0xf7, 0x3c, 0xfb,
+    0xf1, 0x11, 0x0f, 0xa2, 0x7c, 0x74, 0x7a, 0x16, 0xed, 0x40, 0xe4, 0x34, 0xd7, 0x48, 0x03, 0xd4,
+    0x2e, 0x25, 0x67, 0x59, 0x93, 0xaa, 0x83, 0xec, 0x9b, 0x65, 0x8f, 0x38, 0x76, 0xea, 0x50, 0x87,
+    0xa5, 0x26, 0xba, 0x2a, 0x77, 0x92, 0x60, 0x36, 0x37, 0x49, 0xd8, 0x8d, 0xa8, 0x59, 0xdc, 0x04,
+    0x6a, 0x96, 0xa5, 0xa3, 0xf4, 0xdc, 0x38, 0x93, 0xca, 0x8c, 0x1e, 0xba, 0xea, 0x61, 0xee, 0x30,
+    0x12, 0xcd, 0x9d, 0x3d, 0x42, 0x87, 0x91, 0x91, 0xed, 0x71, 0x7f, 0x29, 0x85, 0x2c, 0x0b, 0x92,
+    0x52, 0x63, 0x7b, 0x61, 0x82, 0x28, 0xf1, 0x89, 0x69, 0x7c, 0x15, 0x85, 0xc3, 0x49, 0x83, 0x70,
+    0xe4, 0x69, 0xb2, 0x69, 0xc5, 0x7d, 0x5f, 0x4c, 0x71, 0x99, 0x2a, 0x56, 0xe8, 0xa4, 0x95, 0x57,
+    0x22, 0xd5, 0x0c, 0xa9, 0x52, 0x15, 0x5c, 0x92, 0xcc, 0xd5, 0x5e, 0xa7, 0x6b, 0x23, 0x8e, 0xfc,
+    0x2d, 0x35, 0x18, 0xd2, 0x5d, 0x1a, 0x0e, 0xc2, 0x14, 0x32, 0x99, 0x56, 0x4b, 0xac, 0x8e, 0x70,
+    0x4e, 0xf5, 0x5b, 0x4e, 0xcd, 0xed, 0x2f, 0xeb, 0xcb, 0xac, 0xd3, 0x4e, 0xad, 0xde, 0x3b, 0x5c,
+    0xda, 0xee, 0x9a, 0xe0, 0xb1, 0x1c, 0x3a, 0x2f, 0x1a, 0xcd, 0xd0, 0xdc, 0x95, 0x21, 0xa7, 0x62,
+    0xae, 0x17, 0xce, 0x36, 0x00, 0xe1, 0x54, 0xe9, 0x4e, 0xfb, 0x9a, 0x53, 0x52, 0x52, 0x28, 0x29,
+    0xa7, 0xa9, 0x06, 0x02, 0xce, 0x52, 0xf8, 0x77, 0x89, 0x98, 0xf2, 0xc6, 0x1e, 0x80, 0xa2, 0xba,
+    0x52, 0xc2, 0xdc, 0x6f, 0x5a, 0x5b, 0x6c, 0x52, 0x2d, 0xdf, 0x10, 0x4d, 0x10, 0x9a, 0xa0, 0x2b,
+    0x78, 0xe7, 0x1f, 0x3b, 0x5d, 0x47, 0x71, 0xf7, 0x14, 0x92, 0xa2, 0xa0, 0xa2, 0x01, 0xd9, 0x3e,
+    0x81, 0x03, 0x60, 0x1f, 0xa2, 0x8f, 0xa8, 0xd0, 0x18, 0x75, 0x19, 0x7e, 0xc3, 0xee, 0xbf, 0xed,
+    0xf0, 0x7b, 0xbb, 0xd4, 0x41, 0x6c, 0xd4, 0x90, 0xb2, 0x58, 0xf3, 0xbf, 0xde, 0xfc, 0xf1, 0x3b,
+    0x1a, 0x68, 0xdf, 0xda, 0xb8, 0x62, 0x66, 0xc3, 0x30, 0x6c, 0xdb, 0x5d, 0x72, 0xaa, 0xd3, 0x45,
+    0xa7, 0xdd, 0x27, 0x05, 0xeb, 0x3b, 0x33, 0x7d, 0x17, 0x7c, 0x44, 0xe6, 0x42, 0xb3, 0xa4, 0x7a,
+    0x21, 0x91, 0x1c, 0xed, 0xeb, 0xab, 0xf7, 0x37, 0xed, 0x13, 0x2b, 0x33, 0xed, 0x6f, 0xdc, 0xf8,
+    0x64, 0xc2, 0xd0, 0xc5, 0x9f, 0x50, 0x2f, 0xa8, 0xe8, 0x28, 0x5a, 0x16, 0x08, 0x9d, 0xc2, 0x34,
+    0x81, 0xfa, 0xde, 0x46, 0xb0, 0xd3, 0xdd, 0x2e, 0xca, 0x6c, 0x9c, 0x12, 0xbf, 0x85, 0x49, 0x90,
+    0x91, 0x84, 0x65, 0x95, 0xa6, 0xb4, 0x2c, 0xeb, 0xac, 0x7c, 0xd5, 0x8f, 0x18, 0x99, 0x26, 0xc0,
+    0xd2, 0x67, 0x1a, 0xd4, 0xd4, 0xf6, 0x5d, 0x22, 0x48, 0x5e, 0xbd, 0x1c, 0x44, 0x51, 0x34, 0x9a,
+    0xf8, 0xe6, 0x5d, 0x29, 0xe2, 0x49, 0x85, 0x7b, 0xd0, 0xec, 0x05, 0xfc, 0x49, 0x67, 0x15, 0xe3,
+    0x26, 0x0c, 0x70, 0x7b, 0x89, 0x91, 0x40, 0x22, 0xa2, 0xb9, 0xa4, 0x3d, 0xa9, 0x37, 0xa5, 0xfa,
+    0x86, 0x2d, 0xa9, 0xac, 0x74, 0x07, 0xc9, 0xd7, 0xa0, 0x7c, 0x2a, 0x1e, 0x5f, 0xd1, 0x41, 0x72,
+    0x7b, 0x89, 0x81, 0x30, 0x5b, 0xea, 0x10, 0xf7, 0x26, 0x78, 0x72, 0x68, 0x09, 0x15, 0x46, 0xc8,
+    0xd0, 0x24, 0xdd, 0xc5, 0x78, 0x04, 0x65, 0x73, 0x82, 0x2d, 0x26, 0x8a, 0x3c, 0xed, 0x36, 0x40,
+    0x39, 0xaa, 0xfd, 0x9b, 0xe0, 0xd0, 0xf3, 0x53, 0x2c, 0xfc, 0x26, 0x38, 0xd8, 0x01, 0xde, 0x2a,
+    0x65, 0xde, 0xb4, 0xe1, 0x07, 0x1f, 0x7c, 0x6a, 0x04, 0xf0, 0xe5, 0x0b, 0xd2, 0x44, 0xdc, 0x09,
+    0xb9, 0x12, 0x60, 0x25, 0xed, 0x2e, 0xae, 0x68, 0xef, 0x03, 0xdb, 0x34, 0x29, 0x4f, 0x89, 0xe1,
+    0x8f, 0x53, 0x6d, 0x22, 0xf5, 0xdf, 0x80, 0x39, 0x92, 0x42, 0x4e, 0xb0, 0x1c, 0x32, 0x07, 0xd0,
+    0xd9, 0x3f, 0x80, 0xb1, 0xe9, 0x9a, 0x1e, 0x78, 0xd8, 0x34, 0xde, 0x31, 0xb5, 0x5c, 0x11, 0x45,
+    0x9f, 0xde, 0x36, 0x72, 0xaf, 0xf9, 0x1c, 0x8d, 0x23, 0x9c, 0x31, 0x01, 0x08, 0xd9, 0x5c, 0xc3,
+    0xf9, 0x27, 0xa8, 0x6d, 0x3f, 0x77, 0x17, 0xa9, 0xed, 0x3e, 0x4f, 0x1f, 0x91, 0x9a, 0x3c, 0xa5,
+    0x89, 0x34, 0x5e, 0x1d, 0x75, 0x13, 0x57, 0x6a, 0xcf, 0xdb, 0x42, 0xcc, 0xb1, 0xf8, 0x1d, 0x2d,
+    0x84, 0x89, 0x8c, 0x3e, 0x5c, 0xe5, 0x9d, 0xf6, 0xd5, 0x6f, 0xc8, 0xdc, 0x64, 0x0a, 0xd1, 0x73,
+    0x75, 0x93, 0x9a, 0x59, 0x7b, 0x8d, 0x44, 0x4a, 0xed, 0xda, 0xe9, 0x41, 0x81, 0x3c, 0x67, 0xa5,
+    0x1e, 0x6c, 0xec, 0x2b, 0xe3, 0x7f, 0x5b, 0x91, 0x28, 0xf1, 0xe7, 0x79, 0xdc, 0xb7, 0x43, 0x75,
+    0x2b, 0x36, 0xc9, 0xc6, 0x4b, 0x86, 0xf4, 0x4b, 0x39, 0x29, 0x4b, 0xb3, 0x99, 0x1f, 0x47, 0x83,
+    0x04, 0x15, 0xe3, 0xc5, 0xf0, 0x68, 0xe6, 0xf6, 0x2d, 0x11, 0x6d, 0x0c, 0x13, 0xc3, 0xad, 0x5d,
+    0x6d, 0x33, 0x87, 0x59, 0x45, 0x14, 0x97, 0x5a, 0x49, 0x31, 0x4f, 0x3c, 0x46, 0xb2, 0xdf, 0x50,
+    0x6d, 0x55, 0x98, 0x41, 0xc3, 0xae, 0x89, 0x67, 0xca, 0x29, 0xbd, 0x77, 0x75, 0xba, 0x96, 0x95,
+    0x82, 0xd8, 0x0c, 0x42, 0xc9, 0xce, 0x49, 0x1f, 0xf7, 0xad, 0xc4, 0xaa, 0xda, 0x4e, 0xed, 0xa2,
+    0x8e, 0xa4, 0x83, 0x85, 0xd4, 0x77, 0x74, 0x0d, 0x38, 0xde, 0xe2, 0xe1, 0x10, 0x5a, 0x53, 0x37,
+    0x28, 0xce, 0xe8, 0x3d, 0x4b, 0x29, 0xac, 0x18, 0xe7, 0x70, 0x8f, 0x93, 0x9b, 0x5d, 0x4f, 0x04,
+    0xa2, 0x29, 0x0a, 0xbe, 0xb6, 0x9a, 0xfb, 0xa8, 0x56, 0x0c, 0x0b, 0x02, 0xbb, 0x91, 0x6a, 0x08,
+    0x64, 0x1c, 0xec, 0xa3, 0x87, 0xce, 0x55, 0x53, 0x16, 0xde, 0x3d, 0x3b, 0x71, 0x83, 0x9d, 0xb8,
+    0x03, 0x83, 0x28, 0x00, 0x96, 0xd9, 0xf0, 0xf9, 0x11, 0x27, 0x00, 0x41, 0x96, 0xb4, 0x96, 0x04,
+    0x40, 0xf0, 0x04, 0x2d, 0xf4, 0x34, 0xb0, 0xae, 0xd4, 0x31, 0xf2, 0x13, 0xb8, 0xb3, 0xe2, 0x1e,
+    0x02, 0x90, 0x22, 0xe5, 0x2c, 0xbd, 0x9b, 0x06, 0xfb, 0xd3, 0x56, 0x50, 0x87, 0xf2, 0x20, 0x0d,
+    0x4e, 0xcd, 0x66, 0xab, 0xef, 0xf0, 0xd5, 0x49, 0xd9, 0x02, 0x72, 0xdd, 0x23, 0xa8, 0xd3, 0xe4,
+    0x58, 0x17, 0x24, 0x3b, 0x9e, 0x2d, 0xd4, 0xf7, 0x24, 0xb3, 0x61, 0xfc, 0xad, 0x8b, 0x7d, 0xe7,
+    0xea, 0xe6, 0xe7, 0xee, 0x57, 0xd3, 0xe8, 0x32, 0xd8, 0x34, 0x23, 0x6c, 0xb9, 0x3e, 0x85, 0x27,
+    0xa6, 0x05, 0x9b, 0xe8, 0x97, 0x4b, 0xc2, 0xb1, 0x51, 0x3f, 0xb2, 0x12, 0x9b, 0xb3, 0x5f, 0x6c,
+    0x2d, 0xe6, 0x4a, 0x2e, 0x9d, 0x06, 0x06, 0x15, 0xec, 0x98, 0x80, 0x1f, 0x34, 0x0a, 0x77, 0x91,
+    0x6a, 0x1d, 0x1e, 0x25, 0xdb, 0xe5, 0x0f, 0x48, 0x8e, 0x9f, 0x15, 0x48, 0x3d, 0x3f, 0xbe, 0xe4,
+    0x15, 0xf7, 0xa4, 0x71, 0x47, 0x04, 0x12, 0xc1, 0xb5, 0x7a, 0xc3, 0x26, 0x63, 0xbc, 0x50, 0x68,
+    0x43, 0xe2, 0xe0, 0xde, 0x1c, 0x0b, 0xd8, 0xbe, 0xcc, 0x0b, 0xd3, 0xf1, 0xf1, 0xcb, 0xc6, 0x56,
+    0x5a, 0x69, 0x56, 0x63, 0x04, 0x95, 0x7e, 0x2a, 0x39, 0x76, 0x0f, 0xb2, 0x9a, 0x1e, 0xb5, 0x6c,
+    0x87, 0x20, 0xe8, 0xfd, 0x09, 0xba, 0xff, 0x14, 0x8e, 0x6c, 0x0f, 0xd7, 0x86, 0x25, 0xb5, 0xe8,
+    0x5b, 0x04, 0x69, 0xce, 0x96, 0x6f, 0xb1, 0xe3, 0x11, 0x72, 0xd4, 0x1d, 0xea, 0xe8, 0xcb, 0x68,
+    0xef, 0x3b, 0xc7, 0x7c, 0x93, 0x1c, 0xf0, 0xe8, 0x9a, 0x13, 0x6d, 0xa0, 0x5c, 0x5e, 0x01, 0x32,
+    0x68, 0x7c, 0xcc, 0x20, 0x47, 0x88, 0x82, 0x49, 0x50, 0x95, 0x80, 0x9e, 0xf6, 0x43, 0x04, 0xf4,
+    0x7a, 0xee, 0xa6, 0x57, 0x48, 0xa5, 0xe1, 0x15, 0xd7, 0x93, 0xcb, 0xeb, 0x57, 0x73, 0x3d, 0xd9,
+    0x72, 0xc5, 0xa3, 0x6e, 0x2e, 0xbe, 0xc5, 0xf5, 0xed, 0x9f, 0x09, 0xad, 0x7f, 0x00, 0x21, 0x60,
+    0x70, 0x99, 0x63, 0x10, 0x00, 0x00,
+};
+
+static const WebAsset WEB_ASSETS[] = {
+    { "/", "text/html", web_index_html_gz, sizeof(web_index_html_gz), "\"e50fc6fb\"" },
+};
@@ -0,0 +1,95 @@
+#pragma once
+#include <lvgl.h>
+#include <stdint.h>
+#include "config.h"
+#include "status_store.h"
+
+// ============================================================
+// Widget type registry
+//
+// Each WidgetType is described by a traits struct (specialised in ui.cpp):
+//
+//   template <> struct WidgetTraits<WIDGET_CLOCK> : WidgetTraitsBase {
+//       static constexpr bool enabled = UI_WIDGET_CLOCK;
+//       static constexpr uint8_t events = STATUS_MINUTE;   // What tick() wants
+//       static void render(lv_obj_t *parent, const WidgetConfig *cfg, uint8_t page, uint8_t widget);
+//       static void tick(uint8_t events, int page);
+//   };
+//
+// widget_type_entry<>() turns that into a table row. The ticker in ui.cpp
+// walks the table once per status change or page switch and calls tick()
+// only for types that subscribed to one of the events and have a widget
+// on the page concerned (PageSlot::widget_types), instead of every update
+// path walking its own ref vector on every page.
+//
+// A type built with UI_WIDGET_<TYPE>=0 has a null row: its renderer and
+// tick are never referenced, so they and the modules they pull in
+// (trackpad, remote images, ...) are dropped at link time. Configs that
+// still use it get nothing drawn in its place.
+// ============================================================
+
+#ifndef UI_WIDGET_HOTKEY_BUTTON
+#define UI_WIDGET_HOTKEY_BUTTON 1
+#endif
+#ifndef UI_WIDGET_STAT_MONITOR
+#define UI_WIDGET_STAT_MONITOR 1
+#endif
+#ifndef UI_WIDGET_STATUS_BAR
+#define UI_WIDGET_STATUS_BAR 1
+#endif
+#ifndef UI_WIDGET_CLOCK
+#define UI_WIDGET_CLOCK 1
+#endif
+#ifndef UI_WIDGET_TEXT_LABEL
+#define UI_WIDGET_TEXT_LABEL 1
+#endif
+#ifndef UI_WIDGET_SEPARATOR
+#define UI_WIDGET_SEPARATOR 1
+#endif
+#ifndef UI_WIDGET_PAGE_NAV
+#define UI_WIDGET_PAGE_NAV 1
+#endif
+#ifndef UI_WIDGET_STAT_GRAPH
+#define UI_WIDGET_STAT_GRAPH 1
+#endif
+#ifndef UI_WIDGET_TRACKPAD
+#define UI_WIDGET_TRACKPAD 1
+#endif
+#ifndef UI_WIDGET_REMOTE_IMAGE
+#define UI_WIDGET_REMOTE_IMAGE 1
+#endif
+#ifndef UI_WIDGET_SCROLL_GRID
+#define UI_WIDGET_SCROLL_GRID 1
+#endif
+
+// Tick events: the StatusField bits, plus
+#define WIDGET_TICK_PAGE 0x40   // Page shown / realized, or the page count changed
+#define WIDGET_TICK_ALL  (STATUS_ALL | WIDGET_TICK_PAGE)
+
+typedef void (*WidgetRenderFn)(lv_obj_t *parent, const WidgetConfig *cfg, uint8_t page_idx, uint8_t widget_idx);
+// page_idx -1 = every realized page
+typedef void (*WidgetTickFn)(uint8_t events, int page_idx);
+
+struct WidgetTypeEntry {
+    WidgetRenderFn render;   // nullptr = compiled out
+    WidgetTickFn tick;       // nullptr = never ticked
+    uint8_t events;
+};
+
+template <WidgetType T> struct WidgetTraits;
+
+// Defaults for types that only render
+struct WidgetTraitsBase {
+    static constexpr bool enabled = true;
+    static constexpr uint8_t events = 0;
+    static void tick(uint8_t, int) {}
+};
+
+template <class Traits>
+constexpr WidgetTypeEntry widget_type_entry() {
+    if constexpr (Traits::enabled) {
+        return { Traits::render, Traits::events ? Traits::tick : nullptr, Traits::events };
+    } else {
+        return { nullptr, nullptr, 0 };
+    }
+}
@@ -0,0 +1,176 @@
+/**
+ * @file wired_link.cpp
+ * Framed companion link on the console UART (see wired_link.h)
+ *
+ * Receive side: a byte-wise state machine. Outside a frame every byte is
+ * console input; a zero opens a frame, the next zero closes it (an empty
+ * one just re-opens, the sender's leading zero after our trailing one).
+ * A frame that doesn't decode is counted and dropped, never executed.
+ */
+
+#include "wired_link.h"
+
+#if WIRED_LINK_ENABLE
+
+#include "espnow_link.h"
+#include "events.h"
+#include "log.h"
+#include "trace.h"
+#include <Arduino.h>
+#include <string.h>
+
+static uint8_t rx_buf[WIRED_ENCODED_MAX];
+static size_t rx_len = 0;
+static bool rx_in_frame = false;
+static bool rx_overrun = false;    // Frame longer than WIRED_ENCODED_MAX: skip to its end
+static bool was_up = false;
+static WiredLinkStats stats = {};
+
+// ============================================================
+// COBS
+// ============================================================
+
+static size_t cobs_encode(const uint8_t *in, size_t len, uint8_t *out) {
+    size_t code_pos = 0, o = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[code_pos] = code;
+            code_pos = o++;
+            code = 1;
+            continue;
+        }
+        out[o++] = in[i];
+        if (++code == 0xFF) {
+            out[code_pos] = code;
+            code_pos = o++;
+            code = 1;
+        }
+    }
+    out[code_pos] = code;
+    return o;
+}
+
+// 0 on a malformed block or if the result doesn't fit in `max`
+static size_t cobs_decode(const uint8_t *in, size_t len, uint8_t *out, size_t max) {
+    size_t i = 0, o = 0;
+    while (i < len) {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > len || o + code - 1 > max) return 0;
+        memcpy(&out[o], &in[i], code - 1);
+        i += code - 1;
+        o += code - 1;
+        if (code < 0xFF && i < len) {
+            if (o >= max) return 0;
+            out[o++] = 0;
+        }
+    }
+    return o;
+}
+
+// ============================================================
+// Link
+// ============================================================
+
+// UART event task: wake loop() rather than wait for its next deadline
+static void on_uart_rx() {
+    events_post(EVT_WIRED_RX);
+}
+
+void wired_link_init() {
+    Serial.setRxBufferSize(WIRED_LINK_RX_BUFFER);
+    Serial.setTxBufferSize(WIRED_LINK_TX_BUFFER);
+    Serial.onReceive(on_uart_rx);
+}
+
+bool wired_link_up() {
+    return stats.last_rx_ms != 0 && millis() - stats.last_rx_ms < WIRED_LINK_TIMEOUT_MS;
+}
+
+bool wired_link_send(uint8_t type, const uint8_t *payload, uint8_t len) {
+    if (!wired_link_up() || len > PROTO_MAX_PAYLOAD) return false;
+
+    uint8_t frame[WIRED_FRAME_MAX];
+    frame[0] = type;
+    if (len && payload) memcpy(&frame[1], payload, len);
+    uint32_t crc = crc32_update(0, frame, 1 + len);
+    memcpy(&frame[1 + len], &crc, 4);   // Little-endian, as on the companion
+
+    uint8_t out[WIRED_ENCODED_MAX + 2];
+    out[0] = 0;
+    size_t n = 1 + cobs_encode(frame, 1 + len + 4, &out[1]);
+    out[n++] = 0;
+
+    // Never block loop() on the UART: the caller falls back to the radio
+    if ((size_t)Serial.availableForWrite() < n) {
+        stats.tx_dropped++;
+        return false;
+    }
+    Serial.write(out, n);
+    stats.tx_frames++;
+    return true;
+}
+
+static bool deliver_frame(const uint8_t *encoded, size_t len) {
+    uint8_t frame[WIRED_FRAME_MAX];
+    size_t n = cobs_decode(encoded, len, frame, sizeof(frame));
+    uint32_t crc;
+    if (n < 1 + 4) return false;
+    memcpy(&crc, &frame[n - 4], 4);
+    if (crc32_update(0, frame, n - 4) != crc) return false;
+
+    stats.rx_frames++;
+    stats.last_rx_ms = millis();
+    if (!stats.last_rx_ms) stats.last_rx_ms = 1;   // 0 means never
+    espnow_deliver_wired(frame[0], &frame[1], (uint8_t)(n - 5), micros());
+    return true;
+}
+
+int wired_link_poll() {
+    int frames = 0;
+    uint8_t chunk[64];
+    int avail;
+    while ((avail = Serial.available()) > 0) {
+        size_t got = Serial.read(chunk, avail < (int)sizeof(chunk) ? avail : sizeof(chunk));
+        for (size_t i = 0; i < got; i++) {
+            uint8_t c = chunk[i];
+            if (c == 0) {
+                if (rx_in_frame && (rx_len || rx_overrun)) {
+                    if (!rx_overrun && deliver_frame(rx_buf, rx_len)) frames++;
+                    else stats.rx_bad++;
+                    rx_in_frame = false;
+                } else {
+                    rx_in_frame = true;
+                }
+                rx_len = 0;
+                rx_overrun = false;
+            } else if (!rx_in_frame) {
+                trace_console_char(c);
+            } else if (rx_len < sizeof(rx_buf)) {
+                rx_buf[rx_len++] = c;
+            } else {
+                rx_overrun = true;
+            }
+        }
+    }
+
+    bool up = wired_link_up();
+    if (up != was_up) {
+        was_up = up;
+        Serial.printf("Wired link: %s\n", up ? "companion on USB, radio standing by" : "down, back on ESP-NOW");
+    }
+    return frames;
+}
+
+void wired_link_get_stats(WiredLinkStats &out) {
+    out = stats;
+    out.up = wired_link_up();
+}
+
+void wired_link_reset_stats() {
+    uint32_t last_rx_ms = stats.last_rx_ms;
+    stats = {};
+    stats.last_rx_ms = last_rx_ms;   // Link state, not a counter
+}
+
+#endif
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include "protocol.h"
+
+// ============================================================
+// Wired link: the display's own USB port straight to the companion
+//
+// The CrowPanel's USB socket is a USB-UART bridge (CH340) on UART0, the
+// serial console. With the panel plugged into the PC, the companion
+// opens that port and the display's messages go over the cable instead
+// of display -> ESP-NOW -> bridge -> vendor HID, with the same message
+// types both ways. There is no USB HID on that port: the companion plays
+// hotkeys, media keys and macros itself (action_executor.py).
+//
+// Frames share the wire with the console log:
+//
+//   0x00  COBS( [TYPE] [PAYLOAD...] [CRC-32 LE] )  0x00
+//
+// COBS leaves no zero byte inside a frame and log text never has one, so
+// the receiver cuts the stream at zeros and keeps what decodes with a
+// good CRC (crc32_update, as for bulk transfers); everything else is log.
+// A frame is one Serial.write(), which the UART driver keeps in one piece
+// against other tasks' log lines. Host -> display the same: bytes outside
+// a frame are console input ('t' dumps the trace ring).
+//
+// The companion sends MSG_HELLO at least every WIRED_LINK_KEEPALIVE_MS;
+// the display answers with its own (HELLO_F_REPLY) and counts the link
+// as up until WIRED_LINK_TIMEOUT_MS pass without a valid frame. While it
+// is up, espnow_send()/espnow_send_reliable() go over the cable (no SEQ
+// or retransmit: the cable doesn't lose frames silently, and the CRC
+// catches the rest); pairing, pings and HELLO keep running on the radio,
+// so unplugging falls back to the bridge without a reconnect.
+// ============================================================
+
+#ifndef WIRED_LINK_ENABLE
+#define WIRED_LINK_ENABLE 1
+#endif
+#ifndef WIRED_LINK_BAUD
+#define WIRED_LINK_BAUD 115200      // Console and link; raise with monitor_speed and the companion's --wired-baud
+#endif
+#ifndef WIRED_LINK_TIMEOUT_MS
+#define WIRED_LINK_TIMEOUT_MS 3000  // Up while a valid frame came in this recently
+#endif
+#define WIRED_LINK_KEEPALIVE_MS 1000  // Companion's MSG_HELLO period (documentation only)
+#define WIRED_LINK_RX_BUFFER    4096  // UART RX ring: a bulk window arrives between polls
+#define WIRED_LINK_TX_BUFFER    2048  // UART TX ring: frames queue instead of blocking loop()
+
+// [TYPE] + payload + CRC-32, and the COBS overhead on top
+#define WIRED_FRAME_MAX   (1 + PROTO_MAX_PAYLOAD + 4)
+#define WIRED_ENCODED_MAX (WIRED_FRAME_MAX + WIRED_FRAME_MAX / 254 + 1)
+
+struct WiredLinkStats {
+    bool up;
+    uint32_t rx_frames;      // Valid frames from the companion
+    uint32_t rx_bad;         // Zero-delimited chunks inside a frame that failed COBS/CRC
+    uint32_t tx_frames;
+    uint32_t tx_dropped;     // Not enough room in the UART TX ring
+    uint32_t last_rx_ms;     // millis() of the last valid frame, 0 = never
+};
+
+#if WIRED_LINK_ENABLE
+
+// Size the UART rings and hook the receive event. Call from setup(),
+// before Serial.begin(WIRED_LINK_BAUD).
+void wired_link_init();
+
+// Drain the UART: frames to espnow_deliver_wired(), console bytes to
+// trace_console_char(). Call from loop() (UI lock held, as for
+// espnow_dispatch()). Returns the number of frames delivered.
+int wired_link_poll();
+
+// The companion is on the other end of the cable
+bool wired_link_up();
+
+// One frame to the companion. False if the link is down or the TX ring is full.
+bool wired_link_send(uint8_t type, const uint8_t *payload, uint8_t len);
+
+void wired_link_get_stats(WiredLinkStats &out);
+void wired_link_reset_stats();
+
+#else
+
+// Console only
+#include "trace.h"
+inline void wired_link_init() {}
+inline int wired_link_poll() { trace_serial_poll(); return 0; }
+inline bool wired_link_up() { return false; }
+inline bool wired_link_send(uint8_t, const uint8_t *, uint8_t) { return false; }
+inline void wired_link_get_stats(WiredLinkStats &out) { out = {}; }
+inline void wired_link_reset_stats() {}
+
+#endif
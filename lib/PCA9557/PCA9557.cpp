@@ -63,10 +63,13 @@ byte PCA9557::getMode(pin_t pin) {
 /*==============================================================================================================*
     GET STATE (0 = LOW / 1 = HIGH)
  *==============================================================================================================*/
-/*
+
+// Cached: outputs answer from the shadow register, only inputs are read
+
 byte PCA9557::getState(pin_t pin) {
-    return getPin(pin, getMode(pin) ? IO_LOW : IO_HIGH);
-}*/
+    if (_cached && !bitRead(_shadow[REG_CONFIG], pin)) return bitRead(_shadow[REG_OUTPUT], pin);
+    return bitRead(readReg(REG_INPUT), pin);
+}
 
 /*==============================================================================================================*
     GET POLARITY: INPUT PINS ONLY (0 = NON-INVERTED / 1 = INVERTED)
@@ -149,6 +152,14 @@ void PCA9557::setPolarity(polarity_t newPolarity) {                     // PARAM
  *==============================================================================================================*/
 
 void PCA9557::reset() {
+    if (_cached) {
+        _batching = false;
+        _dirty = 0;
+        writeReg(REG_CONFIG, ALL_INPUT);
+        writeReg(REG_OUTPUT, ALL_HIGH);
+        writeReg(REG_POLARITY, ALL_NON_INVERTED);
+        return;
+    }
     setMode(IO_INPUT);
     setState(IO_HIGH);
     setPolarity(IO_NON_INVERTED);
@@ -156,11 +167,52 @@ void PCA9557::reset() {
     endCall();
 }
 
+/*==============================================================================================================*
+    SHADOW-REGISTER MODE
+ *==============================================================================================================*/
+
+void PCA9557::setCached(bool enable) {
+    _cached = enable;
+    _batching = false;
+    _dirty = 0;
+}
+
+void PCA9557::sync() {
+    _shadow[REG_OUTPUT]   = readReg(REG_OUTPUT);
+    _shadow[REG_POLARITY] = readReg(REG_POLARITY);
+    _shadow[REG_CONFIG]   = readReg(REG_CONFIG);
+    _dirty = 0;
+}
+
+void PCA9557::beginBatch() {
+    if (_cached) _batching = true;
+}
+
+// Writes each changed register once; returns the last I2C result (0 = success)
+
+byte PCA9557::commit() {
+    _batching = false;
+    static const reg_ptr_t order[] = {REG_OUTPUT, REG_POLARITY, REG_CONFIG};
+    byte result = COM_SUCCESS;
+    for (reg_ptr_t reg : order) {
+        if (!(_dirty & (1 << reg))) continue;
+        writeReg(reg, _shadow[reg]);
+        if (_comBuffer != COM_SUCCESS) result = _comBuffer;
+    }
+    _dirty = 0;
+    return result;
+}
+
 /*==============================================================================================================*
     GET REGISTER DATA
  *==============================================================================================================*/
 
 byte PCA9557::getReg(reg_ptr_t regPtr) {
+    if (_cached && regPtr != REG_INPUT) return _shadow[regPtr];
+    return readReg(regPtr);
+}
+
+byte PCA9557::readReg(reg_ptr_t regPtr) {
     byte regData = 0;
     initCall(regPtr);
     endCall();
@@ -188,10 +240,25 @@ byte PCA9557::getPin(pin_t pin, reg_ptr_t regPtr) {
  *==============================================================================================================*/
 
 void PCA9557::setReg(reg_ptr_t regPtr, byte newSetting) {
-    if (regPtr > 0) {
-        initCall(regPtr);
-        Wire.write(newSetting);
-        endCall();
+    if (regPtr == REG_INPUT) return;
+    if (_cached) {
+        if (_shadow[regPtr] == newSetting && !(_dirty & (1 << regPtr))) return;
+        _shadow[regPtr] = newSetting;
+        if (_batching) {
+            _dirty |= 1 << regPtr;
+            return;
+        }
+    }
+    writeReg(regPtr, newSetting);
+}
+
+void PCA9557::writeReg(reg_ptr_t regPtr, byte newSetting) {
+    initCall(regPtr);
+    Wire.write(newSetting);
+    endCall();
+    if (_cached) {
+        _shadow[regPtr] = newSetting;
+        _dirty &= ~(1 << regPtr);
     }
 }
 
@@ -87,6 +87,20 @@
 	 PIN_IO7             BIT 7         1
 
 
+*===============================================================================================================*
+    SHADOW-REGISTER MODE
+*===============================================================================================================*
+
+    setCached(true) keeps copies of the OUTPUT, POLARITY and CONFIG registers. A pin change then costs one
+    write instead of a read-modify-write, getMode() / getPolarity() and the state of output pins never touch
+    the bus, and REG_INPUT is only read for pins configured as inputs.
+
+    Between beginBatch() and commit() pin changes only update the copies; commit() writes each register that
+    changed exactly once (OUTPUT before CONFIG, so pins switching to output come up at their new level).
+
+    The copies start from reset(), which writes the power-on defaults, or from sync(), which reads them back.
+    The driver holds no lock: run it inside the caller's bus transaction (an i2c_bus job on the display).
+
 *===============================================================================================================*
     LICENSE
 *===============================================================================================================*
@@ -182,8 +196,18 @@ public:
 	void setPolarity(polarity_t newPolarity);
 	void reset();
 	byte getComResult();
+	void setCached(bool enable);
+	void sync();
+	void beginBatch();
+	byte commit();
 private:
 	byte _comBuffer;
+	bool _cached = false;
+	bool _batching = false;
+	byte _dirty = 0;                      // Bit per register waiting for commit()
+	byte _shadow[4] = {0x00, 0xFF, 0x00, 0xFF};   // Indexed by reg_ptr_t; [REG_INPUT] unused
+	byte readReg(reg_ptr_t regPtr);
+	void writeReg(reg_ptr_t regPtr, byte newSetting);
 	byte getReg(reg_ptr_t regPtr);
 	byte getPin(pin_t pin, reg_ptr_t regPtr);
 	void setReg(reg_ptr_t ptr, byte newSetting);
@@ -0,0 +1,157 @@
+#pragma once
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <stdint.h>
+#include "protocol.h"
+
+// ============================================================
+// Shared timebase (MSG_CLOCK_SYNC)
+//
+// The companion's wall clock (Unix time in microseconds) is the reference.
+// The bridge asks the companion over vendor HID, each display asks the
+// bridge over ESP-NOW, NTP style: the requester stamps t1 and t4 with its
+// own esp_timer, the responder t2 and t3 on the shared timebase, so
+//
+//   offset = ((t2 - t1) + (t3 - t4)) / 2    delay = (t4 - t1) - (t3 - t2)
+//
+// Receive stamps are taken in the ESP-NOW callback (EspnowMsg::rx_us), not
+// when the handler runs. Slow exchanges are dropped, a burst after boot
+// locks the offset, and later samples steer it while the slope between
+// them gives the crystal's drift, so clock_sync_host_us() stays within
+// tens of microseconds between exchanges. Trace timestamps (trace.h) are
+// mapped through it to put every unit's events on one timeline.
+//
+// Header-only: one state per unit, used by the display and bridge builds.
+// ============================================================
+
+#ifndef CLOCK_SYNC_INTERVAL_MS
+#define CLOCK_SYNC_INTERVAL_MS 16000   // Between exchanges once locked
+#endif
+#ifndef CLOCK_SYNC_MAX_DELAY_US
+#define CLOCK_SYNC_MAX_DELAY_US 20000  // Exchanges with a longer round trip are dropped
+#endif
+#define CLOCK_SYNC_BURST       8       // Exchanges, CLOCK_SYNC_BURST_MS apart, to lock
+#define CLOCK_SYNC_BURST_MS    250
+#define CLOCK_SYNC_STEP_US     50000   // Further off than predicted: the reference jumped, re-lock
+#define CLOCK_SYNC_DRIFT_MAX   500.0f  // ppm, a sane crystal is well inside this
+#define CLOCK_SYNC_LOST        3       // Unanswered requests before bursting again
+
+struct ClockSyncState {
+    bool valid;
+    int64_t base_local_us;    // esp_timer at the reference point
+    int64_t base_host_us;     // Shared timebase at the same instant
+    float drift_ppm;          // Reference rate minus ours
+    uint32_t delay_us;        // Round trip of the last accepted exchange
+    int32_t last_error_us;    // Last sample against the prediction
+    uint32_t samples;         // Accepted since the last (re)lock
+    uint32_t rejected;
+    uint8_t unanswered;
+    uint8_t id;               // Of the pending request
+    int64_t t1_us;            // Its send time, 0 = none pending
+    uint32_t request_ms;
+};
+
+inline ClockSyncState clock_sync = {};
+
+// 64-bit esp_timer time of a recent micros() stamp (within ~71 minutes)
+inline int64_t clock_local_from_micros(uint32_t us) {
+    int64_t now = esp_timer_get_time();
+    return now - (int64_t)(uint32_t)((uint32_t)now - us);
+}
+
+inline bool clock_sync_valid() {
+    return clock_sync.valid;
+}
+
+// Shared-timebase microseconds at local esp_timer time `local_us`
+inline int64_t clock_sync_host_us(int64_t local_us) {
+    const ClockSyncState &s = clock_sync;
+    int64_t elapsed = local_us - s.base_local_us;
+    return s.base_host_us + elapsed + (int64_t)((double)elapsed * s.drift_ppm * 1e-6);
+}
+
+inline int64_t clock_sync_now_us() {
+    return clock_sync_host_us(esp_timer_get_time());
+}
+
+// Requester, from loop(): true when a request is due, filled into `req`.
+// `link` is false while nobody could answer (no companion, not paired).
+inline bool clock_sync_poll(ClockSyncMsg &req, bool link) {
+    ClockSyncState &s = clock_sync;
+    uint32_t now = millis();
+    uint32_t interval = s.samples < CLOCK_SYNC_BURST ? CLOCK_SYNC_BURST_MS : CLOCK_SYNC_INTERVAL_MS;
+    if (!link || (s.request_ms && now - s.request_ms < interval)) return false;
+    if (s.t1_us && ++s.unanswered >= CLOCK_SYNC_LOST && s.samples >= CLOCK_SYNC_BURST) {
+        s.samples = 0;   // Keep the estimate, but re-lock quickly once answers come back
+        s.unanswered = 0;
+    }
+    s.request_ms = now;
+    s.id++;
+    s.t1_us = esp_timer_get_time();
+    req = {};
+    req.id = s.id;
+    req.t1_us = s.t1_us;
+    return true;
+}
+
+// Responder: answer `req` received at local time `rx_local_us`. False until
+// this unit has a timebase of its own to hand out.
+inline bool clock_sync_answer(const ClockSyncMsg &req, int64_t rx_local_us, ClockSyncMsg &reply) {
+    if (!clock_sync.valid || (req.flags & CLOCK_F_REPLY)) return false;
+    reply = req;
+    reply.flags = CLOCK_F_REPLY;
+    reply.t2_us = clock_sync_host_us(rx_local_us);
+    reply.t3_us = clock_sync_now_us();
+    return true;
+}
+
+// Requester: the answer arrived at local time `t4_us`. Returns true if the
+// sample was used; `stepped` is set when the clock was (re)locked by it.
+inline bool clock_sync_sample(const ClockSyncMsg &reply, int64_t t4_us, bool *stepped = nullptr) {
+    ClockSyncState &s = clock_sync;
+    if (stepped) *stepped = false;
+    if (!(reply.flags & CLOCK_F_REPLY) || !s.t1_us || reply.id != s.id || reply.t1_us != s.t1_us) {
+        return false;   // Late answer to an older request
+    }
+    s.t1_us = 0;
+    s.unanswered = 0;
+    int64_t delay = (t4_us - reply.t1_us) - (reply.t3_us - reply.t2_us);
+    if (delay < 0 || delay > CLOCK_SYNC_MAX_DELAY_US) {
+        s.rejected++;
+        return false;
+    }
+    // Midpoints of both sides: offset = host - local there
+    int64_t local_mid = reply.t1_us + (t4_us - reply.t1_us) / 2;
+    int64_t host_mid = reply.t2_us + (reply.t3_us - reply.t2_us) / 2;
+    // While locking, a round trip much slower than the last one is mostly queueing
+    if (s.valid && s.samples && s.samples < CLOCK_SYNC_BURST && delay > 2 * (int64_t)s.delay_us + 1000) {
+        s.rejected++;
+        return false;
+    }
+    int64_t error = s.valid ? host_mid - clock_sync_host_us(local_mid) : 0;
+    if (!s.valid || error > CLOCK_SYNC_STEP_US || error < -CLOCK_SYNC_STEP_US) {
+        s.valid = true;
+        s.base_local_us = local_mid;
+        s.base_host_us = host_mid;
+        s.drift_ppm = 0;
+        s.samples = 1;
+        s.delay_us = (uint32_t)delay;
+        s.last_error_us = 0;
+        if (stepped) *stepped = true;
+        return true;
+    }
+    // Steer: half the error into the offset, and once the samples span a few
+    // seconds, a quarter of the implied rate error into the drift
+    int64_t span = local_mid - s.base_local_us;
+    if (s.samples >= CLOCK_SYNC_BURST && span >= 4000000) {
+        float ppm = s.drift_ppm + 0.25f * (float)((double)error * 1e6 / (double)span);
+        s.drift_ppm = ppm > CLOCK_SYNC_DRIFT_MAX ? CLOCK_SYNC_DRIFT_MAX
+                    : ppm < -CLOCK_SYNC_DRIFT_MAX ? -CLOCK_SYNC_DRIFT_MAX : ppm;
+    }
+    s.base_host_us = clock_sync_host_us(local_mid) + error / 2;
+    s.base_local_us = local_mid;
+    s.samples++;
+    s.delay_us = (uint32_t)delay;
+    s.last_error_us = (int32_t)error;
+    return true;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <stdint.h>
+#include "protocol.h"
+
+// ============================================================
+// Arduino keycodes -> HID keyboard usages
+//
+// HotkeyMsg and macro keycodes are the Arduino ones from protocol.h: ASCII
+// below 0x80 (US layout, shifted characters add left shift), 0x80-0x87
+// modifier keys, 0x88 and up raw usage + 136. Shared by the bridge's USB
+// keyboard and the display's BLE one (display/ble_hid.h).
+// ============================================================
+
+#define KEY_USAGE_SHIFT 0x80       // hid_ascii_usage(): character needs shift
+#define KEY_RAW_BASE    0x88       // Keycode of raw usage u: KEY_RAW_BASE + u
+
+struct HidAsciiPunct { char c; uint8_t usage; };
+constexpr HidAsciiPunct HID_ASCII_PUNCT[] = {
+    { ' ', 0x2C }, { '!', 0x1E | KEY_USAGE_SHIFT }, { '"', 0x34 | KEY_USAGE_SHIFT },
+    { '#', 0x20 | KEY_USAGE_SHIFT }, { '$', 0x21 | KEY_USAGE_SHIFT }, { '%', 0x22 | KEY_USAGE_SHIFT },
+    { '&', 0x24 | KEY_USAGE_SHIFT }, { '\'', 0x34 }, { '(', 0x26 | KEY_USAGE_SHIFT },
+    { ')', 0x27 | KEY_USAGE_SHIFT }, { '*', 0x25 | KEY_USAGE_SHIFT }, { '+', 0x2E | KEY_USAGE_SHIFT },
+    { ',', 0x36 }, { '-', 0x2D }, { '.', 0x37 }, { '/', 0x38 },
+    { ':', 0x33 | KEY_USAGE_SHIFT }, { ';', 0x33 }, { '<', 0x36 | KEY_USAGE_SHIFT },
+    { '=', 0x2E }, { '>', 0x37 | KEY_USAGE_SHIFT }, { '?', 0x38 | KEY_USAGE_SHIFT },
+    { '@', 0x1F | KEY_USAGE_SHIFT }, { '[', 0x2F }, { '\\', 0x31 }, { ']', 0x30 },
+    { '^', 0x23 | KEY_USAGE_SHIFT }, { '_', 0x2D | KEY_USAGE_SHIFT }, { '`', 0x35 },
+    { '{', 0x2F | KEY_USAGE_SHIFT }, { '|', 0x31 | KEY_USAGE_SHIFT }, { '}', 0x30 | KEY_USAGE_SHIFT },
+    { '~', 0x35 | KEY_USAGE_SHIFT },
+};
+
+// Usage of a printable ASCII character (US layout), KEY_USAGE_SHIFT set for
+// shifted ones. constexpr: key_layouts.h builds its tables from it.
+constexpr uint8_t hid_ascii_usage(uint8_t c) {
+    if (c >= 'a' && c <= 'z') return 0x04 + (c - 'a');
+    if (c >= 'A' && c <= 'Z') return (0x04 + (c - 'A')) | KEY_USAGE_SHIFT;
+    if (c >= '1' && c <= '9') return 0x1E + (c - '1');
+    if (c == '0') return 0x27;
+    switch (c) {
+        case '\b': return 0x2A;
+        case '\t': return 0x2B;
+        case '\n': return 0x28;
+        case 0x1B: return 0x29;
+    }
+    for (const auto &p : HID_ASCII_PUNCT) {
+        if (p.c == c) return p.usage;
+    }
+    return 0;
+}
+
+// Arduino keycode -> (usage, modifier bits it implies). usage 0 = modifier key only.
+inline bool hid_key_lookup(uint8_t keycode, uint8_t &usage, uint8_t &mods) {
+    mods = 0;
+    usage = 0;
+    if (keycode >= KEY_RAW_BASE) {
+        usage = keycode - KEY_RAW_BASE;
+    } else if (keycode >= 0x80) {
+        mods = 1 << (keycode - 0x80);   // KEY_LEFT_CTRL .. KEY_RIGHT_GUI, same order as the HID byte
+    } else {
+        uint8_t u = hid_ascii_usage(keycode);
+        if (!u) return false;
+        usage = u & ~KEY_USAGE_SHIFT;
+        if (u & KEY_USAGE_SHIFT) mods = MOD_SHIFT;
+    }
+    return true;
+}
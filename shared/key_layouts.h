@@ -0,0 +1,280 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "hid_keys.h"
+#include "protocol.h"
+
+// ============================================================
+// Host keyboard layouts for typed text (ACTION_TYPE_TEXT / MSG_TYPE_TEXT)
+//
+// The host turns usages into characters with its own layout, so typing a
+// character means pressing the key that produces it there. Per layout:
+//
+//   - printable ASCII: a 95-entry table built at compile time from the US
+//     mapping (hid_ascii_usage()) plus the keys that layout moves. A moved
+//     lowercase letter moves its capital with it.
+//   - everything else: a short list of the layout's own characters (umlauts,
+//     accented letters, currency signs).
+//
+// A character behind a dead key (^ and the accents on DE/FR) is two
+// strokes: the dead key, then the base letter, or space for the accent on
+// its own. Characters a layout can't type return no strokes and are
+// skipped by the player. Layouts are the stock Windows/xkb ones without
+// variants; FR is AZERTY with the digits shifted.
+// ============================================================
+
+enum KeyLayout : uint8_t {
+    KEY_LAYOUT_US = 0,
+    KEY_LAYOUT_UK = 1,
+    KEY_LAYOUT_DE = 2,   // QWERTZ
+    KEY_LAYOUT_FR = 3,   // AZERTY
+    KEY_LAYOUT_COUNT
+};
+
+struct KeyStroke {
+    uint8_t usage;       // HID keyboard usage
+    uint8_t mods;        // MOD_SHIFT / MOD_RALT (AltGr)
+};
+
+#define KEY_STROKES_MAX 2   // Dead key + base
+
+struct KeyDef {
+    uint16_t cp;         // Unicode code point (BMP)
+    KeyStroke key;
+    KeyStroke dead;      // usage 0 = typed directly
+};
+
+namespace key_layout_detail {
+
+constexpr uint8_t S = MOD_SHIFT;
+constexpr uint8_t G = MOD_RALT;
+
+constexpr KeyDef k(uint16_t cp, uint8_t usage, uint8_t mods = 0) {
+    return { cp, { usage, mods }, { 0, 0 } };
+}
+// Dead key (dead_usage + dead_mods), then `usage`
+constexpr KeyDef d(uint16_t cp, uint8_t dead_usage, uint8_t dead_mods, uint8_t usage, uint8_t mods = 0) {
+    return { cp, { usage, mods }, { dead_usage, dead_mods } };
+}
+
+#define KEY_ASCII_FIRST 0x20
+#define KEY_ASCII_COUNT 95   // ' ' .. '~'
+
+struct AsciiMap {
+    KeyStroke key[KEY_ASCII_COUNT] = {};
+    KeyStroke dead[KEY_ASCII_COUNT] = {};
+};
+
+template <size_t N>
+constexpr AsciiMap make_ascii(const KeyDef (&moved)[N]) {
+    AsciiMap m;
+    for (int i = 0; i < KEY_ASCII_COUNT; i++) {
+        uint8_t u = hid_ascii_usage((uint8_t)(KEY_ASCII_FIRST + i));
+        m.key[i] = { (uint8_t)(u & ~KEY_USAGE_SHIFT), (uint8_t)(u & KEY_USAGE_SHIFT ? MOD_SHIFT : 0) };
+    }
+    for (size_t j = 0; j < N; j++) {
+        const KeyDef &def = moved[j];
+        if (def.cp < KEY_ASCII_FIRST || def.cp >= KEY_ASCII_FIRST + KEY_ASCII_COUNT) continue;
+        m.key[def.cp - KEY_ASCII_FIRST] = def.key;
+        m.dead[def.cp - KEY_ASCII_FIRST] = def.dead;
+        if (def.cp >= 'a' && def.cp <= 'z') {
+            m.key[def.cp - 'a' + 'A' - KEY_ASCII_FIRST] = { def.key.usage, (uint8_t)(def.key.mods | MOD_SHIFT) };
+        }
+    }
+    return m;
+}
+
+// Every printable ASCII character has a key (the layout list is complete)
+constexpr bool ascii_complete(const AsciiMap &m) {
+    for (int i = 0; i < KEY_ASCII_COUNT; i++) {
+        if (!m.key[i].usage) return false;
+    }
+    return true;
+}
+
+constexpr KeyDef NONE[] = { k(0, 0) };
+
+constexpr KeyDef UK_MOVED[] = {
+    k('"', 0x1F, S), k('@', 0x34, S), k('#', 0x32), k('~', 0x32, S), k('\\', 0x64), k('|', 0x64, S),
+};
+constexpr KeyDef UK_EXTRA[] = {
+    k(0x00A3, 0x20, S),   // £
+    k(0x00AC, 0x35, S),   // ¬
+    k(0x20AC, 0x21, G),   // €
+};
+
+constexpr KeyDef DE_MOVED[] = {
+    k('y', 0x1D), k('z', 0x1C),
+    k('"', 0x1F, S), k('#', 0x32), k('&', 0x23, S), k('\'', 0x32, S), k('(', 0x25, S), k(')', 0x26, S),
+    k('*', 0x30, S), k('+', 0x30), k('-', 0x38), k('/', 0x24, S), k(':', 0x37, S), k(';', 0x36, S),
+    k('<', 0x64), k('=', 0x27, S), k('>', 0x64, S), k('?', 0x2D, S), k('@', 0x14, G), k('[', 0x25, G),
+    k('\\', 0x2D, G), k(']', 0x26, G), k('_', 0x38, S), k('{', 0x24, G), k('|', 0x64, G),
+    k('}', 0x27, G), k('~', 0x30, G),
+    d('^', 0x35, 0, 0x2C), d('`', 0x2E, S, 0x2C),
+};
+constexpr KeyDef DE_EXTRA[] = {
+    k(0x00A7, 0x20, S), k(0x00B0, 0x35, S), k(0x00B2, 0x1F, G), k(0x00B3, 0x20, G),   // § ° ² ³
+    k(0x00B5, 0x10, G), k(0x20AC, 0x08, G),                                           // µ €
+    k(0x00C4, 0x34, S), k(0x00D6, 0x33, S), k(0x00DC, 0x2F, S),                       // Ä Ö Ü
+    k(0x00E4, 0x34), k(0x00F6, 0x33), k(0x00FC, 0x2F), k(0x00DF, 0x2D),               // ä ö ü ß
+    d(0x00B4, 0x2E, 0, 0x2C),                                                          // ´
+    // Acute, grave and circumflex dead keys
+    d(0x00E1, 0x2E, 0, 0x04), d(0x00E9, 0x2E, 0, 0x08), d(0x00ED, 0x2E, 0, 0x0C),
+    d(0x00F3, 0x2E, 0, 0x12), d(0x00FA, 0x2E, 0, 0x18),
+    d(0x00C1, 0x2E, 0, 0x04, S), d(0x00C9, 0x2E, 0, 0x08, S), d(0x00CD, 0x2E, 0, 0x0C, S),
+    d(0x00D3, 0x2E, 0, 0x12, S), d(0x00DA, 0x2E, 0, 0x18, S),
+    d(0x00E0, 0x2E, S, 0x04), d(0x00E8, 0x2E, S, 0x08), d(0x00EC, 0x2E, S, 0x0C),
+    d(0x00F2, 0x2E, S, 0x12), d(0x00F9, 0x2E, S, 0x18),
+    d(0x00C0, 0x2E, S, 0x04, S), d(0x00C8, 0x2E, S, 0x08, S), d(0x00CC, 0x2E, S, 0x0C, S),
+    d(0x00D2, 0x2E, S, 0x12, S), d(0x00D9, 0x2E, S, 0x18, S),
+    d(0x00E2, 0x35, 0, 0x04), d(0x00EA, 0x35, 0, 0x08), d(0x00EE, 0x35, 0, 0x0C),
+    d(0x00F4, 0x35, 0, 0x12), d(0x00FB, 0x35, 0, 0x18),
+};
+
+constexpr KeyDef FR_MOVED[] = {
+    k('a', 0x14), k('q', 0x04), k('z', 0x1A), k('w', 0x1D), k('m', 0x33),
+    k('1', 0x1E, S), k('2', 0x1F, S), k('3', 0x20, S), k('4', 0x21, S), k('5', 0x22, S),
+    k('6', 0x23, S), k('7', 0x24, S), k('8', 0x25, S), k('9', 0x26, S), k('0', 0x27, S),
+    k('&', 0x1E), k('"', 0x20), k('\'', 0x21), k('(', 0x22), k('-', 0x23), k('_', 0x25), k(')', 0x2D),
+    k('=', 0x2E), k('+', 0x2E, S), k('$', 0x30), k('*', 0x32), k('%', 0x34, S), k(',', 0x10),
+    k('?', 0x10, S), k(';', 0x36), k('.', 0x36, S), k(':', 0x37), k('/', 0x37, S), k('!', 0x38),
+    k('<', 0x64), k('>', 0x64, S),
+    k('~', 0x1F, G), k('#', 0x20, G), k('{', 0x21, G), k('[', 0x22, G), k('|', 0x23, G),
+    k('`', 0x24, G), k('\\', 0x25, G), k('^', 0x26, G), k('@', 0x27, G), k(']', 0x2D, G),
+    k('}', 0x2E, G),
+};
+constexpr KeyDef FR_EXTRA[] = {
+    k(0x00E9, 0x1F), k(0x00E8, 0x24), k(0x00E7, 0x26), k(0x00E0, 0x27), k(0x00F9, 0x34),   // é è ç à ù
+    k(0x00B0, 0x2D, S), k(0x00A3, 0x30, S), k(0x00A4, 0x30, G), k(0x00B5, 0x32, S),        // ° £ ¤ µ
+    k(0x00A7, 0x38, S), k(0x00B2, 0x35), k(0x20AC, 0x08, G),                               // § ² €
+    d(0x00A8, 0x2F, S, 0x2C),                                                               // ¨
+    // Circumflex and diaeresis dead keys (AZERTY letter positions)
+    d(0x00E2, 0x2F, 0, 0x14), d(0x00EA, 0x2F, 0, 0x08), d(0x00EE, 0x2F, 0, 0x0C),
+    d(0x00F4, 0x2F, 0, 0x12), d(0x00FB, 0x2F, 0, 0x18),
+    d(0x00C2, 0x2F, 0, 0x14, S), d(0x00CA, 0x2F, 0, 0x08, S), d(0x00CE, 0x2F, 0, 0x0C, S),
+    d(0x00D4, 0x2F, 0, 0x12, S), d(0x00DB, 0x2F, 0, 0x18, S),
+    d(0x00E4, 0x2F, S, 0x14), d(0x00EB, 0x2F, S, 0x08), d(0x00EF, 0x2F, S, 0x0C),
+    d(0x00F6, 0x2F, S, 0x12), d(0x00FC, 0x2F, S, 0x18), d(0x00FF, 0x2F, S, 0x1C),
+    d(0x00C4, 0x2F, S, 0x14, S), d(0x00CB, 0x2F, S, 0x08, S), d(0x00CF, 0x2F, S, 0x0C, S),
+    d(0x00D6, 0x2F, S, 0x12, S), d(0x00DC, 0x2F, S, 0x18, S),
+};
+
+constexpr AsciiMap ASCII[KEY_LAYOUT_COUNT] = {
+    make_ascii(NONE), make_ascii(UK_MOVED), make_ascii(DE_MOVED), make_ascii(FR_MOVED),
+};
+static_assert(ascii_complete(ASCII[KEY_LAYOUT_US]) && ascii_complete(ASCII[KEY_LAYOUT_UK]) &&
+              ascii_complete(ASCII[KEY_LAYOUT_DE]) && ascii_complete(ASCII[KEY_LAYOUT_FR]),
+              "every layout types all of printable ASCII");
+static_assert(ASCII[KEY_LAYOUT_DE].key['Z' - KEY_ASCII_FIRST].usage == 0x1C, "moved letters take their capitals");
+
+struct ExtraList {
+    const KeyDef *defs;
+    uint8_t count;
+};
+constexpr ExtraList EXTRA[KEY_LAYOUT_COUNT] = {
+    { nullptr, 0 },
+    { UK_EXTRA, sizeof(UK_EXTRA) / sizeof(KeyDef) },
+    { DE_EXTRA, sizeof(DE_EXTRA) / sizeof(KeyDef) },
+    { FR_EXTRA, sizeof(FR_EXTRA) / sizeof(KeyDef) },
+};
+
+inline uint8_t emit(const KeyStroke &key, const KeyStroke &dead, KeyStroke *out) {
+    uint8_t n = 0;
+    if (dead.usage) out[n++] = dead;
+    out[n++] = key;
+    return n;
+}
+
+}  // namespace key_layout_detail
+
+// Strokes that type code point `cp` on `layout`, in order. Returns how many
+// (0: the layout has no key for it). Tab, newline, backspace and escape
+// are the same everywhere.
+inline uint8_t key_layout_strokes(uint8_t layout, uint32_t cp, KeyStroke out[KEY_STROKES_MAX]) {
+    using namespace key_layout_detail;
+    if (layout >= KEY_LAYOUT_COUNT) layout = KEY_LAYOUT_US;
+    if (cp < KEY_ASCII_FIRST) {
+        uint8_t u = hid_ascii_usage((uint8_t)cp);
+        if (!u) return 0;
+        out[0] = { u, 0 };
+        return 1;
+    }
+    if (cp < KEY_ASCII_FIRST + KEY_ASCII_COUNT) {
+        const AsciiMap &m = ASCII[layout];
+        return emit(m.key[cp - KEY_ASCII_FIRST], m.dead[cp - KEY_ASCII_FIRST], out);
+    }
+    const ExtraList &x = EXTRA[layout];
+    for (uint8_t i = 0; i < x.count; i++) {
+        if (x.defs[i].cp == cp) return emit(x.defs[i].key, x.defs[i].dead, out);
+    }
+    return 0;
+}
+
+// Next code point of a UTF-8 string. A malformed or truncated sequence
+// yields U+FFFD and skips one byte. False at `end`.
+inline bool utf8_next(const uint8_t *&p, const uint8_t *end, uint32_t &cp) {
+    if (p >= end) return false;
+    uint8_t b = *p++;
+    int more = b < 0x80 ? 0 : (b & 0xE0) == 0xC0 ? 1 : (b & 0xF0) == 0xE0 ? 2 : (b & 0xF8) == 0xF0 ? 3 : -1;
+    if (more < 0) {
+        cp = 0xFFFD;
+        return true;
+    }
+    cp = more ? b & (0x3F >> more) : b;
+    const uint8_t *q = p;
+    for (int i = 0; i < more; i++, q++) {
+        if (q >= end || (*q & 0xC0) != 0x80) {
+            cp = 0xFFFD;
+            return true;
+        }
+        cp = cp << 6 | (*q & 0x3F);
+    }
+    p = q;
+    return true;
+}
+
+// `utf8` as MACRO_OP_TAP steps (raw usage keycodes, KEY_RAW_BASE), for
+// players without MSG_TYPE_TEXT: BLE, bridges that don't advertise
+// PROTO_CAP_TYPE_TEXT. Stops at a character that doesn't fit in `max`.
+// Returns the step count; `typed` is how many bytes it covers.
+inline uint8_t key_layout_macro(uint8_t layout, const char *utf8, size_t len, MacroStep *steps, uint8_t max,
+                                size_t *typed = nullptr) {
+    const uint8_t *p = (const uint8_t *)utf8, *end = p + len;
+    uint8_t n = 0;
+    uint32_t cp;
+    const uint8_t *at = p;
+    while (utf8_next(p, end, cp)) {
+        KeyStroke ks[KEY_STROKES_MAX];
+        uint8_t k = key_layout_strokes(layout, cp, ks);
+        if (n + k > max) break;
+        for (uint8_t i = 0; i < k; i++) {
+            steps[n++] = { MACRO_OP_TAP, ks[i].mods, (uint8_t)(KEY_RAW_BASE + ks[i].usage) };
+        }
+        at = p;
+    }
+    if (typed) *typed = at - (const uint8_t *)utf8;
+    return n;
+}
+
+// Bytes of `s` (at most max_len) that end on a character boundary
+inline size_t utf8_clip(const char *s, size_t len, size_t max_len) {
+    if (len <= max_len) return len;
+    size_t n = max_len;
+    while (n > 0 && ((uint8_t)s[n] & 0xC0) == 0x80) n--;
+    return n;
+}
+
+// "us", "uk", "de", "fr"
+inline const char *key_layout_name(uint8_t layout) {
+    static const char *const NAMES[KEY_LAYOUT_COUNT] = { "us", "uk", "de", "fr" };
+    return layout < KEY_LAYOUT_COUNT ? NAMES[layout] : NAMES[KEY_LAYOUT_US];
+}
+
+// KEY_LAYOUT_COUNT for a name that isn't one of the above
+inline uint8_t key_layout_from_name(const char *name) {
+    for (uint8_t i = 0; i < KEY_LAYOUT_COUNT; i++) {
+        if (name && strcasecmp(name, key_layout_name(i)) == 0) return i;
+    }
+    return KEY_LAYOUT_COUNT;
+}
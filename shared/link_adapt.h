@@ -0,0 +1,217 @@
+#pragma once
+#include <stdint.h>
+
+// ============================================================
+// ESP-NOW link adaptation (ESPNOW_ADAPT)
+//
+// Each unit steers its own TX power and unicast PHY rate from how well its
+// frames arrive: the far end's RSSI of them (LinkReportMsg in protocol.h,
+// carried by PINGs and their ACKs) and the share of them lost on the way
+// (MAC-level send failures, plus SEQ retransmits on the display). The
+// RSSI a unit hears itself says how loud the *other* side is, which the
+// other side is turning up and down, so it is not used for this.
+//
+// Evaluated once per window (link_adapt_step):
+//   lossy or weak   power up ADAPT_STEP_UP_QDBM; at full power, one rate
+//                   step more robust instead
+//   strong, clean   after ADAPT_GOOD_WINDOWS such windows in a row: back one
+//                   rate step faster first, then power down ADAPT_STEP_DOWN_QDBM
+// Going down is slow and in small steps, going up fast and in big ones.
+// Without a far-end report (an older peer) power is never lowered.
+//
+// Power is in esp_wifi_set_max_tx_power() units (0.25 dBm). Rate is a step
+// index into the caller's ladder of PHY rates, 0 = fastest (ESPNOW_PHY_RATE).
+//
+// Header-only: shared by the display and bridge builds.
+// ============================================================
+
+#ifndef ESPNOW_ADAPT
+#define ESPNOW_ADAPT 1                 // 0 = fixed power and rate, as before
+#endif
+#ifndef ESPNOW_ADAPT_RSSI_STRONG
+#define ESPNOW_ADAPT_RSSI_STRONG (-60) // Far-end RSSI (dBm) with margin to spare
+#endif
+#ifndef ESPNOW_ADAPT_RSSI_WEAK
+#define ESPNOW_ADAPT_RSSI_WEAK (-80)   // ... below this: turn up
+#endif
+#ifndef ESPNOW_ADAPT_LOSS_PCT
+#define ESPNOW_ADAPT_LOSS_PCT 15       // Frames lost in a window: turn up at or above
+#endif
+#ifndef ESPNOW_ADAPT_POWER_MIN
+#define ESPNOW_ADAPT_POWER_MIN 8       // 2 dBm, the driver's floor
+#endif
+#ifndef ESPNOW_ADAPT_POWER_MAX
+#define ESPNOW_ADAPT_POWER_MAX 80      // 20 dBm, the default
+#endif
+
+#define ADAPT_STEP_DOWN_QDBM 8         // 2 dB
+#define ADAPT_STEP_UP_QDBM   16        // 4 dB
+#define ADAPT_GOOD_WINDOWS   3         // Strong windows in a row before giving anything up
+#define ADAPT_CLEAN_PCT      5         // "Clean": this much loss or less
+#define ADAPT_MIN_FRAMES     4         // Loss counts once a window has this many frames
+#define ADAPT_RSSI_SHIFT     2         // Far-end RSSI EWMA weight 1/4
+#define LINK_ADAPT_HISTORY   8
+
+enum LinkAdaptReason : uint8_t {
+    ADAPT_STRONG = 0,   // Margin to spare: faster / quieter
+    ADAPT_WEAK   = 1,   // Far-end RSSI low
+    ADAPT_LOSSY  = 2,   // Too many frames lost
+    ADAPT_RESET  = 3,   // Back to full power and rate (link lost, new peer, SoftAP)
+};
+
+inline const char *link_adapt_reason_name(uint8_t reason) {
+    switch (reason) {
+        case ADAPT_STRONG: return "strong";
+        case ADAPT_WEAK:   return "weak";
+        case ADAPT_LOSSY:  return "lossy";
+        case ADAPT_RESET:  return "reset";
+    }
+    return "?";
+}
+
+// Smoothed far-end RSSI, x16 to keep the EWMA's fraction
+struct RssiAvg {
+    int16_t x16;
+    bool    valid;
+};
+
+inline void rssi_avg_add(RssiAvg &a, int8_t rssi_dbm) {
+    if (rssi_dbm == 0) return;   // "Nothing heard yet"
+    if (!a.valid) {
+        a.x16 = (int16_t)(rssi_dbm * 16);
+        a.valid = true;
+        return;
+    }
+    a.x16 += (int16_t)((rssi_dbm * 16 - a.x16) >> ADAPT_RSSI_SHIFT);
+}
+
+inline int8_t rssi_avg_dbm(const RssiAvg &a) {
+    return a.valid ? (int8_t)(a.x16 / 16) : 0;
+}
+
+// Our power moved by delta_qdbm: the far end will hear that much more or
+// less, so move the average with it instead of waiting for it to catch up
+inline void rssi_avg_shift(RssiAvg &a, int delta_qdbm) {
+    if (a.valid) a.x16 += (int16_t)(delta_qdbm * 4);   // qdbm / 4 dB, x16
+}
+
+struct LinkAdaptChange {
+    uint32_t at_ms;
+    int8_t   power_qdbm;   // Setting after the change
+    uint8_t  rate;
+    int8_t   rssi_dbm;     // Far-end RSSI that drove it, 0 = none
+    uint8_t  loss_pct;
+    uint8_t  reason;       // LinkAdaptReason
+};
+
+struct LinkAdapt {
+    int8_t   power_qdbm;
+    int8_t   power_min, power_max;
+    uint8_t  rate, rate_steps;      // Ladder has rate_steps entries
+    int8_t   last_delta;            // Power change of the latest step (for rssi_avg_shift)
+    uint8_t  good;                  // Strong windows in a row
+    uint32_t ok, lost;              // This window
+    uint32_t changes;               // Since boot
+    LinkAdaptChange history[LINK_ADAPT_HISTORY];
+    uint8_t  hist_head;             // Next entry written
+};
+
+inline void link_adapt_record_(LinkAdapt &s, uint32_t now, int8_t rssi, uint8_t loss, uint8_t reason) {
+    LinkAdaptChange &c = s.history[s.hist_head];
+    c.at_ms = now;
+    c.power_qdbm = s.power_qdbm;
+    c.rate = s.rate;
+    c.rssi_dbm = rssi;
+    c.loss_pct = loss;
+    c.reason = reason;
+    s.hist_head = (uint8_t)((s.hist_head + 1) % LINK_ADAPT_HISTORY);
+    s.changes++;
+}
+
+inline void link_adapt_init(LinkAdapt &s, uint8_t rate_steps) {
+    s = LinkAdapt();
+    s.power_min = ESPNOW_ADAPT_POWER_MIN;
+    s.power_max = ESPNOW_ADAPT_POWER_MAX;
+    s.power_qdbm = s.power_max;
+    s.rate_steps = rate_steps ? rate_steps : 1;
+}
+
+inline void link_adapt_count(LinkAdapt &s, uint32_t ok, uint32_t lost) {
+    s.ok += ok;
+    s.lost += lost;
+}
+
+// Full power, fastest rate, window cleared. True if that changed anything.
+inline bool link_adapt_reset(LinkAdapt &s, uint32_t now) {
+    s.ok = s.lost = 0;
+    s.good = 0;
+    s.last_delta = (int8_t)(s.power_max - s.power_qdbm);
+    if (s.power_qdbm == s.power_max && s.rate == 0) return false;
+    s.power_qdbm = s.power_max;
+    s.rate = 0;
+    link_adapt_record_(s, now, 0, 0, ADAPT_RESET);
+    return true;
+}
+
+// End of a window. True if power or rate changed: the caller applies them
+// and shifts its far-end averages by last_delta. A window with too few
+// frames for a loss figure goes on counting; RSSI alone can still act.
+inline bool link_adapt_step(LinkAdapt &s, const RssiAvg &far, uint32_t now) {
+    s.last_delta = 0;
+    uint32_t total = s.ok + s.lost;
+    bool counted = total >= ADAPT_MIN_FRAMES;
+    uint8_t loss = total ? (uint8_t)(s.lost * 100 / total) : 0;
+    if (counted) s.ok = s.lost = 0;
+    int8_t rssi = rssi_avg_dbm(far);
+    bool weak = far.valid && rssi < ESPNOW_ADAPT_RSSI_WEAK;
+    bool lossy = counted && loss >= ESPNOW_ADAPT_LOSS_PCT;
+
+    if (weak || lossy) {
+        s.good = 0;
+        if (s.power_qdbm < s.power_max) {
+            int p = s.power_qdbm + ADAPT_STEP_UP_QDBM;
+            if (p > s.power_max) p = s.power_max;
+            s.last_delta = (int8_t)(p - s.power_qdbm);
+            s.power_qdbm = (int8_t)p;
+        } else if (s.rate + 1 < s.rate_steps) {
+            s.rate++;
+        } else {
+            return false;   // Nothing left to give
+        }
+        link_adapt_record_(s, now, rssi, loss, lossy ? ADAPT_LOSSY : ADAPT_WEAK);
+        return true;
+    }
+
+    // A faster rate comes back once the link is fair again, power only
+    // goes down with a far end that hears us clearly
+    bool clean = !counted || loss <= ADAPT_CLEAN_PCT;
+    bool fair = !far.valid || rssi >= (ESPNOW_ADAPT_RSSI_STRONG + ESPNOW_ADAPT_RSSI_WEAK) / 2;
+    bool strong = far.valid && rssi >= ESPNOW_ADAPT_RSSI_STRONG;
+    bool better = s.rate > 0 ? fair : (strong && s.power_qdbm > s.power_min);
+    if (!clean || !better || !counted) {
+        if (!clean || !better) s.good = 0;
+        return false;
+    }
+    if (++s.good < ADAPT_GOOD_WINDOWS) return false;
+    s.good = 0;
+    if (s.rate > 0) {
+        s.rate--;
+    } else {
+        int p = s.power_qdbm - ADAPT_STEP_DOWN_QDBM;
+        if (p < s.power_min) p = s.power_min;
+        s.last_delta = (int8_t)(p - s.power_qdbm);
+        s.power_qdbm = (int8_t)p;
+    }
+    link_adapt_record_(s, now, rssi, loss, ADAPT_STRONG);
+    return true;
+}
+
+// History, newest first; returns the number of entries copied
+inline int link_adapt_history(const LinkAdapt &s, LinkAdaptChange *out, int max) {
+    uint32_t n = s.changes < LINK_ADAPT_HISTORY ? s.changes : LINK_ADAPT_HISTORY;
+    int count = 0;
+    for (uint32_t i = 0; i < n && count < max; i++) {
+        out[count++] = s.history[(s.hist_head + LINK_ADAPT_HISTORY - 1 - i) % LINK_ADAPT_HISTORY];
+    }
+    return count;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <Arduino.h>
+
+// ============================================================
+// Compile-time log levels
+//
+// Serial.printf at 115200 baud costs ~87us per character once the UART
+// FIFO is full, so a chatty line on a per-keystroke or per-frame path
+// stalls that path for milliseconds. Hot-path messages use LOG_D and
+// compile to nothing unless LOG_LEVEL is raised; the event itself is
+// still recorded in the trace ring (trace.h).
+//
+//   LOG_LEVEL 0 none, 1 errors, 2 + warnings, 3 + info (default), 4 + debug
+// ============================================================
+
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_E(...) Serial.printf(__VA_ARGS__)
+#else
+#define LOG_E(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_W(...) Serial.printf(__VA_ARGS__)
+#else
+#define LOG_W(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_I(...) Serial.printf(__VA_ARGS__)
+#else
+#define LOG_I(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_D(...) Serial.printf(__VA_ARGS__)
+#else
+#define LOG_D(...) do {} while (0)
+#endif
@@ -0,0 +1,213 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include "log.h"
+#include "trace.h"
+
+// ============================================================
+// Loop-stall watchdog
+//
+// Attributes every loop() pass to the subsystems it ran, from the CPU
+// cycle counter: loop_watch_begin() once the pass has work (after the
+// idle wait), then loop_watch_mark(section) after each subsystem. A mark
+// closes the section that began at the previous mark, as
+// perf_boot_mark() does for boot phases; loop_watch_end() closes the pass.
+//
+// A pass over the budget is a stall. It goes into the trace ring
+// (TR_LOOP_STALL, a = the longest section, b = pass us), onto the console
+// (LOG_W, at most once per LOOP_STALL_LOG_MS) and into a small log in RTC
+// memory, which survives the panic or task watchdog reset a long stall
+// may end in. Per-section worst times and stall counts are reported by
+// GET /api/perf on the display and MSG_BRIDGE_STATS on the bridge.
+//
+// Header-only: shared by the display and bridge builds, one watch per
+// unit, fed by the loop() task alone.
+// ============================================================
+
+#ifndef LOOP_WATCH_ENABLE
+#define LOOP_WATCH_ENABLE 1
+#endif
+#define LOOP_WATCH_SECTIONS 16   // Most sections a unit may name
+#ifndef LOOP_STALL_LOG_SIZE
+#define LOOP_STALL_LOG_SIZE 16   // Stalls kept in RTC memory (16 bytes each)
+#endif
+#ifndef LOOP_STALL_LOG_MS
+#define LOOP_STALL_LOG_MS 1000   // Console lines at most this often
+#endif
+
+struct LoopStall {
+    uint16_t boot;         // loop_watch_boot() of the pass
+    uint8_t  section;      // Longest section of the pass
+    uint8_t  reserved;
+    uint32_t at_ms;        // millis() at the end of the pass
+    uint32_t total_us;     // Pass time
+    uint32_t section_us;   // ... of which in `section`
+};
+
+struct LoopSectionStats {
+    uint32_t max_us;       // Longest single run (since reset)
+    uint32_t stalls;       // Stalls it was the longest section in
+};
+
+struct LoopWatchStats {
+    uint32_t budget_us;
+    uint32_t passes;       // Since reset
+    uint32_t stalls;
+    uint32_t max_us;       // Longest pass
+    uint8_t  max_section;  // ... and its longest section
+};
+
+struct LoopWatch {
+    const char *const *names;
+    uint8_t count;
+    uint32_t budget_us;
+    uint32_t pass_ccount;  // Cycle counter at loop_watch_begin()
+    uint32_t mark_ccount;  // ... at the last mark
+    uint32_t cycles[LOOP_WATCH_SECTIONS];   // This pass
+    LoopSectionStats sections[LOOP_WATCH_SECTIONS];
+    LoopWatchStats stats;
+    uint32_t console_ms;
+    uint32_t unreported;   // Stalls not printed because of LOOP_STALL_LOG_MS
+};
+
+// RTC slow memory, not cleared by a software, panic or watchdog reset
+struct LoopStallLog {
+    uint32_t magic;
+    uint16_t boot;         // Incremented by every loop_watch_init()
+    uint16_t reserved;
+    uint32_t head;         // Stalls recorded, all boots
+    LoopStall entries[LOOP_STALL_LOG_SIZE];
+};
+#define LOOP_STALL_LOG_MAGIC 0x4C535431   // "LST1"
+
+inline LoopWatch loop_watch;
+// Plain section name (not RTC_NOINIT_ATTR's per-unit counter suffix) so
+// every translation unit agrees on where the one inline copy lives
+__attribute__((section(".rtc_noinit"))) inline LoopStallLog loop_stall_log;
+
+// `names[count]` (static strings) label the section ids passed to
+// loop_watch_mark(). Call once from setup().
+inline void loop_watch_init(const char *const *names, uint8_t count, uint32_t budget_us) {
+    LoopWatch &w = loop_watch;
+    w.names = names;
+    w.count = count < LOOP_WATCH_SECTIONS ? count : LOOP_WATCH_SECTIONS;
+    w.budget_us = budget_us;
+    w.stats = {};
+    w.stats.budget_us = budget_us;
+    memset(w.sections, 0, sizeof(w.sections));
+
+    LoopStallLog &log = loop_stall_log;
+    if (log.magic != LOOP_STALL_LOG_MAGIC) {
+        memset(&log, 0, sizeof(log));   // Power-on: RTC memory holds garbage
+        log.magic = LOOP_STALL_LOG_MAGIC;
+    }
+    log.boot++;
+    if (log.head) {
+        const LoopStall &last = log.entries[(log.head - 1) % LOOP_STALL_LOG_SIZE];
+        if (last.boot == (uint16_t)(log.boot - 1)) {
+            Serial.printf("Loop watch: previous boot stalled %lu us in %s at %lu ms\n",
+                          (unsigned long)last.total_us,
+                          last.section < w.count ? names[last.section] : "?",
+                          (unsigned long)last.at_ms);
+        }
+    }
+}
+
+inline void loop_watch_begin() {
+#if LOOP_WATCH_ENABLE
+    LoopWatch &w = loop_watch;
+    w.pass_ccount = w.mark_ccount = ESP.getCycleCount();
+    memset(w.cycles, 0, sizeof(w.cycles));
+#endif
+}
+
+// Close section `id`: everything since the previous mark (or begin) ran in it
+inline void loop_watch_mark(uint8_t id) {
+#if LOOP_WATCH_ENABLE
+    LoopWatch &w = loop_watch;
+    uint32_t now = ESP.getCycleCount();
+    if (id < LOOP_WATCH_SECTIONS) w.cycles[id] += now - w.mark_ccount;
+    w.mark_ccount = now;
+#else
+    (void)id;
+#endif
+}
+
+inline void loop_watch_end() {
+#if LOOP_WATCH_ENABLE
+    LoopWatch &w = loop_watch;
+    uint32_t mhz = getCpuFrequencyMhz();   // The power policy may have changed it
+    uint32_t total_us = (ESP.getCycleCount() - w.pass_ccount) / mhz;
+    uint8_t worst = 0;
+    for (uint8_t i = 0; i < w.count; i++) {
+        uint32_t us = w.cycles[i] / mhz;
+        if (us > w.sections[i].max_us) w.sections[i].max_us = us;
+        if (w.cycles[i] > w.cycles[worst]) worst = i;
+    }
+    w.stats.passes++;
+    if (total_us > w.stats.max_us) {
+        w.stats.max_us = total_us;
+        w.stats.max_section = worst;
+    }
+    if (total_us <= w.budget_us || !w.count) return;
+
+    w.stats.stalls++;
+    w.sections[worst].stalls++;
+    uint32_t section_us = w.cycles[worst] / mhz;
+    trace(TR_LOOP_STALL, worst, total_us);
+
+    LoopStallLog &log = loop_stall_log;
+    LoopStall &e = log.entries[log.head % LOOP_STALL_LOG_SIZE];
+    e.boot = log.boot;
+    e.section = worst;
+    e.reserved = 0;
+    e.at_ms = millis();
+    e.total_us = total_us;
+    e.section_us = section_us;
+    log.head++;
+
+    // After the pass is measured, so the line itself is never counted
+    if (w.console_ms && e.at_ms - w.console_ms < LOOP_STALL_LOG_MS) {
+        w.unreported++;
+        return;
+    }
+    LOG_W("Loop stall: %lu us (budget %lu), %lu us in %s, %lu more since the last report\n",
+          (unsigned long)total_us, (unsigned long)w.budget_us, (unsigned long)section_us,
+          w.names[worst], (unsigned long)w.unreported);
+    w.console_ms = e.at_ms;
+    w.unreported = 0;
+#endif
+}
+
+inline uint16_t loop_watch_boot() { return loop_stall_log.boot; }
+
+inline const char *loop_watch_section_name(uint8_t id) {
+    return id < loop_watch.count ? loop_watch.names[id] : "?";
+}
+
+inline uint8_t loop_watch_section_count() { return loop_watch.count; }
+
+// Counters since the last reset, and one section's
+inline void loop_watch_get(LoopWatchStats &out) { out = loop_watch.stats; }
+inline LoopSectionStats loop_watch_section(uint8_t id) {
+    return id < loop_watch.count ? loop_watch.sections[id] : LoopSectionStats{};
+}
+
+// Clears the counters; the RTC log is history and stays
+inline void loop_watch_reset() {
+    LoopWatch &w = loop_watch;
+    w.stats = {};
+    w.stats.budget_us = w.budget_us;
+    memset(w.sections, 0, sizeof(w.sections));
+}
+
+// Copy up to `max` of the newest logged stalls (any boot), oldest first
+inline size_t loop_watch_stalls(LoopStall *out, size_t max) {
+    const LoopStallLog &log = loop_stall_log;
+    uint32_t avail = log.head < LOOP_STALL_LOG_SIZE ? log.head : LOOP_STALL_LOG_SIZE;
+    if (max > avail) max = avail;
+    for (size_t i = 0; i < max; i++) {
+        out[i] = log.entries[(log.head - max + i) % LOOP_STALL_LOG_SIZE];
+    }
+    return max;
+}
@@ -0,0 +1,145 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// ============================================================
+// LZ payload compression (PROTO_CAP_COMPRESS)
+//
+// A byte-aligned LZ77 in the LZ4 / heatshrink family, sized for a
+// microcontroller receiver: a 1 KB back-reference window and no tables to
+// build, so decoding needs nothing but the window itself. The companion
+// compresses (companion/lz_stream.py); the display decodes compact
+// notifications (NOTIF_F_LZ) and BULK_FLAG_LZ file transfers, the bridge
+// notifications for displays that don't.
+//
+// The stream is a sequence of tokens:
+//   0x00..0x7F  literal run: the next (t + 1) bytes are copied as they are
+//   0x80..0xFF  match: length ((t >> 2) & 0x1F) + LZ_MIN_MATCH, distance
+//               ((t & 3) << 8 | next byte) + 1 back into the output
+// A match may overlap the bytes it produces (distance < length repeats a
+// run). The stream ends after any complete token.
+//
+// LzDecoder is streaming: input goes in as it arrives, split anywhere,
+// and output leaves through the sink in pieces of at most LZ_WINDOW bytes.
+// No allocation, and no state beyond the struct (a little over LZ_WINDOW).
+// lz_decode_flat() is the one-shot form for a payload that fits a buffer.
+//
+// Header-only: shared by the display and bridge builds.
+// ============================================================
+
+#define LZ_WINDOW       1024   // Power of two: back references are masked into it
+#define LZ_MIN_MATCH    3
+#define LZ_MAX_MATCH    (0x1F + LZ_MIN_MATCH)   // 34
+#define LZ_MAX_LITERALS 0x80
+
+// Takes `len` decoded bytes; false stops the decoder (a failed write)
+typedef bool (*LzSink)(void *ctx, const uint8_t *data, size_t len);
+
+enum LzState : uint8_t {
+    LZ_ST_TOKEN,      // Next byte is a token
+    LZ_ST_LITERAL,    // `count` literal bytes to go
+    LZ_ST_DISTANCE,   // Match token read, its distance byte next
+};
+
+struct LzDecoder {
+    uint8_t  window[LZ_WINDOW];
+    uint16_t head;       // Next window byte written
+    uint16_t flushed;    // First window byte not handed to the sink yet
+    uint8_t  state;      // LzState
+    uint8_t  count;      // Literals left, or the pending match's length
+    uint8_t  dist_hi;    // Pending match's distance, high bits
+    bool     failed;     // Malformed stream or sink error: sticky
+    uint32_t out;        // Bytes decoded so far
+    LzSink   sink;
+    void    *ctx;
+};
+
+inline void lz_init(LzDecoder &d, LzSink sink, void *ctx) {
+    d.head = d.flushed = 0;
+    d.state = LZ_ST_TOKEN;
+    d.count = d.dist_hi = 0;
+    d.failed = false;
+    d.out = 0;
+    d.sink = sink;
+    d.ctx = ctx;
+}
+
+inline void lz_flush_(LzDecoder &d) {
+    if (d.head > d.flushed && !d.sink(d.ctx, d.window + d.flushed, d.head - d.flushed)) d.failed = true;
+    d.flushed = d.head;
+    if (d.head == LZ_WINDOW) d.head = d.flushed = 0;
+}
+
+inline void lz_put_(LzDecoder &d, uint8_t b) {
+    d.window[d.head++] = b;
+    d.out++;
+    if (d.head == LZ_WINDOW) lz_flush_(d);
+}
+
+// Decode the next `len` stream bytes. False once the stream turned out
+// malformed or the sink failed; everything after that is ignored.
+inline bool lz_decode(LzDecoder &d, const uint8_t *in, size_t len) {
+    for (size_t i = 0; i < len && !d.failed; i++) {
+        uint8_t b = in[i];
+        switch (d.state) {
+            case LZ_ST_TOKEN:
+                if (b & 0x80) {
+                    d.count = ((b >> 2) & 0x1F) + LZ_MIN_MATCH;
+                    d.dist_hi = b & 0x03;
+                    d.state = LZ_ST_DISTANCE;
+                } else {
+                    d.count = b + 1;
+                    d.state = LZ_ST_LITERAL;
+                }
+                break;
+            case LZ_ST_LITERAL:
+                lz_put_(d, b);
+                if (--d.count == 0) d.state = LZ_ST_TOKEN;
+                break;
+            case LZ_ST_DISTANCE: {
+                uint16_t dist = ((uint16_t)d.dist_hi << 8 | b) + 1;
+                if (dist > d.out) {
+                    d.failed = true;   // Reaches back before the first byte
+                    break;
+                }
+                for (uint8_t n = d.count; n && !d.failed; n--) {
+                    lz_put_(d, d.window[(d.head + LZ_WINDOW - dist) & (LZ_WINDOW - 1)]);
+                }
+                d.state = LZ_ST_TOKEN;
+                break;
+            }
+        }
+    }
+    if (!d.failed) lz_flush_(d);
+    return !d.failed;
+}
+
+// The stream so far ends on a token boundary and decoded cleanly
+inline bool lz_done(const LzDecoder &d) {
+    return !d.failed && d.state == LZ_ST_TOKEN;
+}
+
+// One-shot decode into out[cap]. Decoded length, or -1 if the stream is
+// malformed or decodes to more than cap bytes.
+inline int lz_decode_flat(const uint8_t *in, size_t len, uint8_t *out, size_t cap) {
+    size_t o = 0;
+    size_t i = 0;
+    while (i < len) {
+        uint8_t t = in[i++];
+        if (!(t & 0x80)) {
+            size_t n = (size_t)t + 1;
+            if (n > len - i || n > cap - o) return -1;
+            memcpy(out + o, in + i, n);
+            i += n;
+            o += n;
+            continue;
+        }
+        if (i >= len) return -1;
+        size_t n = ((t >> 2) & 0x1F) + LZ_MIN_MATCH;
+        size_t dist = ((size_t)(t & 0x03) << 8 | in[i++]) + 1;
+        if (dist > o || n > cap - o) return -1;
+        for (; n; n--, o++) out[o] = out[o - dist];
+    }
+    return (int)o;
+}
@@ -1,18 +1,46 @@
 #pragma once
 #include <stdint.h>
 #include <string.h>
+#include "lz_stream.h"
 
 // ============================================================
-// SOF-Framed Binary Protocol for Display <-> Bridge UART
+// ESP-NOW frames, Display <-> Bridge
 // ============================================================
 //
-// Frame format:
-//   [SOF 0xAA] [LENGTH] [TYPE] [PAYLOAD 0-250 bytes] [CRC8]
+// One message per ESP-NOW packet (ESPNOW_MAX_FRAME bytes), in one of two
+// formats:
 //
-// CRC8 is computed over LENGTH + TYPE + PAYLOAD bytes.
+//   v2:     [0xF0 | VERSION] [FLAGS] [SEQ] [TYPE] [FRAG]? [PAYLOAD...] [CRC8]
+//   legacy: [TYPE] [PAYLOAD...]  or  [TYPE | MSG_FLAG_SEQ] [SEQ] [PAYLOAD...]
+//
+// A legacy frame never starts with 0xF0..0xFF, since every MsgType stays
+// below 0x40. CRC8 covers every v2 byte before it; a v2 frame that fails it,
+// or carries a version this firmware doesn't know, is dropped and counted.
+// SEQ 0 = unsequenced; otherwise it is the command's sequence number, the
+// SEQ being acknowledged (FRAME_F_ACK), or the message a fragment belongs
+// to (FRAME_F_FRAG, followed by the FRAG byte: index | FRAG_LAST).
+//
+// With PROTO_CAP_BATCH a v2 frame of type MSG_BATCH carries several small
+// messages instead of one (see "Batched frames" below).
+//
+// Both units decode both formats. They send v2 only to a peer whose
+// MSG_HELLO said it speaks v2, so an older unit on either end keeps working
+// with legacy frames. Pairing (PAIR_REQ / PAIR_ACK) and HELLO itself always
+// go out legacy.
 
-#define PROTO_SOF         0xAA
-#define PROTO_MAX_PAYLOAD 250
+#define PROTO_VERSION      2
+#define PROTO_FRAME_MARK   0xF0   // High nibble of a v2 frame's first byte
+#define ESPNOW_MAX_FRAME   250    // ESP_NOW_MAX_DATA_LEN
+#define FRAME_HDR_SIZE     4
+#define FRAME_MAX_PAYLOAD  (ESPNOW_MAX_FRAME - FRAME_HDR_SIZE - 1)   // 245: one BULK_DATA chunk
+#define FRAME_FRAG_DATA    (FRAME_MAX_PAYLOAD - 1)                   // Payload bytes per fragment
+#define PROTO_MAX_PAYLOAD  250    // Message payloads, reassembled; legacy frames fit 1 + 249
+
+enum FrameFlags : uint8_t {
+    FRAME_F_ACK        = 0x01,  // SEQ is the acknowledged command's (MSG_HOTKEY_ACK, payload = status)
+    FRAME_F_FRAG       = 0x02,  // One piece of a payload longer than FRAME_MAX_PAYLOAD
+    FRAME_F_COMPRESSED = 0x04,  // Reserved: whole-frame compression (payloads that compress say so themselves)
+};
 
 // --- Message Types ---------------------------------------------------
 
@@ -29,75 +57,300 @@ enum MsgType : uint8_t {
     MSG_CONFIG_DONE  = 0x0A,  // Bridge -> Display: reload config, exit AP mode
     MSG_BUTTON_PRESS = 0x0B,  // Display -> Bridge: button identity (page + widget index)
     MSG_DDC_CMD      = 0x0C,  // Display -> Bridge: DDC/CI monitor control
+    MSG_MACRO        = 0x0D,  // Display -> Bridge: key sequence played back by bridge
+    MSG_FRAGMENT     = 0x0E,  // Companion <-> Bridge (vendor HID only): piece of a larger message
+    MSG_BULK_BEGIN   = 0x0F,  // Companion -> Display (relayed): start/resume a file transfer
+    MSG_BULK_DATA    = 0x10,  // Companion -> Display (relayed): file chunk
+    MSG_BULK_END     = 0x11,  // Companion -> Display (relayed): verify CRC and commit
+    MSG_BULK_ACK     = 0x12,  // Display -> Companion (relayed): progress / result
+    MSG_PAIR_REQ     = 0x13,  // Display -> Bridge (broadcast): find/confirm the bridge
+    MSG_PAIR_ACK     = 0x14,  // Bridge -> Display (unicast): pairing accepted
+    MSG_PROFILE_SWITCH = 0x15,  // Companion -> Display (relayed): activate a profile by name
+    MSG_ACTION_RESULT  = 0x16,  // Companion -> Display (relayed): button press executed + host timings
+    MSG_BENCH_START    = 0x17,  // Companion -> Display (relayed): run the end-to-end latency benchmark
+    MSG_BENCH_PROBE    = 0x18,  // Display -> Bridge -> Companion: synthetic press, stamped per hop
+    MSG_BENCH_ECHO     = 0x19,  // Companion -> Display (relayed): probe returned with host timing
+    MSG_BENCH_REPORT   = 0x1A,  // Display -> Companion (relayed): per-stage p50/p99 + throughput
+    MSG_STATS_RATE     = 0x1B,  // Display -> Companion (relayed): requested stats cadence (battery policy)
+    MSG_POINTER        = 0x1C,  // Display -> Bridge: trackpad motion / buttons (mouse or absolute pointer)
+    MSG_BRIDGE_STATS   = 0x1D,  // Bridge -> Companion (vendor HID only): link and loop health counters
+    MSG_DISPLAY        = 0x1E,  // Companion <-> Bridge (vendor HID only): envelope addressing one display
+    MSG_CHANNEL        = 0x1F,  // Bridge <-> Display: coordinated channel switch / survey request
+    MSG_FW_BEGIN       = 0x20,  // Companion -> Bridge (vendor HID only): start/resume a bridge firmware update
+    MSG_FW_DATA        = 0x21,  // Companion -> Bridge (vendor HID only): firmware chunk
+    MSG_FW_END         = 0x22,  // Companion -> Bridge (vendor HID only): verify, switch boot slot, reboot
+    MSG_FW_ACK         = 0x23,  // Bridge -> Companion (vendor HID only): progress / result
+    MSG_HELLO          = 0x24,  // Display <-> Bridge: protocol version and capabilities at link-up
+    MSG_DDC_STATE      = 0x25,  // Companion -> Display (relayed): monitor's VCP value after a DDC command
+    MSG_CLOCK_SYNC     = 0x26,  // Bridge <-> Companion, Display <-> Bridge: timestamp exchange (clock_sync.h)
+    MSG_REPLAY         = 0x27,  // Companion -> Display (relayed): record / replay an input session
+    MSG_REPLAY_REPORT  = 0x28,  // Display -> Companion (relayed): recording saved / replay measurements
+    MSG_TYPE_TEXT      = 0x29,  // Display -> Bridge: UTF-8 text to type in a host keyboard layout
+    MSG_HOST_STATS     = 0x2A,  // Companion -> Display (relayed): TLV stats of a remote collector
+    MSG_STATS_SUBSCRIBE = 0x2B, // Display -> Companion (relayed): StatTypes currently on screen
+    MSG_BATCH          = 0x2C,  // Bridge -> Display (v2 only): several small messages in one frame
+    MSG_WAKE_HOST      = 0x2D,  // Display <-> Bridge: wake the sleeping PC (USB remote wakeup) / result
+};
+
+// --- Link-up handshake (MSG_HELLO) -----------------------------------
+//
+// The display sends HELLO (legacy framing) when it pairs or boots paired,
+// and again whenever its bridge answers in legacy frames after having
+// spoken v2 (rebooted, or reflashed with older firmware). The bridge keeps
+// the display's caps per display id and answers with its own, flagged
+// HELLO_F_REPLY. A peer that never answers -- firmware from before HELLO --
+// counts as PROTO_CAPS_LEGACY: legacy frames, and only what that firmware
+// already did. A sender uses a feature only if the receiver advertised it.
+
+enum ProtoCaps : uint16_t {
+    PROTO_CAP_DELTA_STATS = 0x0001,  // Keeps stats a packet omits (else the bridge sends full snapshots)
+    PROTO_CAP_MACRO       = 0x0002,  // Plays MSG_MACRO (else the display sends the taps one by one)
+    PROTO_CAP_FRAGMENT    = 0x0004,  // Reassembles FRAME_F_FRAG messages
+    PROTO_CAP_COMPRESS    = 0x0008,  // Takes compact / LZ MSG_NOTIFICATION (else the bridge expands it)
+    PROTO_CAP_WIDE_STATS  = 0x0010,  // Decodes 32-bit / varint / tenths stat values (else narrowed)
+    PROTO_CAP_TYPE_TEXT   = 0x0020,  // Types MSG_TYPE_TEXT (else the display sends it as a macro)
+    PROTO_CAP_BATCH       = 0x0040,  // Unpacks MSG_BATCH frames
+};
+
+#define PROTO_CAPS_LEGACY (PROTO_CAP_DELTA_STATS | PROTO_CAP_MACRO)
+#define HELLO_F_REPLY     0x01
+
+struct __attribute__((packed)) HelloMsg {
+    uint8_t  version;         // Highest frame version the sender speaks
+    uint16_t caps;            // ProtoCaps
+    uint8_t  flags;           // HELLO_F_REPLY: answer, don't answer back
+};
+
+// --- Pairing (MSG_PAIR_REQ / MSG_PAIR_ACK) ----------------------------
+//
+// Broadcast frames get no MAC-layer ACK/retry and go out at the lowest
+// rate, so each side stores the other's MAC in NVS and talks unicast.
+// An unpaired display (or one that has lost its bridge) broadcasts
+// PAIR_REQ in place of the heartbeat PING; the bridge stores the sender,
+// replies PAIR_ACK unicast and then ACKs it like a PING. The peer MAC is
+// the frame's source address, the payload only guards against strangers.
+
+#define PAIR_MAGIC 0x574F5243u  // "CROW"
+
+struct __attribute__((packed)) PairMsg {
+    uint32_t magic;           // PAIR_MAGIC
 };
 
+// --- Sequenced (acknowledged) commands -------------------------------
+//
+// Display -> Bridge commands that must not be lost or repeated carry a
+// nonzero SEQ: in the v2 header, or in a legacy frame by setting
+// MSG_FLAG_SEQ on the type byte and putting SEQ first in the payload:
+//   [TYPE | MSG_FLAG_SEQ] [SEQ] [PAYLOAD...]
+// The bridge answers every sequenced frame with an ACK echoing SEQ (v2:
+// FRAME_F_ACK + [status], legacy: a HotkeyAckMsg). The display retransmits
+// unacknowledged frames; the bridge remembers recent SEQs and re-ACKs a
+// duplicate without executing it again. All MsgType values stay below 0x40.
+
+#define MSG_FLAG_SEQ      0x80
+#define SEQ_DUP_WINDOW_MS 2000   // Bridge treats a repeated SEQ within this as a retry
+
 // --- Stat Type Enum (for TLV stats protocol) ------------------------
 
 enum StatType : uint8_t {
     STAT_CPU_PERCENT    = 0x01,
     STAT_RAM_PERCENT    = 0x02,
     STAT_GPU_PERCENT    = 0x03,
-    STAT_CPU_TEMP       = 0x04,
-    STAT_GPU_TEMP       = 0x05,
+    STAT_CPU_TEMP       = 0x04,  // Celsius, may carry tenths
+    STAT_GPU_TEMP       = 0x05,  // Celsius, may carry tenths
     STAT_DISK_PERCENT   = 0x06,
-    STAT_NET_UP         = 0x07,  // KB/s, uint16
-    STAT_NET_DOWN       = 0x08,  // KB/s, uint16
-    STAT_CPU_FREQ       = 0x09,  // MHz, uint16
-    STAT_GPU_FREQ       = 0x0A,  // MHz, uint16
+    STAT_NET_UP         = 0x07,  // KB/s
+    STAT_NET_DOWN       = 0x08,  // KB/s
+    STAT_CPU_FREQ       = 0x09,  // MHz
+    STAT_GPU_FREQ       = 0x0A,  // MHz
     STAT_SWAP_PERCENT   = 0x0B,
-    STAT_UPTIME_HOURS   = 0x0C,  // Hours, uint16
+    STAT_UPTIME_HOURS   = 0x0C,  // Hours
     STAT_BATTERY_PCT    = 0x0D,  // For laptops
-    STAT_FAN_RPM        = 0x0E,  // uint16
-    STAT_LOAD_AVG       = 0x0F,  // Load average x 100, uint16
-    STAT_PROC_COUNT     = 0x10,  // Process count, uint16
+    STAT_FAN_RPM        = 0x0E,
+    STAT_LOAD_AVG       = 0x0F,  // Load average x 100
+    STAT_PROC_COUNT     = 0x10,  // Process count
     STAT_GPU_MEM_PCT    = 0x11,  // GPU memory percent
     STAT_GPU_POWER_W    = 0x12,  // GPU power in watts
-    STAT_DISK_READ_KBS  = 0x13,  // Disk read KB/s, uint16
-    STAT_DISK_WRITE_KBS = 0x14,  // Disk write KB/s, uint16
+    STAT_DISK_READ_KBS  = 0x13,  // Disk read KB/s
+    STAT_DISK_WRITE_KBS = 0x14,  // Disk write KB/s
     STAT_DISPLAY_UPTIME = 0x15,  // Display uptime hours (local, no companion data)
-    STAT_PROC_USER      = 0x16,  // User process count, uint16
-    STAT_PROC_SYSTEM    = 0x17,  // System/root process count, uint16
+    STAT_PROC_USER      = 0x16,  // User process count
+    STAT_PROC_SYSTEM    = 0x17,  // System/root process count
 };
 
 #define STAT_TYPE_MAX 0x17
 
 // --- TLV Stats Decoding Helper ---------------------------------------
 //
-// TLV format: [count] [type1][len1][val1...] [type2][len2][val2...] ...
-// Each value is 1 byte (uint8) or 2 bytes (uint16 LE).
-// Heuristic: if data[0] <= STAT_TYPE_MAX, it's TLV (count); if > STAT_TYPE_MAX, legacy.
+// TLV format: [count] [type1][desc1][val1...] [type2][desc2][val2...] ...
+// The desc byte is the value's encoding (high nibble) and its size in
+// bytes (low nibble), so 0x01 / 0x02 are the original uint8 / uint16 LE:
+//
+//   0x01, 0x02, 0x04   Unsigned little-endian, 1, 2 or 4 bytes
+//   0x81 .. 0x85       Zig-zag LEB128 varint (signed), 1-5 bytes
+//   0xC1 .. 0xC5       Zig-zag LEB128 of value x 10 (one decimal, e.g. 45.3 C)
+//
+// Displays without PROTO_CAP_WIDE_STATS only take 0x01 / 0x02; the bridge
+// narrows packets for them with tlv_narrow_stats().
+// Legacy frames may still carry a StatsPayload instead; those are told
+// apart by data[0] > STAT_TYPE_MAX. v2 frames are always TLV (the bridge
+// converts with stats_legacy_to_tlv()).
+// A packet may carry any subset of stats: the companion sends only values
+// that changed between periodic full keyframes, and the display keeps the
+// last value of anything omitted.
+
+#define TLV_ENC_MASK   0xF0
+#define TLV_LEN_MASK   0x0F
+#define TLV_ENC_UINT   0x00
+#define TLV_ENC_VARINT 0x80
+#define TLV_ENC_TENTHS 0xC0
+#define TLV_MAX_VALUE  5      // Longest value (a 32-bit varint)
+
+// One value of `desc` encoding at p (the caller has checked the bytes are
+// there). Returns false for an unknown encoding or a malformed varint.
+inline bool tlv_read_value(const uint8_t *p, uint8_t desc, int32_t &value, bool &tenths) {
+    uint8_t n = desc & TLV_LEN_MASK;
+    uint8_t enc = desc & TLV_ENC_MASK;
+    tenths = enc == TLV_ENC_TENTHS;
+    if (enc == TLV_ENC_UINT) {
+        if (n == 1) value = p[0];
+        else if (n == 2) value = p[0] | (p[1] << 8);
+        else if (n == 4) {
+            uint32_t u = p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+            value = u > 0x7FFFFFFF ? 0x7FFFFFFF : (int32_t)u;
+        } else return false;
+        return true;
+    }
+    if ((enc != TLV_ENC_VARINT && enc != TLV_ENC_TENTHS) || n < 1 || n > TLV_MAX_VALUE) return false;
+    uint32_t z = 0;
+    for (uint8_t i = 0; i < n; i++) {
+        // Continuation bit on every byte but the last: the size is exact
+        if (((p[i] & 0x80) != 0) != (i + 1 < n)) return false;
+        z |= (uint32_t)(p[i] & 0x7F) << (7 * i);
+    }
+    value = (int32_t)(z >> 1) ^ -(int32_t)(z & 1);
+    return true;
+}
 
 inline bool tlv_decode_stats(const uint8_t *data, uint8_t len,
-                              void (*callback)(uint8_t type, uint16_t value)) {
+                              void (*callback)(uint8_t type, int32_t value, bool tenths)) {
     if (len < 1) return false;
     uint8_t count = data[0];
     uint8_t pos = 1;
     for (uint8_t i = 0; i < count && pos + 1 < len; i++) {
         uint8_t type = data[pos++];
-        uint8_t vlen = data[pos++];
+        uint8_t desc = data[pos++];
+        uint8_t vlen = desc & TLV_LEN_MASK;
         if (pos + vlen > len) return false;
-        uint16_t value = 0;
-        if (vlen == 1) value = data[pos];
-        else if (vlen == 2) value = data[pos] | (data[pos+1] << 8);
-        else return false;
-        callback(type, value);
+        int32_t value;
+        bool tenths;
+        if (!tlv_read_value(data + pos, desc, value, tenths)) return false;
+        callback(type, value, tenths);
         pos += vlen;
     }
     return true;
 }
 
+// --- TLV Stats Merging -----------------------------------------------
+//
+// Folds the TLV packet `src` into `dst` (same-type entries in src win) and
+// re-encodes it in type order, each value copied in its own encoding. Used
+// by the bridge to coalesce a burst of stats reports into one frame.
+// Returns false, leaving dst untouched, if either packet is malformed or
+// carries an unknown type, or if the merged packet would exceed `cap` bytes.
+
+inline bool tlv_merge_stats(uint8_t *dst, uint8_t &dst_len, uint8_t cap,
+                            const uint8_t *src, uint8_t src_len) {
+    uint8_t entries[STAT_TYPE_MAX + 1][1 + TLV_MAX_VALUE];   // [desc][value], desc 0 = absent
+    for (auto &e : entries) e[0] = 0;
+    const uint8_t *pkts[2] = {dst, src};
+    const uint8_t lens[2] = {dst_len, src_len};
+    for (int p = 0; p < 2; p++) {
+        const uint8_t *data = pkts[p];
+        uint8_t len = lens[p];
+        if (len < 1) return false;
+        uint8_t pos = 1;
+        for (uint8_t i = 0; i < data[0]; i++) {
+            if (pos + 1 >= len) return false;
+            uint8_t type = data[pos++];
+            uint8_t desc = data[pos++];
+            uint8_t vlen = desc & TLV_LEN_MASK;
+            int32_t value;
+            bool tenths;
+            if (type > STAT_TYPE_MAX || pos + vlen > len || !tlv_read_value(data + pos, desc, value, tenths)) {
+                return false;
+            }
+            entries[type][0] = desc;
+            memcpy(&entries[type][1], data + pos, vlen);
+            pos += vlen;
+        }
+    }
+
+    uint16_t need = 1;
+    for (uint8_t t = 0; t <= STAT_TYPE_MAX; t++) {
+        if (entries[t][0]) need += 2 + (entries[t][0] & TLV_LEN_MASK);
+    }
+    if (need > cap) return false;
+
+    uint8_t count = 0, pos = 1;
+    for (uint8_t t = 0; t <= STAT_TYPE_MAX; t++) {
+        uint8_t desc = entries[t][0];
+        if (!desc) continue;
+        dst[pos++] = t;
+        dst[pos++] = desc;
+        memcpy(dst + pos, &entries[t][1], desc & TLV_LEN_MASK);
+        pos += desc & TLV_LEN_MASK;
+        count++;
+    }
+    dst[0] = count;
+    dst_len = pos;
+    return true;
+}
+
+// --- TLV Stats Narrowing ---------------------------------------------
+//
+// Re-encodes `src` with only 0x01 / 0x02 values for displays without
+// PROTO_CAP_WIDE_STATS: decimals are rounded, negatives become 0 and
+// anything past 65535 saturates. No entry grows, so `out` needs `len`
+// bytes. Returns the new length, 0 if src is malformed.
+
+inline uint8_t tlv_narrow_stats(const uint8_t *src, uint8_t len, uint8_t *out) {
+    if (len < 1) return 0;
+    uint8_t count = 0, pos = 1, opos = 1;
+    for (uint8_t i = 0; i < src[0] && pos + 1 < len; i++) {
+        uint8_t type = src[pos++];
+        uint8_t desc = src[pos++];
+        uint8_t vlen = desc & TLV_LEN_MASK;
+        int32_t value;
+        bool tenths;
+        if (pos + vlen > len || !tlv_read_value(src + pos, desc, value, tenths)) return 0;
+        pos += vlen;
+        if (tenths) value = (value + 5) / 10;
+        if (value < 0) value = 0;
+        if (value > 0xFFFF) value = 0xFFFF;
+        out[opos++] = type;
+        out[opos++] = value < 256 ? 1 : 2;
+        out[opos++] = value & 0xFF;
+        if (value >= 256) out[opos++] = value >> 8;
+        count++;
+    }
+    out[0] = count;
+    return opos;
+}
+
 // --- Payload Structs -------------------------------------------------
 
 // NOTE: StatsPayload is the legacy fixed-format struct (v0.9.0).
 // New stats use TLV encoding via tlv_decode_stats() above.
 
 struct __attribute__((packed)) HotkeyMsg {
-    uint8_t modifiers;  // Bitfield: MOD_CTRL | MOD_SHIFT | MOD_ALT | MOD_GUI
+    uint8_t modifiers;  // Bitfield: MOD_CTRL | MOD_SHIFT | MOD_ALT | MOD_GUI (| MOD_R*)
     uint8_t keycode;    // ASCII key or special key code
 };
 
 struct __attribute__((packed)) HotkeyAckMsg {
-    uint8_t status;  // 0 = success, 1 = error
+    uint8_t status;  // 0 = success, 1 = error, 2 = busy (bridge HID queue full)
+    uint8_t seq;     // SEQ of the acknowledged frame (0 for unsequenced ones)
 };
 
 struct __attribute__((packed)) StatsPayload {
@@ -111,6 +364,39 @@ struct __attribute__((packed)) StatsPayload {
     uint16_t net_down_kbps;   // KB/s, little-endian
 };
 
+// Re-encode a legacy StatsPayload as TLV, the same eight values (0xFF
+// "unavailable" included). `out` needs 1 + 8 * 4 bytes. Returns the length.
+inline uint8_t stats_legacy_to_tlv(const StatsPayload &sp, uint8_t *out) {
+    const uint16_t values[] = { sp.cpu_percent, sp.ram_percent, sp.gpu_percent, sp.cpu_temp,
+                                sp.gpu_temp, sp.disk_percent, sp.net_up_kbps, sp.net_down_kbps };
+    const uint8_t types[] = { STAT_CPU_PERCENT, STAT_RAM_PERCENT, STAT_GPU_PERCENT, STAT_CPU_TEMP,
+                              STAT_GPU_TEMP, STAT_DISK_PERCENT, STAT_NET_UP, STAT_NET_DOWN };
+    uint8_t pos = 1;
+    for (int i = 0; i < 8; i++) {
+        bool wide = types[i] == STAT_NET_UP || types[i] == STAT_NET_DOWN;
+        out[pos++] = types[i];
+        out[pos++] = wide ? 2 : 1;
+        out[pos++] = values[i] & 0xFF;
+        if (wide) out[pos++] = values[i] >> 8;
+    }
+    out[0] = 8;
+    return pos;
+}
+
+// --- Remote host stats (MSG_HOST_STATS) ------------------------------
+//
+// Payload: [host id] [TLV stats packet, as MSG_STATS]
+// Stats the companion scraped from another machine (a build server, a
+// NAS); the id is the collector's "id" in the companion's remote_hosts,
+// 1..REMOTE_HOST_MAX, the one a stat monitor's remote_host names. Every
+// entry of the packet belongs to that host, so the tag costs one byte per
+// frame rather than one per stat. Deltas and keyframes work as for the
+// local stats, per host. A packet with no entries (count 0) says the host
+// stopped answering: its values are dropped. Only the active host's
+// companion is listened to.
+
+#define REMOTE_HOST_MAX 8
+
 struct __attribute__((packed)) MediaKeyMsg {
     uint16_t consumer_code;   // USB HID consumer control usage code (e.g. 0x00CD = play/pause)
 };
@@ -123,14 +409,367 @@ struct __attribute__((packed)) PowerStateMsg {
     uint8_t state;            // POWER_SHUTDOWN (0) or POWER_WAKE (1)
 };
 
+// --- Host wake (MSG_WAKE_HOST) ---------------------------------------
+//
+// A touch on the display while the PC sleeps (CLOCK mode after
+// POWER_SHUTDOWN / POWER_LOCKED) sends WAKE_REQ, sequenced. The bridge
+// signals USB remote wakeup at once, answers with a WAKE_RESULT saying how
+// that went, and a second one once the companion is back: the first
+// MSG_POWER_STATE after the request (POWER_WAKE, or POWER_LOCKED for a PC
+// that woke to its lock screen) ends the measurement. No companion within
+// WAKE_TIMEOUT_MS: WAKE_TIMEOUT.
+
+#define WAKE_TIMEOUT_MS 30000
+
+enum WakeOp : uint8_t {
+    WAKE_REQ    = 0,   // Display -> Bridge
+    WAKE_RESULT = 1,   // Bridge -> Display
+};
+
+enum WakeStatus : uint8_t {
+    WAKE_SIGNALLED = 0,   // Bus was suspended, resume signalled
+    WAKE_BUS_AWAKE = 1,   // Bus not suspended (PC locked, or already waking): nothing to signal
+    WAKE_NOT_ARMED = 2,   // Suspended, but the host hasn't enabled remote wakeup for the bridge
+    WAKE_DONE      = 3,   // Companion reported in: latency_ms is request -> its power state
+    WAKE_TIMEOUT   = 4,
+};
+
+struct __attribute__((packed)) WakeHostMsg {
+    uint8_t  op;              // WakeOp
+    uint8_t  status;          // WAKE_RESULT: WakeStatus
+    uint16_t resume_ms;       // WAKE_DONE: request -> USB bus resumed, 0xFFFF = not seen
+    uint32_t latency_ms;      // WAKE_DONE / WAKE_TIMEOUT: request -> companion (or timeout)
+};
+
 struct __attribute__((packed)) TimeSyncMsg {
     uint32_t epoch_seconds;   // Unix timestamp from companion (little-endian)
     int16_t  tz_offset_min;   // Local timezone offset from UTC in minutes (e.g., -300 for EST)
 };
 
+// --- Clock sync (MSG_CLOCK_SYNC) --------------------------------------
+//
+// NTP-style exchange, see clock_sync.h. The requester (bridge towards the
+// companion, display towards the bridge) fills id and t1 from its own
+// esp_timer; the responder echoes them with t2/t3 on the shared timebase
+// (companion Unix time, microseconds) and sets CLOCK_F_REPLY. A responder
+// without a timebase yet stays silent.
+
+#define CLOCK_F_REPLY 0x01
+
+struct __attribute__((packed)) ClockSyncMsg {
+    uint8_t flags;            // CLOCK_F_REPLY on the answer
+    uint8_t id;               // Requester's exchange number, echoed
+    int64_t t1_us;            // Requester's clock at send, echoed
+    int64_t t2_us;            // Responder, shared timebase, at receive
+    int64_t t3_us;            // Responder, shared timebase, at reply
+};
+
 struct __attribute__((packed)) ButtonPressMsg {
-    uint8_t page_index;       // Which page the button is on
+    uint8_t page_index;       // Which page the button is on (0xFF = hardware button)
     uint8_t widget_index;     // Widget index within the page
+    // Trace fields; older displays send only the two bytes above
+    uint16_t press_id;        // Per-boot sequence number, echoed in MSG_ACTION_RESULT
+    uint32_t display_ms;      // Display millis() at the press, echoed back
+    uint8_t  profile_index;   // Active profile on the display (0xFF = unknown)
+    uint16_t entry_index;     // Scroll grid entry (0xFFFF = none); absent from older displays
+};
+
+// --- Button press result (MSG_ACTION_RESULT) ------------------------
+//
+// Sent by the companion once the action for a traced MSG_BUTTON_PRESS has
+// run. The display subtracts the echoed display_ms from millis() for the
+// full press -> executed round trip; the host fields split out the part
+// spent on the PC.
+
+enum ActionResultStatus : uint8_t {
+    ACTION_RESULT_OK        = 0,
+    ACTION_RESULT_NO_ACTION = 1,  // Nothing the companion runs is bound to that widget
+    ACTION_RESULT_FAILED    = 2,  // Handler raised / command could not be started
+};
+
+struct __attribute__((packed)) ActionResultMsg {
+    uint16_t press_id;        // From ButtonPressMsg
+    uint8_t  status;          // ActionResultStatus
+    uint32_t display_ms;      // ButtonPressMsg::display_ms, unchanged
+    uint16_t host_queue_us;   // HID read -> handler start (saturates)
+    uint16_t host_exec_ms;    // Handler run time (saturates)
+};
+
+// --- Latency benchmark (MSG_BENCH_*) --------------------------------
+//
+// The companion starts a run; the display fires `count` probes at
+// `rate_hz` (0 = as fast as BENCH_WINDOW probes in flight allow). A probe
+// takes the same path as a keystroke: reliable ESP-NOW frame, bridge HID
+// scheduler slot (held like a tap), then out as a vendor INPUT report in
+// place of the keyboard report. The companion echoes it straight back.
+//
+// Each unit only subtracts its own timestamps, so no clock sync is needed:
+//   radio      display RTT minus the bridge's rx -> echo interval
+//   hid_queue  bridge rx -> HID scheduler start (waits behind real keys)
+//   usb        bridge HID start -> echo back, minus the host turnaround
+//   host       companion read -> echo write
+//   total      display send -> echo received
+
+#define BENCH_MAX_PROBES 2000
+#define BENCH_WINDOW     8      // Probes in flight in flood mode (rate_hz = 0)
+
+enum BenchStage : uint8_t {
+    BENCH_STAGE_RADIO = 0,
+    BENCH_STAGE_HID_QUEUE,
+    BENCH_STAGE_USB,
+    BENCH_STAGE_HOST,
+    BENCH_STAGE_TOTAL,
+    BENCH_STAGES
+};
+
+struct __attribute__((packed)) BenchStartMsg {
+    uint16_t rate_hz;         // Probes per second, 0 = flood
+    uint16_t count;           // Probes to send (capped at BENCH_MAX_PROBES)
+};
+
+struct __attribute__((packed)) BenchProbeMsg {
+    uint16_t id;
+    uint32_t display_us;      // Display micros() at send
+    uint32_t bridge_rx_us;    // Bridge micros() at ESP-NOW receive
+    uint32_t bridge_hid_us;   // Bridge micros() when the HID scheduler reached it
+};
+
+struct __attribute__((packed)) BenchEchoMsg {
+    BenchProbeMsg probe;      // As received by the companion
+    uint32_t host_us;         // Companion read -> echo write
+    uint32_t bridge_echo_us;  // Bridge micros() when the echo came back over USB
+};
+
+struct __attribute__((packed)) BenchReportMsg {
+    uint16_t rate_hz;
+    uint16_t sent;
+    uint16_t received;
+    uint32_t elapsed_ms;      // First probe -> last echo
+    uint16_t throughput_x10;  // Echoes per second x10
+    uint32_t p50_us[BENCH_STAGES];
+    uint32_t p99_us[BENCH_STAGES];
+};
+
+// --- Input record / replay (MSG_REPLAY, MSG_REPLAY_REPORT) -----------
+//
+// A recording is the panel's raw input -- touch points and PCF8575 pin
+// samples, timestamped -- in /replay/<name>.rec on the SD card. Replaying
+// feeds it back through the same paths (touch_read_cb, action_run()) with
+// the real touch and buttons muted, a scripted stats feed in place of the
+// companion's, and nothing sent off the panel. Every replay of a file
+// takes the same UI through the same frames, so its report compares
+// firmware builds. The report also goes to /replay/<name>.json.
+
+enum ReplayOp : uint8_t {
+    REPLAY_OP_RECORD = 0,     // Start recording input
+    REPLAY_OP_STOP   = 1,     // Stop recording (save) or replaying
+    REPLAY_OP_RUN    = 2,     // Replay `name`, `loops` times back to back
+};
+
+enum ReplayStatus : uint8_t {
+    REPLAY_OK       = 0,
+    REPLAY_ERR_IO   = 1,      // No SD card, file missing or unreadable
+    REPLAY_ERR_BUSY = 2,      // Already recording or replaying
+    REPLAY_ERR_BAD  = 3,      // Bad name, not a recording, or nothing recorded
+    REPLAY_STOPPED  = 4,      // Replay cut short by REPLAY_OP_STOP
+};
+
+#define REPLAY_NAME_MAX 24
+
+struct __attribute__((packed)) ReplayCmdMsg {
+    uint8_t op;               // ReplayOp
+    uint8_t loops;            // REPLAY_OP_RUN: passes (0 = 1)
+    char    name[REPLAY_NAME_MAX];   // File stem under /replay (NUL-terminated)
+};
+
+struct __attribute__((packed)) ReplayReportMsg {
+    uint8_t  op;              // What finished: REPLAY_OP_RECORD (saved) or REPLAY_OP_RUN
+    uint8_t  status;          // ReplayStatus
+    uint16_t events;          // Input events recorded / replayed
+    uint32_t duration_ms;     // Recording length / replay wall time
+    uint32_t frames;          // LVGL frames rendered during the replay
+    uint16_t frame_p50_ms;
+    uint16_t frame_p99_ms;
+    uint16_t frame_max_ms;
+    uint32_t frame_avg_us;
+    uint32_t flushes;         // Areas flushed to the panel
+    uint32_t flush_px;        // Pixels flushed
+    uint32_t flush_avg_us;    // Per area
+    uint32_t heap_min_free;   // Internal RAM low-water mark during the replay
+    int32_t  heap_delta;      // Internal RAM free at the end minus at the start
+    uint32_t psram_min_free;
+    char     name[REPLAY_NAME_MAX];
+};
+
+// MSG_STATS_RATE: the display on battery asks for fewer stats frames. Sent
+// on every policy change and repeated while throttled, so a restarted
+// companion picks it up again; the companion never goes faster than its
+// own configuration.
+struct __attribute__((packed)) StatsRateMsg {
+    uint16_t interval_ms;     // Full stats pass period, 0 = companion default (1 s)
+    uint8_t  live;            // 0 = pause the live-rate stats stream
+};
+
+// MSG_STATS_SUBSCRIBE: the stats the display currently needs: widgets on
+// the page shown, graph histories and alert rules. Sent when that changes
+// (page, mode, profile or host switch), on link-up and every
+// STATS_SUBSCRIBE_REPEAT_MS, so a restarted companion learns it again. The
+// companion collects only the union over its displays' subscriptions; a
+// display that never sent one (older firmware) gets everything configured.
+#define STATS_SUBSCRIBE_REPEAT_MS 30000
+
+struct __attribute__((packed)) StatsSubscribeMsg {
+    uint32_t types;           // Bit N = StatType N (0 = none, e.g. clock or picture frame)
+};
+
+// --- Radio channel (MSG_CHANNEL) --------------------------------------
+//
+// Bridge and displays share one WiFi channel, and the display's SoftAP
+// runs on it too. Both keep it in NVS ("espnow"/"chan"). The bridge owns
+// the choice: it surveys (WiFi scan, APs weighted by strength and channel
+// overlap) when a new display pairs, or when a display reports a bad link
+// with CHANNEL_SURVEY_REQ. If another channel is clearly quieter it sends
+// CHANNEL_SWITCH to every display a few times, and everyone moves delay_ms
+// after hearing it. A display that missed the order loses the bridge and
+// sweeps the channels with PAIR_REQ until it answers again.
+//
+// -DESPNOW_AUTO_CHANNEL=0 pins both units to ESPNOW_CHANNEL.
+
+#ifndef ESPNOW_CHANNEL
+#define ESPNOW_CHANNEL 1          // First boot / pinned channel
+#endif
+#ifndef ESPNOW_AUTO_CHANNEL
+#define ESPNOW_AUTO_CHANNEL 1
+#endif
+#define ESPNOW_CHANNEL_MAX 11     // Surveyed 1..11: legal in every region
+#define CHANNEL_RESURVEY_MS 600000 // Link-quality surveys at most every 10 min
+
+enum ChannelOp : uint8_t {
+    CHANNEL_SWITCH     = 0,   // Bridge -> Display: move to `channel` in delay_ms
+    CHANNEL_SURVEY_REQ = 1,   // Display -> Bridge (sequenced): link is poor, look for a better channel
+};
+
+struct __attribute__((packed)) ChannelMsg {
+    uint8_t  op;              // ChannelOp
+    uint8_t  channel;         // SWITCH: new channel; SURVEY_REQ: current one
+    uint16_t delay_ms;        // SWITCH: time left until the move
+    uint8_t  fail_pct;        // SURVEY_REQ: unicast frames not MAC-ACKed, last window
+    int8_t   rssi_dbm;        // SURVEY_REQ: last RSSI heard from the bridge
+};
+
+// --- Link adaptation (LinkReportMsg) ---------------------------------
+//
+// Each unit sets its TX power / PHY rate from how loud its frames arrive
+// (shared/link_adapt.h), which only the far end can measure. The display's
+// heartbeat MSG_PING carries a LinkReportMsg about the bridge's frames,
+// and the bridge's v2 ACK of a PING carries one about that display's,
+// after the status byte. Both are extra bytes older firmware ignores.
+
+struct __attribute__((packed)) LinkReportMsg {
+    int8_t rssi_dbm;          // Last frame heard from the receiver of this, 0 = none yet
+    int8_t tx_power_qdbm;     // Sender's current TX power, 0.25 dBm
+};
+
+// --- Multiple displays (MSG_DISPLAY) ---------------------------------
+//
+// One bridge serves up to BRIDGE_MAX_DISPLAYS paired displays. Display id
+// = slot in the bridge's peer table (NVS), assigned in pairing order; when
+// the table is full the display heard from least recently gives up its id.
+//
+// Companion -> bridge: a plain vendor message goes to every display;
+// [MSG_DISPLAY][id][TYPE][PAYLOAD...] goes to display `id` only.
+// Bridge -> companion: messages from display 0 (or a display that never
+// paired) arrive plain, so one-display setups see no envelope; the others
+// arrive as [MSG_DISPLAY][id][TYPE][PAYLOAD...].
+//
+// ACKs always go unicast to the display that sent the command. Stats go to
+// all displays as one broadcast frame once more than one is paired (no
+// MAC-layer retry, but the next pass supersedes a lost frame); everything
+// else fanned out is sent unicast to each display.
+
+#define BRIDGE_MAX_DISPLAYS 4
+#define DISPLAY_ALL     0xFF   // Envelope id / espnow_send_to(): every display
+#define DISPLAY_UNKNOWN 0xFE   // Sender not in the peer table
+
+// --- Bridge health (MSG_BRIDGE_STATS) ---------------------------------
+//
+// Sent to the companion once per BRIDGE_STATS_INTERVAL_MS while it is
+// talking to the bridge. Counters are running totals since boot (they
+// wrap), so the companion derives rates from consecutive reports and a
+// lost report costs nothing; the loop times and the RX queue high-water
+// mark cover the interval since the previous report. The task and ring
+// fields at the end (bridge/pipeline.h) are absent from older bridges,
+// and the loop stall fields after them from bridges before those; the same
+// goes for the batching counter and the link adaptation fields after it.
+
+struct __attribute__((packed)) BridgeStatsMsg {
+    uint32_t uptime_ms;
+    uint32_t espnow_rx_frames;
+    uint32_t espnow_rx_bytes;
+    uint32_t espnow_tx_frames;
+    uint32_t espnow_tx_bytes;
+    uint32_t espnow_tx_failed;  // esp_now_send refused (driver queue full)
+    uint32_t rx_queue_drops;    // Display frames lost to a full RX queue
+    uint8_t  rx_queue_high;     // Deepest RX queue this interval
+    uint8_t  rx_queue_size;
+    uint32_t hid_reports;       // Keyboard, consumer and pointer reports
+    uint32_t vendor_rx_bps;     // Vendor HID bytes/s, last 1 s window
+    uint32_t vendor_tx_bps;
+    uint16_t loop_avg_us;       // USB task (loop()) work time, excluding the idle yield
+    uint32_t loop_max_us;
+    int8_t   rssi_dbm;          // Last frame from the display, 0 = none yet
+    uint32_t free_heap;
+    uint8_t  channel;           // Current ESP-NOW channel
+    uint16_t radio_avg_us;      // Radio task work time per pass
+    uint32_t radio_max_us;
+    uint8_t  to_radio_high;     // Deepest USB -> radio ring this interval
+    uint8_t  to_usb_high;       // Deepest radio -> USB ring this interval
+    uint8_t  pipe_size;         // Usable slots per ring
+    uint32_t to_radio_full;     // Vendor reads held back by a full ring (USB flow control)
+    uint32_t to_usb_full;       // Display commands / reports refused by a full ring
+    uint32_t loop_stalls;       // loop() passes over budget since boot (loop_watch.h)
+    uint8_t  stall_section;     // Longest section of the latest stall, 0xFF = none yet
+    uint32_t stall_us;          // ... and that pass's time
+    uint32_t espnow_tx_batched; // Messages sent inside MSG_BATCH frames (counted in tx_frames per frame)
+    int8_t   tx_power_qdbm;     // Link adaptation: TX power now, 0.25 dBm
+    uint8_t  phy_rate_step;     // ... unicast rate step, 0 = ESPNOW_PHY_RATE / basic rate
+    int8_t   far_rssi_dbm;      // ... weakest display's RSSI of our frames, 0 = no report
+    uint8_t  adapt_reason;      // ... LinkAdaptReason of the latest change, 0xFF = none yet
+    uint32_t adapt_changes;     // ... power / rate changes since boot
+};
+
+// --- Pointer (MSG_POINTER) -------------------------------------------
+//
+// Trackpad widgets stream the finger as pointer frames. Relative frames
+// carry the motion accumulated since the previous frame (the display
+// merges deltas into a frame still waiting in its TX queue, so there is at
+// most one motion frame per radio slot); absolute frames carry the latest
+// position scaled to 0..POINTER_ABS_MAX. Motion goes unsequenced: a lost
+// frame only costs a few pixels. Button changes go sequenced, and every
+// frame carries the full button state plus button_seq, which counts
+// changes, so the bridge ignores the buttons of a frame older than the
+// state it already has (a retry arriving after the release).
+
+#define POINTER_ABS_MAX 32767
+
+enum PointerFlags : uint8_t {
+    POINTER_ABSOLUTE = 0x01,  // x/y are a position, not a delta
+};
+
+enum PointerButton : uint8_t {
+    POINTER_BTN_LEFT   = 0x01,
+    POINTER_BTN_RIGHT  = 0x02,
+    POINTER_BTN_MIDDLE = 0x04,
+};
+
+struct __attribute__((packed)) PointerMsg {
+    uint8_t flags;            // PointerFlags
+    uint8_t buttons;          // PointerButton bits currently held
+    uint8_t button_seq;       // Incremented on every button change
+    int16_t x;                // Delta (relative) or 0..POINTER_ABS_MAX
+    int16_t y;
+    int8_t  wheel;            // Scroll steps, positive = up (relative only)
+    int8_t  pan;              // Horizontal scroll steps, positive = right
 };
 
 struct __attribute__((packed)) DdcCmdMsg {
@@ -140,21 +779,304 @@ struct __attribute__((packed)) DdcCmdMsg {
     uint8_t  display_num;     // ddcutil --display N (0 = auto-detect)
 };
 
+// --- DDC/CI monitor state (MSG_DDC_STATE) ---------------------------
+//
+// The companion merges MSG_DDC_CMDs per (display, VCP) and keeps the
+// values it has read or set; after each write it sends where the control
+// landed, so a fast encoder spin shows one level, not a backlog of them.
+
+struct __attribute__((packed)) DdcStateMsg {
+    uint8_t  vcp_code;        // As in DdcCmdMsg
+    uint16_t value;           // Current value
+    uint16_t max_value;       // Monitor's maximum (0 = unknown)
+    uint8_t  display_num;     // As in DdcCmdMsg
+};
+
+// --- Macro (MSG_MACRO) ----------------------------------------------
+//
+// Payload: [step_count] [MacroStep x step_count]
+// The bridge queues every step at once and plays them back locally, so a
+// chord or text snippet costs one radio frame instead of one per key.
+
+enum MacroOp : uint8_t {
+    MACRO_OP_TAP         = 0,  // a = modifiers, b = keycode: press, hold, release
+    MACRO_OP_PRESS       = 1,  // a = modifiers, b = keycode (0 = modifiers only): press and keep held
+    MACRO_OP_RELEASE     = 2,  // a = modifiers, b = keycode: release
+    MACRO_OP_RELEASE_ALL = 3,  // Release every held key
+    MACRO_OP_DELAY       = 4,  // a | b << 8 = milliseconds
+    MACRO_OP_MEDIA       = 5,  // a | b << 8 = consumer control code: tap
+};
+
+struct __attribute__((packed)) MacroStep {
+    uint8_t op;   // MacroOp
+    uint8_t a;
+    uint8_t b;
+};
+
+#define MACRO_MAX_STEPS 64   // 1 + 64*3 = 193 bytes, fits in one ESP-NOW frame
+
+// --- Typed text (MSG_TYPE_TEXT) -------------------------------------
+//
+// Payload: [layout] [UTF-8 bytes, no terminator]
+// layout is a KeyLayout (key_layouts.h): the keyboard layout the host
+// uses, which decides the keys that produce each character. The bridge
+// translates one character at a time as it plays, so a string costs one
+// frame however many strokes it takes. Characters the layout can't type
+// are skipped. The text always fits one frame: there is no ordering
+// across messages to rely on.
+
+#define TYPE_TEXT_MAX_BYTES 240
+static_assert(1 + TYPE_TEXT_MAX_BYTES <= FRAME_MAX_PAYLOAD, "MSG_TYPE_TEXT fits one frame");
+
+// Urgency (from the freedesktop "urgency" hint). NORMAL is 0 so frames
+// from companions predating the field (body NUL-padded) stay normal.
+enum NotifUrgency : uint8_t {
+    NOTIF_NORMAL   = 0,
+    NOTIF_LOW      = 1,
+    NOTIF_CRITICAL = 2,
+};
+
+// A notification comes in one of two forms, told apart by the first byte:
+//
+//   fixed:   NotificationMsg, 248 bytes whatever the text (app_name never
+//            starts with NOTIF_COMPACT_MARK)
+//   compact: NotifCompactHdr + text, where text is app_name, summary and
+//            body back to back, without terminators. The body is whatever
+//            follows the other two; with NOTIF_F_LZ the text is an LZ
+//            stream (shared/lz_stream.h) of those bytes. text_len counts
+//            them, since a single vendor report arrives zero-padded.
+//
+// Compact notifications cost only what they say, and with LZ a body of up
+// to NOTIF_BODY_MAX - 1 bytes fits PROTO_MAX_PAYLOAD (fragmented where it
+// needs more than one frame) instead of being cut at 114. The companion
+// sends compact only; the bridge forwards it to displays that advertise
+// PROTO_CAP_COMPRESS and expands it into NotificationMsg for the others,
+// truncating the body there.
+
+#define NOTIF_APP_MAX      32    // Field sizes, terminator included
+#define NOTIF_SUMMARY_MAX  100
+#define NOTIF_BODY_MAX     400
+#define NOTIF_TEXT_MAX     (NOTIF_APP_MAX + NOTIF_SUMMARY_MAX + NOTIF_BODY_MAX - 3)
+#define NOTIF_COMPACT_MARK 0x01
+#define NOTIF_F_LZ         0x01
+
 struct __attribute__((packed)) NotificationMsg {
-    char app_name[32];   // Source app (null-terminated, truncated)
-    char summary[100];   // Notification title
-    char body[116];      // Notification body (truncated to fit)
+    char app_name[NOTIF_APP_MAX];      // Source app (null-terminated, truncated)
+    char summary[NOTIF_SUMMARY_MAX];   // Notification title
+    char body[115];                    // Notification body (truncated to fit)
+    uint8_t urgency;                   // NotifUrgency
 };
 // Total: 248 bytes, fits within 250-byte ESP-NOW limit
 static_assert(sizeof(NotificationMsg) == 248, "NotificationMsg must be 248 bytes");
 
+struct __attribute__((packed)) NotifCompactHdr {
+    uint8_t mark;          // NOTIF_COMPACT_MARK
+    uint8_t flags;         // NOTIF_F_*
+    uint8_t urgency;       // NotifUrgency
+    uint8_t app_len;       // < NOTIF_APP_MAX
+    uint8_t summary_len;   // < NOTIF_SUMMARY_MAX
+    uint8_t text_len;      // Bytes that follow (the LZ stream with NOTIF_F_LZ); the rest is padding
+};
+
+struct NotifText {
+    char app_name[NOTIF_APP_MAX];
+    char summary[NOTIF_SUMMARY_MAX];
+    char body[NOTIF_BODY_MAX];
+    uint8_t urgency;
+};
+
+inline void notif_copy_(char *dst, size_t cap, const char *src, size_t n) {
+    if (n >= cap) n = cap - 1;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+}
+
+// Either form into `out` (terminated, over-long fields cut). False if the
+// payload is neither.
+inline bool notif_parse(const uint8_t *payload, size_t len, NotifText &out) {
+    if (len >= sizeof(NotifCompactHdr) && payload[0] == NOTIF_COMPACT_MARK) {
+        NotifCompactHdr h;
+        memcpy(&h, payload, sizeof(h));
+        if (h.text_len > len - sizeof(h)) return false;
+        const char *text = (const char *)payload + sizeof(h);
+        size_t n = h.text_len;
+        uint8_t plain[NOTIF_TEXT_MAX];
+        if (h.flags & NOTIF_F_LZ) {
+            int decoded = lz_decode_flat(payload + sizeof(h), n, plain, sizeof(plain));
+            if (decoded < 0) return false;
+            text = (const char *)plain;
+            n = decoded;
+        }
+        if (h.app_len >= NOTIF_APP_MAX || h.summary_len >= NOTIF_SUMMARY_MAX ||
+            (size_t)h.app_len + h.summary_len > n) return false;
+        notif_copy_(out.app_name, sizeof(out.app_name), text, h.app_len);
+        notif_copy_(out.summary, sizeof(out.summary), text + h.app_len, h.summary_len);
+        size_t head = h.app_len + h.summary_len;
+        notif_copy_(out.body, sizeof(out.body), text + head, n - head);
+        out.urgency = h.urgency;
+        return true;
+    }
+    if (len < sizeof(NotificationMsg)) return false;
+    // Fields are NUL-padded, but not necessarily terminated
+    const NotificationMsg *m = (const NotificationMsg *)payload;
+    notif_copy_(out.app_name, sizeof(out.app_name), m->app_name, strnlen(m->app_name, sizeof(m->app_name)));
+    notif_copy_(out.summary, sizeof(out.summary), m->summary, strnlen(m->summary, sizeof(m->summary)));
+    notif_copy_(out.body, sizeof(out.body), m->body, strnlen(m->body, sizeof(m->body)));
+    out.urgency = m->urgency;
+    return true;
+}
+
+// --- Profile switch (MSG_PROFILE_SWITCH) ----------------------------
+//
+// Sent by the companion when the focused application maps to another
+// profile. Unknown names are ignored by the display.
+
+struct __attribute__((packed)) ProfileSwitchMsg {
+    char name[32];       // Profile name (null-terminated, truncated)
+};
+
+// --- Vendor HID fragmentation (MSG_FRAGMENT) ------------------------
+//
+// Vendor HID reports are 63 bytes, so a message longer than one report
+// ([TYPE][PAYLOAD...] > 63 bytes) is split across back-to-back reports:
+//   [MSG_FRAGMENT] [seq] [index | FRAG_LAST] [data_len] [data...]
+// Reports are zero-padded to full size, so data_len marks the real bytes.
+// seq is the same for every fragment of one message and changes per message.
+// Fragment 0 starts with the inner TYPE byte; the reassembled bytes are
+// handled exactly as if they had arrived in a single report. Fragments must
+// arrive in order -- a gap or seq change drops the partial message.
+
+#define VENDOR_REPORT_SIZE 63
+#define FRAG_HEADER_SIZE   4
+#define FRAG_DATA_SIZE     (VENDOR_REPORT_SIZE - FRAG_HEADER_SIZE)  // 59
+#define FRAG_LAST          0x80
+#define FRAG_INDEX_MASK    0x7F
+#define VENDOR_MAX_MESSAGE (3 + PROTO_MAX_PAYLOAD)  // 253 bytes = 5 fragments (MSG_DISPLAY envelope + frame)
+
+// --- Bulk file transfer (MSG_BULK_*) --------------------------------
+//
+// The companion pushes a file to the display's SD card through the bridge
+// (vendor HID -> ESP-NOW), without SoftAP/HTTP:
+//   BEGIN -> ACK(next_offset)          resume point (0 for a fresh transfer)
+//   DATA x BULK_WINDOW in flight       display ACKs in-order progress
+//   END   -> ACK(BULK_DONE | error)    CRC-32 checked, .part renamed over path
+// The display only accepts DATA at exactly next_offset; anything else is
+// answered with an ACK carrying the offset it expects (go-back-N). Sending
+// BEGIN again with the same path/size/crc resumes an interrupted transfer.
+// CRC-32 is the zlib/IEEE polynomial (see crc32_update()).
+
+#define BULK_PATH_MAX    64
+#define BULK_CHUNK_SIZE  240   // 5-byte DATA header + 240 = 245 bytes per frame
+#define BULK_WINDOW      4     // Chunks in flight (display RX queue holds 5 bulk frames)
+
+#define BULK_FLAG_RESTART 0x01  // Ignore any partial transfer, start at offset 0
+#define BULK_FLAG_APPLY   0x02  // Rebuild UI after commit (/config.json is always reloaded)
+#define BULK_FLAG_FIRMWARE 0x04 // Display firmware (.bin or .bin.gz) into the idle OTA slot, not SD;
+                                // path is only a label. Swapped in at the next DIMMED/CLOCK state.
+#define BULK_FLAG_IMAGE   0x08  // Remote image patch (below) for the source named by path, kept in PSRAM
+#define BULK_FLAG_LZ      0x10  // DATA is an LZ stream of the file (shared/lz_stream.h), SD files only.
+                                // total_size, offsets and crc32 are the stream's. A display that
+                                // decodes it says so in the BEGIN ACK's flags; without that the
+                                // sender starts over uncompressed (BULK_FLAG_RESTART).
+
+enum BulkStatus : uint8_t {
+    BULK_OK        = 0,  // next_offset = bytes stored so far
+    BULK_DONE      = 1,  // Verified and committed
+    BULK_ERR_CRC   = 2,  // Checksum mismatch, transfer discarded
+    BULK_ERR_IO    = 3,  // SD card write/rename failed (firmware: flash write or image check)
+    BULK_ERR_BAD   = 4,  // Bad path/size or unknown xfer_id
+};
+
+struct __attribute__((packed)) BulkBeginMsg {
+    uint8_t  xfer_id;               // Chosen by companion, echoed in every ACK
+    uint8_t  flags;                 // BULK_FLAG_*
+    uint32_t total_size;
+    uint32_t crc32;                 // Of the whole file
+    char     path[BULK_PATH_MAX];   // Absolute SD path, null-terminated
+};
+
+struct __attribute__((packed)) BulkDataHdr {
+    uint8_t  xfer_id;
+    uint32_t offset;                // Followed by up to BULK_CHUNK_SIZE bytes
+};
+
+struct __attribute__((packed)) BulkEndMsg {
+    uint8_t  xfer_id;
+};
+
+struct __attribute__((packed)) BulkAckMsg {
+    uint8_t  xfer_id;
+    uint8_t  status;                // BulkStatus
+    uint32_t next_offset;
+    uint8_t  flags;                 // BULK_FLAG_LZ if the transfer is decoded (absent from older displays)
+};
+
+// --- Remote image patches (BULK_FLAG_IMAGE) -------------------------
+//
+// A WIDGET_REMOTE_IMAGE shows a PSRAM RGB565 frame (LV_COLOR_16_SWAP 0)
+// the companion keeps up to date. Each transfer is one patch:
+//   RemoteImageHdr, then tile_count x (RemoteTileHdr + len bytes)
+// covering only the REMOTE_TILE x REMOTE_TILE tiles that changed (edge
+// tiles are cropped to the frame). base_seq 0 is a key frame (the frame
+// is cleared first, and reallocated if the size changed); otherwise the
+// display applies the patch only on top of frame base_seq and answers
+// BULK_ERR_BAD if it holds anything else, e.g. after a reboot, and the
+// companion follows up with a key frame.
+
+#define REMOTE_TILE        32
+#define REMOTE_IMAGE_MAX_DIM 480     // Longest side of a remote frame
+
+enum RemoteTileEncoding : uint8_t {
+    TILE_RAW  = 0,   // w*h RGB565 pixels, row by row
+    TILE_FILL = 1,   // One RGB565 pixel for the whole tile
+    TILE_RLE  = 2,   // Runs of [count-1][RGB565], row-major across the tile
+};
+
+struct __attribute__((packed)) RemoteImageHdr {
+    uint16_t width;
+    uint16_t height;
+    uint16_t seq;              // This frame (never 0)
+    uint16_t base_seq;         // Frame the tiles go on top of, 0 = key frame
+    uint16_t tile_count;
+};
+
+struct __attribute__((packed)) RemoteTileHdr {
+    uint8_t  tx;               // Tile column / row
+    uint8_t  ty;
+    uint8_t  encoding;         // RemoteTileEncoding
+    uint16_t len;              // Bytes that follow
+};
+
+// --- Bridge firmware update (MSG_FW_*) ------------------------------
+//
+// The bulk scheme above, terminated at the bridge: the companion streams a
+// firmware.bin over vendor HID into the bridge's idle OTA slot while the
+// keyboard keeps working. DATA and END are BulkDataHdr / BulkEndMsg, every
+// answer is a MSG_FW_ACK carrying a BulkAckMsg. BULK_ERR_IO = flash write or
+// image verification failed, BULK_ERR_BAD = image doesn't fit the slot.
+// After BULK_DONE the bridge reboots into the new image as soon as no key
+// is held; the image is kept once a companion talks to it, a reset before
+// that rolls back.
+
+struct __attribute__((packed)) FwBeginMsg {
+    uint8_t  xfer_id;
+    uint8_t  flags;                 // BULK_FLAG_RESTART
+    uint32_t total_size;
+    uint32_t crc32;                 // Of the whole image
+};
+
 // --- Modifier Masks --------------------------------------------------
 
-#define MOD_NONE  0x00
-#define MOD_CTRL  0x01
-#define MOD_SHIFT 0x02
-#define MOD_ALT   0x04
-#define MOD_GUI   0x08
+// Same bit layout as the HID keyboard report's modifier byte
+#define MOD_NONE   0x00
+#define MOD_CTRL   0x01
+#define MOD_SHIFT  0x02
+#define MOD_ALT    0x04
+#define MOD_GUI    0x08
+#define MOD_RCTRL  0x10
+#define MOD_RSHIFT 0x20
+#define MOD_RALT   0x40   // AltGr
+#define MOD_RGUI   0x80
 
 // --- CRC8/CCITT (polynomial 0x07, init 0x00) ------------------------
 
@@ -200,3 +1122,137 @@ inline uint8_t crc8_calc(const uint8_t* data, size_t len) {
     }
     return crc;
 }
+
+// --- CRC-32 (IEEE 802.3 / zlib, reflected 0xEDB88320) ----------------
+// crc32_update(0, data, len) == zlib.crc32(data); chain calls for streams.
+
+inline uint32_t crc32_update(uint32_t crc, const uint8_t* data, size_t len) {
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+// --- Frame encode / decode (see "ESP-NOW frames" at the top) ---------
+
+struct FrameView {
+    uint8_t version;          // 1 = legacy frame, else the v2 header's
+    uint8_t flags;            // FrameFlags (v2 only)
+    uint8_t seq;              // 0 = unsequenced
+    uint8_t type;             // MsgType, MSG_FLAG_SEQ stripped
+    uint8_t frag;             // index | FRAG_LAST with FRAME_F_FRAG
+    const uint8_t *payload;   // Points into the frame
+    uint8_t len;
+};
+
+// Split a received frame. False for a v2 frame with a bad CRC, a bad
+// length or an unknown version; legacy frames can't be checked.
+inline bool frame_decode(const uint8_t *data, int len, FrameView &f) {
+    if (len < 1 || len > ESPNOW_MAX_FRAME) return false;
+    f = {};
+    if ((data[0] & 0xF0) != PROTO_FRAME_MARK) {
+        f.version = 1;
+        f.type = data[0];
+        f.payload = data + 1;
+        f.len = (uint8_t)(len - 1);
+        if (f.type & MSG_FLAG_SEQ) {
+            f.type &= ~MSG_FLAG_SEQ;
+            if (f.len < 1) return false;
+            f.seq = f.payload[0];
+            f.payload++;
+            f.len--;
+        }
+        return true;
+    }
+    f.version = data[0] & 0x0F;
+    if (f.version != PROTO_VERSION || len < FRAME_HDR_SIZE + 1) return false;
+    if (crc8_calc(data, len - 1) != data[len - 1]) return false;
+    f.flags = data[1];
+    f.seq = data[2];
+    f.type = data[3];
+    if (f.type & MSG_FLAG_SEQ) return false;
+    int pos = FRAME_HDR_SIZE;
+    if (f.flags & FRAME_F_FRAG) {
+        if (len < pos + 2) return false;
+        f.frag = data[pos++];
+    }
+    f.payload = data + pos;
+    f.len = (uint8_t)(len - 1 - pos);
+    return true;
+}
+
+// Build a frame into `buf` (ESPNOW_MAX_FRAME bytes). Legacy frames can't
+// carry FRAME_F_*: a legacy ACK is a HotkeyAckMsg payload, and fragments
+// are v2 only. Returns the frame length, 0 if the payload doesn't fit.
+inline uint8_t frame_encode(uint8_t *buf, bool v2, uint8_t type, const uint8_t *payload, uint8_t len,
+                            uint8_t seq = 0, uint8_t flags = 0, uint8_t frag = 0) {
+    size_t pos = 0;
+    if (v2) {
+        if (FRAME_HDR_SIZE + (flags & FRAME_F_FRAG ? 1 : 0) + len + 1 > ESPNOW_MAX_FRAME) return 0;
+        buf[pos++] = PROTO_FRAME_MARK | PROTO_VERSION;
+        buf[pos++] = flags;
+        buf[pos++] = seq;
+        buf[pos++] = type;
+        if (flags & FRAME_F_FRAG) buf[pos++] = frag;
+    } else {
+        if (1 + (seq ? 1 : 0) + len > ESPNOW_MAX_FRAME) return 0;
+        buf[pos++] = seq ? (uint8_t)(type | MSG_FLAG_SEQ) : type;
+        if (seq) buf[pos++] = seq;
+    }
+    if (len > 0 && payload) memcpy(buf + pos, payload, len);
+    pos += len;
+    if (v2) {
+        buf[pos] = crc8_calc(buf, pos);
+        pos++;
+    }
+    return (uint8_t)pos;
+}
+
+// --- Batched frames (MSG_BATCH) --------------------------------------
+//
+// Most bridge -> display messages are a few bytes, and air time and send
+// callbacks cost the same per frame whatever it holds. A v2 MSG_BATCH frame
+// (flags and SEQ 0) packs several into its payload, each as a record
+//
+//   [FLAGS] [SEQ] [TYPE] [LEN] [PAYLOAD...]
+//
+// the fields of its own v2 header (an ACK keeps FRAME_F_ACK and the SEQ it
+// acknowledges); the batch frame's CRC8 covers them all. Records are
+// handled in order, as if each had come in its own frame. No fragments and
+// no nested batches. Sent only to a display that advertised PROTO_CAP_BATCH.
+
+#define BATCH_REC_HDR 4
+
+// Append a record to a batch payload of `pos` bytes (FRAME_MAX_PAYLOAD max).
+// Returns the new length, 0 if the record doesn't fit.
+inline uint8_t batch_append(uint8_t *buf, uint8_t pos, uint8_t flags, uint8_t seq, uint8_t type,
+                            const uint8_t *payload, uint8_t len) {
+    if (pos + BATCH_REC_HDR + len > FRAME_MAX_PAYLOAD) return 0;
+    buf[pos++] = flags;
+    buf[pos++] = seq;
+    buf[pos++] = type;
+    buf[pos++] = len;
+    if (len > 0 && payload) memcpy(buf + pos, payload, len);
+    return (uint8_t)(pos + len);
+}
+
+// Next record of a batch payload, from `pos` (0 for the first). Fills the
+// header fields of `f` (version is the caller's) and advances `pos`; false
+// at the end or on a malformed record, which ends the batch.
+inline bool batch_next(const uint8_t *data, uint8_t len, uint8_t &pos, FrameView &f) {
+    if (pos + BATCH_REC_HDR > len) return false;
+    const uint8_t *r = data + pos;
+    if (pos + BATCH_REC_HDR + r[3] > len) return false;
+    f.flags = r[0];
+    f.seq = r[1];
+    f.type = r[2];
+    f.len = r[3];
+    f.frag = 0;
+    f.payload = r + BATCH_REC_HDR;
+    pos += BATCH_REC_HDR + r[3];
+    return !(f.flags & FRAME_F_FRAG) && f.type != MSG_BATCH && !(f.type & MSG_FLAG_SEQ);
+}
@@ -0,0 +1,155 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include <stdint.h>
+#include "clock_sync.h"
+
+// ============================================================
+// Binary trace ring
+//
+// Fixed-size record of hot-path events (keystrokes, button presses, ACKs,
+// relays) that stays on in production builds: trace() is one atomic
+// fetch_add plus a 16-byte store, no formatting and no UART. The ring is
+// read after the fact with trace_dump() (serial 't' on both units) or
+// GET /api/trace on the display config server.
+//
+// Once the shared timebase is locked (clock_sync.h) dumps also give each
+// event's time on it, so the display, bridge and companion traces can be
+// merged into one timeline.
+//
+// Any task or core may write. Each slot carries the sequence number it
+// was written with, so a reader racing a writer skips the torn slot
+// instead of reporting garbage.
+//
+// Header-only: shared by the display and bridge builds, one ring per unit.
+// ============================================================
+
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE 1
+#endif
+#ifndef TRACE_RING_SIZE
+#define TRACE_RING_SIZE 256   // Entries, power of two (16 bytes each)
+#endif
+static_assert((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0, "TRACE_RING_SIZE must be a power of two");
+
+// Event ids. Arguments noted as a / b.
+enum TraceEvent : uint16_t {
+    TR_NONE = 0,
+    // Display
+    TR_UI_ACTION,     // a = action_type, b = page << 8 | widget
+    TR_HW_BUTTON,     // a = button (4 = encoder push), b = action_type
+    TR_HOTKEY_TX,     // a = modifiers << 8 | keycode
+    TR_MEDIA_TX,      // a = consumer code
+    TR_MACRO_TX,      // a = step count
+    TR_DDC_TX,        // a = vcp code, b = value
+    TR_PRESS_TX,      // a = press_id, b = page << 8 | widget
+    TR_ACK_RX,        // a = status
+    TR_TX_LOST,       // a = seq, b = msg type
+    TR_PRESS_RESULT,  // a = press_id, b = status << 24 | rtt_ms
+    // Bridge
+    TR_CMD_RX,        // a = msg type, b = seq
+    TR_DUP_SEQ,       // a = seq, b = msg type
+    TR_HID_KEY,       // a = modifiers << 8 | keycode
+    TR_HID_MEDIA,     // a = consumer code
+    TR_HID_DROP,      // b = dropped total
+    TR_PRESS_RELAY,   // a = page << 8 | widget, b = press_id
+    TR_STATS_RELAY,   // a = frame length, b = reports merged total
+    // Display (later additions)
+    TR_TOUCH_HIT,     // a = page << 8 | widget, b = contact (fire-on-press, input task)
+    // Both units
+    TR_LOOP_STALL,    // a = longest section (loop_watch.h), b = pass us
+    // Display
+    TR_BLE_HID_TX,    // a = modifiers << 8 | keycode, consumer code or step count; b = 0 key, 1 media, 2 macro
+    TR_EVENT_COUNT
+};
+
+inline const char *trace_event_name(uint16_t id) {
+    static const char *const names[TR_EVENT_COUNT] = {
+        "none", "ui_action", "hw_button", "hotkey_tx", "media_tx", "macro_tx", "ddc_tx",
+        "press_tx", "ack_rx", "tx_lost", "press_result",
+        "cmd_rx", "dup_seq", "hid_key", "hid_media", "hid_drop", "press_relay", "stats_relay",
+        "touch_hit", "loop_stall", "ble_hid_tx",
+    };
+    return id < TR_EVENT_COUNT ? names[id] : "?";
+}
+
+struct TraceEntry {
+    uint32_t t_us;   // micros() at record time (wraps every ~71 min)
+    uint16_t id;     // TraceEvent
+    uint16_t a;
+    uint32_t b;
+};
+
+struct TraceSlot {
+    std::atomic<uint32_t> seq;   // Sequence + 1 once written, 0 while being written
+    TraceEntry e;
+};
+
+inline TraceSlot trace_ring[TRACE_RING_SIZE];
+inline std::atomic<uint32_t> trace_head{0};
+
+inline void trace(uint16_t id, uint16_t a = 0, uint32_t b = 0) {
+#if TRACE_ENABLE
+    uint32_t n = trace_head.fetch_add(1, std::memory_order_relaxed);
+    TraceSlot &s = trace_ring[n & (TRACE_RING_SIZE - 1)];
+    s.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    s.e.t_us = (uint32_t)micros();
+    s.e.id = id;
+    s.e.a = a;
+    s.e.b = b;
+    s.seq.store(n + 1, std::memory_order_release);
+#else
+    (void)id; (void)a; (void)b;
+#endif
+}
+
+// Copy up to `max` of the newest entries, oldest first. Returns the count.
+inline size_t trace_snapshot(TraceEntry *out, size_t max) {
+    uint32_t head = trace_head.load(std::memory_order_acquire);
+    uint32_t avail = head < TRACE_RING_SIZE ? head : TRACE_RING_SIZE;
+    if (max > avail) max = avail;
+    size_t count = 0;
+    for (uint32_t n = head - max; n != head; n++) {
+        TraceSlot &s = trace_ring[n & (TRACE_RING_SIZE - 1)];
+        if (s.seq.load(std::memory_order_acquire) != n + 1) continue;
+        TraceEntry e = s.e;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s.seq.load(std::memory_order_relaxed) != n + 1) continue;   // Overwritten meanwhile
+        out[count++] = e;
+    }
+    return count;
+}
+
+// Print the ring, oldest first, one event per line
+inline void trace_dump(Print &out) {
+    static TraceEntry snap[TRACE_RING_SIZE];   // Not on the caller's stack
+    size_t n = trace_snapshot(snap, TRACE_RING_SIZE);
+    bool synced = clock_sync_valid();
+    out.printf("TRACE: %u events (%lu recorded)%s\n", (unsigned)n,
+               (unsigned long)trace_head.load(std::memory_order_relaxed),
+               synced ? ", shared time in column 2" : "");
+    for (size_t i = 0; i < n; i++) {
+        const TraceEntry &e = snap[i];
+        if (synced) {
+            int64_t host = clock_sync_host_us(clock_local_from_micros(e.t_us));
+            out.printf("%10lu %lld.%06ld %-12s a=%u b=%lu\n", (unsigned long)e.t_us,
+                       (long long)(host / 1000000), (long)(host % 1000000),
+                       trace_event_name(e.id), e.a, (unsigned long)e.b);
+        } else {
+            out.printf("%10lu %-12s a=%u b=%lu\n", (unsigned long)e.t_us,
+                       trace_event_name(e.id), e.a, (unsigned long)e.b);
+        }
+    }
+}
+
+// One byte of console input: 't' dumps the ring
+inline void trace_console_char(int c) {
+    if (c == 't') trace_dump(Serial);
+}
+
+// Serial console input. Call from loop() (the display's wired link reads
+// the console itself and hands the bytes on).
+inline void trace_serial_poll() {
+    while (Serial.available() > 0) trace_console_char(Serial.read());
+}
@@ -0,0 +1,194 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================
+// Host stand-in for the Arduino core (sim env only)
+//
+// Just what the UI modules use: the clock, Serial (to stderr), Print /
+// Stream for ArduinoJson, and a String over std::string. The clock is
+// wall time plus whatever sim_advance_ms() skipped, so LVGL timers and
+// animations can be stepped without sleeping. LVGL's lv_conf.h includes
+// this from C for millis().
+// ============================================================
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t millis(void);
+uint32_t micros(void);
+void delay(uint32_t ms);   // Advances the clock, never sleeps
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef __cplusplus
+#include <cstdarg>
+#include <string>
+
+#define IRAM_ATTR
+
+// The sim runs the UI on one thread: critical sections are no-ops
+typedef struct { int unused; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+inline size_t strlcpy(char *dst, const char *src, size_t size) {
+    size_t n = strlen(src);
+    if (size) {
+        size_t c = n < size - 1 ? n : size - 1;
+        memcpy(dst, src, c);
+        dst[c] = 0;
+    }
+    return n;
+}
+#endif
+
+inline long random(long max) { return max > 0 ? rand() % max : 0; }
+inline long random(long min, long max) { return max > min ? min + rand() % (max - min) : min; }
+inline uint32_t esp_random() { return (uint32_t)rand(); }
+
+class String;
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buf, size_t len) {
+        size_t n = 0;
+        while (n < len && write(buf[n])) n++;
+        return n;
+    }
+    size_t write(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+    size_t print(const char *s) { return write(s); }
+    size_t print(const String &s);
+    size_t println(const char *s = "") { return write(s) + write("\n"); }
+    size_t println(const String &s);
+    size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3))) {
+        char small[256];
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(small, sizeof(small), fmt, ap);
+        va_end(ap);
+        if (n < 0) return 0;
+        if ((size_t)n < sizeof(small)) return write((const uint8_t *)small, n);
+        std::string big(n + 1, '\0');
+        va_start(ap, fmt);
+        vsnprintf(&big[0], big.size(), fmt, ap);
+        va_end(ap);
+        return write((const uint8_t *)big.data(), n);
+    }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual size_t readBytes(char *buf, size_t len) {
+        size_t n = 0;
+        int c;
+        while (n < len && (c = read()) >= 0) buf[n++] = (char)c;
+        return n;
+    }
+    size_t readBytes(uint8_t *buf, size_t len) { return readBytes((char *)buf, len); }
+};
+
+class String {
+public:
+    String() {}
+    String(const char *s) : s_(s ? s : "") {}
+    String(const std::string &s) : s_(s) {}
+    explicit String(char c) : s_(1, c) {}
+    explicit String(unsigned char v) : s_(std::to_string(v)) {}
+    explicit String(int v) : s_(std::to_string(v)) {}
+    explicit String(unsigned v) : s_(std::to_string(v)) {}
+    explicit String(long v) : s_(std::to_string(v)) {}
+    explicit String(unsigned long v) : s_(std::to_string(v)) {}
+    explicit String(double v, unsigned decimals = 2) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v);
+        s_ = buf;
+    }
+
+    const char *c_str() const { return s_.c_str(); }
+    unsigned length() const { return (unsigned)s_.size(); }
+    bool isEmpty() const { return s_.empty(); }
+    bool reserve(unsigned n) { s_.reserve(n); return true; }
+    char operator[](unsigned i) const { return i < s_.size() ? s_[i] : 0; }
+
+    bool concat(const char *s) { if (s) s_ += s; return true; }
+    bool concat(const char *s, unsigned n) { if (s) s_.append(s, n); return true; }
+    bool concat(const String &s) { s_ += s.s_; return true; }
+    bool concat(char c) { s_ += c; return true; }
+    String &operator+=(const char *s) { concat(s); return *this; }
+    String &operator+=(const String &s) { concat(s); return *this; }
+    String &operator+=(char c) { concat(c); return *this; }
+
+    friend String operator+(const String &a, const String &b) { return String(a.s_ + b.s_); }
+    friend String operator+(const String &a, const char *b) { return String(a.s_ + (b ? b : "")); }
+    friend String operator+(const char *a, const String &b) { return String((a ? a : "") + b.s_); }
+    bool operator==(const String &o) const { return s_ == o.s_; }
+    bool operator==(const char *o) const { return s_ == (o ? o : ""); }
+    bool operator!=(const String &o) const { return s_ != o.s_; }
+    bool operator<(const String &o) const { return s_ < o.s_; }
+
+    bool startsWith(const String &p) const { return s_.compare(0, p.s_.size(), p.s_) == 0; }
+    bool endsWith(const String &p) const {
+        return s_.size() >= p.s_.size() && s_.compare(s_.size() - p.s_.size(), p.s_.size(), p.s_) == 0;
+    }
+    int indexOf(char c, unsigned from = 0) const {
+        size_t i = s_.find(c, from);
+        return i == std::string::npos ? -1 : (int)i;
+    }
+    int indexOf(const String &s, unsigned from = 0) const {
+        size_t i = s_.find(s.s_, from);
+        return i == std::string::npos ? -1 : (int)i;
+    }
+    String substring(unsigned from) const { return from < s_.size() ? String(s_.substr(from)) : String(); }
+    String substring(unsigned from, unsigned to) const {
+        return from < s_.size() && to > from ? String(s_.substr(from, to - from)) : String();
+    }
+    void toLowerCase() { for (auto &c : s_) if (c >= 'A' && c <= 'Z') c += 'a' - 'A'; }
+    void toUpperCase() { for (auto &c : s_) if (c >= 'a' && c <= 'z') c -= 'a' - 'A'; }
+    void trim() {
+        size_t b = s_.find_first_not_of(" \t\r\n"), e = s_.find_last_not_of(" \t\r\n");
+        s_ = b == std::string::npos ? std::string() : s_.substr(b, e - b + 1);
+    }
+    long toInt() const { return strtol(s_.c_str(), nullptr, 10); }
+
+private:
+    std::string s_;
+};
+
+// ArduinoJson's String adapter names this (Arduino's operator+ result)
+class StringSumHelper : public String {
+public:
+    using String::String;
+};
+
+inline size_t Print::print(const String &s) { return write(s.c_str()); }
+inline size_t Print::println(const String &s) { return print(s) + write("\n"); }
+
+// Serial console: log lines go to stderr so stdout stays machine-readable
+class SimSerial : public Stream {
+public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buf, size_t len) override;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    void flush() {}
+    using Print::write;
+};
+extern SimSerial Serial;
+
+#endif   // __cplusplus
@@ -0,0 +1,72 @@
+#pragma once
+#include <Arduino.h>
+#include <SPI.h>
+#include <memory>
+#include <string>
+
+// ============================================================
+// Host stand-in for the ESP32 SD library (sim env only)
+//
+// Card paths map onto a host directory (sim_sd_set_root()), so the real
+// sdcard.cpp, config loader, icon cache and LVGL "S:" driver run on a
+// copy of a card's contents. Mounting fails while no root is set.
+// ============================================================
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+enum sdcard_type_t { CARD_NONE, CARD_MMC, CARD_SD, CARD_SDHC, CARD_UNKNOWN };
+
+class File : public Stream {
+public:
+    struct Handle;
+    File() {}
+    explicit File(std::shared_ptr<Handle> h) : h_(std::move(h)) {}
+
+    explicit operator bool() const;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buf, size_t len) override;
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t read(uint8_t *buf, size_t len);
+    size_t readBytes(char *buf, size_t len) override { return read((uint8_t *)buf, len); }
+    bool seek(uint32_t pos);
+    size_t position() const;
+    size_t size() const;
+    void flush();
+    void close();
+    const char *name() const;   // Last path component, like the ESP32 core
+    const char *path() const;
+    bool isDirectory() const;
+    File openNextFile();
+    using Print::write;
+
+private:
+    std::shared_ptr<Handle> h_;
+};
+
+class SDFS {
+public:
+    bool begin(uint8_t ss, SPIClass &spi, uint32_t frequency);
+    void end();
+    sdcard_type_t cardType();
+    uint64_t cardSize();
+    uint64_t totalBytes();
+    uint64_t usedBytes();
+    bool readRAW(uint8_t *buf, uint32_t sector);
+
+    File open(const char *path, const char *mode = FILE_READ, bool create = false);
+    File open(const String &path, const char *mode = FILE_READ) { return open(path.c_str(), mode); }
+    bool exists(const char *path);
+    bool exists(const String &path) { return exists(path.c_str()); }
+    bool remove(const char *path);
+    bool rename(const char *from, const char *to);
+    bool mkdir(const char *path);
+    bool rmdir(const char *path);
+};
+extern SDFS SD;
+
+// Host directory standing in for the card root (nullptr = no card)
+void sim_sd_set_root(const char *dir);
@@ -0,0 +1,16 @@
+#pragma once
+#include <stdint.h>
+
+// Host stand-in for the SPI bus object sdcard.cpp hands to SD.begin()
+
+#define FSPI 0
+#define HSPI 1
+
+class SPIClass {
+public:
+    explicit SPIClass(uint8_t bus = HSPI) { (void)bus; }
+    void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1) {
+        (void)sck; (void)miso; (void)mosi; (void)ss;
+    }
+    void end() {}
+};
@@ -0,0 +1,23 @@
+#pragma once
+#include <Arduino.h>
+
+// Host stand-in for the WiFi API the config screen reads (sim env only)
+
+class IPAddress {
+public:
+    IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) : o_{ a, b, c, d } {}
+    String toString() const {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%u.%u.%u.%u", o_[0], o_[1], o_[2], o_[3]);
+        return String(buf);
+    }
+
+private:
+    uint8_t o_[4];
+};
+
+class WiFiClass {
+public:
+    IPAddress softAPIP() { return IPAddress(192, 168, 4, 1); }   // The config AP's address
+};
+inline WiFiClass WiFi;
@@ -0,0 +1,48 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+
+// ============================================================
+// Host stand-in for heap_caps (sim env only)
+//
+// Every capability is the host heap. Block sizes come from the host
+// allocator, so mem_budget pool figures compare pages with each other,
+// not byte for byte with the device heap. Internal RAM reports as full:
+// LVGL's small-block tier stays off and all of its heap counts as PSRAM.
+// ============================================================
+
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_DMA      (1 << 3)
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DEFAULT  (1 << 12)
+
+#define SIM_PSRAM_BYTES (8 * 1024 * 1024)   // The CrowPanel's PSRAM, for free-size reports
+
+inline void *heap_caps_malloc(size_t size, uint32_t caps) { (void)caps; return malloc(size); }
+inline void *heap_caps_calloc(size_t n, size_t size, uint32_t caps) { (void)caps; return calloc(n, size); }
+inline void *heap_caps_realloc(void *p, size_t size, uint32_t caps) { (void)caps; return realloc(p, size); }
+inline void *heap_caps_aligned_alloc(size_t align, size_t size, uint32_t caps) {
+    (void)caps;
+    void *p = nullptr;
+    return posix_memalign(&p, align < sizeof(void *) ? sizeof(void *) : align, size) == 0 ? p : nullptr;
+}
+inline void heap_caps_free(void *p) { free(p); }
+
+inline size_t heap_caps_get_allocated_size(void *p) {
+#if defined(__APPLE__)
+    return p ? malloc_size(p) : 0;
+#else
+    return p ? malloc_usable_size(p) : 0;
+#endif
+}
+inline size_t heap_caps_get_free_size(uint32_t caps) {
+    return (caps & MALLOC_CAP_INTERNAL) ? 0 : SIM_PSRAM_BYTES;
+}
+inline size_t heap_caps_get_largest_free_block(uint32_t caps) { return heap_caps_get_free_size(caps); }
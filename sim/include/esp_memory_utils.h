@@ -0,0 +1,7 @@
+#pragma once
+#include <stdbool.h>
+
+// Host stand-in (sim env only): every block is PSRAM, see esp_heap_caps.h
+
+inline bool esp_ptr_external_ram(const void *p) { (void)p; return true; }
+inline bool esp_ptr_internal(const void *p) { (void)p; return false; }
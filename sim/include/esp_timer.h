@@ -0,0 +1,6 @@
+#pragma once
+#include <stdint.h>
+
+// Host stand-in (sim env only): the sim clock, in microseconds
+
+int64_t esp_timer_get_time();
@@ -0,0 +1,413 @@
+/**
+ * @file main.cpp
+ * Headless run of the display UI: every page rendered, measured, optionally saved
+ *
+ *   .pio/build/sim/program [options] <sd-dir>
+ *
+ *   <sd-dir>             Host copy of the SD card (config.json, icons, fonts, pictures)
+ *   --profile NAME       Render this profile instead of the active one
+ *   --page N             Only page N (0-based)
+ *   --out DIR            Save each page as DIR/page_<n>.ppm (800x480 RGB)
+ *   --settle MS          Simulated time after a page switch before it is measured (1000)
+ *   --idle MS            Window over which idle redraws are counted (2000)
+ *   --max-objects N      Limits: exit status 2 if any page goes over one
+ *   --max-heap-kb N
+ *   --max-render-ms N
+ *   --max-idle-px N      Pixels flushed per second with nothing happening
+ *   --cost-table         Measure each widget type instead (display/config_cost.h):
+ *                        one JSON object per type, then exit
+ *   --log                Keep the firmware's serial log (stderr)
+ *
+ * stdout gets one JSON object per page, then a summary object:
+ *
+ *   objects       LVGL objects shown (the page plus status bar and overlays)
+ *   lvgl_heap     LVGL pool bytes with only this page realized, peak during the switch
+ *   build_us      ui_goto_page(): building the page's objects
+ *   render_us     One full-screen redraw in LVGL's software renderer
+ *   switch_px     Pixels flushed from the switch until the page settled
+ *   idle_px       Pixels flushed per second afterwards (animations, blinking, clocks)
+ *   press_us      Redraw of the first hotkey button going pressed (no action run);
+ *   press_px      omitted on pages without one. Against a background image this
+ *                 is the blend cost a tap pays: compare with a build that sets
+ *                 -DUI_PAGE_LAYERS=0 -DUI_BAKED_BUTTONS=0
+ *
+ * --cost-table builds, per type, a page with one 200x120 instance and one
+ * with nine, and prints the difference per extra instance: heap, objects,
+ * image_heap, and render_us_kpx (render time per 1000 px of widget area).
+ *
+ * Object counts, heap use and flushed pixels follow the device closely;
+ * times are the host's, so compare them between pages and configs rather
+ * than against the ESP32-S3.
+ */
+
+#include <lvgl.h>
+#include <Arduino.h>
+#include <SD.h>
+#include <string>
+#include <vector>
+#include "sim.h"
+#include "config.h"
+#include "display_hw.h"
+#include "mem_budget.h"
+#include "sdcard.h"
+#include "status_store.h"
+#include "tasks.h"
+#include "ui.h"
+#include "ui_jobs.h"
+
+#define SIM_STEP_MS      5    // Simulated time per loop pass
+#define SIM_STRIPE_LINES 40   // Same draw buffers as display_hw.cpp
+
+static AppConfig g_app_config;
+static bool g_rebuild_pending = false;
+
+AppConfig &get_global_config() { return g_app_config; }
+void request_ui_rebuild() { g_rebuild_pending = true; }
+
+// ============================================================
+// Display driver: stripes into a RAM framebuffer
+// ============================================================
+
+static lv_color_t framebuffer[SCREEN_WIDTH * SCREEN_HEIGHT];
+static uint64_t flushed_px = 0;
+
+static void flush_cb(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p) {
+    int32_t w = lv_area_get_width(area);
+    for (int32_t y = area->y1; y <= area->y2; y++) {
+        memcpy(&framebuffer[y * SCREEN_WIDTH + area->x1], color_p + (y - area->y1) * w, w * sizeof(lv_color_t));
+    }
+    flushed_px += (uint64_t)w * lv_area_get_height(area);
+    lv_disp_flush_ready(disp);
+}
+
+static void sim_lvgl_init() {
+    lv_init();
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf1[SCREEN_WIDTH * SIM_STRIPE_LINES];
+    static lv_color_t buf2[SCREEN_WIDTH * SIM_STRIPE_LINES];
+    lv_disp_draw_buf_init(&draw_buf, buf1, buf2, SCREEN_WIDTH * SIM_STRIPE_LINES);
+
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = SCREEN_WIDTH;
+    disp_drv.ver_res = SCREEN_HEIGHT;
+    disp_drv.flush_cb = flush_cb;
+    disp_drv.draw_buf = &draw_buf;
+    lv_disp_drv_register(&disp_drv);
+}
+
+static bool write_ppm(const std::string &path) {
+    FILE *f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    fprintf(f, "P6\n%d %d\n255\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+    std::vector<uint8_t> row(SCREEN_WIDTH * 3);
+    for (int y = 0; y < SCREEN_HEIGHT; y++) {
+        for (int x = 0; x < SCREEN_WIDTH; x++) {
+            uint32_t c = lv_color_to32(framebuffer[y * SCREEN_WIDTH + x]);
+            row[x * 3] = (c >> 16) & 0xFF;
+            row[x * 3 + 1] = (c >> 8) & 0xFF;
+            row[x * 3 + 2] = c & 0xFF;
+        }
+        fwrite(row.data(), 1, row.size(), f);
+    }
+    return fclose(f) == 0;
+}
+
+// ============================================================
+// Loop
+// ============================================================
+
+// What loop() does on the device, minus radio, input and power
+static void run_for(uint32_t sim_ms) {
+    for (uint32_t t = 0; t < sim_ms; t += SIM_STEP_MS) {
+        ui_run_posted();
+        status_clock_update();
+        ui_jobs_run();
+        lv_timer_handler();
+        if (g_rebuild_pending) {
+            g_rebuild_pending = false;
+            rebuild_ui(&g_app_config);
+        }
+        status_flush();
+        sim_advance_ms(SIM_STEP_MS);
+    }
+}
+
+static uint32_t count_objects(lv_obj_t *obj) {
+    if (lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN)) return 0;
+    uint32_t n = 1;
+    for (uint32_t i = 0; i < lv_obj_get_child_cnt(obj); i++) n += count_objects(lv_obj_get_child(obj, i));
+    return n;
+}
+
+// ============================================================
+// Pages
+// ============================================================
+
+struct Options {
+    const char *sd_dir = nullptr;
+    const char *profile = nullptr;
+    const char *out_dir = nullptr;
+    int page = -1;
+    uint32_t settle_ms = 1000;
+    uint32_t idle_ms = 2000;
+    uint32_t max_objects = 0, max_heap_kb = 0, max_render_ms = 0, max_idle_px = 0;   // 0 = no limit
+    bool cost_table = false;
+    bool log = false;
+};
+
+struct PageResult {
+    int page;
+    uint32_t objects;
+    uint32_t heap, heap_peak, heap_blocks, image_heap;
+    uint32_t build_us, render_us;
+    uint64_t switch_px, idle_px;
+    bool has_press;
+    uint32_t press_us;
+    uint64_t press_px;
+};
+
+static lv_obj_t *first_button(int index, const PageConfig &page) {
+    for (size_t wi = 0; wi < page.widgets.size(); wi++) {
+        if (page.widgets[wi].widget_type != WIDGET_HOTKEY_BUTTON) continue;
+        if (lv_obj_t *obj = ui_get_widget_obj(index, (int)wi)) return obj;
+    }
+    return nullptr;
+}
+
+static PageResult measure_page(int index, const PageConfig &page, const Options &opt) {
+    PageResult r = {};
+    r.page = index;
+    mem_reset_peaks();
+
+    uint64_t px0 = flushed_px;
+    uint32_t t0 = micros();
+    ui_goto_page(index);
+    r.build_us = micros() - t0;
+    run_for(opt.settle_ms);
+    r.switch_px = flushed_px - px0;
+
+    px0 = flushed_px;
+    run_for(opt.idle_ms);
+    r.idle_px = opt.idle_ms ? (flushed_px - px0) * 1000 / opt.idle_ms : 0;
+
+    lv_obj_invalidate(lv_scr_act());
+    t0 = micros();
+    lv_refr_now(NULL);
+    r.render_us = micros() - t0;
+
+    // What the touch driver does to the button, minus the event (and so
+    // the action); released again so the saved image is the idle page
+    if (lv_obj_t *btn = first_button(index, page)) {
+        r.has_press = true;
+        px0 = flushed_px;
+        t0 = micros();
+        lv_obj_add_state(btn, LV_STATE_PRESSED);
+        lv_obj_invalidate(btn);   // Baked skins redraw on the event, not a style change
+        lv_refr_now(NULL);
+        r.press_us = micros() - t0;
+        r.press_px = flushed_px - px0;
+        lv_obj_clear_state(btn, LV_STATE_PRESSED);
+        lv_obj_invalidate(btn);
+        lv_refr_now(NULL);
+    }
+
+    r.objects = count_objects(lv_scr_act()) + count_objects(lv_layer_top()) - 1;   // Not the top layer itself
+    MemPoolStats lvgl, images;
+    mem_get_stats(MEM_POOL_LVGL, &lvgl);
+    mem_get_stats(MEM_POOL_IMAGES, &images);
+    r.heap = lvgl.used;
+    r.heap_peak = lvgl.peak;
+    r.heap_blocks = lvgl.blocks;
+    r.image_heap = images.used;
+    return r;
+}
+
+static bool over_limits(const PageResult &r, const Options &opt) {
+    return (opt.max_objects && r.objects > opt.max_objects) ||
+           (opt.max_heap_kb && r.heap > opt.max_heap_kb * 1024) ||
+           (opt.max_render_ms && r.render_us > opt.max_render_ms * 1000) ||
+           (opt.max_idle_px && r.idle_px > opt.max_idle_px);
+}
+
+static void print_json_string(const char *s) {
+    putchar('"');
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') printf("\\%c", *s);
+        else if ((uint8_t)*s < 0x20) printf("\\u%04x", *s);
+        else putchar(*s);
+    }
+    putchar('"');
+}
+
+static void print_result(const PageResult &r, const PageConfig &page, const std::string &image, bool over) {
+    printf("{\"page\":%d,\"name\":", r.page);
+    print_json_string(page.name.c_str());
+    printf(",\"widgets\":%zu,\"objects\":%u,\"lvgl_heap\":%u,\"lvgl_heap_peak\":%u,\"lvgl_blocks\":%u,"
+           "\"image_heap\":%u,\"build_us\":%u,\"render_us\":%u,\"switch_px\":%llu,\"idle_px\":%llu",
+           page.widgets.size(), (unsigned)r.objects, (unsigned)r.heap, (unsigned)r.heap_peak,
+           (unsigned)r.heap_blocks, (unsigned)r.image_heap, (unsigned)r.build_us, (unsigned)r.render_us,
+           (unsigned long long)r.switch_px, (unsigned long long)r.idle_px);
+    if (r.has_press) {
+        printf(",\"press_us\":%u,\"press_px\":%llu", (unsigned)r.press_us, (unsigned long long)r.press_px);
+    }
+    if (!image.empty()) {
+        printf(",\"image\":");
+        print_json_string(image.c_str());
+    }
+    printf(",\"over_limit\":%s}\n", over ? "true" : "false");
+}
+
+// ============================================================
+// Cost table (--cost-table)
+// ============================================================
+
+#define COST_W        200
+#define COST_H        120
+#define COST_SAMPLES  8    // Instances over the one-instance baseline
+
+static WidgetConfig cost_widget(uint8_t type, int i) {
+    WidgetConfig w;
+    w.widget_type = (WidgetType)type;
+    w.x = (i % 3) * 260;
+    w.y = 40 + (i / 3) * 140;
+    w.width = COST_W;
+    w.height = COST_H;
+    w.label = "Label";
+    w.stat_type = 1;
+    if (type == WIDGET_REMOTE_IMAGE) w.image_source = "now_playing";
+    if (type == WIDGET_SCROLL_GRID) {
+        w.grid_columns = 3;
+        w.grid_entries.resize(24);
+        for (auto &e : w.grid_entries) e.label = "App";
+    }
+    return w;
+}
+
+static int run_cost_table(ProfileConfig &profile, const Options &opt) {
+    profile.pages.clear();
+    for (int t = 0; t <= WIDGET_TYPE_MAX; t++) {
+        PageConfig base, full;
+        base.name = full.name = "cost";
+        for (int i = 0; i <= COST_SAMPLES; i++) {
+            if (i == 0) base.widgets.push_back(cost_widget(t, i));
+            full.widgets.push_back(cost_widget(t, i));
+        }
+        profile.pages.push_back(base);
+        profile.pages.push_back(full);
+    }
+    create_ui(&g_app_config);
+    run_for(opt.settle_ms);
+
+    for (int t = 0; t <= WIDGET_TYPE_MAX; t++) {
+        PageResult base = measure_page(2 * t, profile.pages[2 * t], opt);
+        PageResult full = measure_page(2 * t + 1, profile.pages[2 * t + 1], opt);
+        auto per = [](uint32_t a, uint32_t b) { return a > b ? (a - b) / COST_SAMPLES : 0; };
+        uint32_t render_us = per(full.render_us, base.render_us);
+        printf("{\"widget_type\":%d,\"heap\":%u,\"objects\":%u,\"image_heap\":%u,\"render_us_kpx\":%u}\n",
+               t, (unsigned)per(full.heap, base.heap), (unsigned)per(full.objects, base.objects),
+               (unsigned)per(full.image_heap, base.image_heap),
+               (unsigned)(render_us * 1000 / (COST_W * COST_H)));
+    }
+    return 0;
+}
+
+static bool parse_args(int argc, char **argv, Options &opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool has_value = i + 1 < argc;
+        auto num = [&]() { return (uint32_t)strtoul(argv[++i], nullptr, 10); };
+        if (a == "--log") opt.log = true;
+        else if (a == "--cost-table") opt.cost_table = true;
+        else if (a == "--profile" && has_value) opt.profile = argv[++i];
+        else if (a == "--out" && has_value) opt.out_dir = argv[++i];
+        else if (a == "--page" && has_value) opt.page = (int)num();
+        else if (a == "--settle" && has_value) opt.settle_ms = num();
+        else if (a == "--idle" && has_value) opt.idle_ms = num();
+        else if (a == "--max-objects" && has_value) opt.max_objects = num();
+        else if (a == "--max-heap-kb" && has_value) opt.max_heap_kb = num();
+        else if (a == "--max-render-ms" && has_value) opt.max_render_ms = num();
+        else if (a == "--max-idle-px" && has_value) opt.max_idle_px = num();
+        else if (a[0] != '-' && !opt.sd_dir) opt.sd_dir = argv[i];
+        else return false;
+    }
+    return opt.sd_dir != nullptr;
+}
+
+int main(int argc, char **argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        fprintf(stderr, "usage: %s [--profile NAME] [--page N] [--out DIR] [--settle MS] [--idle MS]\n"
+                        "       [--max-objects N] [--max-heap-kb N] [--max-render-ms N] [--max-idle-px N]\n"
+                        "       [--cost-table] [--log] <sd-dir>\n", argv[0]);
+        return 1;
+    }
+    sim_set_log(opt.log);
+    sim_sd_set_root(opt.sd_dir);
+    if (!sdcard_init()) {
+        fprintf(stderr, "sim: %s is not a directory\n", opt.sd_dir);
+        return 1;
+    }
+
+    sim_lvgl_init();
+    g_app_config = config_load();
+    if (opt.profile) {
+        ProfileConfig *p = g_app_config.get_profile(opt.profile);
+        if (!p || !config_load_profile(*p)) {
+            fprintf(stderr, "sim: no profile '%s'\n", opt.profile);
+            return 1;
+        }
+        g_app_config.active_profile_name = p->name;
+    }
+    ProfileConfig *profile = g_app_config.get_active_profile();
+    if (!profile || profile->pages.empty()) {
+        fprintf(stderr, "sim: config has no pages to render\n");
+        return 1;
+    }
+
+    // A connected panel, so status bars render as they usually look
+    status_set_link(-50, true);
+    status_set_pc_active(true);
+    if (opt.cost_table) return run_cost_table(*profile, opt);
+
+    uint32_t t0 = micros();
+    create_ui(&g_app_config);
+    uint32_t create_us = micros() - t0;
+    run_for(opt.settle_ms);
+
+    // Page 0 is visited last so its build is timed like every other page's
+    int count = (int)profile->pages.size();
+    std::vector<int> order;
+    if (opt.page >= 0) {
+        if (opt.page >= count) {
+            fprintf(stderr, "sim: profile '%s' has %d page(s)\n", profile->name.c_str(), count);
+            return 1;
+        }
+        order.push_back(opt.page);
+    } else {
+        for (int i = 1; i < count; i++) order.push_back(i);
+        order.push_back(0);
+    }
+
+    int over = 0;
+    for (int index : order) {
+        PageResult r = measure_page(index, profile->pages[index], opt);
+        std::string image;
+        if (opt.out_dir) {
+            image = std::string(opt.out_dir) + "/page_" + std::to_string(index) + ".ppm";
+            if (!write_ppm(image)) {
+                fprintf(stderr, "sim: cannot write %s\n", image.c_str());
+                image.clear();
+            }
+        }
+        bool page_over = over_limits(r, opt);
+        over += page_over;
+        print_result(r, profile->pages[index], image, page_over);
+    }
+
+    printf("{\"profile\":");
+    print_json_string(profile->name.c_str());
+    printf(",\"pages\":%d,\"create_ui_us\":%u,\"bridge_messages\":%u,\"pages_over_limit\":%d}\n",
+           count, (unsigned)create_us, (unsigned)sim_bridge_messages(), over);
+    return over ? 2 : 0;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <stdint.h>
+
+// ============================================================
+// Host simulator of the display UI (pio run -e sim)
+//
+// ui.cpp, config.cpp and the modules they build pages from (actions,
+// button skins, icon cache, fonts, status store, memory budgets, SD
+// helpers) compile unchanged against LVGL and the host stand-ins in
+// sim/include. The radio, power, touch, input and background loader
+// modules are replaced by sim_stubs.cpp: messages to the bridge are
+// logged and dropped, the panel stays ACTIVE, the slideshow decodes
+// synchronously. sim/main.cpp drives LVGL into a RAM framebuffer.
+// ============================================================
+
+// Skip the clock ahead (LVGL timers and animations see the jump)
+void sim_advance_ms(uint32_t ms);
+
+// Serial output on/off (off: only the runner's own report is printed)
+void sim_set_log(bool enabled);
+
+// Messages the UI tried to send to the bridge since start
+uint32_t sim_bridge_messages();
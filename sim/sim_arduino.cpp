@@ -0,0 +1,39 @@
+/**
+ * @file sim_arduino.cpp
+ * Clock and Serial behind the host Arduino stand-in
+ */
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <chrono>
+#include "sim.h"
+
+SimSerial Serial;
+
+static bool log_enabled = true;
+static uint64_t skipped_us = 0;
+
+static uint64_t now_us() {
+    using namespace std::chrono;
+    static const steady_clock::time_point start = steady_clock::now();
+    return (uint64_t)duration_cast<microseconds>(steady_clock::now() - start).count() + skipped_us;
+}
+
+extern "C" uint32_t millis(void) { return (uint32_t)(now_us() / 1000); }
+extern "C" uint32_t micros(void) { return (uint32_t)now_us(); }
+extern "C" void delay(uint32_t ms) { sim_advance_ms(ms); }
+int64_t esp_timer_get_time() { return (int64_t)now_us(); }
+
+void sim_advance_ms(uint32_t ms) { skipped_us += (uint64_t)ms * 1000; }
+
+void sim_set_log(bool enabled) { log_enabled = enabled; }
+
+size_t SimSerial::write(uint8_t c) {
+    if (log_enabled) fputc(c, stderr);
+    return 1;
+}
+
+size_t SimSerial::write(const uint8_t *buf, size_t len) {
+    if (log_enabled) fwrite(buf, 1, len, stderr);
+    return len;
+}
@@ -0,0 +1,179 @@
+/**
+ * @file sim_sd.cpp
+ * SD library stand-in over a host directory
+ *
+ * Card paths are appended to the root, so "/config.json" is
+ * <root>/config.json. Files are stdio streams, directories are listed
+ * with readdir; handles are shared like the ESP32 core's File.
+ */
+
+#include <SD.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+SDFS SD;
+
+static std::string root;
+static bool begun = false;
+
+struct File::Handle {
+    FILE *fp = nullptr;
+    DIR *dir = nullptr;
+    std::string path;   // Card path
+    std::string name;   // Last component
+
+    ~Handle() {
+        if (fp) fclose(fp);
+        if (dir) closedir(dir);
+    }
+};
+
+void sim_sd_set_root(const char *dir) {
+    root = dir ? dir : "";
+    while (root.size() > 1 && root.back() == '/') root.pop_back();
+}
+
+static std::string host_path(const char *path) {
+    std::string p = path ? path : "";
+    if (p.empty() || p[0] != '/') p.insert(0, "/");
+    return root + p;
+}
+
+// ============================================================
+// File
+// ============================================================
+
+File::operator bool() const { return h_ && (h_->fp || h_->dir); }
+
+size_t File::write(uint8_t c) { return write(&c, 1); }
+
+size_t File::write(const uint8_t *buf, size_t len) {
+    return h_ && h_->fp ? fwrite(buf, 1, len, h_->fp) : 0;
+}
+
+size_t File::read(uint8_t *buf, size_t len) {
+    return h_ && h_->fp ? fread(buf, 1, len, h_->fp) : 0;
+}
+
+int File::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::peek() {
+    if (!h_ || !h_->fp) return -1;
+    int c = fgetc(h_->fp);
+    if (c != EOF) ungetc(c, h_->fp);
+    return c == EOF ? -1 : c;
+}
+
+int File::available() {
+    return h_ && h_->fp ? (int)(size() - position()) : 0;
+}
+
+bool File::seek(uint32_t pos) {
+    return h_ && h_->fp && fseek(h_->fp, (long)pos, SEEK_SET) == 0;
+}
+
+size_t File::position() const {
+    long p = h_ && h_->fp ? ftell(h_->fp) : -1;
+    return p < 0 ? 0 : (size_t)p;
+}
+
+size_t File::size() const {
+    struct stat st;
+    if (!h_ || !h_->fp) return 0;
+    fflush(h_->fp);
+    return fstat(fileno(h_->fp), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+void File::flush() {
+    if (h_ && h_->fp) fflush(h_->fp);
+}
+
+void File::close() { h_.reset(); }
+
+const char *File::name() const { return h_ ? h_->name.c_str() : ""; }
+const char *File::path() const { return h_ ? h_->path.c_str() : ""; }
+bool File::isDirectory() const { return h_ && h_->dir; }
+
+File File::openNextFile() {
+    if (!h_ || !h_->dir) return File();
+    while (struct dirent *e = readdir(h_->dir)) {
+        if (!strcmp(e->d_name, ".") || !strcmp(e->d_name, "..")) continue;
+        std::string child = h_->path == "/" ? "/" : h_->path + "/";
+        return SD.open((child + e->d_name).c_str(), FILE_READ);
+    }
+    return File();
+}
+
+// ============================================================
+// SDFS
+// ============================================================
+
+bool SDFS::begin(uint8_t, SPIClass &, uint32_t) {
+    struct stat st;
+    begun = !root.empty() && stat(root.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+    return begun;
+}
+
+void SDFS::end() { begun = false; }
+
+sdcard_type_t SDFS::cardType() { return begun ? CARD_SDHC : CARD_NONE; }
+
+uint64_t SDFS::totalBytes() {
+    struct statvfs vfs;
+    return begun && statvfs(root.c_str(), &vfs) == 0 ? (uint64_t)vfs.f_blocks * vfs.f_frsize : 0;
+}
+
+uint64_t SDFS::usedBytes() {
+    struct statvfs vfs;
+    if (!begun || statvfs(root.c_str(), &vfs) != 0) return 0;
+    return (uint64_t)(vfs.f_blocks - vfs.f_bfree) * vfs.f_frsize;
+}
+
+uint64_t SDFS::cardSize() { return totalBytes(); }
+
+bool SDFS::readRAW(uint8_t *buf, uint32_t) {
+    memset(buf, 0, 512);   // Same bytes every time: the clock ladder settles on its top rung
+    return begun;
+}
+
+File SDFS::open(const char *path, const char *mode, bool) {
+    if (!begun) return File();
+    std::string host = host_path(path);
+    auto h = std::make_shared<File::Handle>();
+    h->path = path && *path == '/' ? path : std::string("/") + (path ? path : "");
+    size_t slash = h->path.find_last_of('/');
+    h->name = h->path.substr(slash + 1);
+
+    struct stat st;
+    bool exists = stat(host.c_str(), &st) == 0;
+    if (exists && S_ISDIR(st.st_mode)) {
+        h->dir = opendir(host.c_str());
+    } else if (!strcmp(mode, FILE_READ)) {
+        if (exists) h->fp = fopen(host.c_str(), "rb");
+    } else if (!strcmp(mode, "r+")) {
+        if (exists) h->fp = fopen(host.c_str(), "r+b");   // Patch in place
+    } else {
+        h->fp = fopen(host.c_str(), !strcmp(mode, FILE_APPEND) ? "ab" : "wb");
+    }
+    return h->fp || h->dir ? File(h) : File();
+}
+
+bool SDFS::exists(const char *path) {
+    struct stat st;
+    return begun && stat(host_path(path).c_str(), &st) == 0;
+}
+
+bool SDFS::remove(const char *path) { return begun && unlink(host_path(path).c_str()) == 0; }
+
+bool SDFS::rename(const char *from, const char *to) {
+    return begun && ::rename(host_path(from).c_str(), host_path(to).c_str()) == 0;
+}
+
+bool SDFS::mkdir(const char *path) { return begun && ::mkdir(host_path(path).c_str(), 0755) == 0; }
+
+bool SDFS::rmdir(const char *path) { return begun && ::rmdir(host_path(path).c_str()) == 0; }
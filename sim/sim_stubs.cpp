@@ -0,0 +1,177 @@
+/**
+ * @file sim_stubs.cpp
+ * The display modules that need the hardware, as far as the UI sees them
+ *
+ * Radio: messages to the bridge are counted and logged. Power: the panel
+ * stays ACTIVE, display modes switch the UI like power.cpp does; runtime
+ * state isn't persisted. Config
+ * server, battery, touch, trackpad, remote images and the background JPEG
+ * loader report "not there", which every caller already handles. UI
+ * posts queue up and run from the sim's loop, as ui_run_posted() does on
+ * the device.
+ */
+
+#include <Arduino.h>
+#include <vector>
+#include "sim.h"
+#include "espnow_link.h"
+#include "power.h"
+#include "battery.h"
+#include "config_server.h"
+#include "perf.h"
+#include "tasks.h"
+#include "hw_input.h"
+#include "input_replay.h"
+#include "trackpad.h"
+#include "touch.h"
+#include "remote_image.h"
+#include "img_loader.h"
+#include "runtime_state.h"
+#include "clock_direct.h"
+
+// ============================================================
+// ESP-NOW
+// ============================================================
+
+static uint32_t bridge_messages = 0;
+
+uint32_t sim_bridge_messages() { return bridge_messages; }
+
+void send_hotkey_to_bridge(uint8_t modifiers, uint8_t keycode) {
+    bridge_messages++;
+    Serial.printf("[sim] -> bridge: hotkey mod=0x%02X key=0x%02X\n", modifiers, keycode);
+}
+
+void send_media_key_to_bridge(uint16_t consumer_code) {
+    bridge_messages++;
+    Serial.printf("[sim] -> bridge: media key 0x%04X\n", consumer_code);
+}
+
+void send_button_press_to_bridge(uint8_t page_index, uint8_t widget_index, int profile_index,
+                                 uint16_t entry_index) {
+    bridge_messages++;
+    Serial.printf("[sim] -> bridge: button page=%u widget=%u profile=%d entry=%d\n", page_index,
+                  widget_index, profile_index, entry_index == 0xFFFF ? -1 : entry_index);
+}
+
+void send_macro_to_bridge(const MacroStep *, uint8_t count) {
+    bridge_messages++;
+    Serial.printf("[sim] -> bridge: macro, %u steps\n", count);
+}
+
+void send_ddc_to_bridge(const DdcCmdMsg &cmd) {
+    bridge_messages++;
+    Serial.printf("[sim] -> bridge: DDC vcp=0x%02X value=%u\n", cmd.vcp_code, cmd.value);
+}
+
+// One host, never paired: host switching stays a no-op
+uint8_t espnow_host_count() { return 0; }
+uint8_t espnow_active_host() { return 0; }
+bool espnow_select_host(uint8_t) { return false; }
+bool espnow_host_linked(uint8_t) { return false; }
+void espnow_pair_new_host() { Serial.printf("[sim] pairing window (no radio)\n"); }
+bool espnow_pairing_host() { return false; }
+
+bool espnow_send_reliable(MsgType type, const uint8_t *, uint8_t len) {
+    bridge_messages++;
+    Serial.printf("[sim] -> bridge: type 0x%02X, %u bytes\n", type, len);
+    return true;
+}
+
+// ============================================================
+// Power
+// ============================================================
+
+static DisplayMode current_mode = MODE_HOTKEYS;
+
+void power_activity() {}
+void power_wake_detected() {}
+PowerState power_get_state() { return POWER_ACTIVE; }
+bool power_animations_enabled() { return true; }
+void power_cycle_brightness() {}
+
+void display_set_mode(DisplayMode mode) {
+    if (mode == current_mode) return;
+    DisplayMode prev_mode = current_mode;
+    current_mode = mode;
+    extern void ui_transition_mode(DisplayMode from, DisplayMode to);
+    ui_transition_mode(prev_mode, mode);
+    Serial.printf("[sim] Display mode: %d -> %d\n", prev_mode, mode);
+}
+
+DisplayMode display_get_mode() { return current_mode; }
+
+void mode_cycle_next(const std::vector<uint8_t> &enabled_modes) {
+    if (enabled_modes.empty()) return;
+    int idx = -1;
+    for (int i = 0; i < (int)enabled_modes.size(); i++) {
+        if (enabled_modes[i] == (uint8_t)current_mode) { idx = i; break; }
+    }
+    display_set_mode((DisplayMode)enabled_modes[(idx + 1) % (int)enabled_modes.size()]);
+}
+
+bool battery_present() { return false; }
+
+// Runtime state: kept for the run, nothing persists
+void runtime_state_set_page(uint8_t) {}
+
+// ============================================================
+// Config server, perf HUD, hardware input
+// ============================================================
+
+bool config_server_start() { return false; }   // No WiFi: config mode never opens
+void config_server_stop() {}
+bool config_server_active() { return false; }
+
+void perf_record_stat_update() {}
+
+bool clock_direct_active() { return false; }   // The sim never enters POWER_CLOCK
+void clock_direct_draw(const char *) {}
+void perf_hud_toggle() {}
+
+bool replay_running() { return false; }   // Input replay needs the panel's input task
+
+void hw_input_focus_next() {}
+void hw_input_focus_prev() {}
+void hw_input_activate_focus() {}
+void hw_input_clear_focus() {}
+
+// ============================================================
+// Touch, trackpad, remote images, slideshow loader
+// ============================================================
+
+void touch_set_down_hook(TouchDownHook) {}
+void trackpad_attach(lv_obj_t *, const WidgetConfig *) {}
+void remote_image_attach(lv_obj_t *, const char *) {}   // Stays on its placeholder
+
+bool img_loader_begin() { return false; }   // ui.cpp falls back to lv_img_set_src() per slide
+bool img_loader_request(uint8_t, const char *) { return false; }
+ImgLoadState img_loader_state(uint8_t) { return IMG_LOAD_IDLE; }
+const lv_img_dsc_t *img_loader_frame(uint8_t) { return nullptr; }
+void img_loader_end() {}
+bool img_loader_takes(const char *) { return false; }
+bool img_loader_decode_into(const char *, uint16_t *, volatile ImgLoadState *) { return false; }  // Backgrounds via "S:"
+
+// ============================================================
+// UI task
+// ============================================================
+
+struct PostedCall {
+    UiCallFn fn;
+    uint32_t arg;
+};
+static std::vector<PostedCall> posted;
+
+void ui_lock() {}
+void ui_unlock() {}
+
+bool ui_post(UiCallFn fn, uint32_t arg) {
+    posted.push_back({ fn, arg });
+    return true;
+}
+
+void ui_run_posted() {
+    std::vector<PostedCall> calls;
+    calls.swap(posted);
+    for (const PostedCall &c : calls) c.fn(c.arg);
+}
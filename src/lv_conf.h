@@ -12,12 +12,12 @@
 #define LV_COLOR_DEPTH 16
 #define LV_COLOR_16_SWAP 0
 
-/* Memory — use PSRAM via heap_caps so LVGL has plenty of room for images */
+/* Memory — the "lvgl" pool of display/mem_budget: PSRAM, small blocks in internal SRAM */
 #define LV_MEM_CUSTOM 1
-#define LV_MEM_CUSTOM_INCLUDE <esp_heap_caps.h>
-#define LV_MEM_CUSTOM_ALLOC(size) heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
-#define LV_MEM_CUSTOM_FREE(ptr) heap_caps_free(ptr)
-#define LV_MEM_CUSTOM_REALLOC(ptr, size) heap_caps_realloc(ptr, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#define LV_MEM_CUSTOM_INCLUDE "../display/mem_budget.h"
+#define LV_MEM_CUSTOM_ALLOC(size) mem_lvgl_alloc(size)
+#define LV_MEM_CUSTOM_FREE(ptr) mem_lvgl_free(ptr)
+#define LV_MEM_CUSTOM_REALLOC(ptr, size) mem_lvgl_realloc(ptr, size)
 #define LV_MEM_BUF_MAX_NUM 16
 
 /* HAL */
@@ -54,23 +54,34 @@
 #define LV_USE_MEM_MONITOR 0
 
 /* Font */
+/* UI_SUBSET_FONTS=1 links glyph-subset, compressed fonts generated by
+ * tools/font_subset.py into display/fonts/ under the same names, in place
+ * of LVGL's full copies */
+#ifndef UI_SUBSET_FONTS
+#define UI_SUBSET_FONTS 0
+#endif
+#if UI_SUBSET_FONTS
+#define UI_BUILTIN_FONT 0
+#else
+#define UI_BUILTIN_FONT 1
+#endif
 #define LV_FONT_MONTSERRAT_8 0
 #define LV_FONT_MONTSERRAT_10 0
-#define LV_FONT_MONTSERRAT_12 1
-#define LV_FONT_MONTSERRAT_14 1
-#define LV_FONT_MONTSERRAT_16 1
-#define LV_FONT_MONTSERRAT_18 1
-#define LV_FONT_MONTSERRAT_20 1
-#define LV_FONT_MONTSERRAT_22 1
-#define LV_FONT_MONTSERRAT_24 1
+#define LV_FONT_MONTSERRAT_12 UI_BUILTIN_FONT
+#define LV_FONT_MONTSERRAT_14 UI_BUILTIN_FONT
+#define LV_FONT_MONTSERRAT_16 UI_BUILTIN_FONT
+#define LV_FONT_MONTSERRAT_18 UI_BUILTIN_FONT
+#define LV_FONT_MONTSERRAT_20 UI_BUILTIN_FONT
+#define LV_FONT_MONTSERRAT_22 UI_BUILTIN_FONT
+#define LV_FONT_MONTSERRAT_24 UI_BUILTIN_FONT
 #define LV_FONT_MONTSERRAT_26 0
-#define LV_FONT_MONTSERRAT_28 1
+#define LV_FONT_MONTSERRAT_28 UI_BUILTIN_FONT
 #define LV_FONT_MONTSERRAT_30 0
 #define LV_FONT_MONTSERRAT_32 0
 #define LV_FONT_MONTSERRAT_34 0
 #define LV_FONT_MONTSERRAT_36 0
 #define LV_FONT_MONTSERRAT_38 0
-#define LV_FONT_MONTSERRAT_40 1
+#define LV_FONT_MONTSERRAT_40 UI_BUILTIN_FONT
 #define LV_FONT_MONTSERRAT_42 0
 #define LV_FONT_MONTSERRAT_44 0
 #define LV_FONT_MONTSERRAT_46 0
@@ -81,9 +92,18 @@
 #define LV_FONT_SIMSUN_16_CJK 0
 #define LV_FONT_UNSCII_8 0
 #define LV_FONT_UNSCII_16 0
+#if UI_SUBSET_FONTS
+#define LV_FONT_CUSTOM_DECLARE \
+    LV_FONT_DECLARE(lv_font_montserrat_12) LV_FONT_DECLARE(lv_font_montserrat_14) \
+    LV_FONT_DECLARE(lv_font_montserrat_16) LV_FONT_DECLARE(lv_font_montserrat_18) \
+    LV_FONT_DECLARE(lv_font_montserrat_20) LV_FONT_DECLARE(lv_font_montserrat_22) \
+    LV_FONT_DECLARE(lv_font_montserrat_24) LV_FONT_DECLARE(lv_font_montserrat_28) \
+    LV_FONT_DECLARE(lv_font_montserrat_40)
+#else
 #define LV_FONT_CUSTOM_DECLARE
+#endif
 #define LV_FONT_DEFAULT &lv_font_montserrat_16
-#define LV_USE_FONT_COMPRESSED 0
+#define LV_USE_FONT_COMPRESSED UI_SUBSET_FONTS
 #define LV_USE_FONT_SUBPX 0
 #define LV_FONT_SUBPX_BGR 0
 #define LV_USE_FONT_PLACEHOLDER 1
@@ -118,7 +138,7 @@
 /* Extra widgets */
 #define LV_USE_ANIMIMG 0
 #define LV_USE_CALENDAR 0
-#define LV_USE_CHART 0
+#define LV_USE_CHART 1
 #define LV_USE_COLORWHEEL 0
 #define LV_USE_IMGBTN 0
 #define LV_USE_KEYBOARD 1
@@ -153,7 +173,7 @@
 #define LV_USE_PNG 1
 #define LV_USE_BMP 1
 #define LV_USE_SJPG 1
-#define LV_USE_GIF 0
+#define LV_USE_GIF 1
 #define LV_USE_QRCODE 0
 #define LV_USE_FREETYPE 0
 #define LV_USE_TINY_TTF 0
@@ -161,6 +181,6 @@
 #define LV_USE_FFMPEG 0
 
 /* Snapshot */
-#define LV_USE_SNAPSHOT 0
+#define LV_USE_SNAPSHOT 1
 
 #endif /* LV_CONF_H */
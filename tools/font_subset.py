@@ -0,0 +1,223 @@
+"""
+Font Subset: generate glyph-subset, compressed Montserrat fonts for the display.
+
+LVGL's built-in Montserrat sizes carry every ASCII glyph plus all ~60
+FontAwesome symbols, uncompressed, at each of the nine sizes the firmware
+enables. This script rebuilds them with lv_font_conv from the same source
+fonts (shipped in the LVGL package under scripts/built_in_font), keeping:
+
+- printable ASCII, which any label can use at runtime
+- non-ASCII text characters found in the config (accents, degree sign ...)
+- only the symbols the firmware sources (LV_SYMBOL_*) and the config icons
+  actually use
+
+and writes them RLE-compressed under the built-in names to display/fonts/.
+Building with -DUI_SUBSET_FONTS=1 disables LVGL's copies (src/lv_conf.h) and
+links these instead; no UI code changes.
+
+It also writes LVGL binary fonts for the SD card (/fonts/<size>.bin), which
+the display loads at runtime for sizes it has no built-in font for.
+
+A symbol picked in the editor after flashing renders as a placeholder box
+until the fonts are regenerated; --all-symbols keeps the whole editor set.
+
+Usage:
+    python tools/font_subset.py --config config.json
+    python tools/font_subset.py --config config.json --bin 48 64 --bin-dir /media/sd/fonts
+
+As a PlatformIO pre-script (regenerates when inputs changed and the build
+has -DUI_SUBSET_FONTS=1; config path from custom_font_config):
+    extra_scripts = pre:tools/font_subset.py
+    custom_font_config = config.json
+
+Requires lv_font_conv (npm i -g lv_font_conv, or run through npx).
+"""
+
+import argparse
+import glob
+import importlib.util
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+try:
+    SCRIPT = os.path.abspath(__file__)
+except NameError:
+    # PlatformIO runs extra scripts without __file__, from the project directory
+    SCRIPT = os.path.join(os.getcwd(), "tools", "font_subset.py")
+ROOT = os.path.dirname(os.path.dirname(SCRIPT))
+OUT_DIR = os.path.join(ROOT, "display", "fonts")
+SOURCES = os.path.join(ROOT, "display")
+SYMBOLS_PY = os.path.join(ROOT, "companion", "lvgl_symbols.py")
+
+# Must match the LV_FONT_MONTSERRAT_* sizes enabled in src/lv_conf.h
+BUILTIN_SIZES = [12, 14, 16, 18, 20, 22, 24, 28, 40]
+
+TEXT_FONT = "Montserrat-Medium.ttf"
+SYMBOL_FONT = "FontAwesome5-Solid+Brands+Regular.woff"
+ASCII_RANGE = "0x20-0x7E"
+EXTRA_TEXT = "°"   # Degree sign: temperature stats
+BPP = 4
+
+
+def load_symbols():
+    spec = importlib.util.spec_from_file_location("lvgl_symbols", SYMBOLS_PY)
+    mod = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(mod)
+    return mod.LVGL_SYMBOLS
+
+
+def firmware_symbols(symbols):
+    """Codepoints of every LV_SYMBOL_* referenced by the display sources."""
+    by_name = {name: cp for name, cp, _ in symbols}
+    used = set()
+    for path in glob.glob(os.path.join(SOURCES, "*.cpp")) + glob.glob(os.path.join(SOURCES, "*.h")):
+        with open(path, encoding="utf-8", errors="ignore") as f:
+            for name in re.findall(r"LV_SYMBOL_(\w+)", f.read()):
+                if name in by_name:
+                    used.add(by_name[name])
+    return used
+
+
+def config_chars(config_path):
+    """(symbol codepoints, extra text characters) used by strings in a config."""
+    symbols, text = set(), set()
+    if not config_path:
+        return symbols, text
+    with open(config_path, encoding="utf-8") as f:
+        data = json.load(f)
+
+    def walk(node):
+        if isinstance(node, dict):
+            for v in node.values():
+                walk(v)
+        elif isinstance(node, list):
+            for v in node:
+                walk(v)
+        elif isinstance(node, str):
+            for ch in node:
+                cp = ord(ch)
+                if 0xF000 <= cp <= 0xF8FF:
+                    symbols.add(cp)
+                elif cp > 0x7E:
+                    text.add(ch)
+
+    walk(data)
+    return symbols, text
+
+
+def find_source_fonts(font_dir):
+    """Directory holding LVGL's built-in font sources."""
+    candidates = [font_dir] if font_dir else []
+    candidates += glob.glob(os.path.join(ROOT, ".pio", "libdeps", "*", "lvgl", "scripts", "built_in_font"))
+    for d in candidates:
+        if d and os.path.isfile(os.path.join(d, TEXT_FONT)) and os.path.isfile(os.path.join(d, SYMBOL_FONT)):
+            return d
+    raise SystemExit("font_subset: %s / %s not found (pass --font-dir, or build once so "
+                     "PlatformIO fetches LVGL)" % (TEXT_FONT, SYMBOL_FONT))
+
+
+def converter():
+    if shutil.which("lv_font_conv"):
+        return ["lv_font_conv"]
+    if shutil.which("npx"):
+        return ["npx", "--yes", "lv_font_conv"]
+    raise SystemExit("font_subset: lv_font_conv not found (npm i -g lv_font_conv)")
+
+
+def conv_args(font_dir, size, symbols, text):
+    args = ["--bpp", str(BPP), "--size", str(size),
+            "--font", os.path.join(font_dir, TEXT_FONT), "--range", ASCII_RANGE]
+    extra = "".join(sorted(set(EXTRA_TEXT) | text))
+    if extra:
+        args += ["--symbols", extra]
+    if symbols:
+        args += ["--font", os.path.join(font_dir, SYMBOL_FONT),
+                 "--range", ",".join("0x%X" % cp for cp in sorted(symbols))]
+    return args
+
+
+def guard_builtin(path):
+    """lv_font_conv guards the font with its own LV_FONT_<NAME> switch, which
+    lv_conf.h turns off for the LVGL copy: compile ours on UI_SUBSET_FONTS."""
+    with open(path, encoding="utf-8") as f:
+        src = f.read()
+    src = re.sub(r"#ifndef (LV_FONT_MONTSERRAT_\d+)\n#define \1 1\n#endif\n\n#if \1\n",
+                 "#if UI_SUBSET_FONTS\n", src, count=1)
+    with open(path, "w", encoding="utf-8") as f:
+        f.write(src)
+
+
+def generate(config_path, font_dir=None, bin_sizes=(), bin_dir=None, all_symbols=False):
+    symbols_table = load_symbols()
+    cfg_symbols, text = config_chars(config_path)
+    symbols = firmware_symbols(symbols_table) | cfg_symbols
+    if all_symbols:
+        symbols |= {cp for _, cp, _ in symbols_table}
+    font_dir = find_source_fonts(font_dir)
+    conv = converter()
+    os.makedirs(OUT_DIR, exist_ok=True)
+
+    print("font_subset: %d symbols, %d extra text glyphs" % (len(symbols), len(text)))
+    for size in BUILTIN_SIZES:
+        name = "lv_font_montserrat_%d" % size
+        out = os.path.join(OUT_DIR, name + ".c")
+        subprocess.run(conv + conv_args(font_dir, size, symbols, text) +
+                       ["--format", "lvgl", "--lv-include", "lvgl.h",
+                        "--lv-font-name", name, "-o", out], check=True)
+        guard_builtin(out)
+        print("font_subset: %s (%d KB source)" % (name, os.path.getsize(out) // 1024))
+
+    if bin_sizes:
+        bin_dir = bin_dir or os.path.join(OUT_DIR, "sd")
+        os.makedirs(bin_dir, exist_ok=True)
+        for size in bin_sizes:
+            out = os.path.join(bin_dir, "%d.bin" % size)
+            subprocess.run(conv + conv_args(font_dir, size, symbols, text) +
+                           ["--format", "bin", "-o", out], check=True)
+            print("font_subset: %s (%d KB) -> copy to /fonts/ on the SD card"
+                  % (out, os.path.getsize(out) // 1024))
+
+
+def _stale(config_path):
+    inputs = [SYMBOLS_PY, SCRIPT]
+    if config_path:
+        inputs.append(config_path)
+    outputs = [os.path.join(OUT_DIR, "lv_font_montserrat_%d.c" % s) for s in BUILTIN_SIZES]
+    if not all(os.path.isfile(o) for o in outputs):
+        return True
+    oldest = min(os.path.getmtime(o) for o in outputs)
+    return any(os.path.getmtime(i) > oldest for i in inputs if os.path.isfile(i))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate subset Montserrat fonts for the display")
+    parser.add_argument("--config", help="config.json whose icons/labels should be covered")
+    parser.add_argument("--font-dir", help="Directory with %s and %s" % (TEXT_FONT, SYMBOL_FONT))
+    parser.add_argument("--bin", nargs="*", type=int, default=[], metavar="SIZE",
+                        help="Also write LVGL binary fonts of these sizes for the SD card")
+    parser.add_argument("--bin-dir", help="Output directory for --bin (default display/fonts/sd)")
+    parser.add_argument("--all-symbols", action="store_true",
+                        help="Keep every editor symbol (icons picked later need no reflash)")
+    args = parser.parse_args()
+    generate(args.config, args.font_dir, args.bin, args.bin_dir, args.all_symbols)
+
+
+try:
+    Import("env")  # noqa: F821 -- defined when run as a PlatformIO extra script
+except NameError:
+    env = None
+
+if env is not None:
+    flags = " ".join(env.GetProjectOption("build_flags", []))
+    if env.get("PIOENV") == "display" and re.search(r"-DUI_SUBSET_FONTS=1\b", flags):
+        cfg = env.GetProjectOption("custom_font_config", "") or None
+        if cfg:
+            cfg = os.path.join(ROOT, cfg)
+        if _stale(cfg):
+            generate(cfg)
+elif __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,52 @@
+"""
+OTA gzip: write firmware.bin.gz next to firmware.bin for the web updater.
+
+The display's POST /update accepts either file (display/ota_update.cpp
+inflates the gzip into the OTA slot as it arrives), and the compressed one
+is roughly 40% smaller over the SoftAP.
+
+Usage:
+    python tools/ota_gzip.py .pio/build/display/firmware.bin
+
+As a PlatformIO post-script (runs after every build of firmware.bin):
+    extra_scripts = post:tools/ota_gzip.py
+"""
+
+import gzip
+import os
+import sys
+
+
+def compress(bin_path):
+    out = bin_path + ".gz"
+    with open(bin_path, "rb") as f:
+        data = f.read()
+    # mtime=0 and no file name: the same firmware gives the same .gz
+    with open(out, "wb") as f:
+        with gzip.GzipFile(fileobj=f, mode="wb", compresslevel=9, mtime=0, filename="") as gz:
+            gz.write(data)
+    size = os.path.getsize(out)
+    print("ota_gzip: %s (%d KB -> %d KB)" % (out, len(data) // 1024, size // 1024))
+    return out
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(__doc__)
+        return 1
+    compress(sys.argv[1])
+    return 0
+
+
+try:
+    Import("env")  # noqa: F821 -- defined when run as a PlatformIO extra script
+except NameError:
+    env = None
+
+if env is not None:
+    def _after_bin(source, target, env):
+        compress(str(target[0]))
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.bin", _after_bin)
+elif __name__ == "__main__":
+    sys.exit(main())
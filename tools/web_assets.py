@@ -0,0 +1,104 @@
+"""
+Web assets: gzip display/web/* into display/web_assets.h for the config server.
+
+Each file becomes a PROGMEM byte array, gzip-compressed once at build time
+(served with Content-Encoding: gzip, never inflated on the device), plus an
+ETag from the CRC-32 of those bytes so browsers revalidate with a 304
+instead of downloading the page again. index.html is served at "/", any
+other file at "/<name>".
+
+The header is committed; it is only rewritten when the output changes, so
+the pre-script doesn't trigger rebuilds of config_server.cpp.
+
+Usage:
+    python tools/web_assets.py
+
+As a PlatformIO pre-script:
+    extra_scripts = pre:tools/web_assets.py
+"""
+
+import gzip
+import os
+import sys
+import zlib
+
+try:
+    Import("env")  # noqa: F821 -- defined when run as a PlatformIO extra script
+    ROOT = env["PROJECT_DIR"]  # noqa: F821 -- SCons runs this without __file__
+except NameError:
+    env = None
+    ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+WEB_DIR = os.path.join(ROOT, "display", "web")
+OUT = os.path.join(ROOT, "display", "web_assets.h")
+
+MIME = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".svg": "image/svg+xml",
+    ".ico": "image/x-icon",
+    ".json": "application/json",
+}
+
+
+def _symbol(name):
+    return "web_" + "".join(c if c.isalnum() else "_" for c in name) + "_gz"
+
+
+def render():
+    names = sorted(n for n in os.listdir(WEB_DIR) if os.path.splitext(n)[1] in MIME)
+    lines = [
+        "// Generated by tools/web_assets.py from display/web/ -- do not edit",
+        "#pragma once",
+        "#include <Arduino.h>",
+        "",
+        "struct WebAsset {",
+        "    const char *path;       // URL",
+        "    const char *mime;",
+        "    const uint8_t *gz;      // gzip-compressed body",
+        "    size_t gz_len;",
+        "    const char *etag;       // Quoted CRC-32 of gz",
+        "};",
+        "",
+    ]
+    table = []
+    for name in names:
+        with open(os.path.join(WEB_DIR, name), "rb") as f:
+            raw = f.read()
+        gz = gzip.compress(raw, compresslevel=9, mtime=0)
+        sym = _symbol(name)
+        lines.append(f"// {name}: {len(raw)} -> {len(gz)} bytes")
+        lines.append(f"static const uint8_t {sym}[] PROGMEM = {{")
+        for i in range(0, len(gz), 16):
+            lines.append("    " + ", ".join(f"0x{b:02x}" for b in gz[i:i + 16]) + ",")
+        lines.append("};")
+        lines.append("")
+        path = "/" if name == "index.html" else "/" + name
+        etag = f'"\\"{zlib.crc32(gz) & 0xFFFFFFFF:08x}\\""'
+        table.append(f'    {{ "{path}", "{MIME[os.path.splitext(name)[1]]}", {sym}, sizeof({sym}), {etag} }},')
+    lines.append("static const WebAsset WEB_ASSETS[] = {")
+    lines.extend(table)
+    lines.append("};")
+    lines.append("")
+    return "\n".join(lines)
+
+
+def generate():
+    text = render()
+    try:
+        with open(OUT) as f:
+            if f.read() == text:
+                return False
+    except OSError:
+        pass
+    with open(OUT, "w") as f:
+        f.write(text)
+    print("web_assets: wrote %s" % os.path.relpath(OUT, ROOT))
+    return True
+
+
+if env is not None:
+    generate()
+elif __name__ == "__main__":
+    generate()
+    sys.exit(0)